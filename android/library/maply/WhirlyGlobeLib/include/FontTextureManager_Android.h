@@ -58,7 +58,7 @@ public:
 
 protected:
     // Find the appropriate font manager
-    FontManager_AndroidRef findFontManagerForFont(PlatformInfo_Android *,jobject typefaceObj,const LabelInfo &);
+    FontManager_AndroidRef findFontManagerForFont(PlatformInfo_Android *,jobject typefaceObj,const LabelInfo &,bool sdf);
 
     // Java object that can do the character rendering for us
     jobject charRenderObj = nullptr;
@@ -74,6 +74,7 @@ protected:
     jfieldID textureOffsetXID = nullptr;
     jfieldID textureOffsetYID = nullptr;
     jfieldID baselineID = nullptr;
+    jfieldID fontNameID = nullptr;
 };
 typedef std::shared_ptr<FontTextureManager_Android> FontTextureManager_AndroidRef;
 
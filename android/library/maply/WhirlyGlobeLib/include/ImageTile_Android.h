@@ -27,7 +27,8 @@
 namespace WhirlyKit
 {
 
-typedef enum {MaplyImgTypeNone,MaplyImgTypeDataPKM,MaplyImgTypeDataPVRTC4,MaplyImgTypeRawImage} MaplyImgType;
+/// DataCompressed is anything ParseCompressedImage() recognizes, which goes to the GPU as is
+typedef enum {MaplyImgTypeNone,MaplyImgTypeDataPKM,MaplyImgTypeDataPVRTC4,MaplyImgTypeRawImage,MaplyImgTypeDataCompressed} MaplyImgType;
 
 /**
     Android version of the Image Tile.
@@ -43,6 +44,16 @@ public:
     /// Scoop the contents out of a Bitmap
     void setBitmap(JNIEnv *env,jobject bitmapObj);
 
+    /// Take an image that's already in a GPU format (PKM, KTX, KTX2 or .astc).
+    /// Returns false, without copying anything, if it's not one of those.
+    bool setCompressedData(const void *bytes,size_t len);
+
+    /// Same, but keep the data we're given, which may be a mapped file
+    bool setCompressedData(const RawDataRef &data);
+
+    /// Use RGBA 8888 pixels, tightly packed, as they are.  False if there aren't enough of them.
+    bool setRawImage(const RawDataRef &data,int width,int height);
+
     /// Construct and return a texture suitable for the renderer
     virtual Texture *buildTexture();
 
@@ -17,6 +17,8 @@
  */
 
 #import <jni.h>
+#import <mutex>
+#import <unordered_map>
 #import "WhirlyGlobeLib.h"
 #import "LabelInfo_Android.h"
 
@@ -71,12 +73,17 @@ public:
 public:
     jweak thisObj = nullptr;
     jmethodID makeLabelInfoMethod = nullptr;
-    jmethodID calculateTextWidthMethod = nullptr;
+    jmethodID glyphWidthsMethod = nullptr;
     jmethodID makeCircleTextureMethod = nullptr;
     jmethodID makeLineTextureMethod = nullptr;
 
     // Map fontName/size to Java-side labelInfo objects
     std::map<std::pair<std::string, float>, LabelInfoAndroidRef> labelInfos;
+
+    // Advance widths of the characters we've measured, for each of those label infos.
+    // Text widths are added up from these, so wrapping labels doesn't go over to Java per feature.
+    std::unordered_map<const LabelInfo *,std::unordered_map<int,float>> glyphWidths;
+    std::mutex glyphLock;
 };
 typedef std::shared_ptr<MapboxVectorStyleSetImpl_Android> MapboxVectorStyleSetImpl_AndroidRef;
 
@@ -0,0 +1,51 @@
+/*  PointCloudLoader_Android.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <jni.h>
+#import "PointCloudLoader.h"
+
+namespace WhirlyKit
+{
+
+/** Collects fetch and cancel requests during an update,
+    so the Java side can pass them on to its source afterwards
+    rather than us calling back into Java in the middle of things.
+  */
+class PointCloudSource_Android : public PointCloudSource
+{
+public:
+    virtual void startFetch(PointCloudLoader *loader,const OctreeIdentifier &ident) override;
+    virtual void cancelFetch(PointCloudLoader *loader,const OctreeIdentifier &ident) override;
+
+    /// Hand back the requests since the last call, as level, x, y, z
+    std::vector<int> takeRequests(bool cancels);
+
+protected:
+    std::vector<int> fetches,cancels;
+};
+
+// Android version of the point cloud loader
+class PointCloudLoader_Android : public PointCloudLoader
+{
+public:
+    PointCloudLoader_Android(const Point3d &ll,const Point3d &ur,int maxLevel,double rootSpacing);
+
+    /// Requests queued up for the Java side
+    PointCloudSource_Android *getRequests() const;
+};
+
+}
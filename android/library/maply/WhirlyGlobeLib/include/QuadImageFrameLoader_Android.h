@@ -60,6 +60,9 @@ public:
     // Clear out state
     virtual void loadFailed(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader) override;
 
+    // Reload came back the same, so we're done with the request
+    virtual void loadUnchanged(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader) override;
+
 public:
     // Cancel the fetch (with the tile fetcher) on the Java side
     void cancelFetchJava(PlatformInfo_Android *threadInfo,QuadImageFrameLoader_Android *loader,QIFBatchOps_Android *batchOps);
@@ -26,6 +26,7 @@
 #import "LabelInfo_Android.h"
 #import "MapboxVectorStyleSet_Android.h"
 #import "ParticleBatch_Android.h"
+#import "PointCloudLoader_Android.h"
 #import "QuadImageFrameLoader_Android.h"
 #import "QuadSamplingController_Android.h"
 #import "SceneRenderer_Android.h"
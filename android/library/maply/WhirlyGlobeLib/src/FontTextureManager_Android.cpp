@@ -98,6 +98,14 @@ FontTextureManager_Android::FontTextureManager_Android(PlatformThreadInfo *inst,
 		logAndClearJVMException(env);
 		env->DeleteLocalRef(glyphClass);
 	}
+
+	// The font name identifies the typeface in the glyph cache
+	if (jclass labelInfoClass = env->FindClass("com/mousebird/maply/LabelInfo"))
+	{
+		fontNameID = env->GetFieldID(labelInfoClass, "fontName", "Ljava/lang/String;");
+		logAndClearJVMException(env);
+		env->DeleteLocalRef(labelInfoClass);
+	}
 }
 
 FontTextureManager_Android::~FontTextureManager_Android()
@@ -165,21 +173,56 @@ std::unique_ptr<DrawableString> FontTextureManager_Android::addString(
     auto drawString = std::make_unique<DrawableString>();
     auto drawStringRep = std::make_unique<DrawStringRep>(drawString->getId());
 
+    // Outlines are baked into the glyphs, so those can't be distance fields
+    drawString->sdf = sdfMode && labelInfo->outlineSize <= 0.0f;
+
     // Look for the font manager that manages the typeface/attribute combo we need
-    auto fm = findFontManagerForFont(threadInfo,labelInfo->typefaceObj,*labelInfo);
+    auto fm = findFontManagerForFont(threadInfo,labelInfo->typefaceObj,*labelInfo,drawString->sdf);
+
+    // The font manager covers the typeface and colors, which leaves the size and the text
+    std::string layoutKey = std::to_string(fm->getId()) + ":" + std::to_string(labelInfo->fontSize) + ":";
+    layoutKey.append((const char *)codePoints.data(),codePoints.size() * sizeof(int));
+    if (auto cachedString = findLayout(layoutKey))
+    {
+        return cachedString;
+    }
 
     // Work through the characters
     GlyphSet glyphsUsed;
+    LayoutGlyphs layoutGlyphs;
     float offsetX = 0.0;
     for (const int glyph : codePoints)
     {
         // Look for an existing glyph
         auto glyphInfo = fm->findGlyph(glyph);
+
+        // Rendered before, maybe by an earlier run
+        GlyphCache::Glyph cached;
+        const bool useCache = glyphCache && !fm->cacheKey.empty();
+        if (!glyphInfo && useCache && glyphCache->findGlyph(fm->cacheKey, glyph, cached))
+        {
+            TextureGLES tex("FontTextureManager");
+            tex.setRawData(new MutableRawData(cached.pixels.data(), cached.pixels.size()), cached.width, cached.height);
+
+            SubTexture subTex;
+            const Point2f realSize(cached.glyphSizeX + 2 * cached.textureOffsetX,
+                                   cached.glyphSizeY + 2 * cached.textureOffsetY);
+            std::vector<Texture *> texs{&tex};
+            if (texAtlas->addTexture(sceneRender, texs, -1, &realSize, nullptr, subTex,
+                                     changes, 0, 1, nullptr))
+            {
+                glyphInfo = fm->addGlyph(glyph, subTex,
+                                         Point2f(cached.glyphSizeX, cached.glyphSizeY),
+                                         Point2f(cached.offsetX, cached.offsetY),
+                                         Point2f(cached.textureOffsetX, cached.textureOffsetY));
+            }
+        }
+
         if (!glyphInfo)
         {
             // Call the renderer
             jobject glyphObj = env->CallObjectMethod(charRenderObj,renderMethodID,glyph,
-                                                     labelInfo->labelInfoObj,labelInfo->fontSize);
+                                                     labelInfo->labelInfoObj,fm->pointSize);
             if (!glyphObj)
             {
                 wkLogLevel(Warn,"Glyph render failed from FontTextureManager_Android: %d",glyph);
@@ -226,9 +269,34 @@ std::unique_ptr<DrawableString> FontTextureManager_Android::addString(
                     {
                         assert(info.width * 4 == info.stride);
 
-                        auto rawData = new MutableRawData(bitmapPixels, info.height * info.width * 4);
+                        void *pixels = bitmapPixels;
+                        int width = (int)info.width, height = (int)info.height;
+                        std::vector<unsigned char> sdfPixels;
+                        if (fm->sdf)
+                        {
+                            makeSDFGlyph((const unsigned char *)bitmapPixels, width, height,
+                                         sdfPixels, width, height);
+                            pixels = sdfPixels.data();
+                            texSize = Point2f(width, height);
+                            textureOffset += Point2f(SDFRadius, SDFRadius);
+                        }
+
+                        auto rawData = new MutableRawData(pixels, height * width * 4);
+
+                        if (useCache)
+                        {
+                            cached.width = width;
+                            cached.height = height;
+                            cached.sizeX = texSize.x();  cached.sizeY = texSize.y();
+                            cached.glyphSizeX = glyphSize.x();  cached.glyphSizeY = glyphSize.y();
+                            cached.offsetX = offset.x();  cached.offsetY = offset.y();
+                            cached.textureOffsetX = textureOffset.x();  cached.textureOffsetY = textureOffset.y();
+                            const auto *bytes = (const unsigned char *)pixels;
+                            cached.pixels.assign(bytes, bytes + height * width * 4);
+                            glyphCache->addGlyph(fm->cacheKey, glyph, cached);
+                        }
                         TextureGLES tex("FontTextureManager");
-                        tex.setRawData(rawData, info.width, info.height);
+                        tex.setRawData(rawData, width, height);
 
                         // Add it to the texture atlas
                         SubTexture subTex;
@@ -275,7 +343,8 @@ std::unique_ptr<DrawableString> FontTextureManager_Android::addString(
         {
             // Now we make a rectangle that covers the glyph in its texture atlas
             DrawableString::Rect rect;
-            const float scale = 1.0f/BogusFontScale;
+            // Distance fields are all one size, so scale down to the one we want
+            const float scale = fm->sdf ? labelInfo->fontSize / SDFPointSize : 1.0f/BogusFontScale;
             const Point2f offset(offsetX,-glyphInfo->offset.y()*scale);
 
             // Note: was -1,-1
@@ -291,8 +360,9 @@ std::unique_ptr<DrawableString> FontTextureManager_Android::addString(
             drawString->mbr.addPoint(rect.pts[1]);
 
             glyphsUsed.insert(glyphInfo->glyph);
+            layoutGlyphs.emplace_back(fm->getId(),glyphInfo->glyph);
 
-            offsetX += glyphInfo->size.x() / BogusFontScale;
+            offsetX += glyphInfo->size.x() * scale;
         }
     }
 
@@ -308,20 +378,26 @@ std::unique_ptr<DrawableString> FontTextureManager_Android::addString(
 	{
 		// We need to track the glyphs we're using
 		drawStringReps.insert(drawStringRep.release());
+		addLayout(layoutKey,*drawString,std::move(layoutGlyphs));
 		return drawString;
 	}
 }
 
-FontTextureManager_Android::FontManager_AndroidRef FontTextureManager_Android::findFontManagerForFont(PlatformInfo_Android *threadInfo,jobject typefaceObj,const LabelInfo &inLabelInfo)
+FontTextureManager_Android::FontManager_AndroidRef FontTextureManager_Android::findFontManagerForFont(PlatformInfo_Android *threadInfo,jobject typefaceObj,const LabelInfo &inLabelInfo,bool sdf)
 {
 	const LabelInfoAndroid &labelInfo = (LabelInfoAndroid &)inLabelInfo;
 
+	// Distance fields are white at a fixed size, whatever the label wants
+	const float pointSize = sdf ? SDFPointSize : labelInfo.fontSize;
+	const RGBAColor color = sdf ? RGBAColor::white() : labelInfo.textColor;
+
 	for (const auto &it : fontManagers)
 	{
 		if (auto fm = std::dynamic_pointer_cast<FontManager_Android>(it.second))
 		{
-			if (fm->pointSize == labelInfo.fontSize &&
-				fm->color == labelInfo.textColor &&
+			if (fm->pointSize == pointSize &&
+				fm->sdf == sdf &&
+				fm->color == color &&
 				fm->outlineColor == labelInfo.outlineColor &&
 				fm->outlineSize == labelInfo.outlineSize &&
 				labelInfo.typefaceIsSame(threadInfo, fm->typefaceObj))
@@ -333,10 +409,32 @@ FontTextureManager_Android::FontManager_AndroidRef FontTextureManager_Android::f
 
 	// Didn't find it, so create it
 	auto fm = std::make_shared<FontManager_Android>(threadInfo,typefaceObj);
-	fm->color = labelInfo.textColor;
-	fm->pointSize = labelInfo.fontSize;
+	fm->color = color;
+	fm->pointSize = pointSize;
 	fm->outlineColor = labelInfo.outlineColor;
 	fm->outlineSize = labelInfo.outlineSize;
+	fm->sdf = sdf;
+
+	// We can only cache glyphs for typefaces that have a name
+	if (glyphCache && fontNameID && labelInfo.labelInfoObj)
+	{
+		const auto env = threadInfo->env;
+		if (auto nameObj = (jstring)env->GetObjectField(labelInfo.labelInfoObj, fontNameID))
+		{
+			{
+				JavaString fontName(env, nameObj);
+				fm->fontName = fontName.getString();
+			}
+			env->DeleteLocalRef(nameObj);
+		}
+		if (!fm->fontName.empty())
+		{
+			fm->cacheKey = GlyphCache::fontKey(sdf ? fm->fontName + "#sdf" : fm->fontName,
+			                                   fm->pointSize, fm->color, fm->backColor,
+			                                   fm->outlineColor, fm->outlineSize);
+		}
+	}
+
 	fontManagers[fm->getId()] = fm;
 
 //	wkLogLevel(Info,"Font added: fm = %d,",(int)fm->getId());
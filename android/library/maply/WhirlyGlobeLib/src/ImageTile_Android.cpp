@@ -19,6 +19,7 @@
  */
 
 #import "ImageTile_Android.h"
+#import "DecodeBufferPool.h"
 #import <android/bitmap.h>
 
 namespace WhirlyKit
@@ -69,7 +70,19 @@ void ImageTile_Android::setBitmap(JNIEnv *env,jobject bitmapObj)
     {
         if (info.height > 0 && info.width > 0)
         {
-            rawData = std::make_shared<MutableRawData>(bitmapPixels, info.height * info.width * 4);
+            // Tiles tend to be the same size, so reuse the buffers
+            unsigned char *bytes = nullptr;
+            const size_t rowBytes = (size_t)info.width * 4;
+            rawData = DecodeBufferPool::getShared().getBuffer(rowBytes * info.height,&bytes);
+            if (info.stride == rowBytes)
+            {
+                memcpy(bytes,bitmapPixels,rowBytes * info.height);
+            }
+            else
+            {
+                for (unsigned int iy=0;iy<info.height;iy++)
+                    memcpy(bytes + iy*rowBytes,(const unsigned char *)bitmapPixels + iy*info.stride,rowBytes);
+            }
         }
 
         type = MaplyImgTypeRawImage;
@@ -89,6 +102,47 @@ void ImageTile_Android::setBitmap(JNIEnv *env,jobject bitmapObj)
     AndroidBitmap_unlockPixels(env, bitmapObj);
 }
 
+bool ImageTile_Android::setCompressedData(const void *bytes,size_t len)
+{
+    // Check the header before we copy anything
+    CompressedImageInfo info;
+    if (!bytes || !ParseCompressedImage(RawDataWrapper(bytes,len,false),info))
+        return false;
+
+    return setCompressedData(std::make_shared<MutableRawData>((void *)bytes,(unsigned int)len));
+}
+
+bool ImageTile_Android::setRawImage(const RawDataRef &data,int inWidth,int inHeight)
+{
+    if (!data || inWidth <= 0 || inHeight <= 0 || data->getLen() < (size_t)inWidth * inHeight * 4)
+        return false;
+
+    rawData = data;
+    type = MaplyImgTypeRawImage;
+    borderSize = 0;
+    width = targetWidth = inWidth;
+    height = targetHeight = inHeight;
+    components = 4;
+
+    return true;
+}
+
+bool ImageTile_Android::setCompressedData(const RawDataRef &data)
+{
+    CompressedImageInfo info;
+    if (!data || !ParseCompressedImage(*data,info))
+        return false;
+
+    rawData = data;
+    type = MaplyImgTypeDataCompressed;
+    borderSize = 0;
+    width = targetWidth = info.width;
+    height = targetHeight = info.height;
+    components = 4;
+
+    return true;
+}
+
 Texture *ImageTile_Android::buildTexture()
 {
     if (tex)
@@ -114,10 +168,14 @@ Texture *ImageTile_Android::buildTexture()
         case MaplyImgTypeNone:
             break;
         case MaplyImgTypeDataPKM:
+        case MaplyImgTypeDataCompressed:
+            // Size comes from the header
             tex = new TextureGLES("ImageTile_Android");
-            tex->setPKMData(rawData);
-            tex->setWidth(destWidth);
-            tex->setHeight(destHeight);
+            if (!tex->setCompressedData(rawData))
+            {
+                delete tex;
+                tex = nullptr;
+            }
             break;
         case MaplyImgTypeDataPVRTC4:
             tex = new TextureGLES("ImageTile_Android", rawData,true);
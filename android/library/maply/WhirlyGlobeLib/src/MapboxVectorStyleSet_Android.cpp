@@ -41,7 +41,7 @@ void MapboxVectorStyleSetImpl_Android::setupMethods(JNIEnv *env)
     {
         const jclass thisClass = MapboxVectorStyleSetClassInfo::getClassInfo()->getClass();
         makeLabelInfoMethod      = env->GetMethodID(thisClass,"labelInfoForFont",  "(Ljava/lang/String;F)Lcom/mousebird/maply/LabelInfo;");
-        calculateTextWidthMethod = env->GetMethodID(thisClass,"calculateTextWidth","(Ljava/lang/String;Lcom/mousebird/maply/LabelInfo;)D");
+        glyphWidthsMethod        = env->GetMethodID(thisClass,"glyphWidths",       "([ILcom/mousebird/maply/LabelInfo;)[F");
         makeCircleTextureMethod  = env->GetMethodID(thisClass,"makeCircleTexture", "(DIIFLcom/mousebird/maply/Point2d;)J");
         makeLineTextureMethod    = env->GetMethodID(thisClass,"makeLineTexture",   "([D)J");
     }
@@ -55,6 +55,9 @@ void MapboxVectorStyleSetImpl_Android::cleanup(JNIEnv *env)
         labelInfo.second->labelInfoObj = nullptr;
     }
     labelInfos.clear();
+
+    std::lock_guard<std::mutex> guardLock(glyphLock);
+    glyphWidths.clear();
 }
 
 MapboxVectorStyleSetImpl_Android::~MapboxVectorStyleSetImpl_Android()
@@ -215,20 +218,81 @@ ComponentObjectRef MapboxVectorStyleSetImpl_Android::makeComponentObject(Platfor
 double MapboxVectorStyleSetImpl_Android::calculateTextWidth(PlatformThreadInfo *inInst,const LabelInfoRef &inLabelInfo,const std::string &text)
 {
     const auto inst = (PlatformInfo_Android *)inInst;
-    if (auto labelInfo = dynamic_cast<LabelInfoAndroid*>(inLabelInfo.get()))
+    const auto labelInfo = dynamic_cast<LabelInfoAndroid*>(inLabelInfo.get());
+    if (!labelInfo || text.empty())
     {
+        return 0.0;
+    }
+
+    try
+    {
+        std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> utf32conv;
+        const std::u32string codePoints = utf32conv.from_bytes(text);
+
+        // Add up what we know and collect what we don't
+        double width = 0.0;
+        std::vector<int> missing;
+        {
+            std::lock_guard<std::mutex> guardLock(glyphLock);
+            const auto &widths = glyphWidths[labelInfo];
+            for (const auto codePoint : codePoints)
+            {
+                const auto it = widths.find((int)codePoint);
+                if (it != widths.end())
+                {
+                    width += it->second;
+                }
+                else if (std::find(missing.begin(), missing.end(), (int)codePoint) == missing.end())
+                {
+                    missing.push_back((int)codePoint);
+                }
+            }
+        }
+        if (missing.empty())
+        {
+            return width;
+        }
+
+        // Measure the new ones all at once
+        setupMethods(inst->env);
+        jfloatArray widthArray = nullptr;
         if (auto obj = inst->env->NewLocalRef(thisObj))
         {
-            if (jstring jText = inst->env->NewStringUTF(text.c_str()))
+            if (jintArray codeArray = BuildIntArray(inst->env, missing))
             {
-                jdouble width = inst->env->CallDoubleMethod(obj, calculateTextWidthMethod, jText,
-                                                            labelInfo->labelInfoObj);
-                inst->env->DeleteLocalRef(jText);
-                inst->env->DeleteLocalRef(obj);
-                return width;
+                widthArray = (jfloatArray)inst->env->CallObjectMethod(obj, glyphWidthsMethod, codeArray, labelInfo->labelInfoObj);
+                logAndClearJVMException(inst->env, "glyphWidths");
+                inst->env->DeleteLocalRef(codeArray);
             }
+            inst->env->DeleteLocalRef(obj);
+        }
+        if (!widthArray)
+        {
+            return width;
         }
+
+        std::vector<float> newWidths;
+        ConvertFloatArray(inst->env, widthArray, newWidths);
+        inst->env->DeleteLocalRef(widthArray);
+
+        std::lock_guard<std::mutex> guardLock(glyphLock);
+        auto &widths = glyphWidths[labelInfo];
+        for (size_t ii = 0; ii < missing.size() && ii < newWidths.size(); ii++)
+        {
+            widths[missing[ii]] = newWidths[ii];
+        }
+        width = 0.0;
+        for (const auto codePoint : codePoints)
+        {
+            const auto it = widths.find((int)codePoint);
+            if (it != widths.end())
+            {
+                width += it->second;
+            }
+        }
+        return width;
     }
+    MAPLY_STD_JNI_CATCH()
     return 0.0;
 }
 
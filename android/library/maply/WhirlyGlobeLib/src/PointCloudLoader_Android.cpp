@@ -0,0 +1,58 @@
+/*  PointCloudLoader_Android.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "PointCloudLoader_Android.h"
+
+namespace WhirlyKit
+{
+
+static void AddRequest(std::vector<int> &reqs,const OctreeIdentifier &ident)
+{
+    reqs.push_back(ident.level);
+    reqs.push_back(ident.x);
+    reqs.push_back(ident.y);
+    reqs.push_back(ident.z);
+}
+
+void PointCloudSource_Android::startFetch(PointCloudLoader *,const OctreeIdentifier &ident)
+{
+    AddRequest(fetches,ident);
+}
+
+void PointCloudSource_Android::cancelFetch(PointCloudLoader *,const OctreeIdentifier &ident)
+{
+    AddRequest(cancels,ident);
+}
+
+std::vector<int> PointCloudSource_Android::takeRequests(bool which)
+{
+    std::vector<int> reqs;
+    reqs.swap(which ? cancels : fetches);
+    return reqs;
+}
+
+PointCloudLoader_Android::PointCloudLoader_Android(const Point3d &ll,const Point3d &ur,int maxLevel,double rootSpacing)
+: PointCloudLoader(ll,ur,maxLevel,rootSpacing,std::make_shared<PointCloudSource_Android>())
+{
+}
+
+PointCloudSource_Android *PointCloudLoader_Android::getRequests() const
+{
+    return (PointCloudSource_Android *)source.get();
+}
+
+}
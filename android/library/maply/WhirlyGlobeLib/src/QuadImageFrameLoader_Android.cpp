@@ -114,6 +114,13 @@ void QIFFrameAsset_Android::loadFailed(PlatformThreadInfo *threadInfo,QuadImageF
     clearRequestJava((PlatformInfo_Android *) threadInfo,(QuadImageFrameLoader_Android *)loader);
 }
 
+void QIFFrameAsset_Android::loadUnchanged(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader)
+{
+    QIFFrameAsset::loadUnchanged(threadInfo,loader);
+
+    clearRequestJava((PlatformInfo_Android *) threadInfo,(QuadImageFrameLoader_Android *)loader);
+}
+
 QIFTileAsset_Android::QIFTileAsset_Android(PlatformInfo_Android *,const QuadTreeNew::ImportantNode &ident)
         : QIFTileAsset(ident)
 {
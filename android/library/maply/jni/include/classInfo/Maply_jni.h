@@ -605,4 +605,10 @@ jobjectArray BuildObjectArray(JNIEnv *env,jclass cls,const std::vector<jobject>
 // Return new Java string array
 jobjectArray BuildStringArray(JNIEnv *env,const std::vector<std::string> &objVec);
 
+// Bytes [offset,offset+len) of a direct java.nio buffer, or null if it isn't direct or is too short.
+// Nothing is copied, so this is only good while the caller holds on to the buffer.
+const void *GetDirectBufferRange(JNIEnv *env,jobject buffer,jlong offset,jlong len);
+// Same range of a direct buffer as raw data, keeping a global reference to the buffer until the data is released
+WhirlyKit::RawDataRef WrapDirectBuffer(JNIEnv *env,jobject buffer,jlong offset,jlong len);
+
 #endif /* Maply_JNI_h_ */
@@ -19,6 +19,9 @@
 #import "Maply_jni.h"
 #import "WhirlyGlobe_Android.h"
 #import "../../../WhirlyGlobeLib/include/QuadImageFrameLoader_Android.h"
+#import "TileCacheStore.h"
+#import "TileFetchThrottle.h"
+#import "PMTilesArchive.h"
 
 typedef JavaClassInfo<WhirlyKit::SamplingParams> SamplingParamsClassInfo;
 typedef JavaClassInfo<WhirlyKit::QuadLoaderReturnRef> LoaderReturnClassInfo;
@@ -27,6 +30,11 @@ typedef JavaClassInfo<WhirlyKit::QuadImageFrameLoader_AndroidRef> QuadImageFrame
 typedef JavaClassInfo<WhirlyKit::QuadSamplingController_Android> QuadSamplingControllerInfo;
 typedef JavaClassInfo<WhirlyKit::QIFBatchOps_Android> QIFBatchOpsClassInfo;
 typedef JavaClassInfo<WhirlyKit::QIFFrameAsset_Android> QIFFrameAssetClassInfo;
+typedef JavaClassInfo<WhirlyKit::TileCacheStoreRef> TileCacheStoreClassInfo;
+typedef JavaClassInfo<WhirlyKit::TileFetchThrottle> TileFetchThrottleClassInfo;
+typedef JavaClassInfo<WhirlyKit::PMTilesArchive> PMTilesArchiveClassInfo;
+typedef JavaClassInfo<WhirlyKit::PointCloudLoader_Android> PointCloudLoaderClassInfo;
+typedef JavaClassInfo<WhirlyKit::PointCloudChunkRef> PointCloudChunkClassInfo;
 
 JNIEXPORT jobject JNICALL MakeImageTile(JNIEnv *env,WhirlyKit::ImageTile_AndroidRef imgTile);
 JNIEXPORT jobject JNICALL MakeQIFBatchOps(JNIEnv *env,WhirlyKit::QIFBatchOps_Android *batchOps);
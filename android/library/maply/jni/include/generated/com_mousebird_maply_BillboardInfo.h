@@ -23,6 +23,22 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_BillboardInfo_setColor
 JNIEXPORT void JNICALL Java_com_mousebird_maply_BillboardInfo_setOrientNative
   (JNIEnv *, jobject, jint);
 
+/*
+ * Class:     com_mousebird_maply_BillboardInfo
+ * Method:    setInstanced
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_BillboardInfo_setInstanced
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_BillboardInfo
+ * Method:    getInstanced
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_BillboardInfo_getInstanced
+  (JNIEnv *, jobject);
+
 /*
  * Class:     com_mousebird_maply_BillboardInfo
  * Method:    nativeInit
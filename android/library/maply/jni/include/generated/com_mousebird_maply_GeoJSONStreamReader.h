@@ -0,0 +1,61 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_mousebird_maply_GeoJSONStreamReader */
+
+#ifndef _Included_com_mousebird_maply_GeoJSONStreamReader
+#define _Included_com_mousebird_maply_GeoJSONStreamReader
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     com_mousebird_maply_GeoJSONStreamReader
+ * Method:    nativeInit
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeoJSONStreamReader_nativeInit
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_mousebird_maply_GeoJSONStreamReader
+ * Method:    initialise
+ * Signature: (Ljava/io/InputStream;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeoJSONStreamReader_initialise
+  (JNIEnv *, jobject, jobject);
+
+/*
+ * Class:     com_mousebird_maply_GeoJSONStreamReader
+ * Method:    dispose
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeoJSONStreamReader_dispose
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_GeoJSONStreamReader
+ * Method:    next
+ * Signature: ()Lcom/mousebird/maply/VectorObject;
+ */
+JNIEXPORT jobject JNICALL Java_com_mousebird_maply_GeoJSONStreamReader_next
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_GeoJSONStreamReader
+ * Method:    getCRS
+ * Signature: ()Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL Java_com_mousebird_maply_GeoJSONStreamReader_getCRS
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_GeoJSONStreamReader
+ * Method:    getError
+ * Signature: ()Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL Java_com_mousebird_maply_GeoJSONStreamReader_getError
+  (JNIEnv *, jobject);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
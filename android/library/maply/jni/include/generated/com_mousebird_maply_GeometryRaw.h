@@ -71,6 +71,46 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_GeometryRaw_addColors
 JNIEXPORT void JNICALL Java_com_mousebird_maply_GeometryRaw_addTriangles
   (JNIEnv *, jobject, jintArray);
 
+/*
+ * Class:     com_mousebird_maply_GeometryRaw
+ * Method:    addPointsDirect
+ * Signature: (Ljava/nio/ByteBuffer;II)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeometryRaw_addPointsDirect
+  (JNIEnv *, jobject, jobject, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_GeometryRaw
+ * Method:    addNormsDirect
+ * Signature: (Ljava/nio/ByteBuffer;II)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeometryRaw_addNormsDirect
+  (JNIEnv *, jobject, jobject, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_GeometryRaw
+ * Method:    addTexCoordsDirect
+ * Signature: (Ljava/nio/ByteBuffer;II)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeometryRaw_addTexCoordsDirect
+  (JNIEnv *, jobject, jobject, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_GeometryRaw
+ * Method:    addColorsDirect
+ * Signature: (Ljava/nio/ByteBuffer;II)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeometryRaw_addColorsDirect
+  (JNIEnv *, jobject, jobject, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_GeometryRaw
+ * Method:    addTrianglesDirect
+ * Signature: (Ljava/nio/ByteBuffer;II)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeometryRaw_addTrianglesDirect
+  (JNIEnv *, jobject, jobject, jint, jint);
+
 /*
  * Class:     com_mousebird_maply_GeometryRaw
  * Method:    nativeInit
@@ -15,6 +15,38 @@ extern "C" {
 JNIEXPORT void JNICALL Java_com_mousebird_maply_ImageTile_setBitmap
   (JNIEnv *, jobject, jobject);
 
+/*
+ * Class:     com_mousebird_maply_ImageTile
+ * Method:    setCompressedData
+ * Signature: ([B)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ImageTile_setCompressedData
+  (JNIEnv *, jobject, jbyteArray);
+
+/*
+ * Class:     com_mousebird_maply_ImageTile
+ * Method:    setCompressedDataDirect
+ * Signature: (Ljava/nio/ByteBuffer;II)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ImageTile_setCompressedDataDirect
+  (JNIEnv *, jobject, jobject, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_ImageTile
+ * Method:    setPixelsDirect
+ * Signature: (Ljava/nio/ByteBuffer;IIII)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ImageTile_setPixelsDirect
+  (JNIEnv *, jobject, jobject, jint, jint, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_ImageTile
+ * Method:    setCompressedFile
+ * Signature: (Ljava/lang/String;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ImageTile_setCompressedFile
+  (JNIEnv *, jobject, jstring);
+
 /*
  * Class:     com_mousebird_maply_ImageTile
  * Method:    setBorderSize
@@ -15,6 +15,14 @@ extern "C" {
 JNIEXPORT jlong JNICALL Java_com_mousebird_maply_LabelManager_addLabels
   (JNIEnv *, jobject, jobjectArray, jobject, jobject);
 
+/*
+ * Class:     com_mousebird_maply_LabelManager
+ * Method:    addScreenLabelBatch
+ * Signature: (ILjava/nio/ByteBuffer;Ljava/nio/ByteBuffer;[Ljava/lang/String;FILcom/mousebird/maply/LabelInfo;Lcom/mousebird/maply/ChangeSet;)J
+ */
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_LabelManager_addScreenLabelBatch
+  (JNIEnv *, jobject, jint, jobject, jobject, jobjectArray, jfloat, jint, jobject, jobject);
+
 /*
  * Class:     com_mousebird_maply_LabelManager
  * Method:    removeLabels
@@ -0,0 +1,21 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_mousebird_maply_LayerThread */
+
+#ifndef _Included_com_mousebird_maply_LayerThread
+#define _Included_com_mousebird_maply_LayerThread
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     com_mousebird_maply_LayerThread
+ * Method:    scheduleWorkerTaskNative
+ * Signature: (DLjava/lang/Runnable;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_LayerThread_scheduleWorkerTaskNative
+  (JNIEnv *, jclass, jdouble, jobject);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
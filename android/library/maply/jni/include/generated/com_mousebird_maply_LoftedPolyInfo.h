@@ -63,6 +63,22 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_LoftedPolyInfo_setOutlineSide
 JNIEXPORT void JNICALL Java_com_mousebird_maply_LoftedPolyInfo_setOutlineBottom
   (JNIEnv *, jobject, jboolean);
 
+/*
+ * Class:     com_mousebird_maply_LoftedPolyInfo
+ * Method:    setShaderExtrude
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_LoftedPolyInfo_setShaderExtrude
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_LoftedPolyInfo
+ * Method:    setMergeRoofs
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_LoftedPolyInfo_setMergeRoofs
+  (JNIEnv *, jobject, jboolean);
+
 /*
  * Class:     com_mousebird_maply_LoftedPolyInfo
  * Method:    setOutlineDrawPriority
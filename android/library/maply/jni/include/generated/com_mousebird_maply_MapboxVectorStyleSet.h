@@ -90,6 +90,14 @@ JNIEXPORT jobjectArray JNICALL Java_com_mousebird_maply_MapboxVectorStyleSet_get
 JNIEXPORT void JNICALL Java_com_mousebird_maply_MapboxVectorStyleSet_setLayerVisible
         (JNIEnv *, jobject, jstring, jboolean);
 
+/*
+ * Class:     com_mousebird_maply_MapboxVectorStyleSet
+ * Method:    updateLayerPaint
+ * Signature: (Ljava/lang/String;Lcom/mousebird/maply/AttrDictionary;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_MapboxVectorStyleSet_updateLayerPaint
+        (JNIEnv *, jobject, jstring, jobject);
+
 JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_MapboxVectorStyleSet_addSpritesNative
         (JNIEnv *, jobject, jstring, jlong, jint , jint);
 
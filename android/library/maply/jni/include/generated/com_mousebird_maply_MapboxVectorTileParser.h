@@ -24,6 +24,14 @@ extern "C" {
 JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_MapboxVectorTileParser_parseData
   (JNIEnv *, jobject, jbyteArray, jobject, jobject);
 
+/*
+ * Class:     com_mousebird_maply_MapboxVectorTileParser
+ * Method:    parseDataDirect
+ * Signature: (Ljava/nio/ByteBuffer;IILcom/mousebird/maply/VectorTileData;Lcom/mousebird/maply/LoaderReturn;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_MapboxVectorTileParser_parseDataDirect
+  (JNIEnv *, jobject, jobject, jint, jint, jobject, jobject);
+
 /*
  * Class:     com_mousebird_maply_MapboxVectorTileParser
  * Method:    setLocalCoords
@@ -23,6 +23,14 @@ JNIEXPORT jlong JNICALL Java_com_mousebird_maply_MarkerManager_addScreenMarkers
 JNIEXPORT jlong JNICALL Java_com_mousebird_maply_MarkerManager_addMarkers
   (JNIEnv *, jobject, jobjectArray, jobject, jobject);
 
+/*
+ * Class:     com_mousebird_maply_MarkerManager
+ * Method:    addScreenMarkerBatch
+ * Signature: (ILjava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Lcom/mousebird/maply/MarkerInfo;Lcom/mousebird/maply/ChangeSet;)J
+ */
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_MarkerManager_addScreenMarkerBatch
+  (JNIEnv *, jobject, jint, jobject, jobject, jobject, jobject, jobject, jobject, jobject);
+
 /*
  * Class:     com_mousebird_maply_MarkerManager
  * Method:    removeMarkers
@@ -0,0 +1,133 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_mousebird_maply_PMTilesArchive */
+
+#ifndef _Included_com_mousebird_maply_PMTilesArchive
+#define _Included_com_mousebird_maply_PMTilesArchive
+#ifdef __cplusplus
+extern "C" {
+#endif
+#undef com_mousebird_maply_PMTilesArchive_StartSize
+#define com_mousebird_maply_PMTilesArchive_StartSize 16384L
+#undef com_mousebird_maply_PMTilesArchive_TileFound
+#define com_mousebird_maply_PMTilesArchive_TileFound 0L
+#undef com_mousebird_maply_PMTilesArchive_TileMissing
+#define com_mousebird_maply_PMTilesArchive_TileMissing 1L
+#undef com_mousebird_maply_PMTilesArchive_NeedDirectory
+#define com_mousebird_maply_PMTilesArchive_NeedDirectory 2L
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    parseStart
+ * Signature: ([B)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_PMTilesArchive_parseStart
+  (JNIEnv *, jobject, jbyteArray);
+
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    isValid
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_PMTilesArchive_isValid
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    getMinZoom
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_PMTilesArchive_getMinZoom
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    getMaxZoom
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_PMTilesArchive_getMaxZoom
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    getTileType
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_PMTilesArchive_getTileType
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    getBounds
+ * Signature: ()[D
+ */
+JNIEXPORT jdoubleArray JNICALL Java_com_mousebird_maply_PMTilesArchive_getBounds
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    tileIDForTile
+ * Signature: (III)J
+ */
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_PMTilesArchive_tileIDForTile
+  (JNIEnv *, jclass, jint, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    lookup
+ * Signature: (J[J)I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_PMTilesArchive_lookup
+  (JNIEnv *, jobject, jlong, jlongArray);
+
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    addDirectory
+ * Signature: (JJ[B)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_PMTilesArchive_addDirectory
+  (JNIEnv *, jobject, jlong, jlong, jbyteArray);
+
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    decompressTile
+ * Signature: ([B)[B
+ */
+JNIEXPORT jbyteArray JNICALL Java_com_mousebird_maply_PMTilesArchive_decompressTile
+  (JNIEnv *, jobject, jbyteArray);
+
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    groupReads
+ * Signature: ([J[JJJ)[I
+ */
+JNIEXPORT jintArray JNICALL Java_com_mousebird_maply_PMTilesArchive_groupReads
+  (JNIEnv *, jclass, jlongArray, jlongArray, jlong, jlong);
+
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    nativeInit
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PMTilesArchive_nativeInit
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    initialise
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PMTilesArchive_initialise
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PMTilesArchive
+ * Method:    dispose
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PMTilesArchive_dispose
+  (JNIEnv *, jobject);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
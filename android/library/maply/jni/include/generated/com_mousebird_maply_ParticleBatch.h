@@ -47,6 +47,14 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ParticleBatch_addAttribute__
 JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ParticleBatch_addAttribute__Ljava_lang_String_2_3C
   (JNIEnv *, jobject, jstring, jcharArray);
 
+/*
+ * Class:     com_mousebird_maply_ParticleBatch
+ * Method:    addAttributeDirect
+ * Signature: (Ljava/lang/String;Ljava/nio/ByteBuffer;II)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ParticleBatch_addAttributeDirect
+  (JNIEnv *, jobject, jstring, jobject, jint, jint);
+
 /*
  * Class:     com_mousebird_maply_ParticleBatch
  * Method:    isValid
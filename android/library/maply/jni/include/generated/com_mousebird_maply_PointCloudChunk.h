@@ -0,0 +1,77 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_mousebird_maply_PointCloudChunk */
+
+#ifndef _Included_com_mousebird_maply_PointCloudChunk
+#define _Included_com_mousebird_maply_PointCloudChunk
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     com_mousebird_maply_PointCloudChunk
+ * Method:    addPoint
+ * Signature: (DDD)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_addPoint
+  (JNIEnv *, jobject, jdouble, jdouble, jdouble);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudChunk
+ * Method:    addPoints
+ * Signature: ([D)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_addPoints
+  (JNIEnv *, jobject, jdoubleArray);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudChunk
+ * Method:    addColor
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_addColor
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudChunk
+ * Method:    setChildMask
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_setChildMask
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudChunk
+ * Method:    getNumPoints
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_PointCloudChunk_getNumPoints
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudChunk
+ * Method:    nativeInit
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_nativeInit
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudChunk
+ * Method:    initialise
+ * Signature: (Lcom/mousebird/maply/Point3d;Lcom/mousebird/maply/Point3d;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_initialise
+  (JNIEnv *, jobject, jobject, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudChunk
+ * Method:    dispose
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_dispose
+  (JNIEnv *, jobject);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,133 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_mousebird_maply_PointCloudLoader */
+
+#ifndef _Included_com_mousebird_maply_PointCloudLoader
+#define _Included_com_mousebird_maply_PointCloudLoader
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    setPixelSpacing
+ * Signature: (D)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_setPixelSpacing
+  (JNIEnv *, jobject, jdouble);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    setMemoryBudget
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_setMemoryBudget
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    setMaxFetches
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_setMaxFetches
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    boundsForNode
+ * Signature: (IIIILcom/mousebird/maply/Point3d;Lcom/mousebird/maply/Point3d;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_boundsForNode
+  (JNIEnv *, jobject, jint, jint, jint, jint, jobject, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    chunkLoaded
+ * Signature: (Lcom/mousebird/maply/PointCloudChunk;IIII)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_chunkLoaded
+  (JNIEnv *, jobject, jobject, jint, jint, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    chunkFailed
+ * Signature: (IIII)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_chunkFailed
+  (JNIEnv *, jobject, jint, jint, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    getNumLoadedNodes
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_PointCloudLoader_getNumLoadedNodes
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    getNumDisplayedPoints
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_PointCloudLoader_getNumDisplayedPoints
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    startNative
+ * Signature: (Lcom/mousebird/maply/Scene;Lcom/mousebird/maply/GeometryInfo;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_startNative
+  (JNIEnv *, jobject, jobject, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    viewUpdatedNative
+ * Signature: (Lcom/mousebird/maply/ViewState;Lcom/mousebird/maply/ChangeSet;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_PointCloudLoader_viewUpdatedNative
+  (JNIEnv *, jobject, jobject, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    takeRequestsNative
+ * Signature: (Z)[I
+ */
+JNIEXPORT jintArray JNICALL Java_com_mousebird_maply_PointCloudLoader_takeRequestsNative
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    shutdownNative
+ * Signature: (Lcom/mousebird/maply/ChangeSet;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_shutdownNative
+  (JNIEnv *, jobject, jobject);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    nativeInit
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_nativeInit
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    initialise
+ * Signature: (Lcom/mousebird/maply/Point3d;Lcom/mousebird/maply/Point3d;ID)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_initialise
+  (JNIEnv *, jobject, jobject, jobject, jint, jdouble);
+
+/*
+ * Class:     com_mousebird_maply_PointCloudLoader
+ * Method:    dispose
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_dispose
+  (JNIEnv *, jobject);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -79,6 +79,30 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setRenderTa
 JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setTextureSize
   (JNIEnv *, jobject, jint, jint);
 
+/*
+ * Class:     com_mousebird_maply_QuadImageFrameLoader
+ * Method:    setAsyncTextureUpload
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setAsyncTextureUpload
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_QuadImageFrameLoader
+ * Method:    setParentPlaceholders
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setParentPlaceholders
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_QuadImageFrameLoader
+ * Method:    setReprojectSamples
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setReprojectSamples
+  (JNIEnv *, jobject, jint);
+
 /*
  * Class:     com_mousebird_maply_QuadImageFrameLoader
  * Method:    setShaderIDNative
@@ -90,10 +114,58 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setShaderID
 /*
  * Class:     com_mousebird_maply_QuadImageFrameLoader
  * Method:    getStatsNative
- * Signature: ([I[I)I
+ * Signature: ([I[I[I[J)I
  */
 JNIEXPORT jint JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_getStatsNative
-  (JNIEnv *, jobject, jintArray, jintArray);
+  (JNIEnv *, jobject, jintArray, jintArray, jintArray, jlongArray);
+
+/*
+ * Class:     com_mousebird_maply_QuadImageFrameLoader
+ * Method:    setFrameWindowNative
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setFrameWindowNative
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     com_mousebird_maply_QuadImageFrameLoader
+ * Method:    getFrameWindow
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_getFrameWindow
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_QuadImageFrameLoader
+ * Method:    setCompositeFrames
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setCompositeFrames
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_QuadImageFrameLoader
+ * Method:    getCompositeFrames
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_getCompositeFrames
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_QuadImageFrameLoader
+ * Method:    setTerrainNative
+ * Signature: (ID)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setTerrainNative
+  (JNIEnv *, jobject, jint, jdouble);
+
+/*
+ * Class:     com_mousebird_maply_QuadImageFrameLoader
+ * Method:    getTerrain
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_getTerrain
+  (JNIEnv *, jobject);
 
 #ifdef __cplusplus
 }
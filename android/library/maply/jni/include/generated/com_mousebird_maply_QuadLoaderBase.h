@@ -95,6 +95,14 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_clearLoadReturn
 JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_mergeLoaderReturn
   (JNIEnv *, jobject, jobject, jobject);
 
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    mergeLoaderReturns
+ * Signature: ([Lcom/mousebird/maply/LoaderReturn;Lcom/mousebird/maply/ChangeSet;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_mergeLoaderReturns
+  (JNIEnv *, jobject, jobjectArray, jobject);
+
 /*
  * Class:     com_mousebird_maply_QuadLoaderBase
  * Method:    samplingLayerConnectNative
@@ -167,6 +175,14 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadLoaderBase_isFrameLoadin
 JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadLoaderBase_mergeLoadedFrame
         (JNIEnv *env, jobject obj, jobject identObj, jlong frameID, jbyteArray rawData, jobject rawDataArray);
 
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    frameUnchanged
+ * Signature: (Lcom/mousebird/maply/TileID;J[B)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadLoaderBase_frameUnchanged
+        (JNIEnv *env, jobject obj, jobject identObj, jlong frameID, jbyteArray rawData);
+
 /*
  * Class:     com_mousebird_maply_QuadLoaderBase
  * Method:    getZoomSlot
@@ -183,6 +199,86 @@ JNIEXPORT jint JNICALL Java_com_mousebird_maply_QuadLoaderBase_getZoomSlot
 JNIEXPORT jint JNICALL Java_com_mousebird_maply_QuadLoaderBase_getNumFrames
         (JNIEnv *, jobject);
 
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    setSharedTaskThreads
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_setSharedTaskThreads
+  (JNIEnv *, jclass, jint);
+
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    getSharedTaskThreads
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_QuadLoaderBase_getSharedTaskThreads
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    scheduleTaskNative
+ * Signature: (DLcom/mousebird/maply/LoaderReturn;Ljava/lang/Runnable;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadLoaderBase_scheduleTaskNative
+  (JNIEnv *, jobject, jdouble, jobject, jobject);
+
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    setTileLatencyEnabled
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_setTileLatencyEnabled
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    getTileLatencyEnabled
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadLoaderBase_getTileLatencyEnabled
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    setReloadInPlace
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_setReloadInPlace
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    getReloadInPlace
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadLoaderBase_getReloadInPlace
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    clearTileLatencyStats
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_clearTileLatencyStats
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    getTileLatencyStageNames
+ * Signature: ()[Ljava/lang/String;
+ */
+JNIEXPORT jobjectArray JNICALL Java_com_mousebird_maply_QuadLoaderBase_getTileLatencyStageNames
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    getTileLatencyValues
+ * Signature: ()[D
+ */
+JNIEXPORT jdoubleArray JNICALL Java_com_mousebird_maply_QuadLoaderBase_getTileLatencyValues
+  (JNIEnv *, jobject);
+
 /*
  * Class:     com_mousebird_maply_QuadLoaderBase
  * Method:    nativeInit
@@ -33,6 +33,14 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setScene
 JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setupShadersNative
   (JNIEnv *, jobject);
 
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    setShaderCacheDir
+ * Signature: (Ljava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setShaderCacheDir
+  (JNIEnv *, jclass, jstring);
+
 /*
  * Class:     com_mousebird_maply_RenderController
  * Method:    setViewNative
@@ -89,6 +97,190 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_hasChanges
 JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setPerfInterval
   (JNIEnv *, jobject, jint);
 
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    setFramePacingNative
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setFramePacingNative
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    getFramePacingNative
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_RenderController_getFramePacingNative
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    setDisplayFrameRate
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setDisplayFrameRate
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    setDynamicResolution
+ * Signature: (ZFF)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setDynamicResolution
+  (JNIEnv *, jobject, jboolean, jfloat, jfloat);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    getDynamicResolutionScale
+ * Signature: ()F
+ */
+JNIEXPORT jfloat JNICALL Java_com_mousebird_maply_RenderController_getDynamicResolutionScale
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    setChangeBudget
+ * Signature: (DJ)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setChangeBudget
+  (JNIEnv *, jobject, jdouble, jlong);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    setFrameStatsEnabled
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setFrameStatsEnabled
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    getStartupPhaseNames
+ * Signature: ()[Ljava/lang/String;
+ */
+JNIEXPORT jobjectArray JNICALL Java_com_mousebird_maply_RenderController_getStartupPhaseNames
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    getStartupPhaseTimes
+ * Signature: ()[D
+ */
+JNIEXPORT jdoubleArray JNICALL Java_com_mousebird_maply_RenderController_getStartupPhaseTimes
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    getFrameStatsEnabled
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_getFrameStatsEnabled
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    clearFrameStats
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_clearFrameStats
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    getFrameStatNames
+ * Signature: ()[Ljava/lang/String;
+ */
+JNIEXPORT jobjectArray JNICALL Java_com_mousebird_maply_RenderController_getFrameStatNames
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    getFrameStatValues
+ * Signature: ()[D
+ */
+JNIEXPORT jdoubleArray JNICALL Java_com_mousebird_maply_RenderController_getFrameStatValues
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    setGPUTimingsEnabled
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setGPUTimingsEnabled
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    getGPUTimingsEnabled
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_getGPUTimingsEnabled
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    clearGPUTimings
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_clearGPUTimings
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    getGPUTimingNames
+ * Signature: ()[Ljava/lang/String;
+ */
+JNIEXPORT jobjectArray JNICALL Java_com_mousebird_maply_RenderController_getGPUTimingNames
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    getGPUTimingValues
+ * Signature: ()[D
+ */
+JNIEXPORT jdoubleArray JNICALL Java_com_mousebird_maply_RenderController_getGPUTimingValues
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    setFastStartup
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setFastStartup
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    getFastStartup
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_getFastStartup
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    setTraceRecording
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setTraceRecording
+  (JNIEnv *, jclass, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    setSystemTracing
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setSystemTracing
+  (JNIEnv *, jclass, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    getTraceJSON
+ * Signature: ()Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL Java_com_mousebird_maply_RenderController_getTraceJSON
+  (JNIEnv *, jclass);
+
 /*
  * Class:     com_mousebird_maply_RenderController
  * Method:    addLight
@@ -113,6 +305,22 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_replaceLights
 JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_renderToBitmapNative
   (JNIEnv *, jobject, jobject);
 
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    settleNative
+ * Signature: (D)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_settleNative
+  (JNIEnv *, jobject, jdouble);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    runOfflineBenchmarkNative
+ * Signature: (ID)Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL Java_com_mousebird_maply_RenderController_runOfflineBenchmarkNative
+  (JNIEnv *, jobject, jint, jdouble);
+
 /*
  * Class:     com_mousebird_maply_RenderController
  * Method:    nativeInit
@@ -159,6 +159,54 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setEdgeMatching
 JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getEdgeMatching
   (JNIEnv *, jobject);
 
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    setMeshTemplates
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setMeshTemplates
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    getMeshTemplates
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getMeshTemplates
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    setIncludeElev
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setIncludeElev
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    getIncludeElev
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getIncludeElev
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    setElevTextures
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setElevTextures
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    getElevTextures
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getElevTextures
+  (JNIEnv *, jobject);
+
 /*
  * Class:     com_mousebird_maply_SamplingParams
  * Method:    setTesselation
@@ -207,6 +255,54 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setSingleLevel
 JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getSingleLevel
   (JNIEnv *, jobject);
 
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    setIncrementalCoverage
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setIncrementalCoverage
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    getIncrementalCoverage
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getIncrementalCoverage
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    setDisplaySolidCacheSize
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setDisplaySolidCacheSize
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    getDisplaySolidCacheSize
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_SamplingParams_getDisplaySolidCacheSize
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    setTileMemoryBudget
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setTileMemoryBudget
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    getTileMemoryBudget
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_SamplingParams_getTileMemoryBudget
+  (JNIEnv *, jclass);
+
 /*
  * Class:     com_mousebird_maply_SamplingParams
  * Method:    setLevelLoads
@@ -63,6 +63,14 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_Sticker_setEpsilon
 JNIEXPORT void JNICALL Java_com_mousebird_maply_Sticker_setTextureIDs
   (JNIEnv *, jobject, jlongArray);
 
+/*
+ * Class:     com_mousebird_maply_Sticker
+ * Method:    setupTiledSampling
+ * Signature: (Lcom/mousebird/maply/SamplingParams;III)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_Sticker_setupTiledSampling
+  (JNIEnv *, jobject, jobject, jint, jint, jint);
+
 /*
  * Class:     com_mousebird_maply_Sticker
  * Method:    nativeInit
@@ -0,0 +1,117 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_mousebird_maply_StyleRuleFilter */
+
+#ifndef _Included_com_mousebird_maply_StyleRuleFilter
+#define _Included_com_mousebird_maply_StyleRuleFilter
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     com_mousebird_maply_StyleRuleFilter
+ * Method:    nativeInit
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_StyleRuleFilter_nativeInit
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_mousebird_maply_StyleRuleFilter
+ * Method:    addAttr
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addAttr
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     com_mousebird_maply_StyleRuleFilter
+ * Method:    addLiteral
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addLiteral
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     com_mousebird_maply_StyleRuleFilter
+ * Method:    addArith
+ * Signature: (III)I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addArith
+  (JNIEnv *, jobject, jint, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_StyleRuleFilter
+ * Method:    addCompare
+ * Signature: (IIIZ)I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addCompare
+  (JNIEnv *, jobject, jint, jint, jint, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_StyleRuleFilter
+ * Method:    addIsNull
+ * Signature: (I)I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addIsNull
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     com_mousebird_maply_StyleRuleFilter
+ * Method:    addLike
+ * Signature: (ILjava/lang/String;CCCZ)I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addLike
+  (JNIEnv *, jobject, jint, jstring, jchar, jchar, jchar, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_StyleRuleFilter
+ * Method:    addBetween
+ * Signature: (III)I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addBetween
+  (JNIEnv *, jobject, jint, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_StyleRuleFilter
+ * Method:    addLogical
+ * Signature: (I[I)I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addLogical
+  (JNIEnv *, jobject, jint, jintArray);
+
+/*
+ * Class:     com_mousebird_maply_StyleRuleFilter
+ * Method:    compile
+ * Signature: (I)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_StyleRuleFilter_compile
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     com_mousebird_maply_StyleRuleFilter
+ * Method:    test
+ * Signature: (Lcom/mousebird/maply/AttrDictionary;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_StyleRuleFilter_test
+  (JNIEnv *, jobject, jobject);
+
+/*
+ * Class:     com_mousebird_maply_StyleRuleFilter
+ * Method:    initialise
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_StyleRuleFilter_initialise
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_StyleRuleFilter
+ * Method:    dispose
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_StyleRuleFilter_dispose
+  (JNIEnv *, jobject);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -47,6 +47,14 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_Texture_setIsEmpty
 JNIEXPORT jlong JNICALL Java_com_mousebird_maply_Texture_getID
   (JNIEnv *, jobject);
 
+/*
+ * Class:     com_mousebird_maply_Texture
+ * Method:    getContentHash
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_Texture_getContentHash
+  (JNIEnv *, jobject);
+
 /*
  * Class:     com_mousebird_maply_Texture
  * Method:    nativeInit
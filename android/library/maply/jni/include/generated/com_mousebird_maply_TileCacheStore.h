@@ -0,0 +1,93 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_mousebird_maply_TileCacheStore */
+
+#ifndef _Included_com_mousebird_maply_TileCacheStore
+#define _Included_com_mousebird_maply_TileCacheStore
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     com_mousebird_maply_TileCacheStore
+ * Method:    contains
+ * Signature: (Ljava/lang/String;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_TileCacheStore_contains
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     com_mousebird_maply_TileCacheStore
+ * Method:    find
+ * Signature: (Ljava/lang/String;)[B
+ */
+JNIEXPORT jbyteArray JNICALL Java_com_mousebird_maply_TileCacheStore_find
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     com_mousebird_maply_TileCacheStore
+ * Method:    add
+ * Signature: (Ljava/lang/String;[B)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_TileCacheStore_add
+  (JNIEnv *, jobject, jstring, jbyteArray);
+
+/*
+ * Class:     com_mousebird_maply_TileCacheStore
+ * Method:    remove
+ * Signature: (Ljava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCacheStore_remove
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     com_mousebird_maply_TileCacheStore
+ * Method:    setMaxSize
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCacheStore_setMaxSize
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_mousebird_maply_TileCacheStore
+ * Method:    setLifetime
+ * Signature: (D)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCacheStore_setLifetime
+  (JNIEnv *, jobject, jdouble);
+
+/*
+ * Class:     com_mousebird_maply_TileCacheStore
+ * Method:    getSize
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_TileCacheStore_getSize
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_TileCacheStore
+ * Method:    nativeInit
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCacheStore_nativeInit
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_mousebird_maply_TileCacheStore
+ * Method:    initialise
+ * Signature: (Ljava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCacheStore_initialise
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     com_mousebird_maply_TileCacheStore
+ * Method:    dispose
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCacheStore_dispose
+  (JNIEnv *, jobject);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,101 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_mousebird_maply_TileFetchThrottle */
+
+#ifndef _Included_com_mousebird_maply_TileFetchThrottle
+#define _Included_com_mousebird_maply_TileFetchThrottle
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     com_mousebird_maply_TileFetchThrottle
+ * Method:    setLimits
+ * Signature: (II)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_setLimits
+  (JNIEnv *, jobject, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_TileFetchThrottle
+ * Method:    canStart
+ * Signature: (Ljava/lang/String;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_TileFetchThrottle_canStart
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     com_mousebird_maply_TileFetchThrottle
+ * Method:    started
+ * Signature: (Ljava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_started
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     com_mousebird_maply_TileFetchThrottle
+ * Method:    finished
+ * Signature: (Ljava/lang/String;DJ)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_finished
+  (JNIEnv *, jobject, jstring, jdouble, jlong);
+
+/*
+ * Class:     com_mousebird_maply_TileFetchThrottle
+ * Method:    failed
+ * Signature: (Ljava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_failed
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     com_mousebird_maply_TileFetchThrottle
+ * Method:    cancelled
+ * Signature: (Ljava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_cancelled
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     com_mousebird_maply_TileFetchThrottle
+ * Method:    getLimit
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_TileFetchThrottle_getLimit
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     com_mousebird_maply_TileFetchThrottle
+ * Method:    getRate
+ * Signature: ()D
+ */
+JNIEXPORT jdouble JNICALL Java_com_mousebird_maply_TileFetchThrottle_getRate
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_TileFetchThrottle
+ * Method:    nativeInit
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_nativeInit
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_mousebird_maply_TileFetchThrottle
+ * Method:    initialise
+ * Signature: (II)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_initialise
+  (JNIEnv *, jobject, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_TileFetchThrottle
+ * Method:    dispose
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_dispose
+  (JNIEnv *, jobject);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
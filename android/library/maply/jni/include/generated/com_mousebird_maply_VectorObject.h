@@ -71,6 +71,22 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_VectorObject_addPoint
 JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_VectorObject_addLinear
   (JNIEnv *, jobject, jobjectArray);
 
+/*
+ * Class:     com_mousebird_maply_VectorObject
+ * Method:    addLinearDirect
+ * Signature: (Ljava/nio/ByteBuffer;II)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_VectorObject_addLinearDirect
+  (JNIEnv *, jobject, jobject, jint, jint);
+
+/*
+ * Class:     com_mousebird_maply_VectorObject
+ * Method:    addArealDirect
+ * Signature: (Ljava/nio/ByteBuffer;II[I)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_VectorObject_addArealDirect
+  (JNIEnv *, jobject, jobject, jint, jint, jintArray);
+
 /*
  * Class:     com_mousebird_maply_VectorObject
  * Method:    addAreal
@@ -63,6 +63,14 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_VectorTileData_addComponentObjec
 JNIEXPORT void JNICALL Java_com_mousebird_maply_VectorTileData_addComponentObjects
   (JNIEnv *, jobject, jobjectArray);
 
+/*
+ * Class:     com_mousebird_maply_VectorTileData
+ * Method:    addComponentObjectsTo
+ * Signature: (Lcom/mousebird/maply/LoaderReturn;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_VectorTileData_addComponentObjectsTo
+  (JNIEnv *, jobject, jobject);
+
 /*
  * Class:     com_mousebird_maply_VectorTileData
  * Method:    getChangeSet
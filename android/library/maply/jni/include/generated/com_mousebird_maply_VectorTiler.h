@@ -0,0 +1,53 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_mousebird_maply_VectorTiler */
+
+#ifndef _Included_com_mousebird_maply_VectorTiler
+#define _Included_com_mousebird_maply_VectorTiler
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     com_mousebird_maply_VectorTiler
+ * Method:    nativeInit
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_VectorTiler_nativeInit
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_mousebird_maply_VectorTiler
+ * Method:    initialise
+ * Signature: (IIIDD)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_VectorTiler_initialise
+  (JNIEnv *, jobject, jint, jint, jint, jdouble, jdouble);
+
+/*
+ * Class:     com_mousebird_maply_VectorTiler
+ * Method:    dispose
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_VectorTiler_dispose
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_VectorTiler
+ * Method:    addVectorsNative
+ * Signature: (Lcom/mousebird/maply/VectorObject;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_VectorTiler_addVectorsNative
+  (JNIEnv *, jobject, jobject);
+
+/*
+ * Class:     com_mousebird_maply_VectorTiler
+ * Method:    getTile
+ * Signature: (III)[Lcom/mousebird/maply/VectorObject;
+ */
+JNIEXPORT jobjectArray JNICALL Java_com_mousebird_maply_VectorTiler_getTile
+  (JNIEnv *, jobject, jint, jint, jint);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
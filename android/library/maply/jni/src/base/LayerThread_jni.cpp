@@ -0,0 +1,68 @@
+/*  LayerThread_jni.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <jni.h>
+#import "Maply_jni.h"
+#import "com_mousebird_maply_LayerThread.h"
+#import <Exceptions_jni.h>
+#import "ScopedEnv_Android.h"
+#import "TaskScheduler.h"
+
+using namespace WhirlyKit;
+
+static JavaVM *workerJVM = nullptr;
+
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_LayerThread_scheduleWorkerTaskNative
+  (JNIEnv *env, jclass, jdouble priority, jobject taskObj)
+{
+    try
+    {
+        // The shared threads are turned on through QuadLoaderBase.setSharedTaskThreads()
+        auto &scheduler = TaskScheduler::getShared();
+        if (!taskObj || scheduler.getNumThreads() <= 0)
+        {
+            return false;
+        }
+        if (!workerJVM && env->GetJavaVM(&workerJVM) != JNI_OK)
+        {
+            workerJVM = nullptr;
+            return false;
+        }
+
+        static const jmethodID runMethod = [env]{
+            const jclass runnableClass = env->FindClass("java/lang/Runnable");
+            const jmethodID method = env->GetMethodID(runnableClass, "run", "()V");
+            env->DeleteLocalRef(runnableClass);
+            return method;
+        }();
+
+        // No cancel flag, the task checks in with the layer thread before doing anything
+        const jobject task = env->NewGlobalRef(taskObj);
+        scheduler.addTask(priority, nullptr, [task](bool) {
+            ScopedEnv threadEnv(workerJVM);
+            if (threadEnv)
+            {
+                threadEnv->CallVoidMethod(task, runMethod);
+                logAndClearJVMException(threadEnv, "LayerThread worker task");
+                threadEnv->DeleteGlobalRef(task);
+            }
+        });
+        return true;
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
@@ -103,3 +103,34 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_BillboardInfo_setOrientNative
     }
 }
 
+JNIEXPORT void JNICALL Java_com_mousebird_maply_BillboardInfo_setInstanced
+(JNIEnv *env, jobject obj, jboolean instanced)
+{
+    try
+    {
+        BillboardInfoClassInfo *classInfo = BillboardInfoClassInfo::getClassInfo();
+        BillboardInfoRef *inst= classInfo->getObject(env, obj);
+        if (!inst)
+            return;
+        (*inst)->instanced = instanced;
+    }
+    catch (...) {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in BillboardInfo::setInstanced()");
+    }
+}
+
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_BillboardInfo_getInstanced
+(JNIEnv *env, jobject obj)
+{
+    try
+    {
+        BillboardInfoClassInfo *classInfo = BillboardInfoClassInfo::getClassInfo();
+        BillboardInfoRef *inst= classInfo->getObject(env, obj);
+        if (inst)
+            return (*inst)->instanced;
+    }
+    catch (...) {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in BillboardInfo::getInstanced()");
+    }
+    return false;
+}
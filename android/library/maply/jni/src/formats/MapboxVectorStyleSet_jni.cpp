@@ -328,16 +328,29 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_MapboxVectorStyleSet_setLayerVis
         if (const auto styleSetRef = MapboxVectorStyleSetClassInfo::get(env,obj))
         {
             JavaString layerName(env,layerNameJava);
-            for (auto &layer : (*styleSetRef)->layers)
-            {
-                if (layer->ident == layerName.getCString())
-                {
-                    layer->visible = visible;
-                }
-            }
+            (*styleSetRef)->setLayerVisible(layerName.getCString(), visible);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_MapboxVectorStyleSet_updateLayerPaint
+  (JNIEnv *env, jobject obj, jstring layerNameJava, jobject paintObj)
+{
+    try
+    {
+        const auto styleSetRef = MapboxVectorStyleSetClassInfo::get(env,obj);
+        const auto paintDict = AttrDictClassInfo::get(env,paintObj);
+        if (styleSetRef && paintDict)
+        {
+            JavaString layerName(env,layerNameJava);
+            PlatformInfo_Android inst(env);
+            return (*styleSetRef)->updateLayerPaint(&inst, layerName.getCString(), *paintDict);
         }
     }
     MAPLY_STD_JNI_CATCH()
+    return false;
 }
 
 extern "C"
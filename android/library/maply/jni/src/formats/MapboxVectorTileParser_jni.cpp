@@ -108,26 +108,48 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_MapboxVectorTileParser_setLocalC
 static bool noCancel(PlatformThreadInfo*) { return false; }
 
 extern "C"
-JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_MapboxVectorTileParser_parseData
-    (JNIEnv *env, jobject obj, jbyteArray data, jobject vecTileDataObj, jobject loadRetObj)
+// Parse the bytes for the Java side parser, with cancellation from the loader return, if there is one
+static bool parseRawData(JNIEnv *env, jobject obj, const void *bytes, int len, jobject vecTileDataObj, jobject loadRetObj)
 {
-    try
+    const auto inst = MapboxVectorTileParserClassInfo::get(env,obj);
+    const auto tileDataPtr = VectorTileDataClassInfo::get(env,vecTileDataObj);
+    const auto tileData = tileDataPtr ? *tileDataPtr : nullptr;
+    if (!inst || !tileData)
     {
-        const auto inst = MapboxVectorTileParserClassInfo::get(env,obj);
-        const auto tileDataPtr = VectorTileDataClassInfo::get(env,vecTileDataObj);
-        const auto tileData = tileDataPtr ? *tileDataPtr : nullptr;
-        if (!inst || !tileData)
+        return false;
+    }
+
+    const auto loadRetPtr = LoaderReturnClassInfo::get(env,loadRetObj);
+    const auto loadRet = (loadRetPtr && *loadRetPtr) ? loadRetPtr->get() : nullptr;
+
+    using CancelFunction = MapboxVectorTileParser::CancelFunction;
+    const CancelFunction loadRetCancel = [=](auto){return loadRet->cancel;};
+    const auto cancelFn = loadRet ? loadRetCancel : noCancel;
+
+    // Need a pointer to this JNIEnv for low level parsing callbacks
+    PlatformInfo_Android platformInfo(env);
+
+    // Tiles usually come gzipped.  Inflate them here rather than going through Java streams.
+    if (RawDataIsCompressed(bytes, len))
+    {
+        thread_local std::vector<unsigned char> inflated;
+        if (!RawDataInflate(bytes, len, inflated))
         {
             return false;
         }
+        RawDataWrapper rawDataWrap(inflated.data(), inflated.size(), false);
+        return inst->parse(&platformInfo,&rawDataWrap,tileData.get(),cancelFn);
+    }
 
-        const auto loadRetPtr = LoaderReturnClassInfo::get(env,loadRetObj);
-        const auto loadRet = (loadRetPtr && *loadRetPtr) ? loadRetPtr->get() : nullptr;
-
-        using CancelFunction = MapboxVectorTileParser::CancelFunction;
-        const CancelFunction loadRetCancel = [=](auto){return loadRet->cancel;};
-        const auto cancelFn = loadRet ? loadRetCancel : noCancel;
+    RawDataWrapper rawDataWrap(bytes, len, false);
+    return inst->parse(&platformInfo,&rawDataWrap,tileData.get(),cancelFn);
+}
 
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_MapboxVectorTileParser_parseData
+    (JNIEnv *env, jobject obj, jbyteArray data, jobject vecTileDataObj, jobject loadRetObj)
+{
+    try
+    {
         // Copy data into a temporary buffer (must we?)
         const int len = env->GetArrayLength(data);
         bool ret = false;
@@ -135,11 +157,7 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_MapboxVectorTileParser_parse
         {
             try
             {
-                // Need a pointer to this JNIEnv for low level parsing callbacks
-                PlatformInfo_Android platformInfo(env);
-
-                RawDataWrapper rawDataWrap(rawData, len, false);
-                ret = inst->parse(&platformInfo,&rawDataWrap,tileData.get(),cancelFn);
+                ret = parseRawData(env,obj,rawData,len,vecTileDataObj,loadRetObj);
             }
             catch (...)
             {
@@ -159,3 +177,20 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_MapboxVectorTileParser_parse
 
     return false;
 }
+
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_MapboxVectorTileParser_parseDataDirect
+    (JNIEnv *env, jobject obj, jobject buffer, jint offset, jint len, jobject vecTileDataObj, jobject loadRetObj)
+{
+    try
+    {
+        // Parsed in place, the caller holds on to the buffer until we're done
+        const void *bytes = GetDirectBufferRange(env,buffer,offset,len);
+        return bytes && parseRawData(env,obj,bytes,len,vecTileDataObj,loadRetObj);
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in MapboxVectorTileParser::parseDataDirect()");
+    }
+
+    return false;
+}
@@ -21,6 +21,7 @@
 #import <Vectors_jni.h>
 #import <Components_jni.h>
 #import <Scene_jni.h>
+#import <QuadLoading_jni.h>
 #import "com_mousebird_maply_VectorTileData.h"
 
 using namespace WhirlyKit;
@@ -302,6 +303,40 @@ JNIEXPORT jobjectArray JNICALL Java_com_mousebird_maply_VectorTileData_getVector
     return nullptr;
 }
 
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_VectorTileData_addComponentObjectsTo(JNIEnv *env, jobject obj, jobject loadReturnObj)
+{
+    try
+    {
+        const auto tileData = VectorTileDataClassInfo::get(env,obj);
+        const auto loadReturn = LoaderReturnClassInfo::get(env,loadReturnObj);
+        if (!tileData || !loadReturn)
+        {
+            return;
+        }
+
+        // Overlays go in their own list, everything else in the regular one
+        SimpleIDSet ovlIDs;
+        const auto it = (*tileData)->categories.find("overlay");
+        if (it != (*tileData)->categories.end())
+        {
+            for (const auto &compObj : it->second)
+            {
+                ovlIDs.insert(compObj->getId());
+                (*loadReturn)->ovlCompObjs.push_back(compObj);
+            }
+        }
+        for (const auto &compObj : (*tileData)->compObjs)
+        {
+            if (ovlIDs.find(compObj->getId()) == ovlIDs.end())
+            {
+                (*loadReturn)->compObjs.push_back(compObj);
+            }
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
 extern "C"
 JNIEXPORT jobject JNICALL Java_com_mousebird_maply_VectorTileData_getChangeSet(JNIEnv *env, jobject obj)
 {
@@ -226,3 +226,118 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_GeometryRaw_addTriangles
         __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in GeometryRaw::addTriangles()");
     }
 }
+
+// Copy values straight out of a direct buffer.  The buffer may not be aligned for T, hence the memcpy.
+template <typename T> static bool ReadDirectBuffer(JNIEnv *env,jobject buffer,jint offset,jint len,std::vector<T> &vals)
+{
+    const void *data = GetDirectBufferRange(env,buffer,offset,len);
+    if (!data)
+    {
+        __android_log_print(ANDROID_LOG_WARN, "Maply", "GeometryRaw given a buffer that isn't direct or is too short");
+        return false;
+    }
+    vals.resize(len / sizeof(T));
+    if (!vals.empty())
+        memcpy(&vals[0],data,vals.size() * sizeof(T));
+    return true;
+}
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeometryRaw_addPointsDirect
+(JNIEnv *env, jobject obj, jobject buffer, jint offset, jint len)
+{
+    try
+    {
+        GeometryRaw *rawGeom = GeometryRawClassInfo::getClassInfo()->getObject(env, obj);
+        std::vector<double> vals;
+        if (!rawGeom || !ReadDirectBuffer(env,buffer,offset,len,vals))
+            return;
+
+        rawGeom->pts.resize(vals.size() / 3);
+        for (unsigned int ii=0;ii<rawGeom->pts.size();ii++)
+            rawGeom->pts[ii] = Point3d(vals[3*ii+0],vals[3*ii+1],vals[3*ii+2]);
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in GeometryRaw::addPointsDirect()");
+    }
+}
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeometryRaw_addNormsDirect
+(JNIEnv *env, jobject obj, jobject buffer, jint offset, jint len)
+{
+    try
+    {
+        GeometryRaw *rawGeom = GeometryRawClassInfo::getClassInfo()->getObject(env, obj);
+        std::vector<double> vals;
+        if (!rawGeom || !ReadDirectBuffer(env,buffer,offset,len,vals))
+            return;
+
+        rawGeom->norms.resize(vals.size() / 3);
+        for (unsigned int ii=0;ii<rawGeom->norms.size();ii++)
+            rawGeom->norms[ii] = Point3d(vals[3*ii+0],vals[3*ii+1],vals[3*ii+2]);
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in GeometryRaw::addNormsDirect()");
+    }
+}
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeometryRaw_addTexCoordsDirect
+(JNIEnv *env, jobject obj, jobject buffer, jint offset, jint len)
+{
+    try
+    {
+        GeometryRaw *rawGeom = GeometryRawClassInfo::getClassInfo()->getObject(env, obj);
+        std::vector<float> vals;
+        if (!rawGeom || !ReadDirectBuffer(env,buffer,offset,len,vals))
+            return;
+
+        rawGeom->texCoords.reserve(rawGeom->texCoords.size() + vals.size() / 2);
+        for (unsigned int ii=0;ii+1<vals.size();ii+=2)
+            rawGeom->texCoords.push_back(TexCoord(vals[ii],vals[ii+1]));
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in GeometryRaw::addTexCoordsDirect()");
+    }
+}
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeometryRaw_addColorsDirect
+(JNIEnv *env, jobject obj, jobject buffer, jint offset, jint len)
+{
+    try
+    {
+        GeometryRaw *rawGeom = GeometryRawClassInfo::getClassInfo()->getObject(env, obj);
+        std::vector<int> vals;
+        if (!rawGeom || !ReadDirectBuffer(env,buffer,offset,len,vals))
+            return;
+
+        rawGeom->colors.reserve(rawGeom->colors.size() + vals.size());
+        for (const int iVal : vals)
+            rawGeom->colors.emplace_back((iVal >> 16) & 0xff,(iVal >> 8) & 0xff,(iVal) & 0xff,(iVal >> 24) & 0xff);
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in GeometryRaw::addColorsDirect()");
+    }
+}
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeometryRaw_addTrianglesDirect
+(JNIEnv *env, jobject obj, jobject buffer, jint offset, jint len)
+{
+    try
+    {
+        GeometryRaw *rawGeom = GeometryRawClassInfo::getClassInfo()->getObject(env, obj);
+        std::vector<int> vals;
+        if (!rawGeom || !ReadDirectBuffer(env,buffer,offset,len,vals))
+            return;
+
+        rawGeom->triangles.resize(vals.size()/3);
+        for (unsigned int ii=0;ii<rawGeom->triangles.size();ii++)
+            rawGeom->triangles[ii] = GeometryRaw::RawTriangle(vals[3*ii+0],vals[3*ii+1],vals[3*ii+2]);
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in GeometryRaw::addTrianglesDirect()");
+    }
+}
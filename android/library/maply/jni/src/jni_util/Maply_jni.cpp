@@ -432,3 +432,41 @@ jobjectArray BuildStringArray(JNIEnv *env,const std::vector<std::string> &objVec
     return nullptr;
 }
 
+
+const void *GetDirectBufferRange(JNIEnv *env,jobject buffer,jlong offset,jlong len)
+{
+    if (!buffer || offset < 0 || len < 0)
+        return nullptr;
+
+    const auto base = (const unsigned char *)env->GetDirectBufferAddress(buffer);
+    if (!base || env->GetDirectBufferCapacity(buffer) < offset + len)
+        return nullptr;
+    return base + offset;
+}
+
+RawDataRef WrapDirectBuffer(JNIEnv *env,jobject buffer,jlong offset,jlong len)
+{
+    JavaVM *vm = nullptr;
+    const void *data = GetDirectBufferRange(env,buffer,offset,len);
+    if (!data || env->GetJavaVM(&vm) != JNI_OK)
+        return nullptr;
+
+    const jobject bufferRef = env->NewGlobalRef(buffer);
+    if (!bufferRef)
+        return nullptr;
+
+    // The data may be let go of on a thread that's not attached, in which case we attach just long enough
+    return std::make_shared<RawDataWrapper>(data,(unsigned long)len,[vm,bufferRef](const void *)
+    {
+        JNIEnv *releaseEnv = nullptr;
+        if (vm->GetEnv((void **)&releaseEnv,JNI_VERSION_1_6) == JNI_OK)
+        {
+            releaseEnv->DeleteGlobalRef(bufferRef);
+        }
+        else if (vm->AttachCurrentThread(&releaseEnv,nullptr) == JNI_OK)
+        {
+            releaseEnv->DeleteGlobalRef(bufferRef);
+            vm->DetachCurrentThread();
+        }
+    });
+}
@@ -127,6 +127,120 @@ JNIEXPORT jlong JNICALL Java_com_mousebird_maply_LabelManager_addLabels
     return EmptyIdentity;
 }
 
+// Break up UTF-16 text by newlines, into code points
+static void AddTextLines(JNIEnv *env,jstring textObj,SingleLabelAndroid &label)
+{
+	const jsize len = env->GetStringLength(textObj);
+	const jchar *chars = len ? env->GetStringCritical(textObj,nullptr) : nullptr;
+	if (!chars)
+		return;
+
+	std::vector<int> line;
+	for (jsize ii = 0; ii < len; ii++)
+	{
+		int codePoint = chars[ii];
+		if (codePoint >= 0xD800 && codePoint < 0xDC00 && ii + 1 < len &&
+			chars[ii+1] >= 0xDC00 && chars[ii+1] < 0xE000)
+		{
+			codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (chars[ii+1] - 0xDC00);
+			ii++;
+		}
+		if (codePoint == '\n')
+		{
+			label.codePointsLines.push_back(std::move(line));
+			line.clear();
+		}
+		else
+		{
+			line.push_back(codePoint);
+		}
+	}
+	env->ReleaseStringCritical(textObj,chars);
+
+	if (!line.empty())
+		label.codePointsLines.push_back(std::move(line));
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_LabelManager_addScreenLabelBatch
+  (JNIEnv *env, jobject obj, jint count, jobject locsBuf, jobject importanceBuf, jobjectArray textArray,
+   jfloat infoImportance, jint infoPlacement, jobject labelInfoObj, jobject changeSetObj)
+{
+	try
+	{
+		LabelManagerRef *labelManager = LabelManagerClassInfo::get(env,obj);
+		LabelInfoAndroidRef *labelInfo = LabelInfoClassInfo::get(env,labelInfoObj);
+		ChangeSetRef *changeSet = ChangeSetClassInfo::get(env,changeSetObj);
+		if (!labelManager || !labelInfo || !changeSet || !textArray || count <= 0)
+		{
+			__android_log_print(ANDROID_LOG_WARN, "Maply", "One of the inputs was null in LabelManager::addScreenLabelBatch()");
+			return EmptyIdentity;
+		}
+
+		const auto locs = (const unsigned char *)GetDirectBufferRange(env,locsBuf,0,count * 2 * sizeof(double));
+		const auto importance = (const unsigned char *)GetDirectBufferRange(env,importanceBuf,0,count * sizeof(float));
+		if (!locs || !importance || env->GetArrayLength(textArray) < count)
+		{
+			__android_log_print(ANDROID_LOG_WARN, "Maply", "Label batch buffers must be direct and hold %d labels",(int)count);
+			return EmptyIdentity;
+		}
+
+		std::vector<std::unique_ptr<SingleLabelAndroid>> labelStore;
+		std::vector<SingleLabel *> labels;
+		labelStore.reserve(count);
+		labels.reserve(count);
+		for (int ii = 0; ii < count; ii++)
+		{
+			jobject textObj = env->GetObjectArrayElement(textArray,ii);
+			if (!textObj)
+				continue;
+
+			std::unique_ptr<SingleLabelAndroid> label(new SingleLabelAndroid());
+			AddTextLines(env,(jstring)textObj,*label);
+			env->DeleteLocalRef(textObj);
+			if (label->codePointsLines.empty())
+				continue;
+
+			double loc[2];
+			float layoutImportance;
+			memcpy(loc, locs + ii * sizeof(loc), sizeof(loc));
+			memcpy(&layoutImportance, importance + ii * sizeof(layoutImportance), sizeof(layoutImportance));
+
+			// Same precedence as InternalLabel: the label's own, then the info's
+			label->loc = GeoCoord(loc[0],loc[1]);
+			label->layoutImportance = (layoutImportance != MAXFLOAT) ? layoutImportance : infoImportance;
+			label->layoutEngine = label->layoutImportance < MAXFLOAT;
+			if (infoPlacement != -1)
+				label->layoutPlacement = infoPlacement;
+
+			labels.push_back(label.get());
+			labelStore.push_back(std::move(label));
+		}
+
+		if ((*labelInfo)->programID == EmptyIdentity)
+		{
+			if (auto prog = (*labelManager)->getScene()->findProgramByName(MaplyScreenSpaceDefaultShader))
+			{
+				(*labelInfo)->programID = prog->getId();
+			}
+		}
+
+		// We need this in the depths of the engine
+		(*labelInfo)->labelInfoObj = labelInfoObj;
+		PlatformInfo_Android platformInfo(env);
+		const SimpleIdentity labelId = (*labelManager)->addLabels(&platformInfo,labels,**labelInfo,**changeSet);
+		(*labelInfo)->labelInfoObj = nullptr;
+
+		return labelId;
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in LabelManager::addScreenLabelBatch()");
+	}
+
+	return EmptyIdentity;
+}
+
 extern "C"
 JNIEXPORT void JNICALL Java_com_mousebird_maply_LabelManager_removeLabels
   (JNIEnv *env, jobject obj, jlongArray idArrayObj, jobject changeSetObj)
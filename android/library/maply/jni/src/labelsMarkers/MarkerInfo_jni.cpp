@@ -282,6 +282,35 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_MarkerInfo_setClusterGroup
     MAPLY_STD_JNI_CATCH()
 }
 
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_MarkerInfo_setInstanced
+        (JNIEnv *env, jobject obj, jboolean instanced)
+{
+    try
+    {
+        if (const auto info = MarkerInfoClassInfo::get(env,obj))
+        {
+            (*info)->instanced = instanced;
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_MarkerInfo_getInstanced
+        (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto info = MarkerInfoClassInfo::get(env,obj))
+        {
+            return (*info)->instanced;
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
 extern "C"
 JNIEXPORT void JNICALL Java_com_mousebird_maply_MarkerInfo_setZoomSlot
         (JNIEnv *env, jobject obj, jint slot)
@@ -175,6 +175,76 @@ JNIEXPORT jlong JNICALL Java_com_mousebird_maply_MarkerManager_addScreenMarkers
     return EmptyIdentity;
 }
 
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_MarkerManager_addScreenMarkerBatch
+	(JNIEnv *env, jobject obj, jint count, jobject locsBuf, jobject sizesBuf, jobject texIDsBuf,
+	 jobject colorsBuf, jobject importanceBuf, jobject markerInfoObj, jobject changeSetObj)
+{
+	try
+	{
+		MarkerManagerRef *markerManager = MarkerManagerClassInfo::getClassInfo()->getObject(env,obj);
+		MarkerInfoRef *markerInfo = MarkerInfoClassInfo::getClassInfo()->getObject(env,markerInfoObj);
+		ChangeSetRef *changeSet = ChangeSetClassInfo::getClassInfo()->getObject(env,changeSetObj);
+		if (!markerManager || !markerInfo || !changeSet || count <= 0)
+		{
+			__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "One of the inputs was null in MarkerManager::addScreenMarkerBatch()");
+			return EmptyIdentity;
+		}
+
+		// One value (or pair) per marker in each, packed tight and in native order
+		const auto locs = (const unsigned char *)GetDirectBufferRange(env,locsBuf,0,count * 2 * sizeof(double));
+		const auto sizes = (const unsigned char *)GetDirectBufferRange(env,sizesBuf,0,count * 2 * sizeof(float));
+		const auto texIDs = (const unsigned char *)GetDirectBufferRange(env,texIDsBuf,0,count * sizeof(jlong));
+		const auto colors = (const unsigned char *)GetDirectBufferRange(env,colorsBuf,0,count * sizeof(jint));
+		const auto importance = (const unsigned char *)GetDirectBufferRange(env,importanceBuf,0,count * sizeof(float));
+		if (!locs || !sizes || !texIDs || !colors || !importance)
+		{
+			__android_log_print(ANDROID_LOG_WARN, "Maply", "Marker batch buffers must be direct and hold %d markers",(int)count);
+			return EmptyIdentity;
+		}
+
+		std::vector<Marker,Eigen::aligned_allocator<Marker>> markerStore(count);
+		std::vector<Marker *> markers(count);
+		for (int ii = 0; ii < count; ii++)
+		{
+			double loc[2];
+			float size[2];
+			jlong texID;
+			jint color;
+			float layoutImportance;
+			memcpy(loc, locs + ii * sizeof(loc), sizeof(loc));
+			memcpy(size, sizes + ii * sizeof(size), sizeof(size));
+			memcpy(&texID, texIDs + ii * sizeof(texID), sizeof(texID));
+			memcpy(&color, colors + ii * sizeof(color), sizeof(color));
+			memcpy(&layoutImportance, importance + ii * sizeof(layoutImportance), sizeof(layoutImportance));
+
+			Marker &marker = markerStore[ii];
+			marker.loc = GeoCoord(loc[0], loc[1]);
+			marker.width = size[0];
+			marker.height = size[1];
+			if (texID != EmptyIdentity)
+				marker.texIDs.push_back(texID);
+			marker.color = RGBAColor::FromARGBInt(color);
+			marker.layoutImportance = layoutImportance;
+			markers[ii] = &marker;
+		}
+
+		(*markerInfo)->screenObject = true;
+		if ((*markerInfo)->programID == EmptyIdentity)
+		{
+			if (Program *prog = (*markerManager)->getScene()->findProgramByName(MaplyScreenSpaceDefaultShader))
+				(*markerInfo)->programID = prog->getId();
+		}
+
+		return (*markerManager)->addMarkers(markers,*(*markerInfo),*(changeSet->get()));
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in MarkerManager::addScreenMarkerBatch()");
+	}
+
+	return EmptyIdentity;
+}
+
 JNIEXPORT void JNICALL Java_com_mousebird_maply_MarkerManager_removeMarkers
   (JNIEnv *env, jobject obj, jlongArray idArrayObj, jobject changeSetObj)
 {
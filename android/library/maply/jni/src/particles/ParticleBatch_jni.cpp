@@ -159,6 +159,30 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ParticleBatch_addAttribute__
     return ret;
 }
 
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ParticleBatch_addAttributeDirect
+  (JNIEnv *env, jobject obj, jstring inName, jobject buffer, jint offset, jint len)
+{
+    bool ret = false;
+
+    try {
+        ParticleBatch_Android *batch = ParticleBatchClassInfo::getClassInfo()->getObject(env, obj);
+        if (!batch)
+            return false;
+
+        // The batch keeps its own copy, so this is the only one we make
+        const void *body = GetDirectBufferRange(env,buffer,offset,len);
+        if (!body)
+            return false;
+        JavaString name(env,inName);
+        ret = batch->addAttributeDataChar(name.getCString(),(const char *)body,len);
+    } catch (...) {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in ParticleBatch::addAttributeDirect()");
+    }
+
+    return ret;
+}
+
 extern "C"
 JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ParticleBatch_isValid(JNIEnv *env, jobject obj)
 {
@@ -92,6 +92,93 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_ImageTile_setBitmap
 	}
 }
 
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ImageTile_setCompressedData
+  (JNIEnv *env, jobject obj, jbyteArray data)
+{
+	try
+	{
+		ImageTile_AndroidRef *imageTile = ImageTileClassInfo::getClassInfo()->getObject(env,obj);
+		if (!imageTile || !data)
+		    return false;
+
+		const jsize len = env->GetArrayLength(data);
+		jboolean isCopy = false;
+		auto bytes = len ? env->GetPrimitiveArrayCritical(data, &isCopy) : nullptr;
+		if (!bytes)
+		    return false;
+		const bool ret = (*imageTile)->setCompressedData(bytes,(size_t)len);
+		env->ReleasePrimitiveArrayCritical(data, bytes, JNI_ABORT);
+
+		return ret;
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in ImageTile::setCompressedData()");
+	}
+
+	return false;
+}
+
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ImageTile_setCompressedDataDirect
+  (JNIEnv *env, jobject obj, jobject buffer, jint offset, jint len)
+{
+	try
+	{
+		ImageTile_AndroidRef *imageTile = ImageTileClassInfo::getClassInfo()->getObject(env,obj);
+		if (!imageTile)
+		    return false;
+
+		// Goes to the GPU straight from the buffer, which we hang on to until then
+		return (*imageTile)->setCompressedData(WrapDirectBuffer(env,buffer,offset,len));
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in ImageTile::setCompressedDataDirect()");
+	}
+
+	return false;
+}
+
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ImageTile_setPixelsDirect
+  (JNIEnv *env, jobject obj, jobject buffer, jint offset, jint len, jint width, jint height)
+{
+	try
+	{
+		ImageTile_AndroidRef *imageTile = ImageTileClassInfo::getClassInfo()->getObject(env,obj);
+		if (!imageTile)
+		    return false;
+
+		return (*imageTile)->setRawImage(WrapDirectBuffer(env,buffer,offset,len),width,height);
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in ImageTile::setPixelsDirect()");
+	}
+
+	return false;
+}
+
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_ImageTile_setCompressedFile
+  (JNIEnv *env, jobject obj, jstring pathStr)
+{
+	try
+	{
+		ImageTile_AndroidRef *imageTile = ImageTileClassInfo::getClassInfo()->getObject(env,obj);
+		JavaString path(env,pathStr);
+		if (!imageTile || !path)
+		    return false;
+
+		// Goes to the GPU straight from the mapping
+		return (*imageTile)->setCompressedData(RawDataMapped::mapFile(path.getCString(),RawDataMapped::AccessSequential));
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in ImageTile::setCompressedFile()");
+	}
+
+	return false;
+}
+
 JNIEXPORT void JNICALL Java_com_mousebird_maply_ImageTile_setBorderSize
   (JNIEnv *env, jobject obj, jint borderSize)
 {
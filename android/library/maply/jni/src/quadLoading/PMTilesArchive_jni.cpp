@@ -0,0 +1,293 @@
+/*
+ *  PMTilesArchive_jni.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "QuadLoading_jni.h"
+#import "com_mousebird_maply_PMTilesArchive.h"
+
+using namespace WhirlyKit;
+
+template<> PMTilesArchiveClassInfo *PMTilesArchiveClassInfo::classInfoObj = nullptr;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PMTilesArchive_nativeInit
+    (JNIEnv *env, jclass cls)
+{
+    PMTilesArchiveClassInfo::getClassInfo(env,cls);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PMTilesArchive_initialise
+    (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        PMTilesArchiveClassInfo::set(env,obj,new PMTilesArchive());
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+static std::mutex disposeMutex;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PMTilesArchive_dispose
+    (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        const auto classInfo = PMTilesArchiveClassInfo::getClassInfo();
+        std::lock_guard<std::mutex> lock(disposeMutex);
+        delete classInfo->getObject(env,obj);
+        classInfo->clearHandle(env,obj);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_PMTilesArchive_parseStart
+    (JNIEnv *env, jobject obj, jbyteArray data)
+{
+    try
+    {
+        const auto archive = PMTilesArchiveClassInfo::get(env,obj);
+        if (!archive || !data)
+        {
+            return false;
+        }
+
+        const jsize len = env->GetArrayLength(data);
+        bool ret = false;
+        if (jbyte *bytes = env->GetByteArrayElements(data,nullptr))
+        {
+            ret = archive->parseStart(bytes,len);
+            env->ReleaseByteArrayElements(data,bytes,JNI_ABORT);
+        }
+        return ret;
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_PMTilesArchive_isValid
+    (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto archive = PMTilesArchiveClassInfo::get(env,obj))
+        {
+            return archive->isValid();
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_PMTilesArchive_getMinZoom
+    (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto archive = PMTilesArchiveClassInfo::get(env,obj))
+        {
+            return archive->getHeader().minZoom;
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return 0;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_PMTilesArchive_getMaxZoom
+    (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto archive = PMTilesArchiveClassInfo::get(env,obj))
+        {
+            return archive->getHeader().maxZoom;
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return 0;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_PMTilesArchive_getTileType
+    (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto archive = PMTilesArchiveClassInfo::get(env,obj))
+        {
+            return archive->getHeader().tileType;
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return PMTilesArchive::TileTypeUnknown;
+}
+
+extern "C"
+JNIEXPORT jdoubleArray JNICALL Java_com_mousebird_maply_PMTilesArchive_getBounds
+    (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto archive = PMTilesArchiveClassInfo::get(env,obj))
+        {
+            const auto header = archive->getHeader();
+            return BuildDoubleArray(env,{ header.minLon, header.minLat, header.maxLon, header.maxLat });
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return nullptr;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_PMTilesArchive_tileIDForTile
+    (JNIEnv *env, jclass cls, jint x, jint y, jint level)
+{
+    return (jlong)PMTilesArchive::tileIDForTile(x,y,level);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_PMTilesArchive_lookup
+    (JNIEnv *env, jobject obj, jlong tileID, jlongArray rangeArray)
+{
+    try
+    {
+        const auto archive = PMTilesArchiveClassInfo::get(env,obj);
+        if (archive && rangeArray && env->GetArrayLength(rangeArray) >= 2)
+        {
+            PMTilesArchive::Range range;
+            const auto ret = archive->lookup((uint64_t)tileID,range);
+            const jlong vals[2] = { (jlong)range.offset, (jlong)range.length };
+            env->SetLongArrayRegion(rangeArray,0,2,vals);
+            return ret;
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return PMTilesArchive::TileMissing;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_PMTilesArchive_addDirectory
+    (JNIEnv *env, jobject obj, jlong offset, jlong length, jbyteArray data)
+{
+    try
+    {
+        const auto archive = PMTilesArchiveClassInfo::get(env,obj);
+        if (!archive || !data)
+        {
+            return false;
+        }
+
+        PMTilesArchive::Range range;
+        range.offset = (uint64_t)offset;
+        range.length = (uint64_t)length;
+        const jsize len = env->GetArrayLength(data);
+        bool ret = false;
+        if (jbyte *bytes = env->GetByteArrayElements(data,nullptr))
+        {
+            ret = archive->addDirectory(range,bytes,len);
+            env->ReleaseByteArrayElements(data,bytes,JNI_ABORT);
+        }
+        return ret;
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
+extern "C"
+JNIEXPORT jbyteArray JNICALL Java_com_mousebird_maply_PMTilesArchive_decompressTile
+    (JNIEnv *env, jobject obj, jbyteArray data)
+{
+    try
+    {
+        const auto archive = PMTilesArchiveClassInfo::get(env,obj);
+        if (!archive || !data)
+        {
+            return nullptr;
+        }
+
+        RawDataRef tileData;
+        const jsize len = env->GetArrayLength(data);
+        if (jbyte *bytes = env->GetByteArrayElements(data,nullptr))
+        {
+            const auto inData = std::make_shared<RawDataWrapper>(bytes,len,false);
+            tileData = archive->decompressTile(inData);
+            // Not compressed, so hand back what we were given
+            if (tileData == inData)
+            {
+                env->ReleaseByteArrayElements(data,bytes,JNI_ABORT);
+                return data;
+            }
+            env->ReleaseByteArrayElements(data,bytes,JNI_ABORT);
+        }
+        if (tileData)
+        {
+            const auto outLen = (jsize)tileData->getLen();
+            if (jbyteArray array = env->NewByteArray(outLen))
+            {
+                env->SetByteArrayRegion(array, 0, outLen, (const jbyte *)tileData->getRawData());
+                return array;
+            }
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return nullptr;
+}
+
+extern "C"
+JNIEXPORT jintArray JNICALL Java_com_mousebird_maply_PMTilesArchive_groupReads
+    (JNIEnv *env, jclass cls, jlongArray offsetArray, jlongArray lengthArray, jlong maxGap, jlong maxLength)
+{
+    try
+    {
+        std::vector<SimpleIdentity> offsets, lengths;
+        ConvertLongLongArray(env,offsetArray,offsets);
+        ConvertLongLongArray(env,lengthArray,lengths);
+        if (offsets.empty() || offsets.size() != lengths.size())
+        {
+            return nullptr;
+        }
+
+        std::vector<PMTilesArchive::Range> ranges(offsets.size());
+        for (size_t ii=0;ii<offsets.size();ii++)
+        {
+            ranges[ii].offset = offsets[ii];
+            ranges[ii].length = lengths[ii];
+        }
+
+        std::vector<PMTilesArchive::Read> reads;
+        PMTilesArchive::groupReads(ranges,(uint64_t)maxGap,(uint64_t)maxLength,reads);
+
+        std::vector<int> whichRead(ranges.size(),0);
+        for (size_t ii=0;ii<reads.size();ii++)
+        {
+            for (int which : reads[ii].which)
+            {
+                whichRead[which] = (int)ii;
+            }
+        }
+        return BuildIntArray(env,whichRead);
+    }
+    MAPLY_STD_JNI_CATCH()
+    return nullptr;
+}
@@ -0,0 +1,130 @@
+/*  PointCloudChunk_jni.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "QuadLoading_jni.h"
+#import "Geometry_jni.h"
+#import "com_mousebird_maply_PointCloudChunk.h"
+
+using namespace WhirlyKit;
+
+template<> PointCloudChunkClassInfo *PointCloudChunkClassInfo::classInfoObj = nullptr;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_nativeInit
+  (JNIEnv *env, jclass cls)
+{
+    PointCloudChunkClassInfo::getClassInfo(env,cls);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_initialise
+  (JNIEnv *env, jobject obj, jobject llObj, jobject urObj)
+{
+    try
+    {
+        const Point3d *ll = Point3dClassInfo::get(env,llObj);
+        const Point3d *ur = Point3dClassInfo::get(env,urObj);
+        if (!ll || !ur)
+            return;
+        auto chunk = new PointCloudChunkRef(std::make_shared<PointCloudChunk>(*ll,*ur));
+        PointCloudChunkClassInfo::getClassInfo()->setHandle(env,obj,chunk);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+static std::mutex disposeMutex;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_dispose
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        PointCloudChunkClassInfo *classInfo = PointCloudChunkClassInfo::getClassInfo();
+        std::lock_guard<std::mutex> lock(disposeMutex);
+        PointCloudChunkRef *chunk = classInfo->getObject(env,obj);
+        delete chunk;
+        classInfo->clearHandle(env,obj);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_addPoint
+  (JNIEnv *env, jobject obj, jdouble x, jdouble y, jdouble z)
+{
+    try
+    {
+        if (PointCloudChunkRef *chunk = PointCloudChunkClassInfo::get(env,obj))
+            (*chunk)->addPoint(Point3d(x,y,z));
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_addPoints
+  (JNIEnv *env, jobject obj, jdoubleArray xyzArray)
+{
+    try
+    {
+        PointCloudChunkRef *chunk = PointCloudChunkClassInfo::get(env,obj);
+        if (!chunk || !xyzArray)
+            return;
+        std::vector<double> xyz;
+        ConvertDoubleArray(env,xyzArray,xyz);
+        for (size_t ii=0;ii+2<xyz.size();ii+=3)
+            (*chunk)->addPoint(Point3d(xyz[ii],xyz[ii+1],xyz[ii+2]));
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_addColor
+  (JNIEnv *env, jobject obj, jint color)
+{
+    try
+    {
+        if (PointCloudChunkRef *chunk = PointCloudChunkClassInfo::get(env,obj))
+            (*chunk)->addColor(RGBAColor::FromARGBInt(color));
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudChunk_setChildMask
+  (JNIEnv *env, jobject obj, jint childMask)
+{
+    try
+    {
+        if (PointCloudChunkRef *chunk = PointCloudChunkClassInfo::get(env,obj))
+            (*chunk)->childMask = (uint8_t)childMask;
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_PointCloudChunk_getNumPoints
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (PointCloudChunkRef *chunk = PointCloudChunkClassInfo::get(env,obj))
+            return (jint)(*chunk)->getNumPoints();
+    }
+    MAPLY_STD_JNI_CATCH()
+    return 0;
+}
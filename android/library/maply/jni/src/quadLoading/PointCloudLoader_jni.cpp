@@ -0,0 +1,241 @@
+/*  PointCloudLoader_jni.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "QuadLoading_jni.h"
+#import "Geometry_jni.h"
+#import "GeometryManager_jni.h"
+#import "Scene_jni.h"
+#import "View_jni.h"
+#import "com_mousebird_maply_PointCloudLoader.h"
+
+using namespace WhirlyKit;
+
+template<> PointCloudLoaderClassInfo *PointCloudLoaderClassInfo::classInfoObj = nullptr;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_nativeInit
+  (JNIEnv *env, jclass cls)
+{
+    PointCloudLoaderClassInfo::getClassInfo(env,cls);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_initialise
+  (JNIEnv *env, jobject obj, jobject llObj, jobject urObj, jint maxLevel, jdouble rootSpacing)
+{
+    try
+    {
+        const Point3d *ll = Point3dClassInfo::get(env,llObj);
+        const Point3d *ur = Point3dClassInfo::get(env,urObj);
+        if (!ll || !ur)
+            return;
+        auto loader = new PointCloudLoader_Android(*ll,*ur,maxLevel,rootSpacing);
+        PointCloudLoaderClassInfo::getClassInfo()->setHandle(env,obj,loader);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+static std::mutex disposeMutex;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_dispose
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        PointCloudLoaderClassInfo *classInfo = PointCloudLoaderClassInfo::getClassInfo();
+        std::lock_guard<std::mutex> lock(disposeMutex);
+        PointCloudLoader_Android *loader = classInfo->getObject(env,obj);
+        delete loader;
+        classInfo->clearHandle(env,obj);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_setPixelSpacing
+  (JNIEnv *env, jobject obj, jdouble spacing)
+{
+    try
+    {
+        if (PointCloudLoader_Android *loader = PointCloudLoaderClassInfo::get(env,obj))
+            loader->setPixelSpacing(spacing);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_setMemoryBudget
+  (JNIEnv *env, jobject obj, jlong bytes)
+{
+    try
+    {
+        if (PointCloudLoader_Android *loader = PointCloudLoaderClassInfo::get(env,obj))
+            loader->setMemoryBudget((size_t)std::max(bytes,(jlong)0));
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_setMaxFetches
+  (JNIEnv *env, jobject obj, jint maxFetches)
+{
+    try
+    {
+        if (PointCloudLoader_Android *loader = PointCloudLoaderClassInfo::get(env,obj))
+            loader->setMaxFetches(maxFetches);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_boundsForNode
+  (JNIEnv *env, jobject obj, jint level, jint x, jint y, jint z, jobject llObj, jobject urObj)
+{
+    try
+    {
+        PointCloudLoader_Android *loader = PointCloudLoaderClassInfo::get(env,obj);
+        Point3d *ll = Point3dClassInfo::get(env,llObj);
+        Point3d *ur = Point3dClassInfo::get(env,urObj);
+        if (!loader || !ll || !ur)
+            return;
+        loader->boundsForNode(OctreeIdentifier(x,y,z,level),*ll,*ur);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_chunkLoaded
+  (JNIEnv *env, jobject obj, jobject chunkObj, jint level, jint x, jint y, jint z)
+{
+    try
+    {
+        PointCloudLoader_Android *loader = PointCloudLoaderClassInfo::get(env,obj);
+        PointCloudChunkRef *chunk = PointCloudChunkClassInfo::get(env,chunkObj);
+        if (!loader)
+            return;
+        if (chunk && *chunk)
+            loader->chunkLoaded(OctreeIdentifier(x,y,z,level),*chunk);
+        else
+            loader->chunkFailed(OctreeIdentifier(x,y,z,level));
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_chunkFailed
+  (JNIEnv *env, jobject obj, jint level, jint x, jint y, jint z)
+{
+    try
+    {
+        if (PointCloudLoader_Android *loader = PointCloudLoaderClassInfo::get(env,obj))
+            loader->chunkFailed(OctreeIdentifier(x,y,z,level));
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_PointCloudLoader_getNumLoadedNodes
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (PointCloudLoader_Android *loader = PointCloudLoaderClassInfo::get(env,obj))
+            return loader->getStats().numLoaded;
+    }
+    MAPLY_STD_JNI_CATCH()
+    return 0;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_PointCloudLoader_getNumDisplayedPoints
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (PointCloudLoader_Android *loader = PointCloudLoaderClassInfo::get(env,obj))
+            return (jlong)loader->getStats().numPointsDisplayed;
+    }
+    MAPLY_STD_JNI_CATCH()
+    return 0;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_startNative
+  (JNIEnv *env, jobject obj, jobject sceneObj, jobject geomInfoObj)
+{
+    try
+    {
+        PointCloudLoader_Android *loader = PointCloudLoaderClassInfo::get(env,obj);
+        Scene *scene = SceneClassInfo::get(env,sceneObj);
+        if (!loader || !scene)
+            return;
+        if (const GeometryInfoRef *geomInfo = geomInfoObj ? GeometryInfoClassInfo::get(env,geomInfoObj) : nullptr)
+            loader->setGeometryInfo(**geomInfo);
+        loader->start(scene);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_PointCloudLoader_viewUpdatedNative
+  (JNIEnv *env, jobject obj, jobject viewStateObj, jobject changeObj)
+{
+    try
+    {
+        PointCloudLoader_Android *loader = PointCloudLoaderClassInfo::get(env,obj);
+        ViewStateRef *viewState = ViewStateRefClassInfo::get(env,viewStateObj);
+        ChangeSetRef *changes = ChangeSetClassInfo::get(env,changeObj);
+        if (!loader || !viewState || !changes)
+            return false;
+
+        PlatformInfo_Android platformInfo(env);
+        return loader->viewUpdate(&platformInfo,*viewState,**changes);
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
+extern "C"
+JNIEXPORT jintArray JNICALL Java_com_mousebird_maply_PointCloudLoader_takeRequestsNative
+  (JNIEnv *env, jobject obj, jboolean cancels)
+{
+    try
+    {
+        if (PointCloudLoader_Android *loader = PointCloudLoaderClassInfo::get(env,obj))
+            return BuildIntArray(env,loader->getRequests()->takeRequests(cancels));
+    }
+    MAPLY_STD_JNI_CATCH()
+    return BuildIntArray(env,std::vector<int>());
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_PointCloudLoader_shutdownNative
+  (JNIEnv *env, jobject obj, jobject changeObj)
+{
+    try
+    {
+        PointCloudLoader_Android *loader = PointCloudLoaderClassInfo::get(env,obj);
+        ChangeSetRef *changes = ChangeSetClassInfo::get(env,changeObj);
+        if (!loader || !changes)
+            return;
+
+        PlatformInfo_Android platformInfo(env);
+        loader->stop(&platformInfo,**changes);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
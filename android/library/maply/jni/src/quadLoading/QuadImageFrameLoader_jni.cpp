@@ -148,6 +148,48 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setTextureS
     MAPLY_STD_JNI_CATCH()
 }
 
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setAsyncTextureUpload
+  (JNIEnv *env, jobject obj, jboolean async)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            (*loader)->setAsyncTextureUpload(async);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setParentPlaceholders
+  (JNIEnv *env, jobject obj, jboolean placeholders)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            (*loader)->setParentPlaceholders(placeholders);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setReprojectSamples
+  (JNIEnv *env, jobject obj, jint samples)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            (*loader)->setReprojectSamples(samples);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
 extern "C"
 JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setShaderIDNative
   (JNIEnv *env, jobject obj, jint focusID, jlong shaderID)
@@ -164,7 +206,7 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setShaderID
 
 extern "C"
 JNIEXPORT jint JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_getStatsNative
-  (JNIEnv *env, jobject obj, jintArray totalTilesArr, jintArray tilesToLoadArr)
+  (JNIEnv *env, jobject obj, jintArray totalTilesArr, jintArray tilesToLoadArr, jintArray tilesLoadedArr, jlongArray texInfoArr)
 {
     try
     {
@@ -172,12 +214,13 @@ JNIEXPORT jint JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_getStatsNat
         {
             QuadImageFrameLoader::Stats stats = (*loader)->getStats();
             const int numFrames = stats.frameStats.size();
-            std::vector<int> totalTiles(numFrames), tilesToLoad(numFrames);
+            std::vector<int> totalTiles(numFrames), tilesToLoad(numFrames), tilesLoaded(numFrames);
             for (unsigned int ii = 0; ii < numFrames; ii++)
             {
                 auto &frame = stats.frameStats[ii];
                 totalTiles[ii] = frame.totalTiles;
                 tilesToLoad[ii] = frame.tilesToLoad;
+                tilesLoaded[ii] = frame.tilesLoaded;
             }
             // Even taking the address of element zero is technically undefined on an empty vector
             if (!totalTiles.empty())
@@ -188,6 +231,13 @@ JNIEXPORT jint JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_getStatsNat
             {
                 env->SetIntArrayRegion(tilesToLoadArr, 0, tilesToLoad.size(), &tilesToLoad[0]);
             }
+            if (!tilesLoaded.empty())
+            {
+                env->SetIntArrayRegion(tilesLoadedArr, 0, tilesLoaded.size(), &tilesLoaded[0]);
+            }
+            // Texture bytes and the tiles holding them
+            const jlong texInfo[2] = { (jlong)stats.texBytes, (jlong)stats.numTexTiles };
+            env->SetLongArrayRegion(texInfoArr, 0, 2, texInfo);
 
             return stats.numTiles;
         }
@@ -196,6 +246,93 @@ JNIEXPORT jint JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_getStatsNat
     return 0;
 }
 
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setFrameWindowNative
+  (JNIEnv *env, jobject obj, jint numFrames)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            (*loader)->setFrameWindow(numFrames);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setCompositeFrames
+  (JNIEnv *env, jobject obj, jboolean composite)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            (*loader)->setCompositeFrames(composite);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_getCompositeFrames
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            return (*loader)->getCompositeFrames();
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_setTerrainNative
+  (JNIEnv *env, jobject obj, jint encoding, jdouble exaggeration)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            (*loader)->setTerrain(true,encoding == 1 ? ElevEncodeMapboxRGB : ElevEncodeTerrarium,exaggeration);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_getTerrain
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            return (*loader)->getTerrain();
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_getFrameWindow
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            return (*loader)->getFrameWindow();
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return 0;
+}
+
 extern "C"
 JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageFrameLoader_updatePriorities
   (JNIEnv *env, jobject obj)
@@ -40,7 +40,9 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadImageLoaderBase_delayedInitN
         for (unsigned int ii=0;ii<loader->get()->getNumFocus();ii++) {
             if (loader->get()->getShaderID(ii) == EmptyIdentity) {
                 ProgramGLES *prog = (ProgramGLES *) scene->findProgramByName(
-                        MaplyDefaultTriMultiTexShader);
+                        loader->get()->getTerrain() ? MaplyDefaultTriTerrainShader :
+                        (loader->get()->getCompositeFrames() ? MaplyDefaultTriCompositeShader :
+                        MaplyDefaultTriMultiTexShader));
                 if (prog)
                     loader->get()->setShaderID(ii,prog->getId());
             }
@@ -21,6 +21,8 @@
 #import "Scene_jni.h"
 #import "com_mousebird_maply_QuadLoaderBase.h"
 #import <Exceptions_jni.h>
+#import "ScopedEnv_Android.h"
+#import "TaskScheduler.h"
 
 using namespace Eigen;
 using namespace WhirlyKit;
@@ -142,6 +144,119 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_setDebugMode
     MAPLY_STD_JNI_CATCH()
 }
 
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_setTileLatencyEnabled
+  (JNIEnv *env, jobject obj, jboolean enable)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            (*loader)->getLatencyStats()->setEnable(enable);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadLoaderBase_getTileLatencyEnabled(JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            return (*loader)->getLatencyStats()->isEnabled();
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_setReloadInPlace
+  (JNIEnv *env, jobject obj, jboolean inPlace)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            (*loader)->setReloadInPlace(inPlace);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadLoaderBase_getReloadInPlace(JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            return (*loader)->getReloadInPlace();
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_clearTileLatencyStats(JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj))
+        {
+            (*loader)->getLatencyStats()->clear();
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL Java_com_mousebird_maply_QuadLoaderBase_getTileLatencyStageNames(JNIEnv *env, jclass)
+{
+    try
+    {
+        std::vector<std::string> names;
+        for (int ss=0;ss<TileLatencyStats::NumStages;ss++)
+        {
+            names.emplace_back(TileLatencyStats::getStageName((TileLatencyStats::Stage)ss));
+        }
+        return BuildStringArray(env,names);
+    }
+    MAPLY_STD_JNI_CATCH()
+    return nullptr;
+}
+
+// Six values per stage: count, min, max, mean, p50, p95
+extern "C"
+JNIEXPORT jdoubleArray JNICALL Java_com_mousebird_maply_QuadLoaderBase_getTileLatencyValues(JNIEnv *env, jobject obj)
+{
+    try
+    {
+        const auto loader = QuadImageFrameLoaderClassInfo::get(env,obj);
+        if (!loader)
+            return nullptr;
+
+        const auto summaries = (*loader)->getLatencyStats()->getSummaries();
+        std::vector<double> vals;
+        vals.reserve(summaries.size() * 6);
+        for (const auto &summary : summaries)
+        {
+            vals.push_back(summary.numTiles);
+            vals.push_back(summary.minVal);
+            vals.push_back(summary.maxVal);
+            vals.push_back(summary.mean);
+            vals.push_back(summary.p50);
+            vals.push_back(summary.p95);
+        }
+        return BuildDoubleArray(env,vals);
+    }
+    MAPLY_STD_JNI_CATCH()
+    return nullptr;
+}
+
 extern "C"
 JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_geoBoundsForTileNative
   (JNIEnv *env, jobject obj, jint tileX, jint tileY, jint tileLevel, jobject llObj, jobject urObj)
@@ -366,6 +481,61 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_mergeLoaderReturn
     }
 }
 
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_mergeLoaderReturns
+        (JNIEnv *env, jobject obj, jobjectArray loadRetArrayObj, jobject changeObj)
+{
+    try {
+        auto loaderPtr = QuadImageFrameLoaderClassInfo::getClassInfo()->getObject(env,obj);
+        auto loader = loaderPtr ? *loaderPtr : nullptr;
+        auto changesPtr = ChangeSetClassInfo::getClassInfo()->getObject(env,changeObj);
+        auto changes = changesPtr ? *changesPtr : nullptr;
+        if (!loader || !changes || !loadRetArrayObj)
+            return;
+
+        // Hold on to the objects so we can detach them once they're merged
+        std::vector<QuadLoaderReturnRef *> loadReturnPtrs;
+        std::vector<jobject> loadReturnObjs;
+        std::vector<QuadLoaderReturn *> loadReturns;
+        JavaObjectArrayHelper loadRetObjs(env, loadRetArrayObj);
+        loadReturnPtrs.reserve(loadRetObjs.numObjects());
+        loadReturnObjs.reserve(loadRetObjs.numObjects());
+        loadReturns.reserve(loadRetObjs.numObjects());
+        while (jobject loadRetObj = loadRetObjs.getNextObject())
+        {
+            auto loadReturnPtr = LoaderReturnClassInfo::getClassInfo()->getObject(env,loadRetObj);
+            if (loadReturnPtr && *loadReturnPtr)
+            {
+                loadReturnPtrs.push_back(loadReturnPtr);
+                loadReturnObjs.push_back(env->NewLocalRef(loadRetObj));
+                loadReturns.push_back(loadReturnPtr->get());
+            }
+        }
+
+        // Merge the objects, all at once
+        PlatformInfo_Android platformInfo(env);
+        loader->mergeLoadedTiles(&platformInfo,loadReturns,*changes);
+
+        for (unsigned int ii=0;ii<loadReturnPtrs.size();ii++)
+        {
+            const auto &loadReturn = *loadReturnPtrs[ii];
+            loadReturn->clear();
+
+            // Detach the loader return from the frame
+            loader->setLoadReturnRef(loadReturn->ident,loadReturn->frame,nullptr);
+
+            // Destroy the loader return root reference
+            LoaderReturnClassInfo::getClassInfo()->clearHandle(env,loadReturnObjs[ii]);
+            env->DeleteLocalRef(loadReturnObjs[ii]);
+            delete loadReturnPtrs[ii];
+        }
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in QuadLoaderBase::mergeLoaderReturns()");
+    }
+}
+
 extern "C"
 JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_samplingLayerConnectNative
         (JNIEnv *env, jobject obj, jobject layerObj, jobject changeObj)
@@ -653,3 +823,109 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadLoaderBase_mergeLoadedFr
     }
     return false;
 }
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadLoaderBase_frameUnchanged
+        (JNIEnv *env, jobject obj, jobject identObj, jlong frameID, jbyteArray rawData)
+{
+    try
+    {
+        const auto loaderPtr = QuadImageFrameLoaderClassInfo::get(env,obj);
+        const auto loader = loaderPtr ? *loaderPtr : nullptr;
+        if (!loader || !rawData || !loader->getReloadInPlace())
+        {
+            return false;
+        }
+
+        // Copied out, since the frame calls back into Java if it's unchanged
+        const int rawDataSize = env->GetArrayLength(rawData);
+        if (rawDataSize <= 0)
+        {
+            return false;
+        }
+        std::vector<jbyte> rawBytes(rawDataSize);
+        env->GetByteArrayRegion(rawData, 0, rawDataSize, &rawBytes[0]);
+        const RawDataWrapper dataWrapper(&rawBytes[0], rawDataSize, /*free=*/false);
+
+        const auto tileID = loader->getTileID(env, identObj);
+        PlatformInfo_Android platformInfo(env);
+        return loader->frameUnchanged(&platformInfo, tileID, (SimpleIdentity)frameID, &dataWrapper);
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
+// Set up along with the shared task threads
+static JavaVM *taskJVM = nullptr;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_setSharedTaskThreads
+  (JNIEnv *env, jclass, jint numThreads)
+{
+    try
+    {
+        auto &scheduler = TaskScheduler::getShared();
+        if (!taskJVM && env->GetJavaVM(&taskJVM) == JNI_OK)
+        {
+            // The workers run Java code, so they stay attached the whole time
+            scheduler.setThreadHooks([]{
+                                         JNIEnv *threadEnv = nullptr;
+                                         taskJVM->AttachCurrentThread(&threadEnv, nullptr);
+                                     },
+                                     []{ taskJVM->DetachCurrentThread(); });
+        }
+        scheduler.setNumThreads(numThreads);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_QuadLoaderBase_getSharedTaskThreads
+  (JNIEnv *env, jclass)
+{
+    try
+    {
+        return TaskScheduler::getShared().getNumThreads();
+    }
+    MAPLY_STD_JNI_CATCH()
+    return 0;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadLoaderBase_scheduleTaskNative
+  (JNIEnv *env, jobject obj, jdouble importance, jobject loadReturnObj, jobject taskObj)
+{
+    try
+    {
+        auto &scheduler = TaskScheduler::getShared();
+        const auto loadReturnPtr = LoaderReturnClassInfo::get(env,loadReturnObj);
+        if (!taskObj || !taskJVM || !loadReturnPtr || !*loadReturnPtr || scheduler.getNumThreads() <= 0)
+        {
+            return false;
+        }
+
+        static const jmethodID runMethod = [env]{
+            const jclass runnableClass = env->FindClass("java/lang/Runnable");
+            const jmethodID method = env->GetMethodID(runnableClass, "run", "()V");
+            env->DeleteLocalRef(runnableClass);
+            return method;
+        }();
+
+        // Holding the loader return keeps its cancel flag around
+        const QuadLoaderReturnRef loadReturn = *loadReturnPtr;
+        const jobject task = env->NewGlobalRef(taskObj);
+        scheduler.addTask(importance, &loadReturn->cancel, [loadReturn,task](bool) {
+            // Cancelled or not, the task does the cleanup
+            ScopedEnv threadEnv(taskJVM);
+            if (threadEnv)
+            {
+                threadEnv->CallVoidMethod(task, runMethod);
+                logAndClearJVMException(threadEnv, "QuadLoaderBase shared task");
+                threadEnv->DeleteGlobalRef(task);
+            }
+        });
+        return true;
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
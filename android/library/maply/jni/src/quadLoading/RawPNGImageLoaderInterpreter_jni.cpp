@@ -106,7 +106,9 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RawPNGImageLoaderInterpreter_dat
 		if (err != 0 && !outData) {
             wkLogLevel(Warn, "Failed to read PNG in MaplyRawPNGImageLoaderInterpreter for tile %d: (%d,%d)",(*loadReturn)->ident.level,(*loadReturn)->ident.x,(*loadReturn)->ident.y);
         } else {
-			RawDataWrapperRef wrap = std::make_shared<RawDataWrapper>(outData,width*height*byteWidth,true);
+			// The decoders malloc() the output
+			RawDataWrapperRef wrap = std::make_shared<RawDataWrapper>(outData,width*height*byteWidth,
+			        [](const void *p) { free((void *)p); });
 			ImageTileRef imgTile = std::make_shared<ImageTile_Android>("Raw PNG",wrap);
 			imgTile->width = width;  imgTile->height = height;
 			imgTile->components = byteWidth;
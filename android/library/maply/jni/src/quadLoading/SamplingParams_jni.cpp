@@ -410,6 +410,114 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getEdgeMatchi
 	return false;
 }
 
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setMeshTemplates
+  (JNIEnv *env, jobject obj, jboolean meshTemplates)
+{
+	try
+	{
+		if (const auto params = SamplingParamsClassInfo::get(env,obj))
+		{
+			params->meshTemplates = meshTemplates;
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in SamplingParams::setMeshTemplates()");
+	}
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getMeshTemplates
+  (JNIEnv *env, jobject obj)
+{
+	try
+	{
+		if (const auto params = SamplingParamsClassInfo::get(env,obj))
+		{
+			return params->meshTemplates;
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in SamplingParams::getMeshTemplates()");
+	}
+
+	return false;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setIncludeElev
+  (JNIEnv *env, jobject obj, jboolean includeElev)
+{
+	try
+	{
+		if (const auto params = SamplingParamsClassInfo::get(env,obj))
+		{
+			params->includeElev = includeElev;
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in SamplingParams::setIncludeElev()");
+	}
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getIncludeElev
+  (JNIEnv *env, jobject obj)
+{
+	try
+	{
+		if (const auto params = SamplingParamsClassInfo::get(env,obj))
+		{
+			return params->includeElev;
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in SamplingParams::getIncludeElev()");
+	}
+
+	return false;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setElevTextures
+  (JNIEnv *env, jobject obj, jboolean elevTextures)
+{
+	try
+	{
+		if (const auto params = SamplingParamsClassInfo::get(env,obj))
+		{
+			params->elevTextures = elevTextures;
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in SamplingParams::setElevTextures()");
+	}
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getElevTextures
+  (JNIEnv *env, jobject obj)
+{
+	try
+	{
+		if (const auto params = SamplingParamsClassInfo::get(env,obj))
+		{
+			return params->elevTextures;
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in SamplingParams::getElevTextures()");
+	}
+
+	return false;
+}
+
 extern "C"
 JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setTesselation
   (JNIEnv *env, jobject obj, jint tessX, jint tessY)
@@ -519,6 +627,108 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getSingleLeve
 	return false;
 }
 
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setIncrementalCoverage
+  (JNIEnv *env, jobject obj, jboolean incremental)
+{
+	try
+	{
+		if (const auto params = SamplingParamsClassInfo::get(env,obj))
+		{
+			params->incrementalCoverage = incremental;
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in SamplingParams::setIncrementalCoverage()");
+	}
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getIncrementalCoverage
+  (JNIEnv *env, jobject obj)
+{
+	try
+	{
+		if (const auto params = SamplingParamsClassInfo::get(env,obj))
+		{
+			return params->incrementalCoverage;
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in SamplingParams::getIncrementalCoverage()");
+	}
+
+	return false;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setDisplaySolidCacheSize
+  (JNIEnv *env, jobject obj, jint size)
+{
+	try
+	{
+		if (const auto params = SamplingParamsClassInfo::get(env,obj))
+		{
+			params->displaySolidCacheSize = size;
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in SamplingParams::setDisplaySolidCacheSize()");
+	}
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_SamplingParams_getDisplaySolidCacheSize
+  (JNIEnv *env, jobject obj)
+{
+	try
+	{
+		if (const auto params = SamplingParamsClassInfo::get(env,obj))
+		{
+			return params->displaySolidCacheSize;
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in SamplingParams::getDisplaySolidCacheSize()");
+	}
+
+	return 0;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setTileMemoryBudget
+  (JNIEnv *env, jclass cls, jlong bytes)
+{
+	try
+	{
+		TileMemoryManager::getShared().setBudget((size_t)std::max(bytes,(jlong)0));
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in SamplingParams::setTileMemoryBudget()");
+	}
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_SamplingParams_getTileMemoryBudget
+  (JNIEnv *env, jclass cls)
+{
+	try
+	{
+		return (jlong)TileMemoryManager::getShared().getBudget();
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in SamplingParams::getTileMemoryBudget()");
+	}
+
+	return 0;
+}
+
 extern "C"
 JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setLevelLoads
   (JNIEnv *env, jobject obj, jintArray levelArray)
@@ -0,0 +1,191 @@
+/*
+ *  TileCacheStore_jni.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "QuadLoading_jni.h"
+#import "com_mousebird_maply_TileCacheStore.h"
+
+using namespace WhirlyKit;
+
+template<> TileCacheStoreClassInfo *TileCacheStoreClassInfo::classInfoObj = nullptr;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCacheStore_nativeInit
+    (JNIEnv *env, jclass cls)
+{
+    TileCacheStoreClassInfo::getClassInfo(env,cls);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCacheStore_initialise
+    (JNIEnv *env, jobject obj, jstring dirStr)
+{
+    try
+    {
+        const JavaString dir(env,dirStr);
+        if (dir)
+        {
+            TileCacheStoreClassInfo::set(env,obj,new TileCacheStoreRef(TileCacheStore::getShared(dir.getString())));
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+static std::mutex disposeMutex;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCacheStore_dispose
+    (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        const auto classInfo = TileCacheStoreClassInfo::getClassInfo();
+        std::lock_guard<std::mutex> lock(disposeMutex);
+        delete classInfo->getObject(env,obj);
+        classInfo->clearHandle(env,obj);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_TileCacheStore_contains
+    (JNIEnv *env, jobject obj, jstring keyStr)
+{
+    try
+    {
+        if (const auto store = TileCacheStoreClassInfo::get(env,obj))
+        {
+            const JavaString key(env,keyStr);
+            return key && (*store)->contains(key.getString());
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
+extern "C"
+JNIEXPORT jbyteArray JNICALL Java_com_mousebird_maply_TileCacheStore_find
+    (JNIEnv *env, jobject obj, jstring keyStr)
+{
+    try
+    {
+        if (const auto store = TileCacheStoreClassInfo::get(env,obj))
+        {
+            const JavaString key(env,keyStr);
+            // Java wants its own array, so this is the one copy we make
+            if (const auto data = key ? (*store)->find(key.getString()) : RawDataRef())
+            {
+                const auto len = (jsize)data->getLen();
+                if (jbyteArray array = env->NewByteArray(len))
+                {
+                    env->SetByteArrayRegion(array, 0, len, (const jbyte *)data->getRawData());
+                    return array;
+                }
+            }
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return nullptr;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_TileCacheStore_add
+    (JNIEnv *env, jobject obj, jstring keyStr, jbyteArray data)
+{
+    try
+    {
+        const auto store = TileCacheStoreClassInfo::get(env,obj);
+        const JavaString key(env,keyStr);
+        if (!store || !key || !data)
+        {
+            return false;
+        }
+
+        const jsize len = env->GetArrayLength(data);
+        bool ret = false;
+        if (jbyte *bytes = env->GetByteArrayElements(data,nullptr))
+        {
+            ret = (*store)->add(key.getString(),bytes,len);
+            env->ReleaseByteArrayElements(data,bytes,JNI_ABORT);
+        }
+        return ret;
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCacheStore_remove
+    (JNIEnv *env, jobject obj, jstring keyStr)
+{
+    try
+    {
+        if (const auto store = TileCacheStoreClassInfo::get(env,obj))
+        {
+            const JavaString key(env,keyStr);
+            if (key)
+            {
+                (*store)->remove(key.getString());
+            }
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCacheStore_setMaxSize
+    (JNIEnv *env, jobject obj, jlong size)
+{
+    try
+    {
+        if (const auto store = TileCacheStoreClassInfo::get(env,obj))
+        {
+            (*store)->setMaxSize((size_t)std::max(size,(jlong)0));
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCacheStore_setLifetime
+    (JNIEnv *env, jobject obj, jdouble lifetime)
+{
+    try
+    {
+        if (const auto store = TileCacheStoreClassInfo::get(env,obj))
+        {
+            (*store)->setLifetime(lifetime);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_TileCacheStore_getSize
+    (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto store = TileCacheStoreClassInfo::get(env,obj))
+        {
+            return (jlong)(*store)->getSize();
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return 0;
+}
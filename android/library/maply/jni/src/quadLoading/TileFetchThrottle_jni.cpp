@@ -0,0 +1,185 @@
+/*
+ *  TileFetchThrottle_jni.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "QuadLoading_jni.h"
+#import "com_mousebird_maply_TileFetchThrottle.h"
+
+using namespace WhirlyKit;
+
+template<> TileFetchThrottleClassInfo *TileFetchThrottleClassInfo::classInfoObj = nullptr;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_nativeInit
+    (JNIEnv *env, jclass cls)
+{
+    TileFetchThrottleClassInfo::getClassInfo(env,cls);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_initialise
+    (JNIEnv *env, jobject obj, jint minPerHost, jint maxPerHost)
+{
+    try
+    {
+        TileFetchThrottleClassInfo::set(env,obj,new TileFetchThrottle(minPerHost,maxPerHost));
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+static std::mutex disposeMutex;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_dispose
+    (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        const auto classInfo = TileFetchThrottleClassInfo::getClassInfo();
+        std::lock_guard<std::mutex> lock(disposeMutex);
+        delete classInfo->getObject(env,obj);
+        classInfo->clearHandle(env,obj);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_setLimits
+    (JNIEnv *env, jobject obj, jint minPerHost, jint maxPerHost)
+{
+    try
+    {
+        if (const auto throttle = TileFetchThrottleClassInfo::get(env,obj))
+        {
+            throttle->setLimits(minPerHost,maxPerHost);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_TileFetchThrottle_canStart
+    (JNIEnv *env, jobject obj, jstring hostStr)
+{
+    try
+    {
+        if (const auto throttle = TileFetchThrottleClassInfo::get(env,obj))
+        {
+            const JavaString host(env,hostStr);
+            return !host || throttle->canStart(host.getString());
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return true;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_started
+    (JNIEnv *env, jobject obj, jstring hostStr)
+{
+    try
+    {
+        const auto throttle = TileFetchThrottleClassInfo::get(env,obj);
+        const JavaString host(env,hostStr);
+        if (throttle && host)
+        {
+            throttle->started(host.getString());
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_finished
+    (JNIEnv *env, jobject obj, jstring hostStr, jdouble howLong, jlong size)
+{
+    try
+    {
+        const auto throttle = TileFetchThrottleClassInfo::get(env,obj);
+        const JavaString host(env,hostStr);
+        if (throttle && host)
+        {
+            throttle->finished(host.getString(),howLong,(size_t)std::max(size,(jlong)0));
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_failed
+    (JNIEnv *env, jobject obj, jstring hostStr)
+{
+    try
+    {
+        const auto throttle = TileFetchThrottleClassInfo::get(env,obj);
+        const JavaString host(env,hostStr);
+        if (throttle && host)
+        {
+            throttle->failed(host.getString());
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileFetchThrottle_cancelled
+    (JNIEnv *env, jobject obj, jstring hostStr)
+{
+    try
+    {
+        const auto throttle = TileFetchThrottleClassInfo::get(env,obj);
+        const JavaString host(env,hostStr);
+        if (throttle && host)
+        {
+            throttle->cancelled(host.getString());
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_TileFetchThrottle_getLimit
+    (JNIEnv *env, jobject obj, jstring hostStr)
+{
+    try
+    {
+        const auto throttle = TileFetchThrottleClassInfo::get(env,obj);
+        const JavaString host(env,hostStr);
+        if (throttle && host)
+        {
+            return throttle->getLimit(host.getString());
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return 0;
+}
+
+extern "C"
+JNIEXPORT jdouble JNICALL Java_com_mousebird_maply_TileFetchThrottle_getRate
+    (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (const auto throttle = TileFetchThrottleClassInfo::get(env,obj))
+        {
+            return throttle->getRate();
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return 0.0;
+}
@@ -17,10 +17,13 @@
  */
 
 #import <android/bitmap.h>
+#import <sys/stat.h>
+#import <cerrno>
 #import "Renderer_jni.h"
 #import "Scene_jni.h"
 #import "View_jni.h"
 #import "com_mousebird_maply_RenderController.h"
+#import "OfflineRunner.h"
 
 using namespace WhirlyKit;
 
@@ -229,6 +232,8 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setupShadersNat
 
 		bool isGlobe = !renderer->getScene()->getCoordAdapter()->isFlat();
 
+		StartupPhase phase(renderer->getStartupTimeline(),"default shaders");
+
 		SceneRendererWrapper rendWrap(env,renderer->getScene(),obj);
 
 		// Default line shaders
@@ -241,6 +246,7 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setupShadersNat
 		// Default triangle shaders
 		rendWrap.addShader(MaplyDefaultTriangleShader,ProgramGLESRef(BuildDefaultTriShaderLightingGLES(MaplyDefaultTriangleShader,renderer)));
 		rendWrap.addShader(MaplyNoLightTriangleShader,ProgramGLESRef(BuildDefaultTriShaderNoLightingGLES(MaplyNoLightTriangleShader,renderer)));
+		rendWrap.addShader(MaplyLoftedPolyExtrudeShader,ProgramGLESRef(BuildDefaultTriShaderExtrudeGLES(MaplyLoftedPolyExtrudeShader,renderer)));
 
 		// Model instancing
 		rendWrap.addShader(MaplyDefaultModelTriShader,ProgramGLESRef(BuildDefaultTriShaderModelGLES(MaplyDefaultModelTriShader,renderer)));
@@ -252,6 +258,12 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setupShadersNat
 		rendWrap.addShader(MaplyDefaultTriMultiTexShader,ProgramGLESRef(BuildDefaultTriShaderMultitexGLES(MaplyDefaultTriMultiTexShader,renderer)));
 		rendWrap.addShader(MaplyDefaultMarkerShader,ProgramGLESRef(BuildDefaultTriShaderMultitexGLES(MaplyDefaultMarkerShader,renderer)));
 
+		// Layered textures for composited image loaders
+		rendWrap.addShader(MaplyDefaultTriCompositeShader,ProgramGLESRef(BuildDefaultTriShaderCompositeGLES(MaplyDefaultTriCompositeShader,renderer)));
+
+		// Tiles raised by elevation textures
+		rendWrap.addShader(MaplyDefaultTriTerrainShader,ProgramGLESRef(BuildDefaultTriShaderTerrainGLES(MaplyDefaultTriTerrainShader,renderer)));
+
 		// Ramp texture support
 		rendWrap.addShader(MaplyDefaultTriMultiTexRampShader,ProgramGLESRef(BuildDefaultTriShaderRamptexGLES(MaplyDefaultTriMultiTexRampShader,renderer)));
 
@@ -261,6 +273,8 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setupShadersNat
 		// Billboards
 		rendWrap.addShader(MaplyBillboardGroundShader,ProgramGLESRef(BuildBillboardGroundProgramGLES(MaplyBillboardGroundShader,renderer)));
 		rendWrap.addShader(MaplyBillboardEyeShader,ProgramGLESRef(BuildBillboardEyeProgramGLES(MaplyBillboardEyeShader,renderer)));
+		rendWrap.addShader(MaplyBillboardGroundInstanceShader,ProgramGLESRef(BuildBillboardGroundInstanceProgramGLES(MaplyBillboardGroundInstanceShader,renderer)));
+		rendWrap.addShader(MaplyBillboardEyeInstanceShader,ProgramGLESRef(BuildBillboardEyeInstanceProgramGLES(MaplyBillboardEyeInstanceShader,renderer)));
 
 		// Wide vectors
 		rendWrap.addShader(MaplyDefaultWideVectorGlobeShader,ProgramGLESRef(BuildWideVectorGlobeProgramGLES(MaplyDefaultWideVectorGlobeShader,renderer)));
@@ -269,9 +283,14 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setupShadersNat
 		} else {
             rendWrap.addShader(MaplyDefaultWideVectorShader,ProgramGLESRef(BuildWideVectorProgramGLES(MaplyDefaultWideVectorShader,renderer)));
 		}
+		rendWrap.addShader(MaplyWideVectorPerformanceShader,ProgramGLESRef(BuildWideVectorPerfProgramGLES(MaplyWideVectorPerformanceShader,renderer)));
 		// Screen space
 		rendWrap.addShader(MaplyScreenSpaceDefaultMotionShader,ProgramGLESRef(BuildScreenSpaceMotionProgramGLES(MaplyScreenSpaceDefaultMotionShader,renderer)));
 		rendWrap.addShader(MaplyScreenSpaceDefaultShader,ProgramGLESRef(BuildScreenSpaceProgramGLES(MaplyScreenSpaceDefaultShader,renderer)));
+		rendWrap.addShader(MaplyScreenSpaceSDFMotionShader,ProgramGLESRef(BuildScreenSpaceSDFMotionProgramGLES(MaplyScreenSpaceSDFMotionShader,renderer)));
+		rendWrap.addShader(MaplyScreenSpaceSDFShader,ProgramGLESRef(BuildScreenSpaceSDFProgramGLES(MaplyScreenSpaceSDFShader,renderer)));
+		rendWrap.addShader(MaplyScreenSpaceInstanceShader,ProgramGLESRef(BuildScreenSpaceInstanceProgramGLES(MaplyScreenSpaceInstanceShader,renderer)));
+		rendWrap.addShader(MaplyScreenSpaceSDFInstanceShader,ProgramGLESRef(BuildScreenSpaceSDFInstanceProgramGLES(MaplyScreenSpaceSDFInstanceShader,renderer)));
 		// Particles
 		rendWrap.addShader(MaplyParticleSystemPointDefaultShader,ProgramGLESRef(BuildParticleSystemProgramGLES(MaplyParticleSystemPointDefaultShader,renderer)));
 	}
@@ -281,6 +300,24 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setupShadersNat
 	}
 }
 
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setShaderCacheDir(JNIEnv *env, jclass, jstring dirStr)
+{
+	try
+	{
+		if (!dirStr)
+		{
+			ProgramGLES::setBinaryCacheDir(std::string());
+			return;
+		}
+		const JavaString dir(env,dirStr);
+		// Leave it off if we can't make the directory
+		if (mkdir(dir.getCString(),0700) == 0 || errno == EEXIST)
+			ProgramGLES::setBinaryCacheDir(dir.getString());
+	}
+	MAPLY_STD_JNI_CATCH()
+}
+
 extern "C"
 JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setViewNative(JNIEnv *env, jobject obj, jobject objView)
 {
@@ -443,6 +480,51 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_renderToBitmapN
 	}
 }
 
+// Offline renderers draw straight through, so this is all there is to a frame
+static std::unique_ptr<OfflineRunner> MakeOfflineRunner(SceneRendererGLES_Android *renderer)
+{
+	return std::make_unique<OfflineRunner>(renderer->getScene(),renderer,[renderer]{
+		renderer->render(1/60.0);
+	});
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_settleNative(JNIEnv *env, jobject obj, jdouble timeout)
+{
+	try
+	{
+		SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj);
+		if (!renderer || !renderer->getScene())
+			return false;
+
+		OfflineRunner::Params params;
+		params.settleTimeout = timeout;
+		OfflineRunner::Result result;
+		return MakeOfflineRunner(renderer)->settle(params,result);
+	}
+	MAPLY_STD_JNI_CATCH()
+	return false;
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL Java_com_mousebird_maply_RenderController_runOfflineBenchmarkNative(JNIEnv *env, jobject obj, jint frames, jdouble timeout)
+{
+	try
+	{
+		SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj);
+		if (!renderer || !renderer->getScene())
+			return nullptr;
+
+		OfflineRunner::Params params;
+		params.settleTimeout = timeout;
+		params.frames = frames;
+		const auto result = MakeOfflineRunner(renderer)->run(params);
+		return env->NewStringUTF(OfflineRunner::ToJSON(result).c_str());
+	}
+	MAPLY_STD_JNI_CATCH()
+	return nullptr;
+}
+
 extern "C"
 JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_hasChanges(JNIEnv *env, jobject obj)
 {
@@ -452,7 +534,8 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_hasChanges(
 		if (!renderer)
 			return false;
 
-		bool changes = renderer->hasChanges();
+		// The pacer may hold a change back for a later frame, depending on the mode
+		bool changes = renderer->shouldRenderFrame();
         if (renderer->extraFrameMode) {
             // If there were changes, we need two extra frames after things settle
             if (changes) {
@@ -490,6 +573,388 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setPerfInterval
 	}
 }
 
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setFramePacingNative(JNIEnv *env, jobject obj, jint mode)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			renderer->getFramePacer().setMode((FramePacer::Mode)mode);
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::setFramePacingNative()");
+	}
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_RenderController_getFramePacingNative(JNIEnv *env, jobject obj)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			return renderer->getFramePacer().getMode();
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::getFramePacingNative()");
+	}
+	return FramePacer::PacingFull;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setDisplayFrameRate(JNIEnv *env, jobject obj, jint fps)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			renderer->getFramePacer().setDisplayRate(fps);
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::setDisplayFrameRate()");
+	}
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setDynamicResolution(JNIEnv *env, jobject obj, jboolean enable, jfloat minScale, jfloat maxScale)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			renderer->getDynamicResolution().setScaleRange(minScale,maxScale);
+			renderer->getDynamicResolution().setEnabled(enable);
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::setDynamicResolution()");
+	}
+}
+
+extern "C"
+JNIEXPORT jfloat JNICALL Java_com_mousebird_maply_RenderController_getDynamicResolutionScale(JNIEnv *env, jobject obj)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			return renderer->getDynamicResolution().getScale();
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::getDynamicResolutionScale()");
+	}
+	return 1.0f;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setChangeBudget(JNIEnv *env, jobject obj, jdouble maxTime, jlong maxBytes)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			if (Scene *scene = renderer->getScene())
+				scene->setChangeBudget(maxTime,(size_t)std::max(maxBytes,(jlong)0));
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::setChangeBudget()");
+	}
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setFrameStatsEnabled(JNIEnv *env, jobject obj, jboolean enable)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			renderer->getFrameStats().setEnable(enable);
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::setFrameStatsEnabled()");
+	}
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_getFrameStatsEnabled(JNIEnv *env, jobject obj)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			return renderer->getFrameStats().isEnabled();
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::getFrameStatsEnabled()");
+	}
+	return false;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_clearFrameStats(JNIEnv *env, jobject obj)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			renderer->getFrameStats().clear();
+		}
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::clearFrameStats()");
+	}
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL Java_com_mousebird_maply_RenderController_getFrameStatNames(JNIEnv *env, jclass)
+{
+	try
+	{
+		std::vector<std::string> names;
+		names.reserve(FrameStats::NumMetrics);
+		for (int ii=0;ii<FrameStats::NumMetrics;ii++)
+		{
+			names.emplace_back(FrameStats::getMetricName((FrameStats::Metric)ii));
+		}
+		return BuildStringArray(env,names);
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::getFrameStatNames()");
+	}
+	return nullptr;
+}
+
+// Seven values per metric: count, min, max, mean, p50, p95, p99
+extern "C"
+JNIEXPORT jdoubleArray JNICALL Java_com_mousebird_maply_RenderController_getFrameStatValues(JNIEnv *env, jobject obj)
+{
+	try
+	{
+		SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj);
+		if (!renderer)
+			return nullptr;
+
+		const auto summaries = renderer->getFrameStats().getSummaries();
+		std::vector<double> vals;
+		vals.reserve(summaries.size() * 7);
+		for (const auto &summary : summaries)
+		{
+			vals.push_back(summary.numFrames);
+			vals.push_back(summary.minVal);
+			vals.push_back(summary.maxVal);
+			vals.push_back(summary.mean);
+			vals.push_back(summary.p50);
+			vals.push_back(summary.p95);
+			vals.push_back(summary.p99);
+		}
+		return BuildDoubleArray(env,vals);
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::getFrameStatValues()");
+	}
+	return nullptr;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setGPUTimingsEnabled(JNIEnv *env, jobject obj, jboolean enable)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			renderer->getGPUTimings().setEnable(enable);
+		}
+	}
+	MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_getGPUTimingsEnabled(JNIEnv *env, jobject obj)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			return renderer->getGPUTimings().isEnabled();
+		}
+	}
+	MAPLY_STD_JNI_CATCH()
+	return false;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_clearGPUTimings(JNIEnv *env, jobject obj)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			renderer->getGPUTimings().clear();
+		}
+	}
+	MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL Java_com_mousebird_maply_RenderController_getGPUTimingNames(JNIEnv *env, jclass)
+{
+	try
+	{
+		std::vector<std::string> names;
+		names.reserve(GPUTimings::NumPhases);
+		for (int ii=0;ii<GPUTimings::NumPhases;ii++)
+		{
+			names.emplace_back(GPUTimings::getPhaseName((GPUTimings::Phase)ii));
+		}
+		return BuildStringArray(env,names);
+	}
+	MAPLY_STD_JNI_CATCH()
+	return nullptr;
+}
+
+// Same seven values per phase as the frame stats
+extern "C"
+JNIEXPORT jdoubleArray JNICALL Java_com_mousebird_maply_RenderController_getGPUTimingValues(JNIEnv *env, jobject obj)
+{
+	try
+	{
+		SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj);
+		if (!renderer)
+			return nullptr;
+
+		const auto summaries = renderer->getGPUTimings().getSummaries();
+		std::vector<double> vals;
+		vals.reserve(summaries.size() * 7);
+		for (const auto &summary : summaries)
+		{
+			vals.push_back(summary.numFrames);
+			vals.push_back(summary.minVal);
+			vals.push_back(summary.maxVal);
+			vals.push_back(summary.mean);
+			vals.push_back(summary.p50);
+			vals.push_back(summary.p95);
+			vals.push_back(summary.p99);
+		}
+		return BuildDoubleArray(env,vals);
+	}
+	MAPLY_STD_JNI_CATCH()
+	return nullptr;
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL Java_com_mousebird_maply_RenderController_getStartupPhaseNames(JNIEnv *env, jobject obj)
+{
+	try
+	{
+		SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj);
+		if (!renderer)
+			return nullptr;
+
+		std::vector<std::string> names;
+		for (const auto &phase : renderer->getStartupTimeline().getPhases())
+		{
+			names.push_back(phase.name);
+		}
+		return BuildStringArray(env,names);
+	}
+	MAPLY_STD_JNI_CATCH()
+	return nullptr;
+}
+
+// Start and end for each phase, in the same order as the names
+extern "C"
+JNIEXPORT jdoubleArray JNICALL Java_com_mousebird_maply_RenderController_getStartupPhaseTimes(JNIEnv *env, jobject obj)
+{
+	try
+	{
+		SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj);
+		if (!renderer)
+			return nullptr;
+
+		std::vector<double> vals;
+		for (const auto &phase : renderer->getStartupTimeline().getPhases())
+		{
+			vals.push_back(phase.start);
+			vals.push_back(phase.end);
+		}
+		return BuildDoubleArray(env,vals);
+	}
+	MAPLY_STD_JNI_CATCH()
+	return nullptr;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setFastStartup(JNIEnv *env, jobject obj, jboolean fastStartup)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			renderer->setFastStartup(fastStartup);
+		}
+	}
+	MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_getFastStartup(JNIEnv *env, jobject obj)
+{
+	try
+	{
+		if (SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj))
+		{
+			return renderer->getFastStartup();
+		}
+	}
+	MAPLY_STD_JNI_CATCH()
+	return false;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setTraceRecording(JNIEnv *env, jclass, jboolean record)
+{
+	TraceZones::setRecording(record);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setSystemTracing(JNIEnv *env, jclass, jboolean trace)
+{
+	TraceZones::setSystemTracing(trace);
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL Java_com_mousebird_maply_RenderController_getTraceJSON(JNIEnv *env, jclass)
+{
+	try
+	{
+		return env->NewStringUTF(TraceZones::getChromeTrace().c_str());
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::getTraceJSON()");
+	}
+	return nullptr;
+}
+
 extern "C"
 JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_addLight(JNIEnv *env, jobject obj, jobject lightObj)
 {
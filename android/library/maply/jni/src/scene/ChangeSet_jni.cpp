@@ -113,6 +113,9 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_ChangeSet_process
 			return;
 		}
 
+	    // Toss anything redundant before we spend time setting it up
+	    compactChanges(**changes);
+
 	    bool requiresFlush = false;
 	    // Set up anything that needs to be set up
 	    ChangeSet changesToAdd;
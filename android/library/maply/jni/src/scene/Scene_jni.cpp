@@ -125,6 +125,170 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_Scene_removeShaderProgram(JNIEnv
     MAPLY_STD_JNI_CATCH()
 }
 
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_Scene_setGlyphCacheDir(JNIEnv *env, jobject obj, jstring dirStr)
+{
+    try
+    {
+        if (Scene *scene = SceneClassInfo::get(env,obj))
+        if (const auto fontTexManager = scene->getFontTextureManager())
+        {
+            const JavaString dir(env,dirStr);
+            fontTexManager->setGlyphCache(dir ? GlyphCache::getShared(dir.getString()) : GlyphCacheRef());
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_Scene_setLabelSDF(JNIEnv *env, jobject obj, jboolean enable)
+{
+    try
+    {
+        if (Scene *scene = SceneClassInfo::get(env,obj))
+        if (const auto fontTexManager = scene->getFontTextureManager())
+        {
+            fontTexManager->setSDFMode(enable);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_Scene_setLabelAtlasCompaction(JNIEnv *env, jobject obj, jboolean enable)
+{
+    try
+    {
+        if (Scene *scene = SceneClassInfo::get(env,obj))
+        if (const auto fontTexManager = scene->getFontTextureManager())
+        {
+            fontTexManager->setAtlasCompaction(enable);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_Scene_retainSharedImage(JNIEnv *env, jobject obj, jlong contentHash)
+{
+    try
+    {
+        if (Scene *scene = SceneClassInfo::get(env,obj))
+        {
+            return (jlong)scene->retainSharedImage((uint64_t)contentHash);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return EmptyIdentity;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_Scene_addSharedImage(JNIEnv *env, jobject obj, jlong contentHash, jlong texID)
+{
+    try
+    {
+        if (Scene *scene = SceneClassInfo::get(env,obj))
+        {
+            scene->addSharedImage((uint64_t)contentHash,texID);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_Scene_releaseSharedImage(JNIEnv *env, jobject obj, jlong texID)
+{
+    try
+    {
+        if (Scene *scene = SceneClassInfo::get(env,obj))
+        {
+            return scene->releaseSharedImage(texID);
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return true;
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL Java_com_mousebird_maply_Scene_getMemoryUsageNative(JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (Scene *scene = SceneClassInfo::get(env,obj))
+        {
+            MemoryUsage usage = scene->getMemoryGovernor().getUsage();
+
+            // Nothing reports texture and buffer memory for OpenGL ES, so the ledger fills in
+            const auto byType = scene->getMemoryLedger().getByType();
+            for (const auto &it : byType)
+            {
+                if (it.first == "texture")
+                    usage.bytes[MemTextures] += it.second.gpuBytes;
+                else if (it.first != "dynamicTexture")
+                    usage.bytes[MemVertexBuffers] += it.second.gpuBytes;
+            }
+
+            return BuildLongArray(env,std::vector<SimpleIdentity>(&usage.bytes[0],&usage.bytes[MemNumCategories]));
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return nullptr;
+}
+
+// The names and, three to a name, the count, CPU bytes and GPU bytes.
+// They come back together so they're from the same moment.
+extern "C"
+JNIEXPORT jobjectArray JNICALL Java_com_mousebird_maply_Scene_getMemoryLedgerNative(JNIEnv *env, jobject obj, jboolean byType)
+{
+    try
+    {
+        if (Scene *scene = SceneClassInfo::get(env,obj))
+        {
+            const auto &ledger = scene->getMemoryLedger();
+            const auto entries = byType ? ledger.getByType() : ledger.getByOwner();
+
+            std::vector<std::string> names;
+            std::vector<SimpleIdentity> vals;
+            names.reserve(entries.size());
+            vals.reserve(entries.size() * 3);
+            for (const auto &it : entries)
+            {
+                names.push_back(it.first);
+                vals.push_back(it.second.count);
+                vals.push_back(it.second.cpuBytes);
+                vals.push_back(it.second.gpuBytes);
+            }
+
+            jclass objClass = env->FindClass("java/lang/Object");
+            jobjectArray ret = env->NewObjectArray(2, objClass, nullptr);
+            env->DeleteLocalRef(objClass);
+            jobjectArray namesArr = BuildStringArray(env,names);
+            jlongArray valsArr = BuildLongArray(env,vals);
+            env->SetObjectArrayElement(ret, 0, namesArr);
+            env->SetObjectArrayElement(ret, 1, valsArr);
+            env->DeleteLocalRef(namesArr);
+            env->DeleteLocalRef(valsArr);
+            return ret;
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return nullptr;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_Scene_trimMemory(JNIEnv *env, jobject obj, jint level)
+{
+    try
+    {
+        if (Scene *scene = SceneClassInfo::get(env,obj))
+        {
+            PlatformInfo_Android inst(env);
+            scene->trimMemory(&inst,(MemoryTrimLevel)std::min(std::max((int)level,(int)MemTrimNone),(int)MemTrimAtlasPages));
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
 extern "C"
 JNIEXPORT void JNICALL Java_com_mousebird_maply_Scene_teardownGL(JNIEnv *env, jobject obj)
 {
@@ -142,7 +306,8 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_Scene_teardownGL(JNIEnv *env, jo
 extern "C"
 JNIEXPORT void JNICALL Java_com_mousebird_maply_Scene_addRenderTargetNative
   (JNIEnv *env, jobject obj, jlong renderTargetID, jint width, jint height, jlong texID,
-   jboolean clearEveryFrame, jfloat clearVal, jboolean blend, jfloat r, jfloat g, jfloat b, jfloat a)
+   jboolean clearEveryFrame, jfloat clearVal, jboolean blend, jboolean renderWhenChanged,
+   jfloat r, jfloat g, jfloat b, jfloat a)
 {
     try
     {
@@ -152,7 +317,8 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_Scene_addRenderTargetNative
             const RGBAColor color(r * 255.0, g * 255.0, b * 255.0, a * 255.0);
             changes.push_back(
                     new AddRenderTargetReq(renderTargetID, width, height, texID, clearEveryFrame,
-                                           blend, color, clearVal, RenderTargetMipmapNone, false));
+                                           blend, color, clearVal, RenderTargetMipmapNone, false,
+                                           renderWhenChanged));
 
             scene->addChangeRequests(changes);
         }
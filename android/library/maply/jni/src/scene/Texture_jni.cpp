@@ -183,3 +183,23 @@ JNIEXPORT jlong JNICALL Java_com_mousebird_maply_Texture_getID
     
     return EmptyIdentity;
 }
+
+JNIEXPORT jlong JNICALL Java_com_mousebird_maply_Texture_getContentHash
+  (JNIEnv *env, jobject obj)
+{
+	try
+	{
+		TextureClassInfo *classInfo = TextureClassInfo::getClassInfo();
+		Texture *tex = classInfo->getObject(env,obj);
+		if (!tex)
+			return 0;
+
+		return (jlong)tex->getContentHash();
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in Texture::getContentHash()");
+	}
+
+	return 0;
+}
@@ -20,6 +20,7 @@
 #import "Geometry_jni.h"
 #import "CoordSystem_jni.h"
 #import "Renderer_jni.h"
+#import "QuadLoading_jni.h"
 #import "com_mousebird_maply_Sticker.h"
 
 using namespace Eigen;
@@ -219,3 +220,22 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_Sticker_setTextureIDs
         __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in SphericalChunk::setTextureIDs()");
     }
 }
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_Sticker_setupTiledSampling
+  (JNIEnv *env, jobject obj, jobject paramsObj, jint imageWidth, jint imageHeight, jint tileSize)
+{
+    try
+    {
+        SphericalChunk *chunk = SphericalChunkClassInfo::get(env,obj);
+        SamplingParams *params = SamplingParamsClassInfo::get(env,paramsObj);
+        // The tile geometry can't follow a rotated sticker
+        if (!chunk || !params || chunk->rotation != 0.0)
+            return false;
+
+        const CoordSystemRef coordSys = chunk->coordSys ? chunk->coordSys : std::make_shared<PlateCarreeCoordSystem>();
+        return params->setupTiledImage(coordSys,MbrD(chunk->mbr),imageWidth,imageHeight,tileSize);
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
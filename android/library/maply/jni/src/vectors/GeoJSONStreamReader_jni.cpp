@@ -0,0 +1,153 @@
+/*  GeoJSONStreamReader_jni.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "Vectors_jni.h"
+#import "GeoJSONStreamReader.h"
+#import "com_mousebird_maply_GeoJSONStreamReader.h"
+
+using namespace WhirlyKit;
+
+// Reads GeoJSON out of a Java InputStream a piece at a time
+class GeoJSONStreamReaderAndroid
+{
+public:
+    GeoJSONStreamReaderAndroid(JNIEnv *env,jobject inStream) :
+        reader([this](char *buf,size_t len){ return readStream(buf,len); })
+    {
+        stream = env->NewGlobalRef(inStream);
+        javaBuf = (jbyteArray)env->NewGlobalRef(env->NewByteArray(BufSize));
+        jclass streamClass = env->GetObjectClass(inStream);
+        readMethod = env->GetMethodID(streamClass,"read","([BII)I");
+        env->DeleteLocalRef(streamClass);
+    }
+
+    void clear(JNIEnv *env)
+    {
+        env->DeleteGlobalRef(stream);
+        env->DeleteGlobalRef(javaBuf);
+    }
+
+    // Pull out as much as the Java buffer will hold.
+    // Only called from within next(), which gives us the environment to use.
+    size_t readStream(char *buf,size_t len)
+    {
+        if (!env || !readMethod)
+            return 0;
+        const jint toRead = (jint)std::min(len,(size_t)BufSize);
+        const jint numRead = env->CallIntMethod(stream,readMethod,javaBuf,0,toRead);
+        if (logAndClearJVMException(env,"GeoJSONStreamReader read"))
+            return 0;
+        if (numRead <= 0)
+            return 0;
+        env->GetByteArrayRegion(javaBuf,0,numRead,(jbyte *)buf);
+        return (size_t)numRead;
+    }
+
+    static constexpr jint BufSize = 64 * 1024;
+
+    GeoJSONStreamReader reader;
+    JNIEnv *env = nullptr;
+    jobject stream = nullptr;
+    jbyteArray javaBuf = nullptr;
+    jmethodID readMethod = nullptr;
+};
+
+typedef JavaClassInfo<GeoJSONStreamReaderAndroid> GeoJSONStreamReaderClassInfo;
+template<> GeoJSONStreamReaderClassInfo *GeoJSONStreamReaderClassInfo::classInfoObj = nullptr;
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeoJSONStreamReader_nativeInit
+  (JNIEnv *env, jclass cls)
+{
+    GeoJSONStreamReaderClassInfo::getClassInfo(env,cls);
+}
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeoJSONStreamReader_initialise
+  (JNIEnv *env, jobject obj, jobject stream)
+{
+    try
+    {
+        GeoJSONStreamReaderClassInfo::getClassInfo()->setHandle(env,obj,new GeoJSONStreamReaderAndroid(env,stream));
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+static std::mutex disposeMutex;
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_GeoJSONStreamReader_dispose
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        GeoJSONStreamReaderClassInfo *classInfo = GeoJSONStreamReaderClassInfo::getClassInfo();
+        std::lock_guard<std::mutex> lock(disposeMutex);
+        if (GeoJSONStreamReaderAndroid *inst = classInfo->getObject(env,obj))
+        {
+            inst->clear(env);
+            delete inst;
+        }
+        classInfo->clearHandle(env,obj);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+JNIEXPORT jobject JNICALL Java_com_mousebird_maply_GeoJSONStreamReader_next
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (GeoJSONStreamReaderAndroid *inst = GeoJSONStreamReaderClassInfo::get(env,obj))
+        {
+            ShapeSet shapes;
+            MutableDictionaryRef attrs;
+            inst->env = env;
+            const bool found = inst->reader.next(shapes,attrs);
+            inst->env = nullptr;
+            if (found)
+            {
+                auto vecObj = std::make_shared<VectorObject>();
+                vecObj->shapes = std::move(shapes);
+                return MakeVectorObject(env,vecObj);
+            }
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return nullptr;
+}
+
+JNIEXPORT jstring JNICALL Java_com_mousebird_maply_GeoJSONStreamReader_getCRS
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (GeoJSONStreamReaderAndroid *inst = GeoJSONStreamReaderClassInfo::get(env,obj))
+            return env->NewStringUTF(inst->reader.getCRS().c_str());
+    }
+    MAPLY_STD_JNI_CATCH()
+    return nullptr;
+}
+
+JNIEXPORT jstring JNICALL Java_com_mousebird_maply_GeoJSONStreamReader_getError
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (GeoJSONStreamReaderAndroid *inst = GeoJSONStreamReaderClassInfo::get(env,obj))
+            return env->NewStringUTF(inst->reader.getError().c_str());
+    }
+    MAPLY_STD_JNI_CATCH()
+    return nullptr;
+}
@@ -183,6 +183,38 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_LoftedPolyInfo_setOutlineBottom
     }
 }
 
+JNIEXPORT void JNICALL Java_com_mousebird_maply_LoftedPolyInfo_setShaderExtrude
+        (JNIEnv *env, jobject obj, jboolean shaderExtrude)
+{
+    try
+    {
+        LoftedPolyInfoRef *loftInfo = LoftedPolyInfoClassInfo::getClassInfo()->getObject(env,obj);
+        if (!loftInfo)
+            return;
+        (*loftInfo)->shaderExtrude = shaderExtrude;
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in LoftedPolyInfo::setShaderExtrude()");
+    }
+}
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_LoftedPolyInfo_setMergeRoofs
+        (JNIEnv *env, jobject obj, jboolean mergeRoofs)
+{
+    try
+    {
+        LoftedPolyInfoRef *loftInfo = LoftedPolyInfoClassInfo::getClassInfo()->getObject(env,obj);
+        if (!loftInfo)
+            return;
+        (*loftInfo)->mergeRoofs = mergeRoofs;
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in LoftedPolyInfo::setMergeRoofs()");
+    }
+}
+
 JNIEXPORT void JNICALL Java_com_mousebird_maply_LoftedPolyInfo_setOutlineDrawPriority
         (JNIEnv *env, jobject obj, jint outlineDrawPriority)
 {
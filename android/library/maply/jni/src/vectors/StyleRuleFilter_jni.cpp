@@ -0,0 +1,195 @@
+/*  StyleRuleFilter_jni.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "Vectors_jni.h"
+#import "StyleRuleFilter.h"
+#import "com_mousebird_maply_StyleRuleFilter.h"
+
+using namespace WhirlyKit;
+
+typedef JavaClassInfo<StyleRuleFilter> StyleRuleFilterClassInfo;
+template<> StyleRuleFilterClassInfo *StyleRuleFilterClassInfo::classInfoObj = nullptr;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_StyleRuleFilter_nativeInit(JNIEnv *env, jclass cls)
+{
+	StyleRuleFilterClassInfo::getClassInfo(env,cls);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_StyleRuleFilter_initialise(JNIEnv *env, jobject obj)
+{
+	try
+	{
+		StyleRuleFilterClassInfo::getClassInfo()->setHandle(env,obj,new StyleRuleFilter());
+	}
+	MAPLY_STD_JNI_CATCH()
+}
+
+static std::mutex disposeMutex;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_StyleRuleFilter_dispose(JNIEnv *env, jobject obj)
+{
+	try
+	{
+		StyleRuleFilterClassInfo *classInfo = StyleRuleFilterClassInfo::getClassInfo();
+		std::lock_guard<std::mutex> lock(disposeMutex);
+		delete classInfo->getObject(env,obj);
+		classInfo->clearHandle(env,obj);
+	}
+	MAPLY_STD_JNI_CATCH()
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addAttr(JNIEnv *env, jobject obj, jstring nameStr)
+{
+	try
+	{
+		if (StyleRuleFilter *filter = StyleRuleFilterClassInfo::get(env,obj))
+		{
+			JavaString name(env,nameStr);
+			return filter->addAttr(name.getCString());
+		}
+	}
+	MAPLY_STD_JNI_CATCH()
+	return -1;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addLiteral(JNIEnv *env, jobject obj, jstring valStr)
+{
+	try
+	{
+		if (StyleRuleFilter *filter = StyleRuleFilterClassInfo::get(env,obj))
+		{
+			JavaString val(env,valStr);
+			return filter->addLiteral(val.getCString());
+		}
+	}
+	MAPLY_STD_JNI_CATCH()
+	return -1;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addArith(JNIEnv *env, jobject obj, jint type, jint left, jint right)
+{
+	try
+	{
+		if (StyleRuleFilter *filter = StyleRuleFilterClassInfo::get(env,obj))
+			return filter->addArith((StyleExprType)type,left,right);
+	}
+	MAPLY_STD_JNI_CATCH()
+	return -1;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addCompare(JNIEnv *env, jobject obj, jint op, jint left, jint right, jboolean matchCase)
+{
+	try
+	{
+		if (StyleRuleFilter *filter = StyleRuleFilterClassInfo::get(env,obj))
+			return filter->addCompare((StyleRuleOp)op,left,right,matchCase);
+	}
+	MAPLY_STD_JNI_CATCH()
+	return -1;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addIsNull(JNIEnv *env, jobject obj, jint expr)
+{
+	try
+	{
+		if (StyleRuleFilter *filter = StyleRuleFilterClassInfo::get(env,obj))
+			return filter->addIsNull(expr);
+	}
+	MAPLY_STD_JNI_CATCH()
+	return -1;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addLike(JNIEnv *env, jobject obj, jint expr, jstring patternStr,
+                                                                        jchar wildCard, jchar singleChar, jchar escapeChar, jboolean matchCase)
+{
+	try
+	{
+		// The matcher works on bytes, so the special characters have to be plain ASCII
+		if (wildCard > 127 || singleChar > 127 || escapeChar > 127)
+			return -1;
+		if (StyleRuleFilter *filter = StyleRuleFilterClassInfo::get(env,obj))
+		{
+			JavaString pattern(env,patternStr);
+			return filter->addLike(expr,pattern.getCString(),(char)wildCard,(char)singleChar,(char)escapeChar,matchCase);
+		}
+	}
+	MAPLY_STD_JNI_CATCH()
+	return -1;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addBetween(JNIEnv *env, jobject obj, jint expr, jint lower, jint upper)
+{
+	try
+	{
+		if (StyleRuleFilter *filter = StyleRuleFilterClassInfo::get(env,obj))
+			return filter->addBetween(expr,lower,upper);
+	}
+	MAPLY_STD_JNI_CATCH()
+	return -1;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_StyleRuleFilter_addLogical(JNIEnv *env, jobject obj, jint op, jintArray testsArray)
+{
+	try
+	{
+		if (StyleRuleFilter *filter = StyleRuleFilterClassInfo::get(env,obj))
+		{
+			std::vector<int> tests;
+			ConvertIntArray(env,testsArray,tests);
+			return filter->addLogical((StyleRuleOp)op,tests);
+		}
+	}
+	MAPLY_STD_JNI_CATCH()
+	return -1;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_StyleRuleFilter_compile(JNIEnv *env, jobject obj, jint root)
+{
+	try
+	{
+		if (StyleRuleFilter *filter = StyleRuleFilterClassInfo::get(env,obj))
+			return filter->compile(root);
+	}
+	MAPLY_STD_JNI_CATCH()
+	return false;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_StyleRuleFilter_test(JNIEnv *env, jobject obj, jobject attrsObj)
+{
+	try
+	{
+		StyleRuleFilter *filter = StyleRuleFilterClassInfo::get(env,obj);
+		MutableDictionary_AndroidRef *attrs = AttrDictClassInfo::get(env,attrsObj);
+		if (filter && attrs && *attrs)
+			return filter->test(**attrs);
+	}
+	MAPLY_STD_JNI_CATCH()
+	return false;
+}
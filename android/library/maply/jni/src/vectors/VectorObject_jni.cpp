@@ -225,6 +225,93 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_VectorObject_addLinear
     return false;
 }
 
+// Read X,Y doubles from a direct buffer, converting as we go.  The buffer may not be aligned for doubles.
+static bool ReadDirectPoints(JNIEnv *env,jobject buffer,jint offset,jint len,VectorRing &pts)
+{
+    const auto bytes = (const unsigned char *)GetDirectBufferRange(env,buffer,offset,len);
+    if (!bytes)
+    {
+        return false;
+    }
+    const size_t numPts = len / (2 * sizeof(double));
+    pts.reserve(pts.size() + numPts);
+    for (size_t ii = 0; ii < numPts; ii++)
+    {
+        double xy[2];
+        memcpy(xy, bytes + ii * sizeof(xy), sizeof(xy));
+        pts.emplace_back(xy[0], xy[1]);
+    }
+    return true;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_VectorObject_addLinearDirect
+  (JNIEnv *env, jobject obj, jobject buffer, jint offset, jint len)
+{
+    try
+    {
+        if (const auto vecObj = VectorObjectClassInfo::get(env,obj))
+        {
+            VectorLinearRef lin = VectorLinear::createLinear();
+            if (!ReadDirectPoints(env, buffer, offset, len, lin->pts))
+            {
+                return false;
+            }
+            lin->initGeoMbr();
+            (*vecObj)->shapes.insert(lin);
+            return true;
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_VectorObject_addArealDirect
+  (JNIEnv *env, jobject obj, jobject buffer, jint offset, jint len, jintArray loopSizesArray)
+{
+    try
+    {
+        if (const auto vecObj = VectorObjectClassInfo::get(env,obj))
+        {
+            VectorRing allPts;
+            if (!ReadDirectPoints(env, buffer, offset, len, allPts))
+            {
+                return false;
+            }
+
+            // The points are all the loops end to end, the outer one first
+            std::vector<int> loopSizes;
+            if (loopSizesArray)
+            {
+                ConvertIntArray(env, loopSizesArray, loopSizes);
+            }
+            else
+            {
+                loopSizes.push_back((int)allPts.size());
+            }
+
+            VectorArealRef ar = VectorAreal::createAreal();
+            ar->loops.reserve(loopSizes.size());
+            size_t start = 0;
+            for (const int loopSize : loopSizes)
+            {
+                if (loopSize < 0 || start + loopSize > allPts.size())
+                {
+                    return false;
+                }
+                ar->loops.emplace_back(allPts.begin() + start, allPts.begin() + start + loopSize);
+                start += loopSize;
+            }
+            ar->initGeoMbr();
+            (*vecObj)->shapes.insert(ar);
+            return true;
+        }
+    }
+    MAPLY_STD_JNI_CATCH()
+    return false;
+}
+
 extern "C"
 JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_VectorObject_addAreal___3Lcom_mousebird_maply_Point2d_2
   (JNIEnv *env, jobject obj, jobjectArray ptsObj)
@@ -0,0 +1,119 @@
+/*  VectorTiler_jni.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <unordered_map>
+#import "Vectors_jni.h"
+#import "VectorTiler.h"
+#import "com_mousebird_maply_VectorTiler.h"
+
+using namespace WhirlyKit;
+
+typedef JavaClassInfo<VectorTilerRef> VectorTilerClassInfo;
+template<> VectorTilerClassInfo *VectorTilerClassInfo::classInfoObj = nullptr;
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_VectorTiler_nativeInit
+  (JNIEnv *env, jclass cls)
+{
+    VectorTilerClassInfo::getClassInfo(env,cls);
+}
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_VectorTiler_initialise
+  (JNIEnv *env, jobject obj, jint maxZoom, jint indexMaxZoom, jint indexMaxPoints, jdouble tolerance, jdouble buffer)
+{
+    try
+    {
+        VectorTilerSettings settings;
+        settings.maxZoom = maxZoom;
+        settings.indexMaxZoom = indexMaxZoom;
+        settings.indexMaxPoints = indexMaxPoints;
+        settings.tolerance = tolerance;
+        settings.buffer = buffer;
+        VectorTilerClassInfo::getClassInfo()->setHandle(env,obj,new VectorTilerRef(std::make_shared<VectorTiler>(settings)));
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+static std::mutex disposeMutex;
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_VectorTiler_dispose
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        VectorTilerClassInfo *classInfo = VectorTilerClassInfo::getClassInfo();
+        std::lock_guard<std::mutex> lock(disposeMutex);
+        delete classInfo->getObject(env,obj);
+        classInfo->clearHandle(env,obj);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_VectorTiler_addVectorsNative
+  (JNIEnv *env, jobject obj, jobject vecObj)
+{
+    try
+    {
+        VectorTilerRef *tiler = VectorTilerClassInfo::get(env,obj);
+        VectorObjectRef *vec = VectorObjectClassInfo::get(env,vecObj);
+        if (tiler && vec)
+            (*tiler)->addShapes((*vec)->shapes);
+    }
+    MAPLY_STD_JNI_CATCH()
+}
+
+JNIEXPORT jobjectArray JNICALL Java_com_mousebird_maply_VectorTiler_getTile
+  (JNIEnv *env, jobject obj, jint x, jint y, jint level)
+{
+    try
+    {
+        VectorTilerRef *tiler = VectorTilerClassInfo::get(env,obj);
+        if (!tiler)
+            return nullptr;
+
+        const auto shapes = (*tiler)->getTile(x,y,level);
+        if (shapes.empty())
+            return nullptr;
+
+        // Pieces of the same feature share attributes, so put them back together
+        std::unordered_map<const Dictionary *,VectorObjectRef> features;
+        std::vector<VectorObjectRef> featureOrder;
+        for (const auto &shape : shapes)
+        {
+            auto &feature = features[shape->getAttrDict().get()];
+            if (!feature)
+            {
+                feature = std::make_shared<VectorObject>();
+                featureOrder.push_back(feature);
+            }
+            feature->shapes.insert(shape);
+        }
+
+        VectorObjectClassInfo *vecClassInfo = VectorObjectClassInfo::getClassInfo(env,"com/mousebird/maply/VectorObject");
+        std::vector<jobject> vecObjs;
+        vecObjs.reserve(featureOrder.size());
+        for (const auto &feature : featureOrder)
+            if (jobject vecObj = MakeVectorObjectWrapper(env,vecClassInfo,feature))
+                vecObjs.push_back(vecObj);
+
+        jobjectArray retArray = BuildObjectArray(env,vecClassInfo->getClass(),vecObjs);
+        for (jobject vecObj : vecObjs)
+            env->DeleteLocalRef(vecObj);
+        return retArray;
+    }
+    MAPLY_STD_JNI_CATCH()
+    return nullptr;
+}
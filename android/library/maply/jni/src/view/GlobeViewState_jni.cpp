@@ -44,10 +44,10 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_GlobeViewState_initialise
 		if (!globeView || !renderer)
 			return;
 
-		GlobeViewStateRef *globeViewState = new GlobeViewStateRef(new WhirlyGlobe::GlobeViewState(globeView,renderer));
-
-		if (globeViewState)
-			GlobeViewStateRefClassInfo::getClassInfo()->setHandle(env,obj,globeViewState);
+		// Share the snapshot the renderer and everyone else are using
+		const auto viewState = std::dynamic_pointer_cast<WhirlyGlobe::GlobeViewState>(globeView->getViewState(renderer));
+		if (viewState)
+			GlobeViewStateRefClassInfo::getClassInfo()->setHandle(env,obj,new GlobeViewStateRef(viewState));
 	}
 	catch (...)
 	{
@@ -45,10 +45,10 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_MapViewState_initialise
 		if (!mapView || !renderer)
 			return;
 
-		MapViewStateRef *mapViewState = new MapViewStateRef(new Maply::MapViewState(mapView,renderer));
-
-		if (mapViewState)
-			MapViewStateRefClassInfo::getClassInfo()->setHandle(env,obj,mapViewState);
+		// Share the snapshot the renderer and everyone else are using
+		const auto viewState = std::dynamic_pointer_cast<Maply::MapViewState>(mapView->getViewState(renderer));
+		if (viewState)
+			MapViewStateRefClassInfo::getClassInfo()->setHandle(env,obj,new MapViewStateRef(viewState));
 	}
 	catch (...)
 	{
@@ -38,6 +38,7 @@ import android.widget.Toast;
 import androidx.annotation.Nullable;
 import org.jetbrains.annotations.NotNull;
 
+import java.io.File;
 import java.io.IOException;
 import java.lang.ref.WeakReference;
 import java.lang.reflect.Array;
@@ -308,11 +309,22 @@ public abstract class BaseController implements RenderController.TaskManager, Re
 		 * Super special option.  You probably don't need that.
 		 */
 		public String loadLibraryName = null;
+		/**
+		 * If set, get something on the screen sooner at startup.
+		 * Image loaders draw the low levels they have in place of tiles that are still loading,
+		 * and the tile fetchers the controller makes read cached tiles without waiting for a
+		 * connection.  The low zoom tiles cached on the last run show up right away.
+		 * Off by default.
+		 */
+		public boolean fastStartup = false;
 	}
 
 	// Set if we're using a TextureView rather than a SurfaceView
 	boolean useTextureView = false;
 
+	// Set if we're taking the fast startup path
+	boolean fastStartup = false;
+
 	/**
 	 * Returns true if we set up a TextureView rather than a SurfaceView.
      */
@@ -393,9 +405,11 @@ public abstract class BaseController implements RenderController.TaskManager, Re
 			numWorkingThreads = settings.numWorkingThreads;
 			width = settings.width;
 			height = settings.height;
+			fastStartup = settings.fastStartup;
 		}
 
 		renderControl = new RenderController();
+		renderControl.setFastStartup(fastStartup);
 	}
 
 	ColorDrawable tempBackground = null;
@@ -972,6 +986,57 @@ public abstract class BaseController implements RenderController.TaskManager, Re
 		displayRate = inRate;
 		if (metroThread != null)
 			metroThread.setFrameRate(inRate);
+		if (renderControl != null)
+			renderControl.setDisplayFrameRate(getEffectiveFrameRate());
+	}
+
+	// Frames per second we'll actually get, given the display and the display rate
+	private int getEffectiveFrameRate()
+	{
+		float refresh = 60.0f;
+		final android.view.Display display = (baseView != null) ? baseView.getDisplay() : null;
+		if (display != null && display.getRefreshRate() > 0.0f)
+			refresh = display.getRefreshRate();
+		return Math.max(1, Math.round(refresh / Math.max(1, displayRate)));
+	}
+
+	/**
+	 * Control how eagerly we render.
+	 * Full is the default.  The other modes slow down frames that don't
+	 * involve the view moving, to save battery.
+	 */
+	public void setFramePacing(RenderController.FramePacing pacing)
+	{
+		if (renderControl != null)
+			renderControl.setFramePacing(pacing);
+	}
+
+	public RenderController.FramePacing getFramePacing()
+	{
+		return (renderControl != null) ? renderControl.getFramePacing() : RenderController.FramePacing.Full;
+	}
+
+	/**
+	 * Trade resolution for frame rate while the map is moving.
+	 * The map drops to as little as minScale of the screen resolution
+	 * when frames run long, but labels and markers stay sharp.
+	 * It goes back to full resolution when the view stops.
+	 * Needs OpenGL ES 3.  See RenderController.setDynamicResolution().
+	 */
+	public void setDynamicResolution(boolean enable, float minScale, float maxScale)
+	{
+		if (renderControl != null)
+			renderControl.setDynamicResolution(enable, minScale, maxScale);
+	}
+
+	/**
+	 * Spread big batches of changes over several frames instead of stalling one.
+	 * See RenderController.setChangeBudget().
+	 */
+	public void setChangeBudget(double maxTime, long maxBytes)
+	{
+		if (renderControl != null)
+			renderControl.setChangeBudget(maxTime, maxBytes);
 	}
 
 	/**
@@ -1041,6 +1106,7 @@ public abstract class BaseController implements RenderController.TaskManager, Re
 			}
 			metroThread = new MetroThread("Metronome Thread", this, displayRate);
 			metroThread.setRenderer(renderControl);
+			renderControl.setDisplayFrameRate(getEffectiveFrameRate());
 
 			// Make our own context that we can use on the main thread
 			final EGL10 egl = (EGL10) EGLContext.getEGL();
@@ -1065,7 +1131,8 @@ public abstract class BaseController implements RenderController.TaskManager, Re
 
 			setClearColor(renderControl.clearColor);
 
-			// Register the shaders
+			// Register the shaders, reusing the linked programs from last time if we can
+			RenderController.setShaderCacheDir(new File(activity.getCacheDir(), "maply_shaders").getAbsolutePath());
 			renderControl.setupShadersNative();
 
 			synchronized (workerThreads) {
@@ -1282,6 +1349,85 @@ public abstract class BaseController implements RenderController.TaskManager, Re
 			renderControl.setPerfInterval(perfInterval);
 	}
 
+	/**
+	 * Turn on/off per-frame stats collection in the renderer.
+	 * Frame time, phase times, draw calls, triangles, texture uploads and
+	 * change requests are kept for the last several hundred frames.
+	 */
+	public void setFrameStatsEnabled(boolean enable)
+	{
+		if (renderControl != null)
+			renderControl.setFrameStatsEnabled(enable);
+	}
+
+	/**
+	 * Summarize the per-frame stats recorded so far.
+	 * Returns null if stats collection isn't on.
+	 */
+	public RenderController.FrameStat[] getFrameStats()
+	{
+		if (renderControl == null || !renderControl.getFrameStatsEnabled())
+			return null;
+		return renderControl.getFrameStats();
+	}
+
+	/**
+	 * Turn on/off GPU timing in the renderer.
+	 * Time spent on the GPU for offscreen targets and the screen is kept for the last
+	 * several hundred frames, on devices with GL_EXT_disjoint_timer_query.
+	 */
+	public void setGPUTimingsEnabled(boolean enable)
+	{
+		if (renderControl != null)
+			renderControl.setGPUTimingsEnabled(enable);
+	}
+
+	/**
+	 * Summarize the GPU times recorded so far.
+	 * Returns null if GPU timing isn't on.
+	 */
+	public RenderController.FrameStat[] getGPUTimings()
+	{
+		if (renderControl == null || !renderControl.getGPUTimingsEnabled())
+			return null;
+		return renderControl.getGPUTimings();
+	}
+
+	/**
+	 * How long each startup phase took, through to the first frame that drew something.
+	 */
+	public RenderController.StartupPhase[] getStartupTimings()
+	{
+		if (renderControl == null)
+			return new RenderController.StartupPhase[0];
+		return renderControl.getStartupTimings();
+	}
+
+	/**
+	 * Record trace zones from the loaders, parsers, layout and renderer.
+	 * Fetch them with getTraceJSON().  This applies to the whole process.
+	 */
+	public void setTraceRecording(boolean record)
+	{
+		RenderController.setTraceRecording(record);
+	}
+
+	/**
+	 * Pass trace zones through to ATrace so they show up in systrace and Perfetto.
+	 */
+	public void setSystemTracing(boolean trace)
+	{
+		RenderController.setSystemTracing(trace);
+	}
+
+	/**
+	 * Recorded trace zones in Chrome trace event format.
+	 */
+	public String getTraceJSON()
+	{
+		return RenderController.getTraceJSON();
+	}
+
 	/**
 	 * Get the zoom limits for the globe.
 	 */
@@ -1485,6 +1631,8 @@ public abstract class BaseController implements RenderController.TaskManager, Re
 		}
 
 		RemoteTileFetcher tileFetcher = new RemoteTileFetcher(this,name);
+		// Cached tiles go straight in on a fast start, they're the placeholders
+		tileFetcher.immediateCacheReads = fastStartup;
 		tileFetchers.add(tileFetcher);
 
 		return tileFetcher;
@@ -1734,6 +1882,23 @@ public abstract class BaseController implements RenderController.TaskManager, Re
 		return renderControl.addScreenMarkers(markers,markerInfo,mode);
 	}
 
+	/**
+	 * Add a packed batch of screen markers.  This is much faster than addScreenMarkers()
+	 * for large numbers of markers, as they go to the native side in one call.
+	 *
+	 * @param batch The markers to add to the display
+	 * @param markerInfo How the markers should look.
+	 * @param mode Where to execute the add.  Choose ThreadAny by default.
+	 * @return This represents the screen markers for later modification or deletion.
+	 */
+	public ComponentObject addScreenMarkers(final ScreenMarkerBatch batch,final MarkerInfo markerInfo,RenderController.ThreadMode mode)
+	{
+		if (!running)
+			return null;
+
+		return renderControl.addScreenMarkers(batch,markerInfo,mode);
+	}
+
     /**
      * Add moving screen markers to the visual display.  These are the same as the regular
      * screen markers, but they have a start and end point and a duration.
@@ -2011,6 +2176,23 @@ public abstract class BaseController implements RenderController.TaskManager, Re
 		return renderControl.addScreenLabels(labels,labelInfo,mode);
 	}
 
+	/**
+	 * Add a packed batch of screen labels.  This is much faster than addScreenLabels()
+	 * for large numbers of labels, as they go to the native side in one call.
+	 *
+	 * @param batch Labels to add to the display.
+	 * @param labelInfo The visual appearance of the labels.
+	 * @param mode Where to execute the add.  Choose ThreadAny by default.
+	 * @return This represents the labels for modification or deletion.
+	 */
+	public ComponentObject addScreenLabels(final ScreenLabelBatch batch,final LabelInfo labelInfo,RenderController.ThreadMode mode)
+	{
+		if (!running)
+			return null;
+
+		return renderControl.addScreenLabels(batch,labelInfo,mode);
+	}
+
 	/**
 	 * Add screen labels to the display.  Screen labels are 2D labels that float above the 3D geometry
 	 * and stay fixed in size no matter how the user zoom in or out.  Their visual appearance is controlled
@@ -31,7 +31,9 @@ import androidx.annotation.ColorInt;
 import androidx.annotation.RequiresApi;
 
 import java.security.InvalidParameterException;
+import java.util.Collection;
 import java.util.HashMap;
+import java.util.Iterator;
 
 /**
  * The basic cluster generator installed by default.
@@ -235,10 +237,14 @@ public class BasicClusterGenerator extends ClusterGenerator {
         return null;
     }
 
+    // Textures are kept from one layout pass to the next until they go unused
     @Override
-    public void endClusterGroup() {
-        super.endClusterGroup();
-        texByNumber.clear();
+    protected void texturesReleased(Collection<Long> texIDs) {
+        for (Iterator<MaplyTexture> it = texByNumber.values().iterator(); it.hasNext(); ) {
+            if (texIDs.contains(it.next().texID)) {
+                it.remove();
+            }
+        }
     }
 
     @Override
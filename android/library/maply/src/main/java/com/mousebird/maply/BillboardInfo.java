@@ -74,6 +74,13 @@ public class BillboardInfo extends BaseInfo {
         return orient;
     }
 
+    /**
+     * Draw plain billboards as instances of a single quad, which is a lot less vertex data.
+     * Only applies with the default billboard shaders.
+     */
+    public native void setInstanced(boolean instanced);
+    public native boolean getInstanced();
+
     public void finalize()
     {
         dispose();
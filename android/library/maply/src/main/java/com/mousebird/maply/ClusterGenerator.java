@@ -21,6 +21,7 @@ import androidx.annotation.Keep;
 
 import java.lang.ref.WeakReference;
 import java.util.ArrayList;
+import java.util.Collection;
 import java.util.HashSet;
 
 import static com.mousebird.maply.RenderController.EmptyIdentity;
@@ -46,9 +47,16 @@ public class ClusterGenerator
     @SuppressWarnings("unused")		// Used from JNI
     public void startClusterGroup() {
         if (oldTextures != null) {
-            BaseController control = baseController.get();
-            if (control != null) {
-                control.removeTexturesByID(new ArrayList<>(oldTextures), RenderController.ThreadMode.ThreadCurrent);
+            // Textures handed back again in the last pass are still in use
+            if (currentTextures != null) {
+                oldTextures.removeAll(currentTextures);
+            }
+            if (!oldTextures.isEmpty()) {
+                texturesReleased(oldTextures);
+                BaseController control = baseController.get();
+                if (control != null) {
+                    control.removeTexturesByID(new ArrayList<>(oldTextures), RenderController.ThreadMode.ThreadCurrent);
+                }
             }
             oldTextures = null;
         }
@@ -57,10 +65,20 @@ public class ClusterGenerator
         currentTextures = new HashSet<>();
     }
 
+    /**
+     * Called with the textures that went unused for a whole layout pass, right before they're removed.
+     * <p>
+     * If you keep textures from one pass to the next, forget these ones.
+     */
+    protected void texturesReleased(Collection<Long> texIDs) {
+    }
+
     /**
      * Generate a cluster group for a given collection of markers.
      * <p>
      * Generate an image and size to represent the number of marker/labels we're consolidating.
+     * Hand back the same texture for clusters that look the same and it's kept as long as
+     * it's in use, rather than making a new one every layout pass.
      * @param clusterInfo Description of the cluster
      * @return a cluster group for a given collection of markers.
      */
@@ -22,7 +22,6 @@ package com.mousebird.maply;
 import com.mousebird.maply.sld.sldstyleset.SLDStyleSet;
 
 import java.io.InputStream;
-import java.io.ByteArrayOutputStream;
 import java.lang.ref.WeakReference;
 import java.util.Arrays;
 import java.util.HashMap;
@@ -123,53 +122,45 @@ public class GeoJSONSource {
      * @param completionBlock Block to execute after completion.
      */
     public void startParse(final Runnable completionBlock) {
-        ByteArrayOutputStream buffer = new ByteArrayOutputStream();
-        int nRead;
-        byte[] data = new byte[16384];
         HashMap<Long, ArrayList<VectorObject>> featureStyles = new HashMap<Long, ArrayList<VectorObject>>();
         ArrayList<ComponentObject> componentObjects = new ArrayList<ComponentObject>();
 
         try {
 
-            while ((nRead = jsonStream.read(data, 0, data.length)) != -1) {
-                buffer.write(data, 0, nRead);
-            }
-            buffer.flush();
-
-            VectorObject vecs = new VectorObject();
-            vecs.fromGeoJSON(buffer.toString());
-
-            if (vecs != null) {
-                TileID nullTileID = new TileID(0,0,0);
-                for (VectorObject vecObj : vecs) {
-                    VectorStyle[] styles = styleSet.stylesForFeature(vecObj.getAttributes(), nullTileID, "", baseController.get());
-                    if (styles == null || styles.length == 0)
-                        continue;;
-                    for (VectorStyle style : styles) {
-                        ArrayList<VectorObject> featuresForStyle = featureStyles.get(style.getUuid());
-                        if (featuresForStyle == null) {
-                            featuresForStyle = new ArrayList<VectorObject>();
-                            featureStyles.put(style.getUuid(), featuresForStyle);
-                        }
-                        featuresForStyle.add(vecObj);
+            // Style the features as they come out of the stream, rather than
+            // reading the whole document in first
+            GeoJSONStreamReader reader = new GeoJSONStreamReader(jsonStream);
+            TileID nullTileID = new TileID(0,0,0);
+            VectorObject vecObj;
+            while ((vecObj = reader.next()) != null) {
+                VectorStyle[] styles = styleSet.stylesForFeature(vecObj.getAttributes(), nullTileID, "", baseController.get());
+                if (styles == null || styles.length == 0)
+                    continue;
+                for (VectorStyle style : styles) {
+                    ArrayList<VectorObject> featuresForStyle = featureStyles.get(style.getUuid());
+                    if (featuresForStyle == null) {
+                        featuresForStyle = new ArrayList<VectorObject>();
+                        featureStyles.put(style.getUuid(), featuresForStyle);
                     }
+                    featuresForStyle.add(vecObj);
                 }
             }
-
-            if (vecs != null) {
-                TileID nullTileID = new TileID(0, 0, 0);
-                Mbr bounds = new Mbr(new Point2d(-Math.PI,-Math.PI/2.0),new Point2d(Math.PI,Math.PI/2.0));
-                VectorTileData tileData = new VectorTileData(nullTileID,bounds,bounds);
-                for (Long uuid : featureStyles.keySet()) {
-                    VectorStyle style = styleSet.styleForUUID(uuid, baseController.get());
-                    ArrayList<VectorObject> featuresForStyle = featureStyles.get(uuid);
-
-                    //List<VectorObject> objects, MaplyTileID tileID, MaplyBaseController controller)
-                    style.buildObjects(featuresForStyle.toArray(new VectorObject[0]), tileData, baseController.get());
-                    ComponentObject[] newCompObjs = tileData.getComponentObjects();
-                    if (newCompObjs != null && newCompObjs.length > 0)
-                       componentObjects.addAll(Arrays.asList(newCompObjs));
-                }
+            String error = reader.getError();
+            if (error != null && !error.isEmpty())
+                Log.w("GeoJSONSource", "Stopped reading GeoJSON: " + error);
+            reader.dispose();
+
+            Mbr bounds = new Mbr(new Point2d(-Math.PI,-Math.PI/2.0),new Point2d(Math.PI,Math.PI/2.0));
+            VectorTileData tileData = new VectorTileData(nullTileID,bounds,bounds);
+            for (Long uuid : featureStyles.keySet()) {
+                VectorStyle style = styleSet.styleForUUID(uuid, baseController.get());
+                ArrayList<VectorObject> featuresForStyle = featureStyles.get(uuid);
+
+                //List<VectorObject> objects, MaplyTileID tileID, MaplyBaseController controller)
+                style.buildObjects(featuresForStyle.toArray(new VectorObject[0]), tileData, baseController.get());
+                ComponentObject[] newCompObjs = tileData.getComponentObjects();
+                if (newCompObjs != null && newCompObjs.length > 0)
+                   componentObjects.addAll(Arrays.asList(newCompObjs));
             }
             baseController.get().enableObjects(componentObjects, RenderController.ThreadMode.ThreadAny);
 
@@ -0,0 +1,75 @@
+/*
+ *  GeoJSONStreamReader.java
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+package com.mousebird.maply;
+
+import java.io.InputStream;
+
+/**
+ * Reads features out of a GeoJSON document one at a time.
+ * <br>
+ * Unlike VectorObject.fromGeoJSON, the document doesn't need to be read into
+ * memory first.  Text is pulled from the stream as it's needed and each feature
+ * comes back as its own VectorObject, with the feature properties as attributes.
+ * <br>
+ * Reading happens on whatever thread calls next().
+ */
+public class GeoJSONStreamReader
+{
+	private GeoJSONStreamReader()
+	{
+	}
+
+	/**
+	 * Construct with the stream to read from.  The caller is still responsible for closing it.
+	 */
+	public GeoJSONStreamReader(InputStream stream)
+	{
+		initialise(stream);
+	}
+
+	/**
+	 * Return the next feature, or null at the end of the document or if something
+	 * went wrong, which getError() will tell you about.
+	 */
+	public native VectorObject next();
+
+	/**
+	 * The coordinate system name given in the document, if any, once we've read past it.
+	 */
+	public native String getCRS();
+
+	/**
+	 * Empty unless the document couldn't be read.
+	 */
+	public native String getError();
+
+	static
+	{
+		nativeInit();
+	}
+	public void finalize() {
+		dispose();
+	}
+	private static native void nativeInit();
+	native void initialise(InputStream stream);
+	native void dispose();
+
+	private long nativeHandle;
+}
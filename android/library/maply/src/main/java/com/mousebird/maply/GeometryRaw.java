@@ -1,5 +1,7 @@
 package com.mousebird.maply;
 
+import java.nio.ByteBuffer;
+
 /**
  * Raw Geometry object.  Collection of points and triangles.
  */
@@ -69,6 +71,60 @@ public class GeometryRaw
      */
     public native void addTriangles(int[] tris);
 
+    /**
+     * Add a group of points straight from a direct buffer, without copying them onto the Java heap.
+     * The buffer holds doubles, X,Y,Z in order, in native byte order.  Everything from
+     * its position to its limit is used.
+     */
+    public void addPoints(ByteBuffer pts) {
+        checkDirect(pts);
+        addPointsDirect(pts, pts.position(), pts.remaining());
+    }
+
+    /**
+     * Add a group of normals from a direct buffer of doubles, X,Y,Z in order, in native byte order.
+     */
+    public void addNorms(ByteBuffer norms) {
+        checkDirect(norms);
+        addNormsDirect(norms, norms.position(), norms.remaining());
+    }
+
+    /**
+     * Add a group of texture coordinates from a direct buffer of floats, u,v in order, in native byte order.
+     */
+    public void addTexCoords(ByteBuffer texCoords) {
+        checkDirect(texCoords);
+        addTexCoordsDirect(texCoords, texCoords.position(), texCoords.remaining());
+    }
+
+    /**
+     * Add a group of colors from a direct buffer of 32 bit ARGB values, in native byte order.
+     */
+    public void addColors(ByteBuffer colors) {
+        checkDirect(colors);
+        addColorsDirect(colors, colors.position(), colors.remaining());
+    }
+
+    /**
+     * Add a group of triangles from a direct buffer of ints, three vertices per triangle, in native byte order.
+     */
+    public void addTriangles(ByteBuffer tris) {
+        checkDirect(tris);
+        addTrianglesDirect(tris, tris.position(), tris.remaining());
+    }
+
+    private static void checkDirect(ByteBuffer buffer) {
+        if (!buffer.isDirect()) {
+            throw new IllegalArgumentException("GeometryRaw needs a direct ByteBuffer");
+        }
+    }
+
+    private native void addPointsDirect(ByteBuffer buffer,int offset,int len);
+    private native void addNormsDirect(ByteBuffer buffer,int offset,int len);
+    private native void addTexCoordsDirect(ByteBuffer buffer,int offset,int len);
+    private native void addColorsDirect(ByteBuffer buffer,int offset,int len);
+    private native void addTrianglesDirect(ByteBuffer buffer,int offset,int len);
+
     public void finalize() {
         dispose();
     }
@@ -25,6 +25,7 @@ import android.os.Build;
 import androidx.annotation.NonNull;
 
 import java.lang.reflect.Field;
+import java.util.ArrayDeque;
 
 /**
  *  Image loader interpreter turns data objects into ImageTiles.
@@ -40,6 +41,13 @@ public class ImageLoaderInterpreter implements LoaderInterpreter
     // This happens for data loading
     public boolean usePremultiply = false;
 
+    // If set, bigger images are scaled down as they're decoded
+    private int maxDecodeSize = 0;
+
+    // The pixels are copied out as soon as a bitmap is decoded, so we can decode into it again
+    private final ArrayDeque<Bitmap> bitmapPool = new ArrayDeque<>();
+    private static final int MaxPooledBitmaps = 4;
+
     public ImageLoaderInterpreter()
     {
         // See if the premultiplied option is available
@@ -62,24 +70,102 @@ public class ImageLoaderInterpreter implements LoaderInterpreter
     {
     }
 
-    // Convert byte arrays into images
-    public void dataForTile(LoaderReturn inLoadReturn,QuadLoaderBase loader)
+    /**
+     * Scale images bigger than this on a side down as they're decoded.
+     * Decoding at the smaller size is a good deal faster and uses less memory.
+     * The decoder works in powers of two, so images come out between this and twice this.
+     * Defaults to 0, which is full size.
+     */
+    public void setMaxDecodeSize(int size)
     {
-        ImageLoaderReturn loadReturn = (ImageLoaderReturn)inLoadReturn;
+        maxDecodeSize = size;
+    }
+
+    public int getMaxDecodeSize()
+    {
+        return maxDecodeSize;
+    }
+
+    // Power of two to scale the image down by, if it's too big
+    private int sampleSizeFor(byte[] image)
+    {
+        if (maxDecodeSize <= 0)
+            return 1;
+
+        // Just reads the header
+        BitmapFactory.Options bounds = new BitmapFactory.Options();
+        bounds.inJustDecodeBounds = true;
+        BitmapFactory.decodeByteArray(image, 0, image.length, bounds);
+        int size = Math.max(bounds.outWidth, bounds.outHeight);
+
+        int sampleSize = 1;
+        while (size / (sampleSize * 2) >= maxDecodeSize)
+            sampleSize *= 2;
+        return sampleSize;
+    }
+
+    private Bitmap getPooledBitmap()
+    {
+        synchronized (bitmapPool) {
+            return bitmapPool.pollFirst();
+        }
+    }
 
+    private void returnPooledBitmap(Bitmap bitmap)
+    {
+        synchronized (bitmapPool) {
+            if (bitmap.isMutable() && bitmapPool.size() < MaxPooledBitmaps) {
+                bitmapPool.addFirst(bitmap);
+                return;
+            }
+        }
+        bitmap.recycle();
+    }
+
+    private Bitmap decodeBitmap(byte[] image)
+    {
         BitmapFactory.Options options = new BitmapFactory.Options();
         //options.inScaled = false;
         if (hasPremultiplyOption && usePremultiply)
             options.inPremultiplied = false;
+        options.inSampleSize = sampleSizeFor(image);
+        options.inMutable = true;
+        options.inBitmap = getPooledBitmap();
+
+        Bitmap bm = null;
+        try {
+            bm = BitmapFactory.decodeByteArray(image, 0, image.length, options);
+        }
+        catch (IllegalArgumentException ex) {
+            // Pooled bitmap was too small for this one
+        }
+        if (bm == null && options.inBitmap != null) {
+            options.inBitmap.recycle();
+            options.inBitmap = null;
+            bm = BitmapFactory.decodeByteArray(image, 0, image.length, options);
+        }
+        return bm;
+    }
+
+    // Convert byte arrays into images
+    public void dataForTile(LoaderReturn inLoadReturn,QuadLoaderBase loader)
+    {
+        ImageLoaderReturn loadReturn = (ImageLoaderReturn)inLoadReturn;
 
         byte[][] images = loadReturn.getTileData();
         for (byte[] image : images) {
             if (loadReturn.isCanceled()) {
                 return;
             }
-            Bitmap bm = BitmapFactory.decodeByteArray(image,0, image.length,options);
-            if (bm != null)
+            // Tiles already in a GPU format skip the decode
+            if (loadReturn.addCompressedImage(image)) {
+                continue;
+            }
+            Bitmap bm = decodeBitmap(image);
+            if (bm != null) {
                 loadReturn.addBitmap(bm);
+                returnPooledBitmap(bm);
+            }
             else
                 loadReturn.errorString = "Failed to decode bitmap";
         }
@@ -50,6 +50,37 @@ public class ImageLoaderReturn extends LoaderReturn
         addImageTile(imageTile);
     }
 
+    /**
+     * Add image data that's already in a GPU format (KTX, KTX2, PKM or .astc).
+     * @return false if that's not what the data is, in which case nothing is added.
+     */
+    public boolean addCompressedImage(byte[] data)
+    {
+        ImageTile imageTile = new ImageTile();
+        if (!imageTile.setCompressedData(data)) {
+            imageTile.dispose();
+            return false;
+        }
+        addImageTile(imageTile);
+        return true;
+    }
+
+    /**
+     * Add a local file that's already in a GPU format (KTX, KTX2, PKM or .astc).
+     * The file is memory mapped, not copied.
+     * @return false if the file can't be read or isn't one of those, in which case nothing is added.
+     */
+    public boolean addCompressedImageFile(String path)
+    {
+        ImageTile imageTile = new ImageTile();
+        if (!imageTile.setCompressedFile(path)) {
+            imageTile.dispose();
+            return false;
+        }
+        addImageTile(imageTile);
+        return true;
+    }
+
     /**
      * Return the images in this loader return.
      */
@@ -22,6 +22,8 @@ package com.mousebird.maply;
 
 import android.graphics.Bitmap;
 
+import java.nio.ByteBuffer;
+
 
 /**
  * The Maply Image Tile represents the image(s) passed back from the network.
@@ -42,8 +44,47 @@ public class ImageTile
 		setBitmap(bitmap);
 	}
 
+	/**
+	 * Construct from RGBA 8888 pixels, tightly packed, in a direct buffer.
+	 * The pixels are used where they are rather than copied, so don't change them
+	 * until the tile has been loaded.
+	 */
+	public ImageTile(ByteBuffer pixels,int width,int height)
+	{
+		initialise();
+		if (!pixels.isDirect() || !setPixelsDirect(pixels,pixels.position(),pixels.remaining(),width,height))
+			throw new IllegalArgumentException("ImageTile needs a direct buffer with width * height * 4 bytes");
+	}
+
 	private native void setBitmap(Bitmap bitmap);
 
+	/**
+	 * Use image data that's already in a GPU format (KTX, KTX2, PKM or .astc with ETC2/EAC or ASTC).
+	 * It goes to the GPU without being decoded.
+	 * @return false if the data isn't one of those, in which case nothing changes.
+	 */
+	native boolean setCompressedData(byte[] data);
+
+	/**
+	 * Use GPU format image data from a direct buffer, from its position to its limit.
+	 * The buffer is held on to, not copied, until the texture is built.
+	 * @return false if the buffer isn't direct or the data isn't one of the formats.
+	 */
+	boolean setCompressedData(ByteBuffer data)
+	{
+		return data.isDirect() && setCompressedDataDirect(data,data.position(),data.remaining());
+	}
+
+	private native boolean setCompressedDataDirect(ByteBuffer data,int offset,int len);
+	private native boolean setPixelsDirect(ByteBuffer pixels,int offset,int len,int width,int height);
+
+	/**
+	 * Use a local file that's already in a GPU format.  The file is mapped rather than
+	 * read in, so large images don't need to be copied onto the Java heap.
+	 * @return false if the file can't be read or isn't one of those formats.
+	 */
+	native boolean setCompressedFile(String path);
+
 	/**
 	 * If the image has a border built in, set that here.
 	 */
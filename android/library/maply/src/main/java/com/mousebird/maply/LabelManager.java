@@ -20,6 +20,7 @@
 
 package com.mousebird.maply;
 
+import java.nio.ByteBuffer;
 import java.util.List;
 
 /**
@@ -45,6 +46,14 @@ class LabelManager
 	// Add labels to the scene and return an ID to track them
 	public native long addLabels(InternalLabel[] labels,LabelInfo labelInfo,ChangeSet changes);
 	
+	// Add packed screen labels in one go.  See ScreenLabelBatch for the layout.
+	public long addScreenLabels(ScreenLabelBatch batch,LabelInfo labelInfo,ChangeSet changes) {
+		return addScreenLabelBatch(batch.getCount(),batch.locs,batch.importance,batch.texts,
+				labelInfo.layoutImportance,labelInfo.layoutPlacement,labelInfo,changes);
+	}
+	private native long addScreenLabelBatch(int count,ByteBuffer locs,ByteBuffer importance,String[] texts,
+											float infoImportance,int infoPlacement,LabelInfo labelInfo,ChangeSet changes);
+
 	// Remove labels by ID
 	public native void removeLabels(long ids[],ChangeSet changes);
 	
@@ -581,13 +581,47 @@ public class LayerThread extends HandlerThread implements View.ViewWatcher
 	 */
 	public Handler addDelayedTask(Runnable run,long time,boolean unitOfWork) {
 		if (valid && run != null) {
-			Handler handler = new Handler(getLooper());
+			final Handler handler = getHandler();
 			handler.postDelayed(unitOfWork ? () -> runWorkRunnable(run, true) : run, time);
 			return handler;
 		}
 		return null;
 	}
 
+	/**
+	 * Run work that doesn't need OpenGL or our ordering on the shared native worker
+	 * threads (see QuadLoaderBase.setSharedTaskThreads), most important first.
+	 * It's still a unit of work, so shutting down waits for it.
+	 * If the shared threads aren't running, it goes on our queue like any other task.
+	 *
+	 * @param run Runnable to run
+	 * @param priority Higher runs sooner
+	 */
+	public void addWorkerTask(Runnable run,double priority) {
+		if (!valid || run == null) {
+			return;
+		}
+		if (!scheduleWorkerTaskNative(priority, () -> runWorkRunnable(run, true))) {
+			addTask(run, true);
+		}
+	}
+
+	private static native boolean scheduleWorkerTaskNative(double priority,Runnable run);
+
+	// One handler for everything we post, rather than one per task
+	private Handler handler = null;
+
+	private Handler getHandler() {
+		// This waits for the thread to start, so don't do it holding the lock
+		final Looper looper = getLooper();
+		synchronized (this) {
+			if (handler == null) {
+				handler = new Handler(looper);
+			}
+			return handler;
+		}
+	}
+
 	/**
 	 * Add a Runnable to this thread's queue.  It will be executed at some point in the future.
 	 * 
@@ -618,7 +652,7 @@ public class LayerThread extends HandlerThread implements View.ViewWatcher
 			if (!wait && Looper.myLooper() == getLooper()) {
 				runWorkRunnable(run, false);
 			} else {
-				Handler handler = new Handler(getLooper());
+				final Handler handler = getHandler();
 				handler.post(unitOfWork ? () -> runWorkRunnable(run, true) : run);
 				return handler;
 			}
@@ -655,6 +689,9 @@ public class LayerThread extends HandlerThread implements View.ViewWatcher
 		public ViewWatcherInterface watcher;
 		public float minTime;
 		public float maxLagTime;
+		// When it last got an update and how long it's been taking with them, smoothed
+		long lastUpdated = 0;
+		double latency = 0.0;
 		
 		public ViewWatcher(ViewWatcherInterface inWatcher)
 		{
@@ -706,6 +743,8 @@ public class LayerThread extends HandlerThread implements View.ViewWatcher
 	}
 	
 	ViewState currentViewState = null;
+	// The most recent view, which may not have made it to the watchers yet
+	ViewState pendingViewState = null;
 	boolean viewUpdateScheduled = false;
 	long viewUpdateLastCalled = 0;
 	
@@ -717,6 +756,7 @@ public class LayerThread extends HandlerThread implements View.ViewWatcher
 			if (now > viewUpdateLastCalled) {
 				viewUpdateLastCalled = now;
 			}
+			pendingViewState = viewState;
 			if (!viewUpdateScheduled) {
 				viewUpdateScheduled = true;
 				addTask(() -> {
@@ -725,10 +765,34 @@ public class LayerThread extends HandlerThread implements View.ViewWatcher
 					}
 					synchronized(theLayerThread) {
 						viewUpdateScheduled = false;
-						currentViewState = viewState;
 					}
+					long nextUpdate = Long.MAX_VALUE;
 					for (ViewWatcher watcher : watchers) {
-						watcher.watcher.viewUpdated(currentViewState);
+						// A watcher that takes longer than its minimum to handle an update
+						// gets them as often as it can keep up with, rather than one per view
+						final long start = System.currentTimeMillis();
+						final long minTime = (long)(1000.0 * Math.max(watcher.minTime, watcher.latency));
+						final long sinceLast = start - watcher.lastUpdated;
+						if (sinceLast < minTime) {
+							nextUpdate = Math.min(nextUpdate, minTime - sinceLast);
+							continue;
+						}
+
+						// The view may have moved on while the watchers before this one ran
+						final ViewState latest;
+						synchronized(theLayerThread) {
+							currentViewState = pendingViewState;
+							latest = currentViewState;
+						}
+						watcher.watcher.viewUpdated(latest);
+
+						watcher.lastUpdated = System.currentTimeMillis();
+						final double took = (watcher.lastUpdated - start) / 1000.0;
+						watcher.latency = (watcher.latency == 0.0) ? took : 0.75 * watcher.latency + 0.25 * took;
+					}
+					// Catch up the ones we skipped, once they're ready for it
+					if (nextUpdate != Long.MAX_VALUE) {
+						scheduleLateUpdate(nextUpdate);
 					}
 				},true);
 			}
@@ -94,6 +94,41 @@ class LayoutManager
 	public native void setFadeEnabled(boolean enable);
 	public native boolean getFadeEnabled();
 
+	/**
+	 * Keep label placements from one layout pass to the next where nothing changed around them.
+	 * Only the affected drawables are rebuilt.
+	 */
+	public native void setIncremental(boolean enable);
+	public native boolean getIncremental();
+
+	/**
+	 * Lay out labels on this many extra threads, a screen tile at a time.
+	 * Worth it for thousands of labels.  0, the default, turns it off.
+	 */
+	public native void setLayoutThreads(int numThreads);
+	public native int getLayoutThreads();
+
+	/**
+	 * Show and hide labels by updating the drawables they're already in.
+	 * Doesn't apply with fades, clustering or incremental layout.
+	 */
+	public native void setToggleInPlace(boolean enable);
+	public native boolean getToggleInPlace();
+
+	/**
+	 * Draw plain rectangular markers and labels as instances of one shared quad.
+	 * With toggle in place, instanced objects can also be moved without a rebuild.
+	 */
+	public native void setInstancing(boolean enable);
+	public native boolean getInstancing();
+
+	/**
+	 * Cluster from a hierarchy worked out when markers are added instead of
+	 * from scratch on every layout.  Clusters are formed in map space, by zoom level.
+	 */
+	public native void setClusterHierarchy(boolean enable);
+	public native boolean getClusterHierarchy();
+
 	static
 	{
 		nativeInit();
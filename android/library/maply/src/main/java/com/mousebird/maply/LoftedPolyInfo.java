@@ -59,6 +59,18 @@ public class LoftedPolyInfo extends BaseInfo {
      */
     public native void setOutlineBottom(boolean outlineBottom);
 
+    /**
+     * If set, the walls and roof are stored on the ground with their height as an attribute
+     * and the shader raises them.  Only applies with the default triangle shader.
+     */
+    public native void setShaderExtrude(boolean shaderExtrude);
+
+    /**
+     * If set, touching footprints are merged first so they share a roof and lose the walls between them.
+     * Merged roofs aren't clipped to the grid, so this is meant for building sized features.
+     */
+    public native void setMergeRoofs(boolean mergeRoofs);
+
     /**
      * Draw priority of the lines created for the lofted poly outline.
      */
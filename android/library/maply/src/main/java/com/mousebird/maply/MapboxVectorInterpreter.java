@@ -27,13 +27,12 @@ import androidx.annotation.NonNull;
 import org.jetbrains.annotations.NotNull;
 
 import java.io.ByteArrayInputStream;
-import java.io.ByteArrayOutputStream;
 import java.io.FilterInputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.lang.ref.WeakReference;
 import java.util.ArrayList;
-import java.util.Collections;
+import java.util.Arrays;
 import java.util.zip.GZIPInputStream;
 import java.util.zip.InflaterInputStream;
 
@@ -124,40 +123,40 @@ public class MapboxVectorInterpreter implements LoaderInterpreter
         FilterInputStream make(InputStream rawStream, int length) throws IOException;
     }
 
+    // Deflate doesn't do better than about 1032:1, so a bigger size from the trailer is bogus
+    private static final int MAX_INFLATE_RATIO = 1032;
+
     /**
      * Try decoding the data using the specified filter stream, return it as-is if anything goes wrong
+     * <br>
+     * The output is read straight into an array sized as best we can, so there's usually just the one allocation.
      */
-    private byte[] decodeStream(byte[] data, LoaderReturn loadReturn, StreamMaker maker) {
-        FilterInputStream in = null;
-        ByteArrayOutputStream bout = null;
-        ByteArrayInputStream bin = null;
-        try {
-            // Unzip if it's compressed
-            bin = new ByteArrayInputStream(data);
-            in = maker.make(bin, data.length);
-            // Bail as soon as possible if there's a problem
-            if (in.available() != 0) {
-                bout = new ByteArrayOutputStream(data.length * 2);
-
-                byte[] buffer = new byte[1024];
-                for (int count; (count = in.read(buffer)) != 0; ) {
-                    if (loadReturn.isCanceled()) {
-                        return null;
-                    }
-                    if (count < 1) {
+    private byte[] decodeStream(byte[] data, LoaderReturn loadReturn, StreamMaker maker, int expectedSize) {
+        try (FilterInputStream in = maker.make(new ByteArrayInputStream(data), data.length)) {
+            byte[] out = new byte[Math.max(expectedSize, 1024)];
+            int total = 0;
+            while (true) {
+                if (loadReturn.isCanceled()) {
+                    return null;
+                }
+                if (total == out.length) {
+                    // Size was off, or it's a zlib stream with no size recorded.  See if there's more.
+                    int next = in.read();
+                    if (next < 0) {
                         break;
                     }
-                    bout.write(buffer, 0, count);
+                    out = Arrays.copyOf(out, out.length * 2);
+                    out[total++] = (byte)next;
+                }
+                int count = in.read(out, total, out.length - total);
+                if (count < 0) {
+                    break;
                 }
-                return bout.toByteArray();
+                total += count;
             }
+            return (total == out.length) ? out : Arrays.copyOf(out, total);
         } catch (Exception ignored) {
             // No good, try something else
-        }  finally  {
-            // Clean everything up in the opposite order they were created.
-            if (bout != null) try { bout.close (); } catch (IOException ignore){}
-            if (in != null) try { in.close (); } catch (IOException ignore){}
-            if (bin != null) try { bin.close (); } catch (IOException ignore){}
         }
         return data;
     }
@@ -168,9 +167,19 @@ public class MapboxVectorInterpreter implements LoaderInterpreter
     private byte[] decodeStream(byte[] data, LoaderReturn loadReturn) {
         if (data.length > 2) {
             if (data[0] == (byte)0x1F && data[1] == (byte)0x8B) {
-                return decodeStream(data, loadReturn, GZIPInputStream::new);
+                // Gzip keeps the uncompressed size, mod 2^32, in the last four bytes
+                int expected = data.length * 4;
+                if (data.length >= 18) {
+                    final int n = data.length;
+                    long isize = (data[n-4] & 0xFFL) | ((data[n-3] & 0xFFL) << 8) |
+                                 ((data[n-2] & 0xFFL) << 16) | ((data[n-1] & 0xFFL) << 24);
+                    if (isize > 0 && isize <= (long)data.length * MAX_INFLATE_RATIO && isize < Integer.MAX_VALUE) {
+                        expected = (int)isize;
+                    }
+                }
+                return decodeStream(data, loadReturn, GZIPInputStream::new, expected);
             } else if (data[0] == (byte)0x78) {
-                return decodeStream(data, loadReturn, (b,len) -> new InflaterInputStream(b));
+                return decodeStream(data, loadReturn, (b,len) -> new InflaterInputStream(b), data.length * 4);
             }
         }
         return data;
@@ -224,12 +233,7 @@ public class MapboxVectorInterpreter implements LoaderInterpreter
         ArrayList<byte[]> pbfData = new ArrayList<>();
         for (byte[] data : loadReturn.getTileData())
         {
-            // If it's compressed, decompress it
-            data = decodeStream(data, loadReturn);
             if (data == null || data.length < 1) {
-                if (loadReturn.isCanceled()) {
-                    return;
-                }
                 loadReturn.errorString = "Decode Failed";
                 continue;
             }
@@ -243,6 +247,7 @@ public class MapboxVectorInterpreter implements LoaderInterpreter
                 }
             }
 
+            // The parser inflates gzip or zlib data itself, so hand it over as-is
             if (parser.parseData(data, tileData, loadReturn)) {
                 pbfData.add(data);
                 continue;
@@ -253,7 +258,15 @@ public class MapboxVectorInterpreter implements LoaderInterpreter
                 break;
             }
 
-            // Maybe it's an image after all?
+            // Maybe it's a compressed image?
+            data = decodeStream(data, loadReturn);
+            if (data == null || data.length < 1) {
+                if (loadReturn.isCanceled()) {
+                    return;
+                }
+                loadReturn.errorString = "Decode Failed";
+                continue;
+            }
             Bitmap image = BitmapFactory.decodeByteArray(data, 0, data.length);
             if (image != null) {
                 // Yes, we probably need a new heuristic in `maybeImage`
@@ -264,19 +277,12 @@ public class MapboxVectorInterpreter implements LoaderInterpreter
             }
         }
 
-        ArrayList<ComponentObject> ovlObjs = new ArrayList<>();
-        ComponentObject[] thisOvjObjs = tileData.getComponentObjects("overlay");
-        if (thisOvjObjs != null) {
-            Collections.addAll(ovlObjs, thisOvjObjs);
-        }
-
         // Capture changes immediately so they are cleaned up
         loadReturn.mergeChanges(tileData.getChangeSet());
 
         if (loadReturn.isCanceled()) {
             // We'll lose the component objects if we don't put them in here
-            loadReturn.addComponentObjects(tileData.getComponentObjects());
-            loadReturn.addOverlayComponentObjects(ovlObjs.toArray(new ComponentObject[0]));
+            tileData.addComponentObjectsTo(loadReturn);
             return;
         }
 
@@ -354,33 +360,8 @@ public class MapboxVectorInterpreter implements LoaderInterpreter
                 return;
             }
 
-            // Sort out overlays if they're there
-            ComponentObject[] regObjs = tileData.getComponentObjects();
-            if (!ovlObjs.isEmpty()) {
-                // Filter the overlays out of regular objects
-                ArrayList<ComponentObject> minusOvls = new ArrayList<>();
-                for (ComponentObject compObj : regObjs) {
-                    // Look for it in the overlays
-                    boolean found = false;
-                    for (ComponentObject ovlObj : ovlObjs) {
-                        if (ovlObj.getID() == compObj.getID()) {
-                            found = true;
-                            break;
-                        }
-                    }
-
-                    if (!found)
-                        minusOvls.add(compObj);
-                }
-
-                regObjs = minusOvls.toArray(new ComponentObject[1]);
-            }
-
-            // Merge the results into the loadReturn
-            if (!ovlObjs.isEmpty()) {
-                loadReturn.addOverlayComponentObjects(ovlObjs.toArray(new ComponentObject[1]));
-            }
-            loadReturn.addComponentObjects(regObjs);
+            // Merge the results into the loadReturn, overlays separated out
+            tileData.addComponentObjectsTo(loadReturn);
 
             if (loadReturn.isCanceled()) {
                 return;
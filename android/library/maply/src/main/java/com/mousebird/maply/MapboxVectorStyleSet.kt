@@ -171,15 +171,14 @@ class MapboxVectorStyleSet : VectorStyleInterface {
         return labelInfoMap.putIfAbsent(SizedTypeface(fontName, fontSize), labelInfo) ?: labelInfo
     }
 
-    // Calculate text width based on the typeface
+    // Advance widths of individual characters in the typeface.
+    // The native side keeps these, so we're only asked about characters it hasn't seen.
     @Suppress("unused") // called from JNI
-    fun calculateTextWidth(text: String, labelInfo: LabelInfo): Double {
+    fun glyphWidths(codePoints: IntArray, labelInfo: LabelInfo): FloatArray {
         val paint = Paint()
         paint.textSize = labelInfo.fontSize
         paint.typeface = labelInfo.typeface
-        val bounds = Rect()
-        paint.getTextBounds(text, 0, text.length, bounds)
-        return (bounds.right - bounds.left).toDouble()
+        return FloatArray(codePoints.size) { paint.measureText(String(Character.toChars(codePoints[it]))) }
     }
 
     @Suppress("unused") // called from JNI
@@ -464,6 +463,15 @@ class MapboxVectorStyleSet : VectorStyleInterface {
     // Set a named layer visible or invisible
     external fun setLayerVisible(layerName: String, visible: Boolean)
 
+    /**
+     * Replace the paint values for a layer and apply them to what's already displayed.
+     *
+     * Fill and line colors, opacity and line widths can change this way, as long as
+     * they don't vary by zoom level.  Returns false if the layer can't take the new
+     * values without rebuilding.  Nothing changes then, so reload with an updated style.
+     */
+    external fun updateLayerPaint(layerName: String, paint: AttrDictionary): Boolean
+
     data class RepLayer(
         val name: String,
         val size: Float?,
@@ -25,6 +25,7 @@ import androidx.annotation.Nullable;
 import org.jetbrains.annotations.NotNull;
 
 import java.lang.ref.WeakReference;
+import java.nio.ByteBuffer;
 import java.util.concurrent.atomic.AtomicBoolean;
 
 /**
@@ -87,6 +88,24 @@ public class MapboxVectorTileParser
                                     @NotNull VectorTileData tileData,
                                     @Nullable LoaderReturn loadReturn);
 
+    /**
+     * Parse the data from a single tile, read in place from a direct buffer.
+     * Everything from the buffer's position to its limit is parsed.
+     *
+     * @param data The input data to parse, in a direct buffer.
+     * @param tileData A container for the data we parse and the styles create.
+     * @return Returns false on failure to parse or if the buffer isn't direct.
+     */
+    public boolean parseData(@NotNull ByteBuffer data,
+                             @NotNull VectorTileData tileData,
+                             @Nullable LoaderReturn loadReturn) {
+        return data.isDirect() &&
+                parseDataDirect(data,data.position(),data.remaining(),tileData,loadReturn);
+    }
+
+    private native boolean parseDataDirect(ByteBuffer data,int offset,int len,
+                                           VectorTileData tileData,LoaderReturn loadReturn);
+
     /// If set, we'll parse into local coordinates as specified by the bounding box, rather than geo coords
     native void setLocalCoords(boolean localCoords);
 
@@ -136,6 +136,13 @@ public class MarkerInfo extends BaseInfo
 	public native void setClusterGroup(int clusterGroup);
 	public native int getClusterGroup();
 
+	/**
+	 * Draw plain screen markers as instances of one shared quad, rather than four vertices apiece.
+	 * Markers that go through layout are instanced if the layout manager is set up for it.
+	 */
+	public native void setInstanced(boolean instanced);
+	public native boolean getInstanced();
+
 	/**
 	 * Set the zoom slot to use for expression-based properties.
 	 *
@@ -20,6 +20,7 @@
 
 package com.mousebird.maply;
 
+import java.nio.ByteBuffer;
 import java.util.List;
 
 /**
@@ -49,6 +50,14 @@ class MarkerManager
 	// Add markers to the scene and return an ID to track them
 	public native long addMarkers(InternalMarker[] markers,MarkerInfo markerInfo,ChangeSet changes);
 
+	// Add packed screen markers in one go.  See ScreenMarkerBatch for the layout.
+	public long addScreenMarkers(ScreenMarkerBatch batch,MarkerInfo markerInfo,ChangeSet changes) {
+		return addScreenMarkerBatch(batch.getCount(),batch.locs,batch.sizes,batch.texIDs,batch.colors,batch.importance,
+				markerInfo,changes);
+	}
+	private native long addScreenMarkerBatch(int count,ByteBuffer locs,ByteBuffer sizes,ByteBuffer texIDs,
+											 ByteBuffer colors,ByteBuffer importance,MarkerInfo markerInfo,ChangeSet changes);
+
 	// Remove markers by ID
 	public native void removeMarkers(long ids[],ChangeSet changes);
 	
@@ -0,0 +1,197 @@
+/*
+ *  MultiResTileInfo.java
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+package com.mousebird.maply;
+
+import android.os.Handler;
+import android.os.Looper;
+
+import java.lang.ref.WeakReference;
+import java.util.ArrayList;
+
+/**
+ * Picks between versions of the same tile source depending on how fast the network is.
+ * <br>
+ * Add the variants best first, say @2x tiles, then @1x tiles, then @1x tiles with a lower
+ * max zoom, each with the throughput it needs.  New tiles come from the best variant the
+ * fetcher's throughput will support, or the last one until that's been measured.
+ * Tiles past a variant's max zoom are skipped while it's in use, leaving their parents in place.
+ * <br>
+ * When the throughput stays up long enough for a better variant, we switch to it and, if
+ * there's a loader, ask it to reload.  Going down happens right away, for new tiles only.
+ * <br>
+ * Give each variant its own cache directory, since cache files are named by tile.
+ */
+public class MultiResTileInfo extends TileInfoNew
+{
+	// How often we look for a chance to upgrade, when there's something to upgrade
+	private static final long UpgradeCheckPeriod = 2000;
+
+	private final WeakReference<RemoteTileFetcher> fetcher;
+	private final ArrayList<RemoteTileInfoNew> variants = new ArrayList<>();
+	private final ArrayList<Double> minThroughputs = new ArrayList<>();
+	private WeakReference<QuadLoaderBase> loader = new WeakReference<>(null);
+	private int currentVariant = 0;
+	// Lowest quality variant tiles have come from since the last switch
+	private int worstServed = 0;
+	// When the throughput first allowed something better than the current variant
+	private long upgradeStart = 0;
+	private boolean checkPending = false;
+
+	/**
+	 * How long, in seconds, the throughput has to stay up before we switch to a better variant.
+	 */
+	public double upgradeDelay = 10.0;
+
+	/**
+	 * Construct with the fetcher the loader uses, which measures the throughput.
+	 */
+	public MultiResTileInfo(RemoteTileFetcher inFetcher)
+	{
+		fetcher = new WeakReference<>(inFetcher);
+	}
+
+	/**
+	 * Add a version of the tiles, along with the throughput (in bytes per second) needed to use it.
+	 * The last one is used when nothing else fits, so its value doesn't matter.
+	 */
+	public synchronized void addVariant(RemoteTileInfoNew tileInfo,double minThroughput)
+	{
+		if (variants.isEmpty()) {
+			minZoom = tileInfo.minZoom;
+			maxZoom = tileInfo.maxZoom;
+		} else {
+			minZoom = Math.min(minZoom,tileInfo.minZoom);
+			maxZoom = Math.max(maxZoom,tileInfo.maxZoom);
+		}
+		variants.add(tileInfo);
+		minThroughputs.add(minThroughput);
+
+		// Start cheap until we know better
+		currentVariant = variants.size()-1;
+		worstServed = currentVariant;
+	}
+
+	/**
+	 * Which of the variants new tiles are coming from.
+	 */
+	public synchronized int getCurrentVariant()
+	{
+		return currentVariant;
+	}
+
+	/**
+	 * Set this to the loader using us, so it can be told to reload with better tiles.
+	 */
+	public synchronized void setLoader(QuadLoaderBase inLoader)
+	{
+		loader = new WeakReference<>(inLoader);
+	}
+
+	// Switch variants if the throughput says to.  Returns true if the tiles we have should be replaced.
+	private boolean updateVariant()
+	{
+		RemoteTileFetcher theFetcher = fetcher.get();
+		double throughput = theFetcher != null ? theFetcher.getThroughput() : 0.0;
+		// Nothing measured lately, so stick with what we've got
+		if (throughput <= 0.0 || variants.isEmpty())
+			return false;
+
+		int bestFit = variants.size()-1;
+		for (int which = 0;which < bestFit;which++)
+			if (throughput >= minThroughputs.get(which)) {
+				bestFit = which;
+				break;
+			}
+
+		if (bestFit >= currentVariant) {
+			currentVariant = bestFit;
+			upgradeStart = 0;
+			return false;
+		}
+
+		// Better is possible, but make sure it's not just a blip
+		long now = System.currentTimeMillis();
+		if (upgradeStart == 0)
+			upgradeStart = now;
+		if (now - upgradeStart < upgradeDelay * 1000.0)
+			return false;
+
+		currentVariant = bestFit;
+		upgradeStart = 0;
+		boolean replace = worstServed > currentVariant;
+		worstServed = currentVariant;
+		return replace;
+	}
+
+	// Keep checking in the background while there are tiles that could be better
+	private void scheduleCheck()
+	{
+		if (checkPending || worstServed == 0 || loader.get() == null)
+			return;
+		checkPending = true;
+
+		final WeakReference<MultiResTileInfo> weakThis = new WeakReference<>(this);
+		new Handler(Looper.getMainLooper()).postDelayed(() -> {
+			MultiResTileInfo self = weakThis.get();
+			if (self != null)
+				self.checkUpgrade();
+		}, UpgradeCheckPeriod);
+	}
+
+	private void checkUpgrade()
+	{
+		boolean replace;
+		QuadLoaderBase theLoader;
+		synchronized (this) {
+			checkPending = false;
+			replace = updateVariant();
+			scheduleCheck();
+			theLoader = loader.get();
+		}
+
+		if (replace && theLoader != null)
+			theLoader.reload();
+	}
+
+	@Override public Object fetchInfoForTile(TileID tileID,boolean flipY)
+	{
+		RemoteTileInfoNew variant;
+		boolean replace;
+		QuadLoaderBase theLoader;
+		synchronized (this) {
+			if (variants.isEmpty())
+				return null;
+			replace = updateVariant();
+			variant = variants.get(currentVariant);
+			worstServed = Math.max(worstServed,currentVariant);
+			scheduleCheck();
+			theLoader = loader.get();
+		}
+
+		if (replace && theLoader != null)
+			theLoader.reload();
+
+		// This one doesn't go that deep, so the parent will have to do
+		if (tileID.level < variant.minZoom || tileID.level > variant.maxZoom)
+			return null;
+
+		return variant.fetchInfoForTile(tileID,flipY);
+	}
+}
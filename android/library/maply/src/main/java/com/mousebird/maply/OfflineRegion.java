@@ -0,0 +1,313 @@
+/*
+ *  OfflineRegion.java
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+package com.mousebird.maply;
+
+import android.os.Handler;
+import android.os.Looper;
+
+import java.util.ArrayList;
+import java.util.HashSet;
+
+/**
+ * Downloads all the tiles for an area ahead of time, so it can be used without a network.
+ * <br>
+ * Give it the tile info loaders use and the fetcher they use.  Every tile in the bounding box
+ * between the zoom levels goes through the fetcher into the tile info's cache directory.
+ * After that, loaders find the tiles there rather than fetching them.
+ * <br>
+ * Turn on packedCache for the fetcher, so a big region is a few pack files rather than a file
+ * per tile.  Leave cacheSizeLimit and cacheLifetime off for that directory, or the region will
+ * be dropped along with older tiles.
+ * <br>
+ * Tiles already in the cache are skipped, so starting a stopped or interrupted download again
+ * picks up where it left off.
+ */
+public class OfflineRegion
+{
+	/**
+	 * Called on the main thread as tiles come in and once more when the download is done.
+	 */
+	public interface ProgressCallback {
+		void progress(OfflineRegion region);
+	}
+
+	// Tiles we'll look through for one pass, if they're all cached, before letting the fetcher have the lock
+	private static final int MaxChecksPerPass = 1000;
+
+	// Tiles covering the region on one level
+	private static class LevelRange {
+		int level,minX,minY,maxX,maxY;
+	}
+
+	private final RemoteTileInfoNew tileInfo;
+	private final RemoteTileFetcher fetcher;
+	private final ArrayList<LevelRange> levels = new ArrayList<>();
+	private final HashSet<TileFetchRequest> active = new HashSet<>();
+	private final Handler mainHandler = new Handler(Looper.getMainLooper());
+	private long numTiles = 0;
+	// Next tile to look at
+	private int whichLevel = 0, nextX = 0, nextY = 0;
+	// Bumped on each start and stop, so answers from before are ignored
+	private int generation = 0;
+	private long lastProgress = 0;
+	private boolean running = false;
+	private long tilesFetched = 0, tilesSkipped = 0, tilesFailed = 0, bytesFetched = 0;
+
+	/**
+	 * Most tiles to have in the fetcher at once.
+	 */
+	public int maxConcurrent = 8;
+
+	/**
+	 * Priority for the fetches.  Less is more important.  The default puts them behind what the loaders want.
+	 */
+	public int priority = 100;
+
+	/**
+	 * Match this to the loaders.
+	 */
+	public boolean flipY = true;
+
+	/**
+	 * Called on the main thread, at most every progressInterval seconds, and when the download finishes.
+	 */
+	public ProgressCallback progress = null;
+
+	/**
+	 * How often progress is called, in seconds.
+	 */
+	public double progressInterval = 0.5;
+
+	/**
+	 * Set up for a download.
+	 *
+	 * @param inTileInfo Where the tiles come from.  It needs a cache directory.
+	 * @param inFetcher Fetcher to download with.
+	 * @param bbox Area to download, in geographic radians.
+	 * @param minZoom Top level to download.
+	 * @param maxZoom Bottom level to download.
+	 */
+	public OfflineRegion(RemoteTileInfoNew inTileInfo,RemoteTileFetcher inFetcher,Mbr bbox,int minZoom,int maxZoom)
+	{
+		tileInfo = inTileInfo;
+		fetcher = inFetcher;
+
+		// Work out the tiles in the tile set's own coordinates
+		CoordSystem coordSys = tileInfo.coordSys != null ? tileInfo.coordSys : new SphericalMercatorCoordSystem();
+		Mbr mbr = coordSys.getBounds();
+		Mbr region = new Mbr();
+		for (Point2d corner : bbox.asPoints()) {
+			Point3d local = coordSys.geographicToLocal(new Point3d(corner.getX(),corner.getY(),0.0));
+			region.addPoint(new Point2d(local.getX(),local.getY()));
+		}
+		if (mbr == null || !region.isValid())
+			return;
+
+		// Tile sizes the same way the quad tree does them
+		double spanX = mbr.ur.getX() - mbr.ll.getX(), spanY = mbr.ur.getY() - mbr.ll.getY();
+		for (int level = Math.max(Math.max(minZoom, tileInfo.minZoom), 0);level <= Math.min(maxZoom, tileInfo.maxZoom);level++) {
+			int numChunks = 1 << level;
+			double chunkX = spanX / numChunks, chunkY = spanY / numChunks;
+
+			LevelRange range = new LevelRange();
+			range.level = level;
+			range.minX = Math.max((int)Math.floor((region.ll.getX() - mbr.ll.getX()) / chunkX),0);
+			range.minY = Math.max((int)Math.floor((region.ll.getY() - mbr.ll.getY()) / chunkY),0);
+			range.maxX = Math.min((int)Math.floor((region.ur.getX() - mbr.ll.getX()) / chunkX),numChunks-1);
+			range.maxY = Math.min((int)Math.floor((region.ur.getY() - mbr.ll.getY()) / chunkY),numChunks-1);
+			if (range.minX > range.maxX || range.minY > range.maxY)
+				continue;
+
+			numTiles += (long)(range.maxX - range.minX + 1) * (range.maxY - range.minY + 1);
+			levels.add(range);
+		}
+	}
+
+	/** Tiles in the region, from all the levels. */
+	public long getNumTiles() { return numTiles; }
+
+	/** Tiles we downloaded. */
+	public synchronized long getTilesFetched() { return tilesFetched; }
+
+	/** Tiles that were already cached, or outside the tile info's valid bounds. */
+	public synchronized long getTilesSkipped() { return tilesSkipped; }
+
+	/** Tiles that failed to download. */
+	public synchronized long getTilesFailed() { return tilesFailed; }
+
+	/** Bytes downloaded. */
+	public synchronized long getBytesFetched() { return bytesFetched; }
+
+	/** True while the download is going. */
+	public synchronized boolean isRunning() { return running; }
+
+	/**
+	 * Start downloading, or start again after a stop.  The counts start over.
+	 */
+	public void start()
+	{
+		synchronized (this) {
+			if (running)
+				return;
+			running = true;
+			generation++;
+			whichLevel = 0;
+			if (!levels.isEmpty()) {
+				nextX = levels.get(0).minX;
+				nextY = levels.get(0).minY;
+			}
+			tilesFetched = tilesSkipped = tilesFailed = bytesFetched = 0;
+			lastProgress = 0;
+		}
+		fill();
+	}
+
+	/**
+	 * Stop downloading.  Tiles on their way in are cancelled.
+	 */
+	public void stop()
+	{
+		TileFetchRequest[] toCancel;
+		synchronized (this) {
+			if (!running)
+				return;
+			running = false;
+			generation++;
+			toCancel = active.toArray(new TileFetchRequest[0]);
+			active.clear();
+		}
+		if (toCancel.length > 0)
+			fetcher.cancelTileFetches(toCancel);
+		reportProgress(true);
+	}
+
+	// Take the next tile in the region, level by level, then row by row
+	private TileID nextTileID()
+	{
+		if (whichLevel >= levels.size())
+			return null;
+		LevelRange range = levels.get(whichLevel);
+		TileID tileID = new TileID(nextX,nextY,range.level);
+
+		if (++nextX > range.maxX) {
+			nextX = range.minX;
+			if (++nextY > range.maxY) {
+				if (++whichLevel < levels.size()) {
+					nextX = levels.get(whichLevel).minX;
+					nextY = levels.get(whichLevel).minY;
+				}
+			}
+		}
+		return tileID;
+	}
+
+	// Start fetches until we've got as many going as we're allowed
+	private void fill()
+	{
+		ArrayList<TileFetchRequest> toStart = new ArrayList<>();
+		boolean done = false;
+		boolean more = false;
+		synchronized (this) {
+			if (!running)
+				return;
+
+			int checks = 0;
+			while (active.size() + toStart.size() < maxConcurrent) {
+				// Lots of cached tiles in a row.  Come back for the rest.
+				if (checks++ >= MaxChecksPerPass) {
+					more = true;
+					break;
+				}
+
+				TileID tileID = nextTileID();
+				if (tileID == null)
+					break;
+
+				Object fetchInfo = tileInfo.fetchInfoForTile(tileID,flipY);
+				if (!(fetchInfo instanceof RemoteTileFetchInfo) || fetcher.isCached((RemoteTileFetchInfo)fetchInfo)) {
+					tilesSkipped++;
+					continue;
+				}
+
+				TileFetchRequest request = new TileFetchRequest();
+				request.fetchInfo = fetchInfo;
+				request.tileSource = tileInfo.uniqueID;
+				request.priority = priority;
+				request.importance = 0.f;
+				final int thisGeneration = generation;
+				request.callback = new TileFetchRequest.Callback() {
+					@Override
+					public void success(TileFetchRequest fetchRequest, byte[] data) {
+						finished(fetchRequest,thisGeneration,data != null ? data.length : 0,false);
+					}
+
+					@Override
+					public void failure(TileFetchRequest fetchRequest, String errorStr) {
+						finished(fetchRequest,thisGeneration,0,true);
+					}
+				};
+				toStart.add(request);
+			}
+
+			active.addAll(toStart);
+			if (!more && active.isEmpty() && whichLevel >= levels.size()) {
+				running = false;
+				done = true;
+			}
+		}
+
+		if (!toStart.isEmpty())
+			fetcher.startTileFetches(toStart.toArray(new TileFetchRequest[0]));
+		if (more)
+			mainHandler.post(this::fill);
+
+		reportProgress(done);
+	}
+
+	// Called from the fetcher
+	private void finished(TileFetchRequest request,int whichGeneration,int length,boolean failed)
+	{
+		synchronized (this) {
+			if (whichGeneration != generation || !active.remove(request))
+				return;
+			if (failed) {
+				tilesFailed++;
+			} else {
+				tilesFetched++;
+				bytesFetched += length;
+			}
+		}
+		fill();
+	}
+
+	private void reportProgress(boolean force)
+	{
+		final ProgressCallback theProgress;
+		synchronized (this) {
+			long now = System.currentTimeMillis();
+			if (progress == null || (!force && now - lastProgress < progressInterval * 1000.0))
+				return;
+			lastProgress = now;
+			theProgress = progress;
+		}
+
+		mainHandler.post(() -> theProgress.progress(this));
+	}
+}
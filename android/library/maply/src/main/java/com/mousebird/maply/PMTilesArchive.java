@@ -0,0 +1,111 @@
+/*
+ *  PMTilesArchive.java
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+package com.mousebird.maply;
+
+/**
+ * Finds tiles in a PMTiles archive.
+ * <br>
+ * This does the parsing and keeps the directories we've read.  Getting the bytes
+ * is up to the fetcher, which asks where a tile is, reads whatever directory we
+ * say we need first, and hands it back with addDirectory.
+ */
+public class PMTilesArchive
+{
+    /**
+     * The header and root directory are always within this many bytes of the start.
+     */
+    public static final int StartSize = 16384;
+
+    /**
+     * Results from lookup.
+     */
+    public static final int TileFound = 0;
+    public static final int TileMissing = 1;
+    public static final int NeedDirectory = 2;
+
+    public PMTilesArchive() {
+        initialise();
+    }
+
+    /**
+     * Parse the header and root directory from the start of the archive.
+     */
+    public native boolean parseStart(byte[] data);
+
+    /**
+     * True once we've got a good header and root directory.
+     */
+    public native boolean isValid();
+
+    public native int getMinZoom();
+
+    public native int getMaxZoom();
+
+    /**
+     * Tile type from the header.  1 is MVT, 2 PNG, 3 JPEG, 4 WebP and 5 AVIF.
+     */
+    public native int getTileType();
+
+    /**
+     * Min lon, min lat, max lon, max lat in degrees.
+     */
+    public native double[] getBounds();
+
+    /**
+     * Tile ID within the archive, with y counting down from the top.
+     */
+    public static native long tileIDForTile(int x,int y,int level);
+
+    /**
+     * Look for a tile.  The offset and length go in range.  If we need a directory first,
+     * that's where it is.  Read it, hand it to addDirectory, and ask again.
+     */
+    public native int lookup(long tileID,long[] range);
+
+    /**
+     * Keep a directory we asked for.
+     */
+    public native boolean addDirectory(long offset,long length,byte[] data);
+
+    /**
+     * Undo the archive's tile compression, if any.
+     */
+    public native byte[] decompressTile(byte[] data);
+
+    /**
+     * Group tile ranges into reads.  Returns which read each range is in, with the
+     * reads numbered in the order they appear in the archive.
+     */
+    public static native int[] groupReads(long[] offsets,long[] lengths,long maxGap,long maxLength);
+
+    public void finalize()
+    {
+        dispose();
+    }
+
+    static
+    {
+        nativeInit();
+    }
+    private static native void nativeInit();
+    native void initialise();
+    native void dispose();
+    protected long nativeHandle;
+}
@@ -0,0 +1,507 @@
+/*  PMTilesFetcher.java
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package com.mousebird.maply;
+
+import android.os.Handler;
+import android.os.HandlerThread;
+import android.os.Looper;
+import android.util.Log;
+
+import org.jetbrains.annotations.NotNull;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.lang.ref.WeakReference;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.TreeSet;
+
+import okhttp3.Call;
+import okhttp3.Callback;
+import okhttp3.OkHttpClient;
+import okhttp3.Request;
+import okhttp3.Response;
+import okhttp3.ResponseBody;
+
+/**
+ * PMTiles tile fetcher.
+ * <br>
+ * Reads tiles out of a single PMTiles archive, either a local file or one sitting
+ * on a server that handles range requests.  Tiles that sit next to each other in
+ * the archive are read together, so a screen full of tiles takes a handful of
+ * requests rather than one each.  Directories are kept once read.
+ * <br>
+ * Call start() and wait for the callback before handing this to a loader.
+ */
+public class PMTilesFetcher extends HandlerThread implements TileFetcher
+{
+    /**
+     * Called once we know what's in the archive, or that we can't read it.
+     */
+    public interface StartCallback
+    {
+        void started(PMTilesFetcher fetcher,boolean success);
+    }
+
+    /**
+     * Tiles closer together than this in the archive go in the same read.
+     */
+    public long maxGap = 16*1024;
+
+    /**
+     * Reads won't be grouped beyond this size.
+     */
+    public long maxRequestSize = 1024*1024;
+
+    /**
+     * Number of reads we'll have going at once.
+     */
+    public int numConnections = 8;
+
+    /**
+     * Tiles the archive doesn't have are handed back as empty, rather than failing.
+     */
+    public boolean neverFail = true;
+
+    /**
+     * Print out what we're reading.
+     */
+    public boolean debugMode = false;
+
+    /**
+     * Coordinate system, which is always Spherical Mercator.
+     */
+    public final CoordSystem coordSys = new SphericalMercatorCoordSystem();
+
+    /**
+     * Construct with a file path or an http(s) URL for the archive.
+     */
+    public PMTilesFetcher(BaseController inControl,String inName,String inURL)
+    {
+        super(inName);
+        control = new WeakReference<>(inControl);
+        name = inName;
+        url = inURL;
+        if (url.startsWith("file://")) {
+            file = new File(url.substring(7));
+        } else if (!url.startsWith("http://") && !url.startsWith("https://")) {
+            file = new File(url);
+        }
+        if (file == null) {
+            client = inControl.getHttpClient();
+        }
+
+        start();
+    }
+
+    /**
+     * Read the header and root directory.  The callback happens on the main thread.
+     */
+    public void start(final StartCallback callback)
+    {
+        final Handler handler = new Handler(getLooper());
+        handler.post(() -> readRange(0, PMTilesArchive.StartSize, (data, e) -> {
+            valid = data != null && archive.parseStart(data);
+            if (valid) {
+                tileInfo = new PMTilesTileInfo(archive.getMinZoom(), archive.getMaxZoom());
+            } else {
+                Log.w("Maply", "PMTilesFetcher: Failed to read archive header from " + url);
+            }
+            new Handler(Looper.getMainLooper()).post(() -> callback.started(this, valid));
+        }));
+    }
+
+    /**
+     * True once start() has read the archive successfully.
+     */
+    public boolean isValid() { return valid; }
+
+    public int getMinZoom() { return archive.getMinZoom(); }
+
+    public int getMaxZoom() { return archive.getMaxZoom(); }
+
+    /**
+     * Tile type from the header.  See PMTilesArchive.getTileType.
+     */
+    public int getTileType() { return archive.getTileType(); }
+
+    /**
+     * Min lon, min lat, max lon, max lat in degrees.
+     */
+    public double[] getBounds() { return archive.getBounds(); }
+
+    /**
+     * Tile info to give to the loader.  Null until start() succeeds.
+     */
+    public TileInfoNew getTileInfo() { return tileInfo; }
+
+    // All we need to find a tile is where it is
+    private static class PMTilesTileInfo extends TileInfoNew
+    {
+        PMTilesTileInfo(int inMinZoom,int inMaxZoom)
+        {
+            super(inMinZoom,inMaxZoom);
+        }
+
+        @Override public Object fetchInfoForTile(TileID tileID,boolean flipY)
+        {
+            return tileID;
+        }
+    }
+
+    // Wrapper around the fetch request so we can prioritize loads
+    private static class TileInfo implements Comparable<TileInfo>
+    {
+        int priority = 0;
+        float importance = 0.0f;
+        TileFetchRequest request = null;
+        TileID tileID = null;
+        long pmTileID = 0;
+
+        @Override public int compareTo(TileInfo that)
+        {
+            if (priority != that.priority)
+                return (priority < that.priority) ? -1 : 1;
+            if (importance != that.importance)
+                return (importance < that.importance) ? -1 : 1;
+            final int ret = tileID.compareTo(that.tileID);
+            if (ret != 0)
+                return ret;
+            // Different requests for the same tile are still different
+            return Integer.compare(System.identityHashCode(request), System.identityHashCode(that.request));
+        }
+    }
+
+    private interface ReadCallback
+    {
+        // Data is null on failure.  On our own thread.
+        void done(byte[] data,Exception e);
+    }
+
+    @Override public String getFetcherName()
+    {
+        return name;
+    }
+
+    @Override public void startTileFetches(final TileFetchRequest[] requests)
+    {
+        if (!valid)
+            return;
+
+        Handler handler = new Handler(getLooper());
+        handler.post(() -> {
+            for (TileFetchRequest request : requests) {
+                final TileInfo tile = new TileInfo();
+                tile.priority = request.priority;
+                tile.importance = request.importance;
+                tile.request = request;
+                tile.tileID = (TileID)request.fetchInfo;
+                // The archive counts down from the top
+                final int y = (1 << tile.tileID.level) - 1 - tile.tileID.y;
+                tile.pmTileID = PMTilesArchive.tileIDForTile(tile.tileID.x, y, tile.tileID.level);
+                toLoad.add(tile);
+                tilesByFetchRequest.put(request, tile);
+            }
+
+            scheduleLoading();
+        });
+    }
+
+    @Override public Object updateTileFetch(final Object fetchRequest,final int priority,final float importance)
+    {
+        if (!valid)
+            return null;
+
+        Handler handler = new Handler(getLooper());
+        handler.post(() -> {
+            final TileInfo tile = tilesByFetchRequest.get(fetchRequest);
+            if (tile != null && toLoad.remove(tile)) {
+                tile.priority = priority;
+                tile.importance = importance;
+                toLoad.add(tile);
+            }
+        });
+
+        return fetchRequest;
+    }
+
+    /**
+     * Cancel a group of requests.  A read that's already going for other tiles
+     * still finishes, but a cancelled tile won't be handed back.
+     */
+    @Override public void cancelTileFetches(final Object[] fetches)
+    {
+        if (!valid)
+            return;
+
+        Handler handler = new Handler(getLooper());
+        handler.post(() -> {
+            for (Object fetch : fetches) {
+                final TileInfo tile = tilesByFetchRequest.remove(fetch);
+                if (tile != null)
+                    toLoad.remove(tile);
+            }
+        });
+    }
+
+    @Override public void shutdown()
+    {
+        valid = false;
+        quitSafely();
+        control.clear();
+    }
+
+    // Schedule the next loading update
+    private void scheduleLoading()
+    {
+        if (!scheduled) {
+            scheduled = true;
+            Handler handler = new Handler(getLooper());
+            handler.post(this::updateLoading);
+        }
+    }
+
+    // Work out where the queued tiles are and start reading them.  On our own thread.
+    private void updateLoading()
+    {
+        scheduled = false;
+        if (!valid || toLoad.isEmpty() || numReading >= numConnections)
+            return;
+
+        // Most important first.  Missing tiles come out of the queue as we go.
+        final ArrayList<TileInfo> found = new ArrayList<>();
+        final ArrayList<long[]> ranges = new ArrayList<>();
+        for (TileInfo tile : new ArrayList<>(toLoad.descendingSet())) {
+            final long[] range = new long[2];
+            switch (archive.lookup(tile.pmTileID, range)) {
+                case PMTilesArchive.TileFound:
+                    found.add(tile);
+                    ranges.add(range);
+                    break;
+                case PMTilesArchive.TileMissing:
+                    finishTile(tile, null, null);
+                    break;
+                case PMTilesArchive.NeedDirectory:
+                    readDirectory(range[0], range[1]);
+                    break;
+            }
+        }
+        if (found.isEmpty())
+            return;
+
+        final long[] offsets = new long[ranges.size()];
+        final long[] lengths = new long[ranges.size()];
+        for (int ii = 0; ii < ranges.size(); ii++) {
+            offsets[ii] = ranges.get(ii)[0];
+            lengths[ii] = ranges.get(ii)[1];
+        }
+        final int[] whichRead = PMTilesArchive.groupReads(offsets, lengths, maxGap, maxRequestSize);
+        if (whichRead == null)
+            return;
+
+        // Collect the reads, in order of the most important tile in each
+        final HashMap<Integer,ArrayList<Integer>> reads = new HashMap<>();
+        final ArrayList<Integer> readOrder = new ArrayList<>();
+        for (int ii = 0; ii < whichRead.length; ii++) {
+            ArrayList<Integer> read = reads.get(whichRead[ii]);
+            if (read == null) {
+                read = new ArrayList<>();
+                reads.put(whichRead[ii], read);
+                readOrder.add(whichRead[ii]);
+            }
+            read.add(ii);
+        }
+
+        for (int readID : readOrder) {
+            if (numReading >= numConnections)
+                break;
+
+            final ArrayList<Integer> read = reads.get(readID);
+            final ArrayList<TileInfo> tiles = new ArrayList<>();
+            long start = Long.MAX_VALUE, end = 0;
+            for (int which : read) {
+                start = Math.min(start, offsets[which]);
+                end = Math.max(end, offsets[which] + lengths[which]);
+            }
+            final long[] tileOffsets = new long[read.size()];
+            final long[] tileLengths = new long[read.size()];
+            for (int ii = 0; ii < read.size(); ii++) {
+                final int which = read.get(ii);
+                final TileInfo tile = found.get(which);
+                toLoad.remove(tile);
+                tiles.add(tile);
+                tileOffsets[ii] = offsets[which] - start;
+                tileLengths[ii] = lengths[which];
+            }
+            readTiles(start, end - start, tiles, tileOffsets, tileLengths);
+        }
+    }
+
+    // Read a leaf directory, unless someone already is
+    private void readDirectory(final long offset,final long length)
+    {
+        if (!dirsLoading.add(offset))
+            return;
+
+        if (debugMode)
+            Log.d("Maply", "PMTilesFetcher: Reading directory at " + offset);
+
+        numReading++;
+        readRange(offset, length, (data, e) -> {
+            numReading--;
+            dirsLoading.remove(offset);
+            if (data == null || !archive.addDirectory(offset, length, data)) {
+                // Anyone waiting on it isn't going to get anywhere
+                final long[] range = new long[2];
+                for (TileInfo tile : new ArrayList<>(toLoad.descendingSet())) {
+                    if (archive.lookup(tile.pmTileID, range) == PMTilesArchive.NeedDirectory && range[0] == offset) {
+                        toLoad.remove(tile);
+                        finishTile(tile, null, (e != null) ? e.getLocalizedMessage() : "Failed to read PMTiles directory");
+                    }
+                }
+            }
+            scheduleLoading();
+        });
+    }
+
+    // Read a group of tiles in one go and split them up
+    private void readTiles(final long offset,final long length,final ArrayList<TileInfo> tiles,
+                           final long[] tileOffsets,final long[] tileLengths)
+    {
+        if (debugMode)
+            Log.d("Maply", "PMTilesFetcher: Reading " + tiles.size() + " tiles, " + length + " bytes at " + offset);
+
+        numReading++;
+        readRange(offset, length, (data, e) -> {
+            numReading--;
+            for (int ii = 0; ii < tiles.size(); ii++) {
+                final TileInfo tile = tiles.get(ii);
+                if (data == null) {
+                    finishTile(tile, null, (e != null) ? e.getLocalizedMessage() : "Failed to read PMTiles tile");
+                } else {
+                    final int start = (int)tileOffsets[ii];
+                    final int end = (int)Math.min(start + tileLengths[ii], data.length);
+                    final byte[] tileData = (start < end) ? Arrays.copyOfRange(data, start, end) : null;
+                    finishTile(tile, tileData, (tileData == null) ? "Short read from PMTiles archive" : null);
+                }
+            }
+            scheduleLoading();
+        });
+    }
+
+    // Hand a tile back, unless it's been cancelled.  On our own thread.
+    private void finishTile(final TileInfo tile,final byte[] data,final String error)
+    {
+        if (tilesByFetchRequest.remove(tile.request) == null)
+            return;
+        toLoad.remove(tile);
+
+        final BaseController theControl = control.get();
+        final LayerThread workThread = (theControl != null) ? theControl.getWorkingThread() : null;
+        if (workThread == null)
+            return;
+
+        workThread.addTask(() -> {
+            final byte[] tileData = (data != null) ? archive.decompressTile(data) : null;
+            if (tileData != null || (error == null && neverFail)) {
+                tile.request.callback.success(tile.request, tileData);
+            } else {
+                tile.request.callback.failure(tile.request, (error != null) ? error : "Tile not in PMTiles archive");
+            }
+        });
+    }
+
+    // Read part of the archive, calling back on our own thread
+    private void readRange(final long offset,final long length,final ReadCallback callback)
+    {
+        if (file != null) {
+            // Local reads are quick enough to just do here
+            byte[] data = null;
+            Exception err = null;
+            try (RandomAccessFile raf = new RandomAccessFile(file, "r")) {
+                final long len = Math.max(0, Math.min(length, raf.length() - offset));
+                data = new byte[(int)len];
+                raf.seek(offset);
+                raf.readFully(data);
+            } catch (Exception e) {
+                data = null;
+                err = e;
+            }
+            callback.done(data, err);
+            return;
+        }
+
+        final Request request = new Request.Builder()
+                .url(url)
+                .header("Range", "bytes=" + offset + "-" + (offset + length - 1))
+                .build();
+        final Handler handler = new Handler(getLooper());
+        client.newCall(request).enqueue(new Callback() {
+            @Override
+            public void onFailure(@NotNull Call call, @NotNull IOException e) {
+                handler.post(() -> callback.done(null, e));
+            }
+
+            @Override
+            public void onResponse(@NotNull Call call, @NotNull Response response) {
+                byte[] data = null;
+                Exception err = null;
+                try (final ResponseBody body = response.body()) {
+                    if (response.code() == 206) {
+                        data = (body != null) ? body.bytes() : null;
+                    } else if (response.code() == 200 && body != null) {
+                        // Server ignored the range and sent the lot
+                        final byte[] all = body.bytes();
+                        final int start = (int)Math.min(offset, all.length);
+                        data = Arrays.copyOfRange(all, start, (int)Math.min(offset + length, all.length));
+                    } else {
+                        err = new IOException("PMTiles read failed with status " + response.code());
+                    }
+                } catch (Exception e) {
+                    err = e;
+                }
+                final byte[] theData = data;
+                final Exception theErr = err;
+                handler.post(() -> callback.done(theData, theErr));
+            }
+        });
+    }
+
+    private final WeakReference<BaseController> control;
+    private final String name;
+    private final String url;
+    private File file = null;
+    private OkHttpClient client = null;
+    private final PMTilesArchive archive = new PMTilesArchive();
+    private TileInfoNew tileInfo = null;
+    private boolean valid = false;
+    private boolean scheduled = false;
+    private int numReading = 0;
+
+    // Directories being read, by offset
+    private final HashSet<Long> dirsLoading = new HashSet<>();
+
+    // Tiles sorted by priority, importance etc...
+    private final TreeSet<TileInfo> toLoad = new TreeSet<>();
+
+    // Tiles sorted by fetch request
+    private final HashMap<TileFetchRequest,TileInfo> tilesByFetchRequest = new HashMap<>();
+}
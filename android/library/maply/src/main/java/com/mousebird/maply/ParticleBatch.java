@@ -19,6 +19,8 @@
  */
 package com.mousebird.maply;
 
+import java.nio.ByteBuffer;
+
 /**
  * A particle batch adds a set number of particles to the system.
  * <br>
@@ -81,6 +83,20 @@ public class ParticleBatch {
      */
     public native boolean addAttribute(String name,char[] data);
 
+    /**
+     * Add an attribute array of the given name from a direct buffer.
+     * <br>
+     * The values are read in place from the buffer's position to its limit, in native
+     * byte order, so large batches don't have to go through a Java array first.
+     * The number of bytes must match the attribute's size times the batch size.
+     * @return true if the attribute array was valid, false otherwise.
+     */
+    public boolean addAttribute(String name,ByteBuffer data) {
+        return data.isDirect() && addAttributeDirect(name,data,data.position(),data.remaining());
+    }
+
+    private native boolean addAttributeDirect(String name,ByteBuffer data,int offset,int len);
+
 	/**
      * Tests if the batch is valid.
      * <br>
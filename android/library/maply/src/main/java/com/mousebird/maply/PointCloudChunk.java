@@ -0,0 +1,76 @@
+/*  PointCloudChunk.java
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package com.mousebird.maply;
+
+/**
+ * The points for one node of a point cloud, handed back to a PointCloudLoader.
+ * <br>
+ * Positions are in display coordinates and are quantized to 16 bits per axis
+ * within the node's box, so they take much less memory than Points would.
+ */
+public class PointCloudChunk
+{
+    /**
+     * Set up for the given node's box.  Get that from the loader.
+     */
+    public PointCloudChunk(Point3d ll,Point3d ur)
+    {
+        initialise(ll,ur);
+    }
+
+    /**
+     * Add a point in display coordinates.  It's clamped to the node's box.
+     */
+    public native void addPoint(double x,double y,double z);
+
+    /**
+     * Add a run of points, three doubles for each, in display coordinates.
+     */
+    public native void addPoints(double[] xyz);
+
+    /**
+     * Add a color for the point just added.  Colors are optional, but if you add any, add one for every point.
+     * @param color An ARGB color, as Android does them
+     */
+    public native void addColor(int color);
+
+    /**
+     * Which of the node's children have points, one bit each.
+     * Bit 0 of the child number picks x, bit 1 y and bit 2 z.
+     * All eight are assumed to be there by default.
+     */
+    public native void setChildMask(int childMask);
+
+    /**
+     * Number of points added so far.
+     */
+    public native int getNumPoints();
+
+    static
+    {
+        nativeInit();
+    }
+    public void finalize()
+    {
+        dispose();
+    }
+    private static native void nativeInit();
+    native void initialise(Point3d ll,Point3d ur);
+    native void dispose();
+    private long nativeHandle;
+}
@@ -0,0 +1,208 @@
+/*  PointCloudLoader.java
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package com.mousebird.maply;
+
+import androidx.annotation.CallSuper;
+
+import java.lang.ref.WeakReference;
+
+/**
+ * Pages a large point cloud in and out by octree node.
+ * <br>
+ * This is for point clouds too big to add all at once with addPoints.
+ * Starting from the root, the loader works out which nodes are on screen and
+ * how close their points would be, refining until they'd be pixelSpacing apart.
+ * It only asks the source for the nodes it needs, the most visible first.
+ * <br>
+ * Each node should hold a subsample of the points under it, getting denser
+ * as the levels go down.  Nodes are shown along with their parents.
+ * Nodes that go off screen are hidden and kept around until we're over the memory
+ * budget, when the least recently used lose their geometry and then their points.
+ * <br>
+ * Create one and hand it to addLayer on the controller.
+ */
+public class PointCloudLoader extends Layer implements LayerThread.ViewWatcherInterface
+{
+    /**
+     * Fill this in to read point cloud nodes out of your own storage.
+     */
+    public interface SourceInterface
+    {
+        /**
+         * Start loading a node.  This is called on the layer thread, so do the
+         * real work somewhere else and hand back the results with chunkLoaded
+         * or chunkFailed from whatever thread you're on.
+         */
+        void startFetch(PointCloudLoader loader,int level,int x,int y,int z);
+
+        /**
+         * The loader doesn't want this node anymore.  Anything handed back for it is ignored.
+         */
+        void cancelFetch(PointCloudLoader loader,int level,int x,int y,int z);
+    }
+
+    WeakReference<BaseController> control;
+    SourceInterface source;
+    GeometryInfo geomInfo;
+
+    /**
+     * Set up the loader for a point cloud.
+     *
+     * @param control The controller we'll be adding to.
+     * @param ll Lower left of the root node in display coordinates.
+     * @param ur Upper right of the root node in display coordinates.
+     * @param maxLevel The deepest level the octree goes.
+     * @param rootSpacing Typical distance between points in the root node, in display units.  It halves each level down.
+     * @param source Where the nodes come from.
+     * @param geomInfo Point settings, such as point size, shader and draw priority.
+     */
+    public PointCloudLoader(BaseController control,Point3d ll,Point3d ur,int maxLevel,double rootSpacing,SourceInterface source,GeometryInfo geomInfo)
+    {
+        this.control = new WeakReference<>(control);
+        this.source = source;
+        this.geomInfo = geomInfo;
+        initialise(ll,ur,maxLevel,rootSpacing);
+    }
+
+    /**
+     * How far apart points should get on screen before we stop loading more detail.  2 pixels by default.
+     */
+    public native void setPixelSpacing(double spacing);
+
+    /**
+     * Bytes we'll hold for points and geometry.  256MB by default.
+     */
+    public native void setMemoryBudget(long bytes);
+
+    /**
+     * Most fetches we'll have going at once.  8 by default.
+     */
+    public native void setMaxFetches(int maxFetches);
+
+    /**
+     * Fill in the box for a node, in display coordinates.
+     */
+    public native void boundsForNode(int level,int x,int y,int z,Point3d ll,Point3d ur);
+
+    /**
+     * Hand back the points for a node.  Call from any thread.
+     */
+    public native void chunkLoaded(PointCloudChunk chunk,int level,int x,int y,int z);
+
+    /**
+     * The node couldn't be loaded.  Call from any thread.
+     */
+    public native void chunkFailed(int level,int x,int y,int z);
+
+    /**
+     * Number of nodes loaded right now.
+     */
+    public native int getNumLoadedNodes();
+
+    /**
+     * Number of points being displayed right now.
+     */
+    public native long getNumDisplayedPoints();
+
+    /** --- Layer methods --- */
+
+    public void startLayer(LayerThread inLayerThread)
+    {
+        super.startLayer(inLayerThread);
+        startNative(control.get().scene,geomInfo);
+        layerThread.addWatcher(this);
+    }
+
+    @Override
+    @CallSuper
+    public void shutdown()
+    {
+        layerThread.removeWatcher(this);
+        ChangeSet changes = new ChangeSet();
+        shutdownNative(changes);
+        passOnRequests();
+        layerThread.addChanges(changes);
+        super.shutdown();
+    }
+
+    // Used to sunset delayed view updates
+    private int generation = 0;
+
+    /** --- View Updated Methods --- **/
+
+    public void viewUpdated(final ViewState viewState)
+    {
+        if (isShuttingDown || layerThread.isShuttingDown)
+            return;
+
+        final int thisGeneration = ++generation;
+        ChangeSet changes = new ChangeSet();
+        if (viewUpdatedNative(viewState,changes)) {
+            // Fetches are still going, so check back in a bit
+            layerThread.addDelayedTask(() -> {
+                if (thisGeneration >= generation) {
+                    viewUpdated(viewState);
+                }
+            }, LayerThread.UpdatePeriod);
+        }
+        passOnRequests();
+        layerThread.addChanges(changes);
+    }
+
+    // Hand the fetches and cancels from the last update to the source
+    private void passOnRequests()
+    {
+        int[] cancels = takeRequestsNative(true);
+        for (int ii=0;ii+3<cancels.length;ii+=4)
+            source.cancelFetch(this,cancels[ii],cancels[ii+1],cancels[ii+2],cancels[ii+3]);
+        int[] fetches = takeRequestsNative(false);
+        for (int ii=0;ii+3<fetches.length;ii+=4)
+            source.startFetch(this,fetches[ii],fetches[ii+1],fetches[ii+2],fetches[ii+3]);
+    }
+
+    // Called no more often than 1/10 of a second
+    public float getMinTime()
+    {
+        return 0.1f;
+    }
+
+    // Lags no more than 4s (if a user is continuously moving around, basically)
+    public float getMaxLagTime()
+    {
+        return 4.0f;
+    }
+
+    private native void startNative(Scene scene,GeometryInfo geomInfo);
+    private native boolean viewUpdatedNative(ViewState viewState,ChangeSet changes);
+    // Fetch or cancel requests as level, x, y, z
+    private native int[] takeRequestsNative(boolean cancels);
+    private native void shutdownNative(ChangeSet changes);
+
+    public void finalize()
+    {
+        dispose();
+    }
+    static
+    {
+        nativeInit();
+    }
+    private static native void nativeInit();
+    native void initialise(Point3d ll,Point3d ur,int maxLevel,double rootSpacing);
+    native void dispose();
+    private long nativeHandle;
+}
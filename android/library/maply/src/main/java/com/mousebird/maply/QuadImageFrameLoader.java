@@ -13,6 +13,8 @@ import android.os.Handler;
 public class QuadImageFrameLoader extends QuadImageLoaderBase
 {
     protected boolean valid = false;
+    // Sampling params we were started with, so terrain can ask for skirts
+    protected SamplingParams params = null;
 
     protected QuadImageFrameLoader() { }
 
@@ -27,6 +29,7 @@ public class QuadImageFrameLoader extends QuadImageLoaderBase
     {
         super(control, params, inTileInfos.length);
         tileInfos = inTileInfos;
+        this.params = params;
 
         valid = true;
         Handler handler = new Handler(control.getActivity().getMainLooper());
@@ -63,6 +66,77 @@ public class QuadImageFrameLoader extends QuadImageLoaderBase
     }
 
     protected native boolean setLoadFrameModeNative(int mode);
+
+    /**
+     * Number of frames to keep loaded around the current image.
+     * <br>
+     * If set, only this many frames are kept in memory, most of them ahead of the current
+     * image in the direction the animation is running.  Frames are loaded as they come into
+     * that window and unloaded as they leave it.  0, the default, keeps all the frames.
+     */
+    public void setFrameWindow(int numFrames)
+    {
+        setFrameWindowNative(numFrames);
+        if (samplingLayer != null) {
+            QuadSamplingLayer layer = samplingLayer.get();
+            if (layer == null || layer.layerThread == null)
+                return;
+            layer.layerThread.addTask(new Runnable() {
+                @Override
+                public void run() {
+                    updatePriorities();
+                }
+            });
+        }
+    }
+
+    protected native void setFrameWindowNative(int numFrames);
+
+    /**
+     * Number of frames kept loaded around the current image.  0 if all of them are.
+     */
+    public native int getFrameWindow();
+
+    /**
+     * Draw all the frames at once, each blended over the ones before, rather than animating between them.
+     * <br>
+     * Use this for stacked layers, such as a basemap, a hillshade and an overlay.  They share one set
+     * of tile geometry and are drawn in a single pass, which cuts down on overdraw.  Up to four frames are
+     * composited and all of them are loaded.  Set this before the loader starts.
+     */
+    public native void setCompositeFrames(boolean composite);
+
+    public native boolean getCompositeFrames();
+
+    /**
+     * How heights are packed into the pixels of elevation tiles.
+     */
+    public enum ElevationEncoding {Terrarium,MapboxRGB};
+
+    /**
+     * Use the second tile source as elevation for the first, rather than as another frame.
+     * <br>
+     * Give the loader two tile infos, the imagery and then elevation tiles with the same layout.
+     * Each tile is raised in the vertex shader by the heights in its elevation image, so terrain
+     * costs nothing extra to build and the tile geometry can still be shared.  Skirts are built
+     * to hide the seams, on flat maps as well.  Set this before the loader starts.
+     *
+     * @param encoding How the heights are packed into the elevation images.
+     * @param exaggeration Scale for the heights.  1.0 is true to life.
+     */
+    public void setTerrain(ElevationEncoding encoding,double exaggeration)
+    {
+        setTerrainNative(encoding.ordinal(),exaggeration);
+        if (params != null && getTerrain())
+            params.setElevTextures(true);
+    }
+
+    protected native void setTerrainNative(int encoding,double exaggeration);
+
+    /**
+     * Set if the second tile source is elevation for the first.
+     */
+    public native boolean getTerrain();
     protected native void updatePriorities();
 
     /**
@@ -166,6 +240,33 @@ public class QuadImageFrameLoader extends QuadImageLoaderBase
      */
     public native void setTextureSize(int tileSize,int borderSize);
 
+    /**
+     *  If set, tile images are copied into a pixel buffer on the loader's thread
+     *  and the renderer only has to kick off the copy into the texture.
+     *
+     *  Requires OpenGL ES 3.  Off by default.
+     */
+    public native void setAsyncTextureUpload(boolean async);
+
+    /**
+     *  If set, tiles that are still loading are drawn with the part of the nearest
+     *  loaded ancestor's image that covers them, even if levels in between are missing.
+     *  Tiles whose parents are still loading are fetched after everything else.
+     *
+     *  Off by default.
+     */
+    public native void setParentPlaceholders(boolean placeholders);
+
+    /**
+     *  If set, images from tile sources in another coordinate system (Proj4, BNG and so on)
+     *  are warped on the GPU to line up with the display.  Each tile is drawn once into a new
+     *  texture through a mesh with this many samples on a side, so the tile geometry can use
+     *  far fewer samples.
+     *
+     *  0, the default, turns this off.
+     */
+    public native void setReprojectSamples(int samples);
+
     /**
      *  Shader to use for rendering the image frames for a particular focus.
      *
@@ -213,6 +314,11 @@ public class QuadImageFrameLoader extends QuadImageLoaderBase
          * Number of tiles this frame has yet to load
          */
         public int tilesToLoad;
+
+        /**
+         * Number of tiles that have this frame loaded
+         */
+        public int tilesLoaded;
     }
 
     /**
@@ -225,6 +331,16 @@ public class QuadImageFrameLoader extends QuadImageLoaderBase
          */
         public int numTiles = 0;
 
+        /**
+         * Texture memory for all the frames the loader has loaded, in bytes
+         */
+        public long texBytes = 0;
+
+        /**
+         * Tiles holding at least one texture
+         */
+        public int numTexTiles = 0;
+
         /**
          * Per frame stats for current loading state
          */
@@ -244,19 +360,24 @@ public class QuadImageFrameLoader extends QuadImageLoaderBase
         stats.frameStats = new FrameStats[numFrames];
         int totalTiles[] = new int[numFrames];
         int tilesToLoad[] = new int[numFrames];
+        int tilesLoaded[] = new int[numFrames];
 
         // Fetch the data like this because I'm lazy
-        stats.numTiles = getStatsNative(totalTiles, tilesToLoad);
+        long[] texInfo = new long[2];
+        stats.numTiles = getStatsNative(totalTiles, tilesToLoad, tilesLoaded, texInfo);
+        stats.texBytes = texInfo[0];
+        stats.numTexTiles = (int)texInfo[1];
         for (int ii=0;ii<numFrames;ii++)
         {
             FrameStats frameStats = new FrameStats();
             frameStats.tilesToLoad = tilesToLoad[ii];
             frameStats.totalTiles = totalTiles[ii];
+            frameStats.tilesLoaded = tilesLoaded[ii];
             stats.frameStats[ii] = frameStats;
         }
 
         return stats;
     }
 
-    private native int getStatsNative(int[] totalTiles,int[] tilesToLoad);
+    private native int getStatsNative(int[] totalTiles,int[] tilesToLoad,int[] tilesLoaded,long[] texInfo);
 }
@@ -80,6 +80,69 @@ public class QuadLoaderBase implements QuadSamplingLayer.ClientInterface
      */
     public native boolean getDebugMode();
 
+    /**
+     * Time spent getting to one stage of loading a tile from the stage before.
+     * The stages are fetch, decode, merge and display, and "total" covers the whole trip.
+     * Times are in seconds.
+     */
+    public static class TileLatency {
+        public String stage;
+        public int count;
+        public double min, max, mean, p50, p95;
+    }
+
+    /**
+     * Turn per-tile latency tracking on or off.
+     * When on, each tile is timed from the fetch request, through the data coming back,
+     * the interpreter finishing and the results being merged, to the renderer applying
+     * them for the frame that draws them.  Off by default.
+     */
+    public native void setTileLatencyEnabled(boolean enable);
+    public native boolean getTileLatencyEnabled();
+
+    /**
+     * Reload over the tiles currently showing, rather than clearing them.
+     * With this on, a reload only touches the tiles in the areas given.  They keep showing
+     * what they have until their new data is parsed, then the textures are swapped in one go.
+     * Tiles whose data comes back the same as before aren't parsed again, and failed loads
+     * leave the old data up.  Meant for live data that's refreshed often.  Off by default.
+     */
+    public native void setReloadInPlace(boolean inPlace);
+    public native boolean getReloadInPlace();
+
+    /**
+     * Discard the recorded tile latencies.
+     */
+    public native void clearTileLatencyStats();
+
+    /**
+     * Summarize the recorded tile latencies, one entry per stage.
+     * Returns null if there's nothing to report.
+     */
+    public TileLatency[] getTileLatencyStats() {
+        final String[] names = getTileLatencyStageNames();
+        final double[] vals = getTileLatencyValues();
+        if (names == null || vals == null || vals.length < names.length * 6) {
+            return null;
+        }
+        TileLatency[] stats = new TileLatency[names.length];
+        for (int ii = 0; ii < names.length; ii++) {
+            TileLatency stat = new TileLatency();
+            stat.stage = names[ii];
+            stat.count = (int)vals[ii*6];
+            stat.min = vals[ii*6+1];
+            stat.max = vals[ii*6+2];
+            stat.mean = vals[ii*6+3];
+            stat.p50 = vals[ii*6+4];
+            stat.p95 = vals[ii*6+5];
+            stats[ii] = stat;
+        }
+        return stats;
+    }
+
+    private static native String[] getTileLatencyStageNames();
+    private native double[] getTileLatencyValues();
+
     private WeakReference<BaseController> control;
 
     /**
@@ -287,6 +350,8 @@ public class QuadLoaderBase implements QuadSamplingLayer.ClientInterface
 
     protected native void mergeLoaderReturn(LoaderReturn loadReturn,ChangeSet changes);
 
+    protected native void mergeLoaderReturns(LoaderReturn[] loadReturns,ChangeSet changes);
+
     /* --- QuadSamplingLayer interface --- */
 
     public void samplingLayerConnect(QuadSamplingLayer layer,ChangeSet changes)
@@ -379,8 +444,12 @@ public class QuadLoaderBase implements QuadSamplingLayer.ClientInterface
             final boolean placeholder = tileInfo != null &&
                     (tileID.level < tileInfo.minZoom || tileID.level > tileInfo.maxZoom);
 
-            if (tileInfo != null && !placeholder) {
-                fetchRequest.fetchInfo = tileInfo.fetchInfoForTile(tileID, getFlipY());
+            // The tile info can also decline to fetch this one
+            final Object fetchInfo = (tileInfo != null && !placeholder) ?
+                    tileInfo.fetchInfoForTile(tileID, getFlipY()) : null;
+
+            if (fetchInfo != null) {
+                fetchRequest.fetchInfo = fetchInfo;
                 fetchRequest.tileSource = tileInfo.uniqueID;
                 frameAsset.request = fetchRequest;
 
@@ -397,7 +466,7 @@ public class QuadLoaderBase implements QuadSamplingLayer.ClientInterface
         }
     }
 
-    private void fetchSuccess(@SuppressWarnings("unused") TileFetchRequest fetchRequest,
+    private void fetchSuccess(TileFetchRequest fetchRequest,
                               TileID tileID, int frame, long frameID, byte[] data) {
         final LoaderInterpreter theLoadInterp = loadInterp;
         final QuadSamplingLayer layer = getSamplingLayer();
@@ -413,6 +482,11 @@ public class QuadLoaderBase implements QuadSamplingLayer.ClientInterface
             return;
         }
 
+        // An in-place reload that came back with the same data, so keep what's showing
+        if (data != null && frameUnchanged(tileID, frameID, data)) {
+            return;
+        }
+
         ArrayList<byte[]> allData = null;
         final boolean merge = getModeNative() == Mode.SingleFrame.ordinal() && getNumFrames() > 1;
         if (merge) {
@@ -439,7 +513,15 @@ public class QuadLoaderBase implements QuadSamplingLayer.ClientInterface
             loadReturn.addTileData(data);
         }
 
-        // We're on an AsyncTask in the background here, so do the loading
+        // Hand the parsing to the shared workers if they're running.
+        // Otherwise we're on an AsyncTask in the background here, so do the loading.
+        if (!scheduleTaskNative(fetchRequest.importance, loadReturn,
+                                () -> parseAndMerge(theLoadInterp, layer, loadReturn))) {
+            parseAndMerge(theLoadInterp, layer, loadReturn);
+        }
+    }
+
+    private void parseAndMerge(LoaderInterpreter theLoadInterp, QuadSamplingLayer layer, LoaderReturn loadReturn) {
         if (loadInterp != null) {
             try (LayerThread.WorkWrapper wr = layer.layerThread.startOfWorkWrapper()) {
                 if (wr != null) {
@@ -451,24 +533,16 @@ public class QuadLoaderBase implements QuadSamplingLayer.ClientInterface
         // Merge the data back in on the sampling layer's thread.
         // Note that we need to do this even if the loaderReturn is in the canceled state,
         // in order to correctly update the state of the associated tile and frames.
+        // Tiles that finish while a merge is queued go in with it.
         if (!isShuttingDown && !layer.isShuttingDown) {
-            layer.layerThread.addTask(() -> {
-                final BaseController control = getController();
-                if (control != null) {
-                    try (LayerThread.WorkWrapper wr = layer.layerThread.startOfWorkWrapper()) {
-                        if (wr != null) {
-                            if (loadInterp != null && !isShuttingDown) {
-                                ChangeSet changes = new ChangeSet();
-                                mergeLoaderReturn(loadReturn, changes);
-                                layer.layerThread.addChanges(changes);
-                            } else {
-                                cleanupLoadedData(control, loadReturn);
-                            }
-                        }
-                    }
-                }
-                loadReturn.dispose();
-            });
+            final boolean scheduleMerge;
+            synchronized (toMerge) {
+                scheduleMerge = toMerge.isEmpty();
+                toMerge.add(loadReturn);
+            }
+            if (scheduleMerge) {
+                layer.layerThread.addTask(() -> mergeLoaderReturns(layer));
+            }
         } else {
             try (LayerThread.WorkWrapper wr = layer.layerThread.startOfWorkWrapper()) {
                 if (wr != null) {
@@ -479,6 +553,38 @@ public class QuadLoaderBase implements QuadSamplingLayer.ClientInterface
         }
     }
 
+    // Merge everything parsed since the last time in one pass, on the layer thread
+    private void mergeLoaderReturns(QuadSamplingLayer layer) {
+        final LoaderReturn[] loadReturns;
+        synchronized (toMerge) {
+            loadReturns = toMerge.toArray(new LoaderReturn[0]);
+            toMerge.clear();
+        }
+
+        final BaseController control = getController();
+        if (control != null) {
+            try (LayerThread.WorkWrapper wr = layer.layerThread.startOfWorkWrapper()) {
+                if (wr != null) {
+                    if (loadInterp != null && !isShuttingDown) {
+                        ChangeSet changes = new ChangeSet();
+                        mergeLoaderReturns(loadReturns, changes);
+                        layer.layerThread.addChanges(changes);
+                    } else {
+                        for (LoaderReturn loadReturn : loadReturns) {
+                            cleanupLoadedData(control, loadReturn);
+                        }
+                    }
+                }
+            }
+        }
+        for (LoaderReturn loadReturn : loadReturns) {
+            loadReturn.dispose();
+        }
+    }
+
+    // Parsed and waiting for the layer thread
+    private final ArrayList<LoaderReturn> toMerge = new ArrayList<>();
+
     private void fetchFailed(@SuppressWarnings("unused") TileFetchRequest fetchRequest,
                              @SuppressWarnings("unused") String errorMessage) {
         final QuadSamplingLayer layer = getSamplingLayer();
@@ -567,9 +673,31 @@ public class QuadLoaderBase implements QuadSamplingLayer.ClientInterface
 
     protected native boolean isFrameLoading(TileID tileID, long frameID);
 
+    /**
+     * Parse tiles for all the loaders on a shared set of threads.
+     * <br>
+     * With this on, tile parsing is handed to a shared pool, most important tiles first,
+     * rather than being done on whichever thread fetched the tile.
+     * That keeps the total work bounded no matter how many loaders there are.
+     * 0, the default, turns it off.
+     */
+    public static native void setSharedTaskThreads(int numThreads);
+
+    /**
+     * Number of shared threads parsing tiles, if any.
+     */
+    public static native int getSharedTaskThreads();
+
+    /**
+     * Queue the task on the shared threads, returning false if there aren't any.
+     */
+    protected native boolean scheduleTaskNative(double importance, LoaderReturn loadReturn, Runnable task);
+
     protected native boolean mergeLoadedFrame(TileID tileID, long frameID,
                                               byte[] rawData, ArrayList<byte[]> allRawData);
 
+    protected native boolean frameUnchanged(TileID tileID, long frameID, byte[] rawData);
+
     public native int getZoomSlot();
 
     public native int getNumFrames();
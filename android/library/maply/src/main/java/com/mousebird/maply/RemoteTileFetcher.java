@@ -22,6 +22,7 @@ import android.os.AsyncTask;
 import android.os.Handler;
 import android.os.HandlerThread;
 import android.util.Log;
+import android.util.LruCache;
 
 import org.jetbrains.annotations.NotNull;
 
@@ -34,7 +35,10 @@ import java.io.OutputStream;
 import java.lang.ref.WeakReference;
 import java.text.SimpleDateFormat;
 import java.util.Date;
+import java.util.ArrayList;
 import java.util.HashMap;
+import java.util.HashSet;
+import java.util.Iterator;
 import java.util.Locale;
 import java.util.TreeSet;
 
@@ -55,12 +59,135 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
      */
     public boolean debugMode = false;
 
+    /**
+     * Keep cached tiles in a few pack files in each cache directory rather than a file per tile.
+     * This is much faster once there are a lot of tiles and it's what makes the size and
+     * lifetime limits work.  Loose tile files already in the cache directory are ignored.
+     */
+    public boolean packedCache = false;
+
+    /**
+     * With packedCache on, the most space (in bytes) to use in each cache directory.  0 is no limit.
+     */
+    public long cacheSizeLimit = 0;
+
+    /**
+     * With packedCache on, cached tiles older than this (in seconds) are fetched again.  0 keeps them forever.
+     */
+    public double cacheLifetime = 0.0;
+
+    private final HashMap<File,TileCacheStore> cacheStores = new HashMap<>();
+
+    /**
+     * Bytes of recently fetched tile data to keep in memory.
+     * Tiles asked for again soon after they were fetched, as happens when panning back and forth,
+     * come from here rather than the cache directory or the network.  16MB by default, 0 turns it off.
+     */
+    public void setMemoryCacheSize(int size) {
+        synchronized (this) {
+            if (size <= 0) {
+                memCache = null;
+            } else if (memCache == null) {
+                memCache = makeMemoryCache(size);
+            } else {
+                memCache.resize(size);
+            }
+        }
+    }
+
+    // One network transfer and all the tiles waiting on it
+    private static class SharedFetch {
+        final Call call;
+        final String host;
+        final ArrayList<TileInfo> tiles = new ArrayList<>();
+        SharedFetch(Call call,String host) {
+            this.call = call;
+            this.host = host;
+        }
+    }
+
+    // Network fetches in progress, by URL, so loaders asking for the same tile share one
+    private final HashMap<String,SharedFetch> sharedFetches = new HashMap<>();
+
+    // Recently fetched tiles, by URL
+    private LruCache<String,byte[]> memCache = makeMemoryCache(16*1024*1024);
+
+    private static LruCache<String,byte[]> makeMemoryCache(int size) {
+        return new LruCache<String,byte[]>(size) {
+            @Override protected int sizeOf(String key, byte[] data) {
+                return data.length;
+            }
+        };
+    }
+
+    // Data for a tile we fetched recently, if we still have it
+    protected byte[] readFromMemory(TileInfo tile) {
+        final LruCache<String,byte[]> cache;
+        synchronized (this) {
+            cache = memCache;
+        }
+        return (cache != null) ? cache.get(tile.fetchInfo.urlReq.url().toString()) : null;
+    }
+
+    protected void writeToMemory(TileInfo tile,byte[] data) {
+        final LruCache<String,byte[]> cache;
+        synchronized (this) {
+            cache = memCache;
+        }
+        if (cache != null && data != null) {
+            cache.put(tile.fetchInfo.urlReq.url().toString(), data);
+        }
+    }
+
     /**
      * Number of connections we'll allow at once.
      * You can change this later, but it'll take a little time to update.
      */
     int numConnections = 8;
 
+    /**
+     * Work out how many of the connections each host should get.
+     * When more connections aren't getting more data back from a host, the requests are
+     * just waiting at the server, so that host gets fewer and other requests go first.
+     * Timeouts and overloaded responses cut a host back right away.  On by default.
+     */
+    public boolean adaptiveConnections = true;
+
+    /**
+     * Read cached tiles as soon as they're asked for.
+     * Tiles in the memory or disk caches normally take up a connection while they're read,
+     * so they wait behind the network fetches.  With this on, they're read right away and only
+     * network fetches count against the connections.  Off by default.
+     */
+    public boolean immediateCacheReads = false;
+
+    // Connections each host gets, worked out from how it's responding
+    private final TileFetchThrottle throttle = new TileFetchThrottle(Math.min(2,numConnections),numConnections);
+
+    private static String hostFor(TileInfo tile) {
+        return tile.fetchInfo.urlReq.url().host();
+    }
+
+    // Connections the loading tiles are holding
+    private int connectionsInUse() {
+        synchronized (loading) {
+            if (!immediateCacheReads)
+                return loading.size();
+
+            // Cached tiles don't wait on the network, so they don't count
+            int count = 0;
+            for (TileInfo tile : loading)
+                if (!tile.isLocal)
+                    count++;
+            return count;
+        }
+    }
+
+    // Only network fetches count against the hosts
+    private boolean canStartTile(TileInfo tile) {
+        return !adaptiveConnections || tile.isLocal || throttle.canStart(hostFor(tile));
+    }
+
     /**
      * Name of this tile fetcher.  Used for coordinating tile sources.
      */
@@ -81,6 +208,10 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
         // Set if we already know the tile is cached
         boolean isLocal = false;
 
+        // Set if the data came from memory or the cache, or another tile is writing the
+        // same cache file, so there's no need to cache it again
+        boolean fromCache = false;
+
         // Used to uniquely identify a group of requests
         long tileSource = 0;
 
@@ -225,6 +356,16 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
     protected Stats allStats;
     protected Stats recentStats;
 
+    /**
+     * How fast remote data has been coming in lately, in bytes per second.
+     * <br>
+     * This is what all the connections to all the hosts have been getting together.
+     * It's 0 until enough tiles have come back to tell.
+     */
+    public double getThroughput() {
+        return throttle.getRate();
+    }
+
     /** Return the stats (recent or for all time
      */
     public Stats getStats(boolean allTime) {
@@ -323,7 +464,7 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
                     Log.d("RemoteTileFetcher","Requesting fetch for " + tile.fetchInfo.urlReq);
 
                 // If it's already cached, let's mark that
-                tile.isLocal = tile.fetchInfo.cacheFile != null && tile.fetchInfo.cacheFile.exists();
+                tile.isLocal = readFromMemory(tile) != null || isCached(tile.fetchInfo);
 
                 synchronized (tilesByFetchRequest) {
                     tilesByFetchRequest.put(request, tile);
@@ -342,6 +483,19 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
         });
     }
 
+    /**
+     * True if the tile is in the cache on disk, so fetching it won't go to the network.
+     */
+    public boolean isCached(RemoteTileFetchInfo fetchInfo)
+    {
+        final File cacheFile = (fetchInfo != null) ? fetchInfo.cacheFile : null;
+        if (cacheFile == null)
+            return false;
+        if (packedCache)
+            return cacheStoreFor(cacheFile).contains(cacheFile.getName());
+        return cacheFile.exists();
+    }
+
     boolean scheduled = false;
 
     // Schedule the next loading update
@@ -366,16 +520,21 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
         if (!valid)
             return;
 
-        while (loading.size() < numConnections) {
+        int inUse = connectionsInUse();
+        while (inUse < numConnections) {
             updateActiveStats();
 
-            final TileInfo tile;
+            // The most important one we can start, passing over those for hosts that are busy
+            TileInfo tile = null;
             synchronized (toLoad) {
-                if (toLoad.isEmpty())
-                    break;
-                tile = toLoad.last();
-                if (tile != null) {
-                    toLoad.remove(tile);
+                final Iterator<TileInfo> it = toLoad.descendingIterator();
+                while (it.hasNext()) {
+                    final TileInfo next = it.next();
+                    if (canStartTile(next)) {
+                        it.remove();
+                        tile = next;
+                        break;
+                    }
                 }
             }
             if (tile == null) {
@@ -388,6 +547,8 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
                     Log.w("RemoteTileFetcher", "Tile already loading: " + tile.toString());
                 }
             }
+            if (!immediateCacheReads || !tile.isLocal)
+                inUse++;
 
             if (debugMode)
                 Log.d("RemoteTileFetcher","Starting load of request: " + tile.fetchInfo.urlReq);
@@ -395,7 +556,14 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
             // Set up the fetching task
             tile.task = client.newCall(tile.fetchInfo.urlReq);
 
-            if (tile.isLocal) {
+            final byte[] memData = tile.isLocal ? readFromMemory(tile) : null;
+            if (memData != null) {
+                // Fetched recently, so we've still got it
+                tile.fromCache = true;
+                allStats.localData = allStats.localData + memData.length;
+                recentStats.localData = recentStats.localData + memData.length;
+                handleFinishLoading(tile,memData,null);
+            } else if (tile.isLocal && tile.fetchInfo.cacheFile != null) {
                 // Try reading the data in the background
                 new CacheTask(this,tile).executeOnExecutor(AsyncTask.THREAD_POOL_EXECUTOR,(Void)null);
             } else {
@@ -425,8 +593,26 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
     }
 
     // Kick off a network fetch with the appropriate callbacks
+    // Called on our own thread or a random one
     protected void startFetch(final TileInfo tile)
     {
+        final String key = tile.fetchInfo.urlReq.url().toString();
+        synchronized (sharedFetches) {
+            final SharedFetch fetch = sharedFetches.get(key);
+            if (fetch != null) {
+                // Someone else is already fetching this one, so wait on theirs
+                if (debugMode)
+                    Log.d("RemoteTileFetcher","Sharing load of request: " + tile.fetchInfo.urlReq);
+                tile.task = fetch.call;
+                fetch.tiles.add(tile);
+                return;
+            }
+            final SharedFetch newFetch = new SharedFetch(tile.task, hostFor(tile));
+            newFetch.tiles.add(tile);
+            sharedFetches.put(key, newFetch);
+            throttle.started(newFetch.host);
+        }
+
         final double fetchStartTime = System.currentTimeMillis() /1000.0;
 
         tile.task.enqueue(new Callback() {
@@ -447,19 +633,52 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
                     }
                 }
 
-                finishedLoading(tile,null,e, fetchStartTime);
+                finishedLoading(key,null,e, fetchStartTime);
             }
 
             @Override
             public void onResponse(@NotNull Call call, @NotNull Response response) {
-                finishedLoading(tile, response, null, fetchStartTime);
+                finishedLoading(key, response, null, fetchStartTime);
             }
         });
     }
 
-    // Got response back, may be good, may be bad.
+    // Stop waiting on a network fetch, and stop the fetch if nobody else wants it.
+    // On our own thread.
+    protected void cancelFetch(TileInfo tile)
+    {
+        if (tile.task == null)
+            return;
+
+        final String key = tile.fetchInfo.urlReq.url().toString();
+        synchronized (sharedFetches) {
+            final SharedFetch fetch = sharedFetches.get(key);
+            // Tiles for different requests can be equal, so look for this one in particular
+            final int which = (fetch != null) ? indexOfTile(fetch.tiles, tile) : -1;
+            if (which >= 0) {
+                fetch.tiles.remove(which);
+                if (fetch.tiles.isEmpty()) {
+                    fetch.call.cancel();
+                    throttle.cancelled(fetch.host);
+                    sharedFetches.remove(key);
+                }
+                return;
+            }
+        }
+        tile.task.cancel();
+    }
+
+    private static int indexOfTile(ArrayList<TileInfo> tiles,TileInfo tile)
+    {
+        for (int ii = 0; ii < tiles.size(); ii++)
+            if (tiles.get(ii) == tile)
+                return ii;
+        return -1;
+    }
+
+    // Got response back for everyone waiting on the given URL, may be good, may be bad.
     // On a random thread, perhaps
-    protected void finishedLoading(final TileInfo inTile, final Response response, final Exception inE,final double fetchStartTile)
+    protected void finishedLoading(final String key, final Response response, final Exception inE,final double fetchStartTile)
     {
         if (!valid) {
             if (response != null) {
@@ -475,18 +694,39 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
                 final double howLong = System.currentTimeMillis() / 1000.0 - fetchStartTile;
 
                 // Make sure we still care
-                final TileInfo tile;
-                synchronized (tilesByFetchRequest) {
-                    tile = tilesByFetchRequest.get(inTile.request);
+                final SharedFetch fetch;
+                synchronized (sharedFetches) {
+                    fetch = sharedFetches.remove(key);
+                }
+                final ArrayList<TileInfo> tiles = new ArrayList<>();
+                if (fetch != null) {
+                    synchronized (tilesByFetchRequest) {
+                        for (TileInfo inTile : fetch.tiles) {
+                            final TileInfo tile = tilesByFetchRequest.get(inTile.request);
+                            if (tile != null)
+                                tiles.add(tile);
+                        }
+                    }
                 }
-                if (tile == null) {
+                if (tiles.isEmpty()) {
+                    if (fetch != null)
+                        throttle.cancelled(fetch.host);
                     if (debugMode)
-                        Log.d("RemoteTileFetcher", "Dropping a tile request because it was cancelled: " + inTile.fetchInfo.urlReq);
+                        Log.d("RemoteTileFetcher", "Dropping a tile request because it was cancelled: " + key);
                     return;
                 }
 
+                // Only write each cache file once
+                final HashSet<File> cacheFiles = new HashSet<>();
+                for (TileInfo tile : tiles) {
+                    final File cacheFile = tile.fetchInfo.cacheFile;
+                    if (cacheFile != null && !cacheFiles.add(cacheFile))
+                        tile.fromCache = true;
+                }
+
                 boolean success = (inE == null && response != null && response.isSuccessful());
                 Exception e = inE;
+                int received = 0;
 
                 if (debugMode)
                     Log.d("RemoteTileFetcher", "Got response for: " + response.request());
@@ -496,16 +736,19 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
                         final byte[] bodyBytes = (body != null) ? body.bytes() : null;
                         // body.contentLength() is -1 for streamed responses (transfer-encoding:chunked)
                         final int bodyLength = (bodyBytes != null) ? bodyBytes.length : 0;
+                        received = bodyLength;
                         if (bodyLength > 0) {
                             allStats.remoteData = allStats.remoteData + bodyLength;
                             recentStats.remoteData = recentStats.remoteData + bodyLength;
-                            handleFinishLoading(tile, bodyBytes, null);
+                            for (TileInfo tile : tiles)
+                                handleFinishLoading(tile, bodyBytes, null);
                         } else if (response.code() == 204) {
                             // 204 "No Content" means an empty result is "success" ... sortof.
                             // This usually means the requested tile is outside the supported
                             // geographic area or zoom levels.
                             // We still need to process it to make sure the frame(s) load correctly.
-                            handleFinishLoading(tile, null, null);
+                            for (TileInfo tile : tiles)
+                                handleFinishLoading(tile, null, null);
                         } else {
                             // empty response is an error, otherwise
                             success = false;
@@ -516,6 +759,14 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
                     }
                 }
 
+                // Timeouts and busy servers mean the host wants fewer connections.
+                // Any other answer tells us how it's doing.
+                if (e != null || response.code() == 429 || response.code() >= 500) {
+                    throttle.failed(fetch.host);
+                } else {
+                    throttle.finished(fetch.host, howLong, received);
+                }
+
                 allStats.remoteRequests = allStats.remoteRequests + 1;
                 recentStats.remoteRequests = recentStats.remoteRequests + 1;
 
@@ -526,7 +777,8 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
                     allStats.totalFails = allStats.totalFails + 1;
                     recentStats.totalFails = recentStats.totalFails + 1;
 
-                    handleFinishLoading(tile, null, e);
+                    for (TileInfo tile : tiles)
+                        handleFinishLoading(tile, null, e);
                 }
             } finally {
                 if (response != null) {
@@ -546,25 +798,33 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
             return;
 
         boolean success = false;
-        final int size = (int) tile.fetchInfo.cacheFile.length();
-        final byte[] data = new byte[size];
-        try {
-            try (FileInputStream fileStream = new FileInputStream(tile.fetchInfo.cacheFile)) {
-                try (BufferedInputStream buf = new BufferedInputStream(fileStream)) {
-                    final int bytesRead = buf.read(data, 0, data.length);
-                    if (bytesRead == data.length) {
-                        success = true;
+        final File cacheFile = tile.fetchInfo.cacheFile;
+        final byte[] data;
+        if (packedCache) {
+            data = cacheStoreFor(cacheFile).find(cacheFile.getName());
+            success = data != null;
+        } else {
+            data = new byte[(int) cacheFile.length()];
+            try {
+                try (FileInputStream fileStream = new FileInputStream(cacheFile)) {
+                    try (BufferedInputStream buf = new BufferedInputStream(fileStream)) {
+                        final int bytesRead = buf.read(data, 0, data.length);
+                        if (bytesRead == data.length) {
+                            success = true;
+                        }
                     }
                 }
+            } catch (Exception e) {
+                Log.w("RemoteTileFetcher", "Failed to read cache", e);
             }
-        } catch (Exception e) {
-            Log.w("RemoteTileFetcher", "Failed to read cache", e);
         }
+        final int size = success ? data.length : 0;
 
         if (success) {
             if (!valid)
                 return;
 
+            tile.fromCache = true;
             final Handler handler = new Handler(getLooper());
             handler.post(() -> {
                 allStats.localData = allStats.localData + size;
@@ -619,7 +879,10 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
             }
 
             if (error == null) {
-                writeToCache(tile, data);
+                writeToMemory(tile, data);
+                if (!tile.fromCache) {
+                    writeToCache(tile, data);
+                }
                 tile.request.callback.success(tile.request, data);
             } else
                 tile.request.callback.failure(tile.request, error.toString());
@@ -645,6 +908,11 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
         if (cacheFile == null || data == null || data.length < 1)
             return;
 
+        if (packedCache) {
+            cacheStoreFor(cacheFile).add(cacheFile.getName(), data);
+            return;
+        }
+
         final File parent = cacheFile.getParentFile();
         if (parent != null && !parent.isDirectory() && !parent.mkdirs()) {
             return;
@@ -657,6 +925,24 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
         }
     }
 
+    // Packed cache for the directory a cache file would go in
+    protected TileCacheStore cacheStoreFor(File cacheFile)
+    {
+        final File dir = cacheFile.getAbsoluteFile().getParentFile();
+        final TileCacheStore store;
+        synchronized (cacheStores) {
+            TileCacheStore found = cacheStores.get(dir);
+            if (found == null) {
+                found = new TileCacheStore(dir);
+                cacheStores.put(dir, found);
+            }
+            store = found;
+        }
+        store.setMaxSize(cacheSizeLimit);
+        store.setLifetime(cacheLifetime);
+        return store;
+    }
+
     protected void finishTile(TileInfo inTile)
     {
         // Make sure we still want it
@@ -743,8 +1029,7 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
                     }
                     if (tile == null)
                         continue;
-                    if (tile.task != null)
-                        tile.task.cancel();
+                    cancelFetch(tile);
                     tile.state = TileInfoState.None;
                     synchronized (toLoad) {
                         toLoad.remove(tile);
@@ -777,5 +1062,10 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
         synchronized (tilesByFetchRequest) {
             tilesByFetchRequest.clear();
         }
+        synchronized (sharedFetches) {
+            for (SharedFetch fetch : sharedFetches.values())
+                fetch.call.cancel();
+            sharedFetches.clear();
+        }
     }
 }
@@ -660,6 +660,43 @@ public class RenderController implements RenderControllerInterface
         return compObj;
     }
 
+    /**
+     * Add a packed batch of screen markers to the display in one call.
+     *
+     * @param batch The markers to add.
+     * @param markerInfo How the markers should look.
+     * @param mode Where to execute the add.  Choose ThreadAny by default.
+     * @return This represents the screen markers for later modification or deletion.
+     */
+    public ComponentObject addScreenMarkers(final ScreenMarkerBatch batch,final MarkerInfo markerInfo,ThreadMode mode)
+    {
+        final ComponentObject compObj = componentManager.makeComponentObject();
+
+        taskMan.addTask(() -> {
+            if (!running) {
+                return;
+            }
+            ChangeSet changes = new ChangeSet();
+
+            int priority = markerInfo.getDrawPriority();
+            if (priority <= 0) {
+                priority = LabelDrawPriorityDefault;
+            }
+            markerInfo.setDrawPriority(priority + screenObjectDrawPriorityOffset);
+
+            long markerId = markerManager.addScreenMarkers(batch, markerInfo, changes);
+            if (markerId != EmptyIdentity)
+            {
+                compObj.addMarkerID(markerId);
+            }
+
+            componentManager.addComponentObject(compObj, changes);
+            processChangeSet(changes);
+        }, mode);
+
+        return compObj;
+    }
+
     /**
      * Add moving screen markers to the visual display.  These are the same as the regular
      * screen markers, but they have a start and end point and a duration.
@@ -821,6 +858,45 @@ public class RenderController implements RenderControllerInterface
         return compObj;
     }
 
+    /**
+     * Add a packed batch of screen labels to the display in one call.
+     *
+     * @param batch Labels to add to the display.
+     * @param labelInfo The visual appearance of the labels.
+     * @param mode Where to execute the add.  Choose ThreadAny by default.
+     * @return This represents the labels for modification or deletion.
+     */
+    public ComponentObject addScreenLabels(final ScreenLabelBatch batch,final LabelInfo labelInfo,ThreadMode mode)
+    {
+        final ComponentObject compObj = componentManager.makeComponentObject();
+        final LabelManager labelManager = this.labelManager;
+
+        taskMan.addTask(() -> {
+            if (!running) {
+                return;
+            }
+            ChangeSet changes = new ChangeSet();
+
+            if (labelInfo.getDrawPriority() <= 0) {
+                labelInfo.setDrawPriority(LabelDrawPriorityDefault);
+            }
+
+            long labelId;
+            // One at a time, as with the other labels, for the CharRenderer callback
+            synchronized (labelManager) {
+                labelId = labelManager.addScreenLabels(batch, labelInfo, changes);
+            }
+            if (labelId != EmptyIdentity) {
+                compObj.addLabelID(labelId);
+            }
+
+            componentManager.addComponentObject(compObj, changes);
+            processChangeSet(changes);
+        }, mode);
+
+        return compObj;
+    }
+
     /**
      * Add screen labels to the display.  Screen labels are 2D labels that float above the 3D geometry
      * and stay fixed in size no matter how the user zoom in or out.  Their visual appearance is controlled
@@ -1645,6 +1721,7 @@ public class RenderController implements RenderControllerInterface
                 renderTarget.clearEveryFrame,
                 renderTarget.clearVal,
                 renderTarget.blend,
+                renderTarget.renderWhenChanged,
                 Color.red(renderTarget.color)/255.f,Color.green(renderTarget.color)/255.f,Color.blue(renderTarget.color)/255.f,Color.alpha(renderTarget.color)/255.f);
     }
 
@@ -1986,6 +2063,26 @@ public class RenderController implements RenderControllerInterface
         return bitmap;
     }
 
+    /**
+     * Draw until everything handed to the scene has been merged in, or the timeout
+     * passes, then render to a Bitmap.  This is the one to use for static maps.
+     * You should have already set the context at this point
+     */
+    public Bitmap renderToBitmapWhenLoaded(double timeout) {
+        settleNative(timeout);
+        return renderToBitmap();
+    }
+
+    /**
+     * Draw until loading settles, then time a run of frames.
+     * Returns JSON with the time for each frame, summaries of the frame stats
+     * and the memory in use afterward.
+     * You should have already set the context at this point
+     */
+    public String runOfflineBenchmark(int frames, double settleTimeout) {
+        return runOfflineBenchmarkNative(frames, settleTimeout);
+    }
+
     private boolean running = true;
 
     public boolean isRunning() {
@@ -1994,6 +2091,11 @@ public class RenderController implements RenderControllerInterface
 
     public native void setScene(Scene scene);
     public native void setupShadersNative();
+    /**
+     * Keep linked shader programs in this directory so later runs can skip compiling them.
+     * Set it before the shaders are built.  Null turns it off.
+     */
+    public static native void setShaderCacheDir(String dir);
     public native void setViewNative(View view);
     public native void setClearColor(float r,float g,float b,float a);
     private native boolean teardownNative();
@@ -2001,9 +2103,206 @@ public class RenderController implements RenderControllerInterface
     protected native void render();
     protected native boolean hasChanges();
     public native void setPerfInterval(int perfInterval);
+
+    /**
+     * How hard the renderer tries to keep the frame rate up.
+     * <p>
+     * Full renders at the display rate whenever anything changes.
+     * Balanced keeps the full rate for view motion, but runs fades and other
+     * animation at up to 60fps and tile loading at 30fps.
+     * LowPower caps motion at 60fps and everything else at 30fps.
+     */
+    public enum FramePacing {Full,Balanced,LowPower}
+
+    /**
+     * Set the frame pacing mode.  Full is the default.
+     */
+    public void setFramePacing(FramePacing pacing)
+    {
+        setFramePacingNative(pacing.ordinal());
+    }
+
+    public FramePacing getFramePacing()
+    {
+        final int mode = getFramePacingNative();
+        final FramePacing[] vals = FramePacing.values();
+        return (mode >= 0 && mode < vals.length) ? vals[mode] : FramePacing.Full;
+    }
+
+    private native void setFramePacingNative(int mode);
+    private native int getFramePacingNative();
+
+    /**
+     * The fastest we'll be asked to render, in frames per second.
+     * This is the display refresh rate divided by the frame interval.
+     */
+    public native void setDisplayFrameRate(int fps);
+
+    /**
+     * Draw the map at less than full resolution while the view is moving and
+     * frames are taking too long, then go back to full resolution once it stops.
+     * Labels, markers and other screen space objects stay at full resolution.
+     * Scales are fractions of the screen size.  Off by default.
+     * Needs OpenGL ES 3.  Where the driver has GL_EXT_disjoint_timer_query,
+     * the GPU time for each frame decides, otherwise the time between frames.
+     */
+    public native void setDynamicResolution(boolean enable, float minScale, float maxScale);
+
+    /**
+     * The fraction of the screen resolution we're drawing the map at right now.
+     */
+    public native float getDynamicResolutionScale();
+
+    /**
+     * Limit how much of each frame goes to applying changes from the layer threads.
+     * Once either limit is reached, everything but high priority changes waits for
+     * the next frame.  Zero turns a limit off.  The default has no limits.
+     *
+     * @param maxTime Seconds of change processing per frame.
+     * @param maxBytes Bytes of texture and buffer uploads per frame.
+     */
+    public native void setChangeBudget(double maxTime, long maxBytes);
+
+    /**
+     * Distribution of one per-frame metric over the recorded frames.
+     * Times are in seconds.
+     */
+    public static class FrameStat {
+        public String name;
+        public int count;
+        public double min, max, mean, p50, p95, p99;
+    }
+
+    /**
+     * Turn per-frame stats collection on or off.
+     * The renderer keeps the last several hundred frames.
+     */
+    public native void setFrameStatsEnabled(boolean enable);
+    public native boolean getFrameStatsEnabled();
+
+    /**
+     * Discard the recorded per-frame stats.
+     */
+    public native void clearFrameStats();
+
+    /**
+     * Summarize the recorded per-frame stats, one entry per metric.
+     * Returns null if nothing has been recorded.
+     */
+    public FrameStat[] getFrameStats() {
+        return makeFrameStats(getFrameStatNames(), getFrameStatValues());
+    }
+
+    private static native String[] getFrameStatNames();
+    private native double[] getFrameStatValues();
+
+    /**
+     * Turn GPU timing on or off.
+     * When on, the renderer uses timer queries to see how long the GPU spends on
+     * offscreen targets and on the screen.  The device needs GL_EXT_disjoint_timer_query,
+     * otherwise nothing gets recorded.
+     */
+    public native void setGPUTimingsEnabled(boolean enable);
+    public native boolean getGPUTimingsEnabled();
+
+    /**
+     * Discard the recorded GPU times.
+     */
+    public native void clearGPUTimings();
+
+    /**
+     * Summarize the recorded GPU times, one entry per phase ("offscreen", "screenRender", "total", ...).
+     * Results come back from the GPU a frame or two late.
+     * Returns null if nothing has been recorded.
+     */
+    public FrameStat[] getGPUTimings() {
+        return makeFrameStats(getGPUTimingNames(), getGPUTimingValues());
+    }
+
+    private static native String[] getGPUTimingNames();
+    private native double[] getGPUTimingValues();
+
+    // Seven values per name, see the JNI side
+    private static FrameStat[] makeFrameStats(String[] names, double[] vals) {
+        if (names == null || vals == null || vals.length < names.length * 7) {
+            return null;
+        }
+        FrameStat[] stats = new FrameStat[names.length];
+        for (int ii = 0; ii < names.length; ii++) {
+            FrameStat stat = new FrameStat();
+            stat.name = names[ii];
+            stat.count = (int)vals[ii*7];
+            stat.min = vals[ii*7+1];
+            stat.max = vals[ii*7+2];
+            stat.mean = vals[ii*7+3];
+            stat.p50 = vals[ii*7+4];
+            stat.p95 = vals[ii*7+5];
+            stat.p99 = vals[ii*7+6];
+            stats[ii] = stat;
+        }
+        return stats;
+    }
+
+    /**
+     * One startup phase, in seconds from when the renderer was created.
+     * Marks like "first frame" start and end at the same time.
+     * Phases that haven't finished have an end of -1.
+     */
+    public static class StartupPhase {
+        public String name;
+        public double start, end;
+    }
+
+    /**
+     * Startup phases, through to the first frame that drew something.
+     * The phases are also written to the log once that frame is drawn.
+     */
+    public StartupPhase[] getStartupTimings() {
+        final String[] names = getStartupPhaseNames();
+        final double[] times = getStartupPhaseTimes();
+        if (names == null || times == null || times.length < names.length * 2) {
+            return new StartupPhase[0];
+        }
+        StartupPhase[] phases = new StartupPhase[names.length];
+        for (int ii = 0; ii < names.length; ii++) {
+            StartupPhase phase = new StartupPhase();
+            phase.name = names[ii];
+            phase.start = times[ii*2];
+            phase.end = times[ii*2+1];
+            phases[ii] = phase;
+        }
+        return phases;
+    }
+
+    private native String[] getStartupPhaseNames();
+    private native double[] getStartupPhaseTimes();
+
+    /**
+     * Opt in to the fast startup path.  Set this before any loaders start.
+     * Image loaders then draw the low levels they have in place of tiles that are still loading.
+     */
+    public native void setFastStartup(boolean fastStartup);
+    public native boolean getFastStartup();
+
+    /**
+     * Record trace zones into per-thread buffers, for all renderers.
+     */
+    public static native void setTraceRecording(boolean record);
+
+    /**
+     * Pass trace zones through to ATrace.
+     */
+    public static native void setSystemTracing(boolean trace);
+
+    /**
+     * Recorded trace zones as Chrome trace event JSON.
+     */
+    public static native String getTraceJSON();
     public native void addLight(DirectionalLight light);
     public native void replaceLights(DirectionalLight[] lights);
     protected native void renderToBitmapNative(Bitmap outBitmap);
+    private native boolean settleNative(double timeout);
+    private native String runOfflineBenchmarkNative(int frames, double settleTimeout);
 
     private int screenObjectDrawPriorityOffset = 1000000;
     public int getScreenObjectDrawPriorityOffset() { return screenObjectDrawPriorityOffset; }
@@ -48,6 +48,14 @@ public class RenderTarget
      */
     public boolean blend = false;
 
+    /**
+     * If set, we only draw into the render target when something drawn there changes,
+     * something in it animates or the view moves.  Otherwise what's there is left from last time.
+     * Turn it off for shaders that change every frame without asking for continuous rendering.
+     * True by default.
+     */
+    public boolean renderWhenChanged = true;
+
     public RenderTarget()
     {
         renderTargetID = Identifiable.genID();
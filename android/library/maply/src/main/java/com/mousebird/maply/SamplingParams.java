@@ -152,6 +152,41 @@ public class SamplingParams
      */
     public native boolean getEdgeMatching();
 
+    /**
+     * If set, tiles on a flat map are built from one precomputed grid and
+     * sized by their transform.  Quicker to build each tile.
+     * Has no effect on the globe.  Off by default.
+     */
+    public native void setMeshTemplates(boolean meshTemplates);
+
+    /**
+     * Set if tiles on a flat map are built from template meshes.
+     */
+    public native boolean getMeshTemplates();
+
+    /**
+     * If set, tiles on the globe are raised to the heights loaded through
+     * an ElevationInterpreter.  Tiles built before their heights arrive
+     * stay flat.  Off by default.
+     */
+    public native void setIncludeElev(boolean includeElev);
+
+    /**
+     * Set if tiles take their heights from loaded elevation.
+     */
+    public native boolean getIncludeElev();
+
+    /**
+     * Set if tiles are raised in the shader from elevation textures.
+     * A terrain frame loader turns this on.  Flat maps get skirts as well.
+     */
+    public native void setElevTextures(boolean elevTextures);
+
+    /**
+     * Set if tiles are raised in the shader from elevation textures.
+     */
+    public native boolean getElevTextures();
+
     /**
      * Each tile will be tesselated into a given number of X and Y grid
      * points.
@@ -187,6 +222,42 @@ public class SamplingParams
      */
     public native boolean getSingleLevel();
 
+    /**
+     * If set, tile importance from earlier view updates is reused where
+     * the view hasn't moved enough to matter.  Cheaper while panning,
+     * but the ordering of tiles is approximate.  Off by default.
+     */
+    public native void setIncrementalCoverage(boolean incremental);
+
+    /**
+     * True if we're reusing tile importance between view updates.
+     */
+    public native boolean getIncrementalCoverage();
+
+    /**
+     * Memory, in bytes, used to keep the tile volumes we evaluate against the view.
+     * Those don't change as the view moves, so keeping them saves work.
+     * 2MB by default, 0 turns it off.
+     */
+    public native void setDisplaySolidCacheSize(int size);
+
+    /**
+     * Memory used for keeping tile volumes around, in bytes.
+     */
+    public native int getDisplaySolidCacheSize();
+
+    /**
+     * Memory budget, in bytes, for tile textures and geometry shared by all the samplers.
+     * When everything wanted won't fit, the least important tiles are left out,
+     * whichever layer they belong to.  0, the default, means no budget.
+     */
+    public static native void setTileMemoryBudget(long bytes);
+
+    /**
+     * Shared memory budget for tiles, in bytes.  0 if there isn't one.
+     */
+    public static native long getTileMemoryBudget();
+
     /**
      * Detail the levels you want loaded in target level mode.
      * The layer calculates the optimal target level.
@@ -1,5 +1,7 @@
 package com.mousebird.maply;
 
+import android.content.ComponentCallbacks2;
+
 import androidx.annotation.Keep;
 
 /**
@@ -36,7 +38,7 @@ public class Scene
 	public native void addShaderProgram(Shader shader);
 	public native void removeShaderProgram(long shaderID);
 
-	public native void addRenderTargetNative(long renderTargetID,int width,int height,long texID,boolean clearEveryFrame,float clearVal,boolean blend,float red,float green,float blue,float alpha);
+	public native void addRenderTargetNative(long renderTargetID,int width,int height,long texID,boolean clearEveryFrame,float clearVal,boolean blend,boolean renderWhenChanged,float red,float green,float blue,float alpha);
 	public native void changeRenderTarget(long renderTargetID,long texID);
 	public native void removeRenderTargetNative(long renderTargetID);
 
@@ -52,6 +54,139 @@ public class Scene
 	 */
 	public native void teardownGL();
 
+	/**
+	 * Keep rendered label glyphs in this directory so they don't have to be rendered
+	 * again in later runs.  Only fonts with a name set in their LabelInfo are cached.
+	 * Pass null to turn it off.
+	 */
+	public native void setGlyphCacheDir(String dir);
+
+	/**
+	 * Render label glyphs as signed distance fields.  Each font is rendered once at a fixed
+	 * size and the shader scales it, so labels stay sharp at any size.  Labels with outlines
+	 * or their own shader are rendered as before.  Applies to labels added after this.
+	 */
+	public native void setLabelSDF(boolean enable);
+
+	/**
+	 * Release label glyph texture pages as they empty out and fold sparsely used ones
+	 * together.  Useful for long sessions with a lot of labels coming and going.
+	 */
+	public native void setLabelAtlasCompaction(boolean enable);
+
+	/** Drop decode buffers, parsed tile and label layout caches. */
+	public static final int TrimCaches = 1;
+	/** Also hold tile loaders to less than they have for a while, least important tiles first. */
+	public static final int TrimOffscreenTiles = 2;
+	/** Also repack the label glyph textures. */
+	public static final int TrimAtlasPages = 3;
+
+	/** Indices into the array returned by getMemoryUsage() */
+	public static final int MemTextures = 0;
+	public static final int MemVertexBuffers = 1;
+	public static final int MemAtlases = 2;
+	public static final int MemCaches = 3;
+	public static final int MemParsedTiles = 4;
+
+	/**
+	 * Bytes in use by category, indexed by MemTextures and the rest.
+	 * Textures and vertex buffers are the scene's drawables and textures, as the ledger has them.
+	 */
+	public long[] getMemoryUsage() {
+		long[] usage = getMemoryUsageNative();
+		return (usage != null) ? usage : new long[MemParsedTiles + 1];
+	}
+
+	/**
+	 * Give back memory, in order, up to the given level (TrimCaches and so on).
+	 * Nothing on screen is torn down.
+	 */
+	public native void trimMemory(int level);
+
+	/**
+	 * Pass along the level from ComponentCallbacks2.onTrimMemory.
+	 */
+	public void onTrimMemory(int androidLevel) {
+		if (androidLevel >= ComponentCallbacks2.TRIM_MEMORY_COMPLETE ||
+			androidLevel == ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL) {
+			trimMemory(TrimAtlasPages);
+		} else if (androidLevel >= ComponentCallbacks2.TRIM_MEMORY_MODERATE ||
+				   androidLevel == ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW) {
+			trimMemory(TrimOffscreenTiles);
+		} else {
+			trimMemory(TrimCaches);
+		}
+	}
+
+	private native long[] getMemoryUsageNative();
+
+	/**
+	 * Look for a texture that already holds an image with the given content hash
+	 * (from Texture.getContentHash).  If there is one it gets another reference and
+	 * we return its ID, otherwise EmptyIdentity.
+	 */
+	native long retainSharedImage(long contentHash);
+
+	/**
+	 * Note that the given texture holds an image with the given content, with one reference.
+	 */
+	native void addSharedImage(long contentHash,long texID);
+
+	/**
+	 * Drop a reference to a shared image.  Returns true if that was the last one,
+	 * in which case the texture should be removed.
+	 */
+	native boolean releaseSharedImage(long texID);
+
+	/**
+	 * Drawables and textures held for one owner or type, and what they take up.
+	 */
+	public static class MemoryEntry {
+		public String name;
+		public long count;
+		public long cpuBytes, gpuBytes;
+	}
+
+	/**
+	 * Memory held by the drawables and textures in the scene, by owner.
+	 * The owner is the name the manager or loader gave them, such as "Vector Layer".
+	 * These are kept up to date as things are added and removed, so they're cheap to
+	 * poll.  A count that only goes up is a good sign of a leak.
+	 */
+	public MemoryEntry[] getMemoryByOwner() {
+		return makeMemoryEntries(getMemoryLedgerNative(false));
+	}
+
+	/**
+	 * The same, by type: "basic", "instance", "screenSpace", "particles", "texture" and "dynamicTexture".
+	 */
+	public MemoryEntry[] getMemoryByType() {
+		return makeMemoryEntries(getMemoryLedgerNative(true));
+	}
+
+	private static MemoryEntry[] makeMemoryEntries(Object[] ledger) {
+		if (ledger == null || ledger.length < 2) {
+			return new MemoryEntry[0];
+		}
+		final String[] names = (String[])ledger[0];
+		final long[] vals = (long[])ledger[1];
+		if (names == null || vals == null || vals.length < names.length * 3) {
+			return new MemoryEntry[0];
+		}
+		MemoryEntry[] entries = new MemoryEntry[names.length];
+		for (int ii = 0; ii < names.length; ii++) {
+			MemoryEntry entry = new MemoryEntry();
+			entry.name = names[ii];
+			entry.count = vals[ii*3];
+			entry.cpuBytes = vals[ii*3+1];
+			entry.gpuBytes = vals[ii*3+2];
+			entries[ii] = entry;
+		}
+		return entries;
+	}
+
+	private native Object[] getMemoryLedgerNative(boolean byType);
+
 	// Used to render individual characters using Android's Canvas/Paint/Typeface
 	protected final CharRenderer charRenderer = new CharRenderer();
 
@@ -0,0 +1,74 @@
+/*  ScreenLabelBatch.java
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package com.mousebird.maply;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * A lot of screen labels, with their locations and importance packed into direct buffers.
+ * <br>
+ * The whole batch goes over to the native side in one call, rather than as one Java
+ * object per label.  How they look comes from the LabelInfo.
+ * Text is split into lines at newlines, as with ScreenLabel.
+ * <br>
+ * The labels can't be selected.  Use ScreenLabel for that.
+ * The batch is read on the layer thread, so leave it alone once it's been added.
+ */
+public class ScreenLabelBatch
+{
+    /**
+     * Make room for the given number of labels.
+     */
+    public ScreenLabelBatch(int capacity)
+    {
+        texts = new String[capacity];
+        locs = ByteBuffer.allocateDirect(capacity * 2 * 8).order(ByteOrder.nativeOrder());
+        importance = ByteBuffer.allocateDirect(capacity * 4).order(ByteOrder.nativeOrder());
+    }
+
+    /**
+     * Add a label at the end.
+     *
+     * @param lon Longitude in radians.
+     * @param lat Latitude in radians.
+     * @param text What it says.
+     * @param layoutImportance Importance for the layout engine.  Float.MAX_VALUE to use the LabelInfo's.
+     * @return Where the label is in the batch.
+     */
+    public int add(double lon,double lat,String text,float layoutImportance)
+    {
+        if (count >= texts.length) {
+            throw new IndexOutOfBoundsException("ScreenLabelBatch is full");
+        }
+        final int which = count++;
+        texts[which] = text;
+        locs.putDouble(which * 16, lon).putDouble(which * 16 + 8, lat);
+        importance.putFloat(which * 4, layoutImportance);
+        return which;
+    }
+
+    /**
+     * Number of labels in the batch.
+     */
+    public int getCount() { return count; }
+
+    private int count = 0;
+    final String[] texts;
+    final ByteBuffer locs, importance;
+}
@@ -0,0 +1,111 @@
+/*  ScreenMarkerBatch.java
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package com.mousebird.maply;
+
+import androidx.annotation.ColorInt;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * A lot of screen markers, packed into direct buffers one array per field.
+ * <br>
+ * This is for adding tens of thousands of markers at once.  The whole batch goes over
+ * to the native side in one call, rather than one Java object per marker.
+ * Everything else about how the markers look comes from the MarkerInfo.
+ * <br>
+ * The markers can't be selected.  Use ScreenMarker for that.
+ * The buffers are read on the layer thread, so leave the batch alone once it's been added.
+ */
+public class ScreenMarkerBatch
+{
+    /**
+     * Make room for the given number of markers.
+     */
+    public ScreenMarkerBatch(int capacity)
+    {
+        this.capacity = capacity;
+        locs = allocate(capacity * 2 * 8);
+        sizes = allocate(capacity * 2 * 4);
+        texIDs = allocate(capacity * 8);
+        colors = allocate(capacity * 4);
+        importance = allocate(capacity * 4);
+    }
+
+    /**
+     * Add a marker at the end.
+     *
+     * @param lon Longitude in radians.
+     * @param lat Latitude in radians.
+     * @param width Width on the screen, in pixels.
+     * @param height Height on the screen, in pixels.
+     * @param texID Texture to show, or 0 for none.
+     * @param color Color to tint it with.
+     * @param layoutImportance Importance for the layout engine.  Float.MAX_VALUE to always show it.
+     * @return Where the marker is in the batch.
+     */
+    public int add(double lon,double lat,float width,float height,long texID,@ColorInt int color,float layoutImportance)
+    {
+        if (count >= capacity) {
+            throw new IndexOutOfBoundsException("ScreenMarkerBatch is full");
+        }
+        final int which = count++;
+        locs.putDouble(which * 16, lon).putDouble(which * 16 + 8, lat);
+        sizes.putFloat(which * 8, width).putFloat(which * 8 + 4, height);
+        texIDs.putLong(which * 8, texID);
+        colors.putInt(which * 4, color);
+        importance.putFloat(which * 4, layoutImportance);
+        return which;
+    }
+
+    /**
+     * Number of markers in the batch.
+     */
+    public int getCount() { return count; }
+
+    /**
+     * If you've filled in the buffers yourself, say how many markers are in them here.
+     */
+    public void setCount(int newCount)
+    {
+        if (newCount < 0 || newCount > capacity) {
+            throw new IndexOutOfBoundsException("ScreenMarkerBatch holds " + capacity + " markers");
+        }
+        count = newCount;
+    }
+
+    /// Longitude and latitude in radians, as doubles
+    public ByteBuffer getLocations() { return locs; }
+    /// Width and height in pixels, as floats
+    public ByteBuffer getSizes() { return sizes; }
+    /// One texture ID per marker, as longs
+    public ByteBuffer getTextureIDs() { return texIDs; }
+    /// One ARGB color per marker, as ints
+    public ByteBuffer getColors() { return colors; }
+    /// One layout importance per marker, as floats
+    public ByteBuffer getLayoutImportance() { return importance; }
+
+    private static ByteBuffer allocate(int bytes)
+    {
+        return ByteBuffer.allocateDirect(bytes).order(ByteOrder.nativeOrder());
+    }
+
+    private final int capacity;
+    private int count = 0;
+    final ByteBuffer locs, sizes, texIDs, colors, importance;
+}
@@ -54,6 +54,8 @@ public class Shader
 	public static final String DefaultTriScreenTexShader = "Default Triangle;screentex=yes;lighting=yes";
 	public static final String DefaultTriMultiTexShader = "Default Triangle;multitex=yes;lighting=yes";
 	public static final String DefaultTriMultiTexRampShader = "Default Triangle;multitex=yes;lighting=yes;ramp=yes";
+	public static final String DefaultTriCompositeShader = "Default Triangle;composite=yes;lighting=yes";
+	public static final String DefaultTriTerrainShader = "Default Triangle;terrain=yes;lighting=yes";
 	public static final String DefaultMarkerShader = "Default marker;multitex=yes;lighting=yes";
 	public static final String DefaultTriNightDayShader = "Default Triangle;nightday=yes;multitex=yes;lighting=yes";
 	public static final String BillboardGroundShader = "Default Billboard ground";
@@ -79,6 +79,33 @@ public class Sticker
 
     native void setTextureIDs(long[] texIDs);
 
+    /**
+     * Sampling parameters to stream a large image over the sticker's extents.
+     * <br>
+     * Images too big for a single texture can be cut into a tile pyramid and loaded
+     * a piece at a time.  This sets up sampling over just the sticker, with enough levels
+     * to reach full resolution.  Hand it to a QuadImageLoader along with a tile source
+     * for the pyramid, rather than adding the sticker itself, and only the visible tiles
+     * are loaded at the resolution the view needs.
+     * <br>
+     * Level 0 is the whole image in one tile.  The pyramid is anchored at the lower left,
+     * TMS style, so turn off flipY on the loader.  Tiles along the top and right are padded out to tileSize.
+     *
+     * @param imageWidth Width of the full resolution image in pixels.
+     * @param imageHeight Height of the full resolution image in pixels.
+     * @param tileSize Size of the square tiles the image has been cut into.
+     * @return The sampling parameters, or null for rotated stickers, which the tile geometry can't follow.
+     */
+    public SamplingParams makeTiledSamplingParams(int imageWidth,int imageHeight,int tileSize)
+    {
+        SamplingParams params = new SamplingParams();
+        if (!setupTiledSampling(params,imageWidth,imageHeight,tileSize))
+            return null;
+        return params;
+    }
+
+    native boolean setupTiledSampling(SamplingParams params,int imageWidth,int imageHeight,int tileSize);
+
     static
     {
         nativeInit();
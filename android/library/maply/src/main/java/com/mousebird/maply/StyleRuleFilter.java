@@ -0,0 +1,114 @@
+/*  StyleRuleFilter.java
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package com.mousebird.maply;
+
+/**
+ * Compiled feature filter for the SLD style set.
+ * <br>
+ * The parser describes a filter bottom up with the add methods, each of which
+ * hands back an index to build on (or -1 if it couldn't), then compiles from the root.
+ * Testing a feature then happens entirely on the native side, without building
+ * Java objects for each attribute.
+ */
+public class StyleRuleFilter
+{
+    // These match the StyleRuleOp values on the native side
+    public static final int All = 0;
+    public static final int Any = 1;
+    public static final int Not = 2;
+    public static final int Equal = 5;
+    public static final int NotEqual = 6;
+    public static final int Less = 7;
+    public static final int LessEqual = 8;
+    public static final int Greater = 9;
+    public static final int GreaterEqual = 10;
+
+    // These match the StyleExprType values
+    public static final int Add = 2;
+    public static final int Sub = 3;
+    public static final int Mul = 4;
+    public static final int Div = 5;
+
+    public StyleRuleFilter()
+    {
+        initialise();
+    }
+
+    /**
+     * An attribute by name.
+     */
+    public native int addAttr(String name);
+
+    /**
+     * A literal value, as text.  It'll compare as a number if it looks like one.
+     */
+    public native int addLiteral(String val);
+
+    /**
+     * Add, Sub, Mul or Div of two values.
+     */
+    public native int addArith(int type,int left,int right);
+
+    /**
+     * Compare two values with one of Equal, NotEqual, Less and so on.
+     */
+    public native int addCompare(int op,int left,int right,boolean matchCase);
+
+    /**
+     * True if the value is missing.
+     */
+    public native int addIsNull(int expr);
+
+    /**
+     * Pattern match a string value.
+     */
+    public native int addLike(int expr,String pattern,char wildCard,char singleChar,char escapeChar,boolean matchCase);
+
+    /**
+     * Inclusive numeric range check.
+     */
+    public native int addBetween(int expr,int lower,int upper);
+
+    /**
+     * All, Any or Not of the given tests.  Not takes exactly one.
+     */
+    public native int addLogical(int op,int[] tests);
+
+    /**
+     * Flatten everything under the given root.  Returns false if we can't.
+     */
+    public native boolean compile(int root);
+
+    /**
+     * Run the compiled filter against a feature's attributes.
+     */
+    public native boolean test(AttrDictionary attrs);
+
+    static
+    {
+        nativeInit();
+    }
+    public void finalize()
+    {
+        dispose();
+    }
+    private static native void nativeInit();
+    native void initialise();
+    native void dispose();
+    private long nativeHandle;
+}
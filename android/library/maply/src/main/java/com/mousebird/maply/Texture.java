@@ -75,6 +75,12 @@ class Texture
 	
 	// Once created, this is how we identify it to the rendering engine
 	public native long getID();
+
+	/**
+	 * Hash of the pixels, size and settings.  Textures with the same hash look the same.
+	 * Zero if there's nothing in it.
+	 */
+	public native long getContentHash();
 	
 	static
 	{
@@ -84,7 +84,17 @@ class TextureManager
 			if (!texture.setBitmap(theBitmap,MaplyImage4Layer8Bit.ordinal()))
 				return RenderController.EmptyIdentity;
 			testWrapper.refs = 1;
+
+			// A different bitmap with the same pixels can use the same texture
+			long contentHash = texture.getContentHash();
+			long sharedID = scene.retainSharedImage(contentHash);
+			if (sharedID != RenderController.EmptyIdentity) {
+				testWrapper.texID = sharedID;
+				textures.add(testWrapper);
+				return sharedID;
+			}
 			testWrapper.texID = texture.getID();
+			scene.addSharedImage(contentHash, testWrapper.texID);
 
 			// After we call addTexture it's no longer ours to play with
 			changes.addTexture(texture, scene, 1);
@@ -98,15 +108,16 @@ class TextureManager
 	 * Look for the given texture ID, decrementing its reference count or removing it.
 	 * @param texID
 	 */
-	void removeTexture(long texID, ChangeSet changes)
+	void removeTexture(long texID, Scene scene, ChangeSet changes)
 	{
 		synchronized (this) {
 			for (TextureWrapper texWrap : textures) {
 				if (texWrap.texID == texID) {
 					texWrap.refs--;
-					// Remove the texture
+					// Remove the texture, unless another bitmap is sharing it
 					if (texWrap.refs <= 0) {
-						changes.removeTexture(texWrap.texID);
+						if (scene.releaseSharedImage(texWrap.texID))
+							changes.removeTexture(texWrap.texID);
 						textures.remove(texWrap);
 					}
 
@@ -0,0 +1,89 @@
+/*
+ *  TileCacheStore.java
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+package com.mousebird.maply;
+
+import java.io.File;
+
+/**
+ * Cache of fetched tiles packed into a few files in a directory, rather than a file per tile.
+ * <br>
+ * Tiles are appended to pack files and looked up through an index, which is much
+ * faster than the file system once there are a lot of them.  Objects for the same
+ * directory share the same underlying cache.
+ */
+public class TileCacheStore
+{
+    /**
+     * Open the cache in the given directory, creating it if need be.
+     */
+    public TileCacheStore(File dir) {
+        initialise(dir.getPath());
+    }
+
+    /**
+     * True if we have the tile and it's not too old.
+     */
+    public native boolean contains(String key);
+
+    /**
+     * Data for a tile, or null if we don't have it.
+     */
+    public native byte[] find(String key);
+
+    /**
+     * Save a tile, replacing what was there.
+     */
+    public native boolean add(String key,byte[] data);
+
+    /**
+     * Forget about a tile.
+     */
+    public native void remove(String key);
+
+    /**
+     * The most space (in bytes) the cache will take up.  0 for no limit.
+     * Past that, the least recently used tiles are thrown out.
+     */
+    public native void setMaxSize(long size);
+
+    /**
+     * Tiles written longer ago than this (in seconds) are treated as missing.  0 for forever.
+     */
+    public native void setLifetime(double lifetime);
+
+    /**
+     * Space the cache is currently using.
+     */
+    public native long getSize();
+
+    public void finalize()
+    {
+        dispose();
+    }
+
+    static
+    {
+        nativeInit();
+    }
+    private static native void nativeInit();
+    native void initialise(String dir);
+    native void dispose();
+    protected long nativeHandle;
+}
@@ -0,0 +1,93 @@
+/*
+ *  TileFetchThrottle.java
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+package com.mousebird.maply;
+
+/**
+ * Works out how many fetches to have going at once to each host.
+ * <br>
+ * We keep track of how fast each host answers and how much data comes back.
+ * When more connections aren't getting more data the requests are just waiting
+ * at the server, so the host gets fewer.  Timeouts and overloaded responses cut
+ * it back right away.
+ */
+public class TileFetchThrottle
+{
+    /**
+     * Each host will get between the min and max connections.
+     */
+    public TileFetchThrottle(int minPerHost,int maxPerHost) {
+        initialise(minPerHost,maxPerHost);
+    }
+
+    /**
+     * Change the range of connections a host can get.
+     */
+    public native void setLimits(int minPerHost,int maxPerHost);
+
+    /**
+     * True if another fetch to the host can start now.
+     */
+    public native boolean canStart(String host);
+
+    /**
+     * A fetch to the host is underway.
+     */
+    public native void started(String host);
+
+    /**
+     * A fetch came back with an answer, taking the given time (in seconds) for the given bytes.
+     */
+    public native void finished(String host,double howLong,long size);
+
+    /**
+     * A fetch timed out or the host told us it was overloaded.
+     */
+    public native void failed(String host);
+
+    /**
+     * We stopped a fetch, so it doesn't tell us anything.
+     */
+    public native void cancelled(String host);
+
+    /**
+     * Connections the host is currently allowed.
+     */
+    public native int getLimit(String host);
+
+    /**
+     * Bytes per second we've been getting lately, across all the hosts.
+     * 0 until we've measured.
+     */
+    public native double getRate();
+
+    public void finalize()
+    {
+        dispose();
+    }
+
+    static
+    {
+        nativeInit();
+    }
+    private static native void nativeInit();
+    native void initialise(int minPerHost,int maxPerHost);
+    native void dispose();
+    protected long nativeHandle;
+}
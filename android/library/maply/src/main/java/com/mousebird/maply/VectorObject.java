@@ -22,6 +22,7 @@ import androidx.annotation.Nullable;
 
 import org.jetbrains.annotations.NotNull;
 
+import java.nio.ByteBuffer;
 import java.util.Map;
 
 /**
@@ -136,6 +137,28 @@ public class VectorObject implements Iterable<VectorObject>
      */
 	public native boolean addAreal(Point2d[] ext, Point2d[][] holes);
 
+	/**
+	 * Add a linear feature from a direct buffer of X,Y doubles in native byte order,
+	 * from its position to its limit.  The points are read straight out of the buffer.
+	 * @return false if the buffer isn't direct.
+	 */
+	public boolean addLinear(@NotNull ByteBuffer pts) {
+		return pts.isDirect() && addLinearDirect(pts, pts.position(), pts.remaining());
+	}
+
+	/**
+	 * Add an areal feature from a direct buffer of X,Y doubles in native byte order.
+	 * @param pts All the loops end to end, the exterior one first.
+	 * @param loopSizes Number of points in each loop.  If null, it's all one loop.
+	 * @return false if the buffer isn't direct or the sizes don't add up.
+	 */
+	public boolean addAreal(@NotNull ByteBuffer pts, @Nullable int[] loopSizes) {
+		return pts.isDirect() && addArealDirect(pts, pts.position(), pts.remaining(), loopSizes);
+	}
+
+	private native boolean addLinearDirect(ByteBuffer pts, int offset, int len);
+	private native boolean addArealDirect(ByteBuffer pts, int offset, int len, int[] loopSizes);
+
 	/**
 	 * Merge the vectors from the other vector object into this one.
 	 */
@@ -91,6 +91,13 @@ public class VectorTileData
      */
     public native void addComponentObjects(ComponentObject[] compObjs);
 
+    /**
+     * Hand all our component objects over to the loader return, the "overlay" category
+     * as overlays and the rest as regular objects.  This stays on the native side,
+     * with no Java objects made for them.
+     */
+    public native void addComponentObjectsTo(LoaderReturn loadReturn);
+
     /**
      * Return any changes put into the change set rather than ComponentObjects.
      */
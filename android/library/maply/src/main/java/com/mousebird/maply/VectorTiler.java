@@ -0,0 +1,162 @@
+/*
+ *  VectorTiler.java
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+package com.mousebird.maply;
+
+import androidx.annotation.NonNull;
+
+import java.lang.ref.WeakReference;
+import java.util.ArrayList;
+import java.util.TreeMap;
+
+/**
+ * Cuts up a big set of vectors into tiles on the fly and styles them as a loader asks for them.
+ * <br>
+ * Rather than building everything into one huge set of drawables, hand the vectors to this
+ * and use it as the interpreter for a QuadPagingLoader.  Each tile gets the features clipped
+ * to it and simplified for its level, so only what's visible gets built.
+ * <br>
+ * Set the zoom and tolerance values before adding any vectors.
+ */
+public class VectorTiler implements LoaderInterpreter
+{
+	private final VectorStyleInterface styleInterface;
+	private final WeakReference<RenderControllerInterface> control;
+	private boolean started = false;
+
+	/**
+	 * Deepest level we'll make tiles for.  Past this the loader should overzoom.
+	 */
+	public int maxZoom = 14;
+
+	/**
+	 * Levels we split everything down to up front.
+	 */
+	public int indexMaxZoom = 5;
+
+	/**
+	 * Tiles with fewer points than this aren't split up front, only when asked for.
+	 */
+	public int indexMaxPoints = 100000;
+
+	/**
+	 * How far a simplified line can stray, in pixels.
+	 */
+	public double tolerance = 3.0;
+
+	/**
+	 * Extra around the edges of a tile to include, in pixels.
+	 */
+	public double buffer = 16.0;
+
+	/**
+	 * Construct with the styles to apply and the controller to build into.
+	 */
+	public VectorTiler(VectorStyleInterface inStyleInterface,RenderControllerInterface inControl)
+	{
+		styleInterface = inStyleInterface;
+		control = new WeakReference<>(inControl);
+	}
+
+	/**
+	 * Add vectors to the data set.  Do this before the loader starts asking for tiles.
+	 */
+	public void addVectors(VectorObject vecObj)
+	{
+		if (!started) {
+			initialise(maxZoom,indexMaxZoom,indexMaxPoints,tolerance,buffer);
+			started = true;
+		}
+		addVectorsNative(vecObj);
+	}
+
+	public void setLoader(QuadLoaderBase loader) {
+	}
+
+	/**
+	 * Style and build whatever lands in the tile.
+	 */
+	public void dataForTile(LoaderReturn loadReturn,QuadLoaderBase loader)
+	{
+		RenderControllerInterface theControl = control.get();
+		if (theControl == null || !started)
+			return;
+
+		TileID tileID = loadReturn.getTileID();
+		VectorObject[] features = getTile(tileID.x,tileID.y,tileID.level);
+		if (features == null || features.length == 0 || loadReturn.isCanceled())
+			return;
+
+		// Build each style in one go, in a consistent order
+		TreeMap<Long, ArrayList<VectorObject>> featureStyles = new TreeMap<>();
+		for (VectorObject vecObj : features) {
+			VectorStyle[] styles = styleInterface.stylesForFeature(vecObj.getAttributes(), tileID, "", theControl);
+			if (styles == null)
+				continue;
+			for (VectorStyle style : styles) {
+				ArrayList<VectorObject> featuresForStyle = featureStyles.get(style.getUuid());
+				if (featuresForStyle == null) {
+					featuresForStyle = new ArrayList<>();
+					featureStyles.put(style.getUuid(), featuresForStyle);
+				}
+				featuresForStyle.add(vecObj);
+			}
+		}
+
+		VectorTileData tileData = new VectorTileData(tileID, loader.boundsForTile(tileID), loader.geoBoundsForTile(tileID));
+		for (Long uuid : featureStyles.keySet()) {
+			if (loadReturn.isCanceled())
+				return;
+			VectorStyle style = styleInterface.styleForUUID(uuid, theControl);
+			if (style != null)
+				style.buildObjects(featureStyles.get(uuid).toArray(new VectorObject[0]), tileData, theControl);
+		}
+
+		ComponentObject[] compObjs = tileData.getComponentObjects();
+		if (compObjs != null && compObjs.length > 0)
+			loadReturn.addComponentObjects(compObjs);
+	}
+
+	/**
+	 * Nothing to clean up, the loader takes care of the objects.
+	 */
+	@Override
+	public void tilesUnloaded(@NonNull TileID[] ids) {
+	}
+
+	/**
+	 * Features in the given tile, with pieces of the same feature put back together.
+	 */
+	native VectorObject[] getTile(int x,int y,int level);
+
+	native void addVectorsNative(VectorObject vecObj);
+
+	static
+	{
+		nativeInit();
+	}
+	public void finalize() {
+		dispose();
+	}
+	private static native void nativeInit();
+	native void initialise(int maxZoom,int indexMaxZoom,int indexMaxPoints,double tolerance,double buffer);
+	native void dispose();
+
+	private long nativeHandle;
+}
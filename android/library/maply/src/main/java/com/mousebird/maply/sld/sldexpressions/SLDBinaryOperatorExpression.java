@@ -21,6 +21,7 @@ package com.mousebird.maply.sld.sldexpressions;
 
 
 import com.mousebird.maply.AttrDictionary;
+import com.mousebird.maply.StyleRuleFilter;
 import com.mousebird.maply.sld.sldstyleset.SLDParseHelper;
 
 import org.xmlpull.v1.XmlPullParser;
@@ -105,6 +106,21 @@ public class SLDBinaryOperatorExpression extends SLDExpression {
         return null;
     }
 
+    public int addToRuleFilter(StyleRuleFilter filter) {
+        if (leftExpression == null || rightExpression == null || expressionType == null)
+            return -1;
+        int type;
+        if (expressionType == ExpressionType.ExpressionTypeAdd)
+            type = StyleRuleFilter.Add;
+        else if (expressionType == ExpressionType.ExpressionTypeSub)
+            type = StyleRuleFilter.Sub;
+        else if (expressionType == ExpressionType.ExpressionTypeMul)
+            type = StyleRuleFilter.Mul;
+        else
+            type = StyleRuleFilter.Div;
+        return filter.addArith(type, leftExpression.addToRuleFilter(filter), rightExpression.addToRuleFilter(filter));
+    }
+
     public static boolean matchesElementNamed(String elementName) {
         if (elementName.equals("Add"))
             return true;
@@ -20,6 +20,7 @@
 package com.mousebird.maply.sld.sldexpressions;
 
 import com.mousebird.maply.AttrDictionary;
+import com.mousebird.maply.StyleRuleFilter;
 
 import android.util.Log;
 
@@ -32,4 +33,12 @@ import android.util.Log;
 public abstract class SLDExpression {
 
     public abstract Object evaluateWithAttrs(AttrDictionary attrs);
+
+    /**
+     * Add this expression to a compiled filter.
+     * @return The index to build on, or -1 if it can't be compiled.
+     */
+    public int addToRuleFilter(StyleRuleFilter filter) {
+        return -1;
+    }
 }
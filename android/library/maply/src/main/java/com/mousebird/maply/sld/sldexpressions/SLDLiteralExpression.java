@@ -21,6 +21,7 @@ package com.mousebird.maply.sld.sldexpressions;
 
 
 import com.mousebird.maply.AttrDictionary;
+import com.mousebird.maply.StyleRuleFilter;
 
 import org.xmlpull.v1.XmlPullParser;
 import org.xmlpull.v1.XmlPullParserException;
@@ -58,6 +59,12 @@ public class SLDLiteralExpression extends SLDExpression {
         return literal;
     }
 
+    public int addToRuleFilter(StyleRuleFilter filter) {
+        if (literal == null)
+            return -1;
+        return filter.addLiteral(literal.toString());
+    }
+
     public static boolean matchesElementNamed(String elementName) {
         if (elementName.equals("Literal"))
             return true;
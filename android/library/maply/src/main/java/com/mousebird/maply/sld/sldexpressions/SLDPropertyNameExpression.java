@@ -21,6 +21,7 @@ package com.mousebird.maply.sld.sldexpressions;
 
 
 import com.mousebird.maply.AttrDictionary;
+import com.mousebird.maply.StyleRuleFilter;
 import com.mousebird.maply.sld.sldstyleset.SLDParseHelper;
 
 import org.xmlpull.v1.XmlPullParser;
@@ -55,6 +56,12 @@ public class SLDPropertyNameExpression extends SLDExpression {
         return attrs.get(propertyName);
     }
 
+    public int addToRuleFilter(StyleRuleFilter filter) {
+        if (propertyName == null)
+            return -1;
+        return filter.addAttr(propertyName);
+    }
+
     public static boolean matchesElementNamed(String elementName) {
         if (elementName.equals("PropertyName"))
             return true;
@@ -20,6 +20,7 @@
 package com.mousebird.maply.sld.sldoperators;
 
 import com.mousebird.maply.AttrDictionary;
+import com.mousebird.maply.StyleRuleFilter;
 
 import org.xmlpull.v1.XmlPullParser;
 import org.xmlpull.v1.XmlPullParserException;
@@ -109,6 +110,25 @@ public class SLDBinaryComparisonOperator extends SLDOperator {
         return false;
     }
 
+    public int addToRuleFilter(StyleRuleFilter filter) {
+        if (leftExpression == null || rightExpression == null || comparisonType == null)
+            return -1;
+        int op;
+        if (comparisonType == ComparisonType.EqualTo)
+            op = StyleRuleFilter.Equal;
+        else if (comparisonType == ComparisonType.NotEqualTo)
+            op = StyleRuleFilter.NotEqual;
+        else if (comparisonType == ComparisonType.LessThan)
+            op = StyleRuleFilter.Less;
+        else if (comparisonType == ComparisonType.GreaterThan)
+            op = StyleRuleFilter.Greater;
+        else if (comparisonType == ComparisonType.LessThanOrEqualTo)
+            op = StyleRuleFilter.LessEqual;
+        else
+            op = StyleRuleFilter.GreaterEqual;
+        return filter.addCompare(op, leftExpression.addToRuleFilter(filter), rightExpression.addToRuleFilter(filter), matchCase);
+    }
+
     public boolean evaluateWithAttrs(AttrDictionary attrs) {
 
         Object leftResult = leftExpression.evaluateWithAttrs(attrs);
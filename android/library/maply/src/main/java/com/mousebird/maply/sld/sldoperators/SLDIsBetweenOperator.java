@@ -20,6 +20,7 @@
 package com.mousebird.maply.sld.sldoperators;
 
 import com.mousebird.maply.AttrDictionary;
+import com.mousebird.maply.StyleRuleFilter;
 
 import org.xmlpull.v1.XmlPullParser;
 import org.xmlpull.v1.XmlPullParserException;
@@ -32,6 +33,7 @@ import android.util.Log;
 import com.mousebird.maply.sld.sldstyleset.SLDParseHelper;
 import com.mousebird.maply.sld.sldexpressions.SLDExpression;
 import com.mousebird.maply.sld.sldexpressions.SLDExpressionFactory;
+import com.mousebird.maply.sld.sldexpressions.SLDLiteralExpression;
 
 public class SLDIsBetweenOperator extends SLDOperator {
 
@@ -78,6 +80,24 @@ public class SLDIsBetweenOperator extends SLDOperator {
         return false;
     }
 
+    public int addToRuleFilter(StyleRuleFilter filter) {
+        if (subExpression == null || lowerBoundaryExpression == null || upperBoundaryExpression == null)
+            return -1;
+        // The compiled version only does numeric ranges, so leave string bounds to evaluateWithAttrs
+        if (!isNumericLiteral(lowerBoundaryExpression) || !isNumericLiteral(upperBoundaryExpression))
+            return -1;
+        return filter.addBetween(subExpression.addToRuleFilter(filter),
+                lowerBoundaryExpression.addToRuleFilter(filter),
+                upperBoundaryExpression.addToRuleFilter(filter));
+    }
+
+    private static boolean isNumericLiteral(SLDExpression expression) {
+        if (!(expression instanceof SLDLiteralExpression))
+            return false;
+        Object literal = ((SLDLiteralExpression)expression).getLiteral();
+        return (literal instanceof String) && SLDParseHelper.isStringNumeric((String)literal);
+    }
+
     public boolean evaluateWithAttrs(AttrDictionary attrs) {
 
         Object subExpressionResult = subExpression.evaluateWithAttrs(attrs);
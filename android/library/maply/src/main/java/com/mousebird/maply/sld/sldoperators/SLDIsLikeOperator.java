@@ -20,6 +20,7 @@
 package com.mousebird.maply.sld.sldoperators;
 
 import com.mousebird.maply.AttrDictionary;
+import com.mousebird.maply.StyleRuleFilter;
 
 import org.xmlpull.v1.XmlPullParser;
 import org.xmlpull.v1.XmlPullParserException;
@@ -50,6 +51,7 @@ public class SLDIsLikeOperator extends SLDOperator {
     private boolean matchCase;
 
     private Pattern pattern;
+    private String likePattern;
     private SLDPropertyNameExpression propertyExpression;
 
 
@@ -94,6 +96,7 @@ public class SLDIsLikeOperator extends SLDOperator {
             Object literalValueObj = literalExpression.getLiteral();
             if (literalValueObj instanceof String) {
                 String likeStr = (String)literalValueObj;
+                likePattern = likeStr;
 
                 String newLikeStr = new String();
                 int oldLen = likeStr.length();
@@ -131,6 +134,13 @@ public class SLDIsLikeOperator extends SLDOperator {
     }
 
 
+    public int addToRuleFilter(StyleRuleFilter filter) {
+        if (propertyExpression == null || likePattern == null)
+            return -1;
+        return filter.addLike(propertyExpression.addToRuleFilter(filter), likePattern,
+                wildCard.charAt(0), singleChar.charAt(0), escapeChar.charAt(0), matchCase);
+    }
+
     public boolean evaluateWithAttrs(AttrDictionary attrs) {
         Object propertyValueObj = propertyExpression.evaluateWithAttrs(attrs);
         if (!(propertyValueObj instanceof String))
@@ -20,6 +20,7 @@
 package com.mousebird.maply.sld.sldoperators;
 
 import com.mousebird.maply.AttrDictionary;
+import com.mousebird.maply.StyleRuleFilter;
 
 import org.xmlpull.v1.XmlPullParser;
 import org.xmlpull.v1.XmlPullParserException;
@@ -65,6 +66,12 @@ public class SLDIsNullOperator extends SLDOperator {
     }
 
 
+    public int addToRuleFilter(StyleRuleFilter filter) {
+        if (subExpression == null)
+            return -1;
+        return filter.addIsNull(subExpression.addToRuleFilter(filter));
+    }
+
     public boolean evaluateWithAttrs(AttrDictionary attrs) {
         if (subExpression != null)
             return (subExpression.evaluateWithAttrs(attrs) == null);
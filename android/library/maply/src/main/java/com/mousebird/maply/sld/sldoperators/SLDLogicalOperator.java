@@ -20,6 +20,7 @@
 package com.mousebird.maply.sld.sldoperators;
 
 import com.mousebird.maply.AttrDictionary;
+import com.mousebird.maply.StyleRuleFilter;
 
 import org.xmlpull.v1.XmlPullParser;
 import org.xmlpull.v1.XmlPullParserException;
@@ -78,6 +79,13 @@ public class SLDLogicalOperator extends SLDOperator {
         return false;
     }
 
+    public int addToRuleFilter(StyleRuleFilter filter) {
+        int[] subTests = new int[subOperators.size()];
+        for (int ii=0;ii<subTests.length;ii++)
+            subTests[ii] = subOperators.get(ii).addToRuleFilter(filter);
+        return filter.addLogical((logicType == LogicType.LogicTypeAnd) ? StyleRuleFilter.All : StyleRuleFilter.Any, subTests);
+    }
+
     public boolean evaluateWithAttrs(AttrDictionary attrs) {
         boolean result = true;
         if (logicType == LogicType.LogicTypeOr)
@@ -20,6 +20,7 @@
 package com.mousebird.maply.sld.sldoperators;
 
 import com.mousebird.maply.AttrDictionary;
+import com.mousebird.maply.StyleRuleFilter;
 
 import org.xmlpull.v1.XmlPullParser;
 import org.xmlpull.v1.XmlPullParserException;
@@ -63,6 +64,12 @@ public class SLDNotOperator extends SLDOperator {
     }
 
 
+    public int addToRuleFilter(StyleRuleFilter filter) {
+        if (subOperator == null)
+            return -1;
+        return filter.addLogical(StyleRuleFilter.Not, new int[]{subOperator.addToRuleFilter(filter)});
+    }
+
     public boolean evaluateWithAttrs(AttrDictionary attrs) {
         if (subOperator != null)
             return !subOperator.evaluateWithAttrs(attrs);
@@ -20,6 +20,7 @@
 package com.mousebird.maply.sld.sldoperators;
 
 import com.mousebird.maply.AttrDictionary;
+import com.mousebird.maply.StyleRuleFilter;
 
 import org.xmlpull.v1.XmlPullParser;
 import org.xmlpull.v1.XmlPullParserException;
@@ -40,4 +41,12 @@ abstract public class SLDOperator
 {
     public abstract boolean evaluateWithAttrs(AttrDictionary attrs);
 
+    /**
+     * Add this operator and everything under it to a compiled filter.
+     * @return The index to build on, or -1 if it can't be compiled.
+     */
+    public int addToRuleFilter(StyleRuleFilter filter) {
+        return -1;
+    }
+
 }
@@ -25,6 +25,8 @@ import org.xmlpull.v1.XmlPullParserException;
 import java.io.IOException;
 import java.io.InputStream;
 
+import com.mousebird.maply.AttrDictionary;
+import com.mousebird.maply.StyleRuleFilter;
 import com.mousebird.maply.sld.sldoperators.SLDOperator;
 import com.mousebird.maply.sld.sldoperators.SLDOperatorFactory;
 import com.mousebird.maply.sld.sldstyleset.SLDParseHelper;
@@ -44,6 +46,9 @@ public class SLDFilter {
     }
 
     private SLDOperator operator;
+    // Compiled version of the operator, if it could be compiled
+    private StyleRuleFilter ruleFilter;
+
     public SLDFilter(XmlPullParser xpp) throws XmlPullParserException, IOException {
         while (xpp.next() != XmlPullParser.END_TAG) {
             if (xpp.getEventType() != XmlPullParser.START_TAG) {
@@ -60,5 +65,20 @@ public class SLDFilter {
 
 
         }
+
+        if (operator != null) {
+            StyleRuleFilter newFilter = new StyleRuleFilter();
+            if (newFilter.compile(operator.addToRuleFilter(newFilter)))
+                ruleFilter = newFilter;
+        }
+    }
+
+    /**
+     * Test a feature's attributes, natively if we could compile the filter.
+     */
+    public boolean evaluateWithAttrs(AttrDictionary attrs) {
+        if (ruleFilter != null)
+            return ruleFilter.test(attrs);
+        return operator != null && operator.evaluateWithAttrs(attrs);
     }
 }
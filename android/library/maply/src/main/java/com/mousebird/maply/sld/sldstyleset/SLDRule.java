@@ -102,14 +102,14 @@ public class SLDRule {
         if (filters.size() == 0 && elseFilters.size() == 0)
             matched = true;
         for (SLDFilter filter : filters) {
-            if (filter.getOperator().evaluateWithAttrs(attrs)) {
+            if (filter.evaluateWithAttrs(attrs)) {
                 matched = true;
                 break;
             }
         }
         if (!matched) {
             for (SLDFilter filter: elseFilters) {
-                if (filter.getOperator().evaluateWithAttrs(attrs)) {
+                if (filter.evaluateWithAttrs(attrs)) {
                     matched = true;
                     break;
                 }
@@ -0,0 +1,79 @@
+/*  BenchCorpus.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <cstdlib>
+#import <fstream>
+#import <iterator>
+#import "WhirlyGlobeLib.h"
+
+// The test corpus and the stand-ins for the platform parts of the style set,
+// shared by the kernel benchmarks and the offline runner.
+
+namespace WhirlyKit
+{
+
+// Half the width of the spherical mercator world, in meters
+static const double MercatorExtent = 20037508.342789244;
+
+// The tiles in the corpus, numbered the way the quad tree does it.
+// Three from central Belfast and the busiest one from the obstacle set.
+static const QuadTreeIdentifier CorpusTiles[] = {
+    QuadTreeIdentifier(7922,11170,14),
+    QuadTreeIdentifier(7921,11169,14),
+    QuadTreeIdentifier(7922,11169,14),
+    QuadTreeIdentifier(18,39,6),
+};
+
+// The corpus is next to this file.  WG_BENCHMARK_CORPUS in the environment
+// points somewhere else, for when we've been copied to a device.
+inline std::string CorpusPath(const std::string &name)
+{
+    const char *dir = getenv("WG_BENCHMARK_CORPUS");
+    return std::string(dir ? dir : WG_BENCHMARK_CORPUS_DIR) + "/" + name;
+}
+
+inline std::string ReadFile(const std::string &path)
+{
+    std::ifstream in(path,std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in),std::istreambuf_iterator<char>());
+}
+
+// Style set with the platform parts stubbed out.
+// Nothing gets drawn, so there's no need for textures, fonts or selection.
+class BenchStyleSet : public MapboxVectorStyleSetImpl
+{
+public:
+    BenchStyleSet(Scene *scene,CoordSystem *coordSys) :
+        MapboxVectorStyleSetImpl(scene,coordSys,std::make_shared<VectorStyleSettingsImpl>(1.0))
+    {
+    }
+
+    virtual SimpleIdentity makeCircleTexture(PlatformThreadInfo *,double,const RGBAColor &,const RGBAColor &,
+                                             float,Point2f *) override { return EmptyIdentity; }
+    virtual SimpleIdentity makeLineTexture(PlatformThreadInfo *,const std::vector<double> &) override { return EmptyIdentity; }
+    virtual LabelInfoRef makeLabelInfo(PlatformThreadInfo *,const std::vector<std::string> &,float,bool) override { return LabelInfoRef(); }
+    virtual SingleLabelRef makeSingleLabel(PlatformThreadInfo *,const std::string &) override { return SingleLabelRef(); }
+    virtual void addSelectionObject(SimpleIdentity,const VectorObjectRef &,const ComponentObjectRef &) override { }
+    virtual double calculateTextWidth(PlatformThreadInfo *,const LabelInfoRef &,const std::string &) override { return 0.0; }
+    virtual ComponentObjectRef makeComponentObject(PlatformThreadInfo *,const Dictionary *desc) override
+    {
+        return desc ? std::make_shared<ComponentObject>(false,false,*desc) :
+                      std::make_shared<ComponentObject>(false,false);
+    }
+};
+
+}
@@ -0,0 +1,69 @@
+/*  DynamicResolutionTests.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <gtest/gtest.h>
+#import "DynamicResolution.h"
+
+using namespace WhirlyKit;
+
+namespace
+{
+
+const TimeInterval Budget = 1.0 / 60.0;
+
+}
+
+// Slow frames one after another drop the scale when the time between them is all we've got
+TEST(DynamicResolution, IntervalFallback)
+{
+    DynamicResolution dynRes;
+    dynRes.setEnabled(true);
+
+    TimeInterval now = 0.0;
+    for (int ii=0;ii<10;ii++,now += 2*Budget)
+        dynRes.addFrame(now,Budget,true);
+    EXPECT_LT(dynRes.getScale(),1.0f);
+}
+
+// With GPU times coming in, a slow display link doesn't count, but a slow GPU does
+TEST(DynamicResolution, GPUTimesTakeOver)
+{
+    DynamicResolution dynRes;
+    dynRes.setEnabled(true);
+
+    TimeInterval now = 0.0;
+    for (int ii=0;ii<10;ii++,now += 2*Budget)
+    {
+        dynRes.addFrame(now,Budget,true,true);
+        dynRes.addGPUFrame(Budget/2,Budget,true);
+    }
+    EXPECT_EQ(dynRes.getScale(),1.0f);
+
+    for (int ii=0;ii<10;ii++,now += Budget)
+    {
+        dynRes.addFrame(now,Budget,true,true);
+        dynRes.addGPUFrame(2*Budget,Budget,true);
+    }
+    EXPECT_LT(dynRes.getScale(),1.0f);
+
+    // Once the view stops, late results from moving frames don't drop it again
+    dynRes.addFrame(now,Budget,false,true);
+    EXPECT_EQ(dynRes.getScale(),1.0f);
+    for (int ii=0;ii<10;ii++)
+        dynRes.addGPUFrame(2*Budget,Budget,true);
+    EXPECT_EQ(dynRes.getScale(),1.0f);
+}
@@ -0,0 +1,67 @@
+/*  HostPlatform.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <cstdarg>
+#import <cstdio>
+#import "WhirlyKitLog.h"
+#import "ComponentManager.h"
+
+// The bits each platform fills in for the library, done simply for the host build.
+// Android's versions go through the NDK log and the JVM.
+
+static const char *levelNames[] = {"Verbose","Debug","Info","Warn","Error"};
+
+void wkLog(const char *formatStr,...)
+{
+    va_list args;
+    va_start(args, formatStr);
+    vfprintf(stderr, formatStr, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+void wkLogLevel_(WKLogLevel level,const char *formatStr,...)
+{
+    va_list args;
+    va_start(args, formatStr);
+    if (level >= Verbose && level <= Error)
+        fprintf(stderr, "%s: ", levelNames[level]);
+    vfprintf(stderr, formatStr, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+namespace WhirlyKit
+{
+
+// Component objects with nothing platform specific hanging off them
+class ComponentManager_Host : public ComponentManager
+{
+public:
+    virtual ComponentObjectRef makeComponentObject(const Dictionary *desc) override
+    {
+        return desc ? std::make_shared<ComponentObject>(false,false,*desc) :
+                      std::make_shared<ComponentObject>(false,false);
+    }
+};
+
+ComponentManagerRef MakeComponentManager()
+{
+    return std::make_shared<ComponentManager_Host>();
+}
+
+}
@@ -0,0 +1,34 @@
+/*  HostPrefix.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+// Included ahead of every C++ file in the host benchmark build.
+// The library leans on the prefix header on iOS and on what libc++ pulls
+//  in by itself on Android, so the same headers get pulled in here.
+
+#import <memory>
+#import <functional>
+#import <atomic>
+#import <mutex>
+#import <cstring>
+#import <cmath>
+#import <string>
+#import <algorithm>
+
+// Clang and the Apple headers have this one, glibc doesn't
+#ifndef __unused
+#define __unused __attribute__((unused))
+#endif
@@ -0,0 +1,445 @@
+/*  KernelBenchmarks.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <benchmark/benchmark.h>
+#import "WhirlyGlobeLib.h"
+#import "SceneGLES.h"
+#import "SceneRendererGLES.h"
+#import "VectorTilePBFParser.h"
+#import "Tesselator.h"
+#import "ScreenImportance.h"
+#import "Dictionary_Android.h"
+#import "BenchCorpus.h"
+
+using namespace WhirlyKit;
+
+namespace
+{
+
+// Screen size for the layout and importance kernels
+const float FrameSize = 1024.0;
+
+// The frame buffer size is normally set when the surface shows up
+class BenchRenderer : public SceneRendererGLES
+{
+public:
+    using SceneRendererGLES::setFramebufferSize;
+};
+
+// Layout never gets to clustering here, but it insists on a generator
+class BenchClusterGenerator : public ClusterGenerator
+{
+public:
+    virtual void startLayoutObjects(PlatformThreadInfo *) override { }
+    virtual void makeLayoutObject(PlatformThreadInfo *,int,const std::vector<LayoutObjectEntryRef> &,
+                                  LayoutObject &) override { }
+    virtual void endLayoutObjects(PlatformThreadInfo *) override { }
+    virtual void paramsForClusterClass(PlatformThreadInfo *,int,ClusterClassParams &) override { }
+};
+
+// Tile importance the way QuadSamplingController does it, without the rest of the loader
+class BenchQuadTree : public QuadTreeNew
+{
+public:
+    BenchQuadTree(CoordSystem *coordSys,CoordSystemDisplayAdapter *coordAdapter,const ViewStateRef &viewState) :
+        QuadTreeNew(MbrD(Point2d(-M_PI,-M_PI),Point2d(M_PI,M_PI)),0,18),
+        coordSys(coordSys), coordAdapter(coordAdapter), viewState(viewState),
+        solidCache(2*1024*1024)
+    {
+    }
+
+    virtual double importance(const Node &node) override
+    {
+        if (node.level == 0)
+            return MAXFLOAT;
+        const Mbr mbr(generateMbrForNode(node));
+        const QuadTreeIdentifier ident(node.x,node.y,node.level);
+        DisplaySolidRef dispSolid = solidCache.getSolid(ident,mbr,coordSys,coordAdapter);
+        return ScreenImportance(viewState.get(),Point2f(FrameSize,FrameSize),viewState->eyeVec,1,
+                                coordSys,coordAdapter,mbr,ident,dispSolid);
+    }
+
+    virtual bool visible(const Node &node) override
+    {
+        if (node.level == 0)
+            return true;
+        const Mbr mbr(generateMbrForNode(node));
+        const QuadTreeIdentifier ident(node.x,node.y,node.level);
+        DisplaySolidRef dispSolid = solidCache.getSolid(ident,mbr,coordSys,coordAdapter);
+        return TileIsOnScreen(viewState.get(),Point2f(FrameSize,FrameSize),coordSys,coordAdapter,
+                              mbr,ident,dispSolid);
+    }
+
+    CoordSystem *coordSys;
+    CoordSystemDisplayAdapter *coordAdapter;
+    ViewStateRef viewState;
+    DisplaySolidCache solidCache;
+};
+
+// Everything the benchmarks share, set up once.
+// The scene and renderer never see a GL context, so no drawables go anywhere.
+struct Corpus
+{
+    Corpus()
+    {
+        coordAdapter = std::make_unique<SphericalMercatorDisplayAdapter>(0.0,GeoCoord::CoordFromDegrees(-180.0,-90.0),
+                                                                         GeoCoord::CoordFromDegrees(180.0,90.0));
+        scene = new SceneGLES(coordAdapter.get());
+        renderer = std::make_unique<BenchRenderer>();
+        renderer->setFramebufferSize(FrameSize,FrameSize);
+        renderer->setScene(scene);
+
+        // Dictionary_Android is the JSON parser we've got on this side
+        auto styleDict = std::make_shared<MutableDictionary_Android>();
+        styleDict->parseJSON(ReadFile(CorpusPath("style.json")));
+        styleSet = std::make_shared<BenchStyleSet>(scene,coordAdapter->getCoordSystem());
+        styleSet->parse(&inst,styleDict);
+        for (const auto &layer : styleSet->layers)
+            if (layer->filter)
+                filters.emplace_back(layer->sourceLayer,layer->filter);
+
+        for (const auto &ident : CorpusTiles)
+        {
+            char name[64];
+            snprintf(name,sizeof(name),"%d_%d_%d.mvt",ident.level,ident.x,ident.y);
+            tiles.emplace_back(ident,ReadFile(CorpusPath(name)));
+        }
+
+        // Decode everything once for the geometry and attribute kernels
+        for (const auto &tile : tiles)
+        {
+            VectorTileData tileData;
+            parseTile(tile,tileData,true,&features);
+        }
+        for (const auto &feat : features)
+        {
+            for (const auto &shape : feat->shapes)
+            {
+                if (auto areal = std::dynamic_pointer_cast<VectorAreal>(shape))
+                    areals.push_back(areal);
+                else if (auto linear = std::dynamic_pointer_cast<VectorLinear>(shape))
+                    linears.push_back(linear);
+            }
+        }
+
+        // Look down on the middle of the Belfast tiles from about three tiles up
+        mapView = std::make_unique<Maply::MapView>(coordAdapter.get());
+        const GeoCoord center = GeoCoord::CoordFromDegrees(-5.93,54.597);
+        const Point3d centerDisp = coordAdapter->localToDisplay(coordAdapter->getCoordSystem()->geographicToLocal3d(center));
+        mapView->setLoc(Point3d(centerDisp.x(),centerDisp.y(),0.001),false);
+        viewState = mapView->makeViewState(renderer.get());
+    }
+
+    // Parse a tile the way the loader does, sorting the features by style
+    bool parseTile(const std::pair<QuadTreeIdentifier,std::string> &tile,VectorTileData &tileData,
+                   bool parseAll,std::vector<VectorObjectRef> *keep)
+    {
+        const auto &ident = tile.first;
+        const double size = 2.0 * MercatorExtent / (1 << ident.level);
+        tileData.ident = ident;
+        tileData.bbox = MbrD(Point2d(-MercatorExtent + ident.x * size,-MercatorExtent + ident.y * size),
+                             Point2d(-MercatorExtent + (ident.x+1) * size,-MercatorExtent + (ident.y+1) * size));
+
+        VectorTilePBFParser parser(&tileData,styleSet.get(),&inst,std::string(),std::set<std::string>(),
+                                   tileData.vecObjsByStyle,false,parseAll,keep);
+        return parser.parse((const uint8_t *)tile.second.data(),tile.second.size());
+    }
+
+    PlatformThreadInfo inst;
+    std::unique_ptr<CoordSystemDisplayAdapter> coordAdapter;
+    std::unique_ptr<BenchRenderer> renderer;
+    std::unique_ptr<Maply::MapView> mapView;
+    ViewStateRef viewState;
+    SceneGLES *scene = nullptr;
+    std::shared_ptr<BenchStyleSet> styleSet;
+    std::vector<std::pair<std::string,MapboxVectorFilterRef>> filters;
+    std::vector<std::pair<QuadTreeIdentifier,std::string>> tiles;
+    std::vector<VectorObjectRef> features;
+    std::vector<VectorArealRef> areals;
+    std::vector<VectorLinearRef> linears;
+};
+
+// Built on first use and never torn down
+Corpus &GetCorpus()
+{
+    static Corpus *corpus = new Corpus();
+    return *corpus;
+}
+
+// Decode each tile and sort its features by style
+void BM_PBFParse(benchmark::State &state)
+{
+    auto &corpus = GetCorpus();
+    int64_t bytes = 0;
+    for (auto _ : state)
+    {
+        for (const auto &tile : corpus.tiles)
+        {
+            VectorTileData tileData;
+            benchmark::DoNotOptimize(corpus.parseTile(tile,tileData,false,nullptr));
+            bytes += tile.second.size();
+        }
+    }
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_PBFParse);
+
+// Every style filter against every feature from its source layer
+void BM_FilterTestFeature(benchmark::State &state)
+{
+    auto &corpus = GetCorpus();
+    std::vector<std::pair<std::string,DictionaryRef>> attrs;
+    for (const auto &feat : corpus.features)
+    {
+        const auto dict = feat->getAttributes();
+        attrs.emplace_back(dict->getString("layer_name"),dict);
+    }
+
+    const QuadTreeIdentifier &tileID = corpus.tiles.front().first;
+    int64_t tests = 0;
+    for (auto _ : state)
+    {
+        for (const auto &filter : corpus.filters)
+            for (const auto &attr : attrs)
+                if (attr.first == filter.first)
+                {
+                    benchmark::DoNotOptimize(filter.second->testFeature(*attr.second,tileID));
+                    tests++;
+                }
+    }
+    state.SetItemsProcessed(tests);
+}
+BENCHMARK(BM_FilterTestFeature);
+
+// Triangulate the polygons, holes and all
+void BM_TesselateLoops(benchmark::State &state)
+{
+    auto &corpus = GetCorpus();
+    for (auto _ : state)
+    {
+        for (const auto &areal : corpus.areals)
+        {
+            VectorTrianglesRef tris = VectorTriangles::createTriangles();
+            TesselateLoops(areal->loops,tris);
+            benchmark::DoNotOptimize(tris->tris.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * corpus.areals.size());
+}
+BENCHMARK(BM_TesselateLoops);
+
+// Chop the polygons up on a grid an eighth of a tile across, as the globe does
+void BM_ClipLoopsToGrid(benchmark::State &state)
+{
+    auto &corpus = GetCorpus();
+    const float spacing = (float)(2.0 * M_PI / (1 << corpus.tiles.front().first.level) / 8.0);
+    std::vector<VectorRing> rets;
+    for (auto _ : state)
+    {
+        for (const auto &areal : corpus.areals)
+        {
+            rets.clear();
+            ClipLoopsToGrid(areal->loops,Point2f(0.0,0.0),Point2f(spacing,spacing),rets);
+            benchmark::DoNotOptimize(rets.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * corpus.areals.size());
+}
+BENCHMARK(BM_ClipLoopsToGrid);
+
+// Place label sized boxes along the roads on a 1024 pixel screen, as layout would
+void BM_OverlapAddCheckObject(benchmark::State &state)
+{
+    auto &corpus = GetCorpus();
+    GeoMbr geoMbr;
+    for (const auto &linear : corpus.linears)
+        geoMbr.addGeoCoords(linear->pts);
+    const Point2f geoSize(geoMbr.ur().x()-geoMbr.ll().x(),geoMbr.ur().y()-geoMbr.ll().y());
+    const float screenSize = 1024.0;
+
+    std::vector<Point2dVector> boxes;
+    for (const auto &linear : corpus.linears)
+        for (unsigned int ii=0;ii<linear->pts.size();ii+=4)
+        {
+            const Point2f &pt = linear->pts[ii];
+            const double x = (pt.x() - geoMbr.ll().x()) / geoSize.x() * screenSize;
+            const double y = (pt.y() - geoMbr.ll().y()) / geoSize.y() * screenSize;
+            boxes.push_back({Point2d(x-30,y-8),Point2d(x+30,y-8),Point2d(x+30,y+8),Point2d(x-30,y+8)});
+        }
+
+    const Mbr screenMbr(Point2f(0.0,0.0),Point2f(screenSize,screenSize));
+    for (auto _ : state)
+    {
+        OverlapHelper overlap(screenMbr,10,60,boxes.size());
+        for (const auto &box : boxes)
+            benchmark::DoNotOptimize(overlap.addCheckObject(box));
+    }
+    state.SetItemsProcessed(state.iterations() * boxes.size());
+}
+BENCHMARK(BM_OverlapAddCheckObject);
+
+// Lay out labels for the named roads and points of interest from a fixed view.
+// After the first pass nothing moves, so this is mostly runLayoutRules.
+void BM_LayoutUpdate(benchmark::State &state)
+{
+    auto &corpus = GetCorpus();
+    CoordSystemDisplayAdapter *coordAdapter = corpus.coordAdapter.get();
+    CoordSystem *coordSys = coordAdapter->getCoordSystem();
+    const auto layoutManage = corpus.scene->getManager<LayoutManager>(kWKLayoutManager);
+    static BenchClusterGenerator clusterGen;
+    layoutManage->addClusterGenerator(&corpus.inst,&clusterGen);
+
+    // Road classes get the usual label priorities, points of interest go in the middle
+    const std::unordered_map<std::string,float> classImport = {
+        {"motorway",6.0}, {"trunk",5.0}, {"primary",4.0}, {"secondary",3.0}, {"tertiary",2.0}
+    };
+    std::vector<LayoutObject> objs;
+    SimpleIDSet objIDs;
+    for (const auto &feat : corpus.features)
+    {
+        const auto attrs = feat->getAttributes();
+        const std::string name = attrs->getString("name");
+        if (name.empty())
+            continue;
+        for (const auto &shape : feat->shapes)
+        {
+            GeoCoord loc;
+            float import = 3.0;
+            if (auto pts = std::dynamic_pointer_cast<VectorPoints>(shape))
+                loc = pts->pts.front();
+            else if (auto linear = std::dynamic_pointer_cast<VectorLinear>(shape))
+            {
+                loc = linear->pts[linear->pts.size()/2];
+                const auto it = classImport.find(attrs->getString("class"));
+                import = (it == classImport.end()) ? 1.0 : it->second;
+            }
+            else
+                continue;
+
+            objs.emplace_back();
+            LayoutObject &obj = objs.back();
+            obj.setWorldLoc(coordAdapter->localToDisplay(coordSys->geographicToLocal3d(loc)));
+            obj.setLayoutSize(Point2d(7.0 * name.size(),14.0),Point2d(0.0,0.0));
+            obj.importance = import + name.size() / 1000.0;
+            objIDs.insert(obj.getId());
+        }
+    }
+    const size_t numObjs = objs.size();
+    layoutManage->addLayoutObjects(std::move(objs));
+
+    for (auto _ : state)
+    {
+        ChangeSet changes;
+        layoutManage->updateLayout(&corpus.inst,corpus.viewState,changes);
+
+        state.PauseTiming();
+        discardChanges(changes);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * numObjs);
+
+    layoutManage->removeLayoutObjects(objIDs);
+}
+BENCHMARK(BM_LayoutUpdate);
+
+// Pick the tiles to load for the Belfast view, as the sampling layer does each frame
+void BM_QuadTreeCoverage(benchmark::State &state)
+{
+    auto &corpus = GetCorpus();
+    BenchQuadTree quadTree(corpus.coordAdapter->getCoordSystem(),corpus.coordAdapter.get(),corpus.viewState);
+    const std::vector<double> minImportance(quadTree.maxLevel+1,256*256);
+    std::vector<double> maxRejectedImport(quadTree.maxLevel+1,0.0);
+
+    size_t numNodes = 0;
+    for (auto _ : state)
+    {
+        std::fill(maxRejectedImport.begin(),maxRejectedImport.end(),0.0);
+        const auto nodes = quadTree.calcCoverageImportance(minImportance,256,true,maxRejectedImport);
+        numNodes = nodes.size();
+        benchmark::DoNotOptimize(numNodes);
+    }
+    state.counters["tiles"] = numNodes;
+}
+BENCHMARK(BM_QuadTreeCoverage);
+
+// Widen all the roads into drawables
+void BM_WideVectorBuild(benchmark::State &state)
+{
+    auto &corpus = GetCorpus();
+    const auto wideVecManage = corpus.scene->getManager<WideVectorManager>(kWKWideVectorManager);
+    const std::vector<VectorShapeRef> shapes(corpus.linears.begin(),corpus.linears.end());
+    WideVectorInfo vecInfo;
+    vecInfo.width = 4.0;
+
+    for (auto _ : state)
+    {
+        ChangeSet changes;
+        SimpleIDSet vecIDs;
+        vecIDs.insert(wideVecManage->addVectors(shapes,vecInfo,changes));
+
+        state.PauseTiming();
+        wideVecManage->removeVectors(vecIDs,changes);
+        discardChanges(changes);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * shapes.size());
+}
+BENCHMARK(BM_WideVectorBuild);
+
+// The lookups the styles make on feature attributes
+void BM_DictionaryCGet(benchmark::State &state)
+{
+    auto &corpus = GetCorpus();
+    std::vector<MutableDictionaryRef> attrs;
+    for (const auto &feat : corpus.features)
+        attrs.push_back(feat->getAttributes());
+
+    for (auto _ : state)
+    {
+        for (const auto &dict : attrs)
+        {
+            benchmark::DoNotOptimize(dict->getString("class"));
+            benchmark::DoNotOptimize(dict->getInt("oneway",0));
+            benchmark::DoNotOptimize(dict->hasField("name"));
+            benchmark::DoNotOptimize(dict->getType("brunnel"));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * attrs.size() * 4);
+}
+BENCHMARK(BM_DictionaryCGet);
+
+// Fill in attributes the way the parser does for each feature
+void BM_DictionaryCSet(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        MutableDictionaryC dict(6);
+        dict.setString("layer_name","transportation");
+        dict.setInt("geometry_type",2);
+        dict.setString("class","minor");
+        dict.setInt("oneway",0);
+        dict.setString("name","Place 1");
+        dict.setDouble("rank",12.0);
+        benchmark::DoNotOptimize(dict.count());
+    }
+    state.SetItemsProcessed(state.iterations() * 6);
+}
+BENCHMARK(BM_DictionaryCSet);
+
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,205 @@
+/*  OfflineRunnerMain.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <EGL/egl.h>
+#import <EGL/eglext.h>
+#import <cstdio>
+#import "WhirlyGlobeLib.h"
+#import "SceneGLES.h"
+#import "SceneRendererGLES.h"
+#import "OfflineRunner.h"
+#import "MapboxVectorTileParser.h"
+#import "LineAndPointShadersGLES.h"
+#import "TriangleShadersGLES.h"
+#import "WideVectorDrawableBuilderGLES.h"
+#import "ScreenSpaceDrawableBuilderGLES.h"
+#import "Dictionary_Android.h"
+#import "BenchCorpus.h"
+
+using namespace WhirlyKit;
+
+// Draws the corpus tiles into a pbuffer with the offline runner and writes out the results.
+//
+//   wgofflinerunner [frames] [output.json]
+//
+// The JSON goes to stdout if there's no file.  Exits nonzero if there's no context or the scene never settled.
+
+namespace
+{
+
+const int FrameSize = 1024;
+
+// Headless Mesa has no default display, but it does have the surfaceless platform
+EGLDisplay OpenDisplay()
+{
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+    {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,EGL_DEFAULT_DISPLAY,nullptr);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display,nullptr,nullptr))
+            return display;
+    }
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display,nullptr,nullptr))
+        return display;
+    return EGL_NO_DISPLAY;
+}
+
+// A GLES 3 context current on a small pbuffer.
+// The renderer draws into its own offscreen buffer, so the pbuffer is only there to be current on.
+bool MakeContext(EGLDisplay display)
+{
+    const EGLint configAttrs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 16,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(display,configAttrs,&config,1,&numConfigs) || numConfigs < 1)
+        return false;
+
+    const EGLint surfaceAttrs[] = { EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE };
+    EGLSurface surface = eglCreatePbufferSurface(display,config,surfaceAttrs);
+    if (surface == EGL_NO_SURFACE)
+        return false;
+
+    const EGLint contextAttrs[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
+    if (!eglBindAPI(EGL_OPENGL_ES_API))
+        return false;
+    EGLContext context = eglCreateContext(display,config,EGL_NO_CONTEXT,contextAttrs);
+    if (context == EGL_NO_CONTEXT)
+        return false;
+
+    return eglMakeCurrent(display,surface,surface,context);
+}
+
+// The programs the vector tile styles ask for, built the way Android's setupShadersNative does it
+void AddShaders(Scene *scene,SceneRendererGLES *renderer)
+{
+    scene->addProgram(ProgramGLESRef(BuildDefaultLineShaderNoCullingGLES(MaplyDefaultLineShader,renderer)));
+    scene->addProgram(ProgramGLESRef(BuildDefaultLineShaderNoCullingGLES(MaplyNoBackfaceLineShader,renderer)));
+    scene->addProgram(ProgramGLESRef(BuildDefaultTriShaderLightingGLES(MaplyDefaultTriangleShader,renderer)));
+    scene->addProgram(ProgramGLESRef(BuildDefaultTriShaderNoLightingGLES(MaplyNoLightTriangleShader,renderer)));
+    scene->addProgram(ProgramGLESRef(BuildDefaultTriShaderMultitexGLES(MaplyDefaultTriMultiTexShader,renderer)));
+    scene->addProgram(ProgramGLESRef(BuildDefaultTriShaderMultitexGLES(MaplyDefaultMarkerShader,renderer)));
+    scene->addProgram(ProgramGLESRef(BuildWideVectorProgramGLES(MaplyDefaultWideVectorShader,renderer)));
+    scene->addProgram(ProgramGLESRef(BuildWideVectorPerfProgramGLES(MaplyWideVectorPerformanceShader,renderer)));
+    scene->addProgram(ProgramGLESRef(BuildScreenSpaceMotionProgramGLES(MaplyScreenSpaceDefaultMotionShader,renderer)));
+    scene->addProgram(ProgramGLESRef(BuildScreenSpaceProgramGLES(MaplyScreenSpaceDefaultShader,renderer)));
+}
+
+}
+
+int main(int argc,char *argv[])
+{
+    OfflineRunner::Params params;
+    params.settleTimeout = 10.0;
+    params.frames = argc > 1 ? atoi(argv[1]) : 30;
+    const char *outName = argc > 2 ? argv[2] : nullptr;
+
+    EGLDisplay display = OpenDisplay();
+    if (display == EGL_NO_DISPLAY || !MakeContext(display))
+    {
+        fprintf(stderr,"wgofflinerunner: no GLES 3 pbuffer context (EGL error 0x%x)\n",eglGetError());
+        return 1;
+    }
+
+    SphericalMercatorDisplayAdapter coordAdapter(0.0,GeoCoord::CoordFromDegrees(-180.0,-90.0),
+                                                 GeoCoord::CoordFromDegrees(180.0,90.0));
+    CoordSystem *coordSys = coordAdapter.getCoordSystem();
+
+    // Sized at setup, the renderer makes its own offscreen frame buffer as it does for Android's offline controller
+    SceneRendererGLES renderer;
+    if (!renderer.setup(3,FrameSize,FrameSize,1.0))
+    {
+        fprintf(stderr,"wgofflinerunner: renderer setup failed\n");
+        return 1;
+    }
+    auto scene = new SceneGLES(&coordAdapter);
+    renderer.setScene(scene);
+    AddShaders(scene,&renderer);
+
+    // Look down on the middle of the Belfast tiles, same as the layout benchmark
+    Maply::MapView mapView(&coordAdapter);
+    const GeoCoord center = GeoCoord::CoordFromDegrees(-5.93,54.597);
+    const Point3d centerDisp = coordAdapter.localToDisplay(coordSys->geographicToLocal3d(center));
+    mapView.setLoc(Point3d(centerDisp.x(),centerDisp.y(),0.001),false);
+    renderer.setView(&mapView);
+
+    // Build the tiles the way the vector tile loader does, then show them
+    PlatformThreadInfo inst;
+    auto styleDict = std::make_shared<MutableDictionary_Android>();
+    styleDict->parseJSON(ReadFile(CorpusPath("style.json")));
+    auto styleSet = std::make_shared<BenchStyleSet>(scene,coordSys);
+    // The view doesn't move, so the slot the loader would keep updated just sits at the tile level
+    styleSet->zoomSlot = scene->retainZoomSlot();
+    scene->setZoomSlotValue(styleSet->zoomSlot,CorpusTiles[0].level);
+    if (!styleSet->parse(&inst,styleDict))
+    {
+        fprintf(stderr,"wgofflinerunner: couldn't parse %s\n",CorpusPath("style.json").c_str());
+        return 1;
+    }
+    MapboxVectorTileParser parser(&inst,styleSet);
+    auto compManage = scene->getManager<ComponentManager>(kWKComponentManager);
+    for (const auto &ident : CorpusTiles)
+    {
+        char name[64];
+        snprintf(name,sizeof(name),"%d_%d_%d.mvt",ident.level,ident.x,ident.y);
+        const std::string tile = ReadFile(CorpusPath(name));
+
+        const double size = 2.0 * MercatorExtent / (1 << ident.level);
+        VectorTileData tileData;
+        tileData.ident = ident;
+        tileData.bbox = MbrD(Point2d(-MercatorExtent + ident.x * size,-MercatorExtent + ident.y * size),
+                             Point2d(-MercatorExtent + (ident.x+1) * size,-MercatorExtent + (ident.y+1) * size));
+        tileData.geoBBox = MbrD(coordSys->localToGeographicD(Point3d(tileData.bbox.ll().x(),tileData.bbox.ll().y(),0.0)),
+                                coordSys->localToGeographicD(Point3d(tileData.bbox.ur().x(),tileData.bbox.ur().y(),0.0)));
+        RawDataWrapper rawData(tile.data(),tile.size(),false);
+        if (!parser.parse(&inst,&rawData,&tileData,nullptr))
+        {
+            fprintf(stderr,"wgofflinerunner: couldn't parse %s\n",name);
+            return 1;
+        }
+        ChangeSet changes(std::move(tileData.changes));
+        compManage->enableComponentObjects(tileData.compObjs,true,changes);
+        scene->addChangeRequests(changes);
+    }
+
+    OfflineRunner runner(scene,&renderer,[&renderer]{ renderer.render(1/60.0); });
+    const OfflineRunner::Result result = runner.run(params);
+    const std::string json = OfflineRunner::ToJSON(result);
+
+    if (outName)
+    {
+        FILE *fp = fopen(outName,"w");
+        if (!fp)
+        {
+            fprintf(stderr,"wgofflinerunner: can't write %s\n",outName);
+            return 1;
+        }
+        fputs(json.c_str(),fp);
+        fputc('\n',fp);
+        fclose(fp);
+    }
+    else
+        printf("%s\n",json.c_str());
+
+    return result.settled ? 0 : 2;
+}
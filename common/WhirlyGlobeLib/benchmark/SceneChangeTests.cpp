@@ -0,0 +1,62 @@
+/*  SceneChangeTests.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <gtest/gtest.h>
+#import "WhirlyGlobeLib.h"
+#import "SceneGLES.h"
+
+using namespace WhirlyKit;
+
+namespace
+{
+
+// A change that just claims to upload some bytes
+class UploadReq : public ChangeRequest
+{
+public:
+    UploadReq(size_t size) : size(size) { }
+    virtual void execute(Scene *,SceneRenderer *,View *) override { }
+    virtual size_t getUploadSize() const override { return size; }
+
+protected:
+    size_t size;
+};
+
+}
+
+// A second pass in the same frame only gets what the first left of the budget
+TEST(SceneChanges, BudgetCarriesOverWithinFrame)
+{
+    SphericalMercatorDisplayAdapter adapter(0.0,GeoCoord::CoordFromDegrees(-180.0,-90.0),
+                                            GeoCoord::CoordFromDegrees(180.0,90.0));
+    SceneGLES scene(&adapter);
+    scene.setChangeBudget(0.0,100);
+
+    ChangeSet changes { new UploadReq(60), new UploadReq(60), new UploadReq(60) };
+    scene.addChangeRequests(changes);
+
+    // The one that goes over still runs, the rest wait
+    EXPECT_EQ(scene.processChanges(nullptr,nullptr,0.0),2);
+    EXPECT_EQ(scene.getNumDeferredChanges(),1);
+
+    EXPECT_EQ(scene.processChanges(nullptr,nullptr,0.0,true),0);
+    EXPECT_EQ(scene.getNumDeferredChanges(),1);
+
+    // Next frame gets a new budget
+    EXPECT_EQ(scene.processChanges(nullptr,nullptr,0.0),1);
+    EXPECT_EQ(scene.getNumDeferredChanges(),0);
+}
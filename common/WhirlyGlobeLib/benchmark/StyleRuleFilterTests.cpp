@@ -0,0 +1,76 @@
+/*  StyleRuleFilterTests.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <gtest/gtest.h>
+#import "StyleRuleFilter.h"
+#import "DictionaryC.h"
+
+using namespace WhirlyKit;
+
+namespace
+{
+
+// Compare an attribute against a literal, the way the SLD parser builds it
+StyleRuleFilter MakeCompare(StyleRuleOp op,const std::string &attr,const std::string &literal)
+{
+    StyleRuleFilter filter;
+    const int root = filter.addCompare(op,filter.addAttr(attr),filter.addLiteral(literal));
+    EXPECT_TRUE(filter.compile(root));
+    return filter;
+}
+
+}
+
+// Shapefiles and GeoJSON often carry numbers as text.  They should still sort as numbers.
+TEST(StyleRuleFilter, StringAttrAgainstNumericLiteral)
+{
+    MutableDictionaryC attrs;
+    attrs.setString("height","900");
+
+    EXPECT_TRUE(MakeCompare(StyleRuleLess,"height","1000").test(attrs));
+    EXPECT_FALSE(MakeCompare(StyleRuleGreater,"height","1000").test(attrs));
+    EXPECT_TRUE(MakeCompare(StyleRuleEqual,"height","900.0").test(attrs));
+}
+
+// Text that isn't a number still compares as text against a numeric literal
+TEST(StyleRuleFilter, NonNumericStringAgainstNumericLiteral)
+{
+    MutableDictionaryC attrs;
+    attrs.setString("ref","A1");
+
+    EXPECT_TRUE(MakeCompare(StyleRuleNotEqual,"ref","5").test(attrs));
+    EXPECT_FALSE(MakeCompare(StyleRuleEqual,"ref","5").test(attrs));
+}
+
+TEST(StyleRuleFilter, NumericAttrAgainstNumericLiteral)
+{
+    MutableDictionaryC attrs;
+    attrs.setInt("lanes",4);
+
+    EXPECT_TRUE(MakeCompare(StyleRuleGreaterEqual,"lanes","4").test(attrs));
+    EXPECT_FALSE(MakeCompare(StyleRuleLess,"lanes","3").test(attrs));
+}
+
+TEST(StyleRuleFilter, StringAttrAgainstStringLiteral)
+{
+    MutableDictionaryC attrs;
+    attrs.setString("class","Park");
+
+    EXPECT_TRUE(MakeCompare(StyleRuleEqual,"class","Park").test(attrs));
+    EXPECT_FALSE(MakeCompare(StyleRuleEqual,"class","park").test(attrs));
+    EXPECT_FALSE(MakeCompare(StyleRuleEqual,"missing","Park").test(attrs));
+}
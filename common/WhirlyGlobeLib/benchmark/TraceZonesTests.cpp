@@ -0,0 +1,76 @@
+/*  TraceZonesTests.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <gtest/gtest.h>
+#import <set>
+#import <thread>
+#import "PerformanceTimer.h"
+
+using namespace WhirlyKit;
+
+namespace
+{
+
+int CountOf(const std::string &str,const std::string &what)
+{
+    int count = 0;
+    for (size_t pos = str.find(what); pos != std::string::npos; pos = str.find(what,pos+1))
+        count++;
+    return count;
+}
+
+std::set<std::string> ThreadIDs(const std::string &json)
+{
+    std::set<std::string> ids;
+    for (size_t pos = json.find("\"tid\":"); pos != std::string::npos; pos = json.find("\"tid\":",pos+1))
+        ids.insert(json.substr(pos,json.find('}',pos)-pos));
+    return ids;
+}
+
+}
+
+// Threads that come and go one after another share a buffer rather than each leaving one behind
+TEST(TraceZones, RetiredThreadBuffersAreReused)
+{
+    TraceZones::clear();
+    TraceZones::setRecording(true);
+    for (int ii=0;ii<4;ii++)
+    {
+        std::thread([]{ WKTraceScope("test worker"); }).join();
+    }
+    TraceZones::setRecording(false);
+
+    const std::string json = TraceZones::getChromeTrace();
+    EXPECT_EQ(CountOf(json,"\"name\":\"test worker\""),8);
+
+    EXPECT_EQ(ThreadIDs(json).size(),1u);
+}
+
+// A zone that began before recording started doesn't leave an end behind
+TEST(TraceZones, RecordingSwitchedOnMidZone)
+{
+    TraceZones::clear();
+    TraceZones::setSystemTracing(true);
+    {
+        WKTraceScope("test mid zone");
+        TraceZones::setRecording(true);
+    }
+    TraceZones::setRecording(false);
+    TraceZones::setSystemTracing(false);
+
+    EXPECT_EQ(CountOf(TraceZones::getChromeTrace(),"test mid zone"),0);
+}
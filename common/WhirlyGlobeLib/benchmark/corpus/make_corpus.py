@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+#
+#  make_corpus.py
+#  WhirlyGlobeLib
+#
+#  Copyright 2011-2022 mousebird consulting
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# Writes the vector tiles the kernel benchmarks run on.
+#
+# The level 14 tiles are cut from the Belfast OpenStreetMap extract the
+# Android test app ships with, with the attributes renamed to the
+# OpenMapTiles schema the style uses.  The level 6 tile comes straight out
+# of the FAA obstacle mbtiles, which tippecanoe wrote.  It's only unzipped.
+#
+# Output names are level_x_y, with y counting up from the south as the
+# quad tree does.  The same inputs always give the same bytes.
+
+import gzip
+import json
+import math
+import os
+import sqlite3
+import struct
+
+EXTENT = 4096
+BUFFER = 64
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ASSETS = os.path.join(HERE, '..', '..', '..', '..', 'android', 'apps', 'AutoTesterAndroid', 'app', 'src', 'main',
+                      'assets')
+
+# Central Belfast, in the quad tree's numbering
+BELFAST_TILES = [(14, 7922, 11170), (14, 7921, 11169), (14, 7922, 11169)]
+
+# The most crowded tile in the obstacle set, around the Great Lakes
+OBSTACLE_TILES = [(6, 18, 39)]
+
+ROAD_CLASSES = {
+    'motorway': 'motorway', 'motorway_link': 'motorway',
+    'trunk': 'trunk', 'trunk_link': 'trunk',
+    'primary': 'primary', 'primary_link': 'primary',
+    'secondary': 'secondary', 'secondary_link': 'secondary',
+    'tertiary': 'tertiary', 'tertiary_link': 'tertiary',
+    'residential': 'minor', 'unclassified': 'minor', 'living_street': 'minor', 'road': 'minor',
+    'service': 'service',
+    'track': 'track',
+    'rail': 'rail',
+}
+PATH_TYPES = {'footway', 'path', 'cycleway', 'pedestrian', 'steps', 'bridleway'}
+PARK_TYPES = {'park', 'garden', 'playground', 'nature_reserve'}
+WATER_CLASSES = {'riverbank': 'river', 'swimming_pool': 'swimming_pool'}
+
+
+def varint(val):
+    # Negative ints go out as 64 bit two's complement, as protobuf does
+    if val < 0:
+        val += 1 << 64
+    out = bytearray()
+    while True:
+        byte = val & 0x7f
+        val >>= 7
+        if val:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def zigzag(val):
+    return (val << 1) ^ (val >> 31)
+
+
+def field(num, wire, payload):
+    key = varint((num << 3) | wire)
+    if wire == 2:
+        return key + varint(len(payload)) + payload
+    return key + payload
+
+
+def packed(num, vals):
+    return field(num, 2, b''.join(varint(v) for v in vals))
+
+
+def command(cmd, count):
+    return (cmd & 0x7) | (count << 3)
+
+
+def encode_geom(parts, closed):
+    # Parts are lists of (x,y) in tile coordinates
+    out = []
+    cx, cy = 0, 0
+    for part in parts:
+        x, y = part[0]
+        out += [command(1, 1), zigzag(x - cx), zigzag(y - cy)]
+        cx, cy = x, y
+        rest = part[1:]
+        if rest:
+            out.append(command(2, len(rest)))
+            for x, y in rest:
+                out += [zigzag(x - cx), zigzag(y - cy)]
+                cx, cy = x, y
+        if closed:
+            out.append(command(7, 1))
+    return out
+
+
+class Layer:
+    def __init__(self, name):
+        self.name = name
+        self.keys = {}
+        self.values = {}
+        self.features = []
+
+    def key(self, k):
+        return self.keys.setdefault(k, len(self.keys))
+
+    def value(self, v):
+        # Keep 1 and True apart
+        return self.values.setdefault((type(v), v), len(self.values))
+
+    def add(self, geomType, parts, attrs):
+        tags = []
+        for k, v in attrs.items():
+            if v is None:
+                continue
+            tags += [self.key(k), self.value(v)]
+        self.features.append((geomType, encode_geom(parts, geomType == 3), tags))
+
+    def encode(self):
+        out = field(15, 0, varint(2)) + field(1, 2, self.name.encode())
+        for fid, (geomType, geom, tags) in enumerate(self.features):
+            feat = field(1, 0, varint(fid + 1)) + packed(2, tags) + \
+                field(3, 0, varint(geomType)) + packed(4, geom)
+            out += field(2, 2, feat)
+        for k in self.keys:
+            out += field(3, 2, k.encode())
+        for _, v in self.values:
+            if isinstance(v, bool):
+                val = field(7, 0, varint(int(v)))
+            elif isinstance(v, int):
+                val = field(4, 0, varint(v))
+            elif isinstance(v, float):
+                val = field(3, 1, struct.pack('<d', v))
+            else:
+                val = field(1, 2, v.encode())
+            out += field(4, 2, val)
+        out += field(5, 0, varint(EXTENT))
+        return out
+
+
+class TileProjection:
+    """Lon/lat to integer coordinates in one tile, y pointing down"""
+
+    def __init__(self, level, x, y):
+        self.scale = (1 << level) * EXTENT
+        self.x0 = x * EXTENT
+        # Back to the usual north up row for the math
+        self.y0 = ((1 << level) - 1 - y) * EXTENT
+
+    def project(self, lon, lat):
+        px = (lon + 180.0) / 360.0 * self.scale
+        sinLat = math.sin(math.radians(lat))
+        py = (0.5 - math.log((1 + sinLat) / (1 - sinLat)) / (4 * math.pi)) * self.scale
+        return int(round(px - self.x0)), int(round(py - self.y0))
+
+    def line(self, coords):
+        pts = []
+        for lon, lat in coords:
+            pt = self.project(lon, lat)
+            if not pts or pts[-1] != pt:
+                pts.append(pt)
+        return pts
+
+    @staticmethod
+    def overlaps(parts):
+        xs = [p[0] for part in parts for p in part]
+        ys = [p[1] for part in parts for p in part]
+        return min(xs) < EXTENT + BUFFER and max(xs) > -BUFFER and min(ys) < EXTENT + BUFFER and max(ys) > -BUFFER
+
+
+def signed_area(ring):
+    area = 0
+    for (x0, y0), (x1, y1) in zip(ring, ring[1:] + ring[:1]):
+        area += x0 * y1 - x1 * y0
+    return area
+
+
+def polygon_parts(proj, geom):
+    # Outer rings come out with positive area with y down (clockwise in the spec), holes negative
+    polys = geom['coordinates'] if geom['type'] == 'MultiPolygon' else [geom['coordinates']]
+    parts = []
+    for poly in polys:
+        for which, coords in enumerate(poly):
+            ring = proj.line(coords)
+            if len(ring) > 1 and ring[0] == ring[-1]:
+                ring = ring[:-1]
+            area = signed_area(ring) if len(ring) >= 3 else 0
+            if area == 0:
+                # Without an outer ring there's nothing to put the holes in
+                if which == 0:
+                    break
+                continue
+            if (area > 0) != (which == 0):
+                ring.reverse()
+            parts.append(ring)
+    return parts
+
+
+def load(name):
+    with open(os.path.join(ASSETS, 'belfast_ireland_%s.geojson' % name)) as f:
+        return json.load(f)['features']
+
+
+def make_belfast_tile(proj, data):
+    water = Layer('water')
+    waterway = Layer('waterway')
+    landuse = Layer('landuse')
+    park = Layer('park')
+    building = Layer('building')
+    transport = Layer('transportation')
+    poi = Layer('poi')
+
+    for feat in data['waterareas']:
+        parts = polygon_parts(proj, feat['geometry'])
+        if parts and proj.overlaps(parts):
+            kind = feat['properties']['type']
+            water.add(3, parts, {'class': WATER_CLASSES.get(kind, 'lake')})
+
+    for feat in data['waterways']:
+        pts = proj.line(feat['geometry']['coordinates'])
+        if len(pts) > 1 and proj.overlaps([pts]):
+            props = feat['properties']
+            waterway.add(2, [pts], {'class': props['type'], 'name': props['name']})
+
+    for feat in data['landusages']:
+        parts = polygon_parts(proj, feat['geometry'])
+        if parts and proj.overlaps(parts):
+            props = feat['properties']
+            layer = park if props['type'] in PARK_TYPES else landuse
+            layer.add(3, parts, {'class': props['type'], 'name': props['name']})
+
+    for feat in data['buildings']:
+        parts = polygon_parts(proj, feat['geometry'])
+        if parts and proj.overlaps(parts):
+            building.add(3, parts, {'name': feat['properties']['name']})
+
+    for feat in data['roads']:
+        pts = proj.line(feat['geometry']['coordinates'])
+        if len(pts) < 2 or not proj.overlaps([pts]):
+            continue
+        props = feat['properties']
+        kind = props['type']
+        attrs = {'name': props['name'], 'oneway': int(props['oneway'] or 0)}
+        if kind in PATH_TYPES:
+            attrs['class'] = 'path'
+            attrs['subclass'] = kind
+        else:
+            attrs['class'] = ROAD_CLASSES.get(kind, 'minor')
+        if props['bridge']:
+            attrs['brunnel'] = 'bridge'
+        elif props['tunnel']:
+            attrs['brunnel'] = 'tunnel'
+        transport.add(2, [pts], attrs)
+
+    for feat in data['amenities']:
+        pt = proj.project(*feat['geometry']['coordinates'])
+        if proj.overlaps([[pt]]):
+            props = feat['properties']
+            poi.add(1, [[pt]], {'class': props['type'], 'name': props['name']})
+
+    out = b''
+    for layer in (water, waterway, landuse, park, building, transport, poi):
+        if layer.features:
+            out += field(3, 2, layer.encode())
+    return out
+
+
+def main():
+    data = {name: load(name) for name in
+            ('waterareas', 'waterways', 'landusages', 'buildings', 'roads', 'amenities')}
+    for level, x, y in BELFAST_TILES:
+        with open(os.path.join(HERE, '%d_%d_%d.mvt' % (level, x, y)), 'wb') as f:
+            f.write(make_belfast_tile(TileProjection(level, x, y), data))
+
+    # mbtiles rows count up from the south already
+    db = sqlite3.connect(os.path.join(ASSETS, 'mbtiles', 'overlay_obstacles.mbtiles'))
+    for level, x, y in OBSTACLE_TILES:
+        (tile,) = db.execute('select tile_data from tiles where zoom_level=? and tile_column=? and tile_row=?',
+                             (level, x, y)).fetchone()
+        with open(os.path.join(HERE, '%d_%d_%d.mvt' % (level, x, y)), 'wb') as f:
+            f.write(gzip.decompress(tile))
+
+
+if __name__ == '__main__':
+    main()
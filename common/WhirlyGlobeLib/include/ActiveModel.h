@@ -45,6 +45,15 @@ public:
     /// Update your stuff for display, but be quick!
     virtual void updateForFrame(RendererFrameInfo *frameInfo) { }
 
+    /** Batched version of updateForFrame, which is what the scene actually calls.
+        Put your changes in the set instead of handing them to the scene.  They're
+        run along with everyone else's, once the duplicates are weeded out, and
+        show up in the frame you're updating for rather than the next one.
+        If a uniform block is all you're changing every frame,
+        Scene::setUniBlock() skips the change request entirely.
+      */
+    virtual void batchUpdateForFrame(RendererFrameInfo *frameInfo,ChangeSet &changes) { updateForFrame(frameInfo); }
+
     /// Time to clean up your toys
     virtual void teardown(PlatformThreadInfo*) { }
 };
@@ -47,6 +47,7 @@ friend class BasicDrawableBuilder;
 friend class WideVectorDrawableBuilder;
 friend class WideVectorDrawableBuilderMTL;
 friend class ShapeManager;
+friend class ScreenSpaceDrawableBuilder;
 friend class ScreenSpaceDrawableBuilderMTL;
 friend class BasicDrawableInstanceGLES;
 friend class BasicDrawableInstanceMTL;
@@ -73,10 +74,17 @@ public:
     virtual bool isOn(RendererFrameInfo *frameInfo) const override;
     /// True to turn it on, false to turn it off
     void setOnOff(bool onOff);
+
+    /// Set by renderers that check visibility by height and zoom on the GPU, so isOn() leaves those out
+    void setGPUCulled(bool newVal) { gpuCulled = newVal; }
+    bool getGPUCulled() const { return gpuCulled; }
     
     /// Return true if the shader is animating for this type of drawable
     virtual bool hasMotion() const;
 
+    /// Built by the screen space builder
+    virtual bool isScreenSpace() const override { return screenSpace; }
+
     /// Return the local MBR, if we're working in a non-geo coordinate system
     virtual Mbr getLocalMbr() const override;
 
@@ -86,6 +94,9 @@ public:
     /// Set the time range for enable
     void setEnableTimeRange(TimeInterval inStartEnable,TimeInterval inEndEnable);
 
+    /// Return the time range for enable, if there is one
+    virtual bool getEnableTimeRange(TimeInterval &start,TimeInterval &end) const override;
+
     /// Set the fade in and out
     virtual void setFade(TimeInterval inFadeDown,TimeInterval inFadeUp);
     
@@ -95,6 +106,9 @@ public:
     /// Visibility based on zoom level
     void setZoomInfo(int zoomSlot,double minZoomVis,double maxZoomVis);
 
+    /// Cone around the geometry, for skipping it when it's behind the globe
+    void setHorizonBound(const HorizonBound &bound);
+
     /// Set what range we can see this drawable within.
     /// The units are in distance from the center of the globe and
     ///  the surface of the globe as at 1.0
@@ -109,6 +123,15 @@ public:
 
     /// Draw priority used for sorting
     virtual void setDrawPriority(unsigned int newPriority);
+
+    /// Triangles we'll draw, once set up for the renderer
+    virtual unsigned int getNumTris() const override { return numTris; }
+
+    /// Vertices we'll draw, once set up for the renderer
+    unsigned int getNumPoints() const { return numPoints; }
+
+    /// Vertex and index buffers on the GPU, plus the triangles merged drawables keep around
+    virtual void getMemoryBytes(size_t &cpuBytes,size_t &gpuBytes) const override;
     
     /// Set the active transform matrix
     virtual void setMatrix(const Eigen::Matrix4d *inMat);
@@ -130,10 +153,62 @@ public:
     /// Set the line width (if using lines)
     virtual void setLineWidth(float inWidth);
 
+    /// Cycle through the first two texture slots over the period, starting at the given time.
+    /// Returns true if the shader works out the blend between them from the time, otherwise
+    /// the caller has to set u_interp every frame.
+    virtual bool setTexAnimation(TimeInterval startTime,double period,int numTextures) { return false; }
+
     /// Used to override a color that's already been built in (by changeVector:)
     virtual void setOverrideColor(RGBAColor inColor);
     virtual void setOverrideColor(unsigned char inColor[]);
 
+    /// Change the per-vertex color for a run of vertices, without rebuilding.
+    /// The renderer versions take care of it once the vertices have been uploaded.
+    virtual void setVertexColors(unsigned int startVert,unsigned int numVerts,RGBAColor inColor);
+
+    /// Where a run of vertices should be at the drawable's start time, and how they're moving.
+    /// Positions are before the drawable's matrix is applied.
+    struct VertexMotion
+    {
+        unsigned int startVert;
+        unsigned int numVerts;
+        Point3f pos;
+        Point3f dir;
+    };
+
+    /// Move runs of vertices in place, for screen space geometry with motion.
+    /// Like the vertex colors, the renderer versions write into the buffers they've uploaded.
+    virtual void setVertexMotion(const std::vector<VertexMotion> &motions);
+
+    /// One of the drawables merged into this one and which of our triangles it became
+    struct MergedRange
+    {
+        SimpleIdentity drawID;
+        unsigned int startTri;
+        unsigned int numTris;
+        bool on;
+    };
+
+    /// Check that another drawable would look the same if its geometry were part of ours
+    bool canMerge(const BasicDrawable &that) const;
+
+    /// Take over another drawable's geometry, if it's compatible and there's room.
+    /// This only works before either is set up for the renderer.  The first time, we get a new ID
+    ///  and the old one becomes a merged range, as does the other drawable's.
+    virtual bool merge(BasicDrawable &that) { return false; }
+
+    /// Set if other drawables have been merged into this one
+    bool isMerged() const { return !mergedRanges.empty(); }
+
+    /// The drawables merged into this one
+    const std::vector<MergedRange> &getMergedRanges() const { return mergedRanges; }
+
+    /// Turn the triangles for one of the merged drawables on or off
+    void setMergedOnOff(SimpleIdentity drawID,bool onOff);
+
+    /// Get rid of the triangles for one of the merged drawables.  Returns the number left.
+    int removeMerged(SimpleIdentity drawID);
+
     /// Texture ID and pointer to vertex attribute info
     class TexInfo
     {
@@ -216,12 +291,29 @@ public:
     /// For OpenGLES2, this is the program to use to render this drawable.
     virtual SimpleIdentity getProgram() const override;
     void setProgram(SimpleIdentity progId);
+
+    /// First texture ID, for grouping draws
+    virtual SimpleIdentity getSortTexture() const override;
+
+    /// Worked out from the vertex attributes the first time it's asked for
+    virtual uint64_t getVertexLayoutKey() const override;
     
 public:
     /// Update rendering for this drawable
     virtual void setValuesChanged();
     virtual void setTexturesChanged();
 
+    /// Add another drawable's vertex attributes and triangles to ours, given the point counts.
+    /// The renderer versions call this from merge(), having checked everything else.
+    bool mergeGeometry(BasicDrawable &that,std::vector<Triangle> &tris,const std::vector<Triangle> &thatTris,
+                       unsigned int numPts,unsigned int thatNumPts);
+
+    /// The triangles to draw, with the ones for merged drawables that are off collapsed to nothing
+    void maskMergedTris(std::vector<Triangle> &outTris) const;
+
+    /// The renderer versions write the masked triangles into their buffers here, if they have them
+    virtual void mergedTrisChanged() { }
+
     GeometryType type = (GeometryType)-1;
     bool on = false;  // If set, draw.  If not, not
     TimeInterval startEnable = 0.0;
@@ -237,7 +329,9 @@ public:
     int zoomSlot = 0;
     double minZoomVis = 0.0;
     double maxZoomVis = 0.0;
+    uint32_t zoomSlotMask = 0;  // See ZoomSlotMask()
     Point3d viewerCenter;
+    HorizonBound horizonBound;  // Invalid unless the builder worked one out
     int64_t drawOrder = 0;
     unsigned int drawPriority = 0;  // Used to sort drawables
     float drawOffset = 0.0f;    // Number of units of Z buffer resolution to offset upward (by the normal)
@@ -262,6 +356,8 @@ public:
 
     // Attributes associated with each vertex, some standard some not
     std::vector<VertexAttribute *> vertexAttributes;
+    // Summary of the attributes for sorting, zero until needed
+    mutable uint64_t vertexLayoutKey = 0;
     // Uniforms to be passed into a shader (just Metal for now)
     std::vector<UniformBlock> uniBlocks;
 
@@ -272,6 +368,8 @@ public:
     // We'll nuke the data arrays when we hand over the data to GL
     unsigned int numPoints = 0;
     unsigned int numTris = 0;
+    // Filled in by the renderer specific version when it sets up its buffers
+    size_t gpuBytes = 0;
     RGBAColor color = RGBAColor::white();
     bool hasOverrideColor = false;  // If set, we've changed the default color
     
@@ -284,6 +382,16 @@ public:
         
     // If set the geometry is already in OpenGL clip coordinates, so no transform
     bool clipCoords = false;
+
+    // Laid out on the screen, like labels and markers
+    bool screenSpace = false;
+
+    // If set, the renderer does the height and zoom checks
+    bool gpuCulled = false;
+
+    // Drawables merged into this one and, once the data's been handed over, all of their triangles
+    std::vector<MergedRange> mergedRanges;
+    std::vector<Triangle> mergedTris;
     
     // Set if we changed one of the general values (presumably during execution)
     bool valuesChanged = false;
@@ -315,6 +423,9 @@ protected:
     std::vector<SimpleIdentity> texIDs;
     TimeInterval startTime;
     double period;
+    // Set once the drawable is doing the blend itself
+    bool shaderInterp = false;
+    bool setup = false;
 };
 
 /** Calculates important values for the screen space texture application and
@@ -344,11 +455,45 @@ public:
     ColorChangeRequest(SimpleIdentity drawId,RGBAColor color);
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    virtual int getCoalesceSlot() const override { return 0; }
     
 protected:
     unsigned char color[4] = {0};
 };
 
+/// Change the color of some of a drawable's vertices, such as to hide one object out of many
+class VertexColorChangeRequest : public DrawableChangeRequest
+{
+public:
+    VertexColorChangeRequest(SimpleIdentity drawId,unsigned int startVert,unsigned int numVerts,RGBAColor color);
+
+    void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    /// Like visibility changes, these are small
+    virtual Priority getPriority() const override { return PriorityHigh; }
+
+protected:
+    unsigned int startVert;
+    unsigned int numVerts;
+    RGBAColor color;
+};
+
+/// Reposition and redirect runs of vertices in a moving screen space drawable
+class VertexMotionChangeRequest : public DrawableChangeRequest
+{
+public:
+    VertexMotionChangeRequest(SimpleIdentity drawId,std::vector<BasicDrawable::VertexMotion> motions);
+
+    void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    /// These come in a steady stream and should keep up with the frames
+    virtual Priority getPriority() const override { return PriorityHigh; }
+
+protected:
+    std::vector<BasicDrawable::VertexMotion> motions;
+};
+
 /// Turn a given drawable on or off.  This doesn't delete it.
 class OnOffChangeRequest : public DrawableChangeRequest
 {
@@ -356,6 +501,14 @@ public:
     OnOffChangeRequest(SimpleIdentity drawId,bool OnOff);
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    /// Turns just our part of a merged drawable on or off
+    virtual void executeMerged(Scene *scene,SceneRenderer *renderer,DrawableRef mergedDraw) override;
+
+    virtual int getCoalesceSlot() const override { return 0; }
+
+    /// Visibility changes are cheap and shouldn't wait on uploads
+    virtual Priority getPriority() const override { return PriorityHigh; }
     
 protected:
     bool newOnOff;
@@ -368,6 +521,11 @@ public:
     VisibilityChangeRequest(SimpleIdentity drawId,float minVis,float maxVis);
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    virtual int getCoalesceSlot() const override { return 0; }
+
+    /// Visibility changes are cheap and shouldn't wait on uploads
+    virtual Priority getPriority() const override { return PriorityHigh; }
     
 protected:
     float minVis,maxVis;
@@ -380,6 +538,11 @@ public:
     FadeChangeRequest(SimpleIdentity drawId,TimeInterval fadeUp,TimeInterval fadeDown);
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    virtual int getCoalesceSlot() const override { return 0; }
+
+    /// Visibility changes are cheap and shouldn't wait on uploads
+    virtual Priority getPriority() const override { return PriorityHigh; }
     
 protected:
     TimeInterval fadeUp,fadeDown;
@@ -393,6 +556,9 @@ public:
     DrawTexChangeRequest(SimpleIdentity drawId,unsigned int which,SimpleIdentity newTexId,int size,int borderTexel,int relLevel,int relX,int relY);
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    /// Each texture slot is set independently
+    virtual int getCoalesceSlot() const override { return (int)which; }
     
 protected:
     unsigned int which;
@@ -409,6 +575,8 @@ public:
     DrawTexturesChangeRequest(SimpleIdentity drawId, std::vector<SimpleIdentity> newTexIDs);
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    virtual int getCoalesceSlot() const override { return 0; }
     
 protected:
     const std::vector<SimpleIdentity> newTexIDs;
@@ -423,6 +591,8 @@ public:
     TransformChangeRequest(SimpleIdentity drawId,const Eigen::Matrix4d *newMat);
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    virtual int getCoalesceSlot() const override { return 0; }
     
 protected:
     Eigen::Matrix4d newMat;
@@ -435,6 +605,8 @@ public:
     DrawOrderChangeRequest(SimpleIdentity drawId,int64_t drawOrder);
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    virtual int getCoalesceSlot() const override { return 0; }
     
 protected:
     int64_t drawOrder;
@@ -447,6 +619,8 @@ public:
     DrawPriorityChangeRequest(SimpleIdentity drawId,int drawPriority);
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    virtual int getCoalesceSlot() const override { return 0; }
     
 protected:
     int drawPriority;
@@ -459,11 +633,42 @@ public:
     LineWidthChangeRequest(SimpleIdentity drawId,float lineWidth);
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    virtual int getCoalesceSlot() const override { return 0; }
     
 protected:
     float lineWidth;
 };
     
+/** Change the color, visibility, line width, draw priority and draw order on a drawable all at once.
+    One of these replaces a handful of separate requests when restyling lots of drawables,
+    and the drawable only gets re-sorted once if its priority or order changed.
+  */
+class DrawableStyleChangeRequest : public DrawableChangeRequest
+{
+public:
+    DrawableStyleChangeRequest(SimpleIdentity drawId,RGBAColor color,int drawPriority,int64_t drawOrder);
+
+    /// Also change the visibility range
+    void setVisibleRange(float minVis,float maxVis);
+
+    /// Also change the line width
+    void setLineWidth(float lineWidth);
+
+    void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    virtual int getCoalesceSlot() const override { return 0; }
+
+protected:
+    RGBAColor color;
+    int drawPriority;
+    int64_t drawOrder;
+    bool visSet = false;
+    float minVis = DrawVisibleInvalid, maxVis = DrawVisibleInvalid;
+    bool lineWidthSet = false;
+    float lineWidth = 1.0f;
+};
+
 /// Reset the uniforms passed into a shader for a specific drawable
 class DrawUniformsChangeRequest : public DrawableChangeRequest
 {
@@ -496,9 +701,23 @@ public:
     UniformBlockSetRequest(SimpleIdentity drawID,const RawDataRef &uniBlock,int bufferID);
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+    virtual int getCoalesceSlot() const override { return uniBlock.bufferID; }
     
 protected:
     BasicDrawable::UniformBlock uniBlock;
 };
+
+/// Set a uniform block on any of the drawables that take one.
+/// Returns false for those that don't.
+bool SetDrawableUniBlock(const DrawableRef &draw,const BasicDrawable::UniformBlock &uniBlock);
+
+/** Merge the small drawables in a set of changes that draw the same way into bigger ones.
+    Only triangle drawables that haven't been set up are considered.  The requests for
+    the ones merged away are removed and the scene will steer enable and remove requests
+    for them to the right part of what they were merged into.
+    Returns the number of drawables merged away.
+  */
+int MergeBasicDrawables(ChangeSet &changes);
     
 }
@@ -89,6 +89,23 @@ public:
     /// Set the active transform matrix
     virtual void setMatrix(const Eigen::Matrix4d &inMat);
 
+    /** Store the geometry relative to a center point in display space.
+        This sets the drawable's matrix to the translation, which the renderer combines
+        with the view in doubles, so the float coordinates stay small and don't jitter up close.
+        Call it before adding points.
+      */
+    virtual void setCenter(const Point3d &center);
+
+    /// True if there's a center set, in which case the points are relative to it
+    bool hasCenter() const { return centerValid; }
+    const Point3d &getCenter() const { return center; }
+
+    /** Work out a cone around the points so the renderer can skip them when they're behind the globe.
+        Call it once the points and the matrix are in.  Only makes sense on the globe.
+        extraHeight covers anything the shader will raise the geometry by later.
+      */
+    void calcHorizonBound(double extraHeight = 0.0);
+
     /// Resulting drawable wants the Z buffer for comparison
     virtual void setRequestZBuffer(bool val);
 
@@ -172,7 +189,9 @@ public:
     virtual void setClipCoords(bool clipCoords);
     
     /// Add a point when building up geometry.  Returns the index.
+    /// Float points are taken as already relative to the center, if there is one.
     virtual unsigned int addPoint(const Point3f &pt);
+    /// Double points are in display space and have the center taken off before they're stored
     virtual unsigned int addPoint(const Point3d &pt);
     
     /// Number of points added so far
@@ -181,7 +200,7 @@ public:
     /// Number of triangles added so far
     virtual unsigned int getNumTris() const;
 
-    /// Return a given point
+    /// Return a given point, in display space
     virtual Point3d getPoint(int which) const;
 
     /// Add a texture coordinate. -1 means we add the same
@@ -237,6 +256,18 @@ public:
     
     /// Add a triangle.  Should point to the vertex IDs.
     virtual void addTriangle(BasicDrawable::Triangle tri);
+
+    /** Take a batch of vertices already packed together, usually from an InterleavedVertexBuilder.
+        Each vertex is a Point3f followed by one element for each of the given attributes, in order.
+        The triangles refer to these vertices starting from 0.
+        Renderers that can use the packed data as is hang on to it, otherwise it's unpacked here.
+      */
+    virtual void addInterleavedVertices(std::vector<unsigned char> &&verts,int vertexSize,
+                                        const std::vector<int> &attrIDs,
+                                        const std::vector<BasicDrawable::Triangle> &newTris);
+
+    /// Check that a packed layout matches the attributes it's going into
+    bool checkInterleavedLayout(int vertexSize,const std::vector<int> &attrIDs) const;
     
     /// TODO: We need a per-triangle attribute instead of stuffing data always into the vertex attributes
     
@@ -260,6 +291,20 @@ public:
     /// Check for the given texture coordinate entry and add it if it's not there
     virtual void setupTexCoordEntry(int which,int numReserve);
 
+    /// Keep normals as normalized bytes, a third of the size.  Call before adding any.
+    void setCompactNormals();
+
+    /// Keep texture coordinates as half floats, half the size.  Call before adding any.
+    /// Fine for a single texture, less so for coordinates into a big atlas.
+    void setCompactTexCoords();
+
+    /// Name runs of our triangles with their own IDs, as if they'd been merged in.
+    /// Call once all the triangles are in.  Anything not in a range won't draw.
+    void setMergedRanges(std::vector<BasicDrawable::MergedRange> ranges);
+
+    /// Data type we'll use for new texture coordinate entries
+    BDAttributeDataType texCoordType() const { return compactTexCoords ? BDHalf2Type : BDFloat2Type; }
+
     /// We need slightly different tweakers for the rendering variants
     virtual DrawableTweakerRef makeTweaker() const { return {}; }
 
@@ -292,6 +337,12 @@ protected:
     void setName(std::string name);
 
     bool includeExp = false;
+    bool compactTexCoords = false;
+    bool centerValid = false;
+    Point3d center = Point3d(0,0,0);
+
+    // Switch an attribute to another type, if nothing's been added to it yet
+    void changeAttributeType(int attrID,BDAttributeDataType dataType);
 
     ColorExpressionInfoRef colorExp;
     FloatExpressionInfoRef opacityExp;
@@ -44,11 +44,27 @@ public:
     /// Fill out and return the drawable
     virtual BasicDrawableRef getDrawable() override;
 
+    /// We keep packed vertices as they are and upload them in one go
+    virtual void addInterleavedVertices(std::vector<unsigned char> &&verts,int vertexSize,
+                                        const std::vector<int> &attrIDs,
+                                        const std::vector<BasicDrawable::Triangle> &newTris) override;
+
+    /// Includes the packed vertices
+    virtual unsigned int getNumPoints() const override;
+
 protected:
     virtual DrawableTweakerRef makeTweaker() const override;
     virtual void setupTweaker(const DrawableTweakerRef &inTweaker) const override;
 
+    // Any other vertex data rules out handing over the packed vertices as is
+    bool hasUnpackedVertices() const;
+
     bool drawableGotten;
+
+    // Packed vertices, if that's how we got them
+    std::vector<unsigned char> interleavedVerts;
+    int interleavedVertexSize = 0;
+    std::vector<int> interleavedAttrs;
 };
     
 }
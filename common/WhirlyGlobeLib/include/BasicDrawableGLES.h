@@ -55,21 +55,46 @@ public:
     
     /// Fill this in to draw the basic drawable
     virtual void draw(RendererFrameInfoGLES *frameInfo,Scene *scene);
+
+    /// We just repeat the draw call with new matrices for other copies of the world
+    virtual bool drawsWorldCopies() const override { return true; }
     
     /// Check if this has been set up and (more importantly) hasn't been torn down
     virtual bool isSetupInGL();
+
+    /// Change per-vertex colors, in the buffer if we've already uploaded it
+    virtual void setVertexColors(unsigned int startVert,unsigned int numVerts,RGBAColor inColor) override;
+
+    /// Move vertices, in the buffer if we've already uploaded it
+    virtual void setVertexMotion(const std::vector<VertexMotion> &motions) override;
+
+    /// Take over another plain GLES drawable's geometry, before either is uploaded
+    virtual bool merge(BasicDrawable &that) override;
+
+    /// Rewrite the triangles in the buffer when a merged drawable turns on or off
+    virtual void mergedTrisChanged() override;
     
     /// Size of a single vertex used in creating an interleaved buffer.
     virtual unsigned int singleVertexSize();
 
+    /// Turn attributes with the same value on every vertex into defaults
+    /// so they don't take up room in the buffer.  Recalculates the vertex size.
+    void collapseConstantAttributes();
+
     /// Add a single point to the GL Buffer.
     /// Override this to add your own data to interleaved vertex buffers.
     virtual void addPointToBuffer(unsigned char *basePtr,int which,const Point3d *center);
 
+    /// Use vertices the builder already packed, a position and then the given attributes.
+    /// These go into the buffer as is, in place of the points and attribute arrays.
+    void setInterleavedVertices(std::vector<unsigned char> &&verts,int vertSize,const std::vector<int> &attrIDs);
+
 public:
     // Unprocessed data arrays
     std::vector<Eigen::Vector3f> points;
     std::vector<Triangle> tris;
+    // Or the packed version, laid out like the buffer
+    std::vector<unsigned char> interleavedVerts;
 
     // Attribute that should be applied to the given program index if using VAOs
     struct VertAttrDefault
@@ -90,6 +115,14 @@ public:
     GLuint triBuffer = 0;
     GLuint sharedBuffer = 0;
     GLuint vertArrayObj = 0;
+    // The program the VAO was set up for, since it holds that program's attribute locations
+    GLuint vertArrayProg = 0;
+    // Set if the VAO has the colors turned on, so we can put them back after an override
+    bool vertArrayHasColor = false;
+    // Where the colors are within a vertex in the shared buffer, if they're there
+    int colorOffset = -1;
+    // Same for the motion direction, for moving screen space geometry
+    int dirOffset = -1;
 };
     
 }
@@ -75,6 +75,12 @@ public:
     
     /// For OpenGLES2, this is the program to use to render this drawable.
     virtual SimpleIdentity getProgram() const;
+
+    /// Our own texture if we have one, otherwise the base drawable's
+    virtual SimpleIdentity getSortTexture() const override;
+
+    /// The base drawable's vertex layout
+    virtual uint64_t getVertexLayoutKey() const override;
     
     /// Set the shader program
     void setProgram(SimpleIdentity progID);
@@ -101,6 +107,18 @@ public:
     
     /// Set the time range for enable
     void setEnableTimeRange(TimeInterval inStartEnable,TimeInterval inEndEnable);
+
+    /// Return the time range for enable, if there is one
+    virtual bool getEnableTimeRange(TimeInterval &start,TimeInterval &end) const override;
+
+    /// Set the fade in and out.  If they're not set, we use the base drawable's.
+    void setFade(TimeInterval inFadeDown,TimeInterval inFadeUp);
+
+    /// Return our own fade times, if we have them
+    bool getFade(TimeInterval &outFadeDown,TimeInterval &outFadeUp) const;
+
+    /// Screen space if the base drawable is
+    virtual bool isScreenSpace() const override;
     
     /// Set the min/max visible range
     void setVisibleRange(float inMinVis,float inMaxVis);
@@ -110,6 +128,9 @@ public:
     
     /// Visibility based on zoom level
     void setZoomInfo(int zoomSlot,double minZoomVis,double maxZoomVis);
+
+    /// Zoom slot for expressions and visibility, -1 if there isn't one
+    int getZoomSlot() const { return zoomSlot; }
     
     /// Set the color
     virtual void setColor(RGBAColor inColor);
@@ -185,6 +206,11 @@ public:
     
     /// For Metal, we can set instance data in one big chunk
     virtual void setInstanceData(int numInstances,RawDataRef data);
+
+    /// Replace a run of local instances in place, starting with the given one.
+    /// The number of instances stays the same and the renderer versions write
+    /// straight into the instance buffer they've already uploaded.
+    virtual void setInstances(unsigned int startInst,const std::vector<SingleInstance> &insts);
     
 protected:
     /// Update rendering for this drawable
@@ -200,6 +226,7 @@ protected:
     BasicDrawableRef instDraw;
     bool enable;
     TimeInterval startEnable,endEnable;
+    TimeInterval fadeUp = 0.0,fadeDown = 0.0;
     bool hasDrawOrder = false;
     int64_t drawOrder;
     bool hasDrawPriority;
@@ -213,11 +240,13 @@ protected:
     double minViewerDist,maxViewerDist;
     int zoomSlot;
     double minZoomVis,maxZoomVis;
+    uint32_t zoomSlotMask = 0;  // See ZoomSlotMask()
     Point3d viewerCenter;
     int numInstances;
     
     TimeInterval startTime;
     bool moving;
+    bool packedInstances = false;
     // Uniforms to apply to shader
     SingleVertexAttributeSet uniforms;
     // Uniforms to be passed into a shader (just Metal for now)
@@ -245,4 +274,17 @@ protected:
 /// Reference counted version of BasicDrawableInstance
 typedef std::shared_ptr<BasicDrawableInstance> BasicDrawableInstanceRef;
 
+/// Move, recolor or otherwise change a run of instances without rebuilding the drawable
+class InstancesChangeRequest : public DrawableChangeRequest
+{
+public:
+    InstancesChangeRequest(SimpleIdentity drawId,unsigned int startInst,std::vector<BasicDrawableInstance::SingleInstance> insts);
+
+    void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
+
+protected:
+    unsigned int startInst;
+    std::vector<BasicDrawableInstance::SingleInstance> insts;
+};
+
 }
@@ -53,8 +53,7 @@ public:
     /// Set the time range for enable
     void setEnableTimeRange(TimeInterval inStartEnable,TimeInterval inEndEnable);
     
-    /// Set the fade in and out
-    // Not supported for instances
+    /// Set the fade in and out.  If not set, the base drawable's apply.
     void setFade(TimeInterval inFadeDown,TimeInterval inFadeUp);
         
     /// Set the viewer based visibility
@@ -98,6 +97,10 @@ public:
     // Time we start counting from for motion
     void setStartTime(TimeInterval inStartTime);
 
+    /// The instance matrices hold data for the shader rather than transforms,
+    ///  so they can only be drawn with GPU instancing
+    void setPackedInstances(bool packed);
+
     /// Add a instance to the stack of instances this instance represents (mmm, noun overload)
     void addInstances(const std::vector<BasicDrawableInstance::SingleInstance> &insts);
     
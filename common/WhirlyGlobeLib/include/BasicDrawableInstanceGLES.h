@@ -44,8 +44,14 @@ public:
     /// Set up what you need in the way of context and draw.
     virtual void draw(RendererFrameInfoGLES *frameInfo,Scene *scene);
 
+    /// Rewrite part of the instance buffer, if we've set one up
+    virtual void setInstances(unsigned int startInst,const std::vector<SingleInstance> &insts) override;
+
 protected:
     GLuint setupVAO(RendererFrameInfoGLES *frameInfo);
+
+    // Fill in one instance's record in the instance buffer
+    void writeInstance(unsigned char *basePtr,const SingleInstance &inst) const;
     
     int centerSize = 0;
     int matSize = 0;
@@ -55,6 +61,8 @@ protected:
     int modelDirSize = 0;
     GLuint instBuffer = 0U;
     GLuint vertArrayObj = 0U;
+    GLuint vertArrayProg = 0U;
+    bool vertArrayHasColor = false;
     std::vector<BasicDrawableGLES::VertAttrDefault> vertArrayDefaults;
 };
 
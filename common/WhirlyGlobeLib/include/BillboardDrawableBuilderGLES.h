@@ -31,6 +31,10 @@ namespace WhirlyKit
 ProgramGLES *BuildBillboardGroundProgramGLES(const std::string &name,SceneRenderer *render);
 ProgramGLES *BuildBillboardEyeProgramGLES(const std::string &name,SceneRenderer *render);
 
+/// Billboards drawn as instances of a unit quad
+ProgramGLES *BuildBillboardGroundInstanceProgramGLES(const std::string &name,SceneRenderer *render);
+ProgramGLES *BuildBillboardEyeInstanceProgramGLES(const std::string &name,SceneRenderer *render);
+
 /** OpenGL version of BillboardDrawable Builder
  */
 class BillboardDrawableBuilderGLES : public BasicDrawableBuilderGLES, public BillboardDrawableBuilder
@@ -24,6 +24,7 @@
 #import "Identifiable.h"
 #import "BasicDrawable.h"
 #import "BillboardDrawableBuilder.h"
+#import "BasicDrawableInstanceBuilder.h"
 #import "Scene.h"
 #import "SelectionManager.h"
 #import "BaseInfo.h"
@@ -76,7 +77,9 @@ public:
     bool isSelectable;
     /// Unique ID for selection
     WhirlyKit::SimpleIdentity selectID;
-
+    /// If set, this billboard can be turned on and off or removed on its own with this ID.
+    /// It still shares drawables with the rest, so nothing else has to be rebuilt.
+    WhirlyKit::SimpleIdentity partID;
 };
 
 // Used to pass parameters around between threads
@@ -90,6 +93,8 @@ public:
     typedef enum {Eye=0,Ground} Orient;
     Orient orient;
     RGBAColor color;
+    /// Draw plain billboards as instances of one quad, rather than four vertices apiece
+    bool instanced = false;
 };
 typedef std::shared_ptr<BillboardInfo> BillboardInfoRef;
 
@@ -102,8 +107,26 @@ struct BillboardSceneRep : public Identifiable
     // Clear the contents out of the scene
     void clearContents(SelectionManagerRef &selectManager,ChangeSet &changes,TimeInterval when);
 
+    // A billboard drawn as an instance, and what we gave it
+    struct Instance
+    {
+        SimpleIdentity drawID;
+        unsigned int which;
+        BasicDrawableInstance::SingleInstance inst;
+    };
+
+    // Billboards with their own part ID
+    struct Part
+    {
+        SimpleIDSet drawIDs;  // Triangle ranges within our drawables
+        std::vector<Instance> insts;  // Or instances within our instance drawables
+        SimpleIdentity selectID = EmptyIdentity;
+    };
+
     SimpleIDSet drawIDs;  // Drawables created for this
+    SimpleIDSet quadIDs;  // Quads the instances are based on, never turned on
     SimpleIDSet selectIDs;  // IDs used for selection
+    std::map<SimpleIdentity,Part> parts;
     float fadeOut = 0.0;  // Time to fade away for removal
 };
 
@@ -115,16 +138,24 @@ class BillboardBuilder
 public:
     BillboardBuilder(Scene *scene,SceneRenderer *sceneRender,ChangeSet &changes,
                      BillboardSceneRep *sceneRep,const BillboardInfo &billInfo,
-                     SimpleIdentity billboardProgram,SimpleIdentity texId);
+                     SimpleIdentity billboardProgram,SimpleIdentity texId,
+                     SimpleIdentity instProgram = EmptyIdentity);
     ~BillboardBuilder();
 
     void addBillboard(const Point3d &center,const Point2dVector &pts,
                       const std::vector<WhirlyKit::TexCoord> &texCoords,
-                      const RGBAColor *inColor,const SingleVertexAttributeSet &vertAttrs);
+                      const RGBAColor *inColor,const SingleVertexAttributeSet &vertAttrs,
+                      SimpleIdentity partID = EmptyIdentity);
 
     void flush();
 
 protected:
+    // Add a billboard as an instance, if it's a simple textured rectangle
+    bool addInstance(const Point3d &center,const Point2dVector &pts,
+                     const std::vector<WhirlyKit::TexCoord> &texCoords,
+                     const RGBAColor &color,SimpleIdentity partID);
+    void flushInstances();
+
     Scene *scene;
     SceneRenderer *sceneRender;
     ChangeSet &changes;
@@ -134,6 +165,15 @@ protected:
     BillboardSceneRep *sceneRep;
     SimpleIdentity billboardProgram;
     SimpleIdentity texId;
+    // Triangle ranges for the current drawable, if any billboards in it have part IDs
+    std::vector<BasicDrawable::MergedRange> ranges;
+    SimpleIdentity lastPartID;
+    bool hasParts;
+    // Instanced billboards share a quad, if there's a program for them
+    SimpleIdentity instProgram;
+    BillboardDrawableBuilderRef quadDraw;
+    BasicDrawableInstanceBuilderRef instDraw;
+    std::vector<BasicDrawableInstance::SingleInstance> insts;
 };
 typedef std::shared_ptr<BillboardBuilder> BillboardBuilderRef;
 
@@ -157,6 +197,14 @@ public:
     /// Remove a group of billboards named by the given ID
     void removeBillboards(const SimpleIDSet &billIDs,ChangeSet &changes);
 
+    /// Enable/disable individual billboards within a group, by their part IDs
+    void enableBillboardParts(SimpleIdentity billID,const SimpleIDSet &partIDs,bool enable,ChangeSet &changes);
+
+    /// Remove individual billboards from a group, by their part IDs.
+    /// The rest of the group stays where it is.  Instanced billboards are hidden
+    ///  until the group goes, since their buffer doesn't shrink.
+    void removeBillboardParts(SimpleIdentity billID,const SimpleIDSet &partIDs,ChangeSet &changes);
+
 protected:
     BillboardSceneRepSet sceneReps;
 };
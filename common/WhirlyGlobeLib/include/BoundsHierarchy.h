@@ -0,0 +1,104 @@
+/*  BoundsHierarchy.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import "WhirlyVector.h"
+
+namespace WhirlyKit
+{
+
+/// Node in one of the bounding volume hierarchies.
+/// Leaves have a range of entries, interior nodes have children.
+template<typename PointType>
+struct BoundsHierarchyNode
+{
+    PointType ll,ur;
+    int first,count;
+    int left,right;
+};
+
+/** Sort a range of items into a bounding volume hierarchy and return the subtree's node.
+    This is the build the SelectionIndex, VectorObjectIndex and TriangleIndex share.
+    <br>
+    expand(item,ll,ur) grows the bounds to take in an item and center(item) is where it
+    sits for splitting.  Ranges of leafSize or fewer become leaves.  They get first and count
+    for their range unless makeLeaf(node,first,count) does something else with them.
+  */
+template<typename NodeVec,typename ItemVec,typename ExpandFunc,typename CenterFunc,typename LeafFunc>
+int BuildBoundsHierarchy(NodeVec &nodes,ItemVec &items,int first,int count,int leafSize,
+                         const ExpandFunc &expand,const CenterFunc &center,const LeafFunc &makeLeaf)
+{
+    typedef typename NodeVec::value_type Node;
+    typedef decltype(Node::ll) PointType;
+
+    const PointType firstCenter = center(items[first]);
+    Node node { firstCenter, firstCenter, 0, 0, -1, -1 };
+    PointType centerLL = firstCenter, centerUR = firstCenter;
+    for (int ii=first;ii<first+count;ii++)
+    {
+        expand(items[ii],node.ll,node.ur);
+        const PointType itemCenter = center(items[ii]);
+        centerLL = centerLL.cwiseMin(itemCenter);
+        centerUR = centerUR.cwiseMax(itemCenter);
+    }
+
+    const int which = (int)nodes.size();
+    if (count <= leafSize)
+    {
+        node.first = first;
+        node.count = count;
+        makeLeaf(node,first,count);
+        nodes.push_back(node);
+        return which;
+    }
+    nodes.push_back(node);
+
+    // Split on the median along whichever way the centers are most spread out
+    int axis = 0;
+    const PointType spread = centerUR - centerLL;
+    for (int ii=1;ii<spread.size();ii++)
+        if (spread[ii] > spread[axis])
+            axis = ii;
+    const int mid = first + count / 2;
+    typedef typename ItemVec::value_type Item;
+    std::nth_element(items.begin() + first,items.begin() + mid,items.begin() + first + count,
+                     [axis,&center](const Item &a,const Item &b) { return center(a)[axis] < center(b)[axis]; });
+
+    const int left = BuildBoundsHierarchy(nodes,items,first,mid - first,leafSize,expand,center,makeLeaf);
+    const int right = BuildBoundsHierarchy(nodes,items,mid,first + count - mid,leafSize,expand,center,makeLeaf);
+    nodes[which].left = left;
+    nodes[which].right = right;
+    return which;
+}
+
+/// Build over items with their own ll and ur, leaving the leaves pointing at them
+template<typename NodeVec,typename ItemVec>
+int BuildBoundsHierarchy(NodeVec &nodes,ItemVec &items,int first,int count,int leafSize)
+{
+    typedef typename ItemVec::value_type Item;
+    typedef typename NodeVec::value_type Node;
+    typedef decltype(Node::ll) PointType;
+    return BuildBoundsHierarchy(nodes,items,first,count,leafSize,
+                                [](const Item &item,PointType &ll,PointType &ur) {
+                                    ll = ll.cwiseMin(item.ll);
+                                    ur = ur.cwiseMax(item.ur);
+                                },
+                                [](const Item &item) -> PointType { return (item.ll + item.ur) / 2.0; },
+                                [](Node &,int,int) { });
+}
+
+}
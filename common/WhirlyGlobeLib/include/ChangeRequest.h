@@ -19,6 +19,7 @@
 #import <vector>
 #import <set>
 #import <map>
+#import <atomic>
 #import "Identifiable.h"
 #import "StringIndexer.h"
 #import "WhirlyKitView.h"
@@ -67,6 +68,10 @@ class ChangeRequest
 public:
     ChangeRequest() = default;
     virtual ~ChangeRequest() = default;
+
+    /// When change processing runs over its budget for a frame, high priority
+    ///  requests (removals, visibility) still go through, others wait.
+    typedef enum {PriorityHigh=0,PriorityNormal,PriorityLow} Priority;
     
     /// Return true if this change requires a GL Flush in the thread it was executed in
     virtual bool needsFlush();
@@ -80,8 +85,35 @@ public:
     /// Set this if you need to be run before the active models are run
     virtual bool needPreExecute();
 
+    /// How urgent this change is, relative to others
+    virtual Priority getPriority() const;
+
+    /// Rough number of bytes this change will push to the GPU.
+    /// Counts against the per-frame byte budget.
+    virtual size_t getUploadSize() const;
+
+    /// ID of the drawable or texture this change operates on, if there is just one.
+    /// We use this to keep dependent changes in order when some are deferred.
+    virtual SimpleIdentity getTargetID() const;
+
+    /// If this change just sets one piece of state on its target, return a slot number.
+    /// A later change of the same type, target and slot replaces this one.
+    /// The default, -1, means it always runs.
+    virtual int getCoalesceSlot() const;
+
     /// If non-zero we'll execute this request after the given absolute time
     TimeInterval when = 0.0;
+
+    /// Change requests are allocated out of a pool of fixed size slots.
+    /// Each thread keeps its own free list and trades slots with the shared pool in batches,
+    ///  so requests made on a layer thread and deleted on the render thread don't fight
+    ///  over the system allocator.  Large requests fall back to the regular heap.
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr,size_t size);
+
+    /// Hand this thread's free slots back to the shared pool.
+    /// The renderer calls this after executing a batch of changes.
+    static void releasePoolCache();
 };
 
 /// Representation of a list of changes.  Might get more complex in the future.
@@ -101,5 +133,53 @@ typedef struct ChangeSorter
 } ChangeSorter;
 /// This version is sorted by when to run it
 typedef std::set<ChangeRequest *,ChangeSorter> SortedChangeSet;
+
+/** Multiple producer, single consumer queue of change requests.
+    Layer threads push whole change sets without taking a lock and the
+    render thread takes everything outstanding with a single atomic swap.
+    Order is preserved between pushes.
+  */
+class ChangeRequestQueue
+{
+public:
+    ChangeRequestQueue() = default;
+    ChangeRequestQueue(const ChangeRequestQueue &) = delete;
+    ChangeRequestQueue &operator=(const ChangeRequestQueue &) = delete;
+    /// Anything still pending is deleted
+    ~ChangeRequestQueue();
+
+    /// Add a list of changes.  Any thread.  The list is cleared.
+    void push(ChangeSet &newChanges);
+
+    /// Add a single change.  Any thread.
+    void push(ChangeRequest *newChange);
+
+    /// Move everything pending onto the end of the given list, in the order it was pushed.
+    /// Only the consumer (render) thread should call this.
+    /// Returns the number of change requests moved.
+    int drain(ChangeSet &dest);
+
+    /// True if nothing is pending.  This is only a hint when called off the consumer thread.
+    bool empty() const { return head.load(std::memory_order_acquire) == nullptr; }
+
+    /// Number of change requests pushed, but not yet drained
+    int size() const { return numPending.load(std::memory_order_relaxed); }
+
+    /// Number of change sets pushed since the last call.  Used for performance reporting.
+    int takeBatchCount() { return numBatches.exchange(0, std::memory_order_relaxed); }
+
+protected:
+    struct Node
+    {
+        ChangeSet changes;
+        Node *next = nullptr;
+    };
+
+    void pushNode(Node *node);
+
+    std::atomic<Node *> head { nullptr };
+    std::atomic<int> numPending { 0 };
+    std::atomic<int> numBatches { 0 };
+};
     
 }
@@ -0,0 +1,108 @@
+/*  ClusterHierarchy.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import "WhirlyVector.h"
+
+namespace WhirlyKit
+{
+
+/** Static 2D index over a set of points, sorted into a flat KD-tree.
+    Built once, then queried by box or by radius.
+  */
+class ClusterKDIndex
+{
+public:
+    /// Index the given points, replacing what was there
+    void build(const std::vector<double> &inXs,const std::vector<double> &inYs);
+
+    /// Indices of the points inside the box
+    void range(double minX,double minY,double maxX,double maxY,std::vector<int> &results) const;
+
+    /// Indices of the points within the given distance of a point
+    void within(double x,double y,double radius,std::vector<int> &results) const;
+
+protected:
+    std::vector<int> ids;
+    std::vector<double> coords;     // x,y pairs in tree order
+};
+
+/** Clustering of a set of points worked out ahead of time for a range of zoom levels.
+    This is the approach Supercluster takes.  Points are in normalized Mercator ([0,1] across the world)
+    and at each level, starting with the most detailed, anything within the cluster radius of a
+    point left over from the level below is merged into it.
+    Once built, picking out the clusters for a view is a box query on one level.
+  */
+class ClusterHierarchy
+{
+public:
+    /// Radius is in pixels, as is the tile size.  A level's world is tileSize * 2^zoom pixels across.
+    ClusterHierarchy(int minZoom,int maxZoom,double radius,double tileSize = 256.0);
+
+    /// A point or a cluster at a given level
+    struct Node
+    {
+        double x,y;
+        int numPoints;
+        /// Which input point, if this is just the one
+        int leaf;
+        /// Nodes this came from, in the level below
+        int firstChild,numChildren;
+    };
+
+    /// Work out the clusters for the given points in normalized Mercator.
+    /// Returns false if cancelled partway through.
+    bool build(const std::vector<double> &xs,const std::vector<double> &ys,volatile bool &cancel);
+
+    /// The level to use when one normalized unit covers this many pixels.
+    /// Past the last level this is maxZoom+1, where every point is on its own.
+    int zoomForScale(double pixelsPerUnit) const;
+
+    /// Nodes for the given level within the box
+    void query(int zoom,double minX,double minY,double maxX,double maxY,std::vector<int> &nodes) const;
+
+    /// A single node for the given level
+    const Node &getNode(int zoom,int which) const;
+
+    /// The input points for a node
+    void getLeaves(int zoom,int which,std::vector<int> &leaves) const;
+
+    /// Pixel radius we clustered with
+    double getRadius() const { return radius; }
+
+    /// Number of input points
+    size_t getNumPoints() const { return levels.empty() ? 0 : levels.back().nodes.size(); }
+
+protected:
+    struct Level
+    {
+        std::vector<Node> nodes;
+        std::vector<int> children;
+        ClusterKDIndex index;
+    };
+
+    // Index the nodes for a level once they're filled in
+    static void indexLevel(Level &level);
+
+    int minZoom,maxZoom;
+    double radius;
+    double tileSize;
+    // From minZoom up to maxZoom+1, which has the input points
+    std::vector<Level> levels;
+};
+
+}
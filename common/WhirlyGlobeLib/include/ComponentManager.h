@@ -33,6 +33,7 @@
 #import "VectorObject.h"
 #import "WideVectorManager.h"
 #import "SelectionManager.h"
+#import "VectorObjectIndex.h"
 
 namespace WhirlyKit
 {
@@ -206,14 +207,24 @@ protected:
                                        const SimpleIDSet &compIDs,
                                        std::vector<ComponentObjectRef> &objs);
 
+    // Turn on or off the IDs in a component object, or a bunch of them gathered together
+    template <typename T>
+    void enableContents(T &ids, bool enable, ChangeSet &changes);
+
     template <typename TIter>
     void setRepresentation(const std::string &repName,
                            const std::string &fallback,
                            TIter beg, TIter end,
                            ChangeSet &changes);
 
+    // Put a component object's vectors in the index.  Lock must be held.
+    void indexVectors(const ComponentObject &compObj);
+
     ComponentObjectMap compObjsById;
 
+    // Bounds of the vectors in the component objects, for findVectors
+    VectorObjectIndex vecIndex;
+
     std::unordered_multimap<std::string, ComponentObjectRef> compObjsByUUID;
 
     std::unordered_map<std::string, std::string> representations;
@@ -0,0 +1,55 @@
+/*  CompressedImage.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <cstddef>
+#import "RawData.h"
+
+namespace WhirlyKit
+{
+
+/// Block compressed formats the GPU can take without decoding
+typedef enum {CompressedNone,
+    CompressedETC2_RGB8,CompressedETC2_RGB8A1,CompressedETC2_RGBA8,
+    CompressedEAC_R11,CompressedEAC_R11Signed,CompressedEAC_RG11,CompressedEAC_RG11Signed,
+    CompressedASTC} CompressedFormat;
+
+/** What we found in the header of a compressed image.
+    Only the first mip level is used.  It's at offset in the data and runs for size bytes.
+  */
+struct CompressedImageInfo
+{
+    CompressedFormat format = CompressedNone;
+    /// ASTC block sizes vary, the rest are 4x4
+    int blockWidth = 4, blockHeight = 4;
+    bool sRGB = false;
+    int width = 0, height = 0;
+    size_t offset = 0, size = 0;
+
+    int bytesPerBlock() const;
+    int blocksWide() const { return (width + blockWidth - 1) / blockWidth; }
+    int blocksHigh() const { return (height + blockHeight - 1) / blockHeight; }
+    /// Position of the block size in the ASTC list (4x4, 5x4, 5x5 ... 12x12), or -1
+    int astcBlockIndex() const;
+};
+
+/** Look for a compressed image we can hand straight to the renderer.
+    Understands PKM, KTX (1 and 2) holding ETC2/EAC or ASTC, and .astc files.
+    Returns false for anything else, such as PNG or JPEG, or if the data is cut short.
+  */
+bool ParseCompressedImage(const RawData &data,CompressedImageInfo &info);
+
+}
@@ -70,7 +70,15 @@ public:
     /// Convert from display coordinates to geocentric
     virtual Point3f geocentricToLocal(Point3f) const = 0;
     virtual Point3d geocentricToLocal(Point3d) const = 0;
-    
+
+    /// Convert a run of points at once.  The defaults call the single point versions.
+    /// Subclasses do better where they can, without a virtual call per point.
+    /// For the Point3d to Point3d versions the output can be the input.
+    virtual void geographicToLocalBatch(const Point2d *geo,Point3d *local,size_t count) const;
+    virtual void localToGeographicBatch(const Point3d *local,Point2d *geo,size_t count) const;
+    virtual void localToGeocentricBatch(const Point3d *local,Point3d *geoc,size_t count) const;
+    virtual void geocentricToLocalBatch(const Point3d *geoc,Point3d *local,size_t count) const;
+
     /// Return true if the given coordinate system is the same as the one passed in
     virtual bool isSameAs(const CoordSystem *coordSys) const { return false; }
 };
@@ -80,6 +88,8 @@ typedef std::shared_ptr<CoordSystem> CoordSystemRef;
 /// Convert a point from one coordinate system to another
 Point3f CoordSystemConvert(const CoordSystem *inSystem,const CoordSystem *outSystem,const Point3f &inCoord);
 Point3d CoordSystemConvert3d(const CoordSystem *inSystem,const CoordSystem *outSystem,const Point3d &inCoord);
+/// Convert a run of points from one coordinate system to another.  The output can be the input.
+void CoordSystemConvertBatch(const CoordSystem *inSystem,const CoordSystem *outSystem,const Point3d *inCoords,Point3d *outCoords,size_t count);
     
 /** The Coordinate System Display Adapter handles the task of
     converting coordinates in the native system to data values we
@@ -147,6 +157,10 @@ public:
     virtual Point3f normalForLocal(Point3f) const = 0;
     virtual Point3d normalForLocal(Point3d) const = 0;
 
+    /// Convert a run of points from local to display coordinates.  The output can be the input.
+    /// The default calls localToDisplay for each one.
+    virtual void localToDisplayBatch(const Point3d *local,Point3d *disp,size_t count) const;
+
     /// Get a reference to the coordinate system
     virtual CoordSystem *getCoordSystem() const = 0;
     
@@ -192,6 +206,9 @@ public:
     /// For flat systems the normal is Z up.
     virtual Point3f normalForLocal(Point3f) const override { return Point3f(0,0,1); }
     virtual Point3d normalForLocal(Point3d) const override { return Point3d(0,0,1); }
+
+    /// Scale and offset a run of points
+    virtual void localToDisplayBatch(const Point3d *local,Point3d *disp,size_t count) const override;
     
     /// Get a reference to the coordinate system
     virtual CoordSystem *getCoordSystem() const override { return coordSys; }
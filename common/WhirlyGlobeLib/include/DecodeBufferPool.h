@@ -0,0 +1,68 @@
+/*  DecodeBufferPool.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <mutex>
+#import <unordered_map>
+#import "RawData.h"
+
+namespace WhirlyKit
+{
+
+/** Recycles the buffers tile images are decoded into.
+    Tiles come in a few sizes and a texture lets go of its data once it's uploaded,
+    so rather than allocating for every tile the same buffers go around again.
+    Buffers come back when the RawData wrapping them goes away, so a pool has to
+    outlive anything it hands out.  The shared one is never deleted.
+  */
+class DecodeBufferPool
+{
+public:
+    DecodeBufferPool(size_t maxBytes = DefaultMaxBytes);
+    ~DecodeBufferPool();
+
+    /// The one the image decoders share
+    static DecodeBufferPool &getShared();
+
+    /// Most we'll hang on to when nobody's using them
+    static const size_t DefaultMaxBytes = 16 * 1024 * 1024;
+
+    /// A buffer of the given length, which can be written through bytes until it's handed off.
+    /// The contents are whatever was there last.
+    RawDataRef getBuffer(size_t len,unsigned char **bytes);
+
+    /// Change the most we'll keep around.  Anything over is freed.
+    void setMaxBytes(size_t maxBytes);
+    size_t getMaxBytes() const;
+
+    /// Bytes sitting in the pool right now
+    size_t getBytesHeld() const;
+
+    /// Free everything not in use
+    void clear();
+
+protected:
+    void returnBuffer(unsigned char *buf,size_t len);
+    // Free until we're under the limit.  Lock must be held.
+    void trim();
+
+    mutable std::mutex lock;
+    std::unordered_multimap<size_t,unsigned char *> buffers;
+    size_t maxBytes;
+    size_t bytesHeld = 0;
+};
+
+}
@@ -35,15 +35,17 @@ typedef std::shared_ptr<MutableDictionaryC> MutableDictionaryCRef;
 class DictionaryEntryC;
 typedef std::shared_ptr<DictionaryEntryC> DictionaryEntryCRef;
 
-/// The Dictionary is my cross platform replacement for NSDictionary
-/// TODO: Removing & adding things repeatedly will just cause this to grow
+/** The Dictionary is my cross platform replacement for NSDictionary.
+    Fields are kept in a flat array sorted by key, with numbers stored inline.
+    Keys and string values are interned in one table per dictionary, and the
+    whole thing is shared between copies until one of them is modified.
+    TODO: Removing & adding things repeatedly will just cause this to grow
+  */
 class MutableDictionaryC : public MutableDictionary
 {
 public:
     MutableDictionaryC();
     MutableDictionaryC(int capacity);
-    // Construct from a raw data buffer
-//    MutableDictionaryC(RawData *rawData);
     // Copy constructor
     MutableDictionaryC(const MutableDictionaryC &that);
     // Move constructor
@@ -54,6 +56,7 @@ public:
     MutableDictionaryC &operator = (MutableDictionaryC &&that) noexcept;
     virtual ~MutableDictionaryC() = default;
 
+    /// Copies share their contents until one of them changes, so this is cheap
     virtual MutableDictionaryRef copy() const override { return std::make_shared<MutableDictionaryC>(*this); }
 
     // Parse from a JSON string
@@ -68,7 +71,7 @@ public:
     void clear() override;
     
     /// Number of fields being represented
-    int numFields() const { return valueMap.size(); }
+    int numFields() const { return data ? (int)data->fields.size() : 0; }
 
     /// Returns true if the field exists
     virtual bool hasField(const std::string &name) const override;
@@ -77,6 +80,9 @@ public:
     /// Returns the field type
     virtual DictionaryType getType(const std::string &name) const override;
     virtual DictionaryType getType(unsigned int key) const;
+    /// Look up a value without making an entry for it.
+    /// Numbers come back in numVal, strings as a pointer into the dictionary, good until it changes.
+    DictionaryType getValue(const std::string &name,double &numVal,const std::string *&strVal) const;
 
     /// Remove the given field by name
     void removeField(const std::string &name) override;
@@ -119,7 +125,7 @@ public:
     virtual std::vector<std::string> getKeys() const override;
 
     /// Get the key for the given string
-    int getKeyID(const std::string &name);
+    int getKeyID(const std::string &name) const;
     
     /// Set field as int
     void setInt(const std::string &name,int val) override;
@@ -146,83 +152,74 @@ public:
     void setArray(const std::string &name,const std::vector<DictionaryRef> &entries);
     void setArray(unsigned int key,const std::vector<DictionaryRef> &entries);
     
-    // Write data to a raw data buffer
-//    void asRawData(MutableRawData *rawData);
+    /** Write the contents to a raw data buffer in a compact binary form.
+        Keys and strings are written once each and nested dictionaries follow their parent.
+        This is meant for caches, it's not portable across byte orders.
+      */
+    void asRawData(MutableRawData *rawData) const;
+
+    /// Replace the contents with what asRawData wrote.  Returns false if the data is bad.
+    bool readRawData(RawDataReader &reader);
     
     // Merge in key-value pairs from another dictionary
     void addEntries(const Dictionary *other) override;
     void addEntries(const MutableDictionaryC *other);
     
 protected:
-    // The array has to let us know what the type is
-    class ArrayEntry {
-    public:
-        DictionaryType type;   // Type of the data in the array
-        std::vector<unsigned int> vals;  // Array entries
+    // A single value.  Numbers are kept right here, the rest refer into the storage.
+    struct Value {
+        Value() : type(DictTypeNone), i64Val(0) { }
+        Value(DictionaryType type,unsigned int entry) : type(type), i64Val(0) { this->entry = entry; }
+
+        static Value intValue(int val) { Value ret(DictTypeInt,0);  ret.iVal = val;  return ret; }
+        static Value int64Value(int64_t val,DictionaryType type) { Value ret(type,0);  ret.i64Val = val;  return ret; }
+        static Value doubleValue(double val) { Value ret(DictTypeDouble,0);  ret.dVal = val;  return ret; }
+
+        DictionaryType type;
+        union {
+            int iVal;
+            int64_t i64Val;
+            double dVal;
+            unsigned int entry;     // String, dictionary or array
+        };
+    };
+
+    // Key (which is a string entry) and value
+    typedef std::pair<unsigned int,Value> Field;
+
+    // Everything we hold.  Copies share this until one of them changes it.
+    struct Storage {
+        std::vector<Field> fields;              // Sorted by key
+        std::vector<std::string> strings;       // Keys and string values
+        std::vector<std::vector<Value> > arrays;
+        std::vector<MutableDictionaryCRef> dicts;
+        // Only filled in once there are enough strings to be worth hashing
+        std::unordered_map<std::string,unsigned int> stringMap;
     };
 
+    // The storage, all to ourselves, for modifying
+    Storage &mut();
+
+    // Find a key or string value, or -1 if it's not here
+    int findString(const std::string &str) const;
     /// Add the given string key
     unsigned int addKeyID(const std::string &name) { return addString(name); }
-    unsigned int addString(const std::string &name);
-    /// Form an array of entries from an array index;
-    std::vector<DictionaryEntryCRef> formArray(int idx) const;
+    unsigned int addString(const std::string &str);
 
-    // The top level entries in the dictionary
-    struct Value {
-        Value() : type(DictTypeNone), entry(0) { }
-        Value & operator = (const Value &other) { type = other.type;  entry = other.entry;  return *this; }
-        Value(const Value &other) : type(other.type), entry(other.entry) {}
-        Value(DictionaryType type,unsigned int entry) : type(type), entry(entry) {}
+    const Value *findValue(unsigned int key) const;
+    const Value *findValue(const std::string &name) const;
+    void setValue(unsigned int key,const Value &val);
 
-        DictionaryType type;
-        unsigned int entry;
-    };
+    /// Form an array of entries from an array index;
+    std::vector<DictionaryEntryCRef> formArray(int idx) const;
 
     // Make an entry ref for a given value
     DictionaryEntryCRef makeEntryRef(const Value &val) const;
 
     void setupArray(const std::vector<DictionaryEntryCRef> &vals, std::vector<Value>& arr);
 
-    template <typename TVal, typename TVec>
-    void set(unsigned int key, TVal val, DictionaryType type, std::vector<TVec> &vals) {
-        set(key, val, type, type, vals);
-    }
-    template <typename TVal, typename TVec>
-    void set(unsigned int key, TVal val, DictionaryType type, DictionaryType altType, std::vector<TVec> &vals) {
-        const auto res = valueMap.insert(std::make_pair(key, Value(type, (int)vals.size())));
-        if (res.second) {
-            // key was inserted
-            vals.push_back(val);
-        } else {
-            // key was already present
-            const auto &mapVal = res.first->second;
-            
-            if (mapVal.type != type && mapVal.type != altType) {
-                // type mismatch, remove it
-                // shouldn't we replace it?
-                valueMap.erase(res.first);
-            } else {
-                vals[mapVal.entry] = val;
-            }
-        }
-    }
-
-    // Where we store the actual data
-    std::vector<int> intVals;
-    std::vector<int64_t> int64Vals;
-    std::vector<double> dVals;
-    std::vector<std::string> stringVals;
-    std::vector<std::vector<Value> > arrayVals;
-    std::vector<MutableDictionaryCRef> dictVals;
-    
-    // Map strings to integer values for lookup
-    typedef std::unordered_map<std::string,unsigned int> StringMap;
-    StringMap stringMap;
-    
-    // TODO: Turn the values into an array and index the string values separately from keys
-    // Map integer key values into fields
-    typedef std::unordered_map<unsigned int,Value> ValueMap;
-    ValueMap valueMap;
+    // Empty until something is added
+    std::shared_ptr<Storage> data;
 };
 
 /// Wrapper around a single value
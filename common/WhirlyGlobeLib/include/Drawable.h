@@ -25,6 +25,7 @@
 #import "WhirlyVector.h"
 #import "WhirlyKitView.h"
 #import "ChangeRequest.h"
+#import "SlotMap.h"
 
 namespace WhirlyKit
 {
@@ -97,6 +98,9 @@ public:
     
     /// Run the tweakers
     virtual void runTweakers(RendererFrameInfo *frame);
+
+    /// Set if there are tweakers, which can change how we look every frame
+    bool hasTweakers() const { return !tweakers.empty(); }
     
     /// Do any initialization you may want.
     /// For instance, set up VBOs.
@@ -111,6 +115,29 @@ public:
     /// For OpenGLES2, this is the program to use to render this drawable.
     virtual SimpleIdentity getProgram() const = 0;
 
+    /// Number of triangles drawn, for stats.  Zero if we don't know.
+    virtual unsigned int getNumTris() const { return 0; }
+
+    /// The first texture, if any.  Used to group draws that share state.
+    virtual SimpleIdentity getSortTexture() const { return EmptyIdentity; }
+
+    /// Same for any drawables with the same vertex attributes, laid out the same way
+    virtual uint64_t getVertexLayoutKey() const { return 0; }
+
+    /// Set for labels, markers and such that are laid out in screen space rather than on the map
+    virtual bool isScreenSpace() const { return false; }
+
+    /// Memory held on each side once it's set up for the renderer
+    virtual void getMemoryBytes(size_t &cpuBytes,size_t &gpuBytes) const { cpuBytes = 0;  gpuBytes = 0; }
+
+    /// If the drawable is only on for a window of time, return it.  An end of zero means it never ends.
+    /// The renderer assumes this doesn't change once the drawable is added.
+    virtual bool getEnableTimeRange(TimeInterval &start,TimeInterval &end) const { return false; }
+
+    /// Order drawables by the state they'll need set up: program, then (optionally) texture, then vertex layout.
+    /// Returns less than, equal to or greater than zero, like strcmp.
+    static int compareDrawState(const Drawable &a,const Drawable &b,bool useTextures);
+
     /// Controls whether the drawable is blended assuming that its color components have been pre-multipled by its alpha components.
     void setBlendPremultipliedAlpha(bool enable) { blendPremultipliedAlpha = enable; }
     bool getBlendPremultipliedAlpha() const { return blendPremultipliedAlpha; }
@@ -121,6 +148,9 @@ public:
     // If it's being rendered, the target container this belongs to
     RenderTargetContainerRef renderTargetCon;
 
+    // If it's known to the renderer but not being drawn, where it is in that set
+    SlotHandle offSlot = EmptySlotHandle;
+
 protected:
     std::string name;
     DrawableTweakerRefSet tweakers;
@@ -138,8 +168,6 @@ typedef std::shared_ptr<Drawable> DrawableRef;
 class DrawableChangeRequest : public ChangeRequest
 {
 public:
-    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
-
     /// Construct with the ID of the Drawable we'll be changing
     DrawableChangeRequest(SimpleIdentity drawId) : drawId(drawId) { }
     virtual ~DrawableChangeRequest() { }
@@ -150,6 +178,13 @@ public:
     /// This is called by execute if there's a drawable to modify.
     /// This is the one you override.
     virtual void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw) = 0;
+
+    /// Called instead if the drawable was merged into another one.
+    /// Most changes would apply to the whole thing, so by default they're ignored.
+    virtual void executeMerged(Scene *scene,SceneRenderer *renderer,DrawableRef mergedDraw) { }
+
+    /// The drawable we're changing
+    virtual SimpleIdentity getTargetID() const override { return drawId; }
 	
 protected:
     SimpleIdentity drawId;
@@ -157,6 +192,21 @@ protected:
 
 /// Turn off visibility checking
 static const float DrawVisibleInvalid = 1e10;
+
+/// Number of zoom slots the scene keeps
+#define MaplyMaxZoomSlots 32
+
+/** The bit for a drawable's zoom slot, if it has a zoom range to check there.
+    The renderer keeps a mask of the slots in use each frame, so anything
+    without a range, or in a slot nobody's set, is passed over with a bit test.
+  */
+inline uint32_t ZoomSlotMask(int zoomSlot,double minZoomVis,double maxZoomVis)
+{
+    if (zoomSlot < 0 || zoomSlot >= MaplyMaxZoomSlots ||
+        (minZoomVis == DrawVisibleInvalid && maxZoomVis == DrawVisibleInvalid))
+        return 0;
+    return 1u << zoomSlot;
+}
     
 /// Maximum number of points we want in a drawable
 static const unsigned int MaxDrawablePoints = ((1<<16)-1);
@@ -38,6 +38,10 @@ public:
 
     /// Set up what you need in the way of context and draw.
     virtual void draw(RendererFrameInfoGLES *frameInfo,Scene *scene) = 0;
+
+    /// If set, draw() repeats its draw call for each of the frame's copyMats.
+    /// Otherwise the renderer calls draw() once for each copy of the world.
+    virtual bool drawsWorldCopies() const { return false; }
 };
 typedef std::shared_ptr<DrawableGLES> DrawableGLESRef;
 
@@ -0,0 +1,82 @@
+/*  DrawableTimeIndex.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <map>
+#import <unordered_map>
+#import <vector>
+#import "Drawable.h"
+
+namespace WhirlyKit
+{
+
+/** Drawables that are off because of their enable time range, sorted by when that changes.
+    The renderer parks drawables in here once the time is outside their window,
+    so it doesn't have to look at them every frame.
+    Those waiting to start are sorted by start and those that have finished by end.
+    Moving the time, in either direction and by any amount, only touches the
+    drawables whose start or end it passes over.
+    Not thread safe.  The renderer uses it on the rendering thread.
+  */
+class DrawableTimeIndex
+{
+public:
+    /// Park the drawable if its window doesn't cover the given time.
+    /// Returns true if it was parked, false if it should stay where it is.
+    bool park(const DrawableRef &draw,TimeInterval now);
+
+    /// Take a drawable out, if it's in here.  Returns true if it was.
+    bool remove(const DrawableRef &draw);
+
+    /// Move to a new time.  Drawables whose window covers it are taken out and added to draws.
+    void update(TimeInterval now,std::vector<DrawableRef> &draws);
+
+    /// Number of drawables parked
+    size_t size() const { return where.size(); }
+
+    /// Call func on each of the drawables parked
+    template <typename T> void forEach(T &&func) const
+    {
+        for (const auto &it : waiting)
+            func(it.second);
+        for (const auto &it : finished)
+            func(it.second);
+    }
+
+    /// Forget everything
+    void clear();
+
+protected:
+    typedef std::multimap<TimeInterval,DrawableRef> TimeMap;
+
+    struct Entry
+    {
+        TimeInterval start,end;
+        bool finished;
+        TimeMap::iterator it;
+    };
+
+    // File it on the right side for the time, or return false if it's on then
+    bool insert(const DrawableRef &draw,Entry &entry,TimeInterval now);
+
+    // Waiting to start, by start time
+    TimeMap waiting;
+    // Already ended, by end time
+    TimeMap finished;
+    std::unordered_map<SimpleIdentity,Entry> where;
+};
+
+}
@@ -0,0 +1,89 @@
+/*  DynamicResolution.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <mutex>
+#import "WhirlyTypes.h"
+
+namespace WhirlyKit
+{
+
+/** Picks the resolution the renderer draws the map at, as a fraction of the framebuffer.
+    When the view is moving and frames take longer than the display allows, we're usually
+    limited by fill rate, so we give up some sharpness to keep the frame rate.
+    When frames come in well under budget for a while we step back up, and once the view
+    stops we go back to full resolution for the frame that stays on screen.
+    Screen space objects, like labels and markers, aren't affected.
+    Off by default.
+
+    The renderers feed it the GPU time for each frame when they can measure it, which is
+    what the scale actually changes.  That's command buffer times on Metal and timer queries
+    on OpenGL ES, where the driver has GL_EXT_disjoint_timer_query.  Without those we
+    fall back on the time between frames, which also counts the CPU and the display link.
+  */
+class DynamicResolution
+{
+public:
+    DynamicResolution() = default;
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    /// Range of scales we'll use.  Defaults to 0.6 - 1.0.
+    void setScaleRange(float minScale,float maxScale);
+    float getMinScale() const;
+    float getMaxScale() const;
+
+    /// Scale to draw the map at right now
+    float getScale() const;
+
+    /// Note a frame starting at the given time, with the time it should have taken.
+    /// Only frames one after another while the view moves count toward the frame time.
+    /// If gpuTimed is set the GPU times from addGPUFrame() count instead, and this
+    /// only keeps track of whether we're moving.
+    /// Returns true if the scale changed.
+    bool addFrame(TimeInterval now,TimeInterval budget,bool moving,bool gpuTimed = false);
+
+    /// GPU time for an earlier frame, once the results come back.  Thread safe.
+    /// Only frames drawn while the view was moving count, and only while it still is.
+    /// Returns true if the scale changed.
+    bool addGPUFrame(TimeInterval gpuTime,TimeInterval budget,bool moving);
+
+    /// Go back to full resolution if we'd dropped down.
+    /// Returns true if that means drawing again.
+    bool restore();
+
+protected:
+    // Lock must be held
+    void resetTiming();
+    // Fold in one frame time and step the scale if we've been over or under long enough.
+    // Lock must be held.
+    bool updateScale(TimeInterval frameTime,TimeInterval budget);
+
+    mutable std::mutex lock;
+    bool enabled = false;
+    float minScale = 0.6f;
+    float maxScale = 1.0f;
+    float scale = 1.0f;
+    TimeInterval lastFrame = 0.0;
+    bool lastMoving = false;
+    // Smoothed frame time while moving
+    TimeInterval avgFrameTime = 0.0;
+    int slowFrames = 0;
+    int fastFrames = 0;
+};
+
+}
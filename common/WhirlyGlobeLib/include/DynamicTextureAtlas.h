@@ -20,6 +20,7 @@
 
 #import <vector>
 #import <set>
+#import <unordered_map>
 
 #import "Identifiable.h"
 #import "WhirlyVector.h"
@@ -63,16 +64,53 @@ public:
     
     /// Add the data at a given location in the texture
     virtual void addTextureData(int startX,int startY,int width,int height,RawDataRef data) = 0;
-    
-    /// Clear out the area given
-    void clearRegion(const Region &region,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData);
-    virtual void clearTextureData(int startX,int startY,int width,int height,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData) = 0;
+
+    /// Region data copied into staging memory, waiting on the render thread
+    class StagedData
+    {
+    public:
+        virtual ~StagedData() = default;
+        int startX = 0,startY = 0,width = 0,height = 0;
+    };
+    typedef std::shared_ptr<StagedData> StagedDataRef;
+
+    /// Copy region data into staging memory off the render thread.
+    /// Returns null if that's not supported, in which case use addTextureData().
+    virtual StagedDataRef stageTextureData(const RenderSetupInfo *setupInfo,int startX,int startY,int width,int height,const RawDataRef &data) { return StagedDataRef(); }
+
+    /// Render thread only.  Copy staged data into the texture.
+    virtual void addStagedData(SceneRenderer *renderer,const StagedDataRef &staged) { }
+
+    /// Data for an image going into the given region.  If we're clearing textures, it's padded out
+    /// with empty pixels to the whole region, so the one upload replaces whatever was there before.
+    /// Width and height are updated to match.
+    RawDataRef regionData(const Region &region,const RawDataRef &data,int &width,int &height) const;
     
     /// Set or clear a given region
     void setRegion(const Region &region,bool enable);
     
     /// Look for an open region of the given cell extents
     bool findRegion(int cellsX,int cellsY,Region &region);
+
+    /// Open up the regions the renderer has released
+    void applyReleasedRegions();
+
+    /// True if any cell in use here is also in use in the other texture
+    bool overlaps(const DynamicTexture &other) const;
+
+    /// Take on the other texture's cells and region count.  They must not overlap ours.
+    void mergeRegions(const DynamicTexture &other);
+
+    /// Hand over anything the renderer released on the other texture.
+    /// Render thread only.
+    void takeReleasedRegions(DynamicTexture &other);
+
+    /// Set if copyRegions() works for this texture's format
+    virtual bool canCopyRegions() const { return false; }
+
+    /// Render thread only.  Copy the given regions over from another texture of the same
+    ///  size and format, to the same spot in this one.
+    virtual void copyRegions(SceneRenderer *renderer,DynamicTexture *src,const std::vector<Region> &regions) { }
     
     /// Return a list of released regions
     void getReleasedRegions(std::vector<DynamicTexture::Region> &toClear) const;
@@ -90,6 +128,9 @@ public:
     
     /// Return texture cell utilization
     void getUtilization(int &numCell,int &usedCell);
+
+    /// The whole texture, whether the cells are in use or not
+    virtual size_t getGPUBytes() const override;
     
 protected:
     /// Used for debugging
@@ -116,7 +157,7 @@ protected:
     /// Number of active regions (as far as the texture is concerned)
     int numRegions;
 
-    /// If set, overwrite texture data with empty pixels
+    /// If set, write regions in full, with empty pixels around the image
     bool clearTextures;
 };
     
@@ -130,22 +171,42 @@ typedef struct DynamicTextureVecSorter
     bool operator () (const DynamicTextureVec *a,const DynamicTextureVec *b) const { return a->at(0)->getId() < b->at(0)->getId(); }
 } DynamicTextureVecSorter;
 
-/// Copy data into a dynamic texture (on the main thread)
+/// Copy data into a dynamic texture (on the main thread).
+/// Can carry several regions for the same texture.
 class DynamicTextureAddRegion : public ChangeRequest
 {
 public:
     DynamicTextureAddRegion(SimpleIdentity texId,int startX,int startY,int width,int height,RawDataRef data)
-    : texId(texId), startX(startX), startY(startY), width(width), height(height), data(data) { }
+    : texId(texId) { pieces.push_back(Piece { startX, startY, width, height, std::move(data) }); }
+    /// This version stages the data in setupForRenderer if the texture allows async uploads
+    DynamicTextureAddRegion(const DynamicTextureRef &dynTex,int startX,int startY,int width,int height,RawDataRef data)
+    : texId(dynTex->getId()), dynTex(dynTex) { pieces.push_back(Piece { startX, startY, width, height, std::move(data) }); }
     ~DynamicTextureAddRegion();
 
-    /// Add the region.  Never call this.
+    /// Tack on another region for the same texture.  Returns false if it's for a different one.
+    bool addRegion(const DynamicTextureRef &dynTex,int startX,int startY,int width,int height,RawDataRef data);
+
+    /// Copy the data to staging memory, if we can
+    virtual void setupForRenderer(const RenderSetupInfo *setupInfo,Scene *scene) override;
+
+    /// Staging needs a flush on GLES
+    virtual bool needsFlush() override { return dynTex && dynTex->getAsyncUpload(); }
+
+    /// Add the regions.  Never call this.
     void execute(Scene *scene,SceneRenderer *renderer,WhirlyKit::View *view);
     
 protected:
+    struct Piece
+    {
+        int startX,startY,width,height;
+        RawDataRef data;
+        DynamicTexture::StagedDataRef staged;
+    };
+
     bool wasRun = false;
     SimpleIdentity texId;
-    int startX,startY,width,height;
-    RawDataRef data;
+    DynamicTextureRef dynTex;
+    std::vector<Piece> pieces;
 };
     
 /// Tell a dynamic texture that a region has been released for use
@@ -165,6 +226,26 @@ protected:
     DynamicTexture::Region region;
 };
 
+/** Copy one dynamic texture's regions into another and point the old texture ID at the new one.
+    The regions stay where they were, so drawables using them don't need new texture coordinates.
+  */
+class DynamicTextureMergeReq : public ChangeRequest
+{
+public:
+    DynamicTextureMergeReq(DynamicTextureRef dest,DynamicTextureRef src,std::vector<DynamicTexture::Region> regions)
+    : dest(std::move(dest)), src(std::move(src)), regions(std::move(regions)) { }
+
+    /// Copy and redirect.  Never call this.
+    void execute(Scene *scene,SceneRenderer *renderer,WhirlyKit::View *view);
+
+    /// Has to wait on anything else going into the old texture
+    virtual SimpleIdentity getTargetID() const override { return src->getId(); }
+
+protected:
+    DynamicTextureRef dest,src;
+    std::vector<DynamicTexture::Region> regions;
+};
+
 /** The dynamic texture atlas manages a variable number of dynamic textures into which it will stuff
     individual textures.  You use it by adding your individual Textures and passing the
     change requests on to the layer thread (or Scene).  You can also clear your Textures later
@@ -192,6 +273,18 @@ public:
     /// Set the interpolation type used for min and mag
     void setInterpType(TextureInterpType inType);
     TextureInterpType getInterpType() const;
+
+    /// If set, images are written along with empty pixels out to the edges of their region,
+    /// so nothing left by the last user of the region shows through.  Released regions are
+    /// never cleared on their own, so this costs no extra uploads.  Off by default, which
+    /// suits images that fill their regions (or are drawn with a border).
+    /// Set before adding anything.
+    void setClearTextures(bool inClear) { clearTextures = inClear; }
+
+    /// If set, new dynamic textures stage region data off the render thread.
+    /// Only matters when merging on the main thread.
+    void setAsyncUpload(bool inAsync) { asyncUpload = inAsync; }
+    bool getAsyncUpload() const { return asyncUpload; }
     
     /// Return the dynamic texture's format
     TextureType getFormat() const;
@@ -224,12 +317,23 @@ public:
     /// Look for any textures that should be cleaned up
     void cleanup(ChangeSet &changes,TimeInterval when);
 
+    /** Fold sparsely used dynamic textures into others to free up texture memory.
+        A texture is merged into another when none of their cells overlap, so everything
+        keeps its texture coordinates.  The renderer copies the data over and the old
+        texture ID is pointed at the one it was merged into.
+        Returns the number of dynamic textures freed.
+      */
+    int compact(ChangeSet &changes);
+
     /// Clear out the active dynamic textures.  Caller deals with the
     ///  change requests.
     void teardown(ChangeSet &changes);
     
     /// Get some basic info out
     void getUsage(int &numRegions,int &dynamicTextures) const;
+
+    /// Texture memory taken up by the dynamic textures, used or not
+    size_t getBytes() const;
     
     /// Print out some utilization info
     void log() const;
@@ -248,17 +352,24 @@ protected:
     /// Interpolation type
     float pixelFudge;
     bool mainThreadMerge;
+    bool asyncUpload = false;
 
-    /// If set, overwrite texture data with empty pixels
+    /// If set, write regions in full, with empty pixels around the image
     bool clearTextures;
-    
-    // On some devices we can't clear with a NULL, we have to use an actual buffer
-    std::vector<unsigned char> emptyPixelBuffer;
 
     typedef std::set<TextureRegion> TextureRegionSet;
     TextureRegionSet regions;
     typedef std::set<DynamicTextureVec *,DynamicTextureVecSorter> DynamicTextureSet;
     DynamicTextureSet textures;
+
+    // Write an image into its region, either right away or by way of the main thread.
+    // Regions for the same texture in a row in the changes go out together.
+    void addRegionData(const DynamicTextureRef &dynTex,const DynamicTexture::Region &region,Texture *tex,ChangeSet &changes);
+    // Remove the old IDs for textures merged into the given one
+    void removeAliases(SimpleIdentity texId,ChangeSet &changes,TimeInterval when);
+
+    /// IDs of textures merged into each of ours, which the scene has pointing at ours
+    std::unordered_map<SimpleIdentity,std::vector<SimpleIdentity>> aliases;
 };
 
 }
@@ -42,17 +42,34 @@ public:
     
     /// Add the data at a given location in the texture
     void addTextureData(int startX,int startY,int width,int height,RawDataRef data);
-    
-    /// Clear out the low level data
-    void clearTextureData(int startX,int startY,int width,int height,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData);
 
     /// Create an appropriately empty texture in OpenGL ES
     virtual bool createInRenderer(const RenderSetupInfo *setupInfo);
     
     /// Render side only.  Don't call this.  Destroy the OpenGL ES version
     virtual void destroyInRenderer(const RenderSetupInfo *setupInfo,Scene *scene);
+
+    /// Copy the region data into a pixel buffer
+    virtual StagedDataRef stageTextureData(const RenderSetupInfo *setupInfo,int startX,int startY,int width,int height,const RawDataRef &data) override;
+
+    /// Copy from the pixel buffer into the texture
+    virtual void addStagedData(SceneRenderer *renderer,const StagedDataRef &staged) override;
+
+    /// We copy through a framebuffer, so the format has to be renderable
+    virtual bool canCopyRegions() const override { return !compressed && format != GL_ALPHA; }
+
+    /// Copy regions from another texture with glCopyTexSubImage2D
+    virtual void copyRegions(SceneRenderer *renderer,DynamicTexture *src,const std::vector<Region> &regions) override;
     
 protected:
+    /// Pixel buffer holding one region's data
+    class StagedDataGLES : public StagedData
+    {
+    public:
+        GLuint pboId = 0;
+        GLsync fence = nullptr;
+    };
+
     /// If set, this is a compressed format (assume PVRTC4)
     bool compressed;
     GLenum format,glType;
@@ -0,0 +1,163 @@
+/*  ElevationManager.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <list>
+#import <unordered_map>
+#import <vector>
+#import "WhirlyVector.h"
+#import "CoordSystem.h"
+#import "QuadTreeNew.h"
+#import "Scene.h"
+#import "IntersectionManager.h"
+
+namespace WhirlyKit
+{
+
+#define kWKElevationManager "WKElevationManager"
+
+/// How heights are packed into the pixels of an elevation image
+typedef enum {
+    ElevEncodeTerrarium,    // (R * 256 + G + B / 256) - 32768
+    ElevEncodeMapboxRGB     // -10000 + (R * 65536 + G * 256 + B) * 0.1
+} ElevationEncoding;
+
+/** Heights for one elevation tile, sampled on a regular grid over the tile's bounds.
+    Rows start at the top (north), as in the images they come from.
+    The samples are kept as 16 bits each, scaled over the tile's own range of heights.
+  */
+class ElevationTile
+{
+public:
+    /// Construct from heights in meters, sizeX * sizeY of them
+    ElevationTile(int sizeX,int sizeY,const float *heights);
+
+    /// Decode heights from RGB or RGBA pixels, packed the given way
+    static std::shared_ptr<ElevationTile> FromPixels(const unsigned char *pixels,int width,int height,
+                                                     int bytesPerPixel,ElevationEncoding encoding);
+
+    /// Decode heights from a PNG, packed the given way.  Null if it's not a PNG we can read.
+    static std::shared_ptr<ElevationTile> FromPNG(const unsigned char *data,size_t length,ElevationEncoding encoding);
+
+    /// Height in meters at a spot in the tile, with (0,0) its lower left and (1,1) its upper right
+    double heightAt(double u,double v) const;
+
+    /// Lowest and highest heights in the tile
+    double getMinHeight() const { return minHeight; }
+    double getMaxHeight() const { return maxHeight; }
+
+    /// Memory taken up by the samples
+    size_t getBytes() const { return samples.size() * sizeof(uint16_t); }
+
+protected:
+    int sizeX,sizeY;
+    double minHeight,maxHeight;
+    double scale;
+    std::vector<uint16_t> samples;
+};
+typedef std::shared_ptr<ElevationTile> ElevationTileRef;
+
+/** The elevation manager keeps elevation tiles that have been loaded and answers height queries from them.
+    Tiles come in from a loader, laid out the way QuadTreeNew does it for the tile set's coordinate system.
+    Queries use the most detailed tile covering each point.
+    Tiles are dropped, least recently used first, to stay under the memory limit.
+    <br>
+    Tile geometry built with elevation turned on, markers with clamping turned on and the
+    intersection manager all take their heights from here.
+  */
+class ElevationManager : public SceneManager, public IntersectionManager::Intersectable, public MemoryConsumer
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+    ElevationManager();
+    virtual ~ElevationManager();
+
+    /// Set the tile set layout.  The tiles cover mbr at level 0, in the given coordinate system.
+    /// Changing it drops the tiles we have.
+    void setup(const CoordSystemRef &coordSys,const MbrD &mbr,int minZoom,int maxZoom);
+
+    /// Most memory to spend on tiles.  64MB by default.
+    void setMaxBytes(size_t maxBytes);
+
+    /// Add (or replace) the heights for a tile
+    void addTile(const QuadTreeIdentifier &ident,const ElevationTileRef &tile);
+
+    /// Decode a PNG tile and add it.  False if it wouldn't decode.
+    bool addTile(const QuadTreeIdentifier &ident,const unsigned char *data,size_t length,ElevationEncoding encoding);
+
+    /// Forget about a tile
+    void removeTile(const QuadTreeIdentifier &ident);
+
+    /// Forget about all the tiles
+    void clear();
+
+    /// True if there's at least one tile
+    bool hasData() const { return numTiles > 0; }
+
+    /// Look up heights, in meters, for geographic points in radians.
+    /// Points without a tile get 0 and are returned as false in found, if it's passed in.
+    /// Returns the number that had a tile.
+    size_t heightsAt(const Point2d *geo,double *heights,size_t count,std::vector<bool> *found = nullptr);
+
+    /// Look up the height, in meters, for one geographic point in radians.  0 if there's no tile for it.
+    double heightAt(const Point2d &geo,bool *found = nullptr);
+
+    /// Register with the intersection manager as we come and go
+    virtual void setScene(Scene *inScene) override;
+
+    /// Find where a ray in display coordinates hits the terrain, or the globe under it
+    virtual bool findClosestIntersection(SceneRenderer *renderer,View *theView,const Point2f &frameSize,const Point2f &touchPt,
+                                         const Point3d &org,const Point3d &dir,Point3d &iPt,double &dist) override;
+
+    /// Decoded tiles count as parsed tiles
+    virtual void addMemoryUsage(MemoryUsage &usage) override;
+
+    /// Drops the least recently used half of the tiles along with the offscreen tiles
+    virtual void trimMemory(PlatformThreadInfo *inst,MemoryTrimLevel step,ChangeSet &changes) override;
+
+protected:
+    struct TileEntry
+    {
+        ElevationTileRef tile;
+        MbrD mbr;
+        std::list<int64_t>::iterator lruPos;
+    };
+
+    // Look for the most detailed tile covering a point in the tile coordinate system.  Lock must be held.
+    const TileEntry *findTile(const Point2d &local);
+
+    // Drop tiles until we're under the limit.  Lock must be held.
+    void trim(size_t limit);
+
+    CoordSystemRef coordSys;
+    MbrD mbr;
+    int minZoom,maxZoom;
+    size_t maxBytes,curBytes;
+    std::unordered_map<int64_t,TileEntry> tiles;
+    // Most recently used at the front
+    std::list<int64_t> lru;
+    // Deepest level we've got something for
+    int maxLevelLoaded;
+    // Whole range of heights we've seen, for the intersection test
+    double minHeight,maxHeight;
+    std::atomic<size_t> numTiles;
+    // Where we're registered, so we can leave without going through the scene
+    std::weak_ptr<IntersectionManager> intersectManager;
+};
+typedef std::shared_ptr<ElevationManager> ElevationManagerRef;
+
+}
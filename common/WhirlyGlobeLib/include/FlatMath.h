@@ -48,6 +48,12 @@ public:
     /// Convert from WGS84 geocentric to local coordinates
     virtual Point3f geocentricToLocal(Point3f) const override;
     virtual Point3d geocentricToLocal(Point3d) const override;
+
+    /// Batch versions, which go through Proj once for the lot
+    virtual void geographicToLocalBatch(const Point2d *geo,Point3d *local,size_t count) const override;
+    virtual void localToGeographicBatch(const Point3d *local,Point2d *geo,size_t count) const override;
+    virtual void localToGeocentricBatch(const Point3d *local,Point3d *geoc,size_t count) const override;
+    virtual void geocentricToLocalBatch(const Point3d *geoc,Point3d *local,size_t count) const override;
         
     /// Return true if the other coordinate system is also Plate Carree
     virtual bool isSameAs(const CoordSystem *coordSys) const override;
@@ -0,0 +1,209 @@
+/*  FlatNodeSet.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import <algorithm>
+#import <cstdint>
+#import <utility>
+
+namespace WhirlyKit
+{
+
+/** A set of quad tree nodes kept in a sorted vector, keyed on NodeNumber().
+    Node numbers sort by level, then y, then x, which is the same order
+    the nodes themselves use, so iteration matches a std::set.
+    Lookups are a binary search over contiguous memory and adding nodes
+    in order is just an append.  Adding them out of order moves the tail,
+    so build big sets with the range insert.
+    Like a std::vector, changes invalidate iterators.
+  */
+template <typename NodeType>
+class FlatNodeSet
+{
+public:
+    typedef NodeType value_type;
+    typedef NodeType key_type;
+    typedef typename std::vector<NodeType>::const_iterator iterator;
+    typedef typename std::vector<NodeType>::const_iterator const_iterator;
+    typedef typename std::vector<NodeType>::const_reverse_iterator reverse_iterator;
+    typedef typename std::vector<NodeType>::const_reverse_iterator const_reverse_iterator;
+
+    FlatNodeSet() = default;
+    template <typename InputIt>
+    FlatNodeSet(InputIt first,InputIt last) { insert(first,last); }
+
+    /// Add a node, returning where it is and whether it's new
+    std::pair<iterator,bool> insert(const NodeType &node)
+    {
+        const int64_t key = node.NodeNumber();
+        if (nodes.empty() || nodes.back().NodeNumber() < key)
+        {
+            nodes.push_back(node);
+            return std::make_pair(nodes.cend()-1,true);
+        }
+        auto it = lowerBound(key);
+        if (it != nodes.end() && it->NodeNumber() == key)
+            return std::make_pair(iterator(it),false);
+        it = nodes.insert(it,node);
+        return std::make_pair(iterator(it),true);
+    }
+
+    /// Add a bunch of nodes at once, sorting just the once
+    template <typename InputIt>
+    void insert(InputIt first,InputIt last)
+    {
+        const size_t oldSize = nodes.size();
+        nodes.insert(nodes.end(),first,last);
+        if (nodes.size() == oldSize)
+            return;
+        // Stable, so the existing entries win over duplicates
+        std::stable_sort(nodes.begin()+oldSize,nodes.end(),&FlatNodeSet::lessThan);
+        std::inplace_merge(nodes.begin(),nodes.begin()+oldSize,nodes.end(),&FlatNodeSet::lessThan);
+        nodes.erase(std::unique(nodes.begin(),nodes.end(),&FlatNodeSet::sameKey),nodes.end());
+    }
+
+    template <typename... Args>
+    std::pair<iterator,bool> emplace(Args&&... args) { return insert(NodeType(std::forward<Args>(args)...)); }
+
+    iterator find(const NodeType &node) const
+    {
+        const int64_t key = node.NodeNumber();
+        const auto it = lowerBound(key);
+        return (it != nodes.end() && it->NodeNumber() == key) ? it : nodes.end();
+    }
+
+    size_t count(const NodeType &node) const { return find(node) != end() ? 1 : 0; }
+
+    /// Remove a node, returning the number removed
+    size_t erase(const NodeType &node)
+    {
+        const auto it = find(node);
+        if (it == end())
+            return 0;
+        nodes.erase(it);
+        return 1;
+    }
+    iterator erase(const_iterator it) { return nodes.erase(it); }
+
+    iterator begin() const { return nodes.cbegin(); }
+    iterator end() const { return nodes.cend(); }
+    reverse_iterator rbegin() const { return nodes.crbegin(); }
+    reverse_iterator rend() const { return nodes.crend(); }
+
+    size_t size() const { return nodes.size(); }
+    bool empty() const { return nodes.empty(); }
+    void clear() { nodes.clear(); }
+    void reserve(size_t num) { nodes.reserve(num); }
+
+    bool operator == (const FlatNodeSet &that) const { return nodes.size() == that.nodes.size() &&
+                                                              std::equal(begin(),end(),that.begin(),&FlatNodeSet::sameKey); }
+    bool operator != (const FlatNodeSet &that) const { return !operator==(that); }
+
+protected:
+    static bool lessThan(const NodeType &a,const NodeType &b) { return a.NodeNumber() < b.NodeNumber(); }
+    static bool sameKey(const NodeType &a,const NodeType &b) { return a.NodeNumber() == b.NodeNumber(); }
+
+    typename std::vector<NodeType>::const_iterator lowerBound(int64_t key) const
+    {
+        return std::lower_bound(nodes.cbegin(),nodes.cend(),key,
+                                [](const NodeType &node,int64_t val) { return node.NodeNumber() < val; });
+    }
+
+    std::vector<NodeType> nodes;
+};
+
+/** Map from quad tree node to a value, kept in a sorted vector keyed on NodeNumber().
+    Iterates in the same order as a std::map on the nodes would and
+    entries have first and second, so it reads the same way.
+    Changes invalidate iterators and references to values.
+  */
+template <typename NodeType,typename ValueType>
+class FlatNodeMap
+{
+public:
+    typedef std::pair<NodeType,ValueType> value_type;
+    typedef NodeType key_type;
+    typedef ValueType mapped_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+    /// Add an entry if there isn't one for the node already
+    std::pair<iterator,bool> insert(const value_type &entry)
+    {
+        const int64_t key = entry.first.NodeNumber();
+        if (entries.empty() || entries.back().first.NodeNumber() < key)
+        {
+            entries.push_back(entry);
+            return std::make_pair(entries.end()-1,true);
+        }
+        auto it = lowerBound(key);
+        if (it != entries.end() && it->first.NodeNumber() == key)
+            return std::make_pair(it,false);
+        it = entries.insert(it,entry);
+        return std::make_pair(it,true);
+    }
+
+    /// Value for the node, adding a default one if it's not there
+    ValueType &operator [] (const NodeType &node)
+    {
+        return insert(value_type(node,ValueType())).first->second;
+    }
+
+    iterator find(const NodeType &node)
+    {
+        const int64_t key = node.NodeNumber();
+        const auto it = lowerBound(key);
+        return (it != entries.end() && it->first.NodeNumber() == key) ? it : entries.end();
+    }
+    const_iterator find(const NodeType &node) const
+    {
+        return const_cast<FlatNodeMap *>(this)->find(node);
+    }
+
+    size_t count(const NodeType &node) const { return find(node) != end() ? 1 : 0; }
+
+    size_t erase(const NodeType &node)
+    {
+        const auto it = find(node);
+        if (it == end())
+            return 0;
+        entries.erase(it);
+        return 1;
+    }
+    iterator erase(const_iterator it) { return entries.erase(it); }
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.cbegin(); }
+    const_iterator end() const { return entries.cend(); }
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    void clear() { entries.clear(); }
+    void reserve(size_t num) { entries.reserve(num); }
+
+protected:
+    iterator lowerBound(int64_t key)
+    {
+        return std::lower_bound(entries.begin(),entries.end(),key,
+                                [](const value_type &entry,int64_t val) { return entry.first.NodeNumber() < val; });
+    }
+
+    std::vector<value_type> entries;
+};
+
+}
@@ -19,10 +19,14 @@
 #import <math.h>
 #import <set>
 #import <map>
+#import <list>
+#import <unordered_map>
 #import "Identifiable.h"
 #import "BasicDrawable.h"
 #import "TextureAtlas.h"
 #import "DynamicTextureAtlas.h"
+#import "GlyphCache.h"
+#import "MemoryGovernor.h"
 
 namespace WhirlyKit
 {
@@ -99,6 +103,10 @@ public:
     std::string fontName;
     float outlineSize = 0.0f;
     float pointSize = 0.0f;
+    /// Glyphs are distance fields rendered at SDFPointSize, shared by every size of this font
+    bool sdf = false;
+    /// Identifies this font in the glyph cache.  Empty if it can't be cached.
+    std::string cacheKey;
 
 protected:
     // Maps Glyphs (shorts) to texture and region
@@ -127,12 +135,15 @@ struct DrawableString : public Identifiable
 
     /// Bounding box of the string in coordinates related to the font size
     Mbr mbr;
+
+    /// Set if the glyphs are distance fields, which need the SDF shader
+    bool sdf = false;
 };
 
 /** Used to manage a dynamic texture set containing glyphs from
     various fonts.
   */
-class FontTextureManager
+class FontTextureManager : public MemoryConsumer
 {
 public:
     // Construct with a scene
@@ -172,17 +183,90 @@ public:
     // Tear down everything we've built
     void clear(ChangeSet &changes);
 
+    /// Keep rendered glyphs on disk so we don't have to render them again next time.
+    /// Only applies to fonts set up after this.  Null turns it off.
+    void setGlyphCache(GlyphCacheRef cache);
+    GlyphCacheRef getGlyphCache();
+
+    /** Render glyphs once as signed distance fields and scale them to whatever size is wanted.
+        That's one atlas entry per glyph across all the sizes and colors of a font, rather than one each.
+        Text with outlines or background colors is still rendered the usual way.
+        Labels using the default screen space shader are switched over to the SDF version.
+        Other shaders need to threshold the alpha themselves.  Only affects strings added after this.
+      */
+    void setSDFMode(bool enable);
+    bool getSDFMode();
+
+    /** Free up atlas pages as glyphs are removed.
+        Empty pages are released and sparse ones merged into others, which matters over long
+        sessions with lots of labels coming and going.  Off by default.
+      */
+    void setAtlasCompaction(bool enable);
+    bool getAtlasCompaction();
+
+    /** Keep the layout of this many recent strings, keyed by their text and font.
+        Labels that come up again, like road names across tiles, are built from
+        that rather than shaped and looked up glyph by glyph.  0 turns it off.
+      */
+    void setLayoutCacheSize(size_t size);
+    size_t getLayoutCacheSize();
+
+    /// Point size SDF glyphs are rendered at
+    static constexpr float SDFPointSize = 48.0f;
+    /// How far out from the glyph edges the distance field goes, in pixels at that size
+    static constexpr int SDFRadius = 6;
+
+    /** Turn a rendered glyph into a signed distance field, padded by SDFRadius on each side.
+        The result is white with the distance in alpha, 0.5 being the edge.
+      */
+    static void makeSDFGlyph(const unsigned char *rgba,int width,int height,
+                             std::vector<unsigned char> &out,int &outWidth,int &outHeight);
+
     virtual void teardown(PlatformThreadInfo*) = 0;
 
+    /// Atlas pages and the layout cache
+    virtual void addMemoryUsage(MemoryUsage &usage) override;
+
+    /// Drops the layout cache first and repacks the atlas last
+    virtual void trimMemory(PlatformThreadInfo *inst,MemoryTrimLevel step,ChangeSet &changes) override;
+
 protected:    
     void init();
 
+    // Font and glyph for each of a string's rectangles
+    typedef std::vector<std::pair<SimpleIdentity,WKGlyph>> LayoutGlyphs;
+
+    // A string as it was laid out, less its ID
+    struct StringLayout
+    {
+        std::vector<DrawableString::Rect> glyphPolys;
+        LayoutGlyphs glyphs;
+        Mbr mbr;
+        bool sdf;
+        std::list<std::string>::iterator lruPos;
+    };
+
+    /// Make a string from an earlier layout, if there is one and its glyphs are still around.
+    /// The glyphs are referenced as if it was laid out again.  Lock must be held.
+    std::unique_ptr<DrawableString> findLayout(const std::string &key);
+
+    /// Remember how a string was laid out.  Lock must be held.
+    void addLayout(const std::string &key,const DrawableString &drawString,LayoutGlyphs &&glyphs);
+
     FontManagerMap fontManagers;
 
     SceneRenderer *sceneRender = nullptr;
     Scene *scene = nullptr;
     DynamicTextureAtlas *texAtlas = nullptr;
     DrawStringRepSet drawStringReps;
+    GlyphCacheRef glyphCache;
+    bool sdfMode = false;
+    bool atlasCompaction = false;
+    int glyphsRemoved = 0;
+    size_t maxLayouts = 1024;
+    std::unordered_map<std::string,StringLayout> layouts;
+    // Most recently used at the front
+    std::list<std::string> layoutLRU;
     std::mutex lock;    
 };
     
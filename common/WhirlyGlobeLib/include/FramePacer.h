@@ -0,0 +1,82 @@
+/*  FramePacer.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <mutex>
+#import "WhirlyTypes.h"
+
+namespace WhirlyKit
+{
+
+/** Decides when the renderer should draw a frame and how fast the display should drive us.
+    The platform views poll this on every display callback.  The renderer says what's
+    waiting to be drawn and we hold it until the frame rate for that kind of change comes up.
+    With ProMotion or other variable refresh displays it also tells the view what rate
+    to ask for, so an idle map doesn't wake up at the full display rate.
+  */
+class FramePacer
+{
+public:
+    /// How hard we try to keep the frame rate up
+    typedef enum {
+        PacingFull = 0,     // Full display rate whenever anything needs drawing
+        PacingBalanced,     // Full rate for view motion, less for animation and loading
+        PacingLowPower,     // Capped at 60 for motion, the low rate for everything else
+    } Mode;
+
+    /// What's waiting to be drawn, least urgent first
+    typedef enum {
+        NeedNone = 0,
+        NeedBackground,     // Scene changes, such as tiles coming in, and the extra frames after
+        NeedAnimation,      // Fades, render until requests and continuous render requests
+        NeedMotion,         // The view moved
+    } Need;
+
+    FramePacer() = default;
+
+    /// Full by default, which renders whenever there's something to draw
+    void setMode(Mode mode);
+    Mode getMode() const;
+
+    /// Fastest the display will go, such as 120 for ProMotion.  Defaults to 60.
+    void setDisplayRate(int fps);
+    int getDisplayRate() const;
+
+    /// Rate for the things we slow down in the battery friendly modes.  Defaults to 30.
+    void setLowRate(int fps);
+    int getLowRate() const;
+
+    /// Add what's waiting and decide if we should render now.
+    /// A yes clears out what was waiting.
+    bool shouldRender(Need need,TimeInterval now);
+
+    /// Rate the display should call us at, based on what we've been drawing lately
+    int getPreferredRate(TimeInterval now) const;
+
+protected:
+    // Frame rate for a given need in the current mode.  Lock must be held.
+    int rateFor(Need need) const;
+
+    mutable std::mutex lock;
+    Mode mode = PacingFull;
+    int displayRate = 60;
+    int lowRate = 30;
+    Need pending = NeedNone;
+    Need lastNeed = NeedNone;
+    TimeInterval lastFrame = 0.0;
+};
+
+}
@@ -0,0 +1,105 @@
+/*  FrameStats.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import <mutex>
+#import <atomic>
+#import "WhirlyTypes.h"
+
+namespace WhirlyKit
+{
+
+/** Per-frame renderer statistics.
+    The renderer fills in one Frame each time through and hands it over,
+    we keep the last few hundred and summarize them on request.
+    Frames are added on the render thread, but the summaries can be
+    pulled from anywhere.
+  */
+class FrameStats
+{
+public:
+    /// What we track for each frame.  Times are in seconds.
+    typedef enum {
+        FrameTime = 0,      // Whole frame
+        ChangeTime,         // Change requests and active models
+        CullTime,           // Visibility and sorting
+        DrawTime,           // Encoding or issuing draws
+        PresentTime,        // Handing the frame off for display
+        DrawablesDrawn,
+        DrawCalls,
+        Triangles,
+        TextureBytes,       // Texture data handed over by change requests
+        ChangesExecuted,
+        StateCalls,         // GL state changes made on the way to drawing
+        StateCallsSkipped,  // ...and the ones we didn't need to make
+        NumMetrics
+    } Metric;
+
+    /// Readable name for a metric
+    static const char *getMetricName(Metric metric);
+
+    /// One frame's worth of values
+    struct Frame
+    {
+        TimeInterval when = 0.0;
+        double values[NumMetrics] = {0.0};
+
+        void add(Metric metric,double val) { values[metric] += val; }
+    };
+
+    /// Distribution of one metric over the recorded frames
+    struct Summary
+    {
+        Metric metric = FrameTime;
+        int numFrames = 0;
+        double minVal = 0.0, maxVal = 0.0, mean = 0.0;
+        double p50 = 0.0, p95 = 0.0, p99 = 0.0;
+    };
+
+    /// Keep up to this many frames around
+    FrameStats(int maxFrames = 600);
+
+    /// Recording is off by default
+    void setEnable(bool enable);
+    bool isEnabled() const { return enable.load(std::memory_order_relaxed); }
+
+    /// Add a frame to the history, dropping the oldest if we're full
+    void addFrame(const Frame &frame);
+
+    /// Summarize a metric over the frames we've got
+    Summary getSummary(Metric metric) const;
+
+    /// Summarize all the metrics
+    std::vector<Summary> getSummaries() const;
+
+    /// The frames we have, oldest first
+    std::vector<Frame> getFrames() const;
+
+    /// Toss all the frames
+    void clear();
+
+protected:
+    Summary makeSummary(Metric metric,std::vector<double> &vals) const;
+
+    std::atomic<bool> enable;
+    mutable std::mutex lock;
+    std::vector<Frame> frames;
+    size_t maxFrames;
+    size_t nextFrame = 0;
+};
+
+}
@@ -0,0 +1,90 @@
+/*  GPUTimings.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import <mutex>
+#import <atomic>
+#import "WhirlyTypes.h"
+
+namespace WhirlyKit
+{
+
+/** GPU time for each part of a frame, as the GPU reports it.
+    The parts follow the renderer's work groups.  Results come back a frame or
+    more after the CPU is done with it, so the renderer hands them over when they
+    show up, from whatever thread that happens on.
+    We keep the last few hundred frames and summarize them on request.
+  */
+class GPUTimings
+{
+public:
+    /// Parts of a frame.  The first few line up with WorkGroup::GroupType.
+    typedef enum {
+        Calculation = 0,
+        Offscreen,
+        ReduceOps,
+        ScreenRender,
+        Total,          // Sum of the rest, filled in for us
+        NumPhases
+    } Phase;
+
+    /// Readable name for a phase
+    static const char *getPhaseName(Phase phase);
+
+    /// One frame's worth of GPU times, in seconds
+    struct Frame
+    {
+        double values[NumPhases] = {0.0};
+        bool timed[NumPhases] = {false};
+
+        void add(Phase phase,double val) { values[phase] += val;  timed[phase] = true; }
+    };
+
+    /// Distribution of one phase over the frames that ran it
+    struct Summary
+    {
+        Phase phase = Total;
+        int numFrames = 0;
+        double minVal = 0.0, maxVal = 0.0, mean = 0.0;
+        double p50 = 0.0, p95 = 0.0, p99 = 0.0;
+    };
+
+    /// Keep up to this many frames around
+    GPUTimings(int maxFrames = 600);
+
+    /// Timing is off by default.  It costs a little on the GPU side while it's on.
+    void setEnable(bool enable);
+    bool isEnabled() const { return enable.load(std::memory_order_relaxed); }
+
+    /// Add a frame, dropping the oldest if we're full
+    void addFrame(const Frame &frame);
+
+    /// Summarize all the phases
+    std::vector<Summary> getSummaries() const;
+
+    /// Toss all the frames
+    void clear();
+
+protected:
+    std::atomic<bool> enable;
+    mutable std::mutex lock;
+    std::vector<Frame> frames;
+    size_t maxFrames;
+    size_t nextFrame = 0;
+};
+
+}
@@ -0,0 +1,142 @@
+/*  GeoJSONStreamReader.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <functional>
+#import <string>
+#import <vector>
+#import "VectorData.h"
+
+namespace WhirlyKit
+{
+
+/** Reads GeoJSON a feature at a time.
+    VectorParseGeoJSON builds the whole document in memory before making any shapes,
+    which is a problem for big files.  This goes straight from the text to shapes and
+    only holds on to the feature it's working on.  The text can come from memory (a
+    mapped file, say) or be read in pieces as we go.
+    Handles a FeatureCollection, a single Feature, a bare geometry, or an assembly of
+    named collections.  Properties that are strings, numbers or booleans are kept,
+    the same as VectorParseGeoJSON.
+  */
+class GeoJSONStreamReader
+{
+public:
+    /// Fills in up to len bytes, returning how many.  0 at the end.
+    typedef std::function<size_t(char *buf,size_t len)> ReadFunc;
+
+    /// Read from memory, which has to stay around while we're reading
+    GeoJSONStreamReader(const char *data,size_t len);
+    /// Read through the function as we need more
+    GeoJSONStreamReader(ReadFunc readFunc);
+
+    /// Expect an object full of named collections, as in VectorParseGeoJSONAssembly
+    void setAssembly(bool isAssembly) { assembly = isAssembly; }
+
+    /** Read the next feature.
+        The shapes all share the attributes, which are also set on each of them.
+        Returns false at the end, or on an error, which you can tell apart with getError().
+      */
+    bool next(ShapeSet &shapes,MutableDictionaryRef &attrs);
+
+    /// Name of the collection the last feature came out of, for assemblies
+    const std::string &getCollectionName() const { return collectionName; }
+
+    /// CRS name from the document, if it had one and we've passed it
+    const std::string &getCRS() const { return crs; }
+
+    /// Empty unless something went wrong
+    const std::string &getError() const { return error; }
+
+    /// Called for each feature.  Return false to stop.
+    typedef std::function<bool(ShapeSet &shapes,const MutableDictionaryRef &attrs)> FeatureFunc;
+
+    /** Read all the features out of a FeatureCollection in memory on several threads.
+        The features array is split up between them, so the callback happens on any
+        of those threads, in no particular order.
+        Anything that isn't a plain FeatureCollection is read on this thread instead.
+      */
+    static bool readParallel(const char *data,size_t len,int numThreads,const FeatureFunc &featureFunc,
+                             std::string *error = nullptr);
+
+protected:
+    // Where we are in the document between calls to next()
+    typedef enum {StateStart,StateAssembly,StateCollection,StateFeatures,StateDone} State;
+
+    // Coordinates for one geometry, before we know what it is
+    struct Coords
+    {
+        // Depth of the nesting where we found numbers
+        int depth = 0;
+        VectorRing pts;
+        // Where arrays above the positions closed, as (nesting, number of points so far)
+        std::vector<std::pair<int,int>> closes;
+    };
+
+    // Reading the text
+    bool fill();
+    int peek();
+    int get();
+    bool skipSpace();
+    bool expect(char c);
+    bool fail(const char *what);
+
+    // Reading JSON values
+    bool readString(std::string &str);
+    bool readNumber(double &val);
+    bool readLiteral(const char *lit);
+    bool skipValue(int depth = 0);
+    bool skipString();
+    bool nextMember(bool &first,std::string &key,bool &closed);
+
+    // Reading GeoJSON pieces
+    bool readCoords(Coords &coords,int nesting = 1);
+    bool readGeometry(ShapeSet &shapes,int depth = 0);
+    bool readProperties(const MutableDictionaryRef &attrs);
+    bool readCRS();
+    bool readFeature(ShapeSet &shapes,MutableDictionaryRef &attrs);
+    void finishFeature(ShapeSet &shapes,MutableDictionaryRef &attrs);
+    void resetTop();
+    static void buildShapes(const std::string &type,Coords &coords,ShapeSet &shapes);
+
+    // Start reading just inside a features array, for readParallel
+    void startInFeatures();
+
+    const char *pos,*end;
+    ReadFunc readFunc;
+    std::vector<char> buf;
+
+    bool assembly;
+    State state;
+    bool assemblyFirst;
+    bool collectionFirst;
+    bool featuresFirst;
+    // Stop at the end of the data rather than looking for the end of the features
+    bool chunk;
+
+    // A collection that turned out to be a single Feature or a bare geometry
+    std::string topType;
+    Coords topCoords;
+    ShapeSet topShapes;
+    MutableDictionaryRef topAttrs;
+    bool topGeometry;
+
+    std::string collectionName;
+    std::string crs;
+    std::string error;
+};
+
+}
@@ -309,6 +309,12 @@ public:
     /// Add instances that reuse base geometry
     SimpleIdentity addGeometryInstances(SimpleIdentity baseGeomID,const std::vector<GeometryInstance> &instances,GeometryInfo &geomInfo,ChangeSet &changes);
     
+    /** Change a run of instances added with addGeometryInstances, starting with the given one.
+        They're rewritten in place, so the number of instances stays the same.
+        Colors come from the instances alone and selection boxes stay where they started out.
+      */
+    void changeGeometryInstances(SimpleIdentity geomID,unsigned int startInst,const std::vector<GeometryInstance> &instances,ChangeSet &changes);
+
     /// Add a GPU geometry instance
     SimpleIdentity addGPUGeomInstance(SimpleIdentity baseGeomID,SimpleIdentity programID,SimpleIdentity texSourceID,SimpleIdentity srcProgramID,GeometryInfo &geomInfo,ChangeSet &changes);
     
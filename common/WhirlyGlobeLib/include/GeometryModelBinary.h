@@ -0,0 +1,62 @@
+/*  GeometryModelBinary.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <string>
+#import <vector>
+#import "GeometryManager.h"
+#import "RawData.h"
+
+namespace WhirlyKit
+{
+
+/** Compact binary form of a model's raw geometry, so we can skip the OBJ parse on later loads.
+    Each piece of geometry is stored as a block of interleaved vertices (position, normal,
+    color and tex coords if it has them) and a block of triangle indices, along with the
+    table of texture file names the geometry refers to.
+    The source file's size and modification time go in the header, so a stale file is just ignored.
+  */
+class GeometryModelBinary
+{
+public:
+    /// Convert raw geometry, which should already be cache optimized
+    static RawDataRef encode(const std::string &srcPath,
+                             const std::vector<std::string> &textures,
+                             const std::vector<GeometryRaw> &rawGeom);
+
+    /// Convert back to raw geometry.  Returns false if the data doesn't check out for this source file.
+    static bool decode(const RawData &data,const std::string &srcPath,
+                       std::vector<std::string> &textures,
+                       std::vector<GeometryRaw> &rawGeom);
+
+    /** Read an OBJ model by way of a binary cache file.
+        If the cache file is there and matches the OBJ, it's memory mapped and decoded.
+        Otherwise we parse the OBJ, optimize it, and write the cache file for next time.
+      */
+    static bool readOBJ(const std::string &objPath,const std::string &resourceDir,
+                        const std::string &cachePath,
+                        std::vector<std::string> &textures,
+                        std::vector<GeometryRaw> &rawGeom);
+
+    /** Reorder the triangles to make good use of the GPU's post-transform vertex cache,
+        then the vertices in the order the triangles first touch them.
+        This is Tom Forsyth's linear speed vertex cache optimization, which is what
+        meshoptimizer and most other tools use.
+      */
+    static void optimizeVertexCache(GeometryRaw &geom);
+};
+
+}
@@ -34,6 +34,10 @@ public:
     bool parse(FILE *fp);
     // Parse material library
     bool parseMaterials(FILE *fp);
+
+    // Parse from memory, such as a mapped file, without copying it
+    bool parse(const RawData &data);
+    bool parseMaterials(const RawData &data);
     
     // Convert to raw geometry objects
     void toRawGeometry(std::vector<std::string> &textures,std::vector<GeometryRaw> &rawGeom);
@@ -82,6 +86,14 @@ public:
         std::vector<Face> faces;
     };
     
+protected:
+    // Lines from a file or a buffer
+    class LineReader;
+
+    bool parse(LineReader &reader);
+    bool parseMaterials(LineReader &reader);
+
+public:
     std::string resourceDir;
     std::vector<Group> groups;
     Point3dVector verts;
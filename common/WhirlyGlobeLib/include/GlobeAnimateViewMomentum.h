@@ -40,6 +40,9 @@ public:
 
     virtual bool isUserMotion() const { return false; }
 
+    /// Where the rotation will be in a bit
+    virtual bool predictView(WhirlyKit::View *,WhirlyKit::TimeInterval ahead) override;
+
     /// Set the velocity while this is running (for auto-rotate)
     void setVelocity(double newVel) { velocity = newVel; }
 
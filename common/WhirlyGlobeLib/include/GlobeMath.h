@@ -54,6 +54,15 @@ public:
     /// Static version for convenience
     static Point3f GeocentricToLocal(Point3f);
     static Point3d GeocentricToLocal(Point3d);
+
+    /// Batch versions, which go through Proj once for the lot
+    virtual void geographicToLocalBatch(const Point2d *geo,Point3d *local,size_t count) const override;
+    virtual void localToGeographicBatch(const Point3d *local,Point2d *geo,size_t count) const override;
+    virtual void localToGeocentricBatch(const Point3d *local,Point3d *geoc,size_t count) const override { LocalToGeocentric(local,geoc,count); }
+    virtual void geocentricToLocalBatch(const Point3d *geoc,Point3d *local,size_t count) const override { GeocentricToLocal(geoc,local,count); }
+    /// Static versions.  The output can be the input.
+    static void LocalToGeocentric(const Point3d *local,Point3d *geoc,size_t count);
+    static void GeocentricToLocal(const Point3d *geoc,Point3d *local,size_t count);
     
     /// Convenience routine to convert a whole MBR to local coordinates
     static Mbr GeographicMbrToLocal(GeoMbr);
@@ -96,6 +105,9 @@ public:
     /// Return a normal for the given point
     virtual Point3f normalForLocal(Point3f p) const override { return LocalToDisplay(p); }
     virtual Point3d normalForLocal(Point3d p) const override { return LocalToDisplay(p); }
+
+    /// Convert a run of points onto the sphere
+    virtual void localToDisplayBatch(const Point3d *local,Point3d *disp,size_t count) const override;
     
     /// Get a reference to the coordinate system
     virtual CoordSystem *getCoordSystem() const override { return &geoCoordSys; }
@@ -139,6 +151,9 @@ public:
     /// Return a normal for the given point
     virtual Point3f normalForLocal(Point3f p) const override { return LocalToDisplay(p); }
     virtual Point3d normalForLocal(Point3d p) const override { return LocalToDisplay(p); }
+
+    /// Convert a run of points, going through Proj once
+    virtual void localToDisplayBatch(const Point3d *local,Point3d *disp,size_t count) const override;
     
     /// Get a reference to the coordinate system
     virtual CoordSystem *getCoordSystem() const override { return &geoCoordSys; }
@@ -151,6 +166,54 @@ protected:
 };
 
 
+/** A cone out from the center of the globe holding some geometry, for quick horizon checks.
+    Figure it once, when the geometry is built, and test it against a HorizonCuller each frame.
+    The spread is the cone's half angle plus how far past the horizon the highest part can still be seen.
+  */
+struct HorizonBound
+{
+    HorizonBound() = default;
+
+    /// Bound points in display space, plus up to extraHeight above them
+    HorizonBound(const Point3d *pts,size_t numPts,double extraHeight = 0.0);
+
+    /// False if there's nothing in it, or it's spread so wide it can always be seen
+    bool isValid() const { return valid; }
+
+    Point3f axis = { 0, 0, 0 };
+    float cosSpread = 1.0f;
+    float sinSpread = 0.0f;
+    bool valid = false;
+};
+
+/** Tests geometry against the globe as an occluding sphere, from one eye position.
+    Set this up once per frame and share it, since the tests are then just a few multiplies.
+    It does nothing when the eye is inside the globe, or on a flat map, where it's never set up.
+  */
+class HorizonCuller
+{
+public:
+    HorizonCuller() = default;
+
+    /// Set up for an eye in display space
+    HorizonCuller(const Point3d &eyePos);
+
+    /// True if we're doing any culling at all
+    bool isEnabled() const { return enabled; }
+
+    /// True if everything in the bound is around the back of the globe
+    bool isHidden(const HorizonBound &bound) const;
+
+    /// True if a point in display space is around the back of the globe
+    bool isHidden(const Point3d &pt) const;
+
+protected:
+    Point3d eyeDir = { 0, 0, 0 };
+    // Angle between the eye and the horizon, seen from the center
+    double cosHorizon = 1.0, sinHorizon = 0.0;
+    bool enabled = false;
+};
+
 // Returns negative if the given location (with its normal) is currently facing away from the viewer
 float CheckPointAndNormFacing(const Point3f &dispLoc,const Point3f &norm,const Eigen::Matrix4f &viewAndModelMat,const Eigen::Matrix4f &viewModelNormalMat);
 
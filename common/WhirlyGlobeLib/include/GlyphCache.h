@@ -0,0 +1,91 @@
+/*  GlyphCache.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <string>
+#import <vector>
+#import <mutex>
+#import <memory>
+#import <unordered_map>
+#import "WhirlyVector.h"
+
+namespace WhirlyKit
+{
+
+/** On-disk cache of rendered glyph images.
+    The platform font managers render glyphs with the system text engine, which is slow,
+    so we keep the results between runs.  Each font setup (name, size, colors and outline)
+    gets its own file, glyph images are appended to it as they're rendered, and the index
+    for a font is read in the first time it's needed.
+    Several caches on the same directory, or processes, may append to the same file.
+    Anything that doesn't check out is ignored, so a bad file just means rendering again.
+  */
+class GlyphCache
+{
+public:
+    /// Cache in the given directory, which should already exist
+    GlyphCache(std::string dir);
+
+    /// The cache for a given directory, shared with anyone else who asks for it
+    static std::shared_ptr<GlyphCache> getShared(const std::string &dir);
+
+    /// One rendered glyph and the metrics the font manager needs to place it
+    struct Glyph
+    {
+        int width = 0, height = 0;
+        float sizeX = 0.0f, sizeY = 0.0f;
+        float glyphSizeX = 0.0f, glyphSizeY = 0.0f;
+        float offsetX = 0.0f, offsetY = 0.0f;
+        float textureOffsetX = 0.0f, textureOffsetY = 0.0f;
+        /// RGBA, 4 bytes per pixel
+        std::vector<unsigned char> pixels;
+    };
+
+    /// Identifies a font setup.  Anything that changes the rendered image belongs in here.
+    static std::string fontKey(const std::string &fontName,float pointSize,
+                               const RGBAColor &color,const RGBAColor &backColor,
+                               const RGBAColor &outlineColor,float outlineSize);
+
+    /// Look for a rendered glyph
+    bool findGlyph(const std::string &fontKey,uint32_t glyph,Glyph &outGlyph);
+
+    /// Save a rendered glyph for next time
+    void addGlyph(const std::string &fontKey,uint32_t glyph,const Glyph &inGlyph);
+
+    const std::string &getDir() const { return dir; }
+
+protected:
+    // What we know about one font's file
+    struct FontFile
+    {
+        std::string path;
+        bool valid = false;
+        // Where each glyph record starts
+        std::unordered_map<uint32_t,long> offsets;
+    };
+
+    // Find or read the index for a font.  Lock must be held.
+    FontFile &fontFile(const std::string &fontKey);
+    // Read through a font file noting where the glyphs are
+    static bool readIndex(FontFile &file,const std::string &fontKey);
+
+    std::string dir;
+    std::mutex lock;
+    std::unordered_map<std::string,FontFile> fonts;
+};
+typedef std::shared_ptr<GlyphCache> GlyphCacheRef;
+
+}
@@ -25,8 +25,30 @@
 namespace WhirlyKit
 {
 
+/** Clips rings to each cell of a grid for tessellation, keeping its scratch space between calls.
+    Each column is cut out of the ring and then each cell out of the column, Sutherland-Hodgman
+    style, on plain arrays of points.  Only the cells the ring actually covers are visited.
+    A concave ring that crosses into a cell more than once comes out as one ring for that cell,
+    with zero width seams along the cell edge joining the pieces.  Those tessellate to nothing.
+    Not thread safe, use one per thread.
+  */
+class GridClipper
+{
+public:
+    /// Clip a ring to the grid with the given origin and spacing, adding the pieces to rets.
+    /// They all wind clockwise, like those from ClipLoopsToGrid.
+    void clip(const VectorRing &ring,const Point2f &org,const Point2f &spacing,std::vector<VectorRing> &rets);
+
+protected:
+    // Keep the part of the polygon in between lo and hi along the given axis
+    void clipSlab(const std::vector<Point2d> &in,int axis,double lo,double hi,std::vector<Point2d> &out);
+
+    std::vector<Point2d> ringPts,column,cell,half;
+};
+
 /** Clip Loop to Grid will clip the given areal loop to a grid specified by the origin and spacing
     and return the results as individual loops.  This is used by the loft layer.
+    It uses a GridClipper kept for each thread, so the results are meant for tessellation.
   */
 bool ClipLoopToGrid(const VectorRing &ring,Point2f org,Point2f spacing,std::vector<VectorRing> &rets);
 // This version clips a whole group of rings.  The first one is the outer, the rest inner.
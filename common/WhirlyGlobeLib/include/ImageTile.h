@@ -49,6 +49,8 @@ public:
     int borderSize;
     int width,height,components;
     int targetWidth,targetHeight;
+    // If set, images bigger than this on a side are scaled down as they're decoded
+    int maxDecodeSize;
 };
 
 typedef std::shared_ptr<ImageTile> ImageTileRef;
@@ -0,0 +1,133 @@
+/*  InterleavedVertexBuilder.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import <cstring>
+#import "BasicDrawableBuilder.h"
+
+namespace WhirlyKit
+{
+
+/// Texture coordinates for the first texture in an InterleavedVertexBuilder layout
+struct VertexTexCoord
+{
+    typedef TexCoord Type;
+    static int attrID(BasicDrawableBuilder &builder)
+    {
+        builder.setupTexCoordEntry(0,0);
+        return builder.basicDraw->texInfo[0].texCoordEntry;
+    }
+};
+
+/// Per-vertex color in an InterleavedVertexBuilder layout
+struct VertexColor
+{
+    typedef RGBAColor Type;
+    static int attrID(BasicDrawableBuilder &builder) { return builder.basicDraw->colorEntry; }
+};
+
+/// Per-vertex normal in an InterleavedVertexBuilder layout
+struct VertexNormal
+{
+    typedef Point3f Type;
+    static int attrID(BasicDrawableBuilder &builder) { return builder.basicDraw->normalEntry; }
+};
+
+/// Bytes taken up by a set of attributes, one after the other
+template <typename... Attrs> struct VertexLayoutSize;
+template <> struct VertexLayoutSize<>
+{
+    static constexpr size_t value = 0;
+};
+template <typename Attr,typename... Rest> struct VertexLayoutSize<Attr,Rest...>
+{
+    static constexpr size_t value = sizeof(typename Attr::Type) + VertexLayoutSize<Rest...>::value;
+};
+
+/** Packs vertices for a BasicDrawableBuilder with a layout fixed at compile time.
+    Each vertex is a position followed by the given attributes, in order, e.g.
+    InterleavedVertexBuilder<VertexTexCoord,VertexNormal>.
+    Vertices go straight into one buffer laid out the way the renderer wants it,
+    rather than through the builder's per-attribute calls and arrays.
+    Indices are 16 bits, so check hasRoomFor() and flush to a new builder when it's full.
+  */
+template <typename... Attrs>
+class InterleavedVertexBuilder
+{
+public:
+    /// Size of a single vertex, position included
+    static constexpr size_t VertexSize = sizeof(Point3f) + VertexLayoutSize<Attrs...>::value;
+
+    InterleavedVertexBuilder(int numReserve = 0)
+    {
+        if (numReserve > 0)
+            verts.reserve(numReserve * VertexSize);
+    }
+
+    /// Add a vertex with a value for each of the attributes and return its index
+    unsigned int addVertex(const Point3f &pt,const typename Attrs::Type &... vals)
+    {
+        const size_t start = verts.size();
+        verts.resize(start + VertexSize);
+        unsigned char *ptr = put(&verts[start],pt);
+        // Braced lists are evaluated in order, so this writes the attributes in layout order
+        const int written[] = { 0, ((ptr = put(ptr,vals)), 0)... };
+        (void)written;
+        (void)ptr;
+        return numVerts++;
+    }
+
+    /// Add a triangle referring to vertices added since the last flush
+    void addTriangle(unsigned short v0,unsigned short v1,unsigned short v2)
+    {
+        tris.emplace_back(v0,v1,v2);
+    }
+
+    /// Number of vertices since the last flush
+    unsigned int getNumVertices() const { return numVerts; }
+
+    /// True if the builder we're flushing to can take this many more vertices
+    bool hasRoomFor(const BasicDrawableBuilder &builder,unsigned int numNew) const
+    {
+        return builder.getNumPoints() + numVerts + numNew <= MaxDrawablePoints;
+    }
+
+    /// Hand everything to the builder and start over
+    void flush(BasicDrawableBuilder &builder)
+    {
+        if (numVerts == 0)
+            return;
+
+        builder.addInterleavedVertices(std::move(verts),(int)VertexSize,{ Attrs::attrID(builder)... },tris);
+        verts.clear();
+        tris.clear();
+        numVerts = 0;
+    }
+
+protected:
+    template <typename T> static unsigned char *put(unsigned char *ptr,const T &val)
+    {
+        memcpy(ptr,&val,sizeof(T));
+        return ptr + sizeof(T);
+    }
+
+    std::vector<unsigned char> verts;
+    std::vector<BasicDrawable::Triangle> tris;
+    unsigned int numVerts = 0;
+};
+
+}
@@ -27,6 +27,7 @@
 #import "MaplyView.h"
 #import "Scene.h"
 #import "ScreenSpaceBuilder.h"
+#import "TriangleIndex.h"
 
 namespace WhirlyKit
 {
@@ -62,12 +63,25 @@ public:
     /// Remove an intersectable object
     void removeIntersectable(Intersectable *intersect);
 
+    /** Add triangles in display space for something we can hit, such as a tile or an extruded building.
+        Three points to a triangle.  These go into a bounding volume hierarchy, so there can be lots of them.
+        Adding again with the same ID replaces the old ones.
+      */
+    void addTriangles(SimpleIdentity objID,const Point3dVector &tris);
+
+    /// Remove the triangles added with the given ID
+    void removeTriangles(SimpleIdentity objID);
+
+    /// Turn triangles on or off without taking them out
+    void enableTriangles(SimpleIdentity objID,bool enable);
+
     /// Look for the nearest intersection and return the point (in display coordinates)
     bool findIntersection(SceneRenderer *renderer,View *theView,const Point2f &frameSize,const Point2f &touchPt,Point3d &iPt,double &dist);
 
 protected:
     Scene *scene;
     std::set<Intersectable *> intersectables;
+    TriangleIndex triangles;
 };
 typedef std::shared_ptr<IntersectionManager> IntersectionManagerRef;
 
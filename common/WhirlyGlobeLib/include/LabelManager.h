@@ -149,6 +149,9 @@ protected:
     WhirlyKit::LabelSceneRepSet labelReps;
     unsigned int textureAtlasSize;
     SimpleIdentity maskProgID;
+    // Default screen space programs and their distance field counterparts
+    SimpleIdentity defaultProgID = EmptyIdentity, defaultMotionProgID = EmptyIdentity;
+    SimpleIdentity sdfProgID = EmptyIdentity, sdfMotionProgID = EmptyIdentity;
 };
 typedef std::shared_ptr<LabelManager> LabelManagerRef;
 
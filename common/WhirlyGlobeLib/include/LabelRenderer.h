@@ -151,6 +151,9 @@ public:
     float scale = 1.0f;
     // Program used to render masks to their target
     SimpleIdentity maskProgID = 0;
+    /// Distance field strings use these in place of the default screen space programs
+    SimpleIdentity defaultProgID = 0, defaultMotionProgID = 0;
+    SimpleIdentity sdfProgID = 0, sdfMotionProgID = 0;
     
     /// Convenience routine to convert the points to model space
     Point3dVector convertGeoPtsToModelSpace(const VectorRing &inPts) const;
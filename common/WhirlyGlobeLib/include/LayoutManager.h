@@ -24,6 +24,8 @@
 #import "SelectionManager.h"
 #import "OverlapHelper.h"
 #import "VectorManager.h"
+#import "WorkerPool.h"
+#import "ClusterHierarchy.h"
 
 #import <math.h>
 #import <map>
@@ -133,6 +135,34 @@ struct LayoutObjectEntry : public Identifiable
 
     // Set if we changed something during evaluation
     bool changed = true;
+
+    // For incremental layout, where it was on screen net of the view shift when last evaluated,
+    //  the orientation picked (-1 if it was blocked, -2 if there's nothing to reuse) and the area it took
+    Point2f layoutPt {MAXFLOAT,MAXFLOAT};
+    int layoutOrient = -2;
+    Mbr layoutMbr;
+
+    // For layout along a shape, where each instance went the last time we walked the line.
+    // The glyphs are relative to the anchor on screen, so we can reuse them while the view only pans.
+    struct ShapeInstance
+    {
+        Point3d worldPt;
+        // World points right of and below the anchor and where they landed relative to it,
+        // to catch zooms and rotations
+        Point3d refPts[2];
+        Point2f refOffsets[2];
+        std::vector<Eigen::Matrix3d> glyphMats;
+        std::vector<Mbr> glyphMbrs;
+    };
+    std::vector<ShapeInstance> shapeInstances;
+
+    // Screen runs along the shape for each view matrix, if they were worked out ahead of
+    // the placement pass, along with the view they're good for
+    std::vector<std::vector<VectorRing>> shapeRuns;
+    ViewStateRef shapeRunsView;
+
+    // Where its vertices went in the current drawables, if we're toggling in place
+    std::vector<ScreenSpaceBuilder::VertexRange> drawRanges;
 };
 typedef std::shared_ptr<LayoutObjectEntry> LayoutObjectEntryRef;
 typedef std::set<LayoutObjectEntryRef,IdentifiableRefSorter> LayoutEntrySet;
@@ -302,6 +332,51 @@ public:
     /// (e.g., when scheduled animations complete)
     void deferUntil(TimeInterval minTime);
 
+    /** In incremental mode we keep the placements from the previous pass.
+        Objects that haven't moved on screen relative to the rest of the view, by more than
+        the threshold (in points), keep their placement unless something near them changed.
+        Drawables are built in groups and only the groups with changes are replaced.
+        Clustering or a display object limit turn the placement reuse off.  Off by default.
+      */
+    void setIncremental(bool enable,float moveThreshold = 2.0f);
+    bool getIncremental() const { return incremental; }
+
+    /** Lay out on this many extra threads.  The screen is split into tiles.  Objects that
+        could land across a tile edge are laid out first, then each tile's interior is done
+        on its own thread, ordered by importance within the tile.  Not used with a display
+        object limit, debug output or while incremental mode is reusing placements.
+        0, the default, does it all on the calling thread.
+      */
+    void setLayoutThreads(int numThreads);
+    int getLayoutThreads();
+
+    /** When a pass only turns objects on and off, change the vertex colors in the drawables
+        we've got rather than building new ones.  Hidden objects stay in the drawables until there
+        are too many of them, and anything that moves or isn't there yet means a rebuild.
+        Fades, clustering and incremental mode need new drawables, so they turn this off.
+        Off by default.
+      */
+    void setToggleInPlace(bool enable);
+    bool getToggleInPlace() const { return toggleInPlace; }
+
+    /** Draw plain rectangular objects as instances of one shared quad rather than four vertices
+        apiece.  Objects with masks, expressions, extra vertex attributes or animated textures
+        are still built the regular way.  With toggling in place, instanced objects can also be
+        moved to a new offset without a rebuild.
+        Off by default.
+      */
+    void setInstancing(bool enable);
+    bool getInstancing() const { return instancing; }
+
+    /** Cluster from a hierarchy worked out ahead of time rather than from scratch on every pass.
+        Each cluster group is clustered at every zoom level when its objects change, and a layout
+        pass just looks up the clusters on screen for the current zoom.  Clusters are formed in
+        map space, so they don't account for rotation or tilt the way the screen space version does.
+        Off by default.
+      */
+    void setClusterHierarchy(bool enable) { clusterHierarchy = enable; }
+    bool getClusterHierarchy() const { return clusterHierarchy; }
+
     virtual void setRenderer(SceneRenderer *inRenderer) override;
 
     virtual void setScene(Scene *inScene) override;
@@ -319,6 +394,11 @@ protected:
                              const ViewStateRef &viewState,
                              const Mbr &screenMbr,
                              const Point2f &frameBufferSize);
+    static bool calcScreenPt(Point2f &objPt,
+                             const Point3d &worldLoc,
+                             const ViewStateRef &viewState,
+                             const Mbr &screenMbr,
+                             const Point2f &frameBufferSize);
     static Eigen::Matrix2d calcScreenRot(float &screenRot,
                                          const ViewStateRef &viewState,
                                          const WhirlyGlobe::GlobeViewState *globeViewState,
@@ -334,10 +414,35 @@ protected:
                         const std::unordered_set<std::string> &localOverrideUUIDs,
                         std::vector<ClusterEntry> &clusterEntries,
                         std::vector<ClusterGenerator::ClusterClassParams> &outClusterParams,
+                        WorkerPool *workers,
                         ChangeSet &changes);
 
     struct LayoutObjectContainer;
     typedef std::vector<LayoutObjectContainer> LayoutContainerVec;
+    typedef std::unordered_multimap<std::string,LayoutObjectEntryRef> MergeMap;
+
+    // Lay out the sorted containers by screen tile on the workers.
+    // Returns false if this pass can't be done that way.
+    bool runLayoutParallel(WorkerPool &workers,
+                           const ViewStateRef &viewState,
+                           LayoutContainerVec &layoutObjs,
+                           OverlapHelper &overlapMan,
+                           WhirlyGlobe::GlobeViewState *globeViewState,
+                           const Point2f &frameBufferSize,
+                           const Mbr &screenMbr,
+                           const Eigen::Matrix4d &modelTrans,
+                           const Eigen::Matrix4d &normalMat,
+                           float resScale,
+                           ChangeSet &changes,
+                           bool &hadChanges);
+
+    // Keep objects with the same merge ID enabled or disabled together
+    static void syncMergedObject(const LayoutObjectEntryRef &layoutObj,bool &isActive,
+                                 MergeMap &mergeMap,bool &hadChanges);
+
+    // Note where an object landed for the next incremental pass, marking what changed
+    void recordPlacement(LayoutObjectEntry &layoutObj,bool isActive,bool evaluated,bool blocked,
+                         int pickedOrient,const Mbr &placedMbr,const Point2f &netPt,float resScale);
 
     struct ClusteredObjects
     {
@@ -377,6 +482,38 @@ protected:
                              const Eigen::Matrix4d &modelTrans,
                              const Eigen::Matrix4d &normalMat);
 
+    // Cluster one group from its precomputed hierarchy.
+    // Returns false if we can't work out the view, in which case it's up to the screen space version.
+    bool runHierarchyClustering(PlatformThreadInfo *threadInfo,
+                                const ClusteredObjects &cluster,
+                                const ClusterGenerator::ClusterClassParams &params,
+                                int paramsID,
+                                LayoutContainerVec &layoutObjs,
+                                std::vector<ClusterEntry> &clusterEntries,
+                                const ViewStateRef &viewState,
+                                Maply::MapViewState *mapViewState,
+                                WhirlyGlobe::GlobeViewState *globeViewState,
+                                const Point2f &frameBufferSize,
+                                const Mbr &screenMbr,
+                                const Eigen::Matrix4d &modelTrans);
+
+    // Set up the cluster entry for a group of objects, located at the given display point if valid
+    void addClusterEntry(PlatformThreadInfo *threadInfo,
+                         int clusterID,
+                         const ClusterGenerator::ClusterClassParams &params,
+                         int paramsID,
+                         const std::vector<LayoutObjectEntryRef> &objsForCluster,
+                         const Point3d &dispPt,
+                         bool dispPtValid,
+                         std::vector<ClusterEntry> &clusterEntries);
+
+    // Try the last along-shape placement again, if the view hasn't changed too much
+    bool reuseShapeLayout(LayoutObjectEntry &layoutObj,
+                          const ViewStateRef &viewState,
+                          const Point2f &frameBufferSize,
+                          OverlapHelper &overlapMan,
+                          bool &hadChanges);
+
     void layoutAlongShape(const LayoutObjectEntryRef &layoutObj,
                           const ViewStateRef &viewState,
                           const Point2f &frameBufferSize,
@@ -396,11 +533,26 @@ protected:
                         UnorderedIDSetbyUID *newUniqueDrawableMap,
                         const UnorderedIDSetbyUID *oldUniqueDrawableMap);
 
+    // Show and hide objects in the drawables we've got, if possible
+    bool toggleDrawables(const LayoutEntrySet &localLayoutObjects,ChangeSet &changes);
+
+    // Rebuild only the drawable groups with changes, for incremental mode
+    void buildDrawablesIncremental(TimeInterval curTime,
+                                   TimeInterval &maxAnimTime,
+                                   const LayoutEntrySet &localLayoutObjects,
+                                   const std::vector<int> &removedBuckets,
+                                   const std::vector<ClusterEntry> &oldClusters,
+                                   const std::vector<ClusterGenerator::ClusterClassParams> &oldClusterParams,
+                                   std::vector<BasicDrawableRef> &newDraws,
+                                   std::vector<BasicDrawableInstanceRef> &newInstDraws,
+                                   ChangeSet &changes);
+
     void handleFadeOut(const TimeInterval curTime,
                        TimeInterval &maxAnimTime,
                        const LayoutEntrySet &localLayoutObjects,
                        const SimpleIDSet &oldDrawIDs,
                        const std::vector<BasicDrawableRef> &newDrawables,
+                       const std::vector<BasicDrawableInstanceRef> &newInstDrawables,
                        const std::vector<ClusterEntry> &oldClusters,
                        const std::vector<ClusterGenerator::ClusterClassParams> &oldClusterParams,
                        const UnorderedIDSetbyUID &oldUniqueDrawableMap,
@@ -458,6 +610,43 @@ protected:
     
     // Mapping of object unique IDs to drawables from the previous run
     UnorderedIDSetbyUID uniqueDrawableIDs;
+
+    /// Incremental mode settings
+    bool incremental = false;
+    float incrThreshold = 2.0f;
+    /// Passes since everything was evaluated and the screen size at the time
+    int incrPasses = 0;
+    Point2f incrFrameSize {0,0};
+    /// Overall view shift from one evaluation to the next
+    Point2f incrShift {0,0};
+    /// Screen areas (net of the shift) where placements changed in this pass
+    std::vector<Mbr> incrDirty;
+    /// Drawables and unique ID mappings for each group of objects
+    std::vector<SimpleIDSet> bucketDrawIDs;
+    std::vector<UnorderedIDSetbyUID> bucketUniqueIDs;
+
+    /// Threads for parallel layout, if any
+    WorkerPoolRef layoutWorkers;
+
+    /// Objects can be turned on and off in place
+    bool toggleInPlace = false;
+    /// Rectangles are drawn as instances
+    bool instancing = false;
+    /// Set if the vertex ranges match the drawables we've got
+    bool drawRangesValid = false;
+
+    /// Precomputed clustering for one cluster group, and the objects it was built from
+    struct ClusterTree
+    {
+        ClusterTree(int maxZoom,double radius) : hierarchy(0,maxZoom,radius) { }
+
+        ClusterHierarchy hierarchy;
+        std::vector<LayoutObjectEntryRef> objs;
+        size_t signature = 0;
+    };
+    bool clusterHierarchy = false;
+    /// Cluster trees by cluster group, only touched on the layout thread
+    std::unordered_map<int,std::unique_ptr<ClusterTree>> clusterTrees;
 };
 typedef std::shared_ptr<LayoutManager> LayoutManagerRef;
 
@@ -67,14 +67,31 @@ public:
     // Sort the runs by length, toss the ones below the minimum length
     void sortRuns(double minLen);
 
+    /// Working space for process(), which can go from one builder to the next
+    struct Scratch
+    {
+        std::vector<bool> isValid;
+        std::vector<bool> isFrontSide;
+        std::vector<Point2f> projPts;
+    };
+
     // Run our crazy stuff
     void process();
+
+    /// Run our crazy stuff in working space kept by the caller
+    void process(Scratch &scratch);
     
     // Return the individual runs to follow
     std::vector<VectorRing> getScreenVecs() const;
 
     const std::vector<VectorRing> &getScreenVecsRef() const;
 
+    /// Hand over the runs, leaving us with none
+    std::vector<VectorRing> takeScreenVecs() { return std::move(runs); }
+
+    /// Use runs from an earlier builder for the same view instead of calling process()
+    void setScreenVecs(std::vector<VectorRing> &&inRuns) { runs = std::move(inRuns); }
+
     // Visual vectors for debugging
     ShapeSet getVisualVecs() const;
 
@@ -24,6 +24,7 @@
 #import "GlobeMath.h"
 #import "QuadTreeNew.h"
 #import "SceneRenderer.h"
+#import "TileMemoryManager.h"
 
 namespace WhirlyKit
 {
@@ -58,11 +59,15 @@ public:
     bool lineMode;
     // If set, we'll include the elevation data
     bool includeElev;
+    // If set, the shader raises tiles from an elevation texture, so flat maps get skirts too
+    bool elevTextures;
     // If set, we'll enable/disable geometry associated with tiles.
     // Otherwise we'll just always leave it off, assuming someone else is instancing it
     bool enableGeom;
     // If set, we're building single level geometry, so no parent logic
     bool singleLevel;
+    // If set, flat map tiles are built from a shared unit grid and placed with their matrix
+    bool meshTemplates;
 };
 
 class TileGeomManager;
@@ -81,10 +86,13 @@ public:
     void makeDrawables(SceneRenderer *sceneRender,TileGeomManager *geomManage,
                        const TileGeomSettings &geomSettings,ChangeSet &changes);
 
+    // True if we can build this tile from a template mesh
+    bool canUseTemplate(TileGeomManager *geomManage,const TileGeomSettings &geomSettings) const;
+
     // Utility routine to build skirts around the edges
     void buildSkirt(const BasicDrawableBuilderRef &draw,const Point3dVector &pts,
                     const std::vector<TexCoord> &texCoords,double skirtFactor,
-                    bool haveElev,const Point3d &theCenter);
+                    bool haveElev,const Point3d &theCenter,double flatDrop = 0.0);
 
     // Enable associated drawables
     void enable(const TileGeomSettings &geomSettings,ChangeSet &changes);
@@ -114,6 +122,12 @@ public:
     int64_t tileNumber;
     // The Draw Priority as set when created
     int drawPriority;
+    // Roughly what the geometry costs on the renderer side
+    size_t geomBytes;
+    // Set if the drawables are shared with other geometry managers (see TileGeomCache)
+    bool sharedGeom;
+    // How many of our children the geometry manager is holding
+    int numChildren;
 };
 typedef std::shared_ptr<LoadedTileNew> LoadedTileNewRef;
 typedef std::vector<LoadedTileNewRef> LoadedTileVec;
@@ -125,6 +139,7 @@ class TileGeomManager
 {
 public:
     TileGeomManager();
+    ~TileGeomManager();
     
     // Construct with the quad tree we're building off of, the coordinate system we're building from and the (valid) bounding box
     void setup(SceneRenderer *sceneRender,TileGeomSettings &geomSettings,QuadTreeNew *quadTree,
@@ -154,12 +169,21 @@ public:
     // Remove the tiles given, if they're being represented
     NodeChanges removeTiles(const QuadTreeNew::NodeSet &tiles,ChangeSet &changes);
     
-    // Turn tiles on/off based on their children
-    void updateParents(ChangeSet &changes,LoadedTileVec &enabledNodes,LoadedTileVec &disabledNodes);
+    // Turn the given tiles on/off based on their children
+    void updateParents(const LoadedTileVec &tiles,ChangeSet &changes,LoadedTileVec &enabledNodes,LoadedTileVec &disabledNodes);
     
     // Remove all the various geometry
     void cleanup(ChangeSet &changes);
 
+    // Drawable memory for the tiles we're representing
+    TileMemoryUsage getMemoryUsage() const;
+
+    // True if the other manager would build exactly the same tile geometry we do
+    bool sameGeometry(const TileGeomManager &that) const;
+
+    // Set if we can use tile geometry from the shared cache
+    bool canShareGeom() const;
+
 protected:
     TileGeomSettings settings;
     
@@ -182,11 +206,69 @@ public:
     // Build the skirts for edge matching
     bool buildSkirts;
 
+    // Share tile geometry with other managers building the same thing.  On by default.
+    // Only applies when the geometry is instanced rather than turned on directly.
+    bool shareGeom;
+
     // Bounding box of the whole area
     MbrD mbr;
     
 protected:
-    std::map<QuadTreeNew::Node,LoadedTileNewRef> tileMap;
+    // Parent of the given tile, if we have it
+    LoadedTileNewRef getParent(const QuadTreeNew::Node &ident);
+
+    FlatNodeMap<QuadTreeNew::Node,LoadedTileNewRef> tileMap;
+};
+
+/** Tile geometry shared between the geometry managers that would build the same thing.
+    Sampling controllers with different parameters, say tile limits or importance,
+    often produce identical grids for the same tiles.  The loaders on top of them
+    only instance that geometry, so one set of drawables per tile will do.
+    Tiles are reference counted and the last manager to let go removes the drawables.
+  */
+class TileGeomCache
+{
+public:
+    /// The one everyone shares
+    static TileGeomCache &getShared();
+
+    /// Fill in the tile from geometry a matching manager built.
+    /// We only hand out drawables that have already made it to the scene.
+    bool acquire(const TileGeomManager *geomManage,Scene *scene,LoadedTileNew &tile);
+
+    /// Offer up geometry we just built for the tile
+    void add(const TileGeomManager *geomManage,LoadedTileNew &tile);
+
+    /// Done with the tile.  Returns true if the caller should remove the drawables.
+    bool release(const TileGeomManager *geomManage,const QuadTreeNew::Node &ident);
+
+    /// Manager is going away
+    void removeManager(const TileGeomManager *geomManage);
+
+protected:
+    TileGeomCache() = default;
+
+    struct Entry
+    {
+        std::vector<LoadedTileNew::DrawableInfo> drawInfo;
+        size_t geomBytes = 0;
+        int drawPriority = 0;
+        int refs = 0;
+    };
+
+    // Managers that build the same geometry and the tiles between them
+    struct Group
+    {
+        std::vector<const TileGeomManager *> managers;
+        FlatNodeMap<QuadTreeNew::Node,Entry> tiles;
+    };
+    typedef std::shared_ptr<Group> GroupRef;
+
+    // Group for the manager, adding it to one if need be.  Lock must be held.
+    Group *findGroup(const TileGeomManager *geomManage);
+
+    std::mutex lock;
+    std::vector<GroupRef> groups;
 };
 
 }
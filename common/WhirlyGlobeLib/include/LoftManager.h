@@ -54,6 +54,10 @@ public:
     bool        hasCenter;
     Point2d     center;
     double      gridSize;
+    /// Raise the walls and roof in the vertex shader, if the renderer has one
+    bool        shaderExtrude;
+    /// Union the footprints first, dropping shared walls and joining roofs
+    bool        mergeRoofs;
 };
 typedef std::shared_ptr<LoftedPolyInfo> LoftedPolyInfoRef;
 
@@ -91,7 +95,7 @@ public:
     void removeLoftedPolys(const SimpleIDSet &polyIDs,ChangeSet &changes);
         
 protected:
-    void addGeometryToBuilder(LoftedPolySceneRep *sceneRep,const LoftedPolyInfo &polyInfo,GeoMbr &drawMbr,Point3d &center,bool centerValid,Point2d &geoCenter,ShapeSet &shapes, VectorTrianglesRef triMesh,std::vector<WhirlyKit::VectorRing> &outlines,ChangeSet &changes);
+    void addGeometryToBuilder(LoftedPolySceneRep *sceneRep,const LoftedPolyInfo &polyInfo,GeoMbr &drawMbr,Point3d &center,bool centerValid,Point2d &geoCenter,std::vector<WhirlyKit::VectorRing> &wallLoops, VectorTrianglesRef triMesh,std::vector<WhirlyKit::VectorRing> &outlines,ChangeSet &changes);
     
     LoftedPolySceneRepSet loftReps;
 };
@@ -21,6 +21,7 @@
 #import "Dictionary.h"
 #import "QuadTreeNew.h"
 #import <string>
+#import <set>
 
 namespace WhirlyKit
 {
@@ -32,6 +33,7 @@ typedef enum {MBFilterEqual,MBFilterNotEqual,MBFilterGreaterThan,MBFilterGreater
 typedef enum {MBGeomPoint,MBGeomLineString,MBGeomPolygon,MBGeomNone} MapboxVectorGeometryType;
 
 class MapboxVectorStyleSetImpl;
+class MutableDictionaryC;
 typedef std::shared_ptr<MapboxVectorStyleSetImpl> MapboxVectorStyleSetImplRef;
 
 class MapboxVectorFilter;
@@ -43,12 +45,16 @@ class MapboxVectorFilter
 public:
     MapboxVectorFilter();
     
-    /// @brief Parse the filter info out of the style entry
+    /// @brief Parse the filter info out of the style entry and compile it for testing
     bool parse(const std::vector<DictionaryEntryRef> &styleEntry,MapboxVectorStyleSetImpl *styleSet);
 
     /// @brief Test a feature's attributes against the filter
+    /// @details Uses the compiled version for the dictionaries the tile parser makes
     bool testFeature(Dictionary const& attrs,const QuadTreeIdentifier &tileID);
 
+    /// @brief Add the attribute names this filter (and its subfilters) test
+    void collectKeys(std::set<std::string> &keys) const;
+
     /// @brief The comparison type for this filter
     MapboxVectorFilterType filterType;
 
@@ -66,6 +72,47 @@ public:
 
     /// @brief For All and Any these are the MapboxVectorFilters to evaluate
     std::vector<MapboxVectorFilterRef> subFilters;
+
+protected:
+    // Operations in the compiled filter
+    typedef enum {OpFallback,OpAll,OpAny,OpGeom,OpHas,OpIn,OpCompare} FilterOpCode;
+
+    // A comparison value, converted ahead of time.  Type is string, int, or double.
+    struct FilterConst
+    {
+        DictionaryType type;
+        double numVal;
+        std::string strVal;
+    };
+
+    // One filter, flattened.  Its subfilters follow it, up to end.
+    struct FilterOp
+    {
+        FilterOpCode code;
+        MapboxVectorFilterType filterType;
+        unsigned int end;
+        // Range in the constant pool
+        unsigned int constStart,constEnd;
+        // Set for in/!in if we have to compare against strings or numbers
+        bool strConsts,numConsts;
+        // The filter this came from, for the cases we don't handle
+        const MapboxVectorFilter *filter;
+    };
+
+    bool parseFilter(const std::vector<DictionaryEntryRef> &styleEntry,MapboxVectorStyleSetImpl *styleSet);
+
+    // Flatten this filter and its subfilters onto the end of the program
+    void compile(std::vector<FilterOp> &ops,std::vector<FilterConst> &consts) const;
+    static bool makeConst(const DictionaryEntryRef &val,FilterConst &filterConst);
+
+    // Run the compiled op at the given position
+    bool runOp(const MutableDictionaryC &attrs,const QuadTreeIdentifier &tileID,unsigned int pc) const;
+
+    // Test against the parsed filter, walking the subfilters
+    bool testFilter(Dictionary const& attrs,const QuadTreeIdentifier &tileID) const;
+
+    std::vector<FilterOp> program;
+    std::vector<FilterConst> programConsts;
 };
 
 }
@@ -59,7 +59,11 @@ public:
     
     virtual void cleanup(PlatformThreadInfo *inst,ChangeSet &changes) override { }
 
+    /// Fill and outline colors and opacity can change in place, unless they're zoom dependent
+    virtual bool updatePaint(PlatformThreadInfo *inst,const DictionaryRef &paintEntry,ChangeSet &changes) override;
+
     virtual RGBAColor getLegendColor(float zoom) const override {
+        std::lock_guard<std::mutex> guardLock(paintTracker.lock);
         return paint.color ? paint.color->colorForZoom(zoom) : RGBAColor::clear();
     }
 
@@ -67,6 +71,13 @@ protected:
     // N.B.: does not copy base members
     MapboxVectorLayerFill& operator=(const MapboxVectorLayerFill &) = default;
 
+    // Set up the filled or outline vectors for a given tile.  Returns false if there's nothing to draw.
+    bool setupFillInfo(const MapboxVectorFillPaint &fillPaint,const QuadTreeIdentifier &ident,VectorInfo &vecInfo) const;
+    bool setupOutlineInfo(const MapboxVectorFillPaint &fillPaint,const QuadTreeIdentifier &ident,VectorInfo &vecInfo) const;
+
+    // What we've built, for paint changes
+    MapboxVectorPaintTracker paintTracker;
+
 public:
     MapboxVectorFillPaint paint;
     SimpleIdentity arealShaderID;
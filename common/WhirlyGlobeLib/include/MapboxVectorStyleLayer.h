@@ -19,6 +19,9 @@
 #import "MapboxVectorFilter.h"
 #import "VectorObject.h"
 #import "MaplyVectorStyleC.h"
+#import "QuadTreeNew.h"
+#import "ComponentManager.h"
+#import <mutex>
 
 namespace WhirlyKit
 {
@@ -26,6 +29,41 @@ namespace WhirlyKit
 class MapboxVectorStyleLayer;
 typedef std::shared_ptr<MapboxVectorStyleLayer> MapboxVectorStyleLayerRef;
 
+/** Keeps track of what a layer has built, tile by tile, so paint changes can go
+    straight to the existing drawables rather than rebuilding the tiles.
+    Entries go away with their component objects.
+    The lock also covers the layer's paint values while they're changed.
+    Copies start out empty, so layers can still be copied around.
+  */
+class MapboxVectorPaintTracker
+{
+public:
+    MapboxVectorPaintTracker() = default;
+    MapboxVectorPaintTracker(const MapboxVectorPaintTracker &) { }
+    MapboxVectorPaintTracker &operator=(const MapboxVectorPaintTracker &) { return *this; }
+
+    /// Note something built for a tile.  Which is up to the layer, e.g. fill vs. outline.
+    void add(const ComponentObjectRef &compObj,const QuadTreeIdentifier &ident,int which,SimpleIdentity id);
+
+    /// Run over what's still around, dropping anything that isn't
+    void forEach(const std::function<void(const QuadTreeIdentifier &ident,int which,SimpleIdentity id)> &fn);
+
+    mutable std::mutex lock;
+
+protected:
+    struct Entry
+    {
+        std::weak_ptr<ComponentObject> compObj;
+        QuadTreeIdentifier ident;
+        int which;
+        SimpleIdentity id;
+    };
+
+    std::mutex entryLock;
+    std::vector<Entry> entries;
+    size_t pruneSize = 256;
+};
+
 /** @brief Layer definition from the Style Sheet.
     @details This is a single layer from the Mapbox style sheet.  It's also used to build visible objects.
   */
@@ -77,6 +115,16 @@ public:
     /// Clean up any objects (textures, probably)
     virtual void cleanup(PlatformThreadInfo *inst,ChangeSet &changes) { }
 
+    /** Take new paint values and apply them to the objects already built, where we can.
+        Returns false if the layer can't do that for these values, in which case nothing
+        changes and the caller will have to rebuild the tiles with a new style instead.
+      */
+    virtual bool updatePaint(PlatformThreadInfo *inst,const DictionaryRef &paintEntry,ChangeSet &changes) { return false; }
+
+    /// Add the feature attributes this layer filters on or uses to build objects.
+    /// Returns false if it might need any of them, e.g. when the features are selectable.
+    virtual bool attributeKeys(std::set<std::string> &keys) const;
+
 protected:
     MapboxVectorStyleLayer& operator=(const MapboxVectorStyleLayer&) = default;
 
@@ -82,7 +82,11 @@ public:
     
     virtual void cleanup(PlatformThreadInfo *inst,ChangeSet &changes) override { }
 
+    /// Color, opacity and width can change in place, unless they're zoom dependent
+    virtual bool updatePaint(PlatformThreadInfo *inst,const DictionaryRef &paintEntry,ChangeSet &changes) override;
+
     virtual RGBAColor getLegendColor(float zoom) const override {
+        std::lock_guard<std::mutex> guardLock(paintTracker.lock);
         return paint.color ? paint.color->colorForZoom(zoom) : RGBAColor::clear();
     }
 
@@ -90,6 +94,12 @@ protected:
     // N.B.: This does not copy the base members
     MapboxVectorLayerLine& operator=(const MapboxVectorLayerLine&) = default;
 
+    // Set up the wide vectors for a given tile.  Returns false if there's nothing to draw.
+    bool setupInfo(const MapboxVectorLinePaint &linePaint,const QuadTreeIdentifier &ident,WideVectorInfo &vecInfo) const;
+
+    // What we've built, for paint changes
+    MapboxVectorPaintTracker paintTracker;
+
 public:
     MapboxVectorLineLayout layout;
     MapboxVectorLinePaint paint;
@@ -24,7 +24,9 @@
 #import "MapboxVectorTileParser.h"
 #import "MaplyVectorStyleC.h"
 #import "MapboxVectorStyleSpritesImpl.h"
+#import "DictionaryC.h"
 #import <set>
+#import <atomic>
 
 namespace WhirlyKit
 {
@@ -75,6 +77,9 @@ public:
     // Build a string for debug output
     std::string buildDesc(const DictionaryRef &attrs) const;
 
+    // Add the attribute names this field might use
+    void collectKeys(std::set<std::string> &keys) const;
+
     std::vector<MapboxTextChunk> chunks;
     bool valid;
 };
@@ -119,6 +124,9 @@ public:
     /// @brief Returns the maximum value
     double maxValue();
 
+    /// True if the stops give the same numbers or colors as the other ones
+    bool sameValues(const MaplyVectorFunctionStops &that) const;
+
 public:
     std::vector<MaplyVectorFunctionStop> stops;
     
@@ -139,7 +147,7 @@ public:
     double valForZoom(double zoom);
     
     // True if this is an expression, rather than a constant
-    bool isExpression();
+    bool isExpression() const;
 
     // Build the expression, if this has stops
     FloatExpressionInfoRef expression();
@@ -149,6 +157,9 @@ public:
 
     // Maximum possible value
     double maxVal();
+
+    // True if this works out the same as the other one at every level
+    bool sameValues(const MapboxTransDouble &that) const;
     
 protected:
     double val;
@@ -166,7 +177,7 @@ public:
     
     // If set, we're using the alpha to indicate some other value, so just pass it through
     void setAlphaOverride(double alpha);
-    bool hasAlphaOverride() { return useAlphaOverride; }
+    bool hasAlphaOverride() const { return useAlphaOverride; }
 
     // Return a color for the given zoom level
     RGBAColor colorForZoom(double zoom);
@@ -176,6 +187,9 @@ public:
 
     // Build the expression, if this has stops
     ColorExpressionInfoRef expression();
+
+    // True if this works out the same as the other one at every level
+    bool sameValues(const MapboxTransColor &that) const;
     
 protected:
     RGBAColorRef color;
@@ -185,6 +199,18 @@ protected:
 };
 typedef std::shared_ptr<MapboxTransColor> MapboxTransColorRef;
 
+/// True if a paint value can go from one to the other without rebuilding.
+/// Constants can change freely, values that depend on zoom are baked into the shaders.
+template <typename T>
+bool MapboxPaintChangeable(const std::shared_ptr<T> &oldVal,const std::shared_ptr<T> &newVal)
+{
+    if (!oldVal || !newVal)
+    {
+        return !oldVal && !newVal;
+    }
+    return oldVal->sameValues(*newVal) || (!oldVal->isExpression() && !newVal->isExpression());
+}
+
 // Transitional text
 // Picks a text value at a particular level
 class MapboxTransText
@@ -195,6 +221,9 @@ public:
     
     // Return text for the given zoom level
     MapboxRegexField textForZoom(double zoom);
+
+    // Add the attribute names the text might use at any zoom level
+    void collectKeys(std::set<std::string> &keys) const;
     
 protected:
     MapboxRegexField textField;
@@ -221,6 +250,19 @@ public:
     // Parse the entire style sheet.  False on failure
     virtual bool parse(PlatformThreadInfo *inst,const DictionaryRef &dict);
 
+    /** Write the parsed style sheet in the compact binary form, to be cached on disk.
+        The key identifies the source, such as a hash of the style JSON, and must match on the way back in.
+        Returns false if the dictionary isn't one we can write.
+      */
+    static bool compileStyle(const DictionaryRef &styleDict,uint64_t sourceKey,MutableRawData &outData);
+
+    /// Read the style dictionary written by compileStyle.
+    /// Returns null if the data is damaged, from a different version, or for a different source.
+    static MutableDictionaryCRef readCompiledStyle(const RawData &data,uint64_t sourceKey);
+
+    /// Parse from a compiled style, often memory mapped (see RawDataFromMappedFile).  False on failure.
+    bool parseCompiled(PlatformThreadInfo *inst,const RawData &data,uint64_t sourceKey);
+
     /// @brief Default settings and scale factor for Mapnik vector geometry.
     VectorStyleSettingsImplRef tileStyleSettings;
 
@@ -274,6 +316,10 @@ public:
     static RGBAColorRef resolveColor(const MapboxTransColorRef &color,const MapboxTransDoubleRef &opacity,
                                      double zoom,MBResolveColorType resolveMode);
 
+    /// Opacity for the shaders to evaluate against the zoom, if any.
+    /// A zoom dependent color replaces the alpha we resolve up front, so a constant opacity comes along too.
+    static FloatExpressionInfoRef opacityExpression(const MapboxTransColorRef &color,const MapboxTransDoubleRef &opacity);
+
     /// @brief Scale the color by the given opacity
     static RGBAColor color(RGBAColor color,double opacity);
 
@@ -289,6 +335,18 @@ public:
     /// Set the zoom slot if we've got continuous zoom going on
     virtual void setZoomSlot(int slot) override { zoomSlot = slot; }
 
+    /// Bumped when layers are added or shown/hidden, but not for paint changes
+    virtual int getStyleGeneration() const override { return styleGeneration; }
+
+    /// Show or hide the layers with the given ID
+    void setLayerVisible(const std::string &ident,bool visible);
+
+    /** Change the paint values for the layers with the given ID, pushing them to what's already on screen.
+        Returns false if any of those layers can't take the new values that way,
+        in which case the tiles need to be reloaded with an updated style.
+      */
+    bool updateLayerPaint(PlatformThreadInfo *inst,const std::string &ident,const DictionaryRef &paintEntry);
+
     /// Get the background style, if any
     VectorStyleImplRef backgroundStyle(PlatformThreadInfo *inst) const override;
 
@@ -308,6 +366,12 @@ public:
                                     const std::string &name,
                                     const QuadTreeNew::Node &tileID) override;
 
+    /// Attribute keys the filters and layers for a source layer read.
+    /// Worked out once per source layer.
+    virtual bool attributeKeysForLayer(PlatformThreadInfo *inst,
+                                       const std::string &layerName,
+                                       std::set<std::string> &keys) override;
+
     /// Return the style associated with the given UUID.
     virtual VectorStyleImplRef styleForUUID(PlatformThreadInfo *inst,long long uuid) override;
 
@@ -345,6 +409,24 @@ public:
     /// Add a sprite sheet for use by the layers
     virtual void addSprites(MapboxVectorStyleSpritesRef newSprites);
 
+    /// Called as each symbol layer is warmed up
+    typedef std::function<void(int done,int total)> WarmUpProgressFunc;
+
+    /** Render the glyphs labels are likely to need before any tiles come in,
+        rather than stalling the first tiles with labels.
+        Covers the font, size and halo of each symbol layer as they'd be at the given zoom level.
+        Call this after the sprites are added, but before loading starts.
+        The glyphs stay in the font atlas until releaseWarmUp.
+      */
+    void warmUpGlyphs(PlatformThreadInfo *inst,int zoomLevel,const std::string &chars,
+                      const WarmUpProgressFunc &progress = WarmUpProgressFunc());
+
+    /// Printable ASCII and Latin-1, which covers most labels in Western styles
+    static const std::string &defaultWarmUpChars();
+
+    /// Let go of the glyphs from warmUpGlyphs
+    void releaseWarmUp(PlatformThreadInfo *inst,ChangeSet &changes);
+
     /// Create a local platform component object
     virtual ComponentObjectRef makeComponentObject(PlatformThreadInfo *inst, const Dictionary *desc = nullptr) = 0;
 
@@ -361,6 +443,24 @@ public:
 protected:
     void addLayer(PlatformThreadInfo *, MapboxVectorStyleLayerRef);
 
+    // Strings holding the warmed up glyphs
+    std::mutex warmUpLock;
+    std::vector<SimpleIdentity> warmUpStrIDs;
+
+    // Attribute keys by source layer, null if they need everything
+    typedef std::shared_ptr<const std::set<std::string>> KeySetRef;
+    std::mutex attrKeysLock;
+    std::unordered_map<std::string,KeySetRef> attrKeysBySource;
+
+    // Layers for each source layer that could show up in a tile of a given level.
+    // The last level covers everything deeper.
+    static constexpr int MaxLayerLevel = 30;
+    typedef std::vector<std::vector<MapboxVectorStyleLayerRef>> LayersByLevel;
+    std::unordered_map<std::string,LayersByLevel> layersBySourceLevel;
+
+    // Candidate layers for the given source layer and tile level, null if there are none
+    const std::vector<MapboxVectorStyleLayerRef> *layersForTile(const std::string &layerName,int level) const;
+
 public:
     Scene *scene;
     CoordSystem *coordSys;
@@ -391,13 +491,14 @@ public:
     ComponentManagerRef compManage;
     
     // ID's for the various programs
-    SimpleIdentity screenMarkerProgramID;
-    SimpleIdentity vectorArealProgramID;
-    SimpleIdentity vectorLinearProgramID;
-    SimpleIdentity wideVectorProgramID;
-    SimpleIdentity wideVectorPerfProgramID;
+    SimpleIdentity screenMarkerProgramID = EmptyIdentity;
+    SimpleIdentity vectorArealProgramID = EmptyIdentity;
+    SimpleIdentity vectorLinearProgramID = EmptyIdentity;
+    SimpleIdentity wideVectorProgramID = EmptyIdentity;
+    SimpleIdentity wideVectorPerfProgramID = EmptyIdentity;
 
     int zoomSlot;
+    std::atomic<int> styleGeneration { 0 };
     long long currentID;
 };
 typedef std::shared_ptr<MapboxVectorStyleSetImpl> MapboxVectorStyleSetImplRef;
@@ -116,6 +116,9 @@ public:
     virtual MapboxVectorStyleLayerRef clone() const override;
     virtual MapboxVectorStyleLayer& copy(const MapboxVectorStyleLayer&) override;
 
+    /// Text and icon fields pull from the attributes too
+    virtual bool attributeKeys(std::set<std::string> &keys) const override;
+
     virtual void cleanup(PlatformThreadInfo *inst,ChangeSet &changes) override { }
 
     virtual std::string getLegendText(float zoom) const override {
@@ -146,7 +149,21 @@ public:
                         const MutableDictionaryRef &attrs,
                         const VectorTileDataRef &tileInfo);
 
+    /// Render the glyphs for the given characters into the font atlas, as this layer would at the given zoom.
+    /// The glyphs are held by the strings whose IDs we return, until they're removed.
+    void warmUpGlyphs(PlatformThreadInfo *,
+                      int zoomLevel,
+                      const std::string &chars,
+                      std::vector<SimpleIdentity> &strIDs,
+                      ChangeSet &changes);
+
 protected:
+    // Size to render the text at, which is different when merged with an icon
+    float calcTextSize(int zoomLevel, bool merged) const;
+    // Font, color and halo, which together decide which glyphs get rendered
+    LabelInfoRef setupLabelInfo(PlatformThreadInfo *, int zoomLevel, float textSize,
+                                bool merged, const RGBAColorRef &textColor);
+
     // N.B.: This does not copy the base members
     MapboxVectorLayerSymbol& operator=(const MapboxVectorLayerSymbol&) = default;
 
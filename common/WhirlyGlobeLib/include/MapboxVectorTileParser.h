@@ -21,6 +21,10 @@
 #import "QuadTreeNew.h"
 #import "ImageTile.h"
 #import "ComponentManager.h"
+#import "WorkerPool.h"
+#import <list>
+#import <mutex>
+#import <unordered_map>
 
 namespace WhirlyKit
 {
@@ -96,6 +100,64 @@ typedef std::shared_ptr<VectorTileData> VectorTileDataRef;
 class VectorStyleDelegateImpl;
 typedef std::shared_ptr<VectorStyleDelegateImpl> VectorStyleDelegateImplRef;
 
+/** Decoded features for recently parsed tiles, sorted by style.
+    A reload, or a restyle that keeps the same style generation, can
+    skip the decode and go straight to building.  Entries are checked
+    against a hash of the raw data, so new data for a tile is a miss.
+    The least recently used tiles go once we're over the byte limit.
+    Features are held compacted and decoded into new objects on the way out.
+  */
+class VectorTileCache : public MemoryConsumer
+{
+public:
+    VectorTileCache(size_t maxBytes);
+
+    /// Fill in the features for the tile if we have them
+    bool fetch(const QuadTreeIdentifier &ident,int styleGeneration,const RawData *rawData,
+               std::map<SimpleIdentity,std::vector<VectorObjectRef> *> &vecObjsByStyle);
+
+    /// Keep the decoded features for a tile
+    void store(const QuadTreeIdentifier &ident,int styleGeneration,const RawData *rawData,
+               const std::map<SimpleIdentity,std::vector<VectorObjectRef> *> &vecObjsByStyle);
+
+    size_t getMaxBytes() const { return maxBytes; }
+    size_t getBytes() const;
+
+    /// Toss everything
+    void clear();
+
+    /// Counted as parsed tiles
+    virtual void addMemoryUsage(MemoryUsage &usage) override;
+
+    /// It's all cache, so it goes at the first step
+    virtual void trimMemory(PlatformThreadInfo *inst,MemoryTrimLevel step,ChangeSet &changes) override;
+
+protected:
+    struct Entry
+    {
+        int64_t tileNumber;
+        int styleGeneration;
+        uint64_t dataHash;
+        size_t bytes;
+        // Each feature once, even if several styles want it
+        std::vector<CompactShapeSet> vecObjs;
+        std::vector<bool> selectable;
+        std::map<SimpleIdentity,std::vector<uint32_t>> vecObjsByStyle;
+    };
+    typedef std::list<Entry> EntryList;
+
+    static uint64_t hashData(const RawData *rawData);
+    static size_t estimateBytes(const CompactShapeSet &shapes);
+
+    mutable std::mutex lock;
+    size_t maxBytes;
+    size_t bytes = 0;
+    // Most recently used at the front
+    EntryList entries;
+    std::unordered_map<int64_t,EntryList::iterator> entriesByTile;
+};
+typedef std::shared_ptr<VectorTileCache> VectorTileCacheRef;
+
 /** This object parses the data in Mapbox Vector Tile format.
   */
 class MapboxVectorTileParser
@@ -152,6 +214,37 @@ public:
     /// If set, we'll put an outline around the tile
     void setDebugOutline(bool b = true) { debugOutline = b; }
 
+    /** Build the styles for a tile on this many extra threads.
+        The results are merged in the same order as the serial version.
+        Styles get the calling thread's PlatformThreadInfo, so only turn this
+        on where that can be shared and the styles are safe to run together.
+        0, the default, builds everything on the calling thread.
+      */
+    void setBuildThreads(int numThreads);
+    int getBuildThreads() const { return buildWorkers ? buildWorkers->getNumThreads() : 0; }
+
+    /** Keep up to this many bytes of decoded tiles around.
+        Only works with style delegates that report a style generation,
+        and not when keeping vectors or parsing everything.  0, the default, turns it off.
+      */
+    void setTileCacheSize(size_t maxBytes);
+    size_t getTileCacheSize() const { return tileCache ? tileCache->getMaxBytes() : 0; }
+    const VectorTileCacheRef &getTileCache() const { return tileCache; }
+
+    /** Tiles below this level are overzoomed, they're handed the data for their ancestor at this level.
+        Rather than build all of that for each one, we clip the features to the tile
+        and skip vertices too close together to see.  -1, the default, turns it off.
+      */
+    void setSourceMaxZoom(int level) { sourceMaxZoom = level; }
+    int getSourceMaxZoom() const { return sourceMaxZoom; }
+
+    /** Merge the small drawables a tile builds that draw the same way (program, textures,
+        priority, uniforms and so on) into fewer, bigger ones.  Enabling and removing the
+        originals still works, other changes to them don't.  On by default.
+      */
+    void setMergeDrawables(bool merge) { mergeDrawables = merge; }
+    bool getMergeDrawables() const { return mergeDrawables; }
+
     const VectorStyleDelegateImplRef &getStyleDelegate() const { return styleDelegate; }
 protected:
     /// If set, we'll parse into local coordinates as specified by the bounding box, rather than geo coords
@@ -169,14 +262,30 @@ protected:
     /// If set, we'll put an outline around the tile
     bool debugOutline = false;
 
+    /// Deepest level the source has data for, -1 if we don't know
+    int sourceMaxZoom = -1;
+
+    /// Combine compatible drawables once the tile's built
+    bool mergeDrawables = true;
+
     std::string uuidName;
 
     // Used for feature inclusion.  Only keep the features that have this attribute and one of the values.
     std::string filterName;
     std::set<std::string> filterValues;
 
+    // Run the styles one after another
+    bool buildStyles(PlatformThreadInfo *styleInst,VectorTileData *tileData,const CancelFunction &cancelFn);
+    // Run the styles on the workers, then merge
+    bool buildStylesParallel(PlatformThreadInfo *styleInst,VectorTileData *tileData,const CancelFunction &cancelFn);
+    // Merge what a style built into the tile, sorting into categories as needed
+    void mergeStyleData(long long styleID,VectorTileData *tileData,VectorTileData *styleData);
+
     VectorStyleDelegateImplRef styleDelegate;
     std::map<long long,std::string> styleCategories;
+
+    std::unique_ptr<WorkerPool> buildWorkers;
+    VectorTileCacheRef tileCache;
 };
 
 typedef std::shared_ptr<MapboxVectorTileParser> MapboxVectorTileParserRef;
@@ -43,6 +43,9 @@ public:
 
     virtual bool isUserMotion() const { return userMotion; }
 
+    /// Where the map will be in a bit, if it stays in bounds
+    virtual bool predictView(WhirlyKit::View *,WhirlyKit::TimeInterval ahead) override;
+
 protected:
     bool withinBounds(const WhirlyKit::Point3d &loc,
                       MapView * testMapView,
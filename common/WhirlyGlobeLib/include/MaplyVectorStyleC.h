@@ -19,6 +19,7 @@
 #import "VectorObject.h"
 #import "MapboxVectorTileParser.h"
 #import <string>
+#import <set>
 
 namespace WhirlyKit
 {
@@ -89,8 +90,8 @@ struct VectorStyleSettingsImpl
     /// Use widened vectors (which do anti-aliasing and such)
     bool useWideVectors = false;
 
-    /// Use GPU-based wide vector implementation (iOS/Metal only)
-    bool perfWideVec = false;
+    /// Use GPU-based wide vector implementation where the renderer has it (iOS/Metal only)
+    bool perfWideVec = true;
 
     /// If set, we'll make all the features selectable.  If not, we won't.
     bool selectable = false;
@@ -138,6 +139,13 @@ public:
                                     const std::string &name,
                                     const QuadTreeNew::Node &tileID) = 0;
 
+    /// Fill in the attribute keys the styles for a layer will ever look at.
+    /// Parsers can leave the other attributes off the features.
+    /// Return false if any of them might be needed, which is the default.
+    virtual bool attributeKeysForLayer(PlatformThreadInfo *inst,
+                                       const std::string &layerName,
+                                       std::set<std::string> &keys) { return false; }
+
     /// Return the style associated with the given UUID.
     virtual VectorStyleImplRef styleForUUID(PlatformThreadInfo *inst,long long uuid) = 0;
 
@@ -155,6 +163,10 @@ public:
 
     /// Capture the zoom slot if you're going use it
     virtual void setZoomSlot(int zoomSlot) { }
+
+    /// Changes whenever the styles might sort or keep different features.
+    /// Decoded tiles can be reused while it stays the same.  -1, the default, means never reuse them.
+    virtual int getStyleGeneration() const { return -1; }
 };
 typedef std::shared_ptr<VectorStyleDelegateImpl> VectorStyleDelegateImplRef;
 
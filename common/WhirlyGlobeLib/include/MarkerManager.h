@@ -58,6 +58,18 @@ public:
     SimpleIDSet screenShapeIDs;  // IDs for screen space objects
     bool useLayout;  // True if we used the layout manager (and thus need to delete)
     float fadeOut;   // Time to fade away for deletion
+
+    // Where a fleet marker was last put, where it's headed and the vertices (or instances) that draw it
+    struct FleetMarker
+    {
+        SimpleIdentity selectID;
+        Point3d loc;
+        TimeInterval locTime;
+        Point3d dir;
+        std::vector<ScreenSpaceBuilder::VertexRange> ranges;
+    };
+    // In the order the markers were added, if this is a fleet
+    std::vector<FleetMarker> fleet;
 };
 typedef std::set<MarkerSceneRep *,IdentifiableSorter> MarkerSceneRepSet;
 
@@ -80,6 +92,14 @@ struct MarkerInfo : public BaseInfo
     float layoutSpacing = 20.0f;
     int layoutRepeat = 0;
     bool layoutDebug = false;
+    /// Screen markers that will be moved around a lot.  They're kept in place in their
+    ///  drawables so moving them is a buffer write, and they skip the layout engine.
+    bool fleet = false;
+    /// Plain screen markers are drawn as instances of one shared quad.
+    ///  Fleets move by rewriting the instances rather than the vertices.
+    bool instanced = false;
+    /// Markers take their height from the elevation manager, on the globe
+    bool clampToGround = false;
 
     FloatExpressionInfoRef opacityExp;
     ColorExpressionInfoRef colorExp;
@@ -185,6 +205,13 @@ public:
     
     /// Enable/disable markers
     void enableMarkers(SimpleIDSet &markerIDs,bool enable,ChangeSet &changes);
+
+    /** Move a fleet of screen markers to new locations over the given time, one per marker
+        in the order they were added.  They keep going at that speed until told otherwise.
+        A duration of zero puts them straight there.
+      */
+    void moveMarkers(SimpleIdentity markerID,const std::vector<GeoCoord> &locs,
+                     TimeInterval duration,ChangeSet &changes);
     
     /// Called by the scene once things are set up
     virtual void setScene(Scene *inScene);
@@ -20,6 +20,8 @@
 #import "ChangeRequest.h"
 #import <mutex>
 #import <unordered_set>
+#import <map>
+#import <vector>
 
 namespace WhirlyKit
 {
@@ -31,6 +33,9 @@ namespace WhirlyKit
     
 // Maximum of 8 textures for the moment
 #define WhirlyKitMaxTextures 8
+
+/// Bytes worth of allocated textures we'll keep around for reuse
+#define WhirlyKitOpenGLTexPoolMax (32*1024*1024)
     
 /// Used to manage OpenGL buffer IDs and such.
 /// They're expensive to create and delete, so we try to do it
@@ -50,6 +55,27 @@ public:
     GLuint getTexID();
     /// Toss the given texture ID back on the list for reuse
     void removeTexID(GLuint texID);
+
+    /// Size and format of a texture's storage
+    struct TexStorageKey
+    {
+        GLsizei width;
+        GLsizei height;
+        GLenum internalFormat;
+        GLenum format;
+        GLenum type;
+        bool mipmaps;
+
+        bool operator < (const TexStorageKey &that) const;
+    };
+
+    /// Pick a texture with storage that already matches, so it can be filled
+    ///  with glTexSubImage2D.   Returns 0 if there isn't one.
+    GLuint getSizedTexID(const TexStorageKey &key);
+
+    /// Keep a texture around with its storage intact.
+    /// If the pool is over its limit the texture is deleted.
+    void removeSizedTexID(const TexStorageKey &key,GLuint texID,size_t bytes);
     
     /// Clear out any and all buffer IDs that we may have sitting around
     void clearBufferIDs();
@@ -69,16 +95,26 @@ public:
     /// Globally enable/disable texture reuse, 0 to disable
     static void setTextureReuse(int maxTextures);
 
+    /// Bytes of texture storage to keep around for reuse, 0 to disable
+    static void setTexturePoolSize(size_t maxBytes);
+
 protected:
     std::mutex idLock;
     
     std::unordered_set<GLuint> buffIDs;
     std::unordered_set<GLuint> texIDs;
 
+    // Textures with storage, by size and format.  Oldest first in each.
+    std::map<TexStorageKey,std::vector<std::pair<GLuint,size_t>>> sizedTexIDs;
+    size_t sizedTexBytes = 0;
+
+    void clearSizedTexIDs();
+
     bool shutdown = false;
 
     static int maxCachedBuffers;
     static int maxCachedTextures;
+    static size_t maxTexPoolBytes;
 };
     
 /** This is the configuration info passed to setupGL for each
@@ -0,0 +1,110 @@
+/*  MemoryGovernor.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <memory>
+#import <mutex>
+#import <vector>
+#import "Platform.h"
+#import "ChangeRequest.h"
+
+namespace WhirlyKit
+{
+
+/// What memory is going to
+typedef enum {
+    MemTextures = 0,
+    MemVertexBuffers,
+    MemAtlases,
+    MemCaches,
+    MemParsedTiles,
+    MemNumCategories
+} MemoryCategory;
+
+/// Bytes held in each category
+struct MemoryUsage
+{
+    size_t bytes[MemNumCategories] = {};
+
+    size_t total() const
+    {
+        size_t sum = 0;
+        for (size_t b : bytes)
+            sum += b;
+        return sum;
+    }
+};
+
+/// Steps we take under memory pressure, in order.  Each includes the ones before it.
+typedef enum {
+    MemTrimNone = 0,
+    /// Pooled decode buffers, parsed tile and string layout caches, spare GPU buffers
+    MemTrimDecodeCaches,
+    /// Tiles that are off screen or nearly so, and elevation tiles not used lately
+    MemTrimOffscreenTiles,
+    /// Empty and sparse font atlas pages
+    MemTrimAtlasPages
+} MemoryTrimLevel;
+
+/** Anything holding memory that can be counted and, under pressure, given back.
+    Register it with the scene's MemoryGovernor.
+  */
+class MemoryConsumer
+{
+public:
+    virtual ~MemoryConsumer() = default;
+
+    /// Add the bytes held to the totals
+    virtual void addMemoryUsage(MemoryUsage &usage) = 0;
+
+    /// Let go of what can go at this step.  Called once for each step up to the one asked for.
+    virtual void trimMemory(PlatformThreadInfo *inst,MemoryTrimLevel step,ChangeSet &changes) = 0;
+};
+typedef std::shared_ptr<MemoryConsumer> MemoryConsumerRef;
+
+/** Tracks memory use across the things that hold it and trims in a fixed order when asked.
+    Every consumer gives up its caches before any tiles go, and tiles go before atlas pages are repacked,
+    so what's on screen stays put as long as there's something else to give back.
+    The process-wide decode buffer pool and tile budget are included without being registered.
+    Consumers are held weakly, so they don't have to unregister.
+  */
+class MemoryGovernor
+{
+public:
+    /// Start tracking something
+    void addConsumer(const MemoryConsumerRef &consumer);
+
+    /// Totals across everything we know about (thread safe)
+    MemoryUsage getUsage();
+
+    /// Trim each step in turn, up to and including level.
+    /// Changes for the scene are added to changes.
+    void trim(PlatformThreadInfo *inst,MemoryTrimLevel level,ChangeSet &changes);
+
+    /// Fraction of their current memory tiles are held to after a trim
+    static constexpr double TileFraction = 0.75;
+    /// How long tiles are held to that, in seconds
+    static constexpr TimeInterval TileHoldTime = 30.0;
+
+protected:
+    // The ones still around.  Prunes the rest.
+    std::vector<MemoryConsumerRef> liveConsumers();
+
+    std::mutex lock;
+    std::vector<std::weak_ptr<MemoryConsumer>> consumers;
+};
+
+}
@@ -0,0 +1,77 @@
+/*  MemoryLedger.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <map>
+#import <mutex>
+#import <string>
+#import <unordered_map>
+#import "Identifiable.h"
+
+namespace WhirlyKit
+{
+
+/** Running totals for the drawables and textures in the scene.
+    The scene notes each one as it's added and again when it goes, so the totals
+    are always current and cost nothing to read.  They're kept by owner, which is
+    the name the manager or loader gave the drawable or texture, and by type.
+    Anything added and never removed shows up as a count that keeps climbing,
+    which is the point for leak hunting.
+  */
+class MemoryLedger
+{
+public:
+    /// What we know about one owner or type
+    struct Entry
+    {
+        int count = 0;
+        size_t cpuBytes = 0;
+        size_t gpuBytes = 0;
+    };
+    typedef std::map<std::string,Entry> EntryMap;
+
+    /// Note a drawable or texture coming in.  One already there under the same ID is replaced.
+    void add(SimpleIdentity id,const std::string &owner,const char *type,size_t cpuBytes,size_t gpuBytes);
+
+    /// And going away.  IDs we don't know about are ignored.
+    void remove(SimpleIdentity id);
+
+    /// Totals by owner name (thread safe)
+    EntryMap getByOwner() const;
+
+    /// Totals by type, e.g. "basic", "instance", "texture" (thread safe)
+    EntryMap getByType() const;
+
+    /// Everything together
+    Entry getTotal() const;
+
+protected:
+    struct Record
+    {
+        std::string owner;
+        const char *type;
+        size_t cpuBytes,gpuBytes;
+    };
+
+    void removeLocked(SimpleIdentity id);
+
+    mutable std::mutex lock;
+    std::unordered_map<SimpleIdentity,Record> records;
+    EntryMap byOwner,byType;
+    Entry total;
+};
+
+}
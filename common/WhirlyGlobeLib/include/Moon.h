@@ -18,6 +18,8 @@
  *
  */
 
+#import <mutex>
+
 class CAADate;
 
 namespace WhirlyKit
@@ -28,7 +30,10 @@ namespace WhirlyKit
   **/
 class Moon {
 public:
+    Moon();
     Moon(int year, int month, int day, int hour, int minutes, int second);
+    // Construct from a Julian date (UTC)
+    explicit Moon(double jd);
     ~Moon();
 
     double moonLon, moonLat;
@@ -39,4 +44,25 @@ private:
     void calculateValues(CAADate aaDate);
 };
 
+/**
+    Moon positions and phases for times close together, as in a time lapse.
+    As with the SunCache, the calculation is run at fixed steps and the
+    values in between are interpolated.  Thread safe.
+  **/
+class MoonCache {
+public:
+    MoonCache(double stepMinutes = 10.0);
+
+    // Moon for a Julian date (UTC)
+    Moon getMoon(double jd);
+
+private:
+    std::mutex lock;
+    double step;
+    // The step we've got the ends for, if any
+    bool valid;
+    double stepNum;
+    Moon moon0, moon1;
+};
+
 }
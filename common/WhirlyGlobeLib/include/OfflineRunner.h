@@ -0,0 +1,97 @@
+/*  OfflineRunner.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <functional>
+#import <string>
+#import <vector>
+#import "FrameStats.h"
+#import "MemoryGovernor.h"
+
+namespace WhirlyKit
+{
+
+class Scene;
+class SceneRenderer;
+
+/** Drives a renderer with no view or display link behind it.
+    That's an offline render controller on a pbuffer or an offscreen Metal target,
+    used for benchmarks and for drawing static maps on a server.
+    <br>
+    The platform hands us a way to draw one frame and, optionally, ways to ask
+    whether its loaders are still busy.  We draw until the scene settles, then
+    draw and time a fixed number of frames.  Call it all on the render thread.
+  */
+class OfflineRunner
+{
+public:
+    /// Draw one frame, start to finish
+    typedef std::function<void()> DrawFunc;
+    /// True if something is still loading
+    typedef std::function<bool()> BusyFunc;
+
+    struct Params
+    {
+        /// Longest to wait for loading to finish, in seconds
+        TimeInterval settleTimeout = 30.0;
+        /// Checks in a row that have to come back idle before we believe it
+        int settleChecks = 3;
+        /// Frames to draw and throw away before timing
+        int warmupFrames = 5;
+        /// Frames to time
+        int frames = 60;
+    };
+
+    struct Result
+    {
+        /// False if loading was still going when we gave up waiting
+        bool settled = false;
+        /// How long the wait took and the frames we drew during it
+        TimeInterval settleTime = 0.0;
+        int settleFrames = 0;
+        /// Wall clock time of each timed frame, in seconds
+        std::vector<TimeInterval> frameTimes;
+        /// Renderer stats over the timed frames
+        std::vector<FrameStats::Summary> summaries;
+        /// Memory held once we were done
+        MemoryUsage memory;
+    };
+
+    OfflineRunner(Scene *scene,SceneRenderer *renderer,DrawFunc drawFunc);
+
+    /// Add a check for something that loads on its own schedule, such as a tile loader
+    void addBusyCheck(BusyFunc busyFunc);
+
+    /// True if the scene has changes waiting or any of the checks say they're busy
+    bool isBusy() const;
+
+    /// Draw until nothing is busy or we run out of time.  Returns true if it settled.
+    bool settle(const Params &params,Result &result);
+
+    /// Settle, then warm up and time the frames
+    Result run(const Params &params);
+
+    /// Results as JSON, for scripts to pick up
+    static std::string ToJSON(const Result &result);
+
+protected:
+    Scene *scene;
+    SceneRenderer *renderer;
+    DrawFunc drawFunc;
+    std::vector<BusyFunc> busyFuncs;
+};
+
+}
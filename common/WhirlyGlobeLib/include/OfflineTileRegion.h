@@ -0,0 +1,54 @@
+/*  OfflineTileRegion.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import "QuadTreeNew.h"
+
+namespace WhirlyKit
+{
+
+/** The tiles of a tile set that cover an area, between two levels, for fetching ahead of time.
+    They're numbered level by level from the top, then row by row, so a download can walk
+    through them, or pick up partway, without holding a list of them all.
+    Tiles are laid out the way QuadTreeNew does it, with y going up from the bottom of the bounds.
+  */
+class OfflineTileRegion
+{
+public:
+    /// The tile set covers mbr at level 0.  The region is in the same coordinates.
+    OfflineTileRegion(const MbrD &mbr,const MbrD &region,int minLevel,int maxLevel);
+
+    /// Number of tiles from all the levels
+    int64_t getNumTiles() const { return numTiles; }
+
+    /// The tile at the given position.  False if that's past the end.
+    bool getTile(int64_t which,QuadTreeNew::Node &node) const;
+
+protected:
+    struct LevelRange
+    {
+        int level;
+        int minX,minY,maxX,maxY;
+        // Position of the first tile in this level
+        int64_t start;
+    };
+
+    std::vector<LevelRange> levels;
+    int64_t numTiles;
+};
+
+}
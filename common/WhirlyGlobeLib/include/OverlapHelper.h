@@ -21,6 +21,7 @@
 #import <math.h>
 #import <set>
 #import <map>
+#import <unordered_map>
 #import "Identifiable.h"
 #import "BasicDrawable.h"
 #import "Scene.h"
@@ -36,7 +37,12 @@ struct LayoutObjectEntry;
 class LayoutObject;
 using LayoutObjectEntryRef = std::shared_ptr<LayoutObjectEntry>;
 
-// We use this to avoid overlapping labels
+/** We use this to avoid overlapping labels.
+    Objects only collide by their bounds, so that's all we keep.  Each grid cell holds
+    copies of the bounds that touch it and merge IDs are interned, so checks don't
+    allocate and don't need to go anywhere else in memory.  The grid gets finer when
+    there are a lot of objects to keep the cells short.
+  */
 struct OverlapHelper
 {
     OverlapHelper(const Mbr &mbr,int sizeX,int sizeY,size_t totalObjs);
@@ -49,70 +55,49 @@ struct OverlapHelper
     bool checkObject(const Point2dVector &pts, const char* mergeID = nullptr);
     bool checkObject(const Point2dVector &pts, const std::string &mergeID);
 
+    // Same as the above, for objects we already have the bounds for
+    bool addCheckObject(const Mbr &objMbr, const std::string &mergeID);
+    bool checkObject(const Mbr &objMbr, const std::string &mergeID) const;
+    void addObject(const Mbr &objMbr, const std::string &mergeID);
+
     // Force an object in no matter what
     void addObject(Point2dVector pts, std::string mergeID = std::string());
-    
+
+    // Number of objects added
+    size_t getNumObjects() const { return numObjects; }
+
 protected:
-    void calcCells(const Mbr &objMbr, int &sx, int &sy, int &ex, int &ey);
-    bool checkObject(const Point2dVector &pts, const Mbr &objMbr,
-                     int sx, int sy, int ex, int ey,
-                     const char* mergeID);
-    void addObject(Point2dVector pts, std::string mergeID,
-                   int sx, int sy, int ex, int ey);
+    void calcCells(const Mbr &objMbr, int &sx, int &sy, int &ex, int &ey) const;
+    bool checkObject(const Mbr &objMbr, int mergeID) const;
+    void addObject(const Mbr &objMbr, int mergeID);
 
-    struct GridCell
+    // Interned ID for a merge ID, -1 for none
+    int findMergeID(const std::string &mergeID) const;
+    int addMergeID(const std::string &mergeID);
+
+    // Object bounds as stored in each cell they touch
+    struct CellEntry
     {
-        // Indexes into objects vector
-        std::vector<int> objIndexes;
+        Mbr mbr;
+        int mergeID;
     };
 
-    // Object and its bounds
-    struct BoundedObject
+    struct GridCell
     {
-        BoundedObject() = default;
-        BoundedObject(const BoundedObject&) = default;
-        BoundedObject& operator=(const BoundedObject&) = default;
-
-        BoundedObject(const Point2dVector& inPts, const char* id) :
-                pts(inPts), mergeID(id ? id : std::string())
-        {
-        }
-
-        BoundedObject(Point2dVector&& inPts, std::string &&id) :
-                pts(std::move(inPts)), mergeID(std::move(id))
-        {
-        }
-
-        BoundedObject(BoundedObject&& that) :
-                pts(std::move(that.pts)), mergeID(std::move(that.mergeID))
-        {
-        }
-        BoundedObject& operator=(BoundedObject&& that)
-        {
-            if (this != &that)
-            {
-                pts = std::move(that.pts);
-                mergeID = std::move(that.mergeID);
-            }
-            return *this;
-        }
-
-        Point2dVector pts;
-        std::string mergeID;
+        std::vector<CellEntry> entries;
     };
 
     GridCell &cellAt(int x, int y) { return grid[y * sizeX + x]; }
+    const GridCell &cellAt(int x, int y) const { return grid[y * sizeX + x]; }
 
     Mbr mbr;
     int sizeX;
     int sizeY;
     size_t totalObjs;
+    size_t numObjects = 0;
     Point2f cellSize;
-    std::vector<BoundedObject> objects;
     std::vector<GridCell> grid;
-
-    // Estimate the fraction of objects likely to fall in a given cell
-    const double overlapHeuristic = 0.1;
+    std::unordered_map<std::string,int> mergeIDs;
 
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
 };
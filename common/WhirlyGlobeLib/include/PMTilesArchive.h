@@ -0,0 +1,148 @@
+/*  PMTilesArchive.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <string>
+#import <vector>
+#import <list>
+#import <mutex>
+#import <memory>
+#import <unordered_map>
+#import "RawData.h"
+
+namespace WhirlyKit
+{
+
+/** Finds tiles in a PMTiles (version 3) archive.
+    A PMTiles archive is one big file with a header, a directory tree and the tile data,
+    usually living on a web server or object storage and read with range requests.
+    This does the parsing and keeps the directories we've seen.  Reading the bytes is up
+    to the platform fetchers, which ask us where a tile is, fetch whatever directory we
+    say we need first, and hand it back.
+    Safe to use from multiple threads.
+  */
+class PMTilesArchive
+{
+public:
+    enum Compression {CompressUnknown=0,CompressNone=1,CompressGzip=2,CompressBrotli=3,CompressZstd=4};
+    enum TileType {TileTypeUnknown=0,TileTypeMVT=1,TileTypePNG=2,TileTypeJPEG=3,TileTypeWebP=4,TileTypeAVIF=5};
+
+    /// The header and root directory are always within this many bytes from the start
+    static const size_t StartSize = 16384;
+
+    /// What's in the fixed size header
+    struct Header
+    {
+        uint64_t rootOffset = 0, rootLength = 0;
+        uint64_t metadataOffset = 0, metadataLength = 0;
+        uint64_t leafOffset = 0, leafLength = 0;
+        uint64_t tileDataOffset = 0, tileDataLength = 0;
+        uint64_t numAddressedTiles = 0, numTileEntries = 0, numTileContents = 0;
+        bool clustered = false;
+        int internalCompression = CompressUnknown;
+        int tileCompression = CompressUnknown;
+        int tileType = TileTypeUnknown;
+        int minZoom = 0, maxZoom = 0;
+        /// Bounds and center in degrees
+        double minLon = 0.0, minLat = 0.0, maxLon = 0.0, maxLat = 0.0;
+        int centerZoom = 0;
+        double centerLon = 0.0, centerLat = 0.0;
+    };
+
+    /// Bytes within the archive
+    struct Range
+    {
+        uint64_t offset = 0;
+        uint64_t length = 0;
+    };
+
+    /// One read covering several tiles
+    struct Read
+    {
+        Range range;
+        /// Indices into the ranges passed in, for the tiles within this read
+        std::vector<int> which;
+    };
+
+    enum LookupResult {TileFound,TileMissing,NeedDirectory};
+
+    PMTilesArchive();
+
+    /// Parse the header and root directory.  Pass in (at least) the first StartSize bytes.
+    bool parseStart(const void *data,size_t len);
+
+    /// True once we've got a good header and root directory
+    bool isValid();
+
+    /// Header values, once we're valid
+    Header getHeader();
+
+    /// Tile ID in the archive for a tile, with y counting down from the top
+    static uint64_t tileIDForTile(int x,int y,int level);
+
+    /** Look for a tile.
+        If it's there, the range is where its data is.  If we need a leaf directory
+        we haven't got, the range is where that is.  Fetch that, pass it to addDirectory
+        and ask again.
+      */
+    LookupResult lookup(uint64_t tileID,Range &range);
+
+    /// Keep a leaf directory we were asked to fetch
+    bool addDirectory(const Range &range,const void *data,size_t len);
+
+    /// Undo the archive's tile compression, if any.  Null if we can't.
+    RawDataRef decompressTile(const RawDataRef &data);
+
+    /// Leaf directories we'll hang on to
+    void setMaxLeaves(int maxLeaves);
+
+    /** Group tile ranges into as few reads as possible.
+        Ranges less than maxGap apart go into the same read, as long as the read doesn't get
+        longer than maxLength.  Clustered archives store neighboring tiles next to each other,
+        so a batch of requests for an area usually comes down to a few reads.
+      */
+    static void groupReads(const std::vector<Range> &ranges,uint64_t maxGap,uint64_t maxLength,std::vector<Read> &reads);
+
+protected:
+    struct Entry
+    {
+        uint64_t tileID;
+        uint64_t offset;
+        uint32_t length;
+        // 0 for a pointer to a leaf directory
+        uint32_t runLength;
+    };
+    typedef std::vector<Entry> Directory;
+    typedef std::shared_ptr<Directory> DirectoryRef;
+
+    bool parseDirectory(const void *data,size_t len,Directory &dir);
+    static bool decompress(int compression,const void *data,size_t len,std::vector<unsigned char> &out);
+    static const Entry *findEntry(const Directory &dir,uint64_t tileID);
+    // Lock must be held
+    DirectoryRef findLeaf(uint64_t offset);
+
+    std::mutex lock;
+    bool valid;
+    Header header;
+    Directory root;
+    int maxLeaves;
+    // Leaf directories by where they start, most recently used at the front
+    std::list<uint64_t> leafOrder;
+    std::unordered_map<uint64_t,std::pair<DirectoryRef,std::list<uint64_t>::iterator>> leaves;
+};
+typedef std::shared_ptr<PMTilesArchive> PMTilesArchiveRef;
+
+}
@@ -0,0 +1,33 @@
+/*  PNGDecoder.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <cstddef>
+
+namespace WhirlyKit
+{
+
+/** Decode the sort of PNG we get for data and elevation tiles, quickly.
+    Handles non-interlaced 8 and 16 bit grey, grey+alpha, RGB and RGBA.
+    Rows are inflated and unfiltered one at a time, straight into the output, which is
+    one byte per pixel for grey and RGBA otherwise.  16 bit values keep the high byte.
+    The output is allocated with malloc().
+    Returns NULL for anything else, such as palette or interlaced images, or if the data is bad.
+  */
+extern unsigned char *DecodePNGFast(const unsigned char *data,size_t length,
+                                    unsigned int &width,unsigned int &height,int &byteWidth);
+
+}
@@ -72,8 +72,8 @@ protected:
 
     GLuint pointBuffer,rectBuffer;
 
-    void drawSetupTextures(RendererFrameInfo *frameInfo,Scene *scene,ProgramGLES *prog,bool hasTexture[],int &progTexBound);
-    void drawTeardownTextures(RendererFrameInfo *frameInfo,Scene *scene,ProgramGLES *prog,bool hasTexture[],int progTexBound);
+    void drawSetupTextures(RendererFrameInfoGLES *frameInfo,Scene *scene,ProgramGLES *prog,bool hasTexture[],int &progTexBound);
+    void drawTeardownTextures(RendererFrameInfoGLES *frameInfo,Scene *scene,ProgramGLES *prog,bool hasTexture[],int progTexBound);
     void drawSetupUniforms(RendererFrameInfo *frameInfo,Scene *scene,ProgramGLES *prog);
     void drawBindAttrs(RendererFrameInfo *frameInfo,Scene *scene,ProgramGLES *prog,const BufferChunk &chunk,int pointsSoFar,bool useInstancingHere);
     void drawUnbindAttrs(ProgramGLES *prog);
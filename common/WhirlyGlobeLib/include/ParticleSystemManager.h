@@ -48,6 +48,8 @@ public:
     ParticleSystemType type;
     SimpleIdentity calcShaderID;
     SimpleIdentity renderShaderID;
+    /// Particles go away after this long.  Zero keeps them around, so the calculation
+    ///  shader can run them on the GPU without any more batches.
     TimeInterval lifetime,baseTime;
     int totalParticles,batchSize,vertexSize;
     bool continuousUpdate;
@@ -92,6 +94,8 @@ public:
     // For Metal we just use instances
     SimpleIDSet basicIDs;
     SimpleIDSet instIDs;
+    // The Metal drawable that runs the calculation shader
+    SimpleIdentity calcID = EmptyIdentity;
 };
     
 typedef std::map<SimpleIdentity,ParticleSystemSceneRep *> ParticleSystemSceneRepSet;
@@ -118,6 +122,9 @@ public:
     /// Change the render target
     void changeRenderTarget(SimpleIdentity sysID,SimpleIdentity targetID,ChangeSet &changes);
 
+    /// Swap in new textures, such as the next frame of a vector field the particles follow
+    void changeTextures(SimpleIdentity sysID,const std::vector<SimpleIdentity> &texIDs,ChangeSet &changes);
+
     /// Apply the given uniform block to the particle systems selected
     void setUniformBlock(const SimpleIDSet &partSysIDs,const RawDataRef &uniBlock,int bufferID,ChangeSet &changes);
 
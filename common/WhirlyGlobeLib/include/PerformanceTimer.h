@@ -20,6 +20,9 @@
 
 #import <string>
 #import <map>
+#import <vector>
+#import <mutex>
+#import <atomic>
 #import "WhirlyTypes.h"
 
 namespace WhirlyKit
@@ -86,6 +89,145 @@ protected:
     std::map<std::string,TimeEntry> timeEntries;
     std::map<std::string,CountEntry> countEntries;
 };
+
+/** Trace zones are cheap enough to leave in the hot paths.
+    Each zone name is interned once into a small ID, and begin/end
+    events go into a buffer per thread without taking any locks.
+    Recorded events can be pulled out as Chrome trace JSON, which
+    chrome://tracing and Perfetto will read.  Zones can also be passed
+    through to ATrace on Android and os_signpost on iOS.
+    Use WKTraceScope rather than calling begin/end directly.
+  */
+class TraceZones
+{
+public:
+    /// Intern a zone name.  The string has to stick around (use a literal).
+    /// Returns -1, which traces nothing, if there are already too many zones.
+    static int registerZone(const char *name);
+
+    /// Name for a zone ID.  Doesn't take any locks.
+    static const char *getZoneName(int zone);
+
+    /// Record zones into the per-thread buffers
+    static void setRecording(bool record);
+
+    /// Pass zones through to the system tracer (ATrace, os_signpost)
+    static void setSystemTracing(bool trace);
+
+    /// True if zones are going anywhere at all
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    /// What begin sent a zone to, so end closes the same things
+    enum { TraceRecorded = 1, TraceSystem = 2 };
+
+    /// Start and end a zone on the current thread.
+    /// These have to be nested properly.  Pass end what begin returned,
+    ///  since recording or system tracing may have been switched in between.
+    static int begin(int zone);
+    static void end(int zone,int emitted);
+
+    /// Everything recorded so far as Chrome trace event JSON
+    static std::string getChromeTrace();
+
+    /// Forget the recorded events
+    static void clear();
+
+protected:
+    static std::atomic<bool> enabled;
+    static std::atomic<bool> recording;
+    static std::atomic<bool> systemTracing;
+};
+
+/// Traces a zone for its lifetime
+class TraceScope
+{
+public:
+    TraceScope(int inZone) : zone(TraceZones::isEnabled() ? inZone : -1), emitted(0)
+    {
+        if (zone >= 0)
+            emitted = TraceZones::begin(zone);
+    }
+    ~TraceScope()
+    {
+        if (emitted)
+            TraceZones::end(zone,emitted);
+    }
+
+protected:
+    int zone;
+    int emitted;
+};
+
+#define WK_TRACE_CONCAT_(a,b) a##b
+#define WK_TRACE_CONCAT(a,b) WK_TRACE_CONCAT_(a,b)
+
+/// Trace the rest of the enclosing block under the given name (a string literal)
+#define WKTraceScope(name) \
+    static const int WK_TRACE_CONCAT(wkTraceZone_,__LINE__) = WhirlyKit::TraceZones::registerZone(name); \
+    WhirlyKit::TraceScope WK_TRACE_CONCAT(wkTraceScope_,__LINE__)(WK_TRACE_CONCAT(wkTraceZone_,__LINE__))
+
+/** Startup phases, from when the controller starts setting up to the first frame with something in it.
+    Phases can overlap and can come from any thread.  Times are seconds since the timeline started.
+    Marks are phases with no length (first frame, first content) and only the first one of a name counts.
+  */
+class StartupTimeline
+{
+public:
+    struct Phase
+    {
+        std::string name;
+        TimeInterval start,end;
+    };
+
+    StartupTimeline();
+
+    /// Forget everything and start the clock over, from now or an earlier TimeGetCurrent()
+    void restart(TimeInterval when = 0.0);
+
+    /// Start and end a named phase
+    void begin(const std::string &name);
+    void end(const std::string &name);
+
+    /// Add a phase that was timed elsewhere, with TimeGetCurrent() times
+    void add(const std::string &name,TimeInterval start,TimeInterval end);
+
+    /// Note an event, the first time it happens
+    void mark(const std::string &name);
+
+    /// True once all the marks are in and there's nothing more to record
+    bool isDone() const { return done.load(std::memory_order_relaxed); }
+
+    /// Stop recording once this mark comes in
+    void setFinalMark(const std::string &name);
+
+    /// Phases so far, in the order they started.  Unfinished ones have an end of -1.
+    std::vector<Phase> getPhases() const;
+
+    /// Write the phases out to the log
+    void log() const;
+
+protected:
+    mutable std::mutex lock;
+    TimeInterval startTime;
+    std::vector<Phase> phases;
+    std::string finalMark;
+    std::atomic<bool> done;
+};
+
+/// Records a startup phase for its lifetime
+class StartupPhase
+{
+public:
+    StartupPhase(StartupTimeline &timeline,std::string inName) : timeline(timeline), name(std::move(inName))
+    {
+        timeline.begin(name);
+    }
+    ~StartupPhase() { timeline.end(name); }
+
+protected:
+    StartupTimeline &timeline;
+    std::string name;
+};
     
 }
 
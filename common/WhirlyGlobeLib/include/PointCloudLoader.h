@@ -0,0 +1,231 @@
+/*  PointCloudLoader.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <map>
+#import <set>
+#import <mutex>
+#import <vector>
+#import "WhirlyVector.h"
+#import "WhirlyKitView.h"
+#import "GeometryManager.h"
+#import "TileMemoryManager.h"
+
+namespace WhirlyKit
+{
+
+/// A node in a point cloud octree.  Level 0 is the whole cloud and x, y, z run from 0 to 2^level-1.
+struct OctreeIdentifier
+{
+    OctreeIdentifier() = default;
+    OctreeIdentifier(int x,int y,int z,int level) : x(x), y(y), z(z), level(level) { }
+
+    bool operator < (const OctreeIdentifier &that) const;
+    bool operator == (const OctreeIdentifier &that) const;
+
+    /// One of the eight children.  Bit 0 of which picks x, bit 1 y and bit 2 z.
+    OctreeIdentifier child(int which) const;
+
+    int x = 0, y = 0, z = 0;
+    int level = 0;
+};
+
+/** Points for one octree node.
+    Positions are quantized to 16 bits per axis within the node's box, which is
+    plenty at the density a node is shown at and a quarter of what doubles take.
+    The geometry we build from them is in floats relative to the node's center,
+    with the offset in the drawable matrix, so precision holds up far from the origin.
+  */
+class PointCloudChunk
+{
+public:
+    /// Set up for a node's box, in display coordinates
+    PointCloudChunk(const Point3d &ll,const Point3d &ur);
+
+    /// Add a point in display coordinates.  It's clamped to the box.
+    void addPoint(const Point3d &pt);
+    /// Add a color for the last point.  Colors are optional, but if there are any, every point needs one.
+    void addColor(const RGBAColor &color);
+
+    /// Which children have any points, one bit each, numbered as in OctreeIdentifier::child
+    uint8_t childMask = 0xff;
+
+    /// Number of points we're holding
+    size_t getNumPoints() const { return quantPts.size() / 3; }
+
+    /// Position of a point, relative to the center
+    Point3f getPoint(size_t which) const;
+
+    /// Bytes taken up by the quantized points and colors
+    size_t getMemSize() const;
+
+    /// Bytes the geometry takes, once loaded
+    size_t getGeomSize() const;
+
+    /// Fill in the points around the center, along with the matrix that puts them in place
+    void buildPoints(GeometryRawPoints &rawPts,Eigen::Matrix4d &mat) const;
+
+protected:
+    Point3d center;
+    Point3d scale;
+    std::vector<uint16_t> quantPts;
+    std::vector<RGBAColor> colors;
+};
+typedef std::shared_ptr<PointCloudChunk> PointCloudChunkRef;
+
+class PointCloudLoader;
+
+/** Fill this in to read point cloud nodes out of your own storage.
+    Fetches can finish on any thread.
+  */
+class PointCloudSource
+{
+public:
+    virtual ~PointCloudSource() = default;
+
+    /// Start loading a node.  Call chunkLoaded or chunkFailed on the loader when it's done.
+    virtual void startFetch(PointCloudLoader *loader,const OctreeIdentifier &ident) = 0;
+
+    /// We don't want the node anymore.  Results handed back after this are ignored.
+    virtual void cancelFetch(PointCloudLoader *loader,const OctreeIdentifier &ident) { }
+};
+typedef std::shared_ptr<PointCloudSource> PointCloudSourceRef;
+
+/** Pages a point cloud in and out by octree node.
+    Each node holds a subsample of the points under it, getting denser as you go down,
+    and nodes add to their parent's points rather than replacing them.
+    <br>
+    On a view update we walk down from the root, skipping nodes that are off screen,
+    and stop refining where a node's points would be closer than the pixel spacing
+    on screen.  Everything we walked through is wanted, coarsest on screen first,
+    up to the memory budget.  A node's children are only considered once it's loaded,
+    since that's where we learn which of them exist.
+    <br>
+    Nodes we no longer want are hidden and kept.  When we're over budget the least
+    recently used of those lose their geometry, then their points.  We also report to
+    the shared TileMemoryManager, with nodes counting as tiles.
+  */
+class PointCloudLoader
+{
+public:
+    /// The root node's box is in display coordinates.
+    /// Root spacing is the typical distance between points in the root, which halves each level.
+    PointCloudLoader(const Point3d &ll,const Point3d &ur,int maxLevel,double rootSpacing,const PointCloudSourceRef &source);
+    virtual ~PointCloudLoader();
+
+    /// Settings for the point geometry, such as size, shader and draw priority
+    void setGeometryInfo(const GeometryInfo &info) { geomInfo = info; }
+
+    /// Refine until points would be this far apart on screen.  2 pixels by default.
+    void setPixelSpacing(double spacing) { pixelSpacing = spacing; }
+    double getPixelSpacing() const { return pixelSpacing; }
+
+    /// Bytes we'll hold in points and geometry, all told.  256MB by default.
+    void setMemoryBudget(size_t bytes) { memBudget = bytes; }
+    size_t getMemoryBudget() const { return memBudget; }
+
+    /// Most fetches we'll have going at once.  8 by default.
+    void setMaxFetches(int num) { maxFetches = num; }
+
+    /// If set, we report to the shared TileMemoryManager and load fewer nodes when it's over budget
+    void setUseMemoryBudget(bool newVal) { useMemoryBudget = newVal; }
+
+    /// Box for a node, in display coordinates
+    void boundsForNode(const OctreeIdentifier &ident,Point3d &ll,Point3d &ur) const;
+
+    /// The source calls this when a node is in.  Thread safe.
+    void chunkLoaded(const OctreeIdentifier &ident,const PointCloudChunkRef &chunk);
+
+    /// The source calls this if a node couldn't be loaded.  Thread safe.
+    void chunkFailed(const OctreeIdentifier &ident);
+
+    /// Called on the layer thread before the first view update
+    void start(Scene *scene);
+
+    /** Work out the nodes to show for the view, start fetching the ones we don't have
+        and move loaded ones in and out of the scene.  Returns true if fetches are
+        outstanding, so we'd like to be called again shortly.
+        Pass in a null view state to reuse the last one.
+      */
+    bool viewUpdate(PlatformThreadInfo *threadInfo,const ViewStateRef &viewState,ChangeSet &changes);
+
+    /// Remove everything we added.  Layer thread.
+    void stop(PlatformThreadInfo *threadInfo,ChangeSet &changes);
+
+    struct Stats
+    {
+        int numLoaded = 0;
+        int numDisplayed = 0;
+        int numFetching = 0;
+        size_t numPointsDisplayed = 0;
+        size_t bytes = 0;
+    };
+
+    /// What we're holding right now.  Thread safe.
+    Stats getStats() const;
+
+protected:
+    typedef enum {NodeFetching,NodeLoaded,NodeFailed} NodeState;
+
+    struct Node
+    {
+        NodeState state = NodeFetching;
+        PointCloudChunkRef chunk;
+        SimpleIdentity geomID = EmptyIdentity;
+        bool enabled = false;
+        TimeInterval lastUsed = 0.0;
+    };
+
+    struct WantedNode
+    {
+        OctreeIdentifier ident;
+        double import;
+    };
+
+    // Walk the octree for the view, filling in the nodes we'd like, parents ahead of children
+    void calcWanted(const ViewStateRef &viewState,std::vector<WantedNode> &wanted);
+
+    // Drop what we can, least recently used first, until we're under budget
+    void evict(const std::set<OctreeIdentifier> &wantedSet,ChangeSet &changes);
+
+    // Points and geometry held for the given node
+    static size_t nodeBytes(const Node &node);
+
+    Point3d ll,ur;
+    int maxLevel;
+    double rootSpacing;
+    PointCloudSourceRef source;
+    Scene *scene = nullptr;
+    GeometryInfo geomInfo;
+
+    double pixelSpacing = 2.0;
+    size_t memBudget = 256*1024*1024;
+    int maxFetches = 8;
+    bool useMemoryBudget = true;
+    int memClientID = -1;
+
+    std::map<OctreeIdentifier,Node> nodes;
+    int numFetching = 0;
+    ViewStateRef lastViewState;
+
+    // Results from the source waiting for the layer thread
+    mutable std::mutex lock;
+    std::vector<std::pair<OctreeIdentifier,PointCloudChunkRef> > pending;
+    Stats stats;
+};
+typedef std::shared_ptr<PointCloudLoader> PointCloudLoaderRef;
+
+}
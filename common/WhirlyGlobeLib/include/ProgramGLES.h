@@ -21,6 +21,7 @@
 #import <vector>
 #import <unordered_map>
 #import "UtilsGLES.h"
+#import "StateCacheGLES.h"
 #import "Identifiable.h"
 #import "WhirlyVector.h"
 #import "Drawable.h"
@@ -145,13 +146,28 @@ public:
     
     /// Bind any program specific textures right before we draw.
     /// We get to start at 0 and return however many we bound
-    int bindTextures();
+    int bindTextures(StateCacheGLES *stateCache);
     
     /// Clean up OpenGL resources, rather than letting the destructor do it (which it will)
     virtual void teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene,RenderTeardownInfoRef teardown) override;
     void cleanUp();
-    
+
+    /** Keep linked programs in this directory and load them from there on later runs,
+        rather than compiling the shaders again.  Entries are keyed by the shader source
+        and the GL vendor, renderer and version, so a driver update starts fresh.
+        Empty (the default) turns it off.
+      */
+    static void setBinaryCacheDir(const std::string &dir);
+
 protected:
+    // Compile and link from source.  Lock the binary down afterward if asked.
+    bool buildFromSource(const std::string &vShaderString,const std::string &fShaderString,
+                         const std::vector<std::string> *varyings,bool retrievable);
+    // Try to load the linked program from the cache
+    bool loadBinary(const std::string &path);
+    // Write the linked program to the cache
+    void saveBinary(const std::string &path);
+
     GLuint program;
     GLuint vertShader;
     GLuint fragShader;
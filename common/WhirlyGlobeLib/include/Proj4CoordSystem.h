@@ -16,6 +16,9 @@
  *  limitations under the License.
  */
 
+#import <mutex>
+#import <thread>
+#import <unordered_map>
 #import "WhirlyVector.h"
 #import "CoordSystem.h"
 
@@ -23,6 +26,7 @@ namespace WhirlyKit
 {
 
 /** The proj4 coord system object wraps a proj.4 implemented coordinate system.
+    Each thread that uses it gets its own proj.4 context and projections, so it can be shared.
   */
 class Proj4CoordSystem : public CoordSystem
 {
@@ -50,16 +54,63 @@ public:
     virtual Point3f geocentricToLocal(Point3f) const override;
     virtual Point3d geocentricToLocal(Point3d) const override;
     
+    /// Batch versions, which go through proj.4 once for the lot.
+    /// Points that fail come back as zeros, like the single point versions.
+    virtual void geographicToLocalBatch(const Point2d *geo,Point3d *local,size_t count) const override;
+    virtual void localToGeographicBatch(const Point3d *local,Point2d *geo,size_t count) const override;
+    virtual void localToGeocentricBatch(const Point3d *local,Point3d *geoc,size_t count) const override;
+    virtual void geocentricToLocalBatch(const Point3d *geoc,Point3d *local,size_t count) const override;
+
+    /** Approximate local to geographic conversions with a grid.
+        The grid is sampled through proj.4 once, over the given bounds in local coordinates.
+        After that, batch conversions from local coordinates interpolate within the grid for the
+        points inside it and use proj.4 for the rest.
+        This is meant for tile corners and the like, where a little error doesn't show.
+        Finer grids are closer.  Pass 0 cells to turn it off.
+      */
+    void setApproxGrid(const MbrD &localBounds,int cellsX,int cellsY);
+
     /// True if the other system is Spherical Mercator with the same origin
     virtual bool isSameAs(const CoordSystem *coordSys) const override;
     
     /// Check that it actually created the pj structures
-    bool isValid() const { return pj != nullptr; }
+    bool isValid() const { return valid; }
     
 protected:
-    void *pj;
-    void *pj_latlon,*pj_geocentric;
+    // Proj.4 state for one thread
+    struct ProjSet
+    {
+        ProjSet(const std::string &proj4Str);
+        ~ProjSet();
+        void *ctx;
+        void *pj,*pj_latlon,*pj_geocentric;
+    };
+
+    // Geographic coordinates sampled over part of the local space
+    struct ApproxGrid
+    {
+        // Interpolate a point inside the grid.  False if it's outside or the samples around it aren't good.
+        bool interpolate(const Point3d &local,Point2d &geo) const;
+
+        MbrD bounds;
+        int cellsX,cellsY;
+        Point2d cellSize;
+        std::vector<Point2d> geo;
+    };
+
+    // Projections for the calling thread
+    const ProjSet &getProj() const;
+
+    // Convert from local to geographic through proj.4, flagging the points that fail
+    void localToGeographicProj(const Point3d *local,Point2d *geo,size_t count,std::vector<bool> *failed) const;
+
     std::string proj4Str;
+    bool valid;
+    // Tells this one apart from others in the thread caches, even at the same address
+    const uint64_t cacheID;
+    mutable std::mutex lock;
+    mutable std::unordered_map<std::thread::id,std::unique_ptr<ProjSet>> projSets;
+    std::shared_ptr<const ApproxGrid> approxGrid;
 };
     
 }
@@ -26,6 +26,7 @@
 #import "ScreenImportance.h"
 #import "WhirlyKitView.h"
 #import "QuadTreeNew.h"
+#import "TileMemoryManager.h"
 
 namespace WhirlyKit
 {
@@ -64,6 +65,19 @@ public:
                                      const Mbr &mbr,
                                      const ViewStateRef &viewState,
                                      const Point2f &frameSize) = 0;
+
+    /// Return importance values for a group of tiles.
+    /// By default this calls importanceForTile for each one.
+    virtual void importanceForTiles(const std::vector<QuadTreeIdentifier> &idents,
+                                    const std::vector<Mbr> &mbrs,
+                                    const ViewStateRef &viewState,
+                                    const Point2f &frameSize,
+                                    std::vector<double> &imports)
+    {
+        imports.resize(idents.size());
+        for (size_t ii=0;ii<idents.size();ii++)
+            imports[ii] = importanceForTile(idents[ii],mbrs[ii],viewState,frameSize);
+    }
     
     /// Called when the view state changes.  If you're caching info, do it here.
     virtual void newViewState(ViewStateRef viewState) = 0;
@@ -101,6 +115,13 @@ public:
     
     /// Called when a layer is shutting down (on the layer thread)
     virtual void quadLoaderShutdown(PlatformThreadInfo *threadInfo,ChangeSet &changes) = 0;
+
+    /// Tiles we expect to need soon, but aren't loading yet.  Fetch ahead if you can.
+    virtual void quadLoaderPrefetch(PlatformThreadInfo *threadInfo,
+                                    const WhirlyKit::QuadTreeNew::ImportantNodeSet &tiles) { }
+
+    /// Memory used by the loaded tiles, for the shared tile budget
+    virtual TileMemoryUsage quadLoaderMemoryUsage() const { return TileMemoryUsage(); }
     
 protected:
     QuadDisplayControllerNew *control = nullptr;
@@ -137,6 +158,16 @@ public:
     /// Load just the target level (and the lowest level)
     bool getSingleLevel() const;
     void setSingleLevel(bool);
+
+    /// If set, we look at where an animation is taking the view and ask
+    ///  the loader to fetch ahead for the tiles we'll need there.
+    bool getPrefetch() const { return prefetch; }
+    void setPrefetch(bool newVal) { prefetch = newVal; }
+
+    /// If set, we report to the shared TileMemoryManager and load fewer tiles when it's over budget.
+    /// On by default, but the manager doesn't limit anyone until it's given a budget.
+    bool getUseMemoryBudget() const { return useMemoryBudget; }
+    void setUseMemoryBudget(bool newVal) { useMemoryBudget = newVal; }
     
     /// Do we always throw the min level into the mix or not
     void setKeepMinLevel(bool newVal,double height);
@@ -177,7 +208,14 @@ public:
 protected:
     // QuadTreeNew overrides
     virtual double importance(const Node &node) override;
+    virtual void batchImportance(const std::vector<Node> &nodes,std::vector<double> &imports) override;
     virtual bool visible(const Node &node) override;
+
+    // Work out which tiles to load for the current view, up to the given number
+    std::tuple<int,ImportantNodeSet> calcCoverage(int maxNodes,bool localKeepMinLevel,std::vector<double> &maxRejectedImport);
+
+    // Work out what we'd load for the view an animation is headed to and pass that on
+    void prefetchPredicted(PlatformThreadInfo *threadInfo,const ViewStateRef &predictedState,bool localKeepMinLevel);
     
     QuadDataStructure *dataStructure;
     QuadLoaderNew *loader;
@@ -195,9 +233,20 @@ protected:
     double mbrScaling = 1.0;
     double keepMinLevelHeight = 0.0;
     bool singleLevel = false;
+    bool prefetch = false;
+    bool useMemoryBudget = true;
+    int memClientID = -1;
+    int memTileLimit = -1;   // From the memory manager, -1 for no limit
     std::vector<int> levelLoads;
 
     QuadTreeNew::ImportantNodeSet currentNodes;
+
+    // View and frame size from the last coverage pass, for incremental mode
+    ViewStateRef lastCoverageView;
+    Point2f lastFrameSize = Point2f(0,0);
+
+    // Last predicted view we prefetched for
+    ViewStateRef lastPrefetchView;
     
     float lastTargetLevel = 1.0f;   // For tracking continuous zoom
     float lastTargetDecimal = -1.0f;
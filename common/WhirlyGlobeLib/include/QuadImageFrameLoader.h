@@ -19,6 +19,8 @@
 #import "QuadSamplingController.h"
 #import "QuadLoaderReturn.h"
 #import "ComponentManager.h"
+#import "ElevationManager.h"
+#import "TileLatencyStats.h"
 
 namespace WhirlyKit
 {
@@ -54,6 +56,9 @@ public:
     
     // Texture ID (if loaded)
     const std::vector<SimpleIdentity> &getTexIDs() const { return texIDs; }
+
+    // Size of the texture data we handed over
+    size_t getTexBytes() const { return texBytes; }
     
     // Return information about which frame this is
     QuadFrameInfoRef getFrameInfo() const { return frameInfo; }
@@ -79,6 +84,22 @@ public:
     // We're not bothering to load it, but pretend like it succeeded
     virtual void loadSkipped();
 
+    // A reload came back the same as what we're showing, so go back to showing it
+    virtual void loadUnchanged(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader);
+
+    // Set when we're fetching over textures we're still showing
+    void setReloading(bool newVal) { reloading = newVal; }
+    bool isReloading() const { return reloading; }
+
+    // Generation of the loader when the current fetch started
+    int getGeneration() const { return generation; }
+
+    // Hash of the data behind the textures we're showing, 0 if we don't know
+    uint64_t getDataHash() const { return dataHash; }
+
+    // Hash of the data we're parsing, kept once it's loaded
+    void setPendingDataHash(uint64_t hash) { pendingDataHash = hash; }
+
     // Store the raw data for use later
     virtual void setLoadReturn(RawDataRef data);
     
@@ -102,12 +123,18 @@ protected:
     
     int priority;
     double importance;
+
+    int generation;
+    bool reloading;
+    uint64_t dataHash;
+    uint64_t pendingDataHash;
     
     // Which frame this is on the tile side
     QuadFrameInfoRef frameInfo;
     
     // If set, the texture ID for this asset
     std::vector<SimpleIdentity> texIDs;
+    size_t texBytes;
     
     // When fetching a single frame that has multiple data sources, we store the data here
     bool loadReturnSet;
@@ -255,7 +282,7 @@ protected:
 };
 
 typedef std::shared_ptr<QIFTileAsset> QIFTileAssetRef;
-typedef std::map<QuadTreeNew::Node,QIFTileAssetRef> QIFTileAssetMap;
+typedef FlatNodeMap<QuadTreeNew::Node,QIFTileAssetRef> QIFTileAssetMap;
 
 // Information about a single tile and its current state
 class QIFTileState
@@ -297,9 +324,16 @@ public:
     QIFRenderState();
     QIFRenderState(int numFocus,int numFrames);
     
-    std::map<QuadTreeNew::Node,QIFTileStateRef> tiles;
+    FlatNodeMap<QuadTreeNew::Node,QIFTileStateRef> tiles;
 
     int texSize,borderSize;
+
+    // Draw all the frames at once, layered in order
+    bool composite = false;
+
+    // The second frame is elevation, with this to turn its pixels into a height in display units
+    bool terrain = false;
+    float elevDecode[4] = {0.0f,0.0f,0.0f,0.0f};
     
     // Number of tiles loaded for each frame
     std::vector<int> tilesLoaded;
@@ -321,6 +355,13 @@ public:
                      const RGBAColor &color,
                      bool masterEnable,
                      ChangeSet &changes);
+
+protected:
+    // Composite version of updateScene, where every frame goes in its own texture slot
+    void updateSceneComposite(const std::vector<double> &curFrames,
+                              const RGBAColor &color,
+                              bool masterEnable,
+                              ChangeSet &changes);
 };
     
 /** Quad Image Frame Loader
@@ -380,9 +421,27 @@ public:
     /// Set if we need the top tiles to load before we'll display a frame
     virtual void setRequireTopTilesLoaded(bool newVal) { requiringTopTilesLoaded = newVal; }
 
+    /// If set, a tile that's still loading is drawn with the piece of its nearest loaded
+    ///  ancestor's texture, even if there are levels missing in between.
+    /// Tiles whose ancestors are still loading go behind everything else in the fetch queue.
+    /// Off by default, but a renderer set for fast startup turns it on unless this was called.
+    void setParentPlaceholders(bool newVal) { parentPlaceholders = newVal; parentPlaceholdersSet = true; }
+    bool getParentPlaceholders() const { return parentPlaceholders; }
+
+    /// If set, images from tile sources in another coordinate system (Proj4, BNG and so on)
+    ///  are warped on the GPU to line up with the display, once per tile, through a mesh
+    ///  with this many samples on a side.  The tile geometry can then use far fewer samples.
+    /// 0, the default, turns it off.
+    void setReprojectSamples(int samples) { reprojectSamples = std::max(samples,0); }
+    int getReprojectSamples() const { return reprojectSamples; }
+
     /// Return the quad display controller this is attached to
     QuadDisplayControllerNew *getController() const { return control; }
 
+    /// Swap in warped versions of a tile's images, if we're reprojecting and they need it.
+    /// The changes to draw them go in warpChanges, to be applied after the new textures are added.
+    void reprojectTextures(const QuadTreeNew::Node &ident,std::vector<Texture *> &texs,ChangeSet &warpChanges);
+
     /// Color for polygons created during loading
     void setColor(const RGBAColor &inColor,ChangeSet *changes);
     const RGBAColor &getColor() const { return color; }
@@ -402,6 +461,10 @@ public:
 
     /// In-memory texture type
     void setTexType(TextureType type) { texType = type; }
+
+    /// If set, tile textures are staged on the layer thread and copied in by the renderer
+    void setAsyncTextureUpload(bool async) { asyncTexUpload = async; }
+    bool getAsyncTextureUpload() const { return asyncTexUpload; }
     
     /// If we're using border pixels, set the individual texture size and border size
     void setTexSize(int texSize,int borderSize);
@@ -413,6 +476,28 @@ public:
     // What part of the animation we're displaying
     void setCurFrame(PlatformThreadInfo *threadInfo, int focusID, double curFrame);
     double getCurFrame(int focusID);
+
+    /// In multi-frame mode, keep only this many frames around the current one loaded.
+    /// The window leans toward the direction the animation is running and
+    ///  frames that fall out of it are unloaded.  0, the default, loads all the frames.
+    void setFrameWindow(int numFrames);
+    int getFrameWindow() const { return frameWindow; }
+
+    /// Most frames we'll composite in one pass
+    static const int MaxCompositeFrames = 4;
+
+    /// In multi-frame mode, draw all the frames at once, each one blended over the last.
+    /// Stacked layers, like a basemap, hillshade and overlay, can then share one set of tile
+    ///  geometry and a single draw per tile.  Needs a composite shader and loads every frame.
+    void setCompositeFrames(bool composite);
+    bool getCompositeFrames() const { return compositeFrames; }
+
+    /// In multi-frame mode with two frames, treat the second as elevation for the first.
+    /// Each tile is raised in the vertex shader by the heights in its elevation image, so it costs
+    ///  nothing on the CPU and the tile geometry stays shared.  Needs a terrain shader and
+    ///  elevTextures set in the sampling params, for skirts.
+    void setTerrain(bool terrain,ElevationEncoding encoding = ElevEncodeTerrarium,double exaggeration = 1.0);
+    bool getTerrain() const { return terrain; }
     
     // Need to know how we're loading the tiles to calculate the render state
     void setFlipY(bool newFlip) { flipY = newFlip; }
@@ -437,6 +522,27 @@ public:
 
     /// Reload matching tiles in the given frame (or everything)
     virtual void reload(PlatformThreadInfo *threadInfo,int frame,const Mbr *bound,int boundCount,ChangeSet &changes);
+
+    /// If set, reloads leave the tiles outside the bounds alone and keep showing the tiles
+    ///  inside them until their new data is in, when the textures are swapped in one go.
+    /// Data that comes back the same as what a tile is showing isn't parsed again.
+    /// Off by default.
+    void setReloadInPlace(bool newVal) { reloadInPlace = newVal; }
+    bool getReloadInPlace() const { return reloadInPlace; }
+
+    /// Called with the data for a frame before it's parsed.
+    /// If it's the same as what an in-place reload is replacing, the frame goes back to
+    ///  showing what it had and we return true, so the data can be dropped.
+    bool frameUnchanged(PlatformThreadInfo *threadInfo,const QuadTreeIdentifier &ident,
+                        SimpleIdentity frameID,const RawData *data);
+
+    /// Called with the data for a frame before it's parsed
+    bool frameUnchanged(PlatformThreadInfo *threadInfo,const QuadTreeIdentifier &ident,
+                        const QuadFrameInfoRef &frame,const RawData *data);
+
+    /// Textures an in-place reload has replaced.
+    /// They're removed after the next render state goes out, so nothing draws without them in between.
+    void retireTextures(const std::vector<SimpleIdentity> &texIDs);
     
     /// Recalculate all the frame/tile priorities
     virtual void updatePriorities(PlatformThreadInfo *threadInfo);
@@ -473,6 +579,13 @@ public:
     
     /// Returns true if we're in the middle of loading things
     virtual bool builderIsLoading() const override { return loadingStatus; }
+
+    /// Fetch ahead for tiles we'll probably be asked to load soon
+    virtual void builderPrefetch(PlatformThreadInfo *threadInfo,QuadTileBuilder *inBuilder,
+                                 const WhirlyKit::QuadTreeNew::ImportantNodeSet &tiles) override;
+
+    /// Texture memory for our tiles, as of the last stats update
+    virtual TileMemoryUsage builderMemoryUsage() const override;
     
     /// **** Active Model methods ****
 
@@ -480,7 +593,7 @@ public:
     virtual bool hasUpdate() const override;
     
     /// Process the update
-    virtual void updateForFrame(RendererFrameInfo *frameInfo) override;
+    virtual void batchUpdateForFrame(RendererFrameInfo *frameInfo,ChangeSet &changes) override;
     
     /** ----- **/
     
@@ -493,6 +606,10 @@ public:
         int totalTiles = 0;
         // Tiles yet to load for this frame
         int tilesToLoad = 0;
+        // Tiles that have this frame loaded
+        int tilesLoaded = 0;
+        // Set if the frame is inside the frame window (or there isn't one)
+        bool resident = true;
     };
 
     /**
@@ -502,6 +619,11 @@ public:
     {
         // Total number of tiles being managed
         int numTiles = 0;
+
+        // Texture data for all the loaded frames
+        size_t texBytes = 0;
+        // Tiles with at least one texture
+        int numTexTiles = 0;
         
         // Per frame stats
         std::vector<FrameStats> frameStats;
@@ -509,6 +631,9 @@ public:
 
     /// Return the stats (thread safe)
     Stats getStats() const;
+
+    /// Per-tile timing from request to display.  Off until it's enabled.
+    const TileLatencyStatsRef &getLatencyStats() const { return latencyStats; }
     
     /// Shut everything down and remove our geometry and resources
     void cleanup(PlatformThreadInfo *threadInfo,ChangeSet &changes);
@@ -519,6 +644,9 @@ public:
     /// Check if a frame is in the process of loading
     bool isFrameLoading(const QuadTreeIdentifier &ident,const QuadFrameInfoRef &frame) const;
 
+    /// Importance of a tile we're tracking, 0 if we're not
+    double getTileImportance(const QuadTreeIdentifier &ident) const;
+
     /// Set the loader return ref for cancelling while parsing
     void setLoadReturnRef(const QuadTreeIdentifier &ident,
                           const QuadFrameInfoRef &frame,
@@ -547,6 +675,10 @@ public:
     // Run on the layer thread.  Merge the loaded tile into the data.
     virtual void mergeLoadedTile(PlatformThreadInfo *threadInfo,QuadLoaderReturn *loadReturn,ChangeSet &changes);
 
+    // Run on the layer thread.  Merge a burst of loaded tiles in one pass,
+    //  doing the work that covers all the tiles once at the end.
+    virtual void mergeLoadedTiles(PlatformThreadInfo *threadInfo,const std::vector<QuadLoaderReturn *> &loadReturns,ChangeSet &changes);
+
     ComponentManagerRef compManager;
 
 protected:
@@ -557,6 +689,8 @@ protected:
 
     mutable std::mutex statsLock;
     Stats stats;
+
+    TileLatencyStatsRef latencyStats;
     
     // Periodically generates the stats
     void makeStats();
@@ -570,7 +704,42 @@ protected:
     
     // Process whatever ops we batched up during the load phase
     virtual void processBatchOps(PlatformThreadInfo *threadInfo,QIFBatchOps *) = 0;
+
+    // Start low priority fetches for tiles we don't have yet, just to warm up the fetcher's cache.
+    // Nothing is loaded from these.  Up to the subclass, the default does nothing.
+    virtual void prefetchTiles(PlatformThreadInfo *threadInfo,const std::vector<QuadTreeNew::ImportantNode> &tiles) { }
+
+    // Priority for tiles waiting on an ancestor to load, behind everything else we need
+    int getWaitingPriority() const { return std::max(std::max(topPriority,nearFramePriority),std::max(restPriority,0)) + 1; }
+
+    // Priority for fetch-ahead requests, behind anything we actually need
+    int getPrefetchPriority() const { return getWaitingPriority() + 1; }
+
+    // True if an ancestor is still loading the given frame and there's nothing to draw in the mean time
+    bool isAncestorLoading(const QuadTreeNew::Node &ident,int frame) const;
+
+    // Look for a texture for the tile's frame, either its own or one from an ancestor
+    // texNode comes back as the tile the textures belong to
+    bool findFrameTexture(const QuadTreeNew::Node &ident,int frame,
+                          std::vector<SimpleIdentity> &texIDs,QuadTreeNew::Node &texNode) const;
         
+    // True if we're only keeping some of the frames loaded
+    bool usingFrameWindow() const { return mode == MultiFrame && !compositeFrames && !terrain && frameWindow > 0 && frameWindow < getNumFrames(); }
+
+    // Work out which frames belong in the window for the current positions
+    std::vector<bool> calcFrameWindow() const;
+
+    // Steps from a focus to the given frame, in the direction the animation is going, wrapping around
+    int frameStepsAhead(int frame,int focusID) const;
+
+    // Load the frames that moved into the window, unload the ones that left it
+    // Returns true if anything changed
+    bool updateFrameWindow(PlatformThreadInfo *threadInfo,ChangeSet &changes);
+
+    // Start fetching the given frame for a tile, or everything in the window if there's no frame
+    void startTileFetching(PlatformThreadInfo *threadInfo,const QIFTileAssetRef &tile,const QuadFrameInfoRef &frame,
+                           QIFBatchOps *batchOps,ChangeSet &changes);
+
     virtual void removeTile(PlatformThreadInfo *threadInfo,const QuadTreeNew::Node &ident, QIFBatchOps *batchOps, ChangeSet &changes);
     QIFTileAssetRef addNewTile(PlatformThreadInfo *threadInfo,const QuadTreeNew::ImportantNode &ident,QIFBatchOps *batchOps,ChangeSet &changes);
     
@@ -585,9 +754,18 @@ protected:
 
     // Set if we require the top tiles to be loaded before we'll display a frame
     bool requiringTopTilesLoaded;
+
+    // Draw loading tiles with ancestor textures, skipping levels if need be
+    bool parentPlaceholders = false;
+    // Set if the app picked parentPlaceholders, so fast startup leaves it alone
+    bool parentPlaceholdersSet = false;
+
+    // Mesh samples for warping images to the display, 0 for off
+    int reprojectSamples = 0;
     
     TextureType texType;
     int texSize,borderSize;
+    bool asyncTexUpload = false;
 
     // Number of focus points (1 by default)
     int numFocus;
@@ -597,6 +775,21 @@ protected:
 
     // One per focus point
     std::vector<double> curFrames;
+    // Which way each focus was last moving, 1 forward, -1 back, 0 if we don't know yet
+    std::vector<int> frameDirs;
+
+    // Frames we keep resident in multi-frame mode.  0 for all of them.
+    int frameWindow = 0;
+    // Frames currently in the window
+    std::vector<bool> frameWindowState;
+
+    // Frames are layered together rather than animated
+    bool compositeFrames = false;
+
+    // Second frame is elevation for the first
+    bool terrain = false;
+    ElevationEncoding elevEncoding = ElevEncodeTerrarium;
+    double elevExaggeration = 1.0;
     
     bool flipY;
 
@@ -623,6 +816,16 @@ protected:
     
     // We number load requests so we can catch old ones after doing a reload
     int generation;
+
+    // Reload over what's showing rather than clearing it
+    bool reloadInPlace = false;
+
+    // Textures replaced by an in-place reload, removed once the render state stops using them
+    std::vector<SimpleIdentity> replacedTexIDs;
+
+    // Set while merging a burst of tiles, with priorities updated once it's done
+    bool mergingTiles = false;
+    bool prioritiesChanged = false;
     
     // Last target level set in quadBuilder:update: callback
     int targetLevel;
@@ -89,6 +89,13 @@ public:
                                      const Mbr &mbr,
                                      const ViewStateRef &viewState,
                                      const Point2f &frameSize) override;
+
+    /// Importance for a group of tiles, projected together
+    virtual void importanceForTiles(const std::vector<QuadTreeIdentifier> &idents,
+                                    const std::vector<Mbr> &mbrs,
+                                    const ViewStateRef &viewState,
+                                    const Point2f &frameSize,
+                                    std::vector<double> &imports) override;
     
     /// Called when the view state changes.  If you're caching info, do it here.
     virtual void newViewState(ViewStateRef viewState) override;
@@ -126,6 +133,13 @@ public:
     /// Quick loading status check
     virtual bool builderIsLoading() const override;
 
+    /// Pass tiles to fetch ahead on to the loaders
+    virtual void builderPrefetch(PlatformThreadInfo *threadInfo,QuadTileBuilder *inBuilder,
+                                 const WhirlyKit::QuadTreeNew::ImportantNodeSet &tiles) override;
+
+    /// Memory held by all the loaders together
+    virtual TileMemoryUsage builderMemoryUsage() const override;
+
 protected:
     bool debugMode = false;
 
@@ -139,6 +153,9 @@ protected:
 
     QuadTileBuilderRef builder;
     std::vector<QuadTileBuilderDelegateRef> builderDelegates;
+
+    // Display solids from earlier view updates
+    DisplaySolidCache solidCache;
     
     bool builderStarted = false;
     bool valid = true;
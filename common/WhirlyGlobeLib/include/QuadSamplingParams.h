@@ -66,6 +66,17 @@ public:
     
     /// If set, generate skirt geometry to hide the edges between levels
     bool edgeMatching;
+
+    /// If set, flat map tiles share one precomputed grid per tessellation
+    /// and are sized and placed by their transform instead
+    bool meshTemplates;
+
+    /// If set, tile geometry is raised to the heights the elevation manager has for it
+    bool includeElev;
+
+    /// If set, tiles are raised in the shader from elevation textures, as a terrain
+    /// frame loader does.  Flat maps get skirts as well and tiles use the z buffer.
+    bool elevTextures;
     
     /// Tesselation values per level for breaking down the coordinate system (e.g. globe)
     int tessX,tessY;
@@ -80,6 +91,15 @@ public:
     /// If set, we'll try to load a single level
     bool singleLevel;
 
+    /// If set, reuse tile importance from earlier view updates where the view
+    ///  hasn't moved enough to change the outcome
+    bool incrementalCoverage;
+    /// Memory (in bytes) for keeping the display solids used to evaluate tiles.
+    /// Zero turns the cache off.  This doesn't change the results, so it's not compared.
+    int displaySolidCacheSize;
+    /// If set, fetch ahead for the tiles an animation (e.g. momentum) is headed toward
+    bool predictivePrefetch;
+
     /// Scale the bounding boxes of tiles before we evaluate them
     double boundsScale;
     
@@ -104,6 +124,20 @@ public:
     void setImportanceLevel(double minImportance,int level);
     
     std::vector<double> importancePerLevel;
+
+    /**
+     Sample a single large image, cut into a tile pyramid, rather than the whole coordinate system.
+     
+     The image covers imageBounds (in coordSys) and is imageWidth by imageHeight pixels at full
+     resolution.  Level 0 is the whole image in one tile and each level below doubles it until
+     it's at full resolution.  The pyramid is anchored at the lower left and edge tiles are
+     padded out to tileSize, so the quad tree sticks out past the top and right of the image
+     and we clip it back to imageBounds.
+     
+     Returns false if the description doesn't make sense.
+     */
+    bool setupTiledImage(const CoordSystemRef &coordSys,const MbrD &imageBounds,
+                         int imageWidth,int imageHeight,int tileSize);
 };
 
     
@@ -95,6 +95,13 @@ public:
     
     /// Simple status check.  Is this builder in the process of loading something?
     virtual bool builderIsLoading() const = 0;
+
+    /// Tiles we're likely to need soon.  Start fetching them early if that makes sense.
+    virtual void builderPrefetch(PlatformThreadInfo *threadInfo,QuadTileBuilder *builder,
+                                 const WhirlyKit::QuadTreeNew::ImportantNodeSet &tiles) { }
+
+    /// Texture and other memory held for the tiles
+    virtual TileMemoryUsage builderMemoryUsage() const { return TileMemoryUsage(); }
 };
     
 typedef std::shared_ptr<QuadTileBuilderDelegate> QuadTileBuilderDelegateRef;
@@ -116,6 +123,10 @@ public:
 
     // Coordinate system we're building the tiles in
     CoordSystemRef getCoordSystem() const { return geomManage.coordSys; }
+
+    // Geometry manager and settings the tiles are built with
+    const TileGeomManager &getGeomManager() const { return geomManage; }
+    const TileGeomSettings &getGeomSettings() const { return geomSettings; }
     
     // If set, we'll actually build geometry for the drawables
     // The generic quad paging case doesn't use this
@@ -130,6 +141,18 @@ public:
     void setEdgeMatching(bool);
     bool getEdgeMatching() const;
 
+    // If set, flat tiles are built from template meshes
+    void setMeshTemplates(bool);
+    bool getMeshTemplates() const;
+
+    // If set, tile geometry takes its heights from the elevation manager
+    void setIncludeElev(bool);
+    bool getIncludeElev() const;
+
+    // If set, tiles are raised in the shader, so they want skirts everywhere
+    void setElevTextures(bool);
+    bool getElevTextures() const;
+
     // Set the draw priority values for produced tiles
     void setBaseDrawPriority(int);
     int getBaseDrawPriority() const;
@@ -172,6 +195,13 @@ protected:
     
     /// Called when a layer is shutting down (on the layer thread)
     virtual void quadLoaderShutdown(PlatformThreadInfo *threadInfo,ChangeSet &changes);
+
+    /// Pass tiles to fetch ahead on to the delegate
+    virtual void quadLoaderPrefetch(PlatformThreadInfo *threadInfo,
+                                    const WhirlyKit::QuadTreeNew::ImportantNodeSet &tiles);
+
+    /// Our geometry plus whatever the delegate is holding
+    virtual TileMemoryUsage quadLoaderMemoryUsage() const;
     
     bool debugMode;
     
@@ -19,7 +19,9 @@
  */
 
 #import "WhirlyVector.h"
+#import "FlatNodeSet.h"
 #import <set>
+#import <unordered_map>
 
 namespace WhirlyKit
 {
@@ -104,7 +106,7 @@ public:
         /// Level of detail, starting with 0 at the top (low)
         int level;
     };
-    typedef std::set<Node> NodeSet;
+    typedef FlatNodeSet<Node> NodeSet;
 
     // Node with an importance
     class ImportantNode : public Node
@@ -136,6 +138,26 @@ public:
                                                          int maxNodes,const std::vector<int> &levelLoads,
                                                          bool keepMinLevel,std::vector<double> &maxRejectedImport);
     
+    /// Work out what changed between the nodes we had and the new ones, ignoring importance.
+    /// Nodes in both go into toUpdate with their new importance.
+    static void diffNodes(const ImportantNodeSet &oldNodes,const ImportantNodeSet &newNodes,
+                          ImportantNodeSet &toAdd,ImportantNodeSet &toUpdate,NodeSet &toRemove);
+
+    /** In incremental mode we keep the importance values from earlier passes
+        and only ask for them again when the view has moved enough that a node
+        could have crossed its level's cutoff.  Importance values for the
+        others are approximate, which only affects ordering.
+        Off by default.
+      */
+    void setIncremental(bool newVal);
+    bool getIncremental() const { return incremental; }
+
+    /** Start a new evaluation pass, noting how far the view moved since the last one.
+        The delta is roughly the relative change in screen size we might see for
+        a tile.  0 means nothing moved, negative means start over.
+      */
+    void startCoveragePass(double viewDelta);
+
     // Generate a bounding box 
     MbrD generateMbrForNode(const Node &node) const;
     
@@ -143,6 +165,10 @@ public:
     // Filled in by the subclass
     virtual double importance(const Node &node) = 0;
     virtual bool visible(const Node &node) = 0;
+
+    /// Importance for a group of nodes, usually siblings.
+    /// Override this if you can do them faster together, the default does them one by one.
+    virtual void batchImportance(const std::vector<Node> &nodes,std::vector<double> &imports);
     
     // Recursively visit the quad tree evaluating as we go
     void evalNodeImportance(ImportantNode &node,const std::vector<double> &minImportance,
@@ -163,7 +189,28 @@ public:
     int minLevel,maxLevel;
 
 protected:
+    // Importance for a node, possibly from the cache.  The cutoff decides whether we can reuse it.
+    double nodeImportance(const Node &node,double minImport);
+    // Look for a usable importance in the cache
+    bool cachedImportance(const Node &node,double minImport,double &import);
+    // Fill in the importance for the children of a node all at once
+    void childImportance(ImportantNode *children,int numChildren,const std::vector<double> &minImportance);
+    // Evaluate a node that already has its importance and recurse from there
+    void evalImportantNode(const ImportantNode &node,const std::vector<double> &minImportance,
+                           ImportantNodeSet &importSet,std::vector<double> &maxRejectedImport);
+
     volatile bool shutdown = false;
+
+    // Importance from an earlier pass and how far the view has moved since
+    struct CachedImportance
+    {
+        double importance;
+        double drift;
+        unsigned int pass;
+    };
+    bool incremental = false;
+    unsigned int coveragePass = 0;
+    std::unordered_map<int64_t,CachedImportance> importCache;
 };
 
 }
@@ -36,6 +36,9 @@ public:
     virtual const unsigned char *getRawData() const = 0;
     // Length of the buffer
     virtual unsigned long getLen() const = 0;
+    // Hint that we're about to read through the whole thing.
+    // Only does anything for data that isn't in memory yet.
+    virtual void willRead() const { }
     
 protected:
 };
@@ -84,6 +87,10 @@ public:
     bool getDouble(double &val);
     // Read a string
     bool getString(std::string &str);
+    // Copy out the given number of bytes
+    bool getBytes(void *dest,size_t len);
+    // Pointer to the given number of bytes, advancing past them
+    const unsigned char *skipBytes(size_t len);
     
 protected:
     const RawData *rawData;
@@ -94,6 +101,59 @@ protected:
 // Caller responsible for deletion
 RawDataWrapper *RawDataFromFile(FILE *fp,unsigned int dataLen);
 
+// True if the data starts like a gzip or zlib stream
+bool RawDataIsCompressed(const void *data,size_t len);
+
+// Inflate gzip or zlib data into the output, which is resized to fit.
+// Gzip records the uncompressed size at the end, so that's usually a single allocation and no copies.
+// Pass in the same vector each time to reuse its memory.
+bool RawDataInflate(const void *data,size_t len,std::vector<unsigned char> &out);
+
+// Read only data backed by a memory mapped file.
+// The pages are shared with the file cache, so they're only read in as they're touched
+// and the system can drop them again under memory pressure.  Unmapped when the data goes away.
+class RawDataMapped : public RawData
+{
+public:
+    // How we expect to go through the data, passed on to the system as a hint
+    typedef enum {AccessNormal,AccessSequential,AccessRandom} Access;
+
+    // Map part of a file.  A length of 0 means the rest of it.  Null if we fail.
+    static std::shared_ptr<RawDataMapped> mapFile(const std::string &fileName,Access access = AccessNormal,
+                                                  size_t offset = 0,size_t len = 0);
+    RawDataMapped(const RawDataMapped &) = delete;
+    virtual ~RawDataMapped();
+
+    virtual const unsigned char *getRawData() const override { return data; }
+    virtual unsigned long getLen() const override { return len; }
+
+    // Start reading in the pages we'll need
+    virtual void willRead() const override;
+
+    // Change the access hint
+    void setAccess(Access access) const;
+
+    // Ask for part of the data to be read in ahead of time
+    void willNeed(size_t offset,size_t len) const;
+
+    // Let the system drop the pages.  They're read back in if touched.
+    void dontNeed() const;
+
+protected:
+    RawDataMapped(void *mapAddr,size_t mapLen,size_t pageOffset,size_t len);
+
+    void *mapAddr;
+    size_t mapLen;
+    // Where our data starts within the mapping, which has to begin on a page
+    const unsigned char *data;
+    size_t len;
+};
+typedef std::shared_ptr<RawDataMapped> RawDataMappedRef;
+
+// Map a whole file read-only, return null if we fail.
+// The pages are shared with the file cache and unmapped when the data goes away.
+RawDataRef RawDataFromMappedFile(const std::string &fileName);
+
 // You can add data to this one as needed
 class MutableRawData : public RawData
 {
@@ -117,6 +177,8 @@ public:
     virtual void addDouble(double dVal);
     // Add a string
     virtual void addString(const std::string &str);
+    // Add the bytes as-is
+    virtual void addBytes(const void *bytes,size_t len);
     
 protected:
     std::vector<unsigned char> data;
@@ -31,6 +31,25 @@ class SceneRenderer;
 // If we're doing mipmaps for the render target texture, how they're calculated
 typedef enum {RenderTargetMipmapNone,RenderTargetMimpapAverage,RenderTargetMipmapGauss} RenderTargetMipmapType;
 
+/** Histogram of the first channel of a render target, counted on the GPU.
+    The bins split [minVal,maxVal] evenly.  Values outside that range land in the end bins,
+    so every pixel is counted somewhere.
+  */
+struct RenderTargetHistogram
+{
+    float minVal = 0.0, maxVal = 0.0;
+    std::vector<uint32_t> bins;
+    /// Sum of the bins
+    uint64_t numPixels = 0;
+
+    /// Value below which the given fraction (0-1) of the pixels fall, interpolated within a bin
+    float percentile(double frac) const;
+
+    /// Mean, taking each pixel to be in the middle of its bin
+    float mean() const;
+};
+typedef std::shared_ptr<RenderTargetHistogram> RenderTargetHistogramRef;
+
 /** What and where we're rendering.  This can be a regular framebuffer
  to the screen or to a texture.
  */
@@ -55,6 +74,13 @@ public:
     
     /// Calculate the min/max values for a given render target every frame
     virtual void setCalcMinMax(bool newVal) { calcMinMax = newVal; }
+
+    /// Only draw into this target when something feeding it has changed, something in it is animating
+    /// or the view has moved.  Otherwise we keep what's there from the last time.
+    virtual void setRenderWhenChanged(bool newVal) { renderWhenChanged = newVal;  dirty = true; }
+
+    /// Something drawn into this target changed, so it'll be drawn again on the next frame
+    void markDirty() { dirty = true; }
     
     // Clear up resources from the render target (not clear the buffer)
     virtual void clear() = 0;
@@ -89,6 +115,9 @@ public:
 public:
     RenderTargetMipmapType mipmapType;
     bool calcMinMax;
+    bool renderWhenChanged;
+    // Set when the drawables feeding us change, cleared when we're drawn
+    bool dirty;
     virtual void init();
 };
 typedef std::shared_ptr<RenderTarget> RenderTargetRef;
@@ -105,7 +134,8 @@ public:
                        const RGBAColor &clearColor,
                        float clearVal,
                        RenderTargetMipmapType mipmapType,
-                       bool calcMinMax);
+                       bool calcMinMax,
+                       bool renderWhenChanged = true);
     
     /// Add the render target to the renderer
     void execute(Scene *scene,SceneRenderer *renderer,View *view);
@@ -120,6 +150,7 @@ protected:
     bool blend;
     RenderTargetMipmapType mipmapType;
     bool calcMinMax;
+    bool renderWhenChanged;
 };
 
 // Change details about a rendering target.  In this case, just texture.
@@ -42,6 +42,10 @@ public:
     // Pull in framebuffer info from the current OpenGL State
     bool initFromState(int inWidth,int inHeight);
 
+    /// Set up our own color and depth renderbuffers of the given size, to draw into and copy out of.
+    /// Needs ES 3 for the color format.
+    bool initOffscreen(int inWidth,int inHeight);
+
     /// Set up the target texture
     virtual bool setTargetTexture(SceneRenderer *renderer,Scene *scene,SimpleIdentity newTargetTexID);
 
@@ -20,6 +20,7 @@
 
 #import <vector>
 #import <set>
+#import <atomic>
 #import <unordered_map>
 #import "WhirlyVector.h"
 #import "Texture.h"
@@ -27,12 +28,13 @@
 #import "BasicDrawableInstance.h"
 #import "ActiveModel.h"
 #import "CoordSystem.h"
+#import "SlotMap.h"
+#import "MemoryGovernor.h"
+#import "MemoryLedger.h"
 
 namespace WhirlyKit
 {
 
-#define MaplyMaxZoomSlots 32
-    
 class SceneRenderer;
 class Scene;
 class SubTexture;
@@ -58,6 +60,15 @@ public:
     /// Create the texture on its native thread
     virtual void setupForRenderer(const RenderSetupInfo *setupInfo,Scene *scene);
 
+    /// Uploads can wait if we're over budget
+    virtual Priority getPriority() const override { return PriorityLow; }
+
+    /// Size of the texture data, if we know it
+    virtual size_t getUploadSize() const override;
+
+    /// The texture we're adding
+    virtual SimpleIdentity getTargetID() const override;
+
 	/// Add to the renderer.  Never call this.
 	void execute(Scene *scene,SceneRenderer *renderer,View *view);
 	
@@ -79,6 +90,12 @@ public:
 
     /// Remove from the renderer.  Never call this.
 	void execute(Scene *scene,SceneRenderer *renderer,View *view);
+
+    /// Removals go ahead of uploads
+    virtual Priority getPriority() const override { return PriorityHigh; }
+
+    /// The texture we're removing
+    virtual SimpleIdentity getTargetID() const override { return texture; }
 	
 protected:
 	SimpleIdentity texture;
@@ -101,6 +118,15 @@ public:
     /// Create the drawable on its native thread
     virtual void setupForRenderer(const RenderSetupInfo *,Scene *scene);
 
+    /// Uploads can wait if we're over budget
+    virtual Priority getPriority() const override { return PriorityLow; }
+
+    /// The drawable we're adding
+    virtual SimpleIdentity getTargetID() const override;
+
+    /// The drawable itself, until it's been added
+    const DrawableRef &getDrawable() const { return drawRef; }
+
 	/// Add to the renderer.  Never call this
 	void execute(Scene *scene,SceneRenderer *renderer,View *view);
 	
@@ -119,6 +145,12 @@ public:
 
     /// Remove the drawable.  Never call this
 	void execute(Scene *scene,SceneRenderer *renderer,View *view);
+
+    /// Removals go ahead of uploads
+    virtual Priority getPriority() const override { return PriorityHigh; }
+
+    /// The drawable we're removing
+    virtual SimpleIdentity getTargetID() const override { return drawID; }
 	
 protected:	
 	SimpleIdentity drawID;
@@ -207,7 +239,17 @@ protected:
     float zoomVal;
 };
         
-typedef std::unordered_map<SimpleIdentity,DrawableRef> DrawableRefSet;
+/** Clean up redundant changes before they're set up for rendering.
+    Drawables and textures added and then removed in the same set are dropped
+    along with anything done to them in between.  For changes that just set state
+    on a drawable (see ChangeRequest::getCoalesceSlot) only the last one is kept.
+    Timed changes are left alone.  Call this before setupForRenderer().
+    Returns the number of changes removed.
+  */
+int compactChanges(ChangeSet &changes);
+
+/// Drawables are kept packed together and found through handles
+typedef SlotMap<DrawableRef> DrawableRefSet;
 
 typedef std::map<SimpleIdentity,ProgramRef> ProgramSet;
 
@@ -275,14 +317,40 @@ public:
     void addChangeRequests(ChangeSet &newchanges);
     
     /// Process change requests
-    /// Only the renderer should call this in the rendering thread
-    int processChanges(View *view,SceneRenderer *renderer,TimeInterval now);
+    /// Only the renderer should call this in the rendering thread.
+    /// Pass sameFrame for a second call in one frame, so it gets what's left of the budget.
+    int processChanges(View *view,SceneRenderer *renderer,TimeInterval now,bool sameFrame = false);
     
     /// Some changes generate other changes, so they go first
     int preProcessChanges(View *view,SceneRenderer *renderer,TimeInterval now);
+
+    /** Run the active models for a frame.  Only the renderer should call this, in the rendering thread.
+        Their changes are collected in one set, compacted and run right here, so the
+        frame being set up reflects them.  Timed changes are queued up as usual.
+        Returns the number of changes run.
+      */
+    int runActiveModels(RendererFrameInfo *frameInfo);
+
+    /// Set a uniform block on a drawable now, rather than with a change request.
+    /// Meant for active models animating uniforms, so it's rendering thread only.
+    bool setUniBlock(SimpleIdentity drawID,const BasicDrawable::UniformBlock &uniBlock);
     
-    /// True if there are pending updates
+    /// True if there are pending updates.
+    /// Safe to call from any thread, it only looks at what the rendering thread last published.
     bool hasChanges(TimeInterval now) const;
+
+    /// Limit the amount of change processing done in a single call to processChanges.
+    /// Once either limit is hit, everything but high priority changes rolls over to the next frame.
+    /// Zero means no limit, which is the default.  Safe to call from any thread.
+    void setChangeBudget(TimeInterval maxTime,size_t maxBytes);
+    TimeInterval getChangeTimeBudget() const { return changeTimeBudget; }
+    size_t getChangeByteBudget() const { return changeByteBudget; }
+
+    /// Number of changes held back by the budget in the last processChanges
+    int getNumDeferredChanges() const { return numDeferredChanges; }
+
+    /// Bytes of data handed over by changes since the last call
+    size_t takeUploadBytes() { const size_t ret = uploadBytes; uploadBytes = 0; return ret; }
     
     /// Add sub texture mappings.
     /// These are mappings from images to parts of texture atlases.
@@ -300,6 +368,18 @@ public:
     /// Return a sub texture by ID.  The idea being we can use these
     ///  the same way we use full texture IDs.
     SubTexture getSubTexture(SimpleIdentity subTexId) const;
+
+    /// Look for a texture (or sub texture) already holding an image with the given content
+    /// hash, from Texture::getContentHash.  If there is one, it picks up another reference.
+    /// This lets markers, icons and the like share one copy of an image.  Layer side only.
+    SimpleIdentity retainSharedImage(uint64_t contentHash);
+
+    /// Note that a texture (or sub texture) holds an image with the given content, with one reference
+    void addSharedImage(uint64_t contentHash,SimpleIdentity texID);
+
+    /// Drop a reference to a shared image.  Returns true if that was the last one
+    /// (or it was never shared), in which case the caller removes the texture.
+    bool releaseSharedImage(SimpleIdentity texID);
     
     /// Add a drawable to the scene.
     /// A subclass can override this to control how this interacts with cullabes.
@@ -309,17 +389,33 @@ public:
     /// Look for a Drawable by ID
     DrawableRef getDrawable(SimpleIdentity drawId) const;
 
+    /// Return the slot handle for a drawable, which is faster to look up than the ID
+    SlotHandle getDrawableHandle(SimpleIdentity drawId) const;
+
+    /// Look for a Drawable by its slot handle.  Stale handles return nothing.
+    DrawableRef getDrawableByHandle(SlotHandle handle) const;
+
     /// Remove a drawable from the scene
     virtual void remDrawable(const DrawableRef &drawable);
 
     /// Remove a drawable from the scene
     virtual void remDrawable(SimpleIdentity id);
 
+    /// Look for the drawable another one was merged into, if it was
+    DrawableRef getMergedDrawable(SimpleIdentity drawId) const;
+
+    /// Forget a drawable that was merged into another, once it's been removed
+    void remMergedDrawable(SimpleIdentity drawId);
+
     /// Add a fully formed texture
     virtual void addTexture(TextureBaseRef texRef);
     
     /// Look for a Texture by ID
     TextureBaseRef getTexture(SimpleIdentity texId) const;
+
+    /// Point every ID that finds the old texture at the new one instead and return those IDs.
+    /// Removing one of those IDs later only drops the entry.
+    std::vector<SimpleIdentity> redirectTexture(const TextureBaseRef &oldTex,const TextureBaseRef &newTex);
     
     /// Remove a texture by ID.  Return true if it was there
     virtual bool removeTexture(SimpleIdentity texID);
@@ -403,7 +499,8 @@ public:
     
     /// Copy all the zoom slots into a destination array
     // dest must be at least MaplyMaxZoomSlots
-    void copyZoomSlots(float *dest) const;
+    /// Returns a mask with the bits set for the slots in use
+    uint32_t copyZoomSlots(float *dest) const;
 
     /// Copy all zoom slot values from the given scene object
     void copyZoomSlotsFrom(const Scene *otherScene, float offset = 0.0f);
@@ -428,15 +525,28 @@ public:
     std::vector<ActiveModelRef> &getActiveModels() { return activeModels; }
     const std::vector<ActiveModelRef> &getActiveModels() const { return activeModels; }
 
-    /// Return the number of change requests
+    /// Return the number of change requests.  Safe to call from any thread.
     int getNumChangeRequests() const;
 
+    /// Number of change sets handed to us since the last call.
+    /// The renderer uses this for performance reporting.
+    int getNumChangeBatches() { return changeQueue.takeBatchCount(); }
+
     /// Set up the font texture manager.  Don't call this yourself.
     void setFontTextureManager(const FontTextureManagerRef &newManager);
 
     /// Returns the font texture manager, which is thread safe
     FontTextureManagerRef getFontTextureManager() const { return fontTextureManager; }
 
+    /// Keeps track of memory use and trims it under pressure.  Thread safe.
+    MemoryGovernor &getMemoryGovernor() { return memoryGovernor; }
+
+    /// Bytes held by the drawables and textures in the scene, by owner and type.  Thread safe.
+    const MemoryLedger &getMemoryLedger() const { return memoryLedger; }
+
+    /// Respond to memory pressure by trimming up to the given level, and apply the results
+    void trimMemory(PlatformThreadInfo *inst,MemoryTrimLevel level);
+
 protected:
     /// Don't be calling this
     void setDisplayAdapter(CoordSystemDisplayAdapter *newCoordAdapter);
@@ -452,9 +562,13 @@ protected:
     /// All the active models
     std::vector<ActiveModelRef> activeModels;
     
-    /// All the drawables we've been handed, sorted by ID
+    /// All the drawables we've been handed, packed together
     mutable std::mutex drawablesLock;
     DrawableRefSet drawables;
+    /// Maps drawable IDs to their slots in the above
+    std::unordered_map<SimpleIdentity,SlotHandle> drawableHandles;
+    /// Drawables that were merged into others, and the ones they went to
+    std::unordered_map<SimpleIdentity,SimpleIdentity> mergedDrawIDs;
     
     typedef std::unordered_map<SimpleIdentity,TextureBaseRef> TextureRefSet;
     /// Textures, sorted by ID
@@ -463,16 +577,47 @@ protected:
     /// Mutex for accessing textures
     mutable std::mutex textureLock;
 
-    mutable std::mutex changeRequestLock;
-    /// We keep a list of change requests to execute
-    /// This can be accessed in multiple threads, so we lock it
+    /// Change requests come in from any thread through this queue.
+    /// It doesn't lock, so layer threads don't hold up the renderer.
+    ChangeRequestQueue changeQueue;
+    /// Change requests pulled from the queue, waiting to be executed.
+    /// Only the rendering thread touches these.
     ChangeSet changeRequests;
     SortedChangeSet timedChangeRequests;
+    /// Published copies of the above for other threads to poll
+    std::atomic<int> numPendingChanges = {0};
+    /// When the earliest timed change is due, zero for none
+    std::atomic<TimeInterval> nextTimedChange = {0.0};
+
+    /// Per-frame limits on change processing (zero for none).
+    /// Set from the platform side, read on the rendering thread.
+    std::atomic<TimeInterval> changeTimeBudget = {0.0};
+    std::atomic<size_t> changeByteBudget = {0};
+    /// Changes rolled over to the next frame in the last processChanges
+    int numDeferredChanges = 0;
+    /// Budget spent by processChanges so far this frame
+    TimeInterval frameChangeTime = 0.0;
+    size_t frameChangeBytes = 0;
+    /// Upload size of the changes executed since takeUploadBytes
+    size_t uploadBytes = 0;
+
+    /// Move everything waiting in the queue over to the render side lists.
+    /// Rendering thread only.
+    void pullChangeRequests();
+
+    /// Update the published counts after changing the render side lists.
+    /// Rendering thread only.
+    void publishPendingChanges();
 
         mutable std::mutex subTexLock;
     typedef std::set<SubTexture> SubTextureSet;
     /// Mappings from images to parts of texture atlases
     SubTextureSet subTextureMap;
+
+    /// Textures shared by content hash, with their reference counts
+    mutable std::mutex sharedImageLock;
+    std::unordered_map<uint64_t,std::pair<SimpleIdentity,int> > sharedImages;
+    std::unordered_map<SimpleIdentity,uint64_t> sharedImageHashes;
     
     /// Lock for accessing managers
     mutable std::mutex managerLock;
@@ -503,6 +648,9 @@ protected:
     // The font texture manager is created at startup
     FontTextureManagerRef fontTextureManager;
 
+    MemoryGovernor memoryGovernor;
+    MemoryLedger memoryLedger;
+
     SceneRenderer* renderer;
 };
 
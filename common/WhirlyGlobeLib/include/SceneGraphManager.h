@@ -20,6 +20,8 @@
 
 #import <math.h>
 #import <set>
+#import <atomic>
+#import <functional>
 #import "WhirlyVector.h"
 #import "Identifiable.h"
 #import "BasicDrawable.h"
@@ -104,6 +106,58 @@ public:
     WhirlyKit::Point3f center;
 };
 
+/** Level of detail node with its own geometry, kept out of core.
+    The geometry is built by a load function on the shared task scheduler once the node is
+    reached in a traversal, and may be thrown out again when the manager is over its memory budget.
+    The children replace this node's geometry once its screen space error calls for it,
+    but only when they've all loaded, so there are no holes.
+  */
+class SceneGraphPagedLOD : public SceneGraphGroup
+{
+public:
+    /// Builds the drawables for the node on a worker thread, so it mustn't touch the scene.
+    /// Return false if it couldn't, in which case the node stays empty.
+    typedef std::function<bool(std::vector<BasicDrawableRef> &draws)> LoadFunc;
+
+    /// No load function is fine for a node that's just there to hold its children
+    SceneGraphPagedLOD(LoadFunc loadFn,const Point3f &center,float radius,float geomError);
+    virtual ~SceneGraphPagedLOD();
+
+    void traverseNodeDrawables(SceneGraphManager *manage,const Point3f &localPt,const std::set<SceneGraphNode *> &siblingNodes,SimpleIDSet &toDraw) override;
+    void traverseRemNodeIDs(SceneGraphManager *manage,SceneGraphNodeSet &allNodes,ChangeSet &changes) override;
+
+    /// Set once the geometry is in and can be drawn
+    bool isLoaded() const { return state == Loaded; }
+
+    /// Bounding sphere
+    WhirlyKit::Point3f center;
+    float radius;
+    /// How far off this node's geometry is from the real thing, in display units
+    float geomError;
+
+protected:
+    friend class SceneGraphManager;
+
+    enum State { Unloaded, Loading, Loaded };
+
+    // Shared with the task, so the node can go away while it's out
+    struct LoadState
+    {
+        volatile bool cancel = false;
+        std::atomic<bool> done { false };
+        bool success = false;
+        std::vector<BasicDrawableRef> draws;
+    };
+
+    LoadFunc loadFn;
+    State state;
+    std::shared_ptr<LoadState> load;
+    SimpleIDSet drawIDs;
+    size_t memSize;
+    // Traversal this node was last reached in
+    int lastUsed;
+};
+
 // Manages a scene graph
 class SceneGraphManager : DelayedDeletable
 {
@@ -124,8 +178,27 @@ public:
     void removeDrawable(SimpleIdentity drawID,ChangeSet &changes);
     
     /// Run the position calculations and update what we'll display.
+    /// This also picks up finished loads for paged nodes and evicts any over the budget.
     /// The changes need to be flushed by the caller
-    void update(ViewStateRef viewState,ChangeSet &changes);
+    void update(ViewStateRef viewState,const Point2f &frameSize,ChangeSet &changes);
+
+    /// Paged nodes with more screen space error than this (in pixels) are replaced by their children
+    void setMaxScreenError(float error) { maxScreenError = error; }
+    float getMaxScreenError() const { return maxScreenError; }
+
+    /// Rough limit on the memory for paged geometry, in bytes.
+    /// Over this, nodes not used in the last update are evicted, oldest first.
+    void setMemoryBudget(size_t bytes) { memoryBudget = bytes; }
+    size_t getMemoryUsed() const { return memoryUsed; }
+
+    /// Screen space error, in pixels, for geometry with the given error and bounds
+    float screenError(const Point3f &center,float radius,float geomError,const Point3f &localPt) const;
+
+    /// Start loading a paged node, if it isn't already.  Higher priorities go first.
+    void requestLoad(SceneGraphPagedLOD *node,double priority);
+
+    /// Count of updates so far
+    int getFrame() const { return frame; }
     
     /// Print out stats for debugging
     void dumpStats();
@@ -142,6 +215,24 @@ protected:
     
     // Drawables that are currently being drawn
     SimpleIDSet activeDrawIDs;    
+
+    // Hand the geometry over for loads that have finished
+    void checkLoads(ChangeSet &changes);
+    // Get rid of a paged node's geometry, or its load
+    void unloadNode(SceneGraphPagedLOD *node,ChangeSet &changes);
+    // Throw out the least recently used geometry until we're under budget
+    void evictNodes(ChangeSet &changes);
+
+    friend class SceneGraphPagedLOD;
+
+    std::set<SceneGraphPagedLOD *> loadingNodes;
+    std::set<SceneGraphPagedLOD *> loadedNodes;
+    float maxScreenError = 16.0;
+    size_t memoryBudget = 256 * 1024 * 1024;
+    size_t memoryUsed = 0;
+    // Pixels covered by one display unit at a distance of one
+    float pixelScale = 1.0;
+    int frame = 0;
 };
 
 }
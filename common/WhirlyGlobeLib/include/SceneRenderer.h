@@ -20,8 +20,14 @@
 #import "WhirlyKitView.h"
 #import "Scene.h"
 #import "PerformanceTimer.h"
+#import "FrameStats.h"
+#import "GPUTimings.h"
+#import "FramePacer.h"
+#import "DynamicResolution.h"
 #import "Lighting.h"
 #import "RenderTarget.h"
+#import "WorkerPool.h"
+#import "DrawableTimeIndex.h"
 
 namespace WhirlyKit
 {
@@ -92,6 +98,12 @@ struct RendererFrameInfo
     Eigen::Vector3d dispCenter;
     /// Height above surface, if that makes sense
     float heightAboveSurface = 0.0f;
+    /// What the globe hides from the eye.  Turned off for flat maps.
+    HorizonCuller horizon;
+    /// Zoom slot values, copied from the scene once the frame's changes are in
+    float zoomSlots[MaplyMaxZoomSlots] = {};
+    /// Bits for the zoom slots in use.  Drawables compare against their ZoomSlotMask().
+    uint32_t zoomSlotMask = 0;
     /// Screen size in display coordinates
     Point2d screenSizeInDisplayCoords;
     /// Lights, if applicable
@@ -113,7 +125,9 @@ class RenderTargetContainer
 public:
     virtual ~RenderTargetContainer() { }
     
-    // Sort by draw priority and zbuffer on or off
+    // Sort by draw priority and zbuffer on or off.
+    // Within those, z buffered drawables are grouped by pipeline (program and vertex layout).
+    // Textures can change while a drawable is in the set, so they can't be part of this.
     typedef struct PrioritySorter {
         bool operator () (const DrawableRef &a,const DrawableRef &b) const {
             const auto orderA = a->getDrawOrder();
@@ -124,7 +138,14 @@ public:
                 if (priorityA == priorityB) {
                     const bool bufferA = a->getRequestZBuffer();
                     const bool bufferB = b->getRequestZBuffer();
-                    return (bufferA == bufferB) ? (a->getId() < b->getId()) : !bufferA;
+                    if (bufferA != bufferB)
+                        return !bufferA;
+                    if (bufferA) {
+                        const int stateOrder = Drawable::compareDrawState(*a,*b,false);
+                        if (stateOrder != 0)
+                            return stateOrder < 0;
+                    }
+                    return a->getId() < b->getId();
                 }
                 return priorityA < priorityB;
             }
@@ -194,6 +215,13 @@ public:
     /// Set the render until time.  This is used by things like fade to keep
     ///  the rendering optimization from cutting off animation.
     virtual void setRenderUntil(TimeInterval newTime);
+
+    /** Jump to a time, for playing back time enabled data.
+        Drawables with an enable time range come and go for this time from the next frame on.
+        Everything else that runs on time (fades, animation) sees it too.
+        Pass zero to go back to the system clock.
+      */
+    virtual void scrubToTime(TimeInterval when);
     
     /// A drawable wants continuous rendering (bleah!)
     virtual void addContinuousRenderRequest(SimpleIdentity drawID);
@@ -213,6 +241,10 @@ public:
     
     /// Return true if we have changes to process or display
     virtual bool hasChanges();
+
+    /// Return true if the platform view should render a frame now.
+    /// This looks at what's changed and hands it to the frame pacer to decide.
+    virtual bool shouldRenderFrame();
     
     /// Use this to set the clear color for the screen.  Defaults to black
     virtual void setClearColor(const RGBAColor &color);
@@ -262,6 +294,27 @@ public:
     
     /// Set the performance counting interval (0 is off)
     virtual void setPerfInterval(int howLong);
+
+    /// Per-frame stats history.  Enable it to start recording.
+    FrameStats &getFrameStats() { return frameStats; }
+
+    /// GPU time per work group, for renderers that can measure it.  Enable it to start recording.
+    GPUTimings &getGPUTimings() { return gpuTimings; }
+
+    /// Startup phases, through to the first frame with something in it
+    StartupTimeline &getStartupTimeline() { return startupTimeline; }
+
+    /// Opt in to the fast startup path.  Set before the loaders start.
+    /// Image loaders then draw the low levels they've got in place of tiles still loading,
+    ///  and the platforms do what setup they can in parallel.  Off by default.
+    void setFastStartup(bool newVal) { fastStartup = newVal; }
+    bool getFastStartup() const { return fastStartup; }
+
+    /// Frame rate policy, shared by the platform views
+    FramePacer &getFramePacer() { return framePacer; }
+
+    /// Scaling of the map resolution under load, see DynamicResolution
+    DynamicResolution &getDynamicResolution() { return dynamicRes; }
     
     /// If set, we'll use the view changes to trigger rendering
     virtual void setUseViewChanged(bool newVal);
@@ -278,15 +331,56 @@ public:
 
     /// Move things around as required by outside updates
     virtual void updateWorkGroups(RendererFrameInfo *frameInfo);
+
+    /// True if the screen work group has any drawables in it
+    bool hasScreenDrawables() const;
+
+    /// Mark the first frame and the first one that drew something
+    void noteStartupFrame(bool drewSomething);
+
+    /// Number of extra threads used to check drawable visibility in updateWorkGroups.
+    /// Zero does it all on the render thread.  Defaults to a few, based on the core count.
+    virtual void setCullingThreads(int numThreads);
+    int getCullingThreads() const { return numCullThreads; }
         
     /// Add a render target to start rendering too
     virtual void addRenderTarget(RenderTargetRef newTarget);
+
+    /// Draw all the targets that only draw when they change on the next frame
+    void markRenderTargetsDirty();
     
     /// Stop rendering to the matching render target
     virtual void removeRenderTarget(SimpleIdentity targetID);
     
     /// Called before we present the render buffer.  Can do snapshot logic here.
     virtual void snapshotCallback(TimeInterval now) { };
+
+    /// Copy a region out of the given render target.
+    /// Some renderers can only do this on the rendering thread.
+    virtual RawDataRef getSnapshotAt(SimpleIdentity renderTargetID,int x,int y,int width,int height) { return RawDataRef(); }
+
+    /// Gets the pixels from a readback, or an empty ref if it couldn't be done
+    typedef std::function<void(RawDataRef)> ReadbackCallback;
+
+    /** Copy a region out of the given render target without waiting on the GPU.
+        The copy goes in with the next frame and the callback runs once the data is back,
+        usually a frame or two later, on the rendering thread or one of the renderer's own.
+        Width or height of 0 means the whole target.  Can be called from any thread.
+      */
+    void addReadback(SimpleIdentity renderTargetID,int x,int y,int width,int height,ReadbackCallback callback);
+
+    /// Same as addReadback, but for the min/max values of a target with calcMinMax set
+    void addMinMaxReadback(SimpleIdentity renderTargetID,ReadbackCallback callback);
+
+    /// Gets the histogram, or an empty ref if it couldn't be done
+    typedef std::function<void(RenderTargetHistogramRef)> HistogramCallback;
+
+    /** Count the first channel of a render target into numBins bins covering [minVal,maxVal].
+        The counting happens on the GPU with the next frame and the callback runs once it's done,
+        the same way as addReadback.  Only the bins come back, not the pixels.
+        Not every renderer can do this.  Those that can't hand back an empty ref.
+      */
+    void addHistogramReadback(SimpleIdentity renderTargetID,int numBins,float minVal,float maxVal,HistogramCallback callback);
     
     /// Add a light to the existing set
     virtual void addLight(const DirectionalLight &light);
@@ -327,6 +421,9 @@ public:
     
     /// Construct a renderer-specific dynamic texture
     virtual DynamicTextureRef makeDynamicTexture(const std::string &name) const = 0;
+
+    /// Construct a blank renderer-specific texture of the given size, suitable for a render target to draw into
+    virtual Texture *makeRenderTexture(const std::string &name,int width,int height,TextureType type) const = 0;
     
     /// Maps name IDs to slots (slots are just used by Metal)
     virtual int getSlotForNameID(SimpleIdentity nameID);
@@ -441,11 +538,88 @@ protected:
     /// Scale, to reflect the device's screen
     float scale;
 
+    /// Recent frames, when enabled
+    FrameStats frameStats;
+
+    /// GPU side of recent frames, when enabled
+    GPUTimings gpuTimings;
+
+    /// Startup phases the controller and renderer have recorded
+    StartupTimeline startupTimeline;
+
+    /// Set for the fast startup path
+    bool fastStartup = false;
+
+    /// Decides which frames we render
+    FramePacer framePacer;
+
+    /// Resolution we draw the map at while moving
+    DynamicResolution dynamicRes;
+
+    /// Set by viewDidChange if the view itself moved, rather than something asking for a draw
+    bool viewMoved = false;
+
+    struct ReadbackRequest
+    {
+        SimpleIdentity targetID;
+        int x,y,width,height;
+        bool minMax;
+        ReadbackCallback callback;
+    };
+
+    struct HistogramRequest
+    {
+        SimpleIdentity targetID;
+        int numBins;
+        float minVal,maxVal;
+        HistogramCallback callback;
+    };
+
+    /** True if the target has to be drawn this frame.  False for an offscreen target with nothing new.
+        Targets are drawn if their contents changed, the view changed or something in them animates.
+        The screen is always drawn.
+      */
+    bool renderTargetNeedsDraw(const RenderTarget *renderTarget) const;
+
+    // Something drawn into the target runs tweakers or asked for continuous rendering
+    bool renderTargetIsAnimating(const RenderTarget *renderTarget) const;
+
+    // Take the readbacks that came in since the last frame
+    std::vector<ReadbackRequest> takeReadbacks();
+    std::vector<HistogramRequest> takeHistograms();
+
+    // True if we've got readbacks to start or finish, which means more frames
+    virtual bool hasReadbacks();
+
+    // Tell anyone still waiting that they're not getting anything
+    void cancelReadbacks();
+
+    std::mutex readbackLock;
+    std::vector<ReadbackRequest> readbackRequests;
+    std::vector<HistogramRequest> histogramRequests;
+
     std::vector<RenderTargetRef> renderTargets;
     std::vector<WorkGroupRef> workGroups;
 
-    // Drawables that we currently know about, but are off
-    std::set<DrawableRef> offDrawables;
+    // Drawables that we currently know about, but are off.
+    // Packed together since we check them all every frame.
+    SlotMap<DrawableRef> offDrawables;
+
+    // Add to or remove from the off drawables, using the slot stored in the drawable
+    void addOffDrawable(const DrawableRef &draw);
+    void removeOffDrawable(const DrawableRef &draw);
+
+    // Off drawables that are outside their enable time range, so we don't check them every frame
+    DrawableTimeIndex timeIndex;
+
+    // Evaluate isOn() for cullDrawables into cullResults, in parallel if it's worth it
+    void evalCullDrawables(RendererFrameInfo *frameInfo);
+
+    int numCullThreads = 0;
+    std::unique_ptr<WorkerPool> cullWorkers;
+    // Scratch space for updateWorkGroups
+    std::vector<char> cullResults;
+    std::vector<Drawable *> cullDrawables;
 };
 
 typedef std::shared_ptr<SceneRenderer> SceneRendererRef;
@@ -16,6 +16,7 @@
  *  limitations under the License.
  */
 
+#import <deque>
 #import "UtilsGLES.h"
 
 #import "WhirlyVector.h"
@@ -26,10 +27,13 @@
 #import "SceneRenderer.h"
 #import "ProgramGLES.h"
 #import "MemManagerGLES.h"
+#import "StateCacheGLES.h"
+#import "TransformMath.h"
 
 namespace WhirlyKit
 {
 class SceneRendererGLES;
+class RenderTargetGLES;
 
 /** Renderer Frame Info.
  Data about the current frame, passed around by the renderer.
@@ -38,9 +42,57 @@ struct RendererFrameInfoGLES : public RendererFrameInfo
 {
     /// Renderer version (e.g. OpenGL ES 1 vs 2)
     int glesVersion = 0;
+    /// State shared across the drawables for this frame
+    StateCacheGLES *stateCache = nullptr;
+    /// On a wrapped map, the matrices for the other copies of the world.
+    /// Only set for drawables that draw those copies themselves.
+    const DrawMatrices *copyMats = nullptr;
+    unsigned int numCopyMats = 0;
 };
 using RendererFrameInfoGLESRef = std::shared_ptr<RendererFrameInfoGLES>;
 
+/** Drawables and textures removed during a frame are held here and torn down
+    together once the GPU is through with the frames that might have drawn them.
+    Each frame is an epoch.  With ES 3 a fence goes in at the end of the frame and its
+    batch goes when the fence has passed.  Without fences we wait a fixed number of frames.
+    This all happens on the rendering thread, so there's no locking.
+  */
+class RenderTeardownInfoGLES : public RenderTeardownInfo
+{
+public:
+    RenderTeardownInfoGLES(bool useFences);
+    virtual ~RenderTeardownInfoGLES();
+
+    /// Hold on to the texture until its epoch is done
+    virtual void destroyTexture(SceneRenderer *renderer,const TextureBaseRef &tex) override;
+    /// Hold on to the drawable until its epoch is done
+    virtual void destroyDrawable(SceneRenderer *renderer,const DrawableRef &draw) override;
+
+    /// Close out this frame's epoch and tear down the ones the GPU has finished with
+    void endFrame(SceneRenderer *renderer);
+
+    /// Tear down everything now, done or not
+    void flush(SceneRenderer *renderer);
+
+protected:
+    struct Epoch
+    {
+        std::vector<DrawableRef> drawables;
+        std::vector<TextureBaseRef> textures;
+        GLsync fence = nullptr;
+    };
+
+    void release(SceneRenderer *renderer,Epoch &epoch);
+
+    // Frames to wait without fences.  Enough to cover a triple buffered driver.
+    static constexpr size_t MaxEpochs = 3;
+
+    bool useFences;
+    Epoch current;
+    // Oldest first
+    std::deque<Epoch> retired;
+};
+
 class WorkGroupGLES : public WorkGroup
 {
 public:
@@ -112,6 +164,9 @@ public:
     /// Construct a renderer-specific dynamic texture
     virtual DynamicTextureRef makeDynamicTexture(const std::string &name) const override;
 
+    /// Construct a blank texture for a render target to draw into
+    virtual Texture *makeRenderTexture(const std::string &name,int width,int height,TextureType type) const override;
+
     /** Return the snapshot for the given render target.
      *  EmptyIdentity refers to the whole
      *  width <= 0 means the whole screen.
@@ -128,12 +183,63 @@ public:
     
     // Information about the renderer passed around to various calls
     RenderSetupInfoGLES setupInfo;
+
+    // GL state as of the last draw, so we can skip redundant calls
+    StateCacheGLES stateCache;
     
     // If set we draw one extra frame after updates stop
     bool extraFrameMode;
     int extraFrameCount;
 
+    // Where the map goes when we're drawing it at less than full resolution
+    std::shared_ptr<RenderTargetGLES> scaledTarget;
+
     RendererFrameInfoGLESRef lastFrameInfo;
+
+protected:
+    // A readback copying into a pixel buffer while we wait on the GPU
+    struct ReadbackGLES
+    {
+        GLuint pboId;
+        GLsync fence;
+        size_t len;
+        ReadbackCallback callback;
+    };
+
+    // Start copies for the readbacks asked for since the last frame
+    void startReadbacks();
+    // Hand back the ones the GPU is done with
+    void finishReadbacks();
+
+    virtual bool hasReadbacks() override;
+
+    std::vector<ReadbackGLES> activeReadbacks;
+
+    // Timer queries for one frame, one for each phase that ran
+    struct GPUQueriesGLES
+    {
+        GLuint queries[GPUTimings::Total] = {0};
+        bool active[GPUTimings::Total] = {false};
+        bool pending = false;
+        // Dynamic resolution only counts frames drawn while the view moved
+        bool moving = false;
+    };
+
+    // Pick up finished results and take a query slot for this frame, if one is free
+    void startGPUQueries();
+    // Stop timing whatever's running and start on the given phase.  Total just stops.
+    void timeGPUPhase(GPUTimings::Phase phase);
+    // Hand the slot off to wait for its results
+    void endGPUQueries();
+    // Pass along any frames the GPU has finished with, to the timings and dynamic resolution
+    void finishGPUQueries();
+
+    // Results come back a frame or two late, so we cycle through a few
+    static constexpr int NumGPUQueryFrames = 3;
+    GPUQueriesGLES gpuQueries[NumGPUQueryFrames];
+    int gpuQueryNext = 0;
+    int gpuQuerySlot = -1;
+    GPUTimings::Phase gpuQueryPhase = GPUTimings::Total;
 };
     
 typedef std::shared_ptr<SceneRendererGLES> SceneRendererGLESRef;
@@ -27,6 +27,9 @@
 #import "GlobeMath.h"
 #import "QuadTreeNew.h"
 #import "SceneRenderer.h"
+#import <list>
+#import <mutex>
+#import <unordered_map>
 
 
 namespace WhirlyKit
@@ -49,13 +52,16 @@ public:
                  const CoordSystem *,const CoordSystemDisplayAdapter *);
     
     /// Returns true if the given point (in display space) is inside the volume
-    bool isInside(const Point3d &pt);
+    bool isInside(const Point3d &pt) const;
     
     /// Calculate the importance for this display solid given the user's eye position
     double importanceForViewState(ViewState *viewState,const Point2f &frameSize);
     
     /// See if this display solid is current in the viewing frustum
     bool isOnScreenForViewState(ViewState *viewState,const Point2f &frameSize);
+
+    /// Rough number of bytes this takes up
+    size_t getMemoryUsage() const;
     
     /// Set by the constructor
     bool valid;
@@ -72,6 +78,50 @@ public:
     
 typedef std::shared_ptr<DisplaySolid> DisplaySolidRef;
 
+/** Keeps the display solids for recently evaluated tiles.
+    A solid only depends on the tile and the coordinate systems, not the view,
+    so one that's been built can be used on every view update after.
+    Least recently used solids are tossed once we go over the memory limit.
+    Assumes one source and display coordinate system per cache.
+  */
+class DisplaySolidCache
+{
+public:
+    /// Zero disables caching
+    DisplaySolidCache(size_t maxBytes = 0);
+
+    /// Change the memory limit, dropping solids if need be.
+    void setMaxBytes(size_t maxBytes);
+    size_t getMaxBytes() const { return maxBytes; }
+
+    /// Return the solid for a tile, building it if it's not in the cache
+    DisplaySolidRef getSolid(const QuadTreeIdentifier &ident,const Mbr &mbr,
+                             const CoordSystem *srcSystem,const CoordSystemDisplayAdapter *coordAdapter);
+
+    /// Toss everything
+    void clear();
+
+    /// Memory in use, number of solids, and lookups that did or didn't find one
+    void getStats(size_t &bytes,size_t &entries,size_t &hits,size_t &misses) const;
+
+protected:
+    void trim();
+
+    struct Entry
+    {
+        int64_t key;
+        DisplaySolidRef solid;
+        size_t size;
+    };
+
+    mutable std::mutex lock;
+    size_t maxBytes;
+    size_t curBytes = 0;
+    size_t hits = 0, misses = 0;
+    std::list<Entry> lru;
+    std::unordered_map<int64_t,std::list<Entry>::iterator> entries;
+};
+
 /// Check if any part of the given tile is on screen
 bool TileIsOnScreen(WhirlyKit::ViewState *viewState,const WhirlyKit::Point2f &frameSize,WhirlyKit::CoordSystem *srcSystem,WhirlyKit::CoordSystemDisplayAdapter *coordAdapter,const WhirlyKit::Mbr &nodeMbr,const QuadTreeIdentifier &nodeIdent,DisplaySolidRef &dispSold);
 
@@ -85,4 +135,11 @@ double ScreenImportance(WhirlyKit::ViewState *viewState,const WhirlyKit::Point2f
 /// This version takes a min/max height and is optimized for volumes.
 double ScreenImportance(WhirlyKit::ViewState *viewState,const WhirlyKit::Point2f &frameSize,int pixelsSquare,WhirlyKit::CoordSystem *srcSystem,WhirlyKit::CoordSystemDisplayAdapter *coordAdapter,const WhirlyKit::Mbr &nodeMbr, double minZ,double maxZ, const QuadTreeIdentifier &nodeIdent,DisplaySolidRef &dispSold);
 
+/// Calculate the screen importance for a group of tiles at once.
+/// Same result as the single tile version, but the corners of all the tiles
+///  are projected together, which is a good deal faster for siblings.
+void ScreenImportance(WhirlyKit::ViewState *viewState,const WhirlyKit::Point2f &frameSize,int pixelsSquare,WhirlyKit::CoordSystem *srcSystem,WhirlyKit::CoordSystemDisplayAdapter *coordAdapter,const std::vector<QuadTreeIdentifier> &nodeIdents,const std::vector<WhirlyKit::Mbr> &nodeMbrs,std::vector<double> &imports);
+/// Batched version for display solids you already have.  Null or invalid solids get zero.
+void ScreenImportance(WhirlyKit::ViewState *viewState,const WhirlyKit::Point2f &frameSize,int pixelsSquare,const std::vector<DisplaySolidRef> &dispSolids,std::vector<double> &imports);
+
 }
@@ -20,6 +20,7 @@
 #import "BasicDrawable.h"
 #import "TextureAtlas.h"
 #import "ScreenSpaceDrawableBuilder.h"
+#import "BasicDrawableInstanceBuilder.h"
 #import "Scene.h"
 #import "BaseInfo.h"
 
@@ -123,6 +124,12 @@ public:
     /// Set the enable time range
     void setEnableRange(TimeInterval inStartEnable,TimeInterval inEndEnable);
 
+    /// Draw plain rectangles as instances of a shared quad, rather than as four vertices apiece.
+    /// This only covers what goes through addScreenObject and only comes out of flushChanges.
+    /// Turning it on looks up the screen space instance shaders, so it does nothing without them.
+    void setInstancing(bool enable);
+    bool getInstancing() const { return !instPrograms.empty(); }
+
     /// Add a single rectangle with no rotation
     void addRectangle(const Point3d &worldLoc,const Point2d *coords,
                       const TexCoord *texCoords,const RGBAColor &color,
@@ -144,22 +151,80 @@ public:
                           const std::vector<Eigen::Matrix3d> *places = nullptr,
                           SimpleIDUnorderedSet *drawIDs = nullptr);
 
-    /// Add a single screen space object
+    /// One rectangle drawn as an instance of the shared quad.
+    /// The quad's corners, (0,0) (1,0) (1,1) (0,1), pick out org + x*edgeX + y*edgeY
+    ///  on the screen (in pixels) and the same for the texture coordinates.
+    struct ScreenSpaceInstance
+    {
+        /// Fill in the screen and texture corners, if the geometry is a textured parallelogram
+        bool setCorners(const Point2dVector &coords,const std::vector<TexCoord> &texCoords,
+                        const Point2d &offset,float scale);
+
+        /// Pack it up the way the screen space instance shaders want it
+        BasicDrawableInstance::SingleInstance getInstance() const;
+
+        /// Relative to the drawable's center, as of its start time
+        Point3d center {0,0,0};
+        /// Motion per second, if the drawable moves
+        Point3d dir {0,0,0};
+        /// Up vector for rotated objects
+        Point3d rotVec {0,0,0};
+        Point2f org {0,0};
+        Point2f edgeX {0,0};
+        Point2f edgeY {0,0};
+        TexCoord texOrg {0,0};
+        TexCoord texEdgeX {0,0};
+        TexCoord texEdgeY {0,0};
+        RGBAColor color = RGBAColor::white();
+        /// Set if the normal points out from the globe, rather than straight up
+        bool globe = false;
+    };
+
+    /// A run of vertices for one piece of an object's geometry and the color it was given.
+    /// Vertex positions are relative to the drawable's center, and motion to its start time.
+    /// For an instance, startVert is the instance index and inst is what we gave it.
+    struct VertexRange
+    {
+        SimpleIdentity drawID;
+        unsigned int startVert;
+        unsigned int numVerts;
+        RGBAColor color;
+        Point3d center;
+        TimeInterval startTime;
+        bool isInstance = false;
+        ScreenSpaceInstance inst;
+    };
+
+    /// Add a single screen space object.
+    /// If vertRanges is set, we'll add where each piece of the geometry went.
     void addScreenObject(const ScreenSpaceObject &screenObject,
                          const Point3d &worldLoc,
                          const std::vector<ScreenSpaceConvexGeometry> *geoms,
                          const std::vector<Eigen::Matrix3d> *places = nullptr,
-                         SimpleIDUnorderedSet *drawIDs = nullptr);
+                         SimpleIDUnorderedSet *drawIDs = nullptr,
+                         std::vector<VertexRange> *vertRanges = nullptr);
 
     /// Return the drawables constructed.  Caller responsible for deletion.
     void buildDrawables(std::vector<BasicDrawableRef> &draws);
     
-    /// Build drawables and add them to the change list
-    std::vector<BasicDrawableRef> flushChanges(ChangeSet &changes,SimpleIDSet *drawIDs = nullptr);
-    std::vector<BasicDrawableRef> flushChanges(ChangeSet &changes,SimpleIDSet &drawIDs);
+    /// Return the instanced drawables and the quads they're based on.
+    void buildInstanceDrawables(std::vector<BasicDrawableRef> &quads,std::vector<BasicDrawableInstanceRef> &insts);
+
+    /// Build drawables and add them to the change list.
+    /// Instance drawables are added too (after their quads), and handed back in instDraws.
+    std::vector<BasicDrawableRef> flushChanges(ChangeSet &changes,SimpleIDSet *drawIDs = nullptr,
+                                               std::vector<BasicDrawableInstanceRef> *instDraws = nullptr);
+    std::vector<BasicDrawableRef> flushChanges(ChangeSet &changes,SimpleIDSet &drawIDs,
+                                               std::vector<BasicDrawableInstanceRef> *instDraws = nullptr);
     
     /// Calculate the rotation vector for a rotation
     static Point3d CalcRotationVec(CoordSystemDisplayAdapter *coordAdapter,const Point3d &worldLoc,float rot);
+
+    /// Instance updates by drawable, then by instance index
+    typedef std::map<SimpleIdentity,std::map<unsigned int,BasicDrawableInstance::SingleInstance>> InstanceChangeMap;
+
+    /// Turn instance updates into change requests, one for each run of consecutive instances
+    static void AddInstanceChanges(InstanceChangeMap &instChanges,ChangeSet &changes);
     
 protected:
     // Wrapper used to track
@@ -170,8 +235,9 @@ protected:
         DrawableWrap(SceneRenderer *sceneRender,const DrawableState &state);
         ~DrawableWrap() = default;
         
-        void addVertex(CoordSystemDisplayAdapter *,float scale, const Point3d &worldLoc,
-                       const Point3f *dir,float rot, const Point2d &inVert,
+        /// Normal and rotation are the same for every corner of an object, so the caller works them out once
+        void addVertex(float scale, const Point3d &worldLoc, const Point3d &norm,
+                       const Point3f *dir, const Point3d &rotVec, const Point2d &inVert,
                        const TexCoord *texCoord, const RGBAColor *color,
                        const SingleVertexAttributeSet *vertAttrs);
         void addTri(int v0,int v1,int v2);
@@ -187,6 +253,35 @@ protected:
     typedef std::map<DrawableState,DrawableWrapRef> DrawableWrapMap;
     
     DrawableWrapRef findOrAddDrawWrap(const DrawableState &state,int numVerts,int numTri,const Point3d &center);
+
+    // Rectangles sharing a state, drawn as instances of one quad.
+    // The quad itself is never turned on.
+    struct InstanceWrap
+    {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+        InstanceWrap(SceneRenderer *sceneRender,const DrawableState &state,SimpleIdentity instProgID,
+                     const Point3d &center,TimeInterval startTime);
+        ~InstanceWrap() = default;
+
+        /// Returns the index of the new instance
+        unsigned int addInstance(const ScreenSpaceInstance &inst);
+
+        Point3d center;
+        TimeInterval startTime;
+        DrawableState state;
+        ScreenSpaceDrawableBuilderRef quadDraw;
+        BasicDrawableInstanceBuilderRef instDraw;
+        std::vector<BasicDrawableInstance::SingleInstance> insts;
+    };
+
+    typedef std::shared_ptr<InstanceWrap> InstanceWrapRef;
+    typedef std::map<DrawableState,InstanceWrapRef> InstanceWrapMap;
+
+    InstanceWrapRef findOrAddInstWrap(const DrawableState &state,SimpleIdentity instProgID,const Point3d &center);
+
+    // Straight up from a location
+    Point3d calcNormal(const Point3d &worldLoc) const;
     
     float centerDist;
     float scale;
@@ -196,6 +291,10 @@ protected:
     DrawableState curState;
     DrawableWrapMap drawables;
     std::vector<DrawableWrapRef> fullDrawables;
+    // Regular screen space programs and the instance versions to use in their place
+    std::map<SimpleIdentity,SimpleIdentity> instPrograms;
+    InstanceWrapMap instDrawables;
+    std::vector<InstanceWrapRef> fullInstDrawables;
 };
 
 /// Represents a simple set of convex geometry
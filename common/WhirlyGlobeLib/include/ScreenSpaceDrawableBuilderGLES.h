@@ -33,6 +33,12 @@ ProgramGLES *BuildScreenSpaceProgramGLES(const std::string &name,SceneRenderer *
 ProgramGLES *BuildScreenSpaceMotionProgramGLES(const std::string &name,SceneRenderer *render);
 ProgramGLES *BuildScreenSpace2DProgramGLES(const std::string &name,SceneRenderer *render);
 ProgramGLES *BuildScreenSpaceMotion2DProgramGLES(const std::string &name,SceneRenderer *render);
+// Versions for text rendered as signed distance fields
+ProgramGLES *BuildScreenSpaceSDFProgramGLES(const std::string &name,SceneRenderer *render);
+ProgramGLES *BuildScreenSpaceSDFMotionProgramGLES(const std::string &name,SceneRenderer *render);
+// Versions for rectangles drawn as instances of one quad, with or without motion
+ProgramGLES *BuildScreenSpaceInstanceProgramGLES(const std::string &name,SceneRenderer *render);
+ProgramGLES *BuildScreenSpaceSDFInstanceProgramGLES(const std::string &name,SceneRenderer *render);
     
 /// The OpenGL version sets uniforms
 struct ScreenSpaceTweakerGLES : public ScreenSpaceTweaker
@@ -0,0 +1,94 @@
+/*  SelectionIndex.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import <unordered_map>
+#import "Identifiable.h"
+#import "WhirlyVector.h"
+#import "BoundsHierarchy.h"
+
+namespace WhirlyKit
+{
+
+/** Bounding volume hierarchy over the display space bounds of the 3D selectables.
+    The selection manager keeps one of these next to its sets so picking only has to
+    project the selectables near the touch ray, rather than all of them.
+    Moving selectables don't stay inside any one set of bounds, so they aren't in here.
+    Additions go on a list we look through directly and removals are just marked,
+    until there are enough of either to make it worth rebuilding the tree on the next query.
+  */
+class SelectionIndex
+{
+public:
+    /// Which of the selection manager's sets an entry is in
+    enum Kind { Rect3D = 0, Polytope, Linear, Billboard, NumKinds };
+
+    /// Something worth a closer look
+    struct Candidate
+    {
+        SimpleIdentity selectID;
+        Kind kind;
+    };
+
+    /// Add bounds for a selectable in display space, replacing any it already had
+    void add(Kind kind,SimpleIdentity selectID,const Point3d &ll,const Point3d &ur,bool enable);
+
+    /// Take a selectable out
+    void remove(Kind kind,SimpleIdentity selectID);
+
+    /// Disabled selectables stay in the index, but aren't returned
+    void setEnable(Kind kind,SimpleIdentity selectID,bool enable);
+
+    /// Number of selectables in the index
+    size_t size() const { return entries.size() - numDead; }
+
+    /** Enabled selectables whose bounds come near the ray from org along dir.
+        The ray gets wider as it goes, by slope for each unit of distance from org,
+        which is how a pick tolerance in pixels spreads out in a perspective view.
+        Results are appended and may repeat what's already there.
+      */
+    void query(const Point3d &org,const Point3d &dir,double slope,std::vector<Candidate> &results);
+
+protected:
+    struct Entry
+    {
+        Point3d ll,ur;
+        SimpleIdentity selectID;
+        Kind kind;
+        bool enable;
+        bool live;
+    };
+
+    // Leaves have entries, interior nodes have children
+    typedef BoundsHierarchyNode<Point3d> Node;
+
+    // Toss the removed entries and sort everything into a new tree
+    void rebuild();
+    // Check a box against the widening ray
+    static bool rayHits(const Point3d &ll,const Point3d &ur,const Point3d &org,const Point3d &dir,double slope);
+
+    std::vector<Entry> entries;
+    std::vector<Node> nodes;
+    // Entries past this were added since the tree was built
+    size_t numIndexed = 0;
+    // Entries marked removed, but still in the list
+    size_t numDead = 0;
+    // Where each selectable is in the entries
+    std::unordered_map<SimpleIdentity,size_t> where[NumKinds];
+};
+
+}
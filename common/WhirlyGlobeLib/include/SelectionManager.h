@@ -27,6 +27,8 @@
 #import "Scene.h"
 #import "ScreenSpaceBuilder.h"
 #import "VectorObject.h"
+#import "SelectionIndex.h"
+#import "TriangleIndex.h"
 
 namespace WhirlyKit
 {
@@ -82,7 +84,7 @@ struct PolytopeSelectable : public Selectable
     PolytopeSelectable(SimpleIdentity theID) : Selectable(theID) { }
     PolytopeSelectable(const PolytopeSelectable&) = default;
     PolytopeSelectable(PolytopeSelectable&& other) noexcept :
-            Selectable(other.selectID),
+            Selectable(other),
             centerPt(other.centerPt),
             polys(std::move(other.polys))
     {
@@ -130,7 +132,7 @@ struct LinearSelectable : public Selectable
     LinearSelectable(SimpleIdentity theID) : Selectable(theID) { }
     LinearSelectable(const LinearSelectable &) = default;
     LinearSelectable(LinearSelectable &&other) noexcept :
-        Selectable(other.selectID),
+        Selectable(other),
         pts(std::move(other.pts))
     {
     }
@@ -193,6 +195,66 @@ struct BillboardSelectable : public Selectable
   
 typedef std::set<WhirlyKit::BillboardSelectable> BillboardSelectableSet;
     
+/** A group of selectables to hand to the selection manager in one go.
+    Builders fill these in as they work through their features and the selection
+    manager takes them all under one lock, rather than once per feature.
+    The add methods are the same as the selection manager's.
+  */
+class SelectionBatch
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+    void addSelectableRect(SimpleIdentity selectId,const Point3f *pts,bool enable);
+    void addSelectableRect(SimpleIdentity selectId,const Point3f *pts,
+                           float minVis,float maxVis,bool enable);
+    void addSelectableScreenRect(SimpleIdentity selectId,const Point3d &center,
+                                 const Point2f *pts,float minVis,float maxVis,bool enable);
+    void addSelectableMovingScreenRect(SimpleIdentity selectId,const Point3d &startCenter,
+                                       const Point3d &endCenter,TimeInterval startTime,
+                                       TimeInterval endTime,const Point2f *pts,
+                                       float minVis,float maxVis,bool enable);
+    void addSelectableRectSolid(SimpleIdentity selectId,const Point3f *pts,
+                                float minVis,float maxVis,bool enable);
+    void addSelectableRectSolid(SimpleIdentity selectId,const Point3d *pts,
+                                float minVis,float maxVis,bool enable);
+    void addSelectableRectSolid(SimpleIdentity selectId,const BBox &bbox,float minVis,float maxVis,bool enable);
+    void addPolytope(SimpleIdentity selectId,const std::vector<Point3dVector> &surfaces,
+                     float minVis,float maxVis,bool enable);
+    void addPolytopeFromBox(SimpleIdentity selectId,const Point3d &ll,const Point3d &ur,
+                            const Eigen::Matrix4d &mat,float minVis,float maxVis,bool enable);
+    void addMovingPolytope(SimpleIdentity selectId,const std::vector<Point3dVector> &surfaces,
+                           const Point3d &startCenter,const Point3d &endCenter,
+                           TimeInterval startTime,TimeInterval duration,
+                           const Eigen::Matrix4d &mat,float minVis,float maxVis,bool enable);
+    void addMovingPolytopeFromBox(SimpleIdentity selectID,const Point3d &ll,const Point3d &ur,
+                                  const Point3d &startCenter,const Point3d &endCenter,
+                                  TimeInterval startTime,TimeInterval duration,
+                                  const Eigen::Matrix4d &mat,float minVis,float maxVis,bool enable);
+    void addSelectableLinear(SimpleIdentity selectId,const Point3dVector &pts,
+                             float minVis,float maxVis,bool enable);
+    void addSelectableBillboard(SimpleIdentity selectId,const Point3d &center,
+                                const Point3d &norm,const Point2d &size,
+                                float minVis,float maxVis,bool enable);
+
+    /// Nothing's been added
+    bool empty() const;
+
+    /// Number of selectables added
+    size_t size() const;
+
+protected:
+    friend class SelectionManager;
+
+    std::vector<RectSelectable3D> rect3Ds;
+    std::vector<RectSelectable2D> rect2Ds;
+    std::vector<MovingRectSelectable2D> movingRect2Ds;
+    std::vector<PolytopeSelectable> polytopes;
+    std::vector<MovingPolytopeSelectable> movingPolytopes;
+    std::vector<LinearSelectable> linears;
+    std::vector<BillboardSelectable> billboards;
+};
+
 #define kWKSelectionManager "WKSelectionManager"
     
 /** The selection manager tracks a variable number of objects that
@@ -202,7 +264,8 @@ typedef std::set<WhirlyKit::BillboardSelectable> BillboardSelectableSet;
      when the caller uses pickObject.
  
     All objects are currently being projected to the 2D screen and
-     evaluated for distance there.
+     evaluated for distance there.  The 3D ones that don't move are kept
+     in a spatial index as well, so we only project those near the touch.
  
     The selection manager is entirely thread safe except for destruction.
  */
@@ -294,6 +357,9 @@ public:
                                 const Point3d &norm,const Point2d &size,
                                 float minVis,float maxVis,bool enable);
     
+    /// Add everything in the batch at once.  The batch is emptied.
+    void addSelectables(SelectionBatch &batch);
+
     /// Remove the given selectable from consideration
     void removeSelectable(SimpleIdentity selectId);
     
@@ -305,6 +371,12 @@ public:
     
     /// Enable/disable a set of selectables
     void enableSelectables(const SimpleIDSet &selectIDs,bool enable);
+
+    /// Change where a group of moving screen space rectangles are and where they're headed.
+    /// They all share the one time range.
+    void moveSelectableScreenRects(const std::vector<SimpleIdentity> &selectIDs,
+                                   const Point3dVector &startCenters,const Point3dVector &endCenters,
+                                   TimeInterval startTime,TimeInterval endTime);
     
     /// Pass in the view point where the user touched.  This returns the closest hit within the given distance
     SimpleIdentity pickObject(const Point2f &touchPt,float maxDist,const ViewStateRef &viewState);
@@ -312,6 +384,21 @@ public:
     /// Find all the objects within a given distance and return them, sorted by distance
     void pickObjects(const Point2f &touchPt,float maxDist,
                      const ViewStateRef &viewState,std::vector<SelectedObject> &selObjs);
+
+    /** Pick the 3D selectables that draw their IDs into the given render target
+        by reading it back around the touch, rather than checking their geometry.
+        Scale is the size of the render target relative to the framebuffer.
+        Pass in EmptyIdentity to turn it off.
+        Only the shape manager's triangle geometry is drawn into it, and only with Metal.
+        Wide vectors and lofted polys are still picked geometrically by the component manager.
+      */
+    void setIDBuffer(SimpleIdentity renderTargetID,float scale);
+
+    /// Render target for selection IDs, if there is one
+    SimpleIdentity getIDBuffer();
+
+    /// These selectables draw their IDs into the ID buffer, so we needn't check their geometry
+    void addIDBuffered(const SimpleIDSet &selectIDs);
     
     // Everything we need to project a world coordinate to one or more screen locations
     class PlacementInfo
@@ -349,6 +436,24 @@ protected:
     // Convert rect selectables into more generic screen space objects
     void getScreenSpaceObjects(const PlacementInfo &pInfo,std::vector<ScreenSpaceObjectLocation> &screenObjs,TimeInterval now);
 
+    // Track the display space bounds of a selectable in the index.  Lock must be held.
+    void indexSelectable(const RectSelectable3D &sel);
+    void indexSelectable(const PolytopeSelectable &sel);
+    void indexSelectable(const LinearSelectable &sel);
+    void indexSelectable(const BillboardSelectable &sel);
+
+    // Look up the 3D selectables near the touch point in the index,
+    //  along with the polytopes the touch ray actually hits and how far away they are.
+    // Returns false if the view isn't one the index can be used with.
+    bool findCandidates(const Point2f &touchPt,float maxDist,const PlacementInfo &pInfo,
+                        std::vector<SelectionIndex::Candidate> &candidates,
+                        std::unordered_map<SimpleIdentity,double> &polytopeHits);
+
+    // Read back the ID buffer around the touch point.  Lock must be held.
+    // Returns false if there's no ID buffer, or nothing came back from it.
+    bool pickFromIDBuffer(const Point2f &touchPt,float maxDist,const PlacementInfo &pInfo,
+                          std::vector<SelectedObject> &selObjs);
+
     // Internal object picking method
     void pickObjects(const Point2f &touchPt,float maxDist,const ViewStateRef &viewState,
                      bool multi,std::vector<SelectedObject> &selObjs);
@@ -362,6 +467,15 @@ protected:
     WhirlyKit::MovingPolytopeSelectableSet movingPolytopeSelectables;
     WhirlyKit::LinearSelectableSet linearSelectables;
     WhirlyKit::BillboardSelectableSet billboardSelectables;
+    /// Bounds for the 3D selectables
+    SelectionIndex selectIndex;
+    /// Faces of the polytopes, for exact hits on the touch ray
+    TriangleIndex polytopeTris;
+    /// Render target selectables draw their IDs into, and how big it is compared to the screen
+    SimpleIdentity idRenderTargetID = EmptyIdentity;
+    float idScale = 1.0f;
+    /// Selectables that show up in the ID buffer
+    SimpleIDSet idBuffered;
 };
 typedef std::shared_ptr<SelectionManager> SelectionManagerRef;
  
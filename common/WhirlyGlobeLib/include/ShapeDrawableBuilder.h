@@ -40,6 +40,8 @@ struct ShapeInfo : public BaseInfo
     RGBAColor color = RGBAColor::white();
     float lineWidth = 1.0f;
     bool insideOut = false;
+    /// Circles, spheres and cylinders share one mesh per kind and are drawn as instances of it
+    bool instanced = false;
     bool hasCenter = false;
     WhirlyKit::Point3d center = { 0, 0, 0 };
 };
@@ -98,6 +100,12 @@ public:
     // If set, we'll apply the given texture
     void setTexIDs(const std::vector<SimpleIdentity> &texIDs);
 
+    // If set, geometry for selectable shapes is also drawn into the given render target as their select IDs
+    void setIDTarget(SimpleIdentity renderTargetID,SimpleIdentity progID);
+
+    // The select ID for the shape we're about to add, or EmptyIdentity if it's not selectable
+    void setSelectID(SimpleIdentity selectID);
+
     // Add a triangle with normals
     void addTriangle(Point3f p0,Point3f n0,RGBAColor c0,Point3f p1,Point3f n1,RGBAColor c1,Point3f p2,Point3f n2,RGBAColor c2,Mbr shapeMbr);
 
@@ -134,6 +142,9 @@ public:
     // Creates a new local drawable with all the appropriate settings
     void setupNewDrawable();
 
+    // Copy the current drawable for the ID render target
+    void makeIDDrawable();
+
     CoordSystemDisplayAdapter *coordAdapter;    
     SceneRenderer *sceneRender;
     Mbr drawMbr;
@@ -143,6 +154,14 @@ public:
     std::vector<SimpleIdentity> texIDs;
     Point3d center;
     bool clipCoords;
+
+    SimpleIdentity idTargetID = EmptyIdentity;
+    SimpleIdentity idProgID = EmptyIdentity;
+    SimpleIdentity selectID = EmptyIdentity;
+    // Where each select ID starts in the current drawable
+    std::vector<std::pair<unsigned int,SimpleIdentity>> idStarts;
+    /// Select IDs we've drawn into the ID render target
+    SimpleIDSet idsWritten;
 };
 
 }
@@ -22,6 +22,7 @@
 #import "ShapeDrawableBuilder.h"
 #include <vector>
 #include <set>
+#include <tuple>
 
 
 namespace WhirlyKit {
@@ -42,9 +43,24 @@ struct ShapeSceneRep : public Identifiable
     void clearContents(const SelectionManagerRef &selectManager,ChangeSet &changes,TimeInterval when);
 
     SimpleIDSet drawIDs;  // Drawables created for this
+    SimpleIDSet baseDrawIDs;  // Meshes for the instances, which stay off themselves
     SimpleIDSet selectIDs;  // IDs in the selection layer
     float fadeOut = 0.0;  // Time to fade away for removal
 };
+
+/// Unit mesh a shape can be drawn from when shapes are instanced
+struct ShapeInstanceTemplate
+{
+    enum Type { None = 0, UnitDisc, UnitSphere, UnitCylinder };
+
+    Type type = None;
+    int sampleX = 0, sampleY = 0;
+
+    bool operator < (const ShapeInstanceTemplate &that) const
+    {
+        return std::tie(type,sampleX,sampleY) < std::tie(that.type,that.sampleX,that.sampleY);
+    }
+};
     
 typedef std::set<ShapeSceneRep *,IdentifiableSorter> ShapeSceneRepSet;
     
@@ -58,9 +74,14 @@ public:
     Shape();
     virtual ~Shape() = default;
 
-	virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionManagerRef &selectManager, ShapeSceneRep *sceneRep);
+	virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionBatch *selectBatch, ShapeSceneRep *sceneRep);
     virtual Point3d displayCenter(CoordSystemDisplayAdapter *coordAdapter, const ShapeInfo &shapeInfo);
 
+    /// The unit mesh for this shape and where it goes, for instancing.
+    /// Returns false if this kind of shape has to be built on its own.
+    virtual bool makeInstance(CoordSystemDisplayAdapter *coordAdapter, ShapeInstanceTemplate &tmpl,
+                              Point3d &center, Eigen::Matrix4d &mat) const { return false; }
+
 public:
     bool isSelectable;
     WhirlyKit::SimpleIdentity selectID;
@@ -78,8 +99,10 @@ public:
     Circle();
     virtual ~Circle() = default;
     
-    virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionManagerRef &selectManager, ShapeSceneRep *sceneRep);
+    virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionBatch *selectBatch, ShapeSceneRep *sceneRep);
     virtual Point3d displayCenter(CoordSystemDisplayAdapter *coordAdapter, const ShapeInfo &shapeInfo);
+    virtual bool makeInstance(CoordSystemDisplayAdapter *coordAdapter, ShapeInstanceTemplate &tmpl,
+                              Point3d &center, Eigen::Matrix4d &mat) const override;
     
 public:
     /// The location for the origin of the shape
@@ -100,9 +123,11 @@ public:
     
     Sphere();
     virtual ~Sphere() = default;
-
-    virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionManagerRef &selectManager, ShapeSceneRep *sceneRep);
+    
+    virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionBatch *selectBatch, ShapeSceneRep *sceneRep);
     virtual Point3d displayCenter(CoordSystemDisplayAdapter *coordAdapter, const ShapeInfo &shapeInfo);
+    virtual bool makeInstance(CoordSystemDisplayAdapter *coordAdapter, ShapeInstanceTemplate &tmpl,
+                              Point3d &center, Eigen::Matrix4d &mat) const override;
 
 public:
     WhirlyKit::GeoCoord loc;
@@ -120,8 +145,10 @@ public:
     Cylinder();
     virtual ~Cylinder() = default;
     
-    virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionManagerRef &selectManager, ShapeSceneRep *sceneRep);
+    virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionBatch *selectBatch, ShapeSceneRep *sceneRep);
     virtual Point3d displayCenter(CoordSystemDisplayAdapter *coordAdapter, const ShapeInfo &shapeInfo);
+    virtual bool makeInstance(CoordSystemDisplayAdapter *coordAdapter, ShapeInstanceTemplate &tmpl,
+                              Point3d &center, Eigen::Matrix4d &mat) const override;
 
 public:
     /// The location for the origin of the shape
@@ -148,7 +175,7 @@ public:
     Linear();
     virtual ~Linear() = default;
     
-    virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionManagerRef &selectManager, ShapeSceneRep *sceneRep);
+    virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionBatch *selectBatch, ShapeSceneRep *sceneRep);
     virtual Point3d displayCenter(CoordSystemDisplayAdapter *coordAdapter, const ShapeInfo &shapeInfo);
 
 public:
@@ -171,7 +198,7 @@ public:
     Extruded();
     virtual ~Extruded() = default;
     
-    virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionManagerRef &selectManager, ShapeSceneRep *sceneRep);
+    virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionBatch *selectBatch, ShapeSceneRep *sceneRep);
     virtual Point3d displayCenter(CoordSystemDisplayAdapter *coordAdapter, const ShapeInfo &shapeInfo);
 
 public:
@@ -205,7 +232,7 @@ public:
 	
     void setTexIDs(std::vector<SimpleIdentity> inTexIDs) { texIDs = inTexIDs; }
 
-    virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionManagerRef &selectManager, ShapeSceneRep *sceneRep);
+    virtual void makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, SelectionBatch *selectBatch, ShapeSceneRep *sceneRep);
     virtual Point3d displayCenter(CoordSystemDisplayAdapter *coordAdapter, const ShapeInfo &shapeInfo);
 
 public:
@@ -19,6 +19,7 @@
  */
 
 #import <math.h>
+#import <mutex>
 #import "VectorData.h"
 #import "GlobeMath.h"
 
@@ -27,6 +28,9 @@ namespace WhirlyKit
 
 /** Shape File Reader.
 	Open a shapefile and return the features as requested.
+    Features can also be looked up by bounding box.  That uses the .qix spatial index
+    next to the shapefile if there is one, otherwise we build one the first time it's
+    needed and try to save it there for next time.
  */
 class ShapeReader : public VectorReader
 {
@@ -49,12 +53,40 @@ public:
 
     /// Fetch an object by the index
     virtual VectorShapeRef getObjectByIndex(unsigned int vecIndex,const StringSet *filter);
-    
+
+    /// Indices of the shapes overlapping the given bounds (in radians), in file order
+    std::vector<int> findObjectsInBounds(const GeoMbr &mbr);
+
+    /// Read all the shapes that overlap the given bounds (in radians).
+    /// Returns the number added.
+    int getObjectsInBounds(const GeoMbr &mbr,const StringSet *filterAttrs,ShapeSet &shapes);
+
+    /// True if we've got a spatial index from disk or have built one
+    bool hasSpatialIndex();
+
 protected:
+    struct FieldInfo
+    {
+        std::string name;
+        int type;
+    };
+
+    // Read a shape and its attributes, once we hold the lock
+    VectorShapeRef readObject(unsigned int vecIndex,const StringSet *filter,const GeoMbr *mbr);
+
+    // Open or build the spatial index, once we hold the lock
+    void setupIndex();
+
 	void *shp;
 	void *dbf;
+    void *diskTree;
+    void *memTree;
+    bool indexChecked;
+    std::string qixName;
+    std::vector<FieldInfo> fields;
 	int where,numEntity,shapeType;
 	double minBound[4], maxBound[4];
+    std::mutex lock;
 };
 
 }
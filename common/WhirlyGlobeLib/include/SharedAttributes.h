@@ -94,6 +94,8 @@
 #define MaplyBillboardOrientGround WKString("billboardorientground")
 /// Billboards are oriented only towards the eye
 #define MaplyBillboardOrientEye WKString("billboardorienteye")
+/// Billboards are drawn as instances of a single quad
+#define MaplyBillboardInstanced WKString("billboardinstanced")
 
 /// These are the various shader programs we set up by default
 #define MaplyDefaultModelTriShader WKString("Default Triangle;model=yes;lighting=yes")
@@ -101,12 +103,20 @@
 
 #define MaplyDefaultTriMultiTexShader WKString("Default Triangle;multitex=yes;lighting=yes")
 #define MaplyDefaultTriMultiTexRampShader WKString("Default Triangle;multitex=yes;lighting=yes;ramp=yes")
+#define MaplyDefaultTriCompositeShader WKString("Default Triangle;composite=yes;lighting=yes")
+#define MaplyDefaultTriTerrainShader WKString("Default Triangle;terrain=yes;lighting=yes")
 #define MaplyDefaultMarkerShader WKString("Default marker;multitex=yes;lighting=yes")
 
 #define MaplyDefaultTriNightDayShader WKString("Default Triangle;nightday=yes;multitex=yes;lighting=yes")
+/// Writes a_maskID out as an integer, for picking objects out of a render target
+#define MaplyTriangleIDShader WKString("Default Triangle ID")
+/// Lit triangles raised along the up vector by a_height
+#define MaplyLoftedPolyExtrudeShader WKString("Lofted poly extrude")
 
 #define MaplyBillboardGroundShader WKString("Default Billboard ground")
 #define MaplyBillboardEyeShader WKString("Default Billboard eye")
+#define MaplyBillboardGroundInstanceShader WKString("Billboard ground instance")
+#define MaplyBillboardEyeInstanceShader WKString("Billboard eye instance")
 
 #define MaplyDefaultWideVectorShader WKString("Default Wide Vector")
 #define MaplyWideVectorExpShader WKString("Default Wide Vector with expressions")
@@ -117,6 +127,10 @@
 #define MaplyScreenSpaceDefaultShader WKString("Default Screenspace")
 #define MaplyScreenSpaceMaskShader WKString("Screenspace mask")
 #define MaplyScreenSpaceExpShader WKString("Screenspace with expressions")
+#define MaplyScreenSpaceSDFShader WKString("Screenspace SDF")
+#define MaplyScreenSpaceSDFMotionShader WKString("Screenspace SDF Motion")
+#define MaplyScreenSpaceInstanceShader WKString("Screenspace instance")
+#define MaplyScreenSpaceSDFInstanceShader WKString("Screenspace SDF instance")
 
 #define MaplyParticleSystemPointDefaultShader WKString("Default Part Sys (Point)")
 
@@ -212,6 +226,13 @@
 /// This fixes jitter.
 #define MaplyVecCentered WKString("centered")
 
+/// Number of simplified versions of linear and areal features to build for lower zoom levels
+#define MaplyVecLODLevels WKString("lodlevels")
+/// Zoom level where features are shown at full detail
+#define MaplyVecLODMaxZoom WKString("lodmaxzoom")
+/// How far lines can stray during simplification, in pixels
+#define MaplyVecLODTolerance WKString("lodtolerance")
+
 /// If set, the texture to apply to the feature
 #define MaplyVecTexture WKString("texture")
 #define MaplyVecTextureFormat WKString("textureFormat")
@@ -220,6 +241,9 @@
 
 // scale for markers
 #define MaplyMarkerScale WKString("markerScale")
+#define MaplyMarkerFleet WKString("fleet")
+#define MaplyMarkerInstanced WKString("instanced")
+#define MaplyMarkerClampToGround WKString("clamptoground")
 
 /// The projection to use when generating texture coordinates
 #define MaplyVecTextureProjection WKString("texprojection")
@@ -355,6 +379,10 @@
 #define MaplyLoftedPolyOutlineSide WKString("outlineSide")
 /// Whether to include the bottom in the outline lines
 #define MaplyLoftedPolyOutlineBottom WKString("outlineBottom")
+/// Store walls and roofs at ground level with the height as an attribute and let the shader raise them
+#define MaplyLoftedPolyShaderExtrude WKString("shaderExtrude")
+/// Merge touching footprints before building roofs and walls
+#define MaplyLoftedPolyMergeRoofs WKString("mergeRoofs")
 
 /// These are used by active vector objects
 #define MaplyVecHeight WKString("height")
@@ -378,6 +406,8 @@
 #define MaplyShapeCenterX WKString("shapecenterx")
 #define MaplyShapeCenterY WKString("shapecentery")
 #define MaplyShapeCenterZ WKString("shapecenterz")
+/// Draw circles, spheres and cylinders as instances of one mesh per kind
+#define MaplyShapeInstanced WKString("shapeinstanced")
 
 /// Used to designate a non-default render target by ID
 #define MaplyRenderTargetDesc WKString("rendertarget")
@@ -0,0 +1,175 @@
+/*  SlotMap.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import <cstdint>
+#import <utility>
+
+namespace WhirlyKit
+{
+
+/// Handle to an entry in a SlotMap.  Holds an index and a generation.
+typedef uint64_t SlotHandle;
+
+/// Never refers to anything
+static const SlotHandle EmptySlotHandle = 0;
+
+/** A slot map keeps its values packed together in a vector for fast iteration
+    and hands out handles for O(1) lookup and removal without hashing.
+    Handles carry a generation, so a stale handle to a removed value
+    won't find whatever took its place.
+    Not thread safe.
+  */
+template <typename T>
+class SlotMap
+{
+public:
+    typedef typename std::vector<T>::iterator iterator;
+    typedef typename std::vector<T>::const_iterator const_iterator;
+
+    /// Add a value and return the handle to it
+    SlotHandle insert(T value)
+    {
+        uint32_t slotIdx;
+        if (!freeSlots.empty())
+        {
+            slotIdx = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            slotIdx = (uint32_t)slots.size();
+            slots.emplace_back();
+        }
+
+        Slot &slot = slots[slotIdx];
+        slot.valueIdx = (uint32_t)values.size();
+        values.push_back(std::move(value));
+        valueSlots.push_back(slotIdx);
+
+        return makeHandle(slotIdx,slot.generation);
+    }
+
+    /// Remove the value for the given handle.
+    /// Returns false if the handle was stale.
+    bool erase(SlotHandle handle)
+    {
+        Slot *slot = findSlot(handle);
+        if (!slot)
+            return false;
+
+        // Move the last value into the hole
+        const uint32_t valueIdx = slot->valueIdx;
+        const uint32_t lastIdx = (uint32_t)values.size() - 1;
+        if (valueIdx != lastIdx)
+        {
+            values[valueIdx] = std::move(values[lastIdx]);
+            valueSlots[valueIdx] = valueSlots[lastIdx];
+            slots[valueSlots[valueIdx]].valueIdx = valueIdx;
+        }
+        values.pop_back();
+        valueSlots.pop_back();
+
+        // Bump the generation so outstanding handles are invalid
+        slot->generation++;
+        if (slot->generation == 0)
+            slot->generation = 1;
+        freeSlots.push_back(slotIndex(handle));
+
+        return true;
+    }
+
+    /// Return the value for a handle, or null if it's been removed
+    T *get(SlotHandle handle)
+    {
+        Slot *slot = findSlot(handle);
+        return slot ? &values[slot->valueIdx] : nullptr;
+    }
+    const T *get(SlotHandle handle) const
+    {
+        const Slot *slot = findSlot(handle);
+        return slot ? &values[slot->valueIdx] : nullptr;
+    }
+
+    /// True if the handle still refers to a value
+    bool contains(SlotHandle handle) const { return findSlot(handle) != nullptr; }
+
+    /// Values are stored contiguously, in no particular order
+    iterator begin() { return values.begin(); }
+    iterator end() { return values.end(); }
+    const_iterator begin() const { return values.begin(); }
+    const_iterator end() const { return values.end(); }
+
+    size_t size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+
+    void reserve(size_t num)
+    {
+        values.reserve(num);
+        valueSlots.reserve(num);
+        slots.reserve(num);
+    }
+
+    /// Remove everything.  All outstanding handles become invalid.
+    void clear()
+    {
+        values.clear();
+        valueSlots.clear();
+        freeSlots.clear();
+        for (uint32_t ii=0;ii<slots.size();ii++)
+        {
+            slots[ii].generation++;
+            if (slots[ii].generation == 0)
+                slots[ii].generation = 1;
+            freeSlots.push_back(ii);
+        }
+    }
+
+protected:
+    struct Slot
+    {
+        uint32_t generation = 1;
+        uint32_t valueIdx = 0;
+    };
+
+    static SlotHandle makeHandle(uint32_t slotIdx,uint32_t generation)
+        { return ((SlotHandle)generation << 32) | slotIdx; }
+    static uint32_t slotIndex(SlotHandle handle) { return (uint32_t)(handle & 0xFFFFFFFF); }
+    static uint32_t slotGeneration(SlotHandle handle) { return (uint32_t)(handle >> 32); }
+
+    Slot *findSlot(SlotHandle handle)
+    {
+        const uint32_t idx = slotIndex(handle);
+        if (handle == EmptySlotHandle || idx >= slots.size())
+            return nullptr;
+        Slot &slot = slots[idx];
+        return (slot.generation == slotGeneration(handle) && slot.valueIdx < values.size() &&
+                valueSlots[slot.valueIdx] == idx) ? &slot : nullptr;
+    }
+    const Slot *findSlot(SlotHandle handle) const
+    {
+        return const_cast<SlotMap *>(this)->findSlot(handle);
+    }
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<T> values;
+    // Which slot each value belongs to, so we can patch it up after a move
+    std::vector<uint32_t> valueSlots;
+};
+
+}
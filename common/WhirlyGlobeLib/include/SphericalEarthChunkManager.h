@@ -24,6 +24,7 @@
 #import "BaseInfo.h"
 #import "ImageTile.h"
 #import "BasicDrawableBuilder.h"
+#import "WorkerPool.h"
 
 namespace WhirlyKit
 {
@@ -114,7 +115,8 @@ public:
     int minSampleX,minSampleY;
 
     /// If not doing static sampling, break it down until its no farther than this from the globe.
-    /// sampleX,sampleY become maximums
+    /// sampleX,sampleY become maximums.
+    /// With static sampling, small geographic chunks on the globe still get fewer samples than this.
     float eps;
 
     /// Rotation around the middle of the chunk
@@ -139,9 +141,9 @@ protected:
                        const BasicDrawableBuilderRef &skirtDraw,
                        bool enable,
                        const CoordSystemDisplayAdapter *coordAdapter,
-                       const SphericalChunkInfo &chunkInfo);
+                       const SphericalChunkInfo &chunkInfo) const;
 
-    void calcSampleX(int &thisSampleX,int &thisSampleY,const Point3f *dispPts) const;
+    void calcSampleX(int &thisSampleX,int &thisSampleY,const Point3f *dispPts,bool onSphere) const;
 };
 
 typedef std::shared_ptr<ChunkSceneRep> ChunkSceneRepRef;
@@ -181,10 +183,24 @@ public:
     
     /// Process outstanding requests
     void processRequests(ChangeSet &changes);
-    
+
+    /** Build chunk geometry on this many extra threads, when there's enough of it.
+        0, the default, builds it all on the calling thread.
+      */
+    void setBuildThreads(int numThreads);
+    int getBuildThreads();
+
 protected:
+    WorkerPoolRef getBuildWorkers();
+
+    // Build the drawables for a run of chunks sharing a texture
+    void buildChunkRun(const std::vector<SphericalChunk> &chunks,size_t start,size_t end,
+                       const CoordSystemDisplayAdapter *coordAdapter,const SphericalChunkInfo &chunkInfo,
+                       std::vector<BasicDrawableRef> &draws) const;
+
     ChunkRepSet chunkReps;
     int borderTexel;
+    WorkerPoolRef buildWorkers;
 };
 typedef std::shared_ptr<SphericalChunkManager> SphericalChunkManagerRef;
 
@@ -51,6 +51,12 @@ public:
     /// Convert from display coordinates to geocentric
     virtual Point3f geocentricToLocal(Point3f) const override;
     virtual Point3d geocentricToLocal(Point3d) const override;
+
+    /// Batch versions, without a virtual call per point, and going through Proj once for geocentric
+    virtual void geographicToLocalBatch(const Point2d *geo,Point3d *local,size_t count) const override;
+    virtual void localToGeographicBatch(const Point3d *local,Point2d *geo,size_t count) const override;
+    virtual void localToGeocentricBatch(const Point3d *local,Point3d *geoc,size_t count) const override;
+    virtual void geocentricToLocalBatch(const Point3d *geoc,Point3d *local,size_t count) const override;
     
     /// True if the other system is Spherical Mercator with the same origin
     virtual bool isSameAs(const CoordSystem *coordSys) const override;
@@ -98,6 +104,9 @@ public:
     virtual Point3f normalForLocal(Point3f) const override { return Point3f(0,0,1); }
     virtual Point3d normalForLocal(Point3d) const override { return Point3d(0,0,1); }
 
+    /// Offset a run of points
+    virtual void localToDisplayBatch(const Point3d *local,Point3d *disp,size_t count) const override;
+
     /// Get a reference to the coordinate system
     virtual CoordSystem *getCoordSystem() const override {
         // todo: eventually return a const pointer
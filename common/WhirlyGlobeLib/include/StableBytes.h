@@ -0,0 +1,69 @@
+/*  StableBytes.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <cstdint>
+#import <cstring>
+#import <string>
+#import <vector>
+
+namespace WhirlyKit
+{
+
+/// Starting point for StableHash
+static constexpr uint64_t StableHashSeed = 14695981039346656037ULL;
+
+/** FNV-1a over some bytes, carrying on from the given hash.
+    This needs to come out the same every run for the disk caches,
+    which std::hash doesn't promise.  It's also plenty to tell data that changed.
+  */
+inline uint64_t StableHash(const void *data,size_t len,uint64_t hash = StableHashSeed)
+{
+    const auto *bytes = (const unsigned char *)data;
+    for (size_t ii=0;ii<len;ii++)
+        hash = (hash ^ bytes[ii]) * 1099511628211ULL;
+    return hash;
+}
+
+/// StableHash over the characters in a string, without the terminator
+inline uint64_t StableHash(const std::string &str,uint64_t hash = StableHashSeed)
+{
+    return StableHash(str.data(),str.size(),hash);
+}
+
+/// Fold a whole value into the hash in one step, for keys that never leave memory
+inline uint64_t StableHashValue(uint64_t val,uint64_t hash)
+{
+    return (hash ^ val) * 1099511628211ULL;
+}
+
+/// Append a plain value to a record being written out, in native byte order
+template <typename T> void PutRecordValue(std::vector<unsigned char> &buf,T val)
+{
+    const auto *bytes = (const unsigned char *)&val;
+    buf.insert(buf.end(),bytes,bytes + sizeof(T));
+}
+
+/// Read a plain value back out of a record, moving past it
+template <typename T> T GetRecordValue(const unsigned char *&ptr)
+{
+    T val;
+    memcpy(&val,ptr,sizeof(T));
+    ptr += sizeof(T);
+    return val;
+}
+
+}
@@ -0,0 +1,94 @@
+/*  StateCacheGLES.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "UtilsGLES.h"
+#import "MemManagerGLES.h"
+
+namespace WhirlyKit
+{
+
+/** Tracks the bits of OpenGL ES state the renderer changes per drawable and skips
+    calls that wouldn't change anything.
+    This only knows about calls that go through it, so it has to be invalidated
+    whenever something else may have touched the state, such as texture uploads
+    during change processing.  Uniforms are cached by the programs themselves.
+  */
+class StateCacheGLES
+{
+public:
+    StateCacheGLES();
+
+    /// Forget everything, so the next call of each kind goes through
+    void invalidate();
+
+    /// Make the given program current
+    void useProgram(GLuint program);
+
+    /// Bind a 2D texture to a texture unit, switching the active unit if need be
+    void bindTexture(int unit,GLuint texID);
+    /// Unbind anything we've left bound
+    void unbindTextures();
+
+    void setBlend(bool enable);
+    void setBlendFunc(GLenum srcFactor,GLenum dstFactor);
+    void setDepthTest(bool enable);
+    void setDepthMask(bool enable);
+    void setDepthFunc(GLenum func);
+    void setCullFace(bool enable);
+    void setLineWidth(float width);
+
+    /// Calls passed through and skipped since the last reset
+    unsigned int getNumCalls() const { return numCalls; }
+    unsigned int getNumSkipped() const { return numSkipped; }
+    void resetCounts() { numCalls = 0;  numSkipped = 0; }
+
+protected:
+    // Tristate for the enables, since we may not know
+    enum KnownState : signed char { Unknown = -1, Off = 0, On = 1 };
+
+    // True if the call needs to go through, counting either way
+    bool update(KnownState &known,bool enable);
+    template <typename T> bool update(T &known,bool &valid,T val)
+    {
+        if (valid && known == val)
+        {
+            numSkipped++;
+            return false;
+        }
+        known = val;
+        valid = true;
+        numCalls++;
+        return true;
+    }
+
+    GLuint program;
+    bool programValid;
+    int activeUnit;     // -1 if we don't know
+    GLuint textures[WhirlyKitMaxTextures];
+    bool texturesValid[WhirlyKitMaxTextures];
+    KnownState blend,depthTest,depthMask,cullFace;
+    GLenum blendSrc,blendDst;
+    bool blendFuncValid;
+    GLenum depthFunc;
+    bool depthFuncValid;
+    float lineWidth;
+    bool lineWidthValid;
+
+    unsigned int numCalls,numSkipped;
+};
+
+}
@@ -22,6 +22,9 @@
 #import <unordered_map>
 #import <string>
 #import <mutex>
+#import <atomic>
+#import <memory>
+#import <cstdint>
 
 namespace WhirlyKit
 {
@@ -83,10 +86,19 @@ extern StringIdentity u_Realw2NameID;
 extern StringIdentity u_wideOffsetNameID;
 extern StringIdentity u_EdgeNameID;
 extern StringIdentity u_texScaleNameID;
+extern StringIdentity u_wideTexOffsetNameID;
+extern StringIdentity u_wideJoinNameID;
+extern StringIdentity u_wideCapNameID;
+extern StringIdentity u_miterLimitNameID;
+extern StringIdentity u_interClipLimitNameID;
 extern StringIdentity u_colorNameID;
 extern StringIdentity u_lengthNameID;
 extern StringIdentity u_interpNameID;
+extern StringIdentity u_elevDecodeNameID;
 extern StringIdentity u_screenOriginNameID;
+extern StringIdentity u_originNameID;
+extern StringIdentity u_globeNameID;
+extern StringIdentity a_heightNameID;
 extern StringIdentity a_colorNameID;
 extern StringIdentity a_normalNameID;
 extern StringIdentity a_modelCenterNameID;
@@ -98,6 +110,9 @@ extern StringIdentity a_modelDirNameID;
  than a string in certain high performance unordered maps and such.
  
  Only adds strings.  Never removes them.
+ That means strings never move once they're in, so lookups of strings
+ we've already seen don't take the lock.  Only adding a new one does.
+ The well known names the drawables use are put in up front.
  */
 class StringIndexer
 {
@@ -107,17 +122,47 @@ public:
     
     // Return the string for a string identity
     static std::string getString(StringIdentity);
+
+    // Return the string for a string identity without copying it.  Good forever.
+    static const std::string &getStringRef(StringIdentity);
     
 protected:
     StringIndexer();
+    ~StringIndexer();
     StringIndexer(StringIndexer const&)     = delete;
     void operator=(StringIndexer const&)    = delete;
 
     static StringIndexer &getInstance() { return instance; }
-    
-    mutable std::mutex mutex;
-    std::unordered_map<std::string,StringIdentity> stringToIdent;
-    std::vector<std::string> identToString;
+
+    // Open addressed hash table.  Slots hold the top of the hash and the string ID + 1, 0 if empty.
+    struct Table
+    {
+        Table(size_t size);
+
+        size_t mask;
+        std::unique_ptr<std::atomic<uint64_t>[]> slots;
+    };
+
+    // Look for a string in the current table, no lock needed
+    bool findString(const std::string &str,size_t hash,StringIdentity &strID) const;
+    // Add a string we know isn't there yet.  Lock must be held.
+    StringIdentity addString(const std::string &str,size_t hash);
+    // Put an ID into a table, which must have room
+    static void insertSlot(Table &table,size_t hash,StringIdentity strID);
+    // Find a string we know is there
+    const std::string &stringFor(StringIdentity strID) const;
+
+    // Strings go in segments, each twice the size of the one before
+    static constexpr int FirstSegmentBits = 8;
+    static constexpr int MaxSegments = 24;
+
+    // Only held by writers
+    std::mutex mutex;
+    std::atomic<std::string *> segments[MaxSegments];
+    std::atomic<size_t> numStrings;
+    std::atomic<Table *> table;
+    // Older tables stay around in case a reader is still looking at one
+    std::vector<std::unique_ptr<Table>> tables;
 
 private:
     static StringIndexer instance;
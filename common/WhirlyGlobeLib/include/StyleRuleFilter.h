@@ -0,0 +1,141 @@
+/*  StyleRuleFilter.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <string>
+#import <vector>
+#import <set>
+#import <memory>
+#import "Dictionary.h"
+
+namespace WhirlyKit
+{
+
+class MutableDictionaryC;
+
+/// Tests a style rule filter can make
+typedef enum {StyleRuleAll,StyleRuleAny,StyleRuleNot,StyleRuleTrue,StyleRuleFalse,
+              StyleRuleEqual,StyleRuleNotEqual,StyleRuleLess,StyleRuleLessEqual,StyleRuleGreater,StyleRuleGreaterEqual,
+              StyleRuleIsNull,StyleRuleLike,StyleRuleBetween} StyleRuleOp;
+
+/// Values a style rule filter can compare
+typedef enum {StyleExprAttr,StyleExprLiteral,StyleExprAdd,StyleExprSub,StyleExprMul,StyleExprDiv} StyleExprType;
+
+/** Feature filter for the SLD and Mapnik style sets.
+    The style parsers describe their filters with the add methods, bottom up,
+    and then compile from the root.  Compiling flattens the tests the same way
+    MapboxVectorFilter does, each test followed by its subtests, so evaluating
+    a feature is a walk down an array with a string lookup per attribute.
+    <br>
+    Comparisons are numeric if either side is a number and the other can be read
+    as one, otherwise they're string comparisons.  Literals that look like numbers
+    count as numbers.  Missing attributes fail every test but IsNull.
+  */
+class StyleRuleFilter
+{
+public:
+    StyleRuleFilter() = default;
+
+    /// An attribute by name.  These add methods return an index to build with, or -1.
+    int addAttr(const std::string &name);
+    /// A literal, as text.  It'll compare as a number too, if it looks like one.
+    int addLiteral(const std::string &val);
+    /// Add, subtract, multiply or divide two values
+    int addArith(StyleExprType type,int left,int right);
+
+    /// Compare two values
+    int addCompare(StyleRuleOp op,int left,int right,bool matchCase = true);
+    /// True if the value is missing
+    int addIsNull(int expr);
+    /// String pattern match with the given wildcard, single character and escape characters
+    int addLike(int expr,const std::string &pattern,char wildCard,char singleChar,char escapeChar,bool matchCase);
+    /// Inclusive numeric range check
+    int addBetween(int expr,int lower,int upper);
+    /// All, Any or Not of the given tests.  Not takes exactly one.
+    int addLogical(StyleRuleOp op,const std::vector<int> &tests);
+    /// A test that always comes out the same way
+    int addConstant(bool val);
+
+    /// Flatten the tests under the given root.  Returns false if it isn't a test.
+    bool compile(int root);
+
+    /// Set once we've compiled successfully
+    bool isValid() const { return !program.empty(); }
+
+    /// Run the compiled filter against a feature's attributes
+    bool test(const Dictionary &attrs) const;
+
+    /// Attribute names the filter looks at
+    void collectKeys(std::set<std::string> &keys) const;
+
+    /// Parse a Mapnik filter expression, such as ([type] = 'park') and ([area] > 1000).
+    /// Returns false for the parts of Mapnik's language we don't handle, like regular expressions.
+    static bool ParseMapnik(const std::string &str,StyleRuleFilter &filter);
+
+protected:
+    // Value expression, as the parser built it
+    struct Expr
+    {
+        StyleExprType type;
+        std::string strVal;
+        double numVal = 0.0;
+        bool isNum = false;
+        int left = -1, right = -1;
+    };
+
+    // Test, as the parser built it.  Operands index the expressions, subtests index the tests.
+    struct Test
+    {
+        StyleRuleOp op;
+        bool matchCase = true;
+        int operands[3] = {-1,-1,-1};
+        std::vector<int> subTests;
+        // For Like
+        std::string pattern;
+        char wildCard = '*', singleChar = '?', escapeChar = '\\';
+    };
+
+    // One test, flattened.  Its subtests follow it, up to end.
+    struct RuleOp
+    {
+        unsigned int test;
+        unsigned int end;
+    };
+
+    // A value evaluated for one feature
+    struct Value
+    {
+        DictionaryType type = DictTypeNone;
+        double numVal = 0.0;
+        const std::string *strVal = nullptr;
+        std::string ownStr;
+        bool isNum() const;
+        bool toNum(double &num) const;
+    };
+
+    void compileTest(unsigned int which);
+    void evalExpr(const Dictionary &attrs,const MutableDictionaryC *dictC,int which,Value &val) const;
+    bool runOp(const Dictionary &attrs,const MutableDictionaryC *dictC,unsigned int pc) const;
+    bool compareValues(const Value &left,const Value &right,StyleRuleOp op,bool matchCase) const;
+    static bool MatchLike(const std::string &str,const Test &test);
+
+    std::vector<Expr> exprs;
+    std::vector<Test> tests;
+    std::vector<RuleOp> program;
+};
+typedef std::shared_ptr<StyleRuleFilter> StyleRuleFilterRef;
+
+}
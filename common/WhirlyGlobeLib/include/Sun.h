@@ -18,6 +18,7 @@
  *
  */
 
+#import <mutex>
 #import "WhirlyVector.h"
 
 class CAADate;
@@ -39,6 +40,12 @@ public:
     
     // Set the UTC time
     void setTime(int year, int month, int day, int hour, int minutes, int second);
+
+    // Set the time as a Julian date (UTC)
+    void setJulianDate(double jd);
+
+    // Julian date for a time in seconds since 1970, UTC
+    static double JulianDateFromUnixTime(double secs) { return secs / 86400.0 + 2440587.5; }
     
     // Return a direction suitable for passing to a light
     Point3d getDirection();
@@ -47,4 +54,26 @@ private:
     void runCalculation(CAADate aaDate);
 };
 
+/**
+    Sun positions for times close together, as in a time lapse.
+    The ephemeris is only run at fixed steps and positions in between are interpolated.
+    The sun moves smoothly enough that ten minute steps are off by a tiny
+    fraction of an arc second.  Thread safe.
+  */
+class SunCache {
+public:
+    SunCache(double stepMinutes = 10.0);
+
+    // Fill in the sun's position for a Julian date (UTC)
+    void getSun(double jd, Sun &sun);
+
+private:
+    std::mutex lock;
+    double step;
+    // The step we've got the ends for, if any
+    bool valid;
+    double stepNum;
+    double lon0, lat0, lon1, lat1;
+};
+
 }
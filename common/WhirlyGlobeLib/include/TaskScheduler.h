@@ -0,0 +1,113 @@
+/*  TaskScheduler.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import <thread>
+#import <mutex>
+#import <condition_variable>
+#import <atomic>
+#import <functional>
+#import <memory>
+#import <cstdint>
+
+namespace WhirlyKit
+{
+
+/** Runs tile parsing work from all the loaders on one bounded set of threads.
+    Each worker has its own queue, ordered by priority (tile importance, higher first).
+    Tasks added from a worker stay on its queue, others are spread around,
+    and workers with nothing to do steal the best task from someone else's queue.
+    A task can carry a pointer to the loader's cancel flag.  If it's set by the
+    time the task comes up, the task is told so it can skip straight to cleaning up.
+    There are no threads by default, in which case tasks run on the caller's thread.
+  */
+class TaskScheduler
+{
+public:
+    /// Called when the task comes up.  Cancelled is set if the cancel flag was.
+    typedef std::function<void(bool cancelled)> TaskFunc;
+    /// Run on each worker thread as it starts or stops
+    typedef std::function<void()> ThreadFunc;
+
+    TaskScheduler() = default;
+    virtual ~TaskScheduler();
+
+    /// The one the loaders share
+    static TaskScheduler &getShared();
+
+    /** Change the number of worker threads.
+        Current tasks finish first and anything queued is carried over.
+        Going to 0 runs what's left on the calling thread.
+        Don't call this from a task.
+      */
+    void setNumThreads(int numThreads);
+    int getNumThreads() const;
+
+    /// Set functions to run as each worker starts and stops, such as attaching to a VM.
+    /// These apply to threads started after this.
+    void setThreadHooks(ThreadFunc startFn,ThreadFunc stopFn);
+
+    /// Queue up a task.  With no worker threads it runs right here.
+    void addTask(double priority,const volatile bool *cancel,TaskFunc func);
+
+    /// Tasks waiting to run
+    size_t getNumQueued() const { return numQueued.load(std::memory_order_relaxed); }
+
+protected:
+    struct Task
+    {
+        double priority;
+        uint64_t seq;
+        const volatile bool *cancel;
+        TaskFunc func;
+
+        // Heap order, so the highest priority comes out first, oldest first among equals
+        bool operator < (const Task &that) const
+        {
+            return (priority == that.priority) ? (seq > that.seq) : (priority < that.priority);
+        }
+    };
+
+    struct Worker
+    {
+        std::mutex lock;
+        std::vector<Task> tasks;    // Heap
+        std::thread thread;
+    };
+
+    void workerMain(size_t which);
+    // Pull the best task from the given worker's queue
+    bool popTask(Worker &worker,Task &task);
+    // Our own queue first, then everyone else's
+    bool takeTask(size_t which,Task &task);
+
+    // Serializes changes to the thread count
+    std::mutex configLock;
+
+    // Protects the worker list, wakeups and the hooks
+    mutable std::mutex lock;
+    std::condition_variable wakeCond;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> stopping { false };
+    size_t nextWorker = 0;
+    uint64_t nextSeq = 0;
+    ThreadFunc startFn,stopFn;
+
+    std::atomic<size_t> numQueued { 0 };
+};
+
+}
@@ -21,6 +21,7 @@
 #import "WhirlyVector.h"
 #import "WhirlyGeometry.h"
 #import "VectorData.h"
+#import "WorkerPool.h"
 
 namespace WhirlyKit
 {
@@ -31,8 +32,16 @@ void TesselateRing(const WhirlyKit::VectorRing &ring,VectorTrianglesRef tris);
 
 /** Tesselate the given areal feature.  The first ring is the outer,
     all others are meant to be holes.
+    Small rings without holes are ear clipped, anything else goes through libtess.
   */
 void TesselateLoops(const std::vector<VectorRing> &loops,VectorTrianglesRef tris);
 
+/** Tesselate a group of areal features, one mesh for each.
+    If there's a worker pool we'll split them up across it.
+    Each thread reuses its own memory for the tesselator.
+  */
+void TesselateLoopsBatch(const std::vector<const std::vector<VectorRing> *> &loopSets,
+                         std::vector<VectorTrianglesRef> &tris,WorkerPool *workers = nullptr);
+
 
 }
@@ -18,6 +18,7 @@
 
 #import "Platform.h"
 #import "RawData.h"
+#import "CompressedImage.h"
 #import "Identifiable.h"
 #import "WhirlyVector.h"
 #import "BasicDrawable.h"
@@ -43,9 +44,26 @@ public:
 	/// Render side only.  Don't call this.  Destroy the openGL version
     virtual void destroyInRenderer(const RenderSetupInfo *setupInfo,Scene *scene) = 0;
 
+    /// If set, createInRenderer() only copies the data into staging memory
+    ///  and the render thread does the actual copy into the texture later.
+    /// Off by default.  Set this before handing the texture over.
+    void setAsyncUpload(bool inAsync) { asyncUpload = inAsync; }
+    bool getAsyncUpload() const { return asyncUpload; }
+
+    /// Render thread only.  Don't call this.  Finish an asynchronous upload.
+    virtual void finishUploadInRenderer(SceneRenderer *renderer) { }
+
+    /// Name the creator gave us
+    const std::string &getName() const { return name; }
+
+    /// What the texture takes up on the GPU, from its size and format
+    virtual size_t getGPUBytes() const { return 0; }
+
 protected:
     /// Used for debugging
     std::string name;
+
+    bool asyncUpload = false;
 };
     
 typedef std::shared_ptr<TextureBase> TextureBaseRef;
@@ -57,6 +75,9 @@ typedef enum {WKSingleRed,WKSingleGreen,WKSingleBlue,WKSingleRGB,WKSingleAlpha}
 typedef enum {TexTypeUnsignedByte,TexTypeShort565,TexTypeShort4444,TexTypeShort5551,TexTypeSingleChannel,TexTypeDoubleChannel,TexTypeSingleFloat16,TexTypeSingleFloat32,TexTypeDoubleFloat16,TexTypeDoubleFloat32,TexTypeQuadFloat16,TexTypeQuadFloat32,TexTypeDepthFloat32, TexTypeSingleInt16,TexTypeSingleUInt32,TexTypeDoubleUInt32,TexTypeQuadUInt32} TextureType;
 /// Interpolation types for upscaling
 typedef enum {TexInterpNearest,TexInterpLinear} TextureInterpType;
+
+/// Size of one pixel in the given format
+extern int TextureTypeBytesPerPixel(TextureType type);
     
 /** Your basic Texture representation.
     This is how you get an image sent over to the
@@ -92,6 +113,20 @@ public:
     
     /// Set up from raw PKM (ETC2/EAC) data
     void setPKMData(RawDataRef data);
+
+    /// Set up from a compressed image (PKM, KTX, KTX2 or .astc) that goes to the GPU as is.
+    /// Width and height come from the header.  Returns false if we don't recognize it.
+    bool setCompressedData(RawDataRef data);
+
+    /// Width times height in the format, plus the mipmap levels
+    virtual size_t getGPUBytes() const override;
+
+    /// True if this is block compressed data straight from a file
+    bool getIsCompressed() const { return isCompressed; }
+
+    /// Hash of the pixels along with the size, format and sampling settings.
+    /// Two textures with the same hash look the same on screen.  Zero if there's no data.
+    uint64_t getContentHash() const;
 	
     /// Set the texture width
     void setWidth(unsigned int newWidth) { width = newWidth; }
@@ -101,8 +136,9 @@ public:
     void setHeight(unsigned int newHeight) { height = newHeight; }
     /// Get the texture height
     int getHeight() const { return height; }
-    /// Set this to have a mipmap generated and used for minification
-    void setUsesMipmaps(bool use) { usesMipmaps = use; }
+    /// Set this to have a mipmap generated and used for minification.
+    /// Compressed textures can't have one generated for them.
+    void setUsesMipmaps(bool use) { usesMipmaps = use && !isCompressed; }
     /// Set this to let the texture wrap in the appropriate directions
     void setWrap(bool inWrapU,bool inWrapV) { wrapU = inWrapU;  wrapV = inWrapV; }
 
@@ -120,8 +156,9 @@ protected:
 
     /// Need to know how we're going to load it
 	bool isPVRTC;
-    /// This one has a header
-    bool isPKM;
+    /// Block compressed with a header we've already looked at
+    bool isCompressed;
+    CompressedImageInfo compressedInfo;
     /// If we're converting down to one byte, where do we get it?
     WKSingleByteSource byteSource;
 	
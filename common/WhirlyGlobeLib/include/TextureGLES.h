@@ -24,6 +24,7 @@
 #import "WhirlyVector.h"
 #import "Texture.h"
 #import "WrapperGLES.h"
+#import "MemManagerGLES.h"
 
 namespace WhirlyKit
 {
@@ -66,11 +67,35 @@ public:
     /// Render side only.  Don't call this.  Destroy the openGL version
     virtual void destroyInRenderer(const RenderSetupInfo *setupInfo,Scene *scene);
 
-    /// Sort the PKM data out from the NSData
+    /// Render thread only.  Copy a staged upload into the texture.
+    virtual void finishUploadInRenderer(SceneRenderer *renderer) override;
+
+    /// Sort the compressed data (PKM, KTX, KTX2 or .astc) out from the NSData
     /// This is static so the dynamic (haha) textures can use it
     static unsigned char *ResolvePKM(RawDataRef texData,int &pkmType,int &size,int &width,int &height);
 
+    /// GL format for a compressed image, or 0 if this device can't take it
+    static GLenum CompressedFormatGL(const CompressedImageInfo &info);
+
 protected:
+    /// Fill in the storage description for uncompressed formats.
+    /// Returns false if we can't pool this one.
+    bool getStorageKey(OpenGLMemManager::TexStorageKey &key,size_t &bytes) const;
+
+    /// Set up glId and its parameters.  Returns true if the storage is already allocated.
+    bool bindNewTexture(RenderSetupInfoGLES *setupInfo,bool canPool,const OpenGLMemManager::TexStorageKey &key);
+
+    /// Copy the data into a pixel buffer for an asynchronous upload
+    bool stageUpload(RenderSetupInfoGLES *setupInfo);
+
+    /// Pixel buffer and fence for an upload that hasn't been finished yet
+    GLuint pboId = 0;
+    GLsync uploadFence = nullptr;
+
+    /// Set if our storage came from (and will go back to) the sized texture pool
+    bool pooled = false;
+    OpenGLMemManager::TexStorageKey storageKey;
+    size_t storageBytes = 0;
 };
     
 typedef std::shared_ptr<TextureGLES> TextureGLESRef;
@@ -0,0 +1,156 @@
+/*  TileCacheStore.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <string>
+#import <vector>
+#import <mutex>
+#import <memory>
+#import <unordered_map>
+#import "RawData.h"
+#import "WhirlyTypes.h"
+
+namespace WhirlyKit
+{
+
+/** On-disk cache for fetched tiles, packed into a few big files.
+    Writing every tile to its own file gets slow once there are a lot of them, so instead
+    tiles are appended to pack files and found through a hash index.  Both the index and
+    the packs are memory mapped, so reading a tile back doesn't copy it.
+    When the cache is over its size limit the oldest pack goes, after anything in it that's
+    been used recently is copied forward.  Tiles older than the lifetime, if there is one,
+    are treated as missing.
+    Only one process should use a given directory at a time.  If the index is damaged it's
+    rebuilt from the packs.
+  */
+class TileCacheStore
+{
+public:
+    /// Store in the given directory, which is created if need be
+    TileCacheStore(std::string dir);
+    virtual ~TileCacheStore();
+
+    /// The store for a directory, shared with anyone else who asks for it
+    static std::shared_ptr<TileCacheStore> getShared(const std::string &dir);
+
+    /// Total size of the packs we'll keep around, in bytes.  0 for no limit.
+    void setMaxSize(size_t size);
+    size_t getMaxSize() const { return maxSize; }
+
+    /// Tiles written longer ago than this (in seconds) are ignored.  0 for forever.
+    void setLifetime(TimeInterval lifetime);
+    TimeInterval getLifetime() const { return lifetime; }
+
+    /// True if we have the tile and it's not too old
+    bool contains(const std::string &key);
+
+    /// Data for a tile, which points into the mapped pack.  Empty if we don't have it.
+    RawDataRef find(const std::string &key);
+
+    /// Save a tile, replacing what was there
+    bool add(const std::string &key,const void *data,size_t len);
+
+    /// Forget about a tile
+    void remove(const std::string &key);
+
+    /// Space the packs currently take up
+    size_t getSize();
+
+    /// Number of tiles we have
+    int getNumTiles();
+
+    const std::string &getDir() const { return dir; }
+
+protected:
+    // Start of the index file
+    struct IndexHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t numSlots;
+        uint32_t numEntries;
+        // Entries plus removed ones still taking up slots
+        uint32_t numUsed;
+        // Oldest and newest (being written) pack numbers
+        uint32_t firstPack;
+        uint32_t lastPack;
+        uint32_t pad;
+        uint64_t totalSize;
+    };
+
+    // One entry in the open addressed hash table
+    struct IndexSlot
+    {
+        uint64_t hash;
+        uint32_t pack;
+        uint32_t offset;
+        uint32_t len;
+        uint32_t written;
+        uint32_t accessed;
+        uint32_t state;
+    };
+
+    enum SlotState {SlotEmpty=0,SlotLive,SlotRemoved};
+
+    // A pack file mapped for reading.  Tiles we hand out keep it alive.
+    struct PackMap
+    {
+        ~PackMap();
+        const unsigned char *addr = nullptr;
+        size_t mapLen = 0;
+        // What's been written, which is less than the mapping for the newest pack
+        size_t fileLen = 0;
+    };
+    typedef std::shared_ptr<PackMap> PackMapRef;
+
+    // Everything below expects the lock to be held
+    bool openIndex();
+    void closeIndex();
+    bool createIndex(uint32_t numSlots);
+    bool rebuildIndex();
+    bool growIndex();
+    IndexSlot *findSlot(uint64_t hash,const std::string &key,bool forInsert);
+    bool isExpired(const IndexSlot &slot,uint32_t now) const;
+    void removeSlot(IndexSlot *slot);
+    bool readRecordKey(uint32_t pack,uint32_t offset,std::string &key,uint32_t &dataOffset);
+    bool appendRecord(uint64_t hash,const std::string &key,const void *data,size_t len,uint32_t written,
+                      uint32_t &pack,uint32_t &offset);
+    bool insertSlot(uint64_t hash,const std::string &key,uint32_t pack,uint32_t offset,uint32_t len,
+                    uint32_t written,uint32_t accessed);
+    bool startPack(uint32_t pack);
+    PackMapRef mapPack(uint32_t pack);
+    std::string packName(uint32_t pack) const;
+    void evictPacks();
+
+    std::string dir;
+    size_t maxSize;
+    TimeInterval lifetime;
+
+    std::mutex lock;
+    bool valid;
+    int indexFD;
+    void *indexAddr;
+    size_t indexLen;
+    IndexHeader *header;
+    IndexSlot *slots;
+    // Write position in the newest pack
+    int packFD;
+    uint32_t packLen;
+    std::unordered_map<uint32_t,PackMapRef> packMaps;
+};
+typedef std::shared_ptr<TileCacheStore> TileCacheStoreRef;
+
+}
@@ -0,0 +1,99 @@
+/*  TileFetchThrottle.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <string>
+#import <mutex>
+#import <memory>
+#import <unordered_map>
+#import "WhirlyTypes.h"
+
+namespace WhirlyKit
+{
+
+/** Works out how many fetches to have going at once to each host.
+    Every host starts out partway up its range.  We measure how much data it gets back
+    to us per second, from the answer times and sizes, over rounds several answer
+    times long.  If more connections got
+    more data, we try another one.  If they didn't, the requests are just queueing at the
+    server, so we try one fewer.  Timeouts and overloaded responses cut it back right away.
+    The fetcher is still responsible for its overall limit.
+  */
+class TileFetchThrottle
+{
+public:
+    /// Range of connections each host may be given
+    TileFetchThrottle(int minPerHost,int maxPerHost);
+
+    /// Change the range, which takes effect as fetches come and go
+    void setLimits(int minPerHost,int maxPerHost);
+
+    /// True if another fetch to the host can start now
+    bool canStart(const std::string &host);
+
+    /// A fetch to the host is underway
+    void started(const std::string &host);
+
+    /// A fetch came back with an answer, taking the given time (in seconds) for the given bytes
+    void finished(const std::string &host,TimeInterval howLong,size_t size);
+
+    /// A fetch timed out or the host told us it was overloaded
+    void failed(const std::string &host);
+
+    /// A fetch was stopped by us, so it doesn't tell us anything
+    void cancelled(const std::string &host);
+
+    /// Connections the host is currently allowed
+    int getLimit(const std::string &host);
+
+    /// Bytes per second we've been getting lately, across all the hosts.
+    /// 0 until a round has been measured.
+    double getRate();
+
+protected:
+    struct HostInfo
+    {
+        int active = 0;
+        int limit = 0;
+        // Which way we moved the limit last time
+        int direction = 1;
+        // Smoothed time from asking to having the whole answer
+        TimeInterval avgTime = 0.0;
+        // What came back in the round so far.  Bytes are scaled up by the fetches that were going at the time.
+        TimeInterval roundStart = 0.0;
+        double roundBytes = 0.0;
+        TimeInterval roundTime = 0.0;
+        int roundFetches = 0;
+        // Set if we used all the connections we had at some point in the round
+        bool roundFull = false;
+        // Bytes per second from the round before, which the limit was tuned against
+        double lastRate = 0.0;
+        // Bytes per second from the most recent round, and when it ended
+        double rate = 0.0;
+        TimeInterval rateTime = 0.0;
+    };
+
+    // Lock must be held
+    HostInfo &hostInfo(const std::string &host);
+    void endRound(HostInfo &info,TimeInterval now);
+
+    std::mutex lock;
+    int minPerHost,maxPerHost;
+    std::unordered_map<std::string,HostInfo> hosts;
+};
+typedef std::shared_ptr<TileFetchThrottle> TileFetchThrottleRef;
+
+}
@@ -0,0 +1,96 @@
+/*  TileLatencyStats.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import <mutex>
+#import <atomic>
+#import <unordered_map>
+#import <array>
+#import "WhirlyTypes.h"
+
+namespace WhirlyKit
+{
+
+/** Where the time goes for each tile a loader brings in.
+    Tiles are tracked by node number from the first request to the first frame
+    that draws them.  Only the first time through each stage counts, so a tile with
+    several frames is timed by whichever frame gets there first.
+    Stages can be marked from any thread.  We keep the last few hundred tiles that
+    made it all the way and summarize them on request.
+  */
+class TileLatencyStats
+{
+public:
+    /// Stages a tile goes through, in order
+    typedef enum {
+        Requested = 0,  // Fetch handed to the fetcher
+        Received,       // Data is back from the fetcher
+        Decoded,        // Interpreter is done and the results are back on the layer thread
+        Merged,         // Changes handed off to the scene
+        Displayed,      // Renderer applied the changes for the frame that draws them
+        NumStages
+    } Stage;
+
+    /// Readable name for the time leading up to a stage (fetch, decode, merge, display).
+    /// Requested gets "total", for the whole trip.
+    static const char *getStageName(Stage stage);
+
+    /// Distribution of the time spent getting to one stage from the one before.
+    /// The Requested entry covers the whole trip.  Times are in seconds.
+    struct Summary
+    {
+        Stage stage = Requested;
+        int numTiles = 0;
+        double minVal = 0.0, maxVal = 0.0, mean = 0.0;
+        double p50 = 0.0, p95 = 0.0;
+    };
+
+    /// Keep up to this many finished tiles around
+    TileLatencyStats(int maxTiles = 500);
+
+    /// Tracking is off by default
+    void setEnable(bool enable);
+    bool isEnabled() const { return enable.load(std::memory_order_relaxed); }
+
+    /// Note a tile reaching a stage.  Later stages are ignored for tiles we didn't see requested.
+    void mark(int64_t nodeNumber,Stage stage,TimeInterval when);
+
+    /// Stop tracking a tile that failed or went away
+    void drop(int64_t nodeNumber);
+
+    /// Summaries for the total and each stage
+    std::vector<Summary> getSummaries() const;
+
+    /// Tiles that have been requested but haven't made it to the screen
+    int getNumPending() const;
+
+    /// Toss everything
+    void clear();
+
+protected:
+    typedef std::array<TimeInterval,NumStages> Times;
+
+    std::atomic<bool> enable;
+    mutable std::mutex lock;
+    std::unordered_map<int64_t,Times> pending;
+    std::vector<Times> finished;
+    size_t maxTiles;
+    size_t nextTile = 0;
+};
+typedef std::shared_ptr<TileLatencyStats> TileLatencyStatsRef;
+
+}
@@ -0,0 +1,73 @@
+/*  TileMemoryCache.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <string>
+#import <list>
+#import <mutex>
+#import <memory>
+#import <unordered_map>
+#import "RawData.h"
+
+namespace WhirlyKit
+{
+
+/** Tile data we've fetched recently, kept in memory up to a total size.
+    Panning back and forth asks for tiles again just after the loader let go of them,
+    and this saves going back to the disk cache or the network for those.
+    The least recently used tiles are dropped first.
+  */
+class TileMemoryCache
+{
+public:
+    /// Keep up to this many bytes of tile data.  0 keeps nothing.
+    TileMemoryCache(size_t maxSize);
+
+    /// Change the size limit, dropping tiles if we're over
+    void setMaxSize(size_t size);
+    size_t getMaxSize() const { return maxSize; }
+
+    /// Data for a tile, if we still have it.  This makes it the most recently used.
+    RawDataRef find(const std::string &key);
+
+    /// Hang on to a tile's data, replacing what was there
+    void add(const std::string &key,const RawDataRef &data);
+
+    /// Forget about one tile
+    void remove(const std::string &key);
+
+    /// Forget about all of them
+    void clear();
+
+    /// Bytes of tile data we're holding
+    size_t getSize();
+
+protected:
+    typedef std::list<std::pair<std::string,RawDataRef>> EntryList;
+
+    // Drop tiles until we fit.  Lock must be held.
+    void trim();
+
+    std::mutex lock;
+    size_t maxSize;
+    size_t curSize;
+    // Most recently used first
+    EntryList entries;
+    std::unordered_map<std::string,EntryList::iterator> entriesByKey;
+};
+typedef std::shared_ptr<TileMemoryCache> TileMemoryCacheRef;
+
+}
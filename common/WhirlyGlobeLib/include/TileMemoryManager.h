@@ -0,0 +1,117 @@
+/*  TileMemoryManager.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import <mutex>
+#import <cstddef>
+#import "Platform.h"
+
+namespace WhirlyKit
+{
+
+/// What a quad loader's tiles are costing in memory
+struct TileMemoryUsage
+{
+    /// Texture and drawable bytes held right now
+    size_t bytes = 0;
+    /// Typical cost of one loaded tile
+    size_t bytesPerTile = 0;
+
+    TileMemoryUsage &operator += (const TileMemoryUsage &that)
+    {
+        bytes += that.bytes;
+        bytesPerTile += that.bytesPerTile;
+        return *this;
+    }
+};
+
+/** Shares a memory budget between all the quad loaders in the process.
+    Each display controller reports the importance of the tiles it wants
+    and what a tile costs it.  If all of that together won't fit in the budget,
+    the least important tiles lose out, whichever loader they belong to,
+    and the affected controllers are given a smaller tile limit.
+    We work from the tiles wanted rather than the ones loaded, otherwise
+    loaders would drop tiles, fit, then load them right back.
+    The budget is off (0) by default.
+  */
+class TileMemoryManager
+{
+public:
+    /// The one everyone shares
+    static TileMemoryManager &getShared();
+
+    /// Total bytes for tile textures and geometry.  0 turns the budget off.
+    void setBudget(size_t bytes);
+    size_t getBudget() const;
+
+    /** Under memory pressure, hold everyone to a fraction of what they're holding now,
+        budget or no.  The least important tiles go, which are mostly the ones barely on
+        screen or kept beyond the view.  The limit lifts after holdTime seconds.
+      */
+    void relievePressure(double fraction,TimeInterval holdTime);
+
+    /// Register a new client, returning its ID
+    int addClient();
+
+    /// Stop tracking a client
+    void removeClient(int clientID);
+
+    /** Report the importance of the tiles a client would like loaded and what they cost.
+        Returns the most tiles the client should load, or -1 if it can have them all.
+        Importance values are consumed.
+      */
+    int updateClient(int clientID,std::vector<double> &&wantedImports,const TileMemoryUsage &usage);
+
+    struct Stats
+    {
+        size_t budget = 0;
+        /// Bytes the clients say they're holding
+        size_t bytesInUse = 0;
+        /// Bytes it'd take to load everything wanted
+        size_t bytesWanted = 0;
+        int numClients = 0;
+        /// Clients being held below the tiles they want
+        int numLimited = 0;
+    };
+
+    /// Current totals (thread safe)
+    Stats getStats() const;
+
+protected:
+    TileMemoryManager() = default;
+
+    struct Client
+    {
+        int clientID = -1;
+        std::vector<double> imports;    // Sorted, most important first
+        TileMemoryUsage usage;
+        int limit = -1;
+    };
+
+    // Work out the tile limits for everyone.  Lock must be held.
+    void calcLimits();
+
+    mutable std::mutex lock;
+    size_t budget = 0;
+    // Tighter budget from relievePressure and when it runs out
+    size_t pressureBudget = 0;
+    TimeInterval pressureUntil = 0.0;
+    int nextClientID = 0;
+    std::vector<Client> clients;
+};
+
+}
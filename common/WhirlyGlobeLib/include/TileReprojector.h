@@ -0,0 +1,66 @@
+/*  TileReprojector.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "LoadedTileNew.h"
+#import "SceneRenderer.h"
+
+namespace WhirlyKit
+{
+
+/** Warps tile images on the GPU so coarse tile geometry can display them.
+    Tiles in a coordinate system other than the scene's (Proj4, BNG and so on) are
+    curved once they get to the display and normally need lots of samples to look right.
+    Instead, we draw each image once into a new texture through a finely sampled mesh,
+    placing every pixel where the coarse tile geometry will look for it.
+    The tile geometry can then be sampled as lightly as the curvature allows.
+    <br>
+    The warp is a one-shot render target pass.  The source texture, target and mesh
+    are cleaned up once the renderer has drawn it.
+  */
+class TileReprojector
+{
+public:
+    /// Builds the warps for tiles from the given builder's geometry manager and settings
+    TileReprojector(SceneRenderer *renderer,Scene *scene,
+                    const TileGeomManager &geomManage,const TileGeomSettings &geomSettings,
+                    int warpSamples);
+
+    /// True if tiles in this coordinate system need warping for this display at all
+    static bool NeedsReprojection(const TileGeomManager &geomManage);
+
+    /// True if we know how to warp this texture.  Data textures are left alone.
+    static bool CanReproject(const Texture *tex);
+
+    /// Hand back a blank texture, to be added in place of the source, that the renderer
+    ///  will fill in with the warped image.  The changes to do that go in warpChanges
+    ///  and need to be applied after the returned texture is added.
+    /// We take ownership of the source.
+    Texture *reprojectTexture(const QuadTreeNew::Node &ident,Texture *srcTex,ChangeSet &warpChanges);
+
+protected:
+    /// Grid the tile geometry will use for this tile, in display coordinates
+    void makeTileGrid(const QuadTreeNew::Node &ident,MbrD &theMbr,Point2d &texScale,
+                      int &sampleX,int &sampleY,Point3dVector &grid) const;
+
+    SceneRenderer *renderer;
+    Scene *scene;
+    const TileGeomManager &geomManage;
+    const TileGeomSettings &geomSettings;
+    int warpSamples;
+};
+
+}
@@ -0,0 +1,112 @@
+/*  TransformMath.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "WhirlyVector.h"
+
+namespace WhirlyKit
+{
+
+/** Transforms the renderers work out for each drawable, every frame.
+    Most drawables with a matrix are just moved out to a tile or object center, so
+    those get their products and inverses by adjusting a column or a row of the
+    frame's matrices, rather than multiplying and inverting whole 4x4s.
+    Everything here is fixed size, so nothing allocates.
+  */
+
+/// True if the matrix does nothing but move things
+inline bool IsTranslation(const Eigen::Matrix4d &mat)
+{
+    return mat(0,0) == 1.0 && mat(1,0) == 0.0 && mat(2,0) == 0.0 && mat(3,0) == 0.0 &&
+           mat(0,1) == 0.0 && mat(1,1) == 1.0 && mat(2,1) == 0.0 && mat(3,1) == 0.0 &&
+           mat(0,2) == 0.0 && mat(1,2) == 0.0 && mat(2,2) == 1.0 && mat(3,2) == 0.0 &&
+           mat(3,3) == 1.0;
+}
+
+/// True if the bottom row is 0,0,0,1, as it is for everything but projections
+inline bool IsAffine(const Eigen::Matrix4d &mat)
+{
+    return mat(3,0) == 0.0 && mat(3,1) == 0.0 && mat(3,2) == 0.0 && mat(3,3) == 1.0;
+}
+
+/// Inverse of an affine matrix by way of its 3x3 part.  Anything else gets the general inverse.
+inline Eigen::Matrix4d AffineInverse(const Eigen::Matrix4d &mat)
+{
+    if (!IsAffine(mat))
+        return mat.inverse();
+
+    const Eigen::Matrix3d rotInv = mat.topLeftCorner<3,3>().inverse();
+    Eigen::Matrix4d inv;
+    inv.topLeftCorner<3,3>() = rotInv;
+    inv.topRightCorner<3,1>() = -(rotInv * mat.topRightCorner<3,1>());
+    inv.row(3) << 0.0, 0.0, 0.0, 1.0;
+    return inv;
+}
+
+/// Matrices for one view offset, in doubles, that the drawables' own ones are built from
+struct FrameMatrices
+{
+    Eigen::Matrix4d mvp,mvpInv,mv,mvNormal;
+};
+
+/// Matrices handed to a drawable, in floats for the shaders
+struct DrawMatrices
+{
+    DrawMatrices() = default;
+    /// Straight from the frame, for drawables without a matrix
+    explicit DrawMatrices(const FrameMatrices &frame) :
+        mvp(frame.mvp.cast<float>()), mvpInv(frame.mvpInv.cast<float>()),
+        mv(frame.mv.cast<float>()), mvNormal(frame.mvNormal.cast<float>()) { }
+
+    Eigen::Matrix4f mvp,mvpInv,mv,mvNormal;
+};
+
+/** Fold a drawable's matrix into the frame's.
+    The products are done in doubles and rounded to floats once at the end, so geometry
+    stored relative to a center stays steady up close.
+  */
+inline void CalcDrawMatrices(const FrameMatrices &frame,const Eigen::Matrix4d &localMat,DrawMatrices &out)
+{
+    if (IsTranslation(localMat))
+    {
+        // M*T only changes the last column; T^-1*M only changes the top three rows
+        const Eigen::Vector4d trans(localMat(0,3),localMat(1,3),localMat(2,3),1.0);
+        const Eigen::Vector3d trans3 = trans.head<3>();
+
+        out.mvp.leftCols<3>() = frame.mvp.leftCols<3>().cast<float>();
+        out.mvp.col(3) = (frame.mvp * trans).cast<float>();
+
+        out.mv.leftCols<3>() = frame.mv.leftCols<3>().cast<float>();
+        out.mv.col(3) = (frame.mv * trans).cast<float>();
+
+        out.mvpInv.topRows<3>() = (frame.mvpInv.topRows<3>() - trans3 * frame.mvpInv.row(3)).cast<float>();
+        out.mvpInv.row(3) = frame.mvpInv.row(3).cast<float>();
+
+        // (MT)^-T = M^-T T^-T, and T^-T is the identity with -t along the bottom
+        out.mvNormal.leftCols<3>() = (frame.mvNormal.leftCols<3>() - frame.mvNormal.col(3) * trans3.transpose()).cast<float>();
+        out.mvNormal.col(3) = frame.mvNormal.col(3).cast<float>();
+    }
+    else
+    {
+        const Eigen::Matrix4d localInv = AffineInverse(localMat);
+        out.mvp = (frame.mvp * localMat).cast<float>();
+        out.mv = (frame.mv * localMat).cast<float>();
+        out.mvpInv = (localInv * frame.mvpInv).cast<float>();
+        out.mvNormal = (frame.mvNormal * localInv.transpose()).cast<float>();
+    }
+}
+
+}
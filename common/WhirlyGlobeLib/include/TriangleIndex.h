@@ -0,0 +1,110 @@
+/*  TriangleIndex.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import <unordered_map>
+#import "Identifiable.h"
+#import "WhirlyVector.h"
+#import "BoundsHierarchy.h"
+
+namespace WhirlyKit
+{
+
+/** Bounding volume hierarchy over triangles in display space, for exact ray hits.
+    Triangles are added in groups, one per object (a tile, a building), and come and go together.
+    The leaves keep their triangles four to a packet, as floats relative to the leaf,
+    so the ray tests run four at a time and the compiler can use vector instructions for them.
+    As with the SelectionIndex, additions go on a list we look through directly and removals
+    are just marked, until there are enough of either to rebuild the tree on the next query.
+    Not thread safe.  The owner should hold its own lock around all of it.
+  */
+class TriangleIndex
+{
+public:
+    /// Add triangles for an object, three points to each, replacing any it already had
+    void add(SimpleIdentity objID,const Point3dVector &tris,bool enable = true);
+
+    /// Add the faces of a polytope, split into fans.  The points are offsets from center.
+    void addPolygons(SimpleIdentity objID,const Point3d &center,const std::vector<Point3fVector> &polys,bool enable = true);
+
+    /// Take an object's triangles out
+    void remove(SimpleIdentity objID);
+
+    /// Disabled objects stay in the index, but aren't hit
+    void setEnable(SimpleIdentity objID,bool enable);
+
+    /// Number of objects in the index
+    size_t size() const { return where.size(); }
+
+    /** Find the nearest triangle the ray from org along dir hits, closer than maxT.
+        t comes back in multiples of dir, so it's a distance if dir is normalized.
+      */
+    bool findClosest(const Point3d &org,const Point3d &dir,double maxT,SimpleIdentity &hitID,double &t);
+
+    /// Every object the ray hits and the nearest t for each, added to hits
+    void findAll(const Point3d &org,const Point3d &dir,std::unordered_map<SimpleIdentity,double> &hits);
+
+protected:
+    struct Group
+    {
+        SimpleIdentity objID;
+        Point3dVector tris;
+        bool enable;
+        bool live;
+    };
+
+    // Four triangles as a corner and two edges, one lane each, relative to the leaf's corner.
+    // Empty lanes have zero edges and group -1.
+    struct Packet
+    {
+        float v0[3][4];
+        float e1[3][4];
+        float e2[3][4];
+        int group[4];
+    };
+
+    // Leaves have packets, interior nodes have children
+    typedef BoundsHierarchyNode<Point3d> Node;
+
+    // A triangle while we're building
+    struct TriRef
+    {
+        int group,tri;
+        Point3d center;
+    };
+
+    // Toss the removed groups and sort everything into a new tree
+    void rebuild();
+    // Where the ray enters the box, if it does before maxT
+    static bool rayHitsBox(const Point3d &ll,const Point3d &ur,const Point3d &org,const Point3d &invDir,double maxT,double &tEnter);
+    // Check against a triangle the slow way, for those not in the tree yet
+    static bool rayHitsTri(const Point3d &org,const Point3d &dir,const Point3d *tri,double &t);
+    // Look at everything the ray hits.  The callback gets the group and t and returns the t to stop looking past.
+    template<typename T> void traverse(const Point3d &org,const Point3d &dir,double maxT,T &&hit);
+
+    std::vector<Group> groups;
+    std::vector<Node> nodes;
+    std::vector<Packet> packets;
+    // Groups past this were added since the tree was built
+    size_t numIndexed = 0;
+    // Triangles in the tree, in groups that have been added since, and in groups that have been removed
+    size_t numIndexedTris = 0, numPendingTris = 0, numDeadTris = 0;
+    // Where each object is in the groups
+    std::unordered_map<SimpleIdentity,size_t> where;
+};
+
+}
@@ -26,6 +26,8 @@ namespace WhirlyKit
  
 // Triangle shader with lighting
 ProgramGLES *BuildDefaultTriShaderLightingGLES(const std::string &name,SceneRenderer *renderer);
+// Lit triangles raised off the ground by a_height, for lofted polys
+ProgramGLES *BuildDefaultTriShaderExtrudeGLES(const std::string &name,SceneRenderer *renderer);
 // Triangle shader without lighting
 ProgramGLES *BuildDefaultTriShaderNoLightingGLES(const std::string &name,SceneRenderer *renderer);
 // Triangle shader for models
@@ -34,6 +36,10 @@ ProgramGLES *BuildDefaultTriShaderModelGLES(const std::string &name,SceneRendere
 ProgramGLES *BuildDefaultTriShaderScreenTextureGLES(const std::string &name,SceneRenderer *renderer);
 // Triangles with multiple textures
 ProgramGLES *BuildDefaultTriShaderMultitexGLES(const std::string &name,SceneRenderer *renderer);
+// Triangles with up to four textures layered together
+ProgramGLES *BuildDefaultTriShaderCompositeGLES(const std::string &name,SceneRenderer *renderer);
+// Triangles raised by an elevation texture in the second slot
+ProgramGLES *BuildDefaultTriShaderTerrainGLES(const std::string &name,SceneRenderer *renderer);
 // Triangles that use the ramp textures
 ProgramGLES *BuildDefaultTriShaderRamptexGLES(const std::string &name,SceneRenderer *renderer);
 // Day/night support for triangles
@@ -279,7 +279,73 @@ public:
 protected:
     VectorPoints();
 };
-    
+
+/** Compact storage for a group of shapes that need to stay resident, but aren't being looked at.
+    Linear, areal and point coordinates are quantized to a grid of the given number of bits
+    across the bounding box, then delta and varint encoded, typically to 2-4 bytes per vertex
+    rather than 8 plus allocation overhead.  Attribute dictionaries are shared, not copied.
+    Other shape types are kept as they are.  Decoding gives new shapes, so it's safe from any thread.
+  */
+class CompactShapeSet
+{
+public:
+    CompactShapeSet() = default;
+
+    /// Encode the given shapes.  16 bits is fine for a tile, use more for large extents.
+    template <typename TIter>
+    CompactShapeSet(TIter begin,TIter end,int bits = 16) { encode(begin,end,bits); }
+
+    /// Decode into new shapes
+    void decode(std::vector<VectorShapeRef> &shapes) const;
+    void decode(ShapeSet &shapes) const;
+
+    /// Number of shapes held
+    size_t size() const { return attrs.size(); }
+    bool empty() const { return attrs.empty(); }
+
+    /// Approximate memory used
+    size_t getBytes() const;
+
+protected:
+    template <typename TIter>
+    void encode(TIter begin,TIter end,int bits);
+    void setup(const Point2dVector &bounds,int bits);
+    void encodeShape(const VectorShapeRef &shape);
+    void encodeRing(const VectorRing &ring);
+    template <typename TFunc> void decodeAll(TFunc &&addFn) const;
+    size_t decodeRing(size_t pos,VectorRing &ring) const;
+
+    // Quantization grid
+    Point2d org = { 0, 0 };
+    Point2d scale = { 1, 1 };
+
+    std::vector<uint8_t> data;
+    std::vector<MutableDictionaryRef> attrs;
+    // Shapes we don't encode, in order, with a marker in the data
+    std::vector<VectorShapeRef> others;
+};
+
+template <typename TIter>
+void CompactShapeSet::encode(TIter begin,TIter end,int bits)
+{
+    Point2dVector bounds;
+    for (auto it = begin; it != end; ++it)
+    {
+        const GeoMbr mbr = (*it)->calcGeoMbr();
+        if (mbr.valid())
+        {
+            bounds.emplace_back(mbr.ll().x(),mbr.ll().y());
+            bounds.emplace_back(mbr.ur().x(),mbr.ur().y());
+        }
+    }
+    setup(bounds,bits);
+    for (auto it = begin; it != end; ++it)
+    {
+        encodeShape(*it);
+    }
+    data.shrink_to_fit();
+}
+
 /// A set of strings
 typedef std::set<std::string> StringSet;
 
@@ -0,0 +1,65 @@
+/*  VectorLOD.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import "VectorData.h"
+#import "Dictionary.h"
+
+namespace WhirlyKit
+{
+
+/** Settings for building simplified versions of vector data for lower zoom levels.
+    Full detail is shown from maxZoom up.  Below that each level covers two zoom levels
+    and is simplified to the given tolerance in pixels, with the last one going all the way down.
+    This only works with a zoom slot, since that's how the drawables get switched.
+  */
+struct VectorLODSettings
+{
+    VectorLODSettings() = default;
+    VectorLODSettings(const Dictionary &dict);
+
+    /// Levels of detail to build below the full one
+    int levels = 0;
+    /// Zoom level where full detail starts
+    double maxZoom = 12.0;
+    /// How far a simplified line can stray, in pixels
+    double tolerance = 1.0;
+    /// Pixel size of a tile, which sets the scale of a zoom level
+    double tileSize = 256.0;
+};
+
+/// One level of detail: the zoom range to show it in and how much to simplify
+struct VectorLOD
+{
+    double minZoomVis,maxZoomVis;
+    /// In radians of longitude (Spherical Mercator units).  0 is full detail.
+    double eps;
+};
+
+/// Work out the levels for the given settings, clipped to the zoom range the data is shown in
+std::vector<VectorLOD> CalcVectorLODs(const VectorLODSettings &settings,double minZoomVis,double maxZoomVis);
+
+/// Douglas-Peucker simplification in Spherical Mercator, so the tolerance is the same size everywhere.
+/// Closed rings keep at least a triangle, or come back empty if they're smaller than that.
+void SimplifyLine(const VectorRing &inPts,VectorRing &outPts,bool closed,double eps);
+void SimplifyLine(const VectorRing3d &inPts,VectorRing3d &outPts,bool closed,double eps);
+
+/// Simplified copies of the linear and areal features, sharing their attributes.
+/// Anything that simplifies away is left out and other shape types are passed through.
+void SimplifyShapes(const std::vector<VectorShapeRef> &inShapes,double eps,std::vector<VectorShapeRef> &outShapes);
+
+}
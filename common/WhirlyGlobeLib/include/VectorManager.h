@@ -22,6 +22,7 @@
 #import <vector>
 #import <set>
 #import <map>
+#import <unordered_map>
 #import "SceneRenderer.h"
 #import "BasicDrawableBuilder.h"
 #import "BasicDrawableInstanceBuilder.h"
@@ -30,6 +31,8 @@
 #import "Dictionary.h"
 #import "Scene.h"
 #import "BaseInfo.h"
+#import "WorkerPool.h"
+#import "VectorLOD.h"
 
 namespace WhirlyKit
 {
@@ -84,6 +87,7 @@ public:
     bool                        closeAreals = true;
     bool                        selectable = true;
     Point2f                     vecCenter = { 0.0f, 0.0f };
+    VectorLODSettings           lod;
     FloatExpressionInfoRef      opacityExp;
     ColorExpressionInfoRef      colorExp;
 };
@@ -104,9 +108,15 @@ public:
     SimpleIdentity addVectors(const std::vector<VectorShapeRef> &shapes,const VectorInfo &desc,ChangeSet &changes);
     SimpleIdentity addVectors(const ShapeSet *shapes,const VectorInfo &desc,ChangeSet &changes);
     SimpleIdentity addVectors(const std::vector<VectorShapeRef> *shapes,const VectorInfo &desc,ChangeSet &changes);
+    /// Decode compact vectors just long enough to build them
+    SimpleIdentity addVectors(const CompactShapeSet &shapes,const VectorInfo &desc,ChangeSet &changes);
 
     /// Change the vector(s) represented by the given ID
     void changeVectors(SimpleIdentity vecID,const VectorInfo &vecInfo,ChangeSet &changes);
+
+    /// Change lots of vectors at once, each to its own description.
+    /// This takes the lock once and makes one change per drawable.
+    void changeVectors(const std::unordered_map<SimpleIdentity,VectorInfoRef> &vecInfos,ChangeSet &changes);
     
     /// Make an instance of the given vectors with the given attributes and return an ID to identify them.
     SimpleIdentity instanceVectors(SimpleIdentity vecID,const VectorInfo &vecInfo,ChangeSet &changes);
@@ -116,9 +126,27 @@ public:
     
     /// Enable/disable vector data
     void enableVectors(SimpleIDSet &vecIDs,bool enable,ChangeSet &changes);
+
+    /** Tessellate filled areals on this many extra threads, when there are enough of them.
+        0 does them all on the calling thread.  The default is WorkerPool::getDefaultNumThreads(),
+        and those threads aren't started until the first vectors are added.
+      */
+    void setTessThreads(int numThreads);
+    int getTessThreads();
     
 protected:
+    WorkerPoolRef getTessWorkers();
+
+    // Build each level of detail on its own and gather them up under one ID
+    SimpleIdentity addVectorLODs(const std::vector<VectorShapeRef> &shapes,const VectorInfo &vecInfo,ChangeSet &changes);
+
+    // Restyle the drawables for one set of vectors.  Lock must be held.
+    static void changeSceneRep(const VectorSceneRep &sceneRep,const VectorInfo &vecInfo,ChangeSet &changes);
+
     VectorSceneRepSet vectorReps;
+    WorkerPoolRef tessWorkers;
+    // Negative until someone sets it, then we use the default
+    int tessThreads = -1;
 };
 typedef std::shared_ptr<VectorManager> VectorManagerRef;
 
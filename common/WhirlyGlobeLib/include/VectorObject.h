@@ -65,6 +65,13 @@ public:
     
     /// Make a complete company (nothing shared) and return it
     VectorObjectRef deepCopy() const;
+
+    /** Make a copy that shares the shapes until one side or the other changes them.
+        The in-place edits below (subdividing, reprojecting, closing loops and such) copy
+        any shapes that are still shared first.  The attribute dictionaries stay shared,
+        so use deepCopy if the attributes are going to be edited separately.
+      */
+    VectorObjectRef copyOnWrite() const;
     
     /// Dump everything to a string for debugging
     std::string log() const;
@@ -74,6 +81,9 @@ public:
     
     /// Merge in vectors from the other object
     void mergeVectorsFrom(const VectorObject &other);
+
+    /// Merge in vectors from the other object, which is left empty
+    void mergeVectorsFrom(VectorObject &&other);
     
     /// @brief Returns one shape per VectorObject
     void splitVectors(std::vector<VectorObject *> &vecs);
@@ -104,12 +114,25 @@ public:
     bool pointNearLinear(const Point2d &coord,float maxDistance,
                          const ViewStateRef &viewState,
                          const Point2f &frameBufferSize) const;
+
+    /// Geographic area around coord that pointNearLinear will look at for maxDistance.
+    /// False if coord doesn't land on the screen, in which case nothing is near it.
+    static bool nearSearchBounds(const Point2d &coord,float maxDistance,
+                                 const ViewStateRef &viewState,
+                                 const Point2f &frameBufferSize,
+                                 GeoMbr &bounds);
     
     /// Calculate the area of all the loops together
     double areaOfOuterLoops() const;
     
     /// Bounding box of all the various features together
     bool boundingBox(Point2d &ll,Point2d &ur) const;
+
+    /// Quantized copy of the shapes for keeping around cheaply
+    CompactShapeSet compact(int bits = 16) const { return CompactShapeSet(shapes.begin(),shapes.end(),bits); }
+
+    /// Replace our shapes with the decoded contents of a compact set
+    void uncompact(const CompactShapeSet &compactShapes);
     
     /**
      Subdivide the edges in this feature to a given tolerance.
@@ -233,6 +256,15 @@ public:
 public:
     void subdivideToInternal(float epsilon,WhirlyKit::CoordSystemDisplayAdapter *adapter,bool geolib,bool edgeMode);
 
+    /// Copy of a shape's geometry, with its attributes copied or shared
+    static VectorShapeRef CopyShape(const VectorShape *shape,bool copyAttrs);
+
+    /// Before an in-place edit, copy any shapes we're sharing from copyOnWrite
+    void unshareShapes();
+
+    // Set by copyOnWrite on both sides, so either one knows to check before editing
+    mutable bool sharedShapes = false;
+
     bool selectable;
     ShapeSet shapes;
 };
@@ -0,0 +1,87 @@
+/*  VectorObjectIndex.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import <unordered_map>
+#import "Identifiable.h"
+#import "WhirlyVector.h"
+#import "BoundsHierarchy.h"
+
+namespace WhirlyKit
+{
+
+/** Bounding box hierarchy over the geographic bounds of the vector objects kept in component objects.
+    The component manager uses it to narrow down feature queries to the vectors near the point.
+    Each component object can have any number of vectors, which come and go together.
+    Like the SelectionIndex, additions go on a list we look through directly and removals are
+    just marked, until there are enough of either to rebuild the tree on the next query.
+    Not thread safe.  The owner should hold its own lock around all of it.
+  */
+class VectorObjectIndex
+{
+public:
+    /// A vector that might be near, by its component object and where it is in that object's vectors
+    struct Candidate
+    {
+        SimpleIdentity compID;
+        int which;
+    };
+
+    /// Add the bounds for one of a component object's vectors
+    void add(SimpleIdentity compID,int which,const Point2d &ll,const Point2d &ur);
+
+    /// Take out all of a component object's vectors
+    void remove(SimpleIdentity compID);
+
+    /// Number of vectors in the index
+    size_t size() const { return entries.size() - numDead; }
+
+    /// Vectors whose bounds overlap the given box.  Results are appended.
+    void query(const Point2d &ll,const Point2d &ur,std::vector<Candidate> &results);
+
+protected:
+    struct Entry
+    {
+        Point2d ll,ur;
+        SimpleIdentity compID;
+        int which;
+        bool live;
+    };
+
+    // Leaves have entries, interior nodes have children
+    typedef BoundsHierarchyNode<Point2d> Node;
+
+    // Toss the removed entries and sort everything into a new tree
+    void rebuild();
+
+    static bool overlaps(const Point2d &ll0,const Point2d &ur0,const Point2d &ll1,const Point2d &ur1)
+    {
+        return ll0.x() <= ur1.x() && ur0.x() >= ll1.x() && ll0.y() <= ur1.y() && ur0.y() >= ll1.y();
+    }
+
+    // Point2d wants to be aligned
+    std::vector<Entry,Eigen::aligned_allocator<Entry>> entries;
+    std::vector<Node,Eigen::aligned_allocator<Node>> nodes;
+    // Entries past this were added since the tree was built
+    size_t numIndexed = 0;
+    // Entries marked removed, but still in the list
+    size_t numDead = 0;
+    // Where each component object's vectors are in the entries
+    std::unordered_multimap<SimpleIdentity,size_t> where;
+};
+
+}
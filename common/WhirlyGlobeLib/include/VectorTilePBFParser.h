@@ -57,6 +57,13 @@ public:
         std::vector<VectorObjectRef>* keepVectors = nullptr,
         CancelFunction isCancelled = [](auto){return false;});
 
+    /** The data belongs to a tile above ours, with these bounds.
+        Features are decoded relative to that tile, then clipped to our own
+        bounds with vertices closer together than a pixel or so thrown out.
+        Call this before parse.
+      */
+    void setSourceBounds(const MbrD &srcBBox);
+
     bool parse(const uint8_t* data, size_t length);
 
     unsigned getLayerCount() const { return _layerCount; }
@@ -121,14 +128,27 @@ private:
         SmallValueType type;
     };
 
+    // Packed geometry, left encoded in the tile data until a style wants the feature
+    struct GeomView
+    {
+        This *parser = nullptr;
+        const uint8_t *data = nullptr;
+        size_t bytes = 0;
+        // Set if we had to decode it into _featureGeometry instead
+        bool copied = false;
+    };
+
     struct Feature
     {
         uint32_t tagIndex;
         uint32_t geomIndex;
         MapnikGeometryType geomType;
-        Feature() : tagIndex(0), geomIndex(0), geomType(GeomTypeUnknown) {}
-        Feature(uint32_t tagIdx, uint32_t geomIdx, MapnikGeometryType gType)
-            : tagIndex(tagIdx), geomIndex(geomIdx), geomType(gType) { }
+        const uint8_t *geomData;
+        uint32_t geomBytes;
+        Feature() : tagIndex(0), geomIndex(0), geomType(GeomTypeUnknown), geomData(nullptr), geomBytes(0) {}
+        Feature(uint32_t tagIdx, uint32_t geomIdx, MapnikGeometryType gType, const GeomView &geom)
+            : tagIndex(tagIdx), geomIndex(geomIdx), geomType(gType),
+              geomData(geom.copied ? nullptr : geom.data), geomBytes(geom.copied ? 0 : (uint32_t)geom.bytes) { }
     };
 
 private:
@@ -141,6 +161,8 @@ private:
     static bool stringDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg);
     static bool stringVecDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg);
     static bool intVecDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg);
+    static bool geomViewDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg);
+    static bool decodePackedInts(const uint8_t *data, size_t bytes, std::vector<uint32_t> &vec);
     static bool valueVecDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg);
 
     // Wrapped callbacks
@@ -149,11 +171,19 @@ private:
 
     // Parsing methods
     inline bool processTags(const MutableDictionaryCRef &attributes, size_t tagIdx, size_t geomIdx, const Feature &feature);
+    inline bool checkUUIDTag(size_t tagIdx, const Feature &feature) const;
+    inline const std::string &layerKeyString(uint32_t keyIndex);
+    inline const std::string &layerValueString(uint32_t valueIndex);
+    inline bool inTileData(const uint8_t *data, size_t bytes) const;
+    inline void setupLayerKeys(const std::string &layerName);
     inline bool checkStyles(SimpleIDUSet& styleIDs, const MutableDictionaryCRef &attributes, const std::string &layerName);
     inline void parseLineString(const uint32_t *geometry, size_t geomCount, ShapeSet& shapes) const;
     inline bool parsePolygon(const uint32_t *geometry, size_t geomCount, VectorAreal& shape);
     inline bool parsePoints(const uint32_t *geometry, size_t geomCount, VectorPoints& shape);
     inline void addFeature(const VectorObjectRef &vecObj, const SimpleIDUSet &styleIDs);
+    inline Point2d toOutput(double fx, double fy) const;
+    void thinRing(VectorRing &ring, bool closed) const;
+    void clipFeature(VectorObject &vecObj) const;
     inline void layerElement();
     inline bool layerStart();
     inline bool layerFinish();
@@ -181,6 +211,18 @@ private:
     std::vector<Feature> _features;
     std::vector<std::string_view> _layerKeys;
     std::vector<SmallValue> _layerValues;
+    // Strings made from the keys and values above, as features need them
+    std::vector<std::string> _layerKeyStrings;
+    std::vector<std::string> _layerValueStrings;
+    std::vector<bool> _haveValueStrings;
+    // Keys the styles want for this layer, empty if they want them all
+    std::vector<bool> _layerKeyWanted;
+    std::set<std::string> _styleKeys;
+    // Geometry for the feature we're working on, decoded from its view
+    std::vector<uint32_t> _geomScratch;
+    // The tile we're parsing
+    const uint8_t *_data = nullptr;
+    size_t _dataLength = 0;
     std::string _parseError;
 
 private:
@@ -200,14 +242,19 @@ private:
     VectorRing tempRing;
 
     // State used during parsing
-    const MbrD _bbox;
-    const double _bboxWidth;
-    const double _bboxHeight;
+    MbrD _bbox;
+    double _bboxWidth;
+    double _bboxHeight;
     
-    const double _sx;
-    const double _sy;
-    const double _tileOriginX;
-    const double _tileOriginY;
+    double _sx;
+    double _sy;
+    double _tileOriginX;
+    double _tileOriginY;
+
+    // Set when we're decoding an ancestor's data, in output coordinates
+    bool _clip = false;
+    Mbr _clipMbr;
+    double _minVertDist2 = 0.0;
     
     unsigned _layerCount = 0;
     unsigned _featureCount = 0;
@@ -0,0 +1,100 @@
+/*  VectorTiler.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <mutex>
+#import <unordered_map>
+#import <vector>
+#import "VectorData.h"
+#import "QuadTreeNew.h"
+
+namespace WhirlyKit
+{
+
+/// Settings for cutting up vectors into tiles
+struct VectorTilerSettings
+{
+    /// Deepest level we'll make tiles for
+    int maxZoom = 14;
+    /// Levels we split everything down to up front
+    int indexMaxZoom = 5;
+    /// Tiles with fewer points than this aren't split up front, only when asked for
+    int indexMaxPoints = 100000;
+    /// How far a simplified line can stray, in pixels
+    double tolerance = 3.0;
+    /// Extra around the edges of a tile to clip to, in pixels, so lines and outlines don't stop short
+    double buffer = 16.0;
+    /// Pixel size of a tile, which sets the scale for the two above
+    double tileSize = 256.0;
+};
+
+/** Cuts a big set of vectors up into Spherical Mercator tiles, in the manner of geojson-vt.
+    The vectors are clipped down the levels of a quad tree, to indexMaxZoom or until
+    a tile is small enough, and the rest of the way on demand as tiles are asked for.
+    What comes back for a tile is clipped to it, plus the buffer, and simplified for its
+    level, so only what a loader can see gets built into drawables.
+    Tiles use the quad tree convention of y going up from the south.
+  */
+class VectorTiler
+{
+public:
+    VectorTiler(const VectorTilerSettings &settings);
+
+    /// Add shapes to the data set.  Areals, linears and points are kept.
+    /// Do this before asking for any tiles.
+    void addShapes(const ShapeSet &shapes);
+
+    /// Shapes for the given tile.  They share attributes with the originals.
+    /// Empty if there's nothing there or it's past maxZoom.  Thread safe.
+    std::vector<VectorShapeRef> getTile(int x,int y,int level);
+
+    const VectorTilerSettings &getSettings() const { return settings; }
+
+    /// Tiles we're holding on to at the moment
+    int getNumTiles();
+
+protected:
+    struct Tile
+    {
+        // Clipped, but at full detail.  Cleared once the tile has been split.
+        std::vector<VectorShapeRef> source;
+        // Clipped and simplified for the tile's level
+        std::vector<VectorShapeRef> shapes;
+        size_t numPoints = 0;
+    };
+
+    // Make the tile from shapes already clipped to it
+    Tile &makeTile(const QuadTreeNew::Node &node,std::vector<VectorShapeRef> &&source);
+
+    // Clip a tile's source into its children, which it gives up
+    void splitTile(const QuadTreeNew::Node &node,Tile &tile);
+
+    // Cut down the whole data set to indexMaxZoom or indexMaxPoints
+    void buildIndex();
+
+    // Geographic bounds of a tile, with the buffer if asked for
+    Mbr tileMbr(const QuadTreeNew::Node &node,bool buffered) const;
+
+    VectorTilerSettings settings;
+    std::vector<VectorShapeRef> allShapes;
+    bool built;
+
+    std::mutex lock;
+    std::unordered_map<int64_t,Tile> tiles;
+};
+typedef std::shared_ptr<VectorTiler> VectorTilerRef;
+
+}
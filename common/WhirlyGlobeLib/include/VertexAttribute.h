@@ -38,9 +38,27 @@ typedef enum {
     BDFloatType  = 4,
     BDIntType    = 5,
     BDInt64Type = 6,
+    // Compact types, 32 bits each.  They're added as floats and the GPU expands
+    // them back on the way in, so the shaders still see floats.
+    BDHalf2Type = 7,        // Two half floats, added as a Vector2f
+    BDShort2NormType = 8,   // Two shorts normalized to [-1,1], added as a Vector2f
+    BDChar4NormType = 9,    // Three bytes normalized to [-1,1] and a pad, added as a Vector3f.  For normals.
     BDDataTypeMax
 } BDAttributeDataType;
 
+/// True for the types that are stored packed, rather than as the values they were added as
+bool IsCompactAttributeType(BDAttributeDataType dataType);
+
+/// Nearest half float, as the bits
+uint16_t FloatToHalf(float val);
+/// Back to a regular float
+float HalfToFloat(uint16_t half);
+
+/// Pack a value the way a compact attribute type stores it
+uint32_t PackHalf2(const Eigen::Vector2f &vec);
+uint32_t PackShort2Norm(const Eigen::Vector2f &vec);
+uint32_t PackChar4Norm(const Eigen::Vector3f &vec);
+
 /// Used to keep track of attributes (other than points)
 class VertexAttribute
 {
@@ -90,9 +108,18 @@ public:
     
     /// Clean out the data array
     void clear();
+
+    /// Add the other attribute's data on to the end of ours.  False if the types don't match.
+    bool append(const VertexAttribute &that);
+
+    /// Add elements read out of an interleaved buffer, one every stride bytes
+    void appendStrided(const unsigned char *src,int count,int stride);
     
     /// Return a pointer to the given element
     void *addressForElement(int which);
+
+    /// The default value packed like one of our elements, for the compact types
+    uint32_t packedDefault() const;
     
 public:
     /// Data type for the attribute data
@@ -45,6 +45,7 @@
 #import "Identifiable.h"
 #import "ImageTile.h"
 #import "IntersectionManager.h"
+#import "ElevationManager.h"
 #import "LabelManager.h"
 #import "LabelRenderer.h"
 #import "LayoutManager.h"
@@ -73,6 +74,7 @@
 #import "ParticleSystemManager.h"
 #import "PerformanceTimer.h"
 #import "Platform.h"
+#import "PointCloudLoader.h"
 #import "Program.h"
 #import "Proj4CoordSystem.h"
 #import "QuadDisplayControllerNew.h"
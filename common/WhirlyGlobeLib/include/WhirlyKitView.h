@@ -21,6 +21,7 @@
 #import "WhirlyTypes.h"
 #import "WhirlyVector.h"
 #import "CoordSystem.h"
+#import "GlobeMath.h"
 
 namespace WhirlyKit
 {
@@ -46,6 +47,10 @@ struct ViewAnimationDelegate
 
     /// Called every tick to update the view position
     virtual void updateView(WhirlyKit::View *) = 0;
+
+    /// Move the given view (a copy) to where this animation will have it
+    ///  the given number of seconds from now.  Return false if we can't say.
+    virtual bool predictView(WhirlyKit::View *,TimeInterval ahead) { return false; }
 };
 
 /** Whirly Kit View is the base class for the views
@@ -126,6 +131,13 @@ public:
     /// Generate a ViewState corresponding to this view
     virtual ViewStateRef makeViewState(SceneRenderer *renderer) = 0;
 
+    /** The view state for where the view is now, shared with everyone else who asks.
+        A new one is only made when the matrices or the frame size change, so the renderer,
+        layout, selection and the tile loaders all work from the same snapshot and don't
+        each redo the inverses.  Treat it as read only.  Safe to call from any thread.
+      */
+    ViewStateRef getViewState(SceneRenderer *renderer);
+
     /// Add a watcher delegate.  Call this on the main thread.
     virtual void addWatcher(ViewWatcher *delegate);
     
@@ -147,10 +159,19 @@ public:
     WhirlyKit::CoordSystemDisplayAdapter *coordAdapter = nullptr;
     /// If set, we'll scale the near and far clipping planes as we get closer
     bool continuousZoom = false;
+    /// How far ahead (in seconds) we ask animations where they're going.  0 to turn off.
+    TimeInterval predictionTime = 1.5;
     
     /// Called when positions are updated
     ViewWatcherSet watchers;
     std::mutex watcherLock;
+
+protected:
+    // Last shared view state and what it was made from
+    std::mutex viewStateLock;
+    ViewStateRef sharedViewState;
+    Eigen::Matrix4d sharedModelMat,sharedViewMat,sharedProjMat;
+    Point2f sharedFrameSize = { 0, 0 };
 };
     
 typedef std::shared_ptr<View> ViewRef;
@@ -162,7 +183,7 @@ typedef std::shared_ptr<View> ViewRef;
 class ViewState
 {
 public:
-    ViewState() : near(0), far(0) { }
+    ViewState() : frameSize(0,0), horizonDist(0), near(0), far(0) { }
     ViewState(View *view,WhirlyKit::SceneRenderer *renderer);
     virtual ~ViewState() = default;
     
@@ -182,6 +203,15 @@ public:
     
     /// Compare this view state to the other one.  Returns true if they're identical.
     bool isSameAs(const ViewState *other) const;
+
+    /// True if any of a sphere in display space is inside the frustum for the given offset matrix
+    bool sphereInFrustum(const Point3d &center,double radius,unsigned int offset = 0) const;
+
+    /// True if a point in display space is around the far side of the globe.  Always false for flat maps.
+    bool isPastHorizon(const Point3d &dispPt) const { return horizon.isHidden(dispPt); }
+
+    /// True if everything in the bound is around the far side of the globe.  Always false for flat maps.
+    bool isPastHorizon(const HorizonBound &bound) const { return horizon.isHidden(bound); }
     
     /// Return true if the view state has been set to something
     bool isValid() const { return near != far; }
@@ -192,6 +222,19 @@ public:
     Eigen::Matrix4d modelMatrix,projMatrix;
     std::vector<Eigen::Matrix4d> viewMatrices,invViewMatrices,fullMatrices,fullNormalMatrices,invFullMatrices;
     Eigen::Matrix4d invModelMatrix,invProjMatrix;
+    /// The view matrix and its combinations without any wrapping offset, as the renderer wants them
+    Eigen::Matrix4d viewMatrix,fullMatrix,invFullMatrix,fullNormalMatrix,mvpMatrix,invMvpMatrix,mvpNormalMatrix;
+    /// Wrapping offsets and the projection combined with each
+    std::vector<Eigen::Matrix4d> offsetMatrices,mvpMatrices,invMvpMatrices,mvpNormalMatrices;
+    /// Six planes (left, right, bottom, top, near, far) for each offset matrix, in display space.
+    /// Points inside give a positive distance.
+    Vector4dVector frustumPlanes;
+    /// Frame buffer size this was made for
+    Point2f frameSize;
+    /// Distance from the eye to the horizon, for a globe.  0 for flat maps.
+    double horizonDist;
+    /// Horizon checks from this eye position, for a globe
+    HorizonCuller horizon;
     double fieldOfView;
     double imagePlaneSize;
     double nearPlane;
@@ -204,6 +247,10 @@ public:
     
     /// Calculate where the eye is in model coordinates
     Point3d eyePos;
+
+    /// Where an active animation expects the view to be a little while from now.
+    /// Only set if the animation can tell us.
+    ViewStateRef predictedState;
 };
 
 }
@@ -167,7 +167,7 @@ public:
     // The tweaker sets up uniforms before a given drawable draws
     virtual void setupTweaker(BasicDrawable &theDraw) const;
 
-    // For performance mode wide vectors (Metal for now), the center line instances
+    // For performance mode wide vectors, the center line instances
     
     void addCenterLine(const Point3d &centerPt,const Point3d &up,double len,const RGBAColor &color,const std::vector<SimpleIdentity> &maskIDs,int prev,int next);
     // Number of center-lines defined so far
@@ -189,6 +189,9 @@ public:
     /// Set the active transform matrix
     virtual void setMatrix(const Eigen::Matrix4d *inMat);
 
+    /// Points are relative to this display space center.  See BasicDrawableBuilder::setCenter.
+    virtual void setCenter(const Point3d &center);
+
     /// Number of points added so far
     unsigned int getNumPoints();
     
@@ -231,7 +234,7 @@ protected:
     const SceneRenderer *renderer;
     
     // Controls whether we're building basic drawables or instances
-    // We do instances on Metal
+    // Performance mode does instances
     BasicDrawableBuilderRef basicDrawable;
     WideVecImplType implType;
     BasicDrawableInstanceBuilderRef instDrawable;
@@ -246,7 +249,7 @@ protected:
     ColorExpressionInfoRef colorExp;
     FloatExpressionInfoRef opacityExp;
 
-    // Centerline structure (for Metal)
+    // Centerline structure (for performance mode)
     typedef struct {
         Point3f center;
         Point3f up;
@@ -28,6 +28,20 @@ struct WideVectorTweakerGLES : public WideVectorTweaker
     virtual void tweakForFrame(Drawable *inDraw,RendererFrameInfo *frameInfo) override;
 };
 
+/// The performance version runs on the instances and sets up the join and cap logic too
+struct WideVectorPerfTweakerGLES : public WideVectorTweaker
+{
+    virtual void tweakForFrame(Drawable *inDraw,RendererFrameInfo *frameInfo) override;
+
+    Point2f texOffset = { 0.0f, 0.0f };
+    WideVectorLineJoinType joinType = WideVecBevelJoin;
+    WideVectorLineCapType capType = WideVecSquareCap;
+    float miterLimit = 2.0f;
+    float interClipLimit = 0.0f;
+    bool globeMode = false;
+    Point3f origin = { 0.0f, 0.0f, 0.0f };
+};
+
 // Shader name
 //#define kWideVectorShaderName "Wide Vector Shader"
 //#define kWideVectorGlobeShaderName "Wide Vector Shader Globe"
@@ -36,6 +50,8 @@ struct WideVectorTweakerGLES : public WideVectorTweaker
 ProgramGLES *BuildWideVectorProgramGLES(const std::string &name,SceneRenderer *renderer);
 /// This version is for the 3D globe
 ProgramGLES *BuildWideVectorGlobeProgramGLES(const std::string &name,SceneRenderer *renderer);
+/// Performance wide vectors, which work out the geometry from instanced center points.  Needs GLES 3.
+ProgramGLES *BuildWideVectorPerfProgramGLES(const std::string &name,SceneRenderer *renderer);
 
 /// OpenGL version of the WideVectorDrawable Builder
 class WideVectorDrawableBuilderGLES : virtual public WideVectorDrawableBuilder
@@ -62,6 +78,9 @@ public:
 
     virtual DrawableTweakerRef makeTweaker() const override;
 
+    // Each center point is one instance, so this is limited by the instance buffer
+    virtual int maxInstances() const override;
+
     bool drawableGotten;
     bool instanceGotten;
 };
@@ -19,6 +19,7 @@
 #import <math.h>
 #import <set>
 #import <map>
+#import <unordered_map>
 #import "Identifiable.h"
 #import "BasicDrawableInstance.h"
 #import "Scene.h"
@@ -26,6 +27,7 @@
 #import "VectorData.h"
 #import "Dictionary.h"
 #import "BaseInfo.h"
+#import "VectorLOD.h"
 
 namespace WhirlyKit
 {
@@ -91,6 +93,8 @@ public:
 
     SimpleIdentity texID = EmptyIdentity;
 
+    VectorLODSettings lod;
+
     FloatExpressionInfoRef widthExp;
     FloatExpressionInfoRef offsetExp;
     FloatExpressionInfoRef opacityExp;
@@ -129,6 +133,8 @@ public:
 
     /// Add widened vectors for display
     SimpleIdentity addVectors(const std::vector<VectorShapeRef> &shapes,const WideVectorInfo &desc,ChangeSet &changes);
+    /// Widen compact vectors, decoding them only for the build
+    SimpleIdentity addVectors(const CompactShapeSet &shapes,const WideVectorInfo &desc,ChangeSet &changes);
     
     /// Enable/disable active vectors
     void enableVectors(SimpleIDSet &vecIDs,bool enable,ChangeSet &changes);
@@ -139,10 +145,21 @@ public:
     /// Change the vector(s) represented by the given ID
     void changeVectors(SimpleIdentity vecID,const WideVectorInfo &vecInfo,ChangeSet &changes);
 
+    /// Change lots of vectors at once, each to its own description.
+    /// This takes the lock once and makes one style change per drawable.
+    void changeVectors(const std::unordered_map<SimpleIdentity,WideVectorInfoRef> &vecInfos,ChangeSet &changes);
+
     /// Remove a gruop of vectors named by the given ID
     void removeVectors(SimpleIDSet &vecIDs,ChangeSet &changes);
     
 protected:
+    // Build each level of detail on its own and gather them up under one ID
+    SimpleIdentity addVectorLODs(const std::vector<VectorShapeRef> &shapes,const WideVectorInfo &vecInfo,ChangeSet &changes);
+
+    // Restyle the drawables for one set of wide vectors.  Lock must be held.
+    static void changeSceneRep(const WideVectorSceneRep &sceneRep,const WideVectorInfo &vecInfo,
+                               WideVectorDrawableBuilder &builder,ChangeSet &changes);
+
     WideVectorSceneRepSet sceneReps;
 };
 typedef std::shared_ptr<WideVectorManager> WideVectorManagerRef;
@@ -0,0 +1,78 @@
+/*  WorkerPool.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import <thread>
+#import <mutex>
+#import <condition_variable>
+#import <atomic>
+#import <functional>
+#import <memory>
+
+namespace WhirlyKit
+{
+
+/** A small set of worker threads for splitting up a loop.
+    The caller's thread joins in, so a pool with N threads runs
+    N+1 ways.  Threads pull chunks off a shared counter, so the
+    fast ones pick up the slack for the slow ones.
+  */
+class WorkerPool
+{
+public:
+    /// Range of indices to process [start,end)
+    typedef std::function<void(size_t start,size_t end)> RangeFunc;
+
+    /// Start up the given number of threads, not counting the caller
+    WorkerPool(int numThreads);
+    virtual ~WorkerPool();
+
+    /// Number of threads, not counting the caller
+    int getNumThreads() const { return (int)threads.size(); }
+
+    /// Threads to use when nobody's said otherwise.
+    /// One less than the cores, leaving one for the caller, and no more than a few.
+    static int getDefaultNumThreads();
+
+    /// Run the function over [0,count) in pieces of chunkSize or less and wait for it to finish.
+    /// If another thread is already using the pool, this one does all the work itself.
+    void parallelFor(size_t count,size_t chunkSize,const RangeFunc &func);
+
+protected:
+    void workerMain();
+    void runChunks(const RangeFunc &func,size_t count,size_t chunkSize);
+
+    std::vector<std::thread> threads;
+    // Held by whoever is running a job
+    std::mutex callerLock;
+    std::mutex lock;
+    std::condition_variable wakeCond;
+    std::condition_variable doneCond;
+
+    // Current job, protected by lock
+    const RangeFunc *job = nullptr;
+    size_t jobCount = 0;
+    size_t jobChunkSize = 0;
+    unsigned int jobGeneration = 0;
+    int activeWorkers = 0;
+    bool shutdown = false;
+
+    std::atomic<size_t> nextChunk;
+};
+typedef std::shared_ptr<WorkerPool> WorkerPoolRef;
+
+}
@@ -31,6 +31,12 @@
 #include <GLES3/gl3.h>
 #endif
 #include <EGL/egl.h>
+#elif defined(__linux__)
+
+// Desktop Linux, for host builds like the benchmarks
+#include <GLES3/gl32.h>
+#include <GLES2/gl2ext.h>
+#include <EGL/egl.h>
 #else
 
 // iOS
@@ -45,3 +51,12 @@
 
 extern bool hasVertexArraySupport;
 extern bool hasMapBufferSupport;
+extern bool hasFramebufferBlitSupport;
+extern bool hasASTCSupport;
+extern bool hasTimerQuerySupport;
+
+/// Look at the current context and turn on what it can do.
+/// Anything ES 3 or later gets vertex array objects and framebuffer blits.
+/// ASTC comes with ES 3.2 or the LDR extension.
+/// GPU timer queries need ES 3 and GL_EXT_disjoint_timer_query.
+void SetupGLESCapabilities();
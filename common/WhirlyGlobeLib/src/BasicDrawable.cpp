@@ -22,6 +22,7 @@
 #import "ParticleSystemDrawable.h"
 #import "SceneRenderer.h"
 #import "WhirlyKitLog.h"
+#import "StableBytes.h"
 
 using namespace Eigen;
 
@@ -75,6 +76,27 @@ SimpleIdentity BasicDrawable::getProgram() const
     return programId;
 }
 
+SimpleIdentity BasicDrawable::getSortTexture() const
+{
+    return texInfo.empty() ? EmptyIdentity : texInfo[0].texId;
+}
+
+uint64_t BasicDrawable::getVertexLayoutKey() const
+{
+    // The attributes are all in place by the time anyone sorts us
+    if (vertexLayoutKey == 0)
+    {
+        uint64_t key = StableHashSeed;
+        for (const auto *attr : vertexAttributes)
+        {
+            key = StableHashValue(attr->nameID,key);
+            key = StableHashValue((uint64_t)attr->dataType,key);
+        }
+        vertexLayoutKey = key ? key : 1;
+    }
+    return vertexLayoutKey;
+}
+
 void BasicDrawable::setProgram(SimpleIdentity progId)
 {
     if (programId == progId)
@@ -95,6 +117,12 @@ unsigned int BasicDrawable::getDrawPriority() const
     return drawPriority;
 }
 
+void BasicDrawable::getMemoryBytes(size_t &cpuBytes,size_t &gpuBytes) const
+{
+    cpuBytes = mergedTris.capacity() * sizeof(Triangle);
+    gpuBytes = this->gpuBytes;
+}
+
 bool BasicDrawable::isOn(RendererFrameInfo *frameInfo) const
 {
     if (startEnable != endEnable)
@@ -107,9 +135,13 @@ bool BasicDrawable::isOn(RendererFrameInfo *frameInfo) const
     
     if (!on)
         return false;
+
+    if (isMerged() && std::none_of(mergedRanges.begin(),mergedRanges.end(),
+                                   [](const MergedRange &range) { return range.on; }))
+        return false;
     
     // Height based check
-    if (minVisible != DrawVisibleInvalid && maxVisible != DrawVisibleInvalid)
+    if (!gpuCulled && minVisible != DrawVisibleInvalid && maxVisible != DrawVisibleInvalid)
     {
         const double visVal = frameInfo->theView->heightAboveSurface();
         if (!((minVisible <= visVal && visVal <= maxVisible) ||
@@ -131,17 +163,18 @@ bool BasicDrawable::isOn(RendererFrameInfo *frameInfo) const
         }
     }
     
+    // Around the back of the globe
+    if (horizonBound.isValid() && frameInfo->horizon.isHidden(horizonBound))
+        return false;
+
     // Zoom based check.  We need to be in the current zoom range
-    if (zoomSlot > -1 && zoomSlot <= MaplyMaxZoomSlots &&
-        (minZoomVis != DrawVisibleInvalid || maxZoomVis != DrawVisibleInvalid))
+    if (!gpuCulled && (zoomSlotMask & frameInfo->zoomSlotMask))
     {
-        const float zoom = frameInfo->scene->getZoomSlotValue(zoomSlot);
-        if (zoom != MAXFLOAT) {
-            if ((minZoomVis != DrawVisibleInvalid && zoom < minZoomVis) ||
-                (maxZoomVis != DrawVisibleInvalid && zoom >= maxZoomVis))
-            {
-                return false;
-            }
+        const float zoom = frameInfo->zoomSlots[zoomSlot];
+        if ((minZoomVis != DrawVisibleInvalid && zoom < minZoomVis) ||
+            (maxZoomVis != DrawVisibleInvalid && zoom >= maxZoomVis))
+        {
+            return false;
         }
     }
     
@@ -192,6 +225,14 @@ void BasicDrawable::setMatrix(const Eigen::Matrix4d *inMat)
     setValuesChanged();
 
     mat = *inMat; hasMatrix = true;
+
+    // The bound was for the geometry where it was built
+    horizonBound = HorizonBound();
+}
+
+void BasicDrawable::setHorizonBound(const HorizonBound &bound)
+{
+    horizonBound = bound;
 }
     
 const std::vector<BasicDrawable::TexInfo> &BasicDrawable::getTexInfo()
@@ -238,6 +279,208 @@ void BasicDrawable::setOverrideColor(RGBAColor inColor)
     setValuesChanged();
 }
 
+void BasicDrawable::setVertexColors(unsigned int startVert,unsigned int numVerts,RGBAColor inColor)
+{
+    // Only works while we've still got the data
+    if (colorEntry < 0 || colorEntry >= vertexAttributes.size())
+        return;
+    VertexAttribute *colorAttr = vertexAttributes[colorEntry];
+    if (colorAttr->dataType != BDChar4Type || startVert + numVerts > colorAttr->numElements())
+        return;
+
+    auto &colors = *(std::vector<RGBAColor> *)colorAttr->data;
+    std::fill(colors.begin() + startVert, colors.begin() + startVert + numVerts, inColor);
+}
+
+void BasicDrawable::setVertexMotion(const std::vector<VertexMotion> &motions)
+{
+    // Renderers keep the positions as an attribute or on their own, so this only does what it finds
+    for (VertexAttribute *attr : vertexAttributes)
+    {
+        if (attr->dataType != BDFloat3Type || !attr->data ||
+            (attr->nameID != a_PositionNameID && attr->nameID != a_dirNameID))
+            continue;
+
+        auto &vals = *(std::vector<Vector3f> *)attr->data;
+        const bool isPos = (attr->nameID == a_PositionNameID);
+        for (const auto &motion : motions)
+        {
+            if (motion.startVert + motion.numVerts > vals.size())
+                continue;
+            std::fill(vals.begin() + motion.startVert, vals.begin() + motion.startVert + motion.numVerts,
+                      isPos ? motion.pos : motion.dir);
+        }
+    }
+}
+
+namespace {
+    // Uniforms only compare on name and type, so check the values too
+    bool sameUniforms(const SingleVertexAttributeSet &a,const SingleVertexAttributeSet &b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (auto ai = a.begin(), bi = b.begin(); ai != a.end(); ++ai, ++bi)
+        {
+            if (!(*ai == *bi) || ai->slot != bi->slot || memcmp(&ai->data,&bi->data,ai->size()) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    bool sameTexInfo(const BasicDrawable::TexInfo &a,const BasicDrawable::TexInfo &b)
+    {
+        return a.texId == b.texId && a.texCoordEntry == b.texCoordEntry &&
+               a.relLevel == b.relLevel && a.relX == b.relX && a.relY == b.relY &&
+               a.size == b.size && a.borderTexel == b.borderTexel;
+    }
+}
+
+bool BasicDrawable::canMerge(const BasicDrawable &that) const
+{
+    // Anything that's changed per frame or per drawable rules it out
+    if (type != Triangles || that.type != Triangles ||
+        !tweakers.empty() || !that.tweakers.empty() ||
+        hasMatrix || that.hasMatrix || motion || that.motion ||
+        !uniBlocks.empty() || !that.uniBlocks.empty() ||
+        !calcData.empty() || !that.calcData.empty() ||
+        calcProgramId != EmptyIdentity || that.calcProgramId != EmptyIdentity ||
+        hasOverrideColor || that.hasOverrideColor || clipCoords || that.clipCoords)
+        return false;
+
+    if (programId != that.programId || renderTargetID != that.renderTargetID ||
+        drawPriority != that.drawPriority || drawOrder != that.drawOrder ||
+        drawOffset != that.drawOffset || isAlpha != that.isAlpha || extraFrames != that.extraFrames ||
+        requestZBuffer != that.requestZBuffer || writeZBuffer != that.writeZBuffer ||
+        blendPremultipliedAlpha != that.blendPremultipliedAlpha || !(color == that.color) ||
+        startEnable != that.startEnable || endEnable != that.endEnable ||
+        fadeUp != that.fadeUp || fadeDown != that.fadeDown ||
+        minVisible != that.minVisible || maxVisible != that.maxVisible ||
+        minVisibleFadeBand != that.minVisibleFadeBand || maxVisibleFadeBand != that.maxVisibleFadeBand ||
+        minViewerDist != that.minViewerDist || maxViewerDist != that.maxViewerDist ||
+        viewerCenter != that.viewerCenter ||
+        zoomSlot != that.zoomSlot || minZoomVis != that.minZoomVis || maxZoomVis != that.maxZoomVis ||
+        localMbr.valid() != that.localMbr.valid() ||
+        colorEntry != that.colorEntry || normalEntry != that.normalEntry)
+        return false;
+
+    if (texInfo.size() != that.texInfo.size() || vertexAttributes.size() != that.vertexAttributes.size())
+        return false;
+    for (unsigned int ii=0;ii<texInfo.size();ii++)
+    {
+        if (!sameTexInfo(texInfo[ii],that.texInfo[ii]))
+            return false;
+    }
+    for (unsigned int ii=0;ii<vertexAttributes.size();ii++)
+    {
+        const auto *attr = vertexAttributes[ii], *thatAttr = that.vertexAttributes[ii];
+        if (attr->nameID != thatAttr->nameID || attr->dataType != thatAttr->dataType || attr->slot != thatAttr->slot)
+            return false;
+    }
+
+    return sameUniforms(uniforms,that.uniforms);
+}
+
+bool BasicDrawable::mergeGeometry(BasicDrawable &that,std::vector<Triangle> &tris,const std::vector<Triangle> &thatTris,
+                                  unsigned int numPts,unsigned int thatNumPts)
+{
+    if (numPts + thatNumPts > MaxDrawablePoints || that.isMerged())
+        return false;
+
+    // Each attribute has to be all there or all defaults on both sides
+    for (unsigned int ii=0;ii<vertexAttributes.size();ii++)
+    {
+        const auto *attr = vertexAttributes[ii], *thatAttr = that.vertexAttributes[ii];
+        const int num = attr->numElements(), thatNum = thatAttr->numElements();
+        if (num == 0 && thatNum == 0)
+        {
+            if (memcmp(&attr->defaultData,&thatAttr->defaultData,sizeof(attr->defaultData)) != 0)
+                return false;
+        }
+        else if (num != (int)numPts || thatNum != (int)thatNumPts)
+        {
+            return false;
+        }
+    }
+
+    if (mergedRanges.empty())
+    {
+        // We're standing in for the original now, so it needs a range of its own
+        mergedRanges.push_back(MergedRange { getId(), 0, (unsigned int)tris.size(), on });
+        setId(Identifiable::genId());
+        on = true;
+    }
+    mergedRanges.push_back(MergedRange { that.getId(), (unsigned int)tris.size(), (unsigned int)thatTris.size(), that.on });
+
+    for (unsigned int ii=0;ii<vertexAttributes.size();ii++)
+    {
+        vertexAttributes[ii]->append(*that.vertexAttributes[ii]);
+    }
+
+    tris.reserve(tris.size() + thatTris.size());
+    for (const auto &tri : thatTris)
+    {
+        tris.emplace_back(tri.verts[0] + numPts, tri.verts[1] + numPts, tri.verts[2] + numPts);
+    }
+
+    if (localMbr.valid())
+    {
+        localMbr.expand(that.localMbr);
+    }
+
+    // Not worth widening the cone to cover both
+    horizonBound = HorizonBound();
+
+    return true;
+}
+
+void BasicDrawable::maskMergedTris(std::vector<Triangle> &outTris) const
+{
+    // Anything not in a range that's on gets all three corners on vertex zero
+    outTris.assign(mergedTris.size(),Triangle());
+    for (const auto &range : mergedRanges)
+    {
+        if (range.on && range.startTri + range.numTris <= mergedTris.size())
+        {
+            std::copy(mergedTris.begin() + range.startTri,
+                      mergedTris.begin() + range.startTri + range.numTris,
+                      outTris.begin() + range.startTri);
+        }
+    }
+}
+
+void BasicDrawable::setMergedOnOff(SimpleIdentity drawID,bool onOff)
+{
+    for (auto &range : mergedRanges)
+    {
+        if (range.drawID == drawID)
+        {
+            if (range.on != onOff)
+            {
+                range.on = onOff;
+                mergedTrisChanged();
+                setValuesChanged();
+            }
+            return;
+        }
+    }
+}
+
+int BasicDrawable::removeMerged(SimpleIdentity drawID)
+{
+    const auto it = std::find_if(mergedRanges.begin(),mergedRanges.end(),
+                                 [drawID](const MergedRange &range) { return range.drawID == drawID; });
+    if (it != mergedRanges.end())
+    {
+        mergedRanges.erase(it);
+        if (!mergedRanges.empty())
+        {
+            mergedTrisChanged();
+            setValuesChanged();
+        }
+    }
+    return (int)mergedRanges.size();
+}
+
 void BasicDrawable::setOverrideColor(unsigned char inColor[])
 {
     setOverrideColor(RGBAColor(inColor[0],inColor[1],inColor[2],inColor[3]));
@@ -253,6 +496,15 @@ void BasicDrawable::setEnableTimeRange(TimeInterval inStartEnable,TimeInterval i
     }
 }
 
+bool BasicDrawable::getEnableTimeRange(TimeInterval &start,TimeInterval &end) const
+{
+    if (startEnable == endEnable)
+        return false;
+    start = startEnable;
+    end = endEnable;
+    return true;
+}
+
 // NOLINTNEXTLINE(google-default-arguments)
 void BasicDrawable::setVisibleRange(float minVis,float maxVis,float minVisBand,float maxVisBand)
 {
@@ -288,6 +540,7 @@ void BasicDrawable::setZoomInfo(int inZoomSlot,double inMinZoomVis,double inMaxZ
     zoomSlot = inZoomSlot;
     minZoomVis = inMinZoomVis;
     maxZoomVis = inMaxZoomVis;
+    zoomSlotMask = ZoomSlotMask(zoomSlot,minZoomVis,maxZoomVis);
 }
 
 void BasicDrawable::setFade(TimeInterval inFadeDown,TimeInterval inFadeUp)
@@ -517,23 +770,38 @@ void BasicDrawableTexTweaker::tweakForFrame(Drawable *draw,RendererFrameInfo *fr
         return;
     }
 
+    if (texIDs.empty() || period <= 0.0)
+    {
+        return;
+    }
+
+    if (!setup)
+    {
+        shaderInterp = basicDraw->setTexAnimation(startTime, period, (int)texIDs.size());
+        setup = true;
+    }
+
     const double deltaT = std::max(0.0, frame->currentTime - startTime);
     const double t = std::fmod(deltaT, period) / period;
-    const auto base = (size_t)std::floor(t * texIDs.size());
+    const auto base = std::min((size_t)std::floor(t * texIDs.size()), texIDs.size() - 1);
     const auto next = (base + 1) % texIDs.size();
-    const auto interp = (float)(t * texIDs.size() - base);
-    
+
+    // Only does anything when we move on to the next texture
     basicDraw->setTexId(0, texIDs[base]);
     basicDraw->setTexId(1, texIDs[next]);
 
-    // Interpolation as well
-    SingleVertexAttributeSet uniforms;
-    uniforms.emplace(u_interpNameID,-1,interp);
-    basicDraw->setUniforms(uniforms);
+    // Interpolation as well, unless the shader is doing it
+    if (!shaderInterp)
+    {
+        basicDraw->setUniform(u_interpNameID, (float)(t * texIDs.size() - base));
+        basicDraw->setValuesChanged();
+    }
 
-    // This forces a redraw every frame
-    // Note: There has to be a better way
-    frame->scene->addChangeRequest(nullptr);
+    // Keep drawing while we're animating
+    if (frame->sceneRenderer)
+    {
+        frame->sceneRenderer->setRenderUntil(frame->currentTime + std::max(2.0 * frame->frameLen, 1.0 / 30.0));
+    }
 }
 
 // NOLINTNEXTLINE(modernize-pass-by-value)
@@ -585,6 +853,33 @@ void ColorChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableR
     }
 }
 
+VertexColorChangeRequest::VertexColorChangeRequest(SimpleIdentity drawId,unsigned int startVert,
+                                                   unsigned int numVerts,RGBAColor color) :
+    DrawableChangeRequest(drawId), startVert(startVert), numVerts(numVerts), color(color)
+{
+}
+
+void VertexColorChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw)
+{
+    if (auto basicDrawable = dynamic_cast<BasicDrawable*>(draw.get()))
+    {
+        basicDrawable->setVertexColors(startVert,numVerts,color);
+    }
+}
+
+VertexMotionChangeRequest::VertexMotionChangeRequest(SimpleIdentity drawId,std::vector<BasicDrawable::VertexMotion> motions) :
+    DrawableChangeRequest(drawId), motions(std::move(motions))
+{
+}
+
+void VertexMotionChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw)
+{
+    if (auto basicDrawable = dynamic_cast<BasicDrawable*>(draw.get()))
+    {
+        basicDrawable->setVertexMotion(motions);
+    }
+}
+
 OnOffChangeRequest::OnOffChangeRequest(SimpleIdentity drawId,bool OnOff)
 : DrawableChangeRequest(drawId), newOnOff(OnOff)
 {
@@ -606,6 +901,14 @@ void OnOffChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableR
     }
 }
 
+void OnOffChangeRequest::executeMerged(Scene *scene,SceneRenderer *renderer,DrawableRef mergedDraw)
+{
+    if (auto basicDrawable = dynamic_cast<BasicDrawable*>(mergedDraw.get()))
+    {
+        basicDrawable->setMergedOnOff(drawId,newOnOff);
+    }
+}
+
 VisibilityChangeRequest::VisibilityChangeRequest(SimpleIdentity drawId,float minVis,float maxVis)
 : DrawableChangeRequest(drawId), minVis(minVis), maxVis(maxVis)
 {
@@ -636,6 +939,10 @@ void FadeChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRe
     {
         basicDrawable->setFade(fadeDown, fadeUp);
     }
+    else if (const auto drawInst = dynamic_cast<BasicDrawableInstance*>(draw.get()))
+    {
+        drawInst->setFade(fadeDown, fadeUp);
+    }
 
     // And let the renderer know
     renderer->setRenderUntil(fadeDown);
@@ -702,6 +1009,11 @@ void DrawTexturesChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,Dr
     BasicDrawableRef basicDrawable = std::dynamic_pointer_cast<BasicDrawable>(draw);
     if (basicDrawable)
         basicDrawable->setTexIDs(newTexIDs);
+    else {
+        ParticleSystemDrawableRef partDrawable = std::dynamic_pointer_cast<ParticleSystemDrawable>(draw);
+        if (partDrawable)
+            partDrawable->setTexIDs(newTexIDs);
+    }
 }
 
 TransformChangeRequest::TransformChangeRequest(SimpleIdentity drawId,const Matrix4d *newMat)
@@ -779,6 +1091,61 @@ void LineWidthChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,Drawa
     }
 }
     
+DrawableStyleChangeRequest::DrawableStyleChangeRequest(SimpleIdentity drawId,RGBAColor color,int drawPriority,int64_t drawOrder)
+: DrawableChangeRequest(drawId), color(color), drawPriority(drawPriority), drawOrder(drawOrder)
+{
+}
+
+void DrawableStyleChangeRequest::setVisibleRange(float inMinVis,float inMaxVis)
+{
+    visSet = true;
+    minVis = inMinVis;
+    maxVis = inMaxVis;
+}
+
+void DrawableStyleChangeRequest::setLineWidth(float inLineWidth)
+{
+    lineWidthSet = true;
+    lineWidth = inLineWidth;
+}
+
+void DrawableStyleChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw)
+{
+    if (const auto basicDrawable = std::dynamic_pointer_cast<BasicDrawable>(draw))
+    {
+        basicDrawable->setOverrideColor(color);
+        if (visSet)
+            basicDrawable->setVisibleRange(minVis,maxVis);
+        if (lineWidthSet)
+            basicDrawable->setLineWidth(lineWidth);
+
+        // The renderer sorts on these, so take it out and put it back just the once
+        if (basicDrawable->drawPriority != drawPriority || basicDrawable->drawOrder != drawOrder)
+        {
+            renderer->removeDrawable(draw,false,nullptr);
+            basicDrawable->setDrawPriority(drawPriority);
+            basicDrawable->setDrawOrder(drawOrder);
+            renderer->addDrawable(draw);
+        }
+    }
+    else if (const auto basicDrawInst = std::dynamic_pointer_cast<BasicDrawableInstance>(draw))
+    {
+        basicDrawInst->setColor(color);
+        if (visSet)
+            basicDrawInst->setVisibleRange(minVis,maxVis);
+        if (lineWidthSet)
+            basicDrawInst->setLineWidth(lineWidth);
+
+        if (basicDrawInst->getDrawPriority() != drawPriority || basicDrawInst->getDrawOrder() != drawOrder)
+        {
+            renderer->removeDrawable(draw,false,nullptr);
+            basicDrawInst->setDrawPriority(drawPriority);
+            basicDrawInst->setDrawOrder(drawOrder);
+            renderer->addDrawable(draw);
+        }
+    }
+}
+
 DrawUniformsChangeRequest::DrawUniformsChangeRequest(SimpleIdentity drawID, SingleVertexAttributeSet attrs)
     : DrawableChangeRequest(drawID), attrs(std::move(attrs))
 {
@@ -831,19 +1198,65 @@ UniformBlockSetRequest::UniformBlockSetRequest(SimpleIdentity drawID,const RawDa
     
 void UniformBlockSetRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw)
 {
-    BasicDrawableRef basicDrawable = std::dynamic_pointer_cast<BasicDrawable>(draw);
-    if (basicDrawable)
+    SetDrawableUniBlock(draw,uniBlock);
+}
+
+bool SetDrawableUniBlock(const DrawableRef &draw,const BasicDrawable::UniformBlock &uniBlock)
+{
+    if (const auto basicDrawable = std::dynamic_pointer_cast<BasicDrawable>(draw))
         basicDrawable->setUniBlock(uniBlock);
-    else {
-        BasicDrawableInstanceRef basicDrawInst = std::dynamic_pointer_cast<BasicDrawableInstance>(draw);
-        if (basicDrawInst)
-            basicDrawInst->setUniBlock(uniBlock);
-        else {
-            ParticleSystemDrawableRef partDrawable = std::dynamic_pointer_cast<ParticleSystemDrawable>(draw);
-            if (partDrawable)
-                partDrawable->setUniBlock(uniBlock);
+    else if (const auto basicDrawInst = std::dynamic_pointer_cast<BasicDrawableInstance>(draw))
+        basicDrawInst->setUniBlock(uniBlock);
+    else if (const auto partDrawable = std::dynamic_pointer_cast<ParticleSystemDrawable>(draw))
+        partDrawable->setUniBlock(uniBlock);
+    else
+        return false;
+    return true;
+}
+
+int MergeBasicDrawables(ChangeSet &changes)
+{
+    // Instances find their masters by ID, so leave those alone
+    SimpleIDSet masterIDs;
+    for (const auto *change : changes)
+    {
+        const auto *addReq = dynamic_cast<const AddDrawableReq *>(change);
+        if (const auto *drawInst = addReq ? dynamic_cast<const BasicDrawableInstance *>(addReq->getDrawable().get()) : nullptr)
+        {
+            masterIDs.insert(drawInst->getMasterID());
+            masterIDs.insert(drawInst->getInstID());
+        }
+    }
+
+    // Everything so far that others might be merged into, in the order they came
+    std::vector<BasicDrawable *> targets;
+    int numMerged = 0;
+    for (auto &change : changes)
+    {
+        auto *addReq = dynamic_cast<AddDrawableReq *>(change);
+        auto *draw = (addReq && addReq->when == 0.0) ? dynamic_cast<BasicDrawable *>(addReq->getDrawable().get()) : nullptr;
+        if (!draw || draw->type != Triangles || masterIDs.find(draw->getId()) != masterIDs.end())
+            continue;
+
+        const bool merged = std::any_of(targets.begin(),targets.end(),
+                                        [draw](BasicDrawable *target) { return target->merge(*draw); });
+        if (merged)
+        {
+            delete change;
+            change = nullptr;
+            numMerged++;
         }
+        else
+        {
+            targets.push_back(draw);
+        }
+    }
+
+    if (numMerged > 0)
+    {
+        changes.erase(std::remove(changes.begin(),changes.end(),nullptr),changes.end());
     }
+    return numMerged;
 }
 
 }
@@ -16,8 +16,11 @@
  *  limitations under the License.
  */
 
+#import <cstring>
 #import "BasicDrawableBuilder.h"
+#import "BasicDrawableInstance.h"
 #import "SceneRenderer.h"
+#import "WhirlyKitLog.h"
 
 using namespace Eigen;
 
@@ -26,8 +29,12 @@ namespace WhirlyKit
 
 float BasicDrawableTweaker::getZoom(const Drawable &inDraw,const Scene &scene,float def) const
 {
-    const auto bd = dynamic_cast<const BasicDrawable*>(&inDraw);
-    return (bd && bd->zoomSlot >= 0) ? scene.getZoomSlotValue(bd->zoomSlot) : def;
+    int zoomSlot = -1;
+    if (const auto bd = dynamic_cast<const BasicDrawable*>(&inDraw))
+        zoomSlot = bd->zoomSlot;
+    else if (const auto bdi = dynamic_cast<const BasicDrawableInstance*>(&inDraw))
+        zoomSlot = bdi->getZoomSlot();
+    return (zoomSlot >= 0) ? scene.getZoomSlotValue(zoomSlot) : def;
 }
 
 BasicDrawableBuilder::BasicDrawableBuilder() :
@@ -137,13 +144,44 @@ void BasicDrawableBuilder::setupTexCoordEntry(int which,int numReserve)
         BasicDrawable::TexInfo newInfo;
         char attributeName[40];
         sprintf(attributeName,"a_texCoord%d",ii);
-        newInfo.texCoordEntry = addAttribute(BDFloat2Type,StringIndexer::getStringID(attributeName));
+        newInfo.texCoordEntry = addAttribute(texCoordType(),StringIndexer::getStringID(attributeName));
         basicDraw->vertexAttributes[newInfo.texCoordEntry]->setDefaultVector2f(Vector2f(0.0,0.0));
         basicDraw->vertexAttributes[newInfo.texCoordEntry]->reserve(numReserve);
         basicDraw->texInfo.push_back(newInfo);
     }
 }
     
+void BasicDrawableBuilder::changeAttributeType(int attrID,BDAttributeDataType dataType)
+{
+    if (attrID < 0 || attrID >= (int)basicDraw->vertexAttributes.size())
+        return;
+
+    VertexAttribute *attr = basicDraw->vertexAttributes[attrID];
+    if (attr->dataType == dataType || attr->numElements() != 0)
+        return;
+
+    // The data array is typed, so it has to go first.  Defaults stay as they are.
+    attr->clear();
+    attr->dataType = dataType;
+}
+
+void BasicDrawableBuilder::setCompactNormals()
+{
+    changeAttributeType(basicDraw->normalEntry,BDChar4NormType);
+}
+
+void BasicDrawableBuilder::setCompactTexCoords()
+{
+    compactTexCoords = true;
+    for (const auto &info : basicDraw->texInfo)
+        changeAttributeType(info.texCoordEntry,BDHalf2Type);
+}
+
+void BasicDrawableBuilder::setMergedRanges(std::vector<BasicDrawable::MergedRange> ranges)
+{
+    basicDraw->mergedRanges = std::move(ranges);
+}
+
 void BasicDrawableBuilder::setOnOff(bool onOff)
 {
     basicDraw->on = onOff;
@@ -187,6 +225,7 @@ void BasicDrawableBuilder::setZoomInfo(int zoomSlot,double minZoomVis,double max
     basicDraw->zoomSlot = zoomSlot;
     basicDraw->minZoomVis = minZoomVis;
     basicDraw->maxZoomVis = maxZoomVis;
+    basicDraw->zoomSlotMask = ZoomSlotMask(zoomSlot,minZoomVis,maxZoomVis);
 }
 
 void BasicDrawableBuilder::setAlpha(bool onOff)
@@ -219,6 +258,38 @@ void BasicDrawableBuilder::setMatrix(const Eigen::Matrix4d &inMat)
     basicDraw->mat = inMat; basicDraw->hasMatrix = true;
 }
 
+void BasicDrawableBuilder::calcHorizonBound(double extraHeight)
+{
+    // The points are relative to the matrix, if there is one
+    Point3dVector dispPts;
+    dispPts.reserve(points.size());
+    for (const auto &pt : points)
+    {
+        const Point3d pt3d = pt.cast<double>();
+        if (basicDraw->hasMatrix)
+        {
+            const Eigen::Vector4d dispPt = basicDraw->mat * Eigen::Vector4d(pt3d.x(),pt3d.y(),pt3d.z(),1.0);
+            dispPts.emplace_back(dispPt.x(),dispPt.y(),dispPt.z());
+        }
+        else
+        {
+            dispPts.push_back(pt3d);
+        }
+    }
+    basicDraw->horizonBound = HorizonBound(dispPts.data(),dispPts.size(),extraHeight);
+}
+
+void BasicDrawableBuilder::setCenter(const Point3d &newCenter)
+{
+    if (!points.empty())
+        wkLogLevel(Warn,"BasicDrawableBuilder: Center set after points were added");
+
+    center = newCenter;
+    centerValid = true;
+    const Eigen::Affine3d trans(Eigen::Translation3d(center.x(),center.y(),center.z()));
+    setMatrix(trans.matrix());
+}
+
 void BasicDrawableBuilder::setRequestZBuffer(bool val)
 {
     basicDraw->requestZBuffer = val;
@@ -387,7 +458,9 @@ unsigned int BasicDrawableBuilder::addPoint(const Point3f &pt)
 
 unsigned int BasicDrawableBuilder::addPoint(const Point3d &pt)
 {
-    points.push_back(Point3f(pt.x(),pt.y(),pt.z()));
+    // Take the center off while we've still got the precision
+    const Point3d relPt = centerValid ? Point3d(pt - center) : pt;
+    points.push_back(Point3f(relPt.x(),relPt.y(),relPt.z()));
     return (unsigned int)(points.size()-1);
 }
     
@@ -407,7 +480,7 @@ Point3d BasicDrawableBuilder::getPoint(int which) const
         return Point3d(0,0,0);
     const Point3f &pt = points[which];
     
-    return Point3d(pt.x(),pt.y(),pt.z());
+    return Point3d(pt.x(),pt.y(),pt.z()) + center;
 }
 
 void BasicDrawableBuilder::addTexCoord(int which,TexCoord coord)
@@ -546,6 +619,14 @@ void BasicDrawableBuilder::addVertexAttributes(const SingleVertexAttributeSet &a
             case BDInt64Type:
                 addAttributeValue(attrId, attr.data.int64Val);
                 break;
+            // The compact ones are given to us as floats
+            case BDHalf2Type:
+            case BDShort2NormType:
+                addAttributeValue(attrId, Vector2f{attr.data.vec2[0], attr.data.vec2[1]});
+                break;
+            case BDChar4NormType:
+                addAttributeValue(attrId, Vector3f{attr.data.vec3[0], attr.data.vec3[1], attr.data.vec3[2]});
+                break;
             case BDDataTypeMax:
                 break;
         }
@@ -588,6 +669,54 @@ int BasicDrawableBuilder::findAttribute(int nameID)
 void BasicDrawableBuilder::addTriangle(BasicDrawable::Triangle tri)
 { tris.push_back(tri); }
 
+bool BasicDrawableBuilder::checkInterleavedLayout(int vertexSize,const std::vector<int> &attrIDs) const
+{
+    int size = sizeof(float)*3;
+    for (int attrID : attrIDs)
+    {
+        if (attrID < 0 || attrID >= (int)basicDraw->vertexAttributes.size())
+            return false;
+        size += basicDraw->vertexAttributes[attrID]->size();
+    }
+    if (size != vertexSize)
+    {
+        wkLogLevel(Warn,"BasicDrawableBuilder: Packed vertices don't match the attributes in %s",name.c_str());
+        return false;
+    }
+    return true;
+}
+
+void BasicDrawableBuilder::addInterleavedVertices(std::vector<unsigned char> &&verts,int vertexSize,
+                                                  const std::vector<int> &attrIDs,
+                                                  const std::vector<BasicDrawable::Triangle> &newTris)
+{
+    if (!checkInterleavedLayout(vertexSize,attrIDs))
+        return;
+    const int numVerts = (int)(verts.size() / vertexSize);
+    const auto startPt = (unsigned short)points.size();
+
+    points.reserve(points.size() + numVerts);
+    const unsigned char *ptr = verts.data();
+    for (int ii=0;ii<numVerts;ii++,ptr+=vertexSize)
+    {
+        Point3f pt;
+        memcpy(pt.data(),ptr,sizeof(float)*3);
+        points.push_back(pt);
+    }
+
+    int offset = sizeof(float)*3;
+    for (int attrID : attrIDs)
+    {
+        VertexAttribute *attr = basicDraw->vertexAttributes[attrID];
+        attr->appendStrided(verts.data() + offset,numVerts,vertexSize);
+        offset += attr->size();
+    }
+
+    tris.reserve(tris.size() + newTris.size());
+    for (const auto &tri : newTris)
+        tris.emplace_back(tri.verts[0] + startPt,tri.verts[1] + startPt,tri.verts[2] + startPt);
+}
+
 void BasicDrawableBuilder::setUniforms(const SingleVertexAttributeSet &uniforms)
 {
     basicDraw->uniforms = uniforms;
@@ -609,8 +738,25 @@ void BasicDrawableBuilder::applySubTexture(int which,const SubTexture &subTex,in
         
         BasicDrawable::TexInfo &thisTexInfo = basicDraw->texInfo[which];
         thisTexInfo.texId = subTex.texId;
-        auto *texCoords = (std::vector<TexCoord> *)basicDraw->vertexAttributes[thisTexInfo.texCoordEntry]->data;
-        
+        VertexAttribute *texAttr = basicDraw->vertexAttributes[thisTexInfo.texCoordEntry];
+        if (!texAttr->data)
+            return;
+
+        if (texAttr->dataType == BDHalf2Type)
+        {
+            // Unpack, adjust and pack them back up
+            auto &packed = *(std::vector<uint32_t> *)texAttr->data;
+            for (unsigned int ii=startingAt;ii<packed.size();ii++)
+            {
+                const TexCoord tc(HalfToFloat(packed[ii] & 0xffff),HalfToFloat(packed[ii] >> 16));
+                packed[ii] = PackHalf2(subTex.processTexCoord(tc));
+            }
+            return;
+        }
+        if (texAttr->dataType != BDFloat2Type)
+            return;
+
+        auto *texCoords = (std::vector<TexCoord> *)texAttr->data;
         for (unsigned int ii=startingAt;ii<texCoords->size();ii++)
         {
             Point2f tc = (*texCoords)[ii];
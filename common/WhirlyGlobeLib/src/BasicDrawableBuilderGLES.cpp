@@ -83,9 +83,13 @@ BasicDrawableRef BasicDrawableBuilderGLES::getDrawable()
     auto draw = std::dynamic_pointer_cast<BasicDrawableGLES>(basicDraw);
 
     if (draw && !drawableGotten) {
-        draw->points = points;
+        if (!interleavedVerts.empty()) {
+            draw->setInterleavedVertices(std::move(interleavedVerts),interleavedVertexSize,interleavedAttrs);
+        } else {
+            draw->points = points;
+            draw->vertexSize = (int)draw->singleVertexSize();
+        }
         draw->tris = tris;
-        draw->vertexSize = (int)draw->singleVertexSize();
 
         ((BasicDrawableBuilder*)this)->setupTweaker(*draw);
 
@@ -95,6 +99,61 @@ BasicDrawableRef BasicDrawableBuilderGLES::getDrawable()
     return draw;
 }
 
+bool BasicDrawableBuilderGLES::hasUnpackedVertices() const
+{
+    if (!points.empty())
+        return true;
+    for (const auto *attr : basicDraw->vertexAttributes)
+        if (attr->numElements() != 0)
+            return true;
+    return false;
+}
+
+void BasicDrawableBuilderGLES::addInterleavedVertices(std::vector<unsigned char> &&verts,int vertexSize,
+                                                      const std::vector<int> &attrIDs,
+                                                      const std::vector<BasicDrawable::Triangle> &newTris)
+{
+    if (drawableGotten || !checkInterleavedLayout(vertexSize,attrIDs))
+        return;
+
+    // More of the same goes on the end.  Anything else and we have to unpack what we've got.
+    const bool sameLayout = interleavedVerts.empty() ? !hasUnpackedVertices() :
+                            (vertexSize == interleavedVertexSize && attrIDs == interleavedAttrs);
+    if (!sameLayout)
+    {
+        if (!interleavedVerts.empty())
+        {
+            std::vector<unsigned char> oldVerts;
+            oldVerts.swap(interleavedVerts);
+            BasicDrawableBuilder::addInterleavedVertices(std::move(oldVerts),interleavedVertexSize,interleavedAttrs,{});
+        }
+        BasicDrawableBuilder::addInterleavedVertices(std::move(verts),vertexSize,attrIDs,newTris);
+        return;
+    }
+
+    const auto startPt = (unsigned short)getNumPoints();
+    if (interleavedVerts.empty())
+    {
+        interleavedVerts = std::move(verts);
+        interleavedVertexSize = vertexSize;
+        interleavedAttrs = attrIDs;
+    }
+    else
+    {
+        interleavedVerts.insert(interleavedVerts.end(),verts.begin(),verts.end());
+    }
+
+    tris.reserve(tris.size() + newTris.size());
+    for (const auto &tri : newTris)
+        tris.emplace_back(tri.verts[0] + startPt,tri.verts[1] + startPt,tri.verts[2] + startPt);
+}
+
+unsigned int BasicDrawableBuilderGLES::getNumPoints() const
+{
+    const size_t numPacked = interleavedVertexSize > 0 ? interleavedVerts.size() / interleavedVertexSize : 0;
+    return (unsigned int)(points.size() + numPacked);
+}
+
 DrawableTweakerRef BasicDrawableBuilderGLES::makeTweaker() const
 {
     if (colorExp || opacityExp)
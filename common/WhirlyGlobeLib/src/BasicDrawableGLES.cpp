@@ -16,6 +16,7 @@
  *  limitations under the License.
  */
 
+#import <typeinfo>
 #import "BasicDrawableGLES.h"
 #import "WhirlyKitLog.h"
 
@@ -48,11 +49,47 @@ unsigned int BasicDrawableGLES::singleVertexSize()
         {
             attr->buffer = singleVertSize;
             singleVertSize += attr->size();
+        } else {
+            attr->buffer = 0;
         }
     }
     
     return singleVertSize;
 }
+
+void BasicDrawableGLES::collapseConstantAttributes()
+{
+    const int numVerts = (int)points.size();
+    if (numVerts < 2)
+        return;
+
+    bool changed = false;
+    for (unsigned int ii=0;ii<vertexAttributes.size();ii++)
+    {
+        VertexAttribute *attr = vertexAttributes[ii];
+        // Colors and directions can be rewritten in the buffer later, so they have to stay
+        const int attrSize = attr->size();
+        // Compact types keep their defaults as floats, so they can't just be copied over
+        if ((int)ii == colorEntry || attr->nameID == a_dirNameID || attr->dataType == BDInt64Type ||
+            IsCompactAttributeType(attr->dataType) ||
+            attr->numElements() != numVerts || attrSize > (int)sizeof(attr->defaultData))
+            continue;
+
+        const void *first = attr->addressForElement(0);
+        bool same = true;
+        for (int jj=1;jj<numVerts && same;jj++)
+            same = (memcmp(first,attr->addressForElement(jj),attrSize) == 0);
+        if (!same)
+            continue;
+
+        memcpy(&attr->defaultData,first,attrSize);
+        attr->clear();
+        changed = true;
+    }
+
+    if (changed)
+        vertexSize = (int)singleVertexSize();
+}
     
 // Adds the basic vertex data to an interleaved vertex buffer
 void BasicDrawableGLES::addPointToBuffer(unsigned char *basePtr,int which,const Point3d *center)
@@ -85,6 +122,23 @@ void BasicDrawableGLES::addPointToBuffer(unsigned char *basePtr,int which,const
     }
 }
 
+void BasicDrawableGLES::setInterleavedVertices(std::vector<unsigned char> &&verts,int vertSize,const std::vector<int> &attrIDs)
+{
+    interleavedVerts = std::move(verts);
+    vertexSize = vertSize;
+
+    pointBuffer = 0;
+    for (auto *attr : vertexAttributes)
+        ((VertexAttributeGLES *)attr)->buffer = 0;
+    GLuint offset = 3*sizeof(GLfloat);
+    for (int attrID : attrIDs)
+    {
+        auto *attr = (VertexAttributeGLES *)vertexAttributes[attrID];
+        attr->buffer = offset;
+        offset += attr->size();
+    }
+}
+
 // Create VBOs and such
 void BasicDrawableGLES::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scene *scene)
 {
@@ -98,9 +152,30 @@ void BasicDrawableGLES::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scen
     //        NSLog(@"Hey why are we doing setupGL on the main thread? %s",name.c_str());
     //    }
     
+    const bool interleaved = !interleavedVerts.empty();
+    const int numVerts = interleaved ? (int)(interleavedVerts.size() / vertexSize) : (int)points.size();
+
     // Offset the geometry upward by minZres units along the normals
     // Only do this once, obviously
-    if (drawOffset != 0 && (points.size() == vertexAttributes[normalEntry]->numElements()))
+    if (drawOffset != 0 && interleaved)
+    {
+        const auto *normAttr = (VertexAttributeGLES *)vertexAttributes[normalEntry];
+        if (normAttr->buffer != 0 && normAttr->dataType == BDFloat3Type)
+        {
+            const float scale = setupInfo->minZres*drawOffset;
+            unsigned char *basePtr = interleavedVerts.data();
+            for (int ii=0;ii<numVerts;ii++,basePtr+=vertexSize)
+            {
+                Vector3f pt,norm;
+                memcpy(pt.data(), basePtr, 3*sizeof(GLfloat));
+                memcpy(norm.data(), basePtr + normAttr->buffer, 3*sizeof(GLfloat));
+                pt += norm * scale;
+                memcpy(basePtr, pt.data(), 3*sizeof(GLfloat));
+            }
+        }
+    }
+    else if (drawOffset != 0 && vertexAttributes[normalEntry]->dataType == BDFloat3Type &&
+             (points.size() == vertexAttributes[normalEntry]->numElements()))
     {
         float scale = setupInfo->minZres*drawOffset;
         Point3fVector &norms = *(Point3fVector *)vertexAttributes[normalEntry]->data;
@@ -112,14 +187,22 @@ void BasicDrawableGLES::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scen
         }
     }
     
+    // Merged drawables hang on to their triangles so they can put back the ones turned back on
+    if (isMerged())
+    {
+        mergedTris = tris;
+        maskMergedTris(tris);
+    }
+
+    // Normals on a flat map and such don't need to be repeated for every vertex
+    if (typeid(*this) == typeid(BasicDrawableGLES) && !interleaved)
+        collapseConstantAttributes();
+
     pointBuffer = triBuffer = 0;
     sharedBuffer = 0;
     
     // We'll set up a single buffer for everything.
     // The other buffer pointers are now strides
-    // Size of a single vertex entry
-    const int numVerts = (int)points.size();
-    
     // Set up the buffer
     auto bufferSize = (int)(vertexSize*numVerts + tris.size()*sizeof(Triangle));
     sharedBuffer = setupInfo->memManager->getBufferID(bufferSize,GL_STATIC_DRAW);
@@ -135,10 +218,16 @@ void BasicDrawableGLES::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scen
         void *glMem = glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, GL_MAP_WRITE_BIT);
         if (auto *basePtr = (unsigned char *)glMem)
         {
-            memset(glMem, 0, bufferSize);
-
-            for (int ii = 0; ii < numVerts; ii++, basePtr += vertexSize)
-                addPointToBuffer(basePtr, ii, nullptr);
+            if (interleaved)
+            {
+                memcpy(basePtr, interleavedVerts.data(), interleavedVerts.size());
+            }
+            else
+            {
+                memset(glMem, 0, bufferSize);
+                for (int ii = 0; ii < numVerts; ii++, basePtr += vertexSize)
+                    addPointToBuffer(basePtr, ii, nullptr);
+            }
 
             // And copy in the element buffer
             if (!tris.empty())
@@ -159,8 +248,16 @@ void BasicDrawableGLES::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scen
         std::vector<unsigned char> glMemBuf(bufferSize);
         unsigned char *glMem = &glMemBuf[0];
         unsigned char *basePtr = glMem;
-        for (int ii=0;ii<numVerts;ii++,basePtr+=vertexSize)
-            addPointToBuffer(basePtr, ii,nullptr);
+        if (interleaved)
+        {
+            memcpy(basePtr, interleavedVerts.data(), interleavedVerts.size());
+            basePtr += interleavedVerts.size();
+        }
+        else
+        {
+            for (int ii=0;ii<numVerts;ii++,basePtr+=vertexSize)
+                addPointToBuffer(basePtr, ii,nullptr);
+        }
         
         // Now the element buffer
         triBuffer = numVerts*vertexSize;
@@ -172,9 +269,29 @@ void BasicDrawableGLES::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scen
     
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     
+    // Colors can still be changed later, so note where they went
+    colorOffset = -1;
+    if (colorEntry >= 0 && colorEntry < vertexAttributes.size())
+    {
+        const auto *colorAttr = (VertexAttributeGLES *)vertexAttributes[colorEntry];
+        const bool inBuffer = interleaved ? (colorAttr->buffer != 0) : (colorAttr->numElements() == numVerts);
+        if (inBuffer && colorAttr->dataType == BDChar4Type)
+            colorOffset = (int)colorAttr->buffer;
+    }
+    dirOffset = -1;
+    for (const auto *attr : vertexAttributes)
+    {
+        const auto *attrGLES = (const VertexAttributeGLES *)attr;
+        const bool inBuffer = interleaved ? (attrGLES->buffer != 0) : (attr->numElements() == numVerts);
+        if (attr->nameID == a_dirNameID && inBuffer && attr->dataType == BDFloat3Type)
+            dirOffset = (int)attrGLES->buffer;
+    }
+
     // Clear out the arrays, since we won't need them again
-    numPoints = (int)points.size();
+    gpuBytes = sharedBuffer ? bufferSize : 0;
+    numPoints = numVerts;
     points.clear();
+    std::vector<unsigned char>().swap(interleavedVerts);
     numTris = (int)tris.size();
     tris.clear();
     for (auto & vertexAttribute : vertexAttributes)
@@ -184,6 +301,114 @@ void BasicDrawableGLES::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scen
     isSetupGL = true;
 }
 
+void BasicDrawableGLES::setVertexColors(unsigned int startVert,unsigned int numVerts,RGBAColor inColor)
+{
+    if (!usingBuffers)
+    {
+        BasicDrawable::setVertexColors(startVert,numVerts,inColor);
+        return;
+    }
+    if (!sharedBuffer || colorOffset < 0 || startVert + numVerts > numPoints)
+        return;
+
+    unsigned char color[4];
+    inColor.asUChar4(color);
+
+    // The colors are interleaved with everything else, so it's one write per vertex
+    glBindBuffer(GL_ARRAY_BUFFER, sharedBuffer);
+    CheckGLError("BasicDrawable::setVertexColors() glBindBuffer");
+    for (unsigned int ii=0;ii<numVerts;ii++)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, (startVert+ii)*vertexSize + colorOffset, sizeof(color), color);
+    }
+    CheckGLError("BasicDrawable::setVertexColors() glBufferSubData");
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void BasicDrawableGLES::setVertexMotion(const std::vector<VertexMotion> &motions)
+{
+    if (!usingBuffers)
+    {
+        for (const auto &motion : motions)
+        {
+            if (motion.startVert + motion.numVerts <= points.size())
+                std::fill(points.begin() + motion.startVert, points.begin() + motion.startVert + motion.numVerts, motion.pos);
+        }
+        BasicDrawable::setVertexMotion(motions);
+        return;
+    }
+    if (!sharedBuffer || motions.empty())
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, sharedBuffer);
+    CheckGLError("BasicDrawable::setVertexMotion() glBindBuffer");
+
+    // Write the vertices in place, leaving everything interleaved with them alone
+    unsigned char *basePtr = nullptr;
+    if (hasMapBufferSupport)
+    {
+        basePtr = (unsigned char *)glMapBufferRange(GL_ARRAY_BUFFER, 0, numPoints*vertexSize, GL_MAP_WRITE_BIT);
+    }
+    for (const auto &motion : motions)
+    {
+        if (motion.startVert + motion.numVerts > numPoints)
+            continue;
+        for (unsigned int ii=motion.startVert;ii<motion.startVert+motion.numVerts;ii++)
+        {
+            if (basePtr)
+            {
+                memcpy(basePtr + ii*vertexSize + pointBuffer, &motion.pos.x(), 3*sizeof(GLfloat));
+                if (dirOffset >= 0)
+                    memcpy(basePtr + ii*vertexSize + dirOffset, &motion.dir.x(), 3*sizeof(GLfloat));
+            }
+            else
+            {
+                glBufferSubData(GL_ARRAY_BUFFER, ii*vertexSize + pointBuffer, 3*sizeof(GLfloat), &motion.pos.x());
+                if (dirOffset >= 0)
+                    glBufferSubData(GL_ARRAY_BUFFER, ii*vertexSize + dirOffset, 3*sizeof(GLfloat), &motion.dir.x());
+            }
+        }
+    }
+    if (basePtr)
+    {
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    CheckGLError("BasicDrawable::setVertexMotion() update");
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool BasicDrawableGLES::merge(BasicDrawable &inThat)
+{
+    // Subclasses have their own ideas about drawing, so it's just us
+    auto *that = dynamic_cast<BasicDrawableGLES *>(&inThat);
+    if (!that || typeid(*this) != typeid(BasicDrawableGLES) || typeid(*that) != typeid(BasicDrawableGLES) ||
+        usingBuffers || that->usingBuffers || !interleavedVerts.empty() || !that->interleavedVerts.empty() ||
+        !canMerge(*that))
+        return false;
+
+    if (!mergeGeometry(*that,tris,that->tris,(unsigned int)points.size(),(unsigned int)that->points.size()))
+        return false;
+    points.insert(points.end(),that->points.begin(),that->points.end());
+
+    return true;
+}
+
+void BasicDrawableGLES::mergedTrisChanged()
+{
+    if (!usingBuffers || !sharedBuffer || mergedTris.empty())
+        return;
+
+    std::vector<Triangle> masked;
+    maskMergedTris(masked);
+
+    // The triangles come after the vertices in the shared buffer
+    glBindBuffer(GL_ARRAY_BUFFER, sharedBuffer);
+    CheckGLError("BasicDrawable::mergedTrisChanged() glBindBuffer");
+    glBufferSubData(GL_ARRAY_BUFFER, triBuffer, masked.size()*sizeof(Triangle), &masked[0]);
+    CheckGLError("BasicDrawable::mergedTrisChanged() glBufferSubData");
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 // Tear down the VBOs we set up
 void BasicDrawableGLES::teardownForRenderer(const RenderSetupInfo *inSetupInfo,Scene *scene,RenderTeardownInfoRef teardown)
 {
@@ -193,7 +418,9 @@ void BasicDrawableGLES::teardownForRenderer(const RenderSetupInfo *inSetupInfo,S
     if (vertArrayObj)
         glDeleteVertexArrays(1,&vertArrayObj);
     vertArrayObj = 0;
+    vertArrayProg = 0;
     
+    gpuBytes = 0;
     if (sharedBuffer)
     {
         setupInfo->memManager->removeBufferID(sharedBuffer);
@@ -222,6 +449,9 @@ GLuint BasicDrawableGLES::setupVAO(ProgramGLES *prog)
     
     glGenVertexArrays(1, &theVertArrayObj);
     glBindVertexArray(theVertArrayObj);
+
+    vertArrayDefaults.clear();
+    vertArrayHasColor = false;
     
     // We're using a single buffer for all of our vertex attributes
     if (sharedBuffer)
@@ -249,6 +479,8 @@ GLuint BasicDrawableGLES::setupVAO(ProgramGLES *prog)
                 glEnableVertexAttribArray(thisAttr->index);
                 glVertexAttribPointer(thisAttr->index, attr->glEntryComponents(), attr->glType(), attr->glNormalize(), vertexSize, CALCBUFOFF(0,attr->buffer));
                 progAttrs[ii] = thisAttr;
+                if (attr->nameID == a_colorNameID)
+                    vertArrayHasColor = true;
             } else {
                 VertAttrDefault attrDef(thisAttr->index,*attr);
                 vertArrayDefaults.push_back(attrDef);
@@ -367,6 +599,16 @@ void BasicDrawableGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inScene)
         prog->setUniform(mvpNormalMatrixNameID, frameInfo->mvpNormalMat);
         prog->setUniform(u_pMatrixNameID, frameInfo->projMat);
     }
+
+    // Other copies of the world on a wrapped map are the same draw call with their own matrices
+    const unsigned int numDraws = clipCoords ? 1 : frameInfo->numCopyMats + 1;
+    const auto setCopyMatrices = [&](unsigned int which)
+    {
+        const DrawMatrices &mats = frameInfo->copyMats[which - 1];
+        prog->setUniform(mvpMatrixNameID, mats.mvp);
+        prog->setUniform(mvMatrixNameID, mats.mv);
+        prog->setUniform(mvNormalMatrixNameID, mats.mvNormal);
+    };
     
     // Any uniforms we may want to apply to the shader
     for (auto const &attr : uniforms)
@@ -392,10 +634,8 @@ void BasicDrawableGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inScene)
     prog->setUniform(u_EyeVecNameID, frameInfo->fullEyeVec);
     
     // The program itself may have some textures to bind
-    bool hasTexture[WhirlyKitMaxTextures];
-    int progTexBound = prog->bindTextures();
-    for (unsigned int ii=0;ii<progTexBound;ii++)
-        hasTexture[ii] = true;
+    StateCacheGLES *stateCache = frameInfo->stateCache;
+    const int progTexBound = prog->bindTextures(stateCache);
     
     // Zero or more textures in the drawable
     for (unsigned int ii=0;ii<WhirlyKitMaxTextures-progTexBound;ii++)
@@ -406,13 +646,10 @@ void BasicDrawableGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inScene)
         auto texScaleNameID = texScaleNameIDs[ii];
         auto texOffsetNameID = texOffsetNameIDs[ii];
         const OpenGLESUniform *texUni = prog->findUniform(baseMapNameID);
-        hasTexture[ii+progTexBound] = glTexID != 0 && texUni;
-        if (hasTexture[ii+progTexBound])
+        if (glTexID != 0 && texUni)
         {
             const auto &thisTexInfo = texInfo[ii];
-            glActiveTexture(GL_TEXTURE0+ii+progTexBound);
-            glBindTexture(GL_TEXTURE_2D, glTexID);
-            CheckGLError("BasicDrawable::drawVBO2() glBindTexture");
+            stateCache->bindTexture((int)ii+progTexBound, glTexID);
             prog->setUniform(baseMapNameID, (int)ii+progTexBound);
             prog->setUniform(hasBaseMapNameID, 1);
             float texScale = 1.0;
@@ -443,9 +680,18 @@ void BasicDrawableGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inScene)
     
     if (hasVertexArraySupport)
     {
+        // The VAO has the attribute locations baked in, so a different program needs a new one
+        if (vertArrayObj != 0 && vertArrayProg != prog->getProgram())
+        {
+            glDeleteVertexArrays(1, &vertArrayObj);
+            vertArrayObj = 0;
+        }
         // If necessary, set up the VAO (once)
         if (vertArrayObj == 0 && sharedBuffer != 0)
+        {
             vertArrayObj = setupVAO(prog);
+            vertArrayProg = prog->getProgram();
+        }
         
         // Figure out what we're using
         vertAttr = prog->findAttribute(a_PositionNameID);
@@ -558,40 +804,51 @@ void BasicDrawableGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inScene)
         }
     }
     
-    // Color has been overridden, so don't use the embedded ones
-    if (hasOverrideColor)
+    // Color has been overridden, so don't use the embedded ones.
+    // A VAO keeps its own enables, so in that case it has to wait until it's bound.
+    const OpenGLESAttribute *overrideColorAttr = hasOverrideColor ? prog->findAttribute(a_colorNameID) : nullptr;
+    if (overrideColorAttr && !vertArrayObj)
     {
-        if (const OpenGLESAttribute *colorAttr = prog->findAttribute(a_colorNameID))
-        {
-            glDisableVertexAttribArray(colorAttr->index);
-            glVertexAttrib4f(colorAttr->index, color.r / 255.0f, color.g / 255.0f, color.b / 255.0f,color.a / 255.0f);
-        }
+        glDisableVertexAttribArray(overrideColorAttr->index);
+        glVertexAttrib4f(overrideColorAttr->index, color.r / 255.0f, color.g / 255.0f, color.b / 255.0f,color.a / 255.0f);
     }
 
     // If we're using a vertex array object, bind it and draw
     if (vertArrayObj)
     {
         glBindVertexArray(vertArrayObj);
-        switch (type)
+        if (overrideColorAttr)
         {
-            case Triangles:
-                glDrawElements(GL_TRIANGLES, numTris*3, GL_UNSIGNED_SHORT, CALCBUFOFF(0,triBuffer));
-                CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
-                break;
-            case Points:
-                glDrawArrays(GL_POINTS, 0, numPoints);
-                CheckGLError("BasicDrawable::drawVBO2() glDrawArrays");
-                break;
-            case Lines:
-                glLineWidth(lineWidth);
-                glDrawArrays(GL_LINES, 0, numPoints);
-                CheckGLError("BasicDrawable::drawVBO2() glDrawArrays");
-                break;
-//            case GL_TRIANGLE_STRIP:
-//                glDrawArrays(type, 0, numPoints);
-//                CheckGLError("BasicDrawable::drawVBO2() glDrawArrays");
-//                break;
+            glDisableVertexAttribArray(overrideColorAttr->index);
+            glVertexAttrib4f(overrideColorAttr->index, color.r / 255.0f, color.g / 255.0f, color.b / 255.0f,color.a / 255.0f);
         }
+        for (unsigned int di=0;di<numDraws;di++)
+        {
+            if (di > 0)
+                setCopyMatrices(di);
+            switch (type)
+            {
+                case Triangles:
+                    glDrawElements(GL_TRIANGLES, numTris*3, GL_UNSIGNED_SHORT, CALCBUFOFF(0,triBuffer));
+                    CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
+                    break;
+                case Points:
+                    glDrawArrays(GL_POINTS, 0, numPoints);
+                    CheckGLError("BasicDrawable::drawVBO2() glDrawArrays");
+                    break;
+                case Lines:
+                    stateCache->setLineWidth(lineWidth);
+                    glDrawArrays(GL_LINES, 0, numPoints);
+                    CheckGLError("BasicDrawable::drawVBO2() glDrawArrays");
+                    break;
+//                case GL_TRIANGLE_STRIP:
+//                    glDrawArrays(type, 0, numPoints);
+//                    CheckGLError("BasicDrawable::drawVBO2() glDrawArrays");
+//                    break;
+            }
+        }
+        if (overrideColorAttr && vertArrayHasColor)
+            glEnableVertexAttribArray(overrideColorAttr->index);
         glBindVertexArray(0);
     } else {
         // Draw without a VAO
@@ -606,27 +863,46 @@ void BasicDrawableGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inScene)
                         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triBuffer);
                     }
                     CheckGLError("BasicDrawable::drawVBO2() glBindBuffer");
-                    glDrawElements(GL_TRIANGLES, numTris*3, GL_UNSIGNED_SHORT, (void *)((uintptr_t)triBuffer));
-                    CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
+                    for (unsigned int di=0;di<numDraws;di++)
+                    {
+                        if (di > 0)
+                            setCopyMatrices(di);
+                        glDrawElements(GL_TRIANGLES, numTris*3, GL_UNSIGNED_SHORT, (void *)((uintptr_t)triBuffer));
+                        CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
+                    }
                     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
                 } else {
-                    if (!boundElements)
-                        glDrawElements(GL_TRIANGLES, (GLsizei)tris.size()*3, GL_UNSIGNED_SHORT, &tris[0]);
-                    else
-                        glDrawElements(GL_TRIANGLES, numTris*3, GL_UNSIGNED_SHORT, nullptr);
-                    CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
+                    for (unsigned int di=0;di<numDraws;di++)
+                    {
+                        if (di > 0)
+                            setCopyMatrices(di);
+                        if (!boundElements)
+                            glDrawElements(GL_TRIANGLES, (GLsizei)tris.size()*3, GL_UNSIGNED_SHORT, &tris[0]);
+                        else
+                            glDrawElements(GL_TRIANGLES, numTris*3, GL_UNSIGNED_SHORT, nullptr);
+                        CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
+                    }
                 }
             }
                 break;
             case Points:
-                glDrawArrays(GL_POINTS, 0, numPoints);
-                CheckGLError("BasicDrawable::drawVBO2() glDrawArrays");
+                for (unsigned int di=0;di<numDraws;di++)
+                {
+                    if (di > 0)
+                        setCopyMatrices(di);
+                    glDrawArrays(GL_POINTS, 0, numPoints);
+                    CheckGLError("BasicDrawable::drawVBO2() glDrawArrays");
+                }
                 break;
             case Lines:
-                glLineWidth(lineWidth);
-                CheckGLError("BasicDrawable::drawVBO2() glLineWidth");
-                glDrawArrays(GL_LINES, 0, numPoints);
-                CheckGLError("BasicDrawable::drawVBO2() glDrawArrays");
+                stateCache->setLineWidth(lineWidth);
+                for (unsigned int di=0;di<numDraws;di++)
+                {
+                    if (di > 0)
+                        setCopyMatrices(di);
+                    glDrawArrays(GL_LINES, 0, numPoints);
+                    CheckGLError("BasicDrawable::drawVBO2() glDrawArrays");
+                }
                 break;
 //            case GL_TRIANGLE_STRIP:
 //                glDrawArrays(type, 0, numPoints);
@@ -635,13 +911,7 @@ void BasicDrawableGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inScene)
         }
     }
     
-    // Unbind any textures
-    for (unsigned int ii=0;ii<WhirlyKitMaxTextures;ii++)
-        if (hasTexture[ii])
-        {
-            glActiveTexture(GL_TEXTURE0+ii);
-            glBindTexture(GL_TEXTURE_2D, 0);
-        }
+    // Textures are left bound, so a following drawable with the same ones skips the binds
     
     // Tear down the various arrays, if we stood them up
     if (usedLocalVertices)
@@ -90,6 +90,19 @@ SimpleIdentity BasicDrawableInstance::getInstID() const
     return instID;
 }
 
+SimpleIdentity BasicDrawableInstance::getSortTexture() const
+{
+    if (!texInfo.empty() && texInfo[0].texId != EmptyIdentity)
+        return texInfo[0].texId;
+
+    return basicDraw ? basicDraw->getSortTexture() : EmptyIdentity;
+}
+
+uint64_t BasicDrawableInstance::getVertexLayoutKey() const
+{
+    return basicDraw ? basicDraw->getVertexLayoutKey() : 0;
+}
+
 SimpleIdentity BasicDrawableInstance::getProgram() const
 {
     if (programID != EmptyIdentity)
@@ -141,14 +154,12 @@ bool BasicDrawableInstance::isOn(WhirlyKit::RendererFrameInfo *frameInfo) const
     }
     
     // Zoom based check.  We need to be in the current zoom range
-    if (zoomSlot > -1 && zoomSlot <= MaplyMaxZoomSlots) {
-        float zoom = frameInfo->scene->getZoomSlotValue(zoomSlot);
-        if (zoom != MAXFLOAT) {
-            if (minZoomVis != DrawVisibleInvalid && zoom < minZoomVis)
-                return false;
-            if (maxZoomVis != DrawVisibleInvalid && zoom >= maxZoomVis)
-                return false;
-        }
+    if (zoomSlotMask & frameInfo->zoomSlotMask) {
+        const float zoom = frameInfo->zoomSlots[zoomSlot];
+        if (minZoomVis != DrawVisibleInvalid && zoom < minZoomVis)
+            return false;
+        if (maxZoomVis != DrawVisibleInvalid && zoom >= maxZoomVis)
+            return false;
     }
     
     return true;
@@ -186,6 +197,9 @@ bool BasicDrawableInstance::getWriteZbuffer() const
 
 void BasicDrawableInstance::updateRenderer(WhirlyKit::SceneRenderer *renderer)
 {
+    renderer->setRenderUntil(fadeUp);
+    renderer->setRenderUntil(fadeDown);
+
     if (moving)
     {
         // Motion requires continuous rendering
@@ -210,6 +224,37 @@ void BasicDrawableInstance::setEnableTimeRange(TimeInterval inStartEnable,TimeIn
     startEnable = inStartEnable;  endEnable = inEndEnable;
 }
 
+bool BasicDrawableInstance::getEnableTimeRange(TimeInterval &start,TimeInterval &end) const
+{
+    if (startEnable == endEnable)
+        return false;
+    start = startEnable;  end = endEnable;
+    return true;
+}
+
+void BasicDrawableInstance::setFade(TimeInterval inFadeDown,TimeInterval inFadeUp)
+{
+    if (fadeUp == inFadeUp && fadeDown == inFadeDown)
+        return;
+
+    setValuesChanged();
+
+    fadeUp = inFadeUp;  fadeDown = inFadeDown;
+}
+
+bool BasicDrawableInstance::getFade(TimeInterval &outFadeDown,TimeInterval &outFadeUp) const
+{
+    if (fadeUp == fadeDown)
+        return false;
+    outFadeDown = fadeDown;  outFadeUp = fadeUp;
+    return true;
+}
+
+bool BasicDrawableInstance::isScreenSpace() const
+{
+    return basicDraw && basicDraw->isScreenSpace();
+}
+
 void BasicDrawableInstance::setVisibleRange(float inMinVis,float inMaxVis)
 {
     minVis = inMinVis;   maxVis = inMaxVis;
@@ -231,6 +276,7 @@ void BasicDrawableInstance::setZoomInfo(int inZoomSlot,double inMinZoomVis,doubl
     zoomSlot = inZoomSlot;
     minZoomVis = inMinZoomVis;
     maxZoomVis = inMaxZoomVis;
+    zoomSlotMask = ZoomSlotMask(zoomSlot,minZoomVis,maxZoomVis);
 }
 
 /// Set the color
@@ -396,4 +442,25 @@ void BasicDrawableInstance::setInstanceData(int numInstances,RawDataRef data)
     this->instData = data;
 }
 
+void BasicDrawableInstance::setInstances(unsigned int startInst,const std::vector<SingleInstance> &insts)
+{
+    if (startInst + insts.size() > instances.size())
+        return;
+
+    std::copy(insts.begin(), insts.end(), instances.begin() + startInst);
+}
+
+InstancesChangeRequest::InstancesChangeRequest(SimpleIdentity drawId,unsigned int startInst,std::vector<BasicDrawableInstance::SingleInstance> insts) :
+    DrawableChangeRequest(drawId), startInst(startInst), insts(std::move(insts))
+{
+}
+
+void InstancesChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw)
+{
+    if (auto drawInst = dynamic_cast<BasicDrawableInstance*>(draw.get()))
+    {
+        drawInst->setInstances(startInst,insts);
+    }
+}
+
 }
@@ -80,8 +80,8 @@ void BasicDrawableInstanceBuilder::setEnableTimeRange(TimeInterval inStartEnable
 
 void BasicDrawableInstanceBuilder::setFade(TimeInterval inFadeDown,TimeInterval inFadeUp)
 {
-    // TODO: Add fade to instances
-//    drawInst->setFade(inFadeDown,inFadeUp);
+    drawInst->fadeDown = inFadeDown;
+    drawInst->fadeUp = inFadeUp;
 }
 
 void BasicDrawableInstanceBuilder::setViewerVisibility(double minViewerDist,double maxViewerDist,const Point3d &viewerCenter)
@@ -100,6 +100,7 @@ void BasicDrawableInstanceBuilder::setZoomInfo(int zoomSlot,double minZoomVis,do
     drawInst->zoomSlot = zoomSlot;
     drawInst->minZoomVis = minZoomVis;
     drawInst->maxZoomVis = maxZoomVis;
+    drawInst->zoomSlotMask = ZoomSlotMask(zoomSlot,minZoomVis,maxZoomVis);
 }
 
 void BasicDrawableInstanceBuilder::setDrawOrder(int64_t newOrder)
@@ -156,6 +157,11 @@ void BasicDrawableInstanceBuilder::setStartTime(TimeInterval inStartTime)
     drawInst->startTime = inStartTime;
 }
 
+void BasicDrawableInstanceBuilder::setPackedInstances(bool packed)
+{
+    drawInst->packedInstances = packed;
+}
+
 void BasicDrawableInstanceBuilder::addInstances(const std::vector<BasicDrawableInstance::SingleInstance> &insts)
 {
     drawInst->instances.insert(drawInst->instances.end(), insts.begin(), insts.end());
@@ -17,6 +17,7 @@
  */
 
 #import "BasicDrawableInstanceGLES.h"
+#import "TransformMath.h"
 #import "WhirlyKitLog.h"
 
 using namespace Eigen;
@@ -34,8 +35,15 @@ GLuint BasicDrawableInstanceGLES::setupVAO(RendererFrameInfoGLES *frameInfo)
     auto *prog = (ProgramGLES *)frameInfo->program;
     
     auto *basicDrawGL = dynamic_cast<BasicDrawableGLES *>(basicDraw.get());
+    // The basic drawable may have a VAO of its own, so leave its bookkeeping as it was
+    const auto basicDefaults = std::move(basicDrawGL->vertArrayDefaults);
+    const bool basicHasColor = basicDrawGL->vertArrayHasColor;
     vertArrayObj = basicDrawGL->setupVAO(prog);
-    vertArrayDefaults = basicDrawGL->vertArrayDefaults;
+    vertArrayProg = prog->getProgram();
+    vertArrayDefaults = std::move(basicDrawGL->vertArrayDefaults);
+    vertArrayHasColor = basicDrawGL->vertArrayHasColor;
+    basicDrawGL->vertArrayDefaults = basicDefaults;
+    basicDrawGL->vertArrayHasColor = basicHasColor;
     
     glBindVertexArray(vertArrayObj);
     
@@ -150,21 +158,7 @@ void BasicDrawableInstanceGLES::setupForRenderer(const RenderSetupInfo *inSetupI
     {
         for (unsigned int ii = 0; ii < instances.size(); ii++, basePtr += instSize)
         {
-            const SingleInstance &inst = instances[ii];
-            const Point3f center3f(inst.center.x(), inst.center.y(), inst.center.z());
-            const Matrix4f mat = Matrix4dToMatrix4f(inst.mat);
-            const float colorInst = inst.colorOverride ? 1.0 : 0.0;
-            const RGBAColor locColor = inst.colorOverride ? inst.color : color;
-            memcpy(basePtr, (void *) center3f.data(), centerSize);
-            memcpy(basePtr + centerSize, (void *) mat.data(), matSize);
-            memcpy(basePtr + centerSize + matSize, (void *) &colorInst, colorInstSize);
-            memcpy(basePtr + centerSize + matSize + colorInstSize, (void *) &locColor.r, colorSize);
-            if (moving)
-            {
-                const Point3d modelDir = (inst.endCenter - inst.center) / inst.duration;
-                const Point3f modelDir3f(modelDir.x(), modelDir.y(), modelDir.z());
-                memcpy(basePtr + centerSize + matSize + colorInstSize + colorSize, (void *) modelDir3f.data(), modelDirSize);
-            }
+            writeInstance(basePtr, instances[ii]);
         }
 
         if (hasMapBufferSupport)
@@ -181,6 +175,43 @@ void BasicDrawableInstanceGLES::setupForRenderer(const RenderSetupInfo *inSetupI
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void BasicDrawableInstanceGLES::writeInstance(unsigned char *basePtr,const SingleInstance &inst) const
+{
+    const Point3f center3f(inst.center.x(), inst.center.y(), inst.center.z());
+    const Matrix4f mat = Matrix4dToMatrix4f(inst.mat);
+    const float colorInst = inst.colorOverride ? 1.0 : 0.0;
+    const RGBAColor locColor = inst.colorOverride ? inst.color : color;
+    memcpy(basePtr, (void *) center3f.data(), centerSize);
+    memcpy(basePtr + centerSize, (void *) mat.data(), matSize);
+    memcpy(basePtr + centerSize + matSize, (void *) &colorInst, colorInstSize);
+    memcpy(basePtr + centerSize + matSize + colorInstSize, (void *) &locColor.r, colorSize);
+    if (moving)
+    {
+        const Point3d modelDir = (inst.endCenter - inst.center) / inst.duration;
+        const Point3f modelDir3f(modelDir.x(), modelDir.y(), modelDir.z());
+        memcpy(basePtr + centerSize + matSize + colorInstSize + colorSize, (void *) modelDir3f.data(), modelDirSize);
+    }
+}
+
+void BasicDrawableInstanceGLES::setInstances(unsigned int startInst,const std::vector<SingleInstance> &insts)
+{
+    BasicDrawableInstance::setInstances(startInst,insts);
+    if (!instBuffer || insts.empty() || startInst + insts.size() > numInstances)
+        return;
+
+    // Just the run that changed goes up, in one piece
+    std::vector<unsigned char> data(instSize * insts.size());
+    for (unsigned int ii = 0; ii < insts.size(); ii++)
+    {
+        writeInstance(&data[ii * instSize], insts[ii]);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, startInst * instSize, data.size(), data.data());
+    CheckGLError("BasicDrawableInstance::setInstances() glBufferSubData");
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 /// Clean up any rendering objects you may have (e.g. VBOs).
 void BasicDrawableInstanceGLES::teardownForRenderer(const RenderSetupInfo *inSetupInfo,Scene *scene,RenderTeardownInfoRef teardown)
 {
@@ -196,6 +227,7 @@ void BasicDrawableInstanceGLES::teardownForRenderer(const RenderSetupInfo *inSet
     {
         glDeleteVertexArrays(1, &vertArrayObj);
         vertArrayObj = 0;
+        vertArrayProg = 0;
     }
 }
 
@@ -215,8 +247,14 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
     if (!basicDrawGL || !basicDrawGL->isSetupInGL())
         return;
     
+    // Packed instances only make sense with GL instancing, since the
+    //  "matrices" are really things like the corners and texture coordinates of each quad
+    const bool packedInst = (instanceStyle == LocalStyle && packedInstances);
+    if (packedInst && !instBuffer)
+        return;
+
     // The old style where we reuse the basic drawable
-    if (instanceStyle == ReuseStyle)
+    if (instanceStyle == ReuseStyle || packedInst)
     {
         // New style makes use of OpenGL instancing and makes its own copy of the geometry
         auto *prog = (ProgramGLES *)frameInfo->program;
@@ -226,9 +264,32 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
             return;
         }
 
-        // Figure out if we're fading in or out
+        // Figure out if we're fading in or out, with our own times if we have them
         float fade = 1.0;
-        // Note: Time based fade isn't represented in the instance.  Probably should be.
+        const bool ownFade = (fadeUp != fadeDown);
+        const TimeInterval theFadeUp = ownFade ? fadeUp : basicDraw->fadeUp;
+        const TimeInterval theFadeDown = ownFade ? fadeDown : basicDraw->fadeDown;
+        if (theFadeDown < theFadeUp)
+        {
+            // Heading to 1
+            if (frameInfo->currentTime < theFadeDown)
+                fade = 0.0;
+            else
+                if (frameInfo->currentTime > theFadeUp)
+                    fade = 1.0;
+                else
+                    fade = (frameInfo->currentTime - theFadeDown)/(theFadeUp - theFadeDown);
+        } else if (theFadeUp < theFadeDown)
+        {
+            // Heading to 0
+            if (frameInfo->currentTime < theFadeUp)
+                fade = 1.0;
+            else
+                if (frameInfo->currentTime > theFadeDown)
+                    fade = 0.0;
+                else
+                    fade = 1.0f-(frameInfo->currentTime - theFadeUp)/(theFadeDown - theFadeUp);
+        }
 
         // Deal with the range based fade
         if (frameInfo->heightAboveSurface > 0.0)
@@ -294,7 +355,8 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
             }
         }
 
-        if (!anyTextures)
+        // Packed instances (e.g. wide vectors) may not need any
+        if (!anyTextures && !packedInst)
             wkLogLevel(Error,"BasicDrawableInstance: Drawable without textures");
 
         // Model/View/Projection matrix
@@ -328,10 +390,8 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
         prog->setUniform(u_EyeVecNameID, frameInfo->fullEyeVec);
 
         // The program itself may have some textures to bind
-        bool hasTexture[WhirlyKitMaxTextures];
-        int progTexBound = prog->bindTextures();
-        for (unsigned int ii=0;ii<progTexBound;ii++)
-            hasTexture[ii] = true;
+        StateCacheGLES *stateCache = frameInfo->stateCache;
+        const int progTexBound = prog->bindTextures(stateCache);
 
         bool boundElements = false;
 
@@ -344,12 +404,9 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
             const auto texScaleNameID = texScaleNameIDs[ii];
             const auto texOffsetNameID = texOffsetNameIDs[ii];
             const OpenGLESUniform *texUni = prog->findUniform(baseMapNameID);
-            hasTexture[ii+progTexBound] = glTexID != 0 && texUni;
-            if (hasTexture[ii+progTexBound])
+            if (glTexID != 0 && texUni)
             {
-                glActiveTexture(GL_TEXTURE0+ii+progTexBound);
-                glBindTexture(GL_TEXTURE_2D, glTexID);
-                CheckGLError("BasicDrawableInstance::drawVBO2() glBindTexture");
+                stateCache->bindTexture((int)ii+progTexBound, glTexID);
                 prog->setUniform(baseMapNameID, (int)ii+progTexBound);
                 CheckGLError("BasicDrawableInstance::drawVBO2() glUniform1i");
                 prog->setUniform(hasBaseMapNameID, 1);
@@ -384,6 +441,12 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
         }
 
         if (hasVertexArraySupport) {
+            // Attribute locations are particular to the program
+            if (vertArrayObj != 0 && vertArrayProg != prog->getProgram())
+            {
+                glDeleteVertexArrays(1, &vertArrayObj);
+                vertArrayObj = 0;
+            }
             // If necessary, set up the VAO (once)
             if (vertArrayObj == 0 && basicDrawGL->sharedBuffer != 0)
                 vertArrayObj = setupVAO(frameInfo);
@@ -392,9 +455,9 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
         // Figure out what we're using
         const OpenGLESAttribute *vertAttr = prog->findAttribute(a_PositionNameID);
 
-        // Vertex array
+        // Vertex array, which the VAO already has
         bool usedLocalVertices = false;
-        if (vertAttr)
+        if (vertAttr && !vertArrayObj)
         {
             if (basicDrawGL->sharedBuffer) {
                 glBindBuffer(GL_ARRAY_BUFFER,basicDrawGL->sharedBuffer);
@@ -455,13 +518,12 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
         }
 
         // Note: Something of a hack
-        if (hasColor)
+        // With a VAO this has to wait until it's bound, since it keeps its own enables
+        const OpenGLESAttribute *overrideColorAttr = hasColor ? prog->findAttribute(a_colorNameID) : nullptr;
+        if (overrideColorAttr && !vertArrayObj)
         {
-            if (const OpenGLESAttribute *colorAttr = prog->findAttribute(a_colorNameID))
-            {
-                glDisableVertexAttribArray(colorAttr->index);
-                glVertexAttrib4f(colorAttr->index, color.r / 255.0, color.g / 255.0, color.b / 255.0, color.a / 255.0);
-            }
+            glDisableVertexAttribArray(overrideColorAttr->index);
+            glVertexAttrib4f(overrideColorAttr->index, color.r / 255.0, color.g / 255.0, color.b / 255.0, color.a / 255.0);
         }
 
         // If there are no instances, fill in the identity
@@ -489,6 +551,11 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
         if (vertArrayObj)
         {
             glBindVertexArray(vertArrayObj);
+            if (overrideColorAttr)
+            {
+                glDisableVertexAttribArray(overrideColorAttr->index);
+                glVertexAttrib4f(overrideColorAttr->index, color.r / 255.0, color.g / 255.0, color.b / 255.0, color.a / 255.0);
+            }
 
             switch (basicDraw->type)
             {
@@ -509,7 +576,7 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
                     CheckGLError("BasicDrawable::drawVBO2() glDrawArrays");
                     break;
                 case Lines:
-                    glLineWidth(lineWidth);
+                    stateCache->setLineWidth(lineWidth);
                     if (instBuffer)
                     {
                         glDrawArraysInstanced(GL_LINES, 0, basicDraw->numPoints, numInstances);
@@ -527,6 +594,8 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
 //                    break;
             }
 
+            if (overrideColorAttr && vertArrayHasColor)
+                glEnableVertexAttribArray(overrideColorAttr->index);
             glBindVertexArray(0);
         } else {
             // Bind the element array
@@ -574,8 +643,7 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
                     CheckGLError("BasicDrawable::drawVBO2() glDrawArrays");
                     break;
                 case GL_LINES:
-                    glLineWidth(lineWidth);
-                    CheckGLError("BasicDrawable::drawVBO2() glLineWidth");
+                    stateCache->setLineWidth(lineWidth);
                     if (instBuffer)
                     {
                         glDrawArraysInstanced(GL_LINES, 0, basicDraw->numPoints, numInstances);
@@ -594,15 +662,7 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
             }
         }
 
-        // Unbind any textures
-        for (unsigned int ii=0;ii<WhirlyKitMaxTextures;ii++)
-        {
-            if (hasTexture[ii])
-            {
-                glActiveTexture(GL_TEXTURE0 + ii);
-                glBindTexture(GL_TEXTURE_2D, 0);
-            }
-        }
+        // Textures are left bound, like the basic drawables
 
         // Tear down the various arrays, if we stood them up
         if (usedLocalVertices)
@@ -727,24 +787,25 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
         }
         else
         {
+            // Note: Ignoring offsets, so won't work reliably in 2D
+            FrameMatrices frameMats;
+            frameMats.mv = frameInfo->viewTrans4d * frameInfo->modelTrans4d;
+            frameMats.mvp = frameInfo->projMat4d * frameMats.mv;
+            const Eigen::Matrix4d mvInv = AffineInverse(frameMats.mv);
+            frameMats.mvpInv = mvInv * frameInfo->projMat4d.inverse();
+            frameMats.mvNormal = mvInv.transpose();
+
             // Run through the list of instances
+            DrawMatrices instMats;
             for (const auto &singleInst : instances)
             {
                 // Change color
                 basicDrawGL->color = singleInst.colorOverride ? singleInst.color : (hasColor ? color : oldColor);
 
-                // Note: Ignoring offsets, so won't work reliably in 2D
-                const Eigen::Matrix4d newMvpMat = frameInfo->projMat4d * frameInfo->viewTrans4d * frameInfo->modelTrans4d * singleInst.mat;
-                const Eigen::Matrix4d newMvMat = frameInfo->viewTrans4d * frameInfo->modelTrans4d * singleInst.mat;
-                const Eigen::Matrix4d newMvNormalMat = newMvMat.inverse().transpose();
-
-                // Inefficient, but effective
-                const Matrix4f mvpMat4f = Matrix4dToMatrix4f(newMvpMat);
-                const Matrix4f mvMat4f = Matrix4dToMatrix4f(newMvpMat);
-                const Matrix4f mvNormalMat4f = Matrix4dToMatrix4f(newMvNormalMat);
-                frameInfo->mvpMat = mvpMat4f;
-                frameInfo->viewAndModelMat = mvMat4f;
-                frameInfo->viewModelNormalMat = mvNormalMat4f;
+                CalcDrawMatrices(frameMats,singleInst.mat,instMats);
+                frameInfo->mvpMat = instMats.mvp;
+                frameInfo->viewAndModelMat = instMats.mv;
+                frameInfo->viewModelNormalMat = instMats.mvNormal;
 
                 basicDrawGL->draw(frameInfo,scene);
             }
@@ -101,6 +101,62 @@ void main()
 }
 )";
 
+// Billboards as instances of a unit quad.  The instance matrix holds the corner and edges,
+//  the texture corner and edges and the normal.  The quad's offset picks out which corner we are.
+static const char *vertexShaderInstGroundTri = R"(
+precision highp float;
+
+uniform mat4  u_mvpMatrix;
+uniform float u_fade;
+uniform vec3 u_eyeVec;
+
+attribute vec3 a_offset;
+attribute vec3 a_modelCenter;
+attribute mat4 a_singleMatrix;
+attribute vec4 a_instanceColor;
+
+varying vec2 v_texCoord;
+varying vec4 v_color;
+
+void main()
+{
+    v_texCoord = a_singleMatrix[1].zw + a_offset.x * a_singleMatrix[2].xy + a_offset.y * a_singleMatrix[2].zw;
+    v_color = a_instanceColor * u_fade;
+    vec2 offset = a_singleMatrix[0].xy + a_offset.x * a_singleMatrix[0].zw + a_offset.y * a_singleMatrix[1].xy;
+    vec3 normal = a_singleMatrix[3].xyz;
+    vec3 axisX = cross(u_eyeVec,normal);
+    vec3 newPos = a_modelCenter + axisX * offset.x + normal * offset.y;
+
+    gl_Position = u_mvpMatrix * vec4(newPos,1.0);
+}
+)";
+
+static const char *vertexShaderInstEyeTri = R"(
+precision highp float;
+
+uniform mat4  u_mvMatrix;
+uniform mat4  u_pMatrix;
+uniform float u_fade;
+
+attribute vec3 a_offset;
+attribute vec3 a_modelCenter;
+attribute mat4 a_singleMatrix;
+attribute vec4 a_instanceColor;
+
+varying vec2 v_texCoord;
+varying vec4 v_color;
+
+void main()
+{
+    v_texCoord = a_singleMatrix[1].zw + a_offset.x * a_singleMatrix[2].xy + a_offset.y * a_singleMatrix[2].zw;
+    v_color = a_instanceColor * u_fade;
+    vec2 offset = a_singleMatrix[0].xy + a_offset.x * a_singleMatrix[0].zw + a_offset.y * a_singleMatrix[1].xy;
+    vec4 pos = u_mvMatrix * vec4(a_modelCenter,1.0);
+    vec3 pos3 = (pos/pos.w).xyz;
+    gl_Position = u_pMatrix * vec4(pos3.x + offset.x,pos3.y + offset.y,pos3.z,1.0);
+}
+)";
+
 static const char *fragmentShaderTri = R"(
 precision highp float;
 
@@ -162,6 +218,38 @@ ProgramGLES *BuildBillboardEyeProgramGLES(const std::string &name,SceneRenderer
     
     return shader;
 }
+
+ProgramGLES *BuildBillboardGroundInstanceProgramGLES(const std::string &name,SceneRenderer *render)
+{
+    ProgramGLES *shader = new ProgramGLES(name,vertexShaderInstGroundTri,fragmentShaderTri);
+    if (!shader->isValid())
+    {
+        delete shader;
+        shader = NULL;
+    }
+
+    if (shader)
+    {
+        glUseProgram(shader->getProgram());
+        CheckGLError("BuildBillboardGroundInstanceProgram() glUseProgram");
+
+        shader->setUniform(u_EyeVecNameID, Point3f(0,0,1));
+    }
+
+    return shader;
+}
+
+ProgramGLES *BuildBillboardEyeInstanceProgramGLES(const std::string &name,SceneRenderer *render)
+{
+    ProgramGLES *shader = new ProgramGLES(name,vertexShaderInstEyeTri,fragmentShaderTri);
+    if (!shader->isValid())
+    {
+        delete shader;
+        shader = NULL;
+    }
+
+    return shader;
+}
     
 }
 
@@ -17,6 +17,7 @@
  */
 
 #import "BillboardManager.h"
+#import "ScreenSpaceBuilder.h"
 #import "SharedAttributes.h"
 
 using namespace Eigen;
@@ -47,13 +48,16 @@ BillboardInfo::BillboardInfo(const Dictionary &dict) :
 
     const auto orientStr = dict.getString(MaplyBillboardOrient, std::string());
     orient = (orientStr == MaplyBillboardOrientEye) ? Eye : Ground;
+
+    instanced = dict.getBool(MaplyBillboardInstanced,false);
 }
 
 Billboard::Billboard() :
     center(Point3d(0,0,0)),
     size(Point2d(0,0)),
     isSelectable(false),
-    selectID(EmptyIdentity)
+    selectID(EmptyIdentity),
+    partID(EmptyIdentity)
 {
 }
     
@@ -62,12 +66,15 @@ void BillboardSceneRep::clearContents(SelectionManagerRef &selectManager,ChangeS
     for (const auto it: drawIDs){
         changes.push_back(new RemDrawableReq(it,when));
     }
+    for (const auto it: quadIDs){
+        changes.push_back(new RemDrawableReq(it,when));
+    }
     if (selectManager && !selectIDs.empty()){
         selectManager->removeSelectables(selectIDs);
     }
 }
 
-BillboardBuilder::BillboardBuilder(Scene *scene,SceneRenderer *sceneRender,ChangeSet &changes,BillboardSceneRep *sceneRep,const BillboardInfo &billInfo,SimpleIdentity billboardProgram,SimpleIdentity texId) :
+BillboardBuilder::BillboardBuilder(Scene *scene,SceneRenderer *sceneRender,ChangeSet &changes,BillboardSceneRep *sceneRep,const BillboardInfo &billInfo,SimpleIdentity billboardProgram,SimpleIdentity texId,SimpleIdentity instProgram) :
     scene(scene),
     sceneRender(sceneRender),
     changes(changes),
@@ -75,7 +82,10 @@ BillboardBuilder::BillboardBuilder(Scene *scene,SceneRenderer *sceneRender,Chang
     billInfo(billInfo),
     drawable(nullptr),
     billboardProgram(billboardProgram),
-    texId(texId)
+    texId(texId),
+    lastPartID(EmptyIdentity),
+    hasParts(false),
+    instProgram(instProgram)
 {
 
 }
@@ -88,13 +98,20 @@ BillboardBuilder::~BillboardBuilder()
 void BillboardBuilder::addBillboard(const Point3d &center, const Point2dVector &pts,
                                     const std::vector<WhirlyKit::TexCoord> &texCoords,
                                     const WhirlyKit::RGBAColor *inColor,
-                                    const SingleVertexAttributeSet &vertAttrs)
+                                    const SingleVertexAttributeSet &vertAttrs,
+                                    SimpleIdentity partID)
 {
     if (pts.size() != 4)
     {
       //  NSLog(@"Only expecting 4 point polygons in BillboardDrawableBuilder");
         return;
     }
+
+    if (instProgram != EmptyIdentity && vertAttrs.empty() &&
+        addInstance(center, pts, texCoords, inColor ? *inColor : billInfo.color, partID))
+    {
+        return;
+    }
         
     CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
         
@@ -109,6 +126,9 @@ void BillboardBuilder::addBillboard(const Point3d &center, const Point2dVector &
         drawable = sceneRender->makeBillboardDrawableBuilder("Billboard");
         drawable->Init();
         drawable->setType(Triangles);
+        // Normals are unit length and texture coordinates are within one image
+        drawable->setCompactNormals();
+        drawable->setCompactTexCoords();
         billInfo.setupBasicDrawable(drawable);
         drawable->setGroundMode(billInfo.orient == BillboardInfo::Ground);
         drawable->setProgram(billboardProgram);
@@ -132,6 +152,7 @@ void BillboardBuilder::addBillboard(const Point3d &center, const Point2dVector &
     const Point3d axisY = coordAdapter->normalForLocal(localPt);
         
     const auto startPoint = drawable->getNumPoints();
+    const auto startTri = drawable->getNumTris();
     for (unsigned int ii=0;ii<4;ii++)
     {
         drawable->addPoint(center);
@@ -144,16 +165,124 @@ void BillboardBuilder::addBillboard(const Point3d &center, const Point2dVector &
     }
     drawable->addTriangle(BasicDrawable::Triangle(startPoint+0,startPoint+1,startPoint+2));
     drawable->addTriangle(BasicDrawable::Triangle(startPoint+0,startPoint+2,startPoint+3));
+
+    // Runs of triangles for the same part, or no part, share a range
+    if (!ranges.empty() && lastPartID == partID)
+    {
+        ranges.back().numTris += 2;
+    }
+    else
+    {
+        const SimpleIdentity rangeID = Identifiable::genId();
+        ranges.push_back(BasicDrawable::MergedRange { rangeID, (unsigned int)startTri, 2, true });
+        lastPartID = partID;
+        if (partID != EmptyIdentity)
+        {
+            sceneRep->parts[partID].drawIDs.insert(rangeID);
+            hasParts = true;
+        }
+    }
 }
     
+bool BillboardBuilder::addInstance(const Point3d &center,const Point2dVector &pts,
+                                   const std::vector<WhirlyKit::TexCoord> &texCoords,
+                                   const RGBAColor &color,SimpleIdentity partID)
+{
+    // Packed the same way as the screen space instances, with the normal in place of the rotation.
+    // The texture corners pick the billboard's image out of the (usually atlas) texture.
+    ScreenSpaceBuilder::ScreenSpaceInstance inst;
+    if (!inst.setCorners(pts, texCoords, Point2d(0,0), 1.0f))
+    {
+        return false;
+    }
+
+    if (instDraw && insts.size() >= MaxDrawablePoints)
+    {
+        flushInstances();
+    }
+
+    if (!instDraw)
+    {
+        // One quad, with the corners in the offsets.  It's never drawn on its own.
+        quadDraw = sceneRender->makeBillboardDrawableBuilder("Billboard Instance Quad");
+        quadDraw->Init();
+        quadDraw->setType(Triangles);
+        billInfo.setupBasicDrawable(quadDraw);
+        quadDraw->setGroundMode(billInfo.orient == BillboardInfo::Ground);
+        quadDraw->setProgram(instProgram);
+        quadDraw->setTexId(0,texId);
+        quadDraw->setOnOff(false);
+        for (unsigned int ii=0;ii<4;ii++)
+        {
+            quadDraw->addPoint(Point3d(0,0,0));
+            quadDraw->addOffset(Point3d((ii == 1 || ii == 2) ? 1.0 : 0.0,(ii >= 2) ? 1.0 : 0.0,0.0));
+            quadDraw->addTexCoord(0,TexCoord(0,0));
+            quadDraw->addNormal(Point3d(0,0,1));
+            quadDraw->addColor(RGBAColor::white());
+        }
+        quadDraw->addTriangle(BasicDrawable::Triangle(0,1,2));
+        quadDraw->addTriangle(BasicDrawable::Triangle(0,2,3));
+
+        instDraw = sceneRender->makeBasicDrawableInstanceBuilder("Billboard Instances");
+        instDraw->setMasterID(quadDraw->getDrawableID(),BasicDrawableInstance::LocalStyle);
+        instDraw->setPackedInstances(true);
+        billInfo.setupBasicDrawableInstance(instDraw);
+        instDraw->setProgram(instProgram);
+        instDraw->setTexId(0,texId);
+    }
+
+    // Normal is straight up
+    CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
+    const double len = center.norm();
+    const Point3d centerOnSphere = (len != 0.0) ? (center / len) : center;
+    const Point3d localPt = coordAdapter->displayToLocal(centerOnSphere);
+    inst.rotVec = coordAdapter->normalForLocal(localPt);
+    inst.center = center;
+    inst.color = color;
+
+    const auto singleInst = inst.getInstance();
+    if (partID != EmptyIdentity)
+    {
+        sceneRep->parts[partID].insts.push_back(BillboardSceneRep::Instance {
+            instDraw->getDrawableID(), (unsigned int)insts.size(), singleInst });
+    }
+    insts.push_back(singleInst);
+
+    return true;
+}
+
+void BillboardBuilder::flushInstances()
+{
+    if (instDraw && !insts.empty())
+    {
+        // The quad has to be in the scene before the instances based on it
+        sceneRep->quadIDs.insert(quadDraw->getDrawableID());
+        changes.push_back(new AddDrawableReq(quadDraw->getDrawable()));
+
+        instDraw->addInstances(insts);
+        sceneRep->drawIDs.insert(instDraw->getDrawableID());
+        changes.push_back(new AddDrawableReq(instDraw->getDrawable()));
+    }
+    quadDraw = nullptr;
+    instDraw = nullptr;
+    insts.clear();
+}
+
 void BillboardBuilder::flush()
 {
+    flushInstances();
+
     if (drawable)
     {
         if (drawable->getNumPoints() > 0)
         {
             //drawable->setLocalMbr(drawMbr);
             sceneRep->drawIDs.insert(drawable->getDrawableID());
+            // Without parts, there's no need to track the triangles
+            if (hasParts)
+            {
+                drawable->setMergedRanges(std::move(ranges));
+            }
             
 // TODO Port (fade isn't supported yet)
 //           if (billInfo.fade > 0.0)
@@ -165,6 +294,9 @@ void BillboardBuilder::flush()
         }
         drawable = nullptr;
     }
+    ranges.clear();
+    lastPartID = EmptyIdentity;
+    hasParts = false;
 }
 
 
@@ -189,8 +321,27 @@ SimpleIdentity BillboardManager::addBillboards(const std::vector<Billboard*> &bi
 
     CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
 
+    // Plain billboards can be instances, if they're using one of the default programs
+    SimpleIdentity instProgram = EmptyIdentity;
+    if (billboardInfo.instanced)
+    {
+        const Program *eyeProg = scene->findProgramByName(MaplyBillboardEyeShader);
+        const Program *groundProg = scene->findProgramByName(MaplyBillboardGroundShader);
+        if ((eyeProg && eyeProg->getId() == billboardInfo.programID) ||
+            (groundProg && groundProg->getId() == billboardInfo.programID))
+        {
+            const bool eye = (billboardInfo.orient == BillboardInfo::Eye);
+            if (const Program *instProg = scene->findProgramByName(eye ? MaplyBillboardEyeInstanceShader :
+                                                                         MaplyBillboardGroundInstanceShader))
+            {
+                instProgram = instProg->getId();
+            }
+        }
+    }
+
     // One builder per texture
     BuilderMap drawBuilders;
+    SelectionBatch selectBatch;
         
     // Work through the billboards, constructing as we go
     for (auto *billboard : billboards)
@@ -203,11 +354,12 @@ SimpleIdentity BillboardManager::addBillboards(const std::vector<Billboard*> &bi
             {
                 // new item inserted, fill in the value with a new builder
                 it.first->second = std::make_shared<BillboardBuilder>(scene,renderer,changes,sceneRep,billboardInfo,
-                                                                      billboardInfo.programID,billPoly.texId);
+                                                                      billboardInfo.programID,billPoly.texId,
+                                                                      instProgram);
             }
             const auto &drawBuilder = it.first->second;
             drawBuilder->addBillboard(billboard->center, billPoly.pts, billPoly.texCoords,
-                                      &billPoly.color, billPoly.vertexAttrs);
+                                      &billPoly.color, billPoly.vertexAttrs, billboard->partID);
         }
             
         // While we're at it, let's add this to the selection layer
@@ -218,14 +370,16 @@ SimpleIdentity BillboardManager::addBillboards(const std::vector<Billboard*> &bi
                 billboard->selectID = Identifiable::genId();
                 
             sceneRep->selectIDs.insert(billboard->selectID);
+            if (billboard->partID != EmptyIdentity)
+                sceneRep->parts[billboard->partID].selectID = billboard->selectID;
                 
                 // Normal is straight up
             const Point3d localPt = coordAdapter->displayToLocal(billboard->center);
             const Point3d axisY = coordAdapter->normalForLocal(localPt);
                 
-            selectManager->addSelectableBillboard(billboard->selectID, billboard->center, axisY, billboard->size,
-                                                  (float)billboardInfo.minVis, (float)billboardInfo.maxVis,
-                                                  billboardInfo.enable);
+            selectBatch.addSelectableBillboard(billboard->selectID, billboard->center, axisY, billboard->size,
+                                               (float)billboardInfo.minVis, (float)billboardInfo.maxVis,
+                                               billboardInfo.enable);
         }
     }
         
@@ -236,6 +390,9 @@ SimpleIdentity BillboardManager::addBillboards(const std::vector<Billboard*> &bi
         drawBuilder->flush();
     }
     drawBuilders.clear();
+
+    if (selectManager)
+        selectManager->addSelectables(selectBatch);
         
     const SimpleIdentity billID = sceneRep->getId();
 
@@ -303,4 +460,84 @@ void BillboardManager::removeBillboards(const SimpleIDSet &billIDs,ChangeSet &ch
     }
 }
 
+void BillboardManager::enableBillboardParts(SimpleIdentity billID,const SimpleIDSet &partIDs,bool enable,ChangeSet &changes)
+{
+    const auto selectManager = scene->getManager<SelectionManager>(kWKSelectionManager);
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    BillboardSceneRep dummyRep(billID);
+    const auto it = sceneReps.find(&dummyRep);
+    if (it == sceneReps.end())
+        return;
+
+    SimpleIDSet selectIDs;
+    ScreenSpaceBuilder::InstanceChangeMap instChanges;
+    for (const auto partID : partIDs)
+    {
+        const auto pit = (*it)->parts.find(partID);
+        if (pit == (*it)->parts.end())
+            continue;
+
+        // The scene steers these to the drawable holding the triangles
+        for (const auto rangeID : pit->second.drawIDs)
+            changes.push_back(new OnOffChangeRequest(rangeID, enable));
+        // Instances are hidden by clearing their color
+        for (const auto &inst : pit->second.insts)
+        {
+            auto &singleInst = instChanges[inst.drawID][inst.which];
+            singleInst = inst.inst;
+            if (!enable)
+                singleInst.color = RGBAColor(0,0,0,0);
+        }
+        if (pit->second.selectID != EmptyIdentity)
+            selectIDs.insert(pit->second.selectID);
+    }
+    ScreenSpaceBuilder::AddInstanceChanges(instChanges, changes);
+
+    if (selectManager && !selectIDs.empty())
+        selectManager->enableSelectables(selectIDs, enable);
+}
+
+void BillboardManager::removeBillboardParts(SimpleIdentity billID,const SimpleIDSet &partIDs,ChangeSet &changes)
+{
+    const auto selectManager = scene->getManager<SelectionManager>(kWKSelectionManager);
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    BillboardSceneRep dummyRep(billID);
+    const auto it = sceneReps.find(&dummyRep);
+    if (it == sceneReps.end())
+        return;
+    auto *sceneRep = *it;
+
+    SimpleIDSet selectIDs;
+    ScreenSpaceBuilder::InstanceChangeMap instChanges;
+    for (const auto partID : partIDs)
+    {
+        const auto pit = sceneRep->parts.find(partID);
+        if (pit == sceneRep->parts.end())
+            continue;
+
+        // Drops the triangles, and the drawable too if they were the last ones
+        for (const auto rangeID : pit->second.drawIDs)
+            changes.push_back(new RemDrawableReq(rangeID));
+        // Instances just get hidden, they go with the rest of the group
+        for (const auto &inst : pit->second.insts)
+        {
+            auto &singleInst = instChanges[inst.drawID][inst.which];
+            singleInst = inst.inst;
+            singleInst.color = RGBAColor(0,0,0,0);
+        }
+        if (pit->second.selectID != EmptyIdentity)
+        {
+            selectIDs.insert(pit->second.selectID);
+            sceneRep->selectIDs.erase(pit->second.selectID);
+        }
+        sceneRep->parts.erase(pit);
+    }
+    ScreenSpaceBuilder::AddInstanceChanges(instChanges, changes);
+
+    if (selectManager && !selectIDs.empty())
+        selectManager->removeSelectables(selectIDs);
+}
+
 }
@@ -16,6 +16,7 @@
  *  limitations under the License.
  */
 
+#import <mutex>
 #import "ChangeRequest.h"
 #import "Texture.h"
 #import "Drawable.h"
@@ -24,6 +25,245 @@
 namespace WhirlyKit
 {
 
+namespace
+{
+
+// Slots come in multiples of this, which also keeps them aligned for Eigen types
+static constexpr size_t PoolGranularity = 16;
+// Anything bigger than this comes from the regular heap
+static constexpr size_t PoolMaxSize = 256;
+static constexpr int PoolNumClasses = PoolMaxSize / PoolGranularity;
+// Number of slots moved between a thread and the shared pool at once
+static constexpr int PoolBatchSize = 64;
+
+struct PoolSlot
+{
+    PoolSlot *next;
+};
+
+// A list of free slots, all of the same size
+struct PoolChain
+{
+    PoolSlot *head = nullptr;
+    int count = 0;
+};
+
+// Move up to num slots from the front of one chain to another
+static inline void PoolMoveSlots(PoolChain &from,PoolChain &to,int num)
+{
+    while (num-- > 0 && from.head)
+    {
+        PoolSlot *slot = from.head;
+        from.head = slot->next;
+        from.count--;
+        slot->next = to.head;
+        to.head = slot;
+        to.count++;
+    }
+}
+
+// Free slots shared between threads.  Threads only visit this once per batch.
+struct PoolDepot
+{
+    std::mutex lock;
+    // Full batches
+    std::vector<PoolChain> chains[PoolNumClasses];
+    // Leftovers from exiting threads, merged until they make a batch
+    PoolChain partial[PoolNumClasses];
+
+    // Lock must be held
+    void put(int sizeClass,PoolChain &chain)
+    {
+        if (chain.count >= PoolBatchSize)
+        {
+            chains[sizeClass].push_back(chain);
+            chain = PoolChain();
+            return;
+        }
+        auto &part = partial[sizeClass];
+        while (chain.head)
+        {
+            PoolMoveSlots(chain,part,PoolBatchSize - part.count);
+            if (part.count >= PoolBatchSize)
+            {
+                chains[sizeClass].push_back(part);
+                part = PoolChain();
+            }
+        }
+        chain = PoolChain();
+    }
+
+    // Lock must be held.  Returns false if there's nothing.
+    bool take(int sizeClass,PoolChain &chain)
+    {
+        auto &full = chains[sizeClass];
+        if (!full.empty())
+        {
+            chain = full.back();
+            full.pop_back();
+            return true;
+        }
+        if (partial[sizeClass].count > 0)
+        {
+            chain = partial[sizeClass];
+            partial[sizeClass] = PoolChain();
+            return true;
+        }
+        return false;
+    }
+};
+
+// Note: Never deleted, so threads exiting late in shutdown can still return their slots.
+//       The slabs it hands out are kept for reuse rather than returned to the system.
+static PoolDepot &GetPoolDepot()
+{
+    static PoolDepot *depot = new PoolDepot();
+    return *depot;
+}
+
+static inline int PoolSizeClass(size_t size)
+{
+    return (int)((std::max(size,(size_t)1) + PoolGranularity - 1) / PoolGranularity) - 1;
+}
+
+// Per-thread cache of free slots
+struct PoolThreadCache
+{
+    PoolChain free[PoolNumClasses];
+
+    ~PoolThreadCache()
+    {
+        release(true);
+    }
+
+    // Hand back whole batches, keeping the rest for this thread unless it's going away.
+    // Partial batches would leave other threads coming back to the depot every few allocations.
+    void release(bool all)
+    {
+        bool any = false;
+        for (int ii=0;ii<PoolNumClasses && !any;ii++)
+        {
+            any = free[ii].count >= PoolBatchSize || (all && free[ii].count > 0);
+        }
+        if (!any)
+        {
+            return;
+        }
+
+        auto &depot = GetPoolDepot();
+        std::lock_guard<std::mutex> guardLock(depot.lock);
+        for (int ii=0;ii<PoolNumClasses;ii++)
+        {
+            auto &chain = free[ii];
+            while (chain.count >= PoolBatchSize)
+            {
+                PoolChain out;
+                PoolMoveSlots(chain,out,PoolBatchSize);
+                depot.put(ii,out);
+            }
+            if (all && chain.count > 0)
+            {
+                depot.put(ii,chain);
+            }
+        }
+    }
+
+    void *alloc(int sizeClass)
+    {
+        auto &chain = free[sizeClass];
+        if (!chain.head)
+        {
+            refill(sizeClass);
+        }
+
+        PoolSlot *slot = chain.head;
+        chain.head = slot->next;
+        chain.count--;
+        return slot;
+    }
+
+    void dealloc(void *ptr,int sizeClass)
+    {
+        auto &chain = free[sizeClass];
+        auto slot = (PoolSlot *)ptr;
+        slot->next = chain.head;
+        chain.head = slot;
+        chain.count++;
+
+        // The render thread frees most of these, so pass the excess along
+        if (chain.count >= 2*PoolBatchSize)
+        {
+            spill(sizeClass);
+        }
+    }
+
+    void refill(int sizeClass)
+    {
+        auto &chain = free[sizeClass];
+        {
+            auto &depot = GetPoolDepot();
+            std::lock_guard<std::mutex> guardLock(depot.lock);
+            if (depot.take(sizeClass,chain))
+            {
+                return;
+            }
+        }
+
+        // Nothing to reuse, so carve up a new slab
+        const size_t slotSize = (sizeClass + 1) * PoolGranularity;
+        auto slab = (unsigned char *)::operator new(slotSize * PoolBatchSize);
+        for (int ii=PoolBatchSize-1;ii>=0;ii--)
+        {
+            auto slot = (PoolSlot *)(slab + ii * slotSize);
+            slot->next = chain.head;
+            chain.head = slot;
+        }
+        chain.count = PoolBatchSize;
+    }
+
+    void spill(int sizeClass)
+    {
+        PoolChain out;
+        PoolMoveSlots(free[sizeClass],out,PoolBatchSize);
+
+        auto &depot = GetPoolDepot();
+        std::lock_guard<std::mutex> guardLock(depot.lock);
+        depot.put(sizeClass,out);
+    }
+};
+
+static thread_local PoolThreadCache poolThreadCache;
+
+}
+
+void *ChangeRequest::operator new(size_t size)
+{
+    if (size > PoolMaxSize)
+    {
+        return ::operator new(size);
+    }
+    return poolThreadCache.alloc(PoolSizeClass(size));
+}
+
+void ChangeRequest::operator delete(void *ptr,size_t size)
+{
+    if (!ptr)
+    {
+        return;
+    }
+    if (size > PoolMaxSize)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+    poolThreadCache.dealloc(ptr,PoolSizeClass(size));
+}
+
+void ChangeRequest::releasePoolCache()
+{
+    poolThreadCache.release(false);
+}
+
 void discardChanges(ChangeSet &changes)
 {
     for (auto &change : changes)
@@ -50,4 +290,91 @@ void ChangeRequest::setupForRenderer(const RenderSetupInfo *,Scene *scene) { }
 
 bool ChangeRequest::needPreExecute() { return false; }
 
+ChangeRequest::Priority ChangeRequest::getPriority() const { return PriorityNormal; }
+
+size_t ChangeRequest::getUploadSize() const { return 0; }
+
+SimpleIdentity ChangeRequest::getTargetID() const { return EmptyIdentity; }
+
+int ChangeRequest::getCoalesceSlot() const { return -1; }
+
+ChangeRequestQueue::~ChangeRequestQueue()
+{
+    ChangeSet changes;
+    drain(changes);
+    discardChanges(changes);
+}
+
+void ChangeRequestQueue::pushNode(Node *node)
+{
+    numPending.fetch_add((int)node->changes.size(), std::memory_order_relaxed);
+    numBatches.fetch_add(1, std::memory_order_relaxed);
+
+    // Standard lock-free stack push.  The consumer reverses the list to restore order.
+    node->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+void ChangeRequestQueue::push(ChangeSet &newChanges)
+{
+    if (newChanges.empty())
+    {
+        return;
+    }
+
+    auto node = new Node();
+    node->changes.swap(newChanges);
+    pushNode(node);
+}
+
+void ChangeRequestQueue::push(ChangeRequest *newChange)
+{
+    auto node = new Node();
+    node->changes.push_back(newChange);
+    pushNode(node);
+}
+
+int ChangeRequestQueue::drain(ChangeSet &dest)
+{
+    // Take the whole list in one go, leaving it empty for the producers
+    Node *node = head.exchange(nullptr, std::memory_order_acquire);
+    if (!node)
+    {
+        return 0;
+    }
+
+    // It comes out newest first, flip it around
+    Node *ordered = nullptr;
+    while (node)
+    {
+        Node *next = node->next;
+        node->next = ordered;
+        ordered = node;
+        node = next;
+    }
+
+    int count = 0;
+    while (ordered)
+    {
+        Node *next = ordered->next;
+        count += (int)ordered->changes.size();
+        if (dest.empty())
+        {
+            dest.swap(ordered->changes);
+        }
+        else
+        {
+            dest.insert(dest.end(), ordered->changes.begin(), ordered->changes.end());
+        }
+        delete ordered;
+        ordered = next;
+    }
+
+    numPending.fetch_sub(count, std::memory_order_relaxed);
+
+    return count;
+}
+
 }
@@ -0,0 +1,268 @@
+/*  ClusterHierarchy.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import <cmath>
+#import "ClusterHierarchy.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    // Below this we just look through the points
+    constexpr int KDNodeSize = 64;
+
+    // Split the range on the median and recurse, alternating axes
+    void kdSort(std::vector<int> &ids,const std::vector<double> &xs,const std::vector<double> &ys,
+                int left,int right,int axis)
+    {
+        if (right - left <= KDNodeSize)
+            return;
+
+        const int mid = (left + right) / 2;
+        const std::vector<double> &vals = (axis == 0) ? xs : ys;
+        std::nth_element(ids.begin() + left,ids.begin() + mid,ids.begin() + right + 1,
+                         [&vals](int a,int b) { return vals[a] < vals[b]; });
+
+        kdSort(ids,xs,ys,left,mid - 1,1 - axis);
+        kdSort(ids,xs,ys,mid + 1,right,1 - axis);
+    }
+
+    struct KDRange
+    {
+        int left,right,axis;
+    };
+}
+
+void ClusterKDIndex::build(const std::vector<double> &xs,const std::vector<double> &ys)
+{
+    const int numPts = (int)xs.size();
+    ids.resize(numPts);
+    for (int ii=0;ii<numPts;ii++)
+        ids[ii] = ii;
+
+    kdSort(ids,xs,ys,0,numPts - 1,0);
+
+    coords.resize(2 * numPts);
+    for (int ii=0;ii<numPts;ii++)
+    {
+        coords[2*ii] = xs[ids[ii]];
+        coords[2*ii+1] = ys[ids[ii]];
+    }
+}
+
+void ClusterKDIndex::range(double minX,double minY,double maxX,double maxY,std::vector<int> &results) const
+{
+    if (ids.empty())
+        return;
+
+    std::vector<KDRange> stack;
+    stack.push_back(KDRange { 0, (int)ids.size() - 1, 0 });
+    while (!stack.empty())
+    {
+        const KDRange r = stack.back();
+        stack.pop_back();
+
+        if (r.right - r.left <= KDNodeSize)
+        {
+            for (int ii=r.left;ii<=r.right;ii++)
+            {
+                const double x = coords[2*ii], y = coords[2*ii+1];
+                if (x >= minX && x <= maxX && y >= minY && y <= maxY)
+                    results.push_back(ids[ii]);
+            }
+            continue;
+        }
+
+        const int mid = (r.left + r.right) / 2;
+        const double x = coords[2*mid], y = coords[2*mid+1];
+        if (x >= minX && x <= maxX && y >= minY && y <= maxY)
+            results.push_back(ids[mid]);
+
+        const double val = (r.axis == 0) ? x : y;
+        if ((r.axis == 0) ? (minX <= val) : (minY <= val))
+            stack.push_back(KDRange { r.left, mid - 1, 1 - r.axis });
+        if ((r.axis == 0) ? (maxX >= val) : (maxY >= val))
+            stack.push_back(KDRange { mid + 1, r.right, 1 - r.axis });
+    }
+}
+
+void ClusterKDIndex::within(double qx,double qy,double radius,std::vector<int> &results) const
+{
+    if (ids.empty())
+        return;
+
+    const double r2 = radius * radius;
+    std::vector<KDRange> stack;
+    stack.push_back(KDRange { 0, (int)ids.size() - 1, 0 });
+    while (!stack.empty())
+    {
+        const KDRange r = stack.back();
+        stack.pop_back();
+
+        if (r.right - r.left <= KDNodeSize)
+        {
+            for (int ii=r.left;ii<=r.right;ii++)
+            {
+                const double dx = coords[2*ii] - qx, dy = coords[2*ii+1] - qy;
+                if (dx*dx + dy*dy <= r2)
+                    results.push_back(ids[ii]);
+            }
+            continue;
+        }
+
+        const int mid = (r.left + r.right) / 2;
+        const double x = coords[2*mid], y = coords[2*mid+1];
+        const double dx = x - qx, dy = y - qy;
+        if (dx*dx + dy*dy <= r2)
+            results.push_back(ids[mid]);
+
+        const double val = (r.axis == 0) ? x : y;
+        const double q = (r.axis == 0) ? qx : qy;
+        if (q - radius <= val)
+            stack.push_back(KDRange { r.left, mid - 1, 1 - r.axis });
+        if (q + radius >= val)
+            stack.push_back(KDRange { mid + 1, r.right, 1 - r.axis });
+    }
+}
+
+ClusterHierarchy::ClusterHierarchy(int minZoom,int maxZoom,double radius,double tileSize) :
+    minZoom(minZoom), maxZoom(std::max(minZoom,maxZoom)), radius(radius), tileSize(tileSize)
+{
+}
+
+void ClusterHierarchy::indexLevel(Level &level)
+{
+    std::vector<double> xs(level.nodes.size()), ys(level.nodes.size());
+    for (size_t ii=0;ii<level.nodes.size();ii++)
+    {
+        xs[ii] = level.nodes[ii].x;
+        ys[ii] = level.nodes[ii].y;
+    }
+    level.index.build(xs,ys);
+}
+
+bool ClusterHierarchy::build(const std::vector<double> &xs,const std::vector<double> &ys,volatile bool &cancel)
+{
+    levels.clear();
+    levels.resize(maxZoom - minZoom + 2);
+
+    // The input points are the bottom level
+    Level &leafLevel = levels.back();
+    leafLevel.nodes.reserve(xs.size());
+    for (size_t ii=0;ii<xs.size();ii++)
+        leafLevel.nodes.push_back(Node { xs[ii], ys[ii], 1, (int)ii, -1, 0 });
+    indexLevel(leafLevel);
+
+    std::vector<int> neighbors;
+    for (int zoom=maxZoom;zoom>=minZoom;zoom--)
+    {
+        if (cancel)
+        {
+            levels.clear();
+            return false;
+        }
+
+        const Level &below = levels[zoom + 1 - minZoom];
+        Level &level = levels[zoom - minZoom];
+        const double levelRadius = radius / (tileSize * std::pow(2.0,zoom));
+
+        std::vector<char> claimed(below.nodes.size(),0);
+        for (size_t ii=0;ii<below.nodes.size();ii++)
+        {
+            if (claimed[ii])
+                continue;
+            claimed[ii] = 1;
+
+            const Node &node = below.nodes[ii];
+            Node newNode { node.x * node.numPoints, node.y * node.numPoints, node.numPoints,
+                           node.leaf, (int)level.children.size(), 1 };
+            level.children.push_back((int)ii);
+
+            // Pull in anything close that's still free
+            neighbors.clear();
+            below.index.within(node.x,node.y,levelRadius,neighbors);
+            for (int which : neighbors)
+            {
+                if (claimed[which])
+                    continue;
+                claimed[which] = 1;
+
+                const Node &other = below.nodes[which];
+                newNode.x += other.x * other.numPoints;
+                newNode.y += other.y * other.numPoints;
+                newNode.numPoints += other.numPoints;
+                newNode.numChildren++;
+                level.children.push_back(which);
+            }
+
+            newNode.x /= newNode.numPoints;
+            newNode.y /= newNode.numPoints;
+            if (newNode.numChildren > 1)
+                newNode.leaf = -1;
+            level.nodes.push_back(newNode);
+        }
+
+        indexLevel(level);
+    }
+
+    return true;
+}
+
+int ClusterHierarchy::zoomForScale(double pixelsPerUnit) const
+{
+    if (pixelsPerUnit <= 0.0)
+        return minZoom;
+
+    const double zoom = std::floor(std::log2(pixelsPerUnit / tileSize));
+    return (int)std::min(std::max(zoom,(double)minZoom),(double)(maxZoom + 1));
+}
+
+void ClusterHierarchy::query(int zoom,double minX,double minY,double maxX,double maxY,std::vector<int> &nodes) const
+{
+    const int which = std::min(std::max(zoom,minZoom),maxZoom + 1) - minZoom;
+    if (which < (int)levels.size())
+        levels[which].index.range(minX,minY,maxX,maxY,nodes);
+}
+
+const ClusterHierarchy::Node &ClusterHierarchy::getNode(int zoom,int which) const
+{
+    return levels[std::min(std::max(zoom,minZoom),maxZoom + 1) - minZoom].nodes[which];
+}
+
+void ClusterHierarchy::getLeaves(int zoom,int which,std::vector<int> &leaves) const
+{
+    std::vector<std::pair<int,int>> stack;
+    stack.emplace_back(std::min(std::max(zoom,minZoom),maxZoom + 1) - minZoom,which);
+    while (!stack.empty())
+    {
+        const auto entry = stack.back();
+        stack.pop_back();
+
+        const Level &level = levels[entry.first];
+        const Node &node = level.nodes[entry.second];
+        if (node.leaf >= 0)
+        {
+            leaves.push_back(node.leaf);
+            continue;
+        }
+        for (int ii=0;ii<node.numChildren;ii++)
+            stack.emplace_back(entry.first + 1,level.children[node.firstChild + ii]);
+    }
+}
+
+}
@@ -91,6 +91,7 @@ void ComponentManager::addComponentObject(const ComponentObjectRef &compObj, Cha
 
     compObj->underConstruction = false;
     compObjsById[compObj->getId()] = compObj;
+    indexVectors(*compObj);
 
     // Does the new object have a UUID?
     if (!compObj->uuid.empty())
@@ -122,6 +123,23 @@ void ComponentManager::addComponentObject(const ComponentObjectRef &compObj, Cha
     }
 }
 
+void ComponentManager::indexVectors(const ComponentObject &compObj)
+{
+    vecIndex.remove(compObj.getId());
+
+    for (int ii=0;ii<(int)compObj.vecObjs.size();ii++)
+    {
+        Point2d ll,ur;
+        if (compObj.vecObjs[ii] && compObj.vecObjs[ii]->boundingBox(ll,ur))
+        {
+            // Inside tests use the point as-is and the near tests shift it by the offset, so cover both
+            vecIndex.add(compObj.getId(),ii,
+                         ll.cwiseMin(ll + compObj.vectorOffset),
+                         ur.cwiseMax(ur + compObj.vectorOffset));
+        }
+    }
+}
+
 bool ComponentManager::hasComponentObject(SimpleIdentity compID)
 {
     std::lock_guard<std::mutex> guardLock(lock);
@@ -156,6 +174,50 @@ void ComponentManager::removeComponentObjects(PlatformThreadInfo *threadInfo,
     removeComponentObjects(threadInfo,compIDs, changes, disposeAfterRemoval);
 }
 
+// All the IDs from a group of component objects, so each manager gets one call for the lot
+struct ComponentIDSets
+{
+    explicit ComponentIDSets(const std::vector<ComponentObjectRef> &compObjs)
+    {
+        for (const auto &compObj : compObjs)
+        {
+            add(compObj->markerIDs, markerIDs);
+            add(compObj->labelIDs, labelIDs);
+            add(compObj->vectorIDs, vectorIDs);
+            add(compObj->wideVectorIDs, wideVectorIDs);
+            add(compObj->shapeIDs, shapeIDs);
+            add(compObj->chunkIDs, chunkIDs);
+            add(compObj->loftIDs, loftIDs);
+            add(compObj->billIDs, billIDs);
+            add(compObj->geomIDs, geomIDs);
+            add(compObj->partSysIDs, partSysIDs);
+            add(compObj->drawStringIDs, drawStringIDs);
+            add(compObj->maskIDs, maskIDs);
+        }
+    }
+
+    static void add(const SimpleIDSet &from, SimpleIDSet &to)
+    {
+        if (to.empty())
+            to = from;
+        else
+            to.insert(from.begin(), from.end());
+    }
+
+    SimpleIDSet markerIDs;
+    SimpleIDSet labelIDs;
+    SimpleIDSet vectorIDs;
+    SimpleIDSet wideVectorIDs;
+    SimpleIDSet shapeIDs;
+    SimpleIDSet chunkIDs;
+    SimpleIDSet loftIDs;
+    SimpleIDSet billIDs;
+    SimpleIDSet geomIDs;
+    SimpleIDSet partSysIDs;
+    SimpleIDSet drawStringIDs;
+    SimpleIDSet maskIDs;
+};
+
 void ComponentManager::removeComponentObjects_NoLock(PlatformThreadInfo *,
                                                      const SimpleIDSet &compIDs,
                                                      std::vector<ComponentObjectRef> &objs)
@@ -167,7 +229,7 @@ void ComponentManager::removeComponentObjects_NoLock(PlatformThreadInfo *,
         if (it == compObjsById.end())
         {
             wkLogLevel(Warn,"Tried to delete object that doesn't exist: %d",compID);
-            return;
+            continue;
         }
 
         const ComponentObjectRef &compObj = it->second;
@@ -194,6 +256,11 @@ void ComponentManager::removeComponentObjects_NoLock(PlatformThreadInfo *,
             }
         }
 
+        if (!compObj->vecObjs.empty())
+        {
+            vecIndex.remove(compID);
+        }
+
         objs.push_back(compObj);
 
         compObjsById.erase(it);
@@ -217,51 +284,46 @@ void ComponentManager::removeComponentObjects(PlatformThreadInfo *threadInfo,
         removeComponentObjects_NoLock(threadInfo, compIDs, compRefs);
     }
 
-    SimpleIDSet maskIDs;
-    for (const ComponentObjectRef &compObj : compRefs)
+    // Get rid of the various layer objects, with one call to each manager for all of them
+    ComponentIDSets ids(compRefs);
+    if (!ids.markerIDs.empty())
+        markerManager->removeMarkers(ids.markerIDs, changes);
+    if (!ids.labelIDs.empty())
+        labelManager->removeLabels(threadInfo,ids.labelIDs, changes);
+    if (!ids.vectorIDs.empty())
+        vectorManager->removeVectors(ids.vectorIDs, changes);
+    if (!ids.wideVectorIDs.empty())
+        wideVectorManager->removeVectors(ids.wideVectorIDs, changes);
+    if (!ids.shapeIDs.empty())
+        shapeManager->removeShapes(ids.shapeIDs, changes);
+    if (!ids.loftIDs.empty())
+        loftManager->removeLoftedPolys(ids.loftIDs, changes);
+    if (!ids.chunkIDs.empty())
+        chunkManager->removeChunks(ids.chunkIDs, changes);
+    if (!ids.billIDs.empty())
+        billManager->removeBillboards(ids.billIDs, changes);
+    if (!ids.geomIDs.empty())
+        geomManager->removeGeometry(ids.geomIDs, changes);
+    if (!ids.drawStringIDs.empty())
     {
-        // Get rid of the various layer objects
-        if (!compObj->markerIDs.empty())
-            markerManager->removeMarkers(compObj->markerIDs, changes);
-        if (!compObj->labelIDs.empty())
-            labelManager->removeLabels(threadInfo,compObj->labelIDs, changes);
-        if (!compObj->vectorIDs.empty())
-            vectorManager->removeVectors(compObj->vectorIDs, changes);
-        if (!compObj->wideVectorIDs.empty())
-            wideVectorManager->removeVectors(compObj->wideVectorIDs, changes);
-        if (!compObj->shapeIDs.empty())
-            shapeManager->removeShapes(compObj->shapeIDs, changes);
-        if (!compObj->loftIDs.empty())
-            loftManager->removeLoftedPolys(compObj->loftIDs, changes);
-        if (!compObj->chunkIDs.empty())
-            chunkManager->removeChunks(compObj->chunkIDs, changes);
-        if (!compObj->billIDs.empty())
-            billManager->removeBillboards(compObj->billIDs, changes);
-        if (!compObj->geomIDs.empty())
-            geomManager->removeGeometry(compObj->geomIDs, changes);
-        if (!compObj->drawStringIDs.empty())
+        if (const auto ftm = scene ? scene->getFontTextureManager() : nullptr)
         {
-            if (const auto ftm = scene ? scene->getFontTextureManager() : nullptr)
+            // Giving the fonts 2s to stick around
+            //       This avoids problems with texture being paged out.
+            //       Without this we lose the textures before we're done with them
+            const TimeInterval when = scene->getCurrentTime() + 2.0;
+            for (SimpleIdentity dStrID : ids.drawStringIDs)
             {
-                // Giving the fonts 2s to stick around
-                //       This avoids problems with texture being paged out.
-                //       Without this we lose the textures before we're done with them
-                const TimeInterval when = scene->getCurrentTime() + 2.0;
-                for (SimpleIdentity dStrID : compObj->drawStringIDs)
-                {
-                    ftm->removeString(threadInfo, dStrID, changes, when);
-                }
+                ftm->removeString(threadInfo, dStrID, changes, when);
             }
         }
-        for (const auto partSysID : compObj->partSysIDs)
-        {
-            partSysManager->removeParticleSystem(partSysID, changes);
-        }
-        if (!compObj->maskIDs.empty())
-            maskIDs.insert(compObj->maskIDs.begin(),compObj->maskIDs.end());
+    }
+    for (const auto partSysID : ids.partSysIDs)
+    {
+        partSysManager->removeParticleSystem(partSysID, changes);
     }
 
-    releaseMaskIDs(maskIDs);
+    releaseMaskIDs(ids.maskIDs);
 }
 
 // NOLINTNEXTLINE(google-default-arguments)
@@ -308,7 +370,7 @@ void ComponentManager::enableComponentObjects(const SimpleIDSet &compIDs,bool en
             if (it == compObjsById.end())
             {
                 wkLogLevel(Warn,"Tried to enable/disable object that doesn't exist");
-                return;
+                continue;
             }
 
             const ComponentObjectRef &compObj = it->second;
@@ -325,6 +387,41 @@ void ComponentManager::enableComponentObjects(const SimpleIDSet &compIDs,bool en
     enableComponentObjects(compRefs, enable, changes, resolveReps);
 }
 
+template <typename T>
+void ComponentManager::enableContents(T &ids, bool enable, ChangeSet &changes)
+{
+    if (!ids.vectorIDs.empty())
+        vectorManager->enableVectors(ids.vectorIDs, enable, changes);
+    if (!ids.wideVectorIDs.empty())
+        wideVectorManager->enableVectors(ids.wideVectorIDs, enable, changes);
+    if (!ids.markerIDs.empty())
+        markerManager->enableMarkers(ids.markerIDs, enable, changes);
+    if (!ids.labelIDs.empty())
+        labelManager->enableLabels(ids.labelIDs, enable, changes);
+    if (!ids.shapeIDs.empty())
+        shapeManager->enableShapes(ids.shapeIDs, enable, changes);
+    if (!ids.billIDs.empty())
+        billManager->enableBillboards(ids.billIDs, enable, changes);
+    if (!ids.loftIDs.empty())
+        loftManager->enableLoftedPolys(ids.loftIDs, enable, changes);
+    if (geomManager && !ids.geomIDs.empty())
+        geomManager->enableGeometry(ids.geomIDs, enable, changes);
+    if (!ids.chunkIDs.empty())
+    {
+        for (auto const & it : ids.chunkIDs)
+        {
+            chunkManager->enableChunk(it, enable, changes);
+        }
+    }
+    if (partSysManager && !ids.partSysIDs.empty())
+    {
+        for (auto const it : ids.partSysIDs)
+        {
+            partSysManager->enableParticleSystem(it, enable, changes);
+        }
+    }
+}
+
 // Determine the new state for "that" given a change to "this."
 static bool ResolveRepresentationState(const ComponentObjectRef &thisObj, const ComponentObjectRef &thatObj)
 {
@@ -367,36 +464,7 @@ void ComponentManager::enableComponentObject(const ComponentObjectRef &compObj,
     //       But I'm not sure I want one std::mutex per object
     compObj->enable = enable;
 
-    if (!compObj->vectorIDs.empty())
-        vectorManager->enableVectors(compObj->vectorIDs, enable, changes);
-    if (!compObj->wideVectorIDs.empty())
-        wideVectorManager->enableVectors(compObj->wideVectorIDs, enable, changes);
-    if (!compObj->markerIDs.empty())
-        markerManager->enableMarkers(compObj->markerIDs, enable, changes);
-    if (!compObj->labelIDs.empty())
-        labelManager->enableLabels(compObj->labelIDs, enable, changes);
-    if (!compObj->shapeIDs.empty())
-        shapeManager->enableShapes(compObj->shapeIDs, enable, changes);
-    if (!compObj->billIDs.empty())
-        billManager->enableBillboards(compObj->billIDs, enable, changes);
-    if (!compObj->loftIDs.empty())
-        loftManager->enableLoftedPolys(compObj->loftIDs, enable, changes);
-    if (geomManager && !compObj->geomIDs.empty())
-        geomManager->enableGeometry(compObj->geomIDs, enable, changes);
-    if (!compObj->chunkIDs.empty())
-    {
-        for (auto const & it : compObj->chunkIDs)
-        {
-            chunkManager->enableChunk(it, enable, changes);
-        }
-    }
-    if (partSysManager && !compObj->partSysIDs.empty())
-    {
-        for (auto const it : compObj->partSysIDs)
-        {
-            partSysManager->enableParticleSystem(it, enable, changes);
-        }
-    }
+    enableContents(*compObj, enable, changes);
 
     // Handle the other representations of the same thing?
     if (resolveReps && !compObj->uuid.empty())
@@ -459,12 +527,19 @@ void ComponentManager::enableComponentObjects(const std::vector<ComponentObjectR
     }
 
     // Don't resolve individual items unless we skipped the above because there's only one item.
-    resolveReps = resolveReps && (compRefs.size() == 1);
+    if (compRefs.size() == 1)
+    {
+        enableComponentObject(compRefs.front(), enable, changes, resolveReps);
+        return;
+    }
 
+    // Gather up the IDs so each manager only gets called (and locked) once
     for (const auto &compObj : compRefs)
     {
-        enableComponentObject(compObj, enable, changes, resolveReps);
+        compObj->enable = enable;
     }
+    ComponentIDSets ids(compRefs);
+    enableContents(ids, enable, changes);
 }
 
 template <typename TIter>
@@ -649,47 +724,70 @@ std::vector<std::pair<ComponentObjectRef,VectorObjectRef>> ComponentManager::fin
         const Point2d &pt,double maxDist,const ViewStateRef &viewState,
         const Point2f &frameSize,int resultLimit)
 {
-    // not locked, we don't care if the size is off, we just want
-    // to typically do the allocations outside the locked region.
-    std::vector<ComponentObjectRef> compRefs;
-    compRefs.reserve(compObjsById.size());
+    // Anything the near test could pick up is in here.  If the point's not on the
+    // screen, nothing's near it and only the vectors it's inside are worth a look.
+    GeoMbr searchMbr;
+    if (!VectorObject::nearSearchBounds(pt, (float)maxDist, viewState, frameSize, searchMbr))
+    {
+        const GeoCoord geoCoord(pt.x(), pt.y());
+        searchMbr = GeoMbr(geoCoord, geoCoord);
+    }
+    const Point2d searchLL = searchMbr.ll().cast<double>().cwiseMin(pt);
+    const Point2d searchUR = searchMbr.ur().cast<double>().cwiseMax(pt);
 
     // Copy out the vectors that might be candidates
+    std::vector<CompObjVectorObjPair> candidates;
     {
         std::lock_guard<std::mutex> guardLock(lock);
-        for (const auto &kvp: compObjsById)
+
+        std::vector<VectorObjectIndex::Candidate> hits;
+        vecIndex.query(searchLL, searchUR, hits);
+
+        // Go in the same order as the component objects themselves
+        std::sort(hits.begin(), hits.end(), [](const auto &a, const auto &b) {
+            return a.compID < b.compID || (a.compID == b.compID && a.which < b.which);
+        });
+
+        candidates.reserve(hits.size());
+        for (const auto &hit : hits)
         {
-            const auto &compObj = kvp.second;
-            if (compObj->enable && compObj->isSelectable && !compObj->vecObjs.empty())
+            const auto it = compObjsById.find(hit.compID);
+            if (it == compObjsById.end())
+            {
+                continue;
+            }
+            const auto &compObj = it->second;
+            if (compObj->enable && compObj->isSelectable && hit.which < compObj->vecObjs.size())
             {
-                compRefs.push_back(compObj);
+                candidates.emplace_back(compObj, compObj->vecObjs[hit.which]);
             }
         }
     }
 
-    std::vector<std::pair<ComponentObjectRef,VectorObjectRef> > rets;
-    rets.reserve((resultLimit > 0) ? resultLimit : compRefs.size());
+    std::vector<CompObjVectorObjPair> rets;
+    rets.reserve((resultLimit > 0) ? resultLimit : candidates.size());
 
     // Work through the vector objects
-    for (const auto &compObj: compRefs)
+    for (size_t ii = 0; ii < candidates.size(); ++ii)
     {
+        const auto &compObj = candidates[ii].first;
+        const auto &vecObj = candidates[ii].second;
         const Point2d coord = pt - compObj->vectorOffset;
 
-        for (const auto &vecObj: compObj->vecObjs)
+        if (vecObj->pointInside(pt) ||
+            vecObj->pointNearLinear(coord, (float)maxDist, viewState, frameSize))
         {
-            if (vecObj->pointInside(pt) ||
-                vecObj->pointNearLinear(coord, (float)maxDist, viewState, frameSize))
-            {
-                rets.emplace_back(compObj, vecObj);
-            }
+            rets.emplace_back(compObj, vecObj);
         }
-        
-        if (resultLimit > 0 && rets.size() >= resultLimit)
+
+        // Finish up each component object before stopping
+        const bool lastOfObj = (ii + 1 == candidates.size() || candidates[ii + 1].first != compObj);
+        if (lastOfObj && resultLimit > 0 && rets.size() >= resultLimit)
         {
             break;
         }
     }
-    
+
     return rets;
 }
 
@@ -0,0 +1,248 @@
+/*  CompressedImage.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <cstring>
+#import "CompressedImage.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    const unsigned char KTX1Magic[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    const unsigned char KTX2Magic[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    const unsigned char ASTCMagic[4] = { 0x13, 0xAB, 0xA1, 0x5C };
+
+    // ASTC 2D block footprints in the order GL and Vulkan number them
+    const int ASTCBlocks[14][2] = { {4,4}, {5,4}, {5,5}, {6,5}, {6,6}, {8,5}, {8,6}, {8,8},
+                                    {10,5}, {10,6}, {10,8}, {10,10}, {12,10}, {12,12} };
+
+    // The range GL uses for the ASTC formats, and then the sRGB ones
+    const unsigned int GLASTCBase = 0x93B0, GLASTCSRGBBase = 0x93D0;
+    // Vulkan puts two of each ASTC format in a row, linear and sRGB
+    const unsigned int VkASTCBase = 157;
+
+    uint32_t readLE32(const unsigned char *ptr)
+    {
+        return (uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+    }
+
+    uint64_t readLE64(const unsigned char *ptr)
+    {
+        return (uint64_t)readLE32(ptr) | ((uint64_t)readLE32(ptr + 4) << 32);
+    }
+
+    bool setASTCBlock(CompressedImageInfo &info,int which)
+    {
+        if (which < 0 || which >= 14)
+            return false;
+        info.format = CompressedASTC;
+        info.blockWidth = ASTCBlocks[which][0];
+        info.blockHeight = ASTCBlocks[which][1];
+        return true;
+    }
+
+    // GL internal formats, as found in KTX 1
+    bool setGLFormat(CompressedImageInfo &info,unsigned int glFormat)
+    {
+        switch (glFormat)
+        {
+            case 0x9270: info.format = CompressedEAC_R11; break;
+            case 0x9271: info.format = CompressedEAC_R11Signed; break;
+            case 0x9272: info.format = CompressedEAC_RG11; break;
+            case 0x9273: info.format = CompressedEAC_RG11Signed; break;
+            case 0x9274: info.format = CompressedETC2_RGB8; break;
+            case 0x9275: info.format = CompressedETC2_RGB8; info.sRGB = true; break;
+            case 0x9276: info.format = CompressedETC2_RGB8A1; break;
+            case 0x9277: info.format = CompressedETC2_RGB8A1; info.sRGB = true; break;
+            case 0x9278: info.format = CompressedETC2_RGBA8; break;
+            case 0x9279: info.format = CompressedETC2_RGBA8; info.sRGB = true; break;
+            default:
+                if (glFormat >= GLASTCSRGBBase)
+                {
+                    info.sRGB = true;
+                    return setASTCBlock(info,(int)(glFormat - GLASTCSRGBBase));
+                }
+                if (glFormat >= GLASTCBase)
+                    return setASTCBlock(info,(int)(glFormat - GLASTCBase));
+                return false;
+        }
+        return true;
+    }
+
+    // Vulkan formats, as found in KTX 2
+    bool setVkFormat(CompressedImageInfo &info,unsigned int vkFormat)
+    {
+        switch (vkFormat)
+        {
+            case 147: info.format = CompressedETC2_RGB8; break;
+            case 148: info.format = CompressedETC2_RGB8; info.sRGB = true; break;
+            case 149: info.format = CompressedETC2_RGB8A1; break;
+            case 150: info.format = CompressedETC2_RGB8A1; info.sRGB = true; break;
+            case 151: info.format = CompressedETC2_RGBA8; break;
+            case 152: info.format = CompressedETC2_RGBA8; info.sRGB = true; break;
+            case 153: info.format = CompressedEAC_R11; break;
+            case 154: info.format = CompressedEAC_R11Signed; break;
+            case 155: info.format = CompressedEAC_RG11; break;
+            case 156: info.format = CompressedEAC_RG11Signed; break;
+            default:
+                if (vkFormat < VkASTCBase)
+                    return false;
+                info.sRGB = (vkFormat - VkASTCBase) % 2;
+                return setASTCBlock(info,(int)(vkFormat - VkASTCBase) / 2);
+        }
+        return true;
+    }
+
+    bool parsePKM(const unsigned char *bytes,size_t len,CompressedImageInfo &info)
+    {
+        if (len < 16)
+            return false;
+        switch (bytes[7])
+        {
+            case 1: info.format = CompressedETC2_RGB8; break;
+            case 3: info.format = CompressedETC2_RGBA8; break;
+            case 4: info.format = CompressedETC2_RGB8A1; break;
+            case 5: info.format = CompressedEAC_R11; break;
+            case 6: info.format = CompressedEAC_RG11; break;
+            case 7: info.format = CompressedEAC_R11Signed; break;
+            case 8: info.format = CompressedEAC_RG11Signed; break;
+            default:
+                // ETC1 isn't something we can count on
+                return false;
+        }
+        // Big endian, padded out to the block size
+        info.width = (bytes[8] << 8) | bytes[9];
+        info.height = (bytes[10] << 8) | bytes[11];
+        info.offset = 16;
+        return true;
+    }
+
+    bool parseKTX1(const unsigned char *bytes,size_t len,CompressedImageInfo &info)
+    {
+        if (len < 68 || readLE32(&bytes[12]) != 0x04030201)
+            return false;
+        if (!setGLFormat(info,readLE32(&bytes[28])))
+            return false;
+        info.width = (int)readLE32(&bytes[36]);
+        info.height = (int)readLE32(&bytes[40]);
+        // Skip the key/value data to get to the first level's size
+        const size_t levelStart = 64 + (size_t)readLE32(&bytes[60]);
+        if (levelStart + 4 > len)
+            return false;
+        info.offset = levelStart + 4;
+        return true;
+    }
+
+    bool parseKTX2(const unsigned char *bytes,size_t len,CompressedImageInfo &info)
+    {
+        // Header, the section index, then the first entry in the level index
+        if (len < 104)
+            return false;
+        // Basis and zstd supercompression would need decoding on the CPU
+        if (readLE32(&bytes[44]) != 0)
+            return false;
+        if (!setVkFormat(info,readLE32(&bytes[12])))
+            return false;
+        info.width = (int)readLE32(&bytes[20]);
+        info.height = (int)readLE32(&bytes[24]);
+        const uint64_t levelOffset = readLE64(&bytes[80]);
+        const uint64_t levelLen = readLE64(&bytes[88]);
+        if (levelOffset > len || levelLen > len - levelOffset)
+            return false;
+        info.offset = (size_t)levelOffset;
+        return true;
+    }
+
+    bool parseASTC(const unsigned char *bytes,size_t len,CompressedImageInfo &info)
+    {
+        if (len < 16 || bytes[6] != 1)
+            return false;
+        const int blockWidth = bytes[4], blockHeight = bytes[5];
+        int which = 0;
+        while (which < 14 && (ASTCBlocks[which][0] != blockWidth || ASTCBlocks[which][1] != blockHeight))
+            which++;
+        if (!setASTCBlock(info,which))
+            return false;
+        info.width = bytes[7] | (bytes[8] << 8) | (bytes[9] << 16);
+        info.height = bytes[10] | (bytes[11] << 8) | (bytes[12] << 16);
+        info.offset = 16;
+        return true;
+    }
+}
+
+int CompressedImageInfo::bytesPerBlock() const
+{
+    switch (format)
+    {
+        case CompressedETC2_RGB8:
+        case CompressedETC2_RGB8A1:
+        case CompressedEAC_R11:
+        case CompressedEAC_R11Signed:
+            return 8;
+        case CompressedETC2_RGBA8:
+        case CompressedEAC_RG11:
+        case CompressedEAC_RG11Signed:
+        case CompressedASTC:
+            return 16;
+        case CompressedNone:
+        default:
+            return 0;
+    }
+}
+
+int CompressedImageInfo::astcBlockIndex() const
+{
+    if (format != CompressedASTC)
+        return -1;
+    for (int ii=0;ii<14;ii++)
+        if (ASTCBlocks[ii][0] == blockWidth && ASTCBlocks[ii][1] == blockHeight)
+            return ii;
+    return -1;
+}
+
+bool ParseCompressedImage(const RawData &data,CompressedImageInfo &info)
+{
+    info = CompressedImageInfo();
+
+    const unsigned char *bytes = data.getRawData();
+    const size_t len = data.getLen();
+    if (!bytes || len < 16)
+        return false;
+
+    bool found = false;
+    if (memcmp(bytes,"PKM ",4) == 0)
+        found = parsePKM(bytes,len,info);
+    else if (len >= 12 && memcmp(bytes,KTX1Magic,12) == 0)
+        found = parseKTX1(bytes,len,info);
+    else if (len >= 12 && memcmp(bytes,KTX2Magic,12) == 0)
+        found = parseKTX2(bytes,len,info);
+    else if (memcmp(bytes,ASTCMagic,4) == 0)
+        found = parseASTC(bytes,len,info);
+
+    if (found && info.width > 0 && info.height > 0)
+    {
+        // Work the size out ourselves rather than trust the container
+        info.size = (size_t)info.blocksWide() * info.blocksHigh() * info.bytesPerBlock();
+        if (info.offset <= len && info.size <= len - info.offset)
+            return true;
+    }
+
+    info = CompressedImageInfo();
+    return false;
+}
+
+}
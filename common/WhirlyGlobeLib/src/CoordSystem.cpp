@@ -16,6 +16,7 @@
  *  limitations under the License.
  */
 
+#import <algorithm>
 #import "Platform.h"
 #import "CoordSystem.h"
 
@@ -44,6 +45,49 @@ Point3d CoordSystemConvert3d(const CoordSystem *inSystem,const CoordSystem *outS
     return outSystem->geocentricToLocal(inSystem->localToGeocentric(inCoord));
 }
 
+void CoordSystemConvertBatch(const CoordSystem *inSystem,const CoordSystem *outSystem,const Point3d *inCoords,Point3d *outCoords,size_t count)
+{
+    if (inSystem->isSameAs(outSystem))
+    {
+        if (inCoords != outCoords)
+            std::copy(inCoords,inCoords+count,outCoords);
+        return;
+    }
+
+    inSystem->localToGeocentricBatch(inCoords,outCoords,count);
+    outSystem->geocentricToLocalBatch(outCoords,outCoords,count);
+}
+
+void CoordSystem::geographicToLocalBatch(const Point2d *geo,Point3d *local,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        local[ii] = geographicToLocal(geo[ii]);
+}
+
+void CoordSystem::localToGeographicBatch(const Point3d *local,Point2d *geo,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        geo[ii] = localToGeographicD(local[ii]);
+}
+
+void CoordSystem::localToGeocentricBatch(const Point3d *local,Point3d *geoc,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        geoc[ii] = localToGeocentric(local[ii]);
+}
+
+void CoordSystem::geocentricToLocalBatch(const Point3d *geoc,Point3d *local,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        local[ii] = geocentricToLocal(geoc[ii]);
+}
+
+void CoordSystemDisplayAdapter::localToDisplayBatch(const Point3d *local,Point3d *disp,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        disp[ii] = localToDisplay(local[ii]);
+}
+
 GeneralCoordSystemDisplayAdapter::GeneralCoordSystemDisplayAdapter(CoordSystem *coordSys,const Point3d &ll,const Point3d &ur,
                                                                    const Point3d &inCenter,const Point3d &inScale) :
     CoordSystemDisplayAdapter(coordSys,inCenter),
@@ -91,6 +135,21 @@ Point3d GeneralCoordSystemDisplayAdapter::localToDisplay(Point3d localPt) const
             center;
 }
     
+void GeneralCoordSystemDisplayAdapter::localToDisplayBatch(const Point3d *local,Point3d *disp,size_t count) const
+{
+    // Plain arrays of doubles, so the compiler can vectorize it
+    const double sx = scale.x(), sy = scale.y(), sz = scale.z();
+    const double cx = center.x(), cy = center.y(), cz = center.z();
+    const double *in = (const double *)local;
+    double *out = (double *)disp;
+    for (size_t ii=0;ii<count*3;ii+=3)
+    {
+        out[ii] = in[ii] * sx - cx;
+        out[ii+1] = in[ii+1] * sy - cy;
+        out[ii+2] = in[ii+2] * sz - cz;
+    }
+}
+
 Point3f GeneralCoordSystemDisplayAdapter::displayToLocal(Point3f dispPt) const
 {
     return Point3f(dispPt.x()/scale.x(),dispPt.y()/scale.y(),dispPt.z()/scale.z()) +
@@ -0,0 +1,123 @@
+/*  DecodeBufferPool.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "DecodeBufferPool.h"
+
+namespace WhirlyKit
+{
+
+const size_t DecodeBufferPool::DefaultMaxBytes;
+
+DecodeBufferPool::DecodeBufferPool(size_t maxBytes) :
+    maxBytes(maxBytes)
+{
+}
+
+DecodeBufferPool::~DecodeBufferPool()
+{
+    clear();
+}
+
+DecodeBufferPool &DecodeBufferPool::getShared()
+{
+    // Buffers may come back during shutdown, so this one stays
+    static auto *pool = new DecodeBufferPool();
+    return *pool;
+}
+
+RawDataRef DecodeBufferPool::getBuffer(size_t len,unsigned char **bytes)
+{
+    unsigned char *buf = nullptr;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        const auto it = buffers.find(len);
+        if (it != buffers.end())
+        {
+            buf = it->second;
+            buffers.erase(it);
+            bytesHeld -= len;
+        }
+    }
+    if (!buf)
+    {
+        buf = new unsigned char[len];
+    }
+
+    if (bytes)
+    {
+        *bytes = buf;
+    }
+    return std::make_shared<RawDataWrapper>(buf,len,[this,len](const void *data) {
+        returnBuffer((unsigned char *)data,len);
+    });
+}
+
+void DecodeBufferPool::returnBuffer(unsigned char *buf,size_t len)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    if (len > maxBytes)
+    {
+        delete [] buf;
+        return;
+    }
+    buffers.emplace(len,buf);
+    bytesHeld += len;
+    trim();
+}
+
+void DecodeBufferPool::trim()
+{
+    while (bytesHeld > maxBytes && !buffers.empty())
+    {
+        const auto it = buffers.begin();
+        bytesHeld -= it->first;
+        delete [] it->second;
+        buffers.erase(it);
+    }
+}
+
+void DecodeBufferPool::setMaxBytes(size_t inMaxBytes)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    maxBytes = inMaxBytes;
+    trim();
+}
+
+size_t DecodeBufferPool::getMaxBytes() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return maxBytes;
+}
+
+size_t DecodeBufferPool::getBytesHeld() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return bytesHeld;
+}
+
+void DecodeBufferPool::clear()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    for (const auto &it : buffers)
+    {
+        delete [] it.second;
+    }
+    buffers.clear();
+    bytesHeld = 0;
+}
+
+}
@@ -17,45 +17,48 @@
  */
 
 #import <sstream>
+#import <cstring>
+#import <algorithm>
 #import "DictionaryC.h"
 #import "WhirlyKitLog.h"
 
 namespace WhirlyKit
 {
 
+namespace {
+    // Below this many strings a scan beats hashing them
+    constexpr size_t StringHashMin = 16;
+
+    // Fields are kept sorted by key
+    template <typename Fields>
+    auto lowerBound(Fields &fields,unsigned int key) -> decltype(fields.begin())
+    {
+        return std::lower_bound(fields.begin(),fields.end(),key,
+                                [](const auto &field,unsigned int k) { return field.first < k; });
+    }
+}
+
 MutableDictionaryC::MutableDictionaryC()
-    : stringMap(20)     // ?
-    , valueMap(20)
 {
 }
 
 MutableDictionaryC::MutableDictionaryC(int capacity)
-    : stringMap(capacity)
-    , valueMap(capacity)
 {
+    if (capacity > 0)
+    {
+        data = std::make_shared<Storage>();
+        data->fields.reserve(capacity);
+        data->strings.reserve(capacity);
+    }
 }
 
 MutableDictionaryC::MutableDictionaryC(const MutableDictionaryC &that)
-    : intVals(that.intVals)
-    , int64Vals(that.int64Vals)
-    , dVals(that.dVals)
-    , stringVals(that.stringVals)
-    , arrayVals(that.arrayVals)
-    , dictVals(that.dictVals)
-    , stringMap(that.stringMap)
-    , valueMap(that.valueMap)
+    : data(that.data)
 {
 }
 
 MutableDictionaryC::MutableDictionaryC(MutableDictionaryC &&that) noexcept
-    : intVals(std::move(that.intVals))
-    , int64Vals(std::move(that.int64Vals))
-    , dVals(std::move(that.dVals))
-    , stringVals(std::move(that.stringVals))
-    , arrayVals(std::move(that.arrayVals))
-    , dictVals(std::move(that.dictVals))
-    , stringMap(std::move(that.stringMap))
-    , valueMap(std::move(that.valueMap))
+    : data(std::move(that.data))
 {
 }
 
@@ -119,254 +122,429 @@ MutableDictionaryC::MutableDictionaryC(MutableDictionaryC &&that) noexcept
 
 void MutableDictionaryC::clear()
 {
-    intVals.clear();
-    int64Vals.clear();
-    dVals.clear();
-    stringVals.clear();
-    arrayVals.clear();
-    dictVals.clear();
-    stringMap.clear();
-    valueMap.clear();
+    data.reset();
 }
     
 MutableDictionaryC &MutableDictionaryC::operator = (const MutableDictionaryC &that)
 {
-    intVals = that.intVals;
-    int64Vals = that.int64Vals;
-    dVals = that.dVals;
-    stringVals = that.stringVals;
-    arrayVals = that.arrayVals;
-    dictVals = that.dictVals;
-    stringMap = that.stringMap;
-    valueMap = that.valueMap;
+    data = that.data;
     
     return *this;
 }
 
 MutableDictionaryC &MutableDictionaryC::operator = (MutableDictionaryC &&that) noexcept
 {
-    intVals = std::move(that.intVals);
-    int64Vals = std::move(that.int64Vals);
-    dVals = std::move(that.dVals);
-    stringVals = std::move(that.stringVals);
-    arrayVals = std::move(that.arrayVals);
-    dictVals = std::move(that.dictVals);
-    stringMap = std::move(that.stringMap);
-    valueMap = std::move(that.valueMap);
+    data = std::move(that.data);
     
     return *this;
 }
 
-//MutableDictionaryC::MutableDictionaryC(RawData *rawData)
-//{
-//    RawDataReader dataRead(rawData);
-//    while (!dataRead.done())
-//    {
-//        int type;
-//        if (!dataRead.getInt(type))
-//            return;
-//        std::string attrName;
-//        if (!dataRead.getString(attrName))
-//            return;
-//        switch (type)
-//        {
-//            case DictTypeString:
-//            {
-//                std::string sVal;
-//                if (!dataRead.getString(sVal))
-//                    return;
-//                setString(attrName, sVal);
-//            }
-//                break;
-//            case DictTypeInt:
-//            {
-//                int iVal;
-//                if (!dataRead.getInt(iVal))
-//                    return;
-//                setInt(attrName, iVal);
-//            }
-//                break;
-//            case DictTypeDouble:
-//            {
-//                double dVal;
-//                if (!dataRead.getDouble(dVal))
-//                    return;
-//                setDouble(attrName, dVal);
-//            }
-//                break;
-//            default:
-//                return;
-//        }
-//    }
-//}
-//    
-//void MutableDictionaryC::asRawData(MutableRawData *rawData)
-//{
-//    for (FieldMap::iterator it = fields.begin(); it != fields.end(); ++it)
-//    {
-//        ValueRef val = it->second;
-//        if (val->type() == DictTypeObject)
-//            continue;
-//        rawData->addInt(val->type());
-//        rawData->addString(it->first);
-//        switch (val->type())
-//        {
-//            case DictTypeString:
-//            {
-//                std::string str;
-//                val->asString(str);
-//                rawData->addString(str);
-//            }
-//                break;
-//            case DictTypeInt:
-//                rawData->addInt(val->asInt());
-//                break;
-//            case DictTypeDouble:
-//                rawData->addDouble(val->asDouble());
-//                break;
-//            default:
-//                throw 1;
-//                break;
-//        }
-//    }
-//}
+MutableDictionaryC::Storage &MutableDictionaryC::mut()
+{
+    if (!data)
+        data = std::make_shared<Storage>();
+    else if (data.use_count() > 1)
+        data = std::make_shared<Storage>(*data);
+    return *data;
+}
+
+int MutableDictionaryC::findString(const std::string &str) const
+{
+    if (!data)
+        return -1;
+
+    const auto &strings = data->strings;
+    if (strings.size() < StringHashMin)
+    {
+        for (size_t ii=0;ii<strings.size();ii++)
+            if (strings[ii] == str)
+                return (int)ii;
+        return -1;
+    }
+
+    const auto it = data->stringMap.find(str);
+    return (it != data->stringMap.end()) ? (int)it->second : -1;
+}
+
+unsigned int MutableDictionaryC::addString(const std::string &str)
+{
+    const int which = findString(str);
+    if (which >= 0)
+        return which;
+
+    auto &store = mut();
+    const auto stringID = (unsigned int)store.strings.size();
+    store.strings.push_back(str);
+
+    // Start hashing once there are enough of them, keeping it up to date after that
+    if (store.strings.size() == StringHashMin)
+    {
+        store.stringMap.reserve(2 * StringHashMin);
+        for (unsigned int ii=0;ii<store.strings.size();ii++)
+            store.stringMap.emplace(store.strings[ii],ii);
+    }
+    else if (store.strings.size() > StringHashMin)
+    {
+        store.stringMap.emplace(str,stringID);
+    }
+
+    return stringID;
+}
+
+const MutableDictionaryC::Value *MutableDictionaryC::findValue(unsigned int key) const
+{
+    if (!data)
+        return nullptr;
+    const auto it = lowerBound(data->fields,key);
+    return (it != data->fields.end() && it->first == key) ? &it->second : nullptr;
+}
+
+const MutableDictionaryC::Value *MutableDictionaryC::findValue(const std::string &name) const
+{
+    const int key = findString(name);
+    return (key >= 0) ? findValue((unsigned int)key) : nullptr;
+}
+
+void MutableDictionaryC::setValue(unsigned int key,const Value &val)
+{
+    auto &fields = mut().fields;
+    const auto it = lowerBound(fields,key);
+    if (it != fields.end() && it->first == key)
+        it->second = val;
+    else
+        fields.insert(it,Field(key,val));
+}
+
+namespace {
+    // A value as it goes out in the raw data, the payload being whatever the value holds
+    struct PackedValue
+    {
+        uint32_t key;       // Not used for array entries
+        uint32_t type;
+        int64_t bits;
+    };
+
+    template <typename T>
+    void addPlainVector(MutableRawData *rawData,const std::vector<T> &vals)
+    {
+        rawData->addInt((int)vals.size());
+        rawData->addBytes(vals.data(), vals.size() * sizeof(T));
+    }
+
+    template <typename T>
+    bool getPlainVector(RawDataReader &reader,std::vector<T> &vals)
+    {
+        int count;
+        if (!reader.getInt(count) || count < 0)
+            return false;
+        const auto *bytes = reader.skipBytes((size_t)count * sizeof(T));
+        if (!bytes)
+            return false;
+        vals.resize(count);
+        if (count > 0)
+            memcpy(vals.data(), bytes, (size_t)count * sizeof(T));
+        return true;
+    }
+}
+
+void MutableDictionaryC::asRawData(MutableRawData *rawData) const
+{
+    static const Storage emptyStorage;
+    const Storage &store = data ? *data : emptyStorage;
+
+    rawData->addInt((int)store.strings.size());
+    for (const auto &str : store.strings)
+    {
+        rawData->addInt((int)str.size());
+        rawData->addBytes(str.data(), str.size());
+    }
+
+    rawData->addInt((int)store.dicts.size());
+    for (const auto &dict : store.dicts)
+    {
+        rawData->addInt(dict ? 1 : 0);
+        if (dict)
+        {
+            dict->asRawData(rawData);
+        }
+    }
+
+    std::vector<PackedValue> packed;
+    rawData->addInt((int)store.arrays.size());
+    for (const auto &arr : store.arrays)
+    {
+        packed.clear();
+        packed.reserve(arr.size());
+        for (const auto &val : arr)
+            packed.push_back(PackedValue { 0, (uint32_t)val.type, val.i64Val });
+        addPlainVector(rawData, packed);
+    }
+
+    packed.clear();
+    packed.reserve(store.fields.size());
+    for (const auto &field : store.fields)
+        packed.push_back(PackedValue { field.first, (uint32_t)field.second.type, field.second.i64Val });
+    addPlainVector(rawData, packed);
+}
+
+bool MutableDictionaryC::readRawData(RawDataReader &reader)
+{
+    clear();
+
+    auto store = std::make_shared<Storage>();
+
+    int numStrings;
+    if (!reader.getInt(numStrings) || numStrings < 0)
+        return false;
+    store->strings.reserve(numStrings);
+    for (int ii=0;ii<numStrings;ii++)
+    {
+        int len;
+        const unsigned char *bytes;
+        if (!reader.getInt(len) || len < 0 || !(bytes = reader.skipBytes(len)))
+            return false;
+        store->strings.emplace_back((const char *)bytes, len);
+    }
+    if (store->strings.size() >= StringHashMin)
+    {
+        store->stringMap.reserve(store->strings.size());
+        for (unsigned int ii=0;ii<store->strings.size();ii++)
+            store->stringMap.emplace(store->strings[ii],ii);
+    }
+
+    int numDicts;
+    if (!reader.getInt(numDicts) || numDicts < 0)
+        return false;
+    store->dicts.resize(numDicts);
+    for (auto &dict : store->dicts)
+    {
+        int present;
+        if (!reader.getInt(present))
+            return false;
+        if (present)
+        {
+            dict = std::make_shared<MutableDictionaryC>();
+            if (!dict->readRawData(reader))
+                return false;
+        }
+    }
+
+    const auto unpack = [](const PackedValue &packedVal)
+    {
+        Value val((DictionaryType)packedVal.type,0);
+        val.i64Val = packedVal.bits;
+        return val;
+    };
+
+    std::vector<PackedValue> packed;
+    int numArrays;
+    if (!reader.getInt(numArrays) || numArrays < 0)
+        return false;
+    store->arrays.resize(numArrays);
+    for (auto &arr : store->arrays)
+    {
+        if (!getPlainVector(reader, packed))
+            return false;
+        arr.reserve(packed.size());
+        for (const auto &packedVal : packed)
+            arr.push_back(unpack(packedVal));
+    }
+
+    if (!getPlainVector(reader, packed))
+        return false;
+    store->fields.reserve(packed.size());
+    for (const auto &packedVal : packed)
+    {
+        if (packedVal.key >= store->strings.size())
+            return false;
+        store->fields.emplace_back(packedVal.key, unpack(packedVal));
+    }
+
+    // Should be in order already, but we depend on it
+    std::sort(store->fields.begin(), store->fields.end(),
+              [](const Field &a,const Field &b) { return a.first < b.first; });
+    for (size_t ii=1;ii<store->fields.size();ii++)
+        if (store->fields[ii-1].first == store->fields[ii].first)
+            return false;
+
+    // Check the references before anyone follows them
+    const Storage &check = *store;
+    const auto validValue = [&check](const Value &val)
+    {
+        switch (val.type)
+        {
+            case DictTypeInt:
+            case DictTypeInt64:
+            case DictTypeIdentity:
+            case DictTypeDouble:     return true;
+            case DictTypeString:     return val.entry < check.strings.size();
+            case DictTypeDictionary: return val.entry < check.dicts.size() && check.dicts[val.entry];
+            case DictTypeArray:      return val.entry < check.arrays.size();
+            default:                 return false;
+        }
+    };
+    for (const auto &field : store->fields)
+        if (!validValue(field.second))
+            return false;
+    for (const auto &arr : store->arrays)
+        for (const auto &val : arr)
+            if (!validValue(val))
+                return false;
+
+    data = std::move(store);
+
+    return true;
+}
 
 bool MutableDictionaryC::hasField(const std::string &name) const
 {
-    const auto it = stringMap.find(name);
-    return (it != stringMap.end()) && hasField(it->second);
+    return findValue(name) != nullptr;
 }
 
 bool MutableDictionaryC::hasField(unsigned int key) const
 {
-    const auto it = valueMap.find(key);
-    return (it != valueMap.end());
+    return findValue(key) != nullptr;
 }
     
 DictionaryType MutableDictionaryC::getType(const std::string &name) const
 {
-    const auto it = stringMap.find(name);
-    return (it != stringMap.end()) ? getType(it->second) : DictTypeNone;
+    const Value *val = findValue(name);
+    return val ? val->type : DictTypeNone;
 }
 
 DictionaryType MutableDictionaryC::getType(unsigned int key) const
 {
-    const auto it = valueMap.find(key);
-    return (it != valueMap.end()) ? it->second.type : DictTypeNone;
+    const Value *val = findValue(key);
+    return val ? val->type : DictTypeNone;
+}
+
+DictionaryType MutableDictionaryC::getValue(const std::string &name,double &numVal,const std::string *&strVal) const
+{
+    const Value *val = findValue(name);
+    if (!val)
+        return DictTypeNone;
+
+    switch (val->type)
+    {
+        case DictTypeInt:      numVal = val->iVal;    break;
+        case DictTypeInt64:
+        case DictTypeIdentity: numVal = (double)val->i64Val;  break;
+        case DictTypeDouble:   numVal = val->dVal;    break;
+        case DictTypeString:   strVal = &data->strings[val->entry];  break;
+        default: break;
+    }
+    return val->type;
 }
 
 void MutableDictionaryC::removeField(const std::string &name)
 {
-    const auto it = stringMap.find(name);
-    if (it != stringMap.end())
-        removeField(it->second);
+    const int key = findString(name);
+    if (key >= 0)
+        removeField((unsigned int)key);
 }
 
 void MutableDictionaryC::removeField(unsigned int key)
 {
-    // We're "leaking" (via fragmentation) space in the data arrays
-    const auto it = valueMap.find(key);
-    if (it != valueMap.end())
-        valueMap.erase(it);
+    // We're "leaking" (via fragmentation) space in the strings and arrays
+    if (!findValue(key))
+        return;
+    auto &fields = mut().fields;
+    fields.erase(lowerBound(fields,key));
 }
 
 int MutableDictionaryC::getInt(const std::string &name,int defVal) const
 {
-    const auto it = stringMap.find(name);
-    return (it != stringMap.end()) ? getInt(it->second,defVal) : defVal;
+    const int key = findString(name);
+    return (key >= 0) ? getInt((unsigned int)key,defVal) : defVal;
 }
 
 int MutableDictionaryC::getInt(unsigned int key,int defVal) const
 {
-    const auto it = valueMap.find(key);
-    if (it == valueMap.end())
+    const Value *val = findValue(key);
+    if (!val)
         return defVal;
 
-    const auto &val = it->second;
-    switch (val.type) {
-        case DictTypeInt:     return intVals[val.entry];
-        case DictTypeInt64:   return (int)int64Vals[val.entry];
-        case DictTypeDouble:  return (int)dVals[val.entry];
+    switch (val->type) {
+        case DictTypeInt:     return val->iVal;
+        case DictTypeInt64:   return (int)val->i64Val;
+        case DictTypeDouble:  return (int)val->dVal;
         default:
-            wkLogLevel(Warn, "Unsupported conversion from type %d to int", val.type);
+            wkLogLevel(Warn, "Unsupported conversion from type %d to int", val->type);
             return defVal;
     }
 }
 
 SimpleIdentity MutableDictionaryC::getIdentity(const std::string &name) const
 {
-    const auto it = stringMap.find(name);
-    return (it != stringMap.end()) ? getIdentity(it->second) : EmptyIdentity;
+    const int key = findString(name);
+    return (key >= 0) ? getIdentity((unsigned int)key) : EmptyIdentity;
 }
 
 SimpleIdentity MutableDictionaryC::getIdentity(unsigned int key) const
 {
-    const auto it = valueMap.find(key);
-    if (it == valueMap.end())
+    const Value *val = findValue(key);
+    if (!val)
         return EmptyIdentity;
     
-    const auto &val = it->second;
-    switch (val.type) {
-        case DictTypeInt:            return intVals[val.entry];
+    switch (val->type) {
+        case DictTypeInt:            return val->iVal;
         case DictTypeInt64:
-        case DictTypeIdentity:       return int64Vals[val.entry];
-        case DictTypeDouble:         return (SimpleIdentity)dVals[val.entry];
+        case DictTypeIdentity:       return val->i64Val;
+        case DictTypeDouble:         return (SimpleIdentity)val->dVal;
         default:
-            wkLogLevel(Warn, "Unsupported conversion from type %d to identity", val.type);
+            wkLogLevel(Warn, "Unsupported conversion from type %d to identity", val->type);
             return EmptyIdentity;
     }
 }
 
 int64_t MutableDictionaryC::getInt64(const std::string &name,int64_t defVal) const
 {
-    const auto it = stringMap.find(name);
-    return (it != stringMap.end()) ? getInt64(it->second,defVal) : defVal;
+    const int key = findString(name);
+    return (key >= 0) ? getInt64((unsigned int)key,defVal) : defVal;
 }
 
 int64_t MutableDictionaryC::getInt64(unsigned int key,int64_t defVal) const
 {
-    const auto it = valueMap.find(key);
-    if (it == valueMap.end())
+    const Value *val = findValue(key);
+    if (!val)
         return defVal;
 
-    const auto &val = it->second;
-    switch (val.type) {
-        case DictTypeInt:      return intVals[val.entry];
+    switch (val->type) {
+        case DictTypeInt:      return val->iVal;
         case DictTypeInt64:
-        case DictTypeIdentity: return int64Vals[val.entry];
-        case DictTypeDouble:   return (int64_t)dVals[val.entry];
+        case DictTypeIdentity: return val->i64Val;
+        case DictTypeDouble:   return (int64_t)val->dVal;
         default:
-            wkLogLevel(Warn, "Unsupported conversion from type %d to int64", val.type);
+            wkLogLevel(Warn, "Unsupported conversion from type %d to int64", val->type);
             return defVal;
     }
 }
 
 bool MutableDictionaryC::getBool(const std::string &name,bool defVal) const
 {
-    const auto it = stringMap.find(name);
-    return (it == stringMap.end()) ? defVal : getBool(it->second, defVal);
+    const int key = findString(name);
+    return (key < 0) ? defVal : getBool((unsigned int)key, defVal);
 }
 
 bool MutableDictionaryC::getBool(unsigned int key,bool defVal) const
 {
-    const auto it = valueMap.find(key);
-    if (it == valueMap.end())
+    const Value *val = findValue(key);
+    if (!val)
         return defVal;
     
-    const auto &val = it->second;
-    switch (val.type) {
-        case DictTypeInt:   return intVals[val.entry] != 0;
-        case DictTypeInt64: return int64Vals[val.entry] != 0;
+    switch (val->type) {
+        case DictTypeInt:   return val->iVal != 0;
+        case DictTypeInt64: return val->i64Val != 0;
         default:
-            wkLogLevel(Warn, "Unsupported conversion from type %d to bool", val.type);
+            wkLogLevel(Warn, "Unsupported conversion from type %d to bool", val->type);
             return defVal;
     }
 }
 
 RGBAColor MutableDictionaryC::getColor(const std::string &name,const RGBAColor &defVal) const
 {
-    const auto it = stringMap.find(name);
-    return (it == stringMap.end()) ? defVal : getColor(it->second,defVal);
+    const int key = findString(name);
+    return (key < 0) ? defVal : getColor((unsigned int)key,defVal);
 }
 
 RGBAColor ARGBtoRGBAColor(uint32_t v)
@@ -397,16 +575,15 @@ RGBAColor parseColor(const char* const p, RGBAColor ret)
 
 RGBAColor MutableDictionaryC::getColor(unsigned int key,const RGBAColor &defVal) const
 {
-    const auto it = valueMap.find(key);
-    if (it == valueMap.end())
+    const Value *val = findValue(key);
+    if (!val)
         return defVal;
 
-    const auto &val = it->second;
-    switch (val.type)
+    switch (val->type)
     {
         case DictTypeString:
         {
-            const std::string &str = stringVals[val.entry];
+            const std::string &str = data->strings[val->entry];
             // We're looking for #RRGGBBAA, #RRGGBB, #RGBA, or #RGB
             if (str.length() < 4 || str[0] != '#')
                 return defVal;
@@ -415,11 +592,11 @@ RGBAColor MutableDictionaryC::getColor(unsigned int key,const RGBAColor &defVal)
         }
         case DictTypeInt:
         {
-            return ARGBtoRGBAColor(intVals[val.entry]);
+            return ARGBtoRGBAColor(val->iVal);
         }
         // No idea what this means
         default:
-            wkLogLevel(Warn, "Unsupported conversion from type %d to color", val.type);
+            wkLogLevel(Warn, "Unsupported conversion from type %d to color", val->type);
             return defVal;
     }
     
@@ -428,24 +605,23 @@ RGBAColor MutableDictionaryC::getColor(unsigned int key,const RGBAColor &defVal)
     
 double MutableDictionaryC::getDouble(const std::string &name,double defVal) const
 {
-    const auto it = stringMap.find(name);
-    return (it == stringMap.end()) ? defVal : getDouble(it->second,defVal);
+    const int key = findString(name);
+    return (key < 0) ? defVal : getDouble((unsigned int)key,defVal);
 }
 
 double MutableDictionaryC::getDouble(unsigned int key,double defVal) const
 {
-    const auto it = valueMap.find(key);
-    if (it == valueMap.end())
+    const Value *val = findValue(key);
+    if (!val)
         return defVal;
     
-    const auto &val = it->second;
-    switch (val.type) {
-        case DictTypeInt:      return intVals[val.entry];
+    switch (val->type) {
+        case DictTypeInt:      return val->iVal;
         case DictTypeInt64:
-        case DictTypeIdentity: return int64Vals[val.entry];
-        case DictTypeDouble:   return dVals[val.entry];
+        case DictTypeIdentity: return val->i64Val;
+        case DictTypeDouble:   return val->dVal;
         default:
-            wkLogLevel(Warn, "Unsupported conversion from type %d to double", val.type);
+            wkLogLevel(Warn, "Unsupported conversion from type %d to double", val->type);
             return defVal;
     }
 }
@@ -457,8 +633,8 @@ std::string MutableDictionaryC::getString(const std::string &name) const
 
 std::string MutableDictionaryC::getString(const std::string &name,const std::string &defVal) const
 {
-    const auto it = stringMap.find(name);
-    return (it != stringMap.end()) ? getString(it->second,defVal) : defVal;
+    const int key = findString(name);
+    return (key >= 0) ? getString((unsigned int)key,defVal) : defVal;
 }
 
 std::string MutableDictionaryC::getString(unsigned int key) const
@@ -468,22 +644,20 @@ std::string MutableDictionaryC::getString(unsigned int key) const
 
 std::string MutableDictionaryC::getString(unsigned int key,const std::string &defVal) const
 {
-    const auto it = valueMap.find(key);
-    if (it != valueMap.end())
+    if (const Value *value = findValue(key))
     {
-        const auto &value = it->second;
-        switch (value.type)
+        switch (value->type)
         {
-            case DictTypeString:   return stringVals[value.entry];
-            case DictTypeInt:      return std::to_string(intVals[value.entry]);
+            case DictTypeString:   return data->strings[value->entry];
+            case DictTypeInt:      return std::to_string(value->iVal);
             case DictTypeInt64:
-            case DictTypeIdentity: return std::to_string(int64Vals[value.entry]);
-            case DictTypeDouble:   return std::to_string(dVals[value.entry]);
+            case DictTypeIdentity: return std::to_string(value->i64Val);
+            case DictTypeDouble:   return std::to_string(value->dVal);
             case DictTypeNone:
             case DictTypeObject:
             case DictTypeDictionary:
             case DictTypeArray:
-                wkLogLevel(Warn, "Unsupported conversion from type %d to string", value.type);
+                wkLogLevel(Warn, "Unsupported conversion from type %d to string", value->type);
                 break;
         }
     }
@@ -492,21 +666,19 @@ std::string MutableDictionaryC::getString(unsigned int key,const std::string &de
 
 DictionaryRef MutableDictionaryC::getDict(const std::string &name) const
 {
-    const auto it = stringMap.find(name);
-    return (it != stringMap.end()) ? getDict(it->second) : DictionaryRef();
+    const int key = findString(name);
+    return (key >= 0) ? getDict((unsigned int)key) : DictionaryRef();
 }
 
 DictionaryRef MutableDictionaryC::getDict(unsigned int key) const
 {
-    const auto it = valueMap.find(key);
-    if (it != valueMap.end())
+    if (const Value *val = findValue(key))
     {
-        const auto &val = it->second;
-        if (val.type == DictTypeDictionary)
+        if (val->type == DictTypeDictionary)
         {
-            return dictVals[val.entry];
+            return data->dicts[val->entry];
         }
-        wkLogLevel(Warn, "Unsupported conversion from type %d to dictionary", val.type);
+        wkLogLevel(Warn, "Unsupported conversion from type %d to dictionary", val->type);
     }
     wkLogLevel(Warn, "Missing key %d", key);
     return DictionaryRef();
@@ -514,25 +686,25 @@ DictionaryRef MutableDictionaryC::getDict(unsigned int key) const
 
 DictionaryEntryRef MutableDictionaryC::getEntry(const std::string &name) const
 {
-    const auto it = stringMap.find(name);
-    return (it != stringMap.end()) ? getEntry(it->second) : DictionaryEntryRef();
+    const Value *val = findValue(name);
+    return val ? makeEntryRef(*val) : DictionaryEntryRef();
 }
 
 DictionaryEntryRef MutableDictionaryC::getEntry(unsigned int key) const
 {
-    const auto it = valueMap.find(key);
-    return (it != valueMap.end()) ? makeEntryRef(it->second) : DictionaryEntryRef();
+    const Value *val = findValue(key);
+    return val ? makeEntryRef(*val) : DictionaryEntryRef();
 }
 
 DictionaryEntryCRef MutableDictionaryC::makeEntryRef(const Value &val) const
 {
     switch (val.type) {
-    case DictTypeInt:        return std::make_shared<DictionaryEntryCBasic>(intVals[val.entry]);
+    case DictTypeInt:        return std::make_shared<DictionaryEntryCBasic>(val.iVal);
     case DictTypeIdentity:
-    case DictTypeInt64:      return std::make_shared<DictionaryEntryCBasic>(int64Vals[val.entry]);
-    case DictTypeDouble:     return std::make_shared<DictionaryEntryCBasic>(dVals[val.entry]);
-    case DictTypeString:     return std::make_shared<DictionaryEntryCString>(stringVals[val.entry]);
-    case DictTypeDictionary: return std::make_shared<DictionaryEntryCDict>(dictVals[val.entry]);
+    case DictTypeInt64:      return std::make_shared<DictionaryEntryCBasic>(val.i64Val);
+    case DictTypeDouble:     return std::make_shared<DictionaryEntryCBasic>(val.dVal);
+    case DictTypeString:     return std::make_shared<DictionaryEntryCString>(data->strings[val.entry]);
+    case DictTypeDictionary: return std::make_shared<DictionaryEntryCDict>(data->dicts[val.entry]);
     case DictTypeArray:      return std::make_shared<DictionaryEntryCArray>(formArray(val.entry));
     case DictTypeObject:
     case DictTypeNone:
@@ -543,18 +715,18 @@ DictionaryEntryCRef MutableDictionaryC::makeEntryRef(const Value &val) const
 
 std::vector<DictionaryEntryRef> MutableDictionaryC::getArray(const std::string &name) const
 {
-    const auto it = stringMap.find(name);
-    return (it != stringMap.end()) ? getArray(it->second) : std::vector<DictionaryEntryRef>();
+    const int key = findString(name);
+    return (key >= 0) ? getArray((unsigned int)key) : std::vector<DictionaryEntryRef>();
 }
 
 std::vector<DictionaryEntryRef> MutableDictionaryC::getArray(unsigned int key) const
 {
-    const auto it = valueMap.find(key);
-    if (it == valueMap.end() || it->second.type != DictTypeArray) {
+    const Value *val = findValue(key);
+    if (!val || val->type != DictTypeArray) {
         return std::vector<DictionaryEntryRef>();
     }
 
-    const auto arrayVal = arrayVals[it->second.entry];
+    const auto &arrayVal = data->arrays[val->entry];
 
     std::vector<DictionaryEntryRef> rets;
     rets.reserve(arrayVal.size());
@@ -568,7 +740,7 @@ std::vector<DictionaryEntryRef> MutableDictionaryC::getArray(unsigned int key) c
 
 std::vector<DictionaryEntryCRef> MutableDictionaryC::formArray(int idx) const
 {
-    const auto &arrVals = arrayVals[idx];
+    const auto &arrVals = data->arrays[idx];
 
     std::vector<DictionaryEntryCRef> rets;
     rets.reserve(arrVals.size());
@@ -584,19 +756,21 @@ std::vector<DictionaryEntryCRef> MutableDictionaryC::formArray(int idx) const
 std::vector<std::string> MutableDictionaryC::getKeys() const
 {
     std::vector<std::string> keys;
-    keys.reserve(valueMap.size());
-    for (const auto &value : valueMap)
+    if (!data)
+        return keys;
+
+    keys.reserve(data->fields.size());
+    for (const auto &field : data->fields)
     {
-        keys.push_back(stringVals[value.first]);
+        keys.push_back(data->strings[field.first]);
     }
     
     return keys;
 }
 
-int MutableDictionaryC::getKeyID(const std::string &name)
+int MutableDictionaryC::getKeyID(const std::string &name) const
 {
-    const auto &it = stringMap.find(name);
-    return (it != stringMap.end()) ? (int)it->second : -1;
+    return findString(name);
 }
 
 void MutableDictionaryC::setInt(const std::string &name,int val)
@@ -605,7 +779,7 @@ void MutableDictionaryC::setInt(const std::string &name,int val)
 }
 void MutableDictionaryC::setInt(unsigned int key,int val)
 {
-    set(key, val, DictTypeInt, intVals);
+    setValue(key, Value::intValue(val));
 }
 
 void MutableDictionaryC::setInt64(const std::string &name,int64_t val)
@@ -615,7 +789,7 @@ void MutableDictionaryC::setInt64(const std::string &name,int64_t val)
 
 void MutableDictionaryC::setInt64(unsigned int key,int64_t val)
 {
-    set(key, val, DictTypeInt64, int64Vals);
+    setValue(key, Value::int64Value(val, DictTypeInt64));
 }
 
 void MutableDictionaryC::setIdentifiable(const std::string &name,SimpleIdentity val)
@@ -624,7 +798,7 @@ void MutableDictionaryC::setIdentifiable(const std::string &name,SimpleIdentity
 }
 void MutableDictionaryC::setIdentifiable(unsigned int key,SimpleIdentity val)
 {
-    set(key, val, DictTypeIdentity, DictTypeInt64, int64Vals);
+    setValue(key, Value::int64Value((int64_t)val, DictTypeIdentity));
 }
 
 void MutableDictionaryC::setDouble(const std::string &name,double val)
@@ -633,7 +807,7 @@ void MutableDictionaryC::setDouble(const std::string &name,double val)
 }
 void MutableDictionaryC::setDouble(unsigned int key,double val)
 {
-    set(key, val, DictTypeDouble, dVals);
+    setValue(key, Value::doubleValue(val));
 }
 
 void MutableDictionaryC::setString(const std::string &name,const std::string &val)
@@ -642,16 +816,9 @@ void MutableDictionaryC::setString(const std::string &name,const std::string &va
 }
 void MutableDictionaryC::setString(unsigned int key,const std::string &val)
 {
-    const auto &it = valueMap.find(key);
-    // Can't reuse string entries because we share them
-    if (it != valueMap.end())
-    {
-        valueMap.erase(it);
-    }
-    
-    // Make a new one (psst, it's the same as the keys)
+    // Strings are shared with the keys, so this may already be here
     const auto stringID = addString(val);
-    valueMap[key] = Value(DictTypeString,stringID);
+    setValue(key, Value(DictTypeString,stringID));
 }
 
 void MutableDictionaryC::setDict(const std::string &name,const MutableDictionaryCRef &dict)
@@ -660,7 +827,18 @@ void MutableDictionaryC::setDict(const std::string &name,const MutableDictionary
 }
 void MutableDictionaryC::setDict(unsigned int key,const MutableDictionaryCRef &dict)
 {
-    set(key, std::ref(dict), DictTypeDictionary, dictVals);
+    auto &store = mut();
+
+    // Each dictionary field has its own slot, so we can reuse it
+    const Value *val = findValue(key);
+    if (val && val->type == DictTypeDictionary)
+    {
+        store.dicts[val->entry] = dict;
+        return;
+    }
+
+    setValue(key, Value(DictTypeDictionary,store.dicts.size()));
+    store.dicts.push_back(dict);
 }
 
 void MutableDictionaryC::setupArray(const std::vector<DictionaryEntryCRef> &entries, std::vector<Value> &out)
@@ -671,25 +849,23 @@ void MutableDictionaryC::setupArray(const std::vector<DictionaryEntryCRef> &entr
         if (entry) {
             switch (entry->getType()) {
                 case DictTypeInt:
-                    out.emplace_back(DictTypeInt,intVals.size());
-                    intVals.push_back(entry->getInt());
+                    out.push_back(Value::intValue(entry->getInt()));
                     break;
                 case DictTypeIdentity:
                 case DictTypeInt64:
-                    out.emplace_back(DictTypeInt64,int64Vals.size());
-                    int64Vals.push_back(entry->getInt64());
+                    out.push_back(Value::int64Value(entry->getInt64(),DictTypeInt64));
                     break;
                 case DictTypeDouble:
-                    out.emplace_back(DictTypeDouble,dVals.size());
-                    dVals.push_back(entry->getDouble());
+                    out.push_back(Value::doubleValue(entry->getDouble()));
                     break;
                 case DictTypeString:
                     out.emplace_back(DictTypeString,addString(entry->getString()));
                     break;
                 case DictTypeDictionary:
                     if (auto theDict = std::dynamic_pointer_cast<MutableDictionaryC>(entry->getDict())) {
-                        out.emplace_back(DictTypeDictionary,dictVals.size());
-                        dictVals.push_back(theDict);
+                        auto &dicts = mut().dicts;
+                        out.emplace_back(DictTypeDictionary,dicts.size());
+                        dicts.push_back(theDict);
                     }
                     break;
                 case DictTypeArray:
@@ -697,10 +873,11 @@ void MutableDictionaryC::setupArray(const std::vector<DictionaryEntryCRef> &entr
                     auto theArray = std::dynamic_pointer_cast<DictionaryEntryCArray>(entry);
                     if (theArray && !theArray->vals.empty()) {
                         std::vector<Value> locArr;
-                        setupArray(theArray->getArrayC(), locArr);
+                        setupArray(theArray->vals, locArr);
 
-                        out.emplace_back(DictTypeArray,arrayVals.size());
-                        arrayVals.push_back(locArr);
+                        auto &arrays = mut().arrays;
+                        out.emplace_back(DictTypeArray,arrays.size());
+                        arrays.push_back(std::move(locArr));
                     }
                     break;
                 }
@@ -720,11 +897,6 @@ void MutableDictionaryC::setArray(const std::string &name,const std::vector<Dict
 }
 void MutableDictionaryC::setArray(unsigned int key,const std::vector<DictionaryEntryRef> &entries)
 {
-    const auto &it = valueMap.find(key);
-    // Clear out the field.  Just easier
-    if (it != valueMap.end())
-        valueMap.erase(it);
-
     // TODO: Can we cast this once?
     std::vector<DictionaryEntryCRef> theEntries;
     theEntries.reserve(entries.size());
@@ -737,8 +909,9 @@ void MutableDictionaryC::setArray(unsigned int key,const std::vector<DictionaryE
     std::vector<Value> newArray;
     setupArray(theEntries, newArray);
 
-    valueMap[key] = Value(DictTypeArray,arrayVals.size());
-    arrayVals.push_back(newArray);
+    auto &arrays = mut().arrays;
+    setValue(key, Value(DictTypeArray,arrays.size()));
+    arrays.push_back(std::move(newArray));
 }
 
 void MutableDictionaryC::setArray(const std::string &name,const std::vector<DictionaryRef> &entries)
@@ -770,108 +943,59 @@ void MutableDictionaryC::addEntries(const Dictionary *inOther)
 
 void MutableDictionaryC::addEntries(const MutableDictionaryC *other)
 {
+    if (!other || other == this || !other->data)
+        return;
+
+    // Nothing of our own yet, so we can just share theirs
+    if (!data)
+    {
+        data = other->data;
+        return;
+    }
+
+    // Hang on to theirs, in case it's also ours and gets copied out from under us
+    const auto theirs = other->data;
+
     // Map from theirs to our strings
     std::vector<unsigned int> stringRemap;
-    stringRemap.reserve(other->stringVals.size());
-    for (const auto &entry : other->stringVals)
+    stringRemap.reserve(theirs->strings.size());
+    for (const auto &entry : theirs->strings)
     {
-        const auto newStringID = addString(entry);
-        stringRemap.push_back(newStringID);
+        stringRemap.push_back(addString(entry));
     }
 
-    // Some data types we can just append
-    const auto intStart = intVals.size();
-    intVals.reserve(intVals.size() + other->intVals.size());
-    intVals.insert(intVals.end(), other->intVals.begin(), other->intVals.end());
-    
-    const auto int64Start = int64Vals.size();
-    int64Vals.reserve(int64Vals.size() + other->int64Vals.size());
-    int64Vals.insert(int64Vals.end(), other->int64Vals.begin(), other->int64Vals.end());
-    
-    const auto dStart = dVals.size();
-    dVals.reserve(dVals.size() + other->dVals.size());
-    dVals.insert(dVals.end(), other->dVals.begin(), other->dVals.end());
-    
-    const auto dictStart = dictVals.size();
-    dictVals.reserve(dictVals.size() + other->dictVals.size());
-    dictVals.insert(dictVals.end(), other->dictVals.begin(), other->dictVals.end());
-    
-    // Array values need to be modified individually
-    const auto arrayStart = arrayVals.size();
-    for (const auto &arr: other->arrayVals) {
+    auto &store = mut();
+
+    // Dictionaries we can just append
+    const auto dictStart = (unsigned int)store.dicts.size();
+    store.dicts.insert(store.dicts.end(), theirs->dicts.begin(), theirs->dicts.end());
+
+    // Numbers come along as they are, the rest point somewhere new
+    const auto arrayStart = (unsigned int)store.arrays.size();
+    const auto remap = [&](Value val)
+    {
+        switch (val.type) {
+            case DictTypeString:     val.entry = stringRemap[val.entry];  break;
+            case DictTypeDictionary: val.entry += dictStart;  break;
+            case DictTypeArray:      val.entry += arrayStart;  break;
+            default: break;
+        }
+        return val;
+    };
+
+    store.arrays.reserve(store.arrays.size() + theirs->arrays.size());
+    for (const auto &arr: theirs->arrays) {
         std::vector<Value> outArr;
         outArr.reserve(arr.size());
         for (const auto &arrEntry: arr) {
-            switch (arrEntry.type) {
-                case DictTypeString:
-                    outArr.emplace_back(DictTypeString,stringRemap[arrEntry.entry]);
-                    break;
-                case DictTypeInt:
-                    outArr.emplace_back(DictTypeInt,arrEntry.entry+intStart);
-                    break;
-                case DictTypeInt64:
-                case DictTypeIdentity:
-                    outArr.emplace_back(DictTypeInt64,arrEntry.entry+int64Start);
-                    break;
-                case DictTypeDouble:
-                    outArr.emplace_back(DictTypeDouble,arrEntry.entry+dStart);
-                    break;
-                case DictTypeDictionary:
-                    outArr.emplace_back(DictTypeDictionary,arrEntry.entry+dictStart);
-                    break;
-                case DictTypeArray:
-                    outArr.emplace_back(DictTypeArray,arrEntry.entry+arrayStart);
-                    break;
-                case DictTypeObject:
-                case DictTypeNone:
-                    wkLogLevel(Warn, "Unsupported conversion from type %d to array entry", arrEntry.type);
-                    break;
-            }
+            outArr.push_back(remap(arrEntry));
         }
-        arrayVals.push_back(outArr);
+        store.arrays.push_back(std::move(outArr));
     }
-    
-    // Now we map the values into their new locations
-    for (const auto &value: other->valueMap) {
-        unsigned int newKey = stringRemap[value.first];
-        Value val = value.second;   // copy
-        switch (val.type) {
-            case DictTypeString:
-                val.entry = stringRemap[val.entry];
-                break;
-            case DictTypeInt:
-                val.entry = val.entry + intStart;
-                break;
-            case DictTypeInt64:
-            case DictTypeIdentity:
-                val.entry = val.entry + int64Start;
-                break;
-            case DictTypeDouble:
-                val.entry = val.entry + dStart;
-                break;
-            case DictTypeDictionary:
-                val.entry = val.entry + dictStart;
-                break;
-            case DictTypeArray:
-                val.entry = val.entry + arrayStart;
-                break;
-            case DictTypeObject:
-            case DictTypeNone:
-                wkLogLevel(Warn, "Unsupported conversion from type %d to array entry", val.type);
-                break;
-        }
-        valueMap[newKey] = val;
-    }
-}
 
-unsigned int MutableDictionaryC::addString(const std::string &name)
-{
-    const auto res = stringMap.insert(std::make_pair(name,stringVals.size()));
-    if (res.second) {
-        // new key inserted
-        stringVals.push_back(name);
+    for (const auto &field: theirs->fields) {
+        setValue(stringRemap[field.first], remap(field.second));
     }
-    return res.first->second;
 }
 
 int DictionaryEntryCBasic::getInt() const
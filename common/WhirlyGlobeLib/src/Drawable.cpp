@@ -18,6 +18,7 @@
 
 #import "Drawable.h"
 #import "Scene.h"
+#import "SceneRenderer.h"
 
 namespace WhirlyKit
 {
@@ -27,6 +28,29 @@ Drawable::Drawable(std::string name)
 {
 }
 
+int Drawable::compareDrawState(const Drawable &a,const Drawable &b,bool useTextures)
+{
+    const auto progA = a.getProgram();
+    const auto progB = b.getProgram();
+    if (progA != progB)
+        return (progA < progB) ? -1 : 1;
+
+    if (useTextures)
+    {
+        const auto texA = a.getSortTexture();
+        const auto texB = b.getSortTexture();
+        if (texA != texB)
+            return (texA < texB) ? -1 : 1;
+    }
+
+    const auto layoutA = a.getVertexLayoutKey();
+    const auto layoutB = b.getVertexLayoutKey();
+    if (layoutA != layoutB)
+        return (layoutA < layoutB) ? -1 : 1;
+
+    return 0;
+}
+
 void Drawable::runTweakers(RendererFrameInfo *frame)
 {
     for (const auto &tweaker : tweakers)
@@ -35,11 +59,26 @@ void Drawable::runTweakers(RendererFrameInfo *frame)
 	}
 }
 
+// Whatever the drawable goes into has to be drawn again
+static void MarkTargetDirty(const Drawable &draw)
+{
+	if (draw.renderTargetCon && draw.renderTargetCon->renderTarget)
+	{
+		draw.renderTargetCon->renderTarget->markDirty();
+	}
+}
+
 void DrawableChangeRequest::execute(Scene *scene,SceneRenderer *renderer,WhirlyKit::View *view)
 {
 	if (const DrawableRef theDrawable = scene->getDrawable(drawId))
 	{
 		execute2(scene,renderer,theDrawable);
+		MarkTargetDirty(*theDrawable);
+	}
+	else if (const DrawableRef mergedDrawable = scene->getMergedDrawable(drawId))
+	{
+		executeMerged(scene,renderer,mergedDrawable);
+		MarkTargetDirty(*mergedDrawable);
 	}
 }
 
@@ -0,0 +1,105 @@
+/*  DrawableTimeIndex.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "DrawableTimeIndex.h"
+
+namespace WhirlyKit
+{
+
+bool DrawableTimeIndex::insert(const DrawableRef &draw,Entry &entry,TimeInterval now)
+{
+    // These match the tests in the drawables' isOn()
+    if (now < entry.start)
+    {
+        entry.finished = false;
+        entry.it = waiting.emplace(entry.start,draw);
+        return true;
+    }
+    if (entry.end != 0.0 && entry.end < now)
+    {
+        entry.finished = true;
+        entry.it = finished.emplace(entry.end,draw);
+        return true;
+    }
+    return false;
+}
+
+bool DrawableTimeIndex::park(const DrawableRef &draw,TimeInterval now)
+{
+    Entry entry;
+    if (!draw->getEnableTimeRange(entry.start,entry.end))
+        return false;
+    if (where.find(draw->getId()) != where.end())
+        return true;
+    if (!insert(draw,entry,now))
+        return false;
+
+    where[draw->getId()] = entry;
+    return true;
+}
+
+bool DrawableTimeIndex::remove(const DrawableRef &draw)
+{
+    const auto it = where.find(draw->getId());
+    if (it == where.end())
+        return false;
+
+    (it->second.finished ? finished : waiting).erase(it->second.it);
+    where.erase(it);
+    return true;
+}
+
+void DrawableTimeIndex::update(TimeInterval now,std::vector<DrawableRef> &draws)
+{
+    // Going forward, things start.  Some may have ended already if we jumped far enough.
+    while (!waiting.empty() && waiting.begin()->first <= now)
+    {
+        const DrawableRef draw = std::move(waiting.begin()->second);
+        waiting.erase(waiting.begin());
+
+        auto it = where.find(draw->getId());
+        if (!insert(draw,it->second,now))
+        {
+            where.erase(it);
+            draws.push_back(draw);
+        }
+    }
+
+    // Going backward, things un-end.  Or go back to waiting.
+    while (!finished.empty() && std::prev(finished.end())->first >= now)
+    {
+        const auto last = std::prev(finished.end());
+        const DrawableRef draw = std::move(last->second);
+        finished.erase(last);
+
+        auto it = where.find(draw->getId());
+        if (!insert(draw,it->second,now))
+        {
+            where.erase(it);
+            draws.push_back(draw);
+        }
+    }
+}
+
+void DrawableTimeIndex::clear()
+{
+    waiting.clear();
+    finished.clear();
+    where.clear();
+}
+
+}
@@ -0,0 +1,172 @@
+/*  DynamicResolution.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import "DynamicResolution.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    // Drop quickly when we're slow, come back up gently
+    const float ScaleDownStep = 0.1f;
+    const float ScaleUpStep = 0.05f;
+    // Consecutive frames over budget before we drop, and comfortably under before we go back up
+    const int SlowFramesToDrop = 3;
+    const int FastFramesToRaise = 30;
+    // Under this fraction of the budget is comfortable
+    const double FastFraction = 0.75;
+    // Weight of the newest frame in the average
+    const double FrameTimeWeight = 0.2;
+}
+
+void DynamicResolution::setEnabled(bool newEnabled)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    enabled = newEnabled;
+    if (!enabled)
+    {
+        scale = maxScale;
+        resetTiming();
+    }
+}
+
+bool DynamicResolution::isEnabled() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return enabled;
+}
+
+void DynamicResolution::setScaleRange(float newMinScale,float newMaxScale)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    maxScale = std::min(std::max(newMaxScale,0.1f),1.0f);
+    minScale = std::min(std::max(newMinScale,0.1f),maxScale);
+    scale = std::min(std::max(scale,minScale),maxScale);
+}
+
+float DynamicResolution::getMinScale() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return minScale;
+}
+
+float DynamicResolution::getMaxScale() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return maxScale;
+}
+
+float DynamicResolution::getScale() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return enabled ? scale : maxScale;
+}
+
+void DynamicResolution::resetTiming()
+{
+    avgFrameTime = 0.0;
+    slowFrames = 0;
+    fastFrames = 0;
+}
+
+bool DynamicResolution::addFrame(TimeInterval now,TimeInterval budget,bool moving,bool gpuTimed)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    const bool wasMoving = lastMoving;
+    const TimeInterval frameTime = now - lastFrame;
+    lastFrame = now;
+    lastMoving = moving;
+
+    if (!enabled || budget <= 0.0)
+        return false;
+
+    // Anything other than moving gets drawn at full resolution
+    if (!moving)
+    {
+        resetTiming();
+        if (scale < maxScale)
+        {
+            scale = maxScale;
+            return true;
+        }
+        return false;
+    }
+
+    // The gap after an idle period doesn't tell us anything
+    if (!wasMoving || gpuTimed)
+        return false;
+
+    return updateScale(frameTime,budget);
+}
+
+bool DynamicResolution::addGPUFrame(TimeInterval gpuTime,TimeInterval budget,bool moving)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    // Results from before we stopped are no use once we have
+    if (!enabled || budget <= 0.0 || !moving || !lastMoving)
+        return false;
+
+    return updateScale(gpuTime,budget);
+}
+
+bool DynamicResolution::updateScale(TimeInterval frameTime,TimeInterval budget)
+{
+    avgFrameTime = (avgFrameTime == 0.0) ? frameTime :
+                   avgFrameTime + FrameTimeWeight * (frameTime - avgFrameTime);
+
+    const float oldScale = scale;
+    if (avgFrameTime > budget)
+    {
+        fastFrames = 0;
+        if (++slowFrames >= SlowFramesToDrop)
+        {
+            scale = std::max(scale - ScaleDownStep,minScale);
+            slowFrames = 0;
+        }
+    } else if (avgFrameTime < budget * FastFraction)
+    {
+        slowFrames = 0;
+        if (++fastFrames >= FastFramesToRaise)
+        {
+            scale = std::min(scale + ScaleUpStep,maxScale);
+            fastFrames = 0;
+        }
+    } else {
+        slowFrames = 0;
+        fastFrames = 0;
+    }
+
+    return scale != oldScale;
+}
+
+bool DynamicResolution::restore()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    resetTiming();
+    lastMoving = false;
+    if (enabled && scale < maxScale)
+    {
+        scale = maxScale;
+        return true;
+    }
+    return false;
+}
+
+}
@@ -16,9 +16,11 @@
  *  limitations under the License.
  */
 
+#import <algorithm>
 #import "DynamicTextureAtlas.h"
 #import "Scene.h"
 #import "SceneRenderer.h"
+#import "BasicDrawable.h"
 #import "WhirlyKitLog.h"
 
 using namespace Eigen;
@@ -31,6 +33,11 @@ DynamicTexture::DynamicTexture(const std::string &name)
 {
 }
 
+size_t DynamicTexture::getGPUBytes() const
+{
+    return layoutGrid ? (size_t)texSize * texSize * TextureTypeBytesPerPixel(type) : 0;
+}
+
 void DynamicTexture::setup(int inTexSize,int inCellSize,TextureType inType,bool inClearTextures)
 {
     texSize = inTexSize;
@@ -59,10 +66,46 @@ void DynamicTexture::addTexture(Texture *tex,const Region &region)
     int width = tex->getWidth();
     int height = tex->getHeight();
     
-    RawDataRef data = tex->processData();
+    RawDataRef data = regionData(region,tex->processData(),width,height);
     addTextureData(startX,startY,width,height,data);
 }
 
+RawDataRef DynamicTexture::regionData(const Region &region,const RawDataRef &data,int &width,int &height) const
+{
+    if (!clearTextures || !data)
+        return data;
+
+    const int fullWidth = std::min((region.ex - region.sx + 1) * cellSize, texSize - region.sx * cellSize);
+    const int fullHeight = std::min((region.ey - region.sy + 1) * cellSize, texSize - region.sy * cellSize);
+    const int pixSize = TextureTypeBytesPerPixel(type);
+    // Compressed data, or it already fills the region
+    if ((width >= fullWidth && height >= fullHeight) ||
+        data->getLen() != (unsigned long)width * height * pixSize)
+        return data;
+
+    const size_t rowBytes = (size_t)std::min(width,fullWidth) * pixSize;
+    const std::vector<unsigned char> emptyRow((size_t)fullWidth * pixSize, 0);
+    auto padded = std::make_shared<MutableRawData>();
+    data->willRead();
+    const unsigned char *src = data->getRawData();
+    for (int iy=0;iy<fullHeight;iy++)
+    {
+        if (iy < height)
+        {
+            padded->addBytes(src + (size_t)iy * width * pixSize, rowBytes);
+            padded->addBytes(emptyRow.data(), emptyRow.size() - rowBytes);
+        }
+        else
+        {
+            padded->addBytes(emptyRow.data(), emptyRow.size());
+        }
+    }
+
+    width = fullWidth;
+    height = fullHeight;
+    return padded;
+}
+
 void DynamicTexture::setRegion(const Region &region, bool enable)
 {
     const int sx = std::max(region.sx,0), sy = std::max(region.sy,0);
@@ -75,15 +118,6 @@ void DynamicTexture::setRegion(const Region &region, bool enable)
         }
 }
     
-void DynamicTexture::clearRegion(const Region &clearRegion,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData)
-{
-    int startX = clearRegion.sx * cellSize;
-    int startY = clearRegion.sy * cellSize;
-    int width = (clearRegion.ex - clearRegion.sx + 1) * cellSize;
-    int height = (clearRegion.ey - clearRegion.sy + 1) * cellSize;
-    clearTextureData(startX,startY,width,height,changes,mainThreadMerge,emptyData);
-}
-    
 void DynamicTexture::getReleasedRegions(std::vector<DynamicTexture::Region> &toClear) const
 {
     std::lock_guard<std::mutex> guardLock(regionLock);
@@ -96,9 +130,8 @@ std::vector<DynamicTexture::Region> DynamicTexture::getReleasedRegions() const
     return releasedRegions;
 }
 
-bool DynamicTexture::findRegion(int sizeX,int sizeY,Region &region)
+void DynamicTexture::applyReleasedRegions()
 {
-    // First thing we need to do is clear any outstanding regions
     // Don't sit on the lock, as the main thread uses it
     std::vector<Region> toClear;
     {
@@ -110,6 +143,43 @@ bool DynamicTexture::findRegion(int sizeX,int sizeY,Region &region)
     {
         setRegion(ii, false);
     }
+}
+
+bool DynamicTexture::overlaps(const DynamicTexture &other) const
+{
+    if (other.numCell != numCell)
+        return true;
+
+    for (int ii=0;ii<numCell*numCell;ii++)
+        if (layoutGrid[ii] && other.layoutGrid[ii])
+            return true;
+
+    return false;
+}
+
+void DynamicTexture::mergeRegions(const DynamicTexture &other)
+{
+    for (int ii=0;ii<numCell*numCell;ii++)
+        layoutGrid[ii] |= other.layoutGrid[ii];
+    numRegions += other.numRegions;
+}
+
+void DynamicTexture::takeReleasedRegions(DynamicTexture &other)
+{
+    std::vector<Region> released;
+    {
+        std::lock_guard<std::mutex> guardLock(other.regionLock);
+        released.swap(other.releasedRegions);
+    }
+
+    std::lock_guard<std::mutex> guardLock(regionLock);
+    releasedRegions.insert(releasedRegions.end(),released.begin(),released.end());
+}
+
+bool DynamicTexture::findRegion(int sizeX,int sizeY,Region &region)
+{
+    // First thing we need to do is clear any outstanding regions
+    applyReleasedRegions();
     
     // Now look for a region that'll fit
     // Look for a spot big enough
@@ -175,21 +245,90 @@ void DynamicTextureClearRegion::execute(Scene *scene,SceneRenderer *renderer,Vie
     }
 }
 
+void DynamicTextureMergeReq::execute(Scene *scene,SceneRenderer *renderer,View *view)
+{
+    dest->copyRegions(renderer,src.get(),regions);
+
+    // Anything that looks up the old ID, including later clear requests, gets the new texture
+    const std::vector<SimpleIdentity> oldIDs = scene->redirectTexture(src,dest);
+    dest->takeReleasedRegions(*src);
+
+    // Drawables may hang on to what they looked up, so have them do it again
+    for (Drawable *draw : scene->getDrawables())
+    {
+        if (auto basicDraw = dynamic_cast<BasicDrawable *>(draw))
+        {
+            for (const auto &texInfo : basicDraw->getTexInfo())
+            {
+                if (std::find(oldIDs.begin(),oldIDs.end(),texInfo.texId) != oldIDs.end())
+                {
+                    basicDraw->setTexturesChanged();
+                    break;
+                }
+            }
+        }
+    }
+
+    if (auto info = renderer->getTeardownInfo())
+    {
+        info->destroyTexture(renderer,src);
+    }
+    src.reset();
+    dest.reset();
+}
+
 DynamicTextureAddRegion::~DynamicTextureAddRegion()
 {
     if (!wasRun)
         wkLogLevel(Warn,"DynamicTextureAddRegion deleted without being run.");
 }
     
+bool DynamicTextureAddRegion::addRegion(const DynamicTextureRef &inDynTex,int startX,int startY,int width,int height,RawDataRef data)
+{
+    if (wasRun || !dynTex || dynTex != inDynTex)
+        return false;
+
+    pieces.push_back(Piece { startX, startY, width, height, std::move(data) });
+    return true;
+}
+
+void DynamicTextureAddRegion::setupForRenderer(const RenderSetupInfo *setupInfo,Scene *scene)
+{
+    if (!dynTex || !dynTex->getAsyncUpload())
+        return;
+
+    for (auto &piece : pieces)
+    {
+        if (piece.data && !piece.staged)
+        {
+            piece.staged = dynTex->stageTextureData(setupInfo, piece.startX, piece.startY, piece.width, piece.height, piece.data);
+            if (piece.staged)
+                piece.data.reset();
+        }
+    }
+}
+
 void DynamicTextureAddRegion::execute(Scene *scene,SceneRenderer *renderer,View *view)
 {
-    TextureBaseRef tex = scene->getTexture(texId);
-    DynamicTextureRef dynTex = std::dynamic_pointer_cast<DynamicTexture>(tex);
-    if (dynTex)
+    DynamicTextureRef theDynTex = dynTex;
+    if (!theDynTex)
+    {
+        TextureBaseRef tex = scene->getTexture(texId);
+        theDynTex = std::dynamic_pointer_cast<DynamicTexture>(tex);
+    }
+    if (theDynTex)
     {
-        dynTex->addTextureData(startX, startY, width, height, data);
+        for (const auto &piece : pieces)
+        {
+            if (piece.staged)
+                theDynTex->addStagedData(renderer, piece.staged);
+            else
+                theDynTex->addTextureData(piece.startX, piece.startY, piece.width, piece.height, piece.data);
+        }
     } else
         wkLogLevel(Warn,"Tried to add texture data to dynamic texture that doesn't exist.");
+    pieces.clear();
+    dynTex.reset();
     wasRun = true;
 }
    
@@ -214,10 +353,6 @@ DynamicTextureAtlas::TextureRegion::TextureRegion()
 DynamicTextureAtlas::DynamicTextureAtlas(const std::string &name,int texSize,int cellSize,TextureType format,int imageDepth,bool mainThreadMerge)
     : name(name), texSize(texSize), cellSize(cellSize), format(format), imageDepth(imageDepth),  pixelFudge(0.0), mainThreadMerge(mainThreadMerge), clearTextures(false), interpType(TexInterpLinear)
 {
-    if (mainThreadMerge || MainThreadMerge)
-    {
-        emptyPixelBuffer.resize(texSize*texSize*4,0);
-    }
 }
     
 DynamicTextureAtlas::~DynamicTextureAtlas()
@@ -262,23 +397,7 @@ bool DynamicTextureAtlas::addTexture(SceneRenderer *sceneRender,const std::vecto
         return false;
     
     TextureRegion texRegion;
-    const bool doMainThreadMerge = MainThreadMerge || mainThreadMerge;
 
-    // Clear out any released regions
-    for (const auto *dynTexVec : textures)
-    {
-        const DynamicTextureRef &firstDynTex = dynTexVec->at(0);
-        std::vector<DynamicTexture::Region> toClear = firstDynTex->getReleasedRegions();
-        for (const DynamicTexture::Region &clearRegion : toClear)
-        {
-            for (unsigned int ii=0;ii<dynTexVec->size();ii++)
-            {
-                const DynamicTextureRef &dynTex = dynTexVec->at(ii);
-                dynTex->clearRegion(clearRegion,changes,doMainThreadMerge,doMainThreadMerge ? &emptyPixelBuffer[0] : nullptr);
-            }
-        }
-    }
-    
     // Now look for space
     DynamicTextureVec *dynTexVec = nullptr;
     bool found = false;
@@ -309,6 +428,7 @@ bool DynamicTextureAtlas::addTexture(SceneRenderer *sceneRender,const std::vecto
             auto dynTex = sceneRender->makeDynamicTexture(name);
             dynTex->setup(texSize,cellSize,format,clearTextures);
             dynTex->setInterpType(interpType);
+            dynTex->setAsyncUpload(asyncUpload);
             dynTex->createInRenderer(sceneRender->getRenderSetupInfo());
             dynTexVec->push_back(std::move(dynTex));
         }
@@ -345,13 +465,7 @@ bool DynamicTextureAtlas::addTexture(SceneRenderer *sceneRender,const std::vecto
             Texture *tex = newTextures[newTextures.size() == 1 ? 0 : which];
             const DynamicTextureRef &dynTex = dynTexVec->at(which);
             //        NSLog(@"Region: (%d,%d)->(%d,%d)  texture: %ld",texRegion.region.sx,texRegion.region.sy,texRegion.region.ex,texRegion.region.ey,dynTex->getId());
-            // Make the main thread do the merge
-            if (MainThreadMerge || mainThreadMerge)
-                sceneRender->scene->addChangeRequest(new DynamicTextureAddRegion(dynTex->getId(),
-                                                              texRegion.region.sx * cellSize, texRegion.region.sy * cellSize, tex->getWidth(), tex->getHeight(),
-                                                              tex->processData()));
-            else
-                dynTex->addTexture(tex, texRegion.region);
+            addRegionData(dynTex, texRegion.region, tex, changes);
         }
 
         // This asks for a flush
@@ -386,6 +500,33 @@ bool DynamicTextureAtlas::addTexture(SceneRenderer *sceneRender,const std::vecto
     return found;
 }
     
+void DynamicTextureAtlas::addRegionData(const DynamicTextureRef &dynTex,const DynamicTexture::Region &region,Texture *tex,ChangeSet &changes)
+{
+    if (!MainThreadMerge && !mainThreadMerge)
+    {
+        dynTex->addTexture(tex, region);
+        return;
+    }
+
+    int width = tex->getWidth(), height = tex->getHeight();
+    RawDataRef data = dynTex->regionData(region, tex->processData(), width, height);
+    const int startX = region.sx * cellSize, startY = region.sy * cellSize;
+
+    // Ride along with the last batch for this texture, if nothing else has come between
+    for (auto it = changes.rbegin(); it != changes.rend(); ++it)
+    {
+        if (!*it)
+            continue;
+        const auto addReq = dynamic_cast<DynamicTextureAddRegion *>(*it);
+        if (!addReq)
+            break;
+        if (addReq->addRegion(dynTex, startX, startY, width, height, data))
+            return;
+    }
+
+    changes.push_back(new DynamicTextureAddRegion(dynTex, startX, startY, width, height, std::move(data)));
+}
+
 bool DynamicTextureAtlas::updateTexture(Texture *tex,int frame,const TextureRegion &texRegion,ChangeSet &changes)
 {
     const DynamicTextureVec *dynTexVec = nullptr;
@@ -393,7 +534,7 @@ bool DynamicTextureAtlas::updateTexture(Texture *tex,int frame,const TextureRegi
     // Look for the right dynamic texture (list)
     for (const auto *texVec : textures)
     {
-        const DynamicTextureRef &firstDynTex = dynTexVec->at(0);
+        const DynamicTextureRef &firstDynTex = texVec->at(0);
         if (firstDynTex->getId() == texRegion.dynTexId)
         {
             dynTexVec = texVec;
@@ -409,7 +550,7 @@ bool DynamicTextureAtlas::updateTexture(Texture *tex,int frame,const TextureRegi
         }
         // Just use the last one
         // todo: the one with the most space would be best
-        dynTexVec = *textures.end();
+        dynTexVec = *textures.rbegin();
     }
     
     // Look for the matching dynamic texture
@@ -418,13 +559,7 @@ bool DynamicTextureAtlas::updateTexture(Texture *tex,int frame,const TextureRegi
     
     // Merge in the data
     //        NSLog(@"Region: (%d,%d)->(%d,%d)  texture: %ld",texRegion.region.sx,texRegion.region.sy,texRegion.region.ex,texRegion.region.ey,dynTex->getId());
-    // Make the main thread do the merge
-    if (MainThreadMerge)
-        changes.push_back(new DynamicTextureAddRegion(dynTex->getId(),
-                                                      texRegion.region.sx * cellSize, texRegion.region.sy * cellSize, tex->getWidth(), tex->getHeight(),
-                                                      tex->processData()));
-    else
-        dynTex->addTexture(tex, texRegion.region);
+    addRegionData(dynTex, texRegion.region, tex, changes);
     
     return false;
 }
@@ -477,6 +612,7 @@ void DynamicTextureAtlas::cleanup(ChangeSet &changes,TimeInterval when)
         {
             for (const auto &ti : *texVec)
             {
+                removeAliases(ti->getId(),changes,when);
                 changes.push_back(new RemTextureReq(ti->getId(),when));
             }
             delete texVec;
@@ -485,6 +621,115 @@ void DynamicTextureAtlas::cleanup(ChangeSet &changes,TimeInterval when)
     }
 }
     
+void DynamicTextureAtlas::removeAliases(SimpleIdentity texId,ChangeSet &changes,TimeInterval when)
+{
+    const auto it = aliases.find(texId);
+    if (it == aliases.end())
+        return;
+
+    // These only drop the scene's entries, the texture itself goes separately
+    for (const SimpleIdentity aliasId : it->second)
+        changes.push_back(new RemTextureReq(aliasId,when));
+    aliases.erase(it);
+}
+
+int DynamicTextureAtlas::compact(ChangeSet &changes)
+{
+    if (textures.size() < 2)
+        return 0;
+
+    // Least used first, and skip the empty ones, those are for cleanup()
+    std::vector<std::pair<int,DynamicTextureVec *>> pages;
+    pages.reserve(textures.size());
+    int totalCells = 0, totalUsed = 0;
+    for (auto *texVec : textures)
+    {
+        const DynamicTextureRef &tex = texVec->at(0);
+        for (const auto &ti : *texVec)
+            if (!ti->canCopyRegions())
+                return 0;
+        tex->applyReleasedRegions();
+        if (tex->getNumRegions() == 0)
+            continue;
+
+        int numCells = 0, usedCells = 0;
+        tex->getUtilization(numCells,usedCells);
+        totalCells += numCells;
+        totalUsed += usedCells;
+        pages.emplace_back(usedCells,texVec);
+    }
+
+    // Not worth looking if it wouldn't fit in one fewer anyway
+    if (pages.size() < 2 || totalUsed > totalCells - totalCells / (int)pages.size())
+        return 0;
+
+    std::sort(pages.begin(),pages.end(),
+              [](const std::pair<int,DynamicTextureVec *> &a,const std::pair<int,DynamicTextureVec *> &b)
+              { return a.first < b.first; });
+
+    int numMerged = 0;
+    std::vector<bool> merged(pages.size(),false);
+    for (size_t si=0;si<pages.size();si++)
+    {
+        DynamicTextureVec *srcVec = pages[si].second;
+        const DynamicTextureRef &src0 = srcVec->at(0);
+
+        // Fullest one it'll fit in
+        DynamicTextureVec *destVec = nullptr;
+        for (size_t di=pages.size();di-- > 0;)
+        {
+            if (di != si && !merged[di] && !pages[di].second->at(0)->overlaps(*src0))
+            {
+                destVec = pages[di].second;
+                break;
+            }
+        }
+        if (!destVec)
+            continue;
+        const DynamicTextureRef &dest0 = destVec->at(0);
+
+        // Everything in the old one now lives in the new one, in the same spot
+        std::vector<DynamicTexture::Region> moved;
+        TextureRegionSet newRegions;
+        for (TextureRegion texRegion : regions)
+        {
+            if (texRegion.dynTexId == src0->getId())
+            {
+                moved.push_back(texRegion.region);
+                texRegion.dynTexId = dest0->getId();
+                texRegion.subTex.texId = dest0->getId();
+            }
+            newRegions.insert(newRegions.end(),texRegion);
+        }
+        regions.swap(newRegions);
+        dest0->mergeRegions(*src0);
+
+        for (unsigned int ii=0;ii<srcVec->size();ii++)
+        {
+            const DynamicTextureRef &src = srcVec->at(ii);
+            const DynamicTextureRef &dest = destVec->at(ii);
+            changes.push_back(new DynamicTextureMergeReq(dest,src,moved));
+
+            // The scene will have the old IDs pointing at the new texture until it goes away
+            auto &destAliases = aliases[dest->getId()];
+            destAliases.push_back(src->getId());
+            const auto it = aliases.find(src->getId());
+            if (it != aliases.end())
+            {
+                destAliases.insert(destAliases.end(),it->second.begin(),it->second.end());
+                aliases.erase(it);
+            }
+        }
+
+        merged[si] = true;
+        textures.erase(srcVec);
+        delete srcVec;
+        numMerged++;
+    }
+
+    return numMerged;
+}
+
 void DynamicTextureAtlas::getTextureIDs(std::vector<SimpleIdentity> &texIDs,int which)
 {
     for (const auto *dynTexVec : textures)
@@ -501,6 +746,15 @@ SimpleIdentity DynamicTextureAtlas::getTextureIDForFrame(SimpleIdentity baseTexI
         if (((*dynTexVec)[0])->getId() == baseTexID && which < dynTexVec->size())
             return ((*dynTexVec)[which])->getId();
     }
+
+    // Might be from a texture that was merged into one of ours
+    for (const auto *dynTexVec : textures)
+    {
+        const auto it = aliases.find(((*dynTexVec)[0])->getId());
+        if (it != aliases.end() && which < dynTexVec->size() &&
+            std::find(it->second.begin(),it->second.end(),baseTexID) != it->second.end())
+            return ((*dynTexVec)[which])->getId();
+    }
     
     return EmptyIdentity;
 }
@@ -510,11 +764,15 @@ void DynamicTextureAtlas::teardown(ChangeSet &changes)
     for (auto *texVec : textures)
     {
         for (unsigned int ii=0;ii<texVec->size();ii++)
+        {
+            removeAliases(texVec->at(ii)->getId(),changes,0.0);
             changes.push_back(new RemTextureReq(texVec->at(ii)->getId()));
+        }
         delete texVec;
     }
     textures.clear();
     regions.clear();
+    aliases.clear();
 }
     
 void DynamicTextureAtlas::getUsage(int &numRegions,int &dynamicTextures) const
@@ -523,6 +781,38 @@ void DynamicTextureAtlas::getUsage(int &numRegions,int &dynamicTextures) const
     dynamicTextures = textures.size();
 }
 
+size_t DynamicTextureAtlas::getBytes() const
+{
+    size_t pixelBytes;
+    switch (format)
+    {
+        case TexTypeShort565:
+        case TexTypeShort4444:
+        case TexTypeShort5551:
+        case TexTypeDoubleChannel:
+        case TexTypeSingleFloat16:
+        case TexTypeSingleInt16:
+            pixelBytes = 2;
+            break;
+        case TexTypeSingleChannel:
+            pixelBytes = 1;
+            break;
+        case TexTypeDoubleFloat32:
+        case TexTypeQuadFloat16:
+        case TexTypeDoubleUInt32:
+            pixelBytes = 8;
+            break;
+        case TexTypeQuadFloat32:
+        case TexTypeQuadUInt32:
+            pixelBytes = 16;
+            break;
+        default:
+            pixelBytes = 4;
+            break;
+    }
+    return textures.size() * imageDepth * (size_t)texSize * texSize * pixelBytes;
+}
+
 void DynamicTextureAtlas::log() const
 {
     int numCells=0,usedCells=0;
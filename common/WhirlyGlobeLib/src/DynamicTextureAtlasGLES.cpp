@@ -21,6 +21,7 @@
 #import "DynamicTextureAtlasGLES.h"
 #import "MemManagerGLES.h"
 #import "UtilsGLES.h"
+#import "SceneRenderer.h"
 #import "WhirlyKitLog.h"
 
 namespace WhirlyKit
@@ -107,7 +108,7 @@ void DynamicTextureGLES::setup(int texSize,int cellSize,TextureType inType,bool
     }
 }
 
-// If set we'll try to clear the images when we're not using them.
+// If set we'll hand glTexImage2D zeroed memory rather than none
 static const bool ClearImages = false;
 
 // Create the OpenGL texture, empty
@@ -205,37 +206,111 @@ void DynamicTextureGLES::addTextureData(int startX,int startY,int width,int heig
     }
 }
 
-void DynamicTextureGLES::clearTextureData(int startX,int startY,int width,int height,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData)
+DynamicTexture::StagedDataRef DynamicTextureGLES::stageTextureData(const RenderSetupInfo *inSetupInfo,int startX,int startY,int width,int height,const RawDataRef &data)
 {
-    if (!clearTextures)
+    RenderSetupInfoGLES *setupInfo = (RenderSetupInfoGLES *)inSetupInfo;
+    if (compressed || !data || data->getLen() == 0 || !setupInfo || !setupInfo->memManager ||
+        setupInfo->glesVersion < 3 || !hasMapBufferSupport)
+    {
+        return StagedDataRef();
+    }
+
+    const auto staged = std::make_shared<StagedDataGLES>();
+    staged->pboId = setupInfo->memManager->getBufferID();
+    if (!staged->pboId)
+        return StagedDataRef();
+
+    const size_t len = data->getLen();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staged->pboId);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)len, nullptr, GL_STREAM_DRAW);
+    void *glMem = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)len,
+                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (glMem)
+    {
+        memcpy(glMem, data->getRawData(), len);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    CheckGLError("DynamicTexture::stageTextureData()");
+
+    if (!glMem)
+    {
+        setupInfo->memManager->removeBufferID(staged->pboId);
+        return StagedDataRef();
+    }
+
+    staged->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    staged->startX = startX;
+    staged->startY = startY;
+    staged->width = width;
+    staged->height = height;
+
+    return staged;
+}
+
+void DynamicTextureGLES::addStagedData(SceneRenderer *renderer,const StagedDataRef &inStaged)
+{
+    const auto staged = std::dynamic_pointer_cast<StagedDataGLES>(inStaged);
+    if (!staged || !staged->pboId)
         return;
-    
-    glBindTexture(GL_TEXTURE_2D, glId);
-    
-    if (compressed)
+    RenderSetupInfoGLES *setupInfo = (RenderSetupInfoGLES *)renderer->getRenderSetupInfo();
+
+    if (staged->fence)
     {
-        // Note: Can't do this for PKM currently
-        //        int pkmType;
-        //        int size,thisWidth,thisHeight;
-        //        unsigned char *pixData = Texture::ResolvePKM(data,pkmType, size, thisWidth, thisHeight);
-        //        if (!pixData || pkmType != type || thisWidth != width || thisHeight != height)
-        //            NSLog(@"Compressed texture doesn't match atlas.");
-        //        else
-        //            glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, startX, startY, thisWidth, thisHeight, pkmType, (GLsizei)size, pixData);
-    } else {
-        if (ClearImages)
+        glWaitSync(staged->fence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(staged->fence);
+        staged->fence = nullptr;
+    }
+
+    if (glId)
+    {
+        glBindTexture(GL_TEXTURE_2D, glId);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staged->pboId);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, staged->startX, staged->startY, staged->width, staged->height, format, glType, nullptr);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        CheckGLError("DynamicTexture::addStagedData() glTexSubImage2D()");
+    }
+
+    setupInfo->memManager->removeBufferID(staged->pboId);
+    staged->pboId = 0;
+}
+
+void DynamicTextureGLES::copyRegions(SceneRenderer *renderer,DynamicTexture *inSrc,const std::vector<Region> &regions)
+{
+    const auto src = dynamic_cast<DynamicTextureGLES *>(inSrc);
+    if (!src || !src->glId || !glId)
+        return;
+
+    // Read from the source as the color attachment of a scratch framebuffer
+    GLint prevFrameBuf = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFrameBuf);
+    GLuint frameBuf = 0;
+    glGenFramebuffers(1, &frameBuf);
+    glBindFramebuffer(GL_FRAMEBUFFER, frameBuf);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, src->glId, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE)
+    {
+        glBindTexture(GL_TEXTURE_2D, glId);
+        for (const auto &region : regions)
         {
-            if (mainThreadMerge) {
-                RawDataRef clearData(new RawDataWrapper(emptyData,width*height*4,false));
-                changes.push_back(new DynamicTextureAddRegion(getId(),
-                                                              startX, startY, width, height,
-                                                              clearData));
-            } else
-                glTexSubImage2D(GL_TEXTURE_2D, 0, startX, startY, width, height, format, glType, emptyData);
+            const int startX = region.sx * cellSize, startY = region.sy * cellSize;
+            const int width = std::min((region.ex - region.sx + 1) * cellSize, texSize - startX);
+            const int height = std::min((region.ey - region.sy + 1) * cellSize, texSize - startY);
+            if (width > 0 && height > 0)
+                glCopyTexSubImage2D(GL_TEXTURE_2D, 0, startX, startY, startX, startY, width, height);
         }
+        glBindTexture(GL_TEXTURE_2D, 0);
     }
-    
-    glBindTexture(GL_TEXTURE_2D, 0);
+    else
+    {
+        wkLogLevel(Warn, "DynamicTextureGLES: Can't read from %s to copy it", name.c_str());
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, prevFrameBuf);
+    glDeleteFramebuffers(1, &frameBuf);
+    CheckGLError("DynamicTexture::copyRegions()");
 }
-    
+
 }
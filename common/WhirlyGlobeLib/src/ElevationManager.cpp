@@ -0,0 +1,464 @@
+/*  ElevationManager.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "ElevationManager.h"
+#import "PNGDecoder.h"
+#import "FlatMath.h"
+#import "WhirlyGeometry.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+// Steps we take along a ray through the height range before narrowing in on a hit
+static constexpr int IntersectSteps = 64;
+static constexpr int IntersectRefine = 16;
+
+ElevationTile::ElevationTile(int sizeX,int sizeY,const float *heights) :
+    sizeX(std::max(sizeX,1)), sizeY(std::max(sizeY,1)), minHeight(0.0), maxHeight(0.0), scale(0.0)
+{
+    const size_t count = (size_t)this->sizeX * this->sizeY;
+    if (!heights || sizeX <= 0 || sizeY <= 0)
+    {
+        samples.resize(count,0);
+        return;
+    }
+
+    const auto range = std::minmax_element(heights,heights+count);
+    minHeight = *range.first;
+    maxHeight = *range.second;
+    scale = (maxHeight - minHeight) / 65535.0;
+
+    samples.resize(count);
+    const double invScale = (scale > 0.0) ? 1.0 / scale : 0.0;
+    for (size_t ii=0;ii<count;ii++)
+    {
+        samples[ii] = (uint16_t)std::lround((heights[ii] - minHeight) * invScale);
+    }
+}
+
+ElevationTileRef ElevationTile::FromPixels(const unsigned char *pixels,int width,int height,
+                                           int bytesPerPixel,ElevationEncoding encoding)
+{
+    if (!pixels || width <= 0 || height <= 0 || bytesPerPixel < 3)
+    {
+        return nullptr;
+    }
+
+    std::vector<float> heights((size_t)width * height);
+    for (size_t ii=0;ii<heights.size();ii++)
+    {
+        const unsigned char *pix = &pixels[ii * bytesPerPixel];
+        switch (encoding)
+        {
+            case ElevEncodeTerrarium:
+                heights[ii] = (float)(pix[0] * 256.0 + pix[1] + pix[2] / 256.0 - 32768.0);
+                break;
+            case ElevEncodeMapboxRGB:
+                heights[ii] = (float)(-10000.0 + (pix[0] * 65536.0 + pix[1] * 256.0 + pix[2]) * 0.1);
+                break;
+        }
+    }
+
+    return std::make_shared<ElevationTile>(width,height,heights.data());
+}
+
+ElevationTileRef ElevationTile::FromPNG(const unsigned char *data,size_t length,ElevationEncoding encoding)
+{
+    unsigned int width = 0, height = 0;
+    int byteWidth = 0;
+    unsigned char *pixels = DecodePNGFast(data,length,width,height,byteWidth);
+    if (!pixels)
+    {
+        return nullptr;
+    }
+
+    auto tile = FromPixels(pixels,(int)width,(int)height,byteWidth,encoding);
+    free(pixels);
+    return tile;
+}
+
+double ElevationTile::heightAt(double u,double v) const
+{
+    // Samples are at the pixel centers
+    const double fx = std::min(std::max(u * sizeX - 0.5,0.0),(double)(sizeX-1));
+    const double fy = std::min(std::max((1.0 - v) * sizeY - 0.5,0.0),(double)(sizeY-1));
+    const int ix = std::min((int)fx,sizeX-2 >= 0 ? sizeX-2 : 0);
+    const int iy = std::min((int)fy,sizeY-2 >= 0 ? sizeY-2 : 0);
+    const int ix1 = std::min(ix+1,sizeX-1);
+    const int iy1 = std::min(iy+1,sizeY-1);
+    const double tx = fx - ix, ty = fy - iy;
+
+    const double s00 = samples[iy*sizeX+ix], s10 = samples[iy*sizeX+ix1];
+    const double s01 = samples[iy1*sizeX+ix], s11 = samples[iy1*sizeX+ix1];
+    const double s = (s00 * (1.0-tx) + s10 * tx) * (1.0-ty) + (s01 * (1.0-tx) + s11 * tx) * ty;
+
+    return minHeight + s * scale;
+}
+
+ElevationManager::ElevationManager() :
+    minZoom(0), maxZoom(0), maxBytes(64*1024*1024), curBytes(0), maxLevelLoaded(-1),
+    minHeight(0.0), maxHeight(0.0), numTiles(0)
+{
+}
+
+ElevationManager::~ElevationManager()
+{
+    if (const auto theIntManager = intersectManager.lock())
+    {
+        theIntManager->removeIntersectable(this);
+    }
+}
+
+void ElevationManager::setup(const CoordSystemRef &inCoordSys,const MbrD &inMbr,int inMinZoom,int inMaxZoom)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    coordSys = inCoordSys;
+    mbr = inMbr;
+    minZoom = std::max(inMinZoom,0);
+    maxZoom = std::max(inMaxZoom,minZoom);
+
+    tiles.clear();
+    lru.clear();
+    curBytes = 0;
+    maxLevelLoaded = -1;
+    minHeight = maxHeight = 0.0;
+    numTiles = 0;
+}
+
+void ElevationManager::setMaxBytes(size_t inMaxBytes)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    maxBytes = inMaxBytes;
+    trim(maxBytes);
+}
+
+void ElevationManager::addTile(const QuadTreeIdentifier &ident,const ElevationTileRef &tile)
+{
+    if (!tile)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (!coordSys || ident.level < minZoom || ident.level > maxZoom)
+    {
+        return;
+    }
+
+    const int64_t key = ident.NodeNumber();
+    auto it = tiles.find(key);
+    if (it != tiles.end())
+    {
+        curBytes -= it->second.tile->getBytes();
+        lru.erase(it->second.lruPos);
+    }
+    else
+    {
+        it = tiles.insert(std::make_pair(key,TileEntry())).first;
+    }
+
+    const Point2d chunkSize(mbr.span().x() / (1<<ident.level),mbr.span().y() / (1<<ident.level));
+    TileEntry &entry = it->second;
+    entry.tile = tile;
+    entry.mbr = MbrD(Point2d(chunkSize.x()*ident.x,chunkSize.y()*ident.y) + mbr.ll(),
+                     Point2d(chunkSize.x()*(ident.x+1),chunkSize.y()*(ident.y+1)) + mbr.ll());
+    lru.push_front(key);
+    entry.lruPos = lru.begin();
+    curBytes += tile->getBytes();
+
+    if (tiles.size() == 1)
+    {
+        minHeight = tile->getMinHeight();
+        maxHeight = tile->getMaxHeight();
+    }
+    else
+    {
+        minHeight = std::min(minHeight,tile->getMinHeight());
+        maxHeight = std::max(maxHeight,tile->getMaxHeight());
+    }
+    maxLevelLoaded = std::max(maxLevelLoaded,ident.level);
+
+    trim(maxBytes);
+    numTiles = tiles.size();
+}
+
+bool ElevationManager::addTile(const QuadTreeIdentifier &ident,const unsigned char *data,size_t length,ElevationEncoding encoding)
+{
+    // Decode outside the lock, so queries keep going
+    const auto tile = ElevationTile::FromPNG(data,length,encoding);
+    if (!tile)
+    {
+        wkLogLevel(Warn,"ElevationManager: Failed to decode elevation tile %d: (%d,%d)",ident.level,ident.x,ident.y);
+        return false;
+    }
+
+    addTile(ident,tile);
+    return true;
+}
+
+void ElevationManager::removeTile(const QuadTreeIdentifier &ident)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    const auto it = tiles.find(ident.NodeNumber());
+    if (it != tiles.end())
+    {
+        curBytes -= it->second.tile->getBytes();
+        lru.erase(it->second.lruPos);
+        tiles.erase(it);
+        numTiles = tiles.size();
+    }
+}
+
+void ElevationManager::clear()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    tiles.clear();
+    lru.clear();
+    curBytes = 0;
+    maxLevelLoaded = -1;
+    numTiles = 0;
+}
+
+void ElevationManager::addMemoryUsage(MemoryUsage &usage)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    usage.bytes[MemParsedTiles] += curBytes;
+}
+
+void ElevationManager::trimMemory(PlatformThreadInfo *,MemoryTrimLevel step,ChangeSet &)
+{
+    if (step != MemTrimOffscreenTiles)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guardLock(lock);
+    trim(curBytes / 2);
+    numTiles = tiles.size();
+}
+
+void ElevationManager::trim(size_t limit)
+{
+    // Keep the most recent one, even if it's too big on its own
+    while (curBytes > limit && lru.size() > 1)
+    {
+        const auto it = tiles.find(lru.back());
+        if (it != tiles.end())
+        {
+            curBytes -= it->second.tile->getBytes();
+            tiles.erase(it);
+        }
+        lru.pop_back();
+    }
+}
+
+const ElevationManager::TileEntry *ElevationManager::findTile(const Point2d &local)
+{
+    const Point2d span = mbr.span();
+    if (span.x() <= 0.0 || span.y() <= 0.0)
+    {
+        return nullptr;
+    }
+    const double relX = (local.x() - mbr.ll().x()) / span.x();
+    const double relY = (local.y() - mbr.ll().y()) / span.y();
+    if (relX < 0.0 || relX > 1.0 || relY < 0.0 || relY > 1.0)
+    {
+        return nullptr;
+    }
+
+    for (int level = std::min(maxLevelLoaded,maxZoom); level >= minZoom; level--)
+    {
+        const int numChunks = 1 << level;
+        const int x = std::min((int)(relX * numChunks),numChunks-1);
+        const int y = std::min((int)(relY * numChunks),numChunks-1);
+        const auto it = tiles.find(QuadTreeIdentifier::NodeNumber(x,y,level));
+        if (it != tiles.end())
+        {
+            return &it->second;
+        }
+    }
+
+    return nullptr;
+}
+
+size_t ElevationManager::heightsAt(const Point2d *geo,double *heights,size_t count,std::vector<bool> *found)
+{
+    if (found)
+    {
+        found->assign(count,false);
+    }
+    std::fill(heights,heights+count,0.0);
+    if (count == 0 || !hasData())
+    {
+        return 0;
+    }
+
+    CoordSystemRef theCoordSys;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        theCoordSys = coordSys;
+    }
+    if (!theCoordSys)
+    {
+        return 0;
+    }
+
+    // Into the tile set's system all at once
+    std::vector<Point3d> local(count);
+    theCoordSys->geographicToLocalBatch(geo,local.data(),count);
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    size_t numFound = 0;
+    const TileEntry *lastEntry = nullptr;
+    for (size_t ii=0;ii<count;ii++)
+    {
+        const Point2d pt(local[ii].x(),local[ii].y());
+        const TileEntry *entry = findTile(pt);
+        if (!entry)
+        {
+            continue;
+        }
+
+        const Point2d span = entry->mbr.span();
+        heights[ii] = entry->tile->heightAt((pt.x() - entry->mbr.ll().x()) / span.x(),
+                                            (pt.y() - entry->mbr.ll().y()) / span.y());
+        if (found)
+        {
+            (*found)[ii] = true;
+        }
+        numFound++;
+
+        // Nearby points tend to share a tile, so only move it up once
+        if (entry != lastEntry)
+        {
+            lru.splice(lru.begin(),lru,entry->lruPos);
+            lastEntry = entry;
+        }
+    }
+
+    return numFound;
+}
+
+double ElevationManager::heightAt(const Point2d &geo,bool *found)
+{
+    double height = 0.0;
+    const bool isFound = heightsAt(&geo,&height,1) > 0;
+    if (found)
+    {
+        *found = isFound;
+    }
+    return height;
+}
+
+void ElevationManager::setScene(Scene *inScene)
+{
+    // Don't go through the scene to leave, since it may be holding its manager lock
+    if (const auto theIntManager = intersectManager.lock())
+    {
+        theIntManager->removeIntersectable(this);
+    }
+    intersectManager.reset();
+
+    SceneManager::setScene(inScene);
+
+    if (inScene)
+    {
+        if (const auto theIntManager = inScene->getManager<IntersectionManager>(kWKIntersectionManager))
+        {
+            theIntManager->addIntersectable(this);
+            intersectManager = theIntManager;
+        }
+    }
+}
+
+bool ElevationManager::findClosestIntersection(SceneRenderer *renderer,View *theView,const Point2f &frameSize,const Point2f &touchPt,
+                                               const Point3d &org,const Point3d &dir,Point3d &iPt,double &dist)
+{
+    const auto adapter = scene ? scene->getCoordAdapter() : nullptr;
+    if (!hasData() || !adapter || adapter->isFlat())
+    {
+        return false;
+    }
+    const auto sceneCoordSys = adapter->getCoordSystem();
+
+    double lowest,highest;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        lowest = std::min(minHeight,0.0);
+        highest = std::max(maxHeight,0.0);
+    }
+
+    // Only the shell between the lowest and highest terrain can have a hit
+    Point3d hit;
+    double tTop = 0.0, tBottom = 0.0;
+    if (!IntersectSphereRadius(org,dir,1.0 + highest / EarthRadius,hit,&tTop))
+    {
+        return false;
+    }
+    if (!IntersectSphereRadius(org,dir,1.0 + lowest / EarthRadius,hit,&tBottom))
+    {
+        // Grazing the shell, so stop where the ray leaves it
+        tBottom = 2.0 * -org.dot(dir) / dir.dot(dir) - tTop;
+    }
+    tTop = std::max(tTop,0.0);
+    if (tBottom <= tTop)
+    {
+        return false;
+    }
+
+    const auto aboveTerrain = [&](double t)
+    {
+        const Point3d pt = org + dir * t;
+        const Point2d geo = sceneCoordSys->localToGeographicD(adapter->displayToLocal(pt));
+        return pt.norm() - 1.0 > heightAt(geo) / EarthRadius;
+    };
+
+    const double step = (tBottom - tTop) / IntersectSteps;
+    double tPrev = tTop;
+    for (int ii=1;ii<=IntersectSteps;ii++)
+    {
+        double t = tTop + step * ii;
+        if (!aboveTerrain(t))
+        {
+            // Narrow in on where it crossed
+            double tAbove = tPrev;
+            for (int jj=0;jj<IntersectRefine;jj++)
+            {
+                const double tMid = (tAbove + t) / 2.0;
+                if (aboveTerrain(tMid))
+                    tAbove = tMid;
+                else
+                    t = tMid;
+            }
+            iPt = org + dir * t;
+            dist = t * dir.norm();
+            return true;
+        }
+        tPrev = t;
+    }
+
+    return false;
+}
+
+}
@@ -32,6 +32,28 @@ Point3d PlateCarreeCoordSystem::localToGeocentric(Point3d localPt) const
     return GeoCoordSystem::LocalToGeocentric(Point3d(localPt.x(),localPt.y(),localPt.z()));
 }
     
+void PlateCarreeCoordSystem::geographicToLocalBatch(const Point2d *geo,Point3d *local,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        local[ii] = Point3d(geo[ii].x(),geo[ii].y(),0.0);
+}
+
+void PlateCarreeCoordSystem::localToGeographicBatch(const Point3d *local,Point2d *geo,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        geo[ii] = Point2d(local[ii].x(),local[ii].y());
+}
+
+void PlateCarreeCoordSystem::localToGeocentricBatch(const Point3d *local,Point3d *geoc,size_t count) const
+{
+    GeoCoordSystem::LocalToGeocentric(local,geoc,count);
+}
+
+void PlateCarreeCoordSystem::geocentricToLocalBatch(const Point3d *geoc,Point3d *local,size_t count) const
+{
+    GeoCoordSystem::GeocentricToLocal(geoc,local,count);
+}
+
 /// Convert from WGS84 geocentric to local coordinates
 Point3f PlateCarreeCoordSystem::geocentricToLocal(Point3f geocPt) const
 {
@@ -16,6 +16,8 @@
  *  limitations under the License.
  */
 
+#import <algorithm>
+#import <cmath>
 #import "FontTextureManager.h"
 #import "WhirlyVector.h"
 
@@ -126,6 +128,220 @@ void FontTextureManager::init()
     }
 }
             
+void FontTextureManager::setGlyphCache(GlyphCacheRef cache)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    glyphCache = std::move(cache);
+}
+
+GlyphCacheRef FontTextureManager::getGlyphCache()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return glyphCache;
+}
+
+constexpr float FontTextureManager::SDFPointSize;
+constexpr int FontTextureManager::SDFRadius;
+
+void FontTextureManager::setSDFMode(bool enable)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    sdfMode = enable;
+}
+
+bool FontTextureManager::getSDFMode()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return sdfMode;
+}
+
+// Glyphs to remove between looks at compacting the atlas
+static const int CompactionInterval = 64;
+
+void FontTextureManager::setAtlasCompaction(bool enable)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    atlasCompaction = enable;
+}
+
+bool FontTextureManager::getAtlasCompaction()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return atlasCompaction;
+}
+
+void FontTextureManager::setLayoutCacheSize(size_t size)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    maxLayouts = size;
+    while (layouts.size() > maxLayouts)
+    {
+        layouts.erase(layoutLRU.back());
+        layoutLRU.pop_back();
+    }
+}
+
+size_t FontTextureManager::getLayoutCacheSize()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return maxLayouts;
+}
+
+void FontTextureManager::addMemoryUsage(MemoryUsage &usage)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (texAtlas)
+    {
+        usage.bytes[MemAtlases] += texAtlas->getBytes();
+    }
+    for (const auto &layout : layouts)
+    {
+        usage.bytes[MemCaches] += layout.first.size() +
+                                  layout.second.glyphPolys.size() * sizeof(DrawableString::Rect) +
+                                  layout.second.glyphs.size() * sizeof(LayoutGlyphs::value_type);
+    }
+}
+
+void FontTextureManager::trimMemory(PlatformThreadInfo *,MemoryTrimLevel step,ChangeSet &changes)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    switch (step)
+    {
+        case MemTrimDecodeCaches:
+            layouts.clear();
+            layoutLRU.clear();
+            break;
+        case MemTrimAtlasPages:
+            if (texAtlas)
+            {
+                texAtlas->cleanup(changes,0.0);
+                texAtlas->compact(changes);
+                glyphsRemoved = 0;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+std::unique_ptr<DrawableString> FontTextureManager::findLayout(const std::string &key)
+{
+    const auto it = layouts.find(key);
+    if (it == layouts.end())
+    {
+        return nullptr;
+    }
+    StringLayout &layout = it->second;
+
+    // The glyphs may have been dropped since, or moved in the atlas
+    auto drawString = std::make_unique<DrawableString>();
+    drawString->glyphPolys = layout.glyphPolys;
+    SimpleIDGlyphMap glyphsUsed;
+    for (size_t ii=0;ii<layout.glyphs.size();ii++)
+    {
+        const auto fmIt = fontManagers.find(layout.glyphs[ii].first);
+        const auto glyphInfo = (fmIt == fontManagers.end()) ? nullptr : fmIt->second->findGlyph(layout.glyphs[ii].second);
+        if (!glyphInfo)
+        {
+            // Lay it out again
+            layoutLRU.erase(layout.lruPos);
+            layouts.erase(it);
+            return nullptr;
+        }
+        drawString->glyphPolys[ii].subTex = glyphInfo->subTex;
+        glyphsUsed[layout.glyphs[ii].first].insert(layout.glyphs[ii].second);
+    }
+    drawString->mbr = layout.mbr;
+    drawString->sdf = layout.sdf;
+
+    auto drawStringRep = new DrawStringRep(drawString->getId());
+    for (const auto &fontGlyphs : glyphsUsed)
+    {
+        drawStringRep->addGlyphs(fontGlyphs.first,fontGlyphs.second);
+        fontManagers[fontGlyphs.first]->addGlyphRefs(fontGlyphs.second);
+    }
+    drawStringReps.insert(drawStringRep);
+
+    layoutLRU.splice(layoutLRU.begin(),layoutLRU,layout.lruPos);
+
+    return drawString;
+}
+
+void FontTextureManager::addLayout(const std::string &key,const DrawableString &drawString,LayoutGlyphs &&glyphs)
+{
+    if (maxLayouts == 0 || drawString.glyphPolys.size() != glyphs.size())
+    {
+        return;
+    }
+
+    auto it = layouts.find(key);
+    if (it == layouts.end())
+    {
+        layoutLRU.push_front(key);
+        it = layouts.emplace(key,StringLayout()).first;
+        it->second.lruPos = layoutLRU.begin();
+    }
+    else
+    {
+        layoutLRU.splice(layoutLRU.begin(),layoutLRU,it->second.lruPos);
+    }
+    StringLayout &layout = it->second;
+    layout.glyphPolys = drawString.glyphPolys;
+    layout.glyphs = std::move(glyphs);
+    layout.mbr = drawString.mbr;
+    layout.sdf = drawString.sdf;
+
+    while (layouts.size() > maxLayouts)
+    {
+        layouts.erase(layoutLRU.back());
+        layoutLRU.pop_back();
+    }
+}
+
+void FontTextureManager::makeSDFGlyph(const unsigned char *rgba,int width,int height,
+                                      std::vector<unsigned char> &out,int &outWidth,int &outHeight)
+{
+    const int rad = SDFRadius;
+    outWidth = width + 2*rad;
+    outHeight = height + 2*rad;
+
+    // Coverage from the alpha, padded out
+    std::vector<char> inside(outWidth * outHeight,0);
+    for (int iy=0;iy<height;iy++)
+        for (int ix=0;ix<width;ix++)
+            inside[(iy+rad)*outWidth + ix+rad] = rgba[4*(iy*width+ix)+3] >= 128;
+
+    // Nearest pixel on the other side of the edge, within the radius
+    out.resize(4 * outWidth * outHeight);
+    const float maxDist2 = (float)(rad * rad);
+    for (int iy=0;iy<outHeight;iy++)
+    {
+        for (int ix=0;ix<outWidth;ix++)
+        {
+            const bool in = inside[iy*outWidth + ix];
+            float bestDist2 = maxDist2;
+            for (int dy=std::max(-rad,-iy);dy<=std::min(rad,outHeight-1-iy);dy++)
+            {
+                for (int dx=std::max(-rad,-ix);dx<=std::min(rad,outWidth-1-ix);dx++)
+                {
+                    const float dist2 = (float)(dx*dx + dy*dy);
+                    if (dist2 < bestDist2 && inside[(iy+dy)*outWidth + ix+dx] != in)
+                        bestDist2 = dist2;
+                }
+            }
+
+            // The edge is halfway between this pixel and that one
+            const float dist = std::sqrt(bestDist2) - 0.5f;
+            const float val = 0.5f + (in ? dist : -dist) / (2.0f * rad);
+            unsigned char *pix = &out[4*(iy*outWidth + ix)];
+            pix[0] = pix[1] = pix[2] = 255;
+            pix[3] = (unsigned char)std::min(std::max(val * 255.0f + 0.5f,0.0f),255.0f);
+        }
+    }
+}
+
 void FontTextureManager::clear(ChangeSet &changes)
 {
     std::lock_guard<std::mutex> guardLock(lock);
@@ -142,6 +358,8 @@ void FontTextureManager::clear(ChangeSet &changes)
     }
     drawStringReps.clear();
     fontManagers.clear();
+    layouts.clear();
+    layoutLRU.clear();
 }
 
 void FontTextureManager::removeString(PlatformThreadInfo *inst, SimpleIdentity drawStringId,ChangeSet &changes,TimeInterval when)
@@ -182,6 +400,7 @@ void FontTextureManager::removeString(PlatformThreadInfo *inst, SimpleIdentity d
 
             texAtlas->removeTexture(ii, changes, when);
         }
+        glyphsRemoved += (int)texRemove.size();
 
         // Also see if we're done with the font
         if (fm->refCount <= 0)
@@ -194,6 +413,13 @@ void FontTextureManager::removeString(PlatformThreadInfo *inst, SimpleIdentity d
     }
     
     delete theRep;
+
+    if (atlasCompaction && texAtlas && glyphsRemoved >= CompactionInterval)
+    {
+        texAtlas->cleanup(changes,when);
+        texAtlas->compact(changes);
+        glyphsRemoved = 0;
+    }
 }
 
 }
@@ -0,0 +1,126 @@
+/*  FramePacer.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import "FramePacer.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    // Keep the rate up this long after the last frame, so a pause in a gesture doesn't slow it
+    constexpr TimeInterval IdleDelay = 0.5;
+}
+
+void FramePacer::setMode(Mode inMode)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    mode = inMode;
+}
+
+FramePacer::Mode FramePacer::getMode() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return mode;
+}
+
+void FramePacer::setDisplayRate(int fps)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    displayRate = std::max(fps,1);
+}
+
+int FramePacer::getDisplayRate() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return displayRate;
+}
+
+void FramePacer::setLowRate(int fps)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    lowRate = std::max(fps,1);
+}
+
+int FramePacer::getLowRate() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return lowRate;
+}
+
+int FramePacer::rateFor(Need need) const
+{
+    switch (mode)
+    {
+        case PacingFull:
+            return displayRate;
+        case PacingBalanced:
+            switch (need)
+            {
+                case NeedMotion:
+                    return displayRate;
+                case NeedAnimation:
+                    return std::min(displayRate,60);
+                default:
+                    return std::min(displayRate,lowRate);
+            }
+        case PacingLowPower:
+            return (need == NeedMotion) ? std::min(displayRate,60) : std::min(displayRate,lowRate);
+    }
+    return displayRate;
+}
+
+bool FramePacer::shouldRender(Need need,TimeInterval now)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    pending = std::max(pending,need);
+    if (pending == NeedNone)
+        return false;
+
+    // Half a display frame of slack, so we land on the callback we meant to
+    const TimeInterval minInterval = 1.0 / rateFor(pending) - 0.5 / displayRate;
+    if (now - lastFrame < minInterval)
+        return false;
+
+    lastFrame = now;
+    lastNeed = pending;
+    pending = NeedNone;
+    return true;
+}
+
+int FramePacer::getPreferredRate(TimeInterval now) const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (pending != NeedNone || now - lastFrame < IdleDelay)
+        return rateFor(std::max(pending,lastNeed));
+
+    // Nothing going on, so we're just watching for changes
+    switch (mode)
+    {
+        case PacingFull:
+            return displayRate;
+        case PacingBalanced:
+            return std::min(displayRate,lowRate);
+        case PacingLowPower:
+            return std::max(std::min(displayRate,lowRate) / 2,1);
+    }
+    return displayRate;
+}
+
+}
@@ -0,0 +1,152 @@
+/*  FrameStats.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import <cmath>
+#import "FrameStats.h"
+
+namespace WhirlyKit
+{
+
+const char *FrameStats::getMetricName(Metric metric)
+{
+    switch (metric)
+    {
+        case FrameTime: return "frameTime";
+        case ChangeTime: return "changeTime";
+        case CullTime: return "cullTime";
+        case DrawTime: return "drawTime";
+        case PresentTime: return "presentTime";
+        case DrawablesDrawn: return "drawablesDrawn";
+        case DrawCalls: return "drawCalls";
+        case Triangles: return "triangles";
+        case TextureBytes: return "textureBytes";
+        case ChangesExecuted: return "changesExecuted";
+        case StateCalls: return "stateCalls";
+        case StateCallsSkipped: return "stateCallsSkipped";
+        default: return "unknown";
+    }
+}
+
+FrameStats::FrameStats(int inMaxFrames) :
+    enable(false),
+    maxFrames(std::max(inMaxFrames,1))
+{
+}
+
+void FrameStats::setEnable(bool newEnable)
+{
+    enable.store(newEnable,std::memory_order_relaxed);
+}
+
+void FrameStats::addFrame(const Frame &frame)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (frames.size() < maxFrames)
+    {
+        frames.push_back(frame);
+    }
+    else
+    {
+        frames[nextFrame] = frame;
+    }
+    nextFrame = (nextFrame + 1) % maxFrames;
+}
+
+FrameStats::Summary FrameStats::makeSummary(Metric metric,std::vector<double> &vals) const
+{
+    Summary summary;
+    summary.metric = metric;
+    summary.numFrames = (int)vals.size();
+    if (vals.empty())
+        return summary;
+
+    std::sort(vals.begin(),vals.end());
+    double total = 0.0;
+    for (double val : vals)
+        total += val;
+
+    // Nearest rank
+    const auto percentile = [&vals](double frac) {
+        const size_t idx = (size_t)std::ceil(frac * vals.size());
+        return vals[std::min(std::max(idx,(size_t)1),vals.size()) - 1];
+    };
+
+    summary.minVal = vals.front();
+    summary.maxVal = vals.back();
+    summary.mean = total / vals.size();
+    summary.p50 = percentile(0.50);
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+
+    return summary;
+}
+
+FrameStats::Summary FrameStats::getSummary(Metric metric) const
+{
+    std::vector<double> vals;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        vals.reserve(frames.size());
+        for (const auto &frame : frames)
+            vals.push_back(frame.values[metric]);
+    }
+
+    return makeSummary(metric,vals);
+}
+
+std::vector<FrameStats::Summary> FrameStats::getSummaries() const
+{
+    const auto theFrames = getFrames();
+
+    std::vector<Summary> summaries;
+    summaries.reserve(NumMetrics);
+    std::vector<double> vals(theFrames.size());
+    for (int mm=0;mm<NumMetrics;mm++)
+    {
+        for (size_t ii=0;ii<theFrames.size();ii++)
+            vals[ii] = theFrames[ii].values[mm];
+        summaries.push_back(makeSummary((Metric)mm,vals));
+    }
+
+    return summaries;
+}
+
+std::vector<FrameStats::Frame> FrameStats::getFrames() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (frames.size() < maxFrames)
+        return frames;
+
+    // Full, so the oldest one is the next to be overwritten
+    std::vector<Frame> ret;
+    ret.reserve(frames.size());
+    ret.insert(ret.end(),frames.begin() + nextFrame,frames.end());
+    ret.insert(ret.end(),frames.begin(),frames.begin() + nextFrame);
+    return ret;
+}
+
+void FrameStats::clear()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    frames.clear();
+    nextFrame = 0;
+}
+
+}
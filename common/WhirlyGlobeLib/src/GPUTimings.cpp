@@ -0,0 +1,129 @@
+/*  GPUTimings.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import <cmath>
+#import "GPUTimings.h"
+
+namespace WhirlyKit
+{
+
+const char *GPUTimings::getPhaseName(Phase phase)
+{
+    switch (phase)
+    {
+        case Calculation: return "calculation";
+        case Offscreen: return "offscreen";
+        case ReduceOps: return "reduceOps";
+        case ScreenRender: return "screenRender";
+        case Total: return "total";
+        default: return "unknown";
+    }
+}
+
+GPUTimings::GPUTimings(int inMaxFrames) :
+    enable(false),
+    maxFrames(std::max(inMaxFrames,1))
+{
+}
+
+void GPUTimings::setEnable(bool newEnable)
+{
+    enable.store(newEnable,std::memory_order_relaxed);
+}
+
+void GPUTimings::addFrame(const Frame &inFrame)
+{
+    Frame frame = inFrame;
+    frame.values[Total] = 0.0;
+    frame.timed[Total] = false;
+    for (int pp=0;pp<Total;pp++)
+        if (frame.timed[pp])
+            frame.add(Total,frame.values[pp]);
+    if (!frame.timed[Total])
+        return;
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (frames.size() < maxFrames)
+    {
+        frames.push_back(frame);
+    }
+    else
+    {
+        frames[nextFrame] = frame;
+    }
+    nextFrame = (nextFrame + 1) % maxFrames;
+}
+
+std::vector<GPUTimings::Summary> GPUTimings::getSummaries() const
+{
+    std::vector<Frame> theFrames;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        theFrames = frames;
+    }
+
+    std::vector<Summary> summaries;
+    summaries.reserve(NumPhases);
+    std::vector<double> vals;
+    vals.reserve(theFrames.size());
+    for (int pp=0;pp<NumPhases;pp++)
+    {
+        // Frames that didn't run a phase don't count as zero for it
+        vals.clear();
+        for (const auto &frame : theFrames)
+            if (frame.timed[pp])
+                vals.push_back(frame.values[pp]);
+
+        Summary summary;
+        summary.phase = (Phase)pp;
+        summary.numFrames = (int)vals.size();
+        if (!vals.empty())
+        {
+            std::sort(vals.begin(),vals.end());
+            double total = 0.0;
+            for (double val : vals)
+                total += val;
+
+            // Nearest rank
+            const auto percentile = [&vals](double frac) {
+                const size_t idx = (size_t)std::ceil(frac * vals.size());
+                return vals[std::min(std::max(idx,(size_t)1),vals.size()) - 1];
+            };
+
+            summary.minVal = vals.front();
+            summary.maxVal = vals.back();
+            summary.mean = total / vals.size();
+            summary.p50 = percentile(0.50);
+            summary.p95 = percentile(0.95);
+            summary.p99 = percentile(0.99);
+        }
+        summaries.push_back(summary);
+    }
+
+    return summaries;
+}
+
+void GPUTimings::clear()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    frames.clear();
+    nextFrame = 0;
+}
+
+}
@@ -0,0 +1,1031 @@
+/*  GeoJSONStreamReader.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <atomic>
+#import <cstdlib>
+#import <cstring>
+#import <mutex>
+#import <thread>
+#import "GeoJSONStreamReader.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    // How much we ask the read function for at once
+    const size_t ReadSize = 64 * 1024;
+    // Arrays within a coordinates member
+    const int MaxCoordNesting = 8;
+    // Objects and arrays within a value we're skipping, or collections within collections
+    const int MaxValueDepth = 256;
+    const int MaxGeometryDepth = 32;
+
+    inline bool isSpace(int c)
+    {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    inline bool isNumberChar(int c)
+    {
+        return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
+
+    int hexValue(int c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    void appendUTF8(std::string &str,unsigned int code)
+    {
+        if (code < 0x80)
+            str += (char)code;
+        else if (code < 0x800)
+        {
+            str += (char)(0xC0 | (code >> 6));
+            str += (char)(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            str += (char)(0xE0 | (code >> 12));
+            str += (char)(0x80 | ((code >> 6) & 0x3F));
+            str += (char)(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            str += (char)(0xF0 | (code >> 18));
+            str += (char)(0x80 | ((code >> 12) & 0x3F));
+            str += (char)(0x80 | ((code >> 6) & 0x3F));
+            str += (char)(0x80 | (code & 0x3F));
+        }
+    }
+
+    // Find the inside of the top level "features" array and split it between
+    //  commas into about the given number of pieces.
+    bool splitFeatures(const char *data,size_t len,int numPieces,std::vector<std::pair<size_t,size_t>> &pieces)
+    {
+        int depth = 0;
+        bool inString = false;
+        bool lastKeyFeatures = false;
+        size_t strStart = 0;
+        size_t start = 0, pieceStart = 0, nextSplit = 0, pieceSize = 0;
+        bool inFeatures = false;
+
+        for (size_t ii=0;ii<len;ii++)
+        {
+            const char c = data[ii];
+            if (inString)
+            {
+                if (c == '\\')
+                    ii++;
+                else if (c == '"')
+                {
+                    inString = false;
+                    if (depth == 1)
+                        lastKeyFeatures = (ii - strStart == 8 && !strncmp(data + strStart,"features",8));
+                }
+                continue;
+            }
+
+            switch (c)
+            {
+                case '"':
+                    inString = true;
+                    strStart = ii + 1;
+                    break;
+                case '{':
+                    depth++;
+                    break;
+                case '[':
+                    depth++;
+                    if (depth == 2 && lastKeyFeatures)
+                    {
+                        inFeatures = true;
+                        start = pieceStart = ii + 1;
+                        // Rough guess, since the array is most of the file
+                        pieceSize = (len - start) / std::max(numPieces,1) + 1;
+                        nextSplit = start + pieceSize;
+                    }
+                    break;
+                case '}':
+                case ']':
+                    depth--;
+                    if (inFeatures && depth == 1)
+                    {
+                        pieces.emplace_back(pieceStart,ii);
+                        return true;
+                    }
+                    if (depth < 0)
+                        return false;
+                    break;
+                case ',':
+                    if (inFeatures && depth == 2 && ii >= nextSplit)
+                    {
+                        pieces.emplace_back(pieceStart,ii);
+                        pieceStart = ii + 1;
+                        nextSplit = ii + pieceSize;
+                    }
+                    break;
+                case ':':
+                    break;
+                default:
+                    if (!isSpace(c) && depth == 1)
+                        lastKeyFeatures = false;
+                    break;
+            }
+        }
+
+        return false;
+    }
+}
+
+GeoJSONStreamReader::GeoJSONStreamReader(const char *data,size_t len)
+: pos(data), end(data + len), assembly(false), state(StateStart),
+  assemblyFirst(true), collectionFirst(true), featuresFirst(true), chunk(false), topGeometry(false)
+{
+}
+
+GeoJSONStreamReader::GeoJSONStreamReader(ReadFunc inReadFunc)
+: pos(nullptr), end(nullptr), readFunc(std::move(inReadFunc)), assembly(false), state(StateStart),
+  assemblyFirst(true), collectionFirst(true), featuresFirst(true), chunk(false), topGeometry(false)
+{
+}
+
+bool GeoJSONStreamReader::fill()
+{
+    if (!readFunc)
+        return false;
+
+    buf.resize(ReadSize);
+    const size_t len = readFunc(buf.data(),buf.size());
+    if (len == 0)
+    {
+        readFunc = nullptr;
+        return false;
+    }
+    pos = buf.data();
+    end = pos + std::min(len,buf.size());
+
+    return true;
+}
+
+int GeoJSONStreamReader::peek()
+{
+    if (pos == end && !fill())
+        return -1;
+    return (unsigned char)*pos;
+}
+
+int GeoJSONStreamReader::get()
+{
+    const int c = peek();
+    if (c >= 0)
+        pos++;
+    return c;
+}
+
+bool GeoJSONStreamReader::skipSpace()
+{
+    while (true)
+    {
+        if (pos == end && !fill())
+            return false;
+        if (!isSpace(*pos))
+            return true;
+        pos++;
+    }
+}
+
+bool GeoJSONStreamReader::expect(char c)
+{
+    if (!skipSpace())
+        return fail("Unexpected end of data");
+    if (get() != c)
+    {
+        const char what[] = {'E','x','p','e','c','t','e','d',' ','\'',c,'\'',0};
+        return fail(what);
+    }
+    return true;
+}
+
+bool GeoJSONStreamReader::fail(const char *what)
+{
+    if (error.empty())
+        error = what;
+    return false;
+}
+
+bool GeoJSONStreamReader::readString(std::string &str)
+{
+    str.clear();
+    if (!expect('"'))
+        return false;
+
+    while (true)
+    {
+        if (pos == end && !fill())
+            return fail("Unterminated string");
+
+        // Most strings don't have escapes, so take what we can in one go
+        const char *start = pos;
+        while (pos < end && *pos != '"' && *pos != '\\')
+            pos++;
+        str.append(start,pos - start);
+        if (pos == end)
+            continue;
+
+        if (*pos++ == '"')
+            return true;
+
+        const int esc = get();
+        switch (esc)
+        {
+            case '"':  str += '"';  break;
+            case '\\': str += '\\';  break;
+            case '/':  str += '/';  break;
+            case 'b':  str += '\b';  break;
+            case 'f':  str += '\f';  break;
+            case 'n':  str += '\n';  break;
+            case 'r':  str += '\r';  break;
+            case 't':  str += '\t';  break;
+            case 'u':
+            {
+                unsigned int code = 0;
+                for (int ii=0;ii<4;ii++)
+                {
+                    const int val = hexValue(get());
+                    if (val < 0)
+                        return fail("Bad unicode escape");
+                    code = (code << 4) | val;
+                }
+                // Characters outside the BMP come in as surrogate pairs
+                if (code >= 0xD800 && code < 0xDC00 && peek() == '\\')
+                {
+                    get();
+                    if (get() != 'u')
+                        return fail("Bad unicode escape");
+                    unsigned int low = 0;
+                    for (int ii=0;ii<4;ii++)
+                    {
+                        const int val = hexValue(get());
+                        if (val < 0)
+                            return fail("Bad unicode escape");
+                        low = (low << 4) | val;
+                    }
+                    if (low >= 0xDC00 && low < 0xE000)
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    else
+                    {
+                        appendUTF8(str,code);
+                        code = low;
+                    }
+                }
+                appendUTF8(str,code);
+            }
+                break;
+            default:
+                return fail("Bad escape in string");
+        }
+    }
+}
+
+bool GeoJSONStreamReader::skipString()
+{
+    if (!expect('"'))
+        return false;
+
+    while (true)
+    {
+        if (pos == end && !fill())
+            return fail("Unterminated string");
+        while (pos < end && *pos != '"' && *pos != '\\')
+            pos++;
+        if (pos == end)
+            continue;
+        if (*pos++ == '"')
+            return true;
+        // Whatever's escaped can't end the string
+        if (get() < 0)
+            return fail("Unterminated string");
+    }
+}
+
+bool GeoJSONStreamReader::readNumber(double &val)
+{
+    if (!skipSpace())
+        return fail("Unexpected end of data");
+
+    char numBuf[64];
+    size_t len = 0;
+    while (isNumberChar(peek()))
+    {
+        if (len >= sizeof(numBuf) - 1)
+            return fail("Number too long");
+        numBuf[len++] = (char)get();
+    }
+    numBuf[len] = 0;
+
+    char *numEnd = nullptr;
+    val = strtod(numBuf,&numEnd);
+    if (len == 0 || numEnd != numBuf + len)
+        return fail("Bad number");
+
+    return true;
+}
+
+bool GeoJSONStreamReader::readLiteral(const char *lit)
+{
+    if (!skipSpace())
+        return fail("Unexpected end of data");
+    for (const char *c = lit; *c; c++)
+        if (get() != *c)
+            return fail("Unexpected value");
+    return true;
+}
+
+bool GeoJSONStreamReader::skipValue(int depth)
+{
+    if (depth > MaxValueDepth)
+        return fail("Nested too deeply");
+    if (!skipSpace())
+        return fail("Unexpected end of data");
+
+    switch (peek())
+    {
+        case '"':
+            return skipString();
+        case '{':
+        {
+            get();
+            bool memberFirst = true, closed = false;
+            std::string key;
+            while (true)
+            {
+                if (!nextMember(memberFirst,key,closed))
+                    return false;
+                if (closed)
+                    return true;
+                if (!skipValue(depth+1))
+                    return false;
+            }
+        }
+        case '[':
+        {
+            get();
+            bool elemFirst = true;
+            while (true)
+            {
+                if (!skipSpace())
+                    return fail("Unexpected end of data");
+                if (peek() == ']')
+                {
+                    get();
+                    return true;
+                }
+                if (!elemFirst && !expect(','))
+                    return false;
+                elemFirst = false;
+                if (!skipValue(depth+1))
+                    return false;
+            }
+        }
+        case 't':
+            return readLiteral("true");
+        case 'f':
+            return readLiteral("false");
+        case 'n':
+            return readLiteral("null");
+        default:
+        {
+            double val;
+            return readNumber(val);
+        }
+    }
+}
+
+bool GeoJSONStreamReader::nextMember(bool &memberFirst,std::string &key,bool &closed)
+{
+    closed = false;
+    if (!skipSpace())
+        return fail("Unexpected end of data");
+    if (peek() == '}')
+    {
+        get();
+        closed = true;
+        return true;
+    }
+    if (!memberFirst && !expect(','))
+        return false;
+    memberFirst = false;
+
+    return readString(key) && expect(':');
+}
+
+bool GeoJSONStreamReader::readCoords(Coords &coords,int nesting)
+{
+    if (nesting > MaxCoordNesting)
+        return fail("Coordinates nested too deeply");
+    if (!expect('['))
+        return false;
+    if (!skipSpace())
+        return fail("Unexpected end of data");
+
+    // Empty array
+    if (peek() == ']')
+    {
+        get();
+        return true;
+    }
+
+    // A position, of which we only want the first two values
+    if (peek() != '[')
+    {
+        if (coords.depth == 0)
+            coords.depth = nesting;
+        else if (coords.depth != nesting)
+            return fail("Positions at different depths");
+
+        double vals[2] = {0.0,0.0};
+        int numVals = 0;
+        while (true)
+        {
+            double val;
+            if (!readNumber(val))
+                return false;
+            if (numVals < 2)
+                vals[numVals] = val;
+            numVals++;
+
+            if (!skipSpace())
+                return fail("Unexpected end of data");
+            if (peek() == ']')
+            {
+                get();
+                break;
+            }
+            if (!expect(','))
+                return false;
+        }
+        if (numVals < 2)
+            return fail("Position needs two values");
+        coords.pts.push_back(GeoCoord::CoordFromDegrees((float)vals[0],(float)vals[1]));
+
+        return true;
+    }
+
+    bool elemFirst = true;
+    while (true)
+    {
+        if (!skipSpace())
+            return fail("Unexpected end of data");
+        if (peek() == ']')
+        {
+            get();
+            break;
+        }
+        if (!elemFirst && !expect(','))
+            return false;
+        elemFirst = false;
+        if (!readCoords(coords,nesting+1))
+            return false;
+    }
+    coords.closes.emplace_back(nesting,(int)coords.pts.size());
+
+    return true;
+}
+
+void GeoJSONStreamReader::buildShapes(const std::string &type,Coords &coords,ShapeSet &shapes)
+{
+    if (coords.pts.empty())
+        return;
+
+    // Rings close one level above the positions, polygons one more above that
+    const int ringNesting = coords.depth - 1;
+    const int polyNesting = coords.depth - 2;
+    std::vector<std::vector<VectorRing>> polys(1);
+    if (coords.depth < 3)
+        polys.back().push_back(std::move(coords.pts));
+    else
+    {
+        int ringStart = 0;
+        for (const auto &close : coords.closes)
+        {
+            if (close.first == ringNesting)
+            {
+                if (close.second > ringStart)
+                    polys.back().emplace_back(coords.pts.begin() + ringStart,coords.pts.begin() + close.second);
+                ringStart = close.second;
+            }
+            else if (close.first == polyNesting && polyNesting > 1 && !polys.back().empty())
+                polys.emplace_back();
+        }
+    }
+    if (polys.back().empty())
+        polys.pop_back();
+
+    if (type == "Point" || type == "MultiPoint")
+    {
+        VectorPointsRef pts = VectorPoints::createPoints();
+        for (auto &poly : polys)
+            for (auto &ring : poly)
+                pts->pts.insert(pts->pts.end(),ring.begin(),ring.end());
+        pts->initGeoMbr();
+        shapes.insert(pts);
+    }
+    else if (type == "LineString" || type == "MultiLineString")
+    {
+        for (auto &poly : polys)
+            for (auto &ring : poly)
+            {
+                VectorLinearRef lin = VectorLinear::createLinear();
+                lin->pts = std::move(ring);
+                lin->initGeoMbr();
+                shapes.insert(lin);
+            }
+    }
+    else if (type == "Polygon" || type == "MultiPolygon")
+    {
+        for (auto &poly : polys)
+        {
+            VectorArealRef ar = VectorAreal::createAreal();
+            ar->loops = std::move(poly);
+            ar->initGeoMbr();
+            shapes.insert(ar);
+        }
+    }
+}
+
+bool GeoJSONStreamReader::readGeometry(ShapeSet &shapes,int depth)
+{
+    if (depth > MaxGeometryDepth)
+        return fail("Geometry collections nested too deeply");
+    if (!expect('{'))
+        return false;
+
+    std::string type,key;
+    Coords coords;
+    ShapeSet subShapes;
+    bool memberFirst = true, closed = false;
+    while (true)
+    {
+        if (!nextMember(memberFirst,key,closed))
+            return false;
+        if (closed)
+            break;
+
+        if (!skipSpace())
+            return fail("Unexpected end of data");
+        if (key == "type" && peek() == '"')
+        {
+            if (!readString(type))
+                return false;
+        }
+        else if (key == "coordinates" && peek() == '[')
+        {
+            if (!readCoords(coords))
+                return false;
+        }
+        else if (key == "geometries" && peek() == '[')
+        {
+            get();
+            bool elemFirst = true;
+            while (true)
+            {
+                if (!skipSpace())
+                    return fail("Unexpected end of data");
+                if (peek() == ']')
+                {
+                    get();
+                    break;
+                }
+                if (!elemFirst && !expect(','))
+                    return false;
+                elemFirst = false;
+                if (!readGeometry(subShapes,depth+1))
+                    return false;
+            }
+        }
+        else if (!skipValue())
+            return false;
+    }
+
+    if (type == "GeometryCollection")
+        shapes.insert(subShapes.begin(),subShapes.end());
+    else
+        buildShapes(type,coords,shapes);
+
+    return true;
+}
+
+bool GeoJSONStreamReader::readProperties(const MutableDictionaryRef &attrs)
+{
+    if (!expect('{'))
+        return false;
+
+    std::string key,strVal;
+    bool memberFirst = true, closed = false;
+    while (true)
+    {
+        if (!nextMember(memberFirst,key,closed))
+            return false;
+        if (closed)
+            return true;
+
+        if (!skipSpace())
+            return fail("Unexpected end of data");
+        const int c = peek();
+        if (key.empty())
+        {
+            if (!skipValue())
+                return false;
+        }
+        else if (c == '"')
+        {
+            if (!readString(strVal))
+                return false;
+            attrs->setString(key,strVal);
+        }
+        else if (c == '-' || (c >= '0' && c <= '9'))
+        {
+            double val;
+            if (!readNumber(val))
+                return false;
+            attrs->setDouble(key,val);
+        }
+        else if (c == 't')
+        {
+            if (!readLiteral("true"))
+                return false;
+            attrs->setInt(key,1);
+        }
+        else if (c == 'f')
+        {
+            if (!readLiteral("false"))
+                return false;
+            attrs->setInt(key,0);
+        }
+        else if (!skipValue())
+            return false;
+    }
+}
+
+bool GeoJSONStreamReader::readCRS()
+{
+    if (!skipSpace())
+        return fail("Unexpected end of data");
+    if (peek() != '{')
+        return skipValue();
+    get();
+
+    std::string type,name,key;
+    bool memberFirst = true, closed = false;
+    while (true)
+    {
+        if (!nextMember(memberFirst,key,closed))
+            return false;
+        if (closed)
+            break;
+
+        if (!skipSpace())
+            return fail("Unexpected end of data");
+        if (key == "type" && peek() == '"')
+        {
+            if (!readString(type))
+                return false;
+        }
+        else if (key == "properties" && peek() == '{')
+        {
+            get();
+            bool propFirst = true, propClosed = false;
+            while (true)
+            {
+                if (!nextMember(propFirst,key,propClosed))
+                    return false;
+                if (propClosed)
+                    break;
+                if (!skipSpace())
+                    return fail("Unexpected end of data");
+                if (key == "name" && peek() == '"')
+                {
+                    if (!readString(name))
+                        return false;
+                }
+                else if (!skipValue())
+                    return false;
+            }
+        }
+        else if (!skipValue())
+            return false;
+    }
+
+    if (type == "name" && !name.empty())
+        crs = name;
+
+    return true;
+}
+
+bool GeoJSONStreamReader::readFeature(ShapeSet &shapes,MutableDictionaryRef &attrs)
+{
+    if (!expect('{'))
+        return false;
+
+    std::string key;
+    bool memberFirst = true, closed = false;
+    while (true)
+    {
+        if (!nextMember(memberFirst,key,closed))
+            return false;
+        if (closed)
+            break;
+
+        if (!skipSpace())
+            return fail("Unexpected end of data");
+        if (key == "geometry" && peek() == '{')
+        {
+            if (!readGeometry(shapes))
+                return false;
+        }
+        else if (key == "properties" && peek() == '{')
+        {
+            attrs = MutableDictionaryMake();
+            if (!readProperties(attrs))
+                return false;
+        }
+        else if (!skipValue())
+            return false;
+    }
+
+    finishFeature(shapes,attrs);
+
+    return true;
+}
+
+void GeoJSONStreamReader::finishFeature(ShapeSet &shapes,MutableDictionaryRef &attrs)
+{
+    if (!attrs)
+        attrs = MutableDictionaryMake();
+    for (const auto &shape : shapes)
+        shape->setAttrDict(attrs);
+}
+
+void GeoJSONStreamReader::resetTop()
+{
+    topType.clear();
+    topCoords = Coords();
+    topShapes.clear();
+    topAttrs.reset();
+    topGeometry = false;
+    collectionFirst = true;
+}
+
+void GeoJSONStreamReader::startInFeatures()
+{
+    state = StateFeatures;
+    featuresFirst = true;
+    chunk = true;
+}
+
+bool GeoJSONStreamReader::next(ShapeSet &shapes,MutableDictionaryRef &attrs)
+{
+    shapes.clear();
+    attrs.reset();
+
+    while (true)
+    {
+        switch (state)
+        {
+            case StateStart:
+                if (!skipSpace())
+                {
+                    state = StateDone;
+                    return fail("No data");
+                }
+                if (!expect('{'))
+                {
+                    state = StateDone;
+                    return false;
+                }
+                resetTop();
+                state = assembly ? StateAssembly : StateCollection;
+                break;
+            case StateAssembly:
+            {
+                // Each member is a collection of its own, named by the key
+                bool closed = false;
+                if (!nextMember(assemblyFirst,collectionName,closed) || closed || !skipSpace())
+                {
+                    state = StateDone;
+                    return false;
+                }
+                if (peek() == '{')
+                {
+                    get();
+                    resetTop();
+                    state = StateCollection;
+                }
+                else if (!skipValue())
+                {
+                    state = StateDone;
+                    return false;
+                }
+            }
+                break;
+            case StateCollection:
+            {
+                std::string key;
+                bool closed = false, ok = true;
+                if (!nextMember(collectionFirst,key,closed))
+                {
+                    state = StateDone;
+                    return false;
+                }
+                if (closed)
+                {
+                    state = assembly ? StateAssembly : StateDone;
+
+                    // The whole thing was a single feature or geometry
+                    if (topType == "Feature")
+                    {
+                        if (!topGeometry)
+                            break;
+                        shapes = std::move(topShapes);
+                        attrs = topAttrs;
+                        finishFeature(shapes,attrs);
+                    }
+                    else if (topType == "GeometryCollection")
+                        shapes = std::move(topShapes);
+                    else
+                        buildShapes(topType,topCoords,shapes);
+                    resetTop();
+                    if (shapes.empty())
+                        break;
+                    if (!attrs)
+                        finishFeature(shapes,attrs);
+                    return true;
+                }
+
+                if (!skipSpace())
+                {
+                    state = StateDone;
+                    return fail("Unexpected end of data");
+                }
+                const int c = peek();
+                if (key == "features" && c == '[')
+                {
+                    get();
+                    featuresFirst = true;
+                    state = StateFeatures;
+                }
+                else if (key == "type" && c == '"')
+                    ok = readString(topType);
+                else if (key == "crs")
+                    ok = readCRS();
+                else if (key == "geometry" && c == '{')
+                {
+                    ok = readGeometry(topShapes);
+                    topGeometry = true;
+                }
+                else if (key == "properties" && c == '{')
+                {
+                    topAttrs = MutableDictionaryMake();
+                    ok = readProperties(topAttrs);
+                }
+                else if (key == "coordinates" && c == '[')
+                    ok = readCoords(topCoords);
+                else if (key == "geometries" && c == '[')
+                {
+                    get();
+                    bool elemFirst = true;
+                    while (ok)
+                    {
+                        if (!skipSpace())
+                            ok = fail("Unexpected end of data");
+                        else if (peek() == ']')
+                        {
+                            get();
+                            break;
+                        }
+                        else if (!elemFirst && !expect(','))
+                            ok = false;
+                        else
+                        {
+                            elemFirst = false;
+                            ok = readGeometry(topShapes);
+                        }
+                    }
+                }
+                else
+                    ok = skipValue();
+
+                if (!ok)
+                {
+                    state = StateDone;
+                    return false;
+                }
+            }
+                break;
+            case StateFeatures:
+                if (!skipSpace())
+                {
+                    state = StateDone;
+                    // A piece of the array ends with the data
+                    return chunk ? false : fail("Unexpected end of data");
+                }
+                if (peek() == ']')
+                {
+                    get();
+                    state = StateCollection;
+                    break;
+                }
+                if (!featuresFirst && !expect(','))
+                {
+                    state = StateDone;
+                    return false;
+                }
+                featuresFirst = false;
+                if (!readFeature(shapes,attrs))
+                {
+                    state = StateDone;
+                    return false;
+                }
+                // Features without a geometry don't give us anything to return
+                if (!shapes.empty())
+                    return true;
+                attrs.reset();
+                break;
+            case StateDone:
+                return false;
+        }
+    }
+}
+
+bool GeoJSONStreamReader::readParallel(const char *data,size_t len,int numThreads,const FeatureFunc &featureFunc,
+                                       std::string *error)
+{
+    std::vector<std::pair<size_t,size_t>> pieces;
+    if (numThreads <= 1 || !splitFeatures(data,len,numThreads,pieces) || pieces.size() <= 1)
+    {
+        GeoJSONStreamReader reader(data,len);
+        ShapeSet shapes;
+        MutableDictionaryRef attrs;
+        while (reader.next(shapes,attrs))
+            if (!featureFunc(shapes,attrs))
+                return true;
+        if (error)
+            *error = reader.getError();
+        return reader.getError().empty();
+    }
+
+    std::atomic<bool> stop(false);
+    std::mutex errorLock;
+    std::string firstError;
+    std::vector<std::thread> threads;
+    threads.reserve(pieces.size());
+    for (const auto &piece : pieces)
+    {
+        threads.emplace_back([&,piece]()
+        {
+            GeoJSONStreamReader reader(data + piece.first,piece.second - piece.first);
+            reader.startInFeatures();
+            ShapeSet shapes;
+            MutableDictionaryRef attrs;
+            while (!stop && reader.next(shapes,attrs))
+                if (!featureFunc(shapes,attrs))
+                    stop = true;
+            if (!reader.getError().empty())
+            {
+                stop = true;
+                std::lock_guard<std::mutex> guardLock(errorLock);
+                if (firstError.empty())
+                    firstError = reader.getError();
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    if (error)
+        *error = firstError;
+    return firstError.empty();
+}
+
+}
@@ -667,6 +667,7 @@ SimpleIdentity GeometryManager::addGeometry(std::vector<GeometryRaw *> &geom,con
     }
     
     // Work through the model instances
+    SelectionBatch selectBatch;
     for (unsigned int ii=0;ii<instances.size();ii++)
     {
         const GeometryInstance *inst = instances[ii];
@@ -705,10 +706,12 @@ SimpleIdentity GeometryManager::addGeometry(std::vector<GeometryRaw *> &geom,con
         // Add a selection box for each instance
         if (inst->selectable)
         {
-            selectManager->addPolytopeFromBox(inst->getId(), ll, ur, inst->mat, geomInfo.minVis, geomInfo.maxVis, geomInfo.enable);
+            selectBatch.addPolytopeFromBox(inst->getId(), ll, ur, inst->mat, geomInfo.minVis, geomInfo.maxVis, geomInfo.enable);
             sceneRep->selectIDs.insert(inst->getId());
         }
     }
+    if (selectManager)
+        selectManager->addSelectables(selectBatch);
     
     SimpleIdentity geomID = sceneRep->getId();
     
@@ -832,6 +835,7 @@ SimpleIdentity GeometryManager::addGeometryInstances(SimpleIdentity baseGeomID,c
     
     // Work through the model instances
     std::vector<BasicDrawableInstance::SingleInstance> singleInsts;
+    SelectionBatch selectBatch;
     for (unsigned int ii=0;ii<instances.size();ii++)
     {
         const GeometryInstance &inst = instances[ii];
@@ -859,12 +863,14 @@ SimpleIdentity GeometryManager::addGeometryInstances(SimpleIdentity baseGeomID,c
         if (inst.selectable)
         {
             if (hasMotion)
-                selectManager->addMovingPolytopeFromBox(inst.getId(), baseSceneRep->ll, baseSceneRep->ur, inst.center, inst.endCenter, startTime, inst.duration, inst.mat, geomInfo.minVis, geomInfo.maxVis, geomInfo.enable);
+                selectBatch.addMovingPolytopeFromBox(inst.getId(), baseSceneRep->ll, baseSceneRep->ur, inst.center, inst.endCenter, startTime, inst.duration, inst.mat, geomInfo.minVis, geomInfo.maxVis, geomInfo.enable);
             else
-                selectManager->addPolytopeFromBox(inst.getId(), baseSceneRep->ll, baseSceneRep->ur, inst.mat, geomInfo.minVis, geomInfo.maxVis, geomInfo.enable);
+                selectBatch.addPolytopeFromBox(inst.getId(), baseSceneRep->ll, baseSceneRep->ur, inst.mat, geomInfo.minVis, geomInfo.maxVis, geomInfo.enable);
             sceneRep->selectIDs.insert(inst.getId());
         }
     }
+    if (selectManager)
+        selectManager->addSelectables(selectBatch);
 
     // Instance each of the drawables in the base
     for (SimpleIdentity baseDrawID : baseSceneRep->drawIDs)
@@ -891,6 +897,37 @@ SimpleIdentity GeometryManager::addGeometryInstances(SimpleIdentity baseGeomID,c
     return geomID;
 }
 
+void GeometryManager::changeGeometryInstances(SimpleIdentity geomID,unsigned int startInst,const std::vector<GeometryInstance> &instances,ChangeSet &changes)
+{
+    if (instances.empty())
+        return;
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    GeomSceneRep dummyRep(geomID);
+    const auto it = sceneReps.find(&dummyRep);
+    if (it == sceneReps.end())
+        return;
+
+    std::vector<BasicDrawableInstance::SingleInstance> singleInsts;
+    singleInsts.reserve(instances.size());
+    for (const GeometryInstance &inst : instances)
+    {
+        BasicDrawableInstance::SingleInstance singleInst;
+        singleInst.colorOverride = inst.colorOverride;
+        singleInst.color = inst.color;
+        singleInst.center = inst.center;
+        singleInst.mat = inst.mat;
+        singleInst.endCenter = inst.endCenter;
+        singleInst.duration = inst.duration;
+        singleInsts.push_back(singleInst);
+    }
+
+    // Each of the base drawables has its own copy of the instances
+    for (SimpleIdentity drawID : (*it)->drawIDs)
+        changes.push_back(new InstancesChangeRequest(drawID,startInst,singleInsts));
+}
+
 SimpleIdentity GeometryManager::addGPUGeomInstance(SimpleIdentity baseGeomID,SimpleIdentity programID,SimpleIdentity texSourceID,SimpleIdentity srcProgramID,GeometryInfo &geomInfo,ChangeSet &changes)
 {
     std::lock_guard<std::mutex> guardLock(lock);
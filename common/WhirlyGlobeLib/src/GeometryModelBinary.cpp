@@ -0,0 +1,479 @@
+/*  GeometryModelBinary.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <cmath>
+#import <cstdio>
+#import <cstring>
+#import <algorithm>
+#import <sys/stat.h>
+#import "GeometryModelBinary.h"
+#import "GeometryOBJReader.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    const char FileMagic[4] = { 'W', 'K', 'G', 'M' };
+    const int FileVersion = 1;
+
+    // What's in each vertex, beyond the position and color
+    const int HasNorms = 1 << 0;
+    const int HasTexCoords = 1 << 1;
+
+    // Position as doubles, like GeometryRaw, then the normal, color and tex coords
+    const size_t PosSize = 3 * sizeof(double);
+    const size_t NormSize = 3 * sizeof(float);
+    const size_t ColorSize = 4;
+    const size_t TexCoordSize = 2 * sizeof(float);
+
+    // Forsyth's tuning, which holds up well on most hardware
+    const int CacheSize = 32;
+    const float CacheDecayPower = 1.5f;
+    const float LastTriScore = 0.75f;
+    const float ValenceBoostScale = 2.0f;
+    const float ValenceBoostPower = 0.5f;
+
+    float vertexScore(int cachePos,int remaining)
+    {
+        if (remaining <= 0)
+        {
+            // Nothing left to draw with it
+            return -1.0f;
+        }
+
+        float score = 0.0f;
+        if (cachePos >= 0)
+        {
+            // The last triangle's vertices get a fixed score, so we don't just strip along
+            score = (cachePos < 3) ? LastTriScore :
+                    std::pow(1.0f - (float)(cachePos - 3) / (float)(CacheSize - 3),CacheDecayPower);
+        }
+        // Finish off vertices with only a few triangles left, rather than leave them for later
+        score += ValenceBoostScale * std::pow((float)remaining,-ValenceBoostPower);
+        return score;
+    }
+
+    bool sourceInfo(const std::string &srcPath,int64_t &size,int64_t &modTime)
+    {
+        struct stat srcStat;
+        if (stat(srcPath.c_str(),&srcStat) != 0)
+            return false;
+        size = (int64_t)srcStat.st_size;
+        modTime = (int64_t)srcStat.st_mtime;
+        return true;
+    }
+
+    // MutableRawData pads its strings, so we keep the length as is
+    void addName(MutableRawData &data,const std::string &str)
+    {
+        data.addInt((int)str.size());
+        data.addBytes(str.data(),str.size());
+    }
+
+    bool getName(RawDataReader &reader,std::string &str)
+    {
+        int len = 0;
+        if (!reader.getInt(len) || len < 0)
+            return false;
+        const unsigned char *bytes = reader.skipBytes(len);
+        if (!bytes)
+            return false;
+        str.assign((const char *)bytes,len);
+        return true;
+    }
+}
+
+RawDataRef GeometryModelBinary::encode(const std::string &srcPath,
+                                       const std::vector<std::string> &textures,
+                                       const std::vector<GeometryRaw> &rawGeom)
+{
+    int64_t srcSize = 0, srcTime = 0;
+    if (!sourceInfo(srcPath,srcSize,srcTime))
+        return RawDataRef();
+
+    auto data = std::make_shared<MutableRawData>();
+    data->addBytes(FileMagic,4);
+    data->addInt(FileVersion);
+    addName(*data,srcPath);
+    data->addInt64(srcSize);
+    data->addInt64(srcTime);
+
+    data->addInt((int)textures.size());
+    for (const auto &tex : textures)
+        addName(*data,tex);
+
+    data->addInt((int)rawGeom.size());
+    std::vector<unsigned char> verts;
+    std::vector<uint32_t> indices;
+    for (const auto &geom : rawGeom)
+    {
+        const size_t numPts = geom.pts.size();
+        const bool hasNorms = numPts && geom.norms.size() == numPts;
+        const bool hasTexCoords = numPts && geom.texCoords.size() == numPts;
+        const bool hasColors = geom.colors.size() == numPts;
+        const int flags = (hasNorms ? HasNorms : 0) | (hasTexCoords ? HasTexCoords : 0);
+
+        data->addInt(geom.type);
+        data->addInt(flags);
+        data->addInt((int)numPts);
+        data->addInt((int)geom.triangles.size());
+        data->addInt((int)geom.texIDs.size());
+        for (const auto texID : geom.texIDs)
+            data->addInt64((int64_t)texID);
+
+        // Vertices are interleaved, so this is one pass on the way back in
+        const size_t vertSize = PosSize + (hasNorms ? NormSize : 0) + ColorSize + (hasTexCoords ? TexCoordSize : 0);
+        verts.resize(vertSize * numPts);
+        unsigned char *ptr = verts.data();
+        for (size_t ii=0;ii<numPts;ii++)
+        {
+            memcpy(ptr,geom.pts[ii].data(),PosSize);
+            ptr += PosSize;
+            if (hasNorms)
+            {
+                const Point3f norm = geom.norms[ii].cast<float>();
+                memcpy(ptr,norm.data(),NormSize);
+                ptr += NormSize;
+            }
+            const RGBAColor color = hasColors ? geom.colors[ii] : RGBAColor::white();
+            ptr[0] = color.r;  ptr[1] = color.g;  ptr[2] = color.b;  ptr[3] = color.a;
+            ptr += ColorSize;
+            if (hasTexCoords)
+            {
+                memcpy(ptr,geom.texCoords[ii].data(),TexCoordSize);
+                ptr += TexCoordSize;
+            }
+        }
+        data->addBytes(verts.data(),verts.size());
+
+        indices.resize(3 * geom.triangles.size());
+        for (size_t ii=0;ii<geom.triangles.size();ii++)
+            for (unsigned int jj=0;jj<3;jj++)
+                indices[3*ii+jj] = (uint32_t)geom.triangles[ii].verts[jj];
+        data->addBytes(indices.data(),indices.size() * sizeof(uint32_t));
+    }
+
+    return data;
+}
+
+bool GeometryModelBinary::decode(const RawData &data,const std::string &srcPath,
+                                 std::vector<std::string> &textures,
+                                 std::vector<GeometryRaw> &rawGeom)
+{
+    RawDataReader reader(&data);
+
+    // Make sure it's ours and still matches the source
+    const unsigned char *magic = reader.skipBytes(4);
+    int version = 0;
+    std::string path;
+    int64_t srcSize = 0, srcTime = 0, fileSize = 0, fileTime = 0;
+    if (!magic || memcmp(magic,FileMagic,4) != 0 ||
+        !reader.getInt(version) || version != FileVersion ||
+        !getName(reader,path) || path != srcPath ||
+        !reader.getInt64(fileSize) || !reader.getInt64(fileTime) ||
+        !sourceInfo(srcPath,srcSize,srcTime) || srcSize != fileSize || srcTime != fileTime)
+        return false;
+
+    int numTextures = 0;
+    if (!reader.getInt(numTextures) || numTextures < 0)
+        return false;
+    std::vector<std::string> newTextures(numTextures);
+    for (auto &tex : newTextures)
+        if (!getName(reader,tex))
+            return false;
+
+    int numGeom = 0;
+    if (!reader.getInt(numGeom) || numGeom < 0)
+        return false;
+    std::vector<GeometryRaw> newGeom(numGeom);
+    for (auto &geom : newGeom)
+    {
+        int type = 0, flags = 0, numPts = 0, numTris = 0, numTexIDs = 0;
+        if (!reader.getInt(type) || !reader.getInt(flags) ||
+            !reader.getInt(numPts) || !reader.getInt(numTris) || !reader.getInt(numTexIDs) ||
+            numPts < 0 || numTris < 0 || numTexIDs < 0 ||
+            (type != WhirlyKitGeometryLines && type != WhirlyKitGeometryTriangles))
+            return false;
+        geom.type = (WhirlyKitGeometryRawType)type;
+
+        geom.texIDs.resize(numTexIDs);
+        for (auto &texID : geom.texIDs)
+        {
+            int64_t val = 0;
+            if (!reader.getInt64(val))
+                return false;
+            texID = (SimpleIdentity)val;
+        }
+
+        const bool hasNorms = flags & HasNorms;
+        const bool hasTexCoords = flags & HasTexCoords;
+        const size_t vertSize = PosSize + (hasNorms ? NormSize : 0) + ColorSize + (hasTexCoords ? TexCoordSize : 0);
+        const unsigned char *ptr = reader.skipBytes(vertSize * numPts);
+        const unsigned char *indices = reader.skipBytes(3 * sizeof(uint32_t) * numTris);
+        if (!ptr || !indices)
+            return false;
+
+        geom.pts.resize(numPts);
+        geom.colors.resize(numPts);
+        if (hasNorms)
+            geom.norms.resize(numPts);
+        if (hasTexCoords)
+            geom.texCoords.resize(numPts);
+        for (int ii=0;ii<numPts;ii++)
+        {
+            memcpy(geom.pts[ii].data(),ptr,PosSize);
+            ptr += PosSize;
+            if (hasNorms)
+            {
+                Point3f norm;
+                memcpy(norm.data(),ptr,NormSize);
+                geom.norms[ii] = norm.cast<double>();
+                ptr += NormSize;
+            }
+            geom.colors[ii] = RGBAColor(ptr[0],ptr[1],ptr[2],ptr[3]);
+            ptr += ColorSize;
+            if (hasTexCoords)
+            {
+                memcpy(geom.texCoords[ii].data(),ptr,TexCoordSize);
+                ptr += TexCoordSize;
+            }
+        }
+
+        geom.triangles.resize(numTris);
+        for (int ii=0;ii<numTris;ii++)
+        {
+            uint32_t tri[3];
+            memcpy(tri,indices + ii * sizeof(tri),sizeof(tri));
+            for (unsigned int jj=0;jj<3;jj++)
+            {
+                if (tri[jj] >= (uint32_t)numPts)
+                    return false;
+                geom.triangles[ii].verts[jj] = (int)tri[jj];
+            }
+        }
+    }
+
+    textures = std::move(newTextures);
+    rawGeom = std::move(newGeom);
+    return true;
+}
+
+bool GeometryModelBinary::readOBJ(const std::string &objPath,const std::string &resourceDir,
+                                  const std::string &cachePath,
+                                  std::vector<std::string> &textures,
+                                  std::vector<GeometryRaw> &rawGeom)
+{
+    if (!cachePath.empty())
+    {
+        if (RawDataRef data = RawDataFromMappedFile(cachePath))
+        {
+            if (decode(*data,objPath,textures,rawGeom))
+                return true;
+        }
+    }
+
+    GeometryModelOBJ objModel;
+    objModel.setResourceDir(resourceDir);
+    bool parsed = false;
+    if (const auto objData = RawDataMapped::mapFile(objPath,RawDataMapped::AccessSequential))
+    {
+        parsed = objModel.parse(*objData);
+    }
+    else
+    {
+        // Empty files don't map
+        FILE *fp = fopen(objPath.c_str(),"r");
+        if (!fp)
+            return false;
+        parsed = objModel.parse(fp);
+        fclose(fp);
+    }
+    if (!parsed)
+        return false;
+
+    textures.clear();
+    rawGeom.clear();
+    objModel.toRawGeometry(textures,rawGeom);
+    for (auto &geom : rawGeom)
+        optimizeVertexCache(geom);
+
+    if (cachePath.empty())
+        return true;
+
+    // Write it off to the side and move it in, so nobody maps a partial file
+    const RawDataRef data = encode(objPath,textures,rawGeom);
+    const std::string tmpPath = cachePath + ".tmp";
+    FILE *outFP = data ? fopen(tmpPath.c_str(),"wb") : nullptr;
+    if (!outFP)
+    {
+        wkLogLevel(Warn,"GeometryModelBinary: Can't write to %s",cachePath.c_str());
+        return true;
+    }
+    const bool written = fwrite(data->getRawData(),1,data->getLen(),outFP) == data->getLen();
+    if (fclose(outFP) != 0 || !written || rename(tmpPath.c_str(),cachePath.c_str()) != 0)
+    {
+        wkLogLevel(Warn,"GeometryModelBinary: Failed to write %s",cachePath.c_str());
+        remove(tmpPath.c_str());
+    }
+
+    return true;
+}
+
+void GeometryModelBinary::optimizeVertexCache(GeometryRaw &geom)
+{
+    const int numPts = (int)geom.pts.size();
+    const int numTris = (int)geom.triangles.size();
+    if (geom.type != WhirlyKitGeometryTriangles || numTris == 0)
+        return;
+    for (const auto &tri : geom.triangles)
+        for (unsigned int jj=0;jj<3;jj++)
+            if (tri.verts[jj] < 0 || tri.verts[jj] >= numPts)
+                return;
+
+    // Triangles using each vertex, with the ones not drawn yet at the front of each run
+    std::vector<int> triStart(numPts + 1,0);
+    for (const auto &tri : geom.triangles)
+        for (unsigned int jj=0;jj<3;jj++)
+            triStart[tri.verts[jj] + 1]++;
+    for (int ii=0;ii<numPts;ii++)
+        triStart[ii+1] += triStart[ii];
+    std::vector<int> triList(3 * numTris);
+    std::vector<int> remaining(numPts,0);
+    for (int ii=0;ii<numTris;ii++)
+        for (unsigned int jj=0;jj<3;jj++)
+        {
+            const int vert = geom.triangles[ii].verts[jj];
+            triList[triStart[vert] + remaining[vert]++] = ii;
+        }
+
+    std::vector<int> cachePos(numPts,-1);
+    std::vector<float> vertScores(numPts);
+    for (int ii=0;ii<numPts;ii++)
+        vertScores[ii] = vertexScore(-1,remaining[ii]);
+
+    std::vector<float> triScores(numTris);
+    std::vector<char> emitted(numTris,0);
+    int bestTri = 0;
+    for (int ii=0;ii<numTris;ii++)
+    {
+        const auto &verts = geom.triangles[ii].verts;
+        triScores[ii] = vertScores[verts[0]] + vertScores[verts[1]] + vertScores[verts[2]];
+        if (triScores[ii] > triScores[bestTri])
+            bestTri = ii;
+    }
+
+    std::vector<GeometryRaw::RawTriangle> newTris;
+    newTris.reserve(numTris);
+    std::vector<int> cache,newCache;
+    cache.reserve(CacheSize + 3);
+    newCache.reserve(CacheSize + 3);
+    int scanPos = 0;
+    while ((int)newTris.size() < numTris)
+    {
+        // Nothing in the cache has triangles left, so start somewhere new
+        if (bestTri < 0)
+        {
+            while (emitted[scanPos])
+                scanPos++;
+            bestTri = scanPos;
+        }
+
+        const GeometryRaw::RawTriangle tri = geom.triangles[bestTri];
+        emitted[bestTri] = 1;
+        newTris.push_back(tri);
+
+        // Move it out of the undrawn part of each vertex's list
+        for (unsigned int jj=0;jj<3;jj++)
+        {
+            const int vert = tri.verts[jj];
+            const auto begin = triList.begin() + triStart[vert];
+            const auto end = begin + remaining[vert];
+            std::iter_swap(std::find(begin,end,bestTri),end - 1);
+            remaining[vert]--;
+        }
+
+        // This triangle's vertices go to the front of the cache
+        newCache.assign(tri.verts,tri.verts + 3);
+        for (const int vert : cache)
+            if (vert != tri.verts[0] && vert != tri.verts[1] && vert != tri.verts[2])
+                newCache.push_back(vert);
+
+        // Rescore everything that moved, including what just fell out
+        for (int ii=0;ii<(int)newCache.size();ii++)
+        {
+            const int vert = newCache[ii];
+            cachePos[vert] = (ii < CacheSize) ? ii : -1;
+            vertScores[vert] = vertexScore(cachePos[vert],remaining[vert]);
+        }
+
+        // The next triangle is the best one touching the cache
+        bestTri = -1;
+        float bestScore = -1.0f;
+        for (const int vert : newCache)
+        {
+            for (int ii=triStart[vert];ii<triStart[vert]+remaining[vert];ii++)
+            {
+                const int which = triList[ii];
+                const auto &verts = geom.triangles[which].verts;
+                triScores[which] = vertScores[verts[0]] + vertScores[verts[1]] + vertScores[verts[2]];
+                if (triScores[which] > bestScore)
+                {
+                    bestScore = triScores[which];
+                    bestTri = which;
+                }
+            }
+        }
+
+        if (newCache.size() > CacheSize)
+            newCache.resize(CacheSize);
+        cache.swap(newCache);
+    }
+
+    // Now put the vertices in the order they're first used, which helps the pre-transform cache
+    std::vector<int> remap(numPts,-1);
+    int numUsed = 0;
+    for (auto &newTri : newTris)
+        for (unsigned int jj=0;jj<3;jj++)
+        {
+            int &vert = newTri.verts[jj];
+            if (remap[vert] < 0)
+                remap[vert] = numUsed++;
+            vert = remap[vert];
+        }
+    // Anything not used by a triangle goes on the end
+    for (int ii=0;ii<numPts;ii++)
+        if (remap[ii] < 0)
+            remap[ii] = numUsed++;
+
+    geom.triangles = std::move(newTris);
+    const auto reorder = [&remap,numPts](auto &vals)
+    {
+        if ((int)vals.size() != numPts)
+            return;
+        auto newVals = vals;
+        for (int ii=0;ii<numPts;ii++)
+            newVals[remap[ii]] = vals[ii];
+        vals.swap(newVals);
+    };
+    reorder(geom.pts);
+    reorder(geom.norms);
+    reorder(geom.texCoords);
+    reorder(geom.colors);
+}
+
+}
@@ -19,10 +19,40 @@
  */
 
 #import <stdio.h>
+#import <cstring>
 #import "GeometryOBJReader.h"
 
 namespace WhirlyKit
 {
+
+// Hands out lines the way fgets does, whether from a file or memory
+class GeometryModelOBJ::LineReader
+{
+public:
+    LineReader(FILE *fp) : fp(fp) { }
+    LineReader(const RawData &data) : ptr(data.getRawData()), end(data.getRawData() + data.getLen()) { }
+
+    // Copy the next line, newline included, as much as fits in size-1 bytes
+    bool next(char *buf,int size)
+    {
+        if (fp)
+            return fgets(buf, size, fp) != nullptr;
+
+        if (ptr >= end || size <= 1)
+            return false;
+        const size_t maxLen = std::min((size_t)(end - ptr),(size_t)size - 1);
+        const auto *eol = (const unsigned char *)memchr(ptr, '\n', maxLen);
+        const size_t lineLen = eol ? (size_t)(eol - ptr) + 1 : maxLen;
+        memcpy(buf, ptr, lineLen);
+        buf[lineLen] = 0;
+        ptr += lineLen;
+        return true;
+    }
+
+protected:
+    FILE *fp = nullptr;
+    const unsigned char *ptr = nullptr, *end = nullptr;
+};
     
 void GeometryModelOBJ::setResourceDir(const std::string &inResourceDir)
 {
@@ -30,6 +60,19 @@ void GeometryModelOBJ::setResourceDir(const std::string &inResourceDir)
 }
     
 bool GeometryModelOBJ::parseMaterials(FILE *fp)
+{
+    LineReader reader(fp);
+    return parseMaterials(reader);
+}
+
+bool GeometryModelOBJ::parseMaterials(const RawData &data)
+{
+    data.willRead();
+    LineReader reader(data);
+    return parseMaterials(reader);
+}
+
+bool GeometryModelOBJ::parseMaterials(LineReader &reader)
 {
     bool success = true;
     Material *activeMtl = NULL;
@@ -37,7 +80,7 @@ bool GeometryModelOBJ::parseMaterials(FILE *fp)
     char line[2048];
     int lineNo = 0;
     
-    while (fgets(line, 2047, fp))
+    while (reader.next(line, 2047))
     {
         lineNo++;
         int lineLen = (int)strlen(line);
@@ -168,6 +211,19 @@ bool GeometryModelOBJ::parseMaterials(FILE *fp)
 }
 
 bool GeometryModelOBJ::parse(FILE *fp)
+{
+    LineReader reader(fp);
+    return parse(reader);
+}
+
+bool GeometryModelOBJ::parse(const RawData &data)
+{
+    data.willRead();
+    LineReader reader(data);
+    return parse(reader);
+}
+
+bool GeometryModelOBJ::parse(LineReader &reader)
 {
     bool success = true;
     Group *activeGroup = NULL;
@@ -176,7 +232,7 @@ bool GeometryModelOBJ::parse(FILE *fp)
     char line[2048],origLine[2048],tmpTok[2048];
     int lineNo = 0;
     
-    while (fgets(origLine, 2047, fp))
+    while (reader.next(origLine, 2047))
     {
         lineNo++;
         strcpy(line,origLine);
@@ -231,18 +287,25 @@ bool GeometryModelOBJ::parse(FILE *fp)
             
             // Load the model
             std::string fullPath = resourceDir.empty() ? mtlFile : resourceDir + "/" + mtlFile;
-            FILE *mtlFP = fopen(fullPath.c_str(),"r");
-            if (!mtlFP)
+            bool mtlParsed = false;
+            if (const auto mtlData = RawDataMapped::mapFile(fullPath,RawDataMapped::AccessSequential))
             {
-                success = false;
-                break;
+                mtlParsed = parseMaterials(*mtlData);
+            } else {
+                FILE *mtlFP = fopen(fullPath.c_str(),"r");
+                if (!mtlFP)
+                {
+                    success = false;
+                    break;
+                }
+                mtlParsed = parseMaterials(mtlFP);
+                fclose(mtlFP);
             }
-            if (!parseMaterials(mtlFP))
+            if (!mtlParsed)
             {
                 success = false;
                 break;
             }
-            fclose(mtlFP);
         } else if (!strcmp(key,"usemtl"))
         {
             // Use a pre-defined material
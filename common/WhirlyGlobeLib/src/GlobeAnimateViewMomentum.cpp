@@ -83,6 +83,18 @@ Quaterniond AnimateViewMomentum::rotForTime(GlobeView *globeView,TimeInterval si
     return newQuat;
 }
 
+bool AnimateViewMomentum::predictView(WhirlyKit::View *view,TimeInterval ahead)
+{
+    auto globeView = (GlobeView *)view;
+    if (startDate == 0.0)
+        return false;
+
+    const double sinceStart = std::min(TimeGetCurrent() - startDate + ahead,(double)maxTime);
+    globeView->setRotQuat(rotForTime(globeView,sinceStart),false);
+
+    return true;
+}
+
 // Called by the view when it's time to update
 void AnimateViewMomentum::updateView(WhirlyKit::View *view)
 {
@@ -17,6 +17,7 @@
  */
 
 
+#import <algorithm>
 #import "GlobeMath.h"
 #import "FlatMath.h"
 #import "proj_api.h"
@@ -83,6 +84,41 @@ Point3d GeoCoordSystem::GeocentricToLocal(Point3d geocPt)
     return Point3d(x,y,z);
 }
 
+void GeoCoordSystem::LocalToGeocentric(const Point3d *local,Point3d *geoc,size_t count)
+{
+    if (count == 0)
+        return;
+    InitProj4();
+
+    if (local != geoc)
+        std::copy(local,local+count,geoc);
+    // A run of Point3d is just packed doubles, which Proj can step through in place
+    pj_transform(pj_latlon, pj_geocentric, (long)count, 3, &geoc->x(), &geoc->y(), &geoc->z());
+}
+
+void GeoCoordSystem::GeocentricToLocal(const Point3d *geoc,Point3d *local,size_t count)
+{
+    if (count == 0)
+        return;
+    InitProj4();
+
+    if (geoc != local)
+        std::copy(geoc,geoc+count,local);
+    pj_transform(pj_geocentric, pj_latlon, (long)count, 3, &local->x(), &local->y(), &local->z());
+}
+
+void GeoCoordSystem::geographicToLocalBatch(const Point2d *geo,Point3d *local,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        local[ii] = Point3d(geo[ii].x(),geo[ii].y(),0.0);
+}
+
+void GeoCoordSystem::localToGeographicBatch(const Point3d *local,Point2d *geo,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        geo[ii] = Point2d(local[ii].x(),local[ii].y());
+}
+
 Mbr GeoCoordSystem::GeographicMbrToLocal(GeoMbr geoMbr)
 {
     Mbr localMbr;
@@ -125,6 +161,12 @@ Point3d FakeGeocentricDisplayAdapter::LocalToDisplay(Point3d geoPt)
     return pt;
 }
 
+void FakeGeocentricDisplayAdapter::localToDisplayBatch(const Point3d *local,Point3d *disp,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        disp[ii] = LocalToDisplay(local[ii]);
+}
+
 Point3f FakeGeocentricDisplayAdapter::DisplayToLocal(Point3f pt)
 {
     pt.normalize();
@@ -166,6 +208,13 @@ Point3d GeocentricDisplayAdapter::LocalToDisplay(Point3d geoPt)
     return Point3d(geoCpt.x()/EarthRadius,geoCpt.y()/EarthRadius,geoCpt.z()/EarthRadius);
 }
 
+void GeocentricDisplayAdapter::localToDisplayBatch(const Point3d *local,Point3d *disp,size_t count) const
+{
+    GeoCoordSystem::LocalToGeocentric(local,disp,count);
+    for (size_t ii=0;ii<count;ii++)
+        disp[ii] /= EarthRadius;
+}
+
 Point3f GeocentricDisplayAdapter::DisplayToLocal(Point3f pt)
 {
     const Point3f geoCpt = pt * EarthRadius;
@@ -178,6 +227,83 @@ Point3d GeocentricDisplayAdapter::DisplayToLocal(Point3d pt)
     return GeoCoordSystem::GeocentricToLocal(geoCpt);
 }
 
+HorizonBound::HorizonBound(const Point3d *pts,size_t numPts,double extraHeight)
+{
+    Point3d sum(0,0,0);
+    double maxRad = 1.0;
+    for (size_t ii=0;ii<numPts;ii++)
+    {
+        const double rad = pts[ii].norm();
+        if (rad > 0.0)
+            sum += pts[ii] / rad;
+        maxRad = std::max(maxRad,rad);
+    }
+    const double sumLen = sum.norm();
+    if (sumLen <= 0.0)
+        return;
+    const Point3d dir = sum / sumLen;
+
+    // Widest angle out from the middle, then as far again as the top can be seen past the horizon
+    double minCos = 1.0;
+    for (size_t ii=0;ii<numPts;ii++)
+    {
+        const double rad = pts[ii].norm();
+        if (rad > 0.0)
+            minCos = std::min(minCos,dir.dot(pts[ii]) / rad);
+    }
+    const double spread = std::acos(std::max(-1.0,std::min(1.0,minCos))) + std::acos(1.0 / (maxRad + extraHeight));
+    if (spread >= M_PI)
+        return;
+
+    axis = dir.cast<float>();
+    cosSpread = (float)std::cos(spread);
+    sinSpread = (float)std::sin(spread);
+    valid = true;
+}
+
+HorizonCuller::HorizonCuller(const Point3d &eyePos)
+{
+    const double dist = eyePos.norm();
+    if (dist <= 1.0)
+        return;
+
+    eyeDir = eyePos / dist;
+    cosHorizon = 1.0 / dist;
+    sinHorizon = std::sqrt(1.0 - cosHorizon * cosHorizon);
+    enabled = true;
+}
+
+bool HorizonCuller::isHidden(const HorizonBound &bound) const
+{
+    if (!enabled || !bound.valid)
+        return false;
+
+    // Past half way round, it can always be seen
+    if (bound.cosSpread <= -cosHorizon)
+        return false;
+
+    // Hidden if the axis is further from the eye than the horizon and the spread together
+    const double cosLimit = cosHorizon * bound.cosSpread - sinHorizon * bound.sinSpread;
+    return eyeDir.dot(bound.axis.cast<double>()) < cosLimit;
+}
+
+bool HorizonCuller::isHidden(const Point3d &pt) const
+{
+    if (!enabled)
+        return false;
+
+    const double rad = pt.norm();
+    if (rad <= 1.0)
+    {
+        // On (or under) the surface it's hidden once it's past the horizon
+        return rad > 0.0 && eyeDir.dot(pt) < cosHorizon * rad;
+    }
+
+    // Up off the surface it can be seen a little further round
+    const double cosUp = 1.0 / rad, sinUp = std::sqrt(1.0 - cosUp * cosUp);
+    return eyeDir.dot(pt) < (cosHorizon * cosUp - sinHorizon * sinUp) * rad;
+}
+
 float CheckPointAndNormFacing(const Point3f &dispLoc,const Point3f &norm,const Matrix4f &viewAndModelMat,const Matrix4f &viewModelNormalMat)
 {
     Vector4f pt = viewAndModelMat * Vector4f(dispLoc.x(),dispLoc.y(),dispLoc.z(),1.0);
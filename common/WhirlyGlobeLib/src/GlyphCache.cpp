@@ -0,0 +1,264 @@
+/*  GlyphCache.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <cstdio>
+#import <cstring>
+#import "GlyphCache.h"
+#import "StableBytes.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    const char FileMagic[4] = { 'W', 'K', 'G', 'C' };
+    const uint32_t FileVersion = 1;
+
+    // Glyph ID, width and height, then eight floats of metrics
+    const size_t RecordHeaderSize = 4 + 2 + 2 + 8 * 4;
+    // Anything bigger than this isn't a glyph
+    const int MaxGlyphSize = 1024;
+}
+
+GlyphCache::GlyphCache(std::string dir) :
+    dir(std::move(dir))
+{
+    if (!this->dir.empty() && this->dir.back() != '/')
+    {
+        this->dir += '/';
+    }
+}
+
+GlyphCacheRef GlyphCache::getShared(const std::string &dir)
+{
+    static std::mutex sharedLock;
+    static std::unordered_map<std::string,std::weak_ptr<GlyphCache>> caches;
+
+    std::lock_guard<std::mutex> guardLock(sharedLock);
+    auto cache = caches[dir].lock();
+    if (!cache)
+    {
+        cache = std::make_shared<GlyphCache>(dir);
+        caches[dir] = cache;
+    }
+    return cache;
+}
+
+std::string GlyphCache::fontKey(const std::string &fontName,float pointSize,
+                                const RGBAColor &color,const RGBAColor &backColor,
+                                const RGBAColor &outlineColor,float outlineSize)
+{
+    char buf[128];
+    snprintf(buf,sizeof(buf),"/%.3f/%02x%02x%02x%02x/%02x%02x%02x%02x/%02x%02x%02x%02x/%.3f",
+             pointSize,
+             color.r,color.g,color.b,color.a,
+             backColor.r,backColor.g,backColor.b,backColor.a,
+             outlineColor.r,outlineColor.g,outlineColor.b,outlineColor.a,
+             outlineSize);
+    return fontName + buf;
+}
+
+bool GlyphCache::readIndex(FontFile &file,const std::string &fontKey)
+{
+    FILE *fp = fopen(file.path.c_str(),"rb");
+    if (!fp)
+    {
+        // Nothing yet, we'll start it
+        return true;
+    }
+
+    fseek(fp,0,SEEK_END);
+    const long fileSize = ftell(fp);
+    fseek(fp,0,SEEK_SET);
+    if (fileSize == 0)
+    {
+        fclose(fp);
+        return true;
+    }
+
+    // Make sure it's ours and for this font, not just one with the same hash
+    bool valid = false;
+    char magic[4];
+    uint32_t version = 0, keyLen = 0;
+    if (fread(magic,1,4,fp) == 4 && memcmp(magic,FileMagic,4) == 0 &&
+        fread(&version,sizeof(version),1,fp) == 1 && version == FileVersion &&
+        fread(&keyLen,sizeof(keyLen),1,fp) == 1 && keyLen == fontKey.size())
+    {
+        std::string key(keyLen,'\0');
+        valid = fread(&key[0],1,keyLen,fp) == keyLen && key == fontKey;
+    }
+
+    unsigned char header[RecordHeaderSize];
+    while (valid)
+    {
+        const long pos = ftell(fp);
+        if (fread(header,1,RecordHeaderSize,fp) != RecordHeaderSize)
+        {
+            break;
+        }
+        const unsigned char *ptr = header;
+        const auto glyph = GetRecordValue<uint32_t>(ptr);
+        const int width = GetRecordValue<uint16_t>(ptr);
+        const int height = GetRecordValue<uint16_t>(ptr);
+        const long dataLen = (long)width * height * 4;
+
+        // A partial record on the end means someone was interrupted, so stop there
+        if (width > MaxGlyphSize || height > MaxGlyphSize ||
+            pos + (long)RecordHeaderSize + dataLen > fileSize)
+        {
+            break;
+        }
+        file.offsets[glyph] = pos;
+        fseek(fp,dataLen,SEEK_CUR);
+    }
+
+    fclose(fp);
+
+    if (!valid)
+    {
+        wkLogLevel(Warn,"GlyphCache: Ignoring %s",file.path.c_str());
+    }
+    return valid;
+}
+
+GlyphCache::FontFile &GlyphCache::fontFile(const std::string &fontKey)
+{
+    auto it = fonts.find(fontKey);
+    if (it != fonts.end())
+    {
+        return it->second;
+    }
+
+    FontFile &file = fonts[fontKey];
+    char name[32];
+    snprintf(name,sizeof(name),"%016llx.glyphs",(unsigned long long)StableHash(fontKey));
+    file.path = dir + name;
+    file.valid = readIndex(file,fontKey);
+    return file;
+}
+
+bool GlyphCache::findGlyph(const std::string &fontKey,uint32_t glyph,Glyph &outGlyph)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    FontFile &file = fontFile(fontKey);
+    const auto it = file.offsets.find(glyph);
+    if (!file.valid || it == file.offsets.end())
+    {
+        return false;
+    }
+
+    FILE *fp = fopen(file.path.c_str(),"rb");
+    if (!fp)
+    {
+        return false;
+    }
+
+    bool found = false;
+    unsigned char header[RecordHeaderSize];
+    if (fseek(fp,it->second,SEEK_SET) == 0 &&
+        fread(header,1,RecordHeaderSize,fp) == RecordHeaderSize)
+    {
+        const unsigned char *ptr = header;
+        if (GetRecordValue<uint32_t>(ptr) == glyph)
+        {
+            outGlyph.width = GetRecordValue<uint16_t>(ptr);
+            outGlyph.height = GetRecordValue<uint16_t>(ptr);
+            outGlyph.sizeX = GetRecordValue<float>(ptr);
+            outGlyph.sizeY = GetRecordValue<float>(ptr);
+            outGlyph.glyphSizeX = GetRecordValue<float>(ptr);
+            outGlyph.glyphSizeY = GetRecordValue<float>(ptr);
+            outGlyph.offsetX = GetRecordValue<float>(ptr);
+            outGlyph.offsetY = GetRecordValue<float>(ptr);
+            outGlyph.textureOffsetX = GetRecordValue<float>(ptr);
+            outGlyph.textureOffsetY = GetRecordValue<float>(ptr);
+
+            outGlyph.pixels.resize((size_t)outGlyph.width * outGlyph.height * 4);
+            found = fread(outGlyph.pixels.data(),1,outGlyph.pixels.size(),fp) == outGlyph.pixels.size();
+        }
+    }
+    fclose(fp);
+
+    if (!found)
+    {
+        // Don't keep trying it
+        file.offsets.erase(it);
+    }
+    return found;
+}
+
+void GlyphCache::addGlyph(const std::string &fontKey,uint32_t glyph,const Glyph &inGlyph)
+{
+    if (inGlyph.width <= 0 || inGlyph.height <= 0 ||
+        inGlyph.width > MaxGlyphSize || inGlyph.height > MaxGlyphSize ||
+        inGlyph.pixels.size() != (size_t)inGlyph.width * inGlyph.height * 4)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    FontFile &file = fontFile(fontKey);
+    if (!file.valid || file.offsets.find(glyph) != file.offsets.end())
+    {
+        return;
+    }
+
+    FILE *fp = fopen(file.path.c_str(),"ab");
+    if (!fp)
+    {
+        // Probably no directory, so don't keep trying
+        wkLogLevel(Warn,"GlyphCache: Can't write to %s",file.path.c_str());
+        file.valid = false;
+        return;
+    }
+
+    // Put the whole thing together so it goes out in one write
+    std::vector<unsigned char> buf;
+    fseek(fp,0,SEEK_END);
+    if (ftell(fp) == 0)
+    {
+        buf.insert(buf.end(),FileMagic,FileMagic + 4);
+        PutRecordValue<uint32_t>(buf,FileVersion);
+        PutRecordValue<uint32_t>(buf,(uint32_t)fontKey.size());
+        buf.insert(buf.end(),fontKey.begin(),fontKey.end());
+    }
+    const size_t recordStart = buf.size();
+    buf.reserve(buf.size() + RecordHeaderSize + inGlyph.pixels.size());
+    PutRecordValue<uint32_t>(buf,glyph);
+    PutRecordValue<uint16_t>(buf,(uint16_t)inGlyph.width);
+    PutRecordValue<uint16_t>(buf,(uint16_t)inGlyph.height);
+    PutRecordValue<float>(buf,inGlyph.sizeX);
+    PutRecordValue<float>(buf,inGlyph.sizeY);
+    PutRecordValue<float>(buf,inGlyph.glyphSizeX);
+    PutRecordValue<float>(buf,inGlyph.glyphSizeY);
+    PutRecordValue<float>(buf,inGlyph.offsetX);
+    PutRecordValue<float>(buf,inGlyph.offsetY);
+    PutRecordValue<float>(buf,inGlyph.textureOffsetX);
+    PutRecordValue<float>(buf,inGlyph.textureOffsetY);
+    buf.insert(buf.end(),inGlyph.pixels.begin(),inGlyph.pixels.end());
+
+    if (fwrite(buf.data(),1,buf.size(),fp) == buf.size())
+    {
+        // Someone else may have appended in the meantime, so work back from the end
+        const long end = ftell(fp);
+        file.offsets[glyph] = end - (long)(buf.size() - recordStart);
+    }
+    fclose(fp);
+}
+
+}
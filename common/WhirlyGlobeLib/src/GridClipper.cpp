@@ -213,46 +213,122 @@ bool ClipLoopsToMbr(const std::vector<VectorRing> &rings,const Mbr &mbr, bool cl
     return true;
 }
 
-// Clip the given loop to the given grid (org and spacing)
-// Return true on success and the new polygons in the rets
-bool ClipLoopToGrid(const VectorRing &ring,Point2f org,Point2f spacing,std::vector<VectorRing> &rets)
+// Keep the part of a polygon on one side of a line along an axis.
+// Crossings are worked out the same way from either side, so neighboring cells match exactly.
+template <bool KeepAbove>
+static void ClipHalfPlane(const std::vector<Point2d> &in,int axis,double val,std::vector<Point2d> &out)
 {
-    Mbr mbr(ring);
-    int startRet = (int)(rets.size());
-    
-    int ll_ix = (int)std::floor((mbr.ll().x()-org.x())/spacing.x());
-    int ll_iy = (int)std::floor((mbr.ll().y()-org.y())/spacing.y());
-    int ur_ix = (int)std::ceil((mbr.ur().x()-org.x())/spacing.x());
-    int ur_iy = (int)std::ceil((mbr.ur().y()-org.y())/spacing.y());
-    
-    // Clip in strips from left to right
-    for (int ix=ll_ix;ix<=ur_ix;ix++)
+    out.clear();
+    if (in.empty())
+        return;
+
+    const Point2d *prev = &in.back();
+    bool prevIn = KeepAbove ? (*prev)[axis] >= val : (*prev)[axis] <= val;
+    for (const Point2d &cur : in)
     {
-        Point2f l0(ix*spacing.x()+org.x(),mbr.ll().y());
-        Point2f l1((ix+1)*spacing.x()+org.x(),mbr.ur().y());
-        Mbr left(l0,l1);
-        
-        std::vector<VectorRing> leftStrip;
-        ClipLoopToMbr(ring,left, true, leftStrip);
-        
-        // Now clip the left strip vertically
-        for (int iy=ll_iy;iy<=ur_iy;iy++)
+        const bool curIn = KeepAbove ? cur[axis] >= val : cur[axis] <= val;
+        if (curIn != prevIn)
         {
-            
-            Point2f b0(mbr.ll().x(),iy*spacing.y()+org.y());
-            Point2f b1(mbr.ur().x(),(iy+1)*spacing.y()+org.y());
-            Mbr bot(b0,b1);
-            for (unsigned int ic=0;ic<leftStrip.size();ic++)
-                ClipLoopToMbr(leftStrip[ic], bot, true, rets);
+            const Point2d &a = prevIn ? *prev : cur;
+            const Point2d &b = prevIn ? cur : *prev;
+            const double t = (val - a[axis]) / (b[axis] - a[axis]);
+            Point2d pt = a + t * (b - a);
+            pt[axis] = val;
+            out.push_back(pt);
         }
+        if (curIn)
+            out.push_back(cur);
+        prev = &cur;
+        prevIn = curIn;
     }
-    
-    for (unsigned int ii=startRet;ii<rets.size();ii++)
+}
+
+void GridClipper::clipSlab(const std::vector<Point2d> &in,int axis,double lo,double hi,std::vector<Point2d> &out)
+{
+    ClipHalfPlane<true>(in,axis,lo,half);
+    ClipHalfPlane<false>(half,axis,hi,out);
+}
+
+void GridClipper::clip(const VectorRing &ring,const Point2f &org,const Point2f &spacing,std::vector<VectorRing> &rets)
+{
+    if (ring.size() < 3 || spacing.x() <= 0.0 || spacing.y() <= 0.0)
+        return;
+
+    ringPts.clear();
+    ringPts.reserve(ring.size());
+    Point2d ll(ring[0].x(),ring[0].y()),ur = ll;
+    for (const auto &pt : ring)
     {
-        VectorRing &theRing = rets[ii];
-        std::reverse(theRing.begin(),theRing.end());
+        const Point2d pt2d(pt.x(),pt.y());
+        ringPts.push_back(pt2d);
+        ll = ll.cwiseMin(pt2d);
+        ur = ur.cwiseMax(pt2d);
     }
-    
+
+    const Point2d org2d(org.x(),org.y()),spacing2d(spacing.x(),spacing.y());
+    const int startX = (int)std::floor((ll.x()-org2d.x())/spacing2d.x());
+    const int endX = (int)std::floor((ur.x()-org2d.x())/spacing2d.x());
+
+    for (int ix=startX;ix<=endX;ix++)
+    {
+        clipSlab(ringPts,0,ix*spacing2d.x()+org2d.x(),(ix+1)*spacing2d.x()+org2d.x(),column);
+        if (column.size() < 3)
+            continue;
+
+        // Only the rows this column covers
+        double minY = column[0].y(),maxY = minY;
+        for (const auto &pt : column)
+        {
+            minY = std::min(minY,pt.y());
+            maxY = std::max(maxY,pt.y());
+        }
+        const int startY = (int)std::floor((minY-org2d.y())/spacing2d.y());
+        const int endY = (int)std::floor((maxY-org2d.y())/spacing2d.y());
+
+        for (int iy=startY;iy<=endY;iy++)
+        {
+            clipSlab(column,1,iy*spacing2d.y()+org2d.y(),(iy+1)*spacing2d.y()+org2d.y(),cell);
+            if (cell.size() < 3)
+                continue;
+
+            VectorRing outRing;
+            outRing.reserve(cell.size());
+            for (const auto &cellPt : cell)
+            {
+                const Point2f pt = cellPt.cast<float>();
+                if (outRing.empty() || outRing.back() != pt)
+                    outRing.push_back(pt);
+            }
+            if (outRing.size() > 1 && outRing.front() == outRing.back())
+                outRing.pop_back();
+            if (outRing.size() < 3)
+                continue;
+
+            // Once it's in floats, that is
+            double area = 0.0;
+            for (size_t ii=0;ii<outRing.size();ii++)
+            {
+                const Point2f &pt = outRing[ii],&next = outRing[(ii+1)%outRing.size()];
+                area += (double)pt.x()*next.y() - (double)next.x()*pt.y();
+            }
+            // Nothing but seams, or a corner the ring touched
+            if (area == 0.0)
+                continue;
+
+            if (area > 0.0)
+                std::reverse(outRing.begin(),outRing.end());
+            rets.push_back(std::move(outRing));
+        }
+    }
+}
+
+// Clip the given loop to the given grid (org and spacing)
+// Return true on success and the new polygons in the rets
+bool ClipLoopToGrid(const VectorRing &ring,Point2f org,Point2f spacing,std::vector<VectorRing> &rets)
+{
+    thread_local GridClipper clipper;
+    clipper.clip(ring,org,spacing,rets);
+
     return true;
 }
     
@@ -25,13 +25,13 @@ namespace WhirlyKit
     
 ImageTile::ImageTile()
     : borderSize(0),width(0), height(0), components(0),
-    targetWidth(0), targetHeight(0)
+    targetWidth(0), targetHeight(0), maxDecodeSize(0)
 {
 }
     
 ImageTile::ImageTile(const std::string &name)
     : borderSize(0),width(0), height(0), components(0),
-    targetWidth(0), targetHeight(0), name(name)
+    targetWidth(0), targetHeight(0), maxDecodeSize(0), name(name)
 {
 }
 
@@ -13,6 +13,10 @@ using namespace Eigen;
 namespace WhirlyKit
 {
 
+IntersectionManager::Intersectable::~Intersectable()
+{
+}
+
 IntersectionManager::IntersectionManager(Scene *scene)
 : scene(scene)
 {
@@ -25,15 +29,35 @@ IntersectionManager::~IntersectionManager()
     
 void IntersectionManager::addIntersectable(Intersectable *intersect)
 {
+    std::lock_guard<std::mutex> guardLock(lock);
     intersectables.insert(intersect);
 }
 
 /// Remove an intersectable object
 void IntersectionManager::removeIntersectable(Intersectable *intersect)
 {
+    std::lock_guard<std::mutex> guardLock(lock);
     intersectables.erase(intersect);
 }
 
+void IntersectionManager::addTriangles(SimpleIdentity objID,const Point3dVector &tris)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    triangles.add(objID,tris);
+}
+
+void IntersectionManager::removeTriangles(SimpleIdentity objID)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    triangles.remove(objID);
+}
+
+void IntersectionManager::enableTriangles(SimpleIdentity objID,bool enable)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    triangles.setEnable(objID,enable);
+}
+
 /// Look for the nearest intersection and return the point (in display coordinates)
 bool IntersectionManager::findIntersection(SceneRenderer *renderer,View *view,const Point2f &frameSize,const Point2f &touchPt,Point3d &iPt,double &dist)
 {
@@ -59,6 +83,15 @@ bool IntersectionManager::findIntersection(SceneRenderer *renderer,View *view,co
     
     std::lock_guard<std::mutex> guardLock(lock);
 
+    // Triangles we were handed directly, through the hierarchy
+    SimpleIdentity hitID = EmptyIdentity;
+    double hitT = 0.0;
+    if (triangles.size() > 0 && triangles.findClosest(org,dir,minDist,hitID,hitT))
+    {
+        minDist = hitT;
+        minPt = org + dir * hitT;
+    }
+
     for (auto inter : intersectables)
     {
         Point3d thisPt;
@@ -122,6 +122,22 @@ SimpleIdentity LabelManager::addLabels(PlatformThreadInfo *threadInfo,
             maskProgID = prog->getId();
         }
     }
+    if (sdfProgID == EmptyIdentity && fontTexManager && fontTexManager->getSDFMode())
+    {
+        const auto progID = [this](const std::string &name) {
+            const Program *prog = scene->findProgramByName(name);
+            return prog ? prog->getId() : EmptyIdentity;
+        };
+        defaultProgID = progID(MaplyScreenSpaceDefaultShader);
+        defaultMotionProgID = progID(MaplyScreenSpaceDefaultMotionShader);
+        sdfProgID = progID(MaplyScreenSpaceSDFShader);
+        // Metal has the one program for both
+        sdfMotionProgID = progID(MaplyScreenSpaceSDFMotionShader);
+        if (sdfMotionProgID == EmptyIdentity)
+        {
+            sdfMotionProgID = sdfProgID;
+        }
+    }
 
     // Set up the label renderer
     LabelRenderer labelRenderer(scene,renderer,fontTexManager,&labelInfo,maskProgID);
@@ -131,6 +147,10 @@ SimpleIdentity LabelManager::addLabels(PlatformThreadInfo *threadInfo,
     labelRenderer.scene = scene;
     labelRenderer.fontTexManager = (labelInfo.screenObject ? fontTexManager : nullptr);
     labelRenderer.scale = renderer->getScale();
+    labelRenderer.defaultProgID = defaultProgID;
+    labelRenderer.defaultMotionProgID = defaultMotionProgID;
+    labelRenderer.sdfProgID = sdfProgID;
+    labelRenderer.sdfMotionProgID = sdfMotionProgID;
    
     labelRenderer.render(threadInfo, labels, changes, cancelFn);
 
@@ -167,6 +187,7 @@ SimpleIdentity LabelManager::addLabels(PlatformThreadInfo *threadInfo,
     // Pass on selection data
     if (const auto selectManager = scene->getManager<SelectionManager>(kWKSelectionManager))
     {
+        SelectionBatch selectBatch;
         int n = 0;
         for (const auto &sel : labelRenderer.selectables2D)
         {
@@ -174,8 +195,8 @@ SimpleIdentity LabelManager::addLabels(PlatformThreadInfo *threadInfo,
             {
                 return EmptyIdentity;
             }
-            selectManager->addSelectableScreenRect(sel.selectID,sel.center,sel.pts,
-                                                   sel.minVis,sel.maxVis,sel.enable);
+            selectBatch.addSelectableScreenRect(sel.selectID,sel.center,sel.pts,
+                                                sel.minVis,sel.maxVis,sel.enable);
             labelRep->selectIDs.insert(sel.selectID);
         }
         for (const auto &sel : labelRenderer.movingSelectables2D)
@@ -184,9 +205,9 @@ SimpleIdentity LabelManager::addLabels(PlatformThreadInfo *threadInfo,
             {
                 return EmptyIdentity;
             }
-            selectManager->addSelectableMovingScreenRect(sel.selectID,sel.center,sel.endCenter,
-                                                         sel.startTime,sel.endTime,sel.pts,
-                                                         sel.minVis,sel.maxVis,sel.enable);
+            selectBatch.addSelectableMovingScreenRect(sel.selectID,sel.center,sel.endCenter,
+                                                      sel.startTime,sel.endTime,sel.pts,
+                                                      sel.minVis,sel.maxVis,sel.enable);
             labelRep->selectIDs.insert(sel.selectID);
         }
         for (const auto &sel : labelRenderer.selectables3D)
@@ -195,9 +216,10 @@ SimpleIdentity LabelManager::addLabels(PlatformThreadInfo *threadInfo,
             {
                 return EmptyIdentity;
             }
-            selectManager->addSelectableRect(sel.selectID,sel.pts,sel.minVis,sel.maxVis,sel.enable);
+            selectBatch.addSelectableRect(sel.selectID,sel.pts,sel.minVis,sel.maxVis,sel.enable);
             labelRep->selectIDs.insert(sel.selectID);
         }
+        selectManager->addSelectables(selectBatch);
     }
 
     SimpleIdentity labelID = labelRep->getId();
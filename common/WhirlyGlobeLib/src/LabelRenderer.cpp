@@ -439,6 +439,17 @@ void LabelRenderer::render(PlatformThreadInfo *threadInfo,
 
             if (labelInfo->screenObject)
             {
+                // Distance field glyphs need their own shader, but only in place of the default.
+                // Anything custom gets them as they are.
+                SimpleIdentity glyphProgID = labelInfo->programID;
+                if (drawStr->sdf && sdfProgID != EmptyIdentity && glyphProgID != EmptyIdentity)
+                {
+                    if (glyphProgID == defaultMotionProgID)
+                        glyphProgID = sdfMotionProgID;
+                    else if (glyphProgID == defaultProgID)
+                        glyphProgID = sdfProgID;
+                }
+
                 Point2d lineOff(0.0,0.0);
                 switch (labelInfo->textJustify)
                 {
@@ -461,7 +472,7 @@ void LabelRenderer::render(PlatformThreadInfo *threadInfo,
                     {
                         // Note: Ignoring the desired size in favor of the font size
                         ScreenSpaceConvexGeometry smGeom;
-                        smGeom.progID = labelInfo->programID;
+                        smGeom.progID = glyphProgID;
                         smGeom.coords.push_back(Point2d(poly.pts[1].x()+label->screenOffset.x(),poly.pts[0].y()+label->screenOffset.y() + offsetY) + soff + iconOff + justifyOff + lineOff);
                         smGeom.texCoords.emplace_back(poly.texCoords[1].u(),poly.texCoords[0].v());
                         
@@ -475,16 +475,111 @@ static const int OverlapSampleY = 60;
 // Now much around the screen we'll take into account
 static const float ScreenBuffer = 0.1;
 
+// In incremental mode, how often we evaluate everything anyway
+static const int IncrementalFullPass = 10;
+// Objects we look at to work out how the view shifted
+static const size_t IncrementalSamples = 32;
+// Past this many changed areas, just check everything
+static const size_t IncrementalMaxDirty = 256;
+// Groups of objects built into their own drawables in incremental mode.
+// Objects laid out along shapes, which get new placements every pass, have the last one to themselves.
+static const int LayoutBuckets = 16;
+// Parallel layout splits the screen up this way.  Labels are wider than they are tall,
+// so fewer columns keeps more of them off the seams.
+static const int ParallelTilesX = 2;
+static const int ParallelTilesY = 4;
+// Not worth splitting up fewer objects than this
+static const size_t ParallelMinObjects = 256;
+static const size_t ParallelChunkSize = 64;
+// An along-shape placement is reused if the view scale and rotation are within this of when it was made
+static const float ShapeReuseTolerance = 0.005;
+// Cluster hierarchies cover zoom levels 0 to this, past which objects are on their own
+static const int ClusterMaxZoom = 20;
+// Distance in pixels we measure the map scale over for the cluster hierarchy
+static const float ClusterScaleSample = 32.0;
+
+// Geographic (radians) to normalized Mercator, [0,1] with north at the top
+static Point2d geoToMercatorUnit(const Point2d &geo)
+{
+    const double sinLat = std::min(std::max(sin(geo.y()),-0.9999),0.9999);
+    return { geo.x() / (2.0*M_PI) + 0.5,
+             0.5 - 0.25 * log((1.0 + sinLat) / (1.0 - sinLat)) / M_PI };
+}
+
+static Point2d mercatorUnitToGeo(double x,double y)
+{
+    return { (x - 0.5) * 2.0*M_PI, atan(sinh(M_PI * (1.0 - 2.0*y))) };
+}
+
+static int layoutBucket(const LayoutObjectEntry &entry)
+{
+    if (!entry.obj.layoutShape.empty())
+    {
+        return LayoutBuckets - 1;
+    }
+    return (int)((entry.getId() * 0x9E3779B97F4A7C15ULL) >> 32) % (LayoutBuckets - 1);
+}
+
+void LayoutManager::setIncremental(bool enable,float moveThreshold)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    incrThreshold = moveThreshold;
+    if (incremental != enable)
+    {
+        incremental = enable;
+        incrPasses = IncrementalFullPass;
+        // The drawables are organized differently, so rebuild them all on the next pass
+        hasUpdates = true;
+        hasRemoves = true;
+    }
+}
+
+void LayoutManager::setLayoutThreads(int numThreads)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    layoutWorkers = (numThreads > 0) ? std::make_shared<WorkerPool>(numThreads) : WorkerPoolRef();
+}
+
+int LayoutManager::getLayoutThreads()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return layoutWorkers ? layoutWorkers->getNumThreads() : 0;
+}
+
+void LayoutManager::setToggleInPlace(bool enable)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    // The vertex ranges will be filled in on the next full build
+    toggleInPlace = enable;
+}
+
+void LayoutManager::setInstancing(bool enable)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    // Takes effect on the next full build
+    instancing = enable;
+}
+
 bool LayoutManager::calcScreenPt(Point2f &objPt,const LayoutObject *layoutObj,
                                  const ViewStateRef &viewState,
                                  const Mbr &screenMbr,const Point2f &frameBufferSize)
+{
+    return calcScreenPt(objPt,layoutObj->worldLoc,viewState,screenMbr,frameBufferSize);
+}
+
+bool LayoutManager::calcScreenPt(Point2f &objPt,const Point3d &worldLoc,
+                                 const ViewStateRef &viewState,
+                                 const Mbr &screenMbr,const Point2f &frameBufferSize)
 {
     // Figure out where this will land
     bool isInside = false;
     for (unsigned int offi=0;offi<viewState->viewMatrices.size();offi++)
     {
         Eigen::Matrix4d modelTrans = viewState->fullMatrices[offi];
-        Point2f thisObjPt = viewState->pointOnScreenFromDisplay(layoutObj->worldLoc,&modelTrans,frameBufferSize);
+        Point2f thisObjPt = viewState->pointOnScreenFromDisplay(worldLoc,&modelTrans,frameBufferSize);
         if (screenMbr.inside(Point2f(thisObjPt.x(),thisObjPt.y())))
         {
             isInside = true;
@@ -613,6 +708,404 @@ static Point2d offsetForOrientation(unsigned orient, const Point2d &span)
     }
 }
 
+void LayoutManager::syncMergedObject(const LayoutObjectEntryRef &layoutObj,bool &isActive,
+                                     MergeMap &mergeMap,bool &hadChanges)
+{
+    if (!layoutObj->obj.mergeID.empty())
+    {
+        // Consider the objects we've already seen with the same merge ID
+        const auto range = mergeMap.equal_range(layoutObj->obj.mergeID);
+        for (auto ii = range.first; ii != range.second; ++ii)
+        {
+            auto &prevObj = *ii->second;
+            if (isActive && !prevObj.newEnable)
+            {
+                // That object was disabled, we need to disable this one to match.
+                isActive = false;
+                layoutObj->newEnable = false;
+                // we can stop looking
+                break;
+            }
+            else if (!isActive && prevObj.newEnable)
+            {
+                // That object was enabled, we need to disable it to match this one.
+                // This might actually undo the change leaving us with no changes, but we
+                // can't easily detect that.
+                prevObj.newEnable = false;
+                layoutObj->changed = true;
+                hadChanges = true;
+            }
+        }
+        // If this one is still enabled, or is the first disabled
+        // item of its ID that we've seen, we need to keep track of it.
+        if (layoutObj->newEnable || range.first == range.second)
+        {
+            mergeMap.insert(std::make_pair(layoutObj->obj.mergeID, layoutObj));
+        }
+    }
+}
+
+void LayoutManager::recordPlacement(LayoutObjectEntry &layoutObj,bool isActive,bool evaluated,bool blocked,
+                                    int pickedOrient,const Mbr &placedMbr,const Point2f &netPt,float resScale)
+{
+    // Let the less important objects know if anything changed here
+    const Mbr newMbr = placedMbr.valid() ? Mbr(placedMbr.ll() - incrShift, placedMbr.ur() - incrShift) : Mbr();
+    const int newOrient = isActive ? pickedOrient : ((evaluated && blocked) ? -1 : -2);
+    const Mbr &oldMbr = layoutObj.layoutMbr;
+    const bool same = newOrient == layoutObj.layoutOrient &&
+                      newMbr.valid() == oldMbr.valid() &&
+                      (!newMbr.valid() || (newMbr.ll() - oldMbr.ll()).norm() <= incrThreshold * resScale);
+    if (!same)
+    {
+        if (oldMbr.valid())
+            incrDirty.push_back(oldMbr);
+        if (newMbr.valid())
+            incrDirty.push_back(newMbr);
+    }
+
+    layoutObj.layoutPt = (evaluated && newOrient != -2) ? netPt : Point2f(MAXFLOAT,MAXFLOAT);
+    layoutObj.layoutOrient = newOrient;
+    layoutObj.layoutMbr = newMbr;
+}
+
+// Project and generalize the shape for each view matrix, which doesn't depend on
+// where anything else went, so the caller can do a bunch of these at once
+static void CalcShapeRuns(LayoutObjectEntry &layoutObj,const ViewStateRef &viewState,
+                          const Point2f &frameBufferSize,LinearTextBuilder::Scratch &scratch)
+{
+    layoutObj.shapeRuns.resize(viewState->viewMatrices.size());
+    for (unsigned int oi=0;oi<viewState->viewMatrices.size();oi++)
+    {
+        LinearTextBuilder textBuilder(viewState,oi,frameBufferSize,
+                                      layoutObj.obj.layoutWidth*1.5f,
+                                      &layoutObj.obj);
+        textBuilder.setPoints(layoutObj.obj.layoutShape);
+        textBuilder.process(scratch);
+        layoutObj.shapeRuns[oi] = textBuilder.takeScreenVecs();
+    }
+    layoutObj.shapeRunsView = viewState;
+}
+
+bool LayoutManager::runLayoutParallel(WorkerPool &workers,
+                                      const ViewStateRef &viewState,
+                                      LayoutContainerVec &layoutObjs,
+                                      OverlapHelper &overlapMan,
+                                      WhirlyGlobe::GlobeViewState *globeViewState,
+                                      const Point2f &frameBufferSize,
+                                      const Mbr &screenMbr,
+                                      const Matrix4d &modelTrans,
+                                      const Matrix4d &normalMat,
+                                      float resScale,
+                                      ChangeSet &changes,
+                                      bool &hadChanges)
+{
+    WKTraceScope("Layout runLayoutParallel");
+
+    if (layoutObjs.size() < ParallelMinObjects)
+    {
+        return false;
+    }
+
+    // Flatten out the objects so we can keep track of them by index
+    std::vector<size_t> containerStart;
+    containerStart.reserve(layoutObjs.size() + 1);
+    size_t numObjs = 0;
+    for (auto &container : layoutObjs)
+    {
+        // Sort the objects by importance within their container, large to small
+        std::sort(container.objs.begin(),container.objs.end(),
+                  [](const LayoutObjectEntryRef &a,const LayoutObjectEntryRef &b) -> bool {
+                      return a->obj.importance > b->obj.importance;
+                  });
+        for (const auto &layoutObj : container.objs)
+        {
+            // Debug output has to go out in order
+            if (layoutObj->obj.layoutDebug)
+            {
+                return false;
+            }
+        }
+        containerStart.push_back(numObjs);
+        numObjs += container.objs.size();
+    }
+    containerStart.push_back(numObjs);
+
+    // Where each object could go, then what we did with it
+    struct ObjPlacement
+    {
+        LayoutObjectEntry *entry = nullptr;
+        bool inside = false;
+        Point2f objPt {0,0};
+        Point2f span {0,0};
+        // The screen bounds for each allowed orientation
+        unsigned int orients = 0;
+        Mbr orientMbrs[6];
+
+        bool active = false;
+        bool evaluated = false;
+        bool blocked = false;
+        int pickedOrient = -2;
+        // The last orientation tried, which sets the offset
+        int triedOrient = -1;
+    };
+    std::vector<ObjPlacement> places(numObjs);
+    for (size_t ci=0;ci<layoutObjs.size();ci++)
+    {
+        for (size_t oi=0;oi<layoutObjs[ci].objs.size();oi++)
+        {
+            places[containerStart[ci] + oi].entry = layoutObjs[ci].objs[oi].get();
+        }
+    }
+
+    // Work out the screen positions and candidate boxes, which don't depend on each other
+    workers.parallelFor(numObjs, ParallelChunkSize, [&](size_t start, size_t end)
+    {
+        Point2dVector objPts(4);
+        LinearTextBuilder::Scratch scratch;
+        for (size_t ii=start;ii<end && !cancelLayout;ii++)
+        {
+            auto &place = places[ii];
+            auto *layoutObj = place.entry;
+            layoutObj->newEnable = false;
+            layoutObj->obj.layoutModelPlaces.clear();
+            layoutObj->obj.layoutPlaces.clear();
+
+            if (!layoutObj->obj.layoutShape.empty())
+            {
+                // Walking the line can happen here too, unless the last placement might still do
+                if (layoutObj->shapeInstances.empty() || viewState->viewMatrices.size() != 1)
+                {
+                    CalcShapeRuns(*layoutObj, viewState, frameBufferSize, scratch);
+                }
+                continue;
+            }
+
+            place.inside = calcScreenPt(place.objPt,&layoutObj->obj,viewState,screenMbr,frameBufferSize);
+            if (!place.inside || layoutObj->obj.layoutPts.empty())
+            {
+                continue;
+            }
+
+            float screenRot = 0.0;
+            Matrix2d screenRotMat = Matrix2d::Identity();
+            if (layoutObj->obj.rotation != 0.0)
+            {
+                screenRotMat = calcScreenRot(screenRot, viewState, globeViewState, &layoutObj->obj,
+                                             place.objPt, modelTrans, normalMat, frameBufferSize);
+            }
+
+            const Mbr layoutMbr(layoutObj->obj.layoutPts);
+            const Point2f &layoutOrg = layoutMbr.ll();
+            place.span = layoutMbr.span();
+            for (unsigned int orient=0;orient<6;orient++)
+            {
+                if (!(layoutObj->obj.acceptablePlacement & (1U<<orient)))
+                    continue;
+
+                const Point2d objOffset = offsetForOrientation(orient, place.span.cast<double>());
+                objPts[0] = objOffset + layoutOrg.cast<double>();
+                objPts[1] = objPts[0] + Point2d(place.span.x(), 0.0);
+                objPts[2] = objPts[0] + Point2d(place.span.x(), place.span.y());
+                objPts[3] = objPts[0] + Point2d(0.0, place.span.y());
+                for (auto &p : objPts)
+                {
+                    const Point2d offPt = screenRotMat * (p * resScale);
+                    p = Point2d(offPt.x(),-offPt.y()) + place.objPt.cast<double>();
+                }
+
+                place.orientMbrs[orient] = Mbr(objPts);
+                place.orients |= 1U<<orient;
+            }
+        }
+    });
+
+    if (UNLIKELY(cancelLayout))
+    {
+        return true;
+    }
+
+    // Containers that can only land inside one tile go with that tile.
+    // Anything that could reach across a tile edge goes on the seam list.
+    const Point2f tileSize = screenMbr.span().cwiseQuotient(Point2f(ParallelTilesX, ParallelTilesY));
+    const auto tileFor = [&](const Point2f &pt)
+    {
+        const int tx = std::min(std::max((int)floor((pt.x() - screenMbr.ll().x()) / tileSize.x()), 0), ParallelTilesX - 1);
+        const int ty = std::min(std::max((int)floor((pt.y() - screenMbr.ll().y()) / tileSize.y()), 0), ParallelTilesY - 1);
+        return ty * ParallelTilesX + tx;
+    };
+    std::vector<size_t> seamContainers;
+    std::vector<std::vector<size_t>> tileContainers(ParallelTilesX * ParallelTilesY);
+    for (size_t ci=0;ci<layoutObjs.size();ci++)
+    {
+        Mbr reach;
+        bool alongShape = false;
+        for (size_t pi=containerStart[ci];pi<containerStart[ci+1];pi++)
+        {
+            const auto &place = places[pi];
+            alongShape |= !place.entry->obj.layoutShape.empty();
+            for (unsigned int orient=0;orient<6;orient++)
+            {
+                if (place.orients & (1U<<orient))
+                {
+                    reach.addPoint(place.orientMbrs[orient].ll());
+                    reach.addPoint(place.orientMbrs[orient].ur());
+                }
+            }
+        }
+
+        const int tile = reach.valid() ? tileFor(reach.ll()) : -1;
+        if (alongShape || tile < 0 || tile != tileFor(reach.ur()))
+        {
+            seamContainers.push_back(ci);
+        }
+        else
+        {
+            tileContainers[tile].push_back(ci);
+        }
+    }
+
+    // Same rules as the regular layout, checking the candidate boxes with the function given
+    const auto placeContainer = [&](size_t ci, const auto &addCheck)
+    {
+        const auto &container = layoutObjs[ci];
+        bool isActive = true;
+        bool pickedOne = false;
+        for (size_t oi=0;oi<container.objs.size();oi++)
+        {
+            const auto &layoutObj = container.objs[oi];
+            auto &place = places[containerStart[ci] + oi];
+            if (!layoutObj->obj.layoutShape.empty())
+            {
+                // Only ever done on the seam pass
+                layoutAlongShape(layoutObj, viewState, frameBufferSize, overlapMan, changes, isActive, hadChanges);
+                place.active = isActive;
+                continue;
+            }
+
+            if (pickedOne)
+                isActive = false;
+
+            if (isActive)
+            {
+                isActive = place.inside;
+                place.evaluated = place.inside;
+                if (isActive && !layoutObj->obj.layoutPts.empty())
+                {
+                    bool validOrient = false;
+                    for (unsigned int orient=0;orient<6 && !validOrient;orient++)
+                    {
+                        if (!(place.orients & (1U<<orient)))
+                            continue;
+
+                        // Objects we've pegged as essential always win
+                        place.triedOrient = (int)orient;
+                        if (container.importance >= MAXFLOAT ||
+                            addCheck(place.orientMbrs[orient], layoutObj->obj.mergeID))
+                        {
+                            validOrient = true;
+                            pickedOne = true;
+                            place.pickedOrient = (int)orient;
+                        }
+                    }
+                    place.blocked = !validOrient;
+                    isActive = validOrient;
+                }
+            }
+            place.active = isActive;
+        }
+    };
+
+    // Seams first, so the tiles only have to look at what's settled
+    for (const size_t ci : seamContainers)
+    {
+        if (UNLIKELY(cancelLayout))
+        {
+            return true;
+        }
+        placeContainer(ci, [&overlapMan](const Mbr &mbr, const std::string &mergeID) {
+            return overlapMan.addCheckObject(mbr, mergeID);
+        });
+    }
+
+    // Then the tile interiors, which can't run into each other
+    const Point2f tileCells(std::max(OverlapSampleX / ParallelTilesX, 1), std::max(OverlapSampleY / ParallelTilesY, 1));
+    workers.parallelFor(tileContainers.size(), 1, [&](size_t start, size_t end)
+    {
+        for (size_t ti=start;ti<end;ti++)
+        {
+            const auto &tileConts = tileContainers[ti];
+            if (tileConts.empty())
+            {
+                continue;
+            }
+
+            const Point2f tileOrg = screenMbr.ll() + tileSize.cwiseProduct(Point2f(ti % ParallelTilesX, ti / ParallelTilesX));
+            size_t tileObjs = 0;
+            for (const size_t ci : tileConts)
+            {
+                tileObjs += layoutObjs[ci].objs.size();
+            }
+            OverlapHelper tileOverlap(Mbr(tileOrg, tileOrg + tileSize), (int)tileCells.x(), (int)tileCells.y(), tileObjs);
+
+            for (const size_t ci : tileConts)
+            {
+                if (UNLIKELY(cancelLayout))
+                {
+                    return;
+                }
+                placeContainer(ci, [&overlapMan,&tileOverlap](const Mbr &mbr, const std::string &mergeID) {
+                    return overlapMan.checkObject(mbr, mergeID) && tileOverlap.addCheckObject(mbr, mergeID);
+                });
+            }
+        }
+    });
+
+    if (UNLIKELY(cancelLayout))
+    {
+        return true;
+    }
+
+    // Now apply the results in importance order, as the regular layout does
+    MergeMap mergeMap(numObjs);
+    for (size_t ci=0;ci<layoutObjs.size();ci++)
+    {
+        Point2d objOffset(0.0,0.0);
+        const auto &container = layoutObjs[ci];
+        for (size_t oi=0;oi<container.objs.size();oi++)
+        {
+            const auto &layoutObj = container.objs[oi];
+            const auto &place = places[containerStart[ci] + oi];
+            if (place.triedOrient >= 0)
+            {
+                objOffset = offsetForOrientation((unsigned)place.triedOrient, place.span.cast<double>());
+            }
+
+            bool isActive = place.active;
+            syncMergedObject(layoutObj, isActive, mergeMap, hadChanges);
+
+            // See if we've changed any of the state
+            if (layoutObj->currentEnable != isActive || layoutObj->newEnable || layoutObj->offset != objOffset)
+            {
+                layoutObj->changed = true;
+                hadChanges = true;
+            }
+            layoutObj->newEnable = isActive;
+            layoutObj->newCluster = -1;
+            layoutObj->offset = objOffset;
+
+            if (incremental && layoutObj->obj.layoutShape.empty())
+            {
+                const Mbr placedMbr = (isActive && place.pickedOrient >= 0) ? place.orientMbrs[place.pickedOrient] : Mbr();
+                recordPlacement(*layoutObj, isActive, place.evaluated, place.blocked, place.pickedOrient,
+                                placedMbr, place.evaluated ? Point2f(place.objPt - incrShift) : Point2f(MAXFLOAT,MAXFLOAT),
+                                resScale);
+            }
+        }
+    }
+
+    return true;
+}
+
 // Do the actual layout logic.  We'll modify the offset and on value in place.
 bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                                    const ViewStateRef &viewState,
@@ -620,8 +1113,11 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                                    const std::unordered_set<std::string> &localOverrideUUIDs,
                                    std::vector<ClusterEntry> &clusterEntries,
                                    std::vector<ClusterGenerator::ClusterClassParams> &outClusterParams,
+                                   WorkerPool *workers,
                                    ChangeSet &changes)
 {
+    WKTraceScope("Layout runLayoutRules");
+
     if (localLayoutObjects.empty())
         return false;
 
@@ -640,9 +1136,7 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
 
     // View related matrix stuff
     const Matrix4d modelTrans = viewState->fullMatrices[0];
-    const Matrix4d fullMatrix = viewState->fullMatrices[0];
-    const Matrix4d fullNormalMatrix = viewState->fullNormalMatrices[0];
-    const Matrix4d normalMat = viewState->fullMatrices[0].inverse().transpose();
+    const Matrix4d &normalMat = viewState->fullNormalMatrices[0];
 
     // Turn everything off and sort by importance
     for (const auto &layoutObjRef : localLayoutObjects)
@@ -672,16 +1166,21 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
             }
 
             // Make sure this one isn't behind the globe
+            bool behind = false;
             if (use && globeViewState)
             {
                 // Layout shape following doesn't work with this check
                 if (obj->obj.layoutShape.empty())
                 {
-                    // Make sure this one is facing toward the viewer
-                    use = CheckPointAndNormFacing(obj->obj.worldLoc,obj->obj.worldLoc.normalized(),
-                                                  fullMatrix,fullNormalMatrix) > 0.0;
+                    // Make sure the globe isn't in the way
+                    behind = viewState->isPastHorizon(obj->obj.worldLoc);
                 }
             }
+            // The cluster hierarchy wants the whole group and does its own check
+            if (behind && !(clusterHierarchy && obj->obj.clusterGroup > -1))
+            {
+                use = false;
+            }
 
             if (use)
             {
@@ -757,10 +1256,23 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
             {
                 obj->newEnable = false;
                 obj->newCluster = -1;
+
+                if (incremental)
+                {
+                    // Whatever it was covering is open now
+                    if (obj->layoutMbr.valid())
+                    {
+                        incrDirty.push_back(obj->layoutMbr);
+                    }
+                    obj->layoutPt = Point2f(MAXFLOAT,MAXFLOAT);
+                    obj->layoutOrient = -2;
+                    obj->layoutMbr.reset();
+                }
             }
 
             // Note: Update this for clusters
-            if ((use && !obj->currentEnable) || (!use && obj->currentEnable))
+            const bool shown = use && !behind;
+            if ((shown && !obj->currentEnable) || (!shown && obj->currentEnable))
             {
                 hadChanges = true;
             }
@@ -787,6 +1299,56 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
         return false;
     }
 
+    // In incremental mode we can reuse placements for objects that haven't moved relative to the view.
+    // Every so often, or if anything big changed, we evaluate everything.
+    const bool incrPass = incremental && maxDisplayObjects == 0 && clusterEntries.empty() &&
+                          incrFrameSize == frameBufferSize && ++incrPasses < IncrementalFullPass;
+    if (incremental && !incrPass)
+    {
+        incrPasses = 0;
+        incrShift = Point2f(0.0,0.0);
+        incrDirty.clear();
+    }
+    incrFrameSize = frameBufferSize;
+    if (incrPass)
+    {
+        // Work out how the view shifted from a sample of the objects we placed before
+        std::vector<float> shiftX, shiftY;
+        shiftX.reserve(IncrementalSamples);
+        shiftY.reserve(IncrementalSamples);
+        const size_t stride = std::max((size_t)1, localLayoutObjects.size() / IncrementalSamples);
+        size_t which = 0;
+        for (const auto &entry : localLayoutObjects)
+        {
+            if (shiftX.size() >= IncrementalSamples)
+            {
+                break;
+            }
+            if ((which++ % stride) != 0 || entry->layoutPt.x() == MAXFLOAT)
+            {
+                continue;
+            }
+            Point2f pt;
+            if (calcScreenPt(pt,&entry->obj,viewState,screenMbr,frameBufferSize))
+            {
+                shiftX.push_back(pt.x() - entry->layoutPt.x());
+                shiftY.push_back(pt.y() - entry->layoutPt.y());
+            }
+        }
+        if (!shiftX.empty())
+        {
+            const auto mid = shiftX.size() / 2;
+            std::nth_element(shiftX.begin(), shiftX.begin() + mid, shiftX.end());
+            std::nth_element(shiftY.begin(), shiftY.begin() + mid, shiftY.end());
+            incrShift = Point2f(shiftX[mid], shiftY[mid]);
+        }
+    }
+    const auto isDirty = [this](const Mbr &mbr)
+    {
+        return incrDirty.size() > IncrementalMaxDirty ||
+               std::any_of(incrDirty.begin(), incrDirty.end(), [&mbr](const Mbr &d) { return d.overlaps(mbr); });
+    };
+
 //    NSLog(@"----Starting Layout----");
 
     // Set up the overlap sampler
@@ -812,7 +1374,15 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
         overlapMan.addObject(objPts);
     }
 
-    std::unordered_multimap<std::string, LayoutObjectEntryRef> mergeMap(localLayoutObjects.size());
+    // Split the work up by screen tiles if we can
+    if (workers && !incrPass && maxDisplayObjects == 0 && !showDebugBoundaries &&
+        runLayoutParallel(*workers, viewState, layoutObjs, overlapMan, globeViewState,
+                          frameBufferSize, screenMbr, modelTrans, normalMat, resScale, changes, hadChanges))
+    {
+        return hadChanges;
+    }
+
+    MergeMap mergeMap(localLayoutObjects.size());
 
     // Lay out the various objects that are active
     int numSoFar = 0;
@@ -849,10 +1419,21 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
             layoutObj->obj.layoutModelPlaces.clear();
             layoutObj->obj.layoutPlaces.clear();
 
+            // What we did with it, for incremental mode
+            bool evaluated = false, reused = false, blocked = false;
+            int pickedOrient = -2;
+            Point2f netPt(MAXFLOAT,MAXFLOAT);
+
             // Layout along a shape
             if (!layoutObj->obj.layoutShape.empty())
             {
                 layoutAlongShape(layoutObj, viewState, frameBufferSize, overlapMan, changes, isActive, hadChanges);
+
+                // We don't track where these land, so anything could be affected
+                if (incrPass && layoutObj->currentEnable != isActive)
+                {
+                    incrDirty.emplace_back(Point2f(-MAXFLOAT,-MAXFLOAT),Point2f(MAXFLOAT,MAXFLOAT));
+                }
             }
             else
             {
@@ -868,6 +1449,11 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                     bool isInside = calcScreenPt(objPt,&layoutObj->obj,viewState,screenMbr,frameBufferSize);
 
                     isActive &= isInside;
+                    if (isInside)
+                    {
+                        evaluated = true;
+                        netPt = objPt - incrShift;
+                    }
 
                     // Deal with the rotation
                     float screenRot = 0.0;
@@ -884,19 +1470,14 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                         // Try the four different orientations
                         if (!layoutObj->obj.layoutPts.empty())
                         {
-                            bool validOrient = false;
-                            for (unsigned int orient=0;orient<6;orient++)
-                            {
-                                // May only want to be placed certain ways.  Fair enough.
-                                if (!(layoutObj->obj.acceptablePlacement & (1U<<orient)))
-                                    continue;
-
-                                // Layout points are relative to the object, figure out where they are on the screen
-                                const Point2dVector &layoutPts = layoutObj->obj.layoutPts;
-                                const Mbr layoutMbr(layoutPts);
-                                const Point2f span = layoutMbr.span();
-                                const Point2f &layoutOrg = layoutMbr.ll();
+                            // Layout points are relative to the object, figure out where they are on the screen
+                            const Point2dVector &layoutPts = layoutObj->obj.layoutPts;
+                            const Mbr layoutMbr(layoutPts);
+                            const Point2f span = layoutMbr.span();
+                            const Point2f &layoutOrg = layoutMbr.ll();
 
+                            const auto placeObj = [&](unsigned int orient)
+                            {
                                 // Set up the offset for this orientation
                                 objOffset = offsetForOrientation(orient, span.cast<double>());
 
@@ -910,33 +1491,85 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                                     const Point2d offPt = screenRotMat * (p * resScale);
                                     p = Point2d(offPt.x(),-offPt.y()) + objPt.cast<double>();
                                 }
+                            };
 
-                                //wkLogLevel(Debug, "Center pt = (%f,%f), orient = %d, pts:",objPt.x(),objPt.y(),orient);
-                                //for (const auto &p : objPts) wkLogLevel(Debug, "  (%f,%f)\n",p.x(),p.y());
+                            // If it hasn't moved and nothing around it changed, it should come out the same
+                            int lastOrient = -2;
+                            if (incrPass && layoutObj->obj.rotation == 0.0 && layoutObj->layoutPt.x() != MAXFLOAT &&
+                                (netPt - layoutObj->layoutPt).norm() <= incrThreshold * resScale)
+                            {
+                                const float reach = (layoutOrg.norm() + 2.0f * span.norm()) * resScale;
+                                if (!isDirty(Mbr(netPt - Point2f(reach,reach),netPt + Point2f(reach,reach))))
+                                {
+                                    lastOrient = layoutObj->layoutOrient;
+                                }
+                            }
 
-                                // Now try it.  Objects we've pegged as essential always win
-                                if (container.importance >= MAXFLOAT ||
-                                    overlapMan.addCheckObject(objPts, layoutObj->obj.mergeID))
+                            bool validOrient = false;
+                            if (lastOrient == -1)
+                            {
+                                // Still blocked by the same things
+                                objOffset = layoutObj->offset;
+                                reused = true;
+                                blocked = true;
+                            }
+                            else
+                            {
+                                if (lastOrient >= 0)
                                 {
-                                    if (showDebugBoundaries || layoutObj->obj.layoutDebug)
+                                    placeObj(lastOrient);
+                                    if (container.importance >= MAXFLOAT ||
+                                        overlapMan.addCheckObject(objPts, layoutObj->obj.mergeID))
                                     {
-                                        // Debugging visual output
-                                        // The chosen placement is drawn in black.
-                                        addDebugOutput(objPts,globeViewState,mapViewState,frameBufferSize,
-                                                       changes, 10000000, RGBAColor::black());
+                                        if (showDebugBoundaries || layoutObj->obj.layoutDebug)
+                                        {
+                                            addDebugOutput(objPts,globeViewState,mapViewState,frameBufferSize,
+                                                           changes, 10000000, RGBAColor::black());
+                                        }
+                                        validOrient = true;
+                                        pickedOne = true;
+                                        pickedOrient = lastOrient;
+                                        reused = true;
                                     }
-
-                                    validOrient = true;
-                                    pickedOne = true;
-                                    break;
                                 }
 
-                                if (showDebugBoundaries || layoutObj->obj.layoutDebug)
+                                for (unsigned int orient=0;orient<6 && !validOrient;orient++)
                                 {
-                                    // Placements that don't work are drawn in translucent blue
-                                    addDebugOutput(objPts,globeViewState,mapViewState,frameBufferSize,
-                                                   changes, 10000000, RGBAColor::blue().withAlpha(0.5));
+                                    // May only want to be placed certain ways.  Fair enough.
+                                    if (!(layoutObj->obj.acceptablePlacement & (1U<<orient)))
+                                        continue;
+
+                                    placeObj(orient);
+
+                                    //wkLogLevel(Debug, "Center pt = (%f,%f), orient = %d, pts:",objPt.x(),objPt.y(),orient);
+                                    //for (const auto &p : objPts) wkLogLevel(Debug, "  (%f,%f)\n",p.x(),p.y());
+
+                                    // Now try it.  Objects we've pegged as essential always win
+                                    if (container.importance >= MAXFLOAT ||
+                                        overlapMan.addCheckObject(objPts, layoutObj->obj.mergeID))
+                                    {
+                                        if (showDebugBoundaries || layoutObj->obj.layoutDebug)
+                                        {
+                                            // Debugging visual output
+                                            // The chosen placement is drawn in black.
+                                            addDebugOutput(objPts,globeViewState,mapViewState,frameBufferSize,
+                                                           changes, 10000000, RGBAColor::black());
+                                        }
+
+                                        validOrient = true;
+                                        pickedOne = true;
+                                        pickedOrient = (int)orient;
+                                        break;
+                                    }
+
+                                    if (showDebugBoundaries || layoutObj->obj.layoutDebug)
+                                    {
+                                        // Placements that don't work are drawn in translucent blue
+                                        addDebugOutput(objPts,globeViewState,mapViewState,frameBufferSize,
+                                                       changes, 10000000, RGBAColor::blue().withAlpha(0.5));
+                                    }
                                 }
+                                blocked = !validOrient;
                             }
 
                             isActive = validOrient;
@@ -957,38 +1590,7 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                 numSoFar++;
 
             // Keep merged items in sync.
-            if (!layoutObj->obj.mergeID.empty())
-            {
-                // Consider the objects we've already seen with the same merge ID
-                const auto range = mergeMap.equal_range(layoutObj->obj.mergeID);
-                for (auto ii = range.first; ii != range.second; ++ii)
-                {
-                    auto &prevObj = *ii->second;
-                    if (isActive && !prevObj.newEnable)
-                    {
-                        // That object was disabled, we need to disable this one to match.
-                        isActive = false;
-                        layoutObj->newEnable = false;
-                        // we can stop looking
-                        break;
-                    }
-                    else if (!isActive && prevObj.newEnable)
-                    {
-                        // That object was enabled, we need to disable it to match this one.
-                        // This might actually undo the change leaving us with no changes, but we
-                        // can't easily detect that.
-                        prevObj.newEnable = false;
-                        layoutObj->changed = true;
-                        hadChanges = true;
-                    }
-                }
-                // If this one is still enabled, or is the first disabled
-                // item of its ID that we've seen, we need to keep track of it.
-                if (layoutObj->newEnable || range.first == range.second)
-                {
-                    mergeMap.insert(std::make_pair(layoutObj->obj.mergeID, layoutObj));
-                }
-            }
+            syncMergedObject(layoutObj, isActive, mergeMap, hadChanges);
 
             // See if we've changed any of the state
             if (layoutObj->currentEnable != isActive || layoutObj->newEnable || layoutObj->offset != objOffset)
@@ -999,6 +1601,14 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
             layoutObj->newEnable = isActive;
             layoutObj->newCluster = -1;
             layoutObj->offset = objOffset;
+
+            // Reused placements keep the position from when they were worked out,
+            // so drift is measured from there.
+            if (incremental && !reused && layoutObj->obj.layoutShape.empty())
+            {
+                const Mbr placedMbr = (isActive && !layoutObj->obj.layoutPts.empty()) ? Mbr(objPts) : Mbr();
+                recordPlacement(*layoutObj, isActive, evaluated, blocked, pickedOrient, placedMbr, netPt, resScale);
+            }
         }
     }
 
@@ -1031,6 +1641,18 @@ void LayoutManager::runLayoutClustering(PlatformThreadInfo *threadInfo,
         ClusterGenerator::ClusterClassParams &params = outClusterParams.back();
         clusterGen->paramsForClusterClass(threadInfo,cluster->clusterID,params);
 
+        if (clusterHierarchy &&
+            runHierarchyClustering(threadInfo, *cluster, params, (int)(outClusterParams.size() - 1),
+                                   layoutObjs, clusterEntries, viewState, mapViewState, globeViewState,
+                                   frameBufferSize, screenMbr, modelTrans))
+        {
+            if (UNLIKELY(cancelLayout))
+            {
+                break;
+            }
+            continue;
+        }
+
         ClusterHelper clusterHelper(screenMbr,OverlapSampleX,OverlapSampleY,resScale,params.clusterSize);
 
         // Add all the various objects to the cluster and figure out overlaps
@@ -1043,6 +1665,12 @@ void LayoutManager::runLayoutClustering(PlatformThreadInfo *threadInfo,
 
             isActive &= isInside;
 
+            // With the hierarchy on, the group includes objects behind the globe
+            if (isActive && clusterHierarchy && globeViewState && entry->obj.layoutShape.empty())
+            {
+                isActive = !viewState->isPastHorizon(entry->obj.worldLoc);
+            }
+
             if (isActive)
             {
                 // Deal with the rotation
@@ -1076,101 +1704,363 @@ void LayoutManager::runLayoutClustering(PlatformThreadInfo *threadInfo,
             }
         }
 
-        // Deal with the clusters and their own overlaps
-        clusterHelper.resolveClusters(cancelLayout);
+        // Deal with the clusters and their own overlaps
+        clusterHelper.resolveClusters(cancelLayout);
+
+        if (UNLIKELY(cancelLayout))
+        {
+            break;
+        }
+
+        // Toss the unaffected layout objects into the mix
+        layoutObjs.reserve(layoutObjs.size() + clusterHelper.simpleObjects.size());
+        for (const auto &obj : clusterHelper.simpleObjects)
+        {
+            if (obj.parentObject < 0)
+            {
+                layoutObjs.emplace_back(obj.objEntry);
+                obj.objEntry->newEnable = true;
+                obj.objEntry->newCluster = -1;
+            }
+        }
+
+        // Create new objects for the clusters
+        for (const auto &clusterObj : clusterHelper.clusterObjects)
+        {
+            std::vector<LayoutObjectEntryRef> objsForCluster;
+            clusterHelper.objectsForCluster(clusterObj,objsForCluster);
+
+            if (!objsForCluster.empty())
+            {
+                const Point2f clusterLoc = clusterObj.center.cast<float>();
+
+                // Project the cluster back into a geolocation so we can place it.
+                Point3d dispPt;
+                bool dispPtValid = false;
+                if (globeViewState)
+                {
+                    dispPtValid = globeViewState->pointOnSphereFromScreen(clusterLoc,modelTrans,frameBufferSize,dispPt);
+                }
+                else
+                {
+                    dispPtValid = mapViewState->pointOnPlaneFromScreen(clusterLoc,modelTrans,frameBufferSize,dispPt,false);
+                }
+
+                addClusterEntry(threadInfo, cluster->clusterID, params, (int)(outClusterParams.size() - 1),
+                                objsForCluster, dispPt, dispPtValid, clusterEntries);
+            }
+        }
+    }
+
+    // Drop the trees for groups that are gone
+    if (!clusterHierarchy)
+    {
+        clusterTrees.clear();
+    }
+    else
+    {
+        for (auto it = clusterTrees.begin(); it != clusterTrees.end(); )
+        {
+            ClusteredObjects findClusterObj(it->first);
+            it = (clusterGroups.find(&findClusterObj) == clusterGroups.end()) ? clusterTrees.erase(it) : std::next(it);
+        }
+    }
+
+    // Tear down the clusters
+    for (auto clusterObj : clusterGroups)
+    {
+        delete clusterObj;
+    }
+    clusterGroups.clear();
+
+    clusterGen->endLayoutObjects(threadInfo);
+}
+
+void LayoutManager::addClusterEntry(PlatformThreadInfo *threadInfo,
+                                    int clusterID,
+                                    const ClusterGenerator::ClusterClassParams &params,
+                                    int paramsID,
+                                    const std::vector<LayoutObjectEntryRef> &objsForCluster,
+                                    const Point3d &dispPt,
+                                    bool dispPtValid,
+                                    std::vector<ClusterEntry> &clusterEntries)
+{
+    const int clusterEntryID = (int)clusterEntries.size();
+    clusterEntries.emplace_back();
+    ClusterEntry &clusterEntry = clusterEntries.back();
+
+    // Note: What happens if the display point isn't valid?
+    if (dispPtValid)
+    {
+        clusterEntry.layoutObj.worldLoc = dispPt;
+        for (const auto &thisObj : objsForCluster)
+        {
+            clusterEntry.objectIDs.push_back(thisObj->obj.getId());
+        }
+        clusterGen->makeLayoutObject(threadInfo,clusterID, objsForCluster, clusterEntry.layoutObj);
+        if (!params.selectable)
+        {
+            clusterEntry.layoutObj.selectPts.clear();
+        }
+    }
+    clusterEntry.clusterParamID = paramsID;
+
+    // Figure out if all the objects in this new cluster come from the same old cluster
+    //  and assign the new cluster ID
+    int whichOldCluster = -1;
+    for (const auto &obj : objsForCluster)
+    {
+        if (obj->currentCluster > -1 && whichOldCluster != -2)
+        {
+            if (whichOldCluster == -1)
+            {
+                whichOldCluster = obj->currentCluster;
+            }
+            else if (whichOldCluster != obj->currentCluster)
+            {
+                whichOldCluster = -2;
+            }
+        }
+        obj->newCluster = clusterEntryID;
+    }
+
+    // If the children all agree about the old cluster, let's reflect that
+    clusterEntry.childOfCluster = (whichOldCluster == -2) ? -1 : whichOldCluster;
+}
+
+bool LayoutManager::runHierarchyClustering(PlatformThreadInfo *threadInfo,
+                                           const ClusteredObjects &cluster,
+                                           const ClusterGenerator::ClusterClassParams &params,
+                                           int paramsID,
+                                           LayoutContainerVec &layoutObjs,
+                                           std::vector<ClusterEntry> &clusterEntries,
+                                           const ViewStateRef &viewState,
+                                           Maply::MapViewState *mapViewState,
+                                           WhirlyGlobe::GlobeViewState *globeViewState,
+                                           const Point2f &frameBufferSize,
+                                           const Mbr &screenMbr,
+                                           const Matrix4d &modelTrans)
+{
+    const CoordSystemDisplayAdapter *coordAdapter = scene ? scene->getCoordAdapter() : nullptr;
+    const CoordSystem *coordSys = coordAdapter ? coordAdapter->getCoordSystem() : nullptr;
+    if (!coordSys || (!globeViewState && !mapViewState))
+    {
+        return false;
+    }
+
+    const auto unproject = [&](const Point2f &screenPt,Point2d &unitPt)
+    {
+        Point3d dispPt;
+        const bool valid = globeViewState ?
+            globeViewState->pointOnSphereFromScreen(screenPt,modelTrans,frameBufferSize,dispPt) :
+            mapViewState->pointOnPlaneFromScreen(screenPt,modelTrans,frameBufferSize,dispPt,false);
+        if (valid)
+        {
+            unitPt = geoToMercatorUnit(coordSys->localToGeographicD(coordAdapter->displayToLocal(dispPt)));
+        }
+        return valid;
+    };
+
+    // Work out the map scale in the middle of the screen
+    const Point2f center = frameBufferSize / 2.0;
+    Point2d centerPt,offPt;
+    if (!unproject(center,centerPt) ||
+        !unproject(center + Point2f(ClusterScaleSample,0.0),offPt) ||
+        (offPt - centerPt).norm() <= 0.0)
+    {
+        return false;
+    }
+    const double pixelsPerUnit = ClusterScaleSample / (offPt - centerPt).norm();
+
+    // Rebuild the tree if the objects or the marker size changed
+    const double radius = params.clusterSize.maxCoeff() * renderer->getScale();
+    const auto &objs = cluster.getLayoutObjects();
+    size_t signature = objs.size();
+    for (const auto &entry : objs)
+    {
+        signature = signature * 31 + std::hash<const LayoutObjectEntry *>()(entry.get());
+    }
+
+    auto &tree = clusterTrees[cluster.clusterID];
+    if (!tree || tree->signature != signature || tree->hierarchy.getRadius() != radius)
+    {
+        tree.reset(new ClusterTree(ClusterMaxZoom,radius));
+        tree->objs.assign(objs.begin(),objs.end());
+        tree->signature = signature;
+
+        std::vector<double> xs,ys;
+        xs.reserve(objs.size());
+        ys.reserve(objs.size());
+        for (const auto &entry : tree->objs)
+        {
+            const Point2d unitPt = geoToMercatorUnit(coordSys->localToGeographicD(coordAdapter->displayToLocal(entry->obj.worldLoc)));
+            xs.push_back(unitPt.x());
+            ys.push_back(unitPt.y());
+        }
+        if (!tree->hierarchy.build(xs,ys,cancelLayout))
+        {
+            tree.reset();
+            return true;
+        }
+    }
+
+    const int zoom = tree->hierarchy.zoomForScale(pixelsPerUnit);
 
-        if (UNLIKELY(cancelLayout))
+    // Look at what's under the screen, or the whole world if we can't tell
+    double minX = 0.0, minY = 0.0, maxX = 1.0, maxY = 1.0;
+    if (viewState->viewMatrices.size() == 1)
+    {
+        MbrD unitMbr;
+        bool allValid = true;
+        for (int ix=0;ix<=2 && allValid;ix++)
         {
-            break;
+            for (int iy=0;iy<=2 && allValid;iy++)
+            {
+                Point2d unitPt;
+                const Point2f screenPt(screenMbr.ll().x() + screenMbr.span().x() * ix / 2.0,
+                                       screenMbr.ll().y() + screenMbr.span().y() * iy / 2.0);
+                allValid = unproject(screenPt,unitPt);
+                unitMbr.addPoint(unitPt);
+            }
+        }
+        // Something that wide probably wraps around
+        if (allValid && unitMbr.span().x() < 0.5)
+        {
+            const double pad = radius / pixelsPerUnit;
+            minX = unitMbr.ll().x() - pad;  maxX = unitMbr.ur().x() + pad;
+            minY = unitMbr.ll().y() - pad;  maxY = unitMbr.ur().y() + pad;
         }
+    }
 
-        // Toss the unaffected layout objects into the mix
-        layoutObjs.reserve(layoutObjs.size() + clusterHelper.simpleObjects.size());
-        for (const auto &obj : clusterHelper.simpleObjects)
+    std::vector<int> nodes;
+    tree->hierarchy.query(zoom,minX,minY,maxX,maxY,nodes);
+
+    // On the globe, the group includes what's around the back
+    const auto facing = [&](const Point3d &dispPt)
+    {
+        return !globeViewState || !viewState->isPastHorizon(dispPt);
+    };
+
+    std::vector<int> leaves;
+    std::vector<LayoutObjectEntryRef> objsForCluster;
+    Point2f objPt;
+    for (int which : nodes)
+    {
+        const ClusterHierarchy::Node &node = tree->hierarchy.getNode(zoom,which);
+        if (node.leaf >= 0)
         {
-            if (obj.parentObject < 0)
+            // It stands on its own
+            const auto &entry = tree->objs[node.leaf];
+            if (facing(entry->obj.worldLoc) &&
+                calcScreenPt(objPt,&entry->obj,viewState,screenMbr,frameBufferSize))
             {
-                layoutObjs.emplace_back(obj.objEntry);
-                obj.objEntry->newEnable = true;
-                obj.objEntry->newCluster = -1;
+                layoutObjs.emplace_back(entry);
+                entry->newEnable = true;
+                entry->newCluster = -1;
             }
+            continue;
         }
 
-        // Create new objects for the clusters
-        for (const auto &clusterObj : clusterHelper.clusterObjects)
+        const Point3d dispPt = coordAdapter->localToDisplay(coordSys->geographicToLocal(mercatorUnitToGeo(node.x,node.y)));
+        if (!facing(dispPt) || !calcScreenPt(objPt,dispPt,viewState,screenMbr,frameBufferSize))
         {
-            std::vector<LayoutObjectEntryRef> objsForCluster;
-            clusterHelper.objectsForCluster(clusterObj,objsForCluster);
+            continue;
+        }
 
-            if (!objsForCluster.empty())
-            {
-                const int clusterEntryID = (int)clusterEntries.size();
-                clusterEntries.emplace_back();
-                ClusterEntry &clusterEntry = clusterEntries.back();
+        leaves.clear();
+        tree->hierarchy.getLeaves(zoom,which,leaves);
+        objsForCluster.clear();
+        objsForCluster.reserve(leaves.size());
+        for (int leaf : leaves)
+        {
+            objsForCluster.push_back(tree->objs[leaf]);
+        }
 
-                const Point2f clusterLoc = clusterObj.center.cast<float>();
+        addClusterEntry(threadInfo, cluster.clusterID, params, paramsID, objsForCluster, dispPt, true, clusterEntries);
+    }
 
-                // Project the cluster back into a geolocation so we can place it.
-                Point3d dispPt;
-                bool dispPtValid = false;
-                if (globeViewState)
-                {
-                    dispPtValid = globeViewState->pointOnSphereFromScreen(clusterLoc,modelTrans,frameBufferSize,dispPt);
-                }
-                else
-                {
-                    dispPtValid = mapViewState->pointOnPlaneFromScreen(clusterLoc,modelTrans,frameBufferSize,dispPt,false);
-                }
+    return true;
+}
 
-                // Note: What happens if the display point isn't valid?
-                if (dispPtValid)
-                {
-                    clusterEntry.layoutObj.worldLoc = dispPt;
-                    for (const auto &thisObj : objsForCluster)
-                    {
-                        clusterEntry.objectIDs.push_back(thisObj->obj.getId());
-                    }
-                    clusterGen->makeLayoutObject(threadInfo,cluster->clusterID, objsForCluster, clusterEntry.layoutObj);
-                    if (!params.selectable)
-                    {
-                        clusterEntry.layoutObj.selectPts.clear();
-                    }
-                }
-                clusterEntry.clusterParamID = (int)(outClusterParams.size() - 1);
+bool LayoutManager::reuseShapeLayout(LayoutObjectEntry &layoutObj,
+                                     const ViewStateRef &viewState,
+                                     const Point2f &frameBufferSize,
+                                     OverlapHelper &overlapMan,
+                                     bool &hadChanges)
+{
+    if (layoutObj.shapeInstances.empty())
+    {
+        return false;
+    }
 
-                // Figure out if all the objects in this new cluster come from the same old cluster
-                //  and assign the new cluster ID
-                int whichOldCluster = -1;
-                for (const auto &obj : objsForCluster)
-                {
-                    if (obj->currentCluster > -1 && whichOldCluster != -2)
-                    {
-                        if (whichOldCluster == -1)
-                        {
-                            whichOldCluster = obj->currentCluster;
-                        }
-                        else if (whichOldCluster != obj->currentCluster)
-                        {
-                            whichOldCluster = -2;
-                        }
-                    }
-                    obj->newCluster = clusterEntryID;
-                }
+    const auto globeViewState = dynamic_cast<WhirlyGlobe::GlobeViewState *>(viewState.get());
+    const Matrix4d &modelTrans = viewState->fullMatrices[0];
+    const Mbr frameMbr(Point2f(0.0,0.0),frameBufferSize);
 
-                // If the children all agree about the old cluster, let's reflect that
-                clusterEntry.childOfCluster = (whichOldCluster == -2) ? -1 : whichOldCluster;
+    // Every instance has to still be on screen and look the same, otherwise walk the line again
+    std::vector<Point2f> anchors;
+    anchors.reserve(layoutObj.shapeInstances.size());
+    for (const auto &inst : layoutObj.shapeInstances)
+    {
+        if (globeViewState && viewState->isPastHorizon(inst.worldPt))
+        {
+            return false;
+        }
+        const Point2f anchor = viewState->pointOnScreenFromDisplay(inst.worldPt,&modelTrans,frameBufferSize);
+        if (!frameMbr.inside(anchor))
+        {
+            return false;
+        }
+        for (unsigned int ri=0;ri<2;ri++)
+        {
+            const Point2f refOffset = viewState->pointOnScreenFromDisplay(inst.refPts[ri],&modelTrans,frameBufferSize) - anchor;
+            if ((refOffset - inst.refOffsets[ri]).norm() > ShapeReuseTolerance * inst.refOffsets[ri].norm())
+            {
+                return false;
             }
         }
+        anchors.push_back(anchor);
     }
 
-    // Tear down the clusters
-    for (auto clusterObj : clusterGroups)
+    // Keep the instances that still fit
+    std::vector<std::vector<Eigen::Matrix3d>> layoutInstances;
+    std::vector<Point3d> layoutModelInstances;
+    for (unsigned int ii=0;ii<layoutObj.shapeInstances.size();ii++)
     {
-        delete clusterObj;
+        const auto &inst = layoutObj.shapeInstances[ii];
+        const auto &anchor = anchors[ii];
+        const bool fits = std::all_of(inst.glyphMbrs.begin(),inst.glyphMbrs.end(),[&](const Mbr &glyphMbr) {
+            return overlapMan.checkObject(Mbr(glyphMbr.ll() + anchor,glyphMbr.ur() + anchor),std::string());
+        });
+        if (!fits)
+        {
+            continue;
+        }
+        for (const auto &glyphMbr : inst.glyphMbrs)
+        {
+            overlapMan.addObject(Mbr(glyphMbr.ll() + anchor,glyphMbr.ur() + anchor),std::string());
+        }
+        layoutInstances.push_back(inst.glyphMats);
+        layoutModelInstances.push_back(inst.worldPt);
     }
-    clusterGroups.clear();
 
-    clusterGen->endLayoutObjects(threadInfo);
+    if (layoutInstances.empty())
+    {
+        return false;
+    }
+
+    // If they're all still there nothing changed, as far as the drawables go
+    if (layoutInstances.size() != layoutObj.shapeInstances.size())
+    {
+        layoutObj.changed = true;
+        hadChanges = true;
+    }
+    layoutObj.obj.layoutPlaces = std::move(layoutInstances);
+    layoutObj.obj.layoutModelPlaces = std::move(layoutModelInstances);
+    layoutObj.newCluster = -1;
+    layoutObj.offset = Point2d(0.0,0.0);
+
+    return true;
 }
 
 void LayoutManager::layoutAlongShape(const LayoutObjectEntryRef &layoutObj,
@@ -1181,6 +2071,24 @@ void LayoutManager::layoutAlongShape(const LayoutObjectEntryRef &layoutObj,
                                      bool &isActive,
                                      bool &hadChanges)
 {
+    // The runs may have been worked out ahead of time for this view
+    std::vector<std::vector<VectorRing>> shapeRuns;
+    if (layoutObj->shapeRunsView == viewState)
+    {
+        shapeRuns = std::move(layoutObj->shapeRuns);
+    }
+    layoutObj->shapeRuns.clear();
+    layoutObj->shapeRunsView.reset();
+
+    // If the view has only panned since the last time, the same placement should still work
+    const bool keepInstances = viewState->viewMatrices.size() == 1 && !layoutObj->obj.layoutDebug;
+    if (keepInstances && reuseShapeLayout(*layoutObj, viewState, frameBufferSize, overlapMan, hadChanges))
+    {
+        isActive = true;
+        return;
+    }
+    layoutObj->shapeInstances.clear();
+
     const float resScale = renderer->getScale();
 
     for (unsigned int oi=0;oi<viewState->viewMatrices.size();oi++)
@@ -1189,8 +2097,15 @@ void LayoutManager::layoutAlongShape(const LayoutObjectEntryRef &layoutObj,
         LinearTextBuilder textBuilder(viewState,oi,frameBufferSize,
                                       layoutObj->obj.layoutWidth*1.5f,
                                       &layoutObj->obj);
-        textBuilder.setPoints(layoutObj->obj.layoutShape);
-        textBuilder.process();
+        if (oi < shapeRuns.size())
+        {
+            textBuilder.setScreenVecs(std::move(shapeRuns[oi]));
+        }
+        else
+        {
+            textBuilder.setPoints(layoutObj->obj.layoutShape);
+            textBuilder.process();
+        }
         // Sort the runs by length and get rid of the ones too short
 //                    textBuilder.sortRuns(2.0*layoutObj->obj.layoutSpacing);
 
@@ -1207,6 +2122,10 @@ void LayoutManager::layoutAlongShape(const LayoutObjectEntryRef &layoutObj,
         std::vector<Eigen::Matrix3d> layoutMats;
         std::vector<Point2dVector> overlapPts;
 
+        // Where the instances went, if we can keep them for next time
+        std::vector<LayoutObjectEntry::ShapeInstance> newInstances;
+        bool instancesValid = keepInstances && textLen > 0.0;
+
         const auto &runs = textBuilder.getScreenVecsRef();
         for (const auto& run: runs)
         {
@@ -1368,6 +2287,32 @@ void LayoutManager::layoutAlongShape(const LayoutObjectEntryRef &layoutObj,
                 layoutModelInstances.push_back(worldPt);
                 layoutInstances.push_back(layoutMats);
 
+                if (instancesValid)
+                {
+                    // Note where the glyphs went relative to the anchor and how the view looked around it
+                    LayoutObjectEntry::ShapeInstance inst;
+                    inst.worldPt = worldPt;
+                    const Point2f anchor = textBuilder.worldToScreen(worldPt);
+                    const float refDist = resScale * textLen;
+                    instancesValid = textBuilder.screenToWorld(midRun + Point2f(refDist,0.0), inst.refPts[0]) &&
+                                     textBuilder.screenToWorld(midRun + Point2f(0.0,refDist), inst.refPts[1]);
+                    if (instancesValid)
+                    {
+                        for (unsigned int ri=0;ri<2;ri++)
+                        {
+                            inst.refOffsets[ri] = textBuilder.worldToScreen(inst.refPts[ri]) - anchor;
+                        }
+                        inst.glyphMats = layoutMats;
+                        inst.glyphMbrs.reserve(overlapPts.size());
+                        for (const auto &glyph : overlapPts)
+                        {
+                            const Mbr glyphMbr(glyph);
+                            inst.glyphMbrs.emplace_back(glyphMbr.ll() - anchor, glyphMbr.ur() - anchor);
+                        }
+                        newInstances.push_back(std::move(inst));
+                    }
+                }
+
                 // Add the individual glyphs to the overlap manager
                 for (auto &glyph: overlapPts)
                 {
@@ -1384,6 +2329,10 @@ void LayoutManager::layoutAlongShape(const LayoutObjectEntryRef &layoutObj,
 
         if (!layoutInstances.empty())
         {
+            if (instancesValid)
+            {
+                layoutObj->shapeInstances = std::move(newInstances);
+            }
             isActive = true;
             hadChanges = true;
             layoutObj->newEnable = true;
@@ -1476,6 +2425,7 @@ void LayoutManager::buildDrawables(ScreenSpaceBuilder &ssBuild,
         }
 
         layoutObj->obj.offset = layoutObj->offset;
+        layoutObj->drawRanges.clear();
 
         // Note: The animation below doesn't handle offsets
 
@@ -1558,12 +2508,15 @@ void LayoutManager::buildDrawables(ScreenSpaceBuilder &ssBuild,
                 }
             }
 
+            // Keep track of the vertices if we may want to hide them later
+            auto *vertRanges = toggleInPlace ? &layoutObj->drawRanges : nullptr;
+
             // It's a single point placement
             SimpleIDUnorderedSet tempSet;
             if (layoutObj->obj.layoutShape.empty())
             {
                 ssBuild.addScreenObject(layoutObj->obj, layoutObj->obj.worldLoc,
-                                        &layoutObj->obj.geometry, nullptr, &tempSet);
+                                        &layoutObj->obj.geometry, nullptr, &tempSet, vertRanges);
             }
             else
             {
@@ -1572,7 +2525,7 @@ void LayoutManager::buildDrawables(ScreenSpaceBuilder &ssBuild,
                 {
                     ssBuild.addScreenObject(layoutObj->obj, layoutObj->obj.layoutModelPlaces[ii],
                                             &layoutObj->obj.geometry, &layoutObj->obj.layoutPlaces[ii],
-                                            &tempSet);
+                                            &tempSet, vertRanges);
                 }
             }
             if (drawIDSet)
@@ -1641,11 +2594,90 @@ void LayoutManager::buildDrawables(ScreenSpaceBuilder &ssBuild,
     }
 }
 
+bool LayoutManager::toggleDrawables(const LayoutEntrySet &localLayoutObjects,ChangeSet &changes)
+{
+    // Everything that's on has to be in the drawables already, where we left it
+    size_t numDrawn = 0, numHidden = 0;
+    for (const auto &layoutObj : localLayoutObjects)
+    {
+        const bool drawn = !layoutObj->drawRanges.empty();
+        // Instances can be moved, vertices can't
+        const bool moved = layoutObj->offset != layoutObj->obj.offset;
+        const bool canMove = std::all_of(layoutObj->drawRanges.begin(), layoutObj->drawRanges.end(),
+                                         [](const ScreenSpaceBuilder::VertexRange &r) { return r.isInstance; });
+        if (layoutObj->newEnable && (!drawn || (moved && !canMove) ||
+                                     (layoutObj->changed && !layoutObj->obj.layoutShape.empty())))
+        {
+            return false;
+        }
+        if (drawn)
+        {
+            numDrawn++;
+            if (!layoutObj->newEnable)
+            {
+                numHidden++;
+            }
+        }
+    }
+
+    // Once most of what we're drawing is hidden, it's time to clean up
+    if (numHidden * 2 > numDrawn)
+    {
+        return false;
+    }
+
+    // Instance changes are collected so we can send runs of them
+    ScreenSpaceBuilder::InstanceChangeMap instChanges;
+
+    static const RGBAColor hiddenColor(0,0,0,0);
+    const float scale = renderer->getScale();
+    for (const auto &layoutObj : localLayoutObjects)
+    {
+        const bool moved = layoutObj->offset != layoutObj->obj.offset;
+        if (moved && layoutObj->newEnable)
+        {
+            const Point2f delta = ((layoutObj->offset - layoutObj->obj.offset) * scale).cast<float>();
+            for (auto &range : layoutObj->drawRanges)
+            {
+                range.inst.org += delta;
+            }
+            layoutObj->obj.offset = layoutObj->offset;
+        }
+
+        if (layoutObj->newEnable != layoutObj->currentEnable || (moved && layoutObj->newEnable))
+        {
+            for (const auto &range : layoutObj->drawRanges)
+            {
+                if (range.isInstance)
+                {
+                    auto inst = range.inst;
+                    inst.color = layoutObj->newEnable ? range.color : hiddenColor;
+                    instChanges[range.drawID][range.startVert] = inst.getInstance();
+                }
+                else
+                {
+                    changes.push_back(new VertexColorChangeRequest(range.drawID, range.startVert, range.numVerts,
+                                                                   layoutObj->newEnable ? range.color : hiddenColor));
+                }
+            }
+        }
+
+        layoutObj->currentEnable = layoutObj->newEnable;
+        layoutObj->currentCluster = layoutObj->newCluster;
+        layoutObj->changed = false;
+    }
+
+    ScreenSpaceBuilder::AddInstanceChanges(instChanges, changes);
+
+    return true;
+}
+
 void LayoutManager::handleFadeOut(const TimeInterval curTime,
                                   TimeInterval &maxAnimTime,
                                   const LayoutEntrySet &localLayoutObjects,
                                   const SimpleIDSet &oldDrawIDs,
                                   const std::vector<BasicDrawableRef> &newDrawables,
+                                  const std::vector<BasicDrawableInstanceRef> &newInstDrawables,
                                   const std::vector<ClusterEntry> &oldClusters,
                                   const std::vector<ClusterGenerator::ClusterClassParams> &oldClusterParams,
                                   const UnorderedIDSetbyUID &oldUniqueDrawableMap,
@@ -1667,7 +2699,7 @@ void LayoutManager::handleFadeOut(const TimeInterval curTime,
         }
     }
 
-    std::unordered_map<SimpleIdentity,BasicDrawableRef> newDrawsByID;
+    std::unordered_map<SimpleIdentity,DrawableRef> newDrawsByID;
     
     const auto frameInfo = renderer->getFrameInfo();
     UnorderedUIDSet rebuildLayoutIDs(oldUniqueIDsByDrawable.size());
@@ -1699,6 +2731,10 @@ void LayoutManager::handleFadeOut(const TimeInterval curTime,
                     {
                         newDrawsByID.insert(std::make_pair(draw->getId(), draw));
                     }
+                    for (const auto &inst : newInstDrawables)
+                    {
+                        newDrawsByID.insert(std::make_pair(inst->getId(), inst));
+                    }
                 }
 
                 if (checkDrawableOn)
@@ -1758,9 +2794,122 @@ void LayoutManager::handleFadeOut(const TimeInterval curTime,
     }
 }
 
+void LayoutManager::buildDrawablesIncremental(TimeInterval curTime,
+                                              TimeInterval &maxAnimTime,
+                                              const LayoutEntrySet &localLayoutObjects,
+                                              const std::vector<int> &removedBuckets,
+                                              const std::vector<ClusterEntry> &oldClusters,
+                                              const std::vector<ClusterGenerator::ClusterClassParams> &oldClusterParams,
+                                              std::vector<BasicDrawableRef> &newDraws,
+                                              std::vector<BasicDrawableInstanceRef> &newInstDraws,
+                                              ChangeSet &changes)
+{
+    // Coming from the regular mode, all the drawables need replacing
+    const bool rebuildAll = (bucketDrawIDs.size() != LayoutBuckets);
+    if (rebuildAll)
+    {
+        bucketDrawIDs.assign(LayoutBuckets, SimpleIDSet());
+        bucketUniqueIDs.assign(LayoutBuckets, UnorderedIDSetbyUID());
+    }
+
+    // Sort the objects into groups and see which groups have changes
+    std::vector<LayoutEntrySet> bucketObjs(LayoutBuckets);
+    std::vector<bool> dirty(LayoutBuckets, rebuildAll);
+    for (const auto &entry : localLayoutObjects)
+    {
+        const int bucket = layoutBucket(*entry);
+        bucketObjs[bucket].insert(entry);
+        if (entry->changed || entry->currentEnable != entry->newEnable || entry->currentCluster != entry->newCluster)
+        {
+            dirty[bucket] = true;
+        }
+    }
+    for (const int bucket : removedBuckets)
+    {
+        dirty[bucket] = true;
+    }
+
+    // Build the groups that changed, each into its own drawables
+    auto *coordAdapter = scene->getCoordAdapter();
+    const auto oldUniqueDrawableMap = uniqueDrawableIDs;
+    SimpleIDSet oldDrawIDs;
+    SimpleIDSet newDrawIDs;
+    for (int bucket = 0; bucket < LayoutBuckets; bucket++)
+    {
+        if (!dirty[bucket])
+        {
+            continue;
+        }
+        // Stopping partway is fine, the groups we did are still consistent
+        if (UNLIKELY(cancelLayout || !renderer))
+        {
+            break;
+        }
+
+        UnorderedIDSetbyUID bucketUnique;
+        ScreenSpaceBuilder ssBuild(renderer,coordAdapter,renderer->getScale());
+        ssBuild.setInstancing(instancing);
+        buildDrawables(ssBuild, fadeEnabled, /*doClusters=*/false, curTime, &maxAnimTime,
+                       bucketObjs[bucket], oldClusters, oldClusterParams,
+                       &bucketUnique, &oldUniqueDrawableMap);
+
+        SimpleIDSet bucketIDs;
+        const auto bucketDraws = ssBuild.flushChanges(changes, bucketIDs, &newInstDraws);
+        newDraws.insert(newDraws.end(), bucketDraws.begin(), bucketDraws.end());
+        newDrawIDs.insert(bucketIDs.begin(), bucketIDs.end());
+
+        oldDrawIDs.insert(bucketDrawIDs[bucket].begin(), bucketDrawIDs[bucket].end());
+        bucketDrawIDs[bucket].swap(bucketIDs);
+        bucketUniqueIDs[bucket].swap(bucketUnique);
+    }
+
+    // Anything left over from the regular mode goes too, unless we didn't get to everything.
+    // In that case, keep it all and start over next time.
+    if (rebuildAll)
+    {
+        if (cancelLayout)
+        {
+            drawIDs.insert(newDrawIDs.begin(), newDrawIDs.end());
+            bucketDrawIDs.clear();
+            bucketUniqueIDs.clear();
+            return;
+        }
+        oldDrawIDs.insert(drawIDs.begin(), drawIDs.end());
+        drawIDs.clear();
+    }
+
+    if (oldDrawIDs.empty() && newDrawIDs.empty())
+    {
+        return;
+    }
+
+    // Get rid of the replaced drawables
+    for (const auto &drawID : oldDrawIDs)
+    {
+        changes.push_back(new RemDrawableReq(drawID));
+        drawIDs.erase(drawID);
+    }
+    drawIDs.insert(newDrawIDs.begin(), newDrawIDs.end());
+
+    // The unique ID mapping covers all the groups
+    uniqueDrawableIDs.clear();
+    for (const auto &bucketUnique : bucketUniqueIDs)
+    {
+        for (const auto &kv : bucketUnique)
+        {
+            uniqueDrawableIDs[kv.first].insert(kv.second.begin(), kv.second.end());
+        }
+    }
+
+    handleFadeOut(curTime, maxAnimTime, localLayoutObjects, oldDrawIDs, newDraws, newInstDraws,
+                  oldClusters, oldClusterParams, oldUniqueDrawableMap, uniqueDrawableIDs, changes);
+}
+
 // Layout all the objects we're tracking
 void LayoutManager::updateLayout(PlatformThreadInfo *threadInfo,const ViewStateRef &viewState,ChangeSet &changes)
 {
+    WKTraceScope("Layout updateLayout");
+
     CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
 
     if (!vecManage)
@@ -1797,6 +2946,7 @@ void LayoutManager::updateLayout(PlatformThreadInfo *threadInfo,const ViewStateR
     hasUpdates = false;
     const bool hadRemoves = hasRemoves;
     hasRemoves = false;
+    const WorkerPoolRef localWorkers = layoutWorkers;
 
     // Release the external lock to allow objects to be added and removed while we're doing the
     // layout on our copies, and replace it with a separate lock to make sure we're only run once.
@@ -1830,11 +2980,35 @@ void LayoutManager::updateLayout(PlatformThreadInfo *threadInfo,const ViewStateR
     const std::vector<ClusterEntry> oldClusters = std::move(clusters);
     const std::vector<ClusterGenerator::ClusterClassParams> oldClusterParams = std::move(clusterParams);
 
+    // Objects removed since the last pass leave openings and stale drawables behind
+    std::vector<int> removedBuckets;
+    if (incremental)
+    {
+        incrDirty.clear();
+        if (hadRemoves)
+        {
+            for (const auto &entry : prevLayoutObjects)
+            {
+                if (localLayoutObjects.find(entry) == localLayoutObjects.end())
+                {
+                    if (entry->layoutMbr.valid())
+                    {
+                        incrDirty.push_back(entry->layoutMbr);
+                    }
+                    if (entry->currentEnable)
+                    {
+                        removedBuckets.push_back(layoutBucket(*entry));
+                    }
+                }
+            }
+        }
+    }
+
     // This will recalculate the offsets and enables
     // If there were any changes, we need to regenerate
     bool layoutChanges = runLayoutRules(threadInfo, viewState,
                                         localLayoutObjects, localOverrideUUIDs,
-                                        clusters,clusterParams,changes);
+                                        clusters,clusterParams,localWorkers.get(),changes);
 
     // Note: check for cancellation before accessing `clusterGen`.
     // If shutdown has timed out, it will be invalid.
@@ -1866,44 +3040,72 @@ void LayoutManager::updateLayout(PlatformThreadInfo *threadInfo,const ViewStateR
     const TimeInterval curTime = scene->getCurrentTime();
     TimeInterval maxAnimTime = 0.0;
 
-    // Save the drawable mapping from the previous iteration
-    const auto oldUniqueDrawableMap = std::move(uniqueDrawableIDs);
-    uniqueDrawableIDs.clear();
-
-    // Generate the drawables.
-    // Note that the renderer is not managed by a shared pointer, and will be destroyed
-    // during shutdown, so we must stop using it quickly if controller shutdown is initiated.
-    ScreenSpaceBuilder ssBuild(renderer,coordAdapter,renderer->getScale());
+    std::vector<BasicDrawableRef> newDraws;
+    std::vector<BasicDrawableInstanceRef> newInstDraws;
+    if (toggleInPlace && drawRangesValid && !fadeEnabled && !incremental && !hadRemoves &&
+        clusters.empty() && oldClusters.empty() && toggleDrawables(localLayoutObjects, changes))
+    {
+        // Nothing new to build
+    }
+    else if (incremental && clusters.empty() && oldClusters.empty())
+    {
+        drawRangesValid = false;
+        buildDrawablesIncremental(curTime, maxAnimTime, localLayoutObjects, removedBuckets,
+                                  oldClusters, oldClusterParams, newDraws, newInstDraws, changes);
+        if (cancelLayout)
+        {
+            cancelLayout = false;
+            return;
+        }
+    }
+    else
+    {
+        // Everything goes into one set of drawables
+        bucketDrawIDs.clear();
+        bucketUniqueIDs.clear();
+        drawRangesValid = false;
+
+        // Save the drawable mapping from the previous iteration
+        const auto oldUniqueDrawableMap = std::move(uniqueDrawableIDs);
+        uniqueDrawableIDs.clear();
+
+        // Generate the drawables.
+        // Note that the renderer is not managed by a shared pointer, and will be destroyed
+        // during shutdown, so we must stop using it quickly if controller shutdown is initiated.
+        ScreenSpaceBuilder ssBuild(renderer,coordAdapter,renderer->getScale());
+        ssBuild.setInstancing(instancing);
 
-    //wkLog("Starting Layout t=%f", curTime);
+        //wkLog("Starting Layout t=%f", curTime);
 
-    buildDrawables(ssBuild, fadeEnabled, /*doClusters=*/true, curTime, &maxAnimTime,
-                   localLayoutObjects, oldClusters, oldClusterParams,
-                   &uniqueDrawableIDs, &oldUniqueDrawableMap);
+        buildDrawables(ssBuild, fadeEnabled, /*doClusters=*/true, curTime, &maxAnimTime,
+                       localLayoutObjects, oldClusters, oldClusterParams,
+                       &uniqueDrawableIDs, &oldUniqueDrawableMap);
 
-    if (cancelLayout)
-    {
-        cancelLayout = false;
-        return;
-    }
+        if (cancelLayout)
+        {
+            cancelLayout = false;
+            return;
+        }
 
-    // Add the new ones
-    SimpleIDSet newDrawIDs;
-    const auto newDraws = ssBuild.flushChanges(changes, newDrawIDs);
+        // Add the new ones
+        SimpleIDSet newDrawIDs;
+        newDraws = ssBuild.flushChanges(changes, newDrawIDs, &newInstDraws);
 
 //        NSLog(@"Got %lu clusters",clusters.size());
 
-    // Get rid of the last set of drawables
-    for (const auto &drawID : drawIDs)
-    {
-        changes.push_back(new RemDrawableReq(drawID));
-    }
+        // Get rid of the last set of drawables
+        for (const auto &drawID : drawIDs)
+        {
+            changes.push_back(new RemDrawableReq(drawID));
+        }
 
-    handleFadeOut(curTime, maxAnimTime, localLayoutObjects, drawIDs, newDraws,
-                  oldClusters, oldClusterParams, oldUniqueDrawableMap, uniqueDrawableIDs, changes);
+        handleFadeOut(curTime, maxAnimTime, localLayoutObjects, drawIDs, newDraws, newInstDraws,
+                      oldClusters, oldClusterParams, oldUniqueDrawableMap, uniqueDrawableIDs, changes);
 
-    drawIDs.clear();
-    drawIDs.swap(newDrawIDs);
+        drawIDs.clear();
+        drawIDs.swap(newDrawIDs);
+        drawRangesValid = toggleInPlace;
+    }
 
     prevLayoutObjects.swap(localLayoutObjects);
 
@@ -1928,6 +3130,21 @@ void LayoutManager::updateLayout(PlatformThreadInfo *threadInfo,const ViewStateR
                 if (dp->endEnable > 0.0) dp->endEnable += deltaT;
             }
         }
+        for (auto &inst : newInstDraws)
+        {
+            TimeInterval fadeDown,fadeUp;
+            if (inst->getFade(fadeDown,fadeUp))
+            {
+                inst->setFade(fadeDown > 0.0 ? fadeDown + deltaT : fadeDown,
+                              fadeUp > 0.0 ? fadeUp + deltaT : fadeUp);
+            }
+            TimeInterval startEnable,endEnable;
+            if (inst->getEnableTimeRange(startEnable,endEnable))
+            {
+                inst->setEnableTimeRange(startEnable > 0.0 ? startEnable + deltaT : startEnable,
+                                         endEnable > 0.0 ? endEnable + deltaT : endEnable);
+            }
+        }
         for (auto &change : changes)
         {
             if (change->when > 0.0) change->when += deltaT;
@@ -157,6 +157,12 @@ void LinearTextBuilder::sortRuns(double minLen)
 }
 
 void LinearTextBuilder::process()
+{
+    Scratch scratch;
+    process(scratch);
+}
+
+void LinearTextBuilder::process(Scratch &scratch)
 {
     if (pts.size() == 1)
         return;
@@ -169,10 +175,10 @@ void LinearTextBuilder::process()
         VectorRing curRun;
         
         // Project the points and evaluate the individual validity of each one
-        std::vector<bool> isValid;  isValid.reserve(pts.size()+1);
-        std::vector<bool> isFrontSide;  isFrontSide.reserve(pts.size()+1);
-        std::vector<Point2f> projPts;  projPts.reserve(pts.size()+1);
-        for (auto pt: pts) {
+        auto &isValid = scratch.isValid;  isValid.clear();  isValid.reserve(pts.size()+1);
+        auto &isFrontSide = scratch.isFrontSide;  isFrontSide.clear();  isFrontSide.reserve(pts.size()+1);
+        auto &projPts = scratch.projPts;  projPts.clear();  projPts.reserve(pts.size()+1);
+        for (const auto &pt: pts) {
             Point2f thisObjPt = viewState->pointOnScreenFromDisplay(pt,&modelTrans,frameBufferSize);
 
             bool testFrontSide = true;
@@ -236,9 +242,9 @@ void LinearTextBuilder::process()
         }
         
         if (curRun.size() > 1)
-            newRuns.push_back(curRun);
+            newRuns.push_back(std::move(curRun));
         
-        runs = newRuns;
+        runs = std::move(newRuns);
         
 //        wkLogLevel(Debug,"Found %d runs",runs.size());
 //        for (unsigned int ii=0;ii<runs.size();ii++)
@@ -255,10 +261,10 @@ void LinearTextBuilder::process()
             // Generalize the source line
             auto newRun = LineGeneralization(run,generalEps,0,run.size()-1);
             if (newRun.size() > 1)
-                newRuns.push_back(newRun);
+                newRuns.push_back(std::move(newRun));
         }
                 
-        runs = newRuns;
+        runs = std::move(newRuns);
 
 //        wkLogLevel(Debug,"Generalize %d runs",runs.size());
 //        for (unsigned int ii=0;ii<runs.size();ii++)
@@ -278,9 +284,9 @@ void LinearTextBuilder::process()
             else {
                 theseRuns = BufferLinear(run, layoutObj->layoutOffset);
             }
-            newRuns.insert(newRuns.end(),theseRuns.begin(),theseRuns.end());
+            newRuns.insert(newRuns.end(),std::make_move_iterator(theseRuns.begin()),std::make_move_iterator(theseRuns.end()));
         }
-        runs = newRuns;
+        runs = std::move(newRuns);
 
 //        wkLogLevel(Debug,"Offset %d runs",runs.size());
 //        for (unsigned int ii=0;ii<runs.size();ii++)
@@ -19,6 +19,9 @@
 #import "LoadedTileNew.h"
 #import "BasicDrawableBuilder.h"
 #import "WhirlyKitLog.h"
+#import "ElevationManager.h"
+#import <map>
+#import <mutex>
 
 using namespace Eigen;
 
@@ -30,16 +33,78 @@ TileGeomSettings::TileGeomSettings()
       programID(0), sampleX(10), sampleY(10), topSampleX(10), topSampleY(10),
       minVis(DrawVisibleInvalid), maxVis(DrawVisibleInvalid),
       baseDrawPriority(0), drawPriorityPerLevel(1), lineMode(false),
-      includeElev(false), enableGeom(true), singleLevel(false)
+      includeElev(false), elevTextures(false), enableGeom(true), singleLevel(false), meshTemplates(false)
 {
 }
+
+namespace
+{
+// A unit grid, centered on the origin, that flat tiles can share
+struct TileMeshTemplate
+{
+    Point3dVector pts;
+    std::vector<TexCoord> texCoords;
+    std::vector<BasicDrawable::Triangle> tris;
+};
+typedef std::shared_ptr<TileMeshTemplate> TileMeshTemplateRef;
+
+TileMeshTemplateRef getMeshTemplate(int tessX,int tessY)
+{
+    static std::mutex templateLock;
+    static std::map<std::pair<int,int>,TileMeshTemplateRef> templates;
+
+    std::lock_guard<std::mutex> guardLock(templateLock);
+    auto &mesh = templates[std::make_pair(tessX,tessY)];
+    if (mesh)
+        return mesh;
+
+    mesh = std::make_shared<TileMeshTemplate>();
+    mesh->pts.reserve((tessX+1)*(tessY+1));
+    mesh->texCoords.reserve((tessX+1)*(tessY+1));
+    for (int iy=0;iy<tessY+1;iy++)
+        for (int ix=0;ix<tessX+1;ix++)
+        {
+            mesh->pts.emplace_back((double)ix/tessX - 0.5,(double)iy/tessY - 0.5,0.0);
+            mesh->texCoords.emplace_back((float)ix/tessX,1.0-(float)iy/tessY);
+        }
+
+    // Two triangles per cell, same as the regular tiles
+    mesh->tris.reserve(2*tessX*tessY);
+    for (int iy=0;iy<tessY;iy++)
+        for (int ix=0;ix<tessX;ix++)
+        {
+            BasicDrawable::Triangle triA,triB;
+            triA.verts[0] = (iy+1)*(tessX+1)+ix;
+            triA.verts[1] = iy*(tessX+1)+ix;
+            triA.verts[2] = (iy+1)*(tessX+1)+(ix+1);
+            triB.verts[0] = triA.verts[2];
+            triB.verts[1] = triA.verts[1];
+            triB.verts[2] = iy*(tessX+1)+(ix+1);
+            mesh->tris.push_back(triA);
+            mesh->tris.push_back(triB);
+        }
+
+    return mesh;
+}
+}
     
 LoadedTileNew::LoadedTileNew(const QuadTreeNew::ImportantNode &ident,const MbrD &mbr)
     : ident(ident), mbr(mbr), enabled(false),
-      tileNumber(ident.NodeNumber())
+      tileNumber(ident.NodeNumber()), drawPriority(0), geomBytes(0), sharedGeom(false), numChildren(0)
 {
 }
     
+bool LoadedTileNew::canUseTemplate(TileGeomManager *geomManage,const TileGeomSettings &geomSettings) const
+{
+    // Flat displays are a scale and offset from the scene coordinate system,
+    //  so if the tiles are in that same system, every grid is the same grid.
+    const CoordSystemDisplayAdapter *coordAdapter = geomManage->coordAdapter;
+    return geomSettings.meshTemplates && geomSettings.useTileCenters &&
+           !geomSettings.lineMode && !geomSettings.includeElev &&
+           coordAdapter->isFlat() &&
+           geomManage->coordSys->isSameAs(coordAdapter->getCoordSystem());
+}
+
 bool LoadedTileNew::isValidSpatial(TileGeomManager *geomManage)
 {
     const MbrD theMbr = geomManage->quadTree->generateMbrForNode(ident);
@@ -92,7 +157,17 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
     const Point3d chunkMidDisp = (geomSettings.useTileCenters ? dispCenter : Point3d(0,0,0));
 //        wkLogLevel(Debug,"id = %d: (%d,%d),mid = (%f,%f,%f)",ident.level,ident.x,ident.y,chunkMidDisp.x(),chunkMidDisp.y(),chunkMidDisp.z());
     const Eigen::Affine3d trans(Eigen::Translation3d(chunkMidDisp.x(),chunkMidDisp.y(),chunkMidDisp.z()));
-    const Matrix4d transMat = trans.matrix();
+    Matrix4d transMat = trans.matrix();
+
+    // Template tiles are a unit grid, so the matrix does the sizing too
+    const bool useTemplate = canUseTemplate(geomManage,geomSettings);
+    if (useTemplate)
+    {
+        // Use the exact middle here or neighboring tiles won't quite meet
+        const Eigen::Affine3d exactTrans(Eigen::Translation3d((ll.x()+ur.x())/2.0,(ll.y()+ur.y())/2.0,0.0));
+        const Eigen::Affine3d scale(Eigen::Scaling(ur.x()-ll.x(),ur.y()-ll.y(),1.0));
+        transMat = (exactTrans * scale).matrix();
+    }
 
     // Size of each chunk
     const Point2d chunkSize = theMbr.ur() - theMbr.ll();
@@ -149,6 +224,9 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
     chunk->setLocalMbr(Mbr(Point2f(geoLL.x(),geoLL.y()),Point2f(geoUR.x(),geoUR.y())));
     chunk->setProgram(geomSettings.programID);
     chunk->setOnOff(false);
+    // Raised tiles on a flat map have to sort by depth
+    if (geomSettings.elevTextures)
+        chunk->setRequestZBuffer(true);
 
     // Might need another drawable for poles
     bool separatePoleChunk = false;
@@ -173,6 +251,30 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
     } else
         poleChunk = chunk;
     
+    // The grid points, for the skirts
+    Point3dVector locs;
+    std::vector<TexCoord> texCoords;
+
+    if (useTemplate)
+    {
+        chunk->setType(Triangles);
+
+        const auto mesh = getMeshTemplate(sphereTessX,sphereTessY);
+        const Point3d norm3D = geomManage->coordAdapter->normalForLocal(dispCenter);
+        locs = mesh->pts;
+        texCoords.reserve(mesh->texCoords.size());
+        for (unsigned int ii=0;ii<mesh->pts.size();ii++)
+        {
+            const TexCoord &texCoord = mesh->texCoords[ii];
+            // Clipped tiles only show part of the texture
+            texCoords.emplace_back(texCoord.x()*texScale.x(),1.0-(1.0-texCoord.y())*texScale.y());
+            chunk->addPoint(mesh->pts[ii]);
+            chunk->addNormal(norm3D);
+            chunk->addTexCoord(-1,texCoords.back());
+        }
+        for (const auto &tri : mesh->tris)
+            chunk->addTriangle(tri);
+    } else
     // We're in line mode or the texture didn't load
     if (geomSettings.lineMode)
     {
@@ -206,32 +308,47 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
     } else {
         chunk->setType(Triangles);
         // Generate point, texture coords, and normals
-        Point3dVector locs((sphereTessX+1)*(sphereTessY+1));
-        std::vector<float> elevs;
-        if (geomSettings.includeElev)
-            elevs.resize((sphereTessX+1)*(sphereTessY+1));
-        std::vector<TexCoord> texCoords((sphereTessX+1)*(sphereTessY+1));
+        locs.resize((sphereTessX+1)*(sphereTessY+1));
+        texCoords.resize((sphereTessX+1)*(sphereTessY+1));
+        const float locZ = 0.0;
         for (unsigned int iy=0;iy<sphereTessY+1;iy++)
         {
             for (unsigned int ix=0;ix<sphereTessX+1;ix++)
             {
-                float locZ = 0.0;
-                const auto cs = geomManage->coordSys.get();
-                auto loc3D = geomManage->coordAdapter->localToDisplay(CoordSystemConvert3d(cs,sceneCoordSys,Point3d(chunkLL.x()+ix*incr.x(),chunkLL.y()+iy*incr.y(),locZ)));
-                if (geomManage->coordAdapter->isFlat())
-                    loc3D.z() = locZ;
-                
-                // Use Z priority to sort the levels
-                //                    if (singleLevel != -1)
-                //                        loc3D.z() = (drawPriority + nodeInfo->ident.level * 0.01)/10000;
-                
-                locs[iy*(sphereTessX+1)+ix] = loc3D;
+                locs[iy*(sphereTessX+1)+ix] = Point3d(chunkLL.x()+ix*incr.x(),chunkLL.y()+iy*incr.y(),locZ);
                 
                 // Do the texture coordinate separately
                 const TexCoord texCoord(ix*texIncr.x(),1.0-(iy*texIncr.y()));
                 texCoords[iy*(sphereTessX+1)+ix] = texCoord;
             }
         }
+
+        // Lift the grid to the terrain with whatever elevation tiles are loaded
+        if (geomSettings.includeElev && !geomManage->coordAdapter->isFlat())
+        {
+            const auto elevManager = sceneRender->getScene()->getManager<ElevationManager>(kWKElevationManager);
+            if (elevManager && elevManager->hasData())
+            {
+                Point2dVector geoLocs(locs.size());
+                std::vector<double> elevs(locs.size());
+                geomManage->coordSys->localToGeographicBatch(locs.data(),geoLocs.data(),locs.size());
+                elevManager->heightsAt(geoLocs.data(),elevs.data(),elevs.size());
+                for (unsigned int ii=0;ii<locs.size();ii++)
+                    locs[ii].z() = elevs[ii];
+            }
+        }
+
+        // Take the whole grid to display coordinates in a couple of passes
+        CoordSystemConvertBatch(geomManage->coordSys.get(),sceneCoordSys,locs.data(),locs.data(),locs.size());
+        geomManage->coordAdapter->localToDisplayBatch(locs.data(),locs.data(),locs.size());
+        if (geomManage->coordAdapter->isFlat())
+        {
+            // Use Z priority to sort the levels
+            //                    if (singleLevel != -1)
+            //                        loc3D.z() = (drawPriority + nodeInfo->ident.level * 0.01)/10000;
+            for (auto &loc3D : locs)
+                loc3D.z() = locZ;
+        }
         
         // Without elevation data we can share the vertices
         for (unsigned int iy=0;iy<sphereTessY+1;iy++)
@@ -272,72 +389,6 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
             }
         }
         
-        if (geomManage->buildSkirts && !geomManage->coordAdapter->isFlat())
-        {
-            // We'll set up and fill in the drawable
-            const auto skirtChunk = sceneRender->makeBasicDrawableBuilder("LoadedTileNew SkirtChunk");
-            drawables.push_back(skirtChunk);
-            if (geomSettings.useTileCenters)
-                skirtChunk->setMatrix(&transMat);
-            // We hard-wire this to appear after the atmosphere.  A bit hacky.
-            skirtChunk->setupTexCoordEntry(0, 0);
-            skirtChunk->setDrawOrder(drawOrder);
-            skirtChunk->setDrawPriority(11);
-            skirtChunk->setVisibleRange(geomSettings.minVis, geomSettings.maxVis);
-//            skirtChunk->setColor(geomSettings.color);
-            skirtChunk->setLocalMbr(Mbr(Point2f(geoLL.x(),geoLL.y()),Point2f(geoUR.x(),geoUR.y())));
-            skirtChunk->setType(Triangles);
-            // We need the skirts rendered with the z buffer on, even if we're doing (mostly) pure sorting
-            skirtChunk->setRequestZBuffer(true);
-            skirtChunk->setProgram(geomSettings.programID);
-            skirtChunk->setOnOff(false);
-            drawInfo.emplace_back(DrawableSkirt,skirtChunk->getDrawableID(),skirtChunk->getDrawablePriority(),drawOrder);
-
-            // We'll vary the skirt size a bit.  Otherwise the fill gets ridiculous when we're looking
-            //  at the very highest levels.  On the other hand, this doesn't fix a really big large/small
-            //  disparity
-            const float skirtFactor = 1.0 - 0.2 / (1<<ident.level);
-            
-            // Bottom skirt
-            Point3dVector skirtLocs;
-            std::vector<TexCoord> skirtTexCoords;
-            skirtLocs.reserve(sphereTessX);
-            skirtTexCoords.reserve(sphereTessX);
-            for (unsigned int ix=0;ix<=sphereTessX;ix++)
-            {
-                skirtLocs.push_back(locs[ix]);
-                skirtTexCoords.push_back(texCoords[ix]);
-            }
-            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,chunkMidDisp);
-            // Top skirt
-            skirtLocs.clear();
-            skirtTexCoords.clear();
-            for (int ix=sphereTessX;ix>=0;ix--)
-            {
-                skirtLocs.push_back(locs[(sphereTessY)*(sphereTessX+1)+ix]);
-                skirtTexCoords.push_back(texCoords[(sphereTessY)*(sphereTessX+1)+ix]);
-            }
-            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,chunkMidDisp);
-            // Left skirt
-            skirtLocs.clear();
-            skirtTexCoords.clear();
-            for (int iy=sphereTessY;iy>=0;iy--)
-            {
-                skirtLocs.push_back(locs[(sphereTessX+1)*iy+0]);
-                skirtTexCoords.push_back(texCoords[(sphereTessX+1)*iy+0]);
-            }
-            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,chunkMidDisp);
-            // right skirt
-            skirtLocs.clear();
-            skirtTexCoords.clear();
-            for (int iy=0;iy<=sphereTessY;iy++)
-            {
-                skirtLocs.push_back(locs[(sphereTessX+1)*iy+(sphereTessX)]);
-                skirtTexCoords.push_back(texCoords[(sphereTessX+1)*iy+(sphereTessX)]);
-            }
-            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,chunkMidDisp);
-        }
-        
         if (geomManage->coverPoles && !geomManage->coordAdapter->isFlat())
         {
             // If we're at the top, toss in a few more triangles to represent that
@@ -426,16 +477,101 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
         }
     }
 
+    // Skirts hide the cracks between tiles.  When the shader raises tiles, flat maps need them too.
+    const bool isFlat = geomManage->coordAdapter->isFlat();
+    if (geomManage->buildSkirts && !geomSettings.lineMode && !locs.empty() &&
+        (!isFlat || geomSettings.elevTextures))
+    {
+        // We'll set up and fill in the drawable
+        const auto skirtChunk = sceneRender->makeBasicDrawableBuilder("LoadedTileNew SkirtChunk");
+        drawables.push_back(skirtChunk);
+        if (geomSettings.useTileCenters)
+            skirtChunk->setMatrix(&transMat);
+        // We hard-wire this to appear after the atmosphere.  A bit hacky.
+        skirtChunk->setupTexCoordEntry(0, 0);
+        skirtChunk->setDrawOrder(drawOrder);
+        skirtChunk->setDrawPriority(11);
+        skirtChunk->setVisibleRange(geomSettings.minVis, geomSettings.maxVis);
+//        skirtChunk->setColor(geomSettings.color);
+        skirtChunk->setLocalMbr(Mbr(Point2f(geoLL.x(),geoLL.y()),Point2f(geoUR.x(),geoUR.y())));
+        skirtChunk->setType(Triangles);
+        // We need the skirts rendered with the z buffer on, even if we're doing (mostly) pure sorting
+        skirtChunk->setRequestZBuffer(true);
+        skirtChunk->setProgram(geomSettings.programID);
+        skirtChunk->setOnOff(false);
+        drawInfo.emplace_back(DrawableSkirt,skirtChunk->getDrawableID(),skirtChunk->getDrawablePriority(),drawOrder);
+
+        // We'll vary the skirt size a bit.  Otherwise the fill gets ridiculous when we're looking
+        //  at the very highest levels.  On the other hand, this doesn't fix a really big large/small
+        //  disparity
+        const float skirtFactor = 1.0 - 0.2 / (1<<ident.level);
+        // On a flat map they hang straight down, a tenth of the tile's size
+        const double flatDrop = isFlat ? 0.1 * std::max(std::abs(ur.x()-ll.x()),std::abs(ur.y()-ll.y())) : 0.0;
+        // Template points are already relative to the tile
+        const Point3d skirtCenter = useTemplate ? Point3d(0,0,0) : chunkMidDisp;
+
+        // Bottom skirt
+        Point3dVector skirtLocs;
+        std::vector<TexCoord> skirtTexCoords;
+        skirtLocs.reserve(sphereTessX+1);
+        skirtTexCoords.reserve(sphereTessX+1);
+        for (unsigned int ix=0;ix<=sphereTessX;ix++)
+        {
+            skirtLocs.push_back(locs[ix]);
+            skirtTexCoords.push_back(texCoords[ix]);
+        }
+        buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,skirtCenter,flatDrop);
+        // Top skirt
+        skirtLocs.clear();
+        skirtTexCoords.clear();
+        for (int ix=sphereTessX;ix>=0;ix--)
+        {
+            skirtLocs.push_back(locs[(sphereTessY)*(sphereTessX+1)+ix]);
+            skirtTexCoords.push_back(texCoords[(sphereTessY)*(sphereTessX+1)+ix]);
+        }
+        buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,skirtCenter,flatDrop);
+        // Left skirt
+        skirtLocs.clear();
+        skirtTexCoords.clear();
+        for (int iy=sphereTessY;iy>=0;iy--)
+        {
+            skirtLocs.push_back(locs[(sphereTessX+1)*iy+0]);
+            skirtTexCoords.push_back(texCoords[(sphereTessX+1)*iy+0]);
+        }
+        buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,skirtCenter,flatDrop);
+        // right skirt
+        skirtLocs.clear();
+        skirtTexCoords.clear();
+        for (int iy=0;iy<=sphereTessY;iy++)
+        {
+            skirtLocs.push_back(locs[(sphereTessX+1)*iy+(sphereTessX)]);
+            skirtTexCoords.push_back(texCoords[(sphereTessX+1)*iy+(sphereTessX)]);
+        }
+        buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,skirtCenter,flatDrop);
+    }
+
+    // Let the renderer skip tiles around the back of the globe.
+    // Raised tiles can peek over the horizon, so leave room for the highest mountains, exaggerated a bit.
+    if (!isFlat)
+    {
+        const double extraHeight = geomSettings.elevTextures ? 0.01 : 0.0;
+        for (const auto &draw : drawables)
+            draw->calcHorizonBound(extraHeight);
+    }
+
     changes.reserve(changes.size() + drawables.size());
     for (const auto &draw : drawables) {
+        geomBytes += draw->getNumPoints() * (sizeof(Point3f) + sizeof(TexCoord)) +
+                     draw->getNumTris() * 3 * sizeof(uint16_t);
         changes.push_back(new AddDrawableReq(draw->getDrawable()));
     }
 }
     
 void LoadedTileNew::buildSkirt(const BasicDrawableBuilderRef &draw,const Point3dVector &pts,
                                const std::vector<TexCoord> &texCoords,double skirtFactor,
-                               bool haveElev,const Point3d &theCenter)
+                               bool haveElev,const Point3d &theCenter,double flatDrop)
 {
+    const Point3d drop(0.0,0.0,flatDrop);
     for (unsigned int ii=0;ii<pts.size()-1;ii++)
     {
         Point3d corners[4];
@@ -444,12 +580,16 @@ void LoadedTileNew::buildSkirt(const BasicDrawableBuilderRef &draw,const Point3d
         cornerTex[0] = texCoords[ii];
         corners[1] = pts[ii+1];
         cornerTex[1] = texCoords[ii+1];
-        if (haveElev)
+        if (flatDrop > 0.0)
+            corners[2] = pts[ii+1] - drop;
+        else if (haveElev)
             corners[2] = pts[ii+1].normalized();
         else
             corners[2] = pts[ii+1] * skirtFactor;
         cornerTex[2] = texCoords[ii+1];
-        if (haveElev)
+        if (flatDrop > 0.0)
+            corners[3] = pts[ii] - drop;
+        else if (haveElev)
             corners[3] = pts[ii].normalized();
         else
             corners[3] = pts[ii] * skirtFactor;
@@ -457,10 +597,10 @@ void LoadedTileNew::buildSkirt(const BasicDrawableBuilderRef &draw,const Point3d
         
         // Toss in the points, but point the normal up
         const int base = draw->getNumPoints();
+        const Point3d norm = flatDrop > 0.0 ? Point3d(0,0,1) : Point3d((pts[ii]+pts[ii+1])/2.f);
         for (unsigned int jj=0;jj<4;jj++)
         {
             draw->addPoint(Point3d(corners[jj]-theCenter));
-            const Point3d norm = (pts[ii]+pts[ii+1])/2.f;
             draw->addNormal(norm);
             const TexCoord texCoord = cornerTex[jj];
             draw->addTexCoord(-1,texCoord);
@@ -510,8 +650,13 @@ TileGeomManager::TileGeomManager() :
     coordAdapter(nullptr), coverPoles(false),
     useNorthPoleColor(false), northPoleColor(255,255,255,255),
     useSouthPoleColor(false), southPoleColor(255,255,255,255),
-    buildSkirts(false)
+    buildSkirts(false), shareGeom(true)
+{
+}
+
+TileGeomManager::~TileGeomManager()
 {
+    TileGeomCache::getShared().removeManager(this);
 }
 
 void TileGeomManager::setup(SceneRenderer *inSceneRender,TileGeomSettings &geomSettings,
@@ -532,12 +677,21 @@ TileGeomManager::NodeChanges TileGeomManager::addRemoveTiles(
 {
     NodeChanges nodeChanges;
 
+    // Only the tiles whose children came or went need a look afterwards
+    LoadedTileVec checkTiles;
+
     for (const auto &ident: removeTiles) {
         const auto it = tileMap.find(ident);
         if (it != tileMap.end()) {
             const auto &tile = it->second;
-            tile->removeDrawables(changes);
+            if (!tile->sharedGeom || TileGeomCache::getShared().release(this,ident))
+                tile->removeDrawables(changes);
             tileMap.erase(it);
+
+            if (const auto parent = getParent(ident)) {
+                parent->numChildren--;
+                checkTiles.push_back(parent);
+            }
         }
     }
 
@@ -550,14 +704,36 @@ TileGeomManager::NodeChanges TileGeomManager::addRemoveTiles(
             const auto tile = std::make_shared<LoadedTileNew>(ident, nodeMbr);
             if (tile->isValidSpatial(this))
             {
-                tile->makeDrawables(sceneRender,this,settings,changes);
+                // Someone else may have built this one already
+                const bool share = canShareGeom();
+                if (!share || !TileGeomCache::getShared().acquire(this,sceneRender->getScene(),*tile))
+                {
+                    tile->makeDrawables(sceneRender,this,settings,changes);
+                    if (share)
+                        TileGeomCache::getShared().add(this,*tile);
+                }
+                // Children can show up before their parents
+                if (ident.level < quadTree->maxLevel-1) {
+                    for (int iy=0;iy<2;iy++)
+                        for (int ix=0;ix<2;ix++) {
+                            const QuadTreeNew::Node child(ident.x*2+ix,ident.y*2+iy,ident.level+1);
+                            if (tileMap.find(child) != tileMap.end())
+                                tile->numChildren++;
+                        }
+                }
+                if (const auto parent = getParent(ident)) {
+                    parent->numChildren++;
+                    checkTiles.push_back(parent);
+                }
+
                 tileMap[ident] = tile;
                 nodeChanges.addedTiles.push_back(tile);
+                checkTiles.push_back(tile);
             }
         }
     }
     
-    updateParents(changes,nodeChanges.enabledTiles,nodeChanges.disabledTiles);
+    updateParents(checkTiles,changes,nodeChanges.enabledTiles,nodeChanges.disabledTiles);
     
     return nodeChanges;
 }
@@ -566,12 +742,59 @@ void TileGeomManager::cleanup(ChangeSet &changes)
 {
     for (const auto &tileInst: tileMap) {
         const auto &tile = tileInst.second;
-        tile->removeDrawables(changes);
+        if (!tile->sharedGeom || TileGeomCache::getShared().release(this,tileInst.first))
+            tile->removeDrawables(changes);
     }
     
     tileMap.clear();
+    TileGeomCache::getShared().removeManager(this);
 }
     
+TileMemoryUsage TileGeomManager::getMemoryUsage() const
+{
+    TileMemoryUsage usage;
+    for (const auto &tile: tileMap) {
+        usage.bytes += tile.second->geomBytes;
+    }
+    if (!tileMap.empty())
+        usage.bytesPerTile = usage.bytes / tileMap.size();
+
+    return usage;
+}
+
+bool TileGeomManager::sameGeometry(const TileGeomManager &that) const
+{
+    const TileGeomSettings &a = settings, &b = that.settings;
+    if (a.buildGeom != b.buildGeom || a.useTileCenters != b.useTileCenters ||
+        !(a.color == b.color) || a.programID != b.programID ||
+        a.sampleX != b.sampleX || a.sampleY != b.sampleY ||
+        a.topSampleX != b.topSampleX || a.topSampleY != b.topSampleY ||
+        a.minVis != b.minVis || a.maxVis != b.maxVis ||
+        a.baseDrawPriority != b.baseDrawPriority || a.drawPriorityPerLevel != b.drawPriorityPerLevel ||
+        a.lineMode != b.lineMode || a.includeElev != b.includeElev || a.elevTextures != b.elevTextures ||
+        a.enableGeom != b.enableGeom || a.singleLevel != b.singleLevel ||
+        a.meshTemplates != b.meshTemplates)
+        return false;
+
+    if (sceneRender != that.sceneRender || coordAdapter != that.coordAdapter ||
+        !quadTree || !that.quadTree || !(quadTree->mbr == that.quadTree->mbr) ||
+        !(mbr == that.mbr) || coverPoles != that.coverPoles || buildSkirts != that.buildSkirts)
+        return false;
+
+    if (useNorthPoleColor != that.useNorthPoleColor || (useNorthPoleColor && !(northPoleColor == that.northPoleColor)) ||
+        useSouthPoleColor != that.useSouthPoleColor || (useSouthPoleColor && !(southPoleColor == that.southPoleColor)))
+        return false;
+
+    return coordSys && that.coordSys &&
+           (coordSys == that.coordSys || coordSys->isSameAs(that.coordSys.get()));
+}
+
+bool TileGeomManager::canShareGeom() const
+{
+    // If we're turning the geometry on and off ourselves, nobody else can use it
+    return shareGeom && settings.buildGeom && !settings.enableGeom && sceneRender;
+}
+
 std::vector<LoadedTileNewRef> TileGeomManager::getTiles(const QuadTreeNew::NodeSet &tiles)
 {
     std::vector<LoadedTileNewRef> retTiles;
@@ -605,28 +828,32 @@ LoadedTileNewRef TileGeomManager::getTile(const QuadTreeNew::Node &ident)
     const auto it = tileMap.find(ident);
     return (it != tileMap.end()) ? it->second : LoadedTileNewRef();
 }
+
+LoadedTileNewRef TileGeomManager::getParent(const QuadTreeNew::Node &ident)
+{
+    if (ident.level == 0)
+        return LoadedTileNewRef();
+
+    return getTile(QuadTreeNew::Node(ident.x/2,ident.y/2,ident.level-1));
+}
     
-void TileGeomManager::updateParents(ChangeSet &changes,LoadedTileVec &enabledNodes,LoadedTileVec &disabledNodes)
+void TileGeomManager::updateParents(const LoadedTileVec &tiles,ChangeSet &changes,LoadedTileVec &enabledNodes,LoadedTileVec &disabledNodes)
 {
     // No parent logic with single level.  Everything is on.
     if (settings.singleLevel)
         return;
     
-    for (const auto &entry : tileMap) {
-        const auto ident = entry.first;
-        const auto tile = entry.second;
+    // A tile can be on the list more than once, but it only flips the first time
+    for (const auto &tile : tiles) {
+        const auto &ident = tile->ident;
         
         if (ident.level < quadTree->maxLevel-1) {
-            bool childPresent = false;
-            for (int iy=0;iy<2;iy++)
-                for (int ix=0;ix<2;ix++) {
-                    QuadTreeNew::Node child(ident.x*2+ix,ident.y*2+iy,ident.level+1);
-                    if (tileMap.find(child) != tileMap.end()) {
-                        childPresent = true;
-                        break;
-                    }
-                }
-            if (childPresent)
+            // May have been removed after its child was
+            const auto it = tileMap.find(ident);
+            if (it == tileMap.end() || it->second != tile)
+                continue;
+
+            if (tile->numChildren > 0)
             {
                 if (tile->enabled)
                 {
@@ -643,4 +870,109 @@ void TileGeomManager::updateParents(ChangeSet &changes,LoadedTileVec &enabledNod
     }
 }
 
+
+TileGeomCache &TileGeomCache::getShared()
+{
+    static TileGeomCache shared;
+    return shared;
+}
+
+TileGeomCache::Group *TileGeomCache::findGroup(const TileGeomManager *geomManage)
+{
+    for (const auto &group : groups)
+        if (std::find(group->managers.begin(),group->managers.end(),geomManage) != group->managers.end())
+            return group.get();
+
+    for (const auto &group : groups)
+        if (!group->managers.empty() && group->managers.front()->sameGeometry(*geomManage))
+        {
+            group->managers.push_back(geomManage);
+            return group.get();
+        }
+
+    groups.push_back(std::make_shared<Group>());
+    groups.back()->managers.push_back(geomManage);
+    return groups.back().get();
+}
+
+bool TileGeomCache::acquire(const TileGeomManager *geomManage,Scene *scene,LoadedTileNew &tile)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    Group *group = findGroup(geomManage);
+    const auto it = group->tiles.find(tile.ident);
+    if (it == group->tiles.end())
+        return false;
+    Entry &entry = it->second;
+
+    // The manager that built it may not have flushed its changes yet and
+    // instances that get to the scene before their drawable are dropped
+    if (!scene)
+        return false;
+    for (const auto &di : entry.drawInfo)
+        if (!scene->getDrawable(di.drawID))
+            return false;
+
+    tile.drawInfo = entry.drawInfo;
+    tile.geomBytes = entry.geomBytes;
+    tile.drawPriority = entry.drawPriority;
+    tile.enabled = true;
+    tile.sharedGeom = true;
+    entry.refs++;
+
+    return true;
+}
+
+void TileGeomCache::add(const TileGeomManager *geomManage,LoadedTileNew &tile)
+{
+    if (tile.drawInfo.empty())
+        return;
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    Group *group = findGroup(geomManage);
+    // We lost the race, so this one stays private
+    if (group->tiles.find(tile.ident) != group->tiles.end())
+        return;
+
+    Entry &entry = group->tiles[tile.ident];
+    entry.drawInfo = tile.drawInfo;
+    entry.geomBytes = tile.geomBytes;
+    entry.drawPriority = tile.drawPriority;
+    entry.refs = 1;
+    tile.sharedGeom = true;
+}
+
+bool TileGeomCache::release(const TileGeomManager *geomManage,const QuadTreeNew::Node &ident)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    Group *group = findGroup(geomManage);
+    const auto it = group->tiles.find(ident);
+    if (it == group->tiles.end())
+        return true;
+    if (--it->second.refs > 0)
+        return false;
+
+    group->tiles.erase(it);
+    return true;
+}
+
+void TileGeomCache::removeManager(const TileGeomManager *geomManage)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    for (auto git = groups.begin(); git != groups.end(); ++git)
+    {
+        auto &managers = (*git)->managers;
+        const auto it = std::find(managers.begin(),managers.end(),geomManage);
+        if (it == managers.end())
+            continue;
+        managers.erase(it);
+        if (managers.empty())
+            groups.erase(git);
+        return;
+    }
+}
+
 }
@@ -22,9 +22,11 @@
 #import "Tesselator.h"
 #import "BaseInfo.h"
 #import "SharedAttributes.h"
+#import "clipper.hpp"
 
 using namespace Eigen;
 using namespace WhirlyKit;
+using namespace ClipperLib;
 
 namespace WhirlyKit
 {
@@ -35,7 +37,8 @@ LoftedPolyInfo::LoftedPolyInfo()
     outline(true), outlineSide(false), outlineBottom(false),
     outlineDrawPriority(MaplyLoftedPolysDrawPriorityDefault+1),
     color(255,255,255,255), outlineColor(255,255,255,255), outlineWidth(1.0),
-    centered(false), hasCenter(false), center(0.0,0.0), gridSize(10.0 / 180.0 * M_PI)
+    centered(false), hasCenter(false), center(0.0,0.0), gridSize(10.0 / 180.0 * M_PI),
+    shaderExtrude(false), mergeRoofs(false)
 {
     zBufferRead = true;
     zBufferWrite = false;
@@ -68,6 +71,8 @@ LoftedPolyInfo::LoftedPolyInfo(const Dictionary &dict)
     }
     // 10 degress by default
     gridSize = dict.getDouble(MaplyLoftedPolyGridSize,10.0 / 180.0 * M_PI);
+    shaderExtrude = dict.getBool(MaplyLoftedPolyShaderExtrude,false);
+    mergeRoofs = dict.getBool(MaplyLoftedPolyMergeRoofs,false);
 }
 
 /* Drawable Builder
@@ -95,6 +100,12 @@ public:
         center = newCenter;
         geoCenter = inGeoCenter;
     }
+
+    // Leave the triangles on the ground and have this program raise them
+    void setExtrudeProgram(SimpleIdentity progID)
+    {
+        extrudeProgID = progID;
+    }
     
     // Initialize or flush a drawable, as needed
     void setupDrawable(int numToAdd)
@@ -106,6 +117,7 @@ public:
                 flush();
             
             drawable = sceneRender->makeBasicDrawableBuilder("Lofted Poly");
+            drawable->setCompactNormals();
             drawable->setType(primType);
             // Adjust according to the vector info
             //            drawable->setOnOff(polyInfo.enable);
@@ -116,57 +128,107 @@ public:
                 drawable->setLineWidth(polyInfo.outlineWidth);
                 drawable->setDrawPriority(polyInfo.outlineDrawPriority);
             }
+            heightAttr = -1;
+            if (primType == Triangles && extrudeProgID != EmptyIdentity)
+            {
+                // Positions are relative to the center, so the shader needs it to find up on the globe
+                drawable->setProgram(extrudeProgID);
+                heightAttr = drawable->addAttribute(BDFloatType,a_heightNameID);
+                SingleVertexAttributeSet uniforms;
+                uniforms.insert(SingleVertexAttribute(u_originNameID,-1,(float)center.x(),(float)center.y(),(float)center.z()));
+                uniforms.insert(SingleVertexAttribute(u_globeNameID,-1,scene->getCoordAdapter()->isFlat() ? 0.0f : 1.0f));
+                drawable->setUniforms(uniforms);
+            }
         }
     }
-    
-    // Add a triangle, keeping track of limits
-    void addLoftTriangle(Point2f verts[3],float height)
+
+    // Add a vertex the given height above a point on the ground.
+    // When extruding, the height goes in an attribute and the shader does the raising.
+    int addVert(const Point3d &groundPt,const Point3d &up,const Point3d &norm,float height)
     {
-        CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
-        setupDrawable(3);
-        
-        int startVert = drawable->getNumPoints();
-        for (unsigned int ii=0;ii<3;ii++)
+        int vert;
+        if (heightAttr >= 0)
         {
-            // Get some real world coordinates and corresponding normal
-            Point2f &geoPt = verts[ii];
-            Point2d geoCoordD(geoPt.x()+geoCenter.x(),geoPt.y()+geoCenter.y());
-            Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal(geoCoordD);
-            Point3d dispPt = coordAdapter->localToDisplay(localPt);
-            Point3d norm = coordAdapter->normalForLocal(localPt);
-            Point3d pt1 = dispPt + norm * height - center;
-            
-            drawable->addPoint(pt1);
-            drawable->addNormal(norm);
-        }
-        
-        BasicDrawable::Triangle tri;
-        tri.verts[0] = startVert;
-        tri.verts[1] = startVert+1;
-        tri.verts[2] = startVert+2;
-        drawable->addTriangle(tri);
+            vert = (int)drawable->addPoint((Point3d)(groundPt - center));
+            drawable->addAttributeValue(heightAttr,height);
+        } else
+            vert = (int)drawable->addPoint((Point3d)(groundPt + up * height - center));
+        drawable->addNormal(norm);
+        return vert;
     }
     
+    // Where a mesh vertex went in the current drawable, at the top and the base
+    struct MeshVert
+    {
+        int drawIdx = -1;
+        int top = -1, base = -1;
+    };
+
+    // Add a mesh vertex at the given height, if it's not already in this drawable
+    int addMeshVert(const VectorTriangles &mesh,int which,float height,int &vert)
+    {
+        if (vert >= 0)
+            return vert;
+
+        CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
+        const Point3f &geoPt = mesh.pts[which];
+        const Point2d geoCoordD(geoPt.x()+geoCenter.x(),geoPt.y()+geoCenter.y());
+        const Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal(geoCoordD);
+        const Point3d dispPt = coordAdapter->localToDisplay(localPt);
+        const Point3d norm = coordAdapter->normalForLocal(localPt);
+
+        vert = addVert(dispPt,norm,norm,height);
+        return vert;
+    }
+
     // Add a whole mess of triangles, adding
     //  in the height
     void addPolyGroup(VectorTrianglesRef mesh)
     {
-        for (unsigned int ii=0;ii<mesh->tris.size();ii++)
+        // The tops of all the polygons are one mesh, so we share its vertices
+        //  rather than making three new ones for every triangle
+        const bool doBase = (polyInfo.base > 0.0);
+        std::vector<MeshVert> meshVerts(mesh->pts.size());
+        int drawIdx = 0;
+        const BasicDrawableBuilder *lastDrawable = nullptr;
+        for (const auto &tri : mesh->tris)
         {
-            VectorRing tri;
-            mesh->getTriangle(ii, tri);
-            if (tri.size() == 3)
+            const int numPts = (int)mesh->pts.size();
+            if (tri.pts[0] < 0 || tri.pts[0] >= numPts ||
+                tri.pts[1] < 0 || tri.pts[1] >= numPts ||
+                tri.pts[2] < 0 || tri.pts[2] >= numPts)
+                continue;
+
+            setupDrawable(doBase ? 6 : 3);
+            if (drawable.get() != lastDrawable)
             {
-                Point2f verts[3];
-                verts[2] = tri[0];  verts[1] = tri[1];  verts[0] = tri[2];
-                addLoftTriangle(verts,polyInfo.height);
-                // If they've got a base, we want to see it from the underside, probably
-                if (polyInfo.base > 0.0)
+                // New drawable, so none of the vertices are in it yet
+                lastDrawable = drawable.get();
+                drawIdx++;
+            }
+
+            int top[3],base[3];
+            for (unsigned int ii=0;ii<3;ii++)
+            {
+                MeshVert &meshVert = meshVerts[tri.pts[ii]];
+                if (meshVert.drawIdx != drawIdx)
                 {
-                    Point2f verts[3];
-                    verts[1] = tri[0];  verts[2] = tri[1];  verts[0] = tri[2];
-                    addLoftTriangle(verts,polyInfo.base);
+                    meshVert = MeshVert();
+                    meshVert.drawIdx = drawIdx;
                 }
+                top[ii] = addMeshVert(*mesh,tri.pts[ii],polyInfo.height,meshVert.top);
+                if (doBase)
+                    base[ii] = addMeshVert(*mesh,tri.pts[ii],polyInfo.base,meshVert.base);
+            }
+
+            BasicDrawable::Triangle newTri;
+            newTri.verts[0] = top[2];  newTri.verts[1] = top[1];  newTri.verts[2] = top[0];
+            drawable->addTriangle(newTri);
+            // If they've got a base, we want to see it from the underside, probably
+            if (doBase)
+            {
+                newTri.verts[0] = base[2];  newTri.verts[1] = base[0];  newTri.verts[2] = base[1];
+                drawable->addTriangle(newTri);
             }
         }
     }
@@ -230,7 +292,8 @@ public:
         int ptCount = (int)(4*(pts.size()+1));
         setupDrawable(ptCount);
         
-        Point3d prevPt0,prevPt1,prevNorm,firstPt0,firstPt1,firstNorm;
+        const float base = (polyInfo.base > 0.0) ? polyInfo.base : 0.0;
+        Point3d prevGround,prevPt0,prevPt1,prevNorm,firstPt0,firstPt1,firstNorm;
         for (unsigned int jj=0;jj<pts.size();jj++)
         {
             // Get some real world coordinates and corresponding normal
@@ -238,29 +301,22 @@ public:
             Point2d geoCoordD(geoPt.x()+geoCenter.x(),geoPt.y()+geoCenter.y());
             Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal(geoCoordD);
             Point3d norm = coordAdapter->normalForLocal(localPt);
-            Point3d pt0 = coordAdapter->localToDisplay(localPt);
-            Point3d pt1 = pt0 + norm * polyInfo.height;
-            if (polyInfo.base > 0.0)
-                pt0 = pt0 + norm * polyInfo.base;
+            Point3d ground = coordAdapter->localToDisplay(localPt);
+            Point3d pt0 = ground + norm * base;
+            Point3d pt1 = ground + norm * polyInfo.height;
             
             // Add to drawable
             if (jj > 0)
             {
-                int startVert = drawable->getNumPoints();
-                drawable->addPoint((Point3d)(prevPt0-center));
-                drawable->addPoint((Point3d)(prevPt1-center));
-                drawable->addPoint((Point3d)(pt1-center));
-                drawable->addPoint((Point3d)(pt0-center));
-                
                 // Normal points out
                 Point3d crossNorm = norm.cross(pt1-prevPt1);
                 crossNorm.normalize();
                 crossNorm *= -1;
-                
-                drawable->addNormal(crossNorm);
-                drawable->addNormal(crossNorm);
-                drawable->addNormal(crossNorm);
-                drawable->addNormal(crossNorm);
+
+                int startVert = addVert(prevGround,prevNorm,crossNorm,base);
+                addVert(prevGround,prevNorm,crossNorm,polyInfo.height);
+                addVert(ground,norm,crossNorm,polyInfo.height);
+                addVert(ground,norm,crossNorm,base);
                 
                 BasicDrawable::Triangle triA,triB;
                 triA.verts[0] = startVert+0;
@@ -277,6 +333,7 @@ public:
                 firstPt1 = pt1;
                 firstNorm = norm;
             }
+            prevGround = ground;
             prevPt0 = pt0;  prevPt1 = pt1;
             prevNorm = norm;
         }
@@ -380,6 +437,8 @@ protected:
     BasicDrawableBuilderRef drawable;
     const LoftedPolyInfo &polyInfo;
     GeometryType primType;
+    SimpleIdentity extrudeProgID = EmptyIdentity;
+    int heightAttr = -1;
     Point3d center;
     Point2d geoCenter;
     bool applyCenter;
@@ -400,8 +459,69 @@ LoftManager::~LoftManager()
     loftReps.clear();
 }
     
+// Scale for handing geographic coordinates to Clipper
+static const double MergeScale = 1e9;
+
+// Union all the footprints, so touching ones share a single roof and lose the walls between them.
+// Each result is an outer loop followed by its holes.
+static void MergeFootprints(const ShapeSet &shapes,std::vector<std::vector<VectorRing> > &merged)
+{
+    Clipper c;
+    Point2f org(0.0,0.0);
+    bool orgValid = false;
+    for (const auto &shape : shapes)
+    {
+        const auto theAreal = std::dynamic_pointer_cast<VectorAreal>(shape);
+        if (!theAreal)
+            continue;
+        for (const auto &ring : theAreal->loops)
+        {
+            if (ring.size() < 3)
+                continue;
+            if (!orgValid)
+            {
+                org = ring[0];
+                orgValid = true;
+            }
+            Path path;
+            path.reserve(ring.size());
+            for (const auto &pt : ring)
+                path.push_back(IntPoint((pt.x() - org.x()) * MergeScale, (pt.y() - org.y()) * MergeScale));
+            c.AddPath(path, ptSubject, true);
+        }
+    }
+
+    PolyTree tree;
+    if (!orgValid || !c.Execute(ctUnion, tree, pftNonZero, pftNonZero))
+        return;
+
+    // Clipper hands back open loops, but the walls want them closed
+    const auto toRing = [&](const Path &path)
+    {
+        VectorRing ring;
+        ring.reserve(path.size()+1);
+        for (const auto &pt : path)
+            ring.push_back(Point2f(pt.X / MergeScale + org.x(), pt.Y / MergeScale + org.y()));
+        if (!ring.empty())
+            ring.push_back(ring.front());
+        return ring;
+    };
+
+    for (const PolyNode *node = tree.GetFirst(); node; node = node->GetNext())
+    {
+        if (node->IsHole())
+            continue;
+        std::vector<VectorRing> loops;
+        loops.reserve(node->ChildCount()+1);
+        loops.push_back(toRing(node->Contour));
+        for (const PolyNode *hole : node->Childs)
+            loops.push_back(toRing(hole->Contour));
+        merged.push_back(std::move(loops));
+    }
+}
+
 // From a scene rep and a description, add the given polygons to the drawable builder
-void LoftManager::addGeometryToBuilder(LoftedPolySceneRep *sceneRep,const LoftedPolyInfo &polyInfo,GeoMbr &drawMbr,Point3d &center,bool centerValid,Point2d &geoCenter,ShapeSet &shapes, VectorTrianglesRef triMesh,std::vector<WhirlyKit::VectorRing> &outlines,ChangeSet &changes)
+void LoftManager::addGeometryToBuilder(LoftedPolySceneRep *sceneRep,const LoftedPolyInfo &polyInfo,GeoMbr &drawMbr,Point3d &center,bool centerValid,Point2d &geoCenter,std::vector<WhirlyKit::VectorRing> &wallLoops, VectorTrianglesRef triMesh,std::vector<WhirlyKit::VectorRing> &outlines,ChangeSet &changes)
 {
     int numShapes = 0;
     
@@ -410,30 +530,32 @@ void LoftManager::addGeometryToBuilder(LoftedPolySceneRep *sceneRep,const Lofted
     DrawableBuilder2 drawBuild(scene,renderer,changes,sceneRep,polyInfo,Triangles,drawMbr);
     if (centerValid)
         drawBuild.setCenter(center,geoCenter);
+
+    // The extrude shader only stands in for the default one.
+    // Renderers without it get the walls built here instead.
+    if (polyInfo.shaderExtrude)
+    {
+        const Program *triProg = scene->findProgramByName(MaplyDefaultTriangleShader);
+        if (polyInfo.programID == EmptyIdentity || (triProg && triProg->getId() == polyInfo.programID))
+        {
+            if (const Program *extrudeProg = scene->findProgramByName(MaplyLoftedPolyExtrudeShader))
+                drawBuild.setExtrudeProgram(extrudeProg->getId());
+        }
+    }
     
     // Toss in the polygons for the sides
-    if (polyInfo.height != 0.0)
+    if (polyInfo.height != 0.0 && polyInfo.side)
     {
         DrawableBuilder2 drawBuild2(scene,renderer,changes,sceneRep,polyInfo,Lines,drawMbr);
 
-        for (ShapeSet::iterator it = shapes.begin(); it != shapes.end(); ++it)
+        for (auto &loop : wallLoops)
         {
-            VectorArealRef theAreal = std::dynamic_pointer_cast<VectorAreal>(*it);
-            if (theAreal.get())
-            {
-                for (unsigned int ri=0;ri<theAreal->loops.size();ri++)
-                {
-                    if (polyInfo.side)
-                    {
-                        drawBuild.addSkirtPoints(theAreal->loops[ri]);
-                        numShapes++;
-                        
-                        // Do the uprights around the side
-                        if (polyInfo.outlineSide)
-                            drawBuild2.addUprights(theAreal->loops[ri]);
-                    }
-                }
-            }
+            drawBuild.addSkirtPoints(loop);
+            numShapes++;
+
+            // Do the uprights around the side
+            if (polyInfo.outlineSide)
+                drawBuild2.addUprights(loop);
         }
     }
     
@@ -498,37 +620,57 @@ SimpleIdentity LoftManager::addLoftedPolys(WhirlyKit::ShapeSet *shapes,const Lof
     VectorTrianglesRef triMesh(VectorTriangles::createTriangles());
     GeoMbr shapeMbr;
     std::vector<WhirlyKit::VectorRing> outlines;
-    
-    for (ShapeSet::iterator it = shapes->begin();it != shapes->end(); ++it)
+    std::vector<WhirlyKit::VectorRing> wallLoops;
+
+    if (polyInfo.mergeRoofs)
     {
-        VectorArealRef theAreal = std::dynamic_pointer_cast<VectorAreal>(*it);
-        if (theAreal.get())
+        // Merged roofs keep their holes, so they skip the grid clipping
+        std::vector<std::vector<VectorRing> > merged;
+        MergeFootprints(*shapes,merged);
+        for (const auto &loops : merged)
         {
-            // Work through the loops
-            for (unsigned int ri=0;ri<theAreal->loops.size();ri++)
+            for (const auto &ring : loops)
             {
-                VectorRing &ring = theAreal->loops[ri];
-                
                 shapeMbr.addGeoCoords(ring);
-                
-                if (coordAdapter->isFlat())
+                wallLoops.push_back(ring);
+                if (!coordAdapter->isFlat() && polyInfo.outline)
+                    outlines.push_back(ring);
+            }
+            TesselateLoops(loops,triMesh);
+        }
+    } else {
+        for (ShapeSet::iterator it = shapes->begin();it != shapes->end(); ++it)
+        {
+            VectorArealRef theAreal = std::dynamic_pointer_cast<VectorAreal>(*it);
+            if (theAreal.get())
+            {
+                // Work through the loops
+                for (unsigned int ri=0;ri<theAreal->loops.size();ri++)
                 {
-                    // No grid to worry about, just tesselate
-                    TesselateRing(ring, triMesh);
-                } else {
-                    // Clip the polys for the top
-                    std::vector<VectorRing> clippedMesh;
-                    ClipLoopToGrid(ring,Point2f(0.f,0.f),Point2f(polyInfo.gridSize,polyInfo.gridSize),clippedMesh);
+                    VectorRing &ring = theAreal->loops[ri];
+                
+                    shapeMbr.addGeoCoords(ring);
+                    wallLoops.push_back(ring);
+                
+                    if (coordAdapter->isFlat())
+                    {
+                        // No grid to worry about, just tesselate
+                        TesselateRing(ring, triMesh);
+                    } else {
+                        // Clip the polys for the top
+                        std::vector<VectorRing> clippedMesh;
+                        ClipLoopToGrid(ring,Point2f(0.f,0.f),Point2f(polyInfo.gridSize,polyInfo.gridSize),clippedMesh);
                     
-                    // May need to add the outline as well
-                    if (polyInfo.outline)
-                        outlines.push_back(ring);
+                        // May need to add the outline as well
+                        if (polyInfo.outline)
+                            outlines.push_back(ring);
                     
-                    for (unsigned int ii=0;ii<clippedMesh.size();ii++)
-                    {
-                        VectorRing &ring = clippedMesh[ii];
-                        // Tesselate the ring, even if it's concave (it's concave a lot)
-                        TesselateRing(ring,triMesh);
+                        for (unsigned int ii=0;ii<clippedMesh.size();ii++)
+                        {
+                            VectorRing &ring = clippedMesh[ii];
+                            // Tesselate the ring, even if it's concave (it's concave a lot)
+                            TesselateRing(ring,triMesh);
+                        }
                     }
                 }
             }
@@ -537,7 +679,7 @@ SimpleIdentity LoftManager::addLoftedPolys(WhirlyKit::ShapeSet *shapes,const Lof
             
     //    printf("runAddPoly: handing off %d clipped loops to addGeometry\n",(int)sceneRep->triMesh.size());
     
-    addGeometryToBuilder(sceneRep, polyInfo, shapeMbr, center, centerValid, geoCenter, *shapes, triMesh, outlines, changes);
+    addGeometryToBuilder(sceneRep, polyInfo, shapeMbr, center, centerValid, geoCenter, wallLoops, triMesh, outlines, changes);
     
     {
         std::lock_guard<std::mutex> guardLock(lock);
@@ -20,6 +20,7 @@
 
 #import "MapboxVectorFilter.h"
 #import "MapboxVectorStyleSetC.h"
+#import "DictionaryC.h"
 #import "WhirlyKitLog.h"
 
 namespace WhirlyKit
@@ -33,6 +34,18 @@ static const char * const filterTypes[] = {"==","!=",">",">=","<","<=","in","!in
 static const char * const geomTypes[] = {"Point","LineString","Polygon"};
 
 bool MapboxVectorFilter::parse(const std::vector<DictionaryEntryRef> &filterArray,MapboxVectorStyleSetImpl *styleSet)
+{
+    if (!parseFilter(filterArray,styleSet))
+        return false;
+
+    program.clear();
+    programConsts.clear();
+    compile(program,programConsts);
+
+    return true;
+}
+
+bool MapboxVectorFilter::parseFilter(const std::vector<DictionaryEntryRef> &filterArray,MapboxVectorStyleSetImpl *styleSet)
 {
     if (filterArray.empty()) {
         wkLogLevel(Warn, "Expecting array for filter");
@@ -102,7 +115,7 @@ bool MapboxVectorFilter::parse(const std::vector<DictionaryEntryRef> &filterArra
         for (unsigned int ii=1;ii<filterArray.size();ii++)
         {
             const auto subFilter = std::make_shared<MapboxVectorFilter>();
-            if (!subFilter->parse(filterArray[ii]->getArray(), styleSet))
+            if (!subFilter->parseFilter(filterArray[ii]->getArray(), styleSet))
                 return false;
             subFilters.push_back(subFilter);
         }
@@ -115,7 +128,213 @@ namespace {
     const static std::string geometryType("geometry_type");
 }
 
+void MapboxVectorFilter::collectKeys(std::set<std::string> &keys) const
+{
+    if (geomType != MBGeomNone)
+    {
+        keys.insert(geometryType);
+    }
+    else if (!attrName.empty())
+    {
+        keys.insert(attrName);
+    }
+
+    for (const auto &subFilter : subFilters)
+    {
+        subFilter->collectKeys(keys);
+    }
+}
+
+bool MapboxVectorFilter::makeConst(const DictionaryEntryRef &val,FilterConst &filterConst)
+{
+    filterConst.type = val->getType();
+    switch (filterConst.type)
+    {
+        case DictTypeString:
+            filterConst.strVal = val->getString();
+            // Same as the entry conversion, minus the complaints about non-numbers
+            filterConst.numVal = strtod(filterConst.strVal.c_str(), nullptr);
+            return true;
+        case DictTypeInt:
+        case DictTypeDouble:
+            filterConst.numVal = val->getDouble();
+            filterConst.strVal = val->getString();
+            return true;
+        default:
+            return false;
+    }
+}
+
+void MapboxVectorFilter::compile(std::vector<FilterOp> &ops,std::vector<FilterConst> &consts) const
+{
+    const unsigned int pc = (unsigned int)ops.size();
+    ops.emplace_back();
+
+    FilterOp op;
+    op.code = OpFallback;
+    op.filterType = filterType;
+    op.constStart = (unsigned int)consts.size();
+    op.strConsts = false;
+    op.numConsts = false;
+    op.filter = this;
+
+    switch (filterType)
+    {
+        case MBFilterAll:
+        case MBFilterAny:
+            op.code = (filterType == MBFilterAll) ? OpAll : OpAny;
+            for (const auto &filter : subFilters)
+                filter->compile(ops,consts);
+            break;
+        case MBFilterHas:
+        case MBFilterNotHas:
+            op.code = OpHas;
+            break;
+        case MBFilterIn:
+        case MBFilterNotIn:
+            op.code = OpIn;
+            for (const auto &val : attrVals)
+            {
+                FilterConst filterConst;
+                if (!makeConst(val,filterConst))
+                {
+                    op.code = OpFallback;
+                    break;
+                }
+                ((filterConst.type == DictTypeString) ? op.strConsts : op.numConsts) = true;
+                consts.push_back(std::move(filterConst));
+            }
+            break;
+        case MBFilterNone:
+            break;
+        default:
+            if (geomType != MBGeomNone && (filterType == MBFilterEqual || filterType == MBFilterNotEqual))
+            {
+                op.code = OpGeom;
+            }
+            else
+            {
+                FilterConst filterConst;
+                if (makeConst(attrVal,filterConst))
+                {
+                    op.code = OpCompare;
+                    consts.push_back(std::move(filterConst));
+                }
+            }
+            break;
+    }
+
+    op.constEnd = (unsigned int)consts.size();
+    op.end = (unsigned int)ops.size();
+    ops[pc] = op;
+}
+
+bool MapboxVectorFilter::runOp(const MutableDictionaryC &attrs,const QuadTreeIdentifier &tileID,unsigned int pc) const
+{
+    const FilterOp &op = program[pc];
+    switch (op.code)
+    {
+        case OpAll:
+            for (unsigned int sub = pc + 1; sub < op.end; sub = program[sub].end)
+                if (!runOp(attrs,tileID,sub))
+                    return false;
+            return true;
+        case OpAny:
+            for (unsigned int sub = pc + 1; sub < op.end; sub = program[sub].end)
+                if (runOp(attrs,tileID,sub))
+                    return true;
+            return false;
+        case OpGeom:
+            return ((attrs.getInt(geometryType,0) - 1 == op.filter->geomType) == (op.filterType == MBFilterEqual));
+        case OpHas:
+            return (attrs.hasField(op.filter->attrName) == (op.filterType == MBFilterHas));
+        case OpIn:
+        {
+            double numVal = 0.0;
+            const std::string *strVal = nullptr;
+            const bool isIn = (op.filterType == MBFilterIn);
+            switch (attrs.getValue(op.filter->attrName,numVal,strVal))
+            {
+                case DictTypeNone:
+                    return !isIn;
+                case DictTypeString:
+                    if (op.numConsts)
+                        break;
+                    for (unsigned int ci = op.constStart; ci < op.constEnd; ci++)
+                        if (*strVal == programConsts[ci].strVal)
+                            return isIn;
+                    return !isIn;
+                case DictTypeInt:
+                case DictTypeDouble:
+                    if (op.strConsts)
+                        break;
+                    for (unsigned int ci = op.constStart; ci < op.constEnd; ci++)
+                    {
+                        const auto &filterConst = programConsts[ci];
+                        // Integer constants compare as integers
+                        if ((filterConst.type == DictTypeInt) ? ((int)filterConst.numVal == (int)numVal) :
+                                                                 (filterConst.numVal == numVal))
+                            return isIn;
+                    }
+                    return !isIn;
+                default:
+                    break;
+            }
+            break;
+        }
+        case OpCompare:
+        {
+            double numVal = 0.0;
+            const std::string *strVal = nullptr;
+            const auto &filterConst = programConsts[op.constStart];
+            switch (attrs.getValue(op.filter->attrName,numVal,strVal))
+            {
+                case DictTypeNone:
+                    return (op.filterType == MBFilterNotEqual);
+                case DictTypeString:
+                    switch (op.filterType)
+                    {
+                        case MBFilterEqual:    return *strVal == filterConst.strVal;
+                        case MBFilterNotEqual: return *strVal != filterConst.strVal;
+                        default: return true;
+                    }
+                case DictTypeInt:
+                case DictTypeDouble:
+                    switch (op.filterType)
+                    {
+                        case MBFilterEqual:            return numVal == filterConst.numVal;
+                        case MBFilterNotEqual:         return numVal != filterConst.numVal;
+                        case MBFilterGreaterThan:      return numVal > filterConst.numVal;
+                        case MBFilterGreaterThanEqual: return numVal >= filterConst.numVal;
+                        case MBFilterLessThan:         return numVal < filterConst.numVal;
+                        case MBFilterLessThanEqual:    return numVal <= filterConst.numVal;
+                        default: return true;
+                    }
+                default:
+                    break;
+            }
+            break;
+        }
+        case OpFallback:
+            break;
+    }
+
+    return op.filter->testFilter(attrs,tileID);
+}
+
 bool MapboxVectorFilter::testFeature(const Dictionary &attrs,const QuadTreeIdentifier &tileID)
+{
+    if (!program.empty())
+    {
+        if (const auto dict = dynamic_cast<const MutableDictionaryC *>(&attrs))
+        {
+            return runOp(*dict,tileID,0);
+        }
+    }
+    return testFilter(attrs,tileID);
+}
+
+bool MapboxVectorFilter::testFilter(const Dictionary &attrs,const QuadTreeIdentifier &tileID) const
 {
     // Compare geometry type
     if (geomType != MBGeomNone)
@@ -133,14 +352,14 @@ bool MapboxVectorFilter::testFeature(const Dictionary &attrs,const QuadTreeIdent
     // Run each of the rules as either AND or OR
     case MBFilterAll:
         for (const auto &filter : subFilters) {
-            if (!filter->testFeature(attrs, tileID)) {
+            if (!filter->testFilter(attrs, tileID)) {
                 return false;
             }
         }
         return true;
     case MBFilterAny:
         for (const auto &filter : subFilters) {
-            if (filter->testFeature(attrs, tileID)) {
+            if (filter->testFilter(attrs, tileID)) {
                 return true;
             }
         }
@@ -111,7 +111,7 @@ void MapboxVectorLayerBackground::buildObjects(PlatformThreadInfo *inst,
     vecInfo.zBufferWrite = styleSet->tileStyleSettings->zBufferWrite;
     vecInfo.zBufferRead = styleSet->tileStyleSettings->zBufferRead;
     vecInfo.colorExp = paint.color->expression();
-    vecInfo.opacityExp = paint.opacity->expression();
+    vecInfo.opacityExp = MapboxVectorStyleSetImpl::opacityExpression(paint.color, paint.opacity);
     vecInfo.programID = styleSet->vectorArealProgramID;
     vecInfo.drawPriority = drawPriority + tileInfo->ident.level * std::max(0, styleSet->tileStyleSettings->drawPriorityPerLevel);
     // TODO: Switch to stencils
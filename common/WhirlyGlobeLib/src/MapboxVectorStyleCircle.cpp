@@ -117,12 +117,23 @@ void MapboxVectorLayerCircle::buildObjects(PlatformThreadInfo *inst,
     auto const capacity = vecObjs.size() * 5;  // ?
     std::unordered_map<std::string,std::pair<MarkerPtrVec,VecObjRefVec>> markersByUUID(capacity);
 
-    const double opacity = paint.opacity->valForZoom(tileInfo->ident.level);
-    const double radius = paint.radius->valForZoom(tileInfo->ident.level);
-
-    // Default settings
+    // Zoom dependent values go to the shaders, which scale down from the largest radius
     MarkerInfo markerInfo(/*screenObject=*/true);
     markerInfo.zoomSlot = styleSet->zoomSlot;
+    markerInfo.opacityExp = paint.opacity->expression();
+    markerInfo.scaleExp = paint.radius->expression();
+    double radius = paint.radius->valForZoom(tileInfo->ident.level);
+    if (markerInfo.scaleExp)
+    {
+        radius = paint.radius->maxVal();
+        if (radius > 0.0)
+        {
+            markerInfo.scaleExp->scaleBy(1.0 / radius);
+        }
+    }
+    markerInfo.hasExp = markerInfo.opacityExp || markerInfo.scaleExp;
+
+    const double opacity = markerInfo.opacityExp ? 1.0 : paint.opacity->valForZoom(tileInfo->ident.level);
     markerInfo.color = RGBAColor(255,255,255,(int)(opacity*255));
     markerInfo.drawPriority = drawPriority + ScreenDrawPriorityOffset +
         tileInfo->ident.level * std::max(0, styleSet->tileStyleSettings->drawPriorityPerLevel) + 1;
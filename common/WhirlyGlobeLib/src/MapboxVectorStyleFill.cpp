@@ -87,6 +87,119 @@ MapboxVectorStyleLayer& MapboxVectorLayerFill::copy(const MapboxVectorStyleLayer
     return *this;
 }
 
+bool MapboxVectorLayerFill::setupFillInfo(const MapboxVectorFillPaint &fillPaint,const QuadTreeIdentifier &ident,VectorInfo &vecInfo) const
+{
+    MBResolveColorType resolveMode = MBResolveColorOpacityComposeAlpha;
+#ifdef __ANDROID__
+    // On Android, pre-multiply the alpha on static colors.
+    // When the color or opacity is dynamic, we need to do it in the tweaker.
+    if ((!fillPaint.color || !fillPaint.color->isExpression()) &&
+        (!fillPaint.opacity || !fillPaint.opacity->isExpression()))
+    {
+        resolveMode = MBResolveColorOpacityMultiply;
+    }
+#endif
+    const auto color = MapboxVectorStyleSetImpl::resolveColor(fillPaint.color, fillPaint.opacity, ident.level, resolveMode);
+    if (!color)
+    {
+        return false;
+    }
+
+    // Set up the description for constructing vectors
+    vecInfo.hasExp = true;
+    vecInfo.filled = true;
+    vecInfo.centered = true;
+    vecInfo.color = *color;
+    vecInfo.zoomSlot = styleSet->zoomSlot;
+    vecInfo.zBufferWrite = styleSet->tileStyleSettings->zBufferWrite;
+    vecInfo.zBufferRead = styleSet->tileStyleSettings->zBufferRead;
+    vecInfo.colorExp = fillPaint.color->expression();
+    vecInfo.opacityExp = MapboxVectorStyleSetImpl::opacityExpression(fillPaint.color, fillPaint.opacity);
+    vecInfo.programID = (arealShaderID != EmptyIdentity) ? arealShaderID : styleSet->vectorArealProgramID;
+    vecInfo.drawPriority = drawPriority + ident.level * std::max(0, styleSet->tileStyleSettings->drawPriorityPerLevel) + 1;
+    // TODO: Switch to stencils
+//    vecInfo.drawOrder = ident.NodeNumber();
+
+//    wkLogLevel(Debug, "fill: tileID = %d: (%d,%d)  drawOrder = %d, drawPriority = %d",ident.level, ident.x, ident.y, vecInfo.drawOrder,vecInfo.drawPriority);
+
+    if (minzoom != 0 || maxzoom < 1000)
+    {
+        vecInfo.minZoomVis = minzoom;
+        vecInfo.maxZoomVis = maxzoom;
+    }
+
+    //wkLogLevel(Debug, "Color: %s %d %d %d %d",this->ident.c_str(),(int)color->r,(int)color->g,(int)color->b,(int)color->a);
+
+    return true;
+}
+
+bool MapboxVectorLayerFill::setupOutlineInfo(const MapboxVectorFillPaint &fillPaint,const QuadTreeIdentifier &ident,VectorInfo &vecInfo) const
+{
+    const auto color = MapboxVectorStyleSetImpl::resolveColor(fillPaint.outlineColor, fillPaint.opacity,
+                                                              ident.level, MBResolveColorOpacityComposeAlpha);
+    if (!color)
+    {
+        return false;
+    }
+
+    // Set up the description for constructing vectors
+    vecInfo.hasExp = true;
+    vecInfo.filled = false;
+    vecInfo.centered = true;
+    vecInfo.colorExp = fillPaint.outlineColor->expression();
+    vecInfo.opacityExp = MapboxVectorStyleSetImpl::opacityExpression(fillPaint.outlineColor, fillPaint.opacity);
+    vecInfo.programID = (arealShaderID != EmptyIdentity) ? arealShaderID : styleSet->vectorArealProgramID;
+    vecInfo.color = *color;
+    vecInfo.zoomSlot = styleSet->zoomSlot;
+    vecInfo.drawPriority = drawPriority + ident.level * std::max(0, styleSet->tileStyleSettings->drawPriorityPerLevel) + 1;
+    vecInfo.drawOrder = ident.NodeNumber();
+
+    if (minzoom != 0 || maxzoom < 1000)
+    {
+        vecInfo.zoomSlot = styleSet->zoomSlot;
+        vecInfo.minZoomVis = minzoom;
+        vecInfo.maxZoomVis = maxzoom;
+    }
+
+    return true;
+}
+
+// Which thing we built for the tracker
+static constexpr int FillEntry = 0;
+static constexpr int OutlineEntry = 1;
+
+bool MapboxVectorLayerFill::updatePaint(PlatformThreadInfo *inst,const DictionaryRef &paintEntry,ChangeSet &changes)
+{
+    MapboxVectorFillPaint newPaint;
+    if (!newPaint.parse(inst, styleSet, paintEntry))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guardLock(paintTracker.lock);
+
+    // Adding or taking away the fill or outline means building or tossing geometry
+    if (!MapboxPaintChangeable(paint.color, newPaint.color) ||
+        !MapboxPaintChangeable(paint.outlineColor, newPaint.outlineColor) ||
+        !MapboxPaintChangeable(paint.opacity, newPaint.opacity))
+    {
+        return false;
+    }
+
+    paint = newPaint;
+
+    paintTracker.forEach([&](const QuadTreeIdentifier &ident,int which,SimpleIdentity vecID)
+    {
+        VectorInfo vecInfo;
+        if ((which == OutlineEntry) ? setupOutlineInfo(paint, ident, vecInfo) : setupFillInfo(paint, ident, vecInfo))
+        {
+            styleSet->vecManage->changeVectors(vecID, vecInfo, changes);
+        }
+    });
+
+    return true;
+}
+
 void MapboxVectorLayerFill::buildObjects(PlatformThreadInfo *inst,
                                          const std::vector<VectorObjectRef> &vecObjs,
                                          const VectorTileDataRef &tileInfo,
@@ -99,7 +212,14 @@ void MapboxVectorLayerFill::buildObjects(PlatformThreadInfo *inst,
         return;
     }
 
-    if (!paint.color && !paint.outlineColor)
+    // The paint can be changed underneath us
+    MapboxVectorFillPaint fillPaint;
+    {
+        std::lock_guard<std::mutex> guardLock(paintTracker.lock);
+        fillPaint = paint;
+    }
+
+    if (!fillPaint.color && !fillPaint.outlineColor)
     {
         return;
     }
@@ -124,7 +244,7 @@ void MapboxVectorLayerFill::buildObjects(PlatformThreadInfo *inst,
     }
 
     // Filled polygons
-    if (paint.color)
+    if (fillPaint.color)
     {
         // tessellate the area features
         std::vector<VectorShapeRef> tessShapes;
@@ -141,8 +261,10 @@ void MapboxVectorLayerFill::buildObjects(PlatformThreadInfo *inst,
                 auto coordAdapter = scene->getCoordAdapter();
                 auto coordSys = coordAdapter->getCoordSystem();
 
-                // Convert to local to make tessellation work better (#1392)
-                for (auto &loop : ar->loops)
+                // Convert to local to make tessellation work better (#1392).
+                // The features may be shared with other styles or cached, so leave them alone.
+                std::vector<VectorRing> localLoops(ar->loops);
+                for (auto &loop : localLoops)
                 {
                     for (auto &pt : loop)
                     {
@@ -152,7 +274,7 @@ void MapboxVectorLayerFill::buildObjects(PlatformThreadInfo *inst,
 
                 const auto trisRef = VectorTriangles::createTriangles();
                 trisRef->localCoords = true;
-                TesselateLoops(ar->loops, trisRef);
+                TesselateLoops(localLoops, trisRef);
                 trisRef->setAttrDict(ar->getAttrDict());
 
                 // Generate MBR in local, that's what the builders will expect when we've
@@ -163,49 +285,14 @@ void MapboxVectorLayerFill::buildObjects(PlatformThreadInfo *inst,
             }
         }
 
-        MBResolveColorType resolveMode = MBResolveColorOpacityComposeAlpha;
-#ifdef __ANDROID__
-        // On Android, pre-multiply the alpha on static colors.
-        // When the color or opacity is dynamic, we need to do it in the tweaker.
-        if ((!paint.color || !paint.color->isExpression()) &&
-            (!paint.opacity || !paint.opacity->isExpression()))
-        {
-            resolveMode = MBResolveColorOpacityMultiply;
-        }
-#endif
-        if (const auto color = MapboxVectorStyleSetImpl::resolveColor(paint.color, paint.opacity,
-                                                                      tileInfo->ident.level, resolveMode))
+        VectorInfo vecInfo;
+        if (setupFillInfo(fillPaint, tileInfo->ident, vecInfo))
         {
-            // Set up the description for constructing vectors
-            VectorInfo vecInfo;
-            vecInfo.hasExp = true;
-            vecInfo.filled = true;
-            vecInfo.centered = true;
-            vecInfo.color = *color;
-            vecInfo.zoomSlot = styleSet->zoomSlot;
-            vecInfo.zBufferWrite = styleSet->tileStyleSettings->zBufferWrite;
-            vecInfo.zBufferRead = styleSet->tileStyleSettings->zBufferRead;
-            vecInfo.colorExp = paint.color->expression();
-            vecInfo.opacityExp = paint.opacity->expression();
-            vecInfo.programID = (arealShaderID != EmptyIdentity) ? arealShaderID : styleSet->vectorArealProgramID;
-            vecInfo.drawPriority = drawPriority + tileInfo->ident.level * std::max(0, styleSet->tileStyleSettings->drawPriorityPerLevel) + 1;
-            // TODO: Switch to stencils
-//            vecInfo.drawOrder = tileInfo->tileNumber();
-
-//            wkLogLevel(Debug, "fill: tileID = %d: (%d,%d)  drawOrder = %d, drawPriority = %d",tileInfo->ident.level, tileInfo->ident.x, tileInfo->ident.y, vecInfo.drawOrder,vecInfo.drawPriority);
-
-            if (minzoom != 0 || maxzoom < 1000)
-            {
-                vecInfo.minZoomVis = minzoom;
-                vecInfo.maxZoomVis = maxzoom;
-            }
-
-            //wkLogLevel(Debug, "Color: %s %d %d %d %d",ident.c_str(),(int)color->r,(int)color->g,(int)color->b,(int)color->a);
-
             const SimpleIdentity vecID = styleSet->vecManage->addVectors(&tessShapes, vecInfo, tileInfo->changes);
             if (vecID != EmptyIdentity)
             {
                 compObj->vectorIDs.insert(vecID);
+                paintTracker.add(compObj, tileInfo->ident, FillEntry, vecID);
                 
                 if (selectable)
                 {
@@ -217,36 +304,16 @@ void MapboxVectorLayerFill::buildObjects(PlatformThreadInfo *inst,
     }
     
     // Outlines
-    if (paint.outlineColor)
+    if (fillPaint.outlineColor)
     {
-        if (const auto color = WhirlyKit::MapboxVectorStyleSetImpl::resolveColor(
-                paint.outlineColor, paint.opacity,
-                tileInfo->ident.level, MBResolveColorOpacityComposeAlpha))
+        VectorInfo vecInfo;
+        if (setupOutlineInfo(fillPaint, tileInfo->ident, vecInfo))
         {
-            // Set up the description for constructing vectors
-            VectorInfo vecInfo;
-            vecInfo.hasExp = true;
-            vecInfo.filled = false;
-            vecInfo.centered = true;
-            vecInfo.colorExp = paint.outlineColor->expression();
-            vecInfo.opacityExp = paint.opacity->expression();
-            vecInfo.programID = (arealShaderID != EmptyIdentity) ? arealShaderID : styleSet->vectorArealProgramID;
-            vecInfo.color = *color;
-            vecInfo.zoomSlot = styleSet->zoomSlot;
-            vecInfo.drawPriority = drawPriority + tileInfo->ident.level * std::max(0, styleSet->tileStyleSettings->drawPriorityPerLevel) + 1;
-            vecInfo.drawOrder = tileInfo->tileNumber();
-
-            if (minzoom != 0 || maxzoom < 1000)
-            {
-                vecInfo.zoomSlot = styleSet->zoomSlot;
-                vecInfo.minZoomVis = minzoom;
-                vecInfo.maxZoomVis = maxzoom;
-            }
-
             const SimpleIdentity vecID = styleSet->vecManage->addVectors(&shapes, vecInfo, tileInfo->changes);
             if (vecID != EmptyIdentity)
             {
                 compObj->vectorIDs.insert(vecID);
+                paintTracker.add(compObj, tileInfo->ident, OutlineEntry, vecID);
             }
         }
     }
@@ -26,10 +26,40 @@
 #import "MapboxVectorStyleCircle.h"
 #import "MapboxVectorFilter.h"
 #import "WhirlyKitLog.h"
+#import <algorithm>
 
 namespace WhirlyKit
 {
 
+void MapboxVectorPaintTracker::add(const ComponentObjectRef &compObj,const QuadTreeIdentifier &ident,int which,SimpleIdentity id)
+{
+    std::lock_guard<std::mutex> guardLock(entryLock);
+
+    // Tiles come and go, so clear out the dead ones every so often
+    if (entries.size() >= pruneSize)
+    {
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [](const Entry &entry) { return entry.compObj.expired(); }),
+                      entries.end());
+        pruneSize = std::max(pruneSize, 2 * entries.size());
+    }
+
+    entries.push_back(Entry { compObj, ident, which, id });
+}
+
+void MapboxVectorPaintTracker::forEach(const std::function<void(const QuadTreeIdentifier &ident,int which,SimpleIdentity id)> &fn)
+{
+    std::lock_guard<std::mutex> guardLock(entryLock);
+
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [](const Entry &entry) { return entry.compObj.expired(); }),
+                  entries.end());
+    for (const auto &entry : entries)
+    {
+        fn(entry.ident, entry.which, entry.id);
+    }
+}
+
 MapboxVectorStyleLayerRef MapboxVectorStyleLayer::VectorStyleLayer(PlatformThreadInfo *inst,
                                                                    MapboxVectorStyleSetImpl *styleSet,
                                                                    const DictionaryRef &layerDict,
@@ -103,6 +133,30 @@ MapboxVectorStyleLayer::MapboxVectorStyleLayer(MapboxVectorStyleSetImpl *styleSe
 {
 }
 
+bool MapboxVectorStyleLayer::attributeKeys(std::set<std::string> &keys) const
+{
+    // Selected features hand all their attributes back to the app
+    if (selectable)
+    {
+        return false;
+    }
+
+    if (filter)
+    {
+        filter->collectKeys(keys);
+    }
+    if (!uuidField.empty())
+    {
+        keys.insert(uuidField);
+    }
+    if (!repUUIDField.empty())
+    {
+        keys.insert(repUUIDField);
+    }
+
+    return true;
+}
+
 MapboxVectorStyleLayerRef MapboxVectorStyleLayer::clone() const
 {
 #if defined(DEBUG)
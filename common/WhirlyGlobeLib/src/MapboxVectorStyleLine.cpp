@@ -164,6 +164,133 @@ static WideVectorLineCapType convertCap(MapboxVectorLineCap cap)
     }
 }
 
+bool MapboxVectorLayerLine::setupInfo(const MapboxVectorLinePaint &linePaint,const QuadTreeIdentifier &ident,WideVectorInfo &vecInfo) const
+{
+    MBResolveColorType resolveMode = MBResolveColorOpacityComposeAlpha;
+#ifdef __ANDROID__
+    // On Android, pre-multiply the alpha on static colors.
+    // When the color or opacity is dynamic, we need to do it in the tweaker.
+    if ((!linePaint.color || !linePaint.color->isExpression()) &&
+        (!linePaint.opacity || !linePaint.opacity->isExpression()))
+    {
+        resolveMode = MBResolveColorOpacityMultiply;
+    }
+#endif
+
+    const RGBAColorRef color = MapboxVectorStyleSetImpl::resolveColor(linePaint.color, linePaint.opacity, ident.level, resolveMode);
+
+    const double width = linePaint.width->valForZoom(ident.level) * lineScale;
+    const double offset = linePaint.offset->valForZoom(ident.level) * lineScale;
+    
+    if (!color || width <= 0.0)
+    {
+        return false;
+    }
+
+    vecInfo.coordType = WideVecCoordScreen;
+    vecInfo.fadeIn = fade;
+    vecInfo.fadeOut = fade;
+    vecInfo.zoomSlot = styleSet->zoomSlot;
+    vecInfo.color = *color;
+    vecInfo.width = (float)width;
+    vecInfo.offset = (float)-offset;
+    vecInfo.joinType = layout.joinSet ? convertJoin(layout.join) : WideVecMiterSimpleJoin;
+    vecInfo.capType = convertCap(layout.cap);
+    vecInfo.widthExp = linePaint.width->expression();
+    vecInfo.offsetExp = linePaint.offset->expression();
+    vecInfo.colorExp = linePaint.color->expression();
+    vecInfo.opacityExp = MapboxVectorStyleSetImpl::opacityExpression(linePaint.color, linePaint.opacity);
+    vecInfo.hasExp = vecInfo.widthExp || vecInfo.offsetExp || vecInfo.colorExp || vecInfo.opacityExp;
+    vecInfo.drawPriority = drawPriority + ident.level * std::max(0, styleSet->tileStyleSettings->drawPriorityPerLevel)+2;
+    // The GPU version handles every line style, but not every renderer has it
+    const bool perfWideVec = styleSet->tileStyleSettings->perfWideVec &&
+                             styleSet->wideVectorPerfProgramID != EmptyIdentity;
+    vecInfo.implType = perfWideVec ? WideVecImplPerf : WideVecImplBasic;
+    vecInfo.programID = perfWideVec ? styleSet->wideVectorPerfProgramID : styleSet->wideVectorProgramID;
+    // TODO: Switch to stencils
+//        vecInfo.drawOrder = tileInfo->tileNumber();
+
+    // Legacy wide vectors have limited join support
+    if (!perfWideVec)
+    {
+        switch (vecInfo.joinType)
+        {
+            case WideVecMiterClipJoin:
+            case WideVecMiterSimpleJoin:
+            case WideVecRoundJoin:
+            case WideVecNoneJoin:
+                vecInfo.joinType = WideVecMiterJoin;
+            default: break;
+        }
+    }
+
+    if (minzoom != 0 || maxzoom < 1000)
+    {
+        vecInfo.minZoomVis = minzoom;
+        vecInfo.maxZoomVis = maxzoom;
+    }
+    if (filledLineTexID != EmptyIdentity)
+    {
+        // If we have a filled texture, we'll use that
+        vecInfo.texID = filledLineTexID;
+        vecInfo.repeatSize = (float)totLen;
+    }
+    if (vecInfo.widthExp)
+    {
+        vecInfo.widthExp->scaleBy(lineScale);
+    }
+    if (vecInfo.offsetExp)
+    {
+        vecInfo.offsetExp->scaleBy(-lineScale);
+    }
+
+    return true;
+}
+
+bool MapboxVectorLayerLine::updatePaint(PlatformThreadInfo *inst,const DictionaryRef &paintEntry,ChangeSet &changes)
+{
+    MapboxVectorLinePaint newPaint;
+    if (!newPaint.parse(inst, styleSet, paintEntry))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guardLock(paintTracker.lock);
+
+    // Dashes are baked into a texture sized by the width
+    if (newPaint.pattern != paint.pattern || newPaint.lineDashArray != paint.lineDashArray ||
+        (!paint.lineDashArray.empty() && !paint.width->sameValues(*newPaint.width)))
+    {
+        return false;
+    }
+    if (!MapboxPaintChangeable(paint.color, newPaint.color) ||
+        !MapboxPaintChangeable(paint.opacity, newPaint.opacity) ||
+        !MapboxPaintChangeable(paint.width, newPaint.width) ||
+        !MapboxPaintChangeable(paint.offset, newPaint.offset))
+    {
+        return false;
+    }
+    // Lines that weren't built can't be shown and ones that were can't be taken away
+    if (!paint.width->sameValues(*newPaint.width) &&
+        (paint.width->valForZoom(0) > 0.0) != (newPaint.width->valForZoom(0) > 0.0))
+    {
+        return false;
+    }
+
+    paint = newPaint;
+
+    paintTracker.forEach([&](const QuadTreeIdentifier &ident,int,SimpleIdentity wideVecID)
+    {
+        WideVectorInfo vecInfo;
+        if (setupInfo(paint, ident, vecInfo))
+        {
+            styleSet->wideVecManage->changeVectors(wideVecID, vecInfo, changes);
+        }
+    });
+
+    return true;
+}
+
 void MapboxVectorLayerLine::buildObjects(PlatformThreadInfo *inst,
                                          const std::vector<VectorObjectRef> &inVecObjs,
                                          const VectorTileDataRef &tileInfo,
@@ -202,6 +329,12 @@ void MapboxVectorLayerLine::buildObjects(PlatformThreadInfo *inst,
         {
             newVecObj = newVecObj->clipToMbr(tileInfo->geoBBox.ll(), tileInfo->geoBBox.ur());
         }
+        if (newVecObj && newVecObj == vecObj && subdivToGlobe > 0.0)
+        {
+            // Subdividing works in place and the originals may be shared with other styles or the tile cache.
+            // The attributes aren't changed, so they can stay shared.
+            newVecObj = newVecObj->copyOnWrite();
+        }
         if (newVecObj)
         {
             vecObjs.push_back(newVecObj);
@@ -221,86 +354,21 @@ void MapboxVectorLayerLine::buildObjects(PlatformThreadInfo *inst,
         vecObjs = newVecObjs;
     }
     
-    // If we have a filled texture, we'll use that
-    const auto repeatLen = (float)totLen;
-    
     // TODO: We can also have a symbol, where we might do the same thing
     // Problem is, we'll need to pass the sub-texture logic through to the renderer
     //  because right now it's expecting a single texture that can be strung along the line
 
-    MBResolveColorType resolveMode = MBResolveColorOpacityComposeAlpha;
-#ifdef __ANDROID__
-    // On Android, pre-multiply the alpha on static colors.
-    // When the color or opacity is dynamic, we need to do it in the tweaker.
-    if ((!paint.color || !paint.color->isExpression()) &&
-        (!paint.opacity || !paint.opacity->isExpression()))
-    {
-        resolveMode = MBResolveColorOpacityMultiply;
-    }
-#endif
-
-    const RGBAColorRef color = MapboxVectorStyleSetImpl::resolveColor(paint.color, paint.opacity, tileInfo->ident.level, resolveMode);
-
-    const double width = paint.width->valForZoom(tileInfo->ident.level) * lineScale;
-    const double offset = paint.offset->valForZoom(tileInfo->ident.level) * lineScale;
-    
-    if (!color || width <= 0.0)
+    // The paint can be changed underneath us
+    MapboxVectorLinePaint linePaint;
     {
-        return;
+        std::lock_guard<std::mutex> guardLock(paintTracker.lock);
+        linePaint = paint;
     }
 
     WideVectorInfo vecInfo;
-    vecInfo.coordType = WideVecCoordScreen;
-    vecInfo.fadeIn = fade;
-    vecInfo.fadeOut = fade;
-    vecInfo.zoomSlot = styleSet->zoomSlot;
-    vecInfo.color = *color;
-    vecInfo.width = (float)width;
-    vecInfo.offset = (float)-offset;
-    vecInfo.joinType = layout.joinSet ? convertJoin(layout.join) : WideVecMiterSimpleJoin;
-    vecInfo.capType = convertCap(layout.cap);
-    vecInfo.widthExp = paint.width->expression();
-    vecInfo.offsetExp = paint.offset->expression();
-    vecInfo.colorExp = paint.color->expression();
-    vecInfo.opacityExp = paint.opacity->expression();
-    vecInfo.hasExp = vecInfo.widthExp || vecInfo.offsetExp || vecInfo.colorExp || vecInfo.opacityExp;
-    vecInfo.drawPriority = drawPriority + tileInfo->ident.level * std::max(0, styleSet->tileStyleSettings->drawPriorityPerLevel)+2;
-    vecInfo.implType = styleSet->tileStyleSettings->perfWideVec ? WideVecImplPerf : WideVecImplBasic;
-    vecInfo.programID = styleSet->tileStyleSettings->perfWideVec ? styleSet->wideVectorPerfProgramID : styleSet->wideVectorProgramID;
-    // TODO: Switch to stencils
-//        vecInfo.drawOrder = tileInfo->tileNumber();
-
-    // Legacy wide vectors have limited join support
-    if (!styleSet->tileStyleSettings->perfWideVec)
-    {
-        switch (vecInfo.joinType)
-        {
-            case WideVecMiterClipJoin:
-            case WideVecMiterSimpleJoin:
-            case WideVecRoundJoin:
-            case WideVecNoneJoin:
-                vecInfo.joinType = WideVecMiterJoin;
-            default: break;
-        }
-    }
-
-    if (minzoom != 0 || maxzoom < 1000)
-    {
-        vecInfo.minZoomVis = minzoom;
-        vecInfo.maxZoomVis = maxzoom;
-    }
-    if (filledLineTexID != EmptyIdentity)
-    {
-        vecInfo.texID = filledLineTexID;
-        vecInfo.repeatSize = repeatLen;
-    }
-    if (vecInfo.widthExp)
+    if (!setupInfo(linePaint, tileInfo->ident, vecInfo))
     {
-        vecInfo.widthExp->scaleBy(lineScale);
-    }
-    if (vecInfo.offsetExp)
-    {
-        vecInfo.offsetExp->scaleBy(-lineScale);
+        return;
     }
 
     using ShapeRefVec = std::vector<VectorShapeRef>;
@@ -357,6 +425,7 @@ void MapboxVectorLayerLine::buildObjects(PlatformThreadInfo *inst,
             compObj->uuid = uuid;
             compObj->representation = representation;
             compObj->wideVectorIDs.insert(wideVecID);
+            paintTracker.add(compObj, tileInfo->ident, 0, wideVecID);
             styleSet->compManage->addComponentObject(compObj, tileInfo->changes);
             tileInfo->compObjs.push_back(std::move(compObj));
         }
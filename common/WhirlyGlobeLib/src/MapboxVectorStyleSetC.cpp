@@ -37,6 +37,8 @@ static const std::string strName("name");
 static const std::string strVersion("version");
 static const std::string strLayers("layers");
 static const std::string strBackground("background");
+static const int CompiledStyleMagic = 0x5342564d;    // 'MVBS'
+static const int CompiledStyleVersion = 2;
 static const std::regex colorSeparatorPattern("[(),]");
 static const std::regex fieldSeparatorPattern(R"([{}]+)");
 static const std::regex colonPattern(":\\w+$");
@@ -106,6 +108,14 @@ static void trim(std::string &s)
     }
 }
 
+void MapboxRegexField::collectKeys(std::set<std::string> &keys) const
+{
+    for (const auto &chunk : chunks)
+    {
+        keys.insert(chunk.keys.begin(), chunk.keys.end());
+    }
+}
+
 std::string MapboxRegexField::build(const DictionaryRef &attrs) const
 {
     bool found = false;
@@ -316,6 +326,24 @@ double MaplyVectorFunctionStops::maxValue()
     return val;
 }
 
+bool MaplyVectorFunctionStops::sameValues(const MaplyVectorFunctionStops &that) const
+{
+    if (base != that.base || stops.size() != that.stops.size())
+    {
+        return false;
+    }
+    for (size_t ii=0;ii<stops.size();++ii)
+    {
+        const auto &a = stops[ii];
+        const auto &b = that.stops[ii];
+        if (a.zoom != b.zoom || a.val != b.val || !a.color != !b.color || (a.color && !(*a.color == *b.color)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 MapboxTransDouble::MapboxTransDouble(double value)
 {
     val = value;
@@ -332,7 +360,7 @@ double MapboxTransDouble::valForZoom(double zoom)
     return stops ? stops->valueForZoom(zoom) : val;
 }
 
-bool MapboxTransDouble::isExpression()
+bool MapboxTransDouble::isExpression() const
 {
     return stops.get() != nullptr;
 }
@@ -357,6 +385,15 @@ FloatExpressionInfoRef MapboxTransDouble::expression()
 }
 
 
+bool MapboxTransDouble::sameValues(const MapboxTransDouble &that) const
+{
+    if (!stops || !that.stops)
+    {
+        return !stops && !that.stops && val == that.val;
+    }
+    return stops->sameValues(*that.stops);
+}
+
 double MapboxTransDouble::minVal()
 {
     return stops ? stops->minValue() : val;
@@ -404,6 +441,19 @@ bool MapboxTransColor::isExpression() const
     return stops.get() != nullptr;
 }
 
+bool MapboxTransColor::sameValues(const MapboxTransColor &that) const
+{
+    if (useAlphaOverride != that.useAlphaOverride || (useAlphaOverride && alpha != that.alpha))
+    {
+        return false;
+    }
+    if (!stops || !that.stops)
+    {
+        return !stops && !that.stops && !color == !that.color && (!color || *color == *that.color);
+    }
+    return stops->sameValues(*that.stops);
+}
+
 ColorExpressionInfoRef MapboxTransColor::expression()
 {
     if (!stops)
@@ -438,6 +488,18 @@ MapboxRegexField MapboxTransText::textForZoom(double zoom)
     return stops ? stops->textForZoom(zoom) : textField;
 }
 
+void MapboxTransText::collectKeys(std::set<std::string> &keys) const
+{
+    textField.collectKeys(keys);
+    if (stops)
+    {
+        for (const auto &stop : stops->stops)
+        {
+            stop.textField.collectKeys(keys);
+        }
+    }
+}
+
 static constexpr size_t TypicalLayerCount = 500;
 
 MapboxVectorStyleSetImpl::MapboxVectorStyleSetImpl(Scene *inScene,
@@ -515,6 +577,48 @@ bool MapboxVectorStyleSetImpl::parse(PlatformThreadInfo *inst,const DictionaryRe
     return true;
 }
 
+bool MapboxVectorStyleSetImpl::compileStyle(const DictionaryRef &styleDict,uint64_t sourceKey,MutableRawData &outData)
+{
+    const auto dict = dynamic_cast<const MutableDictionaryC *>(styleDict.get());
+    if (!dict)
+    {
+        return false;
+    }
+
+    outData.addInt(CompiledStyleMagic);
+    outData.addInt(CompiledStyleVersion);
+    outData.addInt64((int64_t)sourceKey);
+    dict->asRawData(&outData);
+    return true;
+}
+
+MutableDictionaryCRef MapboxVectorStyleSetImpl::readCompiledStyle(const RawData &data,uint64_t sourceKey)
+{
+    RawDataReader reader(&data);
+    int magic = 0, fileVersion = 0;
+    int64_t key = 0;
+    if (!reader.getInt(magic) || magic != CompiledStyleMagic ||
+        !reader.getInt(fileVersion) || fileVersion != CompiledStyleVersion ||
+        !reader.getInt64(key) || (uint64_t)key != sourceKey)
+    {
+        return MutableDictionaryCRef();
+    }
+
+    auto dict = std::make_shared<MutableDictionaryC>();
+    if (!dict->readRawData(reader) || !reader.done())
+    {
+        wkLogLevel(Warn, "MapboxVectorStyleSet: Compiled style is damaged");
+        return MutableDictionaryCRef();
+    }
+    return dict;
+}
+
+bool MapboxVectorStyleSetImpl::parseCompiled(PlatformThreadInfo *inst,const RawData &data,uint64_t sourceKey)
+{
+    const auto dict = readCompiledStyle(data, sourceKey);
+    return dict && parse(inst, dict);
+}
+
 void MapboxVectorStyleSetImpl::addLayer(PlatformThreadInfo *inst, MapboxVectorStyleLayerRef layer)
 {
     if (!layer)
@@ -522,16 +626,64 @@ void MapboxVectorStyleSetImpl::addLayer(PlatformThreadInfo *inst, MapboxVectorSt
         return;
     }
 
+    {
+        std::lock_guard<std::mutex> guardLock(attrKeysLock);
+        attrKeysBySource.clear();
+    }
+    styleGeneration++;
+
     // Sort into various buckets for quick lookup
     layersByName[layer->ident] = layer;
     layersByUUID[layer->getUuid(inst)] = layer;
     if (!layer->sourceLayer.empty())
     {
         layersBySource.insert(std::make_pair(layer->sourceLayer, layer));
+
+        // A tile keeps showing once we zoom in past it, so minzoom doesn't rule a level out.
+        // Allow for a tile showing up a bit early when checking maxzoom.
+        auto &byLevel = layersBySourceLevel[layer->sourceLayer];
+        byLevel.resize(MaxLayerLevel + 1);
+        for (int level = 0; level <= std::min(layer->maxzoom, MaxLayerLevel); level++)
+        {
+            byLevel[level].push_back(layer);
+        }
     }
     layers.push_back(std::move(layer));
 }
 
+void MapboxVectorStyleSetImpl::setLayerVisible(const std::string &ident,bool visible)
+{
+    for (auto &layer : layers)
+    {
+        if (layer->ident == ident && layer->visible != visible)
+        {
+            layer->visible = visible;
+            styleGeneration++;
+        }
+    }
+}
+
+bool MapboxVectorStyleSetImpl::updateLayerPaint(PlatformThreadInfo *inst,const std::string &ident,const DictionaryRef &paintEntry)
+{
+    bool found = false, ret = true;
+    ChangeSet changes;
+    for (auto &layer : layers)
+    {
+        if (layer->ident == ident)
+        {
+            found = true;
+            ret &= layer->updatePaint(inst, paintEntry, changes);
+        }
+    }
+
+    if (!changes.empty())
+    {
+        scene->addChangeRequests(changes);
+    }
+
+    return found && ret;
+}
+
 long long MapboxVectorStyleSetImpl::generateID()
 {
     return currentID++;
@@ -951,6 +1103,31 @@ RGBAColorRef MapboxVectorStyleSetImpl::resolveColor(const MapboxTransColorRef &c
     }
 }
 
+FloatExpressionInfoRef MapboxVectorStyleSetImpl::opacityExpression(const MapboxTransColorRef &color,const MapboxTransDoubleRef &opacity)
+{
+    if (!opacity || opacity->isExpression())
+    {
+        return opacity ? opacity->expression() : FloatExpressionInfoRef();
+    }
+    if (!color || !color->isExpression() || color->hasAlphaOverride())
+    {
+        return FloatExpressionInfoRef();
+    }
+
+    const auto val = (float)opacity->valForZoom(0);
+    if (val >= 1.0f)
+    {
+        return FloatExpressionInfoRef();
+    }
+
+    // One stop is the same value everywhere
+    auto floatExp = std::make_shared<FloatExpressionInfo>();
+    floatExp->type = ExpressionLinear;
+    floatExp->stopInputs.push_back(0.0f);
+    floatExp->stopOutputs.push_back(val);
+    return floatExp;
+}
+
 RGBAColor MapboxVectorStyleSetImpl::color(RGBAColor color,double opacity)
 {
     return {
@@ -989,6 +1166,17 @@ RGBAColorRef MapboxVectorStyleSetImpl::backgroundColor(PlatformThreadInfo *inst,
     return RGBAColorRef();
 }
 
+const std::vector<MapboxVectorStyleLayerRef> *MapboxVectorStyleSetImpl::layersForTile(const std::string &layerName,int level) const
+{
+    const auto it = layersBySourceLevel.find(layerName);
+    if (it == layersBySourceLevel.end())
+    {
+        return nullptr;
+    }
+    const auto &layers = it->second[std::max(0, std::min(level, MaxLayerLevel))];
+    return layers.empty() ? nullptr : &layers;
+}
+
 std::vector<VectorStyleImplRef> MapboxVectorStyleSetImpl::stylesForFeature(PlatformThreadInfo *inst,
                                                                            const Dictionary &attrs,
                                                                            const QuadTreeIdentifier &tileID,
@@ -996,15 +1184,19 @@ std::vector<VectorStyleImplRef> MapboxVectorStyleSetImpl::stylesForFeature(Platf
 {
     std::vector<VectorStyleImplRef> styles;
 
-    const auto range = layersBySource.equal_range(layerName);
-    for (auto i = range.first; i != range.second; ++i)
+    const auto candidates = layersForTile(layerName, tileID.level);
+    if (!candidates)
+    {
+        return styles;
+    }
+
+    for (const auto &layer : *candidates)
     {
-        auto &layer = i->second;
         if (!layer->filter || layer->filter->testFeature(attrs, tileID))
         {
             if (styles.empty())
             {
-                styles.reserve(std::distance(range.first, range.second));
+                styles.reserve(candidates->size());
             }
             styles.push_back(layer);
         }
@@ -1018,15 +1210,44 @@ bool MapboxVectorStyleSetImpl::layerShouldDisplay(PlatformThreadInfo *inst,
                                                   const std::string &layerName,
                                                   const QuadTreeNew::Node &tileID)
 {
-    const auto range = layersBySource.equal_range(layerName);
-    for (auto i = range.first; i != range.second; ++i)
+    // Visibility can be changed at any time, so that's checked here
+    const auto candidates = layersForTile(layerName, tileID.level);
+    return candidates && std::any_of(candidates->begin(), candidates->end(),
+                                     [](const auto &layer){ return layer->visible || !layer->representation.empty(); });
+}
+
+bool MapboxVectorStyleSetImpl::attributeKeysForLayer(PlatformThreadInfo *inst,
+                                                     const std::string &layerName,
+                                                     std::set<std::string> &keys)
+{
+    std::lock_guard<std::mutex> guardLock(attrKeysLock);
+
+    auto it = attrKeysBySource.find(layerName);
+    if (it == attrKeysBySource.end())
     {
-        if (i->second->visible || !i->second->representation.empty())
+        auto layerKeys = std::make_shared<std::set<std::string>>();
+        bool allKeys = false;
+        const auto range = layersBySource.equal_range(layerName);
+        for (auto i = range.first; i != range.second && !allKeys; ++i)
         {
-            return true;
+            allKeys = !i->second->attributeKeys(*layerKeys);
         }
+
+        // Vectors can carry their own color
+        if (tileStyleSettings && tileStyleSettings->enableOverrideColor)
+        {
+            layerKeys->insert("color");
+        }
+
+        it = attrKeysBySource.insert(std::make_pair(layerName, allKeys ? KeySetRef() : KeySetRef(layerKeys))).first;
     }
-    return false;
+
+    if (!it->second)
+    {
+        return false;
+    }
+    keys.insert(it->second->begin(), it->second->end());
+    return true;
 }
 
 /// Return the style associated with the given UUID.
@@ -1047,6 +1268,74 @@ void MapboxVectorStyleSetImpl::addSprites(MapboxVectorStyleSpritesRef newSprites
     sprites = std::move(newSprites);
 }
 
+const std::string &MapboxVectorStyleSetImpl::defaultWarmUpChars()
+{
+    static const std::string chars = []{
+        std::string str;
+        for (int ch = 0x20; ch < 0x7f; ch++)
+        {
+            str.push_back((char)ch);
+        }
+        // As UTF-8
+        for (int ch = 0xa1; ch <= 0xff; ch++)
+        {
+            str.push_back((char)(0xc0 | (ch >> 6)));
+            str.push_back((char)(0x80 | (ch & 0x3f)));
+        }
+        return str;
+    }();
+    return chars;
+}
+
+void MapboxVectorStyleSetImpl::warmUpGlyphs(PlatformThreadInfo *inst,int zoomLevel,const std::string &chars,
+                                            const WarmUpProgressFunc &progress)
+{
+    std::vector<MapboxVectorLayerSymbol *> symbolLayers;
+    for (const auto &layer : layers)
+    {
+        if (auto symbolLayer = dynamic_cast<MapboxVectorLayerSymbol *>(layer.get()))
+        {
+            if (zoomLevel >= symbolLayer->minzoom && zoomLevel <= symbolLayer->maxzoom)
+            {
+                symbolLayers.push_back(symbolLayer);
+            }
+        }
+    }
+
+    // Layers sharing a font just add references to glyphs that are already there
+    ChangeSet changes;
+    std::vector<SimpleIdentity> strIDs;
+    for (size_t ii = 0; ii < symbolLayers.size(); ii++)
+    {
+        symbolLayers[ii]->warmUpGlyphs(inst, zoomLevel, chars, strIDs, changes);
+        if (progress)
+        {
+            progress((int)ii + 1, (int)symbolLayers.size());
+        }
+    }
+    scene->addChangeRequests(changes);
+
+    std::lock_guard<std::mutex> guardLock(warmUpLock);
+    warmUpStrIDs.insert(warmUpStrIDs.end(), strIDs.begin(), strIDs.end());
+}
+
+void MapboxVectorStyleSetImpl::releaseWarmUp(PlatformThreadInfo *inst,ChangeSet &changes)
+{
+    std::vector<SimpleIdentity> strIDs;
+    {
+        std::lock_guard<std::mutex> guardLock(warmUpLock);
+        strIDs.swap(warmUpStrIDs);
+    }
+
+    if (const auto fontTexManager = scene->getFontTextureManager())
+    {
+        for (const auto strID : strIDs)
+        {
+            fontTexManager->removeString(inst, strID, changes, 0.0);
+        }
+    }
+}
+
 bool MapboxVectorStyleSetImpl::hasRepresentations()
 {
     return std::any_of(layers.begin(), layers.end(),
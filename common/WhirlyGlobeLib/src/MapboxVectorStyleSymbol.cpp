@@ -205,6 +205,26 @@ static float calcStringHash(const std::string &str)
     return val / (float)len / 256.0f;
 }
 
+bool MapboxVectorLayerSymbol::attributeKeys(std::set<std::string> &keys) const
+{
+    if (!MapboxVectorStyleLayer::attributeKeys(keys))
+    {
+        return false;
+    }
+
+    if (layout.textField)
+    {
+        layout.textField->collectKeys(keys);
+    }
+    if (layout.iconImageField)
+    {
+        layout.iconImageField->collectKeys(keys);
+    }
+    keys.insert("rank");
+
+    return true;
+}
+
 MapboxVectorStyleLayerRef MapboxVectorLayerSymbol::clone() const
 {
     auto layer = std::make_shared<MapboxVectorLayerSymbol>(styleSet);
@@ -413,6 +433,83 @@ static const char *genMergeId(std::array<char,N> &buf)
     return (res > 0 && res < buf.size() - 1) ? &buf[0] : nullptr;
 }
 
+float MapboxVectorLayerSymbol::calcTextSize(int zoomLevel, bool merged) const
+{
+    // If we will be producing both icons and text, it's likely that their sizes need to correspond
+    // (e.g., highway shields) so we can't apply independent scale factors.  For now, use the marker
+    // scales for the text instead of the normal text scale.
+    const auto renderScale = styleSet->tileStyleSettings->rendererScale;
+    // see setupMarker
+    const auto markerCombinedScale =
+        styleSet->tileStyleSettings->markerScale * styleSet->tileStyleSettings->symbolScale *
+        (layout.iconSize->isExpression() ? 1.0 : layout.iconSize->valForZoom(zoomLevel));
+    // todo: An extra renderScale (or just 2?) seems to be needed here, why?
+    const auto textScale = merged ? markerCombinedScale * renderScale : layout.globalTextScale;
+    // Render at the max size and then scale dynamically
+    return (float)(layout.textSize->maxVal() * textScale / renderScale);
+}
+
+LabelInfoRef MapboxVectorLayerSymbol::setupLabelInfo(PlatformThreadInfo *inst, int zoomLevel, float textSize,
+                                                     bool merged, const RGBAColorRef &textColor)
+{
+    const auto labelInfo = styleSet->makeLabelInfo(inst,layout.textFontNames,textSize,merged);
+    if (!labelInfo)
+    {
+        return labelInfo;
+    }
+
+    labelInfo->textColor = textColor ? *textColor : RGBAColor::white();
+
+    if (paint.textHaloColor && paint.textHaloWidth)
+    {
+        labelInfo->outlineColor = paint.textHaloColor->colorForZoom(zoomLevel);
+        // Note: We're not using blur right here
+        labelInfo->outlineSize = std::max(0.5, (paint.textHaloWidth->valForZoom(zoomLevel) -
+                                                paint.textHaloBlur->valForZoom(zoomLevel)));
+    }
+
+    return labelInfo;
+}
+
+void MapboxVectorLayerSymbol::warmUpGlyphs(PlatformThreadInfo *inst, int zoomLevel, const std::string &chars,
+                                           std::vector<SimpleIdentity> &strIDs, ChangeSet &changes)
+{
+    const auto fontTexManager = styleSet->scene->getFontTextureManager();
+    if (!visible || chars.empty() || !layout.textField || !fontTexManager)
+    {
+        return;
+    }
+
+    const auto textColor = MapboxVectorStyleSetImpl::resolveColor(paint.textColor, nullptr, zoomLevel,
+                                                                  MBResolveColorOpacityReplaceAlpha);
+    if (!textColor)
+    {
+        return;
+    }
+
+    // Whether it merges depends on the feature, so this is a guess
+    const bool merged = layout.iconImageField && styleSet->sprites;
+    const auto textSize = calcTextSize(zoomLevel, merged);
+    if (textSize < 1)
+    {
+        return;
+    }
+
+    const auto labelInfo = setupLabelInfo(inst, zoomLevel, textSize, merged, textColor);
+    const auto label = labelInfo ? styleSet->makeSingleLabel(inst, chars) : SingleLabelRef();
+    if (!label)
+    {
+        return;
+    }
+
+    // The glyphs stay in the atlas as long as the strings do
+    float lineHeight = 0.0f;
+    for (const auto &drawStr : label->generateDrawableStrings(inst, labelInfo.get(), fontTexManager, lineHeight, changes))
+    {
+        strIDs.push_back(drawStr->getId());
+    }
+}
+
 void MapboxVectorLayerSymbol::buildObjects(PlatformThreadInfo *inst,
                                            const std::vector<VectorObjectRef> &vecObjs,
                                            const VectorTileDataRef &tileInfo,
@@ -445,18 +542,7 @@ void MapboxVectorLayerSymbol::buildObjects(PlatformThreadInfo *inst,
     // If we're doing a merged symbol, the font height needs to be treated differently
     const auto merged = textInclude && iconInclude;
 
-    // If we will be producing both icons and text, it's likely that their sizes need to correspond
-    // (e.g., highway shields) so we can't apply independent scale factors.  For now, use the marker
-    // scales for the text instead of the normal text scale.
-    const auto renderScale = styleSet->tileStyleSettings->rendererScale;
-    // see setupMarker
-    const auto markerCombinedScale =
-        styleSet->tileStyleSettings->markerScale * styleSet->tileStyleSettings->symbolScale *
-        (layout.iconSize->isExpression() ? 1.0 : layout.iconSize->valForZoom(tileInfo->ident.level));
-    // todo: An extra renderScale (or just 2?) seems to be needed here, why?
-    const auto textScale = merged ? markerCombinedScale * renderScale : layout.globalTextScale;
-    // Render at the max size and then scale dynamically
-    const auto textSize = (float)(layout.textSize->maxVal() * textScale / renderScale);
+    const auto textSize = calcTextSize(zoomLevel, merged);
 
     // todo: if icon size is an expression, make text size an expression based on it?
     //if (layout.iconSize->isExpression())
@@ -468,7 +554,7 @@ void MapboxVectorLayerSymbol::buildObjects(PlatformThreadInfo *inst,
         return;
     }
 
-    const auto labelInfo = styleSet->makeLabelInfo(inst,layout.textFontNames,textSize,merged);
+    const auto labelInfo = setupLabelInfo(inst, zoomLevel, textSize, merged, textColor);
     if (!labelInfo)
     {
         return;
@@ -488,7 +574,6 @@ void MapboxVectorLayerSymbol::buildObjects(PlatformThreadInfo *inst,
         labelInfo->textJustify = layout.textJustify;
         labelInfo->drawPriority = priority;
         labelInfo->opacityExp = paint.textOpacity->expression();
-        labelInfo->textColor = textColor ? *textColor : RGBAColor::white();
 
         // We can apply a scale, but it needs to be scaled to the current text size.
         // That is, the expression produces [0.0,1.0] when is then multiplied by textSize
@@ -502,14 +587,6 @@ void MapboxVectorLayerSymbol::buildObjects(PlatformThreadInfo *inst,
             }
         }
 
-        if (paint.textHaloColor && paint.textHaloWidth)
-        {
-            labelInfo->outlineColor = paint.textHaloColor->colorForZoom(zoomLevel);
-            // Note: We're not using blur right here
-            labelInfo->outlineSize = std::max(0.5, (paint.textHaloWidth->valForZoom(zoomLevel) -
-                                                    paint.textHaloBlur->valForZoom(zoomLevel)));
-        }
-
         labelInfo->hasExp = labelInfo->scaleExp || labelInfo->opacityExp;
     }
 
@@ -22,6 +22,8 @@
 #import "WhirlyKitLog.h"
 #import "DictionaryC.h"
 #import "VectorTilePBFParser.h"
+#import "BasicDrawable.h"
+#import "StableBytes.h"
 
 #include <utility>
 #import <vector>
@@ -164,6 +166,149 @@ static inline double secondsSince(const std::chrono::steady_clock::time_point &t
     return (double)duration_cast<nanoseconds>(steady_clock::now() - t0).count() / 1.0e9;
 }
 
+VectorTileCache::VectorTileCache(size_t maxBytes) :
+    maxBytes(maxBytes)
+{
+}
+
+size_t VectorTileCache::getBytes() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return bytes;
+}
+
+void VectorTileCache::clear()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    entries.clear();
+    entriesByTile.clear();
+    bytes = 0;
+}
+
+void VectorTileCache::addMemoryUsage(MemoryUsage &usage)
+{
+    usage.bytes[MemParsedTiles] += getBytes();
+}
+
+void VectorTileCache::trimMemory(PlatformThreadInfo *,MemoryTrimLevel step,ChangeSet &)
+{
+    if (step == MemTrimDecodeCaches)
+    {
+        clear();
+    }
+}
+
+uint64_t VectorTileCache::hashData(const RawData *rawData)
+{
+    return StableHash(rawData->getRawData(),rawData->getLen());
+}
+
+size_t VectorTileCache::estimateBytes(const CompactShapeSet &shapes)
+{
+    // Rough guess at the attributes, which are shared with the first decode and aren't compacted
+    return shapes.getBytes() + shapes.size() * 8 * 48;
+}
+
+bool VectorTileCache::fetch(const QuadTreeIdentifier &ident,int styleGeneration,const RawData *rawData,
+                            std::map<SimpleIdentity,std::vector<VectorObjectRef> *> &vecObjsByStyle)
+{
+    const auto dataHash = hashData(rawData);
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    const auto it = entriesByTile.find(ident.NodeNumber());
+    if (it == entriesByTile.end())
+    {
+        return false;
+    }
+    const auto entryIt = it->second;
+    if (entryIt->styleGeneration != styleGeneration || entryIt->dataHash != dataHash)
+    {
+        // Stale, it'll get replaced once this one's parsed
+        return false;
+    }
+
+    entries.splice(entries.begin(), entries, entryIt);
+
+    // Fresh objects every time, so the styles can't step on each other's geometry
+    std::vector<VectorObjectRef> vecObjs(entryIt->vecObjs.size());
+    for (size_t ii = 0; ii < vecObjs.size(); ii++)
+    {
+        vecObjs[ii] = std::make_shared<VectorObject>();
+        vecObjs[ii]->uncompact(entryIt->vecObjs[ii]);
+        vecObjs[ii]->selectable = entryIt->selectable[ii];
+    }
+
+    for (const auto &kv : entryIt->vecObjsByStyle)
+    {
+        auto &vecs = vecObjsByStyle[kv.first];
+        if (!vecs)
+        {
+            vecs = new std::vector<VectorObjectRef>();
+        }
+        vecs->reserve(vecs->size() + kv.second.size());
+        for (const auto which : kv.second)
+        {
+            vecs->push_back(vecObjs[which]);
+        }
+    }
+    return true;
+}
+
+void VectorTileCache::store(const QuadTreeIdentifier &ident,int styleGeneration,const RawData *rawData,
+                            const std::map<SimpleIdentity,std::vector<VectorObjectRef> *> &vecObjsByStyle)
+{
+    Entry entry;
+    entry.tileNumber = ident.NodeNumber();
+    entry.styleGeneration = styleGeneration;
+    entry.dataHash = hashData(rawData);
+    entry.bytes = sizeof(Entry);
+
+    std::unordered_map<const VectorObject *,uint32_t> objIndex;
+    for (const auto &kv : vecObjsByStyle)
+    {
+        auto &which = entry.vecObjsByStyle[kv.first];
+        which.reserve(kv.second->size());
+        for (const auto &vecObj : *kv.second)
+        {
+            const auto ins = objIndex.insert(std::make_pair(vecObj.get(), (uint32_t)entry.vecObjs.size()));
+            if (ins.second)
+            {
+                entry.vecObjs.push_back(vecObj->compact());
+                entry.selectable.push_back(vecObj->selectable);
+                entry.bytes += estimateBytes(entry.vecObjs.back());
+            }
+            which.push_back(ins.first->second);
+        }
+    }
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    const auto it = entriesByTile.find(entry.tileNumber);
+    if (it != entriesByTile.end())
+    {
+        bytes -= it->second->bytes;
+        entries.erase(it->second);
+        entriesByTile.erase(it);
+    }
+
+    if (entry.bytes > maxBytes)
+    {
+        return;
+    }
+
+    bytes += entry.bytes;
+    entries.push_front(std::move(entry));
+    entriesByTile[entries.front().tileNumber] = entries.begin();
+
+    while (bytes > maxBytes && !entries.empty())
+    {
+        bytes -= entries.back().bytes;
+        entriesByTile.erase(entries.back().tileNumber);
+        entries.pop_back();
+    }
+}
+
 static bool noCancel(PlatformThreadInfo*) { return false; }
 
 bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst, RawData *rawData,
@@ -178,56 +323,87 @@ bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst,
                                    VectorTileData *tileData,
                                    const CancelFunction &cancelFn)
 {
+    WKTraceScope("MVT parse");
+
 //#if DEBUG
 //    wkLogLevel(Verbose, "MapboxVectorTileParser: Parse [%d/%d/%d] starting",
 //               tileData->ident.level, tileData->ident.x, tileData->ident.y);
 //#endif
     const auto t0 = std::chrono::steady_clock::now();
 
-    VectorTilePBFParser parser(tileData, &*styleDelegate, styleInst, filterName, filterValues,
-                               tileData->vecObjsByStyle, localCoords, parseAll,
-                               keepVectors ? &tileData->vecObjs : nullptr, cancelFn);
-    if (!parser.parse(rawData->getRawData(), rawData->getLen()))
+    // We're going to go through all of it, hashing or parsing, so get it coming in if it's mapped
+    rawData->willRead();
+
+    // Decoded features kept from an earlier parse of the same data work as long as the styles haven't moved
+    const int styleGeneration = (tileCache && !keepVectors && !parseAll) ? styleDelegate->getStyleGeneration() : -1;
+    const bool cached = (styleGeneration >= 0 &&
+                         tileCache->fetch(tileData->ident, styleGeneration, rawData, tileData->vecObjsByStyle));
+    if (!cached)
     {
-        if (parser.getParseCancelled())
+        VectorTilePBFParser parser(tileData, &*styleDelegate, styleInst, filterName, filterValues,
+                                   tileData->vecObjsByStyle, localCoords, parseAll,
+                                   keepVectors ? &tileData->vecObjs : nullptr, cancelFn);
+
+        // Overzoomed, so the data covers the ancestor at the source's max zoom
+        const auto &ident = tileData->ident;
+        if (sourceMaxZoom >= 0 && ident.level > sourceMaxZoom && tileData->bbox.valid())
         {
-            const auto duration = secondsSince(t0);
-            wkLogLevel(Verbose, "MapboxVectorTileParser: Cancelled [%d/%d/%d] - %.2f MiB - %.4f s",
-                       tileData->ident.level, tileData->ident.x, tileData->ident.y,
-                       rawData->getLen() / 1024.0 / 1024, duration);
+            const int dl = ident.level - sourceMaxZoom;
+            const int n = 1 << dl;
+            const double width = tileData->bbox.ur().x() - tileData->bbox.ll().x();
+            const double height = tileData->bbox.ur().y() - tileData->bbox.ll().y();
+            const Point2d srcLL(tileData->bbox.ll().x() - (ident.x - ((ident.x >> dl) << dl)) * width,
+                                tileData->bbox.ll().y() - (ident.y - ((ident.y >> dl) << dl)) * height);
+            parser.setSourceBounds(MbrD(srcLL, srcLL + Point2d(n * width, n * height)));
         }
-        else
+
+        if (!parser.parse(rawData->getRawData(), rawData->getLen()))
         {
-            wkLogLevel(Warn, "MapboxVectorTileParser: Parse [%d/%d/%d] failed - '%s'",
-                       tileData->ident.level, tileData->ident.x, tileData->ident.y,
-                       parser.getErrorString("unknown").c_str());
-#if DEBUG
-            if (parser.getTotalErrorCount() > 0)
+            if (parser.getParseCancelled())
             {
-                wkLogLevel(Debug,
-                           "MapboxVectorTileParser: [%d/%d/%d] parse Errors: %d, Bad Attributes: %d, "
-                           "Unknown Commands: %d, Unknown Geom: %d, Unknown Value Types: %d",
+                const auto duration = secondsSince(t0);
+                wkLogLevel(Verbose, "MapboxVectorTileParser: Cancelled [%d/%d/%d] - %.2f MiB - %.4f s",
                            tileData->ident.level, tileData->ident.x, tileData->ident.y,
-                           parser.getParseErrorCount(),
-                           parser.getBadAttributeCount(),
-                           parser.getUnknownCommandCount(),
-                           parser.getUknownGeomTypeCount(),
-                           parser.getUnknownValueTypeCount());
+                           rawData->getLen() / 1024.0 / 1024, duration);
             }
+            else
+            {
+                wkLogLevel(Warn, "MapboxVectorTileParser: Parse [%d/%d/%d] failed - '%s'",
+                           tileData->ident.level, tileData->ident.x, tileData->ident.y,
+                           parser.getErrorString("unknown").c_str());
+#if DEBUG
+                if (parser.getTotalErrorCount() > 0)
+                {
+                    wkLogLevel(Debug,
+                               "MapboxVectorTileParser: [%d/%d/%d] parse Errors: %d, Bad Attributes: %d, "
+                               "Unknown Commands: %d, Unknown Geom: %d, Unknown Value Types: %d",
+                               tileData->ident.level, tileData->ident.x, tileData->ident.y,
+                               parser.getParseErrorCount(),
+                               parser.getBadAttributeCount(),
+                               parser.getUnknownCommandCount(),
+                               parser.getUknownGeomTypeCount(),
+                               parser.getUnknownValueTypeCount());
+                }
 #endif
+            }
+            return false;
         }
-        return false;
-    }
 
 #if DEBUG
-    const auto duration = std::max(1e-9, secondsSince(t0));
-    wkLogLevel(Verbose, "MapboxVectorTileParser: Finished [%d/%d/%d] - %.2f MiB - %.4f s - %.4f MiB/s - %.1f features/s",
-               tileData->ident.level, tileData->ident.x, tileData->ident.y,
-               rawData->getLen() / 1024.0 / 1024,
-               duration, rawData->getLen() / duration / 1024 / 1024,
-               parser.getFeatureCount() / duration);
+        const auto duration = std::max(1e-9, secondsSince(t0));
+        wkLogLevel(Verbose, "MapboxVectorTileParser: Finished [%d/%d/%d] - %.2f MiB - %.4f s - %.4f MiB/s - %.1f features/s",
+                   tileData->ident.level, tileData->ident.x, tileData->ident.y,
+                   rawData->getLen() / 1024.0 / 1024,
+                   duration, rawData->getLen() / duration / 1024 / 1024,
+                   parser.getFeatureCount() / duration);
 #endif
 
+        if (styleGeneration >= 0)
+        {
+            tileCache->store(tileData->ident, styleGeneration, rawData, tileData->vecObjsByStyle);
+        }
+    }
+
     // TODO: Switch to stencils and get this working again
     // Call background
 //    if (const auto backgroundStyle = styleDelegate->backgroundStyle(styleInst)) {
@@ -239,39 +415,18 @@ bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst,
 //    }
     
     // Run the styles over their assembled data
-    for (const auto &it : tileData->vecObjsByStyle)
+    const bool built = (buildWorkers && tileData->vecObjsByStyle.size() > 1) ?
+            buildStylesParallel(styleInst,tileData,cancelFn) :
+            buildStyles(styleInst,tileData,cancelFn);
+    if (!built)
     {
-        std::vector<VectorObjectRef> &vecs = *it.second;
-
-        auto styleData = std::make_shared<VectorTileData>(*tileData);
-
-        // Ask the subclass to run the style and fill in the VectorTileData
-        buildForStyle(styleInst,it.first,vecs,styleData,cancelFn);
-
-        // Sort the results into categories if needed
-        auto catIt = styleCategories.find(it.first);
-        if (catIt != styleCategories.end() && !styleData->compObjs.empty())
-        {
-            const std::string &category = catIt->second;
-            auto &compObjs = styleData->compObjs;
-            auto categoryIt = tileData->categories.find(category);
-            if (categoryIt != tileData->categories.end())
-            {
-                compObjs.insert(compObjs.end(), categoryIt->second.begin(), categoryIt->second.end());
-            }
-            tileData->categories[category] = compObjs;
-        }
-        
-        // Merge this into the general return data
-        tileData->mergeFrom(styleData.get());
+        return false;
+    }
 
-        // The changes in `tileData` represent objects already tracked
-        // in the managers they must be merged or we'll have leaks, so
-        // we can't return between the build and the merge above.
-        if (cancelFn(styleInst))
-        {
-            return false;
-        }
+    // Styles each build their own drawables, lots of them small and drawn the same way
+    if (mergeDrawables)
+    {
+        MergeBasicDrawables(tileData->changes);
     }
     
     // These are layered on top for debugging
@@ -321,6 +476,92 @@ bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst,
     return true;
 }
 
+void MapboxVectorTileParser::setTileCacheSize(size_t maxBytes)
+{
+    tileCache = maxBytes ? std::make_shared<VectorTileCache>(maxBytes) : VectorTileCacheRef();
+}
+
+void MapboxVectorTileParser::setBuildThreads(int numThreads)
+{
+    buildWorkers.reset(numThreads > 0 ? new WorkerPool(numThreads) : nullptr);
+}
+
+void MapboxVectorTileParser::mergeStyleData(long long styleID,VectorTileData *tileData,VectorTileData *styleData)
+{
+    // Sort the results into categories if needed
+    auto catIt = styleCategories.find(styleID);
+    if (catIt != styleCategories.end() && !styleData->compObjs.empty())
+    {
+        const std::string &category = catIt->second;
+        auto &compObjs = styleData->compObjs;
+        auto categoryIt = tileData->categories.find(category);
+        if (categoryIt != tileData->categories.end())
+        {
+            compObjs.insert(compObjs.end(), categoryIt->second.begin(), categoryIt->second.end());
+        }
+        tileData->categories[category] = compObjs;
+    }
+
+    // Merge this into the general return data
+    tileData->mergeFrom(styleData);
+}
+
+bool MapboxVectorTileParser::buildStyles(PlatformThreadInfo *styleInst,VectorTileData *tileData,const CancelFunction &cancelFn)
+{
+    for (const auto &it : tileData->vecObjsByStyle)
+    {
+        std::vector<VectorObjectRef> &vecs = *it.second;
+
+        auto styleData = std::make_shared<VectorTileData>(*tileData);
+
+        // Ask the subclass to run the style and fill in the VectorTileData
+        buildForStyle(styleInst,it.first,vecs,styleData,cancelFn);
+
+        mergeStyleData(it.first,tileData,styleData.get());
+
+        // The changes in `tileData` represent objects already tracked
+        // in the managers they must be merged or we'll have leaks, so
+        // we can't return between the build and the merge above.
+        if (cancelFn(styleInst))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MapboxVectorTileParser::buildStylesParallel(PlatformThreadInfo *styleInst,VectorTileData *tileData,const CancelFunction &cancelFn)
+{
+    WKTraceScope("MVT parallel build");
+
+    // Each style gets its own output, in the same order we'd do them serially
+    std::vector<std::pair<long long,std::vector<VectorObjectRef> *>> styleVecs(tileData->vecObjsByStyle.begin(),
+                                                                               tileData->vecObjsByStyle.end());
+    std::vector<VectorTileDataRef> styleDatas(styleVecs.size());
+    for (auto &styleData : styleDatas)
+    {
+        styleData = std::make_shared<VectorTileData>(*tileData);
+    }
+
+    buildWorkers->parallelFor(styleVecs.size(),1,[&](size_t start,size_t end) {
+        for (size_t ii=start;ii<end;ii++)
+        {
+            if (!cancelFn(styleInst))
+            {
+                buildForStyle(styleInst,styleVecs[ii].first,*styleVecs[ii].second,styleDatas[ii],cancelFn);
+            }
+        }
+    });
+
+    // Whatever got built is tracked by the managers, so it all has to be merged, cancelled or not
+    for (size_t ii=0;ii<styleVecs.size();ii++)
+    {
+        mergeStyleData(styleVecs[ii].first,tileData,styleDatas[ii].get());
+    }
+
+    return !cancelFn(styleInst);
+}
+
 void MapboxVectorTileParser::buildForStyle(PlatformThreadInfo *styleInst,
                                            long long styleID,
                                            const std::vector<VectorObjectRef> &vecObjs,
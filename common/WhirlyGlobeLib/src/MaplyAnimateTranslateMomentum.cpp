@@ -60,6 +60,26 @@ bool AnimateTranslateMomentum::withinBounds(const Point3d &loc,MapView *testMapV
     return MaplyGestureWithinBounds(bounds,loc,renderer,testMapView,newCenter);
 }
 
+bool AnimateTranslateMomentum::predictView(WhirlyKit::View *view,TimeInterval ahead)
+{
+    auto mapView = (MapView *)view;
+    if (startDate == 0.0)
+        return false;
+
+    const double sinceStart = std::min(TimeGetCurrent() - startDate + ahead,(double)maxTime);
+    const double dist = (velocity + 0.5 * acceleration * sinceStart) * sinceStart;
+    const Point3d newLoc = org + dir * dist;
+
+    // If it runs into the bounds, it stops short of that and we can't tell where
+    Point3d newCenter;
+    MapView testMapView(*mapView);
+    if (!withinBounds(newLoc, &testMapView, &newCenter))
+        return false;
+    mapView->setLoc(newCenter,false);
+
+    return true;
+}
+
 // Called by the view when it's time to update
 void AnimateTranslateMomentum::updateView(WhirlyKit::View *view)
 {
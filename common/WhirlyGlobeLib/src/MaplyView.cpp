@@ -304,7 +304,19 @@ void MapView::animate()
     
 ViewStateRef MapView::makeViewState(SceneRenderer *renderer)
 {
-    return std::make_shared<MapViewState>(this,renderer);
+    auto viewState = std::make_shared<MapViewState>(this,renderer);
+
+    // See where we're going, if the animation knows
+    if (auto theDelegate = delegate)
+    {
+        MapView predictView(*this);
+        if (predictionTime > 0.0 && theDelegate->predictView(&predictView,predictionTime))
+        {
+            viewState->predictedState = std::make_shared<MapViewState>(&predictView,renderer);
+        }
+    }
+
+    return viewState;
 }
 
 MapViewState::MapViewState(MapView *mapView,SceneRenderer *renderer)
@@ -21,6 +21,7 @@
 #import "ScreenSpaceBuilder.h"
 #import "SharedAttributes.h"
 #import "CoordSystem.h"
+#import "ElevationManager.h"
 #import "WhirlyKitLog.h"
 #import "MapboxVectorStyleSetC.h"
 
@@ -53,6 +54,9 @@ MarkerInfo::MarkerInfo(const Dictionary &dict,bool screenObject) :
     layoutRepeat = dict.getInt(MaplyTextLayoutRepeat,-1);
     layoutSpacing = (float)dict.getDouble(MaplyTextLayoutSpacing,24.0);
     layoutOffset = (float)dict.getDouble(MaplyTextLayoutOffset,0.0);
+    fleet = dict.getBool(MaplyMarkerFleet,false);
+    instanced = dict.getBool(MaplyMarkerInstanced,false);
+    clampToGround = dict.getBool(MaplyMarkerClampToGround,false);
 
     if (const auto entry = dict.getEntry(MaplyOpacity))
     {
@@ -230,6 +234,17 @@ SimpleIdentity MarkerManager::addMarkers(const std::vector<Marker *> &markers,co
         return EmptyIdentity;
     }
 
+    // Heights for markers sitting on the terrain, if there's terrain loaded
+    ElevationManagerRef elevManager;
+    if (markerInfo.clampToGround && !coordAdapter->isFlat())
+    {
+        elevManager = scene->getManager<ElevationManager>(kWKElevationManager);
+        if (elevManager && !elevManager->hasData())
+        {
+            elevManager.reset();
+        }
+    }
+
     auto markerRep = std::make_unique<MarkerSceneRep>();
     markerRep->fadeOut = (float)markerInfo.fadeOut;
     
@@ -244,6 +259,11 @@ SimpleIdentity MarkerManager::addMarkers(const std::vector<Marker *> &markers,co
     std::vector<LayoutObjectRef> layoutObjects;
     layoutObjects.reserve(markers.size());
 
+    // Selectables go in at the end, all together
+    SelectionBatch selectBatch;
+    // Select IDs to go with the screen shapes, for a fleet
+    std::vector<SimpleIdentity> fleetSelectIDs;
+
     bool cancel = false;
     for (auto &marker : markers)
     {
@@ -257,7 +277,11 @@ SimpleIdentity MarkerManager::addMarkers(const std::vector<Marker *> &markers,co
         const float width2 = (marker->width == 0.0f ? markerInfo.width : marker->width)/2.0f;
         const float height2 = (marker->height == 0.0f ? markerInfo.height : marker->height)/2.0f;
         
-        const Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal3d(marker->loc);
+        Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal3d(marker->loc);
+        if (elevManager)
+        {
+            localPt.z() = elevManager->heightAt(Point2d(marker->loc.x(),marker->loc.y()));
+        }
         const Vector3d norm = coordAdapter->normalForLocal(localPt);
         
         // Look for a texture sub mapping
@@ -298,6 +322,11 @@ SimpleIdentity MarkerManager::addMarkers(const std::vector<Marker *> &markers,co
             {
                 layoutImport = marker->layoutImportance;
             }
+            if (markerInfo.fleet)
+            {
+                // The layout engine would be fighting the moves
+                layoutImport = MAXFLOAT;
+            }
 
             std::shared_ptr<LayoutObject> layoutObj;
             std::shared_ptr<ScreenSpaceObject> shape;   // may or may not alias layoutObj
@@ -358,6 +387,11 @@ SimpleIdentity MarkerManager::addMarkers(const std::vector<Marker *> &markers,co
                 const Point3d display = coordAdapter->localToDisplay(local);
                 shape->setMovingLoc(display, marker->startTime, marker->endTime);
             }
+            else if (markerInfo.fleet)
+            {
+                // Standing still, but it needs the motion setup to be moved later
+                shape->setMovingLoc(shape->getWorldLoc(), curTime, curTime);
+            }
 
             if (marker->lockRotation)
             {
@@ -480,32 +514,48 @@ SimpleIdentity MarkerManager::addMarkers(const std::vector<Marker *> &markers,co
                         pts2f[jj] = Point2f(pts[jj].x(), pts[jj].y());
                     }
 
-                    if (marker->hasMotion)
+                    if (markerInfo.fleet)
                     {
-                        selectManager->addSelectableMovingScreenRect(marker->selectID,
-                                                                     shape->getWorldLoc(),
-                                                                     shape->getEndWorldLoc(),
-                                                                     shape->getStartTime(),
-                                                                     shape->getEndTime(), pts2f,
-                                                                     (float)markerInfo.minVis,
-                                                                     (float)markerInfo.maxVis,
-                                                                     markerInfo.enable);
+                        // Always moving, so the selectable can be redirected along with it
+                        const Point3d dir = marker->hasMotion ?
+                            Point3d((shape->getEndWorldLoc() - shape->getWorldLoc()) /
+                                    std::max(shape->getEndTime() - shape->getStartTime(), 1e-6)) :
+                            Point3d(0,0,0);
+                        const TimeInterval locTime = marker->hasMotion ? shape->getStartTime() : curTime;
+                        selectBatch.addSelectableMovingScreenRect(marker->selectID,
+                                                                  shape->getWorldLoc(),
+                                                                  shape->getWorldLoc() + dir,
+                                                                  locTime, locTime + 1.0, pts2f,
+                                                                  (float)markerInfo.minVis,
+                                                                  (float)markerInfo.maxVis,
+                                                                  markerInfo.enable);
                     }
-                    else
-                        {
-                        selectManager->addSelectableScreenRect(marker->selectID,
-                                                               shape->getWorldLoc(),
-                                                               pts2f,
-                                                               (float)markerInfo.minVis,
-                                                               (float)markerInfo.maxVis,
-                                                               markerInfo.enable);
+                    else if (marker->hasMotion)
+                    {
+                        selectBatch.addSelectableMovingScreenRect(marker->selectID,
+                                                                  shape->getWorldLoc(),
+                                                                  shape->getEndWorldLoc(),
+                                                                  shape->getStartTime(),
+                                                                  shape->getEndTime(), pts2f,
+                                                                  (float)markerInfo.minVis,
+                                                                  (float)markerInfo.maxVis,
+                                                                  markerInfo.enable);
                     }
-                    if (!markerInfo.enable)
+                    else
                     {
-                        selectManager->enableSelectable(marker->selectID, false);
+                        selectBatch.addSelectableScreenRect(marker->selectID,
+                                                            shape->getWorldLoc(),
+                                                            pts2f,
+                                                            (float)markerInfo.minVis,
+                                                            (float)markerInfo.maxVis,
+                                                            markerInfo.enable);
                     }
                 }
 
+                if (markerInfo.fleet)
+                {
+                    fleetSelectIDs.push_back(selectManager ? marker->selectID : EmptyIdentity);
+                }
                 screenShapes.push_back(std::move(shape));
             }
         }
@@ -595,10 +645,10 @@ SimpleIdentity MarkerManager::addMarkers(const std::vector<Marker *> &markers,co
 
             if (selectManager)
             {
-                selectManager->addSelectableRect(marker->selectID,pts,
-                                                 (float)markerInfo.minVis,
-                                                 (float)markerInfo.maxVis,
-                                                 markerInfo.enable);
+                selectBatch.addSelectableRect(marker->selectID,pts,
+                                              (float)markerInfo.minVis,
+                                              (float)markerInfo.maxVis,
+                                              markerInfo.enable);
                 markerRep->selectIDs.insert(marker->selectID);
             }
         }
@@ -624,11 +674,43 @@ SimpleIdentity MarkerManager::addMarkers(const std::vector<Marker *> &markers,co
         if (!cancel && renderer)
         {
             ScreenSpaceBuilder ssBuild(renderer,coordAdapter,renderer->getScale());
-            ssBuild.addScreenObjects(screenShapes);
+            ssBuild.setInstancing(markerInfo.instanced);
+            if (markerInfo.fleet)
+            {
+                // Keep track of where each one's vertices went, so we can move them later
+                markerRep->fleet.reserve(screenShapes.size());
+                for (size_t ii=0;ii<screenShapes.size();ii++)
+                {
+                    const auto &shape = screenShapes[ii];
+                    MarkerSceneRep::FleetMarker fleetMarker;
+                    fleetMarker.selectID = fleetSelectIDs[ii];
+                    fleetMarker.loc = shape->getWorldLoc();
+                    fleetMarker.locTime = curTime;
+                    fleetMarker.dir = Point3d(0,0,0);
+                    if (shape->getStartTime() < shape->getEndTime())
+                    {
+                        fleetMarker.locTime = shape->getStartTime();
+                        fleetMarker.dir = (shape->getEndWorldLoc() - shape->getWorldLoc()) /
+                                          (shape->getEndTime() - shape->getStartTime());
+                    }
+                    ssBuild.addScreenObject(*shape, shape->getWorldLoc(), shape->getGeometry(),
+                                            nullptr, nullptr, &fleetMarker.ranges);
+                    markerRep->fleet.push_back(std::move(fleetMarker));
+                }
+            }
+            else
+            {
+                ssBuild.addScreenObjects(screenShapes);
+            }
             ssBuild.flushChanges(changes, markerRep->drawIDs);
         }
     }
     
+    if (selectManager && !cancel)
+    {
+        selectManager->addSelectables(selectBatch);
+    }
+
     // And any layout constraints to the layout engine
     if (layoutManager && !layoutObjects.empty() && !cancel)
     {
@@ -672,6 +754,101 @@ void MarkerManager::enableMarkers(SimpleIDSet &markerIDs,bool enable,ChangeSet &
     }
 }
 
+void MarkerManager::moveMarkers(SimpleIdentity markerID,const std::vector<GeoCoord> &locs,
+                                TimeInterval duration,ChangeSet &changes)
+{
+    if (!scene)
+        return;
+
+    const auto selectManager = scene->getManager<SelectionManager>(kWKSelectionManager);
+    CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
+    const CoordSystem *coordSys = coordAdapter ? coordAdapter->getCoordSystem() : nullptr;
+    if (!coordSys)
+        return;
+
+    const TimeInterval curTime = scene->getCurrentTime();
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    MarkerSceneRep dummyRep;
+    dummyRep.setId(markerID);
+    const auto it = markerReps.find(&dummyRep);
+    if (it == markerReps.end())
+        return;
+    MarkerSceneRep *markerRep = *it;
+    if (markerRep->fleet.empty())
+    {
+        wkLogLevel(Warn,"MarkerManager: Can only move markers added as a fleet");
+        return;
+    }
+
+    // Gather up the changes for each drawable so it's one request apiece
+    std::map<SimpleIdentity,std::vector<BasicDrawable::VertexMotion>> motions;
+    ScreenSpaceBuilder::InstanceChangeMap instChanges;
+    std::vector<SimpleIdentity> selectIDs;
+    Point3dVector startCenters,endCenters;
+    selectIDs.reserve(markerRep->fleet.size());
+    startCenters.reserve(markerRep->fleet.size());
+    endCenters.reserve(markerRep->fleet.size());
+
+    const size_t numMove = std::min(locs.size(),markerRep->fleet.size());
+    for (size_t ii=0;ii<numMove;ii++)
+    {
+        auto &fleetMarker = markerRep->fleet[ii];
+        const Point3d target = coordAdapter->localToDisplay(coordSys->geographicToLocal3d(locs[ii]));
+
+        // Pick up from wherever it's gotten to
+        Point3d cur = fleetMarker.loc + (curTime - fleetMarker.locTime) * fleetMarker.dir;
+        if (duration > 0.0)
+        {
+            fleetMarker.dir = (target - cur) / duration;
+        }
+        else
+        {
+            cur = target;
+            fleetMarker.dir = Point3d(0,0,0);
+        }
+        fleetMarker.loc = cur;
+        fleetMarker.locTime = curTime;
+
+        // The shader works from the drawable's start time, so back up to that
+        const Point3f dir = fleetMarker.dir.cast<float>();
+        for (auto &range : fleetMarker.ranges)
+        {
+            const Point3d startLoc = cur + (range.startTime - curTime) * fleetMarker.dir - range.center;
+            if (range.isInstance)
+            {
+                range.inst.center = startLoc;
+                range.inst.dir = fleetMarker.dir;
+                instChanges[range.drawID][range.startVert] = range.inst.getInstance();
+            }
+            else
+            {
+                motions[range.drawID].push_back(BasicDrawable::VertexMotion {
+                    range.startVert, range.numVerts, startLoc.cast<float>(), dir });
+            }
+        }
+
+        if (fleetMarker.selectID != EmptyIdentity)
+        {
+            selectIDs.push_back(fleetMarker.selectID);
+            startCenters.push_back(cur);
+            endCenters.push_back(cur + fleetMarker.dir);
+        }
+    }
+
+    for (auto &motion : motions)
+    {
+        changes.push_back(new VertexMotionChangeRequest(motion.first, std::move(motion.second)));
+    }
+    ScreenSpaceBuilder::AddInstanceChanges(instChanges, changes);
+
+    if (selectManager && !selectIDs.empty())
+    {
+        selectManager->moveSelectableScreenRects(selectIDs, startCenters, endCenters, curTime, curTime + 1.0);
+    }
+}
+
 void MarkerManager::removeMarkers(SimpleIDSet &markerIDs,ChangeSet &changes)
 {
     if (!scene)
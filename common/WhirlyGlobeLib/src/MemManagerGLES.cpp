@@ -42,6 +42,7 @@ RenderSetupInfoGLES::RenderSetupInfoGLES(Scene *inScene) :
 
 int OpenGLMemManager::maxCachedBuffers = WhirlyKitOpenGLMemCacheMax;
 int OpenGLMemManager::maxCachedTextures = WhirlyKitOpenGLMemCacheMax;
+size_t OpenGLMemManager::maxTexPoolBytes = WhirlyKitOpenGLTexPoolMax;
 
 OpenGLMemManager::OpenGLMemManager() :
     buffIDs(WhirlyKitOpenGLMemCacheMax),
@@ -64,7 +65,7 @@ OpenGLMemManager::~OpenGLMemManager()
         assert(!"OpenGL Memory Manager destroyed with outstanding buffer allocations");
     }
 
-    if (!texIDs.empty())
+    if (!texIDs.empty() || !sizedTexIDs.empty())
     {
         wkLogLevel(Error,"OpenGL Memory Manager destroyed with outstanding texture allocations");
         assert(!"OpenGL Memory Manager destroyed with outstanding texture allocations");
@@ -208,6 +209,106 @@ void OpenGLMemManager::removeTexID(GLuint texID)
     }
 }
 
+bool OpenGLMemManager::TexStorageKey::operator < (const TexStorageKey &that) const
+{
+    if (width != that.width)
+        return width < that.width;
+    if (height != that.height)
+        return height < that.height;
+    if (internalFormat != that.internalFormat)
+        return internalFormat < that.internalFormat;
+    if (format != that.format)
+        return format < that.format;
+    if (type != that.type)
+        return type < that.type;
+    return mipmaps < that.mipmaps;
+}
+
+GLuint OpenGLMemManager::getSizedTexID(const TexStorageKey &key)
+{
+    std::lock_guard<std::mutex> guardLock(idLock);
+
+    const auto it = sizedTexIDs.find(key);
+    if (it == sizedTexIDs.end() || it->second.empty())
+    {
+        return 0;
+    }
+
+    // Most recently returned is most likely to still be resident
+    const auto entry = it->second.back();
+    it->second.pop_back();
+    if (it->second.empty())
+    {
+        sizedTexIDs.erase(it);
+    }
+    sizedTexBytes -= entry.second;
+
+    return entry.first;
+}
+
+void OpenGLMemManager::removeSizedTexID(const TexStorageKey &key,GLuint texID,size_t bytes)
+{
+    if (texID == 0)
+    {
+        return;
+    }
+
+    std::vector<GLuint> toDelete;
+    {
+        std::lock_guard<std::mutex> guardLock(idLock);
+
+        if (shutdown || bytes > maxTexPoolBytes)
+        {
+            toDelete.push_back(texID);
+        }
+        else
+        {
+            sizedTexIDs[key].emplace_back(texID,bytes);
+            sizedTexBytes += bytes;
+
+            // Over the limit, so toss the oldest from the biggest group
+            while (sizedTexBytes > maxTexPoolBytes && !sizedTexIDs.empty())
+            {
+                auto biggest = sizedTexIDs.begin();
+                for (auto it = sizedTexIDs.begin(); it != sizedTexIDs.end(); ++it)
+                {
+                    if (it->second.size() > biggest->second.size())
+                        biggest = it;
+                }
+                const auto entry = biggest->second.front();
+                biggest->second.erase(biggest->second.begin());
+                if (biggest->second.empty())
+                {
+                    sizedTexIDs.erase(biggest);
+                }
+                sizedTexBytes -= entry.second;
+                toDelete.push_back(entry.first);
+            }
+        }
+    }
+
+    if (!toDelete.empty())
+    {
+        glDeleteTextures((GLsizei)toDelete.size(), &toDelete[0]);
+    }
+}
+
+void OpenGLMemManager::clearSizedTexIDs()
+{
+    std::vector<GLuint> toRemove;
+    for (const auto &group : sizedTexIDs)
+    {
+        for (const auto &entry : group.second)
+            toRemove.push_back(entry.first);
+    }
+    if (!toRemove.empty())
+    {
+        glDeleteTextures((GLsizei)toRemove.size(), &toRemove[0]);
+    }
+    sizedTexIDs.clear();
+    sizedTexBytes = 0;
+}
+
 // Clear out any and all texture IDs that we have sitting around
 void OpenGLMemManager::clearTextureIDs()
 {
@@ -219,12 +320,16 @@ void OpenGLMemManager::clearTextureIDs()
         glDeleteTextures((GLsizei)toRemove.size(), &toRemove[0]);
         texIDs.clear();
     }
+
+    clearSizedTexIDs();
 }
 
 void OpenGLMemManager::dumpStats()
 {
     wkLogLevel(Verbose,"MemCache: %ld buffers",(long int)buffIDs.size());
     wkLogLevel(Verbose,"MemCache: %ld textures",(long int)texIDs.size());
+    wkLogLevel(Verbose,"MemCache: %ld texture sizes pooled, %.1f MB",
+               (long int)sizedTexIDs.size(),sizedTexBytes / (1024.0*1024.0));
 }
 
 void OpenGLMemManager::teardown()
@@ -244,4 +349,9 @@ void OpenGLMemManager::setTextureReuse(int maxTextures)
     maxCachedTextures = maxTextures;
 }
 
+void OpenGLMemManager::setTexturePoolSize(size_t maxBytes)
+{
+    maxTexPoolBytes = maxBytes;
+}
+
 }
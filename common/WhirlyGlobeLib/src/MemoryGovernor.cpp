@@ -0,0 +1,93 @@
+/*  MemoryGovernor.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import "MemoryGovernor.h"
+#import "DecodeBufferPool.h"
+#import "TileMemoryManager.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+constexpr double MemoryGovernor::TileFraction;
+constexpr TimeInterval MemoryGovernor::TileHoldTime;
+
+void MemoryGovernor::addConsumer(const MemoryConsumerRef &consumer)
+{
+    if (!consumer)
+        return;
+
+    std::lock_guard<std::mutex> guardLock(lock);
+    consumers.push_back(consumer);
+}
+
+std::vector<MemoryConsumerRef> MemoryGovernor::liveConsumers()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    std::vector<MemoryConsumerRef> live;
+    live.reserve(consumers.size());
+    for (const auto &weakConsumer : consumers)
+        if (auto consumer = weakConsumer.lock())
+            live.push_back(std::move(consumer));
+    consumers.erase(std::remove_if(consumers.begin(),consumers.end(),
+                                   [](const std::weak_ptr<MemoryConsumer> &c) { return c.expired(); }),
+                    consumers.end());
+
+    return live;
+}
+
+MemoryUsage MemoryGovernor::getUsage()
+{
+    MemoryUsage usage;
+    usage.bytes[MemCaches] += DecodeBufferPool::getShared().getBytesHeld();
+
+    for (const auto &consumer : liveConsumers())
+        consumer->addMemoryUsage(usage);
+
+    return usage;
+}
+
+void MemoryGovernor::trim(PlatformThreadInfo *inst,MemoryTrimLevel level,ChangeSet &changes)
+{
+    const auto theConsumers = liveConsumers();
+    const size_t before = getUsage().total();
+
+    for (int step = MemTrimDecodeCaches; step <= level; step++)
+    {
+        switch (step)
+        {
+            case MemTrimDecodeCaches:
+                DecodeBufferPool::getShared().clear();
+                break;
+            case MemTrimOffscreenTiles:
+                TileMemoryManager::getShared().relievePressure(TileFraction,TileHoldTime);
+                break;
+            default:
+                break;
+        }
+
+        for (const auto &consumer : theConsumers)
+            consumer->trimMemory(inst,(MemoryTrimLevel)step,changes);
+    }
+
+    wkLogLevel(Info,"MemoryGovernor: Trimmed to level %d, %zu bytes before, %zu after",
+               (int)level,before,getUsage().total());
+}
+
+}
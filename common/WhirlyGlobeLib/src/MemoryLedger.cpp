@@ -0,0 +1,98 @@
+/*  MemoryLedger.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import "MemoryLedger.h"
+
+namespace WhirlyKit
+{
+
+// Take a record back out of a total, dropping the entry once it's empty
+static void SubtractEntry(MemoryLedger::EntryMap &entries,const std::string &key,size_t cpuBytes,size_t gpuBytes)
+{
+    const auto it = entries.find(key);
+    if (it == entries.end())
+        return;
+    auto &entry = it->second;
+    entry.count--;
+    entry.cpuBytes -= std::min(cpuBytes,entry.cpuBytes);
+    entry.gpuBytes -= std::min(gpuBytes,entry.gpuBytes);
+    if (entry.count <= 0)
+        entries.erase(it);
+}
+
+static void AddEntry(MemoryLedger::Entry &entry,size_t cpuBytes,size_t gpuBytes)
+{
+    entry.count++;
+    entry.cpuBytes += cpuBytes;
+    entry.gpuBytes += gpuBytes;
+}
+
+void MemoryLedger::add(SimpleIdentity id,const std::string &owner,const char *type,size_t cpuBytes,size_t gpuBytes)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    removeLocked(id);
+
+    Record record { owner.empty() ? std::string("unnamed") : owner, type, cpuBytes, gpuBytes };
+    AddEntry(byOwner[record.owner],cpuBytes,gpuBytes);
+    AddEntry(byType[type],cpuBytes,gpuBytes);
+    AddEntry(total,cpuBytes,gpuBytes);
+    records.emplace(id,std::move(record));
+}
+
+void MemoryLedger::remove(SimpleIdentity id)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    removeLocked(id);
+}
+
+void MemoryLedger::removeLocked(SimpleIdentity id)
+{
+    const auto it = records.find(id);
+    if (it == records.end())
+        return;
+
+    const Record &record = it->second;
+    SubtractEntry(byOwner,record.owner,record.cpuBytes,record.gpuBytes);
+    SubtractEntry(byType,record.type,record.cpuBytes,record.gpuBytes);
+    total.count--;
+    total.cpuBytes -= std::min(record.cpuBytes,total.cpuBytes);
+    total.gpuBytes -= std::min(record.gpuBytes,total.gpuBytes);
+    records.erase(it);
+}
+
+MemoryLedger::EntryMap MemoryLedger::getByOwner() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return byOwner;
+}
+
+MemoryLedger::EntryMap MemoryLedger::getByType() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return byType;
+}
+
+MemoryLedger::Entry MemoryLedger::getTotal() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return total;
+}
+
+}
@@ -33,6 +33,23 @@ Moon::Moon(int year, int month, int day, int hour, int minutes, int second) :
     this->calculateValues(aaDate);
 }
 
+Moon::Moon() :
+    moonLon(0.0),
+    moonLat(0.0),
+    illuminatedFraction(0.0),
+    phase(0.0)
+{
+}
+
+Moon::Moon(double jd) :
+    moonLon(0.0),
+    moonLat(0.0),
+    illuminatedFraction(0.0),
+    phase(0.0)
+{
+    this->calculateValues(CAADate(jd, true));
+}
+
 Moon::~Moon()
 {
 }
@@ -68,4 +85,38 @@ void Moon::calculateValues(CAADate aaDate)
     this->phase = (positionAngle < 180 ? phaseAngle + 180 : 180 - phaseAngle);
 }
 
+MoonCache::MoonCache(double stepMinutes) :
+    step(stepMinutes / (24.0 * 60.0)),
+    valid(false),
+    stepNum(0.0),
+    moon0(),
+    moon1()
+{
+}
+
+Moon MoonCache::getMoon(double jd)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    const double newStep = floor(jd / step);
+    if (!valid || newStep != stepNum)
+    {
+        moon0 = (valid && newStep == stepNum + 1.0) ? moon1 : Moon(newStep * step);
+        moon1 = Moon((newStep + 1.0) * step);
+        // Longitude and phase wrap around, so unwrap the far end to interpolate
+        moon1.moonLon = moon0.moonLon + remainder(moon1.moonLon - moon0.moonLon, 2.0 * M_PI);
+        moon1.phase = moon0.phase + remainder(moon1.phase - moon0.phase, 360.0);
+        stepNum = newStep;
+        valid = true;
+    }
+
+    const double t = jd / step - stepNum;
+    Moon moon(moon0);
+    moon.moonLon += t * (moon1.moonLon - moon0.moonLon);
+    moon.moonLat += t * (moon1.moonLat - moon0.moonLat);
+    moon.illuminatedFraction += t * (moon1.illuminatedFraction - moon0.illuminatedFraction);
+    moon.phase = fmod(moon.phase + t * (moon1.phase - moon0.phase) + 360.0, 360.0);
+    return moon;
+}
+
 }
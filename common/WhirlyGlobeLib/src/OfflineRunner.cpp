@@ -0,0 +1,180 @@
+/*  OfflineRunner.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <thread>
+#import <chrono>
+#import "OfflineRunner.h"
+#import "Scene.h"
+#import "SceneRenderer.h"
+#import "PerformanceTimer.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+// How long to let the layer threads run between checks while we're settling
+static constexpr int SettlePollMS = 5;
+
+static const char *MemoryCategoryName(int which)
+{
+    switch (which)
+    {
+        case MemTextures: return "textures";
+        case MemVertexBuffers: return "vertexBuffers";
+        case MemAtlases: return "atlases";
+        case MemCaches: return "caches";
+        case MemParsedTiles: return "parsedTiles";
+        default: return "unknown";
+    }
+}
+
+OfflineRunner::OfflineRunner(Scene *scene,SceneRenderer *renderer,DrawFunc drawFunc) :
+    scene(scene),
+    renderer(renderer),
+    drawFunc(std::move(drawFunc))
+{
+}
+
+void OfflineRunner::addBusyCheck(BusyFunc busyFunc)
+{
+    if (busyFunc)
+        busyFuncs.push_back(std::move(busyFunc));
+}
+
+bool OfflineRunner::isBusy() const
+{
+    // Not the renderer's version, continuous render requests would keep that going forever
+    if (scene && scene->hasChanges(scene->getCurrentTime()))
+        return true;
+
+    for (const auto &busyFunc : busyFuncs)
+        if (busyFunc())
+            return true;
+
+    return false;
+}
+
+bool OfflineRunner::settle(const Params &params,Result &result)
+{
+    WKTraceScope("Offline Settle");
+
+    const TimeInterval startTime = TimeGetCurrent();
+    const int checksNeeded = std::max(params.settleChecks,1);
+    int idleChecks = 0;
+    result.settled = false;
+    result.settleFrames = 0;
+
+    while (TimeGetCurrent() - startTime < params.settleTimeout)
+    {
+        // Drawing is what merges the changes the loaders hand over, which can kick off more loading
+        renderer->forceDrawNextFrame();
+        drawFunc();
+        result.settleFrames++;
+
+        if (isBusy())
+        {
+            idleChecks = 0;
+        }
+        else if (++idleChecks >= checksNeeded)
+        {
+            result.settled = true;
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(SettlePollMS));
+    }
+    result.settleTime = TimeGetCurrent() - startTime;
+
+    if (!result.settled)
+        wkLogLevel(Warn,"OfflineRunner: Still loading after %.1fs, going ahead anyway",result.settleTime);
+
+    return result.settled;
+}
+
+OfflineRunner::Result OfflineRunner::run(const Params &params)
+{
+    Result result;
+    if (!scene || !renderer || !drawFunc)
+        return result;
+
+    settle(params,result);
+
+    for (int ii=0;ii<params.warmupFrames;ii++)
+    {
+        renderer->forceDrawNextFrame();
+        drawFunc();
+    }
+
+    // Only the timed frames go into the stats, and we put the recording back the way we found it
+    FrameStats &frameStats = renderer->getFrameStats();
+    const bool wasEnabled = frameStats.isEnabled();
+    frameStats.clear();
+    frameStats.setEnable(true);
+
+    result.frameTimes.reserve(std::max(params.frames,0));
+    for (int ii=0;ii<params.frames;ii++)
+    {
+        const TimeInterval frameStart = TimeGetCurrent();
+        renderer->forceDrawNextFrame();
+        drawFunc();
+        result.frameTimes.push_back(TimeGetCurrent() - frameStart);
+    }
+
+    result.summaries = frameStats.getSummaries();
+    frameStats.setEnable(wasEnabled);
+
+    result.memory = scene->getMemoryGovernor().getUsage();
+
+    return result;
+}
+
+std::string OfflineRunner::ToJSON(const Result &result)
+{
+    char buf[256];
+    std::string json;
+
+    snprintf(buf,sizeof(buf),"{\"settled\":%s,\"settleTime\":%.6f,\"settleFrames\":%d,\"frameTimes\":[",
+             result.settled ? "true" : "false",result.settleTime,result.settleFrames);
+    json += buf;
+    for (size_t ii=0;ii<result.frameTimes.size();ii++)
+    {
+        snprintf(buf,sizeof(buf),"%s%.6f",ii > 0 ? "," : "",result.frameTimes[ii]);
+        json += buf;
+    }
+
+    json += "],\"stats\":{";
+    for (size_t ii=0;ii<result.summaries.size();ii++)
+    {
+        const auto &summary = result.summaries[ii];
+        snprintf(buf,sizeof(buf),"%s\"%s\":{\"frames\":%d,\"min\":%g,\"max\":%g,\"mean\":%g,\"p50\":%g,\"p95\":%g,\"p99\":%g}",
+                 ii > 0 ? "," : "",FrameStats::getMetricName(summary.metric),summary.numFrames,
+                 summary.minVal,summary.maxVal,summary.mean,summary.p50,summary.p95,summary.p99);
+        json += buf;
+    }
+
+    json += "},\"memory\":{";
+    for (int ii=0;ii<MemNumCategories;ii++)
+    {
+        snprintf(buf,sizeof(buf),"%s\"%s\":%zu",ii > 0 ? "," : "",MemoryCategoryName(ii),result.memory.bytes[ii]);
+        json += buf;
+    }
+    json += "}}";
+
+    return json;
+}
+
+}
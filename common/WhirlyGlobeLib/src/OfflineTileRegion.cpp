@@ -0,0 +1,69 @@
+/*  OfflineTileRegion.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import <cmath>
+#import "OfflineTileRegion.h"
+
+namespace WhirlyKit
+{
+
+OfflineTileRegion::OfflineTileRegion(const MbrD &mbr,const MbrD &region,int minLevel,int maxLevel)
+: numTiles(0)
+{
+    const Point2d span = mbr.span();
+    if (span.x() <= 0.0 || span.y() <= 0.0 || !region.valid())
+        return;
+
+    for (int level = std::max(minLevel,0);level <= maxLevel;level++)
+    {
+        // Tile sizes the same way QuadTreeNew::generateMbrForNode does them
+        const int numChunks = 1 << level;
+        const double chunkX = span.x() / numChunks, chunkY = span.y() / numChunks;
+
+        LevelRange range;
+        range.level = level;
+        range.minX = std::max((int)std::floor((region.ll().x() - mbr.ll().x()) / chunkX),0);
+        range.minY = std::max((int)std::floor((region.ll().y() - mbr.ll().y()) / chunkY),0);
+        range.maxX = std::min((int)std::floor((region.ur().x() - mbr.ll().x()) / chunkX),numChunks-1);
+        range.maxY = std::min((int)std::floor((region.ur().y() - mbr.ll().y()) / chunkY),numChunks-1);
+        if (range.minX > range.maxX || range.minY > range.maxY)
+            continue;
+
+        range.start = numTiles;
+        numTiles += (int64_t)(range.maxX - range.minX + 1) * (range.maxY - range.minY + 1);
+        levels.push_back(range);
+    }
+}
+
+bool OfflineTileRegion::getTile(int64_t which,QuadTreeNew::Node &node) const
+{
+    if (which < 0 || which >= numTiles)
+        return false;
+
+    // Last level that starts at or before this one
+    auto it = std::upper_bound(levels.begin(),levels.end(),which,
+                               [](int64_t val,const LevelRange &range) { return val < range.start; });
+    const LevelRange &range = *(it - 1);
+
+    const int64_t offset = which - range.start;
+    const int numX = range.maxX - range.minX + 1;
+    node = QuadTreeNew::Node(range.minX + (int)(offset % numX),range.minY + (int)(offset / numX),range.level);
+    return true;
+}
+
+}
@@ -28,51 +28,80 @@ using namespace WhirlyKit;
 namespace WhirlyKit
 {
 
-OverlapHelper::OverlapHelper(const Mbr &mbr, int sizeX, int sizeY, size_t count) :
+// Aim for about this many objects per cell when there are lots of them
+static const size_t OverlapObjsPerCell = 4;
+// But don't go past this many cells in either direction
+static const int OverlapMaxCells = 256;
+
+OverlapHelper::OverlapHelper(const Mbr &mbr, int inSizeX, int inSizeY, size_t count) :
     mbr(mbr),
-    sizeX(sizeX),
-    sizeY(sizeY),
-    totalObjs(count),
-    cellSize(mbr.span().cwiseQuotient(Point2f(sizeX, sizeY)))
+    sizeX(std::max(inSizeX, 1)),
+    sizeY(std::max(inSizeY, 1)),
+    totalObjs(count)
 {
-    grid.resize(sizeX * sizeY);
-
-    if (count > 0)
+    // Keep the shape of the grid we were given, but go finer for big collections
+    const double cellsWanted = (double)count / OverlapObjsPerCell;
+    if (cellsWanted > (double)sizeX * sizeY)
     {
-        objects.reserve(count);
+        const double scale = std::sqrt(cellsWanted / ((double)sizeX * sizeY));
+        sizeX = std::min(OverlapMaxCells, (int)std::ceil(sizeX * scale));
+        sizeY = std::min(OverlapMaxCells, (int)std::ceil(sizeY * scale));
     }
+    cellSize = mbr.span().cwiseQuotient(Point2f(sizeX, sizeY));
+
+    grid.resize(sizeX * sizeY);
 }
 
-bool OverlapHelper::addCheckObject(const Point2dVector &pts, const std::string &mergeID)
+bool OverlapHelper::addCheckObject(const Point2dVector &pts, const char* mergeID)
 {
-    return addCheckObject(pts, mergeID.empty() ? nullptr : mergeID.c_str());
+    return addCheckObject(pts, (mergeID && *mergeID) ? std::string(mergeID) : std::string());
 }
-bool OverlapHelper::checkObject(const Point2dVector &pts, const std::string &mergeID)
+
+bool OverlapHelper::checkObject(const Point2dVector &pts, const char* mergeID)
 {
-    return checkObject(pts, mergeID.empty() ? nullptr : mergeID.c_str());
+    return checkObject(pts, (mergeID && *mergeID) ? std::string(mergeID) : std::string());
 }
 
 // Try to add an object.  Might fail (kind of the whole point).
-bool OverlapHelper::addCheckObject(const Point2dVector &pts, const char* mergeID)
+bool OverlapHelper::addCheckObject(const Point2dVector &pts, const std::string &mergeID)
 {
-    const Mbr objMbr(pts);
-
-    int sx,sy,ex,ey;
-    calcCells(objMbr, sx,sy,ex,ey);
+    return addCheckObject(Mbr(pts), mergeID);
+}
 
-    if (!checkObject(pts, objMbr, sx,sy,ex,ey, mergeID))
+bool OverlapHelper::addCheckObject(const Mbr &objMbr, const std::string &mergeID)
+{
+    if (!checkObject(objMbr, findMergeID(mergeID)))
     {
         return false;
     }
 
     // Okay, so it doesn't overlap.  Let's add it where needed.
-    addObject(pts, mergeID ? mergeID : std::string(),
-              sx, sy, ex, ey);
+    addObject(objMbr, addMergeID(mergeID));
 
     return true;
 }
 
-void OverlapHelper::calcCells(const Mbr &objMbr, int &sx, int &sy, int &ex, int &ey)
+bool OverlapHelper::checkObject(const Point2dVector &pts, const std::string &mergeID)
+{
+    return checkObject(Mbr(pts), findMergeID(mergeID));
+}
+
+bool OverlapHelper::checkObject(const Mbr &objMbr, const std::string &mergeID) const
+{
+    return checkObject(objMbr, findMergeID(mergeID));
+}
+
+void OverlapHelper::addObject(Point2dVector pts, std::string mergeID)
+{
+    addObject(Mbr(pts), addMergeID(mergeID));
+}
+
+void OverlapHelper::addObject(const Mbr &objMbr, const std::string &mergeID)
+{
+    addObject(objMbr, addMergeID(mergeID));
+}
+
+void OverlapHelper::calcCells(const Mbr &objMbr, int &sx, int &sy, int &ex, int &ey) const
 {
     sx = std::max(0, (int) floor((objMbr.ll().x() - mbr.ll().x()) / cellSize.x()));
     sy = std::max(0, (int) floor((objMbr.ll().y() - mbr.ll().y()) / cellSize.y()));
@@ -80,70 +109,68 @@ void OverlapHelper::calcCells(const Mbr &objMbr, int &sx, int &sy, int &ex, int
     ey = std::min(sizeY - 1, (int) ceil((objMbr.ur().y() - mbr.ll().y()) / cellSize.y()));
 }
 
-static inline bool eq(const char* ida, const std::string &idb)
+int OverlapHelper::findMergeID(const std::string &mergeID) const
 {
-    // Don't create a temporary string object for for `ida`
-    return ida && ida == idb;
+    if (mergeID.empty())
+    {
+        return -1;
+    }
+    // Not there means nothing we have can match it, which is the same as none
+    const auto it = mergeIDs.find(mergeID);
+    return (it == mergeIDs.end()) ? -1 : it->second;
 }
 
-bool OverlapHelper::checkObject(const Point2dVector &pts, const Mbr &objMbr,
-                                int sx, int sy, int ex, int ey, const char* mergeID)
+int OverlapHelper::addMergeID(const std::string &mergeID)
 {
-    const auto sizeGuess = (int)std::ceil((ex - sx + 1) * (ey - sy + 1) / overlapHeuristic);
-    std::unordered_set<int> indexes(std::max(1, sizeGuess));
-
-    // Gather all the matching indexes, ignoring duplicates
-    for (int ix=sx;ix<=ex;ix++)
+    if (mergeID.empty())
     {
-        for (int iy=sy;iy<=ey;iy++)
-        {
-            const auto &cellIndexes = cellAt(ix, iy).objIndexes;
-            indexes.insert(cellIndexes.begin(), cellIndexes.end());
-        }
+        return -1;
     }
-    // Check each unique object index, unless it shares the same ID
-    return !std::any_of(indexes.begin(), indexes.end(), [&](int ii) {
-            return !eq(mergeID, objects[ii].mergeID) &&
-                    ConvexPolyIntersect(objects[ii].pts,pts);
-        });
+    return mergeIDs.insert(std::make_pair(mergeID, (int)mergeIDs.size())).first->second;
 }
 
-bool OverlapHelper::checkObject(const Point2dVector &pts, const char* mergeID)
+bool OverlapHelper::checkObject(const Mbr &objMbr, int mergeID) const
 {
-    const Mbr objMbr(pts);
     int sx,sy,ex,ey;
     calcCells(objMbr, sx,sy,ex,ey);
-    return checkObject(pts, objMbr, sx,sy,ex,ey, mergeID);
+
+    // An object in more than one cell gets checked more than once, but that's cheaper than
+    // keeping track.  Objects with the same merge ID don't count.
+    for (int iy=sy;iy<=ey;iy++)
+    {
+        for (int ix=sx;ix<=ex;ix++)
+        {
+            for (const auto &entry : cellAt(ix, iy).entries)
+            {
+                if ((mergeID < 0 || entry.mergeID != mergeID) && entry.mbr.overlaps(objMbr))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
 }
 
-void OverlapHelper::addObject(Point2dVector pts, std::string mergeID)
+void OverlapHelper::addObject(const Mbr &objMbr, int mergeID)
 {
-    const Mbr objMbr(pts);
-
     int sx,sy,ex,ey;
     calcCells(objMbr, sx,sy,ex,ey);
 
-    // Okay, so it doesn't overlap.  Let's add it where needed.
-    addObject(std::move(pts), std::move(mergeID), sx, sy, ex, ey);
-}
+    numObjects++;
+    // Objects usually touch more than one cell, so this tends to be enough
+    const auto sizeEstimate = std::max(totalObjs / grid.size(), OverlapObjsPerCell);
 
-void OverlapHelper::addObject(Point2dVector pts, std::string mergeID,
-                              int sx, int sy, int ex, int ey)
-{
-    objects.emplace_back(std::move(pts), std::move(mergeID));
-    const auto newId = (int)(objects.size() - 1);
-    const auto sizeEstimate = std::max((int)std::ceil(totalObjs * overlapHeuristic),5);
-
-    for (int ix=sx;ix<=ex;ix++)
+    for (int iy=sy;iy<=ey;iy++)
     {
-        for (int iy=sy;iy<=ey;iy++)
+        for (int ix=sx;ix<=ex;ix++)
         {
             auto &cell = cellAt(ix, iy);
-            if (cell.objIndexes.empty())
+            if (cell.entries.empty())
             {
-                cell.objIndexes.reserve(sizeEstimate);
+                cell.entries.reserve(sizeEstimate);
             }
-            cell.objIndexes.push_back(newId);
+            cell.entries.push_back(CellEntry { objMbr, mergeID });
         }
     }
 }
@@ -0,0 +1,365 @@
+/*  PMTilesArchive.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import <cstring>
+#import "PMTilesArchive.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    const char Magic[7] = { 'P', 'M', 'T', 'i', 'l', 'e', 's' };
+    const int Version = 3;
+    const size_t HeaderSize = 127;
+    // Directories don't nest deeper than this in anything sensible
+    const int MaxDepth = 4;
+    // No directory should have more entries than this
+    const uint64_t MaxEntries = 10*1000*1000;
+
+    template <typename T> T getValue(const unsigned char *ptr)
+    {
+        T val;
+        memcpy(&val,ptr,sizeof(T));
+        return val;
+    }
+
+    // Lat/lon are stored as 10^7 fixed point
+    double getDegrees(const unsigned char *ptr)
+    {
+        return getValue<int32_t>(ptr) / 10000000.0;
+    }
+
+    bool readVarint(const unsigned char *&ptr,const unsigned char *end,uint64_t &val)
+    {
+        val = 0;
+        for (int shift = 0; shift < 64 && ptr < end; shift += 7)
+        {
+            const unsigned char byte = *ptr++;
+            val |= (uint64_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+}
+
+PMTilesArchive::PMTilesArchive() :
+    valid(false), maxLeaves(64)
+{
+}
+
+bool PMTilesArchive::parseStart(const void *inData,size_t len)
+{
+    const auto *data = (const unsigned char *)inData;
+    if (len < HeaderSize || memcmp(data,Magic,sizeof(Magic)) != 0 || data[7] != Version)
+    {
+        wkLogLevel(Warn,"PMTilesArchive: Not a version %d PMTiles archive",Version);
+        return false;
+    }
+
+    Header newHeader;
+    newHeader.rootOffset = getValue<uint64_t>(data + 8);
+    newHeader.rootLength = getValue<uint64_t>(data + 16);
+    newHeader.metadataOffset = getValue<uint64_t>(data + 24);
+    newHeader.metadataLength = getValue<uint64_t>(data + 32);
+    newHeader.leafOffset = getValue<uint64_t>(data + 40);
+    newHeader.leafLength = getValue<uint64_t>(data + 48);
+    newHeader.tileDataOffset = getValue<uint64_t>(data + 56);
+    newHeader.tileDataLength = getValue<uint64_t>(data + 64);
+    newHeader.numAddressedTiles = getValue<uint64_t>(data + 72);
+    newHeader.numTileEntries = getValue<uint64_t>(data + 80);
+    newHeader.numTileContents = getValue<uint64_t>(data + 88);
+    newHeader.clustered = data[96] == 1;
+    newHeader.internalCompression = data[97];
+    newHeader.tileCompression = data[98];
+    newHeader.tileType = data[99];
+    newHeader.minZoom = data[100];
+    newHeader.maxZoom = data[101];
+    newHeader.minLon = getDegrees(data + 102);
+    newHeader.minLat = getDegrees(data + 106);
+    newHeader.maxLon = getDegrees(data + 110);
+    newHeader.maxLat = getDegrees(data + 114);
+    newHeader.centerZoom = data[118];
+    newHeader.centerLon = getDegrees(data + 119);
+    newHeader.centerLat = getDegrees(data + 123);
+
+    if (newHeader.rootOffset + newHeader.rootLength > len)
+    {
+        wkLogLevel(Warn,"PMTilesArchive: Root directory isn't in the data we were given");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    header = newHeader;
+    if (!parseDirectory(data + header.rootOffset,header.rootLength,root))
+    {
+        wkLogLevel(Warn,"PMTilesArchive: Bad root directory");
+        return false;
+    }
+    leaves.clear();
+    leafOrder.clear();
+    valid = true;
+
+    return true;
+}
+
+bool PMTilesArchive::isValid()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return valid;
+}
+
+PMTilesArchive::Header PMTilesArchive::getHeader()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return header;
+}
+
+uint64_t PMTilesArchive::tileIDForTile(int x,int y,int level)
+{
+    // Tiles for all the levels above come first
+    uint64_t tileID = 0;
+    for (int ii=0;ii<level;ii++)
+        tileID += (uint64_t)1 << (2*ii);
+
+    // Then the position along the Hilbert curve for this level
+    const uint64_t n = (uint64_t)1 << level;
+    uint64_t tx = x, ty = y;
+    for (uint64_t s = n / 2; s > 0; s /= 2)
+    {
+        const uint64_t rx = (tx & s) ? 1 : 0;
+        const uint64_t ry = (ty & s) ? 1 : 0;
+        tileID += s * s * ((3 * rx) ^ ry);
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                tx = n - 1 - tx;
+                ty = n - 1 - ty;
+            }
+            std::swap(tx,ty);
+        }
+    }
+
+    return tileID;
+}
+
+bool PMTilesArchive::decompress(int compression,const void *data,size_t len,std::vector<unsigned char> &out)
+{
+    switch (compression)
+    {
+        case CompressUnknown:
+        case CompressNone:
+            out.assign((const unsigned char *)data,(const unsigned char *)data + len);
+            return true;
+        case CompressGzip:
+            return RawDataInflate(data,len,out);
+        default:
+            wkLogLevel(Warn,"PMTilesArchive: Compression type %d isn't supported",compression);
+            return false;
+    }
+}
+
+bool PMTilesArchive::parseDirectory(const void *data,size_t len,Directory &dir)
+{
+    std::vector<unsigned char> raw;
+    if (!decompress(header.internalCompression,data,len,raw))
+        return false;
+
+    const unsigned char *ptr = raw.data(), *end = raw.data() + raw.size();
+    uint64_t numEntries = 0;
+    if (!readVarint(ptr,end,numEntries) || numEntries > MaxEntries)
+        return false;
+
+    // Each field is stored for all the entries at once, which compresses better
+    dir.resize(numEntries);
+    uint64_t val = 0, lastID = 0;
+    for (auto &entry : dir)
+    {
+        if (!readVarint(ptr,end,val))
+            return false;
+        lastID += val;
+        entry.tileID = lastID;
+    }
+    for (auto &entry : dir)
+    {
+        if (!readVarint(ptr,end,val))
+            return false;
+        entry.runLength = (uint32_t)val;
+    }
+    for (auto &entry : dir)
+    {
+        if (!readVarint(ptr,end,val))
+            return false;
+        entry.length = (uint32_t)val;
+    }
+    for (size_t ii=0;ii<dir.size();ii++)
+    {
+        if (!readVarint(ptr,end,val))
+            return false;
+        // Zero means right after the one before
+        dir[ii].offset = (val == 0 && ii > 0) ? dir[ii-1].offset + dir[ii-1].length : val - 1;
+    }
+
+    return true;
+}
+
+const PMTilesArchive::Entry *PMTilesArchive::findEntry(const Directory &dir,uint64_t tileID)
+{
+    // First entry after the tile, then back up one
+    auto it = std::upper_bound(dir.begin(),dir.end(),tileID,
+                               [](uint64_t id,const Entry &entry) { return id < entry.tileID; });
+    if (it == dir.begin())
+        return nullptr;
+    --it;
+
+    // Leaf directories cover everything up to the next entry
+    if (it->runLength == 0 || tileID - it->tileID < it->runLength)
+        return &(*it);
+    return nullptr;
+}
+
+PMTilesArchive::DirectoryRef PMTilesArchive::findLeaf(uint64_t offset)
+{
+    const auto it = leaves.find(offset);
+    if (it == leaves.end())
+        return DirectoryRef();
+    leafOrder.splice(leafOrder.begin(),leafOrder,it->second.second);
+    return it->second.first;
+}
+
+PMTilesArchive::LookupResult PMTilesArchive::lookup(uint64_t tileID,Range &range)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (!valid)
+        return TileMissing;
+
+    DirectoryRef leaf;
+    const Directory *dir = &root;
+    for (int depth = 0; depth < MaxDepth; depth++)
+    {
+        const Entry *entry = findEntry(*dir,tileID);
+        if (!entry)
+            return TileMissing;
+
+        if (entry->runLength > 0)
+        {
+            range.offset = header.tileDataOffset + entry->offset;
+            range.length = entry->length;
+            return TileFound;
+        }
+
+        const uint64_t leafOffset = header.leafOffset + entry->offset;
+        leaf = findLeaf(leafOffset);
+        if (!leaf)
+        {
+            range.offset = leafOffset;
+            range.length = entry->length;
+            return NeedDirectory;
+        }
+        dir = leaf.get();
+    }
+
+    return TileMissing;
+}
+
+bool PMTilesArchive::addDirectory(const Range &range,const void *data,size_t len)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (!valid || len < range.length)
+        return false;
+    if (findLeaf(range.offset))
+        return true;
+
+    const auto dir = std::make_shared<Directory>();
+    if (!parseDirectory(data,range.length,*dir))
+    {
+        wkLogLevel(Warn,"PMTilesArchive: Bad leaf directory at %llu",(unsigned long long)range.offset);
+        return false;
+    }
+
+    leafOrder.push_front(range.offset);
+    leaves[range.offset] = std::make_pair(dir,leafOrder.begin());
+    while ((int)leaves.size() > maxLeaves && !leafOrder.empty())
+    {
+        leaves.erase(leafOrder.back());
+        leafOrder.pop_back();
+    }
+
+    return true;
+}
+
+void PMTilesArchive::setMaxLeaves(int inMaxLeaves)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    maxLeaves = std::max(inMaxLeaves,1);
+}
+
+RawDataRef PMTilesArchive::decompressTile(const RawDataRef &data)
+{
+    int compression = CompressNone;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        compression = header.tileCompression;
+    }
+    if (!data || compression == CompressNone || compression == CompressUnknown)
+        return data;
+
+    const auto buf = std::make_shared<std::vector<unsigned char>>();
+    if (!decompress(compression,data->getRawData(),data->getLen(),*buf))
+        return RawDataRef();
+    return std::make_shared<RawDataWrapper>(buf->data(),buf->size(),[buf](const void *){ });
+}
+
+void PMTilesArchive::groupReads(const std::vector<Range> &ranges,uint64_t maxGap,uint64_t maxLength,std::vector<Read> &reads)
+{
+    reads.clear();
+
+    std::vector<int> order(ranges.size());
+    for (int ii=0;ii<(int)order.size();ii++)
+        order[ii] = ii;
+    std::sort(order.begin(),order.end(),[&ranges](int a,int b) { return ranges[a].offset < ranges[b].offset; });
+
+    for (int which : order)
+    {
+        const Range &range = ranges[which];
+        if (!reads.empty())
+        {
+            Read &read = reads.back();
+            const uint64_t readEnd = read.range.offset + read.range.length;
+            const uint64_t newEnd = std::max(readEnd,range.offset + range.length);
+            if (range.offset <= readEnd + maxGap && newEnd - read.range.offset <= maxLength)
+            {
+                read.range.length = newEnd - read.range.offset;
+                read.which.push_back(which);
+                continue;
+            }
+        }
+
+        Read read;
+        read.range = range;
+        read.which.push_back(which);
+        reads.push_back(read);
+    }
+}
+
+}
@@ -0,0 +1,330 @@
+/*  PNGDecoder.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <cstdint>
+#import <cstdlib>
+#import <cstring>
+#import <vector>
+#import <zlib.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#import <arm_neon.h>
+#endif
+#import "PNGDecoder.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    const unsigned char PNGSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    // Bigger than any tile we'd see, and keeps the sizes well inside 32 bits
+    const uint32_t MaxDimension = 16384;
+
+    enum { ColorGrey = 0, ColorRGB = 2, ColorGreyAlpha = 4, ColorRGBA = 6 };
+    enum { FilterNone = 0, FilterSub, FilterUp, FilterAvg, FilterPaeth };
+
+    uint32_t readBE32(const unsigned char *ptr)
+    {
+        return ((uint32_t)ptr[0] << 24) | ((uint32_t)ptr[1] << 16) | ((uint32_t)ptr[2] << 8) | ptr[3];
+    }
+
+    uint32_t load32(const unsigned char *ptr)
+    {
+        uint32_t val;
+        memcpy(&val,ptr,4);
+        return val;
+    }
+
+    void store32(unsigned char *ptr,uint32_t val)
+    {
+        memcpy(ptr,&val,4);
+    }
+
+    // Four bytes at once in a regular register, no carries between them
+    inline uint32_t addBytes(uint32_t a,uint32_t b)
+    {
+        return ((a & 0x7f7f7f7fU) + (b & 0x7f7f7f7fU)) ^ ((a ^ b) & 0x80808080U);
+    }
+
+    inline uint32_t avgBytes(uint32_t a,uint32_t b)
+    {
+        return (a & b) + (((a ^ b) & 0xfefefefeU) >> 1);
+    }
+
+    inline unsigned char paeth(int a,int b,int c)
+    {
+        const int pa = abs(b - c), pb = abs(a - c), pc = abs(a + b - 2 * c);
+        return (unsigned char)((pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c);
+    }
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    // Paeth is the common filter for photos and such, and the slowest.  This does a whole
+    //  RGBA pixel per step, which is the best we can do since each depends on the last.
+    void paethRow4(unsigned char *row,const unsigned char *prev,size_t rowBytes)
+    {
+        uint8x8_t a = vdup_n_u8(0), c = vdup_n_u8(0);
+        for (size_t ii=0;ii<rowBytes;ii+=4)
+        {
+            const uint8x8_t b = vreinterpret_u8_u32(vdup_n_u32(load32(prev + ii)));
+            uint8x8_t x = vreinterpret_u8_u32(vdup_n_u32(load32(row + ii)));
+
+            const uint16x8_t pa = vabdl_u8(b,c);
+            const uint16x8_t pb = vabdl_u8(a,c);
+            const uint16x8_t pc = vabdq_u16(vaddl_u8(a,b),vaddl_u8(c,c));
+            const uint8x8_t useA = vmovn_u16(vandq_u16(vcleq_u16(pa,pb),vcleq_u16(pa,pc)));
+            const uint8x8_t useB = vmovn_u16(vcleq_u16(pb,pc));
+            x = vadd_u8(x,vbsl_u8(useA,a,vbsl_u8(useB,b,c)));
+
+            store32(row + ii,vget_lane_u32(vreinterpret_u32_u8(x),0));
+            a = x;
+            c = b;
+        }
+    }
+#else
+    void paethRow4(unsigned char *row,const unsigned char *prev,size_t rowBytes)
+    {
+        for (size_t ii=0;ii<4;ii++)
+            row[ii] += prev[ii];
+        for (size_t ii=4;ii<rowBytes;ii++)
+            row[ii] += paeth(row[ii-4],prev[ii],prev[ii-4]);
+    }
+#endif
+
+    // Undo the filter on one row in place.  prev is all zeros for the first row.
+    bool unfilterRow(int filter,unsigned char *row,const unsigned char *prev,size_t rowBytes,size_t bpp)
+    {
+        switch (filter)
+        {
+            case FilterNone:
+                break;
+            case FilterSub:
+                if (bpp == 4)
+                {
+                    uint32_t a = 0;
+                    for (size_t ii=0;ii<rowBytes;ii+=4)
+                    {
+                        a = addBytes(load32(row + ii),a);
+                        store32(row + ii,a);
+                    }
+                }
+                else
+                {
+                    for (size_t ii=bpp;ii<rowBytes;ii++)
+                        row[ii] += row[ii-bpp];
+                }
+                break;
+            case FilterUp:
+                // The compiler vectorizes this one for us
+                for (size_t ii=0;ii<rowBytes;ii++)
+                    row[ii] += prev[ii];
+                break;
+            case FilterAvg:
+                if (bpp == 4)
+                {
+                    uint32_t a = 0;
+                    for (size_t ii=0;ii<rowBytes;ii+=4)
+                    {
+                        a = addBytes(load32(row + ii),avgBytes(a,load32(prev + ii)));
+                        store32(row + ii,a);
+                    }
+                }
+                else
+                {
+                    for (size_t ii=0;ii<bpp;ii++)
+                        row[ii] += prev[ii] >> 1;
+                    for (size_t ii=bpp;ii<rowBytes;ii++)
+                        row[ii] += (row[ii-bpp] + prev[ii]) >> 1;
+                }
+                break;
+            case FilterPaeth:
+                if (bpp == 4)
+                {
+                    paethRow4(row,prev,rowBytes);
+                }
+                else
+                {
+                    for (size_t ii=0;ii<bpp;ii++)
+                        row[ii] += prev[ii];
+                    for (size_t ii=bpp;ii<rowBytes;ii++)
+                        row[ii] += paeth(row[ii-bpp],prev[ii],prev[ii-bpp]);
+                }
+                break;
+            default:
+                return false;
+        }
+        return true;
+    }
+
+    // Copy an unfiltered row to the output.  With 16 bit samples we keep the high byte,
+    //  which is the first since PNG is big endian.
+    void convertRow(const unsigned char *row,unsigned char *out,uint32_t width,int colorType,int sampleBytes)
+    {
+        const int step = sampleBytes;
+        switch (colorType)
+        {
+            case ColorGrey:
+                if (step == 1)
+                    memcpy(out,row,width);
+                else
+                    for (uint32_t ii=0;ii<width;ii++)
+                        out[ii] = row[ii*2];
+                break;
+            case ColorGreyAlpha:
+                for (uint32_t ii=0;ii<width;ii++,row+=2*step,out+=4)
+                {
+                    out[0] = out[1] = out[2] = row[0];
+                    out[3] = row[step];
+                }
+                break;
+            case ColorRGB:
+                for (uint32_t ii=0;ii<width;ii++,row+=3*step,out+=4)
+                {
+                    out[0] = row[0];
+                    out[1] = row[step];
+                    out[2] = row[2*step];
+                    out[3] = 255;
+                }
+                break;
+            case ColorRGBA:
+                if (step == 1)
+                    memcpy(out,row,(size_t)width * 4);
+                else
+                    for (uint32_t ii=0;ii<width;ii++,row+=8,out+=4)
+                    {
+                        out[0] = row[0];
+                        out[1] = row[2];
+                        out[2] = row[4];
+                        out[3] = row[6];
+                    }
+                break;
+        }
+    }
+}
+
+unsigned char *DecodePNGFast(const unsigned char *data,size_t length,
+                             unsigned int &outWidth,unsigned int &outHeight,int &byteWidth)
+{
+    if (!data || length < 8 + 25 || memcmp(data,PNGSignature,8) != 0)
+        return NULL;
+
+    // IHDR has to come first
+    const unsigned char *ihdr = data + 8;
+    if (readBE32(ihdr) != 13 || memcmp(ihdr + 4,"IHDR",4) != 0)
+        return NULL;
+    const uint32_t width = readBE32(ihdr + 8);
+    const uint32_t height = readBE32(ihdr + 12);
+    const int bitDepth = ihdr[16], colorType = ihdr[17], interlace = ihdr[20];
+    if (width == 0 || height == 0 || width > MaxDimension || height > MaxDimension ||
+        (bitDepth != 8 && bitDepth != 16) || interlace != 0 || ihdr[18] != 0 || ihdr[19] != 0)
+        return NULL;
+
+    int channels = 0;
+    switch (colorType)
+    {
+        case ColorGrey: channels = 1; break;
+        case ColorGreyAlpha: channels = 2; break;
+        case ColorRGB: channels = 3; break;
+        case ColorRGBA: channels = 4; break;
+        default:
+            // Palettes we leave to the general decoder
+            return NULL;
+    }
+    const int sampleBytes = bitDepth / 8;
+    const size_t bpp = (size_t)channels * sampleBytes;
+    const size_t rowBytes = bpp * width;
+    const int outBytes = (colorType == ColorGrey) ? 1 : 4;
+
+    // Find the image data, which may be split over several chunks
+    std::vector<std::pair<const unsigned char *,uint32_t>> idats;
+    const unsigned char *ptr = ihdr + 25;
+    const unsigned char *end = data + length;
+    while (end - ptr >= 12)
+    {
+        const uint32_t chunkLen = readBE32(ptr);
+        if (chunkLen > (size_t)(end - ptr) - 12)
+            return NULL;
+        const unsigned char *type = ptr + 4;
+        if (memcmp(type,"IDAT",4) == 0)
+            idats.emplace_back(ptr + 8,chunkLen);
+        else if (memcmp(type,"IEND",4) == 0)
+            break;
+        else if (memcmp(type,"tRNS",4) == 0)
+            // A transparent color key would need to go into the alpha
+            return NULL;
+        ptr += 12 + chunkLen;
+    }
+    if (idats.empty())
+        return NULL;
+
+    z_stream stream;
+    memset(&stream,0,sizeof(stream));
+    if (inflateInit(&stream) != Z_OK)
+        return NULL;
+
+    unsigned char *outData = (unsigned char *)malloc((size_t)width * height * outBytes);
+    // Filter byte plus the row, for this row and the last one
+    std::vector<unsigned char> rows(2 * (rowBytes + 1),0);
+    unsigned char *curRow = &rows[0], *prevRow = &rows[rowBytes + 1];
+
+    bool ok = (outData != NULL);
+    size_t whichIdat = 0;
+    for (uint32_t iy=0;ok && iy<height;iy++)
+    {
+        stream.next_out = curRow;
+        stream.avail_out = (uInt)(rowBytes + 1);
+        while (ok && stream.avail_out > 0)
+        {
+            if (stream.avail_in == 0)
+            {
+                if (whichIdat >= idats.size())
+                {
+                    ok = false;
+                    break;
+                }
+                stream.next_in = (Bytef *)idats[whichIdat].first;
+                stream.avail_in = idats[whichIdat].second;
+                whichIdat++;
+            }
+            const int ret = inflate(&stream,Z_NO_FLUSH);
+            if (ret == Z_STREAM_END)
+                ok = (stream.avail_out == 0 && iy == height - 1);
+            else if (ret != Z_OK && ret != Z_BUF_ERROR)
+                ok = false;
+        }
+        if (!ok)
+            break;
+
+        ok = unfilterRow(curRow[0],curRow + 1,prevRow + 1,rowBytes,bpp);
+        if (ok)
+            convertRow(curRow + 1,outData + (size_t)iy * width * outBytes,width,colorType,sampleBytes);
+        std::swap(curRow,prevRow);
+    }
+    inflateEnd(&stream);
+
+    if (!ok)
+    {
+        free(outData);
+        return NULL;
+    }
+
+    outWidth = width;
+    outHeight = height;
+    byteWidth = outBytes;
+    return outData;
+}
+
+}
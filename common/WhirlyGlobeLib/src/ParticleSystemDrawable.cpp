@@ -139,7 +139,8 @@ void ParticleSystemDrawable::updateBatches(TimeInterval now)
             Batch &batch = batches[bi % batches.size()];
             if (batch.active)
             {
-                if (batch.startTime + lifetime < now)
+                // With no lifetime the particles stay and the calculation shader keeps moving them
+                if (lifetime > 0.0 && batch.startTime + lifetime < now)
                 {
                     batch.active = false;
                     chunksDirty = true;
@@ -175,7 +175,7 @@ void ParticleSystemDrawableGLES::addAttributeData(const RenderSetupInfo *setupIn
     }
 }
 
-void ParticleSystemDrawableGLES::drawSetupTextures(RendererFrameInfo *frameInfo,Scene *inScene,ProgramGLES *prog,bool hasTexture[],int &progTexBound)
+void ParticleSystemDrawableGLES::drawSetupTextures(RendererFrameInfoGLES *frameInfo,Scene *inScene,ProgramGLES *prog,bool hasTexture[],int &progTexBound)
 {
     auto scene = (SceneGLES *)inScene;
     
@@ -190,7 +190,7 @@ void ParticleSystemDrawableGLES::drawSetupTextures(RendererFrameInfo *frameInfo,
     }
     
     // The program itself may have some textures to bind
-    progTexBound = prog->bindTextures();
+    progTexBound = prog->bindTextures(frameInfo->stateCache);
     for (unsigned int ii=0;ii<progTexBound;ii++)
         hasTexture[ii] = true;
     
@@ -204,9 +204,7 @@ void ParticleSystemDrawableGLES::drawSetupTextures(RendererFrameInfo *frameInfo,
         hasTexture[ii+progTexBound] = glTexID != 0 && texUni;
         if (hasTexture[ii+progTexBound])
         {
-            glActiveTexture(GL_TEXTURE0+ii+progTexBound);
-            glBindTexture(GL_TEXTURE_2D, glTexID);
-            CheckGLError("BasicDrawable::drawVBO2() glBindTexture");
+            frameInfo->stateCache->bindTexture((int)ii+progTexBound, glTexID);
             prog->setUniform(baseMapNameID, (int)ii+progTexBound);
             CheckGLError("BasicDrawable::drawVBO2() glUniform1i");
             prog->setUniform(hasBaseMapNameID, 1);
@@ -216,14 +214,13 @@ void ParticleSystemDrawableGLES::drawSetupTextures(RendererFrameInfo *frameInfo,
     }
 }
 
-void ParticleSystemDrawableGLES::drawTeardownTextures(RendererFrameInfo *frameInfo,Scene *scene,ProgramGLES *prog,bool hasTexture[],int progTexBound)
+void ParticleSystemDrawableGLES::drawTeardownTextures(RendererFrameInfoGLES *frameInfo,Scene *scene,ProgramGLES *prog,bool hasTexture[],int progTexBound)
 {
     // Unbind any textures
     for (unsigned int ii=0;ii<WhirlyKitMaxTextures;ii++)
         if (hasTexture[ii])
         {
-            glActiveTexture(GL_TEXTURE0+ii);
-            glBindTexture(GL_TEXTURE_2D, 0);
+            frameInfo->stateCache->bindTexture((int)ii, 0);
         }
 }
 
@@ -67,12 +67,21 @@ void ParticleSystemSceneRep::clearContents(ChangeSet &changes)
 {
     for (const ParticleSystemDrawable *it : draws)
         changes.push_back(new RemDrawableReq(it->getId()));
+    for (const SimpleIdentity instID : instIDs)
+        changes.push_back(new RemDrawableReq(instID));
+    for (const SimpleIdentity basicID : basicIDs)
+        changes.push_back(new RemDrawableReq(basicID));
 }
     
 void ParticleSystemSceneRep::enableContents(bool enable,ChangeSet &changes)
 {
     for (const ParticleSystemDrawable *it : draws)
         changes.push_back(new OnOffChangeRequest(it->getId(),enable));
+    // The base geometry for Metal is never drawn itself
+    for (const SimpleIdentity instID : instIDs)
+        changes.push_back(new OnOffChangeRequest(instID,enable));
+    if (calcID != EmptyIdentity)
+        changes.push_back(new OnOffChangeRequest(calcID,enable));
 }
     
 ParticleSystemManager::ParticleSystemManager()
@@ -115,6 +124,7 @@ SimpleIdentity ParticleSystemManager::addParticleSystem(const ParticleSystem &ne
         calcBuild->setOnOff(newSystem.enable);
         calcBuild->setCalculationProgram(newSystem.calcShaderID);
         sceneRep->basicIDs.insert(calcBuild->getDrawableID());
+        sceneRep->calcID = calcBuild->getDrawableID();
         calcBuild->setCalculationData(newSystem.totalParticles, newSystem.partData);
         calcBuild->setTexIDs(sceneRep->partSys.texIDs);
         changes.push_back(new AddDrawableReq(calcBuild->getDrawable()));
@@ -254,8 +264,27 @@ void ParticleSystemManager::changeRenderTarget(SimpleIdentity sysID,SimpleIdenti
         if (draw) {
             changes.push_back(new RenderTargetChangeRequest(draw->getId(),targetID));
         }
+        for (const SimpleIdentity instID : sceneRep->instIDs)
+            changes.push_back(new RenderTargetChangeRequest(instID,targetID));
     }
 }
+
+void ParticleSystemManager::changeTextures(SimpleIdentity sysID,const std::vector<SimpleIdentity> &texIDs,ChangeSet &changes)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    auto it = sceneReps.find(sysID);
+    if (it == sceneReps.end())
+        return;
+    ParticleSystemSceneRep *sceneRep = it->second;
+    sceneRep->partSys.texIDs = texIDs;
+
+    // OpenGL samples them in its own drawable, Metal in the calculation pass
+    for (const ParticleSystemDrawable *draw : sceneRep->draws)
+        changes.push_back(new DrawTexturesChangeRequest(draw->getId(),texIDs));
+    if (sceneRep->calcID != EmptyIdentity)
+        changes.push_back(new DrawTexturesChangeRequest(sceneRep->calcID,texIDs));
+}
     
 void ParticleSystemManager::setUniformBlock(const SimpleIDSet &partSysIDs,const RawDataRef &uniBlock,int bufferID,ChangeSet &changes)
 {
@@ -264,8 +293,14 @@ void ParticleSystemManager::setUniformBlock(const SimpleIDSet &partSysIDs,const
     for (auto sysID : partSysIDs) {
         auto it = sceneReps.find(sysID);
         if (it != sceneReps.end())
+        {
             for (auto draw : it->second->draws)
                 changes.push_back(new UniformBlockSetRequest(draw->getId(),uniBlock,bufferID));
+            for (const SimpleIdentity instID : it->second->instIDs)
+                changes.push_back(new UniformBlockSetRequest(instID,uniBlock,bufferID));
+            if (it->second->calcID != EmptyIdentity)
+                changes.push_back(new UniformBlockSetRequest(it->second->calcID,uniBlock,bufferID));
+        }
     }
 }
 
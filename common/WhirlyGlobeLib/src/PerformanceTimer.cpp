@@ -19,6 +19,14 @@
 #import <math.h>
 #import <vector>
 #import <algorithm>
+#import <mutex>
+#import <memory>
+#import <cstring>
+#if defined(__ANDROID__)
+#import <dlfcn.h>
+#elif defined(__APPLE__)
+#import <os/signpost.h>
+#endif
 #import "WhirlyKitLog.h"
 #import "PerformanceTimer.h"
 #import "Platform.h"
@@ -153,4 +161,371 @@ void PerformanceTimer::log(double min)
     }
 }
     
+
+namespace
+{
+struct TraceEvent
+{
+    uint64_t time;      // nanoseconds
+    int32_t zone;
+    bool isBegin;
+};
+
+// Power of two, so we can wrap with a mask
+static constexpr uint64_t TraceBufferSize = 8192;
+
+// Zones past this many aren't traced.  There are a few dozen in the library.
+static constexpr int MaxTraceZones = 1024;
+
+// Written by one thread, read by whoever's dumping
+struct TraceThreadBuffer
+{
+    uint64_t threadID = 0;
+    std::atomic<uint64_t> numWritten { 0 };
+    std::atomic<uint64_t> clearedTo { 0 };
+    TraceEvent events[TraceBufferSize];
+
+    void add(int zone,bool isBegin,uint64_t time)
+    {
+        const uint64_t idx = numWritten.load(std::memory_order_relaxed);
+        TraceEvent &event = events[idx & (TraceBufferSize-1)];
+        event.time = time;
+        event.zone = zone;
+        event.isBegin = isBegin;
+        numWritten.store(idx+1,std::memory_order_release);
+    }
+};
+
+struct TraceRegistry
+{
+    std::mutex lock;
+    // Names are written before numZones goes up and never change after,
+    // so they can be read without the lock up to numZones
+    const char *zoneNames[MaxTraceZones] = {};
+    std::atomic<int> numZones { 0 };
+    std::vector<std::shared_ptr<TraceThreadBuffer>> buffers;
+    // Buffers whose threads have exited, ready for new threads
+    std::vector<std::shared_ptr<TraceThreadBuffer>> freeBuffers;
+    uint64_t nextThreadID = 1;
+};
+
+// Never torn down, threads may still be tracing at exit
+static TraceRegistry &GetTraceRegistry()
+{
+    static TraceRegistry *registry = new TraceRegistry();
+    return *registry;
+}
+
+// Hands the thread's buffer back when the thread exits.
+// Pools create and retire threads, so the buffers are reused rather than piling up.
+// A reused buffer keeps its thread ID, so it shows up as one track with the
+// old thread's events followed by the new thread's.
+struct TraceThreadSlot
+{
+    std::shared_ptr<TraceThreadBuffer> buffer;
+
+    ~TraceThreadSlot()
+    {
+        if (buffer)
+        {
+            auto &registry = GetTraceRegistry();
+            std::lock_guard<std::mutex> guardLock(registry.lock);
+            registry.freeBuffers.push_back(std::move(buffer));
+        }
+    }
+};
+
+static thread_local TraceThreadSlot traceThreadSlot;
+
+static TraceThreadBuffer *GetTraceThreadBuffer()
+{
+    auto &buffer = traceThreadSlot.buffer;
+    if (!buffer)
+    {
+        auto &registry = GetTraceRegistry();
+        std::lock_guard<std::mutex> guardLock(registry.lock);
+        if (!registry.freeBuffers.empty())
+        {
+            buffer = std::move(registry.freeBuffers.back());
+            registry.freeBuffers.pop_back();
+        }
+        else
+        {
+            buffer = std::make_shared<TraceThreadBuffer>();
+            buffer->threadID = registry.nextThreadID++;
+            registry.buffers.push_back(buffer);
+        }
+    }
+    return buffer.get();
+}
+
+static inline uint64_t TraceTime()
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (uint64_t)tp.tv_sec * 1000000000ULL + (uint64_t)tp.tv_nsec;
+}
+
+#if defined(__ANDROID__)
+// ATrace is API 23, but we support older, so look it up at runtime
+typedef void (*ATraceBeginFunc)(const char *);
+typedef void (*ATraceEndFunc)();
+struct ATraceFuncs
+{
+    ATraceFuncs()
+    {
+        if (void *lib = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL))
+        {
+            beginSection = (ATraceBeginFunc)dlsym(lib, "ATrace_beginSection");
+            endSection = (ATraceEndFunc)dlsym(lib, "ATrace_endSection");
+        }
+    }
+    ATraceBeginFunc beginSection = nullptr;
+    ATraceEndFunc endSection = nullptr;
+};
+static const ATraceFuncs &GetATrace()
+{
+    static ATraceFuncs funcs;
+    return funcs;
+}
+#elif defined(__APPLE__)
+static os_log_t GetTraceLog()
+{
+    static os_log_t traceLog = os_log_create("com.mousebird.maply", "Trace");
+    return traceLog;
+}
+// Signposts need the ID from the begin to match up the end
+static thread_local std::vector<os_signpost_id_t> traceSignposts;
+#endif
+
+}
+
+std::atomic<bool> TraceZones::enabled(false);
+std::atomic<bool> TraceZones::recording(false);
+std::atomic<bool> TraceZones::systemTracing(false);
+
+int TraceZones::registerZone(const char *name)
+{
+    auto &registry = GetTraceRegistry();
+    std::lock_guard<std::mutex> guardLock(registry.lock);
+
+    // Zones with the same name from different places are the same zone
+    const int numZones = registry.numZones.load(std::memory_order_relaxed);
+    for (int ii=0;ii<numZones;ii++)
+    {
+        if (!strcmp(registry.zoneNames[ii],name))
+            return ii;
+    }
+    if (numZones >= MaxTraceZones)
+        return -1;
+    registry.zoneNames[numZones] = name;
+    registry.numZones.store(numZones+1,std::memory_order_release);
+    return numZones;
+}
+
+const char *TraceZones::getZoneName(int zone)
+{
+    const auto &registry = GetTraceRegistry();
+    return (zone >= 0 && zone < registry.numZones.load(std::memory_order_acquire)) ? registry.zoneNames[zone] : "unknown";
+}
+
+void TraceZones::setRecording(bool record)
+{
+    recording.store(record,std::memory_order_relaxed);
+    enabled.store(record || systemTracing.load(std::memory_order_relaxed),std::memory_order_relaxed);
+}
+
+void TraceZones::setSystemTracing(bool trace)
+{
+    systemTracing.store(trace,std::memory_order_relaxed);
+    enabled.store(trace || recording.load(std::memory_order_relaxed),std::memory_order_relaxed);
+}
+
+int TraceZones::begin(int zone)
+{
+    int emitted = 0;
+    if (recording.load(std::memory_order_relaxed))
+    {
+        GetTraceThreadBuffer()->add(zone,true,TraceTime());
+        emitted |= TraceRecorded;
+    }
+    if (systemTracing.load(std::memory_order_relaxed))
+    {
+#if defined(__ANDROID__)
+        const auto &atrace = GetATrace();
+        if (atrace.beginSection)
+        {
+            atrace.beginSection(getZoneName(zone));
+            emitted |= TraceSystem;
+        }
+#elif defined(__APPLE__)
+        const os_log_t traceLog = GetTraceLog();
+        const os_signpost_id_t signpost = os_signpost_id_generate(traceLog);
+        os_signpost_interval_begin(traceLog, signpost, "Zone", "%{public}s", getZoneName(zone));
+        traceSignposts.push_back(signpost);
+        emitted |= TraceSystem;
+#endif
+    }
+    return emitted;
+}
+
+void TraceZones::end(int zone,int emitted)
+{
+    // Only close what the begin opened, whatever the switches say now
+    if (emitted & TraceRecorded)
+    {
+        GetTraceThreadBuffer()->add(zone,false,TraceTime());
+    }
+    if (emitted & TraceSystem)
+    {
+#if defined(__ANDROID__)
+        GetATrace().endSection();
+#elif defined(__APPLE__)
+        os_signpost_interval_end(GetTraceLog(), traceSignposts.back(), "Zone");
+        traceSignposts.pop_back();
+#endif
+    }
+}
+
+std::string TraceZones::getChromeTrace()
+{
+    auto &registry = GetTraceRegistry();
+    std::vector<std::shared_ptr<TraceThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> guardLock(registry.lock);
+        buffers = registry.buffers;
+    }
+
+    std::string json = "{\"traceEvents\":[";
+    bool first = true;
+    char line[256];
+    std::vector<TraceEvent> events;
+    for (const auto &buffer : buffers)
+    {
+        // Copy out what's there, then toss anything the writer lapped while we were copying
+        const uint64_t numWritten = buffer->numWritten.load(std::memory_order_acquire);
+        const uint64_t start = std::max(buffer->clearedTo.load(std::memory_order_relaxed),
+                                        numWritten > TraceBufferSize ? numWritten - TraceBufferSize : 0);
+        events.clear();
+        for (uint64_t ii=start;ii<numWritten;ii++)
+            events.push_back(buffer->events[ii & (TraceBufferSize-1)]);
+        const uint64_t numWrittenAfter = buffer->numWritten.load(std::memory_order_acquire);
+        const uint64_t validStart = numWrittenAfter > TraceBufferSize ? numWrittenAfter - TraceBufferSize : 0;
+        const size_t skip = (size_t)std::min<uint64_t>(validStart > start ? validStart - start : 0,events.size());
+
+        for (size_t ii=skip;ii<events.size();ii++)
+        {
+            const auto &event = events[ii];
+            const char *name = getZoneName(event.zone);
+            snprintf(line,sizeof(line),"%s{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%llu}",
+                     first ? "" : ",",name,event.isBegin ? "B" : "E",
+                     event.time / 1000.0,(unsigned long long)buffer->threadID);
+            json += line;
+            first = false;
+        }
+    }
+    json += "]}";
+
+    return json;
+}
+
+void TraceZones::clear()
+{
+    auto &registry = GetTraceRegistry();
+    std::lock_guard<std::mutex> guardLock(registry.lock);
+    for (const auto &buffer : registry.buffers)
+        buffer->clearedTo.store(buffer->numWritten.load(std::memory_order_acquire),std::memory_order_relaxed);
+}
+
+StartupTimeline::StartupTimeline() :
+    startTime(TimeGetCurrent()),
+    finalMark("first content"),
+    done(false)
+{
+}
+
+void StartupTimeline::restart(TimeInterval when)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    startTime = (when > 0.0) ? when : TimeGetCurrent();
+    phases.clear();
+    done = false;
+}
+
+void StartupTimeline::begin(const std::string &name)
+{
+    if (isDone())
+        return;
+    std::lock_guard<std::mutex> guardLock(lock);
+    phases.push_back(Phase { name, TimeGetCurrent() - startTime, -1.0 });
+}
+
+void StartupTimeline::end(const std::string &name)
+{
+    if (isDone())
+        return;
+    std::lock_guard<std::mutex> guardLock(lock);
+    // The most recent one by that name that's still going
+    for (auto it = phases.rbegin(); it != phases.rend(); ++it)
+        if (it->end < 0.0 && it->name == name)
+        {
+            it->end = TimeGetCurrent() - startTime;
+            break;
+        }
+}
+
+void StartupTimeline::add(const std::string &name,TimeInterval start,TimeInterval end)
+{
+    if (isDone())
+        return;
+    std::lock_guard<std::mutex> guardLock(lock);
+    phases.push_back(Phase { name, start - startTime, end - startTime });
+}
+
+void StartupTimeline::mark(const std::string &name)
+{
+    if (isDone())
+        return;
+    std::lock_guard<std::mutex> guardLock(lock);
+    for (const auto &phase : phases)
+        if (phase.name == name)
+            return;
+    const TimeInterval when = TimeGetCurrent() - startTime;
+    phases.push_back(Phase { name, when, when });
+    if (name == finalMark)
+        done = true;
+}
+
+void StartupTimeline::setFinalMark(const std::string &name)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    finalMark = name;
+}
+
+std::vector<StartupTimeline::Phase> StartupTimeline::getPhases() const
+{
+    std::vector<Phase> ret;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        ret = phases;
+    }
+    // Phases added after the fact can be out of order
+    std::stable_sort(ret.begin(),ret.end(),[](const Phase &a,const Phase &b) { return a.start < b.start; });
+    return ret;
+}
+
+void StartupTimeline::log() const
+{
+    for (const auto &phase : getPhases())
+    {
+        if (phase.end < 0.0)
+            wkLogLevel(Info,"Startup %s: started at %.1f ms, not done",phase.name.c_str(),1000*phase.start);
+        else if (phase.end == phase.start)
+            wkLogLevel(Info,"Startup %s: at %.1f ms",phase.name.c_str(),1000*phase.start);
+        else
+            wkLogLevel(Info,"Startup %s: %.1f to %.1f ms (%.1f ms)",phase.name.c_str(),
+                       1000*phase.start,1000*phase.end,1000*(phase.end-phase.start));
+    }
+}
+
 }
@@ -0,0 +1,466 @@
+/*  PointCloudLoader.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import <cmath>
+#import <limits>
+#import "PointCloudLoader.h"
+
+namespace WhirlyKit
+{
+
+static const double QuantMax = 65535.0;
+
+bool OctreeIdentifier::operator < (const OctreeIdentifier &that) const
+{
+    if (level != that.level)
+        return level < that.level;
+    if (x != that.x)
+        return x < that.x;
+    if (y != that.y)
+        return y < that.y;
+    return z < that.z;
+}
+
+bool OctreeIdentifier::operator == (const OctreeIdentifier &that) const
+{
+    return level == that.level && x == that.x && y == that.y && z == that.z;
+}
+
+OctreeIdentifier OctreeIdentifier::child(int which) const
+{
+    return OctreeIdentifier(2*x + (which & 0x1),
+                            2*y + ((which >> 1) & 0x1),
+                            2*z + ((which >> 2) & 0x1),
+                            level+1);
+}
+
+PointCloudChunk::PointCloudChunk(const Point3d &ll,const Point3d &ur)
+: center((ll+ur)/2.0), scale((ur-ll)/QuantMax)
+{
+}
+
+void PointCloudChunk::addPoint(const Point3d &pt)
+{
+    // Work from the center out, so a flat box still comes back where it started
+    const Point3d minPt = center - scale * QuantMax / 2.0;
+    for (unsigned int ii=0;ii<3;ii++)
+    {
+        const double val = (scale[ii] > 0.0) ? std::round((pt[ii] - minPt[ii]) / scale[ii]) : 0.0;
+        quantPts.push_back((uint16_t)std::min(std::max(val,0.0),QuantMax));
+    }
+}
+
+void PointCloudChunk::addColor(const RGBAColor &color)
+{
+    colors.push_back(color);
+}
+
+Point3f PointCloudChunk::getPoint(size_t which) const
+{
+    const uint16_t *qPt = &quantPts[which*3];
+    return Point3f((qPt[0] - QuantMax / 2.0) * scale.x(),
+                   (qPt[1] - QuantMax / 2.0) * scale.y(),
+                   (qPt[2] - QuantMax / 2.0) * scale.z());
+}
+
+size_t PointCloudChunk::getMemSize() const
+{
+    return quantPts.size() * sizeof(uint16_t) + colors.size() * sizeof(RGBAColor);
+}
+
+size_t PointCloudChunk::getGeomSize() const
+{
+    // Float3 positions, along with Float4 colors if we have them
+    return getNumPoints() * (3 + (colors.empty() ? 0 : 4)) * sizeof(float);
+}
+
+void PointCloudChunk::buildPoints(GeometryRawPoints &rawPts,Eigen::Matrix4d &mat) const
+{
+    const size_t numPts = getNumPoints();
+    const bool hasColors = !colors.empty() && colors.size() >= numPts;
+
+    const int posIdx = rawPts.addAttribute(a_PositionNameID,GeomRawFloat3Type);
+    const int colorIdx = hasColors ? rawPts.addAttribute(a_colorNameID,GeomRawFloat4Type) : -1;
+    for (size_t ii=0;ii<numPts;ii++)
+    {
+        rawPts.addPoint(posIdx,getPoint(ii));
+        if (hasColors)
+        {
+            float rgba[4];
+            colors[ii].asUnitFloats(rgba);
+            rawPts.addPoint(colorIdx,Eigen::Vector4f(rgba[0],rgba[1],rgba[2],rgba[3]));
+        }
+    }
+
+    const Eigen::Affine3d trans(Eigen::Translation3d(center.x(),center.y(),center.z()));
+    mat = trans.matrix();
+}
+
+PointCloudLoader::PointCloudLoader(const Point3d &ll,const Point3d &ur,int maxLevel,double rootSpacing,const PointCloudSourceRef &source)
+: ll(ll), ur(ur), maxLevel(maxLevel), rootSpacing(rootSpacing), source(source)
+{
+}
+
+PointCloudLoader::~PointCloudLoader()
+{
+    if (memClientID >= 0)
+        TileMemoryManager::getShared().removeClient(memClientID);
+}
+
+void PointCloudLoader::boundsForNode(const OctreeIdentifier &ident,Point3d &outLL,Point3d &outUR) const
+{
+    const Point3d size = (ur - ll) / (double)(1 << ident.level);
+    outLL = ll + Point3d(ident.x * size.x(),ident.y * size.y(),ident.z * size.z());
+    outUR = outLL + size;
+}
+
+void PointCloudLoader::chunkLoaded(const OctreeIdentifier &ident,const PointCloudChunkRef &chunk)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    pending.emplace_back(ident,chunk);
+}
+
+void PointCloudLoader::chunkFailed(const OctreeIdentifier &ident)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    pending.emplace_back(ident,PointCloudChunkRef());
+}
+
+void PointCloudLoader::start(Scene *inScene)
+{
+    scene = inScene;
+    if (useMemoryBudget)
+        memClientID = TileMemoryManager::getShared().addClient();
+}
+
+size_t PointCloudLoader::nodeBytes(const Node &node)
+{
+    if (!node.chunk)
+        return 0;
+    return node.chunk->getMemSize() + (node.geomID != EmptyIdentity ? node.chunk->getGeomSize() : 0);
+}
+
+void PointCloudLoader::calcWanted(const ViewStateRef &viewState,std::vector<WantedNode> &wanted)
+{
+    // Pixels covered by one display unit at a distance of one
+    const double focal = viewState->frameSize.y() * 0.5 * viewState->projMatrix(1,1);
+    const bool checkHorizon = viewState->horizon.isEnabled();
+
+    std::vector<std::pair<OctreeIdentifier,double> > toVisit;
+    toVisit.emplace_back(OctreeIdentifier(),std::numeric_limits<double>::max());
+    while (!toVisit.empty())
+    {
+        const OctreeIdentifier ident = toVisit.back().first;
+        const double parentImport = toVisit.back().second;
+        toVisit.pop_back();
+
+        Point3d nodeLL,nodeUR;
+        boundsForNode(ident,nodeLL,nodeUR);
+        const Point3d center = (nodeLL + nodeUR) / 2.0;
+        const double radius = (nodeUR - nodeLL).norm() / 2.0;
+        if (!viewState->sphereInFrustum(center,radius))
+            continue;
+        if (checkHorizon)
+        {
+            const Point3d corners[8] = {
+                nodeLL, Point3d(nodeUR.x(),nodeLL.y(),nodeLL.z()),
+                Point3d(nodeLL.x(),nodeUR.y(),nodeLL.z()), Point3d(nodeUR.x(),nodeUR.y(),nodeLL.z()),
+                Point3d(nodeLL.x(),nodeLL.y(),nodeUR.z()), Point3d(nodeUR.x(),nodeLL.y(),nodeUR.z()),
+                Point3d(nodeLL.x(),nodeUR.y(),nodeUR.z()), nodeUR };
+            if (viewState->isPastHorizon(HorizonBound(corners,8)))
+                continue;
+        }
+
+        const double dist = std::max((viewState->eyePos - center).norm() - radius,viewState->nearPlane);
+        const double pixSize = radius * focal / dist;
+        const double pixSpacing = std::ldexp(rootSpacing,-ident.level) * focal / dist;
+
+        // Rank by screen area, like the quad loaders, but never ahead of the parent
+        const double import = std::min(pixSize * pixSize,parentImport);
+        wanted.push_back(WantedNode{ident,import});
+
+        if (pixSpacing <= pixelSpacing || ident.level >= maxLevel)
+            continue;
+
+        // Children are only known once the parent is in
+        const auto it = nodes.find(ident);
+        if (it == nodes.end() || it->second.state != NodeLoaded || !it->second.chunk)
+            continue;
+        for (int which=0;which<8;which++)
+            if (it->second.chunk->childMask & (1 << which))
+                toVisit.emplace_back(ident.child(which),import);
+    }
+
+    // Parents come before their children and ties keep that order
+    std::stable_sort(wanted.begin(),wanted.end(),
+                     [](const WantedNode &a,const WantedNode &b) { return a.import > b.import; });
+}
+
+void PointCloudLoader::evict(const std::set<OctreeIdentifier> &wantedSet,ChangeSet &changes)
+{
+    size_t totalBytes = 0;
+    std::vector<std::map<OctreeIdentifier,Node>::iterator> candidates;
+    for (auto it = nodes.begin(); it != nodes.end(); ++it)
+    {
+        totalBytes += nodeBytes(it->second);
+        if (it->second.state == NodeLoaded && wantedSet.find(it->first) == wantedSet.end())
+            candidates.push_back(it);
+    }
+    if (totalBytes <= memBudget || candidates.empty())
+        return;
+
+    std::sort(candidates.begin(),candidates.end(),
+              [](const std::map<OctreeIdentifier,Node>::iterator &a,const std::map<OctreeIdentifier,Node>::iterator &b)
+              { return a->second.lastUsed < b->second.lastUsed; });
+
+    const auto geomManager = scene->getManager<GeometryManager>(kWKGeometryManager);
+
+    // Geometry goes first, since the points are cheap to hold and quick to rebuild from
+    SimpleIDSet removeIDs;
+    for (auto it : candidates)
+    {
+        if (totalBytes <= memBudget)
+            break;
+        Node &node = it->second;
+        if (node.geomID != EmptyIdentity)
+        {
+            totalBytes -= node.chunk->getGeomSize();
+            removeIDs.insert(node.geomID);
+            node.geomID = EmptyIdentity;
+            node.enabled = false;
+        }
+    }
+    for (auto it : candidates)
+    {
+        if (totalBytes <= memBudget)
+            break;
+        totalBytes -= nodeBytes(it->second);
+        if (it->second.geomID != EmptyIdentity)
+            removeIDs.insert(it->second.geomID);
+        nodes.erase(it);
+    }
+
+    if (geomManager && !removeIDs.empty())
+        geomManager->removeGeometry(removeIDs,changes);
+}
+
+bool PointCloudLoader::viewUpdate(PlatformThreadInfo *threadInfo,const ViewStateRef &inViewState,ChangeSet &changes)
+{
+    if (!scene)
+        return false;
+    const auto geomManager = scene->getManager<GeometryManager>(kWKGeometryManager);
+    if (!geomManager)
+        return false;
+
+    // Pick up whatever the source finished
+    std::vector<std::pair<OctreeIdentifier,PointCloudChunkRef> > loaded;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        loaded.swap(pending);
+    }
+    for (const auto &result : loaded)
+    {
+        const auto it = nodes.find(result.first);
+        // Canceled in the meantime
+        if (it == nodes.end() || it->second.state != NodeFetching)
+            continue;
+        it->second.state = result.second ? NodeLoaded : NodeFailed;
+        it->second.chunk = result.second;
+        numFetching--;
+    }
+
+    if (inViewState)
+        lastViewState = inViewState;
+    const ViewStateRef viewState = lastViewState;
+    if (!viewState || !viewState->isValid())
+        return numFetching > 0;
+
+    std::vector<WantedNode> wanted;
+    calcWanted(viewState,wanted);
+
+    // Take what fits in our budget, guessing at the nodes we haven't seen yet
+    size_t avgBytes = 64*1024;
+    size_t totalBytes = 0;
+    int numLoaded = 0;
+    for (const auto &it : nodes)
+        if (it.second.chunk)
+        {
+            totalBytes += it.second.chunk->getMemSize() + it.second.chunk->getGeomSize();
+            numLoaded++;
+        }
+    if (numLoaded > 0)
+        avgBytes = std::max(totalBytes / numLoaded,(size_t)1);
+
+    size_t numWanted = 0;
+    size_t wantedBytes = 0;
+    for (const auto &want : wanted)
+    {
+        const auto it = nodes.find(want.ident);
+        const size_t bytes = (it != nodes.end() && it->second.chunk) ?
+                it->second.chunk->getMemSize() + it->second.chunk->getGeomSize() : avgBytes;
+        if (numWanted > 0 && wantedBytes + bytes > memBudget)
+            break;
+        wantedBytes += bytes;
+        numWanted++;
+    }
+
+    // And share the rest of the budget with the tile loaders
+    if (memClientID >= 0)
+    {
+        std::vector<double> wantedImports;
+        wantedImports.reserve(wanted.size());
+        for (const auto &want : wanted)
+            wantedImports.push_back(want.import);
+        TileMemoryUsage usage;
+        for (const auto &it : nodes)
+            usage.bytes += nodeBytes(it.second);
+        usage.bytesPerTile = avgBytes;
+        const int memLimit = TileMemoryManager::getShared().updateClient(memClientID,std::move(wantedImports),usage);
+        if (memLimit >= 0)
+            numWanted = std::min(numWanted,(size_t)std::max(memLimit,1));
+    }
+    wanted.resize(numWanted);
+
+    std::set<OctreeIdentifier> wantedSet;
+    for (const auto &want : wanted)
+        wantedSet.insert(want.ident);
+
+    // Stop fetching what we don't want anymore and forget failures, so they can be tried again later
+    for (auto it = nodes.begin(); it != nodes.end(); )
+    {
+        if (it->second.state != NodeLoaded && wantedSet.find(it->first) == wantedSet.end())
+        {
+            if (it->second.state == NodeFetching)
+            {
+                source->cancelFetch(this,it->first);
+                numFetching--;
+            }
+            it = nodes.erase(it);
+        } else
+            ++it;
+    }
+
+    // Start fetches for the most important nodes we don't have
+    for (const auto &want : wanted)
+    {
+        if (numFetching >= maxFetches)
+            break;
+        if (nodes.find(want.ident) != nodes.end())
+            continue;
+        nodes[want.ident].state = NodeFetching;
+        numFetching++;
+        source->startFetch(this,want.ident);
+    }
+
+    // Show the nodes we want and hide the rest
+    const TimeInterval now = scene->getCurrentTime();
+    SimpleIDSet enableIDs,disableIDs;
+    for (auto &it : nodes)
+    {
+        Node &node = it.second;
+        if (node.state != NodeLoaded)
+            continue;
+        if (wantedSet.find(it.first) != wantedSet.end())
+        {
+            node.lastUsed = now;
+            if (node.geomID == EmptyIdentity)
+            {
+                GeometryRawPoints rawPts;
+                Eigen::Matrix4d mat;
+                node.chunk->buildPoints(rawPts,mat);
+                if (node.chunk->getNumPoints() > 0)
+                    node.geomID = geomManager->addGeometryPoints(rawPts,mat,geomInfo,changes);
+            } else if (!node.enabled)
+                enableIDs.insert(node.geomID);
+            node.enabled = true;
+        } else if (node.enabled)
+        {
+            if (node.geomID != EmptyIdentity)
+                disableIDs.insert(node.geomID);
+            node.enabled = false;
+        }
+    }
+    if (!enableIDs.empty())
+        geomManager->enableGeometry(enableIDs,true,changes);
+    if (!disableIDs.empty())
+        geomManager->enableGeometry(disableIDs,false,changes);
+
+    evict(wantedSet,changes);
+
+    // Update the stats for anyone watching
+    Stats newStats;
+    newStats.numFetching = numFetching;
+    for (const auto &it : nodes)
+    {
+        if (!it.second.chunk)
+            continue;
+        newStats.numLoaded++;
+        newStats.bytes += nodeBytes(it.second);
+        if (it.second.enabled)
+        {
+            newStats.numDisplayed++;
+            newStats.numPointsDisplayed += it.second.chunk->getNumPoints();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        stats = newStats;
+    }
+
+    return numFetching > 0;
+}
+
+void PointCloudLoader::stop(PlatformThreadInfo *threadInfo,ChangeSet &changes)
+{
+    SimpleIDSet removeIDs;
+    for (const auto &it : nodes)
+    {
+        if (it.second.state == NodeFetching)
+            source->cancelFetch(this,it.first);
+        if (it.second.geomID != EmptyIdentity)
+            removeIDs.insert(it.second.geomID);
+    }
+    nodes.clear();
+    numFetching = 0;
+
+    if (scene && !removeIDs.empty())
+        if (const auto geomManager = scene->getManager<GeometryManager>(kWKGeometryManager))
+            geomManager->removeGeometry(removeIDs,changes);
+
+    if (memClientID >= 0)
+    {
+        TileMemoryManager::getShared().removeClient(memClientID);
+        memClientID = -1;
+    }
+
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        pending.clear();
+        stats = Stats();
+    }
+    lastViewState.reset();
+    scene = nullptr;
+}
+
+PointCloudLoader::Stats PointCloudLoader::getStats() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return stats;
+}
+
+}
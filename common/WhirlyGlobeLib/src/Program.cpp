@@ -19,6 +19,7 @@
 #import "Program.h"
 #import "Scene.h"
 #import "BasicDrawable.h"
+#import "SceneRenderer.h"
 
 namespace WhirlyKit
 {
@@ -64,6 +65,8 @@ void ShaderAddTextureReq::execute(Scene *scene, SceneRenderer *renderer, View *v
     if (prog && tex)
     {
         prog->setTexture(nameID,tex.get(),textureSlot);
+        if (renderer)
+            renderer->markRenderTargetsDirty();
     }
 }
 
@@ -77,6 +80,8 @@ void ShaderRemTextureReq::execute(Scene *scene,SceneRenderer *renderer,WhirlyKit
     if (Program *prog = scene->getProgram(shaderID))
     {
         prog->clearTexture(texID);
+        if (renderer)
+            renderer->markRenderTargetsDirty();
     }
 }
 
@@ -92,6 +97,9 @@ void ProgramUniformBlockSetRequest::execute(Scene *scene,SceneRenderer *renderer
     if (Program *prog = scene->getProgram(progID))
     {
         prog->setUniBlock(uniBlock);
+        // We don't know who's using the program, so anything we're caching has to go
+        if (renderer)
+            renderer->markRenderTargetsDirty();
     }
 }
 
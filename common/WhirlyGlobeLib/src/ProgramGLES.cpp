@@ -17,12 +17,16 @@
  */
 
 #import <string>
+#import <mutex>
+#import <cstdio>
+#import <cstring>
 #import "ProgramGLES.h"
 #import "Lighting.h"
 #import "UtilsGLES.h"
 #import "SceneRendererGLES.h"
 #import "TextureGLES.h"
 #import "WhirlyKitLog.h"
+#import "StableBytes.h"
 
 using namespace Eigen;
 
@@ -78,11 +82,18 @@ bool ProgramGLES::setUniform(StringIdentity nameID,float val,int index)
 
     if (uni->type != GL_FLOAT)
         return false;
+
+    // We only keep the first entry's value
+    if (index == 0 && uni->isSet && uni->val.fVals[0] == val)
+        return true;
     
     glUniform1f(uni->index+index,val);
     CheckGLError("ProgramGLES::setUniform() glUniform1f");
-    uni->isSet = true;
-    uni->val.fVals[0] = val;
+    if (index == 0)
+    {
+        uni->isSet = true;
+        uni->val.fVals[0] = val;
+    }
     
     return true;
 }
@@ -203,14 +214,18 @@ bool ProgramGLES::setUniform(StringIdentity nameID,const Eigen::Vector4f &vec,in
     
     if (uni->type != GL_FLOAT_VEC4)
         return false;
-    if (uni->isSet && uni->val.fVals[0] == vec.x() && uni->val.fVals[1] == vec.y() &&
+    // We only keep the first entry's value
+    if (index == 0 && uni->isSet && uni->val.fVals[0] == vec.x() && uni->val.fVals[1] == vec.y() &&
         uni->val.fVals[2] == vec.z() && uni->val.fVals[3] == vec.w())
         return true;
     
     glUniform4f(uni->index+index, vec.x(), vec.y(), vec.z(), vec.w());
     CheckGLError("ProgramGLES::setUniform() glUniform4f");
-    uni->isSet = true;
-    uni->val.fVals[0] = vec.x();  uni->val.fVals[1] = vec.y();  uni->val.fVals[2] = vec.z(); uni->val.fVals[3] = vec.w();
+    if (index == 0)
+    {
+        uni->isSet = true;
+        uni->val.fVals[0] = vec.x();  uni->val.fVals[1] = vec.y();  uni->val.fVals[2] = vec.z(); uni->val.fVals[3] = vec.w();
+    }
     
     return true;
 }
@@ -313,6 +328,130 @@ bool compileShader(const std::string &name,const char *shaderTypeStr,GLuint *sha
     return status == GL_TRUE;
 }
 
+// Where linked programs go, if anywhere
+static std::mutex binaryCacheLock;
+static std::string binaryCacheDir;
+
+static const char BinaryMagic[4] = { 'W', 'K', 'P', 'B' };
+static const uint32_t BinaryVersion = 1;
+
+void ProgramGLES::setBinaryCacheDir(const std::string &dir)
+{
+    std::lock_guard<std::mutex> guardLock(binaryCacheLock);
+    binaryCacheDir = dir;
+}
+
+// Hash a driver string along with its terminator, if there is one
+static uint64_t HashString(uint64_t hash,const char *str)
+{
+    return str ? StableHash(str,strlen(str)+1,hash) : hash;
+}
+
+// File for a program with this source on this driver, or empty if we're not caching
+static std::string BinaryCachePath(const std::string &vShaderString,const std::string &fShaderString,
+                                   const std::vector<std::string> *varying)
+{
+    std::string dir;
+    {
+        std::lock_guard<std::mutex> guardLock(binaryCacheLock);
+        dir = binaryCacheDir;
+    }
+    if (dir.empty())
+        return std::string();
+
+    // Some drivers can't hand out binaries at all
+    GLint numFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    if (numFormats <= 0)
+        return std::string();
+
+    uint64_t hash = StableHashSeed;
+    hash = HashString(hash,(const char *)glGetString(GL_VENDOR));
+    hash = HashString(hash,(const char *)glGetString(GL_RENDERER));
+    hash = HashString(hash,(const char *)glGetString(GL_VERSION));
+    hash = StableHash(vShaderString.c_str(),vShaderString.size()+1,hash);
+    hash = StableHash(fShaderString.c_str(),fShaderString.size()+1,hash);
+    if (varying)
+        for (const auto &str : *varying)
+            hash = StableHash(str.c_str(),str.size()+1,hash);
+
+    char name[64];
+    snprintf(name,sizeof(name),"%016llx.glprog",(unsigned long long)hash);
+    if (dir.back() != '/')
+        dir += '/';
+    return dir + name;
+}
+
+bool ProgramGLES::loadBinary(const std::string &path)
+{
+    FILE *fp = fopen(path.c_str(),"rb");
+    if (!fp)
+        return false;
+
+    char magic[4];
+    uint32_t version = 0, format = 0, len = 0;
+    std::vector<char> data;
+    bool valid = fread(magic,1,4,fp) == 4 && memcmp(magic,BinaryMagic,4) == 0 &&
+                 fread(&version,sizeof(version),1,fp) == 1 && version == BinaryVersion &&
+                 fread(&format,sizeof(format),1,fp) == 1 &&
+                 fread(&len,sizeof(len),1,fp) == 1 && len > 0;
+    if (valid)
+    {
+        data.resize(len);
+        valid = fread(data.data(),1,len,fp) == len;
+    }
+    fclose(fp);
+
+    if (valid)
+    {
+        glProgramBinary(program, format, data.data(), len);
+        GLint status = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        valid = (glGetError() == GL_NO_ERROR) && status == GL_TRUE;
+    }
+
+    // The driver is free to turn down binaries it made itself, so toss it and build from source
+    if (!valid)
+    {
+        wkLogLevel(Info,"Discarding cached program binary for %s",name.c_str());
+        remove(path.c_str());
+    }
+
+    return valid;
+}
+
+void ProgramGLES::saveBinary(const std::string &path)
+{
+    GLint len = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &len);
+    if (len <= 0)
+        return;
+
+    std::vector<char> data(len);
+    GLenum format = 0;
+    GLsizei outLen = 0;
+    glGetProgramBinary(program, len, &outLen, &format, data.data());
+    if (!CheckGLError("ProgramGLES: glGetProgramBinary") || outLen <= 0)
+        return;
+
+    // Write it out under another name and move it into place, so nobody reads half a file
+    const std::string tmpPath = path + ".tmp";
+    FILE *fp = fopen(tmpPath.c_str(),"wb");
+    if (!fp)
+        return;
+
+    const uint32_t version = BinaryVersion, format32 = format, len32 = outLen;
+    const bool ok = fwrite(BinaryMagic,1,4,fp) == 4 &&
+                    fwrite(&version,sizeof(version),1,fp) == 1 &&
+                    fwrite(&format32,sizeof(format32),1,fp) == 1 &&
+                    fwrite(&len32,sizeof(len32),1,fp) == 1 &&
+                    fwrite(data.data(),1,outLen,fp) == (size_t)outLen;
+    if (fclose(fp) == 0 && ok)
+        rename(tmpPath.c_str(),path.c_str());
+    else
+        remove(tmpPath.c_str());
+}
+
 #define DUMP_UNIFORMS 0
 
 // Construct the program, compile and link
@@ -337,16 +476,68 @@ ProgramGLES::ProgramGLES(const std::string &inName,const std::string &vShaderStr
         return;
     }
     
+    // Linked programs from an earlier run skip the compile entirely
+    const std::string cachePath = BinaryCachePath(vShaderString,fShaderString,varying);
+    if (cachePath.empty() || !loadBinary(cachePath))
+    {
+        if (!buildFromSource(vShaderString,fShaderString,varying,!cachePath.empty()))
+        {
+            cleanUp();
+            return;
+        }
+        if (!cachePath.empty())
+            saveBinary(cachePath);
+    }
+
+    // Convert the uniforms into a more friendly form
+    GLint numUniform;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &numUniform);
+    char thingName[1024];
+    for (unsigned int ii=0;ii<numUniform;ii++)
+    {
+        auto uni = std::make_shared<OpenGLESUniform>();
+        GLint bufLen;
+        thingName[0] = 0;
+        glGetActiveUniform(program, ii, sizeof(thingName)-1, &bufLen, &uni->size, &uni->type, thingName);
+        uni->nameID = StringIndexer::getStringID(thingName);
+        uni->index = glGetUniformLocation(program, thingName);
+        uniforms[uni->nameID] = uni;
+#if DUMP_UNIFORMS
+        wkLog("%s Uniform %d/%d, name=%d, idx=%d, %s", inName.c_str(), ii, numUniform, uni->nameID, uni->index, thingName);
+#endif
+    }
+    CheckGLError("ProgramGLES: glGetActiveUniform");
+
+    // Convert the attributes into a more useful form
+    GLint numAttr;
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &numAttr);
+    for (unsigned int ii=0;ii<numAttr;ii++)
+    {
+        auto attr = std::make_shared<OpenGLESAttribute>();
+        GLint bufLen;
+        thingName[0] = 0;
+        glGetActiveAttrib(program, ii, sizeof(thingName)-1, &bufLen, &attr->size, &attr->type, thingName);
+        attr->index = glGetAttribLocation(program, thingName);
+        attr->nameID = StringIndexer::getStringID(thingName);
+        attrs[attr->nameID] = attr;
+#if DUMP_UNIFORMS
+        wkLog("%s Attribute %d/%d, name=%d, idx=%d, %s", inName.c_str(), ii, numAttr, attr->nameID, attr->index, thingName);
+#endif
+    }
+    CheckGLError("ProgramGLES: glGetActiveAttrib");
+}
+    
+bool ProgramGLES::buildFromSource(const std::string &vShaderString,const std::string &fShaderString,
+                                  const std::vector<std::string> *varying,bool retrievable)
+{
     if (!compileShader(name,"vertex",&vertShader,GL_VERTEX_SHADER,vShaderString))
     {
-        cleanUp();
-        return;
+        return false;
     }
     CheckGLError("ProgramGLES: compileShader() vertex");
     if (!compileShader(name,"fragment",&fragShader,GL_FRAGMENT_SHADER,fShaderString))
     {
-        cleanUp();
-        return;
+        return false;
     }
     CheckGLError("ProgramGLES: compileShader() fragment");
 
@@ -379,6 +570,13 @@ ProgramGLES::ProgramGLES(const std::string &inName,const std::string &vShaderStr
         }
     }
     
+    // Ask for a binary we can read back, before linking
+    if (retrievable)
+    {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        CheckGLError("ProgramGLES: glProgramParameteri");
+    }
+
     // Now link it
     GLint status;
     glLinkProgram(program);
@@ -395,8 +593,7 @@ ProgramGLES::ProgramGLES(const std::string &inName,const std::string &vShaderStr
             glGetProgramInfoLog(program, len, &len, &logStr[0]);
             wkLogLevel(Error,"Link error for shader program %s:\n%s",name.c_str(),&logStr[0]);
         }
-        cleanUp();
-        return;
+        return false;
     }
 
     if (vertShader)
@@ -409,45 +606,10 @@ ProgramGLES::ProgramGLES(const std::string &inName,const std::string &vShaderStr
         glDeleteShader(fragShader);
         fragShader = 0;
     }
-    
-    // Convert the uniforms into a more friendly form
-    GLint numUniform;
-    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &numUniform);
-    char thingName[1024];
-    for (unsigned int ii=0;ii<numUniform;ii++)
-    {
-        auto uni = std::make_shared<OpenGLESUniform>();
-        GLint bufLen;
-        thingName[0] = 0;
-        glGetActiveUniform(program, ii, sizeof(thingName)-1, &bufLen, &uni->size, &uni->type, thingName);
-        uni->nameID = StringIndexer::getStringID(thingName);
-        uni->index = glGetUniformLocation(program, thingName);
-        uniforms[uni->nameID] = uni;
-#if DUMP_UNIFORMS
-        wkLog("%s Uniform %d/%d, name=%d, idx=%d, %s", inName.c_str(), ii, numUniform, uni->nameID, uni->index, thingName);
-#endif
-    }
-    CheckGLError("ProgramGLES: glGetActiveUniform");
 
-    // Convert the attributes into a more useful form
-    GLint numAttr;
-    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &numAttr);
-    for (unsigned int ii=0;ii<numAttr;ii++)
-    {
-        auto attr = std::make_shared<OpenGLESAttribute>();
-        GLint bufLen;
-        thingName[0] = 0;
-        glGetActiveAttrib(program, ii, sizeof(thingName)-1, &bufLen, &attr->size, &attr->type, thingName);
-        attr->index = glGetAttribLocation(program, thingName);
-        attr->nameID = StringIndexer::getStringID(thingName);
-        attrs[attr->nameID] = attr;
-#if DUMP_UNIFORMS
-        wkLog("%s Attribute %d/%d, name=%d, idx=%d, %s", inName.c_str(), ii, numAttr, attr->nameID, attr->index, thingName);
-#endif
-    }
-    CheckGLError("ProgramGLES: glGetActiveAttrib");
+    return true;
 }
-    
+
 void ProgramGLES::teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene,RenderTeardownInfoRef teardown)
 {
     cleanUp();
@@ -547,7 +709,7 @@ bool ProgramGLES::setLights(const std::vector<DirectionalLight> &lights, TimeInt
     return lightsSet;
 }
 
-int ProgramGLES::bindTextures()
+int ProgramGLES::bindTextures(StateCacheGLES *stateCache)
 {
     int numTextures = 0;
     
@@ -555,8 +717,7 @@ int ProgramGLES::bindTextures()
     {
         if (uni.second->isTexture)
         {
-            glActiveTexture(GL_TEXTURE0+numTextures);
-            glBindTexture(GL_TEXTURE_2D, uni.second->val.iVals[0]);
+            stateCache->bindTexture(numTextures, uni.second->val.iVals[0]);
             glUniform1i(uni.second->index,numTextures);
             numTextures++;
         }
@@ -26,26 +26,130 @@
 namespace WhirlyKit
 {
 
+namespace
+{
+// Last few coordinate systems the thread used, so it doesn't have to look up its projections every time
+struct ProjCacheEntry
+{
+    uint64_t cacheID = 0;
+    const void *projSet = nullptr;
+};
+static constexpr int ProjCacheSize = 4;
+thread_local ProjCacheEntry projCache[ProjCacheSize];
+thread_local int projCacheNext = 0;
+
+std::atomic<uint64_t> nextCacheID(1);
+
+// Run a batch through proj.4 in place.  Points that fail are zeroed, and flagged if asked.
+void ProjTransform(void *src,void *dst,Point3d *pts,size_t count,std::vector<bool> *failed,const char *what)
+{
+    if (failed)
+        failed->assign(count,false);
+    if (count == 0)
+        return;
+
+    // Proj.4 gives up on the whole batch for some errors, so keep the inputs around to go one by one
+    thread_local std::vector<Point3d> orig;
+    orig.assign(pts,pts+count);
+
+    // A run of Point3d is packed doubles, so proj.4 can step through it
+    const int result = pj_transform(src, dst, (long)count, 3, &pts->x(), &pts->y(), &pts->z());
+    if (result != 0)
+    {
+        bool logged = false;
+        for (size_t ii=0;ii<count;ii++)
+        {
+            Point3d &pt = pts[ii];
+            pt = orig[ii];
+            const int ptResult = pj_transform(src, dst, 1, 1, &pt.x(), &pt.y(), &pt.z());
+            if (ptResult != 0)
+            {
+                if (ptResult != PJ_ERR_BOUNDS && !logged)
+                {
+                    wkLogLevel(Debug, "Proj4CoordSystem::%s error (%d) converting %f,%f,%f",
+                               what,ptResult,orig[ii].x(),orig[ii].y(),orig[ii].z());
+                    logged = true;
+                }
+                pt.x() = HUGE_VAL;
+            }
+        }
+    }
+
+    // Points proj.4 couldn't do come back as HUGE_VAL
+    for (size_t ii=0;ii<count;ii++)
+    {
+        Point3d &pt = pts[ii];
+        if (pt.x() == HUGE_VAL || pt.y() == HUGE_VAL)
+        {
+            pt = Point3d(0,0,0);
+            if (failed)
+                (*failed)[ii] = true;
+        }
+    }
+}
+}
+
+Proj4CoordSystem::ProjSet::ProjSet(const std::string &proj4Str)
+{
+    ctx = pj_ctx_alloc();
+    pj = pj_init_plus_ctx(ctx, proj4Str.c_str());
+    pj_latlon = pj_init_plus_ctx(ctx, "+proj=latlong +datum=WGS84");
+    pj_geocentric = pj_init_plus_ctx(ctx, "+proj=geocent +datum=WGS84");
+}
+
+Proj4CoordSystem::ProjSet::~ProjSet()
+{
+    if (pj)
+        pj_free(pj);
+    if (pj_latlon)
+        pj_free(pj_latlon);
+    if (pj_geocentric)
+        pj_free(pj_geocentric);
+    pj_ctx_free(ctx);
+}
+
 Proj4CoordSystem::Proj4CoordSystem(const std::string &proj4Str)
-: proj4Str(proj4Str)
+: proj4Str(proj4Str), valid(false), cacheID(nextCacheID++)
 {
-    pj = pj_init_plus(proj4Str.c_str());
-    pj_latlon = pj_init_plus("+proj=latlong +datum=WGS84");
-    pj_geocentric = pj_init_plus("+proj=geocent +datum=WGS84");
+    valid = getProj().pj != nullptr;
 }
     
 Proj4CoordSystem::~Proj4CoordSystem()
 {
-    pj_free(pj);
-    pj_free(pj_latlon);
-    pj_free(pj_geocentric);
+}
+
+const Proj4CoordSystem::ProjSet &Proj4CoordSystem::getProj() const
+{
+    for (const auto &entry : projCache)
+    {
+        if (entry.cacheID == cacheID)
+            return *(const ProjSet *)entry.projSet;
+    }
+
+    // Proj.4 objects can't be used from more than one thread at once, so each thread gets its own
+    const ProjSet *projSet = nullptr;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        auto &entry = projSets[std::this_thread::get_id()];
+        if (!entry)
+            entry = std::make_unique<ProjSet>(proj4Str);
+        projSet = entry.get();
+    }
+
+    auto &entry = projCache[projCacheNext];
+    projCacheNext = (projCacheNext + 1) % ProjCacheSize;
+    entry.cacheID = cacheID;
+    entry.projSet = projSet;
+
+    return *projSet;
 }
 
 /// Convert from the local coordinate system to lat/lon
 GeoCoord Proj4CoordSystem::localToGeographic(Point3f pt) const
 {
+    const auto &proj = getProj();
     double x = pt.x(),y = pt.y(),z = pt.z();
-    const auto result = pj_transform(pj, pj_latlon, 1, 1, &x, &y, &z);
+    const auto result = pj_transform(proj.pj, proj.pj_latlon, 1, 1, &x, &y, &z);
     if (result != 0) {
         if (result != PJ_ERR_BOUNDS) {
             wkLogLevel(Debug, "Proj4CoordSystem::localToGeographic error (%d) converting to geographic %f,%f,%f",
@@ -58,8 +162,9 @@ GeoCoord Proj4CoordSystem::localToGeographic(Point3f pt) const
 
 GeoCoord Proj4CoordSystem::localToGeographic(Point3d pt) const
 {
+    const auto &proj = getProj();
     double x = pt.x(),y = pt.y(),z = pt.z();
-    const auto result = pj_transform(pj, pj_latlon, 1, 1, &x, &y, &z);
+    const auto result = pj_transform(proj.pj, proj.pj_latlon, 1, 1, &x, &y, &z);
     if (result != 0) {
         if (result != PJ_ERR_BOUNDS) {
             wkLogLevel(Debug, "Proj4CoordSystem::localToGeographic error (%d) converting to geographic %f,%f,%f",
@@ -72,8 +177,9 @@ GeoCoord Proj4CoordSystem::localToGeographic(Point3d pt) const
 
 Point2d Proj4CoordSystem::localToGeographicD(Point3d pt) const
 {
+    const auto &proj = getProj();
     double x = pt.x(),y = pt.y(),z = pt.z();
-    const auto result = pj_transform(pj, pj_latlon, 1, 1, &x, &y, &z);
+    const auto result = pj_transform(proj.pj, proj.pj_latlon, 1, 1, &x, &y, &z);
     if (result != 0) {
         if (result != PJ_ERR_BOUNDS) {
             wkLogLevel(Debug, "Proj4CoordSystem::localToGeographicD error (%d) converting to geographic %f,%f,%f",
@@ -87,8 +193,9 @@ Point2d Proj4CoordSystem::localToGeographicD(Point3d pt) const
 /// Convert from lat/lon t the local coordinate system
 Point3f Proj4CoordSystem::geographicToLocal(GeoCoord geo) const
 {
+    const auto &proj = getProj();
     double x = geo.x(),y = geo.y(),z = 0.0;
-    const auto result = pj_transform(pj_latlon, pj, 1, 1, &x, &y, &z);
+    const auto result = pj_transform(proj.pj_latlon, proj.pj, 1, 1, &x, &y, &z);
     if (result != 0) {
         if (result != PJ_ERR_BOUNDS) {
             wkLogLevel(Debug, "Proj4CoordSystem::geographicToLocal error (%d) converting from geographic %f,%f",
@@ -101,8 +208,9 @@ Point3f Proj4CoordSystem::geographicToLocal(GeoCoord geo) const
 
 Point3d Proj4CoordSystem::geographicToLocal3d(GeoCoord geo) const
 {
+    const auto &proj = getProj();
     double x = geo.x(),y = geo.y(),z = 0.0;
-    const auto result = pj_transform(pj_latlon, pj, 1, 1, &x, &y, &z);
+    const auto result = pj_transform(proj.pj_latlon, proj.pj, 1, 1, &x, &y, &z);
     if (result != 0) {
         if (result != PJ_ERR_BOUNDS) {
             wkLogLevel(Debug, "Proj4CoordSystem::geographicToLocal3d error (%d) converting from geographic %f,%f",
@@ -115,8 +223,9 @@ Point3d Proj4CoordSystem::geographicToLocal3d(GeoCoord geo) const
 
 Point3d Proj4CoordSystem::geographicToLocal(Point2d geo) const
 {
+    const auto &proj = getProj();
     double x = geo.x(),y = geo.y(),z = 0.0;
-    const auto result = pj_transform(pj_latlon, pj, 1, 1, &x, &y, &z);
+    const auto result = pj_transform(proj.pj_latlon, proj.pj, 1, 1, &x, &y, &z);
     if (result != 0) {
         if (result != PJ_ERR_BOUNDS) {
             wkLogLevel(Debug, "Proj4CoordSystem::geographicToLocal error (%d) converting from geographic %f,%f",
@@ -129,8 +238,9 @@ Point3d Proj4CoordSystem::geographicToLocal(Point2d geo) const
 
 Point2d Proj4CoordSystem::geographicToLocal2(const Point2d &geo) const
 {
+    const auto &proj = getProj();
     double x = geo.x(),y = geo.y(),z = 0.0;
-    const auto result = pj_transform(pj_latlon, pj, 1, 1, &x, &y, &z);
+    const auto result = pj_transform(proj.pj_latlon, proj.pj, 1, 1, &x, &y, &z);
     if (result != 0) {
         if (result != PJ_ERR_BOUNDS) {
             wkLogLevel(Debug, "Proj4CoordSystem::geographicToLocal error (%d) converting from geographic %f,%f",
@@ -144,8 +254,9 @@ Point2d Proj4CoordSystem::geographicToLocal2(const Point2d &geo) const
 /// Convert from the local coordinate system to geocentric
 Point3f Proj4CoordSystem::localToGeocentric(Point3f localPt) const
 {
+    const auto &proj = getProj();
     double x = localPt.x(),y = localPt.y(),z = localPt.z();
-    const auto result = pj_transform(pj, pj_geocentric, 1, 1, &x, &y, &z);
+    const auto result = pj_transform(proj.pj, proj.pj_geocentric, 1, 1, &x, &y, &z);
     if (result != 0) {
         if (result != PJ_ERR_BOUNDS) {
             wkLogLevel(Debug, "Proj4CoordSystem::localToGeocentric error (%d) converting to geocentric %f,%f,%f",
@@ -158,8 +269,9 @@ Point3f Proj4CoordSystem::localToGeocentric(Point3f localPt) const
 
 Point3d Proj4CoordSystem::localToGeocentric(Point3d localPt) const
 {
+    const auto &proj = getProj();
     double x = localPt.x(),y = localPt.y(),z = localPt.z();
-    const auto result = pj_transform(pj, pj_geocentric, 1, 1, &x, &y, &z);
+    const auto result = pj_transform(proj.pj, proj.pj_geocentric, 1, 1, &x, &y, &z);
     if (result != 0) {
         if (result != PJ_ERR_BOUNDS) {
             wkLogLevel(Debug, "Proj4CoordSystem::localToGeocentric error (%d) converting to geocentric %f,%f,%f",
@@ -173,8 +285,9 @@ Point3d Proj4CoordSystem::localToGeocentric(Point3d localPt) const
 /// Convert from display coordinates to geocentric
 Point3f Proj4CoordSystem::geocentricToLocal(Point3f geocPt) const
 {
+    const auto &proj = getProj();
     double x = geocPt.x(),y = geocPt.y(),z = geocPt.z();
-    const auto result = pj_transform(pj_geocentric, pj, 1, 1, &x, &y, &z);
+    const auto result = pj_transform(proj.pj_geocentric, proj.pj, 1, 1, &x, &y, &z);
     if (result != 0) {
         if (result != PJ_ERR_BOUNDS) {
             wkLogLevel(Debug, "Proj4CoordSystem::geocentricToLocal error (%d) converting from geocentric %f,%f,%f",
@@ -187,8 +300,9 @@ Point3f Proj4CoordSystem::geocentricToLocal(Point3f geocPt) const
 
 Point3d Proj4CoordSystem::geocentricToLocal(Point3d geocPt) const
 {
+    const auto &proj = getProj();
     double x = geocPt.x(),y = geocPt.y(),z = geocPt.z();
-    const auto result = pj_transform(pj_geocentric, pj, 1, 1, &x, &y, &z);
+    const auto result = pj_transform(proj.pj_geocentric, proj.pj, 1, 1, &x, &y, &z);
     if (result != 0) {
         if (result != PJ_ERR_BOUNDS) {
             wkLogLevel(Debug, "Proj4CoordSystem::geocentricToLocal error (%d) converting from geocentric %f,%f,%f",
@@ -205,4 +319,135 @@ bool Proj4CoordSystem::isSameAs(const CoordSystem *coordSys) const
     return other && proj4Str == other->proj4Str;
 }
 
+void Proj4CoordSystem::geographicToLocalBatch(const Point2d *geo,Point3d *local,size_t count) const
+{
+    const auto &proj = getProj();
+    for (size_t ii=0;ii<count;ii++)
+        local[ii] = Point3d(geo[ii].x(),geo[ii].y(),0.0);
+    ProjTransform(proj.pj_latlon, proj.pj, local, count, nullptr, "geographicToLocalBatch");
+}
+
+void Proj4CoordSystem::localToGeographicProj(const Point3d *local,Point2d *geo,size_t count,std::vector<bool> *failed) const
+{
+    const auto &proj = getProj();
+    thread_local std::vector<Point3d> pts;
+    pts.assign(local,local+count);
+    ProjTransform(proj.pj, proj.pj_latlon, pts.data(), count, failed, "localToGeographicBatch");
+    for (size_t ii=0;ii<count;ii++)
+        geo[ii] = Point2d(pts[ii].x(),pts[ii].y());
+}
+
+void Proj4CoordSystem::localToGeographicBatch(const Point3d *local,Point2d *geo,size_t count) const
+{
+    const auto grid = std::atomic_load(&approxGrid);
+    if (!grid)
+    {
+        localToGeographicProj(local,geo,count,nullptr);
+        return;
+    }
+
+    // Interpolate what we can and send the rest through proj.4 together
+    std::vector<size_t> misses;
+    std::vector<Point3d> missPts;
+    for (size_t ii=0;ii<count;ii++)
+    {
+        if (!grid->interpolate(local[ii],geo[ii]))
+        {
+            misses.push_back(ii);
+            missPts.push_back(local[ii]);
+        }
+    }
+    if (misses.empty())
+        return;
+
+    std::vector<Point2d> missGeo(misses.size());
+    localToGeographicProj(missPts.data(),missGeo.data(),misses.size(),nullptr);
+    for (size_t ii=0;ii<misses.size();ii++)
+        geo[misses[ii]] = missGeo[ii];
+}
+
+void Proj4CoordSystem::localToGeocentricBatch(const Point3d *local,Point3d *geoc,size_t count) const
+{
+    const auto &proj = getProj();
+    if (std::atomic_load(&approxGrid))
+    {
+        // Going by way of geographic lets the grid do the hard part
+        std::vector<Point2d> geo(count);
+        localToGeographicBatch(local,geo.data(),count);
+        for (size_t ii=0;ii<count;ii++)
+            geoc[ii] = Point3d(geo[ii].x(),geo[ii].y(),local[ii].z());
+        ProjTransform(proj.pj_latlon, proj.pj_geocentric, geoc, count, nullptr, "localToGeocentricBatch");
+        return;
+    }
+
+    std::copy(local,local+count,geoc);
+    ProjTransform(proj.pj, proj.pj_geocentric, geoc, count, nullptr, "localToGeocentricBatch");
+}
+
+void Proj4CoordSystem::geocentricToLocalBatch(const Point3d *geoc,Point3d *local,size_t count) const
+{
+    const auto &proj = getProj();
+    std::copy(geoc,geoc+count,local);
+    ProjTransform(proj.pj_geocentric, proj.pj, local, count, nullptr, "geocentricToLocalBatch");
+}
+
+void Proj4CoordSystem::setApproxGrid(const MbrD &localBounds,int cellsX,int cellsY)
+{
+    if (cellsX <= 0 || cellsY <= 0 || !localBounds.valid())
+    {
+        std::atomic_store(&approxGrid,std::shared_ptr<const ApproxGrid>());
+        return;
+    }
+
+    auto grid = std::make_shared<ApproxGrid>();
+    grid->bounds = localBounds;
+    grid->cellsX = cellsX;
+    grid->cellsY = cellsY;
+    grid->cellSize = Point2d(localBounds.span().x() / cellsX,localBounds.span().y() / cellsY);
+
+    std::vector<Point3d> samples;
+    samples.reserve((cellsX+1)*(cellsY+1));
+    for (int iy=0;iy<=cellsY;iy++)
+        for (int ix=0;ix<=cellsX;ix++)
+            samples.emplace_back(localBounds.ll().x() + ix * grid->cellSize.x(),
+                                 localBounds.ll().y() + iy * grid->cellSize.y(), 0.0);
+
+    // Samples proj.4 can't do leave holes in the grid, which fall back to proj.4 later
+    std::vector<bool> failed;
+    grid->geo.resize(samples.size());
+    localToGeographicProj(samples.data(),grid->geo.data(),samples.size(),&failed);
+    for (size_t ii=0;ii<samples.size();ii++)
+        if (failed[ii])
+            grid->geo[ii] = Point2d(NAN,NAN);
+
+    std::atomic_store(&approxGrid,std::shared_ptr<const ApproxGrid>(grid));
+}
+
+bool Proj4CoordSystem::ApproxGrid::interpolate(const Point3d &local,Point2d &outGeo) const
+{
+    const double fx = (local.x() - bounds.ll().x()) / cellSize.x();
+    const double fy = (local.y() - bounds.ll().y()) / cellSize.y();
+    if (!(fx >= 0.0 && fx <= cellsX && fy >= 0.0 && fy <= cellsY))
+        return false;
+
+    const int ix = std::min((int)fx,cellsX-1);
+    const int iy = std::min((int)fy,cellsY-1);
+    const Point2d &g00 = geo[iy*(cellsX+1)+ix];
+    const Point2d &g10 = geo[iy*(cellsX+1)+ix+1];
+    const Point2d &g01 = geo[(iy+1)*(cellsX+1)+ix];
+    const Point2d &g11 = geo[(iy+1)*(cellsX+1)+ix+1];
+    if (std::isnan(g00.x()) || std::isnan(g10.x()) || std::isnan(g01.x()) || std::isnan(g11.x()))
+        return false;
+
+    // Cells straddling the date line would interpolate the long way around
+    const double minLon = std::min(std::min(g00.x(),g10.x()),std::min(g01.x(),g11.x()));
+    const double maxLon = std::max(std::max(g00.x(),g10.x()),std::max(g01.x(),g11.x()));
+    if (maxLon - minLon > M_PI)
+        return false;
+
+    const double tx = fx - ix, ty = fy - iy;
+    outGeo = (g00 * (1.0-tx) + g10 * tx) * (1.0-ty) + (g01 * (1.0-tx) + g11 * tx) * ty;
+    return true;
+}
+
 }
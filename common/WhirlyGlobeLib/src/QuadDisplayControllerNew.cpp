@@ -17,6 +17,7 @@
  */
 
 #import "QuadDisplayControllerNew.h"
+#import "MaplyView.h"
 
 namespace WhirlyKit
 {
@@ -148,16 +149,60 @@ int QuadDisplayControllerNew::getZoomSlot() const
     return zoomSlot;
 }
     
+// Roughly how much the screen size of a tile could change between two views.
+// Negative if we can't tell.
+static double CalcViewDelta(const ViewStateRef &oldView,const ViewStateRef &newView)
+{
+    if (!oldView || !newView)
+    {
+        return -1.0;
+    }
+
+    double height = -1.0;
+    if (const auto globeViewState = dynamic_cast<WhirlyGlobe::GlobeViewState*>(newView.get()))
+    {
+        height = globeViewState->heightAboveGlobe;
+    }
+    else if (const auto mapViewState = dynamic_cast<Maply::MapViewState*>(newView.get()))
+    {
+        height = mapViewState->heightAboveSurface;
+    }
+    if (height <= 0.0 || newView->fieldOfView <= 0.0 || oldView->fieldOfView <= 0.0)
+    {
+        return -1.0;
+    }
+
+    // Eye movement relative to how far we are from the surface
+    const double moveDelta = (newView->eyePos - oldView->eyePos).norm() / height;
+
+    // Rotation as a fraction of the field of view
+    const double cosAng = newView->eyeVec.normalized().dot(oldView->eyeVec.normalized());
+    const double rotDelta = std::acos(std::min(std::max(cosAng,-1.0),1.0)) / newView->fieldOfView;
+
+    const double fovDelta = std::abs(newView->fieldOfView / oldView->fieldOfView - 1.0);
+
+    return moveDelta + rotDelta + fovDelta;
+}
+
 // Called on the LayerThread
 void QuadDisplayControllerNew::start()
 {
     loader->setController(this);
+    if (useMemoryBudget)
+    {
+        memClientID = TileMemoryManager::getShared().addClient();
+    }
     running = true;
 }
 
 void QuadDisplayControllerNew::stop(PlatformThreadInfo *threadInfo,ChangeSet &changes)
 {
     running = false;
+    if (memClientID >= 0)
+    {
+        TileMemoryManager::getShared().removeClient(memClientID);
+        memClientID = -1;
+    }
     scene->releaseZoomSlot(zoomSlot);
     loader->quadLoaderShutdown(threadInfo,changes);
     dataStructure = nullptr;
@@ -194,22 +239,36 @@ bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,const V
         }
     }
 
-    // Nodes to load are different for single level vs regular loading
+    // Let the quad tree know how far we've moved so it can reuse what it can
+    if (incremental)
+    {
+        const Point2f frameSize = renderer->getFramebufferSize();
+        const bool sameFrame = frameSize == lastFrameSize;
+        startCoveragePass(sameFrame ? CalcViewDelta(lastCoverageView, viewState) : -1.0);
+        lastCoverageView = viewState;
+        lastFrameSize = frameSize;
+    }
+
     QuadTreeNew::ImportantNodeSet newNodes;
     int targetLevel = -1;
     std::vector<double> maxRejectedImport(std::max(reportedMaxZoom, maxLevel) + 1,0.0);
-    if (singleLevel)
-    {
-        std::tie(targetLevel,newNodes) = calcCoverageVisible(minImportancePerLevel, maxTiles, levelLoads, localKeepMinLevel, maxRejectedImport);
-    }
-    else
-    {
-        newNodes = calcCoverageImportance(minImportancePerLevel,maxTiles,true, maxRejectedImport);
+    std::tie(targetLevel,newNodes) = calcCoverage(maxTiles, localKeepMinLevel, maxRejectedImport);
 
-        // Just take the highest level as target
+    // Tell the memory manager what we'd like and back off if that's more than we get
+    if (memClientID >= 0)
+    {
+        std::vector<double> wantedImports;
+        wantedImports.reserve(newNodes.size());
         for (const auto &node : newNodes)
         {
-            targetLevel = std::max(targetLevel,node.level);
+            wantedImports.push_back(node.importance);
+        }
+        memTileLimit = TileMemoryManager::getShared().updateClient(memClientID, std::move(wantedImports),
+                                                                   loader->quadLoaderMemoryUsage());
+        if (memTileLimit >= 0 && memTileLimit < (int)newNodes.size())
+        {
+            std::fill(maxRejectedImport.begin(), maxRejectedImport.end(), 0.0);
+            std::tie(targetLevel,newNodes) = calcCoverage(memTileLimit, localKeepMinLevel, maxRejectedImport);
         }
     }
 
@@ -227,45 +286,15 @@ bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,const V
     
     QuadTreeNew::ImportantNodeSet toAdd,toUpdate;
     QuadTreeNew::NodeSet toRemove;
-    
-    // Need a version of new and old that has no importance values, since those change
-    QuadTreeNew::NodeSet testNewNodes;
-    for (const auto &node : newNodes)
-    {
-        testNewNodes.insert(node);
-    }
-
-    QuadTreeNew::NodeSet testCurrentNodes;
-    for (const auto &node : currentNodes)
-    {
-        testCurrentNodes.insert(node);
-    }
-    
-    // Nodes to remove
-    for (const auto &node : currentNodes)
-    {
-        if (testNewNodes.find(node) == testNewNodes.end())
-        {
-            toRemove.insert(node);
-        }
-    }
-
-    // Nodes to add and nodes to update importance for
-    for (const auto &node : newNodes)
-    {
-        if (testCurrentNodes.find(node) == testCurrentNodes.end())
-        {
-            toAdd.insert(node);
-        }
-        else
-        {
-            toUpdate.insert(node);
-        }
-    }
+    diffNodes(currentNodes, newNodes, toAdd, toUpdate, toRemove);
     
     const QuadTreeNew::NodeSet removesToKeep =
         loader->quadLoaderUpdate(threadInfo, toAdd, toRemove, toUpdate, targetLevel, changes);
 
+    // First tiles for the view have been asked for
+    if (!toAdd.empty() && !renderer->getStartupTimeline().isDone())
+        renderer->getStartupTimeline().mark("first tiles requested");
+
     const bool needsDelayCheck = !removesToKeep.empty();
     
     currentNodes = newNodes;
@@ -308,8 +337,73 @@ bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,const V
         }
     }
 
+    if (prefetch && viewState->predictedState)
+    {
+        prefetchPredicted(threadInfo, viewState->predictedState, localKeepMinLevel);
+    }
+
     return needsDelayCheck;
 }
+
+std::tuple<int,QuadTreeNew::ImportantNodeSet> QuadDisplayControllerNew::calcCoverage(int maxNodes,bool localKeepMinLevel,
+                                                                                  std::vector<double> &maxRejectedImport)
+{
+    // Nodes to load are different for single level vs regular loading
+    if (singleLevel)
+    {
+        return calcCoverageVisible(minImportancePerLevel, maxNodes, levelLoads, localKeepMinLevel, maxRejectedImport);
+    }
+
+    auto nodes = calcCoverageImportance(minImportancePerLevel, maxNodes, true, maxRejectedImport);
+
+    // Just take the highest level as target
+    int targetLevel = -1;
+    for (const auto &node : nodes)
+    {
+        targetLevel = std::max(targetLevel,node.level);
+    }
+
+    return std::make_tuple(targetLevel,std::move(nodes));
+}
+
+void QuadDisplayControllerNew::prefetchPredicted(PlatformThreadInfo *threadInfo,const ViewStateRef &predictedState,bool localKeepMinLevel)
+{
+    // Still headed to the same place
+    if (lastPrefetchView && lastPrefetchView->isSameAs(predictedState.get()))
+    {
+        return;
+    }
+    lastPrefetchView = predictedState;
+
+    // Evaluate against the predicted view, leaving the importance cache alone
+    const ViewStateRef curViewState = viewState;
+    const bool wasIncremental = incremental;
+    viewState = predictedState;
+    incremental = false;
+
+    QuadTreeNew::ImportantNodeSet predictedNodes;
+    std::vector<double> maxRejectedImport(std::max(reportedMaxZoom, maxLevel) + 1,0.0);
+    const int maxNodes = (memTileLimit >= 0) ? std::min(maxTiles, memTileLimit) : maxTiles;
+    std::tie(std::ignore,predictedNodes) = calcCoverage(maxNodes, localKeepMinLevel, maxRejectedImport);
+
+    viewState = curViewState;
+    incremental = wasIncremental;
+
+    if (!running)
+    {
+        return;
+    }
+
+    // Only the ones we're not already loading
+    QuadTreeNew::ImportantNodeSet toFetch,toUpdate;
+    QuadTreeNew::NodeSet toRemove;
+    diffNodes(currentNodes, predictedNodes, toFetch, toUpdate, toRemove);
+
+    if (!toFetch.empty())
+    {
+        loader->quadLoaderPrefetch(threadInfo, toFetch);
+    }
+}
     
 void QuadDisplayControllerNew::preSceneFlush(ChangeSet &changes)
 {
@@ -338,6 +432,42 @@ double QuadDisplayControllerNew::importance(const Node &node)
     return dataStructure->importanceForTile(ident, nodeMbr, viewState, renderer->getFramebufferSize());
 }
 
+// Calculate importance for a group of nodes together
+void QuadDisplayControllerNew::batchImportance(const std::vector<Node> &nodes,std::vector<double> &imports)
+{
+    imports.assign(nodes.size(),-1.0);
+
+    std::vector<QuadTreeIdentifier> idents;
+    std::vector<Mbr> mbrs;
+    std::vector<size_t> which;
+    idents.reserve(nodes.size());
+    mbrs.reserve(nodes.size());
+    which.reserve(nodes.size());
+    for (size_t ii=0;ii<nodes.size();ii++)
+    {
+        const Node &node = nodes[ii];
+        MbrD nodeMbrD = generateMbrForNode(node);
+        if (mbrScaling != 1.0)
+            nodeMbrD.expandByFraction(mbrScaling-1.0);
+
+        // Invalid tiles keep the -1
+        const Mbr nodeMbr(nodeMbrD);
+        if (!nodeMbr.inside(nodeMbr.mid()))
+            continue;
+
+        idents.emplace_back(node.x, node.y, node.level);
+        mbrs.push_back(nodeMbr);
+        which.push_back(ii);
+    }
+    if (idents.empty())
+        return;
+
+    std::vector<double> validImports;
+    dataStructure->importanceForTiles(idents, mbrs, viewState, renderer->getFramebufferSize(), validImports);
+    for (size_t ii=0;ii<which.size();ii++)
+        imports[which[ii]] = validImports[ii];
+}
+
 // Pure visibility check
 bool QuadDisplayControllerNew::visible(const Node &node) {
     MbrD nodeMbrD = generateMbrForNode(node);
@@ -17,16 +17,42 @@
  */
 
 #import "QuadImageFrameLoader.h"
+#import "TileReprojector.h"
 #import "WhirlyKitLog.h"
+#import "FlatMath.h"
+#import "StableBytes.h"
 
 namespace WhirlyKit
 {
 
+// Runs with the rest of a tile's changes, so the renderer tells us when the tile is about to be drawn
+class TileDisplayedReq : public ChangeRequest
+{
+public:
+    TileDisplayedReq(const TileLatencyStatsRef &stats,int64_t nodeNumber) :
+        stats(stats), nodeNumber(nodeNumber) { }
+
+    virtual void execute(Scene *scene,SceneRenderer *renderer,View *view) override
+    {
+        if (const auto theStats = stats.lock())
+            theStats->mark(nodeNumber,TileLatencyStats::Displayed,TimeGetCurrent());
+    }
+
+protected:
+    std::weak_ptr<TileLatencyStats> stats;
+    int64_t nodeNumber;
+};
+
 QIFFrameAsset::QIFFrameAsset(QuadFrameInfoRef frameInfo) :
     frameInfo(std::move(frameInfo)),
     state(Empty),
     priority(0),
     importance(0.0),
+    generation(0),
+    reloading(false),
+    dataHash(0),
+    pendingDataHash(0),
+    texBytes(0),
     loadReturnSet(false)
 {
 
@@ -35,6 +61,7 @@ QIFFrameAsset::QIFFrameAsset(QuadFrameInfoRef frameInfo) :
 void QIFFrameAsset::setupFetch(QuadImageFrameLoader *loader)
 {
     state = Loading;
+    generation = loader->getGeneration();
 }
 
 void QIFFrameAsset::clear(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader,QIFBatchOps *batchOps,ChangeSet &changes)
@@ -54,6 +81,10 @@ void QIFFrameAsset::clear(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *l
         changes.push_back(new RemTextureReq(texID));
     }
     texIDs.clear();
+    texBytes = 0;
+    reloading = false;
+    dataHash = 0;
+    pendingDataHash = 0;
 }
 
 bool QIFFrameAsset::updateFetching(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader,int newPriority,double newImportance)
@@ -74,14 +105,24 @@ void QIFFrameAsset::cancelFetch(PlatformThreadInfo *threadInfo,QuadImageFrameLoa
 void QIFFrameAsset::loadSuccess(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader,const std::vector<Texture *> &texs)
 {
     state = Loaded;
+    reloading = false;
+    dataHash = pendingDataHash;
+    pendingDataHash = 0;
     texIDs.clear();
+    texBytes = 0;
     for (auto tex : texs)
+    {
         texIDs.push_back(tex->getId());
+        texBytes += tex->texData ? tex->texData->getLen() : (size_t)tex->getWidth() * tex->getHeight() * 4;
+    }
 }
 
 void QIFFrameAsset::loadFailed(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader)
 {
-    state = Empty;
+    // A failed reload leaves what we had up
+    state = (reloading && !texIDs.empty()) ? Loaded : Empty;
+    reloading = false;
+    pendingDataHash = 0;
 }
     
 void QIFFrameAsset::loadSkipped()
@@ -90,6 +131,13 @@ void QIFFrameAsset::loadSkipped()
     state = Loaded;
 }
 
+void QIFFrameAsset::loadUnchanged(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader)
+{
+    state = Loaded;
+    reloading = false;
+    pendingDataHash = 0;
+}
+
 void QIFFrameAsset::setLoadReturn(RawDataRef data)
 {
     loadReturn = std::move(data);
@@ -327,7 +375,9 @@ bool QIFTileAsset::frameLoaded(PlatformThreadInfo *threadInfo,
     }
     
     // Check the generation.  This is how we catch old data that was in transit.
-    if (loadReturn->generation < loader->getGeneration()) {
+    // In-place reloads leave some tiles fetching, so those go by when their own fetch started.
+    const int minGeneration = (frame && loader->getReloadInPlace()) ? frame->getGeneration() : loader->getGeneration();
+    if (loadReturn->generation < minGeneration) {
         if (!loadReturn->compObjs.empty())
         {
             loader->compManager->removeComponentObjects(threadInfo,loadReturn->compObjs, changes);
@@ -360,10 +410,21 @@ bool QIFTileAsset::frameLoaded(PlatformThreadInfo *threadInfo,
         ovlCompObjs.insert(ovlCompObj->getId());
     loadReturn->ovlCompObjs.clear();
     
+    // Warp the images to line up with the display, leaving elevation alone
+    ChangeSet warpChanges;
+    const bool isElev = loader->getTerrain() && frame && frame->getFrameInfo() && frame->getFrameInfo()->frameIndex == 1;
+    if (loader->getReprojectSamples() > 0 && !texs.empty() && !isElev)
+        loader->reprojectTextures(ident,texs,warpChanges);
+
+    // Replacing a texture that's still showing, so the new one has to be in before the swap
+    const bool replacing = frame && frame->isReloading();
+
     if (frame) {
         // Clear out the old texture if it's there
         // Happens in the reload case
-        if (!frame->getTexIDs().empty()) {
+        if (replacing) {
+            loader->retireTextures(frame->getTexIDs());
+        } else if (!frame->getTexIDs().empty()) {
             for (auto texID : frame->getTexIDs())
                 changes.push_back(new RemTextureReq(texID));
         }
@@ -388,8 +449,11 @@ bool QIFTileAsset::frameLoaded(PlatformThreadInfo *threadInfo,
     }
     
     if (!texs.empty()) {
-        for (auto tex : texs)
+        for (auto tex : texs) {
+            tex->setAsyncUpload(loader->getAsyncTextureUpload() && !replacing);
             changes.push_back(new AddTextureReq(tex));
+        }
+        changes.insert(changes.end(),warpChanges.begin(),warpChanges.end());
     } else {
         changes.push_back(nullptr);
     }
@@ -588,6 +652,12 @@ void QIFRenderState::updateScene(Scene *,
     lastRenderTime = now;
     lastCurFrames = curFrames;
     lastMasterEnable = masterEnable;
+
+    if (composite)
+    {
+        updateSceneComposite(curFrames, color, masterEnable, changes);
+        return;
+    }
     
     // We allow one or more points in the time slices where we're rendering
     // Useful if we're doing multi-stage rendering
@@ -714,6 +784,66 @@ void QIFRenderState::updateScene(Scene *,
     }
 }
     
+void QIFRenderState::updateSceneComposite(const std::vector<double> &curFrames,
+                                          const RGBAColor &color,
+                                          bool masterEnable,
+                                          ChangeSet &changes)
+{
+    unsigned char color4[4];
+    color.asUChar4(color4);
+
+    SingleVertexAttributeSet attrs;
+    attrs.insert(SingleVertexAttribute(u_interpNameID,-1,0.0f));
+    attrs.insert(SingleVertexAttribute(u_colorNameID,-1,color4));
+    if (terrain)
+        attrs.insert(SingleVertexAttribute(u_elevDecodeNameID,-1,elevDecode[0],elevDecode[1],elevDecode[2],elevDecode[3]));
+
+    const int numLayers = std::min((int)tilesLoaded.size(),QuadImageFrameLoader::MaxCompositeFrames);
+
+    // Wait until at least one layer covers everything.  For terrain, that has to be the imagery.
+    bool bigEnable = false;
+    for (int ii=0;ii<(terrain ? 1 : numLayers);ii++)
+        bigEnable |= topTilesLoaded[ii];
+    bigEnable &= masterEnable;
+
+    for (unsigned int focusID=0;focusID<curFrames.size();focusID++) {
+        for (const auto& tileIt : tiles) {
+            const auto tileID = tileIt.first;
+            const auto tile = tileIt.second;
+            bool enable = bigEnable && tile->enable;
+            if (enable) {
+                // Each layer goes in its own slot, whatever level its texture came from
+                bool anyTex = false;
+                for (int ii=0;ii<numLayers;ii++) {
+                    const auto &frame = tile->frames[ii];
+                    if (frame.texIDs.empty()) {
+                        for (const auto drawID : tile->instanceDrawIDs[focusID])
+                            changes.push_back(new DrawTexChangeRequest(drawID,ii,EmptyIdentity));
+                        continue;
+                    }
+                    // Elevation on its own has nothing to show
+                    anyTex |= !terrain || ii == 0;
+
+                    const auto relLevel = (unsigned)std::max(0, tileID.level - frame.texNode.level);
+                    const int relX = tileID.x - frame.texNode.x * (int)(1U<<relLevel);
+                    const int tileIDY = (int)(1U<<(unsigned)tileID.level)-tileID.y-1;
+                    const int frameIdentY = (int)(1U<<(unsigned)frame.texNode.level)-frame.texNode.y-1;
+                    const int relY = tileIDY - frameIdentY * (int)(1U<<relLevel);
+                    for (const auto drawID : tile->instanceDrawIDs[focusID])
+                        changes.push_back(new DrawTexChangeRequest(drawID,ii,frame.texIDs[0],texSize,borderSize,relLevel,relX,relY));
+                }
+                enable = anyTex;
+            }
+
+            for (const auto drawID : tile->instanceDrawIDs[focusID]) {
+                changes.push_back(new OnOffChangeRequest(drawID,enable));
+                if (enable)
+                    changes.push_back(new DrawUniformsChangeRequest(drawID,attrs));
+            }
+        }
+    }
+}
+
 QuadImageFrameLoader::QuadImageFrameLoader(const SamplingParams &params,Mode mode) :
     mode(mode), loadMode(Narrow), debugMode(false), masterEnable(true), params(params),
     requiringTopTilesLoaded(true),
@@ -730,9 +860,11 @@ QuadImageFrameLoader::QuadImageFrameLoader(const SamplingParams &params,Mode mod
     topPriority(-1), nearFramePriority(-1), restPriority(-1)
 {
     lastRunReqFlag = std::make_shared<bool>(true);
+    latencyStats = std::make_shared<TileLatencyStats>();
     renderTargetIDs.push_back(EmptyIdentity);
     shaderIDs.push_back(EmptyIdentity);
     curFrames.push_back(0.0);
+    frameDirs.push_back(0);
     
     updatePriorityDefaults();
     
@@ -746,6 +878,7 @@ void QuadImageFrameLoader::addFocus()
     renderTargetIDs.push_back(EmptyIdentity);
     shaderIDs.push_back(EmptyIdentity);
     curFrames.push_back(0.0);
+    frameDirs.push_back(0);
 }
 
 void QuadImageFrameLoader::setZoomLimits(int inMinZoom,int inMaxZoom)
@@ -776,6 +909,10 @@ void QuadImageFrameLoader::updatePriorityDefaults()
     
 int QuadImageFrameLoader::calcLoadPriority(const QuadTreeNew::ImportantNode &ident,int frame)
 {
+    // Get the parents in first so there's something to show while these load
+    if (parentPlaceholders && isAncestorLoading(ident,frame))
+        return getWaitingPriority();
+
     if (getNumFrames() == 1)
         return 0;
     
@@ -786,7 +923,14 @@ int QuadImageFrameLoader::calcLoadPriority(const QuadTreeNew::ImportantNode &ide
     }
     
     // Frames next to the one we're loading have priority
-    if (nearFramePriority > -1) {
+    if (nearFramePriority > -1 && usingFrameWindow()) {
+        // With a window, that's the ones we're showing and the next one coming up
+        for (int focusID = 0;focusID<numFocus;focusID++) {
+            const int steps = frameStepsAhead(frame,focusID);
+            if (steps >= 0 && steps <= 2)
+                return nearFramePriority;
+        }
+    } else if (nearFramePriority > -1) {
         for (auto focusFrame : curFrames) {
             // We want a frame before and after the current position
             int minFrame = floor(focusFrame);
@@ -803,6 +947,60 @@ int QuadImageFrameLoader::calcLoadPriority(const QuadTreeNew::ImportantNode &ide
     return restPriority;
 }
     
+bool QuadImageFrameLoader::isAncestorLoading(const QuadTreeNew::Node &ident,int frame) const
+{
+    QuadTreeNew::Node node = ident;
+    while (node.level > 0) {
+        node.level -= 1;
+        node.x /= 2;
+        node.y /= 2;
+
+        const auto it = tiles.find(node);
+        if (it == tiles.end())
+            continue;
+        if (const auto parentFrame = it->second->getFrame(std::max(frame,0))) {
+            // The nearest one with a texture is what we'd draw, so we're not waiting
+            if (!parentFrame->getTexIDs().empty())
+                return false;
+            if (parentFrame->getState() == QIFFrameAsset::Loading)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+bool QuadImageFrameLoader::findFrameTexture(const QuadTreeNew::Node &ident,int frame,
+                                            std::vector<SimpleIdentity> &texIDs,QuadTreeNew::Node &texNode) const
+{
+    // Look for a tile or parent tile that has a texture ID
+    texNode = ident;
+    while (true) {
+        const auto it = tiles.find(texNode);
+        if (it != tiles.end()) {
+            const auto parentFrame = it->second->getFrame(frame);
+            if (parentFrame && !parentFrame->getTexIDs().empty()) {
+                // Got one, so stop
+                texIDs = parentFrame->getTexIDs();
+                return true;
+            }
+        } else if (!parentPlaceholders) {
+            // Without placeholders we only go through the tiles we have
+            break;
+        }
+
+        // Work our way up the hierarchy
+        if (texNode.level <= 0)
+            break;
+        texNode.level -= 1;
+        texNode.x /= 2;
+        texNode.y /= 2;
+    }
+
+    texIDs.clear();
+    return false;
+}
+
 void QuadImageFrameLoader::setColor(const RGBAColor &inColor,ChangeSet *changes)
 {
     color = inColor;
@@ -842,11 +1040,142 @@ void QuadImageFrameLoader::setTexSize(int inTexSize,int inBorderSize)
     texSize = inTexSize;
     borderSize = inBorderSize;
 }
+
+void QuadImageFrameLoader::reprojectTextures(const QuadTreeNew::Node &ident,std::vector<Texture *> &texs,ChangeSet &warpChanges)
+{
+    if (!builder || !control || !TileReprojector::NeedsReprojection(builder->getGeomManager()))
+        return;
+
+    TileReprojector reproj(control->getRenderer(),control->getScene(),
+                           builder->getGeomManager(),builder->getGeomSettings(),reprojectSamples);
+    for (auto &tex : texs)
+    {
+        if (TileReprojector::CanReproject(tex))
+        {
+            tex->setAsyncUpload(asyncTexUpload);
+            tex = reproj.reprojectTexture(ident,tex,warpChanges);
+        }
+    }
+}
     
 void QuadImageFrameLoader::setCurFrame(PlatformThreadInfo *,int focusID,double inCurFrame)
 {
+    const double oldFrame = curFrames[focusID];
+    if (inCurFrame != oldFrame) {
+        // A big jump the other way is probably the animation looping around
+        double delta = inCurFrame - oldFrame;
+        if (std::abs(delta) > getNumFrames() / 2.0)
+            delta = -delta;
+        frameDirs[focusID] = (delta > 0.0) ? 1 : -1;
+    }
     curFrames[focusID] = inCurFrame;
 }
+
+const int QuadImageFrameLoader::MaxCompositeFrames;
+
+void QuadImageFrameLoader::setCompositeFrames(bool composite)
+{
+    compositeFrames = composite && mode == MultiFrame;
+    if (compositeFrames && getNumFrames() > MaxCompositeFrames)
+        wkLogLevel(Warn, "QuadImageFrameLoader: Only the first %d frames will be composited", MaxCompositeFrames);
+}
+
+void QuadImageFrameLoader::setTerrain(bool inTerrain,ElevationEncoding encoding,double exaggeration)
+{
+    terrain = inTerrain && mode == MultiFrame;
+    elevEncoding = encoding;
+    elevExaggeration = exaggeration;
+    if (terrain && getNumFrames() != 2)
+        wkLogLevel(Warn, "QuadImageFrameLoader: Terrain mode wants two frames, imagery and then elevation");
+}
+
+void QuadImageFrameLoader::setFrameWindow(int numFrames)
+{
+    // Need at least the two we're interpolating between
+    frameWindow = (numFrames <= 0) ? 0 : std::max(numFrames,2);
+}
+
+int QuadImageFrameLoader::frameStepsAhead(int frame,int focusID) const
+{
+    const int numFrames = getNumFrames();
+    if (numFrames <= 0)
+        return 0;
+
+    // Going forward we count from the frame before the position, going back from the one after
+    const int dir = frameDirs[focusID];
+    const double focusFrame = curFrames[focusID];
+    const int base = (dir < 0) ? (int)std::ceil(focusFrame) : (int)std::floor(focusFrame);
+    const int steps = (dir < 0) ? (base - frame) : (frame - base);
+
+    return ((steps % numFrames) + numFrames) % numFrames;
+}
+
+std::vector<bool> QuadImageFrameLoader::calcFrameWindow() const
+{
+    const int numFrames = getNumFrames();
+    if (!usingFrameWindow())
+        return std::vector<bool>(numFrames,true);
+
+    std::vector<bool> inWindow(numFrames,false);
+    for (int focusID = 0;focusID<numFocus;focusID++) {
+        // Two frames are being shown, the rest of the window is mostly out in front
+        const int dir = frameDirs[focusID];
+        const int behind = (dir == 0) ? (frameWindow-2)/2 : (frameWindow-2)/4;
+        const int ahead = frameWindow - 2 - behind;
+        for (int frame = 0;frame<numFrames;frame++) {
+            const int steps = frameStepsAhead(frame,focusID);
+            if (steps <= ahead + 1 || numFrames - steps <= behind)
+                inWindow[frame] = true;
+        }
+    }
+
+    return inWindow;
+}
+
+bool QuadImageFrameLoader::updateFrameWindow(PlatformThreadInfo *threadInfo,ChangeSet &changes)
+{
+    std::vector<bool> newWindow = calcFrameWindow();
+    if (newWindow == frameWindowState)
+        return false;
+    frameWindowState = std::move(newWindow);
+
+    auto batchOps = std::unique_ptr<QIFBatchOps>(makeBatchOps(threadInfo));
+    for (const auto &it : tiles) {
+        const auto &tile = it.second;
+        for (int frameID = 0;frameID<tile->getNumFrames();frameID++) {
+            const auto frame = tile->getFrame(frameID);
+            if (frameID < frameWindowState.size() && frameWindowState[frameID]) {
+                if (frame->getState() == QIFFrameAsset::Empty)
+                    tile->startFetching(threadInfo, this, frame->getFrameInfo(), batchOps.get(), changes);
+            } else if (frame->getState() != QIFFrameAsset::Empty) {
+                // Out of the window, so cancel it or give up the texture
+                frame->clear(threadInfo, this, batchOps.get(), changes);
+            }
+        }
+    }
+    processBatchOps(threadInfo,batchOps.get());
+
+    return true;
+}
+
+void QuadImageFrameLoader::startTileFetching(PlatformThreadInfo *threadInfo,const QIFTileAssetRef &tile,const QuadFrameInfoRef &frame,
+                                             QIFBatchOps *batchOps,ChangeSet &changes)
+{
+    if (latencyStats->isEnabled())
+        latencyStats->mark(tile->getIdent().NodeNumber(),TileLatencyStats::Requested,TimeGetCurrent());
+
+    if (frame || !usingFrameWindow()) {
+        tile->startFetching(threadInfo, this, frame, batchOps, changes);
+        return;
+    }
+
+    if (frameWindowState.size() != getNumFrames())
+        frameWindowState = calcFrameWindow();
+    for (int frameID = 0;frameID<getNumFrames();frameID++) {
+        if (frameWindowState[frameID])
+            tile->startFetching(threadInfo, this, getFrameInfo(frameID), batchOps, changes);
+    }
+}
     
 double QuadImageFrameLoader::getCurFrame(int focusID)
 {
@@ -914,6 +1243,26 @@ void QuadImageFrameLoader::reload(PlatformThreadInfo *threadInfo,int frameIndex,
     for (const auto &it : tiles) {
         const QIFTileAssetRef &tile = it.second;
 
+        if (reloadInPlace) {
+            // Tiles outside the bounds keep whatever they're doing
+            if (!localBounds.empty()) {
+                const auto tileBound = quadTree->generateMbrForNode(tile->getIdent());
+                if (std::none_of(localBounds.begin(), localBounds.end(), [&](const auto& b){ return tileBound.overlaps(b); })) {
+                    continue;
+                }
+            }
+
+            // Frames with textures keep showing them until the new data is in
+            tile->cancelFetches(threadInfo, this, frame, batchOps.get());
+            for (const auto &tileFrame : tile->frames) {
+                if (!frame || tileFrame->getFrameInfo() == frame)
+                    tileFrame->setReloading(!tileFrame->getTexIDs().empty());
+            }
+
+            startTileFetching(threadInfo, tile, frame, batchOps.get(), changes);
+            continue;
+        }
+
         // We cancel everything, even if it's not being refreshed.
         // We've increased the generation, so the incoming data will be dropped.
         // It might be better to increment the generation of everything outstanding,
@@ -930,7 +1279,7 @@ void QuadImageFrameLoader::reload(PlatformThreadInfo *threadInfo,int frameIndex,
             }
         }
 
-        tile->startFetching(threadInfo, this, frame, batchOps.get(), changes);
+        startTileFetching(threadInfo, tile, frame, batchOps.get(), changes);
     }
     
     // Process all the fetches and cancels at once
@@ -940,6 +1289,21 @@ void QuadImageFrameLoader::reload(PlatformThreadInfo *threadInfo,int frameIndex,
 
 void QuadImageFrameLoader::updatePriorities(PlatformThreadInfo *threadInfo)
 {
+    // The current frame moved, so the frame window may have too
+    if (usingFrameWindow() && builder) {
+        ChangeSet changes;
+        if (updateFrameWindow(threadInfo, changes)) {
+            buildRenderState(changes);
+            makeStats();
+        }
+        Scene *scene = control ? control->getScene() : nullptr;
+        if (scene && !changes.empty())
+            scene->addChangeRequests(changes);
+        else
+            for (auto change : changes)
+                delete change;
+    }
+
     // Work through the tiles and frames
     for (const auto &it : tiles) {
         const QIFTileAssetRef &tile = it.second;
@@ -975,7 +1339,7 @@ QIFTileAssetRef QuadImageFrameLoader::addNewTile(PlatformThreadInfo *threadInfo,
         wkLogLevel(Debug,"MaplyQuadImageLoader: Starting fetch for tile %d: (%d,%d)",ident.level,ident.x,ident.y);
     
     // Normal remote data fetching
-    newTile->startFetching(threadInfo,this, nullptr, batchOps, changes);
+    startTileFetching(threadInfo, newTile, nullptr, batchOps, changes);
         
     return newTile;
 }
@@ -987,6 +1351,8 @@ void QuadImageFrameLoader::removeTile(PlatformThreadInfo *threadInfo,const QuadT
     if (it != tiles.end()) {
         if (debugMode)
             wkLogLevel(Debug,"MaplyQuadImageLoader: Unloading tile %d: (%d,%d)",ident.level,ident.x,ident.y);
+
+        latencyStats->drop(ident.NodeNumber());
         
         it->second->clear(threadInfo, this, batchOps, changes);
         
@@ -999,6 +1365,8 @@ void QuadImageFrameLoader::removeTile(PlatformThreadInfo *threadInfo,const QuadT
     
 void QuadImageFrameLoader::mergeLoadedTile(PlatformThreadInfo *threadInfo,QuadLoaderReturn *loadReturn,ChangeSet &changes)
 {
+    WKTraceScope("QIF mergeLoadedTile");
+
     changesSinceLastFlush = true;
 
     if (debugMode)
@@ -1008,6 +1376,10 @@ void QuadImageFrameLoader::mergeLoadedTile(PlatformThreadInfo *threadInfo,QuadLo
     const auto it = tiles.find(ident);
     const auto tile = (it != tiles.end()) ? it->second : nullptr;
 
+    const bool trackLatency = tile && latencyStats->isEnabled();
+    if (trackLatency)
+        latencyStats->mark(ident.NodeNumber(),TileLatencyStats::Decoded,TimeGetCurrent());
+
     // Tile disappeared in the mean time, so drop it
     bool failed = (!tile || loadReturn->hasError || loadReturn->cancel);
     if (failed && debugMode) {
@@ -1020,13 +1392,20 @@ void QuadImageFrameLoader::mergeLoadedTile(PlatformThreadInfo *threadInfo,QuadLo
     std::vector<Texture *> texs;
     if (!failed) {
         // Build the texture(s)
+        // Elevation has to come through exactly, so no smaller formats or blending between pixels
+        const bool isElev = terrain && loadReturn->frame && loadReturn->frame->frameIndex == 1;
         for (const auto& image : loadReturn->images) {
             //const auto loadedTile = builder->getLoadedTile(ident);
             if (image) {
                 Texture *tex = image->buildTexture();
                 image->clearTexture();
                 if (tex) {
-                    tex->setFormat(texType);
+                    if (isElev) {
+                        tex->setFormat(TexTypeUnsignedByte);
+                        tex->setInterpType(TexInterpNearest);
+                    } else {
+                        tex->setFormat(texType);
+                    }
                     texs.push_back(tex);
                 }
             }
@@ -1053,6 +1432,21 @@ void QuadImageFrameLoader::mergeLoadedTile(PlatformThreadInfo *threadInfo,QuadLo
         {
             failed = true;
         }
+
+        // Anything underneath that was waiting on this one can move up in the queue
+        if (parentPlaceholders && ident.level < maxZoom)
+        {
+            bool hasChildren = false;
+            for (int iy=0;iy<2 && !hasChildren;iy++)
+                for (int ix=0;ix<2 && !hasChildren;ix++)
+                    hasChildren = tiles.find(QuadTreeNew::Node(2*ident.x+ix,2*ident.y+iy,ident.level+1)) != tiles.end();
+            if (hasChildren) {
+                if (mergingTiles)
+                    prioritiesChanged = true;
+                else
+                    updatePriorities(threadInfo);
+            }
+        }
     }
 
     // For whatever reason, didn't correctly integrate the tile, so now delete everything
@@ -1082,11 +1476,51 @@ void QuadImageFrameLoader::mergeLoadedTile(PlatformThreadInfo *threadInfo,QuadLo
 
         loadReturn->clear();
     }
+
+    if (trackLatency)
+    {
+        if (failed)
+        {
+            latencyStats->drop(ident.NodeNumber());
+        }
+        else
+        {
+            latencyStats->mark(ident.NodeNumber(),TileLatencyStats::Merged,TimeGetCurrent());
+            changes.push_back(new TileDisplayedReq(latencyStats,ident.NodeNumber()));
+        }
+    }
+}
+
+void QuadImageFrameLoader::mergeLoadedTiles(PlatformThreadInfo *threadInfo,const std::vector<QuadLoaderReturn *> &loadReturns,ChangeSet &changes)
+{
+    WKTraceScope("QIF mergeLoadedTiles");
+
+    mergingTiles = true;
+    prioritiesChanged = false;
+    changes.reserve(changes.size() + 4 * loadReturns.size());
+    for (auto loadReturn : loadReturns)
+    {
+        // Changes made directly with the managers go ahead of the tile's own
+        changes.insert(changes.end(),loadReturn->changes.begin(),loadReturn->changes.end());
+        loadReturn->changes.clear();
+
+        mergeLoadedTile(threadInfo,loadReturn,changes);
+    }
+    mergingTiles = false;
+
+    // Every parent that came in moves its children up, and once is enough for all of them
+    if (prioritiesChanged)
+    {
+        prioritiesChanged = false;
+        updatePriorities(threadInfo);
+    }
 }
     
 // Figure out what needs to be on/off for the non-frame cases
 void QuadImageFrameLoader::updateRenderState(ChangeSet &changes)
 {
+    WKTraceScope("QIF updateRenderState");
+
     // See if there's any loading happening
     bool allLoaded = true;
     for (const auto& it : tiles) {
@@ -1131,29 +1565,8 @@ void QuadImageFrameLoader::updateRenderState(ChangeSet &changes)
         if (mode != Object) {
             // For the image modes, we try to refer to parent textures as needed
             std::vector<SimpleIdentity> texIDs;
-            QuadTreeNew::Node texNode = tile->getIdent();   // NOLINT Slicing ImportantNode to Node
-
-            // Look for a tile or parent tile that has a texture ID
-            do {
-                auto it = tiles.find(texNode);
-                if (it == tiles.end())
-                    break;
-                auto parentTile = it->second;
-                auto parentFrame = parentTile->getFrame(0);
-                if (parentFrame && !parentFrame->getTexIDs().empty()) {
-                    // Got one, so stop
-                    texIDs = parentFrame->getTexIDs();
-                    texNode = parentTile->getIdent();   // NOLINT Slicing ImportantNode to Node
-                    break;
-                }
-                
-                // Work our way up the hierarchy
-                if (texNode.level <= 0)
-                    break;
-                texNode.level -= 1;
-                texNode.x /= 2;
-                texNode.y /= 2;
-            } while (texIDs.empty());
+            QuadTreeNew::Node texNode;
+            findFrameTexture(tileID,0,texIDs,texNode);
 
             // Turn on the node and adjust the texture
             // Note: Should cache this so we're not changing it every frame
@@ -1195,14 +1608,59 @@ void QuadImageFrameLoader::updateRenderState(ChangeSet &changes)
     }
 }
 
+// Pixel to height conversion for the terrain shader, already scaled to display units.
+// The shader gets the color channels from 0 to 1, so the 255 is folded in too.
+static void CalcElevDecode(const CoordSystemDisplayAdapter *coordAdapter,ElevationEncoding encoding,
+                           double exaggeration,float *decode)
+{
+    // Display units per meter.  On a flat map we take it at the equator.
+    double scale = 1.0 / EarthRadius;
+    if (coordAdapter && coordAdapter->isFlat())
+    {
+        const double spanRad = 1.0e-4;
+        const CoordSystem *coordSys = coordAdapter->getCoordSystem();
+        const Point3d pt0 = coordAdapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord(0.0,0.0)));
+        const Point3d pt1 = coordAdapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord(spanRad,0.0)));
+        scale = (pt1 - pt0).norm() / (spanRad * EarthRadius);
+    }
+    scale *= exaggeration;
+
+    switch (encoding)
+    {
+        case ElevEncodeTerrarium:
+            // (R * 256 + G + B / 256) - 32768
+            decode[0] = (float)(255.0 * 256.0 * scale);
+            decode[1] = (float)(255.0 * scale);
+            decode[2] = (float)(255.0 / 256.0 * scale);
+            decode[3] = (float)(-32768.0 * scale);
+            break;
+        case ElevEncodeMapboxRGB:
+            // -10000 + (R * 65536 + G * 256 + B) * 0.1
+            decode[0] = (float)(255.0 * 6553.6 * scale);
+            decode[1] = (float)(255.0 * 25.6 * scale);
+            decode[2] = (float)(255.0 * 0.1 * scale);
+            decode[3] = (float)(-10000.0 * scale);
+            break;
+    }
+}
+
 // Build up the drawing state for use on the main thread
 // All the texture are assigned there
 void QuadImageFrameLoader::buildRenderState(ChangeSet &changes)
 {
+    WKTraceScope("QIF buildRenderState");
+
     const int numFrames = getNumFrames();
     QIFRenderState newRenderState(numFocus,numFrames);
     newRenderState.texSize = texSize;
     newRenderState.borderSize = borderSize;
+    newRenderState.composite = compositeFrames || terrain;
+    newRenderState.terrain = terrain;
+    if (terrain)
+    {
+        const auto scene = control ? control->getScene() : nullptr;
+        CalcElevDecode(scene ? scene->getCoordAdapter() : nullptr,elevEncoding,elevExaggeration,newRenderState.elevDecode);
+    }
     for (int frameID=0;frameID<numFrames;frameID++)
         newRenderState.topTilesLoaded[frameID] = true;
         
@@ -1227,27 +1685,7 @@ void QuadImageFrameLoader::buildRenderState(ChangeSet &changes)
                 continue;
             
             // Look for a tile or parent tile that has a texture ID
-            QuadTreeNew::Node texNode = tile->getIdent();   // NOLINT Slicing ImportantNode to Node
-            do {
-                const auto it = tiles.find(texNode);
-                if (it == tiles.end())
-                    break;
-                const auto parentTile = it->second;
-                const auto parentFrame = parentTile->getFrame(frameID);
-                if (parentFrame && !parentFrame->getTexIDs().empty()) {
-                    // Got one, so stop
-                    outFrame.texIDs = parentFrame->getTexIDs();
-                    outFrame.texNode = parentTile->getIdent();  // NOLINT Slicing ImportantNode to Node
-                    break;
-                }
-                
-                // Work our way up the hierarchy
-                if (texNode.level <= 0)
-                    break;
-                texNode.level -= 1;
-                texNode.x /= 2;
-                texNode.y /= 2;
-            } while (outFrame.texIDs.empty());
+            findFrameTexture(tileID,frameID,outFrame.texIDs,outFrame.texNode);
             
             // Metrics for overall loading used by the display side
             if (outFrame.texIDs.empty() && inFrame->getState() != QIFFrameAsset::Loaded) {
@@ -1286,6 +1724,11 @@ void QuadImageFrameLoader::setBuilder(QuadTileBuilder *inBuilder,QuadDisplayCont
     builder = inBuilder;
     control = inControl;
     compManager = control->getScene()->getManager<ComponentManager>(kWKComponentManager);
+
+    // On a fast start, the low levels read from the cache stand in until the rest arrive.
+    // Unless the app has said otherwise.
+    if (!parentPlaceholdersSet && control->getRenderer()->getFastStartup())
+        parentPlaceholders = true;
 }
 
 /// Before we tell the delegate to unload tiles, see if they want to keep them around
@@ -1295,6 +1738,8 @@ QuadTreeNew::NodeSet QuadImageFrameLoader::builderUnloadCheck(QuadTileBuilder *i
         const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
         int inTargetLevel)
 {
+    WKTraceScope("QIF builderUnloadCheck");
+
     QuadTreeNew::NodeSet toKeep;
 
     // Not initialized yet
@@ -1304,12 +1749,12 @@ QuadTreeNew::NodeSet QuadImageFrameLoader::builderUnloadCheck(QuadTileBuilder *i
     auto theActiveFrames = getActiveFrames();
     
     // List all the tiles that we're going to load or are loading
-    QuadTreeNew::NodeSet allLoads;
-    for (const auto& node : loadTiles)
-        allLoads.insert(node);
+    QuadTreeNew::NodeSet allLoads(loadTiles.begin(),loadTiles.end());
+    std::vector<QuadTreeNew::Node> loading;
     for (const auto& node : tiles)
         if (node.second->anyFramesLoading(theActiveFrames))
-            allLoads.insert(node.first);
+            loading.push_back(node.first);
+    allLoads.insert(loading.begin(),loading.end());
     
     // For all those loading or will be loading nodes, nail down their parents
     for (const auto& node : allLoads) {
@@ -1361,12 +1806,33 @@ QuadTreeNew::NodeSet QuadImageFrameLoader::builderUnloadCheck(QuadTileBuilder *i
     return toKeep;
 }
 
+void QuadImageFrameLoader::builderPrefetch(PlatformThreadInfo *threadInfo,QuadTileBuilder *inBuilder,
+                                           const QuadTreeNew::ImportantNodeSet &inTiles)
+{
+    if (!builder || !masterEnable)
+        return;
+
+    // Skip anything we already have or that's outside our zoom range
+    std::vector<QuadTreeNew::ImportantNode> toFetch;
+    toFetch.reserve(inTiles.size());
+    for (auto it = inTiles.rbegin(); it != inTiles.rend(); ++it)
+    {
+        if (it->level >= minZoom && it->level <= maxZoom && tiles.find(*it) == tiles.end())
+            toFetch.push_back(*it);
+    }
+
+    if (!toFetch.empty())
+        prefetchTiles(threadInfo,toFetch);
+}
+
 /// Load the given group of tiles.  If you don't load them immediately, up to you to cancel any requests
 void QuadImageFrameLoader::builderLoad(PlatformThreadInfo *threadInfo,
                                        QuadTileBuilder *inBuilder,
                                        const WhirlyKit::TileBuilderDelegateInfo &updates,
                                        ChangeSet &changes)
 {
+    WKTraceScope("QIF builderLoad");
+
     // Not initialized yet
     if (!this->builder)
         return;
@@ -1378,12 +1844,21 @@ void QuadImageFrameLoader::builderLoad(PlatformThreadInfo *threadInfo,
     bool somethingChanged = false;
     
     targetLevel = updates.targetLevel;
+
+    // Catch up with the frame window before adding new tiles to it
+    if (usingFrameWindow())
+        somethingChanged |= updateFrameWindow(threadInfo, changes);
     
     QIFBatchOps *batchOps = makeBatchOps(threadInfo);
     
     // Add new tiles
-    for (auto it = updates.loadTiles.rbegin(); it != updates.loadTiles.rend(); ++it) {
-        auto &tile = *it;
+    LoadedTileVec loadTiles(updates.loadTiles.rbegin(),updates.loadTiles.rend());
+    if (parentPlaceholders) {
+        // Parents go first so their children can see they're loading
+        std::stable_sort(loadTiles.begin(),loadTiles.end(),
+                         [](const LoadedTileNewRef &a,const LoadedTileNewRef &b) { return a->ident.level < b->ident.level; });
+    }
+    for (const auto &tile : loadTiles) {
         // If it's already there, clear it out
         removeTile(threadInfo,tile->ident,batchOps,changes);
         
@@ -1456,6 +1931,11 @@ void QuadImageFrameLoader::builderPreSceneFlush(QuadTileBuilder *inBuilder, Chan
         // For single frame (or object) mode we can just take action now
         updateRenderState(changes);
     }
+
+    // The new render state is queued up ahead of these, so they're no longer in use when they go
+    for (auto texID : replacedTexIDs)
+        changes.push_back(new RemTextureReq(texID));
+    replacedTexIDs.clear();
     
     // Let's also generate the stats right here.  That should be often enough.
     makeStats();
@@ -1468,6 +1948,10 @@ void QuadImageFrameLoader::builderShutdown(PlatformThreadInfo *threadInfo, QuadT
 {
     if (lastRunReqFlag)
         *lastRunReqFlag = false;
+
+    for (auto texID : replacedTexIDs)
+        changes.push_back(new RemTextureReq(texID));
+    replacedTexIDs.clear();
 }
 
 /// Returns true if there's an update to process
@@ -1477,8 +1961,10 @@ bool QuadImageFrameLoader::hasUpdate() const
 }
 
 /// Process the update
-void QuadImageFrameLoader::updateForFrame(RendererFrameInfo *frameInfo)
+void QuadImageFrameLoader::batchUpdateForFrame(RendererFrameInfo *frameInfo,ChangeSet &changes)
 {
+    WKTraceScope("QIF updateForFrame");
+
     if (!control || !renderState.hasUpdate(curFrames,masterEnable))
         return;
     Scene *scene = control->getScene();
@@ -1489,13 +1975,8 @@ void QuadImageFrameLoader::updateForFrame(RendererFrameInfo *frameInfo)
     if (lastRunReqFlag && !*lastRunReqFlag)
         return;
 
-
-    ChangeSet changes;
-
     TimeInterval now = control->getScene()->getCurrentTime();
     renderState.updateScene(frameInfo->scene, curFrames, now, flipY, color, masterEnable, changes);
-
-    frameInfo->scene->addChangeRequests(changes);
 }
 
 void QuadImageFrameLoader::makeStats()
@@ -1505,15 +1986,28 @@ void QuadImageFrameLoader::makeStats()
     newStats.numTiles = tiles.size();
     const int numFrames = getNumFrames();
     newStats.frameStats.resize(numFrames);
+    if (usingFrameWindow() && frameWindowState.size() == numFrames) {
+        for (int frameID = 0;frameID<numFrames;frameID++)
+            newStats.frameStats[frameID].resident = frameWindowState[frameID];
+    }
     for (const auto &it : tiles) {
         const auto tile = it.second;
         
+        size_t tileTexBytes = 0;
+        for (const auto &frame : tile->frames)
+            tileTexBytes += frame->getTexBytes();
+        newStats.texBytes += tileTexBytes;
+        if (tileTexBytes > 0)
+            newStats.numTexTiles++;
+
         for (int frameID = 0;frameID<numFrames;frameID++) {
             if (const auto frame = tile->getFrame(frameID)) {
                 auto &frameStat = newStats.frameStats[frameID];
                 switch (frame->getState()) {
                     case QIFFrameAsset::Empty:
+                        break;
                     case QIFFrameAsset::Loaded:
+                        frameStat.tilesLoaded++;
                         break;
                     case QIFFrameAsset::Loading:
                         frameStat.tilesToLoad++;
@@ -1533,6 +2027,17 @@ QuadImageFrameLoader::Stats QuadImageFrameLoader::getStats() const
     std::lock_guard<std::mutex> guardLock(statsLock);
     return stats;
 }
+
+TileMemoryUsage QuadImageFrameLoader::builderMemoryUsage() const
+{
+    std::lock_guard<std::mutex> guardLock(statsLock);
+
+    TileMemoryUsage usage;
+    usage.bytes = stats.texBytes;
+    if (stats.numTexTiles > 0)
+        usage.bytesPerTile = stats.texBytes / stats.numTexTiles;
+    return usage;
+}
     
 void QuadImageFrameLoader::cleanup(PlatformThreadInfo *threadInfo,ChangeSet &changes)
 {
@@ -1571,6 +2076,12 @@ bool QuadImageFrameLoader::isFrameLoading(const QuadTreeIdentifier &ident, Simpl
     return it != tiles.end() && it->second->isFrameLoading(frameID);
 }
 
+double QuadImageFrameLoader::getTileImportance(const QuadTreeIdentifier &ident) const
+{
+    const auto it = tiles.find(ident);
+    return (it != tiles.end()) ? it->second->getIdent().importance : 0.0;
+}
+
 void QuadImageFrameLoader::setLoadReturnRef(const QuadTreeIdentifier &ident,const QuadFrameInfoRef &frame,const QuadLoaderReturnRef &loadReturnRef)
 {
     const auto it = tiles.find(ident);
@@ -1579,6 +2090,52 @@ void QuadImageFrameLoader::setLoadReturnRef(const QuadTreeIdentifier &ident,cons
     }
 }
 
+// Hash the fetched bytes, enough to tell whether a tile's data changed
+static uint64_t HashTileData(const RawData *data)
+{
+    data->willRead();
+    return StableHash(data->getRawData(),data->getLen());
+}
+
+bool QuadImageFrameLoader::frameUnchanged(PlatformThreadInfo *threadInfo,const QuadTreeIdentifier &ident,
+                                          const QuadFrameInfoRef &frameInfo,const RawData *data)
+{
+    return frameUnchanged(threadInfo, ident, frameInfo ? frameInfo->getId() : EmptyIdentity, data);
+}
+
+bool QuadImageFrameLoader::frameUnchanged(PlatformThreadInfo *threadInfo,const QuadTreeIdentifier &ident,
+                                          SimpleIdentity frameID,const RawData *data)
+{
+    // Single frame mode with multiple sources needs every piece to build the tile
+    if (!reloadInPlace || !data || frameID == EmptyIdentity || (mode == SingleFrame && getNumFrames() > 1))
+    {
+        return false;
+    }
+
+    const auto it = tiles.find(ident);
+    const auto frame = (it != tiles.end()) ? it->second->findFrameFor(frameID) : nullptr;
+    if (!frame)
+    {
+        return false;
+    }
+
+    const uint64_t hash = HashTileData(data);
+    if (frame->isReloading() && frame->getDataHash() == hash)
+    {
+        frame->loadUnchanged(threadInfo,this);
+        changesSinceLastFlush = true;
+        return true;
+    }
+
+    frame->setPendingDataHash(hash);
+    return false;
+}
+
+void QuadImageFrameLoader::retireTextures(const std::vector<SimpleIdentity> &texIDs)
+{
+    replacedTexIDs.insert(replacedTexIDs.end(),texIDs.begin(),texIDs.end());
+}
+
 bool QuadImageFrameLoader::mergeLoadedFrame(const QuadTreeIdentifier &ident,
                                             const QuadFrameInfoRef &frame,
                                             RawDataRef data,
@@ -1602,6 +2159,9 @@ bool QuadImageFrameLoader::mergeLoadedFrame(const QuadTreeIdentifier &ident,
     }
     const auto &tile = it->second;
 
+    if (latencyStats->isEnabled())
+        latencyStats->mark(ident.NodeNumber(),TileLatencyStats::Received,TimeGetCurrent());
+
     // Single frame mode with multiple sources is the only case where we keep the data
     if (mode == SingleFrame && getNumFrames() > 1)
     {
@@ -32,10 +32,17 @@ void QuadSamplingController::start(const SamplingParams &inParams,Scene *inScene
     builder->setBuildGeom(params.generateGeom);
     builder->setCoverPoles(params.coverPoles);
     builder->setEdgeMatching(params.edgeMatching);
+    builder->setMeshTemplates(params.meshTemplates);
+    builder->setIncludeElev(params.includeElev);
+    builder->setElevTextures(params.elevTextures);
     builder->setSingleLevel(params.singleLevel);
+
+    solidCache.setMaxBytes(std::max(params.displaySolidCacheSize,0));
     
     displayControl = std::make_shared<QuadDisplayControllerNew>(this,builder.get(),renderer);
     displayControl->setSingleLevel(params.singleLevel);
+    displayControl->setIncremental(params.incrementalCoverage);
+    displayControl->setPrefetch(params.predictivePrefetch);
     displayControl->setKeepMinLevel(params.forceMinLevel,params.forceMinLevelHeight);
     displayControl->setLevelLoads(params.levelLoads);
     std::vector<double> importance(params.maxZoom+1);
@@ -71,6 +78,7 @@ void QuadSamplingController::stop()
     builder = nullptr;
     displayControl = nullptr;
     builderDelegates.clear();
+    solidCache.clear();
 }
 
 bool QuadSamplingController::addBuilderDelegate(PlatformThreadInfo *,QuadTileBuilderDelegateRef delegate)
@@ -159,8 +167,38 @@ double QuadSamplingController::importanceForTile(const QuadTreeIdentifier &ident
         return MAXFLOAT;
     }
     
+    DisplaySolidRef dispSolid = solidCache.getSolid(ident, mbr, params.coordSys.get(), coordAdapter);
     return ScreenImportance(viewState.get(), frameSize, viewState->eyeVec, 1,
-                 params.coordSys.get(), coordAdapter, mbr, ident);
+                 params.coordSys.get(), coordAdapter, mbr, ident, dispSolid);
+}
+
+void QuadSamplingController::importanceForTiles(const std::vector<QuadTreeIdentifier> &idents,
+                                                const std::vector<Mbr> &mbrs,
+                                                const ViewStateRef &viewState,
+                                                const Point2f &frameSize,
+                                                std::vector<double> &imports)
+{
+    const auto coordAdapter = scene->getCoordAdapter();
+    if (!coordAdapter)
+    {
+        imports.assign(idents.size(),MAXFLOAT);
+        return;
+    }
+
+    std::vector<DisplaySolidRef> dispSolids;
+    dispSolids.reserve(idents.size());
+    for (size_t ii=0;ii<idents.size();ii++)
+        dispSolids.push_back(solidCache.getSolid(idents[ii], mbrs[ii], params.coordSys.get(), coordAdapter));
+
+    ScreenImportance(viewState.get(), frameSize, 1, dispSolids, imports);
+
+    // World spanning level 0 nodes sometimes have problems evaluating
+    if (params.minImportanceTop == 0.0)
+    {
+        for (size_t ii=0;ii<idents.size();ii++)
+            if (idents[ii].level == 0)
+                imports[ii] = MAXFLOAT;
+    }
 }
 
 void QuadSamplingController::newViewState(ViewStateRef viewState)
@@ -175,9 +213,10 @@ bool QuadSamplingController::visibilityForTile(const QuadTreeIdentifier &ident,
     if (ident.level == 0)
         return true;
     
-    DisplaySolidRef dispSolid;
+    const auto coordAdapter = scene->getCoordAdapter();
+    DisplaySolidRef dispSolid = solidCache.getSolid(ident, mbr, params.coordSys.get(), coordAdapter);
     return TileIsOnScreen(viewState.get(), frameSize,  params.coordSys.get(),
-                          scene->getCoordAdapter(), mbr, ident, dispSolid);
+                          coordAdapter, mbr, ident, dispSolid);
 }
     
 /// **** QuadTileBuilderDelegate methods ****
@@ -248,6 +287,34 @@ void QuadSamplingController::builderLoad(PlatformThreadInfo *threadInfo,
     }
 }
     
+void QuadSamplingController::builderPrefetch(PlatformThreadInfo *threadInfo,QuadTileBuilder *inBuilder,
+                                             const QuadTreeNew::ImportantNodeSet &tiles)
+{
+    std::vector<QuadTileBuilderDelegateRef> delegates;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        delegates = builderDelegates;
+    }
+
+    for (const auto& delegate : delegates)
+    {
+        delegate->builderPrefetch(threadInfo, inBuilder, tiles);
+    }
+}
+
+TileMemoryUsage QuadSamplingController::builderMemoryUsage() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    TileMemoryUsage usage;
+    for (const auto& delegate : builderDelegates)
+    {
+        usage += delegate->builderMemoryUsage();
+    }
+
+    return usage;
+}
+
 void QuadSamplingController::builderPreSceneFlush(QuadTileBuilder *inBuilder, ChangeSet &changes)
 {
     std::vector<QuadTileBuilderDelegateRef> delegates;
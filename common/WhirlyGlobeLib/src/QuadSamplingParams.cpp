@@ -16,6 +16,8 @@
  *  limitations under the License.
  */
 
+#import <algorithm>
+#import <cmath>
 #import "QuadSamplingParams.h"
 
 namespace WhirlyKit
@@ -26,10 +28,13 @@ SamplingParams::SamplingParams()
     minZoom(0), maxZoom(0), reportedMaxZoom(-1),
     maxTiles(128),
     minImportance(256*256), minImportanceTop(0.0),
-    coverPoles(true), edgeMatching(true),
+    coverPoles(true), edgeMatching(true), meshTemplates(false), includeElev(false), elevTextures(false),
     tessX(10), tessY(10),
       boundsScale(1.0),
     singleLevel(false),
+    incrementalCoverage(false),
+    displaySolidCacheSize(2*1024*1024),
+    predictivePrefetch(false),
     forceMinLevel(true),
     forceMinLevelHeight(0.0),
     generateGeom(true)
@@ -44,15 +49,19 @@ bool SamplingParams::operator == (const SamplingParams &that) const
         (coordSys && !that.coordSys))
         return false;
     
-    if (!coordSys->isSameAs(that.coordSys.get()))
+    if (!coordSys->isSameAs(that.coordSys.get()) || !(coordBounds == that.coordBounds))
         return false;
     
     return minZoom == that.minZoom && maxZoom == that.maxZoom && reportedMaxZoom == that.reportedMaxZoom &&
         maxTiles == that.maxTiles &&
         minImportance == that.minImportance && minImportanceTop == that.minImportanceTop &&
         coverPoles == that.coverPoles && edgeMatching == that.edgeMatching &&
+        meshTemplates == that.meshTemplates && includeElev == that.includeElev &&
+        elevTextures == that.elevTextures &&
         tessX == that.tessX && tessY == that.tessY &&
         singleLevel == that.singleLevel &&
+        incrementalCoverage == that.incrementalCoverage &&
+        predictivePrefetch == that.predictivePrefetch &&
         boundsScale == that.boundsScale &&
         forceMinLevel == that.forceMinLevel &&
         forceMinLevelHeight == that.forceMinLevelHeight &&
@@ -69,5 +78,39 @@ void SamplingParams::setImportanceLevel(double theMinImportance,int level)
     }
     importancePerLevel[level] = theMinImportance;
 }
+
+bool SamplingParams::setupTiledImage(const CoordSystemRef &inCoordSys,const MbrD &imageBounds,
+                                     int imageWidth,int imageHeight,int tileSize)
+{
+    if (!inCoordSys || !imageBounds.valid() || imageWidth <= 0 || imageHeight <= 0 || tileSize <= 0)
+        return false;
+    const Point2d imageSpan = imageBounds.span();
+    if (imageSpan.x() <= 0.0 || imageSpan.y() <= 0.0)
+        return false;
+
+    // Enough levels that the bottom one is at full resolution
+    int levels = 0;
+    while (std::ldexp((double)tileSize,levels) < std::max(imageWidth,imageHeight) && levels < 30)
+        levels++;
+
+    // The pyramid is square in pixels, so it usually runs past the image
+    const double pyramidPixels = std::ldexp((double)tileSize,levels);
+    const Point2d pixelSize(imageSpan.x() / imageWidth,imageSpan.y() / imageHeight);
+
+    coordSys = inCoordSys;
+    coordBounds.reset();
+    coordBounds.addPoint(imageBounds.ll());
+    coordBounds.addPoint(Point2d(imageBounds.ll().x() + pixelSize.x() * pyramidPixels,
+                                 imageBounds.ll().y() + pixelSize.y() * pyramidPixels));
+    clipBounds = imageBounds;
+
+    minZoom = 0;
+    maxZoom = levels;
+    // Neither of these make sense for a piece of the globe
+    coverPoles = false;
+    edgeMatching = false;
+
+    return true;
+}
     
 }
@@ -75,6 +75,36 @@ bool QuadTileBuilder::getEdgeMatching() const
     return geomManage.buildSkirts;
 }
 
+void QuadTileBuilder::setMeshTemplates(bool meshTemplates)
+{
+    geomSettings.meshTemplates = meshTemplates;
+}
+
+bool QuadTileBuilder::getMeshTemplates() const
+{
+    return geomSettings.meshTemplates;
+}
+
+void QuadTileBuilder::setIncludeElev(bool includeElev)
+{
+    geomSettings.includeElev = includeElev;
+}
+
+bool QuadTileBuilder::getIncludeElev() const
+{
+    return geomSettings.includeElev;
+}
+
+void QuadTileBuilder::setElevTextures(bool elevTextures)
+{
+    geomSettings.elevTextures = elevTextures;
+}
+
+bool QuadTileBuilder::getElevTextures() const
+{
+    return geomSettings.elevTextures;
+}
+
 void QuadTileBuilder::setBaseDrawPriority(int baseDrawPriority)
 {
     geomSettings.baseDrawPriority = baseDrawPriority;
@@ -231,4 +261,18 @@ void QuadTileBuilder::quadLoaderShutdown(PlatformThreadInfo *threadInfo,ChangeSe
     delegate = nullptr;
 }
 
+void QuadTileBuilder::quadLoaderPrefetch(PlatformThreadInfo *threadInfo,const QuadTreeNew::ImportantNodeSet &tiles)
+{
+    if (delegate)
+        delegate->builderPrefetch(threadInfo,this,tiles);
+}
+
+TileMemoryUsage QuadTileBuilder::quadLoaderMemoryUsage() const
+{
+    TileMemoryUsage usage = geomManage.getMemoryUsage();
+    if (delegate)
+        usage += delegate->builderMemoryUsage();
+    return usage;
+}
+
 }
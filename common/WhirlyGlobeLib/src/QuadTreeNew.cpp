@@ -18,6 +18,7 @@
 
 #import "QuadTreeNew.h"
 #import <WhirlyKitLog.h>
+#import "PerformanceTimer.h"
 #include <Expect.h>
 
 static constexpr int maxMaxLevel = 24;
@@ -100,8 +101,146 @@ QuadTreeNew::QuadTreeNew(const MbrD &mbr,int minLevel,int maxLevel)
 {
 }
 
+void QuadTreeNew::diffNodes(const ImportantNodeSet &oldNodes,const ImportantNodeSet &newNodes,
+                            ImportantNodeSet &toAdd,ImportantNodeSet &toUpdate,NodeSet &toRemove)
+{
+    // Importance changes, so compare by node only
+    const NodeSet oldTest(oldNodes.begin(),oldNodes.end());
+    const NodeSet newTest(newNodes.begin(),newNodes.end());
+
+    for (const auto &node : oldTest)
+    {
+        if (newTest.find(node) == newTest.end())
+            toRemove.insert(node);
+    }
+    for (const auto &node : newNodes)
+    {
+        if (oldTest.find(node) == oldTest.end())
+            toAdd.insert(node);
+        else
+            toUpdate.insert(node);
+    }
+}
+
+void QuadTreeNew::setIncremental(bool newVal)
+{
+    incremental = newVal;
+    importCache.clear();
+}
+
+void QuadTreeNew::startCoveragePass(double viewDelta)
+{
+    if (!incremental)
+        return;
+
+    if (viewDelta < 0.0)
+    {
+        importCache.clear();
+        coveragePass++;
+        return;
+    }
+
+    // Anything we didn't look at last time is off the frontier
+    for (auto it = importCache.begin(); it != importCache.end(); )
+    {
+        if (it->second.pass != coveragePass)
+        {
+            it = importCache.erase(it);
+        }
+        else
+        {
+            it->second.drift += viewDelta;
+            ++it;
+        }
+    }
+    coveragePass++;
+}
+
+bool QuadTreeNew::cachedImportance(const Node &node,double minImport,double &import)
+{
+    const auto it = importCache.find(node.NodeNumber());
+    if (it == importCache.end())
+        return false;
+
+    CachedImportance &cached = it->second;
+    cached.pass = coveragePass;
+    import = cached.importance;
+
+    // Nothing's moved
+    if (cached.drift == 0.0)
+        return true;
+
+    // Screen size goes roughly with the square of the change.
+    // If that can't get us across the cutoff, the old value will do.
+    // Tiles that weren't on screen at all could show up with any move.
+    if (cached.importance > 0.0 && minImport > 0.0 && minImport != MAXFLOAT)
+    {
+        const double bound = (1.0 + cached.drift) * (1.0 + cached.drift);
+        if (cached.importance > minImport * bound || cached.importance * bound < minImport)
+            return true;
+    }
+
+    return false;
+}
+
+double QuadTreeNew::nodeImportance(const Node &node,double minImport)
+{
+    if (!incremental)
+        return importance(node);
+
+    double import = 0.0;
+    if (cachedImportance(node,minImport,import))
+        return import;
+
+    import = importance(node);
+    importCache[node.NodeNumber()] = CachedImportance { import, 0.0, coveragePass };
+    return import;
+}
+
+void QuadTreeNew::batchImportance(const std::vector<Node> &nodes,std::vector<double> &imports)
+{
+    imports.resize(nodes.size());
+    for (size_t ii=0;ii<nodes.size();ii++)
+        imports[ii] = importance(nodes[ii]);
+}
+
+void QuadTreeNew::childImportance(ImportantNode *children,int numChildren,const std::vector<double> &minImportance)
+{
+    // Sort out the ones we actually need to ask about
+    std::vector<Node> toEval;
+    std::vector<int> toEvalIdx;
+    toEval.reserve(numChildren);
+    toEvalIdx.reserve(numChildren);
+    for (int ii=0;ii<numChildren;ii++)
+    {
+        ImportantNode &child = children[ii];
+        child.importance = 0.0;
+        if (child.level < minLevel)
+            continue;
+        if (incremental && cachedImportance(child,minImportance[child.level],child.importance))
+            continue;
+        toEval.push_back(child);
+        toEvalIdx.push_back(ii);
+    }
+    if (toEval.empty())
+        return;
+
+    std::vector<double> imports;
+    batchImportance(toEval,imports);
+
+    for (size_t ii=0;ii<toEval.size();ii++)
+    {
+        ImportantNode &child = children[toEvalIdx[ii]];
+        child.importance = imports[ii];
+        if (incremental)
+            importCache[child.NodeNumber()] = CachedImportance { child.importance, 0.0, coveragePass };
+    }
+}
+
 QuadTreeNew::ImportantNodeSet QuadTreeNew::calcCoverageImportance(const std::vector<double> &minImportance,int maxNodes,bool siblingNodes,std::vector<double> &maxRejectedImport)
 {
+    WKTraceScope("QuadTree calcCoverageImportance");
+
     ImportantNodeSet sortedNodes;
 
     // Start at the lowest level and work our way to higher resolution
@@ -160,8 +299,14 @@ void QuadTreeNew::evalNodeImportance(ImportantNode &node,const std::vector<doubl
         return;
     }
 
-    node.importance = (node.level >= minLevel) ? importance(node) : 0;
+    node.importance = (node.level >= minLevel) ? nodeImportance(node,minImportance[node.level]) : 0;
 
+    evalImportantNode(node,minImportance,importSet,maxRejectedImport);
+}
+
+void QuadTreeNew::evalImportantNode(const ImportantNode &node,const std::vector<double> &minImportance,
+                                    ImportantNodeSet &importSet,std::vector<double> &maxRejectedImport)
+{
     //wkLogLevel(Verbose,"tree %llx node %d:(%d,%d) importance=%f",this,node.level,node.x,node.y,node.importance);
     assert(node.level < minImportance.size() && node.level < maxRejectedImport.size());
 
@@ -183,15 +328,18 @@ void QuadTreeNew::evalNodeImportance(ImportantNode &node,const std::vector<doubl
 
     if (node.level < maxLevel)
     {
-        // Add the children
+        // Work out the children together, then recurse
+        ImportantNode children[4];
         for (int iy=0;iy<2;iy++)
-        {
-            const int indY = 2*node.y + iy;
             for (int ix=0;ix<2;ix++)
-            {
-                ImportantNode childNode(2*node.x + ix, indY,node.level + 1);
-                evalNodeImportance(childNode,minImportance,importSet,maxRejectedImport);
-            }
+                children[iy*2+ix] = ImportantNode(2*node.x + ix,2*node.y + iy,node.level + 1);
+        childImportance(children,4,minImportance);
+
+        for (const auto &childNode : children)
+        {
+            if (UNLIKELY(shutdown))
+                return;
+            evalImportantNode(childNode,minImportance,importSet,maxRejectedImport);
         }
     }
 }
@@ -205,8 +353,9 @@ bool QuadTreeNew::evalNodeVisible(ImportantNode node, const std::vector<double>
         return true;
     }
 
-    // These are used for sorting elsewhere, so let's keep 'em around
-    node.importance = importance(node);
+    // These are used for sorting elsewhere, so let's keep 'em around.
+    // Below the top we only care whether it's zero, which any move can change.
+    node.importance = nodeImportance(node,(node.level == minLevel) ? minImportance[node.level] : 0.0);
 
     if (node.level == minLevel && node.importance < minImportance[node.level])
         return true;
@@ -16,10 +16,17 @@
  *  limitations under the License.
  */
 
+#include <algorithm>
 #include <cstdlib>
 #include <string>
 #include <cstring>
+#include <climits>
 #include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
 #import "RawData.h"
 
 namespace WhirlyKit
@@ -74,7 +81,7 @@ bool RawDataReader::getInt(int &val)
     const size_t dataSize = sizeof(int);
     if (pos+dataSize > rawData->getLen())
         return false;
-    val = *((int *)(rawData->getRawData()+pos));
+    memcpy(&val, rawData->getRawData()+pos, dataSize);
     pos += dataSize;
     
     return true;
@@ -85,7 +92,7 @@ bool RawDataReader::getInt64(int64_t &val)
     const size_t dataSize = sizeof(int64_t);
     if (pos+dataSize > rawData->getLen())
         return false;
-    val = *((int *)(rawData->getRawData()+pos));
+    memcpy(&val, rawData->getRawData()+pos, dataSize);
     pos += dataSize;
 
     return true;
@@ -96,7 +103,7 @@ bool RawDataReader::getDouble(double &val)
     const size_t dataSize = sizeof(double);
     if (pos+dataSize > rawData->getLen())
         return false;
-    val = *((int *)(rawData->getRawData()+pos));
+    memcpy(&val, rawData->getRawData()+pos, dataSize);
     pos += dataSize;
     
     return true;
@@ -115,6 +122,25 @@ bool RawDataReader::getString(std::string &str)
     return true;
 }
 
+bool RawDataReader::getBytes(void *dest,size_t len)
+{
+    const unsigned char *bytes = skipBytes(len);
+    if (!bytes)
+        return false;
+    if (len > 0)
+        memcpy(dest, bytes, len);
+    return true;
+}
+
+const unsigned char *RawDataReader::skipBytes(size_t len)
+{
+    if (len > rawData->getLen() - pos)
+        return nullptr;
+    const unsigned char *bytes = rawData->getRawData() + pos;
+    pos += len;
+    return bytes;
+}
+
 
 MutableRawData::MutableRawData(void *inData,unsigned int size)
 {
@@ -166,6 +192,15 @@ void MutableRawData::addString(const std::string &str)
     memset(&data[start+len], 0, extra);
 }
 
+void MutableRawData::addBytes(const void *bytes,size_t len)
+{
+    if (len == 0)
+        return;
+    const size_t start = data.size();
+    data.resize(start+len);
+    memcpy(&data[start], bytes, len);
+}
+
 RawDataWrapper *RawDataFromFile(FILE *fp,unsigned int dataLen)
 {
     auto *data = new unsigned char[dataLen];
@@ -179,4 +214,163 @@ RawDataWrapper *RawDataFromFile(FILE *fp,unsigned int dataLen)
     return new RawDataWrapper(data,dataLen,true);
 }
 
+bool RawDataIsCompressed(const void *inData,size_t len)
+{
+    if (len < 8)
+        return false;
+    const auto *bytes = (const unsigned char *)inData;
+    switch (bytes[0])
+    {
+        case 0x1f:
+            return bytes[1] == 0x8b;
+        case 0x78:
+            // Compression levels 0-1, 2-5, 6 and 7-9
+            return bytes[1] == 0x01 || bytes[1] == 0x5e || bytes[1] == 0x9c || bytes[1] == 0xda;
+        default:
+            return false;
+    }
+}
+
+bool RawDataInflate(const void *inData,size_t len,std::vector<unsigned char> &out)
+{
+    out.clear();
+    if (!inData || len == 0)
+        return false;
+
+    // Deflate doesn't do better than about 1032:1, so anything past that is a bad trailer
+    const size_t maxRatio = 1032;
+    const auto *bytes = (const unsigned char *)inData;
+    size_t expected = len * 4;
+    if (len >= 18 && bytes[0] == 0x1f && bytes[1] == 0x8b)
+    {
+        // Uncompressed size, mod 2^32, in the last four bytes
+        const uint32_t isize = (uint32_t)bytes[len-4] | ((uint32_t)bytes[len-3] << 8) |
+                               ((uint32_t)bytes[len-2] << 16) | ((uint32_t)bytes[len-1] << 24);
+        if (isize > 0 && isize <= len * maxRatio)
+            expected = isize;
+    }
+
+    z_stream stream;
+    memset(&stream,0,sizeof(stream));
+    // Accept gzip or zlib headers
+    if (inflateInit2(&stream,15 + 32) != Z_OK)
+        return false;
+
+    stream.next_in = (Bytef *)inData;
+    stream.avail_in = (uInt)len;
+    out.resize(std::max(expected,(size_t)1024));
+    int ret = Z_OK;
+    while (ret == Z_OK)
+    {
+        if (stream.total_out == out.size())
+            out.resize(out.size() * 2);
+        stream.next_out = &out[stream.total_out];
+        stream.avail_out = (uInt)(out.size() - stream.total_out);
+        ret = inflate(&stream,Z_NO_FLUSH);
+    }
+    out.resize(stream.total_out);
+    inflateEnd(&stream);
+
+    return ret == Z_STREAM_END;
+}
+
+RawDataMapped::RawDataMapped(void *mapAddr,size_t mapLen,size_t pageOffset,size_t len) :
+    mapAddr(mapAddr), mapLen(mapLen), data((const unsigned char *)mapAddr + pageOffset), len(len)
+{
+}
+
+RawDataMapped::~RawDataMapped()
+{
+    munmap(mapAddr, mapLen);
+}
+
+RawDataMappedRef RawDataMapped::mapFile(const std::string &fileName,Access access,size_t offset,size_t len)
+{
+    const int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return RawDataMappedRef();
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0 || (size_t)fileStat.st_size <= offset)
+    {
+        close(fd);
+        return RawDataMappedRef();
+    }
+    const auto fileSize = (size_t)fileStat.st_size;
+    if (len == 0 || len > fileSize - offset)
+    {
+        len = fileSize - offset;
+    }
+    // Everything else takes the length as a 32 bit value
+    if (len >= UINT_MAX)
+    {
+        close(fd);
+        return RawDataMappedRef();
+    }
+
+    // The mapping has to start on a page boundary
+    const auto pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t mapStart = offset - offset % pageSize;
+    const size_t mapLen = len + (offset - mapStart);
+    void *addr = mmap(nullptr, mapLen, PROT_READ, MAP_PRIVATE, fd, (off_t)mapStart);
+    // The mapping stays good after the file is closed
+    close(fd);
+
+    if (addr == MAP_FAILED)
+    {
+        return RawDataMappedRef();
+    }
+
+    RawDataMappedRef ret(new RawDataMapped(addr, mapLen, offset - mapStart, len));
+    if (access != AccessNormal)
+    {
+        ret->setAccess(access);
+    }
+    return ret;
+}
+
+void RawDataMapped::willRead() const
+{
+    madvise(mapAddr, mapLen, MADV_WILLNEED);
+}
+
+void RawDataMapped::setAccess(Access access) const
+{
+    int advice = MADV_NORMAL;
+    switch (access)
+    {
+        case AccessSequential: advice = MADV_SEQUENTIAL; break;
+        case AccessRandom: advice = MADV_RANDOM; break;
+        default: break;
+    }
+    madvise(mapAddr, mapLen, advice);
+}
+
+void RawDataMapped::willNeed(size_t offset,size_t inLen) const
+{
+    if (offset >= len)
+    {
+        return;
+    }
+    inLen = std::min(inLen, len - offset);
+
+    // Round out to whole pages, which madvise wants
+    const auto pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t start = (size_t)(data - (const unsigned char *)mapAddr) + offset;
+    const size_t pageStart = start - start % pageSize;
+    madvise((unsigned char *)mapAddr + pageStart, start + inLen - pageStart, MADV_WILLNEED);
+}
+
+void RawDataMapped::dontNeed() const
+{
+    madvise(mapAddr, mapLen, MADV_DONTNEED);
+}
+
+RawDataRef RawDataFromMappedFile(const std::string &fileName)
+{
+    return RawDataMapped::mapFile(fileName);
+}
+
 }
@@ -22,11 +22,38 @@
 #include <string>
 #import "WhirlyKitLog.h"
 #import "RawPNGImage.h"
+#import "PNGDecoder.h"
 #import "lodepng.h"
 
+// Set to 0 to send everything through lodepng
+#ifndef WK_FAST_PNG
+#define WK_FAST_PNG 1
+#endif
+
 namespace WhirlyKit
 {
 
+static unsigned char *LodePNGDecode(unsigned int &width,unsigned int &height,
+                                    const unsigned char *data,size_t length,
+                                    int &byteWidth,unsigned int &err)
+{
+    unsigned char *outData = NULL;
+
+    LodePNGState pngState;
+    lodepng_state_init(&pngState);
+    err = lodepng_inspect(&width, &height, &pngState, data, length);
+    if (pngState.info_png.color.colortype == LCT_GREY) {
+        byteWidth = 1;
+        err = lodepng_decode_memory(&outData, &width, &height, data, length, LCT_GREY, 8);
+    } else {
+        byteWidth = 4;
+        err = lodepng_decode_memory(&outData, &width, &height, data, length, LCT_RGBA, 8);
+    }
+    lodepng_state_cleanup(&pngState);
+
+    return outData;
+}
+
 unsigned char *RawPNGImageLoaderInterpreter(unsigned int &width,unsigned int &height,
                                           const unsigned char *data,size_t length,
                                           const std::vector<int> &valueMap,
@@ -36,16 +63,14 @@ unsigned char *RawPNGImageLoaderInterpreter(unsigned int &width,unsigned int &he
     unsigned char *outData = NULL;
 
     try {
-        LodePNGState pngState;
-        lodepng_state_init(&pngState);
-        err = lodepng_inspect(&width, &height, &pngState, data, length);
-        if (pngState.info_png.color.colortype == LCT_GREY) {
-            byteWidth = 1;
-            err = lodepng_decode_memory(&outData, &width, &height, data, length, LCT_GREY, 8);
-        } else {
-            byteWidth = 4;
-            err = lodepng_decode_memory(&outData, &width, &height, data, length, LCT_RGBA, 8);
-        }
+#if WK_FAST_PNG
+        // Handles the usual data tiles.  Anything else comes back empty and goes to lodepng.
+        outData = DecodePNGFast(data, length, width, height, byteWidth);
+        if (outData)
+            err = 0;
+#endif
+        if (!outData)
+            outData = LodePNGDecode(width, height, data, length, byteWidth, err);
     }
     catch (const std::exception &ex) {
         wkLogLevel(Error, "Exception in MaplyQuadImageLoader::dataForTile: %s", ex.what());
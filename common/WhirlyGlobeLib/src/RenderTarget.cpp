@@ -50,6 +50,8 @@ void RenderTarget::init()
     clearColor[0] = 0.0; clearColor[1] = 0.0; clearColor[2] = 0.0; clearColor[3] = 0.0;
     clearVal = 0.0;
     calcMinMax = false;
+    renderWhenChanged = false;
+    dirty = true;
     mipmapType = RenderTargetMipmapNone;
 }
 
@@ -58,8 +60,40 @@ int RenderTarget::numLevels()
     return 0;
 }
 
-AddRenderTargetReq::AddRenderTargetReq(SimpleIdentity renderTargetID,int width,int height,SimpleIdentity texID,bool clearEveryFrame,bool blend,const RGBAColor &clearColor, float clearVal, RenderTargetMipmapType mipmapType, bool calcMinMax)
-: renderTargetID(renderTargetID), width(width), height(height), texID(texID), clearEveryFrame(clearEveryFrame), blend(blend), clearColor(clearColor), clearVal(clearVal), mipmapType(mipmapType), calcMinMax(calcMinMax)
+float RenderTargetHistogram::percentile(double frac) const
+{
+    if (bins.empty() || numPixels == 0)
+        return minVal;
+
+    const double binSize = (maxVal - minVal) / bins.size();
+    const double target = std::min(std::max(frac,0.0),1.0) * numPixels;
+    double sum = 0.0;
+    for (unsigned int ii=0;ii<bins.size();ii++)
+    {
+        const double next = sum + bins[ii];
+        if (next >= target && bins[ii] > 0)
+            return (float)(minVal + binSize * (ii + (target - sum) / bins[ii]));
+        sum = next;
+    }
+
+    return maxVal;
+}
+
+float RenderTargetHistogram::mean() const
+{
+    if (bins.empty() || numPixels == 0)
+        return minVal;
+
+    const double binSize = (maxVal - minVal) / bins.size();
+    double total = 0.0;
+    for (unsigned int ii=0;ii<bins.size();ii++)
+        total += bins[ii] * (minVal + binSize * (ii + 0.5));
+
+    return (float)(total / numPixels);
+}
+
+AddRenderTargetReq::AddRenderTargetReq(SimpleIdentity renderTargetID,int width,int height,SimpleIdentity texID,bool clearEveryFrame,bool blend,const RGBAColor &clearColor, float clearVal, RenderTargetMipmapType mipmapType, bool calcMinMax, bool renderWhenChanged)
+: renderTargetID(renderTargetID), width(width), height(height), texID(texID), clearEveryFrame(clearEveryFrame), blend(blend), clearColor(clearColor), clearVal(clearVal), mipmapType(mipmapType), calcMinMax(calcMinMax), renderWhenChanged(renderWhenChanged)
 {
 }
 
@@ -79,6 +113,7 @@ void AddRenderTargetReq::execute(Scene *scene,SceneRenderer *renderer,View *view
     renderTarget->blendEnable = blend;
     renderTarget->setMipmap(mipmapType);
     renderTarget->calcMinMax = calcMinMax;
+    renderTarget->setRenderWhenChanged(renderWhenChanged);
     renderTarget->init(renderer,scene,texID);
     
     renderer->addRenderTarget(std::move(renderTarget));
@@ -97,6 +132,7 @@ void ChangeRenderTargetReq::execute(Scene *scene,SceneRenderer *renderer,View *v
         if (renderTarget->getId() == renderTargetID)
         {
             renderTarget->setTargetTexture(renderer,scene,texID);
+            renderTarget->markDirty();
             break;
         }
     }
@@ -186,6 +186,44 @@ bool RenderTargetGLES::initFromState(int inWidth,int inHeight)
     return true;
 }
 
+bool RenderTargetGLES::initOffscreen(int inWidth,int inHeight)
+{
+    width = inWidth;
+    height = inHeight;
+
+    if (framebuffer == 0)
+        glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    CheckGLError("RenderTarget: glBindFramebuffer");
+
+    if (colorbuffer == 0)
+        glGenRenderbuffers(1, &colorbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    CheckGLError("RenderTarget: glRenderbufferStorage");
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorbuffer);
+    CheckGLError("RenderTarget: glFramebufferRenderbuffer");
+
+    if (depthbuffer == 0)
+        glGenRenderbuffers(1, &depthbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width, height);
+    CheckGLError("RenderTarget: glRenderbufferStorage");
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthbuffer);
+    CheckGLError("RenderTarget: glFramebufferRenderbuffer");
+
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        wkLogLevel(Error,"Failed to build valid offscreen render target: %x", status);
+        return false;
+    }
+
+    isSetup = false;
+    return true;
+}
+
 void RenderTargetGLES::clear()
 {
     if (colorbuffer)
@@ -194,6 +232,9 @@ void RenderTargetGLES::clear()
         glDeleteRenderbuffers(1,&depthbuffer);
     if (framebuffer)
         glDeleteFramebuffers(1,&framebuffer);
+    colorbuffer = 0;
+    depthbuffer = 0;
+    framebuffer = 0;
 }
 
 void RenderTargetGLES::setActiveFramebuffer(SceneRendererGLES *renderer)
@@ -212,10 +253,10 @@ void RenderTargetGLES::setActiveFramebuffer(SceneRendererGLES *renderer)
     {
         if (blendEnable)
         {
-            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-            glEnable(GL_BLEND);
+            renderer->stateCache.setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            renderer->stateCache.setBlend(true);
         } else {
-            glDisable(GL_BLEND);
+            renderer->stateCache.setBlend(false);
         }
         glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
         
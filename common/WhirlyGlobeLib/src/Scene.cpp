@@ -16,6 +16,9 @@
  *  limitations under the License.
  */
 
+#import <unordered_set>
+#import <typeindex>
+#import <tuple>
 #import "WhirlyKitLog.h"
 #import "Scene.h"
 #import "GlobeView.h"
@@ -25,6 +28,7 @@
 #import "FontTextureManager.h"
 #import "SelectionManager.h"
 #import "IntersectionManager.h"
+#import "ElevationManager.h"
 #import "LayoutManager.h"
 #import "ShapeManager.h"
 #import "MarkerManager.h"
@@ -89,6 +93,10 @@ Scene::Scene(CoordSystemDisplayAdapter *adapter) :
     addManager(kWKSelectionManager,std::make_shared<SelectionManager>(this));
     // Intersection handling
     addManager(kWKIntersectionManager, std::make_shared<IntersectionManager>(this));
+    // Elevation tiles for terrain heights.  After intersection, which it registers with.
+    const auto elevManager = std::make_shared<ElevationManager>();
+    addManager(kWKElevationManager, elevManager);
+    memoryGovernor.addConsumer(elevManager);
     // Layout manager handles text and icon layout
     addManager(kWKLayoutManager, std::make_shared<LayoutManager>());
     // Shape manager handles circles, spheres and such
@@ -128,7 +136,6 @@ Scene::~Scene()
             std::unique_lock<std::mutex>(coordAdapterLock, std::try_to_lock),
             std::unique_lock<std::mutex>(drawablesLock, std::try_to_lock),
             std::unique_lock<std::mutex>(textureLock, std::try_to_lock),
-            std::unique_lock<std::mutex>(changeRequestLock, std::try_to_lock),
             std::unique_lock<std::mutex>(subTexLock, std::try_to_lock),
             std::unique_lock<std::mutex>(managerLock, std::try_to_lock),
             std::unique_lock<std::mutex>(programLock, std::try_to_lock),
@@ -174,6 +181,7 @@ Scene::~Scene()
 #endif
 
     auto theChangeRequests = std::move(changeRequests);
+    changeQueue.drain(theChangeRequests);
     for (auto *theChangeRequest : theChangeRequests)
     {
         delete theChangeRequest;
@@ -185,6 +193,7 @@ Scene::~Scene()
         delete theChangeRequest;
     }
     timedChangeRequests.clear();
+    publishPendingChanges();
 
     activeModels.clear();
     
@@ -231,40 +240,72 @@ void Scene::setDisplayAdapter(CoordSystemDisplayAdapter *newCoordAdapter)
 // Add change requests to our list
 void Scene::addChangeRequests(ChangeSet &newChanges)
 {
-    std::lock_guard<std::mutex> guardLock(changeRequestLock);
+    changeQueue.push(newChanges);
+}
+
+// Add a single change request
+void Scene::addChangeRequest(ChangeRequest *newChange)
+{
+    changeQueue.push(newChange);
+}
+
+// Sort out the incoming changes on the rendering thread
+void Scene::pullChangeRequests()
+{
+    if (changeQueue.empty())
+        return;
+
+    ChangeSet newChanges;
+    changeQueue.drain(newChanges);
+
+    changeRequests.reserve(changeRequests.size() + newChanges.size());
     for (ChangeRequest *change : newChanges) {
         if (change && change->when > 0.0)
             timedChangeRequests.insert(change);
         else
             changeRequests.push_back(change);
     }
-    newChanges.clear();
+
+    publishPendingChanges();
 }
 
-// Add a single change request
-void Scene::addChangeRequest(ChangeRequest *newChange)
+void Scene::publishPendingChanges()
 {
-    std::lock_guard<std::mutex> guardLock(changeRequestLock);
-
-    if (newChange && newChange->when > 0.0)
-        timedChangeRequests.insert(newChange);
-    else
-        changeRequests.push_back(newChange);
+    numPendingChanges.store((int)changeRequests.size(), std::memory_order_relaxed);
+    nextTimedChange.store(timedChangeRequests.empty() ? 0.0 : (*timedChangeRequests.begin())->when,
+                          std::memory_order_relaxed);
 }
 
 int Scene::getNumChangeRequests() const
 {
-    std::lock_guard<std::mutex> guardLock(changeRequestLock);
-
-    return changeRequests.size();
+    return numPendingChanges.load(std::memory_order_relaxed) + changeQueue.size();
 }
 
 DrawableRef Scene::getDrawable(SimpleIdentity drawId) const
 {
     std::lock_guard<std::mutex> guardLock(drawablesLock);
     
-    const auto it = drawables.find(drawId);
-    return (it != drawables.end()) ? it->second : DrawableRef();
+    const auto it = drawableHandles.find(drawId);
+    if (it == drawableHandles.end())
+        return DrawableRef();
+    const DrawableRef *draw = drawables.get(it->second);
+    return draw ? *draw : DrawableRef();
+}
+
+SlotHandle Scene::getDrawableHandle(SimpleIdentity drawId) const
+{
+    std::lock_guard<std::mutex> guardLock(drawablesLock);
+
+    const auto it = drawableHandles.find(drawId);
+    return (it != drawableHandles.end()) ? it->second : EmptySlotHandle;
+}
+
+DrawableRef Scene::getDrawableByHandle(SlotHandle handle) const
+{
+    std::lock_guard<std::mutex> guardLock(drawablesLock);
+
+    const DrawableRef *draw = drawables.get(handle);
+    return draw ? *draw : DrawableRef();
 }
     
 void Scene::addLocalMbr(const Mbr &localMbr)
@@ -357,14 +398,30 @@ TextureBaseRef Scene::getTexture(SimpleIdentity texId) const
     return (it != textures.end()) ? it->second : TextureBaseRef();
 }
 
+std::vector<SimpleIdentity> Scene::redirectTexture(const TextureBaseRef &oldTex,const TextureBaseRef &newTex)
+{
+    std::lock_guard<std::mutex> guardLock(textureLock);
+
+    std::vector<SimpleIdentity> ids;
+    for (auto &it : textures)
+    {
+        if (it.second == oldTex)
+        {
+            it.second = newTex;
+            ids.push_back(it.first);
+        }
+    }
+    return ids;
+}
+
 std::vector<Drawable *> Scene::getDrawables() const
 {
     std::vector<Drawable *> retDraws;
     retDraws.reserve(drawables.size());
     
     std::lock_guard<std::mutex> guardLock(drawablesLock);
-    for (const auto& it : drawables) {
-        retDraws.push_back(it.second.get());
+    for (const auto& draw : drawables) {
+        retDraws.push_back(draw.get());
     }
     
     return retDraws;
@@ -400,20 +457,19 @@ int Scene::preProcessChanges(WhirlyKit::View *view,SceneRenderer *renderer,__unu
 {
     ChangeSet preRequests;
 
+    pullChangeRequests();
+
+    // Just doing the ones that require a pre-process
+    for (auto &req : changeRequests)
     {
-        std::lock_guard<std::mutex> guardLock(changeRequestLock);
-        // Just doing the ones that require a pre-process
-        for (auto &req : changeRequests)
+        if (req && req->needPreExecute())
         {
-            if (req && req->needPreExecute())
-            {
-                preRequests.push_back(req);
-                req = nullptr;
-            }
+            preRequests.push_back(req);
+            req = nullptr;
         }
     }
 
-    // Run these outside of the lock, since they might use the lock
+    // These may add more changes, which will go through the queue
     for (auto &req : preRequests)
     {
         req->execute(this,renderer,view);
@@ -427,68 +483,200 @@ int Scene::preProcessChanges(WhirlyKit::View *view,SceneRenderer *renderer,__unu
 }
 
 // Process outstanding changes.
-// We'll grab the lock and we're only expecting to be called in the rendering thread
-int Scene::processChanges(WhirlyKit::View *view,SceneRenderer *renderer,TimeInterval now)
+// We're only expecting to be called in the rendering thread
+int Scene::processChanges(WhirlyKit::View *view,SceneRenderer *renderer,TimeInterval now,bool sameFrame)
 {
-    // Set up a local collection of approximately the same capacity before locking
-    decltype(changeRequests) localChanges;
+    WKTraceScope("Scene processChanges");
+
+    pullChangeRequests();
+
+    // See if any of the timed changes are ready
+    if (!timedChangeRequests.empty())
+    {
+        // Establish the range of changes to be moved
+        const auto beg = timedChangeRequests.begin();
+        auto end = beg;
+        while (end != timedChangeRequests.end() && (*end)->when <= now)
+        {
+            ++end;
+        }
+
+        // Move them
+        if (end != beg)
+        {
+            changeRequests.insert(changeRequests.end(),
+                                  std::make_move_iterator(beg),
+                                  std::make_move_iterator(end));
+            timedChangeRequests.erase(beg, end);
+        }
+    }
+
+    // Move the outstanding changes to a local collection.
+    // Executing them may add more, which we'll get next time.
+    ChangeSet localChanges;
     localChanges.reserve(changeRequests.capacity());
+    localChanges.swap(changeRequests);
+
+    const TimeInterval timeBudget = changeTimeBudget;
+    const size_t byteBudget = changeByteBudget;
+    const bool budgeted = timeBudget > 0.0 || byteBudget > 0;
+    const TimeInterval startTime = budgeted ? TimeGetCurrent() : 0.0;
+    size_t bytesUsed = 0;
+
+    // The budget is per frame, so a second call in the same frame carries on from the first
+    if (!sameFrame)
+    {
+        frameChangeTime = 0.0;
+        frameChangeBytes = 0;
+    }
+    const auto isOverBudget = [&]()
+    {
+        return (byteBudget > 0 && frameChangeBytes + bytesUsed >= byteBudget) ||
+               (timeBudget > 0.0 && frameChangeTime + (TimeGetCurrent() - startTime) >= timeBudget);
+    };
+    bool overBudget = budgeted && sameFrame && isOverBudget();
 
+    // Once we're over budget, anything we hold back is tracked so later changes
+    //  to the same drawable or texture are held back too.
+    ChangeSet deferred;
+    std::unordered_set<SimpleIdentity> deferredIDs;
+    bool deferAll = false;
+
+    int processed = 0;
+    for (auto &req : localChanges)
     {
-        std::lock_guard<std::mutex> guardLock(changeRequestLock);
+        if (!req)
+        {
+            continue;
+        }
 
-        // See if any of the timed changes are ready
-        if (!timedChangeRequests.empty())
+        if (overBudget)
         {
-            // Establish the range of changes to be moved
-            const auto beg = timedChangeRequests.begin();
-            auto end = beg;
-            while (end != timedChangeRequests.end() && (*end)->when <= now)
+            const SimpleIdentity targetID = req->getTargetID();
+            if (deferAll || targetID == EmptyIdentity ||
+                req->getPriority() != ChangeRequest::PriorityHigh ||
+                deferredIDs.find(targetID) != deferredIDs.end())
             {
-                ++end;
+                // We can't tell what a change without a target depends on, so everything after it waits
+                if (targetID == EmptyIdentity)
+                    deferAll = true;
+                else
+                    deferredIDs.insert(targetID);
+                // Changes to anything merged into a drawable have to wait for it too
+                const auto *addReq = dynamic_cast<AddDrawableReq *>(req);
+                if (const auto *basicDraw = addReq ? dynamic_cast<BasicDrawable *>(addReq->getDrawable().get()) : nullptr)
+                {
+                    for (const auto &range : basicDraw->getMergedRanges())
+                        deferredIDs.insert(range.drawID);
+                }
+                deferred.push_back(req);
+                req = nullptr;
+                continue;
             }
+        }
 
-            // Move them
-            if (end != beg)
-            {
-                changeRequests.insert(changeRequests.end(),
-                                      std::make_move_iterator(beg),
-                                      std::make_move_iterator(end));
-                timedChangeRequests.erase(beg, end);
-            }
+        bytesUsed += req->getUploadSize();
+
+        req->execute(this,renderer,view);
+        delete req;
+        req = nullptr;
+        processed++;
+
+        if (budgeted && !overBudget)
+        {
+            overBudget = isOverBudget();
         }
+    }
+    localChanges.clear();
 
-        // Move the outstanding changes to the local collection and release the lock
-        localChanges.swap(changeRequests);
+    uploadBytes += bytesUsed;
+    frameChangeBytes += bytesUsed;
+    if (budgeted)
+    {
+        frameChangeTime += TimeGetCurrent() - startTime;
     }
 
-    for (auto &req : localChanges)
+    // What's left goes first next time
+    numDeferredChanges = (int)deferred.size();
+    changeRequests.swap(deferred);
+    publishPendingChanges();
+
+    // Most of those were allocated on other threads, give the memory back in one go
+    if (processed > 0)
     {
-        if (req)
+        ChangeRequest::releasePoolCache();
+    }
+
+    return processed;
+}
+
+int Scene::runActiveModels(RendererFrameInfo *frameInfo)
+{
+    WKTraceScope("Scene runActiveModels");
+
+    ChangeSet changes;
+    for (const auto &model : activeModels)
+    {
+        model->batchUpdateForFrame(frameInfo,changes);
+    }
+    if (changes.empty())
+    {
+        return 0;
+    }
+
+    // Animations tend to set the same thing over and over
+    compactChanges(changes);
+
+    SceneRenderer *renderer = frameInfo->sceneRenderer;
+    const RenderSetupInfo *setupInfo = renderer ? renderer->getRenderSetupInfo() : nullptr;
+
+    ChangeSet timed;
+    int processed = 0;
+    for (ChangeRequest *req : changes)
+    {
+        if (!req)
         {
-            req->execute(this,renderer,view);
-            delete req;
-            req = nullptr;
+            continue;
+        }
+        if (req->when > 0.0)
+        {
+            timed.push_back(req);
+            continue;
         }
+
+        req->setupForRenderer(setupInfo,this);
+        req->execute(this,renderer,frameInfo->theView);
+        delete req;
+        processed++;
+    }
+
+    if (!timed.empty())
+    {
+        addChangeRequests(timed);
     }
 
-    const auto processed = (int)localChanges.size();
-    localChanges.clear();
     return processed;
 }
+
+bool Scene::setUniBlock(SimpleIdentity drawID,const BasicDrawable::UniformBlock &uniBlock)
+{
+    return SetDrawableUniBlock(getDrawable(drawID),uniBlock);
+}
+
+void Scene::setChangeBudget(TimeInterval maxTime,size_t maxBytes)
+{
+    changeTimeBudget = std::max(maxTime,0.0);
+    changeByteBudget = maxBytes;
+}
     
 bool Scene::hasChanges(TimeInterval now) const
 {
-    bool changes = false;
-    std::unique_lock<std::mutex> lock(changeRequestLock,std::try_to_lock);
-    if (lock.owns_lock())
-    {
-        changes = !changeRequests.empty();
-        
-        if (!changes && !timedChangeRequests.empty())
-            changes = now >= (*timedChangeRequests.begin())->when;
+    bool changes = !changeQueue.empty() || numPendingChanges.load(std::memory_order_relaxed) > 0;
 
-        lock.unlock();
+    if (!changes)
+    {
+        const TimeInterval nextTimed = nextTimedChange.load(std::memory_order_relaxed);
+        changes = nextTimed > 0.0 && now >= nextTimed;
     }
     
     // How about the active models?
@@ -555,12 +743,92 @@ SubTexture Scene::getSubTexture(SimpleIdentity subTexId) const
     
     return *it;
 }
+
+SimpleIdentity Scene::retainSharedImage(uint64_t contentHash)
+{
+    if (contentHash == 0)
+        return EmptyIdentity;
+
+    std::lock_guard<std::mutex> guardLock(sharedImageLock);
+    const auto it = sharedImages.find(contentHash);
+    if (it == sharedImages.end())
+        return EmptyIdentity;
+
+    it->second.second++;
+    return it->second.first;
+}
+
+void Scene::addSharedImage(uint64_t contentHash,SimpleIdentity texID)
+{
+    if (contentHash == 0 || texID == EmptyIdentity)
+        return;
+
+    std::lock_guard<std::mutex> guardLock(sharedImageLock);
+    // Somebody beat us to it, so leave theirs as the shared one
+    if (sharedImages.find(contentHash) != sharedImages.end())
+        return;
+    sharedImages[contentHash] = std::make_pair(texID,1);
+    sharedImageHashes[texID] = contentHash;
+}
+
+bool Scene::releaseSharedImage(SimpleIdentity texID)
+{
+    std::lock_guard<std::mutex> guardLock(sharedImageLock);
+    const auto hashIt = sharedImageHashes.find(texID);
+    if (hashIt == sharedImageHashes.end())
+        return true;
+
+    const auto it = sharedImages.find(hashIt->second);
+    if (it != sharedImages.end() && --it->second.second > 0)
+        return false;
+
+    if (it != sharedImages.end())
+        sharedImages.erase(it);
+    sharedImageHashes.erase(hashIt);
+    return true;
+}
     
+// Broad kinds of drawable, for the memory ledger
+static const char *DrawableLedgerType(const Drawable *draw)
+{
+    if (dynamic_cast<const BasicDrawableInstance *>(draw))
+        return "instance";
+    if (const auto basicDraw = dynamic_cast<const BasicDrawable *>(draw))
+        return basicDraw->isScreenSpace() ? "screenSpace" : "basic";
+    if (dynamic_cast<const ParticleSystemDrawable *>(draw))
+        return "particles";
+    return "other";
+}
+
 void Scene::addDrawable(DrawableRef draw)
 {
+    // It's set up for the renderer by now, so the sizes are real
+    size_t cpuBytes = 0, gpuBytes = 0;
+    draw->getMemoryBytes(cpuBytes,gpuBytes);
+    memoryLedger.add(draw->getId(),draw->getName(),DrawableLedgerType(draw.get()),cpuBytes,gpuBytes);
+
     std::lock_guard<std::mutex> guardLock(drawablesLock);
 
-    drawables[draw->getId()] = std::move(draw);
+    // Replace an existing one with the same ID
+    const SimpleIdentity drawId = draw->getId();
+    const auto it = drawableHandles.find(drawId);
+    if (it != drawableHandles.end())
+    {
+        if (DrawableRef *existing = drawables.get(it->second))
+        {
+            *existing = std::move(draw);
+            return;
+        }
+    }
+
+    // Requests for the drawables merged into this one need to find it
+    if (const auto *basicDraw = dynamic_cast<BasicDrawable *>(draw.get()))
+    {
+        for (const auto &range : basicDraw->getMergedRanges())
+            mergedDrawIDs[range.drawID] = drawId;
+    }
+
+    drawableHandles[drawId] = drawables.insert(std::move(draw));
 }
     
 void Scene::remDrawable(const DrawableRef &draw)
@@ -569,16 +837,53 @@ void Scene::remDrawable(const DrawableRef &draw)
 }
 
 void Scene::remDrawable(SimpleIdentity id)
+{
+    memoryLedger.remove(id);
+
+    std::lock_guard<std::mutex> guardLock(drawablesLock);
+
+    const auto it = drawableHandles.find(id);
+    if (it != drawableHandles.end())
+    {
+        if (const DrawableRef *draw = drawables.get(it->second))
+        {
+            if (const auto *basicDraw = dynamic_cast<BasicDrawable *>(draw->get()))
+            {
+                for (const auto &range : basicDraw->getMergedRanges())
+                    mergedDrawIDs.erase(range.drawID);
+            }
+        }
+        drawables.erase(it->second);
+        drawableHandles.erase(it);
+    }
+}
+
+DrawableRef Scene::getMergedDrawable(SimpleIdentity drawId) const
 {
     std::lock_guard<std::mutex> guardLock(drawablesLock);
 
-    const auto it = drawables.find(id);
-    if (it != drawables.end())
-        drawables.erase(it);
+    const auto mergedIt = mergedDrawIDs.find(drawId);
+    if (mergedIt == mergedDrawIDs.end())
+        return DrawableRef();
+    const auto it = drawableHandles.find(mergedIt->second);
+    if (it == drawableHandles.end())
+        return DrawableRef();
+    const DrawableRef *draw = drawables.get(it->second);
+    return draw ? *draw : DrawableRef();
+}
+
+void Scene::remMergedDrawable(SimpleIdentity drawId)
+{
+    std::lock_guard<std::mutex> guardLock(drawablesLock);
+
+    mergedDrawIDs.erase(drawId);
 }
 
 void Scene::addTexture(TextureBaseRef texRef)
 {
+    const bool dynamic = dynamic_cast<const DynamicTexture *>(texRef.get()) != nullptr;
+    memoryLedger.add(texRef->getId(),texRef->getName(),dynamic ? "dynamicTexture" : "texture",0,texRef->getGPUBytes());
+
     std::lock_guard<std::mutex> guardLock(textureLock);
     
     textures[texRef->getId()] = std::move(texRef);
@@ -586,6 +891,8 @@ void Scene::addTexture(TextureBaseRef texRef)
 
 bool Scene::removeTexture(SimpleIdentity texID)
 {
+    memoryLedger.remove(texID);
+
     std::lock_guard<std::mutex> guardLock(textureLock);
     
     const auto it = textures.find(texID);
@@ -608,6 +915,14 @@ void Scene::dumpStats() const
 void Scene::setFontTextureManager(const FontTextureManagerRef &newManager)
 {
     fontTextureManager = newManager;
+    memoryGovernor.addConsumer(newManager);
+}
+
+void Scene::trimMemory(PlatformThreadInfo *inst,MemoryTrimLevel level)
+{
+    ChangeSet changes;
+    memoryGovernor.trim(inst,level,changes);
+    addChangeRequests(changes);
 }
 
 Program *Scene::getProgram(SimpleIdentity progId)
@@ -701,10 +1016,16 @@ float Scene::getZoomSlotValue(int zoomSlot) const
     return (zoomSlot < 0 || zoomSlot >= MaplyMaxZoomSlots) ? 0.0f : zoomSlots[zoomSlot];
 }
 
-void Scene::copyZoomSlots(float *dest) const
+uint32_t Scene::copyZoomSlots(float *dest) const
 {
     std::lock_guard<std::mutex> guardLock(zoomSlotLock);
     std::copy(&zoomSlots[0], &zoomSlots[MaplyMaxZoomSlots], dest);
+
+    uint32_t mask = 0;
+    for (int ii=0;ii<MaplyMaxZoomSlots;ii++)
+        if (zoomSlots[ii] != MAXFLOAT)
+            mask |= 1u << ii;
+    return mask;
 }
 
 void Scene::copyZoomSlotsFrom(const Scene *otherScene, float offset)
@@ -737,6 +1058,17 @@ TextureBase *AddTextureReq::getTex() const
 {
     return texRef.get();
 }
+
+size_t AddTextureReq::getUploadSize() const
+{
+    const auto tex = dynamic_cast<const Texture *>(texRef.get());
+    return (tex && tex->texData) ? tex->texData->getLen() : 0;
+}
+
+SimpleIdentity AddTextureReq::getTargetID() const
+{
+    return texRef ? texRef->getId() : EmptyIdentity;
+}
     
 AddTextureReq::~AddTextureReq()
 {
@@ -746,6 +1078,8 @@ AddTextureReq::~AddTextureReq()
 void AddTextureReq::execute(Scene *scene,SceneRenderer *renderer,WhirlyKit::View *view)
 {
     texRef->createInRenderer(renderer->getRenderSetupInfo());
+    if (texRef->getAsyncUpload())
+        texRef->finishUploadInRenderer(renderer);
     scene->addTexture(texRef);
     texRef = nullptr;
 }
@@ -755,6 +1089,12 @@ void RemTextureReq::execute(Scene *scene,SceneRenderer *renderer,WhirlyKit::View
     TextureBaseRef tex = scene->getTexture(texture);
     if (tex)
     {
+        // A redirected ID doesn't own the texture it points to
+        if (tex->getId() != texture)
+        {
+            scene->removeTexture(texture);
+            return;
+        }
         if (auto info = renderer->getTeardownInfo())
         {
             info->destroyTexture(renderer,tex);
@@ -781,6 +1121,11 @@ AddDrawableReq::~AddDrawableReq()
     drawRef = nullptr;
 }
 
+SimpleIdentity AddDrawableReq::getTargetID() const
+{
+    return drawRef ? drawRef->getId() : EmptyIdentity;
+}
+
 void AddDrawableReq::execute(Scene *scene,SceneRenderer *renderer,WhirlyKit::View *view)
 {
     // If this is an instance, deal with that madness
@@ -839,6 +1184,16 @@ void RemDrawableReq::execute(Scene *scene,SceneRenderer *renderer,WhirlyKit::Vie
         renderer->removeDrawable(draw, true, renderer->getTeardownInfo());
         scene->remDrawable(draw);
     }
+    else if (const auto merged = std::dynamic_pointer_cast<BasicDrawable>(scene->getMergedDrawable(drawID)))
+    {
+        // Just our part of it, unless we were the last
+        scene->remMergedDrawable(drawID);
+        if (merged->removeMerged(drawID) == 0)
+        {
+            renderer->removeDrawable(merged, true, renderer->getTeardownInfo());
+            scene->remDrawable(merged);
+        }
+    }
     else
     {
         wkLogLevel(Warn,"Missing drawable for RemDrawableReq: %llu", drawID);
@@ -878,6 +1233,90 @@ void SetZoomSlotReq::execute(Scene *scene,SceneRenderer *renderer,View *view)
         scene->setZoomSlotValue(zoomSlot, zoomVal);
 }
 
+int compactChanges(ChangeSet &changes)
+{
+    if (changes.size() < 2)
+        return 0;
+
+    // Type, target and slot of a change that sets some state
+    typedef std::tuple<std::type_index,SimpleIdentity,int> CoalesceKey;
+    std::map<CoalesceKey,size_t> lastStates;
+    // Adds which haven't been matched with a remove
+    std::unordered_map<SimpleIdentity,size_t> pendingAdds;
+
+    // Note: Null entries are flush requests and have to stay put
+    std::vector<bool> dropped(changes.size(),false);
+    int numDropped = 0;
+    const auto drop = [&](size_t which)
+    {
+        if (!dropped[which])
+        {
+            delete changes[which];
+            changes[which] = nullptr;
+            dropped[which] = true;
+            numDropped++;
+        }
+    };
+
+    for (size_t ii=0;ii<changes.size();ii++)
+    {
+        ChangeRequest *change = changes[ii];
+        if (!change || change->when > 0.0)
+            continue;
+        const SimpleIdentity targetID = change->getTargetID();
+        if (targetID == EmptyIdentity)
+            continue;
+
+        if (dynamic_cast<AddDrawableReq *>(change) || dynamic_cast<AddTextureReq *>(change))
+        {
+            pendingAdds[targetID] = ii;
+            continue;
+        }
+
+        if (dynamic_cast<RemDrawableReq *>(change) || dynamic_cast<RemTextureReq *>(change))
+        {
+            const auto it = pendingAdds.find(targetID);
+            if (it != pendingAdds.end())
+            {
+                // Nobody's going to see this one, so skip the whole thing
+                for (size_t jj=it->second;jj<=ii;jj++)
+                {
+                    ChangeRequest *other = changes[jj];
+                    if (other && other->when == 0.0 && other->getTargetID() == targetID)
+                        drop(jj);
+                }
+                pendingAdds.erase(it);
+            }
+            continue;
+        }
+
+        const int slot = change->getCoalesceSlot();
+        if (slot >= 0)
+        {
+            const auto key = std::make_tuple(std::type_index(typeid(*change)),targetID,slot);
+            const auto res = lastStates.insert(std::make_pair(key,ii));
+            if (!res.second)
+            {
+                drop(res.first->second);
+                res.first->second = ii;
+            }
+        }
+    }
+
+    if (numDropped > 0)
+    {
+        size_t out = 0;
+        for (size_t ii=0;ii<changes.size();ii++)
+        {
+            if (!dropped[ii])
+                changes[out++] = changes[ii];
+        }
+        changes.resize(out);
+    }
+
+    return numDropped;
+}
+
 
 
 }
@@ -48,11 +48,12 @@ GLuint SceneGLES::getGLTexture(SimpleIdentity texIdent)
 
 void SceneGLES::teardown(PlatformThreadInfo* threadInfo)
 {
-    for (const auto& it : drawables)
+    for (const auto& draw : drawables)
     {
-        it.second->teardownForRenderer(setupInfo,this, nullptr);
+        draw->teardownForRenderer(setupInfo,this, nullptr);
     }
     drawables.clear();
+    drawableHandles.clear();
 
     for (const auto& it : textures)
     {
@@ -18,8 +18,10 @@
  *
  */
 
+#import <cfloat>
 #import "SceneGraphManager.h"
 #import "SceneRenderer.h"
+#import "TaskScheduler.h"
 #import "WhirlyKitLog.h"
 
 using namespace Eigen;
@@ -94,6 +96,59 @@ void SceneGraphLOD::traverseNodeDrawables(SceneGraphManager *manage,const Point3
         SceneGraphGroup::traverseNodeDrawables(manage, localPt, nodes, toDraw);
 }
 
+SceneGraphPagedLOD::SceneGraphPagedLOD(LoadFunc loadFn,const Point3f &center,float radius,float geomError) :
+    center(center), radius(radius), geomError(geomError),
+    loadFn(std::move(loadFn)), state(Unloaded), memSize(0), lastUsed(-1)
+{
+}
+
+SceneGraphPagedLOD::~SceneGraphPagedLOD()
+{
+    if (load)
+        load->cancel = true;
+}
+
+void SceneGraphPagedLOD::traverseNodeDrawables(SceneGraphManager *manage,const Point3f &localPt,const std::set<SceneGraphNode *> &siblingNodes,SimpleIDSet &toDraw)
+{
+    lastUsed = manage->getFrame();
+
+    const float error = manage->screenError(center,radius,geomError,localPt);
+    if (state != Loaded)
+    {
+        manage->requestLoad(this,error);
+        return;
+    }
+
+    // Switch to the children if we're too coarse, but only once they're all in
+    bool refine = error > manage->getMaxScreenError() && !nodes.empty();
+    if (refine)
+    {
+        for (auto node : nodes)
+        {
+            if (auto paged = dynamic_cast<SceneGraphPagedLOD *>(node))
+            {
+                if (!paged->isLoaded())
+                {
+                    paged->lastUsed = lastUsed;
+                    manage->requestLoad(paged,manage->screenError(paged->center,paged->radius,paged->geomError,localPt));
+                    refine = false;
+                }
+            }
+        }
+    }
+
+    if (refine)
+        SceneGraphGroup::traverseNodeDrawables(manage, localPt, nodes, toDraw);
+    else
+        toDraw.insert(drawIDs.begin(), drawIDs.end());
+}
+
+void SceneGraphPagedLOD::traverseRemNodeIDs(SceneGraphManager *manage,SceneGraphNodeSet &allNodes,ChangeSet &changes)
+{
+    manage->unloadNode(this,changes);
+    SceneGraphGroup::traverseRemNodeIDs(manage, allNodes, changes);
+}
+
 SceneGraphManager::SceneGraphManager()
 {
 }
@@ -110,7 +165,7 @@ SceneGraphManager::~SceneGraphManager()
 void SceneGraphManager::removeDrawable(SimpleIdentity drawID,ChangeSet &changes)
 {
     auto it = drawables.find(drawID);
-    if (it == drawables.end())
+    if (it != drawables.end())
     {
         changes.push_back(new RemDrawableReq(drawID));
         drawables.erase(it);
@@ -118,9 +173,134 @@ void SceneGraphManager::removeDrawable(SimpleIdentity drawID,ChangeSet &changes)
 }
 
 
-void SceneGraphManager::update(ViewStateRef viewState,ChangeSet &changes)
+float SceneGraphManager::screenError(const Point3f &center,float radius,float geomError,const Point3f &localPt) const
+{
+    const float dist = (localPt-center).norm() - radius;
+    // Inside the bounds, so as bad as it gets
+    if (dist <= 0.0)
+        return FLT_MAX;
+    return geomError * pixelScale / dist;
+}
+
+void SceneGraphManager::requestLoad(SceneGraphPagedLOD *node,double priority)
+{
+    if (node->state != SceneGraphPagedLOD::Unloaded)
+        return;
+
+    // Nothing of its own to load
+    if (!node->loadFn)
+    {
+        node->state = SceneGraphPagedLOD::Loaded;
+        return;
+    }
+
+    auto load = std::make_shared<SceneGraphPagedLOD::LoadState>();
+    node->load = load;
+    node->state = SceneGraphPagedLOD::Loading;
+    loadingNodes.insert(node);
+
+    const auto loadFn = node->loadFn;
+    TaskScheduler::getShared().addTask(priority,&load->cancel,[load,loadFn](bool cancelled)
+    {
+        if (!cancelled)
+            load->success = loadFn(load->draws);
+        load->done.store(true,std::memory_order_release);
+    });
+}
+
+void SceneGraphManager::checkLoads(ChangeSet &changes)
+{
+    for (auto it = loadingNodes.begin(); it != loadingNodes.end(); )
+    {
+        auto node = *it;
+        if (!node->load->done.load(std::memory_order_acquire))
+        {
+            // Not wanted any more, so skip it if it hasn't started
+            if (node->lastUsed < frame - 1)
+                node->load->cancel = true;
+            ++it;
+            continue;
+        }
+        it = loadingNodes.erase(it);
+
+        const auto load = std::move(node->load);
+        if (load->cancel)
+        {
+            node->state = SceneGraphPagedLOD::Unloaded;
+            continue;
+        }
+
+        // A failed load is left empty rather than tried over and over
+        node->state = SceneGraphPagedLOD::Loaded;
+        node->memSize = 0;
+        if (load->success)
+        {
+            for (const auto &draw : load->draws)
+            {
+                size_t vertSize = sizeof(float) * 3;
+                for (const auto *attr : draw->vertexAttributes)
+                    vertSize += attr->size();
+                node->memSize += vertSize * draw->getNumPoints() + sizeof(uint16_t) * 3 * draw->getNumTris();
+                node->drawIDs.insert(draw->getId());
+                addDrawable(draw,changes);
+            }
+        }
+        memoryUsed += node->memSize;
+        loadedNodes.insert(node);
+    }
+}
+
+void SceneGraphManager::unloadNode(SceneGraphPagedLOD *node,ChangeSet &changes)
+{
+    if (node->load)
+    {
+        node->load->cancel = true;
+        node->load.reset();
+    }
+    loadingNodes.erase(node);
+    loadedNodes.erase(node);
+
+    for (auto drawID : node->drawIDs)
+    {
+        removeDrawable(drawID,changes);
+        activeDrawIDs.erase(drawID);
+    }
+    node->drawIDs.clear();
+    memoryUsed -= std::min(memoryUsed,node->memSize);
+    node->memSize = 0;
+    node->state = SceneGraphPagedLOD::Unloaded;
+}
+
+void SceneGraphManager::evictNodes(ChangeSet &changes)
+{
+    if (memoryUsed <= memoryBudget)
+        return;
+
+    // Anything used in this update is on screen or about to be
+    std::vector<SceneGraphPagedLOD *> candidates;
+    for (auto node : loadedNodes)
+        if (node->lastUsed < frame && node->memSize > 0)
+            candidates.push_back(node);
+    std::sort(candidates.begin(),candidates.end(),
+              [](const SceneGraphPagedLOD *a,const SceneGraphPagedLOD *b) { return a->lastUsed < b->lastUsed; });
+
+    for (auto node : candidates)
+    {
+        if (memoryUsed <= memoryBudget)
+            break;
+        unloadNode(node,changes);
+    }
+}
+
+void SceneGraphManager::update(ViewStateRef viewState,const Point2f &frameSize,ChangeSet &changes)
 {
     Point3f localPt = Vector3dToVector3f(viewState->eyePos);
+
+    frame++;
+    const double fov = viewState->fieldOfView;
+    pixelScale = (float)((fov > 0.0) ? frameSize.y() / (2.0 * tan(fov / 2.0)) : frameSize.y());
+
+    checkLoads(changes);
     
     SimpleIDSet shouldBeOn;
     
@@ -153,6 +333,8 @@ void SceneGraphManager::update(ViewStateRef viewState,ChangeSet &changes)
     }
     
     activeDrawIDs = shouldBeOn;
+
+    evictNodes(changes);
 }
         
 void SceneGraphManager::addDrawable(const BasicDrawableRef &draw,ChangeSet &changes)
@@ -31,6 +31,13 @@ static bool matrixAisSameAsB(const Matrix4d &a,const Matrix4d &b)
     return !memcmp(a.data(), b.data(), 16 * sizeof(Matrix4d::Scalar));
 }
 
+// Renderers time the work groups straight into the matching GPU phases
+static_assert((int)GPUTimings::Calculation == (int)WorkGroup::Calculation &&
+              (int)GPUTimings::Offscreen == (int)WorkGroup::Offscreen &&
+              (int)GPUTimings::ReduceOps == (int)WorkGroup::ReduceOps &&
+              (int)GPUTimings::ScreenRender == (int)WorkGroup::ScreenRender,
+              "GPU timing phases out of step with the work groups");
+
 WorkGroup::~WorkGroup()
 {
     for (auto &targetCon : renderTargetContainers) {
@@ -59,6 +66,8 @@ bool WorkGroup::addDrawable(DrawableRef drawable)
             renderTargetCon->renderTarget->getId() == drawable->getRenderTarget()) {
             drawable->renderTargetCon = renderTargetCon;
             renderTargetCon->modified = true;
+            if (renderTargetCon->renderTarget)
+                renderTargetCon->renderTarget->markDirty();
             renderTargetCon->drawables.insert(drawable);
             drawable->workGroupIDs.insert(getId());
             return true;
@@ -75,6 +84,8 @@ void WorkGroup::removeDrawable(DrawableRef drawable)
         if (it != renderTargetCon->drawables.end()) {
             drawable->renderTargetCon = NULL;
             renderTargetCon->modified = true;
+            if (renderTargetCon->renderTarget)
+                renderTargetCon->renderTarget->markDirty();
             renderTargetCon->drawables.erase(it);
         }
     }
@@ -128,6 +139,10 @@ void SceneRenderer::init()
     clearColor = RGBAColor(0,0,0,0);
     framebufferTex = nullptr;
 
+    // Leave a couple of cores for the layer threads
+    const int numCores = (int)std::thread::hardware_concurrency();
+    setCullingThreads(std::min(std::max(numCores - 3,0),3));
+
     // Add a simple default light
     DirectionalLight light;
     light.setPos(Vector3f(0.75, 0.5, -1.0));
@@ -164,6 +179,36 @@ void SceneRenderer::setZBufferMode(WhirlyKitSceneRendererZBufferMode inZBufferMo
 void SceneRenderer::setPerfInterval(int howLong)
     { perfInterval = howLong; }
 
+bool SceneRenderer::hasScreenDrawables() const
+{
+    if (workGroups.size() <= WorkGroup::ScreenRender)
+        return false;
+    for (const auto &targetContainer : workGroups[WorkGroup::ScreenRender]->renderTargetContainers)
+        if (!targetContainer->drawables.empty())
+            return true;
+    return false;
+}
+
+void SceneRenderer::noteStartupFrame(bool drewSomething)
+{
+    startupTimeline.mark("first frame");
+    if (drewSomething)
+    {
+        startupTimeline.mark("first content");
+        startupTimeline.log();
+    }
+}
+
+void SceneRenderer::setCullingThreads(int numThreads)
+{
+    numThreads = std::max(numThreads,0);
+    if (cullWorkers && cullWorkers->getNumThreads() == numThreads)
+        return;
+
+    numCullThreads = numThreads;
+    cullWorkers.reset(numThreads > 0 ? new WorkerPool(numThreads) : nullptr);
+}
+
 void SceneRenderer::setUseViewChanged(bool newVal)
     { useViewChanged = newVal; }
 
@@ -183,7 +228,26 @@ void SceneRenderer::addDrawable(DrawableRef newDrawable)
     newDrawable->updateRenderer(this);
     
     // This will sort it into the appropriate work group later
-    offDrawables.insert(newDrawable);
+    addOffDrawable(newDrawable);
+}
+
+void SceneRenderer::addOffDrawable(const DrawableRef &draw)
+{
+    const DrawableRef *existing = offDrawables.get(draw->offSlot);
+    if (existing && *existing == draw)
+        return;
+
+    draw->offSlot = offDrawables.insert(draw);
+}
+
+void SceneRenderer::removeOffDrawable(const DrawableRef &draw)
+{
+    const DrawableRef *existing = offDrawables.get(draw->offSlot);
+    if (existing && *existing == draw)
+    {
+        offDrawables.erase(draw->offSlot);
+        draw->offSlot = EmptySlotHandle;
+    }
 }
 
 void SceneRenderer::removeDrawable(DrawableRef draw,bool teardown,RenderTeardownInfoRef teardownInfo)
@@ -192,10 +256,8 @@ void SceneRenderer::removeDrawable(DrawableRef draw,bool teardown,RenderTeardown
     for (auto &workGroup : workGroups) {
         workGroup->removeDrawable(draw);
     }
-    auto it = offDrawables.find(draw);
-    if (it != offDrawables.end()) {
-        offDrawables.erase(it);
-    }
+    removeOffDrawable(draw);
+    timeIndex.remove(draw);
     
     removeContinuousRenderRequest(draw->getId());
     removeExtraFrameRenderRequest(draw->getId());
@@ -205,30 +267,74 @@ void SceneRenderer::removeDrawable(DrawableRef draw,bool teardown,RenderTeardown
     }
 }
 
+// Below this many drawables it's not worth waking up the workers
+static const size_t CullParallelMin = 1024;
+static const size_t CullChunkSize = 256;
+
+void SceneRenderer::evalCullDrawables(RendererFrameInfo *frameInfo)
+{
+    const size_t numDraws = cullDrawables.size();
+    cullResults.resize(numDraws);
+
+    // isOn() only reads drawable and view state, nothing is changing under us here
+    auto evalRange = [this,frameInfo](size_t start,size_t end) {
+        for (size_t ii=start;ii<end;ii++)
+            cullResults[ii] = cullDrawables[ii]->isOn(frameInfo);
+    };
+
+    if (cullWorkers && numDraws >= CullParallelMin)
+        cullWorkers->parallelFor(numDraws,CullChunkSize,evalRange);
+    else
+        evalRange(0,numDraws);
+}
+
 void SceneRenderer::updateWorkGroups(RendererFrameInfo *frameInfo)
 {
+    WKTraceScope("Render updateWorkGroups");
+
+    // Bring back the drawables whose time has come
+    if (timeIndex.size() > 0) {
+        std::vector<DrawableRef> timeDraws;
+        timeIndex.update(frameInfo->currentTime,timeDraws);
+        for (const auto &draw : timeDraws)
+            addOffDrawable(draw);
+    }
+
     // Look at drawables to move into the active set
-    std::vector<DrawableRef> drawsToMoveIn;
-    for (auto &draw : offDrawables) {
-        if (draw->isOn(frameInfo)) {
-            bool keep = false;
-            // If there's a render target, we need that too
-            if (draw->getRenderTarget() != EmptyIdentity) {
-                for (auto &renderTarget : renderTargets) {
-                    if (draw->getRenderTarget() == renderTarget->getId())
-                        keep = true;
-                }
-            } else
-                keep = true;
-            if (keep)
-                drawsToMoveIn.push_back(draw);
+    cullDrawables.clear();
+    cullDrawables.reserve(offDrawables.size());
+    for (const auto &draw : offDrawables)
+        cullDrawables.push_back(draw.get());
+    evalCullDrawables(frameInfo);
+
+    std::vector<DrawableRef> drawsToMoveIn,drawsToPark;
+    for (size_t ii=0;ii<cullDrawables.size();ii++) {
+        const DrawableRef &draw = *(offDrawables.begin() + ii);
+        if (!cullResults[ii]) {
+            TimeInterval start,end;
+            if (draw->getEnableTimeRange(start,end))
+                drawsToPark.push_back(draw);
+            continue;
         }
+        bool keep = false;
+        // If there's a render target, we need that too
+        if (draw->getRenderTarget() != EmptyIdentity) {
+            for (auto &renderTarget : renderTargets) {
+                if (draw->getRenderTarget() == renderTarget->getId())
+                    keep = true;
+            }
+        } else
+            keep = true;
+        if (keep)
+            drawsToMoveIn.push_back(draw);
+    }
+    // The ones that are off for the time wait in the index until it comes around
+    for (const auto &draw : drawsToPark) {
+        if (timeIndex.park(draw,frameInfo->currentTime))
+            removeOffDrawable(draw);
     }
     for (auto &draw : drawsToMoveIn) {
-        auto it = offDrawables.find(draw);
-        if (it != offDrawables.end()) {
-            offDrawables.erase(it);
-        }
+        removeOffDrawable(draw);
 
         // If there's a calculation program, it always goes in there
         if (draw->getCalculationProgram() != EmptyIdentity) {
@@ -242,23 +348,36 @@ void SceneRenderer::updateWorkGroups(RendererFrameInfo *frameInfo)
         }
     }
     
-    // Look for active drawables to move out of the active set
+    // Look for active drawables to move out of the active set.
+    // Check them all in one pass, then sort out which container they came from.
+    cullDrawables.clear();
+    std::vector<std::pair<RenderTargetContainer *,const DrawableRef *> > activeDraws;
     for (auto &workGroup : workGroups) {
         for (auto &renderTargetCon : workGroup->renderTargetContainers) {
-            std::vector<DrawableRef> drawsToMoveOut;
-            for (auto &draw : renderTargetCon->drawables) {
-                if (!draw->isOn(frameInfo)) {
-                    drawsToMoveOut.push_back(draw);
-                }
-            }
-            for (auto &draw : drawsToMoveOut) {
-                auto it = renderTargetCon->drawables.find(draw);
-                if (it != renderTargetCon->drawables.end())
-                    renderTargetCon->drawables.erase(it);
-                offDrawables.insert(draw);
+            for (const auto &draw : renderTargetCon->drawables) {
+                cullDrawables.push_back(draw.get());
+                activeDraws.emplace_back(renderTargetCon.get(),&draw);
             }
         }
     }
+    evalCullDrawables(frameInfo);
+
+    std::vector<std::pair<RenderTargetContainer *,DrawableRef> > drawsToMoveOut;
+    for (size_t ii=0;ii<cullDrawables.size();ii++) {
+        if (!cullResults[ii])
+            drawsToMoveOut.emplace_back(activeDraws[ii].first,*activeDraws[ii].second);
+    }
+    cullDrawables.clear();
+
+    for (auto &moveOut : drawsToMoveOut) {
+        auto &drawables = moveOut.first->drawables;
+        auto it = drawables.find(moveOut.second);
+        if (it != drawables.end()) {
+            drawables.erase(it);
+            moveOut.first->modified = true;
+        }
+        addOffDrawable(moveOut.second);
+    }
 }
 
 void SceneRenderer::removeRenderTarget(SimpleIdentity targetID)
@@ -367,6 +486,12 @@ void SceneRenderer::setRenderUntil(TimeInterval newRenderUntil)
     renderUntil = std::max(renderUntil,newRenderUntil);
 }
 
+void SceneRenderer::scrubToTime(TimeInterval when)
+{
+    scene->setCurrentTime(when);
+    setTriggerDraw();
+}
+
 void SceneRenderer::setTriggerDraw()
 {
     triggerDraw = true;
@@ -422,6 +547,8 @@ RGBAColor SceneRenderer::getClearColor() const
 
 bool SceneRenderer::viewDidChange()
 {
+    viewMoved = true;
+
     if (!useViewChanged)
         return true;
     
@@ -436,23 +563,24 @@ bool SceneRenderer::viewDidChange()
         return true;
     }
     
-    // Something wants us to draw (probably an animation)
-    // We look at the last draw so we can handle jumps in time
-    if (lastDraw < renderUntil)
-        return true;
-    
+    // Check the matrices even when animating, since the pacer cares if the view is moving too
     Matrix4d newModelMat = theView->calcModelMatrix();
     Matrix4d newViewMat = theView->calcViewMatrix();
     Matrix4d newProjMat = theView->calcProjectionMatrix(Point2f(framebufferWidth,framebufferHeight),0.0);
     
     // Should be exactly the same
-    if (matrixAisSameAsB(newModelMat,modelMat) && matrixAisSameAsB(newViewMat,viewMat) && matrixAisSameAsB(newProjMat, projMat))
-        return false;
-    
-    modelMat = newModelMat;
-    viewMat = newViewMat;
-    projMat = newProjMat;
-    return true;
+    if (!matrixAisSameAsB(newModelMat,modelMat) || !matrixAisSameAsB(newViewMat,viewMat) || !matrixAisSameAsB(newProjMat, projMat))
+    {
+        modelMat = newModelMat;
+        viewMat = newViewMat;
+        projMat = newProjMat;
+        return true;
+    }
+    viewMoved = false;
+
+    // Something wants us to draw (probably an animation)
+    // We look at the last draw so we can handle jumps in time
+    return lastDraw < renderUntil;
 }
 
 void SceneRenderer::forceDrawNextFrame()
@@ -524,7 +652,9 @@ int SceneRenderer::processScene(TimeInterval now)
 
 bool SceneRenderer::hasChanges()
 {
-    if (scene->hasChanges(scene->getCurrentTime()) || viewDidChange() || !contRenderRequests.empty()) {
+    // Always look at the view, so we know if it was the thing that moved
+    const bool viewChanged = viewDidChange();
+    if (viewChanged || scene->hasChanges(scene->getCurrentTime()) || !contRenderRequests.empty()) {
         frameCountLastChanged = frameCount;
         return true;
     }
@@ -532,6 +662,35 @@ bool SceneRenderer::hasChanges()
     return frameCount - frameCountLastChanged <= extraFrames;
 }
 
+bool SceneRenderer::shouldRenderFrame()
+{
+    if (!scene)
+        return false;
+
+    FramePacer::Need need = FramePacer::NeedNone;
+    if (hasChanges())
+    {
+        if (viewMoved)
+            need = FramePacer::NeedMotion;
+        else if (lastDraw < renderUntil || !contRenderRequests.empty())
+            need = FramePacer::NeedAnimation;
+        else
+            need = FramePacer::NeedBackground;
+    }
+    // Once things settle down, draw the last frame again at full resolution
+    else if (dynamicRes.restore())
+    {
+        need = FramePacer::NeedBackground;
+    }
+    // Readbacks only move along when we draw
+    else if (hasReadbacks())
+    {
+        need = FramePacer::NeedBackground;
+    }
+
+    return framePacer.shouldRender(need,TimeGetCurrent());
+}
+
 int SceneRenderer::getSlotForNameID(SimpleIdentity nameID)
 {
     auto it = slotMap.find(nameID);
@@ -540,9 +699,112 @@ int SceneRenderer::getSlotForNameID(SimpleIdentity nameID)
     return it->second;
 }
 
+void SceneRenderer::addReadback(SimpleIdentity renderTargetID,int x,int y,int width,int height,ReadbackCallback callback)
+{
+    if (!callback)
+        return;
+
+    std::lock_guard<std::mutex> guardLock(readbackLock);
+    readbackRequests.push_back(ReadbackRequest { renderTargetID, x, y, width, height, false, std::move(callback) });
+}
+
+void SceneRenderer::addMinMaxReadback(SimpleIdentity renderTargetID,ReadbackCallback callback)
+{
+    if (!callback)
+        return;
+
+    std::lock_guard<std::mutex> guardLock(readbackLock);
+    readbackRequests.push_back(ReadbackRequest { renderTargetID, 0, 0, 0, 0, true, std::move(callback) });
+}
+
+void SceneRenderer::markRenderTargetsDirty()
+{
+    for (const auto &renderTarget : renderTargets)
+        renderTarget->markDirty();
+}
+
+bool SceneRenderer::renderTargetNeedsDraw(const RenderTarget *renderTarget) const
+{
+    if (!renderTarget || !renderTarget->renderWhenChanged || renderTarget->getId() == EmptyIdentity)
+        return true;
+
+    // Tiles come and go as the view moves, so there's no point checking the drawables
+    if (renderTarget->dirty || renderTarget->clearOnce || viewMoved)
+        return true;
+
+    // Fades and such run on time rather than changes
+    if (lastDraw < renderUntil)
+        return true;
+
+    return renderTargetIsAnimating(renderTarget);
+}
+
+bool SceneRenderer::renderTargetIsAnimating(const RenderTarget *renderTarget) const
+{
+    for (const auto &workGroup : workGroups)
+    {
+        for (const auto &targetCon : workGroup->renderTargetContainers)
+        {
+            if (targetCon->renderTarget.get() != renderTarget)
+                continue;
+            for (const auto &draw : targetCon->drawables)
+                if (draw->hasTweakers() || contRenderRequests.find(draw->getId()) != contRenderRequests.end())
+                    return true;
+        }
+    }
+
+    return false;
+}
+
+void SceneRenderer::addHistogramReadback(SimpleIdentity renderTargetID,int numBins,float minVal,float maxVal,HistogramCallback callback)
+{
+    if (!callback)
+        return;
+    if (numBins <= 0 || !(maxVal > minVal))
+    {
+        callback(RenderTargetHistogramRef());
+        return;
+    }
+
+    std::lock_guard<std::mutex> guardLock(readbackLock);
+    histogramRequests.push_back(HistogramRequest { renderTargetID, numBins, minVal, maxVal, std::move(callback) });
+}
+
+std::vector<SceneRenderer::ReadbackRequest> SceneRenderer::takeReadbacks()
+{
+    std::vector<ReadbackRequest> requests;
+    std::lock_guard<std::mutex> guardLock(readbackLock);
+    requests.swap(readbackRequests);
+    return requests;
+}
+
+std::vector<SceneRenderer::HistogramRequest> SceneRenderer::takeHistograms()
+{
+    std::vector<HistogramRequest> requests;
+    std::lock_guard<std::mutex> guardLock(readbackLock);
+    requests.swap(histogramRequests);
+    return requests;
+}
+
+bool SceneRenderer::hasReadbacks()
+{
+    std::lock_guard<std::mutex> guardLock(readbackLock);
+    return !readbackRequests.empty() || !histogramRequests.empty();
+}
+
+void SceneRenderer::cancelReadbacks()
+{
+    for (const auto &request : takeReadbacks())
+        request.callback(RawDataRef());
+    for (const auto &request : takeHistograms())
+        request.callback(RenderTargetHistogramRef());
+}
+
 void SceneRenderer::shutdown()
 {
+    cancelReadbacks();
     offDrawables.clear();
+    timeIndex.clear();
     renderTargets.clear();
     workGroups.clear();
     lights.clear();
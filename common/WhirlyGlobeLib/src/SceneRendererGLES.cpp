@@ -16,6 +16,7 @@
  *  limitations under the License.
  */
 
+#import <algorithm>
 #import "SceneRendererGLES.h"
 #import "TextureGLES.h"
 #import "RenderTargetGLES.h"
@@ -27,15 +28,105 @@
 #import "ParticleSystemDrawableBuilderGLES.h"
 #import "DynamicTextureAtlasGLES.h"
 #import "MaplyView.h"
+#import "TransformMath.h"
 #import "WhirlyKitLog.h"
 #import "Expect.h"
 
 using namespace Eigen;
 using namespace WhirlyKit;
 
+// From GL_EXT_disjoint_timer_query, which the ES 3 headers leave out
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
 namespace WhirlyKit
 {
 
+RenderTeardownInfoGLES::RenderTeardownInfoGLES(bool useFences) :
+    useFences(useFences)
+{
+}
+
+RenderTeardownInfoGLES::~RenderTeardownInfoGLES()
+{
+    // Without a renderer we can't tear anything down, the references just go.
+    // Fences don't survive the context, so don't bother with them either.
+}
+
+void RenderTeardownInfoGLES::destroyTexture(SceneRenderer *,const TextureBaseRef &tex)
+{
+    current.textures.push_back(tex);
+}
+
+void RenderTeardownInfoGLES::destroyDrawable(SceneRenderer *,const DrawableRef &draw)
+{
+    current.drawables.push_back(draw);
+}
+
+void RenderTeardownInfoGLES::release(SceneRenderer *renderer,Epoch &epoch)
+{
+    const RenderSetupInfo *setupInfo = renderer->getRenderSetupInfo();
+    Scene *scene = renderer->getScene();
+    for (const auto &draw : epoch.drawables)
+        draw->teardownForRenderer(setupInfo, scene, renderer->getTeardownInfo());
+    for (const auto &tex : epoch.textures)
+        tex->destroyInRenderer(setupInfo, scene);
+    if (epoch.fence)
+        glDeleteSync(epoch.fence);
+    epoch = Epoch();
+}
+
+void RenderTeardownInfoGLES::endFrame(SceneRenderer *renderer)
+{
+    if (!current.drawables.empty() || !current.textures.empty())
+    {
+        if (useFences)
+        {
+            current.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            CheckGLError("RenderTeardownInfoGLES::endFrame() glFenceSync");
+        }
+        retired.push_back(std::move(current));
+        current = Epoch();
+    }
+
+    while (!retired.empty())
+    {
+        Epoch &oldest = retired.front();
+        bool done = retired.size() > MaxEpochs;
+        if (!done && oldest.fence)
+        {
+            const GLenum status = glClientWaitSync(oldest.fence, 0, 0);
+            done = (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED);
+        }
+        if (!done)
+            break;
+
+        // Tearing down one may retire others.  Those go in the current epoch.
+        Epoch epoch = std::move(oldest);
+        retired.pop_front();
+        release(renderer, epoch);
+    }
+}
+
+void RenderTeardownInfoGLES::flush(SceneRenderer *renderer)
+{
+    while (!retired.empty() || !current.drawables.empty() || !current.textures.empty())
+    {
+        if (!current.drawables.empty() || !current.textures.empty())
+        {
+            retired.push_back(std::move(current));
+            current = Epoch();
+        }
+        Epoch epoch = std::move(retired.front());
+        retired.pop_front();
+        release(renderer, epoch);
+    }
+}
+
 WorkGroupGLES::WorkGroupGLES(GroupType inGroupType)
 {
     groupType = inGroupType;
@@ -107,6 +198,7 @@ bool SceneRendererGLES::setup(int apiVersion,int sizeX,int sizeY,float inScale)
     framebufferHeight = sizeY;
     
     setupInfo.glesVersion = apiVersion;
+    SetupGLESCapabilities();
     
     // We need a texture to draw to in this case
     if (framebufferWidth > 0)
@@ -135,8 +227,8 @@ bool SceneRendererGLES::setup(int apiVersion,int sizeX,int sizeY,float inScale)
     defaultTarget->clearEveryFrame = true;
     renderTargets.push_back(defaultTarget);
 
-    // GL doesn't do anything special for teardown
-    teardownInfo = RenderTeardownInfoRef(new RenderTeardownInfo());
+    // Removed drawables and textures wait for the GPU to finish with them, fenced if we can
+    teardownInfo = std::make_shared<RenderTeardownInfoGLES>(setupInfo.glesVersion >= 3);
     
     return true;
 }
@@ -149,6 +241,11 @@ void SceneRendererGLES::setView(View *newView)
     
 void SceneRendererGLES::setScene(Scene *newScene)
 {
+    // Anything still waiting goes back to the old scene's memory manager
+    if (scene && newScene != scene)
+        if (const auto glTeardown = std::dynamic_pointer_cast<RenderTeardownInfoGLES>(teardownInfo))
+            glTeardown->flush(this);
+
     SceneRenderer::setScene(newScene);
     auto *sceneGL = (SceneGLES *)newScene;
     setupInfo.memManager = sceneGL ? sceneGL->getMemManager() : nullptr;
@@ -172,39 +269,37 @@ bool SceneRendererGLES::resize(int sizeX,int sizeY)
     return true;
 }
 
-SceneRendererGLES::~SceneRendererGLES() = default;
+SceneRendererGLES::~SceneRendererGLES()
+{
+    // The context may already be gone, so just let everyone know
+    for (const auto &readback : activeReadbacks)
+        readback.callback(RawDataRef());
+    cancelReadbacks();
+}
 
-// Keep track of a drawable and the MVP we're supposed to use with it
+// Keep track of a drawable and where its matrices are, one set for each copy of the world
 class DrawableContainer
 {
 public:
-    explicit DrawableContainer(DrawableGLES *draw) :
+    DrawableContainer(DrawableGLES *draw,unsigned int firstMats) :
         drawable(draw),
-        mvpMat(Eigen::Matrix4d::Identity()),
-        mvMat(Eigen::Matrix4d::Identity()),
-        mvNormalMat(Eigen::Matrix4d::Identity())
-    {
-    }
-
-    DrawableContainer(DrawableGLES *draw,Matrix4d mvpMat,Matrix4d mvMat,Matrix4d mvNormalMat) :
-        drawable(draw),
-        mvpMat(std::move(mvpMat)),
-        mvMat(std::move(mvMat)),
-        mvNormalMat(std::move(mvNormalMat))
+        firstMats(firstMats)
     {
     }
 
     DrawableGLES *drawable;
-    Matrix4d mvpMat,mvMat,mvNormalMat;
+    unsigned int firstMats;
 };
 
 // Alpha stuff goes at the end
 // Otherwise sort by draw priority
+// Within a priority, depth tested drawables are grouped by the GL state they need
 class DrawListSortStruct2
 {
 public:
     DrawListSortStruct2() = delete;
-    DrawListSortStruct2(bool useZBuffer,const RendererFrameInfo *frameInfo) : useZBuffer(useZBuffer), frameInfo(frameInfo)
+    DrawListSortStruct2(bool useZBuffer,bool allDepthTested,const RendererFrameInfo *frameInfo) :
+        useZBuffer(useZBuffer), allDepthTested(allDepthTested), frameInfo(frameInfo)
     {
     }
     DrawListSortStruct2(const DrawListSortStruct2 &that) = default;
@@ -213,6 +308,7 @@ public:
         if (this != &that)
         {
             useZBuffer = that.useZBuffer;
+            allDepthTested = that.allDepthTested;
             frameInfo = that.frameInfo;
         }
         return *this;
@@ -224,12 +320,22 @@ public:
 
         if (a->getDrawPriority() == b->getDrawPriority())
         {
+            bool depthTested = allDepthTested;
             if (useZBuffer)
             {
                 const bool bufferA = a->getRequestZBuffer();
                 const bool bufferB = b->getRequestZBuffer();
                 if (bufferA != bufferB)
                     return !bufferA;
+                depthTested |= bufferA;
+            }
+            // The z buffer sorts these out, so the order is ours to pick.
+            // Without it, later objects draw over earlier ones and we leave that alone.
+            if (depthTested)
+            {
+                const int stateOrder = Drawable::compareDrawState(*a,*b,true);
+                if (stateOrder != 0)
+                    return stateOrder < 0;
             }
             // Ensure a stable order among items with identical priority and z-buffering
             const auto idA = a->getId();
@@ -245,6 +351,7 @@ public:
     }
     
     bool useZBuffer;
+    bool allDepthTested;
     const RendererFrameInfo *frameInfo;
 };
 
@@ -262,6 +369,8 @@ bool SceneRendererGLES::hasChanges()
 
 void SceneRendererGLES::render(TimeInterval duration)
 {
+    WKTraceScope("Render frame");
+
     if (!scene)
         return;
     
@@ -273,20 +382,43 @@ void SceneRendererGLES::render(TimeInterval duration)
 
     lastDraw = now;
 
+    // See if we need to trade some resolution for frame rate.
+    // The timer queries tell us what the GPU took, if we've got them.  Otherwise it's the time between frames.
+    const bool gpuTimedRes = hasTimerQuerySupport && dynamicRes.isEnabled();
+    dynamicRes.addFrame(TimeGetCurrent(), 1.0 / std::max(framePacer.getDisplayRate(),1), viewMoved, gpuTimedRes);
+
     // Don't start reporting mid-frame.
     const bool reportStats = (perfInterval > 0);
 
+    // Structured stats for this frame, if anyone's recording them
+    const bool collectStats = frameStats.isEnabled();
+    FrameStats::Frame frameStat;
+    frameStat.when = now;
+    const TimeInterval frameStart = collectStats ? TimeGetCurrent() : 0.0;
+    TimeInterval phaseStart = frameStart;
+    const auto markPhase = [&](FrameStats::Metric metric)
+    {
+        const TimeInterval phaseEnd = TimeGetCurrent();
+        frameStat.add(metric, phaseEnd - phaseStart);
+        phaseStart = phaseEnd;
+    };
+    bool drewSomething = false;
+
     if (UNLIKELY(reportStats))
         perfTimer.startTiming("Render Frame");
     
     if (UNLIKELY(reportStats))
         perfTimer.startTiming("Render Setup");
     
+    // Someone else may have been at the GL state since last time
+    stateCache.invalidate();
+    stateCache.resetCounts();
+
     //if (!renderSetup)
     {
         // Turn on blending
-        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-        glEnable(GL_BLEND);
+        stateCache.setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        stateCache.setBlend(true);
     }
     
     // See if we're dealing with a globe or map view
@@ -296,47 +428,46 @@ void SceneRendererGLES::render(TimeInterval duration)
         overlapMarginX = (float)scene->getOverlapMargin();
     }
     
-    // Get the model and view matrices
-    const Eigen::Matrix4d modelTrans4d = theView->calcModelMatrix();
+    // The matrices and their inverses come from the same view state everyone else is using
+    const ViewStateRef viewState = theView->getViewState(this);
+    const Eigen::Matrix4d &modelTrans4d = viewState->modelMatrix;
     const Eigen::Matrix4f modelTrans = Matrix4dToMatrix4f(modelTrans4d);
-    const Eigen::Matrix4d viewTrans4d = theView->calcViewMatrix();
+    const Eigen::Matrix4d &viewTrans4d = viewState->viewMatrix;
     const Eigen::Matrix4f viewTrans = Matrix4dToMatrix4f(viewTrans4d);
     
-    // Set up a projection matrix
     const Point2f frameSize(framebufferWidth,framebufferHeight);
-    const Eigen::Matrix4d projMat4d = theView->calcProjectionMatrix(frameSize,0.0);
+    const Eigen::Matrix4d &projMat4d = viewState->projMatrix;
 
     const Eigen::Matrix4f projMat = Matrix4dToMatrix4f(projMat4d);
-    Eigen::Matrix4f modelAndViewMat = viewTrans * modelTrans;
-    Eigen::Matrix4d modelAndViewMat4d = viewTrans4d * modelTrans4d;
+    Eigen::Matrix4f modelAndViewMat = Matrix4dToMatrix4f(viewState->fullMatrix);
+    Eigen::Matrix4d modelAndViewMat4d = viewState->fullMatrix;
     Eigen::Matrix4d pvMat = projMat4d * viewTrans4d;
-    const Eigen::Matrix4f mvpMat = projMat * (modelAndViewMat);
-    Eigen::Matrix4f mvpNormalMat4f = mvpMat.inverse().transpose();
-    Eigen::Matrix4d modelAndViewNormalMat4d = modelAndViewMat4d.inverse().transpose();
+    const Eigen::Matrix4f mvpMat = Matrix4dToMatrix4f(viewState->mvpMatrix);
+    Eigen::Matrix4f mvpNormalMat4f = Matrix4dToMatrix4f(viewState->mvpNormalMatrix);
+    Eigen::Matrix4d modelAndViewNormalMat4d = viewState->fullNormalMatrix;
     Eigen::Matrix4f modelAndViewNormalMat = Matrix4dToMatrix4f(modelAndViewNormalMat4d);
     
     switch (zBufferMode)
     {
         case zBufferOn:
-            glDepthMask(GL_TRUE);
-            glEnable(GL_DEPTH_TEST);
-            glDepthFunc(GL_LESS);
+            stateCache.setDepthMask(true);
+            stateCache.setDepthTest(true);
+            stateCache.setDepthFunc(GL_LESS);
             break;
         case zBufferOff:
-            glDepthMask(GL_FALSE);
-            glDisable(GL_DEPTH_TEST);
+            stateCache.setDepthMask(false);
+            stateCache.setDepthTest(false);
             break;
         case zBufferOffDefault:
-            glDepthMask(GL_TRUE);
-            glEnable(GL_DEPTH_TEST);
-            glDepthFunc(GL_ALWAYS);
+            stateCache.setDepthMask(true);
+            stateCache.setDepthTest(true);
+            stateCache.setDepthFunc(GL_ALWAYS);
             break;
     }
     
     //if (!renderSetup)
     {
-        glEnable(GL_CULL_FACE);
-        CheckGLError("SceneRendererES2: glEnable(GL_CULL_FACE)");
+        stateCache.setCullFace(true);
     }
     
     if (UNLIKELY(reportStats))
@@ -349,6 +480,7 @@ void SceneRendererGLES::render(TimeInterval duration)
         const auto frameInfoRef = std::make_shared<RendererFrameInfoGLES>();
         auto &baseFrameInfo = *frameInfoRef;
         baseFrameInfo.glesVersion = setupInfo.glesVersion;
+        baseFrameInfo.stateCache = &stateCache;
         baseFrameInfo.sceneRenderer = this;
         baseFrameInfo.theView = theView;
         baseFrameInfo.viewTrans = viewTrans;
@@ -361,8 +493,7 @@ void SceneRendererGLES::render(TimeInterval duration)
         baseFrameInfo.projMat = projMat;
         baseFrameInfo.projMat4d = projMat4d;
         baseFrameInfo.mvpMat = mvpMat;
-        Eigen::Matrix4f mvpInvMat = mvpMat.inverse();
-        baseFrameInfo.mvpInvMat = mvpInvMat;
+        baseFrameInfo.mvpInvMat = Matrix4dToMatrix4f(viewState->invMvpMatrix);
         baseFrameInfo.mvpNormalMat = mvpNormalMat4f;
         baseFrameInfo.viewModelNormalMat = modelAndViewNormalMat;
         baseFrameInfo.viewAndModelMat = modelAndViewMat;
@@ -378,19 +509,17 @@ void SceneRendererGLES::render(TimeInterval duration)
 
         // We need a reverse of the eye vector in model space
         // We'll use this to determine what's pointed away
-        Eigen::Matrix4f modelTransInv = modelTrans.inverse();
-        Vector4f eyeVec4 = modelTransInv * Vector4f(0,0,1,0);
-        Vector3f eyeVec3(eyeVec4.x(),eyeVec4.y(),eyeVec4.z());
-        baseFrameInfo.eyeVec = eyeVec3;
-        Eigen::Matrix4f fullTransInv = modelAndViewMat.inverse();
-        Vector4f fullEyeVec4 = fullTransInv * Vector4f(0,0,1,0);
-        Vector3f fullEyeVec3(fullEyeVec4.x(),fullEyeVec4.y(),fullEyeVec4.z());
-        baseFrameInfo.fullEyeVec = -fullEyeVec3;
-        Vector4d eyeVec4d = modelTrans4d.inverse() * Vector4d(0,0,1,0.0);
-        baseFrameInfo.heightAboveSurface = 0.0;
+        const Vector3d &eyeVec3d = viewState->eyeVecModel;
+        baseFrameInfo.eyeVec = eyeVec3d.cast<float>();
+        const Vector4d fullEyeVec4 = viewState->invFullMatrix * Vector4d(0,0,1,0);
+        baseFrameInfo.fullEyeVec = -Vector3f(fullEyeVec4.x(),fullEyeVec4.y(),fullEyeVec4.z());
         baseFrameInfo.heightAboveSurface = (float)theView->heightAboveSurface();
-        baseFrameInfo.eyePos = Vector3d(eyeVec4d.x(),eyeVec4d.y(),eyeVec4d.z()) * (1.0+baseFrameInfo.heightAboveSurface);
+        baseFrameInfo.eyePos = eyeVec3d * (1.0+baseFrameInfo.heightAboveSurface);
+        baseFrameInfo.horizon = viewState->horizon;
         
+        if (UNLIKELY(collectStats))
+            phaseStart = TimeGetCurrent();
+
         if (UNLIKELY(reportStats))
             perfTimer.startTiming("Scene preprocessing");
         
@@ -409,28 +538,39 @@ void SceneRendererGLES::render(TimeInterval duration)
         
         // Let the active models to their thing
         // That thing had better not take too long
-        const auto &activeModels = scene->getActiveModels();
-        for (const auto &activeModel : activeModels) {
-            activeModel->updateForFrame(&baseFrameInfo);
-            // Note: We were setting the GL context here.  Do we need to?
-        }
+        const int numModelChanges = scene->runActiveModels(&baseFrameInfo);
         if (UNLIKELY(reportStats))
-            perfTimer.addCount("Active Models", (int)activeModels.size());
+        {
+            perfTimer.addCount("Active Models", (int)scene->getActiveModels().size());
+            perfTimer.addCount("Active Model Changes", numModelChanges);
+        }
         
         if (UNLIKELY(reportStats))
             perfTimer.stopTiming("Active Model Runs");
         
         if (UNLIKELY(reportStats))
             perfTimer.addCount("Scene changes", scene->getNumChangeRequests());
+
+        if (UNLIKELY(reportStats))
+            perfTimer.addCount("Change batches", scene->getNumChangeBatches());
         
         if (UNLIKELY(reportStats))
             perfTimer.startTiming("Scene processing");
         
         // Merge any outstanding changes into the scenegraph
-        scene->processChanges(theView,this,now + duration / 2);
+        const int numChanges = scene->processChanges(theView,this,now + duration / 2);
 
         if (UNLIKELY(reportStats))
             perfTimer.stopTiming("Scene processing");
+
+        if (UNLIKELY(reportStats))
+            perfTimer.addCount("Changes deferred", scene->getNumDeferredChanges());
+
+        if (UNLIKELY(collectStats))
+        {
+            markPhase(FrameStats::ChangeTime);
+            frameStat.add(FrameStats::ChangesExecuted, numPreProcessChanges + numModelChanges + numChanges);
+        }
         
         // Work through the available offset matrices (only 1 if we're not wrapping)
         const std::vector<Matrix4d> &offsetMats = baseFrameInfo.offsetMatrices;
@@ -438,63 +578,83 @@ void SceneRendererGLES::render(TimeInterval duration)
         std::vector<DrawableContainer> drawList;
         std::vector<DrawableRef> screenDrawables;
         std::vector<DrawableRef> generatedDrawables;
-        std::vector<Matrix4d> mvpMats;
-        std::vector<Matrix4d> mvpInvMats;
-        std::vector<Matrix4f> mvpMats4f;
-        std::vector<Matrix4f> mvpInvMats4f;
-        mvpMats.resize(offsetMats.size());
-        mvpInvMats.resize(offsetMats.size());
-        mvpMats4f.resize(offsetMats.size());
-        mvpInvMats4f.resize(offsetMats.size());
-        for (unsigned int off=0;off<offsetMats.size();off++)
+        std::vector<FrameMatrices> frameMats(offsetMats.size());
+        // The world copies come first, then a run of the same length for each drawable with its own matrix
+        std::vector<DrawMatrices> drawMats;
+
+        // Zoom slots were just updated by the changes, so get them once for the whole frame
+        baseFrameInfo.zoomSlotMask = scene->copyZoomSlots(baseFrameInfo.zoomSlots);
+
+        // Visibility doesn't depend on the offset matrix, so check everything once up front
+        const auto rawDrawables = scene->getDrawables();
+        cullDrawables.clear();
+        cullDrawables.reserve(rawDrawables.size());
+        for (auto *draw : rawDrawables)
+        {
+            if (dynamic_cast<DrawableGLES *>(draw))
+            {
+                cullDrawables.push_back(draw);
+            }
+        }
+        evalCullDrawables(&baseFrameInfo);
+
+        const auto numOffsets = (unsigned int)offsetMats.size();
+        drawMats.reserve(numOffsets * 4);
+        for (unsigned int off=0;off<numOffsets;off++)
         {
-            RendererFrameInfoGLES offFrameInfo(baseFrameInfo);
             // Tweak with the appropriate offset matrix
-            modelAndViewMat4d = viewTrans4d * offsetMats[off] * modelTrans4d;
-            pvMat = projMat4d * viewTrans4d * offsetMats[off];
-            modelAndViewMat = Matrix4dToMatrix4f(modelAndViewMat4d);
-            mvpMats[off] = projMat4d * modelAndViewMat4d;
-            mvpInvMats[off] = (Eigen::Matrix4d)mvpMats[off].inverse();
-            mvpMats4f[off] = Matrix4dToMatrix4f(mvpMats[off]);
-            mvpInvMats4f[off] = Matrix4dToMatrix4f(mvpInvMats[off]);
-            modelAndViewNormalMat4d = modelAndViewMat4d.inverse().transpose();
-            modelAndViewNormalMat = Matrix4dToMatrix4f(modelAndViewNormalMat4d);
-            const Matrix4d &thisMvpMat = mvpMats[off];
-            offFrameInfo.mvpMat = mvpMats4f[off];
-            offFrameInfo.mvpInvMat = mvpInvMats4f[off];
-            mvpNormalMat4f = Matrix4dToMatrix4f(mvpMats[off].inverse().transpose());
-            offFrameInfo.mvpNormalMat = mvpNormalMat4f;
-            offFrameInfo.viewModelNormalMat = modelAndViewNormalMat;
-            offFrameInfo.viewAndModelMat4d = modelAndViewMat4d;
-            offFrameInfo.viewAndModelMat = modelAndViewMat;
-            offFrameInfo.pvMat = Matrix4dToMatrix4f(pvMat);
-            offFrameInfo.pvMat4d = pvMat;
-
-            const auto rawDrawables = scene->getDrawables();
-            drawList.reserve(rawDrawables.size());
-            for (auto *draw : rawDrawables)
+            FrameMatrices &offMats = frameMats[off];
+            offMats.mv = viewTrans4d * offsetMats[off] * modelTrans4d;
+            offMats.mvp = projMat4d * offMats.mv;
+            // The view state has the inverses, unless the overlap margin gave us different offsets
+            const bool sharedOffset = off < viewState->offsetMatrices.size() && viewState->offsetMatrices[off] == offsetMats[off];
+            if (sharedOffset)
+            {
+                offMats.mvpInv = viewState->invMvpMatrices[off];
+                offMats.mvNormal = viewState->fullNormalMatrices[off];
+            }
+            else
+            {
+                const Eigen::Matrix4d mvInv = AffineInverse(offMats.mv);
+                offMats.mvpInv = mvInv * viewState->invProjMatrix;
+                offMats.mvNormal = mvInv.transpose();
+            }
+            drawMats.emplace_back(offMats);
+        }
+
+        // One entry per drawable.  The world copies get drawn together, further down.
+        drawList.reserve(cullDrawables.size());
+        for (size_t ii=0;ii<cullDrawables.size();ii++)
+        {
+            if (cullResults[ii])
             {
-                auto *theDrawable = dynamic_cast<DrawableGLES *>(draw);
-                if (theDrawable && theDrawable->isOn(&offFrameInfo))
+                auto *theDrawable = dynamic_cast<DrawableGLES *>(cullDrawables[ii]);
+                if (const Matrix4d *localMat = theDrawable->getMatrix())
                 {
-                    if (const Matrix4d *localMat = theDrawable->getMatrix())
+                    const auto firstMats = (unsigned int)drawMats.size();
+                    drawMats.resize(firstMats + numOffsets);
+                    for (unsigned int off=0;off<numOffsets;off++)
                     {
-                        Matrix4d newMvpMat = thisMvpMat * (*localMat);
-                        Matrix4d newMvMat = modelAndViewMat4d * (*localMat);
-                        Matrix4d newMvNormalMat = newMvMat.inverse().transpose();
-                        drawList.emplace_back(theDrawable,newMvpMat,newMvMat,newMvNormalMat);
-                    }
-                    else
-                    {
-                        drawList.emplace_back(theDrawable,thisMvpMat,modelAndViewMat4d,modelAndViewNormalMat4d);
+                        CalcDrawMatrices(frameMats[off],*localMat,drawMats[firstMats + off]);
                     }
+                    drawList.emplace_back(theDrawable,firstMats);
+                }
+                else
+                {
+                    drawList.emplace_back(theDrawable,0);
                 }
             }
         }
         
-        // Sort the drawables (possibly multiple of the same if we have offset matrices)
+        // Sort the drawables
         const bool sortLinesToEnd = (zBufferMode == zBufferOffDefault);
-        std::sort(drawList.begin(),drawList.end(),DrawListSortStruct2(sortLinesToEnd,&baseFrameInfo));
+        std::sort(drawList.begin(),drawList.end(),DrawListSortStruct2(sortLinesToEnd,zBufferMode == zBufferOn,&baseFrameInfo));
+
+        if (UNLIKELY(collectStats))
+        {
+            markPhase(FrameStats::CullTime);
+            frameStat.add(FrameStats::DrawablesDrawn, (double)std::count(cullResults.begin(), cullResults.end(), 1));
+        }
         
         if (UNLIKELY(reportStats))
             perfTimer.startTiming("Calculation Shaders");
@@ -554,26 +714,14 @@ void SceneRendererGLES::render(TimeInterval duration)
             perfTimer.startTiming("Draw Execution");
         
         SimpleIdentity curProgramId = EmptyIdentity;
+
+        // Textures may have come and gone while processing changes
+        stateCache.invalidate();
         
-        // Iterate through rendering targets here
-        for (const RenderTargetRef &inRenderTarget : renderTargets)
+        // Which of a target's drawables go in a pass
+        enum { DrawAll, DrawWorld, DrawScreenSpace };
+        const auto drawPass = [&](SimpleIdentity targetID,int which)
         {
-            const auto renderTarget = dynamic_cast<RenderTargetGLES*>(inRenderTarget.get());
-            if (!renderTarget)
-            {
-                continue;
-            }
-            
-            renderTarget->setActiveFramebuffer(this);
-            
-            if (renderTarget->clearEveryFrame || renderTarget->clearOnce)
-            {
-                renderTarget->clearOnce = false;
-                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-                CheckGLError("SceneRendererES2: glClear");
-            }
-            
-            //bool depthMaskOn = (zBufferMode == zBufferOn);
             for (const auto &drawContain : drawList)
             {
                 // For this mode we turn the z buffer off until we get a request to turn it on
@@ -581,31 +729,26 @@ void SceneRendererGLES::render(TimeInterval duration)
                 {
                     if (drawContain.drawable->getRequestZBuffer())
                     {
-                        glDepthFunc(GL_LESS);
+                        stateCache.setDepthFunc(GL_LESS);
                         //depthMaskOn = true;
                     } else {
-                        glDepthFunc(GL_ALWAYS);
+                        stateCache.setDepthFunc(GL_ALWAYS);
                     }
                 }
                 
                 // If we're drawing lines or points we don't want to update the z buffer
                 if (zBufferMode != zBufferOff)
                 {
-                    if (drawContain.drawable->getWriteZbuffer())
-                        glDepthMask(GL_TRUE);
-                    else
-                        glDepthMask(GL_FALSE);
+                    stateCache.setDepthMask(drawContain.drawable->getWriteZbuffer());
                 }
                 
                 // Set up transforms to use right now
-                const Matrix4f currentMvpMat = Matrix4dToMatrix4f(drawContain.mvpMat);
-                const Matrix4f currentMvpInvMat = Matrix4dToMatrix4f(drawContain.mvpMat.inverse());
-                const Matrix4f currentMvMat = Matrix4dToMatrix4f(drawContain.mvMat);
-                const Matrix4f currentMvNormalMat = Matrix4dToMatrix4f(drawContain.mvNormalMat);
+                const DrawMatrices &mats = drawMats[drawContain.firstMats];
+                const Matrix4f &currentMvpMat = mats.mvp;
                 baseFrameInfo.mvpMat = currentMvpMat;
-                baseFrameInfo.mvpInvMat = currentMvpInvMat;
-                baseFrameInfo.viewAndModelMat = currentMvMat;
-                baseFrameInfo.viewModelNormalMat = currentMvNormalMat;
+                baseFrameInfo.mvpInvMat = mats.mvpInv;
+                baseFrameInfo.viewAndModelMat = mats.mv;
+                baseFrameInfo.viewModelNormalMat = mats.mvNormal;
                 
                 // Figure out the program to use for drawing
                 const SimpleIdentity drawProgramId = drawContain.drawable->getProgram();
@@ -619,8 +762,7 @@ void SceneRendererGLES::render(TimeInterval duration)
                     auto program = (ProgramGLES *)scene->getProgram(drawProgramId);
                     if (program)
                     {
-                        //                    [renderStateOptimizer setUseProgram:program->getProgram()];
-                        glUseProgram(program->getProgram());
+                        stateCache.useProgram(program->getProgram());
                         // Assign the lights if we need to
                         if (program->hasLights() && !lights.empty())
                             program->setLights(lights, lightsLastUpdated, &defaultMat, currentMvpMat);
@@ -637,7 +779,9 @@ void SceneRendererGLES::render(TimeInterval duration)
                     continue;
                 
                 // Only draw drawables that are active for the current render target
-                if (drawContain.drawable->getRenderTarget() != renderTarget->getId())
+                if (drawContain.drawable->getRenderTarget() != targetID)
+                    continue;
+                if (which != DrawAll && drawContain.drawable->isScreenSpace() != (which == DrawScreenSpace))
                     continue;
 
                 if (UNLIKELY(reportStats))
@@ -652,25 +796,171 @@ void SceneRendererGLES::render(TimeInterval duration)
                 if (UNLIKELY(reportStats))
                     perfTimer.startTiming("Draw Drawables");
 
-                // Draw using the given program
-                drawContain.drawable->draw(&baseFrameInfo,scene);
+                // Draw using the given program.
+                // Drawables that can repeat their draw calls do the other copies of the world
+                //  themselves, without setting everything up again.
+                if (numOffsets > 1 && drawContain.drawable->drawsWorldCopies())
+                {
+                    baseFrameInfo.copyMats = &drawMats[drawContain.firstMats + 1];
+                    baseFrameInfo.numCopyMats = numOffsets - 1;
+                    drawContain.drawable->draw(&baseFrameInfo,scene);
+                    baseFrameInfo.copyMats = nullptr;
+                    baseFrameInfo.numCopyMats = 0;
+                }
+                else
+                {
+                    for (unsigned int off=0;off<numOffsets;off++)
+                    {
+                        if (off > 0)
+                        {
+                            const DrawMatrices &offMats = drawMats[drawContain.firstMats + off];
+                            baseFrameInfo.mvpMat = offMats.mvp;
+                            baseFrameInfo.mvpInvMat = offMats.mvpInv;
+                            baseFrameInfo.viewAndModelMat = offMats.mv;
+                            baseFrameInfo.viewModelNormalMat = offMats.mvNormal;
+                        }
+                        drawContain.drawable->draw(&baseFrameInfo,scene);
+                    }
+                }
 
                 if (UNLIKELY(reportStats))
                     perfTimer.stopTiming("Draw Drawables");
 
-                // If we had a local matrix, set the frame info back to the general one
-                //            if (localMat)
-                //                offFrameInfo.mvpMat = mvpMat;
-                
-                numDrawables++;
+                if (UNLIKELY(collectStats))
+                    frameStat.add(FrameStats::Triangles, (double)drawContain.drawable->getNumTris() * numOffsets);
+
+                numDrawables += numOffsets;
+            }
+        };
+
+        // If we're falling behind, draw the map at a lower resolution and scale it up,
+        // then draw the screen space objects on top at full resolution
+        RenderTargetGLES *mapTarget = nullptr;
+        const float resScale = dynamicRes.getScale();
+        if (resScale < 1.0f && !framebufferTex && hasFramebufferBlitSupport)
+        {
+            const int scaledWidth = std::max(1,(int)(framebufferWidth * resScale + 0.5f));
+            const int scaledHeight = std::max(1,(int)(framebufferHeight * resScale + 0.5f));
+            if (!scaledTarget)
+            {
+                scaledTarget = std::make_shared<RenderTargetGLES>(EmptyIdentity);
+            }
+            if (scaledTarget->framebuffer == 0 || scaledTarget->width != scaledWidth || scaledTarget->height != scaledHeight)
+            {
+                // Blits can't go into a multisampled framebuffer
+                GLint sampleBuffers = 0;
+                if (const auto defaultTarget = dynamic_cast<RenderTargetGLES *>(renderTargets.back().get()))
+                {
+                    glBindFramebuffer(GL_FRAMEBUFFER, defaultTarget->framebuffer);
+                    glGetIntegerv(GL_SAMPLE_BUFFERS, &sampleBuffers);
+                }
+                if (sampleBuffers > 0 || !scaledTarget->initOffscreen(scaledWidth,scaledHeight))
+                {
+                    wkLogLevel(Warn,"Turning off dynamic resolution, can't scale into this framebuffer");
+                    scaledTarget->clear();
+                    dynamicRes.setEnabled(false);
+                }
+            }
+            if (scaledTarget->framebuffer)
+            {
+                mapTarget = scaledTarget.get();
             }
         }
+
+        if (UNLIKELY(gpuTimings.isEnabled() || gpuTimedRes) && hasTimerQuerySupport)
+            startGPUQueries();
+
+        // Iterate through rendering targets here
+        for (const RenderTargetRef &inRenderTarget : renderTargets)
+        {
+            const auto renderTarget = dynamic_cast<RenderTargetGLES*>(inRenderTarget.get());
+            if (!renderTarget)
+            {
+                continue;
+            }
+
+            // Cached targets keep what they drew last time until something changes
+            if (!renderTargetNeedsDraw(renderTarget))
+            {
+                continue;
+            }
+            renderTarget->dirty = false;
+
+            // Offscreen targets come first and the screen is last, so each gets one query
+            if (UNLIKELY(gpuQuerySlot >= 0))
+                timeGPUPhase(renderTarget->getId() == EmptyIdentity ? GPUTimings::ScreenRender : GPUTimings::Offscreen);
+            
+            // Drawables leave their textures bound, which mustn't include the one we're rendering to
+            stateCache.unbindTextures();
+
+            const bool scaled = mapTarget && renderTarget->getId() == EmptyIdentity;
+            if (scaled)
+            {
+                std::copy(renderTarget->clearColor,renderTarget->clearColor + 4,mapTarget->clearColor);
+                mapTarget->blendEnable = renderTarget->blendEnable;
+                mapTarget->setActiveFramebuffer(this);
+            }
+            else
+            {
+                renderTarget->setActiveFramebuffer(this);
+            }
+            
+            if (renderTarget->clearEveryFrame || renderTarget->clearOnce)
+            {
+                renderTarget->clearOnce = false;
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                CheckGLError("SceneRendererES2: glClear");
+            }
+
+            if (!scaled)
+            {
+                drawPass(renderTarget->getId(),DrawAll);
+                continue;
+            }
+
+            drawPass(EmptyIdentity,DrawWorld);
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, mapTarget->framebuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, renderTarget->framebuffer);
+            glBlitFramebuffer(0, 0, mapTarget->width, mapTarget->height,
+                              0, 0, renderTarget->width, renderTarget->height,
+                              GL_COLOR_BUFFER_BIT, GL_LINEAR);
+            CheckGLError("SceneRendererES2: glBlitFramebuffer");
+
+            // The map's depth doesn't carry over, so start the screen space pass clean
+            stateCache.unbindTextures();
+            renderTarget->setActiveFramebuffer(this);
+            stateCache.setDepthMask(true);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            CheckGLError("SceneRendererES2: glClear");
+
+            drawPass(EmptyIdentity,DrawScreenSpace);
+        }
+
+        if (UNLIKELY(gpuQuerySlot >= 0))
+            endGPUQueries();
         
+        // Leave things clean for whoever's next
+        stateCache.unbindTextures();
+
         if (UNLIKELY(reportStats))
             perfTimer.stopTiming("Draw Execution");
 
         if (UNLIKELY(reportStats))
+        {
             perfTimer.addCount("Drawables drawn", numDrawables);
+            perfTimer.addCount("GL state calls skipped", (int)stateCache.getNumSkipped());
+        }
+
+        drewSomething = numDrawables > 0;
+
+        if (UNLIKELY(collectStats))
+        {
+            markPhase(FrameStats::DrawTime);
+            frameStat.add(FrameStats::DrawCalls, numDrawables);
+            frameStat.add(FrameStats::StateCalls, stateCache.getNumCalls());
+            frameStat.add(FrameStats::StateCallsSkipped, stateCache.getNumSkipped());
+        }
 
         // Anything generated needs to be cleaned up
         generatedDrawables.clear();
@@ -689,6 +979,10 @@ void SceneRendererGLES::render(TimeInterval duration)
     if (UNLIKELY(reportStats))
         perfTimer.startTiming("Present Renderbuffer");
 
+    // Pick up finished readbacks before starting new ones on this frame
+    finishReadbacks();
+    startReadbacks();
+
 #ifndef __ANDROID__
     // Explicitly discard the depth buffer
     const GLenum discards[]  = {GL_DEPTH_ATTACHMENT};
@@ -698,30 +992,56 @@ void SceneRendererGLES::render(TimeInterval duration)
     
     // Subclass with do the presentation
     presentRender();
+
+    // Whatever was removed in earlier frames can go once the GPU is past them
+    if (const auto glTeardown = std::dynamic_pointer_cast<RenderTeardownInfoGLES>(teardownInfo))
+        glTeardown->endFrame(this);
     
     // Snapshots tend to be platform specific
     snapshotCallback(now);
     
     if (UNLIKELY(reportStats))
         perfTimer.stopTiming("Present Renderbuffer");
+
+    if (UNLIKELY(collectStats))
+        markPhase(FrameStats::PresentTime);
     
     if (UNLIKELY(reportStats))
         perfTimer.stopTiming("Render Frame");
 
+    if (UNLIKELY(!startupTimeline.isDone()))
+        noteStartupFrame(drewSomething);
+
     const TimeInterval newNow = scene->getCurrentTime();
     const TimeInterval frameDuration = newNow - now;
 
     // If we've finished faster than is necessary to achieve the target frame rate, process
     // changes that came in or became active since we started so that the next frame is faster.
+    // This gets whatever the first pass left of the change budget.
     if (frameDuration < duration)
     {
         if (UNLIKELY(reportStats))
             perfTimer.startTiming("Scene processing 2");
 
-        scene->processChanges(theView, this, newNow + duration / 2);
+        const int numChanges2 = scene->processChanges(theView, this, newNow + duration / 2, true);
 
         if (UNLIKELY(reportStats))
             perfTimer.stopTiming("Scene processing 2");
+
+        if (UNLIKELY(collectStats))
+        {
+            markPhase(FrameStats::ChangeTime);
+            frameStat.add(FrameStats::ChangesExecuted, numChanges2);
+        }
+    }
+
+    // Take this every frame so it doesn't pile up while we're not recording
+    const size_t uploadBytes = scene->takeUploadBytes();
+    if (UNLIKELY(collectStats))
+    {
+        frameStat.add(FrameStats::FrameTime, TimeGetCurrent() - frameStart);
+        frameStat.add(FrameStats::TextureBytes, (double)uploadBytes);
+        frameStats.addFrame(frameStat);
     }
 
     // Update the frames per sec
@@ -768,6 +1088,227 @@ RawDataRef SceneRendererGLES::getSnapshotAt(SimpleIdentity renderTargetID, int x
     return RawDataRef();
 }
 
+bool SceneRendererGLES::hasReadbacks()
+{
+    return !activeReadbacks.empty() || SceneRenderer::hasReadbacks();
+}
+
+void SceneRendererGLES::startReadbacks()
+{
+    // No compute to count with in OpenGL ES 3.0
+    for (const auto &request : takeHistograms())
+        request.callback(RenderTargetHistogramRef());
+
+    std::vector<ReadbackRequest> requests = takeReadbacks();
+    if (requests.empty())
+        return;
+
+    // Without pixel buffers we fall back to a copy that waits on the GPU
+    const bool async = setupInfo.glesVersion >= 3 && hasMapBufferSupport;
+
+    GLint oldFramebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldFramebuffer);
+
+    for (auto &request : requests)
+    {
+        RenderTargetGLES *renderTarget = nullptr;
+        for (const auto &target : renderTargets)
+        {
+            if (target->getId() == request.targetID)
+            {
+                renderTarget = dynamic_cast<RenderTargetGLES *>(target.get());
+                break;
+            }
+        }
+        // No min/max calculation in OpenGL
+        if (!renderTarget || request.minMax)
+        {
+            request.callback(RawDataRef());
+            continue;
+        }
+
+        int x = request.x, y = request.y, width = request.width, height = request.height;
+        if (width <= 0 || height <= 0)
+        {
+            x = 0;  y = 0;
+            width = renderTarget->width;  height = renderTarget->height;
+        }
+        if (width <= 0 || height <= 0)
+        {
+            request.callback(RawDataRef());
+            continue;
+        }
+
+        if (!async)
+        {
+            request.callback(renderTarget->snapshot(x,y,width,height));
+            continue;
+        }
+
+        // Note: Assuming RGBA8, as snapshot() does
+        const size_t len = (size_t)width * height * 4;
+        const GLuint pboId = setupInfo.memManager->getBufferID();
+        if (!pboId)
+        {
+            request.callback(RawDataRef());
+            continue;
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, renderTarget->framebuffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pboId);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)len, nullptr, GL_STREAM_READ);
+        // With a pixel buffer bound, this just queues the copy
+        glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        CheckGLError("SceneRendererGLES::startReadbacks()");
+
+        const GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        activeReadbacks.push_back(ReadbackGLES { pboId, fence, len, std::move(request.callback) });
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)oldFramebuffer);
+}
+
+void SceneRendererGLES::finishReadbacks()
+{
+    for (auto it = activeReadbacks.begin(); it != activeReadbacks.end(); )
+    {
+        // Just checking, we don't want to wait
+        const GLenum status = glClientWaitSync(it->fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+        {
+            ++it;
+            continue;
+        }
+        glDeleteSync(it->fence);
+
+        RawDataRef data;
+        if (status != GL_WAIT_FAILED)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, it->pboId);
+            if (const void *glMem = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)it->len, GL_MAP_READ_BIT))
+            {
+                auto *pixels = (unsigned char *)malloc(it->len);
+                memcpy(pixels, glMem, it->len);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                data = std::make_shared<RawDataWrapper>(pixels,it->len,true);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            CheckGLError("SceneRendererGLES::finishReadbacks()");
+        }
+        setupInfo.memManager->removeBufferID(it->pboId);
+
+        const ReadbackCallback callback = std::move(it->callback);
+        it = activeReadbacks.erase(it);
+        callback(data);
+    }
+}
+
+void SceneRendererGLES::startGPUQueries()
+{
+    finishGPUQueries();
+
+    // If the GPU is that far behind, skip this frame rather than wait
+    gpuQuerySlot = -1;
+    GPUQueriesGLES &slot = gpuQueries[gpuQueryNext];
+    if (slot.pending)
+        return;
+
+    for (int pp=0;pp<GPUTimings::Total;pp++)
+    {
+        if (!slot.queries[pp])
+            glGenQueries(1, &slot.queries[pp]);
+        slot.active[pp] = false;
+    }
+    gpuQuerySlot = gpuQueryNext;
+    gpuQueryPhase = GPUTimings::Total;
+}
+
+void SceneRendererGLES::timeGPUPhase(GPUTimings::Phase phase)
+{
+    if (gpuQuerySlot < 0 || phase == gpuQueryPhase)
+        return;
+    GPUQueriesGLES &slot = gpuQueries[gpuQuerySlot];
+
+    // Only one timer can run at a time
+    if (gpuQueryPhase != GPUTimings::Total)
+        glEndQuery(GL_TIME_ELAPSED_EXT);
+    gpuQueryPhase = GPUTimings::Total;
+
+    // A phase that comes back around in the same frame goes untimed the second time
+    if (phase != GPUTimings::Total && !slot.active[phase])
+    {
+        glBeginQuery(GL_TIME_ELAPSED_EXT, slot.queries[phase]);
+        slot.active[phase] = true;
+        gpuQueryPhase = phase;
+    }
+    CheckGLError("SceneRendererGLES::timeGPUPhase()");
+}
+
+void SceneRendererGLES::endGPUQueries()
+{
+    timeGPUPhase(GPUTimings::Total);
+
+    gpuQueries[gpuQuerySlot].pending = true;
+    gpuQueries[gpuQuerySlot].moving = viewMoved;
+    gpuQueryNext = (gpuQuerySlot + 1) % NumGPUQueryFrames;
+    gpuQuerySlot = -1;
+}
+
+void SceneRendererGLES::finishGPUQueries()
+{
+    // Something like a power state change spoils everything in flight
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    // Oldest first, stopping at the first one that isn't done
+    for (int ii=0;ii<NumGPUQueryFrames;ii++)
+    {
+        GPUQueriesGLES &slot = gpuQueries[(gpuQueryNext + ii) % NumGPUQueryFrames];
+        if (!slot.pending)
+            continue;
+        if (disjoint)
+        {
+            slot.pending = false;
+            continue;
+        }
+
+        GPUTimings::Frame frame;
+        bool available = true;
+        for (int pp=0;pp<GPUTimings::Total && available;pp++)
+        {
+            if (!slot.active[pp])
+                continue;
+            GLuint isAvailable = GL_FALSE;
+            glGetQueryObjectuiv(slot.queries[pp], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+            if (isAvailable)
+            {
+                // Nanoseconds, which a 32 bit result covers for anything short of four seconds
+                GLuint elapsed = 0;
+                glGetQueryObjectuiv(slot.queries[pp], GL_QUERY_RESULT, &elapsed);
+                frame.add((GPUTimings::Phase)pp, elapsed / 1e9);
+            }
+            else
+            {
+                available = false;
+            }
+        }
+        if (!available)
+            break;
+
+        slot.pending = false;
+        if (gpuTimings.isEnabled())
+            gpuTimings.addFrame(frame);
+        if (dynamicRes.isEnabled())
+        {
+            double total = 0.0;
+            for (int pp=0;pp<GPUTimings::Total;pp++)
+                total += frame.values[pp];
+            dynamicRes.addGPUFrame(total, 1.0 / std::max(framePacer.getDisplayRate(),1), slot.moving);
+        }
+    }
+    CheckGLError("SceneRendererGLES::finishGPUQueries()");
+}
 
 BasicDrawableBuilderRef SceneRendererGLES::makeBasicDrawableBuilder(const std::string &name) const
 {
@@ -809,4 +1350,14 @@ DynamicTextureRef SceneRendererGLES::makeDynamicTexture(const std::string &name)
     return std::make_shared<DynamicTextureGLES>(name);
 }
 
+Texture *SceneRendererGLES::makeRenderTexture(const std::string &name,int width,int height,TextureType type) const
+{
+    auto tex = new TextureGLES(name);
+    tex->setWidth(width);
+    tex->setHeight(height);
+    tex->setIsEmptyTexture(true);
+    tex->setFormat(type);
+    return tex;
+}
+
 }
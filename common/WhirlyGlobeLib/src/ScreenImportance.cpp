@@ -148,6 +148,56 @@ DisplaySolid::DisplaySolid(const QuadTreeIdentifier &nodeIdent,
     valid = true;
 }
 
+// Importance of a polygon already in clip space for one of the view matrices
+static double ClipSpaceImportance(Vector4dVector &&pts,double origArea,const Point3d &norm,
+                                  ViewState *viewState,unsigned int offi,const WhirlyKit::Point2f &frameSize)
+{
+    // The points are in clip space, so clip!
+    Vector4dVector clipSpacePts;
+    clipSpacePts.reserve(2*pts.size());
+    ClipHomogeneousPolygon(std::move(pts),clipSpacePts);
+
+    // Outside the viewing frustum, so ignore it
+    if (clipSpacePts.empty())
+        return 0.0;
+        
+    // Project to the screen
+    Point2dVector screenPts;
+    screenPts.reserve(clipSpacePts.size());
+
+    const Point2d halfFrameSize(frameSize.x()/2.0,frameSize.y()/2.0);
+    for (auto &outPt : clipSpacePts)
+    {
+        screenPts.emplace_back(outPt.x()/outPt.w() * halfFrameSize.x() + halfFrameSize.x(),
+                               outPt.y()/outPt.w() * halfFrameSize.y() + halfFrameSize.y());
+    }
+
+    const double screenArea = CalcLoopArea(screenPts);
+    // The polygon came out backwards, so toss it
+    if (!std::isfinite(screenArea) || screenArea <= 0.0)
+        return 0.0;
+
+    // Now project the screen points back into model space
+    Point3dVector backPts;
+    backPts.reserve(screenPts.size());
+    for (unsigned int ii=0;ii<screenPts.size();ii++)
+    {
+        const Vector4d modelPt = viewState->invProjMatrix * clipSpacePts[ii];
+        const Vector4d backPt = viewState->invFullMatrices[offi] * modelPt;
+        backPts.emplace_back(backPt.x(),backPt.y(),backPt.z());
+    }
+
+    // Then calculate the area
+    const double backArea = std::abs(PolygonArea(backPts,norm));
+
+    // Now we know how much of the original polygon made it out to the screen
+    // We can scale its importance accordingly.
+    // This gets rid of small slices of big tiles not getting loaded
+    const double scale = (backArea == 0.0) ? 1.0 : origArea / backArea;
+
+    return std::abs(screenArea) * scale;
+}
+
 double PolyImportance(const Point3dVector &poly,const Point3d &norm,ViewState *viewState,const WhirlyKit::Point2f &frameSize)
 {
     double import = 0.0;
@@ -164,61 +214,14 @@ double PolyImportance(const Point3dVector &poly,const Point3d &norm,ViewState *v
             // And then the projection matrix.  Now we're in clip space
             pts.emplace_back(viewState->projMatrix * modPt);
         }
-        
-        // The points are in clip space, so clip!
-        Vector4dVector clipSpacePts;
-        clipSpacePts.reserve(2*pts.size());
-        ClipHomogeneousPolygon(std::move(pts),clipSpacePts);
-        
-        // Outside the viewing frustum, so ignore it
-        if (clipSpacePts.empty())
-            continue;
-        
-        // Project to the screen
-        Point2dVector screenPts;
-        screenPts.reserve(clipSpacePts.size());
 
-        const Point2d halfFrameSize(frameSize.x()/2.0,frameSize.y()/2.0);
-        for (auto &outPt : clipSpacePts)
-        {
-            screenPts.emplace_back(outPt.x()/outPt.w() * halfFrameSize.x() + halfFrameSize.x(),
-                                   outPt.y()/outPt.w() * halfFrameSize.y() + halfFrameSize.y());
-        }
-        
-        const double screenArea = CalcLoopArea(screenPts);
-        // The polygon came out backwards, so toss it
-        if (!std::isfinite(screenArea) || screenArea <= 0.0)
-            continue;
-        
-        // Now project the screen points back into model space
-        Point3dVector backPts;
-        backPts.reserve(screenPts.size());
-        for (unsigned int ii=0;ii<screenPts.size();ii++)
-        {
-            const Vector4d modelPt = viewState->invProjMatrix * clipSpacePts[ii];
-            const Vector4d backPt = viewState->invFullMatrices[offi] * modelPt;
-            backPts.emplace_back(backPt.x(),backPt.y(),backPt.z());
-        }
-
-        // Then calculate the area
-        const double backArea = std::abs(PolygonArea(backPts,norm));
-
-        // Now we know how much of the original polygon made it out to the screen
-        // We can scale its importance accordingly.
-        // This gets rid of small slices of big tiles not getting loaded
-        const double scale = (backArea == 0.0) ? 1.0 : origArea / backArea;
-
-        const double newImport =  std::abs(screenArea) * scale;
-        if (newImport > import)
-        {
-            import = newImport;
-        }
+        import = std::max(import,ClipSpaceImportance(std::move(pts),origArea,norm,viewState,offi,frameSize));
     }
     
     return import;
 }
 
-bool DisplaySolid::isInside(const Point3d &pt)
+bool DisplaySolid::isInside(const Point3d &pt) const
 {
     return bbox0.x() <= pt.x() &&
            bbox0.y() <= pt.y() &&
@@ -361,5 +364,191 @@ double ScreenImportance(ViewState *viewState,const WhirlyKit::Point2f &frameSize
     
     return import;
 }
+
+void ScreenImportance(ViewState *viewState,const WhirlyKit::Point2f &frameSize,int pixelsSquare,
+                      WhirlyKit::CoordSystem *srcSystem,WhirlyKit::CoordSystemDisplayAdapter *coordAdapter,
+                      const std::vector<QuadTreeIdentifier> &nodeIdents,const std::vector<Mbr> &nodeMbrs,
+                      std::vector<double> &imports)
+{
+    const size_t numNodes = std::min(nodeIdents.size(),nodeMbrs.size());
+    std::vector<DisplaySolidRef> dispSolids;
+    dispSolids.reserve(numNodes);
+    for (size_t ni=0;ni<numNodes;ni++)
+        dispSolids.push_back(std::make_shared<DisplaySolid>(nodeIdents[ni],nodeMbrs[ni],0.0,0.0,srcSystem,coordAdapter));
+
+    ScreenImportance(viewState,frameSize,pixelsSquare,dispSolids,imports);
+}
+
+void ScreenImportance(ViewState *viewState,const WhirlyKit::Point2f &frameSize,int pixelsSquare,
+                      const std::vector<DisplaySolidRef> &dispSolids,std::vector<double> &imports)
+{
+    const size_t numNodes = dispSolids.size();
+    imports.assign(numNodes,0.0);
+    if (numNodes == 0)
+        return;
+
+    const Point3d &eyePos = viewState->eyePos;
+    const bool isFlat = viewState->coordAdapter->isFlat();
+
+    // Polygons facing us, pointing into the big list of corners
+    struct BatchPoly
+    {
+        size_t node;
+        size_t start,count;
+        double origArea;
+        Point3d norm;
+        double import;
+    };
+    std::vector<BatchPoly> batchPolys;
+    std::vector<double> corners;
+    std::vector<double> scales(numNodes,1.0);
+
+    for (size_t ni=0;ni<numNodes;ni++)
+    {
+        if (!dispSolids[ni] || !dispSolids[ni]->valid)
+            continue;
+        const DisplaySolid &dispSolid = *dispSolids[ni];
+
+        // If the viewer is inside the bounds, the node is maximally important
+        if (!isFlat && dispSolid.isInside(eyePos))
+        {
+            imports[ni] = MAXFLOAT / (pixelsSquare * pixelsSquare);
+            scales[ni] = 0.0;
+            continue;
+        }
+        scales[ni] = (dispSolid.polys.size() > 1 ? 0.5 : 1.0) / (pixelsSquare * pixelsSquare);
+
+        for (unsigned int ii=0;ii<dispSolid.polys.size();ii++)
+        {
+            const Point3dVector &poly = dispSolid.polys[ii];
+            const Point3d &norm = dispSolid.normals[ii];
+            if (norm.dot(eyePos) < 0.0)
+                continue;
+
+            batchPolys.push_back(BatchPoly { ni, corners.size()/4, poly.size(),
+                                             std::abs(PolygonArea(poly,norm)), norm, 0.0 });
+            for (const auto &pt : poly)
+            {
+                corners.push_back(pt.x());
+                corners.push_back(pt.y());
+                corners.push_back(pt.z());
+                corners.push_back(1.0);
+            }
+        }
+    }
+
+    if (!batchPolys.empty())
+    {
+        // Project all the corners at once.  As one big matrix product Eigen
+        // can use the vector units (SSE/NEON) across the whole batch.
+        const Eigen::Map<const Eigen::Matrix<double,4,Eigen::Dynamic>> srcPts(corners.data(),4,corners.size()/4);
+        Eigen::Matrix<double,4,Eigen::Dynamic> clipPts(4,srcPts.cols());
+        for (unsigned int offi=0;offi<viewState->viewMatrices.size();offi++)
+        {
+            const Eigen::Matrix4d projFullMat = viewState->projMatrix * viewState->fullMatrices[offi];
+            clipPts.noalias() = projFullMat * srcPts;
+
+            for (auto &batchPoly : batchPolys)
+            {
+                Vector4dVector pts;
+                pts.reserve(batchPoly.count);
+                for (size_t pi=0;pi<batchPoly.count;pi++)
+                    pts.emplace_back(clipPts.col(batchPoly.start+pi));
+
+                const double import = ClipSpaceImportance(std::move(pts),batchPoly.origArea,batchPoly.norm,
+                                                          viewState,offi,frameSize);
+                batchPoly.import = std::max(batchPoly.import,import);
+            }
+        }
+    }
+
+    for (const auto &batchPoly : batchPolys)
+        imports[batchPoly.node] += batchPoly.import;
+    for (size_t ni=0;ni<numNodes;ni++)
+        if (scales[ni] != 0.0)
+            imports[ni] *= scales[ni];
+}
     
+size_t DisplaySolid::getMemoryUsage() const
+{
+    size_t size = sizeof(DisplaySolid);
+    for (const auto &poly : polys)
+        size += sizeof(poly) + poly.capacity() * sizeof(Point3d);
+    size += (normals.capacity() + surfNormals.capacity()) * sizeof(Point3d);
+    return size;
+}
+
+DisplaySolidCache::DisplaySolidCache(size_t maxBytes) :
+    maxBytes(maxBytes)
+{
+}
+
+void DisplaySolidCache::setMaxBytes(size_t newMaxBytes)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    maxBytes = newMaxBytes;
+    trim();
+}
+
+DisplaySolidRef DisplaySolidCache::getSolid(const QuadTreeIdentifier &ident,const Mbr &mbr,
+                                            const CoordSystem *srcSystem,const CoordSystemDisplayAdapter *coordAdapter)
+{
+    const int64_t key = ident.NodeNumber();
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        const auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            // Most recently used goes to the front
+            lru.splice(lru.begin(),lru,it->second);
+            hits++;
+            return it->second->solid;
+        }
+        misses++;
+    }
+
+    // Build it outside the lock, it's the slow part
+    auto solid = std::make_shared<DisplaySolid>(ident,mbr,0.0,0.0,srcSystem,coordAdapter);
+    const size_t size = solid->getMemoryUsage();
+
+    std::lock_guard<std::mutex> guardLock(lock);
+    if (maxBytes > 0 && entries.find(key) == entries.end())
+    {
+        lru.push_front(Entry { key, solid, size });
+        entries[key] = lru.begin();
+        curBytes += size;
+        trim();
+    }
+
+    return solid;
+}
+
+void DisplaySolidCache::clear()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    lru.clear();
+    entries.clear();
+    curBytes = 0;
+}
+
+void DisplaySolidCache::getStats(size_t &outBytes,size_t &outEntries,size_t &outHits,size_t &outMisses) const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    outBytes = curBytes;
+    outEntries = entries.size();
+    outHits = hits;
+    outMisses = misses;
+}
+
+void DisplaySolidCache::trim()
+{
+    while (curBytes > maxBytes && !lru.empty())
+    {
+        const Entry &oldest = lru.back();
+        curBytes -= oldest.size;
+        entries.erase(oldest.key);
+        lru.pop_back();
+    }
+}
+
 }
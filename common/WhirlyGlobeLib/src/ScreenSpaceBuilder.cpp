@@ -18,6 +18,7 @@
 
 #import "ScreenSpaceBuilder.h"
 #import "ScreenSpaceDrawableBuilder.h"
+#import "SharedAttributes.h"
 #import "WhirlyKitLog.h"
 
 namespace WhirlyKit
@@ -153,6 +154,8 @@ ScreenSpaceBuilder::DrawableWrap::DrawableWrap(SceneRenderer *render,const Drawa
 
     locDraw->ScreenSpaceInit(state.motion,state.rotation,state.hasMask);
     locDraw->setType(Triangles);
+    // Normals are only there for backface checks on the globe
+    locDraw->setCompactNormals();
     // A max of two textures per
     for (unsigned int ii=0;ii<state.texIDs.size() && ii<2;ii++)
         locDraw->setTexId(ii, state.texIDs[ii]);
@@ -184,6 +187,140 @@ ScreenSpaceBuilder::DrawableWrap::DrawableWrap(SceneRenderer *render,const Drawa
     }
 }
 
+ScreenSpaceBuilder::InstanceWrap::InstanceWrap(SceneRenderer *render,const DrawableState &state,SimpleIdentity instProgID,
+                                              const Point3d &center,TimeInterval startTime)
+    : center(center), startTime(startTime), state(state)
+{
+    if (!render)
+    {
+        throw std::invalid_argument("render");
+    }
+
+    // One quad, with the corners in the offsets.  The instances say where they go.
+    quadDraw = render->makeScreenSpaceDrawableBuilder("ScreenSpace Instance Quad");
+    quadDraw->ScreenSpaceInit(state.motion,state.rotation);
+    quadDraw->setType(Triangles);
+    quadDraw->setCompactNormals();
+    quadDraw->setCenter(center);
+    quadDraw->setKeepUpright(state.keepUpright);
+    if (state.motion)
+        quadDraw->setStartTime(startTime);
+    quadDraw->setTexId(0, state.texIDs[0]);
+    quadDraw->setProgram(instProgID);
+    quadDraw->setRequestZBuffer(false);
+    quadDraw->setWriteZBuffer(false);
+    quadDraw->setOnOff(false);
+    for (unsigned int ii=0;ii<4;ii++)
+    {
+        quadDraw->addPoint(center);
+        quadDraw->addNormal(Point3d(0,0,1));
+        quadDraw->addOffset(Point2f((ii == 1 || ii == 2) ? 1.0 : 0.0,(ii >= 2) ? 1.0 : 0.0));
+        quadDraw->addTexCoord(0, TexCoord(0,0));
+        quadDraw->addColor(RGBAColor::white());
+        if (state.motion)
+            quadDraw->addDir(Point3f(0,0,0));
+        if (state.rotation)
+            quadDraw->addRot(Point3f(0,0,0));
+    }
+    quadDraw->addTriangle(BasicDrawable::Triangle(0,1,2));
+    quadDraw->addTriangle(BasicDrawable::Triangle(0,2,3));
+
+    // The instances carry everything visible about the drawable
+    instDraw = render->makeBasicDrawableInstanceBuilder("ScreenSpace Instances");
+    instDraw->setMasterID(quadDraw->getDrawableID(),BasicDrawableInstance::LocalStyle);
+    instDraw->setPackedInstances(true);
+    instDraw->setProgram(instProgID);
+    instDraw->setDrawOrder(state.drawOrder);
+    instDraw->setDrawPriority(state.drawPriority);
+    if (state.renderTargetID != EmptyIdentity)
+        instDraw->setRenderTarget(state.renderTargetID);
+    instDraw->setFade(state.fadeDown, state.fadeUp);
+    instDraw->setVisibleRange(state.minVis, state.maxVis);
+    instDraw->setZoomInfo(state.zoomSlot, state.minZoomVis, state.maxZoomVis);
+    instDraw->setRequestZBuffer(false);
+    instDraw->setWriteZBuffer(false);
+    instDraw->setOnOff(state.enable);
+    if (state.startEnable != state.endEnable)
+        instDraw->setEnableTimeRange(state.startEnable, state.endEnable);
+    if (state.motion)
+    {
+        instDraw->setStartTime(startTime);
+        instDraw->setIsMoving(true);
+    }
+
+    // Instance centers are relative, so the shader needs this to find up on the globe
+    SingleVertexAttributeSet uniforms;
+    uniforms.insert(SingleVertexAttribute(u_originNameID,-1,(float)center.x(),(float)center.y(),(float)center.z()));
+    instDraw->setUniforms(uniforms);
+
+    // Scale, rotation and such get set up by the quad's tweaker, but run on the instances
+    if (const auto tweak = quadDraw->makeTweaker())
+    {
+        quadDraw->setupTweaker(tweak);
+        instDraw->addTweaker(tweak);
+    }
+}
+
+unsigned int ScreenSpaceBuilder::InstanceWrap::addInstance(const ScreenSpaceInstance &inst)
+{
+    insts.push_back(inst.getInstance());
+    return (unsigned int)(insts.size()-1);
+}
+
+bool ScreenSpaceBuilder::ScreenSpaceInstance::setCorners(const Point2dVector &coords,const std::vector<TexCoord> &texCoords,
+                                                         const Point2d &offset,float scale)
+{
+    if (coords.size() != 4 || texCoords.size() != 4)
+    {
+        return false;
+    }
+
+    // The fourth corner has to follow from the other three, on the screen and in the texture
+    const Point2d ex = coords[1] - coords[0];
+    const Point2d ey = coords[3] - coords[0];
+    const double tol = 1e-6 * (ex.squaredNorm() + ey.squaredNorm());
+    if ((coords[2] - coords[0] - ex - ey).squaredNorm() > tol)
+    {
+        return false;
+    }
+    const Eigen::Vector2f tx = texCoords[1] - texCoords[0];
+    const Eigen::Vector2f ty = texCoords[3] - texCoords[0];
+    const float texTol = 1e-6f * (tx.squaredNorm() + ty.squaredNorm());
+    if ((texCoords[2] - texCoords[0] - tx - ty).squaredNorm() > texTol)
+    {
+        return false;
+    }
+
+    org = ((coords[0] + offset) * scale).cast<float>();
+    edgeX = (ex * scale).cast<float>();
+    edgeY = (ey * scale).cast<float>();
+    texOrg = texCoords[0];
+    texEdgeX = tx;
+    texEdgeY = ty;
+
+    return true;
+}
+
+BasicDrawableInstance::SingleInstance ScreenSpaceBuilder::ScreenSpaceInstance::getInstance() const
+{
+    BasicDrawableInstance::SingleInstance singleInst;
+    singleInst.colorOverride = true;
+    singleInst.color = color;
+    singleInst.center = center;
+    singleInst.endCenter = center + dir;
+    singleInst.duration = 1.0;
+    singleInst.mat << org.x(),     edgeY.x(),    texEdgeX.x(), rotVec.x(),
+                      org.y(),     edgeY.y(),    texEdgeX.y(), rotVec.y(),
+                      edgeX.x(),   texOrg.x(),   texEdgeY.x(), rotVec.z(),
+                      edgeX.y(),   texOrg.y(),   texEdgeY.y(), globe ? 1.0 : 0.0;
+    return singleInst;
+}
+
+Point3d ScreenSpaceBuilder::calcNormal(const Point3d &worldLoc) const
+{
+    return coordAdapter->isFlat() ? Point3d(0,0,1) : worldLoc.normalized();
+}
+
 Point3d ScreenSpaceBuilder::CalcRotationVec(CoordSystemDisplayAdapter *coordAdapter,const Point3d &worldLoc,float rot)
 {
     // Switch from counter-clockwise to clockwise
@@ -208,13 +345,12 @@ Point3d ScreenSpaceBuilder::CalcRotationVec(CoordSystemDisplayAdapter *coordAdap
     return rotVec;
 }
 
-void ScreenSpaceBuilder::DrawableWrap::addVertex(CoordSystemDisplayAdapter *inCoordAdapter, float inScale,
-                                                 const Point3d &worldLoc, const Point3f *dir, float rot,
+void ScreenSpaceBuilder::DrawableWrap::addVertex(float inScale, const Point3d &worldLoc, const Point3d &norm,
+                                                 const Point3f *dir, const Point3d &rotVec,
                                                  const Point2d &inVert, const TexCoord *texCoord,
                                                  const RGBAColor *color, const SingleVertexAttributeSet *vertAttrs)
 {
-    locDraw->addPoint(Point3d(worldLoc.x()-center.x(),worldLoc.y()-center.y(),worldLoc.z()-center.z()));
-    Point3d norm = inCoordAdapter->isFlat() ? Point3d(0, 0, 1) : worldLoc.normalized();
+    locDraw->addPoint(worldLoc);
     locDraw->addNormal(norm);
     Point2d vert = inVert * inScale;
     locDraw->addOffset(vert);
@@ -227,7 +363,7 @@ void ScreenSpaceBuilder::DrawableWrap::addVertex(CoordSystemDisplayAdapter *inCo
     if (vertAttrs && !vertAttrs->empty())
         locDraw->addVertexAttributes(*vertAttrs);
     if (state.rotation)
-        locDraw->addRot(ScreenSpaceBuilder::CalcRotationVec(inCoordAdapter, worldLoc, rot));
+        locDraw->addRot(rotVec);
 }
 
 void ScreenSpaceBuilder::DrawableWrap::addTri(int v0, int v1, int v2)
@@ -323,11 +459,46 @@ void ScreenSpaceBuilder::setEnableRange(TimeInterval inStartEnable,TimeInterval
     curState.endEnable = inEndEnable;
 }
 
+void ScreenSpaceBuilder::setInstancing(bool enable)
+{
+    instPrograms.clear();
+
+    Scene *scene = (enable && sceneRender) ? sceneRender->getScene() : nullptr;
+    if (!scene)
+    {
+        return;
+    }
+
+    // Only the regular programs have instance versions, the rest stay as they are
+    const Program *instProg = scene->findProgramByName(MaplyScreenSpaceInstanceShader);
+    const Program *sdfInstProg = scene->findProgramByName(MaplyScreenSpaceSDFInstanceShader);
+    const auto addProg = [&](const char *name,const Program *toProg)
+    {
+        const Program *prog = scene->findProgramByName(name);
+        if (prog && toProg)
+        {
+            instPrograms[prog->getId()] = toProg->getId();
+        }
+    };
+    addProg(MaplyScreenSpaceDefaultShader,instProg);
+    addProg(MaplyScreenSpaceDefaultMotionShader,instProg);
+    addProg(MaplyScreenSpaceSDFShader,sdfInstProg);
+    addProg(MaplyScreenSpaceSDFMotionShader,sdfInstProg);
+}
+
 ScreenSpaceBuilder::DrawableWrapRef ScreenSpaceBuilder::findOrAddDrawWrap(
     const DrawableState &state,int numVerts,int numTris,const Point3d &center)
 {
     // Look for an existing drawable
     DrawableWrapRef drawWrap;
+    const auto setupWrap = [&](const DrawableWrapRef &wrap)
+    {
+        wrap->center = center;
+        wrap->locDraw->setCenter(center);
+        if (state.motion)
+            wrap->locDraw->setStartTime(sceneRender->getScene()->getCurrentTime());
+    };
+
     const auto it = drawables.find(state);
     if (it == drawables.end())
     {
@@ -343,11 +514,7 @@ ScreenSpaceBuilder::DrawableWrapRef ScreenSpaceBuilder::findOrAddDrawWrap(
 
         if (drawWrap)
         {
-            drawWrap->center = center;
-            const Eigen::Affine3d trans(Eigen::Translation3d(center.x(), center.y(), center.z()));
-            drawWrap->locDraw->setMatrix(trans.matrix());
-            if (state.motion)
-                drawWrap->locDraw->setStartTime(sceneRender->getScene()->getCurrentTime());
+            setupWrap(drawWrap);
             drawables[state] = (drawWrap);
         }
     }
@@ -362,6 +529,7 @@ ScreenSpaceBuilder::DrawableWrapRef ScreenSpaceBuilder::findOrAddDrawWrap(
             // It is, so we need to flush it and create a new one
             fullDrawables.push_back(drawWrap);
             drawWrap = std::make_shared<DrawableWrap>(sceneRender,state);
+            setupWrap(drawWrap);
             it->second = drawWrap;
         }
     }
@@ -369,6 +537,37 @@ ScreenSpaceBuilder::DrawableWrapRef ScreenSpaceBuilder::findOrAddDrawWrap(
     return drawWrap;
 }
 
+ScreenSpaceBuilder::InstanceWrapRef ScreenSpaceBuilder::findOrAddInstWrap(const DrawableState &state,
+                                                                          SimpleIdentity instProgID,
+                                                                          const Point3d &center)
+{
+    const auto it = instDrawables.find(state);
+    if (it != instDrawables.end())
+    {
+        if (it->second->insts.size() < MaxDrawablePoints)
+        {
+            return it->second;
+        }
+        // Big enough, start another one
+        fullInstDrawables.push_back(it->second);
+    }
+
+    InstanceWrapRef instWrap;
+    try
+    {
+        instWrap = std::make_shared<InstanceWrap>(sceneRender,state,instProgID,center,
+                                                  sceneRender->getScene()->getCurrentTime());
+    }
+    catch (const std::exception &ex)
+    {
+        wkLogLevel(Error, "Failed to create instance wrapper: %s", ex.what());
+        return instWrap;
+    }
+
+    instDrawables[state] = instWrap;
+    return instWrap;
+}
+
 void ScreenSpaceBuilder::addRectangle(const Point3d &worldLoc,const Point2d *coords,
                                       const TexCoord *texCoords,const RGBAColor &color,
                                       SimpleIDUnorderedSet *drawIDs)
@@ -381,12 +580,14 @@ void ScreenSpaceBuilder::addRectangle(const Point3d &worldLoc,const Point2d *coo
         drawIDs->insert(builder->getDrawableID());
     }
 
+    const Point3d norm = calcNormal(worldLoc);
+    const Point3d rotVec = drawWrap->state.rotation ? CalcRotationVec(coordAdapter,worldLoc,0.0) : Point3d(0,0,0);
     const unsigned int baseVert = builder->getNumPoints();
     for (unsigned int ii=0;ii<4;ii++)
     {
         const Point2d &coord = coords[ii];
         const TexCoord *texCoord = (texCoords ? &texCoords[ii] : nullptr);
-        drawWrap->addVertex(coordAdapter,scale,worldLoc, nullptr, 0.0, coord, texCoord, &color, nullptr);
+        drawWrap->addVertex(scale,worldLoc, norm, nullptr, rotVec, coord, texCoord, &color, nullptr);
     }
     drawWrap->addTri(0+baseVert,1+baseVert,2+baseVert);
     drawWrap->addTri(0+baseVert,2+baseVert,3+baseVert);
@@ -407,13 +608,14 @@ void ScreenSpaceBuilder::addRectangle(const Point3d &worldLoc,double rotation,
     }
 
     // Note: Do something with keepUpright
+    const Point3d norm = calcNormal(worldLoc);
+    const Point3d rotVec = drawWrap->state.rotation ? CalcRotationVec(coordAdapter,worldLoc,(float)rotation) : Point3d(0,0,0);
     const unsigned int baseVert = drawWrap->getDrawableBuilder()->getNumPoints();
     for (unsigned int ii=0;ii<4;ii++)
     {
         const Point2d &coord = coords[ii];
         const TexCoord *texCoord = (texCoords ? &texCoords[ii] : nullptr);
-        drawWrap->addVertex(coordAdapter,scale,worldLoc, nullptr,
-                            (float)rotation, coord, texCoord, &color, nullptr);
+        drawWrap->addVertex(scale,worldLoc, norm, nullptr, rotVec, coord, texCoord, &color, nullptr);
     }
     drawWrap->addTri(0+baseVert,1+baseVert,2+baseVert);
     drawWrap->addTri(0+baseVert,2+baseVert,3+baseVert);
@@ -462,7 +664,8 @@ void ScreenSpaceBuilder::addScreenObject(const ScreenSpaceObject &ssObj,
                                          const Point3d &worldLoc,
                                          const std::vector<ScreenSpaceConvexGeometry> *geoms,
                                          const std::vector<Eigen::Matrix3d> *places,
-                                         SimpleIDUnorderedSet *drawIDs)
+                                         SimpleIDUnorderedSet *drawIDs,
+                                         std::vector<VertexRange> *vertRanges)
 {
     for (unsigned int ii=0;ii<geoms->size();ii++)
     {
@@ -494,6 +697,46 @@ void ScreenSpaceBuilder::addScreenObject(const ScreenSpaceObject &ssObj,
         state.endEnable = ssObj.endEnable;
         VertexAttributeSetConvert(geom.vertexAttrs,state.vertexAttrs);
 
+        // Plain textured rectangles can be instances of a shared quad
+        if (!instPrograms.empty() && state.texIDs.size() == 1 && state.period == 0.0 && !state.hasMask &&
+            state.vertexAttrs.empty() && !state.opacityExp && !state.colorExp && !state.scaleExp)
+        {
+            const auto progIt = instPrograms.find(state.progID);
+            ScreenSpaceInstance inst;
+            if (progIt != instPrograms.end() && inst.setCorners(geom.coords,geom.texCoords,ssObj.offset,scale))
+            {
+                if (const auto instWrap = findOrAddInstWrap(state,progIt->second,worldLoc))
+                {
+                    // Same as below, motion is from the drawable's start time
+                    Point3d startLoc3d = worldLoc;
+                    if (state.motion && ssObj.startTime < ssObj.endTime)
+                    {
+                        const double dur = ssObj.endTime - ssObj.startTime;
+                        inst.dir = (ssObj.endWorldLoc - ssObj.worldLoc)/dur;
+                        startLoc3d = inst.dir * (instWrap->startTime - ssObj.startTime) + startLoc3d;
+                    }
+                    inst.center = startLoc3d - instWrap->center;
+                    inst.rotVec = state.rotation ? CalcRotationVec(coordAdapter,startLoc3d,(float)ssObj.getRotation()) :
+                                                   Point3d(0,0,0);
+                    inst.color = geom.color;
+                    inst.globe = !coordAdapter->isFlat();
+
+                    const SimpleIdentity instDrawID = instWrap->instDraw->getDrawableID();
+                    const unsigned int which = instWrap->addInstance(inst);
+                    if (drawIDs)
+                    {
+                        drawIDs->insert(instDrawID);
+                    }
+                    if (vertRanges)
+                    {
+                        vertRanges->push_back(VertexRange { instDrawID, which, 1, geom.color,
+                                                            instWrap->center, instWrap->startTime, true, inst });
+                    }
+                    continue;
+                }
+            }
+        }
+
         DrawableWrapRef drawWrap = findOrAddDrawWrap(state,(int)geom.coords.size(),(int)(geom.coords.size()-2),worldLoc);
         auto &builder = drawWrap->getDrawableBuilder();
 
@@ -516,22 +759,20 @@ void ScreenSpaceBuilder::addScreenObject(const ScreenSpaceObject &ssObj,
         }
 
         const unsigned int baseVert = drawWrap->locDraw->getNumPoints();
+        if (vertRanges)
+        {
+            vertRanges->push_back(VertexRange { builder->getDrawableID(), baseVert, (unsigned int)geom.coords.size(), geom.color,
+                                                drawWrap->center, drawWrap->locDraw->getStartTime() });
+        }
+        const Point3d norm = calcNormal(startLoc3d);
+        const Point3d rotVec = state.rotation ? CalcRotationVec(coordAdapter,startLoc3d,(float)ssObj.getRotation()) :
+                                                Point3d(0,0,0);
         for (unsigned int jj=0;jj<geom.coords.size();jj++)
         {
             const Point2d coord = geom.coords[jj] + ssObj.offset;
             const TexCoord *texCoord = (jj < geom.texCoords.size()) ? &geom.texCoords[jj] : nullptr;
-            const auto rot = (float)ssObj.getRotation();
-            if (state.motion)
-            {
-                const Point3f dir3f = dir.cast<float>();
-                drawWrap->addVertex(coordAdapter,scale,startLoc3d, &dir3f, rot, coord,
-                                    texCoord, &geom.color, &geom.vertexAttrs);
-            }
-            else
-            {
-                drawWrap->addVertex(coordAdapter,scale,startLoc3d, nullptr, rot, coord,
-                                    texCoord, &geom.color, &geom.vertexAttrs);
-            }
+            drawWrap->addVertex(scale,startLoc3d, norm, state.motion ? &dir : nullptr, rotVec, coord,
+                                texCoord, &geom.color, &geom.vertexAttrs);
         }
         for (unsigned int jj=0;jj<geom.coords.size()-2;jj++)
         {
@@ -556,12 +797,64 @@ void ScreenSpaceBuilder::buildDrawables(std::vector<BasicDrawableRef> &draws)
     drawables.clear();
 }
     
-std::vector<BasicDrawableRef> ScreenSpaceBuilder::flushChanges(ChangeSet &changes,SimpleIDSet &drawIDs)
+void ScreenSpaceBuilder::buildInstanceDrawables(std::vector<BasicDrawableRef> &quads,
+                                                std::vector<BasicDrawableInstanceRef> &insts)
 {
-    return flushChanges(changes, &drawIDs);
+    fullInstDrawables.reserve(fullInstDrawables.size() + instDrawables.size());
+    for (const auto &it : instDrawables)
+    {
+        fullInstDrawables.push_back(it.second);
+    }
+    instDrawables.clear();
+
+    quads.reserve(quads.size() + fullInstDrawables.size());
+    insts.reserve(insts.size() + fullInstDrawables.size());
+    for (const auto &instWrap : fullInstDrawables)
+    {
+        const auto quad = instWrap->quadDraw->getDrawable();
+        instWrap->instDraw->addInstances(instWrap->insts);
+        const auto inst = instWrap->instDraw->getDrawable();
+        inst->setBlendPremultipliedAlpha(quad->getBlendPremultipliedAlpha());
+        quads.push_back(quad);
+        insts.push_back(inst);
+    }
+    fullInstDrawables.clear();
 }
 
-std::vector<BasicDrawableRef> ScreenSpaceBuilder::flushChanges(ChangeSet &changes,SimpleIDSet *drawIDs)
+void ScreenSpaceBuilder::AddInstanceChanges(InstanceChangeMap &instChanges,ChangeSet &changes)
+{
+    for (auto &kv : instChanges)
+    {
+        std::vector<BasicDrawableInstance::SingleInstance> run;
+        unsigned int runStart = 0;
+        for (auto &instKv : kv.second)
+        {
+            if (!run.empty() && instKv.first != runStart + run.size())
+            {
+                changes.push_back(new InstancesChangeRequest(kv.first, runStart, std::move(run)));
+                run.clear();
+            }
+            if (run.empty())
+            {
+                runStart = instKv.first;
+            }
+            run.push_back(instKv.second);
+        }
+        if (!run.empty())
+        {
+            changes.push_back(new InstancesChangeRequest(kv.first, runStart, std::move(run)));
+        }
+    }
+}
+
+std::vector<BasicDrawableRef> ScreenSpaceBuilder::flushChanges(ChangeSet &changes,SimpleIDSet &drawIDs,
+                                                               std::vector<BasicDrawableInstanceRef> *instDraws)
+{
+    return flushChanges(changes, &drawIDs, instDraws);
+}
+
+std::vector<BasicDrawableRef> ScreenSpaceBuilder::flushChanges(ChangeSet &changes,SimpleIDSet *drawIDs,
+                                                               std::vector<BasicDrawableInstanceRef> *instDraws)
 {
     std::vector<BasicDrawableRef> draws;
     buildDrawables(draws);
@@ -575,6 +868,31 @@ std::vector<BasicDrawableRef> ScreenSpaceBuilder::flushChanges(ChangeSet &change
         changes.push_back(new AddDrawableReq(draw));
     }
 
+    // The quads have to be in the scene before the instances based on them
+    std::vector<BasicDrawableRef> quads;
+    std::vector<BasicDrawableInstanceRef> insts;
+    buildInstanceDrawables(quads, insts);
+    for (const auto &quad : quads)
+    {
+        if (drawIDs)
+        {
+            drawIDs->insert(quad->getId());
+        }
+        changes.push_back(new AddDrawableReq(quad));
+    }
+    for (const auto &inst : insts)
+    {
+        if (drawIDs)
+        {
+            drawIDs->insert(inst->getId());
+        }
+        changes.push_back(new AddDrawableReq(inst));
+    }
+    if (instDraws)
+    {
+        instDraws->insert(instDraws->end(), insts.begin(), insts.end());
+    }
+
     return draws;
 }
 
@@ -35,6 +35,7 @@ void ScreenSpaceDrawableBuilder::ScreenSpaceInit(bool hasMotion,bool hasRotation
     motion = hasMotion;
     BasicDrawableBuilder::Init();
     setupStandardAttributes();
+    basicDraw->screenSpace = true;
 
     offsetIndex = addAttribute(BDFloat2Type, a_offsetNameID);
     if (hasRotation || buildAnyway)
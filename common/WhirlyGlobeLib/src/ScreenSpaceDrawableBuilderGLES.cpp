@@ -265,6 +265,58 @@ void main()
 }
 )";
 
+// Rectangles drawn as instances of a unit quad.  The instance matrix holds the
+//  screen corner and edges, the texture corner and edges and the rotation vector.
+// The quad's offset picks out which corner we are.
+static const char *vertexShaderInstTri = R"(
+precision highp float;
+
+uniform mat4  u_mvpMatrix;
+uniform mat4  u_mvMatrix;
+uniform mat4  u_mvNormalMatrix;
+uniform float u_fade;
+uniform vec2  u_scale;
+uniform float u_time;
+uniform bool  u_activerot;
+uniform vec3  u_origin;
+
+attribute vec2 a_offset;
+attribute vec3 a_modelCenter;
+attribute mat4 a_singleMatrix;
+attribute vec4 a_instanceColor;
+attribute vec3 a_modelDir;
+
+varying vec2 v_texCoord;
+varying vec4 v_color;
+
+void main()
+{
+    v_texCoord = a_singleMatrix[1].zw + a_offset.x * a_singleMatrix[2].xy + a_offset.y * a_singleMatrix[2].zw;
+    v_color = a_instanceColor * u_fade;
+
+    // Position can be modified over time
+    vec3 thePos = a_modelCenter + u_time * a_modelDir;
+    // Flat objects face straight up, the rest face out from the globe
+    vec3 theNorm = (a_singleMatrix[3].w > 0.5) ? normalize(u_origin + thePos) : vec3(0.0,0.0,1.0);
+    // Convert from model space into display space
+    vec4 pt = u_mvMatrix * vec4(thePos,1.0);
+    pt /= pt.w;
+    // Make sure the object is facing the user
+    vec4 testNorm = u_mvNormalMatrix * vec4(theNorm,0.0);
+    float dot_res = dot(-pt.xyz,testNorm.xyz);
+    // Project the point all the way to screen space
+    vec4 screenPt = (u_mvpMatrix * vec4(thePos,1.0));
+    screenPt /= screenPt.w;
+    // Corner of the rectangle, then project the rotation into display space and drop the Z
+    vec2 offset = a_singleMatrix[0].xy + a_offset.x * a_singleMatrix[0].zw + a_offset.y * a_singleMatrix[1].xy;
+    vec4 projRot = u_mvNormalMatrix * vec4(a_singleMatrix[3].xyz,0.0);
+    vec2 rotY = normalize(projRot.xy);
+    vec2 rotX = vec2(rotY.y,-rotY.x);
+    vec2 screenOffset = (u_activerot ? offset.x*rotX + offset.y*rotY : offset);
+    gl_Position = (dot_res > 0.0 && pt.z <= 0.0) ? vec4(screenPt.xy + vec2(screenOffset.x*u_scale.x,screenOffset.y*u_scale.y),0.0,1.0) : vec4(0.0,0.0,0.0,0.0);
+}
+)";
+
 static const char *fragmentShaderTri = R"(
 precision highp float;
 
@@ -281,6 +333,25 @@ void main()
 }
 )";
 
+// Glyphs as distance fields, with the edge at 0.5.
+// Without derivatives in ES 2 we can't match the blend to the scale, so it's a fixed width.
+static const char *fragmentShaderSDF = R"(
+precision highp float;
+
+uniform sampler2D s_baseMap0;
+uniform bool  u_hasTexture;
+
+varying vec2      v_texCoord;
+varying vec4      v_color;
+
+void main()
+{
+    float dist = u_hasTexture ? texture2D(s_baseMap0, v_texCoord).a : 1.0;
+    float alpha = smoothstep(0.4, 0.6, dist);
+    gl_FragColor = v_color * alpha;
+}
+)";
+
 ProgramGLES *BuildScreenSpaceProgramGLES(const std::string &name,SceneRenderer *render)
 {
     ProgramGLES *shader = new ProgramGLES(name,vertexShaderTri,fragmentShaderTri);
@@ -341,4 +412,64 @@ ProgramGLES *BuildScreenSpaceMotion2DProgramGLES(const std::string &name,SceneRe
     return shader;
 }
 
+ProgramGLES *BuildScreenSpaceSDFProgramGLES(const std::string &name,SceneRenderer *render)
+{
+    ProgramGLES *shader = new ProgramGLES(name,vertexShaderTri,fragmentShaderSDF);
+    if (!shader->isValid())
+    {
+        delete shader;
+        shader = nullptr;
+    }
+    
+    if (shader)
+        glUseProgram(shader->getProgram());
+    
+    return shader;
+}
+
+ProgramGLES *BuildScreenSpaceSDFMotionProgramGLES(const std::string &name,SceneRenderer *render)
+{
+    ProgramGLES *shader = new ProgramGLES(name,vertexShaderMotionTri,fragmentShaderSDF);
+    if (!shader->isValid())
+    {
+        delete shader;
+        shader = nullptr;
+    }
+    
+    if (shader)
+        glUseProgram(shader->getProgram());
+    
+    return shader;
+}
+
+ProgramGLES *BuildScreenSpaceInstanceProgramGLES(const std::string &name,SceneRenderer *render)
+{
+    ProgramGLES *shader = new ProgramGLES(name,vertexShaderInstTri,fragmentShaderTri);
+    if (!shader->isValid())
+    {
+        delete shader;
+        shader = nullptr;
+    }
+    
+    if (shader)
+        glUseProgram(shader->getProgram());
+    
+    return shader;
+}
+
+ProgramGLES *BuildScreenSpaceSDFInstanceProgramGLES(const std::string &name,SceneRenderer *render)
+{
+    ProgramGLES *shader = new ProgramGLES(name,vertexShaderInstTri,fragmentShaderSDF);
+    if (!shader->isValid())
+    {
+        delete shader;
+        shader = nullptr;
+    }
+    
+    if (shader)
+        glUseProgram(shader->getProgram());
+    
+    return shader;
+}
+
 }
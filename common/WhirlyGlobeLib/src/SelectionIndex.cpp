@@ -0,0 +1,151 @@
+/*  SelectionIndex.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import <cmath>
+#import <limits>
+#import "SelectionIndex.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    // Below this we just look through the entries
+    constexpr int LeafSize = 8;
+    // Never bother rebuilding for fewer changes than this
+    constexpr size_t MinRebuild = 64;
+}
+
+void SelectionIndex::add(Kind kind,SimpleIdentity selectID,const Point3d &ll,const Point3d &ur,bool enable)
+{
+    remove(kind,selectID);
+
+    // Don't let removals pile up if nobody's picking
+    if (numDead > std::max(MinRebuild,entries.size() / 2))
+        rebuild();
+
+    where[kind][selectID] = entries.size();
+    entries.push_back(Entry { ll, ur, selectID, kind, enable, true });
+}
+
+void SelectionIndex::remove(Kind kind,SimpleIdentity selectID)
+{
+    const auto it = where[kind].find(selectID);
+    if (it == where[kind].end())
+        return;
+
+    entries[it->second].live = false;
+    where[kind].erase(it);
+    numDead++;
+}
+
+void SelectionIndex::setEnable(Kind kind,SimpleIdentity selectID,bool enable)
+{
+    const auto it = where[kind].find(selectID);
+    if (it != where[kind].end())
+        entries[it->second].enable = enable;
+}
+
+void SelectionIndex::rebuild()
+{
+    entries.erase(std::remove_if(entries.begin(),entries.end(),[](const Entry &entry) { return !entry.live; }),
+                  entries.end());
+    numDead = 0;
+
+    nodes.clear();
+    nodes.reserve(2 * entries.size() / LeafSize + 1);
+    if (!entries.empty())
+        BuildBoundsHierarchy(nodes,entries,0,(int)entries.size(),LeafSize);
+    numIndexed = entries.size();
+
+    for (auto &kindWhere : where)
+        kindWhere.clear();
+    for (size_t ii=0;ii<entries.size();ii++)
+        where[entries[ii].kind][entries[ii].selectID] = ii;
+}
+
+bool SelectionIndex::rayHits(const Point3d &ll,const Point3d &ur,const Point3d &org,const Point3d &dir,double slope)
+{
+    // The ray is widest at the far side of the box, so pad it out by that much
+    const Point3d farPt = (ll - org).cwiseAbs().cwiseMax((ur - org).cwiseAbs());
+    const double pad = slope * farPt.norm();
+
+    double tMin = 0.0, tMax = std::numeric_limits<double>::max();
+    for (int ii=0;ii<3;ii++)
+    {
+        const double lo = ll[ii] - pad, hi = ur[ii] + pad;
+        if (dir[ii] == 0.0)
+        {
+            if (org[ii] < lo || org[ii] > hi)
+                return false;
+            continue;
+        }
+        double t0 = (lo - org[ii]) / dir[ii], t1 = (hi - org[ii]) / dir[ii];
+        if (t0 > t1)
+            std::swap(t0,t1);
+        tMin = std::max(tMin,t0);
+        tMax = std::min(tMax,t1);
+        if (tMin > tMax)
+            return false;
+    }
+
+    return true;
+}
+
+void SelectionIndex::query(const Point3d &org,const Point3d &dir,double slope,std::vector<Candidate> &results)
+{
+    const size_t numPending = entries.size() - numIndexed;
+    if (numPending > std::max(MinRebuild,numIndexed / 8) || numDead > std::max(MinRebuild,numIndexed / 4))
+        rebuild();
+
+    const auto checkEntry = [&](const Entry &entry)
+    {
+        if (entry.live && entry.enable && rayHits(entry.ll,entry.ur,org,dir,slope))
+            results.push_back(Candidate { entry.selectID, entry.kind });
+    };
+
+    if (!nodes.empty())
+    {
+        std::vector<int> stack;
+        stack.push_back(0);
+        while (!stack.empty())
+        {
+            const Node &node = nodes[stack.back()];
+            stack.pop_back();
+
+            if (!rayHits(node.ll,node.ur,org,dir,slope))
+                continue;
+
+            if (node.count > 0)
+            {
+                for (int ii=node.first;ii<node.first+node.count;ii++)
+                    checkEntry(entries[ii]);
+            }
+            else
+            {
+                stack.push_back(node.left);
+                stack.push_back(node.right);
+            }
+        }
+    }
+
+    // Anything added since the last build
+    for (size_t ii=numIndexed;ii<entries.size();ii++)
+        checkEntry(entries[ii]);
+}
+
+}
@@ -16,6 +16,7 @@
  *  limitations under the License.
  */
 
+#import <unordered_map>
 #import "SelectionManager.h"
 #import "GlobeMath.h"
 #import "MaplyView.h"
@@ -103,7 +104,7 @@ SelectionManager::SelectionManager(Scene *scene)
 }
 
 // Add a rectangle (in 3-space) available for selection
-void SelectionManager::addSelectableRect(SimpleIdentity selectId,const Point3f *pts,bool enable)
+void SelectionBatch::addSelectableRect(SimpleIdentity selectId,const Point3f *pts,bool enable)
 {
     if (selectId == EmptyIdentity || !pts)
         return;
@@ -119,12 +120,11 @@ void SelectionManager::addSelectableRect(SimpleIdentity selectId,const Point3f *
         newSelect.pts[ii] = pts[ii];
     }
 
-    std::lock_guard<std::mutex> guardLock(lock);
-    rect3Dselectables.insert(std::move(newSelect));
+    rect3Ds.push_back(std::move(newSelect));
 }
 
 // Add a rectangle (in 3-space) for selection, but only between the given visibilities
-void SelectionManager::addSelectableRect(SimpleIdentity selectId,const Point3f *pts,
+void SelectionBatch::addSelectableRect(SimpleIdentity selectId,const Point3f *pts,
                                          float minVis,float maxVis,bool enable)
 {
     if (selectId == EmptyIdentity || !pts)
@@ -141,12 +141,11 @@ void SelectionManager::addSelectableRect(SimpleIdentity selectId,const Point3f *
         newSelect.pts[ii] = pts[ii];
     }
 
-    std::lock_guard<std::mutex> guardLock(lock);
-    rect3Dselectables.insert(std::move(newSelect));
+    rect3Ds.push_back(std::move(newSelect));
 }
 
 /// Add a screen space rectangle (2D) for selection, between the given visibilities
-void SelectionManager::addSelectableScreenRect(SimpleIdentity selectId,const Point3d &center,
+void SelectionBatch::addSelectableScreenRect(SimpleIdentity selectId,const Point3d &center,
                                                const Point2f *pts,float minVis,float maxVis,bool enable)
 {
     if (selectId == EmptyIdentity)
@@ -167,12 +166,11 @@ void SelectionManager::addSelectableScreenRect(SimpleIdentity selectId,const Poi
         }
     }
     
-    std::lock_guard<std::mutex> guardLock(lock);
-    rect2Dselectables.insert(std::move(newSelect));
+    rect2Ds.push_back(std::move(newSelect));
 }
 
 /// Add a screen space rectangle (2D) for selection, between the given visibilities
-void SelectionManager::addSelectableMovingScreenRect(SimpleIdentity selectId,const Point3d &startCenter,
+void SelectionBatch::addSelectableMovingScreenRect(SimpleIdentity selectId,const Point3d &startCenter,
                                                      const Point3d &endCenter,TimeInterval startTime,
                                                      TimeInterval endTime,const Point2f *pts,float minVis,
                                                      float maxVis,bool enable)
@@ -198,13 +196,12 @@ void SelectionManager::addSelectableMovingScreenRect(SimpleIdentity selectId,con
         }
     }
     
-    std::lock_guard<std::mutex> guardLock(lock);
-    movingRect2Dselectables.insert(std::move(newSelect));
+    movingRect2Ds.push_back(std::move(newSelect));
 }
 
 static const int corners[6][4] = {{0,1,2,3},{7,6,5,4},{1,0,4,5},{1,5,6,2},{2,6,7,3},{3,7,4,0}};
 
-void SelectionManager::addSelectableRectSolid(SimpleIdentity selectId,const Point3f *pts,
+void SelectionBatch::addSelectableRectSolid(SimpleIdentity selectId,const Point3f *pts,
                                               float minVis,float maxVis,bool enable)
 {
     if (selectId == EmptyIdentity)
@@ -239,13 +236,10 @@ void SelectionManager::addSelectableRectSolid(SimpleIdentity selectId,const Poin
         }
     }
     
-    {
-        std::lock_guard<std::mutex> guardLock(lock);
-        polytopeSelectables.insert(std::move(newSelect));
-    }
+    polytopes.push_back(std::move(newSelect));
 }
 
-void SelectionManager::addSelectableRectSolid(SimpleIdentity selectId,const Point3d *pts,
+void SelectionBatch::addSelectableRectSolid(SimpleIdentity selectId,const Point3d *pts,
                                               float minVis,float maxVis,bool enable)
 {
     if (selectId == EmptyIdentity)
@@ -279,11 +273,10 @@ void SelectionManager::addSelectableRectSolid(SimpleIdentity selectId,const Poin
         }
     }
     
-    std::lock_guard<std::mutex> guardLock(lock);
-    polytopeSelectables.insert(std::move(newSelect));
+    polytopes.push_back(std::move(newSelect));
 }
 
-void SelectionManager::addSelectableRectSolid(SimpleIdentity selectId,const BBox &bbox,
+void SelectionBatch::addSelectableRectSolid(SimpleIdentity selectId,const BBox &bbox,
                                               float minVis,float maxVis,bool enable)
 {
     Point3fVector pts;
@@ -291,7 +284,7 @@ void SelectionManager::addSelectableRectSolid(SimpleIdentity selectId,const BBox
     addSelectableRect(selectId,&pts[0],minVis,maxVis,enable);
 }
 
-void SelectionManager::addPolytope(SimpleIdentity selectId,
+void SelectionBatch::addPolytope(SimpleIdentity selectId,
                                    const std::vector<Point3dVector> &surfaces,
                                    float minVis,float maxVis,bool enable)
 {
@@ -328,11 +321,10 @@ void SelectionManager::addPolytope(SimpleIdentity selectId,
         }
     }
     
-    std::lock_guard<std::mutex> guardLock(lock);
-    polytopeSelectables.insert(std::move(newSelect));
+    polytopes.push_back(std::move(newSelect));
 }
 
-void SelectionManager::addPolytopeFromBox(SimpleIdentity selectId,const Point3d &ll,const Point3d &ur,
+void SelectionBatch::addPolytopeFromBox(SimpleIdentity selectId,const Point3d &ll,const Point3d &ur,
                                           const Eigen::Matrix4d &mat,float minVis,float maxVis,bool enable)
 {
     // Corners of the box
@@ -375,7 +367,7 @@ void SelectionManager::addPolytopeFromBox(SimpleIdentity selectId,const Point3d
     addPolytope(selectId, polys, minVis, maxVis, enable);
 }
 
-void SelectionManager::addMovingPolytope(SimpleIdentity selectId,const std::vector<Point3dVector> &surfaces,
+void SelectionBatch::addMovingPolytope(SimpleIdentity selectId,const std::vector<Point3dVector> &surfaces,
                                          const Point3d &startCenter,const Point3d &endCenter,
                                          TimeInterval startTime, TimeInterval duration,
                                          const Eigen::Matrix4d &mat,float minVis,float maxVis,bool enable)
@@ -405,11 +397,10 @@ void SelectionManager::addMovingPolytope(SimpleIdentity selectId,const std::vect
         }
     }
     
-    std::lock_guard<std::mutex> guardLock(lock);
-    movingPolytopeSelectables.insert(std::move(newSelect));
+    movingPolytopes.push_back(std::move(newSelect));
 }
 
-void SelectionManager::addMovingPolytopeFromBox(SimpleIdentity selectID, const Point3d &ll, const Point3d &ur,
+void SelectionBatch::addMovingPolytopeFromBox(SimpleIdentity selectID, const Point3d &ll, const Point3d &ur,
                                                 const Point3d &startCenter, const Point3d &endCenter,
                                                 TimeInterval startTime,TimeInterval duration,
                                                 const Eigen::Matrix4d &mat, float minVis, float maxVis, bool enable)
@@ -454,7 +445,7 @@ void SelectionManager::addMovingPolytopeFromBox(SimpleIdentity selectID, const P
     addMovingPolytope(selectID, polys, startCenter, endCenter, startTime, duration, mat, minVis, maxVis, enable);
 }
 
-void SelectionManager::addSelectableLinear(SimpleIdentity selectId,const Point3dVector &pts,
+void SelectionBatch::addSelectableLinear(SimpleIdentity selectId,const Point3dVector &pts,
                                            float minVis,float maxVis,bool enable)
 {
     if (selectId == EmptyIdentity)
@@ -467,11 +458,10 @@ void SelectionManager::addSelectableLinear(SimpleIdentity selectId,const Point3d
     newSelect.enable = enable;
     newSelect.pts = pts;
 
-    std::lock_guard<std::mutex> guardLock(lock);
-    linearSelectables.insert(std::move(newSelect));
+    linears.push_back(std::move(newSelect));
 }
 
-void SelectionManager::addSelectableBillboard(SimpleIdentity selectId,const Point3d &center,
+void SelectionBatch::addSelectableBillboard(SimpleIdentity selectId,const Point3d &center,
                                               const Point3d &norm,const Point2d &size,
                                               float minVis,float maxVis,bool enable)
 {
@@ -488,8 +478,174 @@ void SelectionManager::addSelectableBillboard(SimpleIdentity selectId,const Poin
     newSelect.minVis = minVis;
     newSelect.maxVis = maxVis;
     
+    billboards.push_back(std::move(newSelect));
+}
+
+bool SelectionBatch::empty() const
+{
+    return size() == 0;
+}
+
+size_t SelectionBatch::size() const
+{
+    return rect3Ds.size() + rect2Ds.size() + movingRect2Ds.size() + polytopes.size() +
+           movingPolytopes.size() + linears.size() + billboards.size();
+}
+
+// The single versions just go through a batch of one
+
+void SelectionManager::addSelectableRect(SimpleIdentity selectId,const Point3f *pts,bool enable)
+{
+    SelectionBatch batch;
+    batch.addSelectableRect(selectId,pts,enable);
+    addSelectables(batch);
+}
+
+void SelectionManager::addSelectableRect(SimpleIdentity selectId,const Point3f *pts,
+                                         float minVis,float maxVis,bool enable)
+{
+    SelectionBatch batch;
+    batch.addSelectableRect(selectId,pts,minVis,maxVis,enable);
+    addSelectables(batch);
+}
+
+void SelectionManager::addSelectableScreenRect(SimpleIdentity selectId,const Point3d &center,
+                                               const Point2f *pts,float minVis,float maxVis,bool enable)
+{
+    SelectionBatch batch;
+    batch.addSelectableScreenRect(selectId,center,pts,minVis,maxVis,enable);
+    addSelectables(batch);
+}
+
+void SelectionManager::addSelectableMovingScreenRect(SimpleIdentity selectId,const Point3d &startCenter,
+                                                     const Point3d &endCenter,TimeInterval startTime,
+                                                     TimeInterval endTime,const Point2f *pts,float minVis,
+                                                     float maxVis,bool enable)
+{
+    SelectionBatch batch;
+    batch.addSelectableMovingScreenRect(selectId,startCenter,endCenter,startTime,endTime,pts,minVis,maxVis,enable);
+    addSelectables(batch);
+}
+
+void SelectionManager::addSelectableRectSolid(SimpleIdentity selectId,const Point3f *pts,
+                                              float minVis,float maxVis,bool enable)
+{
+    SelectionBatch batch;
+    batch.addSelectableRectSolid(selectId,pts,minVis,maxVis,enable);
+    addSelectables(batch);
+}
+
+void SelectionManager::addSelectableRectSolid(SimpleIdentity selectId,const Point3d *pts,
+                                              float minVis,float maxVis,bool enable)
+{
+    SelectionBatch batch;
+    batch.addSelectableRectSolid(selectId,pts,minVis,maxVis,enable);
+    addSelectables(batch);
+}
+
+void SelectionManager::addSelectableRectSolid(SimpleIdentity selectId,const BBox &bbox,
+                                              float minVis,float maxVis,bool enable)
+{
+    SelectionBatch batch;
+    batch.addSelectableRectSolid(selectId,bbox,minVis,maxVis,enable);
+    addSelectables(batch);
+}
+
+void SelectionManager::addPolytope(SimpleIdentity selectId,
+                                   const std::vector<Point3dVector> &surfaces,
+                                   float minVis,float maxVis,bool enable)
+{
+    SelectionBatch batch;
+    batch.addPolytope(selectId,surfaces,minVis,maxVis,enable);
+    addSelectables(batch);
+}
+
+void SelectionManager::addPolytopeFromBox(SimpleIdentity selectId,const Point3d &ll,const Point3d &ur,
+                                          const Eigen::Matrix4d &mat,float minVis,float maxVis,bool enable)
+{
+    SelectionBatch batch;
+    batch.addPolytopeFromBox(selectId,ll,ur,mat,minVis,maxVis,enable);
+    addSelectables(batch);
+}
+
+void SelectionManager::addMovingPolytope(SimpleIdentity selectId,const std::vector<Point3dVector> &surfaces,
+                                         const Point3d &startCenter,const Point3d &endCenter,
+                                         TimeInterval startTime, TimeInterval duration,
+                                         const Eigen::Matrix4d &mat,float minVis,float maxVis,bool enable)
+{
+    SelectionBatch batch;
+    batch.addMovingPolytope(selectId,surfaces,startCenter,endCenter,startTime,duration,mat,minVis,maxVis,enable);
+    addSelectables(batch);
+}
+
+void SelectionManager::addMovingPolytopeFromBox(SimpleIdentity selectID, const Point3d &ll, const Point3d &ur,
+                                                const Point3d &startCenter, const Point3d &endCenter,
+                                                TimeInterval startTime,TimeInterval duration,
+                                                const Eigen::Matrix4d &mat, float minVis, float maxVis, bool enable)
+{
+    SelectionBatch batch;
+    batch.addMovingPolytopeFromBox(selectID,ll,ur,startCenter,endCenter,startTime,duration,mat,minVis,maxVis,enable);
+    addSelectables(batch);
+}
+
+void SelectionManager::addSelectableLinear(SimpleIdentity selectId,const Point3dVector &pts,
+                                           float minVis,float maxVis,bool enable)
+{
+    SelectionBatch batch;
+    batch.addSelectableLinear(selectId,pts,minVis,maxVis,enable);
+    addSelectables(batch);
+}
+
+void SelectionManager::addSelectableBillboard(SimpleIdentity selectId,const Point3d &center,
+                                              const Point3d &norm,const Point2d &size,
+                                              float minVis,float maxVis,bool enable)
+{
+    SelectionBatch batch;
+    batch.addSelectableBillboard(selectId,center,norm,size,minVis,maxVis,enable);
+    addSelectables(batch);
+}
+
+// IDs mostly come in increasing order, so hinting at the end makes most of these constant time
+template <typename T> static void insertAll(std::set<T> &set,std::vector<T> &sels)
+{
+    for (auto &sel : sels)
+    {
+        set.insert(set.end(),std::move(sel));
+    }
+    sels.clear();
+}
+
+void SelectionManager::addSelectables(SelectionBatch &batch)
+{
+    if (batch.empty())
+        return;
+
     std::lock_guard<std::mutex> guardLock(lock);
-    billboardSelectables.insert(std::move(newSelect));
+
+    for (auto &sel : batch.rect3Ds)
+    {
+        indexSelectable(*rect3Dselectables.insert(rect3Dselectables.end(),std::move(sel)));
+    }
+    batch.rect3Ds.clear();
+    for (auto &sel : batch.polytopes)
+    {
+        indexSelectable(*polytopeSelectables.insert(polytopeSelectables.end(),std::move(sel)));
+    }
+    batch.polytopes.clear();
+    for (auto &sel : batch.linears)
+    {
+        indexSelectable(*linearSelectables.insert(linearSelectables.end(),std::move(sel)));
+    }
+    batch.linears.clear();
+    for (auto &sel : batch.billboards)
+    {
+        indexSelectable(*billboardSelectables.insert(billboardSelectables.end(),std::move(sel)));
+    }
+    batch.billboards.clear();
+
+    insertAll(rect2Dselectables,batch.rect2Ds);
+    insertAll(movingRect2Dselectables,batch.movingRect2Ds);
+    insertAll(movingPolytopeSelectables,batch.movingPolytopes);
 }
 
 void SelectionManager::enableSelectable(SimpleIdentity selectID,bool enable)
@@ -504,6 +660,7 @@ void SelectionManager::enableSelectable(SimpleIdentity selectID,bool enable)
         rect3Dselectables.erase(it);
         sel.enable = enable;
         rect3Dselectables.insert(std::move(sel));
+        selectIndex.setEnable(SelectionIndex::Rect3D,selectID,enable);
     }
 
     const auto it2 = rect2Dselectables.find(RectSelectable2D(selectID));
@@ -531,6 +688,8 @@ void SelectionManager::enableSelectable(SimpleIdentity selectID,bool enable)
         polytopeSelectables.erase(it3);
         sel.enable = enable;
         polytopeSelectables.insert(std::move(sel));
+        selectIndex.setEnable(SelectionIndex::Polytope,selectID,enable);
+        polytopeTris.setEnable(selectID,enable);
     }
 
     const auto it3a = movingPolytopeSelectables.find(MovingPolytopeSelectable(selectID));
@@ -549,6 +708,7 @@ void SelectionManager::enableSelectable(SimpleIdentity selectID,bool enable)
         linearSelectables.erase(it5);
         sel.enable = enable;
         linearSelectables.insert(std::move(sel));
+        selectIndex.setEnable(SelectionIndex::Linear,selectID,enable);
     }
 
     const auto it4 = billboardSelectables.find(BillboardSelectable(selectID));
@@ -558,6 +718,7 @@ void SelectionManager::enableSelectable(SimpleIdentity selectID,bool enable)
         billboardSelectables.erase(it4);
         sel.enable = enable;
         billboardSelectables.insert(std::move(sel));
+        selectIndex.setEnable(SelectionIndex::Billboard,selectID,enable);
     }
 }
 
@@ -575,6 +736,7 @@ void SelectionManager::enableSelectables(const SimpleIDSet &selectIDs,bool enabl
             rect3Dselectables.erase(it);
             sel.enable = enable;
             rect3Dselectables.insert(std::move(sel));
+            selectIndex.setEnable(SelectionIndex::Rect3D,selectID,enable);
         }
 
         const auto it2 = rect2Dselectables.find(RectSelectable2D(selectID));
@@ -602,6 +764,9 @@ void SelectionManager::enableSelectables(const SimpleIDSet &selectIDs,bool enabl
             polytopeSelectables.erase(it3);
             sel.enable = enable;
             polytopeSelectables.insert(std::move(sel));
+            selectIndex.setEnable(SelectionIndex::Polytope,selectID,enable);
+            polytopeTris.setEnable(selectID,enable);
+        polytopeTris.setEnable(selectID,enable);
         }
 
         const auto it3a = movingPolytopeSelectables.find(MovingPolytopeSelectable(selectID));
@@ -620,6 +785,7 @@ void SelectionManager::enableSelectables(const SimpleIDSet &selectIDs,bool enabl
             linearSelectables.erase(it5);
             sel.enable = enable;
             linearSelectables.insert(std::move(sel));
+            selectIndex.setEnable(SelectionIndex::Linear,selectID,enable);
         }
 
         const auto it4 = billboardSelectables.find(BillboardSelectable(selectID));
@@ -629,10 +795,36 @@ void SelectionManager::enableSelectables(const SimpleIDSet &selectIDs,bool enabl
             billboardSelectables.erase(it4);
             sel.enable = enable;
             billboardSelectables.insert(std::move(sel));
+            selectIndex.setEnable(SelectionIndex::Billboard,selectID,enable);
         }
     }
 }
 
+void SelectionManager::moveSelectableScreenRects(const std::vector<SimpleIdentity> &selectIDs,
+                                                 const Point3dVector &startCenters,const Point3dVector &endCenters,
+                                                 TimeInterval startTime,TimeInterval endTime)
+{
+    if (startCenters.size() < selectIDs.size() || endCenters.size() < selectIDs.size())
+        return;
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    for (size_t ii=0;ii<selectIDs.size();ii++)
+    {
+        const auto it = movingRect2Dselectables.find(MovingRectSelectable2D(selectIDs[ii]));
+        if (it == movingRect2Dselectables.end())
+            continue;
+
+        MovingRectSelectable2D sel = *it;
+        const auto next = movingRect2Dselectables.erase(it);
+        sel.center = startCenters[ii];
+        sel.endCenter = endCenters[ii];
+        sel.startTime = startTime;
+        sel.endTime = endTime;
+        movingRect2Dselectables.insert(next,std::move(sel));
+    }
+}
+
 // Remove the given selectable from consideration
 void SelectionManager::removeSelectable(SimpleIdentity selectID)
 {
@@ -640,7 +832,10 @@ void SelectionManager::removeSelectable(SimpleIdentity selectID)
 
     const auto it = rect3Dselectables.find(RectSelectable3D(selectID));
     if (it != rect3Dselectables.end())
+    {
         rect3Dselectables.erase(it);
+        selectIndex.remove(SelectionIndex::Rect3D,selectID);
+    }
 
     const auto it2 = rect2Dselectables.find(RectSelectable2D(selectID));
     if (it2 != rect2Dselectables.end())
@@ -652,7 +847,11 @@ void SelectionManager::removeSelectable(SimpleIdentity selectID)
 
     const auto it3 = polytopeSelectables.find(PolytopeSelectable(selectID));
     if (it3 != polytopeSelectables.end())
+    {
         polytopeSelectables.erase(it3);
+        selectIndex.remove(SelectionIndex::Polytope,selectID);
+        polytopeTris.remove(selectID);
+    }
 
     const auto it3a = movingPolytopeSelectables.find(MovingPolytopeSelectable(selectID));
     if (it3a != movingPolytopeSelectables.end())
@@ -660,11 +859,19 @@ void SelectionManager::removeSelectable(SimpleIdentity selectID)
 
     const auto it5 = linearSelectables.find(LinearSelectable(selectID));
     if (it5 != linearSelectables.end())
+    {
         linearSelectables.erase(it5);
+        selectIndex.remove(SelectionIndex::Linear,selectID);
+    }
 
     const auto it4 = billboardSelectables.find(BillboardSelectable(selectID));
     if (it4 != billboardSelectables.end())
+    {
         billboardSelectables.erase(it4);
+        selectIndex.remove(SelectionIndex::Billboard,selectID);
+    }
+
+    idBuffered.erase(selectID);
 }
 
 void SelectionManager::removeSelectables(const SimpleIDSet &selectIDs)
@@ -679,6 +886,7 @@ void SelectionManager::removeSelectables(const SimpleIDSet &selectIDs)
         {
             //found = true;
             rect3Dselectables.erase(it);
+            selectIndex.remove(SelectionIndex::Rect3D,selectID);
         }
 
         const auto it2 = rect2Dselectables.find(RectSelectable2D(selectID));
@@ -700,6 +908,9 @@ void SelectionManager::removeSelectables(const SimpleIDSet &selectIDs)
         {
             //found = true;
             polytopeSelectables.erase(it3);
+            selectIndex.remove(SelectionIndex::Polytope,selectID);
+            polytopeTris.remove(selectID);
+        polytopeTris.remove(selectID);
         }
 
         const auto it3a = movingPolytopeSelectables.find(MovingPolytopeSelectable(selectID));
@@ -714,6 +925,7 @@ void SelectionManager::removeSelectables(const SimpleIDSet &selectIDs)
         {
             //found = true;
             linearSelectables.erase(it5);
+            selectIndex.remove(SelectionIndex::Linear,selectID);
         }
 
         const auto it4 = billboardSelectables.find(BillboardSelectable(selectID));
@@ -721,13 +933,85 @@ void SelectionManager::removeSelectables(const SimpleIDSet &selectIDs)
         {
             //found = true;
             billboardSelectables.erase(it4);
+            selectIndex.remove(SelectionIndex::Billboard,selectID);
         }
+
+        idBuffered.erase(selectID);
     }
     
 //    if (!found)
 //        NSLog(@"Tried to delete selectable that doesn't exist.");
 }
 
+void SelectionManager::setIDBuffer(SimpleIdentity renderTargetID,float scale)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    idRenderTargetID = renderTargetID;
+    idScale = (scale > 0.0f) ? scale : 1.0f;
+}
+
+SimpleIdentity SelectionManager::getIDBuffer()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return idRenderTargetID;
+}
+
+void SelectionManager::addIDBuffered(const SimpleIDSet &selectIDs)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    idBuffered.insert(selectIDs.begin(),selectIDs.end());
+}
+
+void SelectionManager::indexSelectable(const RectSelectable3D &sel)
+{
+    Point3d ll = sel.pts[0].cast<double>(), ur = ll;
+    for (const auto &pt : sel.pts)
+    {
+        ll = ll.cwiseMin(pt.cast<double>());
+        ur = ur.cwiseMax(pt.cast<double>());
+    }
+    selectIndex.add(SelectionIndex::Rect3D,sel.selectID,ll,ur,sel.enable);
+}
+
+void SelectionManager::indexSelectable(const PolytopeSelectable &sel)
+{
+    Point3d ll = sel.centerPt, ur = sel.centerPt;
+    for (const auto &poly : sel.polys)
+    {
+        for (const auto &pt : poly)
+        {
+            const Point3d pt3d = pt.cast<double>() + sel.centerPt;
+            ll = ll.cwiseMin(pt3d);
+            ur = ur.cwiseMax(pt3d);
+        }
+    }
+    selectIndex.add(SelectionIndex::Polytope,sel.selectID,ll,ur,sel.enable);
+    polytopeTris.addPolygons(sel.selectID,sel.centerPt,sel.polys,sel.enable);
+}
+
+void SelectionManager::indexSelectable(const LinearSelectable &sel)
+{
+    if (sel.pts.empty())
+        return;
+
+    Point3d ll = sel.pts[0], ur = sel.pts[0];
+    for (const auto &pt : sel.pts)
+    {
+        ll = ll.cwiseMin(pt);
+        ur = ur.cwiseMax(pt);
+    }
+    selectIndex.add(SelectionIndex::Linear,sel.selectID,ll,ur,sel.enable);
+}
+
+void SelectionManager::indexSelectable(const BillboardSelectable &sel)
+{
+    // It turns towards the viewer, so take anywhere it could reach.
+    // That's assuming a unit length eye vector, which picking checks for.
+    const double rad = Point2d(sel.size.x() / 2.0,sel.size.y()).norm() * sel.normal.norm();
+    const Point3d ext(rad,rad,rad);
+    selectIndex.add(SelectionIndex::Billboard,sel.selectID,sel.center - ext,sel.center + ext,sel.enable);
+}
+
 void SelectionManager::getScreenSpaceObjects(const PlacementInfo &pInfo,std::vector<ScreenSpaceObjectLocation> &screenPts,TimeInterval now)
 {
     screenPts.reserve(rect2Dselectables.size() + movingRect2Dselectables.size());
@@ -788,19 +1072,18 @@ SelectionManager::PlacementInfo::PlacementInfo(ViewStateRef inViewState,SceneRen
 
 void SelectionManager::projectWorldPointToScreen(const Point3d &worldLoc,const PlacementInfo &pInfo,Point2dVector &screenPts,float scale)
 {
+    // Make sure the globe isn't in the way
+    if (pInfo.globeViewState && pInfo.viewState->isPastHorizon(worldLoc))
+        return;
+
     for (unsigned int offi=0;offi<pInfo.viewState->fullMatrices.size();offi++)
     {
         // Project the world location to the screen
         const Eigen::Matrix4d &modelAndViewMat = pInfo.viewState->fullMatrices[offi];
-        const Eigen::Matrix4d &viewModelNormalMat = pInfo.viewState->fullNormalMatrices[offi];
 
         Point2f screenPt;
         if (pInfo.globeViewState)
         {
-            // Make sure this one is facing toward the viewer
-            if (CheckPointAndNormFacing(worldLoc,worldLoc.normalized(),modelAndViewMat,viewModelNormalMat) < 0.0)
-                return;
-            
             screenPt = pInfo.globeViewState->pointOnScreenFromDisplay(worldLoc, &modelAndViewMat, pInfo.frameSize);
         }
         else if (pInfo.mapViewState)
@@ -915,6 +1198,149 @@ static double checkScreenPts(const Point2fVector &screenPts, const Point2f &touc
     return dist2;
 }
 
+bool SelectionManager::findCandidates(const Point2f &touchPt,float maxDist,const PlacementInfo &pInfo,
+                                      std::vector<SelectionIndex::Candidate> &candidates,
+                                      std::unordered_map<SimpleIdentity,double> &polytopeHits)
+{
+    // The pick tolerance only spreads out evenly with distance in a perspective view
+    const ViewStateRef &viewState = pInfo.viewState;
+    if (viewState->projMatrix(3,3) != 0.0 || viewState->invFullMatrices.empty())
+        return false;
+
+    const auto frameWidth = (unsigned int)pInfo.frameSizeScale.x();
+    const auto frameHeight = (unsigned int)pInfo.frameSizeScale.y();
+    if (frameWidth == 0 || frameHeight == 0)
+        return false;
+
+    // The touch on the near plane and a point off to the side of it, in eye space.
+    // Twice the pick distance leaves some room for error, which is cheap.
+    const Point2d touch2d = touchPt.cast<double>();
+    const Point3d nearPt = viewState->pointUnproject(touch2d,frameWidth,frameHeight,false);
+    const Point3d sidePt = viewState->pointUnproject(touch2d + Point2d(2.0 * maxDist,0.0),frameWidth,frameHeight,false);
+
+    // Run the ray out from the eye for each of the wrapped copies of the world
+    for (const auto &invMat : viewState->invFullMatrices)
+    {
+        const auto toDisplay = [&invMat](const Point3d &pt)
+        {
+            const Vector4d dispPt = invMat * Vector4d(pt.x(),pt.y(),pt.z(),1.0);
+            return Point3d(Point3d(dispPt.x(),dispPt.y(),dispPt.z()) / dispPt.w());
+        };
+        const Point3d org = toDisplay(Point3d(0,0,0)), nearDisp = toDisplay(nearPt);
+        const Point3d dir = nearDisp - org;
+        const double dirLen = dir.norm();
+        if (dirLen > 0.0)
+        {
+            selectIndex.query(org,dir,(toDisplay(sidePt) - nearDisp).norm() / dirLen,candidates);
+
+            // Polytopes right under the touch don't need projecting, and we get a real distance to them
+            polytopeTris.findAll(org,dir / dirLen,polytopeHits);
+        }
+    }
+
+    // The same ones can turn up in more than one copy
+    std::sort(candidates.begin(),candidates.end(),
+              [](const SelectionIndex::Candidate &a,const SelectionIndex::Candidate &b)
+              { return (a.kind == b.kind) ? (a.selectID < b.selectID) : (a.kind < b.kind); });
+    candidates.erase(std::unique(candidates.begin(),candidates.end(),
+                                 [](const SelectionIndex::Candidate &a,const SelectionIndex::Candidate &b)
+                                 { return a.kind == b.kind && a.selectID == b.selectID; }),
+                     candidates.end());
+
+    return true;
+}
+
+bool SelectionManager::pickFromIDBuffer(const Point2f &touchPt,float maxDist,const PlacementInfo &pInfo,
+                                        std::vector<SelectedObject> &selObjs)
+{
+    if (idRenderTargetID == EmptyIdentity)
+        return false;
+
+    // The touch is in points, the ID buffer is some fraction of the framebuffer
+    const float toPixels = renderer->getScale() * idScale;
+    const int width = (int)(pInfo.frameSize.x() * idScale), height = (int)(pInfo.frameSize.y() * idScale);
+    const int rad = std::max(0,(int)std::ceil(maxDist * toPixels));
+    const int cx = (int)(touchPt.x() * toPixels), cy = (int)(touchPt.y() * toPixels);
+    const int x0 = std::max(0,cx - rad), y0 = std::max(0,cy - rad);
+    const int x1 = std::min(width - 1,cx + rad), y1 = std::min(height - 1,cy + rad);
+    if (x1 < x0 || y1 < y0)
+        return false;
+
+    const int snapWidth = x1 - x0 + 1, snapHeight = y1 - y0 + 1;
+    const RawDataRef data = renderer->getSnapshotAt(idRenderTargetID,x0,y0,snapWidth,snapHeight);
+    if (!data || data->getLen() < (unsigned long)snapWidth * snapHeight * sizeof(uint32_t))
+        return false;
+
+    // Closest pixel to the touch for each ID, within the pick distance
+    std::unordered_map<uint32_t,int> closest;
+    const auto *pixels = (const uint32_t *)data->getRawData();
+    for (int iy=0;iy<snapHeight;iy++)
+    {
+        for (int ix=0;ix<snapWidth;ix++)
+        {
+            const uint32_t pixID = pixels[iy * snapWidth + ix];
+            const int dx = x0 + ix - cx, dy = y0 + iy - cy;
+            const int dist2 = dx * dx + dy * dy;
+            if (pixID == 0 || dist2 > rad * rad)
+            {
+                continue;
+            }
+            const auto it = closest.find(pixID);
+            if (it == closest.end())
+                closest[pixID] = dist2;
+            else
+                it->second = std::min(it->second,dist2);
+        }
+    }
+
+    const Point3d eyePos = pInfo.globeViewState ? pInfo.globeViewState->eyePos : pInfo.mapViewState->eyePos;
+    for (const auto &hit : closest)
+    {
+        // The buffer can be a frame behind, so make sure it's still around and selectable
+        const SimpleIdentity selectID = hit.first;
+        if (idBuffered.find(selectID) == idBuffered.end())
+        {
+            continue;
+        }
+        const double screenDist = std::sqrt((double)hit.second) / toPixels;
+
+        const auto it = polytopeSelectables.find(PolytopeSelectable(selectID));
+        if (it != polytopeSelectables.end())
+        {
+            if (it->isVisibleAt(pInfo.heightAboveSurface))
+                selObjs.emplace_back(selectID,(it->centerPt - eyePos).norm(),screenDist);
+            continue;
+        }
+        const auto it2 = rect3Dselectables.find(RectSelectable3D(selectID));
+        if (it2 != rect3Dselectables.end() && it2->isVisibleAt(pInfo.heightAboveSurface))
+        {
+            selObjs.emplace_back(selectID,(it2->pts[0].cast<double>() - eyePos).norm(),screenDist);
+        }
+    }
+
+    return true;
+}
+
+// Pointers to everything in a set of selectables
+template <typename T> static void allSelectables(const std::set<T> &sels,std::vector<const T *> &ptrs)
+{
+    ptrs.reserve(sels.size());
+    for (const auto &sel : sels)
+    {
+        ptrs.push_back(&sel);
+    }
+}
+
+// Pointer to the selectable for an entry from the index
+template <typename T> static void findSelectable(const std::set<T> &sels,SimpleIdentity selectID,std::vector<const T *> &ptrs)
+{
+    const auto it = sels.find(T(selectID));
+    if (it != sels.end())
+    {
+        ptrs.push_back(&*it);
+    }
+}
+
 /// Pass in the screen point where the user touched.  This returns the closest hit within the given distance
 void SelectionManager::pickObjects(const Point2f &touchPt,float maxDist,const ViewStateRef &viewState,
                                    bool multi,std::vector<SelectedObject> &selObjs)
@@ -931,10 +1357,10 @@ void SelectionManager::pickObjects(const Point2f &touchPt,float maxDist,const Vi
     const double maxDist2 = maxDist * maxDist;
 
     // And the eye vector for billboards
-    const Vector4d eyeVec4 = pInfo.viewState->fullMatrices[0].inverse() * Vector4d(0,0,1,0);
+    const Vector4d eyeVec4 = pInfo.viewState->invFullMatrices[0] * Vector4d(0,0,1,0);
     const Vector3d eyeVec(eyeVec4.x(),eyeVec4.y(),eyeVec4.z());
     const Matrix4d modelTrans = pInfo.viewState->fullMatrices[0];
-    const Matrix4d normalMat = pInfo.viewState->fullMatrices[0].inverse().transpose();
+    const Matrix4d &normalMat = pInfo.viewState->fullNormalMatrices[0];
 
     const Point2f frameBufferSize = renderer->getFramebufferSize();
 
@@ -1042,16 +1468,74 @@ void SelectionManager::pickObjects(const Point2f &touchPt,float maxDist,const Vi
 
     const Point3d eyePos = pInfo.globeViewState ? pInfo.globeViewState->eyePos : pInfo.mapViewState->eyePos;
 
-    if (!polytopeSelectables.empty())
+    // Narrow the 3D selectables down to the ones near the touch, if the index works for this view
+    std::vector<const RectSelectable3D *> rect3Ds;
+    std::vector<const PolytopeSelectable *> polytopes;
+    std::vector<const LinearSelectable *> linears;
+    std::vector<const BillboardSelectable *> billboards;
+    std::vector<SelectionIndex::Candidate> candidates;
+    std::unordered_map<SimpleIdentity,double> polytopeHits;
+    const bool indexed = findCandidates(touchPt,maxDist,pInfo,candidates,polytopeHits);
+    // Billboard bounds only hold if turning toward the eye doesn't stretch them
+    const bool billboardsIndexed = indexed && eyeVec.norm() < 1.0 + 1e-6;
+    for (const auto &cand : candidates)
+    {
+        switch (cand.kind)
+        {
+            case SelectionIndex::Rect3D:
+                findSelectable(rect3Dselectables,cand.selectID,rect3Ds);
+                break;
+            case SelectionIndex::Polytope:
+                findSelectable(polytopeSelectables,cand.selectID,polytopes);
+                break;
+            case SelectionIndex::Linear:
+                findSelectable(linearSelectables,cand.selectID,linears);
+                break;
+            case SelectionIndex::Billboard:
+                if (billboardsIndexed)
+                    findSelectable(billboardSelectables,cand.selectID,billboards);
+                break;
+            default:
+                break;
+        }
+    }
+    if (!indexed)
+    {
+        allSelectables(rect3Dselectables,rect3Ds);
+        allSelectables(polytopeSelectables,polytopes);
+        allSelectables(linearSelectables,linears);
+    }
+    if (!billboardsIndexed)
+    {
+        allSelectables(billboardSelectables,billboards);
+    }
+
+    // Whatever's in the ID buffer we've already found, or not
+    if (pickFromIDBuffer(touchPt,maxDist,pInfo,selObjs))
+    {
+        const auto inIDBuffer = [this](const Selectable *sel) { return idBuffered.find(sel->selectID) != idBuffered.end(); };
+        polytopes.erase(std::remove_if(polytopes.begin(),polytopes.end(),inIDBuffer),polytopes.end());
+        rect3Ds.erase(std::remove_if(rect3Ds.begin(),rect3Ds.end(),inIDBuffer),rect3Ds.end());
+    }
+
+    if (!polytopes.empty())
     {
         // Work through the axis aligned rectangular solids
-        for (const auto &sel : polytopeSelectables)
+        for (const auto *polytope : polytopes)
         {
+            const PolytopeSelectable &sel = *polytope;
             if (!sel.isVisibleAt(pInfo.heightAboveSurface))
             {
                 continue;
             }
 
+            const auto hit = polytopeHits.find(sel.selectID);
+            if (hit != polytopeHits.end())
+            {
+                selObjs.emplace_back(sel.selectID,hit->second,0.0);
+                continue;
+            }
+
             float closeDist2 = MAXFLOAT;
             // Project each plane to the screen, including clipping
             for (unsigned int ii=0;ii<sel.polys.size();ii++)
@@ -1129,8 +1613,9 @@ void SelectionManager::pickObjects(const Point2f &touchPt,float maxDist,const Vi
         }
     }
     
-    for (const auto &sel : linearSelectables)
+    for (const auto *linear : linears)
     {
+        const LinearSelectable &sel = *linear;
         if (!sel.isVisibleAt(pInfo.heightAboveSurface))
         {
             continue;
@@ -1173,8 +1658,9 @@ void SelectionManager::pickObjects(const Point2f &touchPt,float maxDist,const Vi
     }
 
     // Work through the 3D rectangles
-    for (const auto &sel : rect3Dselectables)
+    for (const auto *rect3D : rect3Ds)
     {
+        const RectSelectable3D &sel = *rect3D;
         if (!sel.isVisibleAt(pInfo.heightAboveSurface))
         {
             continue;
@@ -1236,9 +1722,9 @@ void SelectionManager::pickObjects(const Point2f &touchPt,float maxDist,const Vi
     }
 
     // Work through the billboards
-    for (const auto &billboardSelectable : billboardSelectables)
+    for (const auto *billboard : billboards)
     {
-        const BillboardSelectable &sel = billboardSelectable;
+        const BillboardSelectable &sel = *billboard;
         if (sel.selectID == EmptyIdentity || !sel.enable)
         {
             continue;
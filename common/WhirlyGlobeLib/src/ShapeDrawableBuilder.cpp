@@ -22,6 +22,8 @@
 #import "Tesselator.h"
 #import "Scene.h"
 #import "SharedAttributes.h"
+#import "StringIndexer.h"
+#import <algorithm>
 
 using namespace Eigen;
 using namespace WhirlyKit;
@@ -44,6 +46,7 @@ ShapeInfo::ShapeInfo(const Dictionary &dict)
     color = dict.getColor(MaplyColor,RGBAColor(255,255,255,255));
     lineWidth = dict.getDouble(MaplyVecWidth,1.0);
     insideOut = dict.getBool(MaplyShapeInsideOut,false);
+    instanced = dict.getBool(MaplyShapeInstanced,false);
     if (dict.hasField(MaplyShapeCenterX) || dict.hasField(MaplyShapeCenterY) || dict.hasField(MaplyShapeCenterZ))
     {
         hasCenter = true;
@@ -184,11 +187,15 @@ ShapeDrawableBuilderTri::ShapeDrawableBuilderTri(WhirlyKit::CoordSystemDisplayAd
 void ShapeDrawableBuilderTri::setupNewDrawable()
 {
     drawable = sceneRender->makeBasicDrawableBuilder("Shape Layer");
+    // Lots of normals and they're only used for lighting
+    drawable->setCompactNormals();
     shapeInfo.setupBasicDrawable(drawable);
     if (clipCoords)
         drawable->setClipCoords(true);
     drawMbr.reset();
     drawable->setType(Triangles);
+    idStarts.clear();
+    idStarts.emplace_back(0,selectID);
     // Adjust according to the vector info
     drawable->setColor(shapeInfo.color);
     int which = 0;
@@ -228,6 +235,65 @@ void ShapeDrawableBuilderTri::setTexIDs(const std::vector<SimpleIdentity> &newTe
     texIDs = newTexIDs;
 }
 
+void ShapeDrawableBuilderTri::setIDTarget(SimpleIdentity renderTargetID,SimpleIdentity progID)
+{
+    idTargetID = renderTargetID;
+    idProgID = progID;
+}
+
+void ShapeDrawableBuilderTri::setSelectID(SimpleIdentity newSelectID)
+{
+    selectID = newSelectID;
+    if (drawable)
+        idStarts.emplace_back(drawable->getNumPoints(),selectID);
+}
+
+void ShapeDrawableBuilderTri::makeIDDrawable()
+{
+    if (std::none_of(idStarts.begin(),idStarts.end(),
+                     [](const std::pair<unsigned int,SimpleIdentity> &start) { return start.second != EmptyIdentity; }))
+        return;
+
+    // Same geometry, but the select IDs go into the render target instead of colors to the screen
+    BasicDrawableBuilderRef idDrawable = sceneRender->makeBasicDrawableBuilder("Shape Layer IDs");
+    shapeInfo.setupBasicDrawable(idDrawable);
+    idDrawable->setType(Triangles);
+    if (clipCoords)
+        idDrawable->setClipCoords(true);
+    idDrawable->setRenderTarget(idTargetID);
+    idDrawable->setProgram(idProgID);
+    if (center.x() != 0.0 || center.y() != 0.0 || center.z() != 0.0)
+    {
+        Eigen::Affine3d trans(Eigen::Translation3d(center.x(),center.y(),center.z()));
+        Matrix4d transMat = trans.matrix();
+        idDrawable->setMatrix(&transMat);
+    }
+
+    const auto numPts = (unsigned int)drawable->points.size();
+    idDrawable->reserve((int)numPts,(int)drawable->tris.size());
+    const int idEntry = idDrawable->addAttribute(BDIntType,a_maskNameID,sceneRender->getSlotForNameID(a_maskNameID),(int)numPts);
+    size_t which = 0;
+    for (unsigned int ii=0;ii<numPts;ii++)
+    {
+        while (which + 1 < idStarts.size() && idStarts[which + 1].first <= ii)
+            which++;
+        idDrawable->addPoint(drawable->points[ii]);
+        idDrawable->addAttributeValue(idEntry,(int)idStarts[which].second);
+    }
+    for (const auto &tri : drawable->tris)
+    {
+        idDrawable->addTriangle(tri);
+    }
+    idDrawable->setLocalMbr(drawMbr);
+    drawables.push_back(idDrawable);
+
+    for (const auto &start : idStarts)
+    {
+        if (start.second != EmptyIdentity)
+            idsWritten.insert(start.second);
+    }
+}
+
 // Add a triangle with normals
 void ShapeDrawableBuilderTri::addTriangle(Point3f p0,Point3f n0,RGBAColor c0,Point3f p1,Point3f n1,RGBAColor c1,Point3f p2,Point3f n2,RGBAColor c2,Mbr shapeMbr)
 {
@@ -427,6 +493,9 @@ void ShapeDrawableBuilderTri::flush()
             }
 
             drawables.push_back(drawable);
+
+            if (idTargetID != EmptyIdentity && idProgID != EmptyIdentity)
+                makeIDDrawable();
         }
         drawable = NULL;
     }
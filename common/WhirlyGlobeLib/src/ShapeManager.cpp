@@ -25,7 +25,9 @@
 #import "VectorData.h"
 #import "Tesselator.h"
 #import "GeometryManager.h"
+#import "BasicDrawableInstanceBuilder.h"
 #import "FlatMath.h"
+#import "SharedAttributes.h"
 
 using namespace Eigen;
 using namespace WhirlyKit;
@@ -34,18 +36,41 @@ namespace WhirlyKit {
 
 static const Point3d north(0,0,1);  // nolint
 
+// Axes to build a shape around, flat on the surface
+static void surfaceAxes(const CoordSystemDisplayAdapter *coordAdapter, const Point3d &up, Point3d &xAxis, Point3d &yAxis)
+{
+    if (coordAdapter->isFlat())
+    {
+        xAxis = Point3d(1,0,0);
+        yAxis = Point3d(0,1,0);
+    }
+    else
+    {
+        // Note: Also check if we're at a pole
+        xAxis = north.cross(up);  xAxis.normalize();
+        yAxis = up.cross(xAxis);  yAxis.normalize();
+    }
+}
+
+// Matrix taking the unit axes to the given ones
+static Matrix4d axesMatrix(const Point3d &xAxis, const Point3d &yAxis, const Point3d &zAxis)
+{
+    Matrix4d mat = Matrix4d::Identity();
+    mat.block<3,1>(0,0) = xAxis;
+    mat.block<3,1>(0,1) = yAxis;
+    mat.block<3,1>(0,2) = zAxis;
+    return mat;
+}
+
 void ShapeSceneRep::enableContents(const SelectionManagerRef &selectManager, bool enable, ChangeSet &changes)
 {
     for (const SimpleIdentity idIt : drawIDs)
     {
         changes.push_back(new OnOffChangeRequest(idIt, enable));
     }
-    if (selectManager)
+    if (selectManager && !selectIDs.empty())
     {
-        for (const SimpleIdentity it : selectIDs)
-        {
-            selectManager->enableSelectable(it, enable);
-        }
+        selectManager->enableSelectables(selectIDs, enable);
     }
 }
 
@@ -55,12 +80,13 @@ void ShapeSceneRep::clearContents(const SelectionManagerRef &selectManager, Chan
     {
         changes.push_back(new RemDrawableReq(idIt,when));
     }
-    if (selectManager)
+    for (const SimpleIdentity idIt : baseDrawIDs)
     {
-        for (const SimpleIdentity it : selectIDs)
-        {
-            selectManager->removeSelectable(it);
-        }
+        changes.push_back(new RemDrawableReq(idIt,when));
+    }
+    if (selectManager && !selectIDs.empty())
+    {
+        selectManager->removeSelectables(selectIDs);
     }
 }
 
@@ -70,7 +96,7 @@ Shape::Shape()
 }
 
 // Base shape doesn't make anything
-void Shape::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, WhirlyKit::SelectionManagerRef &selectManager, WhirlyKit::ShapeSceneRep *sceneRep)
+void Shape::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, WhirlyKit::SelectionBatch *selectBatch, WhirlyKit::ShapeSceneRep *sceneRep)
 {
 }
 
@@ -95,10 +121,25 @@ Point3d Circle::displayCenter(WhirlyKit::CoordSystemDisplayAdapter *coordAdapter
 
 static const float sqrt2 = M_SQRT2;
 
+bool Circle::makeInstance(CoordSystemDisplayAdapter *coordAdapter, ShapeInstanceTemplate &tmpl,
+                          Point3d &center, Eigen::Matrix4d &mat) const
+{
+    const Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal3d(loc);
+    const Point3d norm = coordAdapter->normalForLocal(localPt);
+    Point3d xAxis,yAxis;
+    surfaceAxes(coordAdapter, norm, xAxis, yAxis);
+
+    tmpl.type = ShapeInstanceTemplate::UnitDisc;
+    tmpl.sampleX = sampleX;
+    center = coordAdapter->localToDisplay(localPt) + norm * height;
+    mat = axesMatrix(xAxis * radius, yAxis * radius, norm * radius);
+    return true;
+}
+
 void Circle::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder,
                                      WhirlyKit::ShapeDrawableBuilderTri *triBuilder,
                                      WhirlyKit::Scene *scene,
-                                     WhirlyKit::SelectionManagerRef &selectManager,
+                                     WhirlyKit::SelectionBatch *selectBatch,
                                      WhirlyKit::ShapeSceneRep *sceneRep)
 {
     CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
@@ -154,7 +195,7 @@ void Circle::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder
     triBuilder->addConvexOutline(samples,norm,theColor,shapeMbr);
     
     // Add a selection region
-    if (isSelectable && selectManager && sceneRep)
+    if (isSelectable && selectBatch && sceneRep)
     {
         Point3d pts[8];
         pts[0] = Point3d(bot.x(),bot.y(),bot.z());
@@ -165,7 +206,7 @@ void Circle::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder
         pts[5] = Point3d(top.x(),bot.y(),top.z());
         pts[6] = Point3d(top.x(),top.y(),top.z());
         pts[7] = Point3d(bot.x(),top.y(),top.z());
-        selectManager->addSelectableRectSolid(selectID,pts,
+        selectBatch->addSelectableRectSolid(selectID,pts,
                                               (float)triBuilder->getShapeInfo()->minVis,
                                               (float)triBuilder->getShapeInfo()->maxVis,
                                               regBuilder->getShapeInfo()->enable);
@@ -189,7 +230,22 @@ Point3d Sphere::displayCenter(WhirlyKit::CoordSystemDisplayAdapter *coordAdapter
     return dispPt;
 }
 
-void Sphere::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, WhirlyKit::SelectionManagerRef &selectManager, WhirlyKit::ShapeSceneRep *sceneRep)
+bool Sphere::makeInstance(CoordSystemDisplayAdapter *coordAdapter, ShapeInstanceTemplate &tmpl,
+                          Point3d &center, Eigen::Matrix4d &mat) const
+{
+    const Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal3d(loc);
+    const Point3d norm = coordAdapter->normalForLocal(localPt);
+
+    // The unit sphere is already in display orientation
+    tmpl.type = ShapeInstanceTemplate::UnitSphere;
+    tmpl.sampleX = sampleX;
+    tmpl.sampleY = sampleY;
+    center = coordAdapter->localToDisplay(localPt) + norm * height;
+    mat = axesMatrix(Point3d(radius,0,0), Point3d(0,radius,0), Point3d(0,0,radius));
+    return true;
+}
+
+void Sphere::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, WhirlyKit::SelectionBatch *selectBatch, WhirlyKit::ShapeSceneRep *sceneRep)
 {
     CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
 
@@ -263,7 +319,7 @@ void Sphere::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder
     triBuilder->addTriangles(locs,norms,colors,tris);
 
     // Add a selection region
-    if (isSelectable && selectManager && sceneRep)
+    if (isSelectable && selectBatch && sceneRep)
     {
         Point3d pts[8];
         const float dist = radius * sqrt2;
@@ -275,7 +331,7 @@ void Sphere::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder
         pts[5] = dispPt + dist * Point3d(1,-1,1);
         pts[6] = dispPt + dist * Point3d(1,1,1);
         pts[7] = dispPt + dist * Point3d(-1,1,1);
-        selectManager->addSelectableRectSolid(selectID,pts,
+        selectBatch->addSelectableRectSolid(selectID,pts,
                                               (float)triBuilder->getShapeInfo()->minVis,
                                               (float)triBuilder->getShapeInfo()->maxVis,
                                               regBuilder->getShapeInfo()->enable);
@@ -299,7 +355,22 @@ Point3d Cylinder::displayCenter(WhirlyKit::CoordSystemDisplayAdapter *coordAdapt
     return dispPt;
 }
 
-void Cylinder::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, WhirlyKit::SelectionManagerRef &selectManager, WhirlyKit::ShapeSceneRep *sceneRep)
+bool Cylinder::makeInstance(CoordSystemDisplayAdapter *coordAdapter, ShapeInstanceTemplate &tmpl,
+                            Point3d &center, Eigen::Matrix4d &mat) const
+{
+    const Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal3d(loc);
+    const Point3d norm = coordAdapter->normalForLocal(localPt);
+    Point3d xAxis,yAxis;
+    surfaceAxes(coordAdapter, norm, xAxis, yAxis);
+
+    tmpl.type = ShapeInstanceTemplate::UnitCylinder;
+    tmpl.sampleX = sampleX;
+    center = coordAdapter->localToDisplay(localPt) + norm * baseHeight;
+    mat = axesMatrix(xAxis * radius, yAxis * radius, norm * height);
+    return true;
+}
+
+void Cylinder::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, WhirlyKit::SelectionBatch *selectBatch, WhirlyKit::ShapeSceneRep *sceneRep)
 {
     const CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
 
@@ -377,7 +448,7 @@ void Cylinder::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuild
     circleSamples.clear();
     
     // Add a selection region
-    if (isSelectable && selectManager && sceneRep)
+    if (isSelectable && selectBatch && sceneRep)
     {
         Point3d pts[8];
         const auto dist1 = radius * sqrt2;
@@ -389,7 +460,7 @@ void Cylinder::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuild
         pts[5] = pts[1] + height * norm;
         pts[6] = pts[2] + height * norm;
         pts[7] = pts[3] + height * norm;
-        selectManager->addSelectableRectSolid(selectID,pts,
+        selectBatch->addSelectableRectSolid(selectID,pts,
                                               (float)triBuilder->getShapeInfo()->minVis,
                                               (float)triBuilder->getShapeInfo()->maxVis,
                                               triBuilder->getShapeInfo()->enable);
@@ -409,16 +480,16 @@ Point3d Linear::displayCenter(WhirlyKit::CoordSystemDisplayAdapter *coordAdapter
     return !pts.empty() ? pts[pts.size()/2] : Point3d { 0.0,0.0,0.0 };
 }
 
-void Linear::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, WhirlyKit::SelectionManagerRef &selectManager, WhirlyKit::ShapeSceneRep *sceneRep)
+void Linear::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, WhirlyKit::SelectionBatch *selectBatch, WhirlyKit::ShapeSceneRep *sceneRep)
 {
     auto theColor = useColor ? color : regBuilder->getShapeInfo()->color;
 
-    if (isSelectable)
+    if (isSelectable && selectBatch && sceneRep)
     {
-        selectManager->addSelectableLinear(selectID,pts,
-                                           (float)regBuilder->getShapeInfo()->minVis,
-                                           (float)regBuilder->getShapeInfo()->maxVis,
-                                           regBuilder->getShapeInfo()->enable);
+        selectBatch->addSelectableLinear(selectID,pts,
+                                         (float)regBuilder->getShapeInfo()->minVis,
+                                         (float)regBuilder->getShapeInfo()->maxVis,
+                                         regBuilder->getShapeInfo()->enable);
         sceneRep->selectIDs.insert(selectID);
     }
     
@@ -440,7 +511,7 @@ Point3d Extruded::displayCenter(WhirlyKit::CoordSystemDisplayAdapter *coordAdapt
     return coordAdapter->localToDisplay(localPt);
 }
 
-void Extruded::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, WhirlyKit::SelectionManagerRef &selectManager, WhirlyKit::ShapeSceneRep *sceneRep)
+void Extruded::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuilder, WhirlyKit::ShapeDrawableBuilderTri *triBuilder, WhirlyKit::Scene *scene, WhirlyKit::SelectionBatch *selectBatch, WhirlyKit::ShapeSceneRep *sceneRep)
 {
     CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
     
@@ -546,9 +617,9 @@ void Extruded::makeGeometryWithBuilder(WhirlyKit::ShapeDrawableBuilder *regBuild
     }
     
     // Add a selection region
-    if (isSelectable && selectManager && sceneRep)
+    if (isSelectable && selectBatch && sceneRep)
     {
-        selectManager->addPolytope(selectID,polytope,
+        selectBatch->addPolytope(selectID,polytope,
                                    (float)triBuilder->getShapeInfo()->minVis,
                                    (float)triBuilder->getShapeInfo()->maxVis,
                                    triBuilder->getShapeInfo()->enable);
@@ -571,7 +642,7 @@ Point3d Rectangle::displayCenter(CoordSystemDisplayAdapter *coordAdapter,const S
 }
 
 // Build the geometry for a circle in display space
-void Rectangle::makeGeometryWithBuilder(ShapeDrawableBuilder *regBuilder,ShapeDrawableBuilderTri *triBuilder,Scene *scene,SelectionManagerRef &selectManager,ShapeSceneRep *sceneRep)
+void Rectangle::makeGeometryWithBuilder(ShapeDrawableBuilder *regBuilder,ShapeDrawableBuilderTri *triBuilder,Scene *scene,SelectionBatch *selectBatch,ShapeSceneRep *sceneRep)
 {
     CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
     
@@ -646,8 +717,7 @@ void ShapeManager::convertShape(Shape &shape,std::vector<WhirlyKit::GeometryRaw>
     {
         drawBuildTri.clipCoords = true;
     }
-    auto selectManage = SelectionManagerRef();
-    shape.makeGeometryWithBuilder(&drawBuildReg,&drawBuildTri,scene,selectManage,nullptr);
+    shape.makeGeometryWithBuilder(&drawBuildReg,&drawBuildTri,scene,nullptr,nullptr);
     
     // Scrape out the triangles
     drawBuildTri.flush();
@@ -679,6 +749,12 @@ void ShapeManager::convertShape(Shape &shape,std::vector<WhirlyKit::GeometryRaw>
             VertexAttribute *vertAttr = draw->basicDraw->vertexAttributes[draw->basicDraw->normalEntry];
             for (int ii=0;ii<vertAttr->numElements();ii++)
             {
+                if (vertAttr->dataType == BDChar4NormType)
+                {
+                    const auto *norm = (const int8_t *)vertAttr->addressForElement(ii);
+                    outGeom.norms.push_back(Point3d(norm[0]/127.0,norm[1]/127.0,norm[2]/127.0));
+                    continue;
+                }
                 const auto *norm = (Point3f *)vertAttr->addressForElement(ii);
                 outGeom.norms.push_back(Point3d(norm->x(),norm->y(),norm->z()));
             }
@@ -687,6 +763,98 @@ void ShapeManager::convertShape(Shape &shape,std::vector<WhirlyKit::GeometryRaw>
 }
 
 /// Add an array of shapes.  The returned ID can be used to remove or modify the group of shapes.
+// Build the unit mesh for a kind of instanced shape, in the frame the instance matrices expect
+static void buildShapeTemplate(const ShapeInstanceTemplate &tmpl, const ShapeInfo &shapeInfo,
+                               const BasicDrawableBuilderRef &draw)
+{
+    const int sampleX = std::max(tmpl.sampleX,3);
+
+    // Circle samples repeat the first at the end, as the tessellated versions do
+    Point3dVector ring(sampleX);
+    for (int ii=0;ii<sampleX;ii++)
+        ring[ii] = Point3d(std::sin(2*M_PI*ii/(double)(sampleX-1)),std::cos(2*M_PI*ii/(double)(sampleX-1)),0.0);
+
+    // Fan for a convex outline, as addConvexOutline does it
+    const auto addFan = [&draw](const Point3dVector &pts,const Point3d &norm)
+    {
+        const auto base = (int)draw->getNumPoints();
+        for (const auto &pt : pts)
+        {
+            draw->addPoint(pt);
+            draw->addNormal(norm);
+        }
+        for (int ii=2;ii<(int)pts.size();ii++)
+            draw->addTriangle(BasicDrawable::Triangle(base,base+ii-1,base+ii));
+    };
+
+    switch (tmpl.type)
+    {
+        case ShapeInstanceTemplate::UnitDisc:
+            addFan(ring,Point3d(0,0,1));
+            break;
+        case ShapeInstanceTemplate::UnitCylinder:
+        {
+            Point3dVector top(ring);
+            for (auto &pt : top)
+                pt.z() = 1.0;
+            addFan(top,Point3d(0,0,1));
+
+            // The last sample is the first again, so that side would be empty
+            for (int ii=0;ii<sampleX-1;ii++)
+            {
+                const Point3dVector side { ring[ii], ring[ii+1], top[ii+1], top[ii] };
+                const Point3d sideNorm = (side[0]-side[1]).cross(side[2]-side[1]).normalized();
+                addFan(side,sideNorm);
+            }
+            break;
+        }
+        case ShapeInstanceTemplate::UnitSphere:
+        {
+            const int sampleY = std::max(tmpl.sampleY,2);
+            const Point2d geoIncr(2*M_PI/sampleX,M_PI/sampleY);
+            for (int iy=0;iy<sampleY+1;iy++)
+            {
+                for (int ix=0;ix<sampleX+1;ix++)
+                {
+                    const double lon = std::min(std::max(-M_PI + ix * geoIncr.x(),-M_PI),M_PI);
+                    const double lat = std::min(std::max(-M_PI_2 + iy * geoIncr.y(),-M_PI_2),M_PI_2);
+                    const Point3d spherePt = FakeGeocentricDisplayAdapter::LocalToDisplay(Point3d(lon,lat,0.0));
+                    draw->addPoint(spherePt);
+                    draw->addNormal(spherePt);
+                }
+            }
+            for (int iy=0;iy<sampleY;iy++)
+            {
+                for (int ix=0;ix<sampleX;ix++)
+                {
+                    const int v0 = iy*(sampleX+1)+ix, v1 = iy*(sampleX+1)+(ix+1);
+                    const int v2 = (iy+1)*(sampleX+1)+(ix+1), v3 = (iy+1)*(sampleX+1)+ix;
+                    if (shapeInfo.insideOut)
+                    {
+                        draw->addTriangle(BasicDrawable::Triangle(v0,v2,v1));
+                        draw->addTriangle(BasicDrawable::Triangle(v0,v3,v2));
+                    }
+                    else
+                    {
+                        draw->addTriangle(BasicDrawable::Triangle(v0,v1,v2));
+                        draw->addTriangle(BasicDrawable::Triangle(v0,v2,v3));
+                    }
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Bounding box of a unit mesh, for selection
+static void shapeTemplateBounds(const ShapeInstanceTemplate &tmpl, Point3d &ll, Point3d &ur)
+{
+    ll = Point3d(-1,-1,(tmpl.type == ShapeInstanceTemplate::UnitSphere) ? -1 : 0);
+    ur = Point3d(1,1,(tmpl.type == ShapeInstanceTemplate::UnitDisc) ? 0 : 1);
+}
+
 SimpleIdentity ShapeManager::addShapes(const std::vector<Shape*> &shapes, const ShapeInfo &shapeInfo, ChangeSet &changes)
 {
     auto selectManager = scene->getManager<SelectionManager>(kWKSelectionManager);
@@ -708,14 +876,53 @@ SimpleIdentity ShapeManager::addShapes(const std::vector<Shape*> &shapes, const
     ShapeDrawableBuilderTri drawBuildTri(getScene()->getCoordAdapter(),renderer,shapeInfo,center);
     ShapeDrawableBuilder drawBuildReg(getScene()->getCoordAdapter(),renderer,shapeInfo,true,center);
 
+    // Selectable solids also go into the ID buffer, if there is one.
+    // Wide vectors and lofts don't.  They have no selectables here and are picked
+    //  by their component objects (ComponentManager::findVectors), so there'd be nothing to map an ID back to.
+    const SimpleIdentity idTargetID = selectManager ? selectManager->getIDBuffer() : EmptyIdentity;
+    if (idTargetID != EmptyIdentity)
+    {
+        if (const Program *idProg = scene->findProgramByName(MaplyTriangleIDShader))
+            drawBuildTri.setIDTarget(idTargetID,idProg->getId());
+    }
+
+    // Selectables all go in at the end
+    SelectionBatch selectBatch;
+
+    // Instanced shapes, sorted by the mesh they're drawn from
+    std::map<ShapeInstanceTemplate,std::vector<BasicDrawableInstance::SingleInstance>> instances;
+
     // Work through the shapes
     for (auto shape : shapes)
     {
+        ShapeInstanceTemplate tmpl;
+        BasicDrawableInstance::SingleInstance inst;
+        if (shapeInfo.instanced &&
+            shape->makeInstance(getScene()->getCoordAdapter(), tmpl, inst.center, inst.mat))
+        {
+            inst.colorOverride = true;
+            inst.color = shape->useColor ? shape->color : shapeInfo.color;
+            instances[tmpl].push_back(inst);
+
+            // These don't go in the ID buffer, just the regular selection
+            if (shape->isSelectable && selectManager)
+            {
+                Point3d ll,ur;
+                shapeTemplateBounds(tmpl, ll, ur);
+                const Matrix4d selectMat = Eigen::Affine3d(Eigen::Translation3d(inst.center)).matrix() * inst.mat;
+                selectBatch.addPolytopeFromBox(shape->selectID, ll, ur, selectMat,
+                                               (float)shapeInfo.minVis, (float)shapeInfo.maxVis, shapeInfo.enable);
+                sceneRep->selectIDs.insert(shape->selectID);
+            }
+            continue;
+        }
+
+        drawBuildTri.setSelectID(shape->isSelectable ? shape->selectID : EmptyIdentity);
         if (shape->clipCoords)
             drawBuildTri.setClipCoords(true);
         else
             drawBuildTri.setClipCoords(false);
-        shape->makeGeometryWithBuilder(&drawBuildReg, &drawBuildTri, getScene(), selectManager, sceneRep.get());
+        shape->makeGeometryWithBuilder(&drawBuildReg, &drawBuildTri, getScene(), selectManager ? &selectBatch : nullptr, sceneRep.get());
     }
 
 	// Flush out remaining geometry
@@ -724,6 +931,37 @@ SimpleIdentity ShapeManager::addShapes(const std::vector<Shape*> &shapes, const
     drawBuildTri.flush();
     drawBuildTri.getChanges(changes, sceneRep->drawIDs);
 
+    // One mesh for each kind of instanced shape, drawn once per shape
+    const Program *instProg = instances.empty() ? nullptr : scene->findProgramByName(MaplyDefaultModelTriShader);
+    for (const auto &it : instances)
+    {
+        BasicDrawableBuilderRef baseDraw = renderer->makeBasicDrawableBuilder("Shape Template");
+        baseDraw->setCompactNormals();
+        shapeInfo.setupBasicDrawable(baseDraw);
+        baseDraw->setType(Triangles);
+        baseDraw->setOnOff(false);
+        buildShapeTemplate(it.first, shapeInfo, baseDraw);
+        const SimpleIdentity baseDrawID = baseDraw->getDrawableID();
+        sceneRep->baseDrawIDs.insert(baseDrawID);
+        changes.push_back(new AddDrawableReq(baseDraw->getDrawable()));
+
+        BasicDrawableInstanceBuilderRef drawInst = renderer->makeBasicDrawableInstanceBuilder("Shape Instances");
+        drawInst->setMasterID(baseDrawID, BasicDrawableInstance::LocalStyle);
+        shapeInfo.setupBasicDrawableInstance(drawInst);
+        // The instance matrices need the model version of the shader
+        if (instProg)
+            drawInst->setProgram(instProg->getId());
+        drawInst->addInstances(it.second);
+        sceneRep->drawIDs.insert(drawInst->getDrawableID());
+        changes.push_back(new AddDrawableReq(drawInst->getDrawable()));
+    }
+    if (selectManager)
+    {
+        selectManager->addSelectables(selectBatch);
+        if (!drawBuildTri.idsWritten.empty())
+            selectManager->addIDBuffered(drawBuildTri.idsWritten);
+    }
+
     SimpleIdentity shapeID = sceneRep->getId();
     {
         std::lock_guard<std::mutex> guardLock(lock);
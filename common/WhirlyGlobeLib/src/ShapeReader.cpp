@@ -21,12 +21,14 @@
 #import "ShapeReader.h"
 #import "shapefil.h"
 #import "GlobeMath.h"
+#import "WhirlyKitLog.h"
 
 namespace WhirlyKit
 {
 
 ShapeReader::ShapeReader(const std::string &fileName)
-    : shp(NULL), dbf(NULL)
+    : shp(NULL), dbf(NULL), diskTree(NULL), memTree(NULL), indexChecked(false),
+      where(0), numEntity(0), shapeType(0)
 {
 	const char *cFile =  fileName.c_str();
 	shp = SHPOpen(cFile, "rb");
@@ -35,12 +37,32 @@ ShapeReader::ShapeReader(const std::string &fileName)
 	dbf = DBFOpen(cFile, "rb");
     if (!dbf)
         return;
-	where = 0;	
 	SHPGetInfo((SHPInfo *)shp, &numEntity, &shapeType, minBound, maxBound);
+
+    // The index lives next to the .shp, like the .dbf
+    const auto slash = fileName.find_last_of('/');
+    const auto dot = fileName.find_last_of('.');
+    qixName = (dot != std::string::npos && (slash == std::string::npos || dot > slash)) ? fileName.substr(0,dot) : fileName;
+    qixName += ".qix";
+
+    // Look up the fields once, rather than for every record
+    char attrTitle[12];
+    int attrWidth, numDecimals;
+    const int numFields = DBFGetFieldCount((DBFHandle)dbf);
+    fields.resize(numFields);
+    for (int ii = 0; ii < numFields; ii++)
+    {
+        fields[ii].type = DBFGetFieldInfo((DBFHandle)dbf, ii, attrTitle, &attrWidth, &numDecimals);
+        fields[ii].name = attrTitle;
+    }
 }
 	
 ShapeReader::~ShapeReader()
 {
+    if (diskTree)
+        SHPCloseDiskTree((SHPTreeDiskHandle)diskTree);
+    if (memTree)
+        SHPDestroyTree((SHPTree *)memTree);
 	if (shp)
 		SHPClose((SHPHandle)shp);
 	if (dbf)
@@ -75,9 +97,28 @@ unsigned int ShapeReader::getNumObjects()
 // Return a single shape by index
 VectorShapeRef ShapeReader::getObjectByIndex(unsigned int vecIndex,const StringSet *filterAttrs)
 {
+    std::lock_guard<std::mutex> guardLock(lock);
+    return readObject(vecIndex, filterAttrs, NULL);
+}
+
+VectorShapeRef ShapeReader::readObject(unsigned int vecIndex,const StringSet *filterAttrs,const GeoMbr *mbr)
+{
+    if (!shp || !dbf || vecIndex >= numEntity)
+        return VectorShapeRef();
+
     // Read from disk
 	SHPObject *thisShape = SHPReadObject((SHPInfo *)shp, vecIndex);
-    
+    if (!thisShape)
+        return VectorShapeRef();
+
+    // The index only gets us close, so check the real bounds before doing any more work
+    if (mbr && (RadToDeg(mbr->ur().x()) < thisShape->dfXMin || RadToDeg(mbr->ll().x()) > thisShape->dfXMax ||
+                RadToDeg(mbr->ur().y()) < thisShape->dfYMin || RadToDeg(mbr->ll().y()) > thisShape->dfYMax))
+    {
+        SHPDestroyObject(thisShape);
+        return VectorShapeRef();
+    }
+
     VectorShapeRef theShape;
 	
     switch (shapeType)
@@ -150,25 +191,25 @@ VectorShapeRef ShapeReader::getObjectByIndex(unsigned int vecIndex,const StringS
     }
 	
 	SHPDestroyObject(thisShape);
+    if (!theShape)
+        return VectorShapeRef();
 	
 	// Attributes
-	char attrTitle[12];
-	int attrWidth, numDecimals;
     MutableDictionaryRef attrDict = theShape->getAttrDict();
 	DBFHandle dbfHandle = (DBFHandle)dbf;
 	int numDbfRecord = DBFGetRecordCount(dbfHandle);
 	if (vecIndex < numDbfRecord)
 	{
-		for (unsigned int ii = 0; ii < DBFGetFieldCount(dbfHandle); ii++)
+		for (unsigned int ii = 0; ii < fields.size(); ii++)
 		{
-			DBFFieldType attrType = DBFGetFieldInfo(dbfHandle, ii, attrTitle, &attrWidth, &numDecimals);
+            const std::string &attrTitle = fields[ii].name;
             // If we have a set of filter attrs, skip this one if it's not there
             if (filterAttrs && (filterAttrs->find(attrTitle) == filterAttrs->end()))
                 continue;
 			
 			if (!DBFIsAttributeNULL(dbfHandle, vecIndex, ii))
 			{
-				switch (attrType)
+				switch (fields[ii].type)
 				{
 					case FTString:
 					{
@@ -203,14 +244,100 @@ VectorShapeRef ShapeReader::getObjectByIndex(unsigned int vecIndex,const StringS
 // Return the next shape
 VectorShapeRef ShapeReader::getNextObject(const StringSet *filterAttrs)
 {
+    std::lock_guard<std::mutex> guardLock(lock);
+
 	// Reached the end
 	if (where >= numEntity)
 		return VectorShapeRef();
     
-    VectorShapeRef retShape = getObjectByIndex(where, filterAttrs);
+    VectorShapeRef retShape = readObject(where, filterAttrs, NULL);
     where++;
     
     return retShape;
 }
+
+void ShapeReader::setupIndex()
+{
+    if (indexChecked || !shp)
+        return;
+    indexChecked = true;
+
+    diskTree = SHPOpenDiskTree(qixName.c_str(), NULL);
+    if (diskTree)
+        return;
+
+    // No index yet, so make one.  This reads every shape, but only the once.
+    SHPTree *tree = SHPCreateTree((SHPHandle)shp, 2, 0, NULL, NULL);
+    if (!tree)
+        return;
+    SHPTreeTrimExtraNodes(tree);
+    memTree = tree;
+
+    // Save it for next time, if we're allowed to write there
+    if (!SHPWriteTree(tree, qixName.c_str()))
+        wkLogLevel(Debug, "ShapeReader: Couldn't write spatial index to %s", qixName.c_str());
+}
+
+bool ShapeReader::hasSpatialIndex()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    setupIndex();
+    return diskTree || memTree;
+}
+
+std::vector<int> ShapeReader::findObjectsInBounds(const GeoMbr &mbr)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    std::vector<int> indices;
+    if (!shp || !mbr.valid())
+        return indices;
+    setupIndex();
+
+    double boundsMin[4] = { RadToDeg(mbr.ll().x()), RadToDeg(mbr.ll().y()), 0.0, 0.0 };
+    double boundsMax[4] = { RadToDeg(mbr.ur().x()), RadToDeg(mbr.ur().y()), 0.0, 0.0 };
+
+    int numFound = 0;
+    int *found = NULL;
+    if (diskTree)
+        found = SHPSearchDiskTreeEx((SHPTreeDiskHandle)diskTree, boundsMin, boundsMax, &numFound);
+    else if (memTree)
+        found = SHPTreeFindLikelyShapes((SHPTree *)memTree, boundsMin, boundsMax, &numFound);
+    else
+    {
+        // No index, so every shape is a candidate
+        indices.resize(numEntity);
+        for (int ii = 0; ii < numEntity; ii++)
+            indices[ii] = ii;
+        return indices;
+    }
+
+    if (found)
+    {
+        indices.assign(found, found + numFound);
+        free(found);
+    }
+
+    return indices;
+}
+
+int ShapeReader::getObjectsInBounds(const GeoMbr &mbr,const StringSet *filterAttrs,ShapeSet &shapes)
+{
+    const std::vector<int> indices = findObjectsInBounds(mbr);
+
+    std::lock_guard<std::mutex> guardLock(lock);
+    int numAdded = 0;
+    shapes.reserve(shapes.size() + indices.size());
+    for (int idx : indices)
+    {
+        if (VectorShapeRef shape = readObject(idx, filterAttrs, &mbr))
+        {
+            shapes.insert(shape);
+            numAdded++;
+        }
+    }
+
+    return numAdded;
+}
 	
 }
@@ -51,6 +51,15 @@ SphericalChunk::SphericalChunk()
 }
 
 static const float SkirtFactor = 0.95;
+// How far a cell may bow in from the globe with static sampling before it's worth splitting
+static const float StaticSampleEps = 1e-6;
+// Chunks handed to a worker at a time
+static const size_t ChunksPerTask = 16;
+
+static SimpleIdentity chunkTexID(const SphericalChunk &chunk)
+{
+    return chunk.texIDs.empty() ? EmptyIdentity : chunk.texIDs[0];
+}
 
 // Helper routine for constructing the skirt around a tile
 void SphericalChunk::buildSkirt(SceneRenderer *sceneRender,const BasicDrawableBuilderRef &draw,
@@ -88,22 +97,24 @@ void SphericalChunk::buildSkirt(SceneRenderer *sceneRender,const BasicDrawableBu
 }
 
 // Calculate a reasonable sample size based on the four corners passed in
-void SphericalChunk::calcSampleX(int &thisSampleX,int &thisSampleY,const Point3f *dispPts) const
+void SphericalChunk::calcSampleX(int &thisSampleX,int &thisSampleY,const Point3f *dispPts,bool onSphere) const
 {
     // Default to the sample passed in
     thisSampleX = sampleX;
     thisSampleY = sampleY;
-    
+    if (!dispPts)
+        return;
+
+    float angBot = acos(dispPts[0].dot(dispPts[1]));
+    float angTop = acos(dispPts[3].dot(dispPts[2]));
+    float angLeft = acos(dispPts[0].dot(dispPts[3]));
+    float angRight = acos(dispPts[1].dot(dispPts[2]));
+    float angX = std::max(angBot,angTop);
+    float angY = std::max(angLeft,angRight);
+
     // If there's an epsilon, look at that
-    if (eps > 0.0 && dispPts)
+    if (eps > 0.0)
     {
-        float angBot = acos(dispPts[0].dot(dispPts[1]));
-        float angTop = acos(dispPts[3].dot(dispPts[2]));
-        float angLeft = acos(dispPts[0].dot(dispPts[3]));
-        float angRight = acos(dispPts[1].dot(dispPts[2]));
-        float angX = std::max(angBot,angTop);
-        float angY = std::max(angLeft,angRight);
-        
         float minAng = acosf(1.0f-eps) * 2.0f;
         if (minAng < angX)
             thisSampleX = (int)(angX/minAng);
@@ -115,6 +126,11 @@ void SphericalChunk::calcSampleX(int &thisSampleX,int &thisSampleY,const Point3f
             thisSampleX = std::min(thisSampleX,sampleX);
         if (sampleY > 0)
             thisSampleY = std::min(thisSampleY,sampleY);
+    } else if (onSphere && !coordSys) {
+        // Static sampling, but a small chunk doesn't need all of it to follow the globe
+        const float minAng = acosf(1.0f-StaticSampleEps) * 2.0f;
+        thisSampleX = std::min(thisSampleX,std::max(1,(int)ceilf(angX/minAng)));
+        thisSampleY = std::min(thisSampleY,std::max(1,(int)ceilf(angY/minAng)));
     }
 }
 
@@ -124,7 +140,7 @@ void SphericalChunk::buildDrawable(SceneRenderer *sceneRender,
                                    const BasicDrawableBuilderRef &skirtDrawable,
                                    bool enable,
                                    const CoordSystemDisplayAdapter *coordAdapter,
-                                   const SphericalChunkInfo &chunkInfo)
+                                   const SphericalChunkInfo &chunkInfo) const
 {
     const CoordSystem *localSys = coordAdapter->getCoordSystem();
 
@@ -165,7 +181,7 @@ void SphericalChunk::buildDrawable(SceneRenderer *sceneRender,
         srcUR = Point3f(pts[2].x(),pts[2].y(),0.0);
         
         // Calculate a reasonable sample size
-        calcSampleX(thisSampleX, thisSampleY, dispPts);
+        calcSampleX(thisSampleX, thisSampleY, dispPts, !coordAdapter->isFlat());
         locs.resize((thisSampleX+1)*(thisSampleY+1));
         texCoords.resize((thisSampleX+1)*(thisSampleY+1));
         texIncr = Point2f(1.0/thisSampleX,1.0/thisSampleY);
@@ -216,7 +232,7 @@ void SphericalChunk::buildDrawable(SceneRenderer *sceneRender,
         }
         
         // Calculate a reasonable sample size in both directions
-        calcSampleX(thisSampleX, thisSampleY, dispPts);
+        calcSampleX(thisSampleX, thisSampleY, dispPts, !coordAdapter->isFlat());
         locs.resize((thisSampleX+1)*(thisSampleY+1));
         texCoords.resize((thisSampleX+1)*(thisSampleY+1));
         texIncr = Point2f(1.0/thisSampleX,1.0/thisSampleY);
@@ -320,6 +336,58 @@ SphericalChunkManager::~SphericalChunkManager()
 {
     std::lock_guard<std::mutex> guardLock(lock);
 }
+
+void SphericalChunkManager::setBuildThreads(int numThreads)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    buildWorkers = (numThreads > 0) ? std::make_shared<WorkerPool>(numThreads) : WorkerPoolRef();
+}
+
+int SphericalChunkManager::getBuildThreads()
+{
+    const auto workers = getBuildWorkers();
+    return workers ? workers->getNumThreads() : 0;
+}
+
+WorkerPoolRef SphericalChunkManager::getBuildWorkers()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return buildWorkers;
+}
+
+void SphericalChunkManager::buildChunkRun(const std::vector<SphericalChunk> &chunks,size_t start,size_t end,
+                                          const CoordSystemDisplayAdapter *coordAdapter,const SphericalChunkInfo &chunkInfo,
+                                          std::vector<BasicDrawableRef> &draws) const
+{
+    const SimpleIdentity texId = chunkTexID(chunks[start]);
+
+    BasicDrawableBuilderRef drawable,skirtDraw;
+    const auto flush = [&]()
+    {
+        if (skirtDraw && skirtDraw->getNumPoints() > 0)
+            draws.push_back(skirtDraw->getDrawable());
+        if (drawable && drawable->getNumPoints() > 0)
+            draws.push_back(drawable->getDrawable());
+        drawable.reset();
+        skirtDraw.reset();
+    };
+
+    for (size_t ii=start;ii<end;ii++)
+    {
+        if (!drawable)
+        {
+            drawable = renderer->makeBasicDrawableBuilder("Chunk Manager");
+            skirtDraw = renderer->makeBasicDrawableBuilder("Chunk Manager Skirt");
+            drawable->setTexId(0,texId);
+            skirtDraw->setTexId(0,texId);
+        }
+        chunks[ii].buildDrawable(renderer,drawable,chunkInfo.doEdgeMatching,skirtDraw,chunkInfo.enable,coordAdapter,chunkInfo);
+
+        if (drawable->getNumPoints() > MaxDrawablePoints)
+            flush();
+    }
+    flush();
+}
     
 /// Add the given chunk (enabled or disabled)
 SimpleIdentity SphericalChunkManager::addChunks(const std::vector<SphericalChunk> &chunks,const SphericalChunkInfo &chunkInfo,ChangeSet &changes)
@@ -327,12 +395,9 @@ SimpleIdentity SphericalChunkManager::addChunks(const std::vector<SphericalChunk
     CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
     ChunkSceneRepRef chunkRep(new ChunkSceneRep());
 
-    // Build the main drawable and possibly skirt
-    BasicDrawableBuilderRef drawable = getSceneRenderer()->makeBasicDrawableBuilder("Chunk Manager");
-    BasicDrawableBuilderRef skirtDraw = getSceneRenderer()->makeBasicDrawableBuilder("Chunk Manager Skirt");
-    SimpleIdentity lastTexID = -1;
-    
-    for (auto chunk : chunks) {
+    // Textures first, then the geometry can be built anywhere
+    std::vector<SphericalChunk> buildChunks(chunks);
+    for (auto &chunk : buildChunks) {
         // May need to set up the texture
         SimpleIdentity texId = EmptyIdentity;
         Texture *newTex = NULL;
@@ -346,39 +411,39 @@ SimpleIdentity SphericalChunkManager::addChunks(const std::vector<SphericalChunk
             chunk.texIDs.push_back(newTex->getId());
             changes.push_back(new AddTextureReq(newTex));
         }
-        texId = EmptyIdentity;
-        if (!chunk.texIDs.empty())
-            texId = chunk.texIDs.at(0);
-
-        skirtDraw->setTexId(0,texId);
-        drawable->setTexId(0,texId);
-        chunk.buildDrawable(renderer,drawable,chunkInfo.doEdgeMatching,skirtDraw,chunkInfo.enable,coordAdapter,chunkInfo);
-
-        if (drawable->getNumPoints() > MaxDrawablePoints || (lastTexID != -1 && lastTexID != texId)) {
-            if (skirtDraw->getNumPoints() > 0) {
-                chunkRep->drawIDs.insert(skirtDraw->getDrawableID());
-                changes.push_back(new AddDrawableReq(skirtDraw->getDrawable()));
-                
-                skirtDraw = getSceneRenderer()->makeBasicDrawableBuilder("Chunk Manager Skirt");
-            }
-            if (drawable->getNumPoints() > 0) {
-                chunkRep->drawIDs.insert(drawable->getDrawableID());
-                changes.push_back(new AddDrawableReq(drawable->getDrawable()));
-                
-                drawable = getSceneRenderer()->makeBasicDrawableBuilder("Chunk Manager");
-            }
-        }
-        lastTexID = texId;
     }
-    
-    if (skirtDraw->getNumPoints() > 0) {
-        chunkRep->drawIDs.insert(skirtDraw->getDrawableID());
-        changes.push_back(new AddDrawableReq(skirtDraw->getDrawable()));
+
+    // Runs of chunks with the same texture share drawables.
+    // With workers, they're also broken up so there's something to hand out.
+    const auto workers = getBuildWorkers();
+    const size_t maxRun = workers ? ChunksPerTask : buildChunks.size();
+    std::vector<std::pair<size_t,size_t>> runs;
+    for (size_t start = 0; start < buildChunks.size(); ) {
+        const SimpleIdentity texId = chunkTexID(buildChunks[start]);
+        size_t end = start + 1;
+        while (end < buildChunks.size() && end - start < maxRun && chunkTexID(buildChunks[end]) == texId)
+            end++;
+        runs.emplace_back(start,end);
+        start = end;
     }
 
-    if (drawable->getNumPoints() > 0) {
-        chunkRep->drawIDs.insert(drawable->getDrawableID());
-        changes.push_back(new AddDrawableReq(drawable->getDrawable()));
+    std::vector<std::vector<BasicDrawableRef>> runDraws(runs.size());
+    const auto buildRuns = [&](size_t start,size_t end)
+    {
+        for (size_t ii=start;ii<end;ii++)
+            buildChunkRun(buildChunks,runs[ii].first,runs[ii].second,coordAdapter,chunkInfo,runDraws[ii]);
+    };
+    if (workers && runs.size() > 1)
+        workers->parallelFor(runs.size(),1,buildRuns);
+    else
+        buildRuns(0,runs.size());
+
+    // Hand them over in order, as if built one after the other
+    for (const auto &draws : runDraws) {
+        for (const auto &draw : draws) {
+            chunkRep->drawIDs.insert(draw->getId());
+            changes.push_back(new AddDrawableReq(draw));
+        }
     }
 
     {
@@ -127,6 +127,39 @@ Point3d SphericalMercatorCoordSystem::geocentricToLocal(Point3d geocPt) const
     return {localPt.x(),localPt.y(),geoCoordPlus.z()};
 }
 
+void SphericalMercatorCoordSystem::geographicToLocalBatch(const Point2d *geo,Point3d *local,size_t count) const
+{
+    // Same math as geographicToLocal(Point2d), so the results match point for point
+    for (size_t ii=0;ii<count;ii++)
+    {
+        const double lat = std::min(PoleLimit, std::max(-PoleLimit, geo[ii].y()));
+        local[ii] = Point3d(geo[ii].x() - originLon, std::log((1.0 + std::sin(lat)) / std::cos(lat)), 0.0);
+    }
+}
+
+void SphericalMercatorCoordSystem::localToGeographicBatch(const Point3d *local,Point2d *geo,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        geo[ii] = Point2d(local[ii].x() + originLon, std::atan(std::sinh(local[ii].y())));
+}
+
+void SphericalMercatorCoordSystem::localToGeocentricBatch(const Point3d *local,Point3d *geoc,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        geoc[ii] = Point3d(local[ii].x() + originLon, std::atan(std::sinh(local[ii].y())), local[ii].z());
+    GeoCoordSystem::LocalToGeocentric(geoc,geoc,count);
+}
+
+void SphericalMercatorCoordSystem::geocentricToLocalBatch(const Point3d *geoc,Point3d *local,size_t count) const
+{
+    GeoCoordSystem::GeocentricToLocal(geoc,local,count);
+    for (size_t ii=0;ii<count;ii++)
+    {
+        const double lat = std::min(PoleLimit, std::max(-PoleLimit, local[ii].y()));
+        local[ii] = Point3d(local[ii].x() - originLon, std::log((1.0 + std::sin(lat)) / std::cos(lat)), local[ii].z());
+    }
+}
+
 bool SphericalMercatorCoordSystem::isSameAs(const CoordSystem *coordSys) const
 {
     const auto other = dynamic_cast<const SphericalMercatorCoordSystem *>(coordSys);
@@ -184,6 +217,20 @@ WhirlyKit::Point3d SphericalMercatorDisplayAdapter::localToDisplay(WhirlyKit::Po
     return dispPt;
 }
     
+void SphericalMercatorDisplayAdapter::localToDisplayBatch(const Point3d *local,Point3d *disp,size_t count) const
+{
+    // Plain arrays of doubles, so the compiler can vectorize it
+    const double ox = org.x(), oy = org.y();
+    const double *in = (const double *)local;
+    double *out = (double *)disp;
+    for (size_t ii=0;ii<count*3;ii+=3)
+    {
+        out[ii] = in[ii] - ox;
+        out[ii+1] = in[ii+1] - oy;
+        out[ii+2] = in[ii+2];
+    }
+}
+
 /// Convert from display coordinates to the local system's coordinates
 WhirlyKit::Point3f SphericalMercatorDisplayAdapter::displayToLocal(WhirlyKit::Point3f dispPt) const
 {
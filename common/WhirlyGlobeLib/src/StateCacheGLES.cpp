@@ -0,0 +1,190 @@
+/*  StateCacheGLES.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "StateCacheGLES.h"
+
+namespace WhirlyKit
+{
+
+StateCacheGLES::StateCacheGLES() :
+    numCalls(0),
+    numSkipped(0)
+{
+    invalidate();
+}
+
+void StateCacheGLES::invalidate()
+{
+    program = 0;
+    programValid = false;
+    activeUnit = -1;
+    for (unsigned int ii=0;ii<WhirlyKitMaxTextures;ii++)
+    {
+        textures[ii] = 0;
+        texturesValid[ii] = false;
+    }
+    blend = depthTest = depthMask = cullFace = Unknown;
+    blendSrc = blendDst = GL_ZERO;
+    blendFuncValid = false;
+    depthFunc = GL_LESS;
+    depthFuncValid = false;
+    lineWidth = 1.0f;
+    lineWidthValid = false;
+}
+
+bool StateCacheGLES::update(KnownState &known,bool enable)
+{
+    const KnownState val = enable ? On : Off;
+    if (known == val)
+    {
+        numSkipped++;
+        return false;
+    }
+    known = val;
+    numCalls++;
+    return true;
+}
+
+void StateCacheGLES::useProgram(GLuint newProgram)
+{
+    if (update(program,programValid,newProgram))
+    {
+        glUseProgram(newProgram);
+        CheckGLError("StateCacheGLES::useProgram() glUseProgram");
+    }
+}
+
+void StateCacheGLES::bindTexture(int unit,GLuint texID)
+{
+    if (unit < 0 || unit >= WhirlyKitMaxTextures)
+    {
+        glActiveTexture(GL_TEXTURE0+unit);
+        glBindTexture(GL_TEXTURE_2D, texID);
+        activeUnit = unit;
+        numCalls += 2;
+        return;
+    }
+
+    if (texturesValid[unit] && textures[unit] == texID)
+    {
+        numSkipped++;
+        return;
+    }
+
+    if (activeUnit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0+unit);
+        activeUnit = unit;
+        numCalls++;
+    }
+    else
+    {
+        numSkipped++;
+    }
+    glBindTexture(GL_TEXTURE_2D, texID);
+    CheckGLError("StateCacheGLES::bindTexture() glBindTexture");
+    textures[unit] = texID;
+    texturesValid[unit] = true;
+    numCalls++;
+}
+
+void StateCacheGLES::unbindTextures()
+{
+    for (int ii=0;ii<WhirlyKitMaxTextures;ii++)
+    {
+        // If we don't know, it could be anything
+        if (!texturesValid[ii] || textures[ii] != 0)
+        {
+            bindTexture(ii, 0);
+        }
+    }
+}
+
+void StateCacheGLES::setBlend(bool enable)
+{
+    if (update(blend,enable))
+    {
+        if (enable)
+            glEnable(GL_BLEND);
+        else
+            glDisable(GL_BLEND);
+    }
+}
+
+void StateCacheGLES::setBlendFunc(GLenum srcFactor,GLenum dstFactor)
+{
+    if (blendFuncValid && blendSrc == srcFactor && blendDst == dstFactor)
+    {
+        numSkipped++;
+        return;
+    }
+    blendSrc = srcFactor;
+    blendDst = dstFactor;
+    blendFuncValid = true;
+    numCalls++;
+    glBlendFunc(srcFactor, dstFactor);
+}
+
+void StateCacheGLES::setDepthTest(bool enable)
+{
+    if (update(depthTest,enable))
+    {
+        if (enable)
+            glEnable(GL_DEPTH_TEST);
+        else
+            glDisable(GL_DEPTH_TEST);
+    }
+}
+
+void StateCacheGLES::setDepthMask(bool enable)
+{
+    if (update(depthMask,enable))
+    {
+        glDepthMask(enable ? GL_TRUE : GL_FALSE);
+    }
+}
+
+void StateCacheGLES::setDepthFunc(GLenum func)
+{
+    if (update(depthFunc,depthFuncValid,func))
+    {
+        glDepthFunc(func);
+    }
+}
+
+void StateCacheGLES::setCullFace(bool enable)
+{
+    if (update(cullFace,enable))
+    {
+        if (enable)
+            glEnable(GL_CULL_FACE);
+        else
+            glDisable(GL_CULL_FACE);
+        CheckGLError("StateCacheGLES::setCullFace()");
+    }
+}
+
+void StateCacheGLES::setLineWidth(float width)
+{
+    if (update(lineWidth,lineWidthValid,width))
+    {
+        glLineWidth(width);
+        CheckGLError("StateCacheGLES::setLineWidth() glLineWidth");
+    }
+}
+
+}
@@ -22,37 +22,175 @@
 
 namespace WhirlyKit {
 
+namespace {
+    // Start big enough for the shader names and a good set of attribute names
+    constexpr size_t InitialTableSize = 1024;
+
+    // Names nearly everything ends up looking up, so they're in from the start
+    const char * const WellKnownStrings[] = {
+        "u_mvpMatrix", "u_mvpInvMatrix", "u_mvMatrix", "u_mvNormalMatrix", "u_mvpNormalMatrix",
+        "u_pMatrix", "u_fade", "u_scale", "u_hasTexture", "u_eyeVec", "u_eyePos", "u_size",
+        "u_time", "u_lifetime", "u_pixDispSize", "u_frameLen", "u_upright", "u_activerot",
+        "u_w2", "u_real_w2", "u_wideOffset", "u_edge", "u_texScale", "u_color", "u_length",
+        "u_interp", "u_screenOrigin", "u_origin", "u_globe", "u_numLights",
+        "a_singleMatrix", "a_position", "a_offset", "a_rot", "a_dir", "a_maskID",
+        "a_texCoord", "a_color", "a_normal", "a_modelCenter", "a_useInstanceColor",
+        "a_instanceColor", "a_modelDir", "a_height",
+        "material.ambient", "material.diffuse", "material.specular", "material.specular_exponent",
+    };
+
+    // Which segment a string ID is in, and where
+    inline void segmentFor(StringIdentity strID,int firstBits,int &seg,size_t &offset)
+    {
+        const uint64_t which = ((uint64_t)strID >> firstBits) + 1;
+        seg = 63 - __builtin_clzll(which);
+        offset = strID - ((((size_t)1 << seg) - 1) << firstBits);
+    }
+
+    // Top of the hash, kept in the slot so we rarely compare strings that don't match
+    inline uint64_t hashTag(size_t hash)
+    {
+        return (uint64_t)(uint32_t)((uint64_t)hash >> 32 ^ hash) << 32;
+    }
+}
+
 StringIndexer StringIndexer::instance;
 
-StringIndexer::StringIndexer() : stringToIdent(500)
+StringIndexer::Table::Table(size_t size) :
+    mask(size - 1),
+    slots(new std::atomic<uint64_t>[size])
+{
+    for (size_t ii=0;ii<size;ii++)
+        slots[ii].store(0,std::memory_order_relaxed);
+}
+
+StringIndexer::StringIndexer() :
+    numStrings(0)
+{
+    for (auto &seg : segments)
+        seg.store(nullptr,std::memory_order_relaxed);
+
+    tables.emplace_back(new Table(InitialTableSize));
+    table.store(tables.back().get(),std::memory_order_release);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::hash<std::string> hasher;
+    for (const char *name : WellKnownStrings)
+    {
+        const std::string str(name);
+        addString(str,hasher(str));
+    }
+}
+
+StringIndexer::~StringIndexer()
 {
-    identToString.reserve(500);
+    for (auto &seg : segments)
+        delete [] seg.load(std::memory_order_relaxed);
+}
+
+const std::string &StringIndexer::stringFor(StringIdentity strID) const
+{
+    int seg;
+    size_t offset;
+    segmentFor(strID,FirstSegmentBits,seg,offset);
+    return segments[seg].load(std::memory_order_acquire)[offset];
+}
+
+bool StringIndexer::findString(const std::string &str,size_t hash,StringIdentity &strID) const
+{
+    const Table *curTable = table.load(std::memory_order_acquire);
+    const uint64_t tag = hashTag(hash);
+    for (size_t which = hash & curTable->mask;;which = (which + 1) & curTable->mask)
+    {
+        const uint64_t slot = curTable->slots[which].load(std::memory_order_acquire);
+        if (slot == 0)
+            return false;
+        if ((slot & 0xffffffff00000000ULL) == tag)
+        {
+            const StringIdentity thisID = (slot & 0xffffffffULL) - 1;
+            if (stringFor(thisID) == str)
+            {
+                strID = thisID;
+                return true;
+            }
+        }
+    }
+}
+
+void StringIndexer::insertSlot(Table &inTable,size_t hash,StringIdentity strID)
+{
+    size_t which = hash & inTable.mask;
+    while (inTable.slots[which].load(std::memory_order_relaxed) != 0)
+        which = (which + 1) & inTable.mask;
+    inTable.slots[which].store(hashTag(hash) | (strID + 1),std::memory_order_release);
+}
+
+StringIdentity StringIndexer::addString(const std::string &str,size_t hash)
+{
+    const StringIdentity strID = numStrings.load(std::memory_order_relaxed);
+
+    // The string goes in before anyone can find it
+    int seg;
+    size_t offset;
+    segmentFor(strID,FirstSegmentBits,seg,offset);
+    std::string *segStrings = segments[seg].load(std::memory_order_relaxed);
+    if (!segStrings)
+    {
+        segStrings = new std::string[(size_t)1 << (FirstSegmentBits + seg)];
+        segments[seg].store(segStrings,std::memory_order_release);
+    }
+    segStrings[offset] = str;
+    numStrings.store(strID + 1,std::memory_order_release);
+
+    // Keep the table under half full, moving to a bigger one when it isn't
+    Table *curTable = table.load(std::memory_order_relaxed);
+    if (2 * (strID + 1) > curTable->mask + 1)
+    {
+        std::unique_ptr<Table> newTable(new Table(2 * (curTable->mask + 1)));
+        const std::hash<std::string> hasher;
+        for (StringIdentity ii=0;ii<strID;ii++)
+            insertSlot(*newTable,hasher(stringFor(ii)),ii);
+        insertSlot(*newTable,hash,strID);
+        table.store(newTable.get(),std::memory_order_release);
+        tables.push_back(std::move(newTable));
+    }
+    else
+    {
+        insertSlot(*curTable,hash,strID);
+    }
+
+    return strID;
 }
 
 StringIdentity StringIndexer::getStringID(const std::string &str)
 {
     StringIndexer &index = getInstance();
 
-    // todo: upgradeable shared mutex would be perfect here
+    const size_t hash = std::hash<std::string>()(str);
+    StringIdentity strID;
+    if (index.findString(str,hash,strID))
+        return strID;
+
     std::lock_guard<std::mutex> lock(index.mutex);
 
-    const auto it = index.stringToIdent.find(str);
-    if (it != index.stringToIdent.end())
-        return it->second;
+    // Someone may have beaten us to it
+    if (index.findString(str,hash,strID))
+        return strID;
 
-    const int strID = index.identToString.size();
-    index.identToString.push_back(str);
-    index.stringToIdent[str] = strID;
-    return strID;
+    return index.addString(str,hash);
 }
 
 std::string StringIndexer::getString(StringIdentity strID)
 {
-    const StringIndexer &index = getInstance();
+    return getStringRef(strID);
+}
 
-    std::lock_guard<std::mutex> lock(index.mutex);
+const std::string &StringIndexer::getStringRef(StringIdentity strID)
+{
+    static const std::string emptyString;
 
-    return (strID < index.identToString.size()) ? index.identToString[strID] : std::string();
+    const StringIndexer &index = getInstance();
+    return (strID < index.numStrings.load(std::memory_order_acquire)) ? index.stringFor(strID) : emptyString;
 }
  
 // Note: This is from OpenGL.  Doesn't hold anymore on iOS
@@ -105,10 +243,19 @@ StringIdentity u_Realw2NameID;
 StringIdentity u_wideOffsetNameID;
 StringIdentity u_EdgeNameID;
 StringIdentity u_texScaleNameID;
+StringIdentity u_wideTexOffsetNameID;
+StringIdentity u_wideJoinNameID;
+StringIdentity u_wideCapNameID;
+StringIdentity u_miterLimitNameID;
+StringIdentity u_interClipLimitNameID;
 StringIdentity u_colorNameID;
 StringIdentity u_lengthNameID;
 StringIdentity u_interpNameID;
+StringIdentity u_elevDecodeNameID;
 StringIdentity u_screenOriginNameID;
+StringIdentity u_originNameID;
+StringIdentity u_globeNameID;
+StringIdentity a_heightNameID;
 StringIdentity a_colorNameID;
 StringIdentity a_normalNameID;
 StringIdentity a_modelCenterNameID;
@@ -184,10 +331,19 @@ static void SetupDrawableStringsOnce()
     u_wideOffsetNameID = StringIndexer::getStringID("u_wideOffset");
     u_EdgeNameID = StringIndexer::getStringID("u_edge");
     u_texScaleNameID = StringIndexer::getStringID("u_texScale");
+    u_wideTexOffsetNameID = StringIndexer::getStringID("u_wideTexOffset");
+    u_wideJoinNameID = StringIndexer::getStringID("u_wideJoin");
+    u_wideCapNameID = StringIndexer::getStringID("u_wideCap");
+    u_miterLimitNameID = StringIndexer::getStringID("u_miterLimit");
+    u_interClipLimitNameID = StringIndexer::getStringID("u_interClipLimit");
     u_colorNameID = StringIndexer::getStringID("u_color");
     u_lengthNameID = StringIndexer::getStringID("u_length");
     u_interpNameID = StringIndexer::getStringID("u_interp");
+    u_elevDecodeNameID = StringIndexer::getStringID("u_elevDecode");
     u_screenOriginNameID = StringIndexer::getStringID("u_screenOrigin");
+    u_originNameID = StringIndexer::getStringID("u_origin");
+    u_globeNameID = StringIndexer::getStringID("u_globe");
+    a_heightNameID = StringIndexer::getStringID("a_height");
     a_colorNameID = StringIndexer::getStringID("a_color");
     a_normalNameID = StringIndexer::getStringID("a_normal");
     a_modelCenterNameID = StringIndexer::getStringID("a_modelCenter");
@@ -0,0 +1,627 @@
+/*  StyleRuleFilter.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <cctype>
+#import <cstdlib>
+#import <cstring>
+#import <strings.h>
+#import "StyleRuleFilter.h"
+#import "DictionaryC.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+// Read the whole string as a number, or fail
+static bool ParseNumber(const std::string &str,double &num)
+{
+    if (str.empty())
+        return false;
+    const char *start = str.c_str();
+    char *end = nullptr;
+    num = strtod(start,&end);
+    while (end && *end && isspace((unsigned char)*end))
+        end++;
+    return end != start && end && *end == 0;
+}
+
+bool StyleRuleFilter::Value::isNum() const
+{
+    switch (type)
+    {
+        case DictTypeInt:
+        case DictTypeInt64:
+        case DictTypeIdentity:
+        case DictTypeDouble:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool StyleRuleFilter::Value::toNum(double &num) const
+{
+    if (isNum())
+    {
+        num = numVal;
+        return true;
+    }
+    return type == DictTypeString && strVal && ParseNumber(*strVal,num);
+}
+
+int StyleRuleFilter::addAttr(const std::string &name)
+{
+    if (name.empty())
+        return -1;
+    Expr expr;
+    expr.type = StyleExprAttr;
+    expr.strVal = name;
+    exprs.push_back(expr);
+    return (int)exprs.size()-1;
+}
+
+int StyleRuleFilter::addLiteral(const std::string &val)
+{
+    Expr expr;
+    expr.type = StyleExprLiteral;
+    expr.strVal = val;
+    expr.isNum = ParseNumber(val,expr.numVal);
+    exprs.push_back(expr);
+    return (int)exprs.size()-1;
+}
+
+int StyleRuleFilter::addArith(StyleExprType type,int left,int right)
+{
+    if (type < StyleExprAdd || type > StyleExprDiv ||
+        left < 0 || left >= (int)exprs.size() || right < 0 || right >= (int)exprs.size())
+        return -1;
+    Expr expr;
+    expr.type = type;
+    expr.left = left;
+    expr.right = right;
+    exprs.push_back(expr);
+    return (int)exprs.size()-1;
+}
+
+int StyleRuleFilter::addCompare(StyleRuleOp op,int left,int right,bool matchCase)
+{
+    if (op < StyleRuleEqual || op > StyleRuleGreaterEqual ||
+        left < 0 || left >= (int)exprs.size() || right < 0 || right >= (int)exprs.size())
+        return -1;
+    Test test;
+    test.op = op;
+    test.matchCase = matchCase;
+    test.operands[0] = left;
+    test.operands[1] = right;
+    tests.push_back(test);
+    return (int)tests.size()-1;
+}
+
+int StyleRuleFilter::addIsNull(int expr)
+{
+    if (expr < 0 || expr >= (int)exprs.size())
+        return -1;
+    Test test;
+    test.op = StyleRuleIsNull;
+    test.operands[0] = expr;
+    tests.push_back(test);
+    return (int)tests.size()-1;
+}
+
+int StyleRuleFilter::addLike(int expr,const std::string &pattern,char wildCard,char singleChar,char escapeChar,bool matchCase)
+{
+    if (expr < 0 || expr >= (int)exprs.size())
+        return -1;
+    Test test;
+    test.op = StyleRuleLike;
+    test.operands[0] = expr;
+    test.pattern = pattern;
+    test.wildCard = wildCard;
+    test.singleChar = singleChar;
+    test.escapeChar = escapeChar;
+    test.matchCase = matchCase;
+    tests.push_back(test);
+    return (int)tests.size()-1;
+}
+
+int StyleRuleFilter::addBetween(int expr,int lower,int upper)
+{
+    for (int which : { expr, lower, upper })
+        if (which < 0 || which >= (int)exprs.size())
+            return -1;
+    Test test;
+    test.op = StyleRuleBetween;
+    test.operands[0] = expr;
+    test.operands[1] = lower;
+    test.operands[2] = upper;
+    tests.push_back(test);
+    return (int)tests.size()-1;
+}
+
+int StyleRuleFilter::addLogical(StyleRuleOp op,const std::vector<int> &subTests)
+{
+    if ((op != StyleRuleAll && op != StyleRuleAny && op != StyleRuleNot) ||
+        (op == StyleRuleNot && subTests.size() != 1))
+        return -1;
+    for (int which : subTests)
+        if (which < 0 || which >= (int)tests.size())
+            return -1;
+    Test test;
+    test.op = op;
+    test.subTests = subTests;
+    tests.push_back(test);
+    return (int)tests.size()-1;
+}
+
+int StyleRuleFilter::addConstant(bool val)
+{
+    Test test;
+    test.op = val ? StyleRuleTrue : StyleRuleFalse;
+    tests.push_back(test);
+    return (int)tests.size()-1;
+}
+
+void StyleRuleFilter::compileTest(unsigned int which)
+{
+    const unsigned int pc = (unsigned int)program.size();
+    program.push_back({which,0});
+    // Subtests always come before their parents, so this can't loop
+    for (int sub : tests[which].subTests)
+        compileTest(sub);
+    program[pc].end = (unsigned int)program.size();
+}
+
+bool StyleRuleFilter::compile(int root)
+{
+    program.clear();
+    if (root < 0 || root >= (int)tests.size())
+        return false;
+    compileTest(root);
+    return true;
+}
+
+void StyleRuleFilter::collectKeys(std::set<std::string> &keys) const
+{
+    for (const auto &expr : exprs)
+        if (expr.type == StyleExprAttr)
+            keys.insert(expr.strVal);
+}
+
+void StyleRuleFilter::evalExpr(const Dictionary &attrs,const MutableDictionaryC *dictC,int which,Value &val) const
+{
+    const Expr &expr = exprs[which];
+    switch (expr.type)
+    {
+        case StyleExprAttr:
+            if (dictC)
+            {
+                val.type = dictC->getValue(expr.strVal,val.numVal,val.strVal);
+            }
+            else
+            {
+                val.type = attrs.getType(expr.strVal);
+                if (val.isNum())
+                    val.numVal = attrs.getDouble(expr.strVal);
+                else if (val.type == DictTypeString)
+                {
+                    val.ownStr = attrs.getString(expr.strVal);
+                    val.strVal = &val.ownStr;
+                }
+            }
+            break;
+        case StyleExprLiteral:
+            // Numeric literals keep their text, for comparing against strings that aren't numbers
+            val.type = expr.isNum ? DictTypeDouble : DictTypeString;
+            val.numVal = expr.numVal;
+            val.strVal = &expr.strVal;
+            break;
+        default:
+        {
+            Value left,right;
+            evalExpr(attrs,dictC,expr.left,left);
+            evalExpr(attrs,dictC,expr.right,right);
+            double leftNum,rightNum;
+            val.type = DictTypeNone;
+            if (!left.toNum(leftNum) || !right.toNum(rightNum))
+                break;
+            switch (expr.type)
+            {
+                case StyleExprAdd: val.numVal = leftNum + rightNum; break;
+                case StyleExprSub: val.numVal = leftNum - rightNum; break;
+                case StyleExprMul: val.numVal = leftNum * rightNum; break;
+                case StyleExprDiv:
+                    if (rightNum == 0.0)
+                        return;
+                    val.numVal = leftNum / rightNum;
+                    break;
+                default:
+                    return;
+            }
+            val.type = DictTypeDouble;
+            break;
+        }
+    }
+}
+
+bool StyleRuleFilter::compareValues(const Value &left,const Value &right,StyleRuleOp op,bool matchCase) const
+{
+    int cmp;
+    double leftNum,rightNum;
+    if ((left.isNum() || right.isNum()) && left.toNum(leftNum) && right.toNum(rightNum))
+    {
+        cmp = (leftNum < rightNum) ? -1 : ((leftNum > rightNum) ? 1 : 0);
+    }
+    else if (left.strVal && right.strVal && !(left.isNum() && right.isNum()) &&
+             (left.type == DictTypeString || right.type == DictTypeString))
+    {
+        if (matchCase)
+            cmp = left.strVal->compare(*right.strVal);
+        else
+            cmp = strcasecmp(left.strVal->c_str(),right.strVal->c_str());
+    }
+    else
+        return false;
+
+    switch (op)
+    {
+        case StyleRuleEqual: return cmp == 0;
+        case StyleRuleNotEqual: return cmp != 0;
+        case StyleRuleLess: return cmp < 0;
+        case StyleRuleLessEqual: return cmp <= 0;
+        case StyleRuleGreater: return cmp > 0;
+        case StyleRuleGreaterEqual: return cmp >= 0;
+        default: return false;
+    }
+}
+
+// Glob style match, backing up to the last wildcard when we miss
+bool StyleRuleFilter::MatchLike(const std::string &str,const Test &test)
+{
+    const std::string &pat = test.pattern;
+    const auto same = [&test](char a,char b) {
+        return test.matchCase ? a == b : tolower((unsigned char)a) == tolower((unsigned char)b);
+    };
+
+    size_t si = 0, pi = 0;
+    size_t starPi = std::string::npos, starSi = 0;
+    while (si < str.size())
+    {
+        if (pi < pat.size() && pat[pi] == test.wildCard)
+        {
+            starPi = ++pi;
+            starSi = si;
+            continue;
+        }
+        if (pi < pat.size())
+        {
+            const bool escaped = (pat[pi] == test.escapeChar && pi + 1 < pat.size());
+            const char pc = escaped ? pat[pi+1] : pat[pi];
+            if ((!escaped && pc == test.singleChar) || same(pc,str[si]))
+            {
+                pi += escaped ? 2 : 1;
+                si++;
+                continue;
+            }
+        }
+        if (starPi == std::string::npos)
+            return false;
+        pi = starPi;
+        si = ++starSi;
+    }
+    while (pi < pat.size() && pat[pi] == test.wildCard)
+        pi++;
+    return pi == pat.size();
+}
+
+bool StyleRuleFilter::runOp(const Dictionary &attrs,const MutableDictionaryC *dictC,unsigned int pc) const
+{
+    const RuleOp &op = program[pc];
+    const Test &test = tests[op.test];
+    switch (test.op)
+    {
+        case StyleRuleAll:
+            for (unsigned int sub = pc + 1; sub < op.end; sub = program[sub].end)
+                if (!runOp(attrs,dictC,sub))
+                    return false;
+            return true;
+        case StyleRuleAny:
+            for (unsigned int sub = pc + 1; sub < op.end; sub = program[sub].end)
+                if (runOp(attrs,dictC,sub))
+                    return true;
+            return false;
+        case StyleRuleNot:
+            return !runOp(attrs,dictC,pc + 1);
+        case StyleRuleTrue:
+            return true;
+        case StyleRuleFalse:
+            return false;
+        case StyleRuleIsNull:
+        {
+            Value val;
+            evalExpr(attrs,dictC,test.operands[0],val);
+            return val.type == DictTypeNone;
+        }
+        case StyleRuleLike:
+        {
+            Value val;
+            evalExpr(attrs,dictC,test.operands[0],val);
+            return val.type == DictTypeString && MatchLike(*val.strVal,test);
+        }
+        case StyleRuleBetween:
+        {
+            Value val,lower,upper;
+            evalExpr(attrs,dictC,test.operands[0],val);
+            evalExpr(attrs,dictC,test.operands[1],lower);
+            evalExpr(attrs,dictC,test.operands[2],upper);
+            double num,lowerNum,upperNum;
+            return val.toNum(num) && lower.toNum(lowerNum) && upper.toNum(upperNum) &&
+                   num >= lowerNum && num <= upperNum;
+        }
+        default:
+        {
+            Value left,right;
+            evalExpr(attrs,dictC,test.operands[0],left);
+            evalExpr(attrs,dictC,test.operands[1],right);
+            return compareValues(left,right,test.op,test.matchCase);
+        }
+    }
+}
+
+bool StyleRuleFilter::test(const Dictionary &attrs) const
+{
+    if (program.empty())
+        return false;
+    return runOp(attrs,dynamic_cast<const MutableDictionaryC *>(&attrs),0);
+}
+
+// Recursive descent over Mapnik's filter language.
+// We handle comparisons, arithmetic, and/or/not and true/false.
+class MapnikFilterParser
+{
+public:
+    MapnikFilterParser(const std::string &str,StyleRuleFilter &filter) : str(str), filter(filter) { }
+
+    int parse()
+    {
+        const int root = parseOr();
+        skipSpace();
+        return (pos == str.size()) ? root : -1;
+    }
+
+protected:
+    void skipSpace()
+    {
+        while (pos < str.size() && isspace((unsigned char)str[pos]))
+            pos++;
+    }
+
+    bool accept(const char *tok)
+    {
+        skipSpace();
+        const size_t len = strlen(tok);
+        if (str.compare(pos,len,tok) != 0)
+            return false;
+        // Words have to end where the word does
+        if (isalpha((unsigned char)tok[0]) && pos + len < str.size() &&
+            (isalnum((unsigned char)str[pos+len]) || str[pos+len] == '_'))
+            return false;
+        pos += len;
+        return true;
+    }
+
+    bool acceptWord(const char *word)
+    {
+        skipSpace();
+        const size_t len = strlen(word);
+        if (pos + len > str.size() || strncasecmp(str.c_str()+pos,word,len) != 0)
+            return false;
+        if (pos + len < str.size() && (isalnum((unsigned char)str[pos+len]) || str[pos+len] == '_'))
+            return false;
+        pos += len;
+        return true;
+    }
+
+    int parseOr()
+    {
+        std::vector<int> subs = { parseAnd() };
+        while (subs.back() >= 0 && (acceptWord("or") || accept("||")))
+            subs.push_back(parseAnd());
+        return (subs.size() == 1) ? subs[0] : filter.addLogical(StyleRuleAny,subs);
+    }
+
+    int parseAnd()
+    {
+        std::vector<int> subs = { parseNot() };
+        while (subs.back() >= 0 && (acceptWord("and") || accept("&&")))
+            subs.push_back(parseNot());
+        return (subs.size() == 1) ? subs[0] : filter.addLogical(StyleRuleAll,subs);
+    }
+
+    int parseNot()
+    {
+        if (acceptWord("not") || (!accept("!=") && accept("!")))
+        {
+            const int sub = parseNot();
+            return filter.addLogical(StyleRuleNot,{sub});
+        }
+        if (acceptWord("true"))
+            return filter.addConstant(true);
+        if (acceptWord("false"))
+            return filter.addConstant(false);
+
+        // A parenthesized test, unless it turns out to be a value in a comparison
+        const size_t startPos = pos;
+        if (accept("("))
+        {
+            const int sub = parseOr();
+            if (sub >= 0 && accept(")"))
+            {
+                const size_t afterPos = pos;
+                StyleRuleOp op;
+                if (!peekCompare(op) && !peekArith())
+                    return sub;
+                pos = afterPos;
+            }
+            pos = startPos;
+        }
+        return parseCompare();
+    }
+
+    bool peekCompare(StyleRuleOp &op)
+    {
+        const size_t startPos = pos;
+        const bool found = acceptCompare(op);
+        pos = startPos;
+        return found;
+    }
+
+    bool peekArith()
+    {
+        skipSpace();
+        return pos < str.size() && strchr("+-*/",str[pos]);
+    }
+
+    bool acceptCompare(StyleRuleOp &op)
+    {
+        if (accept("==") || accept("=") || acceptWord("eq"))
+            op = StyleRuleEqual;
+        else if (accept("!=") || accept("<>") || acceptWord("neq"))
+            op = StyleRuleNotEqual;
+        else if (accept("<=") || acceptWord("le"))
+            op = StyleRuleLessEqual;
+        else if (accept(">=") || acceptWord("ge"))
+            op = StyleRuleGreaterEqual;
+        else if (accept("<") || acceptWord("lt"))
+            op = StyleRuleLess;
+        else if (accept(">") || acceptWord("gt"))
+            op = StyleRuleGreater;
+        else
+            return false;
+        return true;
+    }
+
+    int parseCompare()
+    {
+        const int left = parseSum();
+        StyleRuleOp op;
+        if (left < 0 || !acceptCompare(op))
+            return -1;
+        const int right = parseSum();
+        return filter.addCompare(op,left,right);
+    }
+
+    int parseSum()
+    {
+        int left = parseTerm();
+        while (left >= 0)
+        {
+            if (accept("+"))
+                left = filter.addArith(StyleExprAdd,left,parseTerm());
+            else if (accept("-"))
+                left = filter.addArith(StyleExprSub,left,parseTerm());
+            else
+                break;
+        }
+        return left;
+    }
+
+    int parseTerm()
+    {
+        int left = parseValue();
+        while (left >= 0)
+        {
+            if (accept("*"))
+                left = filter.addArith(StyleExprMul,left,parseValue());
+            else if (accept("/"))
+                left = filter.addArith(StyleExprDiv,left,parseValue());
+            else
+                break;
+        }
+        return left;
+    }
+
+    int parseValue()
+    {
+        skipSpace();
+        if (pos >= str.size())
+            return -1;
+
+        const char c = str[pos];
+        if (c == '(')
+        {
+            pos++;
+            const int val = parseSum();
+            return accept(")") ? val : -1;
+        }
+        if (c == '[')
+        {
+            const size_t end = str.find(']',pos);
+            if (end == std::string::npos)
+                return -1;
+            std::string name = str.substr(pos+1,end-pos-1);
+            pos = end+1;
+            // Older styles qualify a few of these
+            if (name.compare(0,8,"mapnik::") == 0)
+                name = name.substr(8);
+            return filter.addAttr(name);
+        }
+        if (c == '\'' || c == '"')
+        {
+            std::string val;
+            for (pos++; pos < str.size() && str[pos] != c; pos++)
+            {
+                if (str[pos] == '\\' && pos + 1 < str.size())
+                    pos++;
+                val += str[pos];
+            }
+            if (pos >= str.size())
+                return -1;
+            pos++;
+            return filter.addLiteral(val);
+        }
+        if (isdigit((unsigned char)c) || c == '-' || c == '.')
+        {
+            const char *start = str.c_str() + pos;
+            char *end = nullptr;
+            strtod(start,&end);
+            if (end == start)
+                return -1;
+            const std::string val(start,end-start);
+            pos += end - start;
+            return filter.addLiteral(val);
+        }
+        return -1;
+    }
+
+    const std::string &str;
+    StyleRuleFilter &filter;
+    size_t pos = 0;
+};
+
+bool StyleRuleFilter::ParseMapnik(const std::string &str,StyleRuleFilter &filter)
+{
+    MapnikFilterParser parser(str,filter);
+    const int root = parser.parse();
+    if (root < 0)
+    {
+        wkLogLevel(Debug,"StyleRuleFilter: Can't compile Mapnik filter %s",str.c_str());
+        return false;
+    }
+    return filter.compile(root);
+}
+
+}
@@ -45,6 +45,11 @@ void Sun::setTime(int year, int month, int day, int hour, int minutes, int secon
     this->runCalculation(aaDate);    
 }
 
+void Sun::setJulianDate(double jd)
+{
+    this->runCalculation(CAADate(jd, true));
+}
+
 void Sun::runCalculation(CAADate aaDate)
 {
     double jdSun = CAADynamicalTime::UTC2TT(aaDate.Julian());
@@ -70,4 +75,41 @@ Point3d Sun::getDirection()
     return pt;
 }
 
+SunCache::SunCache(double stepMinutes)
+    : step(stepMinutes / (24.0 * 60.0)), valid(false), stepNum(0.0),
+      lon0(0.0), lat0(0.0), lon1(0.0), lat1(0.0)
+{
+}
+
+void SunCache::getSun(double jd, Sun &sun)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    const double newStep = floor(jd / step);
+    if (!valid || newStep != stepNum)
+    {
+        Sun calc;
+        if (valid && newStep == stepNum + 1.0)
+        {
+            // Moving forward a step, as a time lapse usually does
+            lon0 = lon1;  lat0 = lat1;
+        }
+        else
+        {
+            calc.setJulianDate(newStep * step);
+            lon0 = calc.sunLon;  lat0 = calc.sunLat;
+        }
+        calc.setJulianDate((newStep + 1.0) * step);
+        // Keep the longitude from wrapping around between the ends
+        lon1 = lon0 + remainder(calc.sunLon - lon0, 2.0 * M_PI);
+        lat1 = calc.sunLat;
+        stepNum = newStep;
+        valid = true;
+    }
+
+    const double t = jd / step - stepNum;
+    sun.sunLon = lon0 + t * (lon1 - lon0);
+    sun.sunLat = lat0 + t * (lat1 - lat0);
+}
+
 }
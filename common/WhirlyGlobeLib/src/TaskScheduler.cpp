@@ -0,0 +1,199 @@
+/*  TaskScheduler.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import <iterator>
+#import "TaskScheduler.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    // Which scheduler and worker the current thread belongs to, if any
+    thread_local const TaskScheduler *curScheduler = nullptr;
+    thread_local size_t curWorker = 0;
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    setNumThreads(0);
+}
+
+TaskScheduler &TaskScheduler::getShared()
+{
+    static TaskScheduler shared;
+    return shared;
+}
+
+int TaskScheduler::getNumThreads() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return (int)workers.size();
+}
+
+void TaskScheduler::setThreadHooks(ThreadFunc inStartFn,ThreadFunc inStopFn)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    startFn = std::move(inStartFn);
+    stopFn = std::move(inStopFn);
+}
+
+void TaskScheduler::setNumThreads(int numThreads)
+{
+    std::lock_guard<std::mutex> configGuard(configLock);
+    numThreads = std::max(numThreads,0);
+
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        if ((int)workers.size() == numThreads)
+            return;
+        stopping = true;
+    }
+    wakeCond.notify_all();
+
+    // They finish what they're doing, but nobody picks up anything new
+    for (auto &worker : workers)
+        worker->thread.join();
+
+    std::vector<Task> leftover;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        for (auto &worker : workers)
+            std::move(worker->tasks.begin(),worker->tasks.end(),std::back_inserter(leftover));
+        workers.clear();
+        stopping = false;
+
+        for (int ii=0;ii<numThreads;ii++)
+            workers.emplace_back(new Worker());
+        if (!workers.empty())
+        {
+            for (size_t ii=0;ii<leftover.size();ii++)
+            {
+                auto &tasks = workers[ii % workers.size()]->tasks;
+                tasks.push_back(std::move(leftover[ii]));
+                std::push_heap(tasks.begin(),tasks.end());
+            }
+            numQueued = leftover.size();
+            leftover.clear();
+        }
+        else
+        {
+            numQueued = 0;
+        }
+
+        for (size_t ii=0;ii<workers.size();ii++)
+            workers[ii]->thread = std::thread(&TaskScheduler::workerMain,this,ii);
+    }
+
+    // Nobody left to run these
+    std::sort(leftover.begin(),leftover.end());
+    for (auto it = leftover.rbegin(); it != leftover.rend(); ++it)
+        it->func(it->cancel && *it->cancel);
+}
+
+void TaskScheduler::addTask(double priority,const volatile bool *cancel,TaskFunc func)
+{
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        if (!workers.empty())
+        {
+            // Workers keep what they make, everyone else's goes around
+            const size_t which = (curScheduler == this) ? curWorker : (nextWorker++ % workers.size());
+            auto &worker = *workers[which];
+            {
+                std::lock_guard<std::mutex> queueLock(worker.lock);
+                worker.tasks.push_back(Task { priority, nextSeq++, cancel, std::move(func) });
+                std::push_heap(worker.tasks.begin(),worker.tasks.end());
+            }
+            numQueued++;
+            wakeCond.notify_one();
+            return;
+        }
+    }
+
+    func(cancel && *cancel);
+}
+
+bool TaskScheduler::popTask(Worker &worker,Task &task)
+{
+    std::lock_guard<std::mutex> queueLock(worker.lock);
+    if (worker.tasks.empty())
+        return false;
+    std::pop_heap(worker.tasks.begin(),worker.tasks.end());
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    numQueued--;
+    return true;
+}
+
+bool TaskScheduler::takeTask(size_t which,Task &task)
+{
+    if (popTask(*workers[which],task))
+        return true;
+
+    // Steal from whoever has the most important task waiting
+    Worker *best = nullptr;
+    double bestPriority = 0.0;
+    for (size_t ii=1;ii<workers.size();ii++)
+    {
+        auto &worker = *workers[(which + ii) % workers.size()];
+        std::lock_guard<std::mutex> queueLock(worker.lock);
+        if (!worker.tasks.empty() && (!best || worker.tasks.front().priority > bestPriority))
+        {
+            best = &worker;
+            bestPriority = worker.tasks.front().priority;
+        }
+    }
+
+    // It may have been taken in the meantime, but then we'll just go around again
+    return best && popTask(*best,task);
+}
+
+void TaskScheduler::workerMain(size_t which)
+{
+    curScheduler = this;
+    curWorker = which;
+
+    ThreadFunc threadStartFn,threadStopFn;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        threadStartFn = startFn;
+        threadStopFn = stopFn;
+    }
+    if (threadStartFn)
+        threadStartFn();
+
+    while (!stopping)
+    {
+        Task task;
+        if (takeTask(which,task))
+        {
+            task.func(task.cancel && *task.cancel);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> uniqueLock(lock);
+        wakeCond.wait(uniqueLock,[this]{ return stopping || numQueued > 0; });
+    }
+
+    if (threadStopFn)
+        threadStopFn();
+
+    curScheduler = nullptr;
+}
+
+}
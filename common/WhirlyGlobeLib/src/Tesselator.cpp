@@ -17,8 +17,13 @@
  */
 
 #import <list>
+#import <memory>
+#import <algorithm>
+#import <cmath>
+#import <cstring>
 #include "glues.h"
 #import "Tesselator.h"
+#import "PerformanceTimer.h"
 
 using namespace Eigen;
 
@@ -35,23 +40,236 @@ typedef struct
     bool newVert;
 } TriangulationInfo;
 
-static void* stdAlloc(void* userData, unsigned int size)
+namespace {
+
+// Bump allocator for libtess.  Frees are ignored and the whole thing is reset after each polygon,
+//  so we're not calling malloc for every edge and vertex.  Once it's seen a polygon of a given size,
+//  the next one like it won't allocate at all.
+class TessArena
+{
+public:
+    void *alloc(size_t size)
+    {
+        // Each allocation remembers its size so we can do realloc
+        const size_t total = Header + ((size + Align - 1) & ~(Align - 1));
+        for (; cur < chunks.size(); cur++)
+        {
+            auto &chunk = chunks[cur];
+            if (chunk.used + total <= chunk.size)
+            {
+                return place(chunk,total,size);
+            }
+        }
+        const size_t chunkSize = std::max(total,ChunkSize);
+        chunks.push_back(Chunk { std::unique_ptr<uint8_t[]>(new uint8_t[chunkSize]), chunkSize, 0 });
+        cur = chunks.size() - 1;
+        return place(chunks.back(),total,size);
+    }
+
+    void *realloc(void *ptr,size_t size)
+    {
+        if (!ptr)
+            return alloc(size);
+        const size_t oldSize = *(size_t *)((uint8_t *)ptr - Header);
+        if (size <= oldSize)
+            return ptr;
+
+        // The last thing allocated can just grow
+        if (cur < chunks.size())
+        {
+            auto &chunk = chunks[cur];
+            const size_t newTotal = (size + Align - 1) & ~(Align - 1);
+            if ((uint8_t *)ptr + ((oldSize + Align - 1) & ~(Align - 1)) == chunk.data.get() + chunk.used &&
+                (size_t)((uint8_t *)ptr - chunk.data.get()) + newTotal <= chunk.size)
+            {
+                chunk.used = ((uint8_t *)ptr - chunk.data.get()) + newTotal;
+                *(size_t *)((uint8_t *)ptr - Header) = size;
+                return ptr;
+            }
+        }
+
+        void *newPtr = alloc(size);
+        memcpy(newPtr,ptr,oldSize);
+        return newPtr;
+    }
+
+    // Toss everything, but hang on to a reasonable amount of memory for next time
+    void reset()
+    {
+        size_t used = 0;
+        for (const auto &chunk : chunks)
+            used += chunk.used;
+
+        if (chunks.size() > 1 && used <= MaxKept)
+        {
+            // Consolidate, so a polygon like the last one fits in one go
+            const size_t chunkSize = ((used + ChunkSize - 1) / ChunkSize) * ChunkSize;
+            chunks.clear();
+            chunks.push_back(Chunk { std::unique_ptr<uint8_t[]>(new uint8_t[chunkSize]), chunkSize, 0 });
+        }
+        else if (!chunks.empty())
+        {
+            chunks.resize((chunks[0].size <= MaxKept) ? 1 : 0);
+            if (!chunks.empty())
+                chunks[0].used = 0;
+        }
+        cur = 0;
+    }
+
+    static void *tessAlloc(void *userData,unsigned int size) { return ((TessArena *)userData)->alloc(size); }
+    static void *tessRealloc(void *userData,void *ptr,unsigned int size) { return ((TessArena *)userData)->realloc(ptr,size); }
+    static void tessFree(void *userData,void *ptr) { }
+
+protected:
+    static constexpr size_t Align = 16;
+    static constexpr size_t Header = Align;
+    static constexpr size_t ChunkSize = 256 * 1024;
+    static constexpr size_t MaxKept = 4 * 1024 * 1024;
+
+    struct Chunk
+    {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+        size_t used;
+    };
+
+    static void *place(Chunk &chunk,size_t total,size_t size)
+    {
+        uint8_t *ptr = chunk.data.get() + chunk.used + Header;
+        *(size_t *)(ptr - Header) = size;
+        chunk.used += total;
+        return ptr;
+    }
+
+    std::vector<Chunk> chunks;
+    size_t cur = 0;
+};
+
+thread_local TessArena tessArena;
+thread_local std::vector<TESSreal> tessRing;
+
+// Bucket sizes for libtess's internal pools, so small polygons don't grab much and big ones don't grab often
+inline int tessBucketSize(size_t count)
 {
-  TESS_NOTUSED(userData);
-  return malloc(size);
+    return (int)std::max((size_t)16,std::min(count,(size_t)4096));
 }
 
-static void stdFree(void* userData, void* ptr)
+// Past this, ear clipping loses out to libtess
+constexpr size_t MaxEarClipPoints = 64;
+
+inline double cross(const Point2d &a,const Point2d &b,const Point2d &c)
 {
-  TESS_NOTUSED(userData);
-  free(ptr);
+    return (b.x() - a.x()) * (c.y() - a.y()) - (b.y() - a.y()) * (c.x() - a.x());
 }
 
+inline bool insideTriangle(const Point2d &a,const Point2d &b,const Point2d &c,const Point2d &p)
+{
+    return cross(a,b,p) >= 0 && cross(b,c,p) >= 0 && cross(c,a,p) >= 0;
+}
+
+/** Ear clip a single ring with no holes.
+    Returns false if the ring is too big or doesn't look simple, in which case
+    nothing is added and the caller should use libtess.
+  */
+bool EarClipRing(const VectorRing &ring,VectorTriangles &tris)
+{
+    // Relative to the first point, in double, skipping duplicates and the closing point
+    const Point2f &org = ring[0];
+    std::vector<Point2d> pts;
+    std::vector<int> src;
+    pts.reserve(std::min(ring.size(),MaxEarClipPoints + 1));
+    for (size_t ii = 0; ii < ring.size(); ii++)
+    {
+        const Point2f &pt = ring[ii];
+        if ((ii > 0 && pt == ring[ii-1]) || (ii == ring.size() - 1 && pt == ring[0]))
+            continue;
+        if (pts.size() >= MaxEarClipPoints)
+            return false;
+        pts.emplace_back(pt.x() - org.x(),pt.y() - org.y());
+        src.push_back((int)ii);
+    }
+    const int n = (int)pts.size();
+    if (n < 3)
+        return false;
+
+    // Work counter-clockwise
+    double area = 0.0;
+    for (int ii = 0; ii < n; ii++)
+    {
+        const Point2d &p0 = pts[ii], &p1 = pts[(ii + 1) % n];
+        area += p0.x() * p1.y() - p1.x() * p0.y();
+    }
+    if (area == 0.0)
+        return false;
+    std::vector<int> idx(n);
+    for (int ii = 0; ii < n; ii++)
+        idx[ii] = (area > 0) ? ii : (n - 1 - ii);
+
+    // A ring that winds around more than once isn't simple
+    double turning = 0.0;
+    for (int ii = 0; ii < n; ii++)
+    {
+        const Point2d &p0 = pts[idx[(ii + n - 1) % n]], &p1 = pts[idx[ii]], &p2 = pts[idx[(ii + 1) % n]];
+        const Point2d d0 = p1 - p0, d1 = p2 - p1;
+        turning += atan2(d0.x() * d1.y() - d0.y() * d1.x(), d0.dot(d1));
+    }
+    if (std::abs(turning - 2 * M_PI) > 1e-3)
+        return false;
+
+    std::vector<VectorTriangles::Triangle> newTris;
+    newTris.reserve(n - 2);
+    const int startPt = (int)tris.pts.size();
+    while (idx.size() > 3)
+    {
+        const int m = (int)idx.size();
+        bool found = false;
+        for (int ii = 0; ii < m && !found; ii++)
+        {
+            const int i0 = idx[(ii + m - 1) % m], i1 = idx[ii], i2 = idx[(ii + 1) % m];
+            const Point2d &a = pts[i0], &b = pts[i1], &c = pts[i2];
+            if (cross(a,b,c) <= 0)
+                continue;
+
+            // Nothing else can be in the ear
+            bool empty = true;
+            for (int jj = 0; jj < m && empty; jj++)
+            {
+                const int ij = idx[jj];
+                if (ij != i0 && ij != i1 && ij != i2 && pts[ij] != a && pts[ij] != b && pts[ij] != c)
+                    empty = !insideTriangle(a,b,c,pts[ij]);
+            }
+            if (!empty)
+                continue;
+
+            newTris.push_back(VectorTriangles::Triangle { { startPt + i0, startPt + i1, startPt + i2 } });
+            idx.erase(idx.begin() + ii);
+            found = true;
+        }
+        if (!found)
+            return false;
+    }
+    newTris.push_back(VectorTriangles::Triangle { { startPt + idx[0], startPt + idx[1], startPt + idx[2] } });
+
+    tris.pts.reserve(tris.pts.size() + n);
+    for (int ii = 0; ii < n; ii++)
+    {
+        const Point2f &pt = ring[src[ii]];
+        tris.pts.emplace_back(pt.x(),pt.y(),0.0f);
+    }
+    tris.tris.insert(tris.tris.end(),newTris.begin(),newTris.end());
+
+    return true;
+}
+
+}
 
 static const float PolyScale2 = 1e6;
     
 void TesselateRing(const WhirlyKit::VectorRing &ring,VectorTrianglesRef tris)
 {
+    if (ring.empty() || EarClipRing(ring, *tris))
+        return;
+
     std::vector<VectorRing> rings(1);
     rings[0] = ring;
     TesselateLoops(rings, tris);
@@ -63,25 +281,45 @@ void TesselateLoops(const std::vector<VectorRing> &loops,VectorTrianglesRef tris
         return;
     if (loops[0].size() < 1)
         return;
+    if (loops.size() == 1 && EarClipRing(loops[0], *tris))
+        return;
     
     static const int vertexSize = 2;
     static const int stride = sizeof(TESSreal) * vertexSize;
     static const int verticesPerTriangle = 3;
   
-    TESSalloc ma;
+    size_t numVerts = 0;
+    for (const auto &loop : loops)
+        numVerts += loop.size();
 
-    ma.memalloc = stdAlloc;
-    ma.memfree = stdFree;
-    ma.extraVertices = 256; // realloc not provided, allow 256 extra vertic
+    TESSalloc ma = {};
+
+    ma.memalloc = TessArena::tessAlloc;
+    ma.memrealloc = TessArena::tessRealloc;
+    ma.memfree = TessArena::tessFree;
+    ma.userData = &tessArena;
+    ma.meshEdgeBucketSize = tessBucketSize(numVerts * 2);
+    ma.meshVertexBucketSize = tessBucketSize(numVerts);
+    ma.meshFaceBucketSize = tessBucketSize(numVerts / 2);
+    ma.dictNodeBucketSize = tessBucketSize(numVerts);
+    ma.regionBucketSize = tessBucketSize(numVerts / 2);
+    // Room for the vertices added at intersections, realloc covers anything past this
+    ma.extraVertices = (int)std::max((size_t)16,numVerts / 8);
 
     TESStesselator *tess = tessNewTess(&ma);
+    if (!tess)
+    {
+        tessArena.reset();
+        return;
+    }
     
     Point2f org = (loops[0])[0];
     for (unsigned int li=0;li<loops.size();li++)
     {
         
         const VectorRing &ring = loops[li];
-        std::vector<TESSreal> tessRing;
+        tessRing.clear();
+        tessRing.reserve(ring.size() * 2);
         for (unsigned int ii=0;ii<ring.size();ii++)
         {
             const Point2f &pt = ring[ii];
@@ -105,6 +343,8 @@ void TesselateLoops(const std::vector<VectorRing> &loops,VectorTrianglesRef tris
     const float* verts = tessGetVertices(tess);
     const int* elems = tessGetElements(tess);
     const int nelems = tessGetElementCount(tess);
+    tris->pts.reserve(tris->pts.size() + nelems * verticesPerTriangle);
+    tris->tris.reserve(tris->tris.size() + nelems);
 
     for (int i = 0; i < nelems; i++)
     {
@@ -136,6 +376,7 @@ void TesselateLoops(const std::vector<VectorRing> &loops,VectorTrianglesRef tris
     }
  
     tessDeleteTess(tess);
+    tessArena.reset();
     
     // Convert to triangles
     //    printf("  ");
@@ -175,4 +416,32 @@ void TesselateLoops(const std::vector<VectorRing> &loops,VectorTrianglesRef tris
 //    }
 }
 
+void TesselateLoopsBatch(const std::vector<const std::vector<VectorRing> *> &loopSets,
+                         std::vector<VectorTrianglesRef> &tris,WorkerPool *workers)
+{
+    WKTraceScope("Tesselate batch");
+
+    tris.resize(loopSets.size());
+    const auto tessRange = [&](size_t start,size_t end)
+    {
+        for (size_t ii = start; ii < end; ii++)
+        {
+            tris[ii] = VectorTriangles::createTriangles();
+            if (loopSets[ii])
+            {
+                TesselateLoops(*loopSets[ii], tris[ii]);
+            }
+        }
+    };
+
+    if (workers && loopSets.size() > 1)
+    {
+        workers->parallelFor(loopSets.size(), 16, tessRange);
+    }
+    else
+    {
+        tessRange(0, loopSets.size());
+    }
+}
+
 }
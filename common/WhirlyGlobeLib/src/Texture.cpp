@@ -18,6 +18,7 @@
 
 #import "Texture.h"
 #import "WhirlyKitLog.h"
+#import "StableBytes.h"
 
 using namespace WhirlyKit;
 using namespace Eigen;
@@ -250,25 +251,83 @@ TextureBase::~TextureBase()
 }
 
 Texture::Texture()
-: TextureBase(), isPVRTC(false), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(TexTypeUnsignedByte), byteSource(WKSingleRGB), interpType(TexInterpLinear), isEmptyTexture(false)
+: TextureBase(), isPVRTC(false), isCompressed(false), usesMipmaps(false), wrapU(false), wrapV(false), format(TexTypeUnsignedByte), byteSource(WKSingleRGB), interpType(TexInterpLinear), isEmptyTexture(false)
 {    
 }
 
 Texture::Texture(const std::string &name)
-	: TextureBase(name), isPVRTC(false), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(TexTypeUnsignedByte), byteSource(WKSingleRGB), interpType(TexInterpLinear), isEmptyTexture(false)
+	: TextureBase(name), isPVRTC(false), isCompressed(false), usesMipmaps(false), wrapU(false), wrapV(false), format(TexTypeUnsignedByte), byteSource(WKSingleRGB), interpType(TexInterpLinear), isEmptyTexture(false)
 {
 }
 
 // Construct with raw texture data
 Texture::Texture(const std::string &name,RawDataRef texData,bool isPVRTC)
-	: TextureBase(name), texData(texData), isPVRTC(isPVRTC), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(TexTypeUnsignedByte), byteSource(WKSingleRGB), interpType(TexInterpLinear), isEmptyTexture(false)
+	: TextureBase(name), texData(texData), isPVRTC(isPVRTC), isCompressed(false), usesMipmaps(false), wrapU(false), wrapV(false), format(TexTypeUnsignedByte), byteSource(WKSingleRGB), interpType(TexInterpLinear), isEmptyTexture(false)
 { 
 }
 
 Texture::~Texture()
 {
 }
+
+int TextureTypeBytesPerPixel(TextureType type)
+{
+    switch (type)
+    {
+        case TexTypeSingleChannel:
+            return 1;
+        case TexTypeShort565:
+        case TexTypeShort4444:
+        case TexTypeShort5551:
+        case TexTypeDoubleChannel:
+        case TexTypeSingleFloat16:
+        case TexTypeSingleInt16:
+            return 2;
+        case TexTypeDoubleFloat32:
+        case TexTypeQuadFloat16:
+        case TexTypeDoubleUInt32:
+            return 8;
+        case TexTypeQuadFloat32:
+        case TexTypeQuadUInt32:
+            return 16;
+        case TexTypeUnsignedByte:
+        case TexTypeSingleFloat32:
+        case TexTypeDoubleFloat16:
+        case TexTypeDepthFloat32:
+        case TexTypeSingleUInt32:
+        default:
+            return 4;
+    }
+}
+
+size_t Texture::getGPUBytes() const
+{
+    // Block compressed data goes up as is
+    if (isCompressed)
+        return compressedInfo.size;
+    if (isPVRTC)
+        return texData ? texData->getLen() : (size_t)width * height / 2;
+
+    const size_t bytes = (size_t)width * height * TextureTypeBytesPerPixel(format);
+    return usesMipmaps ? bytes * 4 / 3 : bytes;
+}
     
+uint64_t Texture::getContentHash() const
+{
+    if (!texData || isEmptyTexture)
+        return 0;
+
+    // The settings and then the pixels
+    const int settings[] = { (int)width, (int)height, (int)format, (int)byteSource, (int)interpType,
+                             isPVRTC, isCompressed, usesMipmaps, wrapU, wrapV };
+    uint64_t hash = StableHash(settings,sizeof(settings));
+
+    texData->willRead();
+    hash = StableHash(texData->getRawData(),texData->getLen(),hash);
+
+    return hash ? hash : 1;
+}
+
 void Texture::setRawData(RawData *rawData,int inWidth,int inHeight)
 {
     texData = RawDataRef(rawData);
@@ -281,7 +340,7 @@ RawDataRef Texture::processData()
     if (!texData)
         return NULL;
     
-	if (isPVRTC || isPKM)
+	if (isPVRTC || isCompressed)
 	{
         return texData;
 	} else {
@@ -325,8 +384,25 @@ RawDataRef Texture::processData()
     
 void Texture::setPKMData(RawDataRef inData)
 {
+    setCompressedData(inData);
+}
+
+bool Texture::setCompressedData(RawDataRef inData)
+{
+    if (!inData || !ParseCompressedImage(*inData,compressedInfo))
+    {
+        wkLogLevel(Warn,"Texture: Unrecognized compressed image for %s",name.c_str());
+        return false;
+    }
+
     texData = inData;
-    isPKM = true;
+    isCompressed = true;
+    width = compressedInfo.width;
+    height = compressedInfo.height;
+    // There's only the one level and we can't build the rest on the GPU
+    usesMipmaps = false;
+
+    return true;
 }
 
 }
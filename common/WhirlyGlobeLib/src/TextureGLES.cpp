@@ -38,85 +38,122 @@ TextureGLES::TextureGLES(const std::string &name,RawDataRef texData,bool isPVRTC
 {
 }
     
-// Figure out the PKM data
+// Figure out the compressed data
 unsigned char *TextureGLES::ResolvePKM(RawDataRef texData,int &pkmType,int &size,int &width,int &height)
 {
-    if (texData->getLen() < 16)
+    CompressedImageInfo info;
+    if (!texData || !ParseCompressedImage(*texData,info))
         return NULL;
-    const unsigned char *header = (const unsigned char *)texData->getRawData();
-    //    unsigned short *version = (unsigned short *)&header[4];
-    const unsigned char *type = &header[7];
-    
-    // Verify the magic number
-    if (strncmp((char *)header, "PKM ", 4))
+
+    const GLenum glType = CompressedFormatGL(info);
+    if (!glType)
         return NULL;
-    
-    width = (header[8] << 8) | header[9];
-    height = (header[10] << 8) | header[11];;
-    
-    // Resolve the GL type
-    int glType = -1;
-    switch (*type)
+    pkmType = (int)glType;
+    size = (int)info.size;
+    width = info.width;
+    height = info.height;
+
+    return (unsigned char *)texData->getRawData() + info.offset;
+}
+
+GLenum TextureGLES::CompressedFormatGL(const CompressedImageInfo &info)
+{
+    switch (info.format)
     {
-        case 0:
-            // ETC1 not supported
-            break;
-        case 1:
-            glType = GL_COMPRESSED_RGB8_ETC2;
-            size = width * height / 2;
-            break;
-        case 2:
-            // Unused
-            break;
-        case 3:
-            glType = GL_COMPRESSED_RGBA8_ETC2_EAC;
-            size = width * height;
+        case CompressedETC2_RGB8:
+            return info.sRGB ? GL_COMPRESSED_SRGB8_ETC2 : GL_COMPRESSED_RGB8_ETC2;
+        case CompressedETC2_RGB8A1:
+            return info.sRGB ? GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2 : GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+        case CompressedETC2_RGBA8:
+            return info.sRGB ? GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC : GL_COMPRESSED_RGBA8_ETC2_EAC;
+        case CompressedEAC_R11:
+            return GL_COMPRESSED_R11_EAC;
+        case CompressedEAC_R11Signed:
+            return GL_COMPRESSED_SIGNED_R11_EAC;
+        case CompressedEAC_RG11:
+            return GL_COMPRESSED_RG11_EAC;
+        case CompressedEAC_RG11Signed:
+            return GL_COMPRESSED_SIGNED_RG11_EAC;
+        case CompressedASTC:
+        {
+            // Not every header has the KHR constants, but they're in block size order
+            const int which = info.astcBlockIndex();
+            if (!hasASTCSupport || which < 0)
+                return 0;
+            return (info.sRGB ? 0x93D0 : 0x93B0) + which;
+        }
+        case CompressedNone:
+        default:
+            return 0;
+    }
+}
+
+bool TextureGLES::getStorageKey(OpenGLMemManager::TexStorageKey &key,size_t &bytes) const
+{
+    if (isPVRTC || isCompressed || width <= 0 || height <= 0)
+        return false;
+
+    size_t pixSize = 0;
+    switch (format)
+    {
+        case TexTypeUnsignedByte:
+            key.internalFormat = GL_RGBA;  key.format = GL_RGBA;  key.type = GL_UNSIGNED_BYTE;
+            pixSize = 4;
             break;
-        case 4:
-            glType = GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
-            size = width * height / 2;
+        case TexTypeShort565:
+            key.internalFormat = GL_RGB;  key.format = GL_RGB;  key.type = GL_UNSIGNED_SHORT_5_6_5;
+            pixSize = 2;
             break;
-        case 5:
-            glType = GL_COMPRESSED_R11_EAC;
-            size = width * height / 2;
+        case TexTypeShort4444:
+            key.internalFormat = GL_RGBA;  key.format = GL_RGBA;  key.type = GL_UNSIGNED_SHORT_4_4_4_4;
+            pixSize = 2;
             break;
-        case 6:
-            glType = GL_COMPRESSED_RG11_EAC;
-            size = width * height;
+        case TexTypeShort5551:
+            key.internalFormat = GL_RGBA;  key.format = GL_RGBA;  key.type = GL_UNSIGNED_SHORT_5_5_5_1;
+            pixSize = 2;
             break;
-        case 7:
-            glType = GL_COMPRESSED_SIGNED_R11_EAC;
-            size = width * height / 2;
+        case TexTypeSingleChannel:
+            key.internalFormat = GL_ALPHA;  key.format = GL_ALPHA;  key.type = GL_UNSIGNED_BYTE;
+            pixSize = 1;
             break;
-        case 8:
-            glType = GL_COMPRESSED_SIGNED_RG11_EAC;
-            size = width * height;
+        case TexTypeDoubleChannel:
+            key.internalFormat = GL_RG8;  key.format = GL_RG;  key.type = GL_UNSIGNED_BYTE;
+            pixSize = 2;
             break;
+        default:
+            return false;
     }
-    if (glType == -1)
-        return NULL;
-    pkmType = glType;
-    
-    return (unsigned char*)&header[16];
+    key.width = width;
+    key.height = height;
+    key.mipmaps = usesMipmaps;
+
+    bytes = (size_t)width * height * pixSize;
+    // The mip chain adds about a third
+    if (usesMipmaps)
+        bytes += bytes / 3;
+
+    return true;
 }
 
-// Define the texture in OpenGL
-bool TextureGLES::createInRenderer(const RenderSetupInfo *inSetupInfo)
+// Allocate (or reuse) a texture ID, bind it, and set up the various params
+bool TextureGLES::bindNewTexture(RenderSetupInfoGLES *setupInfo,bool canPool,const OpenGLMemManager::TexStorageKey &key)
 {
-    RenderSetupInfoGLES *setupInfo = (RenderSetupInfoGLES *)inSetupInfo;
-    
-    if (!texData && !isEmptyTexture)
-        return false;
-    
-    // We'll only create this once
-    if (glId)
-        return true;
-    
-    // Allocate a texture and set up the various params
-    if (setupInfo && setupInfo->memManager)
-        glId = setupInfo->memManager->getTexID();
-    else
-        glGenTextures(1, &glId);
+    // Tile imagery tends to come in the same few sizes, so see if there's
+    //  already storage we can fill rather than allocating more
+    bool reuseStorage = false;
+    if (canPool)
+    {
+        glId = setupInfo->memManager->getSizedTexID(key);
+        reuseStorage = (glId != 0);
+    }
+
+    if (!glId)
+    {
+        if (setupInfo && setupInfo->memManager)
+            glId = setupInfo->memManager->getTexID();
+        else
+            glGenTextures(1, &glId);
+    }
     CheckGLError("Texture::createInGL() glGenTextures()");
     
     glBindTexture(GL_TEXTURE_2D, glId);
@@ -137,7 +174,121 @@ bool TextureGLES::createInRenderer(const RenderSetupInfo *inSetupInfo)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, (wrapV ? GL_REPEAT : GL_CLAMP_TO_EDGE));
     
     CheckGLError("Texture::createInGL() glTexParameteri()");
+
+    return reuseStorage;
+}
+
+// Copy the data into a pixel buffer so the render thread only has to kick off the copy
+bool TextureGLES::stageUpload(RenderSetupInfoGLES *setupInfo)
+{
+    RawDataRef convertedData = processData();
+    if (!convertedData || convertedData->getLen() == 0)
+        return false;
+    const size_t len = convertedData->getLen();
+
+    pboId = setupInfo->memManager->getBufferID();
+    if (!pboId)
+        return false;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pboId);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)len, nullptr, GL_STREAM_DRAW);
+    void *glMem = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)len,
+                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (glMem)
+    {
+        memcpy(glMem, convertedData->getRawData(), len);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    CheckGLError("Texture::stageUpload()");
+
+    if (!glMem)
+    {
+        setupInfo->memManager->removeBufferID(pboId);
+        pboId = 0;
+        return false;
+    }
+
+    // We may be on another context, so the render thread will need to wait on this
+    uploadFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    texData.reset();
+    return true;
+}
+
+void TextureGLES::finishUploadInRenderer(SceneRenderer *renderer)
+{
+    if (!pboId)
+        return;
+
+    RenderSetupInfoGLES *setupInfo = (RenderSetupInfoGLES *)renderer->getRenderSetupInfo();
+
+    // Server side wait, so this doesn't block us
+    if (uploadFence)
+    {
+        glWaitSync(uploadFence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(uploadFence);
+        uploadFence = nullptr;
+    }
+
+    const bool reuseStorage = bindNewTexture(setupInfo,true,storageKey);
+
+    // With a pixel buffer bound, the data pointer is an offset into it
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pboId);
+    if (reuseStorage)
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, storageKey.format, storageKey.type, nullptr);
+    }
+    else
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, storageKey.internalFormat, width, height, 0,
+                     storageKey.format, storageKey.type, nullptr);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    CheckGLError("Texture::finishUploadInRenderer()");
+
+    if (usesMipmaps)
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+    setupInfo->memManager->removeBufferID(pboId);
+    pboId = 0;
+    pooled = true;
+}
+
+// Define the texture in OpenGL
+bool TextureGLES::createInRenderer(const RenderSetupInfo *inSetupInfo)
+{
+    RenderSetupInfoGLES *setupInfo = (RenderSetupInfoGLES *)inSetupInfo;
     
+    // We'll only create this once
+    if (glId || pboId)
+        return true;
+
+    if (!texData && !isEmptyTexture)
+        return false;
+
+    if (isCompressed && !CompressedFormatGL(compressedInfo))
+    {
+        wkLogLevel(Warn,"TextureGLES: Compressed format %d isn't supported here for %s",
+                   (int)compressedInfo.format,name.c_str());
+        return false;
+    }
+
+    OpenGLMemManager::TexStorageKey key;
+    size_t keyBytes = 0;
+    const bool canPool = setupInfo && setupInfo->memManager && getStorageKey(key,keyBytes);
+
+    // Pixel buffers need GLES 3 and buffer mapping
+    if (asyncUpload && canPool && texData && setupInfo->glesVersion >= 3 && hasMapBufferSupport)
+    {
+        storageKey = key;
+        storageBytes = keyBytes;
+        if (stageUpload(setupInfo))
+            return true;
+    }
+
+    const bool reuseStorage = bindNewTexture(setupInfo,canPool,key);
+
     RawDataRef convertedData = processData();
     
     // If it's in an optimized form, we can use that more efficiently
@@ -149,13 +300,20 @@ bool TextureGLES::createInRenderer(const RenderSetupInfo *inSetupInfo)
         glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG, width, height, 0, (GLsizei)convertedData->getLen(), convertedData->getRawData());
         CheckGLError("Texture::createInGL() glCompressedTexImage2D()");
 #endif
-    } else if (isPKM)
+    } else if (isCompressed)
     {
-        int compressedType,size;
-        int thisWidth,thisHeight;
-        unsigned char *rawData = ResolvePKM(texData,compressedType,size,thisWidth,thisHeight);
-        glCompressedTexImage2D(GL_TEXTURE_2D, 0, compressedType, width, height, 0, size, rawData);
+        // Straight from the file, past the header
+        glCompressedTexImage2D(GL_TEXTURE_2D, 0, CompressedFormatGL(compressedInfo),
+                               compressedInfo.width, compressedInfo.height, 0,
+                               (GLsizei)compressedInfo.size, texData->getRawData() + compressedInfo.offset);
         CheckGLError("Texture::createInGL() glCompressedTexImage2D()");
+    } else if (reuseStorage) {
+        // Same size and format, so just replace the contents
+        if (convertedData)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, key.format, key.type, convertedData->getRawData());
+            CheckGLError("Texture::createInGL() glTexSubImage2D()");
+        }
     } else {
         // Depending on the format, we may need to mess around with the bytes
         switch (format)
@@ -202,6 +360,14 @@ bool TextureGLES::createInRenderer(const RenderSetupInfo *inSetupInfo)
     
     if (usesMipmaps)
         glGenerateMipmap(GL_TEXTURE_2D);
+
+    // When this goes away the storage can go back in the pool
+    pooled = canPool;
+    if (pooled)
+    {
+        storageKey = key;
+        storageBytes = keyBytes;
+    }
     
     // Once we've moved it over to OpenGL, let's get rid of this copy
     texData.reset();
@@ -215,7 +381,26 @@ void TextureGLES::destroyInRenderer(const RenderSetupInfo *inSetupInfo,Scene *sc
     RenderSetupInfoGLES *setupInfo = (RenderSetupInfoGLES *)inSetupInfo;
 
     if (glId)
-        setupInfo->memManager->removeTexID(glId);
+    {
+        if (pooled)
+            setupInfo->memManager->removeSizedTexID(storageKey,glId,storageBytes);
+        else
+            setupInfo->memManager->removeTexID(glId);
+    }
+    glId = 0;
+    pooled = false;
+
+    // Staged, but never made it to the renderer
+    if (uploadFence)
+    {
+        glDeleteSync(uploadFence);
+        uploadFence = nullptr;
+    }
+    if (pboId)
+    {
+        setupInfo->memManager->removeBufferID(pboId);
+        pboId = 0;
+    }
 }
 
 }
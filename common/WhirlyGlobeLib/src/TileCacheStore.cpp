@@ -0,0 +1,760 @@
+/*  TileCacheStore.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <cstdio>
+#import <cstring>
+#import <ctime>
+#import <algorithm>
+#import <cstdint>
+#import <fcntl.h>
+#import <unistd.h>
+#import <dirent.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import "TileCacheStore.h"
+#import "StableBytes.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    const char FileMagic[4] = { 'W', 'K', 'T', 'C' };
+    const uint32_t FileVersion = 1;
+    const uint32_t RecordMagic = 0x52544b57;
+
+    // Magic, hash, key and data lengths, then when it was written
+    const size_t RecordHeaderSize = 4 + 8 + 4 + 4 + 4;
+    // Packs are started fresh past this, and the newest one is mapped at this size
+    const uint32_t PackSize = 16 * 1024 * 1024;
+    const uint32_t InitialSlots = 4096;
+    // Grow the index when it's this full, counting removed entries
+    const double MaxLoad = 0.7;
+
+    uint32_t timeNow()
+    {
+        return (uint32_t)time(nullptr);
+    }
+
+    // A pack record, as read back out of a mapping
+    struct Record
+    {
+        uint64_t hash;
+        uint32_t keyLen,dataLen,written;
+    };
+
+    bool readRecord(const unsigned char *addr,size_t fileLen,size_t offset,Record &rec)
+    {
+        if (offset + RecordHeaderSize > fileLen)
+            return false;
+        const unsigned char *ptr = addr + offset;
+        if (GetRecordValue<uint32_t>(ptr) != RecordMagic)
+            return false;
+        rec.hash = GetRecordValue<uint64_t>(ptr);
+        rec.keyLen = GetRecordValue<uint32_t>(ptr);
+        rec.dataLen = GetRecordValue<uint32_t>(ptr);
+        rec.written = GetRecordValue<uint32_t>(ptr);
+        return offset + RecordHeaderSize + rec.keyLen + rec.dataLen <= fileLen;
+    }
+
+    void makeDirs(const std::string &dir)
+    {
+        for (size_t pos = dir.find('/',1); ; pos = dir.find('/',pos + 1))
+        {
+            mkdir(dir.substr(0,pos).c_str(),0755);
+            if (pos == std::string::npos)
+                break;
+        }
+    }
+}
+
+TileCacheStore::PackMap::~PackMap()
+{
+    if (addr)
+    {
+        munmap((void *)addr,mapLen);
+    }
+}
+
+TileCacheStore::TileCacheStore(std::string inDir) :
+    dir(std::move(inDir)),
+    maxSize(0),
+    lifetime(0.0),
+    valid(false),
+    indexFD(-1),
+    indexAddr(nullptr),
+    indexLen(0),
+    header(nullptr),
+    slots(nullptr),
+    packFD(-1),
+    packLen(0)
+{
+    if (!dir.empty() && dir.back() != '/')
+    {
+        dir += '/';
+    }
+
+    std::lock_guard<std::mutex> guardLock(lock);
+    valid = openIndex();
+    if (!valid)
+    {
+        wkLogLevel(Warn,"TileCacheStore: Can't set up cache in %s",dir.c_str());
+    }
+}
+
+TileCacheStore::~TileCacheStore()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    closeIndex();
+}
+
+TileCacheStoreRef TileCacheStore::getShared(const std::string &dir)
+{
+    static std::mutex sharedLock;
+    static std::unordered_map<std::string,std::weak_ptr<TileCacheStore>> stores;
+
+    std::lock_guard<std::mutex> guardLock(sharedLock);
+    auto store = stores[dir].lock();
+    if (!store)
+    {
+        store = std::make_shared<TileCacheStore>(dir);
+        stores[dir] = store;
+    }
+    return store;
+}
+
+std::string TileCacheStore::packName(uint32_t pack) const
+{
+    char name[32];
+    snprintf(name,sizeof(name),"pack_%08x",pack);
+    return dir + name;
+}
+
+bool TileCacheStore::openIndex()
+{
+    makeDirs(dir);
+
+    indexFD = open((dir + "index").c_str(),O_RDWR | O_CREAT,0644);
+    if (indexFD < 0)
+    {
+        return false;
+    }
+
+    // Make sure it's ours and all there
+    struct stat indexStat {};
+    if (fstat(indexFD,&indexStat) == 0 && indexStat.st_size >= (off_t)sizeof(IndexHeader))
+    {
+        indexLen = (size_t)indexStat.st_size;
+        indexAddr = mmap(nullptr,indexLen,PROT_READ | PROT_WRITE,MAP_SHARED,indexFD,0);
+        if (indexAddr == MAP_FAILED)
+        {
+            indexAddr = nullptr;
+            indexLen = 0;
+        }
+        else
+        {
+            header = (IndexHeader *)indexAddr;
+            slots = (IndexSlot *)((unsigned char *)indexAddr + sizeof(IndexHeader));
+            if (memcmp(header->magic,FileMagic,4) != 0 || header->version != FileVersion ||
+                header->numSlots == 0 || header->firstPack > header->lastPack ||
+                indexLen != sizeof(IndexHeader) + (size_t)header->numSlots * sizeof(IndexSlot))
+            {
+                munmap(indexAddr,indexLen);
+                indexAddr = nullptr;
+                indexLen = 0;
+                header = nullptr;
+                slots = nullptr;
+            }
+        }
+    }
+
+    if (!header)
+    {
+        if (indexStat.st_size > 0)
+        {
+            wkLogLevel(Warn,"TileCacheStore: Rebuilding index in %s",dir.c_str());
+        }
+        if (!rebuildIndex())
+        {
+            return false;
+        }
+    }
+
+    // Packs are the truth about how much space we use
+    header->totalSize = 0;
+    for (uint32_t pack = header->firstPack; pack <= header->lastPack; pack++)
+    {
+        struct stat packStat;
+        if (stat(packName(pack).c_str(),&packStat) == 0)
+        {
+            header->totalSize += packStat.st_size;
+        }
+    }
+
+    return startPack(header->lastPack);
+}
+
+void TileCacheStore::closeIndex()
+{
+    if (packFD >= 0)
+    {
+        close(packFD);
+        packFD = -1;
+    }
+    if (indexAddr)
+    {
+        munmap(indexAddr,indexLen);
+        indexAddr = nullptr;
+        indexLen = 0;
+    }
+    header = nullptr;
+    slots = nullptr;
+    if (indexFD >= 0)
+    {
+        close(indexFD);
+        indexFD = -1;
+    }
+    packMaps.clear();
+    valid = false;
+}
+
+bool TileCacheStore::createIndex(uint32_t numSlots)
+{
+    if (indexAddr)
+    {
+        munmap(indexAddr,indexLen);
+        indexAddr = nullptr;
+        header = nullptr;
+        slots = nullptr;
+    }
+
+    indexLen = sizeof(IndexHeader) + (size_t)numSlots * sizeof(IndexSlot);
+    // Truncating first clears out the old contents
+    if (ftruncate(indexFD,0) != 0 || ftruncate(indexFD,(off_t)indexLen) != 0)
+    {
+        indexLen = 0;
+        return false;
+    }
+    indexAddr = mmap(nullptr,indexLen,PROT_READ | PROT_WRITE,MAP_SHARED,indexFD,0);
+    if (indexAddr == MAP_FAILED)
+    {
+        indexAddr = nullptr;
+        indexLen = 0;
+        return false;
+    }
+
+    // The magic goes in once the contents are good
+    header = (IndexHeader *)indexAddr;
+    slots = (IndexSlot *)((unsigned char *)indexAddr + sizeof(IndexHeader));
+    header->version = FileVersion;
+    header->numSlots = numSlots;
+
+    return true;
+}
+
+bool TileCacheStore::rebuildIndex()
+{
+    // Find whatever packs are left
+    std::vector<uint32_t> packs;
+    if (DIR *dirp = opendir(dir.c_str()))
+    {
+        while (const struct dirent *ent = readdir(dirp))
+        {
+            unsigned int pack = 0;
+            char extra = 0;
+            if (strlen(ent->d_name) == 13 && sscanf(ent->d_name,"pack_%8x%c",&pack,&extra) == 1)
+            {
+                packs.push_back(pack);
+            }
+        }
+        closedir(dirp);
+    }
+    std::sort(packs.begin(),packs.end());
+
+    if (!createIndex(InitialSlots))
+    {
+        return false;
+    }
+    header->firstPack = packs.empty() ? 0 : packs.front();
+    header->lastPack = packs.empty() ? 0 : packs.back();
+
+    // Later records for the same key replace earlier ones
+    for (uint32_t pack : packs)
+    {
+        const PackMapRef packMap = mapPack(pack);
+        if (!packMap)
+        {
+            continue;
+        }
+        size_t offset = 0;
+        Record rec;
+        while (readRecord(packMap->addr,packMap->fileLen,offset,rec))
+        {
+            const std::string key((const char *)packMap->addr + offset + RecordHeaderSize,rec.keyLen);
+            if (!insertSlot(rec.hash,key,pack,(uint32_t)offset,rec.dataLen,rec.written,rec.written))
+            {
+                return false;
+            }
+            offset += RecordHeaderSize + rec.keyLen + rec.dataLen;
+        }
+    }
+    // Don't hang on to all of them
+    packMaps.clear();
+
+    memcpy(header->magic,FileMagic,4);
+    return true;
+}
+
+bool TileCacheStore::growIndex()
+{
+    // Removed entries fall out here too
+    std::vector<IndexSlot> oldSlots;
+    oldSlots.reserve(header->numEntries);
+    for (uint32_t ii=0;ii<header->numSlots;ii++)
+    {
+        if (slots[ii].state == SlotLive)
+        {
+            oldSlots.push_back(slots[ii]);
+        }
+    }
+
+    const IndexHeader oldHeader = *header;
+    uint32_t numSlots = oldHeader.numSlots;
+    while (oldSlots.size() + 1 > numSlots * MaxLoad / 2)
+    {
+        numSlots *= 2;
+    }
+    if (!createIndex(numSlots))
+    {
+        return false;
+    }
+    header->firstPack = oldHeader.firstPack;
+    header->lastPack = oldHeader.lastPack;
+    header->totalSize = oldHeader.totalSize;
+
+    // Keys were checked on the way in, so the hashes are enough to place them
+    for (const auto &slot : oldSlots)
+    {
+        for (uint32_t which = slot.hash % numSlots; ; which = (which + 1) % numSlots)
+        {
+            if (slots[which].state == SlotEmpty)
+            {
+                slots[which] = slot;
+                break;
+            }
+        }
+    }
+    header->numEntries = header->numUsed = (uint32_t)oldSlots.size();
+
+    // Only mark it good if it was good before, since we may be in the middle of a rebuild
+    memcpy(header->magic,oldHeader.magic,4);
+    return true;
+}
+
+bool TileCacheStore::readRecordKey(uint32_t pack,uint32_t offset,std::string &key,uint32_t &dataOffset)
+{
+    const PackMapRef packMap = mapPack(pack);
+    Record rec;
+    if (!packMap || !readRecord(packMap->addr,packMap->fileLen,offset,rec))
+    {
+        return false;
+    }
+    key.assign((const char *)packMap->addr + offset + RecordHeaderSize,rec.keyLen);
+    dataOffset = (uint32_t)(offset + RecordHeaderSize + rec.keyLen);
+    return true;
+}
+
+TileCacheStore::IndexSlot *TileCacheStore::findSlot(uint64_t hash,const std::string &key,bool forInsert)
+{
+    const uint32_t numSlots = header->numSlots;
+    IndexSlot *firstFree = nullptr;
+    std::string slotKey;
+    uint32_t dataOffset = 0;
+    uint32_t which = hash % numSlots;
+    for (uint32_t ii=0;ii<numSlots;ii++,which = (which + 1) % numSlots)
+    {
+        IndexSlot &slot = slots[which];
+        switch (slot.state)
+        {
+            case SlotEmpty:
+                return forInsert ? (firstFree ? firstFree : &slot) : nullptr;
+            case SlotRemoved:
+                if (!firstFree)
+                    firstFree = &slot;
+                break;
+            default:
+                // Different keys can have the same hash, so check the one in the pack
+                if (slot.hash == hash && readRecordKey(slot.pack,slot.offset,slotKey,dataOffset) && slotKey == key)
+                    return &slot;
+                break;
+        }
+    }
+
+    return forInsert ? firstFree : nullptr;
+}
+
+bool TileCacheStore::isExpired(const IndexSlot &slot,uint32_t now) const
+{
+    return lifetime > 0.0 && now > slot.written && (now - slot.written) > lifetime;
+}
+
+void TileCacheStore::removeSlot(IndexSlot *slot)
+{
+    slot->state = SlotRemoved;
+    header->numEntries--;
+}
+
+bool TileCacheStore::insertSlot(uint64_t hash,const std::string &key,uint32_t pack,uint32_t offset,uint32_t len,
+                                uint32_t written,uint32_t accessed)
+{
+    if (header->numUsed + 1 > header->numSlots * MaxLoad && !growIndex())
+    {
+        return false;
+    }
+
+    IndexSlot *slot = findSlot(hash,key,true);
+    if (!slot)
+    {
+        return false;
+    }
+    if (slot->state == SlotEmpty)
+    {
+        header->numUsed++;
+    }
+    if (slot->state != SlotLive)
+    {
+        header->numEntries++;
+    }
+
+    slot->hash = hash;
+    slot->pack = pack;
+    slot->offset = offset;
+    slot->len = len;
+    slot->written = written;
+    slot->accessed = accessed;
+    slot->state = SlotLive;
+
+    return true;
+}
+
+bool TileCacheStore::startPack(uint32_t pack)
+{
+    if (packFD >= 0)
+    {
+        close(packFD);
+    }
+    packFD = open(packName(pack).c_str(),O_RDWR | O_CREAT,0644);
+    if (packFD < 0)
+    {
+        return false;
+    }
+    struct stat packStat;
+    packLen = (fstat(packFD,&packStat) == 0) ? (uint32_t)packStat.st_size : 0;
+    header->lastPack = pack;
+
+    return true;
+}
+
+TileCacheStore::PackMapRef TileCacheStore::mapPack(uint32_t pack)
+{
+    const auto it = packMaps.find(pack);
+    if (it != packMaps.end())
+    {
+        return it->second;
+    }
+    if (pack < header->firstPack || pack > header->lastPack)
+    {
+        return PackMapRef();
+    }
+
+    const int fd = open(packName(pack).c_str(),O_RDONLY);
+    if (fd < 0)
+    {
+        return PackMapRef();
+    }
+    struct stat packStat;
+    if (fstat(fd,&packStat) != 0 || packStat.st_size == 0)
+    {
+        close(fd);
+        return PackMapRef();
+    }
+
+    // The newest pack is still being written, so leave room for it to grow
+    auto packMap = std::make_shared<PackMap>();
+    packMap->fileLen = (size_t)packStat.st_size;
+    packMap->mapLen = (pack == header->lastPack) ? std::max(packMap->fileLen,(size_t)PackSize) : packMap->fileLen;
+    void *addr = mmap(nullptr,packMap->mapLen,PROT_READ,MAP_SHARED,fd,0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return PackMapRef();
+    }
+    packMap->addr = (const unsigned char *)addr;
+
+    packMaps[pack] = packMap;
+    return packMap;
+}
+
+bool TileCacheStore::appendRecord(uint64_t hash,const std::string &key,const void *data,size_t len,uint32_t written,
+                                  uint32_t &pack,uint32_t &offset)
+{
+    const size_t recordLen = RecordHeaderSize + key.size() + len;
+    if (recordLen >= UINT32_MAX - PackSize)
+    {
+        return false;
+    }
+
+    // Big records get a pack to themselves
+    if (packLen > 0 && packLen + recordLen > PackSize)
+    {
+        if (!startPack(header->lastPack + 1))
+        {
+            return false;
+        }
+    }
+
+    // Put the whole thing together so it goes out in one write
+    std::vector<unsigned char> buf;
+    buf.reserve(recordLen);
+    PutRecordValue<uint32_t>(buf,RecordMagic);
+    PutRecordValue<uint64_t>(buf,hash);
+    PutRecordValue<uint32_t>(buf,(uint32_t)key.size());
+    PutRecordValue<uint32_t>(buf,(uint32_t)len);
+    PutRecordValue<uint32_t>(buf,written);
+    buf.insert(buf.end(),key.begin(),key.end());
+    buf.insert(buf.end(),(const unsigned char *)data,(const unsigned char *)data + len);
+
+    if (pwrite(packFD,buf.data(),buf.size(),packLen) != (ssize_t)buf.size())
+    {
+        wkLogLevel(Warn,"TileCacheStore: Failed to write to %s",packName(header->lastPack).c_str());
+        return false;
+    }
+
+    pack = header->lastPack;
+    offset = packLen;
+    packLen += (uint32_t)recordLen;
+    header->totalSize += recordLen;
+
+    const auto it = packMaps.find(pack);
+    if (it != packMaps.end())
+    {
+        if (packLen <= it->second->mapLen)
+        {
+            it->second->fileLen = packLen;
+        }
+        else
+        {
+            // Outgrew the mapping, so it'll be mapped again when needed
+            packMaps.erase(it);
+        }
+    }
+
+    return true;
+}
+
+void TileCacheStore::evictPacks()
+{
+    const uint32_t now = timeNow();
+    while (maxSize > 0 && header->totalSize > maxSize)
+    {
+        // Never throw out the one we're writing
+        if (header->firstPack == header->lastPack)
+        {
+            if (packLen == 0 || !startPack(header->lastPack + 1))
+            {
+                break;
+            }
+        }
+        const uint32_t evictPack = header->firstPack;
+        const PackMapRef packMap = mapPack(evictPack);
+
+        // Anything used since the next pack was started gets another chance
+        uint32_t cutoff = UINT32_MAX;
+        Record rec;
+        if (const PackMapRef nextMap = mapPack(evictPack + 1))
+        {
+            if (readRecord(nextMap->addr,nextMap->fileLen,0,rec))
+            {
+                cutoff = rec.written;
+            }
+        }
+
+        std::vector<IndexSlot *> keep;
+        for (uint32_t ii=0;ii<header->numSlots;ii++)
+        {
+            IndexSlot *slot = &slots[ii];
+            if (slot->state != SlotLive || slot->pack != evictPack)
+            {
+                continue;
+            }
+            if (packMap && slot->accessed > cutoff && !isExpired(*slot,now))
+            {
+                keep.push_back(slot);
+            }
+            else
+            {
+                removeSlot(slot);
+            }
+        }
+
+        // Most recently used first, and not so many that they'd push out the next pack
+        std::sort(keep.begin(),keep.end(),
+                  [](const IndexSlot *a,const IndexSlot *b) { return a->accessed > b->accessed; });
+        const size_t copyBudget = (maxSize > 0 ? std::min((size_t)PackSize,maxSize) : PackSize) / 2;
+        size_t copied = 0;
+        for (IndexSlot *slot : keep)
+        {
+            uint32_t newPack = 0, newOffset = 0;
+            if (copied + slot->len <= copyBudget &&
+                readRecord(packMap->addr,packMap->fileLen,slot->offset,rec))
+            {
+                const std::string key((const char *)packMap->addr + slot->offset + RecordHeaderSize,rec.keyLen);
+                const unsigned char *data = packMap->addr + slot->offset + RecordHeaderSize + rec.keyLen;
+                if (appendRecord(slot->hash,key,data,slot->len,slot->written,newPack,newOffset))
+                {
+                    slot->pack = newPack;
+                    slot->offset = newOffset;
+                    copied += slot->len;
+                    continue;
+                }
+            }
+            removeSlot(slot);
+        }
+
+        // Tiles we've handed out keep their mapping after this
+        packMaps.erase(evictPack);
+        struct stat packStat;
+        const std::string fileName = packName(evictPack);
+        if (stat(fileName.c_str(),&packStat) == 0)
+        {
+            header->totalSize -= std::min((uint64_t)packStat.st_size,header->totalSize);
+        }
+        unlink(fileName.c_str());
+        header->firstPack++;
+    }
+}
+
+void TileCacheStore::setMaxSize(size_t size)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    maxSize = size;
+    if (valid)
+    {
+        evictPacks();
+    }
+}
+
+void TileCacheStore::setLifetime(TimeInterval inLifetime)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    lifetime = inLifetime;
+}
+
+bool TileCacheStore::contains(const std::string &key)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    if (!valid)
+    {
+        return false;
+    }
+
+    const IndexSlot *slot = findSlot(StableHash(key),key,false);
+    return slot && !isExpired(*slot,timeNow());
+}
+
+RawDataRef TileCacheStore::find(const std::string &key)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    if (!valid)
+    {
+        return RawDataRef();
+    }
+
+    const uint32_t now = timeNow();
+    IndexSlot *slot = findSlot(StableHash(key),key,false);
+    if (!slot)
+    {
+        return RawDataRef();
+    }
+    if (isExpired(*slot,now))
+    {
+        removeSlot(slot);
+        return RawDataRef();
+    }
+
+    const PackMapRef packMap = mapPack(slot->pack);
+    const size_t dataOffset = slot->offset + RecordHeaderSize + key.size();
+    if (!packMap || dataOffset + slot->len > packMap->fileLen)
+    {
+        removeSlot(slot);
+        return RawDataRef();
+    }
+    slot->accessed = now;
+
+    // The data holds on to the mapping rather than freeing anything
+    return std::make_shared<RawDataWrapper>(packMap->addr + dataOffset,slot->len,
+                                            [packMap](const void *){});
+}
+
+bool TileCacheStore::add(const std::string &key,const void *data,size_t len)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    if (!valid)
+    {
+        return false;
+    }
+
+    const uint64_t hash = StableHash(key);
+    const uint32_t now = timeNow();
+    uint32_t pack = 0, offset = 0;
+    if (!appendRecord(hash,key,data,len,now,pack,offset) ||
+        !insertSlot(hash,key,pack,offset,(uint32_t)len,now,now))
+    {
+        return false;
+    }
+
+    evictPacks();
+    return true;
+}
+
+void TileCacheStore::remove(const std::string &key)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    if (!valid)
+    {
+        return;
+    }
+
+    if (IndexSlot *slot = findSlot(StableHash(key),key,false))
+    {
+        removeSlot(slot);
+    }
+}
+
+size_t TileCacheStore::getSize()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return valid ? (size_t)header->totalSize : 0;
+}
+
+int TileCacheStore::getNumTiles()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return valid ? (int)header->numEntries : 0;
+}
+
+}
@@ -0,0 +1,175 @@
+/*  TileFetchThrottle.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import "TileFetchThrottle.h"
+#import "Platform.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    // How much each answer moves the average time
+    const double Smoothing = 0.2;
+    // Rounds last at least this many answer times, and see this many answers per connection
+    const double RoundLength = 4.0;
+    const int RoundFetches = 4;
+    // What a timeout or an overloaded server does to the limit
+    const double FailBackoff = 0.75;
+    // A host we haven't heard from in this long doesn't count toward the overall rate
+    const TimeInterval RateLifetime = 30.0;
+}
+
+TileFetchThrottle::TileFetchThrottle(int minPerHost,int maxPerHost) :
+    minPerHost(1), maxPerHost(1)
+{
+    setLimits(minPerHost,maxPerHost);
+}
+
+void TileFetchThrottle::setLimits(int inMinPerHost,int inMaxPerHost)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    minPerHost = std::max(inMinPerHost,1);
+    maxPerHost = std::max(inMaxPerHost,minPerHost);
+    for (auto &it : hosts)
+        it.second.limit = std::min(std::max(it.second.limit,minPerHost),maxPerHost);
+}
+
+TileFetchThrottle::HostInfo &TileFetchThrottle::hostInfo(const std::string &host)
+{
+    auto it = hosts.find(host);
+    if (it == hosts.end())
+    {
+        // Start partway so there's room to go either way
+        it = hosts.emplace(host,HostInfo()).first;
+        it->second.limit = std::max(minPerHost,maxPerHost / 2);
+    }
+    return it->second;
+}
+
+bool TileFetchThrottle::canStart(const std::string &host)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    HostInfo &info = hostInfo(host);
+    if (info.active < info.limit)
+        return true;
+    info.roundFull = true;
+    return false;
+}
+
+void TileFetchThrottle::started(const std::string &host)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    HostInfo &info = hostInfo(host);
+    if (++info.active >= info.limit)
+        info.roundFull = true;
+    if (info.roundStart == 0.0)
+        info.roundStart = TimeGetCurrent();
+}
+
+void TileFetchThrottle::finished(const std::string &host,TimeInterval howLong,size_t size)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    HostInfo &info = hostInfo(host);
+    // Everything going at once was getting data at about this rate, so that's what the host gives us
+    howLong = std::max(howLong,0.001);
+    info.roundBytes += (double)size * std::max(info.active,1);
+    info.roundTime += howLong;
+    info.roundFetches++;
+    info.active = std::max(info.active - 1,0);
+    info.avgTime = (info.avgTime == 0.0) ? howLong : info.avgTime + (howLong - info.avgTime) * Smoothing;
+
+    const TimeInterval now = TimeGetCurrent();
+    if (now - info.roundStart >= RoundLength * info.avgTime && info.roundFetches >= RoundFetches * info.limit)
+        endRound(info,now);
+}
+
+void TileFetchThrottle::endRound(HostInfo &info,TimeInterval now)
+{
+    const double rate = info.roundBytes / info.roundTime;
+    info.rate = rate;
+    info.rateTime = now;
+
+    // If we weren't using what we had, this round says nothing about needing more or fewer
+    if (info.roundFull)
+    {
+        if (info.lastRate > 0.0)
+        {
+            // One connection more or less should have made about this much difference,
+            // if the host had room.  Much less than that is noise.
+            const double change = 0.5 / (info.limit - info.direction);
+            // Keep going the way that helped.  If it made no difference, fewer is better.
+            if (rate < info.lastRate * (1.0 - change))
+                info.direction = -info.direction;
+            else if (rate <= info.lastRate * (1.0 + change))
+                info.direction = -1;
+        }
+        info.limit = std::min(std::max(info.limit + info.direction,minPerHost),maxPerHost);
+        info.lastRate = rate;
+    }
+
+    info.roundStart = (info.active > 0) ? now : 0.0;
+    info.roundBytes = 0.0;
+    info.roundTime = 0.0;
+    info.roundFetches = 0;
+    info.roundFull = info.active >= info.limit;
+}
+
+void TileFetchThrottle::failed(const std::string &host)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    HostInfo &info = hostInfo(host);
+    info.active = std::max(info.active - 1,0);
+    info.limit = std::max((int)(info.limit * FailBackoff),minPerHost);
+    // What we measured before doesn't apply now
+    info.lastRate = 0.0;
+    info.direction = 1;
+}
+
+void TileFetchThrottle::cancelled(const std::string &host)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    HostInfo &info = hostInfo(host);
+    info.active = std::max(info.active - 1,0);
+}
+
+int TileFetchThrottle::getLimit(const std::string &host)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    return hostInfo(host).limit;
+}
+
+double TileFetchThrottle::getRate()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    const TimeInterval now = TimeGetCurrent();
+    double total = 0.0;
+    for (const auto &it : hosts)
+        if (it.second.rateTime > 0.0 && now - it.second.rateTime < RateLifetime)
+            total += it.second.rate;
+    return total;
+}
+
+}
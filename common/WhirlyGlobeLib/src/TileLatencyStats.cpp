@@ -0,0 +1,165 @@
+/*  TileLatencyStats.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import <cmath>
+#import "TileLatencyStats.h"
+
+namespace WhirlyKit
+{
+
+// Tiles that get requested and then forgotten shouldn't pile up forever
+static constexpr size_t MaxPendingPerFinished = 4;
+
+const char *TileLatencyStats::getStageName(Stage stage)
+{
+    switch (stage)
+    {
+        case Requested: return "total";
+        case Received: return "fetch";
+        case Decoded: return "decode";
+        case Merged: return "merge";
+        case Displayed: return "display";
+        default: return "unknown";
+    }
+}
+
+TileLatencyStats::TileLatencyStats(int inMaxTiles) :
+    enable(false),
+    maxTiles(std::max(inMaxTiles,1))
+{
+}
+
+void TileLatencyStats::setEnable(bool newEnable)
+{
+    enable.store(newEnable,std::memory_order_relaxed);
+    if (!newEnable)
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        pending.clear();
+    }
+}
+
+void TileLatencyStats::mark(int64_t nodeNumber,Stage stage,TimeInterval when)
+{
+    if (!isEnabled() || stage < Requested || stage >= NumStages)
+        return;
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    auto it = pending.find(nodeNumber);
+    if (it == pending.end())
+    {
+        if (stage != Requested || pending.size() >= maxTiles * MaxPendingPerFinished)
+            return;
+        Times times;
+        times.fill(0.0);
+        it = pending.emplace(nodeNumber,times).first;
+    }
+
+    // First one through wins
+    auto &times = it->second;
+    if (times[stage] == 0.0)
+        times[stage] = when;
+
+    if (stage == Displayed)
+    {
+        if (finished.size() < maxTiles)
+            finished.push_back(times);
+        else
+            finished[nextTile] = times;
+        nextTile = (nextTile + 1) % maxTiles;
+        pending.erase(it);
+    }
+}
+
+void TileLatencyStats::drop(int64_t nodeNumber)
+{
+    if (!isEnabled())
+        return;
+
+    std::lock_guard<std::mutex> guardLock(lock);
+    pending.erase(nodeNumber);
+}
+
+std::vector<TileLatencyStats::Summary> TileLatencyStats::getSummaries() const
+{
+    std::vector<Times> theTiles;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        theTiles = finished;
+    }
+
+    std::vector<Summary> summaries;
+    summaries.reserve(NumStages);
+    std::vector<double> vals;
+    vals.reserve(theTiles.size());
+    for (int ss=0;ss<NumStages;ss++)
+    {
+        // Stages we didn't see for a tile are left out rather than counted as zero
+        vals.clear();
+        for (const auto &times : theTiles)
+        {
+            const TimeInterval start = (ss == Requested) ? times[Requested] : times[ss-1];
+            const TimeInterval end = (ss == Requested) ? times[Displayed] : times[ss];
+            if (start > 0.0 && end >= start)
+                vals.push_back(end - start);
+        }
+
+        Summary summary;
+        summary.stage = (Stage)ss;
+        summary.numTiles = (int)vals.size();
+        if (!vals.empty())
+        {
+            std::sort(vals.begin(),vals.end());
+            double total = 0.0;
+            for (double val : vals)
+                total += val;
+
+            // Nearest rank
+            const auto percentile = [&vals](double frac) {
+                const size_t idx = (size_t)std::ceil(frac * vals.size());
+                return vals[std::min(std::max(idx,(size_t)1),vals.size()) - 1];
+            };
+
+            summary.minVal = vals.front();
+            summary.maxVal = vals.back();
+            summary.mean = total / vals.size();
+            summary.p50 = percentile(0.50);
+            summary.p95 = percentile(0.95);
+        }
+        summaries.push_back(summary);
+    }
+
+    return summaries;
+}
+
+int TileLatencyStats::getNumPending() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return (int)pending.size();
+}
+
+void TileLatencyStats::clear()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    pending.clear();
+    finished.clear();
+    nextTile = 0;
+}
+
+}
@@ -0,0 +1,120 @@
+/*  TileMemoryCache.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "TileMemoryCache.h"
+
+namespace WhirlyKit
+{
+
+TileMemoryCache::TileMemoryCache(size_t maxSize) :
+    maxSize(maxSize),
+    curSize(0)
+{
+}
+
+void TileMemoryCache::setMaxSize(size_t size)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    maxSize = size;
+    trim();
+}
+
+RawDataRef TileMemoryCache::find(const std::string &key)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    const auto it = entriesByKey.find(key);
+    if (it == entriesByKey.end())
+    {
+        return RawDataRef();
+    }
+
+    // Move it to the front
+    entries.splice(entries.begin(),entries,it->second);
+    return it->second->second;
+}
+
+void TileMemoryCache::add(const std::string &key,const RawDataRef &data)
+{
+    if (!data)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    // Bigger than the whole cache isn't worth keeping
+    if (data->getLen() > maxSize)
+    {
+        return;
+    }
+
+    const auto it = entriesByKey.find(key);
+    if (it != entriesByKey.end())
+    {
+        curSize -= it->second->second->getLen();
+        entries.erase(it->second);
+        entriesByKey.erase(it);
+    }
+
+    entries.emplace_front(key,data);
+    entriesByKey[key] = entries.begin();
+    curSize += data->getLen();
+
+    trim();
+}
+
+void TileMemoryCache::remove(const std::string &key)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    const auto it = entriesByKey.find(key);
+    if (it != entriesByKey.end())
+    {
+        curSize -= it->second->second->getLen();
+        entries.erase(it->second);
+        entriesByKey.erase(it);
+    }
+}
+
+void TileMemoryCache::clear()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    entries.clear();
+    entriesByKey.clear();
+    curSize = 0;
+}
+
+size_t TileMemoryCache::getSize()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return curSize;
+}
+
+void TileMemoryCache::trim()
+{
+    while (curSize > maxSize && !entries.empty())
+    {
+        const auto &last = entries.back();
+        curSize -= last.second->getLen();
+        entriesByKey.erase(last.first);
+        entries.pop_back();
+    }
+}
+
+}
@@ -0,0 +1,160 @@
+/*  TileMemoryManager.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import <functional>
+#import "TileMemoryManager.h"
+
+namespace WhirlyKit
+{
+
+TileMemoryManager &TileMemoryManager::getShared()
+{
+    static TileMemoryManager shared;
+    return shared;
+}
+
+void TileMemoryManager::setBudget(size_t bytes)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    budget = bytes;
+    calcLimits();
+}
+
+size_t TileMemoryManager::getBudget() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return budget;
+}
+
+void TileMemoryManager::relievePressure(double fraction,TimeInterval holdTime)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    size_t inUse = 0;
+    for (const auto &client : clients)
+        inUse += client.usage.bytes;
+    pressureBudget = std::max((size_t)(inUse * fraction),(size_t)1);
+    pressureUntil = TimeGetCurrent() + holdTime;
+
+    calcLimits();
+}
+
+int TileMemoryManager::addClient()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    Client client;
+    client.clientID = nextClientID++;
+    clients.push_back(client);
+
+    return client.clientID;
+}
+
+void TileMemoryManager::removeClient(int clientID)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    clients.erase(std::remove_if(clients.begin(),clients.end(),
+                                 [clientID](const Client &client) { return client.clientID == clientID; }),
+                  clients.end());
+    calcLimits();
+}
+
+int TileMemoryManager::updateClient(int clientID,std::vector<double> &&wantedImports,const TileMemoryUsage &usage)
+{
+    std::sort(wantedImports.begin(),wantedImports.end(),std::greater<double>());
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    const auto it = std::find_if(clients.begin(),clients.end(),
+                                 [clientID](const Client &client) { return client.clientID == clientID; });
+    if (it == clients.end())
+        return -1;
+    it->imports = std::move(wantedImports);
+    it->usage = usage;
+
+    calcLimits();
+
+    return it->limit;
+}
+
+void TileMemoryManager::calcLimits()
+{
+    if (pressureBudget && TimeGetCurrent() > pressureUntil)
+        pressureBudget = 0;
+    const size_t curBudget = (pressureBudget && budget) ? std::min(budget,pressureBudget) :
+                             std::max(budget,pressureBudget);
+
+    if (curBudget == 0)
+    {
+        for (auto &client : clients)
+            client.limit = -1;
+        return;
+    }
+
+    // Everyone's tiles together, most important first
+    std::vector<std::pair<double,size_t>> allTiles;
+    size_t numTiles = 0;
+    for (const auto &client : clients)
+        numTiles += client.imports.size();
+    allTiles.reserve(numTiles);
+    for (size_t ci=0;ci<clients.size();ci++)
+        for (double import : clients[ci].imports)
+            allTiles.emplace_back(import,ci);
+    std::stable_sort(allTiles.begin(),allTiles.end(),
+                     [](const std::pair<double,size_t> &a,const std::pair<double,size_t> &b) { return a.first > b.first; });
+
+    // Hand out the budget until it runs out
+    std::vector<int> kept(clients.size(),0);
+    size_t total = 0;
+    for (const auto &tile : allTiles)
+    {
+        const size_t tileBytes = clients[tile.second].usage.bytesPerTile;
+        if (total + tileBytes > curBudget)
+            break;
+        total += tileBytes;
+        kept[tile.second]++;
+    }
+
+    for (size_t ci=0;ci<clients.size();ci++)
+    {
+        auto &client = clients[ci];
+        // Always leave them something to show
+        client.limit = (kept[ci] < (int)client.imports.size()) ? std::max(kept[ci],1) : -1;
+    }
+}
+
+TileMemoryManager::Stats TileMemoryManager::getStats() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    Stats stats;
+    stats.budget = budget;
+    stats.numClients = (int)clients.size();
+    for (const auto &client : clients)
+    {
+        stats.bytesInUse += client.usage.bytes;
+        stats.bytesWanted += client.imports.size() * client.usage.bytesPerTile;
+        if (client.limit >= 0)
+            stats.numLimited++;
+    }
+
+    return stats;
+}
+
+}
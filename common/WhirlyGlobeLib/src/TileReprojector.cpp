@@ -0,0 +1,301 @@
+/*  TileReprojector.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import <cmath>
+#import "TileReprojector.h"
+#import "BasicDrawableBuilder.h"
+#import "RenderTarget.h"
+#import "SharedAttributes.h"
+#import "Program.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+// Frames we'll wait for the warp to be drawn before giving up on it
+static constexpr int MaxFinishChecks = 300;
+// Frames to leave the pieces around after the draw, so the GPU is done with them
+static constexpr int FinishDelayFrames = 2;
+
+/** Tears down the warp for one tile once the renderer has drawn it.
+    We check each frame and put ourselves back on the queue until the
+    warp drawable is in its target and the target has been drawn.
+  */
+class TileReprojectFinishReq : public ChangeRequest
+{
+public:
+    TileReprojectFinishReq(SimpleIdentity targetID,SimpleIdentity drawID,SimpleIdentity srcTexID) :
+        targetID(targetID), drawID(drawID), srcTexID(srcTexID)
+    {
+    }
+
+    void execute(Scene *scene,SceneRenderer *renderer,View *view) override
+    {
+        if (checks < MaxFinishChecks)
+        {
+            if (!drawn)
+            {
+                const auto draw = scene->getDrawable(drawID);
+                const auto it = std::find_if(renderer->getRenderTargets().begin(),renderer->getRenderTargets().end(),
+                                             [this](const RenderTargetRef &target) { return target->getId() == targetID; });
+                drawn = draw && draw->renderTargetCon &&
+                        it != renderer->getRenderTargets().end() && !(*it)->dirty;
+            }
+            if (!drawn || framesSinceDrawn++ < FinishDelayFrames)
+            {
+                auto next = new TileReprojectFinishReq(*this);
+                next->checks++;
+                scene->addChangeRequest(next);
+                return;
+            }
+        }
+        else
+        {
+            wkLogLevel(Warn,"TileReprojector: Gave up waiting for a tile warp to draw");
+        }
+
+        renderer->removeRenderTarget(targetID);
+        scene->addChangeRequest(new RemDrawableReq(drawID));
+        scene->addChangeRequest(new RemTextureReq(srcTexID));
+    }
+
+protected:
+    SimpleIdentity targetID,drawID,srcTexID;
+    int checks = 0;
+    bool drawn = false;
+    int framesSinceDrawn = 0;
+};
+
+TileReprojector::TileReprojector(SceneRenderer *renderer,Scene *scene,
+                                 const TileGeomManager &geomManage,const TileGeomSettings &geomSettings,
+                                 int warpSamples) :
+    renderer(renderer),
+    scene(scene),
+    geomManage(geomManage),
+    geomSettings(geomSettings),
+    warpSamples(std::max(warpSamples,1))
+{
+}
+
+bool TileReprojector::NeedsReprojection(const TileGeomManager &geomManage)
+{
+    const CoordSystemDisplayAdapter *coordAdapter = geomManage.coordAdapter;
+    return coordAdapter && geomManage.coordSys &&
+           !geomManage.coordSys->isSameAs(coordAdapter->getCoordSystem());
+}
+
+bool TileReprojector::CanReproject(const Texture *tex)
+{
+    if (!tex || tex->getWidth() <= 0 || tex->getHeight() <= 0)
+        return false;
+
+    // Integer and float textures are data, not colors, and shouldn't be blended around
+    switch (tex->getFormat())
+    {
+        case TexTypeUnsignedByte:
+        case TexTypeShort565:
+        case TexTypeShort4444:
+        case TexTypeShort5551:
+        case TexTypeSingleChannel:
+        case TexTypeDoubleChannel:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Follows LoadedTileNew::makeDrawables so we end up with the same grid it does
+void TileReprojector::makeTileGrid(const QuadTreeNew::Node &ident,MbrD &theMbr,Point2d &texScale,
+                                   int &sampleX,int &sampleY,Point3dVector &grid) const
+{
+    theMbr = geomManage.quadTree->generateMbrForNode(ident);
+
+    texScale = Point2d(1.0,1.0);
+    if (theMbr.ll().x() < geomManage.mbr.ll().x()) {
+        theMbr.ll().x() = geomManage.mbr.ll().x();
+    }
+    if (theMbr.ur().x() > geomManage.mbr.ur().x()) {
+        texScale.x() = (geomManage.mbr.ur().x()-theMbr.ll().x())/(theMbr.ur().x()-theMbr.ll().x());
+        theMbr.ur().x() = geomManage.mbr.ur().x();
+    }
+    if (theMbr.ll().y() < geomManage.mbr.ll().y()) {
+        theMbr.ll().y() = geomManage.mbr.ll().y();
+    }
+    if (theMbr.ur().y() > geomManage.mbr.ur().y()) {
+        texScale.y() = (geomManage.mbr.ur().y()-theMbr.ll().y())/(theMbr.ur().y()-theMbr.ll().y());
+        theMbr.ur().y() = geomManage.mbr.ur().y();
+    }
+
+    sampleX = geomSettings.sampleX;
+    sampleY = geomSettings.sampleY;
+    if (ident.level == 0)
+    {
+        sampleX = geomSettings.topSampleX;
+        sampleY = geomSettings.topSampleY;
+    }
+    if (ident.level > 17)
+    {
+        sampleX = 1;
+        sampleY = 1;
+    }
+    sampleX = std::max(sampleX,1);
+    sampleY = std::max(sampleY,1);
+
+    const Point2d chunkSize = theMbr.ur() - theMbr.ll();
+    const Point2d incr(chunkSize.x()/sampleX,chunkSize.y()/sampleY);
+    grid.resize((sampleX+1)*(sampleY+1));
+    for (int iy=0;iy<sampleY+1;iy++)
+        for (int ix=0;ix<sampleX+1;ix++)
+            grid[iy*(sampleX+1)+ix] = Point3d(theMbr.ll().x()+ix*incr.x(),theMbr.ll().y()+iy*incr.y(),0.0);
+
+    CoordSystem *sceneCoordSys = geomManage.coordAdapter->getCoordSystem();
+    CoordSystemConvertBatch(geomManage.coordSys.get(),sceneCoordSys,grid.data(),grid.data(),grid.size());
+    geomManage.coordAdapter->localToDisplayBatch(grid.data(),grid.data(),grid.size());
+    if (geomManage.coordAdapter->isFlat())
+        for (auto &pt : grid)
+            pt.z() = 0.0;
+}
+
+// The two triangles LoadedTileNew splits each grid cell into, as offsets from the cell's corner
+static const int CellTris[2][3][2] = {{{0,1},{0,0},{1,1}},{{1,1},{0,0},{1,0}}};
+
+// Weights for the point projected onto the triangle's plane.  Outside the triangle is fine.
+static Point3d Barycentric(const Point3d &pt,const Point3d &a,const Point3d &b,const Point3d &c)
+{
+    const Point3d v0 = b - a, v1 = c - a, v2 = pt - a;
+    const double d00 = v0.dot(v0), d01 = v0.dot(v1), d11 = v1.dot(v1);
+    const double d20 = v2.dot(v0), d21 = v2.dot(v1);
+    const double denom = d00 * d11 - d01 * d01;
+    if (denom == 0.0)
+        return { 1.0, 0.0, 0.0 };
+    const double wb = (d11 * d20 - d01 * d21) / denom;
+    const double wc = (d00 * d21 - d01 * d20) / denom;
+    return { 1.0 - wb - wc, wb, wc };
+}
+
+Texture *TileReprojector::reprojectTexture(const QuadTreeNew::Node &ident,Texture *srcTex,ChangeSet &warpChanges)
+{
+    const Program *prog = scene->findProgramByName(MaplyNoLightTriangleShader);
+    if (!prog)
+    {
+        wkLogLevel(Warn,"TileReprojector: Missing triangle shader, leaving tiles as they are");
+        return srcTex;
+    }
+
+    MbrD theMbr;
+    Point2d texScale;
+    int sampleX,sampleY;
+    Point3dVector grid;
+    makeTileGrid(ident,theMbr,texScale,sampleX,sampleY,grid);
+
+    // The warp mesh covers the same area, just more finely
+    const int numWarp = warpSamples;
+    const Point2d chunkSize = theMbr.ur() - theMbr.ll();
+    Point3dVector warpPts((numWarp+1)*(numWarp+1));
+    for (int iy=0;iy<numWarp+1;iy++)
+        for (int ix=0;ix<numWarp+1;ix++)
+            warpPts[iy*(numWarp+1)+ix] = Point3d(theMbr.ll().x()+chunkSize.x()*ix/numWarp,
+                                                  theMbr.ll().y()+chunkSize.y()*iy/numWarp,0.0);
+    CoordSystem *sceneCoordSys = geomManage.coordAdapter->getCoordSystem();
+    CoordSystemConvertBatch(geomManage.coordSys.get(),sceneCoordSys,warpPts.data(),warpPts.data(),warpPts.size());
+    geomManage.coordAdapter->localToDisplayBatch(warpPts.data(),warpPts.data(),warpPts.size());
+    if (geomManage.coordAdapter->isFlat())
+        for (auto &pt : warpPts)
+            pt.z() = 0.0;
+
+    // Render targets come out flipped in Metal
+    const bool flipY = renderer->getType() == SceneRenderer::RenderMetal;
+
+    const SimpleIdentity srcTexID = srcTex->getId();
+    const SimpleIdentity targetID = Identifiable::genId();
+    const int width = srcTex->getWidth(), height = srcTex->getHeight();
+
+    auto warpBuild = renderer->makeBasicDrawableBuilder("TileReprojector");
+    warpBuild->setType(Triangles);
+    warpBuild->setClipCoords(true);
+    warpBuild->setProgram(prog->getId());
+    warpBuild->setTexId(0,srcTexID);
+    warpBuild->setRenderTarget(targetID);
+    warpBuild->setOnOff(true);
+    warpBuild->setColor(RGBAColor::white());
+    warpBuild->setRequestZBuffer(false);
+    warpBuild->setWriteZBuffer(false);
+    warpBuild->reserve((numWarp+1)*(numWarp+1),2*numWarp*numWarp);
+
+    for (int iy=0;iy<numWarp+1;iy++)
+    {
+        for (int ix=0;ix<numWarp+1;ix++)
+        {
+            const double s = (double)ix/numWarp, t = (double)iy/numWarp;
+            const Point3d &dispPt = warpPts[iy*(numWarp+1)+ix];
+
+            // Coarse triangle this piece of the tile lands in
+            const int cx = std::min((int)(s*sampleX),sampleX-1);
+            const int cy = std::min((int)(t*sampleY),sampleY-1);
+            const double fracS = s*sampleX - cx, fracT = t*sampleY - cy;
+            const auto &tri = CellTris[fracT > fracS ? 0 : 1];
+            Point3d corners[3];
+            for (int ii=0;ii<3;ii++)
+                corners[ii] = grid[(cy+tri[ii][1])*(sampleX+1)+cx+tri[ii][0]];
+            const Point3d weights = Barycentric(dispPt,corners[0],corners[1],corners[2]);
+
+            // Where the coarse geometry will be looking in the texture for this spot
+            double u = 0.0, v = 0.0;
+            for (int ii=0;ii<3;ii++)
+            {
+                u += weights[ii] * (cx+tri[ii][0]) / sampleX;
+                v += weights[ii] * (cy+tri[ii][1]) / sampleY;
+            }
+            const double destX = u * texScale.x(), destY = 1.0 - v * texScale.y();
+
+            warpBuild->addPoint(Point3d(2.0*destX-1.0,flipY ? 1.0-2.0*destY : 2.0*destY-1.0,0.0));
+            warpBuild->addTexCoord(0,TexCoord(s * texScale.x(),1.0 - t * texScale.y()));
+        }
+    }
+    for (int iy=0;iy<numWarp;iy++)
+    {
+        for (int ix=0;ix<numWarp;ix++)
+        {
+            BasicDrawable::Triangle triA,triB;
+            triA.verts[0] = (iy+1)*(numWarp+1)+ix;
+            triA.verts[1] = iy*(numWarp+1)+ix;
+            triA.verts[2] = (iy+1)*(numWarp+1)+(ix+1);
+            triB.verts[0] = triA.verts[2];
+            triB.verts[1] = triA.verts[1];
+            triB.verts[2] = iy*(numWarp+1)+(ix+1);
+            warpBuild->addTriangle(triA);
+            warpBuild->addTriangle(triB);
+        }
+    }
+    const SimpleIdentity warpDrawID = warpBuild->getDrawableID();
+
+    // Blank texture the tile geometry will use
+    Texture *destTex = renderer->makeRenderTexture("TileReprojector",width,height,TexTypeUnsignedByte);
+    destTex->setInterpType(srcTex->getInterpType());
+
+    warpChanges.push_back(new AddTextureReq(srcTex));
+    warpChanges.push_back(new AddRenderTargetReq(targetID,width,height,destTex->getId(),
+                                                 true,false,RGBAColor(0,0,0,0),0.0,
+                                                 RenderTargetMipmapNone,false,true));
+    warpChanges.push_back(new AddDrawableReq(warpBuild->getDrawable()));
+    warpChanges.push_back(new TileReprojectFinishReq(targetID,warpDrawID,srcTexID));
+
+    return destTex;
+}
+
+}
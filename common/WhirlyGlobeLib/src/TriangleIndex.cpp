@@ -0,0 +1,335 @@
+/*  TriangleIndex.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import <cmath>
+#import <limits>
+#import "TriangleIndex.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    // Triangles in a leaf, two packets' worth
+    constexpr int LeafSize = 8;
+    // Never bother rebuilding for fewer changes than this
+    constexpr size_t MinRebuild = 256;
+}
+
+void TriangleIndex::add(SimpleIdentity objID,const Point3dVector &tris,bool enable)
+{
+    remove(objID);
+
+    // Don't let removals pile up if nobody's looking
+    if (numDeadTris > std::max(MinRebuild,(numIndexedTris + numPendingTris) / 2))
+        rebuild();
+
+    const size_t numTris = tris.size() / 3;
+    if (numTris == 0)
+        return;
+
+    where[objID] = groups.size();
+    groups.push_back(Group { objID, Point3dVector(tris.begin(),tris.begin() + numTris * 3), enable, true });
+    numPendingTris += numTris;
+}
+
+void TriangleIndex::addPolygons(SimpleIdentity objID,const Point3d &center,const std::vector<Point3fVector> &polys,bool enable)
+{
+    Point3dVector tris;
+    for (const auto &poly : polys)
+    {
+        if (poly.size() < 3)
+            continue;
+        tris.reserve(tris.size() + (poly.size() - 2) * 3);
+        const Point3d first = poly[0].cast<double>() + center;
+        for (size_t ii=1;ii<poly.size()-1;ii++)
+        {
+            tris.push_back(first);
+            tris.push_back(poly[ii].cast<double>() + center);
+            tris.push_back(poly[ii+1].cast<double>() + center);
+        }
+    }
+
+    add(objID,tris,enable);
+}
+
+void TriangleIndex::remove(SimpleIdentity objID)
+{
+    const auto it = where.find(objID);
+    if (it == where.end())
+        return;
+
+    Group &group = groups[it->second];
+    group.live = false;
+    if (it->second >= numIndexed)
+    {
+        // Never made it into the tree, so it can just go
+        numPendingTris -= group.tris.size() / 3;
+        Point3dVector().swap(group.tris);
+    }
+    else
+        numDeadTris += group.tris.size() / 3;
+    where.erase(it);
+}
+
+void TriangleIndex::setEnable(SimpleIdentity objID,bool enable)
+{
+    const auto it = where.find(objID);
+    if (it != where.end())
+        groups[it->second].enable = enable;
+}
+
+void TriangleIndex::rebuild()
+{
+    groups.erase(std::remove_if(groups.begin(),groups.end(),[](const Group &group) { return !group.live; }),
+                 groups.end());
+    where.clear();
+    for (size_t ii=0;ii<groups.size();ii++)
+        where[groups[ii].objID] = ii;
+
+    std::vector<TriRef> refs;
+    refs.reserve(numIndexedTris + numPendingTris);
+    for (size_t ii=0;ii<groups.size();ii++)
+    {
+        const Point3dVector &tris = groups[ii].tris;
+        for (size_t jj=0;jj<tris.size()/3;jj++)
+            refs.push_back(TriRef { (int)ii, (int)jj, (tris[jj*3] + tris[jj*3+1] + tris[jj*3+2]) / 3.0 });
+    }
+
+    nodes.clear();
+    packets.clear();
+    nodes.reserve(2 * refs.size() / LeafSize + 1);
+    packets.reserve(refs.size() / 2 + 1);
+    if (!refs.empty())
+    {
+        const auto expand = [this](const TriRef &ref,Point3d &ll,Point3d &ur)
+        {
+            const Point3d *tri = &groups[ref.group].tris[ref.tri * 3];
+            for (int jj=0;jj<3;jj++)
+            {
+                ll = ll.cwiseMin(tri[jj]);
+                ur = ur.cwiseMax(tri[jj]);
+            }
+        };
+        // Pack the triangles up relative to the corner, where floats will do
+        const auto packLeaf = [this,&refs](Node &node,int first,int count)
+        {
+            node.first = (int)packets.size();
+            node.count = (count + 3) / 4;
+            packets.resize(packets.size() + node.count);
+            for (int ii=0;ii<node.count*4;ii++)
+            {
+                Packet &packet = packets[node.first + ii / 4];
+                const int lane = ii % 4;
+                if (ii >= count)
+                {
+                    for (int jj=0;jj<3;jj++)
+                        packet.v0[jj][lane] = packet.e1[jj][lane] = packet.e2[jj][lane] = 0.0f;
+                    packet.group[lane] = -1;
+                    continue;
+                }
+
+                const TriRef &ref = refs[first + ii];
+                const Point3d *tri = &groups[ref.group].tris[ref.tri * 3];
+                const Point3d v0 = tri[0] - node.ll;
+                const Point3d e1 = tri[1] - tri[0], e2 = tri[2] - tri[0];
+                for (int jj=0;jj<3;jj++)
+                {
+                    packet.v0[jj][lane] = (float)v0[jj];
+                    packet.e1[jj][lane] = (float)e1[jj];
+                    packet.e2[jj][lane] = (float)e2[jj];
+                }
+                packet.group[lane] = ref.group;
+            }
+        };
+        BuildBoundsHierarchy(nodes,refs,0,(int)refs.size(),LeafSize,expand,
+                             [](const TriRef &ref) -> const Point3d & { return ref.center; },packLeaf);
+    }
+
+    numIndexed = groups.size();
+    numIndexedTris = refs.size();
+    numPendingTris = 0;
+    numDeadTris = 0;
+}
+
+bool TriangleIndex::rayHitsBox(const Point3d &ll,const Point3d &ur,const Point3d &org,const Point3d &invDir,double maxT,double &tEnter)
+{
+    double tMin = 0.0, tMax = maxT;
+    for (int ii=0;ii<3;ii++)
+    {
+        double t0 = (ll[ii] - org[ii]) * invDir[ii], t1 = (ur[ii] - org[ii]) * invDir[ii];
+        if (t0 > t1)
+            std::swap(t0,t1);
+        tMin = std::max(tMin,t0);
+        tMax = std::min(tMax,t1);
+        if (tMin > tMax)
+            return false;
+    }
+
+    tEnter = tMin;
+    return true;
+}
+
+bool TriangleIndex::rayHitsTri(const Point3d &org,const Point3d &dir,const Point3d *tri,double &t)
+{
+    const Point3d e1 = tri[1] - tri[0], e2 = tri[2] - tri[0];
+    const Point3d pVec = dir.cross(e2);
+    const double det = e1.dot(pVec);
+    if (det == 0.0)
+        return false;
+    const double invDet = 1.0 / det;
+
+    const Point3d sVec = org - tri[0];
+    const double u = sVec.dot(pVec) * invDet;
+    if (u < 0.0 || u > 1.0)
+        return false;
+    const Point3d qVec = sVec.cross(e1);
+    const double v = dir.dot(qVec) * invDet;
+    if (v < 0.0 || u + v > 1.0)
+        return false;
+
+    t = e2.dot(qVec) * invDet;
+    return t > 0.0;
+}
+
+template<typename T> void TriangleIndex::traverse(const Point3d &org,const Point3d &dir,double maxT,T &&hit)
+{
+    if (numPendingTris > std::max(MinRebuild,numIndexedTris / 8) ||
+        numDeadTris > std::max(MinRebuild,numIndexedTris / 4))
+        rebuild();
+
+    double limit = maxT;
+    const auto groupOn = [this](int group) { return group >= 0 && groups[group].live && groups[group].enable; };
+
+    if (!nodes.empty())
+    {
+        const float dirF[3] = { (float)dir.x(), (float)dir.y(), (float)dir.z() };
+        Point3d invDir;
+        for (int ii=0;ii<3;ii++)
+            invDir[ii] = (dir[ii] != 0.0) ? 1.0 / dir[ii] : std::numeric_limits<double>::max();
+
+        // Nearer children come off the stack first, so the limit tightens early
+        std::vector<std::pair<int,double>> stack;
+        double tEnter;
+        if (rayHitsBox(nodes[0].ll,nodes[0].ur,org,invDir,limit,tEnter))
+            stack.emplace_back(0,tEnter);
+        while (!stack.empty())
+        {
+            const auto entry = stack.back();
+            stack.pop_back();
+            if (entry.second > limit)
+                continue;
+            const Node &node = nodes[entry.first];
+
+            if (node.count > 0)
+            {
+                const Point3d localOrg = org - node.ll;
+                const float orgF[3] = { (float)localOrg.x(), (float)localOrg.y(), (float)localOrg.z() };
+                for (int pp=node.first;pp<node.first+node.count;pp++)
+                {
+                    const Packet &packet = packets[pp];
+                    float tHit[4];
+                    for (int ii=0;ii<4;ii++)
+                    {
+                        const float e1x = packet.e1[0][ii], e1y = packet.e1[1][ii], e1z = packet.e1[2][ii];
+                        const float e2x = packet.e2[0][ii], e2y = packet.e2[1][ii], e2z = packet.e2[2][ii];
+                        const float px = dirF[1] * e2z - dirF[2] * e2y;
+                        const float py = dirF[2] * e2x - dirF[0] * e2z;
+                        const float pz = dirF[0] * e2y - dirF[1] * e2x;
+                        const float det = e1x * px + e1y * py + e1z * pz;
+                        const float invDet = (det != 0.0f) ? 1.0f / det : 0.0f;
+                        const float sx = orgF[0] - packet.v0[0][ii];
+                        const float sy = orgF[1] - packet.v0[1][ii];
+                        const float sz = orgF[2] - packet.v0[2][ii];
+                        const float u = (sx * px + sy * py + sz * pz) * invDet;
+                        const float qx = sy * e1z - sz * e1y;
+                        const float qy = sz * e1x - sx * e1z;
+                        const float qz = sx * e1y - sy * e1x;
+                        const float v = (dirF[0] * qx + dirF[1] * qy + dirF[2] * qz) * invDet;
+                        const float t = (e2x * qx + e2y * qy + e2z * qz) * invDet;
+                        tHit[ii] = (invDet != 0.0f && u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f) ?
+                                    t : std::numeric_limits<float>::infinity();
+                    }
+                    for (int ii=0;ii<4;ii++)
+                    {
+                        if (tHit[ii] < limit && groupOn(packet.group[ii]))
+                            limit = hit(packet.group[ii],(double)tHit[ii]);
+                    }
+                }
+            }
+            else
+            {
+                double tLeft = 0.0, tRight = 0.0;
+                const bool hitLeft = rayHitsBox(nodes[node.left].ll,nodes[node.left].ur,org,invDir,limit,tLeft);
+                const bool hitRight = rayHitsBox(nodes[node.right].ll,nodes[node.right].ur,org,invDir,limit,tRight);
+                const std::pair<int,double> leftEntry(node.left,tLeft), rightEntry(node.right,tRight);
+                if (hitLeft && hitRight)
+                {
+                    stack.push_back(tLeft < tRight ? rightEntry : leftEntry);
+                    stack.push_back(tLeft < tRight ? leftEntry : rightEntry);
+                }
+                else if (hitLeft)
+                    stack.push_back(leftEntry);
+                else if (hitRight)
+                    stack.push_back(rightEntry);
+            }
+        }
+    }
+
+    // Anything added since the last build
+    for (size_t ii=numIndexed;ii<groups.size();ii++)
+    {
+        if (!groupOn((int)ii))
+            continue;
+        const Point3dVector &tris = groups[ii].tris;
+        for (size_t jj=0;jj<tris.size()/3;jj++)
+        {
+            double t;
+            if (rayHitsTri(org,dir,&tris[jj*3],t) && t < limit)
+                limit = hit((int)ii,t);
+        }
+    }
+}
+
+bool TriangleIndex::findClosest(const Point3d &org,const Point3d &dir,double maxT,SimpleIdentity &hitID,double &t)
+{
+    int bestGroup = -1;
+    traverse(org,dir,maxT,[&](int group,double thisT)
+    {
+        bestGroup = group;
+        t = thisT;
+        return thisT;
+    });
+
+    if (bestGroup < 0)
+        return false;
+    hitID = groups[bestGroup].objID;
+    return true;
+}
+
+void TriangleIndex::findAll(const Point3d &org,const Point3d &dir,std::unordered_map<SimpleIdentity,double> &hits)
+{
+    traverse(org,dir,std::numeric_limits<double>::max(),[&](int group,double t)
+    {
+        const auto res = hits.emplace(groups[group].objID,t);
+        if (!res.second)
+            res.first->second = std::min(res.first->second,t);
+        return std::numeric_limits<double>::max();
+    });
+}
+
+}
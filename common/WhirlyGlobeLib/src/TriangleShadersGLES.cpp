@@ -123,6 +123,93 @@ ProgramGLES *BuildDefaultTriShaderLightingGLES(const std::string &name,SceneRend
     return shader;
 }
 
+static const char *vertexShaderExtrudeTri = R"(
+precision highp float;
+
+struct directional_light {
+  vec3 direction;
+  vec3 halfplane;
+  vec4 ambient;
+  vec4 diffuse;
+  vec4 specular;
+  float viewdepend;
+};
+
+struct material_properties {
+  vec4 ambient;
+  vec4 diffuse;
+  vec4 specular;
+  float specular_exponent;
+};
+
+uniform mat4  u_mvpMatrix;
+uniform float u_fade;
+uniform int u_numLights;
+uniform directional_light light[8];
+uniform material_properties material;
+
+uniform vec2 u_texOffset0;
+uniform vec2 u_texScale0;
+uniform vec3 u_origin;
+uniform float u_globe;
+
+attribute vec3 a_position;
+attribute vec2 a_texCoord0;
+attribute vec4 a_color;
+attribute vec3 a_normal;
+attribute float a_height;
+
+varying vec2 v_texCoord;
+varying vec4 v_color;
+
+void main()
+{
+   if (u_texScale0.x != 0.0)
+     v_texCoord = vec2(a_texCoord0.x*u_texScale0.x,a_texCoord0.y*u_texScale0.y) + u_texOffset0;
+   else
+     v_texCoord = a_texCoord0;
+   v_color = vec4(0.0,0.0,0.0,0.0);
+   if (u_numLights > 0)
+   {
+     vec4 ambient = vec4(0.0,0.0,0.0,0.0);
+     vec4 diffuse = vec4(0.0,0.0,0.0,0.0);
+     for (int ii=0;ii<8;ii++)
+     {
+        if (ii>=u_numLights)
+           break;
+        vec3 adjNorm = light[ii].viewdepend > 0.0 ? normalize((u_mvpMatrix * vec4(a_normal.xyz, 0.0)).xyz) : a_normal.xzy;
+        float ndotl;
+//"        float ndoth;
+        ndotl = max(0.0, dot(adjNorm, light[ii].direction));
+//"        ndotl = pow(ndotl,0.5);
+//"        ndoth = max(0.0, dot(adjNorm, light[ii].halfplane));
+        ambient += light[ii].ambient;
+        diffuse += ndotl * light[ii].diffuse;
+     }
+     v_color = vec4(ambient.xyz * material.ambient.xyz * a_color.xyz + diffuse.xyz * a_color.xyz,a_color.a) * u_fade;
+   } else {
+     v_color = a_color * u_fade;
+   }
+
+   // Positions are on the ground, relative to u_origin, and go up by a_height
+   vec3 up = u_globe > 0.5 ? normalize(u_origin + a_position) : vec3(0.0,0.0,1.0);
+   gl_Position = u_mvpMatrix * vec4(a_position + up * a_height,1.0);
+}
+)";
+
+// Lit triangles raised off the ground by a_height, for lofted polys
+ProgramGLES *BuildDefaultTriShaderExtrudeGLES(const std::string &name,SceneRenderer *)
+{
+    auto *shader = new ProgramGLES(name,vertexShaderExtrudeTri,fragmentShaderTri);
+    if (!shader->isValid())
+    {
+        delete shader;
+        shader = nullptr;
+    }
+    
+    return shader;
+}
+
 static const char *vertexShaderNoLightTri = R"(
 precision highp float;
     
@@ -464,6 +551,265 @@ ProgramGLES *BuildDefaultTriShaderMultitexGLES(const std::string &name,SceneRend
     return shader;
 }
 
+static const char *vertexShaderTriComposite = R"(
+precision highp float;
+
+struct directional_light {
+  vec3 direction;
+  vec3 halfplane;
+  vec4 ambient;
+  vec4 diffuse;
+  vec4 specular;
+  float viewdepend;
+};
+
+struct material_properties {
+  vec4 ambient;
+  vec4 diffuse;
+  vec4 specular;
+  float specular_exponent;
+};
+
+uniform mat4  u_mvpMatrix;
+uniform float u_fade;
+uniform int u_numLights;
+uniform directional_light light[8];
+uniform material_properties material;
+uniform vec2 u_texOffset0;
+uniform vec2 u_texScale0;
+uniform vec2 u_texOffset1;
+uniform vec2 u_texScale1;
+uniform vec2 u_texOffset2;
+uniform vec2 u_texScale2;
+uniform vec2 u_texOffset3;
+uniform vec2 u_texScale3;
+
+attribute vec3 a_position;
+attribute vec2 a_texCoord0;
+attribute vec4 a_color;
+attribute vec3 a_normal;
+
+varying vec2 v_texCoord0;
+varying vec2 v_texCoord1;
+varying vec2 v_texCoord2;
+varying vec2 v_texCoord3;
+varying vec4 v_color;
+
+void main()
+{
+    if (u_texScale0.x != 0.0)
+        v_texCoord0 = vec2(a_texCoord0.x*u_texScale0.x,a_texCoord0.y*u_texScale0.y) + u_texOffset0;
+    else
+        v_texCoord0 = a_texCoord0;
+
+    if (u_texScale1.x != 0.0)
+        v_texCoord1 = vec2(a_texCoord0.x*u_texScale1.x,a_texCoord0.y*u_texScale1.y) + u_texOffset1;
+    else
+        v_texCoord1 = a_texCoord0;
+
+    if (u_texScale2.x != 0.0)
+        v_texCoord2 = vec2(a_texCoord0.x*u_texScale2.x,a_texCoord0.y*u_texScale2.y) + u_texOffset2;
+    else
+        v_texCoord2 = a_texCoord0;
+
+    if (u_texScale3.x != 0.0)
+        v_texCoord3 = vec2(a_texCoord0.x*u_texScale3.x,a_texCoord0.y*u_texScale3.y) + u_texOffset3;
+    else
+        v_texCoord3 = a_texCoord0;
+
+    v_color = vec4(0.0,0.0,0.0,0.0);
+   if (u_numLights > 0)
+   {
+     vec4 ambient = vec4(0.0,0.0,0.0,0.0);
+     vec4 diffuse = vec4(0.0,0.0,0.0,0.0);
+     for (int ii=0;ii<8;ii++)
+     {
+        if (ii>=u_numLights)
+           break;
+        vec3 adjNorm = light[ii].viewdepend > 0.0 ? normalize((u_mvpMatrix * vec4(a_normal.xyz, 0.0)).xyz) : a_normal.xzy;
+        float ndotl;
+//        float ndoth;
+        ndotl = max(0.0, dot(adjNorm, light[ii].direction));
+//        ndotl = pow(ndotl,0.5);
+//        ndoth = max(0.0, dot(adjNorm, light[ii].halfplane));
+        ambient += light[ii].ambient;
+        diffuse += ndotl * light[ii].diffuse;
+     }
+     v_color = vec4(ambient.xyz * material.ambient.xyz * a_color.xyz + diffuse.xyz * a_color.xyz,a_color.a) * u_fade;
+   } else {
+     v_color = a_color * u_fade;
+   }
+
+   gl_Position = u_mvpMatrix * vec4(a_position,1.0);
+}
+)";
+
+// Up to four layers, each drawn over the ones before.  Colors are premultiplied.
+static const char *fragmentShaderTriComposite = R"(
+precision highp float;
+
+uniform sampler2D s_baseMap0;
+uniform sampler2D s_baseMap1;
+uniform sampler2D s_baseMap2;
+uniform sampler2D s_baseMap3;
+uniform int u_has_baseMap0;
+uniform int u_has_baseMap1;
+uniform int u_has_baseMap2;
+uniform int u_has_baseMap3;
+
+varying vec2      v_texCoord0;
+varying vec2      v_texCoord1;
+varying vec2      v_texCoord2;
+varying vec2      v_texCoord3;
+varying vec4      v_color;
+
+void main()
+{
+  vec4 color = vec4(0.0,0.0,0.0,0.0);
+  if (u_has_baseMap0 != 0)
+    color = texture2D(s_baseMap0, v_texCoord0);
+  if (u_has_baseMap1 != 0) {
+    vec4 layer = texture2D(s_baseMap1, v_texCoord1);
+    color = layer + color * (1.0 - layer.a);
+  }
+  if (u_has_baseMap2 != 0) {
+    vec4 layer = texture2D(s_baseMap2, v_texCoord2);
+    color = layer + color * (1.0 - layer.a);
+  }
+  if (u_has_baseMap3 != 0) {
+    vec4 layer = texture2D(s_baseMap3, v_texCoord3);
+    color = layer + color * (1.0 - layer.a);
+  }
+  gl_FragColor = v_color * color;
+}
+)";
+
+// Triangles with layered textures
+ProgramGLES *BuildDefaultTriShaderCompositeGLES(const std::string &name,SceneRenderer *)
+{
+    auto *shader = new ProgramGLES(name,vertexShaderTriComposite,fragmentShaderTriComposite);
+    if (!shader->isValid())
+    {
+        delete shader;
+        shader = nullptr;
+    }
+    
+    return shader;
+}
+
+static const char *vertexShaderTriTerrain = R"(
+precision highp float;
+
+struct directional_light {
+  vec3 direction;
+  vec3 halfplane;
+  vec4 ambient;
+  vec4 diffuse;
+  vec4 specular;
+  float viewdepend;
+};
+
+struct material_properties {
+  vec4 ambient;
+  vec4 diffuse;
+  vec4 specular;
+  float specular_exponent;
+};
+
+uniform mat4  u_mvpMatrix;
+uniform float u_fade;
+uniform int u_numLights;
+uniform directional_light light[8];
+uniform material_properties material;
+uniform vec2 u_texOffset0;
+uniform vec2 u_texScale0;
+uniform vec2 u_texOffset1;
+uniform vec2 u_texScale1;
+
+uniform sampler2D s_baseMap1;
+uniform int u_has_baseMap1;
+// Pixel to height in display units: dot with the color, plus the offset
+uniform vec4 u_elevDecode;
+
+attribute vec3 a_position;
+attribute vec2 a_texCoord0;
+attribute vec4 a_color;
+attribute vec3 a_normal;
+
+varying vec2 v_texCoord0;
+varying vec4 v_color;
+
+void main()
+{
+    if (u_texScale0.x != 0.0)
+        v_texCoord0 = vec2(a_texCoord0.x*u_texScale0.x,a_texCoord0.y*u_texScale0.y) + u_texOffset0;
+    else
+        v_texCoord0 = a_texCoord0;
+
+    // Raise the vertex along its normal.  Skirts come along with the edges they hang from.
+    vec3 pos = a_position;
+    if (u_has_baseMap1 != 0)
+    {
+        vec2 elevCoord = a_texCoord0;
+        if (u_texScale1.x != 0.0)
+            elevCoord = vec2(a_texCoord0.x*u_texScale1.x,a_texCoord0.y*u_texScale1.y) + u_texOffset1;
+        vec3 elev = texture2DLod(s_baseMap1, elevCoord, 0.0).rgb;
+        pos += normalize(a_normal) * (dot(elev, u_elevDecode.xyz) + u_elevDecode.w);
+    }
+
+    v_color = vec4(0.0,0.0,0.0,0.0);
+   if (u_numLights > 0)
+   {
+     vec4 ambient = vec4(0.0,0.0,0.0,0.0);
+     vec4 diffuse = vec4(0.0,0.0,0.0,0.0);
+     for (int ii=0;ii<8;ii++)
+     {
+        if (ii>=u_numLights)
+           break;
+        vec3 adjNorm = light[ii].viewdepend > 0.0 ? normalize((u_mvpMatrix * vec4(a_normal.xyz, 0.0)).xyz) : a_normal.xzy;
+        float ndotl;
+        ndotl = max(0.0, dot(adjNorm, light[ii].direction));
+        ambient += light[ii].ambient;
+        diffuse += ndotl * light[ii].diffuse;
+     }
+     v_color = vec4(ambient.xyz * material.ambient.xyz * a_color.xyz + diffuse.xyz * a_color.xyz,a_color.a) * u_fade;
+   } else {
+     v_color = a_color * u_fade;
+   }
+
+   gl_Position = u_mvpMatrix * vec4(pos,1.0);
+}
+)";
+
+static const char *fragmentShaderTriTerrain = R"(
+precision highp float;
+
+uniform sampler2D s_baseMap0;
+uniform int u_has_baseMap0;
+
+varying vec2      v_texCoord0;
+varying vec4      v_color;
+
+void main()
+{
+  vec4 baseColor = u_has_baseMap0 != 0 ? texture2D(s_baseMap0, v_texCoord0) : vec4(1.0,1.0,1.0,1.0);
+  gl_FragColor = v_color * baseColor;
+}
+)";
+
+// Triangles displaced by an elevation texture
+ProgramGLES *BuildDefaultTriShaderTerrainGLES(const std::string &name,SceneRenderer *)
+{
+    auto *shader = new ProgramGLES(name,vertexShaderTriTerrain,fragmentShaderTriTerrain);
+    if (!shader->isValid())
+    {
+        delete shader;
+        shader = nullptr;
+    }
+    
+    return shader;
+}
+
 static const char *fragmentShaderTriMultiTexRamp = R"(
 precision highp float;
 
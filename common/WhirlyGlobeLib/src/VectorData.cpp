@@ -189,35 +189,36 @@ void SubdivideEdges(const VectorRing3d &inPts,VectorRing3d &outPts,bool closed,f
         outPts.push_back(inPts.back());
 }
 
-void subdivideToSurfaceRecurse(const Point2f &p0,const Point2f &p1,VectorRing &outPts,
-                               const CoordSystemDisplayAdapter *adapter,double eps2,
-                               double prevDist2 = std::numeric_limits<double>::max())
+namespace
 {
-    // If the difference is greater than 180, then this is probably crossing the date line
-    //  in which case we'll just leave it alone.
-    if (std::abs(p0.x() - p1.x()) > M_PI)
-        return;
+// Display location for a geographic point, at the precision of the ring
+inline Point3f SurfaceDisplayPt(const CoordSystemDisplayAdapter *adapter,const CoordSystem *coordSys,const Point2f &pt)
+{
+    return adapter->localToDisplay(coordSys->geographicToLocal(GeoCoord(pt.x(),pt.y())));
+}
 
-    const auto coordSys = adapter->getCoordSystem();
-    const Point3f dp0 = adapter->localToDisplay(coordSys->geographicToLocal(GeoCoord(p0.x(),p0.y())));
-    const Point3f dp1 = adapter->localToDisplay(coordSys->geographicToLocal(GeoCoord(p1.x(),p1.y())));
-    const Point2f midPt = (p0+p1)/2.0;
-    const Point3f dMidPt = adapter->localToDisplay(coordSys->geographicToLocal(GeoCoord(midPt.x(),midPt.y())));
-    const Point3f halfPt = (dp0+dp1)/2.0;
-    const auto dist2 = (halfPt-dMidPt).squaredNorm();
-    // Recurse until the distance threshold is met, or until the distance stops decreasing
-    if (dist2 > eps2 && dist2 < prevDist2)
-    {
-        subdivideToSurfaceRecurse(p0, midPt, outPts, adapter, eps2, dist2);
-        subdivideToSurfaceRecurse(midPt, p1, outPts, adapter, eps2, dist2);
-    }
-    if (outPts.empty() || outPts.back() != p1)
-         outPts.push_back(p1);
+inline Point3d SurfaceDisplayPt(const CoordSystemDisplayAdapter *adapter,const CoordSystem *coordSys,const Point3d &pt)
+{
+    return adapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord(pt.x(),pt.y())));
 }
 
-void subdivideToSurfaceRecurse(const Point3d &p0,const Point3d &p1,VectorRing3d &outPts,
-                               const CoordSystemDisplayAdapter *adapter,double eps2,
-                               double prevDist2 = std::numeric_limits<double>::max())
+// A piece of an edge waiting to be checked, or just an end point waiting to go out
+template <typename TPt,typename TDisp>
+struct SurfaceStep
+{
+    TPt p0,p1;
+    TDisp dp0,dp1;
+    double prevDist2;
+    bool emitOnly;
+};
+
+// Break up an edge until the geographic midpoints are close enough to the display midpoints,
+//  or until that stops getting any better.
+// This works through a stack rather than recursing and converts each new point to display once.
+template <typename TRing,typename TPt,typename TDisp>
+void SubdivideToSurfaceEdge(const TPt &p0,const TPt &p1,TRing &outPts,
+                            const CoordSystemDisplayAdapter *adapter,double eps2,
+                            std::vector<SurfaceStep<TPt,TDisp>> &steps)
 {
     // If the difference is greater than 180, then this is probably crossing the date line
     //  in which case we'll just leave it alone.
@@ -225,45 +226,67 @@ void subdivideToSurfaceRecurse(const Point3d &p0,const Point3d &p1,VectorRing3d
         return;
 
     const auto coordSys = adapter->getCoordSystem();
-    const Point3d dp0 = adapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord(p0.x(),p0.y())));
-    const Point3d dp1 = adapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord(p1.x(),p1.y())));
-    const Point3d midPt = (p0+p1)/2.0;
-    const Point3d dMidPt = adapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord(midPt.x(),midPt.y())));
-    const Point3d halfPt = (dp0+dp1)/2.0;
-    const auto dist2 = (halfPt-dMidPt).squaredNorm();
-    // Recurse until the distance threshold is met, or until the distance stops decreasing
-    if (dist2 > eps2 && dist2 < prevDist2)
+    steps.clear();
+    steps.push_back({p0,p1,SurfaceDisplayPt(adapter,coordSys,p0),SurfaceDisplayPt(adapter,coordSys,p1),
+                     std::numeric_limits<double>::max(),false});
+    while (!steps.empty())
     {
-        subdivideToSurfaceRecurse(p0, midPt, outPts, adapter, eps2, dist2);
-        subdivideToSurfaceRecurse(midPt, p1, outPts, adapter, eps2, dist2);
+        const SurfaceStep<TPt,TDisp> step = steps.back();
+        steps.pop_back();
+
+        if (!step.emitOnly)
+        {
+            const TPt midPt = (step.p0+step.p1)/2.0;
+            const TDisp dMidPt = SurfaceDisplayPt(adapter,coordSys,midPt);
+            const TDisp halfPt = (step.dp0+step.dp1)/2.0;
+            const auto dist2 = (halfPt-dMidPt).squaredNorm();
+            if (dist2 > eps2 && dist2 < step.prevDist2)
+            {
+                // Last in, first out, so the first half goes on top
+                steps.push_back({step.p0,step.p1,step.dp0,step.dp1,dist2,true});
+                steps.push_back({midPt,step.p1,dMidPt,step.dp1,dist2,false});
+                steps.push_back({step.p0,midPt,step.dp0,dMidPt,dist2,false});
+                continue;
+            }
+        }
+
+        if (outPts.empty() || outPts.back() != step.p1)
+            outPts.push_back(step.p1);
     }
-    outPts.push_back(p1);
+}
 }
 
 void SubdivideEdgesToSurface(const VectorRing &inPts,VectorRing &outPts,bool closed,
         const CoordSystemDisplayAdapter *adapter,float eps)
 {
+    if (inPts.empty())
+        return;
     const auto eps2 = (double)eps * eps;
+    std::vector<SurfaceStep<Point2f,Point3f>> steps;
     for (int ii=0;ii<(closed ? inPts.size() : inPts.size()-1);ii++)
     {
         const Point2f &p0 = inPts[ii];
         const Point2f &p1 = inPts[(ii+1)%inPts.size()];
         if (outPts.empty() || outPts.back() != p0)
             outPts.push_back(p0);
-        subdivideToSurfaceRecurse(p0,p1,outPts,adapter,eps2);
+        SubdivideToSurfaceEdge(p0,p1,outPts,adapter,eps2,steps);
     }
 }
 
 void SubdivideEdgesToSurface(const VectorRing3d &inPts,VectorRing3d &outPts,bool closed,
                              const CoordSystemDisplayAdapter *adapter,float eps)
 {
+    if (inPts.empty())
+        return;
     const auto eps2 = (double)eps * eps;
+    std::vector<SurfaceStep<Point3d,Point3d>> steps;
     for (int ii=0;ii<(closed ? inPts.size() : inPts.size()-1);ii++)
     {
         const Point3d &p0 = inPts[ii];
         const Point3d &p1 = inPts[(ii+1)%inPts.size()];
-        outPts.push_back(p0);
-        subdivideToSurfaceRecurse(p0,p1,outPts,adapter,eps2);
+        if (outPts.empty() || outPts.back() != p0)
+            outPts.push_back(p0);
+        SubdivideToSurfaceEdge(p0,p1,outPts,adapter,eps2,steps);
     }
 }
 
@@ -284,6 +307,26 @@ void subdivideToSurfaceRecurseGC(const Point3d &p0,const Point3d &p1,Point3dVect
         outPts.push_back(p1);
 }
 
+// Halvings the recursive version does for an arc of the given angle on the sphere.
+// The pieces of an arc are all alike, so they all stop at the same level.
+static int GreatCircleLevels(double angle,double radius,double eps2,int minPts)
+{
+    static constexpr int MaxLevels = 24;
+    int levels = 0;
+    double prevDist2 = std::numeric_limits<double>::max();
+    for (;levels < MaxLevels;levels++)
+    {
+        // The middle of the chord for a piece sits this far below the sphere
+        const double dist = radius * (1.0 - std::cos(angle / 2.0));
+        const double dist2 = dist * dist;
+        if (!((dist2 > eps2 || (minPts >> levels) > 0) && dist2 < prevDist2))
+            break;
+        prevDist2 = dist2;
+        angle /= 2.0;
+    }
+    return levels;
+}
+
 void SubdivideEdgesToSurfaceGC(const VectorRing &inPts,Point3dVector &outPts,bool closed,
         const CoordSystemDisplayAdapter *adapter,float eps,float surfOffset,int minPts)
 {
@@ -299,18 +342,76 @@ void SubdivideEdgesToSurfaceGC(const VectorRing &inPts,Point3dVector &outPts,boo
     }
 
     const auto eps2 = (double)eps * eps;
-    for (int ii=0;ii<(closed ? inPts.size() : inPts.size()-1);ii++)
+    const bool isFlat = adapter->isFlat();
+    const double radius = 1.0 + surfOffset;
+
+    // Convert all the points to display at once
+    const size_t numPts = inPts.size();
+    Point2dVector geoPts(numPts);
+    for (size_t ii=0;ii<numPts;ii++)
+        geoPts[ii] = Point2d(inPts[ii].x(),inPts[ii].y());
+    Point3dVector dispPts(numPts);
+    coordSys->geographicToLocalBatch(geoPts.data(),dispPts.data(),numPts);
+    adapter->localToDisplayBatch(dispPts.data(),dispPts.data(),numPts);
+    if (!isFlat)
     {
-        const Point2f &p0 = inPts[ii];
-        const Point2f &p1 = inPts[(ii+1)%inPts.size()];
-        Point3d dp0 = adapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord(p0.x(),p0.y())));
-        if (!adapter->isFlat())
-           dp0 = dp0.normalized() * (1.0 + surfOffset);
-        Point3d dp1 = adapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord(p1.x(),p1.y())));
-        if (!adapter->isFlat())
-           dp1 = dp1.normalized() * (1.0 + surfOffset);
+        for (auto &pt : dispPts)
+            pt = pt.normalized() * radius;
+    }
+
+    // On the sphere the midpoints land evenly along the great circle, so we can work out how
+    //  many pieces each edge needs up front and then step along the arcs without recursing.
+    const size_t numEdges = closed ? numPts : numPts-1;
+    std::vector<int> levels(numEdges,-1);
+    size_t total = outPts.size() + numEdges + 1;
+    if (!isFlat)
+    {
+        for (size_t ii=0;ii<numEdges;ii++)
+        {
+            const Point3d &dp0 = dispPts[ii];
+            const Point3d &dp1 = dispPts[(ii+1)%numPts];
+            const double sinLen = dp0.cross(dp1).norm();
+            // Matching or opposite points don't have a well defined arc, so leave those to the recursion
+            if (sinLen < 1e-9 * radius * radius)
+                continue;
+            const double angle = std::atan2(sinLen,dp0.dot(dp1));
+            levels[ii] = GreatCircleLevels(angle,radius,eps2,minPts);
+            total += (1 << levels[ii]) - 1;
+        }
+    }
+    outPts.reserve(total);
+
+    for (size_t ii=0;ii<numEdges;ii++)
+    {
+        const Point3d &dp0 = dispPts[ii];
+        const Point3d &dp1 = dispPts[(ii+1)%numPts];
         outPts.push_back(dp0);
-        subdivideToSurfaceRecurseGC(dp0,dp1,outPts,adapter,eps2,surfOffset,minPts);
+
+        const int edgeLevels = levels[ii];
+        if (edgeLevels < 0)
+        {
+            subdivideToSurfaceRecurseGC(dp0,dp1,outPts,adapter,eps2,surfOffset,minPts);
+            continue;
+        }
+
+        if (edgeLevels > 0)
+        {
+            // Rotate from the start toward the end in the plane of the great circle
+            const int pieces = 1 << edgeLevels;
+            const Point3d perp = (dp1 - dp0 * (dp0.dot(dp1) / (radius * radius))).normalized() * radius;
+            const double angle = std::atan2(dp0.cross(dp1).norm(),dp0.dot(dp1)) / pieces;
+            const double cosStep = std::cos(angle), sinStep = std::sin(angle);
+            double c = 1.0, s = 0.0;
+            for (int pi=1;pi<pieces;pi++)
+            {
+                const double nextC = c * cosStep - s * sinStep;
+                s = s * cosStep + c * sinStep;
+                c = nextC;
+                outPts.push_back(dp0 * c + perp * s);
+            }
+        }
+        if (outPts.back() != dp1)
+            outPts.push_back(dp1);
     }
 }
 
@@ -1197,6 +1298,178 @@ bool VectorParseGeoJSONAssembly(const std::string &str,std::map<std::string,Shap
     return true;
 }
 
+namespace {
+    enum CompactShapeType : uint8_t { CompactLinear, CompactAreal, CompactPoints, CompactOther };
+
+    void writeVarint(std::vector<uint8_t> &data,uint64_t val)
+    {
+        while (val >= 0x80)
+        {
+            data.push_back((uint8_t)(val | 0x80));
+            val >>= 7;
+        }
+        data.push_back((uint8_t)val);
+    }
+
+    uint64_t readVarint(const std::vector<uint8_t> &data,size_t &pos)
+    {
+        uint64_t val = 0;
+        for (int shift = 0; pos < data.size() && shift < 64; shift += 7)
+        {
+            const uint8_t b = data[pos++];
+            val |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                break;
+        }
+        return val;
+    }
+
+    inline uint64_t zigZag(int64_t val) { return ((uint64_t)val << 1) ^ (uint64_t)(val >> 63); }
+    inline int64_t unZigZag(uint64_t val) { return (int64_t)(val >> 1) ^ -(int64_t)(val & 1); }
+}
+
+void CompactShapeSet::setup(const Point2dVector &bounds,int bits)
+{
+    const MbrD mbr(bounds);
+    bits = std::max(1,std::min(bits,32));
+    const double steps = (double)((1ULL << bits) - 1);
+    if (mbr.valid())
+    {
+        org = mbr.ll();
+        const Point2d span = mbr.ur() - mbr.ll();
+        scale = Point2d(span.x() > 0 ? steps / span.x() : 1.0,
+                        span.y() > 0 ? steps / span.y() : 1.0);
+    }
+}
+
+void CompactShapeSet::encodeRing(const VectorRing &ring)
+{
+    writeVarint(data,ring.size());
+    int64_t lastX = 0, lastY = 0;
+    for (const auto &pt : ring)
+    {
+        const int64_t x = llround((pt.x() - org.x()) * scale.x());
+        const int64_t y = llround((pt.y() - org.y()) * scale.y());
+        writeVarint(data,zigZag(x - lastX));
+        writeVarint(data,zigZag(y - lastY));
+        lastX = x;
+        lastY = y;
+    }
+}
+
+void CompactShapeSet::encodeShape(const VectorShapeRef &shape)
+{
+    attrs.push_back(shape->getAttrDictRef());
+    if (const auto lin = dynamic_cast<const VectorLinear *>(shape.get()))
+    {
+        data.push_back(CompactLinear);
+        encodeRing(lin->pts);
+    }
+    else if (const auto ar = dynamic_cast<const VectorAreal *>(shape.get()))
+    {
+        data.push_back(CompactAreal);
+        writeVarint(data,ar->loops.size());
+        for (const auto &loop : ar->loops)
+        {
+            encodeRing(loop);
+        }
+    }
+    else if (const auto pts = dynamic_cast<const VectorPoints *>(shape.get()))
+    {
+        data.push_back(CompactPoints);
+        encodeRing(pts->pts);
+    }
+    else
+    {
+        data.push_back(CompactOther);
+        others.push_back(shape);
+    }
+}
+
+size_t CompactShapeSet::decodeRing(size_t pos,VectorRing &ring) const
+{
+    const size_t count = std::min((size_t)readVarint(data,pos),data.size() - pos);
+    ring.reserve(count);
+    int64_t x = 0, y = 0;
+    for (size_t ii=0;ii<count && pos < data.size();ii++)
+    {
+        x += unZigZag(readVarint(data,pos));
+        y += unZigZag(readVarint(data,pos));
+        ring.emplace_back(org.x() + x / scale.x(),org.y() + y / scale.y());
+    }
+    return pos;
+}
+
+template <typename TFunc>
+void CompactShapeSet::decodeAll(TFunc &&addFn) const
+{
+    size_t pos = 0;
+    size_t other = 0;
+    for (const auto &attr : attrs)
+    {
+        if (pos >= data.size())
+            break;
+        switch (data[pos++])
+        {
+            case CompactLinear:
+            {
+                auto lin = VectorLinear::createLinear();
+                pos = decodeRing(pos,lin->pts);
+                lin->initGeoMbr();
+                lin->setAttrDict(attr);
+                addFn(lin);
+                break;
+            }
+            case CompactAreal:
+            {
+                auto ar = VectorAreal::createAreal();
+                const size_t numLoops = std::min((size_t)readVarint(data,pos),data.size() - pos);
+                ar->loops.resize(numLoops);
+                for (auto &loop : ar->loops)
+                {
+                    pos = decodeRing(pos,loop);
+                }
+                ar->initGeoMbr();
+                ar->setAttrDict(attr);
+                addFn(ar);
+                break;
+            }
+            case CompactPoints:
+            {
+                auto pts = VectorPoints::createPoints();
+                pos = decodeRing(pos,pts->pts);
+                pts->initGeoMbr();
+                pts->setAttrDict(attr);
+                addFn(pts);
+                break;
+            }
+            default:
+                if (other < others.size())
+                    addFn(others[other++]);
+                break;
+        }
+    }
+}
+
+void CompactShapeSet::decode(std::vector<VectorShapeRef> &shapes) const
+{
+    shapes.reserve(shapes.size() + attrs.size());
+    decodeAll([&](VectorShapeRef shape) { shapes.push_back(std::move(shape)); });
+}
+
+void CompactShapeSet::decode(ShapeSet &shapes) const
+{
+    shapes.reserve(shapes.size() + attrs.size());
+    decodeAll([&](VectorShapeRef shape) { shapes.insert(std::move(shape)); });
+}
+
+size_t CompactShapeSet::getBytes() const
+{
+    return sizeof(*this) + data.capacity() +
+           attrs.capacity() * sizeof(MutableDictionaryRef) +
+           others.capacity() * sizeof(VectorShapeRef);
+}
+
 //#define LOW_LEVEL_UNIT_TESTS
 #if defined(LOW_LEVEL_UNIT_TESTS)
 static struct UnitTests {
@@ -0,0 +1,223 @@
+/*  VectorLOD.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <cmath>
+#import <algorithm>
+#import "VectorLOD.h"
+#import "SharedAttributes.h"
+#import "BaseInfo.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    // Each simplified level covers this many zoom levels
+    constexpr double LODZoomStep = 2.0;
+    // Spherical Mercator stops here
+    constexpr double MaxMercatorLat = 1.4844222297453323;
+
+    template <typename T> Point2d toMercator(const T &pt)
+    {
+        const double lat = std::max(-MaxMercatorLat,std::min((double)pt.y(),MaxMercatorLat));
+        return { (double)pt.x(), std::log(std::tan(M_PI/4.0 + lat/2.0)) };
+    }
+
+    double segDist2(const Point2d &pt,const Point2d &p0,const Point2d &p1)
+    {
+        const Point2d dir = p1 - p0;
+        const double len2 = dir.squaredNorm();
+        const double t = (len2 > 0.0) ? std::max(0.0,std::min(1.0,(pt - p0).dot(dir) / len2)) : 0.0;
+        return (p0 + t * dir - pt).squaredNorm();
+    }
+
+    // Mark the points to keep between two we're already keeping
+    void simplifyRange(const std::vector<Point2d> &pts,size_t start,size_t end,double eps2,std::vector<char> &keep)
+    {
+        std::vector<std::pair<size_t,size_t>> stack;
+        stack.emplace_back(start,end);
+        while (!stack.empty())
+        {
+            const auto range = stack.back();
+            stack.pop_back();
+
+            double maxDist2 = 0.0;
+            size_t maxIdx = 0;
+            for (size_t ii=range.first+1;ii<range.second;ii++)
+            {
+                const double dist2 = segDist2(pts[ii],pts[range.first],pts[range.second]);
+                if (dist2 > maxDist2)
+                {
+                    maxDist2 = dist2;
+                    maxIdx = ii;
+                }
+            }
+            if (maxDist2 > eps2)
+            {
+                keep[maxIdx] = 1;
+                stack.emplace_back(range.first,maxIdx);
+                stack.emplace_back(maxIdx,range.second);
+            }
+        }
+    }
+
+    template <typename T> void simplify(const T &inPts,T &outPts,bool closed,double eps)
+    {
+        outPts.clear();
+        const size_t numPts = inPts.size();
+        if (numPts < 3 || eps <= 0.0)
+        {
+            outPts = inPts;
+            return;
+        }
+
+        std::vector<Point2d> pts;
+        pts.reserve(numPts);
+        for (const auto &pt : inPts)
+            pts.push_back(toMercator(pt));
+
+        std::vector<char> keep(numPts,0);
+        keep[0] = keep[numPts-1] = 1;
+        if (closed)
+        {
+            // The ends may be the same point, so split on the one farthest from the start
+            size_t far = 0;
+            double farDist2 = 0.0;
+            for (size_t ii=1;ii<numPts-1;ii++)
+            {
+                const double dist2 = (pts[ii] - pts[0]).squaredNorm();
+                if (dist2 > farDist2)
+                {
+                    farDist2 = dist2;
+                    far = ii;
+                }
+            }
+            if (far == 0)
+                return;
+            keep[far] = 1;
+            simplifyRange(pts,0,far,eps*eps,keep);
+            simplifyRange(pts,far,numPts-1,eps*eps,keep);
+        }
+        else
+        {
+            simplifyRange(pts,0,numPts-1,eps*eps,keep);
+        }
+
+        outPts.reserve(std::count(keep.begin(),keep.end(),1));
+        for (size_t ii=0;ii<numPts;ii++)
+            if (keep[ii])
+                outPts.push_back(inPts[ii]);
+
+        // Not enough left to have any area
+        const size_t minPts = (inPts.front() == inPts.back()) ? 4 : 3;
+        if (closed && outPts.size() < minPts)
+            outPts.clear();
+    }
+}
+
+VectorLODSettings::VectorLODSettings(const Dictionary &dict)
+{
+    levels = std::max(0,dict.getInt(MaplyVecLODLevels,levels));
+    maxZoom = dict.getDouble(MaplyVecLODMaxZoom,maxZoom);
+    tolerance = dict.getDouble(MaplyVecLODTolerance,tolerance);
+}
+
+std::vector<VectorLOD> CalcVectorLODs(const VectorLODSettings &settings,double minZoomVis,double maxZoomVis)
+{
+    std::vector<VectorLOD> lods;
+    for (int level=0;level<=settings.levels;level++)
+    {
+        // Full detail at the top, then progressively simpler on the way down
+        const double bottomZoom = settings.maxZoom - level * LODZoomStep;
+        const double topZoom = bottomZoom + LODZoomStep;
+        VectorLOD lod;
+        lod.minZoomVis = (level == settings.levels) ? minZoomVis : bottomZoom;
+        lod.maxZoomVis = (level == 0) ? maxZoomVis : topZoom;
+        // Good enough for the most detailed zoom level it covers
+        lod.eps = (level == 0) ? 0.0 : settings.tolerance * 2.0 * M_PI / (settings.tileSize * std::pow(2.0,topZoom));
+
+        // Clip to what the caller asked for
+        if (minZoomVis != DrawVisibleInvalid && (lod.minZoomVis == DrawVisibleInvalid || lod.minZoomVis < minZoomVis))
+            lod.minZoomVis = minZoomVis;
+        if (maxZoomVis != DrawVisibleInvalid && (lod.maxZoomVis == DrawVisibleInvalid || lod.maxZoomVis > maxZoomVis))
+            lod.maxZoomVis = maxZoomVis;
+        if (lod.minZoomVis != DrawVisibleInvalid && lod.maxZoomVis != DrawVisibleInvalid &&
+            lod.minZoomVis >= lod.maxZoomVis)
+            continue;
+
+        lods.push_back(lod);
+    }
+    return lods;
+}
+
+void SimplifyLine(const VectorRing &inPts,VectorRing &outPts,bool closed,double eps)
+{
+    simplify(inPts,outPts,closed,eps);
+}
+
+void SimplifyLine(const VectorRing3d &inPts,VectorRing3d &outPts,bool closed,double eps)
+{
+    simplify(inPts,outPts,closed,eps);
+}
+
+void SimplifyShapes(const std::vector<VectorShapeRef> &inShapes,double eps,std::vector<VectorShapeRef> &outShapes)
+{
+    outShapes.reserve(outShapes.size() + inShapes.size());
+    for (const auto &shape : inShapes)
+    {
+        if (const auto lin = std::dynamic_pointer_cast<VectorLinear>(shape))
+        {
+            auto newLin = VectorLinear::createLinear();
+            SimplifyLine(lin->pts,newLin->pts,false,eps);
+            newLin->setAttrDict(lin->getAttrDictRef());
+            newLin->initGeoMbr();
+            outShapes.push_back(newLin);
+        }
+        else if (const auto lin3d = std::dynamic_pointer_cast<VectorLinear3d>(shape))
+        {
+            auto newLin = VectorLinear3d::createLinear();
+            SimplifyLine(lin3d->pts,newLin->pts,false,eps);
+            newLin->setAttrDict(lin3d->getAttrDictRef());
+            newLin->initGeoMbr();
+            outShapes.push_back(newLin);
+        }
+        else if (const auto ar = std::dynamic_pointer_cast<VectorAreal>(shape))
+        {
+            auto newAr = VectorAreal::createAreal();
+            newAr->loops.reserve(ar->loops.size());
+            for (const auto &loop : ar->loops)
+            {
+                VectorRing newLoop;
+                SimplifyLine(loop,newLoop,true,eps);
+                if (!newLoop.empty())
+                    newAr->loops.push_back(std::move(newLoop));
+                else if (newAr->loops.empty())
+                    break;      // Outer loop is gone, so the holes don't matter
+            }
+            if (newAr->loops.empty())
+                continue;
+            newAr->setAttrDict(ar->getAttrDictRef());
+            newAr->initGeoMbr();
+            outShapes.push_back(newAr);
+        }
+        else
+        {
+            outShapes.push_back(shape);
+        }
+    }
+}
+
+}
@@ -46,6 +46,7 @@ VectorInfo::VectorInfo(const Dictionary &dict)
     lineWidth = (float)dict.getDouble(MaplyVecWidth,lineWidth);
     centered = dict.getBool(MaplyVecCentered,centered);
     closeAreals = dict.getBool(MaplyVecCloseAreals, closeAreals);
+    lod = VectorLODSettings(dict);
 
     const auto sampleVal = (float)dict.getDouble("sample", 0.0);
     sample = (sampleVal > 0) ? sampleVal : (dict.getBool("sample",sample) ? 0.1f : 0.0f);
@@ -101,6 +102,32 @@ void VectorSceneRep::clear(ChangeSet &changes)
     drawIDs.clear();
 }
 
+/* Convert a run of geographic points, offset by the center, to local and display coordinates.
+ This goes through the batch conversions rather than a couple of virtual calls per point.
+ The vectors are scratch space, kept by the builders so they can be reused.
+ */
+template <typename T>
+static void ConvertToDisplay(const CoordSystemDisplayAdapter *coordAdapter,const T *pts,size_t count,
+                             const Point2d &geoCenter,bool localCoords,std::vector<Point2d> &geoPts,
+                             std::vector<Point3d> &localPts,std::vector<Point3d> &dispPts)
+{
+    geoPts.resize(count);
+    localPts.resize(count);
+    dispPts.resize(count);
+    for (size_t ii=0;ii<count;ii++)
+        geoPts[ii] = Point2d(pts[ii].x()+geoCenter.x(),pts[ii].y()+geoCenter.y());
+    if (localCoords)
+    {
+        for (size_t ii=0;ii<count;ii++)
+            localPts[ii] = Pad(geoPts[ii]);
+    }
+    else
+    {
+        coordAdapter->getCoordSystem()->geographicToLocalBatch(geoPts.data(),localPts.data(),count);
+    }
+    coordAdapter->localToDisplayBatch(localPts.data(),dispPts.data(),count);
+}
+
 /* Drawable Builder
  Used to construct drawables with multiple shapes in them.
  Eventually, we'll move this out to be a more generic object.
@@ -146,7 +173,6 @@ public:
     void addPoints(const VectorRing &pts,bool closed,const MutableDictionaryRef &attrs, bool localCoords)
     {
         const CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
-        const CoordSystem *coordSys = coordAdapter->getCoordSystem();
         const RGBAColor ringColor = attrs->getColor(MaplyColor, vecInfo->color);
         
         // Decide if we'll appending to an existing drawable or create a new one
@@ -167,19 +193,21 @@ public:
             drawable->setLineWidth(vecInfo->lineWidth);
             drawable->setColorExpression(vecInfo->colorExp);
             drawable->setOpacityExpression(vecInfo->opacityExp);
+            if (centerValid)
+                drawable->setCenter(center);
         }
         drawMbr.addPoints(pts);
+
+        // Convert to real world coordinates and offset from the globe
+        ConvertToDisplay(coordAdapter,pts.data(),pts.size(),geoCenter,localCoords,geoPts,localPts,dispPts);
         
         Point3f prevPt,prevNorm,firstPt,firstNorm;
         for (unsigned int jj=0;jj<pts.size();jj++)
         {
-            // Convert to real world coordinates and offset from the globe
-            const Point2f &geoPt = pts[jj];
-            const Point2d geoCoordD(geoPt.x()+geoCenter.x(),geoPt.y()+geoCenter.y());
-            const Point3d localPt = localCoords ? Pad(geoCoordD) : coordSys->geographicToLocal(geoCoordD);
+            const Point3d &localPt = localPts[jj];
             const Point3d norm3d = coordAdapter->normalForLocal(localPt);
             const Point3f norm = norm3d.cast<float>();
-            const Point3d pt3d = coordAdapter->localToDisplay(localPt) - center;
+            const Point3d pt3d = dispPts[jj] - center;
             const Point3f pt = pt3d.cast<float>();
             
             // Add to drawable
@@ -234,12 +262,6 @@ public:
             {
                 drawable->setLocalMbr(drawMbr);
                 sceneRep->drawIDs.insert(drawable->getDrawableID());
-                if (centerValid)
-                {
-                    const Eigen::Affine3d trans(Eigen::Translation3d(center.x(),center.y(),center.z()));
-                    Matrix4d transMat = trans.matrix();
-                    drawable->setMatrix(&transMat);
-                }
                 
                 if (vecInfo->fadeIn > 0.0)
                 {
@@ -272,6 +294,8 @@ protected:
     Point2d geoCenter;
     bool centerValid;
     const GeometryType primType;
+    std::vector<Point2d> geoPts;
+    std::vector<Point3d> localPts,dispPts;
 };
 
 /* Drawable Builder (Triangle version)
@@ -360,11 +384,9 @@ public:
         addPoints(mesh, attrs, localCoords);
     }
 
-    // This version converts a ring into a mesh (chopping, tessellating, etc...)
-    void addPoints(const std::vector<VectorRing> &rings,const MutableDictionaryRef &attrs, bool localCoords)
+    // Grid subdivision for areals, which is done before tessellation
+    bool gridLoops(const std::vector<VectorRing> &rings,std::vector<VectorRing> &inRings) const
     {
-        // Grid subdivision is done here
-        std::vector<VectorRing> inRings;
         if (vecInfo->subdivEps > 0.0 && vecInfo->gridSubdiv)
         {
             for (const auto & ring : rings)
@@ -373,18 +395,74 @@ public:
                 const Point2f spacing(vecInfo->subdivEps,vecInfo->subdivEps);
                 ClipLoopToGrid(ring, origin, spacing, inRings);
             }
+            return true;
         }
-        else
-        {
-            inRings = rings;
-        }
+        return false;
+    }
+
+    // This version converts a ring into a mesh (chopping, tessellating, etc...)
+    void addPoints(const std::vector<VectorRing> &rings,const MutableDictionaryRef &attrs, bool localCoords)
+    {
+        std::vector<VectorRing> inRings;
+        const bool gridded = gridLoops(rings, inRings);
 
         VectorTrianglesRef mesh(VectorTriangles::createTriangles());
-        TesselateLoops(inRings, mesh);
+        TesselateLoops(gridded ? inRings : rings, mesh);
         
         addPoints(mesh, attrs, localCoords);
     }
 
+    /// Tessellate all the areals in one go, spread over the workers.
+    /// The meshes are picked up by addAreal as we go through the shapes in order.
+    template <typename TIter>
+    void prepareAreals(TIter begin,TIter end,WorkerPool *workers)
+    {
+        std::vector<const VectorAreal *> areals;
+        for (auto it = begin; it != end; ++it)
+        {
+            if (const auto theAreal = dynamic_cast<const VectorAreal *>(it->get()))
+            {
+                areals.push_back(theAreal);
+            }
+        }
+        // Not worth handing out a few
+        if (!workers || areals.size() < 32)
+        {
+            return;
+        }
+
+        std::vector<std::vector<VectorRing>> gridRings(areals.size());
+        std::vector<const std::vector<VectorRing> *> loopSets(areals.size());
+        for (size_t ii = 0; ii < areals.size(); ii++)
+        {
+            loopSets[ii] = gridLoops(areals[ii]->loops, gridRings[ii]) ? &gridRings[ii] : &areals[ii]->loops;
+        }
+
+        std::vector<VectorTrianglesRef> meshes;
+        TesselateLoopsBatch(loopSets, meshes, workers);
+
+        preparedMeshes.reserve(areals.size());
+        for (size_t ii = 0; ii < areals.size(); ii++)
+        {
+            preparedMeshes[areals[ii]] = std::move(meshes[ii]);
+        }
+    }
+
+    // Add a filled areal, using the mesh from prepareAreals if there is one
+    void addAreal(const VectorAreal &areal, bool localCoords)
+    {
+        const auto it = preparedMeshes.find(&areal);
+        if (it != preparedMeshes.end())
+        {
+            addPoints(it->second, areal.getAttrDictRef(), localCoords);
+            preparedMeshes.erase(it);
+        }
+        else
+        {
+            addPoints(areal.loops, areal.getAttrDictRef(), localCoords);
+        }
+    }
+
     void addPoints(const VectorTrianglesRef &mesh, const MutableDictionaryRef &attrs, bool localCoords)
     {
         addPoints(*mesh, attrs, localCoords);
@@ -409,6 +487,9 @@ public:
                 centroid = Slice(coordSys->geographicToLocal(centroid));
             }
         }
+
+        // Convert all the mesh points at once, ahead of going through the triangles
+        ConvertToDisplay(coordAdapter,mesh.pts.data(),mesh.pts.size(),geoCenter,localCoords,geoPts,localPts,dispPts);
         
         for (size_t ir=0;ir<mesh.tris.size();ir++)
         {
@@ -419,6 +500,7 @@ public:
             {
                 continue;
             }
+            const auto &tri = mesh.tris[ir];
 
             // Decide if we'll appending to an existing drawable or create a new one
             if (!drawable ||
@@ -438,6 +520,8 @@ public:
                 drawable->setColor(ringColor);
                 if (vecInfo->texId != EmptyIdentity)
                     drawable->setTexId(0, vecInfo->texId);
+                if (centerValid)
+                    drawable->setCenter(center);
             }
             const unsigned baseVert = drawable->getNumPoints();
             drawMbr.addPoints(pts);
@@ -473,15 +557,13 @@ public:
                 int i = 0;
                 for (const auto &geoPt : pts)
                 {
-                    const Point2d geoCoordD = geoPt.cast<double>() + geoCenter;
-
+                    const int which = tri.pts[i];
                     auto &texCoord = texCoords[i++];
                     switch (vecInfo->texProj)
                     {
                         case TextureProjectionTanPlane:
                         {
-                            const Point3d locPt = localCoords ? Pad(geoCoordD) : coordSys->geographicToLocal(geoCoordD);
-                            const Point3d displayPt = coordAdapter->localToDisplay(locPt) - center;
+                            const Point3d displayPt = dispPts[which] - center;
                             const Point3d dir = displayPt - planeOrg;
                             const Point3d comp(dir.dot(planeX),dir.dot(planeY),dir.dot(planeUp));
                             texCoord = Slice(comp).cast<float>().cwiseProduct(vecInfo->texScale);
@@ -514,16 +596,12 @@ public:
             // Add the points
             for (unsigned int jj=0;jj<ptCount;jj++)
             {
-                // Convert to real world coordinates and offset from the globe
-                const Point2f &geoPt = pts[jj];
-                const Point2d geoCoordD = geoPt.cast<double>() + geoCenter;
-                const Point3d localPt = localCoords ? Pad(geoCoordD) : coordSys->geographicToLocal(geoCoordD);
-                const Point3d norm3d = coordAdapter->normalForLocal(localPt);
+                const int which = tri.pts[jj];
+                const Point3d norm3d = coordAdapter->normalForLocal(localPts[which]);
                 const Point3f norm(norm3d.x(),norm3d.y(),norm3d.z());
-                const Point3d pt3d = coordAdapter->localToDisplay(localPt) - center;
-                const Point3f pt = pt3d.cast<float>();
-                
-                drawable->addPoint(pt);
+
+                // The builder takes the center off
+                drawable->addPoint(dispPts[which]);
                 if (doColor)
                 {
                     drawable->addColor(ringColor);
@@ -557,11 +635,6 @@ public:
                 }
 
                 drawable->setLocalMbr(drawMbr);
-                if (centerValid)
-                {
-                    const Eigen::Affine3d trans(Eigen::Translation3d(center.x(),center.y(),center.z()));
-                    drawable->setMatrix(trans.matrix());
-                }
                 sceneRep->drawIDs.insert(drawable->getDrawableID());
 
                 if (vecInfo->fadeIn > 0.0)
@@ -594,8 +667,37 @@ protected:
     bool centerValid;
     BasicDrawableBuilderRef drawable;
     const VectorInfo *vecInfo;
+    std::unordered_map<const VectorAreal *,VectorTrianglesRef> preparedMeshes;
+    std::vector<Point2d> geoPts;
+    std::vector<Point3d> localPts,dispPts;
 };
 
+void VectorManager::setTessThreads(int numThreads)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    tessThreads = std::max(numThreads,0);
+    tessWorkers = (tessThreads > 0) ? std::make_shared<WorkerPool>(tessThreads) : WorkerPoolRef();
+}
+
+int VectorManager::getTessThreads()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return (tessThreads < 0) ? WorkerPool::getDefaultNumThreads() : tessThreads;
+}
+
+WorkerPoolRef VectorManager::getTessWorkers()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    // Start the default pool the first time it's needed
+    if (tessThreads < 0)
+    {
+        tessThreads = WorkerPool::getDefaultNumThreads();
+        if (tessThreads > 0)
+            tessWorkers = std::make_shared<WorkerPool>(tessThreads);
+    }
+    return tessWorkers;
+}
+
 VectorManager::~VectorManager()
 {
     std::lock_guard<std::mutex> guardLock(lock);
@@ -610,6 +712,11 @@ SimpleIdentity VectorManager::addVectors(const ShapeSet *shapes, const VectorInf
 {
     if (shapes->empty())
         return EmptyIdentity;
+
+    if (vecInfo.lod.levels > 0 && vecInfo.zoomSlot >= 0)
+    {
+        return addVectorLODs(std::vector<VectorShapeRef>(shapes->begin(),shapes->end()),vecInfo,changes);
+    }
     
     auto *sceneRep = new VectorSceneRep();
     sceneRep->fadeOut = (float)vecInfo.fadeOut;
@@ -678,6 +785,11 @@ SimpleIdentity VectorManager::addVectors(const ShapeSet *shapes, const VectorInf
     VectorRing3d tempRing3d;
     constexpr auto localCoords = false;
 
+    if (vecInfo.filled)
+    {
+        drawBuildTri.prepareAreals(shapes->begin(),shapes->end(),getTessWorkers().get());
+    }
+
     for (auto const &it : *shapes)
     {
         if (const auto theAreal = dynamic_cast<VectorAreal*>(it.get()))
@@ -685,7 +797,7 @@ SimpleIdentity VectorManager::addVectors(const ShapeSet *shapes, const VectorInf
             if (vecInfo.filled)
             {
                 // Triangulate outside and loops
-                drawBuildTri.addPoints(theAreal->loops,theAreal->getAttrDictRef(), localCoords);
+                drawBuildTri.addAreal(*theAreal, localCoords);
                 continue;
             }
 
@@ -800,6 +912,14 @@ SimpleIdentity VectorManager::addVectors(const std::vector<VectorShapeRef> *shap
     return shapes ? addVectors(*shapes,vecInfo,changes) : EmptyIdentity;
 }
 
+SimpleIdentity VectorManager::addVectors(const CompactShapeSet &shapes,
+                                         const VectorInfo &vecInfo, ChangeSet &changes)
+{
+    std::vector<VectorShapeRef> decoded;
+    shapes.decode(decoded);
+    return addVectors(decoded,vecInfo,changes);
+}
+
 SimpleIdentity VectorManager::addVectors(const std::vector<VectorShapeRef> &shapes,
                                          const VectorInfo &vecInfo, ChangeSet &changes)
 {
@@ -808,6 +928,11 @@ SimpleIdentity VectorManager::addVectors(const std::vector<VectorShapeRef> &shap
         return EmptyIdentity;
     }
 
+    if (vecInfo.lod.levels > 0 && vecInfo.zoomSlot >= 0)
+    {
+        return addVectorLODs(shapes,vecInfo,changes);
+    }
+
     auto sceneRep = std::make_unique<VectorSceneRep>();
     sceneRep->fadeOut = (float)vecInfo.fadeOut;
 
@@ -877,6 +1002,11 @@ SimpleIdentity VectorManager::addVectors(const std::vector<VectorShapeRef> &shap
     VectorRing newPts;
     VectorRing3d newPts3;
 
+    if (vecInfo.filled)
+    {
+        drawBuildTri.prepareAreals(shapes.begin(),shapes.end(),getTessWorkers().get());
+    }
+
     for (auto const &it : shapes)
     {
         if (const auto theAreal = dynamic_cast<const VectorAreal*>(it.get()))
@@ -884,7 +1014,7 @@ SimpleIdentity VectorManager::addVectors(const std::vector<VectorShapeRef> &shap
             if (vecInfo.filled)
             {
                 // Triangulate outside and loops
-                drawBuildTri.addPoints(theAreal->loops,theAreal->getAttrDictRef(),false);
+                drawBuildTri.addAreal(*theAreal,false);
             }
             else
             {
@@ -973,6 +1103,52 @@ SimpleIdentity VectorManager::addVectors(const std::vector<VectorShapeRef> &shap
     return vecID;
 }
 
+SimpleIdentity VectorManager::addVectorLODs(const std::vector<VectorShapeRef> &shapes,
+                                            const VectorInfo &vecInfo, ChangeSet &changes)
+{
+    VectorInfo lodInfo(vecInfo);
+    lodInfo.lod.levels = 0;
+
+    std::vector<VectorShapeRef> lodShapes;
+    VectorSceneRep *sceneRep = nullptr;
+    for (const auto &lod : CalcVectorLODs(vecInfo.lod,vecInfo.minZoomVis,vecInfo.maxZoomVis))
+    {
+        lodInfo.minZoomVis = lod.minZoomVis;
+        lodInfo.maxZoomVis = lod.maxZoomVis;
+        lodShapes.clear();
+        if (lod.eps > 0.0)
+        {
+            SimplifyShapes(shapes,lod.eps,lodShapes);
+        }
+        const SimpleIdentity lodID = addVectors((lod.eps > 0.0) ? lodShapes : shapes,lodInfo,changes);
+        if (lodID == EmptyIdentity)
+        {
+            continue;
+        }
+
+        // Fold this level into the first one
+        std::lock_guard<std::mutex> guardLock(lock);
+        VectorSceneRep dummyRep(lodID);
+        const auto it = vectorReps.find(&dummyRep);
+        if (it == vectorReps.end())
+        {
+            continue;
+        }
+        if (!sceneRep)
+        {
+            sceneRep = *it;
+            continue;
+        }
+        const VectorSceneRep *lodRep = *it;
+        sceneRep->drawIDs.insert(lodRep->drawIDs.begin(),lodRep->drawIDs.end());
+        sceneRep->instIDs.insert(lodRep->instIDs.begin(),lodRep->instIDs.end());
+        vectorReps.erase(it);
+        delete lodRep;
+    }
+
+    return sceneRep ? sceneRep->getId() : EmptyIdentity;
+}
+
 SimpleIdentity VectorManager::instanceVectors(SimpleIdentity vecID,const VectorInfo &vecInfo,ChangeSet &changes)
 {
     SimpleIdentity newId = EmptyIdentity;
@@ -1029,39 +1205,47 @@ static std::unordered_set<SimpleIdentity> &AllIDs(const VectorSceneRep &rep, std
     return set;
 }
 
-void VectorManager::changeVectors(SimpleIdentity vecID,const VectorInfo &vecInfo,ChangeSet &changes)
+void VectorManager::changeSceneRep(const VectorSceneRep &sceneRep,const VectorInfo &vecInfo,ChangeSet &changes)
 {
+    // Make sure we change both drawables and instances
     std::unordered_set<SimpleIdentity> allIDs;
+    for (const auto id : AllIDs(sceneRep,allIDs))
+    {
+        auto change = new DrawableStyleChangeRequest(id, vecInfo.color, vecInfo.drawPriority, vecInfo.drawOrder);
+        if (vecInfo.minVis != DrawVisibleInvalid || vecInfo.maxVis != DrawVisibleInvalid)
+        {
+            change->setVisibleRange((float)vecInfo.minVis, (float)vecInfo.maxVis);
+        }
+        change->setLineWidth(vecInfo.lineWidth);
+        changes.push_back(change);
+    }
+}
 
+void VectorManager::changeVectors(SimpleIdentity vecID,const VectorInfo &vecInfo,ChangeSet &changes)
+{
     std::lock_guard<std::mutex> guardLock(lock);
 
     VectorSceneRep dummyRep(vecID);
     const auto it = vectorReps.find(&dummyRep);
     if (it != vectorReps.end())
     {
-        const VectorSceneRep *sceneRep = *it;
+        changeSceneRep(**it,vecInfo,changes);
+    }
+}
 
-        // Make sure we change both drawables and instances
-        allIDs.clear();
-        for (const auto id : AllIDs(*sceneRep,allIDs))
+void VectorManager::changeVectors(const std::unordered_map<SimpleIdentity,VectorInfoRef> &vecInfos,ChangeSet &changes)
+{
+    changes.reserve(changes.size() + vecInfos.size());
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    for (const auto &entry : vecInfos)
+    {
+        VectorSceneRep dummyRep(entry.first);
+        const auto it = vectorReps.find(&dummyRep);
+        if (it != vectorReps.end() && entry.second)
         {
-            // Changed color
-            changes.push_back(new ColorChangeRequest(id, vecInfo.color));
-            
-            // Changed visibility
-            if (vecInfo.minVis != DrawVisibleInvalid || vecInfo.maxVis != DrawVisibleInvalid)
-            {
-                changes.push_back(new VisibilityChangeRequest(id, (float)vecInfo.minVis, (float)vecInfo.maxVis));
-            }
-            
-            // Changed line width
-            changes.push_back(new LineWidthChangeRequest(id, vecInfo.lineWidth));
-            
-            // Changed draw priority
-            changes.push_back(new DrawPriorityChangeRequest(id, vecInfo.drawPriority));
-            
-            // Changed draw order
-            changes.push_back(new DrawOrderChangeRequest(id, vecInfo.drawOrder));
+            changeSceneRep(**it,*entry.second,changes);
         }
     }
 }
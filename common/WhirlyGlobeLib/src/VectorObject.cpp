@@ -23,11 +23,13 @@
 #import "Tesselator.h"
 #import "GridClipper.h"
 #import "WhirlyKitLog.h"
+#import "PerformanceTimer.h"
 #import "GlobeView.h"
 #import "MaplyView.h"
 
 #import "GeographicLib/Geocentric.hpp"
 #import "GeographicLib/Geodesic.hpp"
+#import "GeographicLib/GeodesicLine.hpp"
 #import "GeographicLib.h"
 
 namespace WhirlyKit
@@ -64,11 +66,10 @@ bool VectorObject::FromGeoJSONAssembly(const std::string &json,std::map<std::str
     if (!VectorParseGeoJSONAssembly(json, newShapes))
         return false;
     
-    for (auto const &it : newShapes)
+    for (auto &it : newShapes)
     {
         auto *vecObj = new VectorObject();
-        vecObj->shapes.reserve(vecObj->shapes.size() + it.second.size());
-        vecObj->shapes.insert(it.second.begin(),it.second.end());
+        vecObj->shapes.swap(it.second);
         vecData[it.first] = vecObj;
     }
     
@@ -83,11 +84,10 @@ bool VectorObject::FromGeoJSONAssembly(const std::string &json,std::map<std::str
     if (!VectorParseGeoJSONAssembly(json, newShapes))
         return false;
 
-    for (auto const &it : newShapes)
+    for (auto &it : newShapes)
     {
         auto vecObj = std::make_shared<VectorObject>();
-        vecObj->shapes.reserve(vecObj->shapes.size() + it.second.size());
-        vecObj->shapes.insert(it.second.begin(),it.second.end());
+        vecObj->shapes.swap(it.second);
         vecData[it.first] = std::move(vecObj);
     }
 
@@ -116,6 +116,7 @@ MutableDictionaryRef VectorObject::getAttributes() const
 
 void VectorObject::setAttributes(const MutableDictionaryRef &newDict)
 {
+    unshareShapes();
     for (const auto &shape : shapes)
     {
         shape->setAttrDict(newDict);
@@ -124,8 +125,24 @@ void VectorObject::setAttributes(const MutableDictionaryRef &newDict)
 
 void VectorObject::mergeVectorsFrom(const VectorObject &otherVec)
 {
-    shapes.reserve(otherVec.shapes.size());
+    shapes.reserve(shapes.size() + otherVec.shapes.size());
     shapes.insert(otherVec.shapes.begin(),otherVec.shapes.end());
+    sharedShapes |= otherVec.sharedShapes;
+}
+
+void VectorObject::mergeVectorsFrom(VectorObject &&otherVec)
+{
+    if (shapes.empty())
+    {
+        shapes.swap(otherVec.shapes);
+    }
+    else
+    {
+        shapes.reserve(shapes.size() + otherVec.shapes.size());
+        shapes.insert(std::make_move_iterator(otherVec.shapes.begin()),std::make_move_iterator(otherVec.shapes.end()));
+        otherVec.shapes.clear();
+    }
+    sharedShapes |= otherVec.sharedShapes;
 }
 
 void VectorObject::splitVectors(std::vector<VectorObject *> &vecs)
@@ -603,6 +620,34 @@ static inline bool checkBounds(const Point2f &screenCoord, const GeoCoord &geoCo
     return itemMbr.overlaps(searchMbr);
 }
 
+bool VectorObject::nearSearchBounds(const Point2d &coord,float maxDistance,
+                                    const ViewStateRef &viewState,const Point2f &frameSize,
+                                    GeoMbr &bounds)
+{
+    CoordSystemDisplayAdapter *coordAdapter = viewState->coordAdapter;
+
+    const auto globeView = dynamic_cast<WhirlyGlobe::GlobeViewState*>(viewState.get());
+    const auto mapView = dynamic_cast<Maply::MapViewState*>(viewState.get());
+
+    const Eigen::Matrix4d &modelAndViewMat4d = viewState->viewMatrices[0] * viewState->modelMatrix;
+    const Eigen::Matrix4f &modelAndViewMat = Matrix4dToMatrix4f(modelAndViewMat4d);
+    const Eigen::Matrix4f &modelAndViewNormalMat = modelAndViewMat.inverse().transpose();
+    const Eigen::Matrix4d &modelMatFull = viewState->fullMatrices[0];
+
+    Point2d p;
+    if (!ScreenPointFromGeo(coord, globeView, mapView, coordAdapter, frameSize, modelAndViewMat,
+                            modelAndViewMat4d, modelMatFull, modelAndViewNormalMat, &p))
+    {
+        return false;
+    }
+
+    const GeoCoord geoCoord(coord.x(),coord.y());
+    bounds = GeoMbr(geoCoord, geoCoord);
+    expandBound(bounds, p.cast<float>(), mapView, globeView,
+                coordAdapter, modelMatFull, frameSize, maxDistance);
+    return true;
+}
+
 bool VectorObject::pointNearLinear(const Point2d &coord,float maxDistance,
                                    const ViewStateRef &viewState,const Point2f &frameSize) const
 {
@@ -795,8 +840,17 @@ bool VectorObject::boundingBox(Point2d &ll,Point2d &ur) const
     return false;
 }
 
+void VectorObject::uncompact(const CompactShapeSet &compactShapes)
+{
+    shapes.clear();
+    compactShapes.decode(shapes);
+    sharedShapes = false;
+}
+
 void VectorObject::addHole(const VectorRing &hole)
 {
+    unshareShapes();
+
     if (shapes.empty())
     {
         return;
@@ -808,6 +862,49 @@ void VectorObject::addHole(const VectorRing &hole)
     }
 }
 
+VectorShapeRef VectorObject::CopyShape(const VectorShape *shape,bool copyAttrs)
+{
+    const auto attrs = [&](const VectorShape *src) {
+        return copyAttrs ? src->getAttrDict()->copy() : src->getAttrDictRef();
+    };
+
+    if (const auto points = dynamic_cast<const VectorPoints*>(shape))
+    {
+        const auto newPts = VectorPoints::createPoints();
+        newPts->pts = points->pts;
+        newPts->setAttrDict(attrs(points));
+        newPts->initGeoMbr();
+        return newPts;
+    } else if (const auto lin = dynamic_cast<const VectorLinear*>(shape)) {
+        const auto newLin = VectorLinear::createLinear();
+        newLin->pts = lin->pts;
+        newLin->setAttrDict(attrs(lin));
+        newLin->initGeoMbr();
+        return newLin;
+    } else if (const auto lin3d = dynamic_cast<const VectorLinear3d*>(shape)) {
+        const auto newLin3d = VectorLinear3d::createLinear();
+        newLin3d->pts = lin3d->pts;
+        newLin3d->setAttrDict(attrs(lin3d));
+        newLin3d->initGeoMbr();
+        return newLin3d;
+    } else if (const auto ar = dynamic_cast<const VectorAreal*>(shape)) {
+        const auto newAr = VectorAreal::createAreal();
+        newAr->loops = ar->loops;
+        newAr->setAttrDict(attrs(ar));
+        newAr->initGeoMbr();
+        return newAr;
+    } else if (const auto tri = dynamic_cast<const VectorTriangles*>(shape)) {
+        const auto newTri = VectorTriangles::createTriangles();
+        newTri->geoMbr = tri->geoMbr;
+        newTri->pts = tri->pts;
+        newTri->tris = tri->tris;
+        newTri->setAttrDict(attrs(tri));
+        newTri->initGeoMbr();
+        return newTri;
+    }
+    return VectorShapeRef();
+}
+
 VectorObjectRef VectorObject::deepCopy() const
 {
     auto newVecObj = std::make_shared<VectorObject>();
@@ -815,46 +912,49 @@ VectorObjectRef VectorObject::deepCopy() const
 
     for (const auto &shapeRef : shapes)
     {
-        const auto shape = shapeRef.get();
-        if (const auto points = dynamic_cast<VectorPoints*>(shape))
+        if (auto newShape = CopyShape(shapeRef.get(), true))
         {
-            const auto newPts = VectorPoints::createPoints();
-            newPts->pts = points->pts;
-            newPts->setAttrDict(points->getAttrDict()->copy());
-            newPts->initGeoMbr();
-            newVecObj->shapes.insert(newPts);
-        } else if (const auto lin = dynamic_cast<VectorLinear*>(shape)) {
-            const auto newLin = VectorLinear::createLinear();
-            newLin->pts = lin->pts;
-            newLin->setAttrDict(lin->getAttrDict()->copy());
-            newLin->initGeoMbr();
-            newVecObj->shapes.insert(newLin);
-        } else if (const auto lin3d = dynamic_cast<VectorLinear3d*>(shape)) {
-            const auto newLin3d = VectorLinear3d::createLinear();
-            newLin3d->pts = lin3d->pts;
-            newLin3d->setAttrDict(lin3d->getAttrDict()->copy());
-            newLin3d->initGeoMbr();
-            newVecObj->shapes.insert(newLin3d);
-        } else if (const auto ar = dynamic_cast<VectorAreal*>(shape)) {
-            const auto newAr = VectorAreal::createAreal();
-            newAr->loops = ar->loops;
-            newAr->setAttrDict(ar->getAttrDict()->copy());
-            newAr->initGeoMbr();
-            newVecObj->shapes.insert(newAr);
-        } else if (const auto tri = dynamic_cast<VectorTriangles*>(shape)) {
-            const auto newTri = VectorTriangles::createTriangles();
-            newTri->geoMbr = tri->geoMbr;
-            newTri->pts = tri->pts;
-            newTri->tris = tri->tris;
-            newTri->setAttrDict(tri->getAttrDict()->copy());
-            newTri->initGeoMbr();
-            newVecObj->shapes.insert(newTri);
+            newVecObj->shapes.insert(std::move(newShape));
         }
     }
     
     return newVecObj;
 }
 
+VectorObjectRef VectorObject::copyOnWrite() const
+{
+    auto newVecObj = std::make_shared<VectorObject>();
+    newVecObj->shapes = shapes;
+    newVecObj->selectable = selectable;
+    newVecObj->sharedShapes = true;
+    sharedShapes = true;
+
+    return newVecObj;
+}
+
+void VectorObject::unshareShapes()
+{
+    if (!sharedShapes)
+        return;
+    sharedShapes = false;
+
+    // Anything only we have a reference to is ours to change
+    ShapeSet newShapes(shapes.size());
+    for (const auto &shapeRef : shapes)
+    {
+        if (shapeRef.use_count() > 1)
+        {
+            if (auto newShape = CopyShape(shapeRef.get(), false))
+            {
+                newShapes.insert(std::move(newShape));
+                continue;
+            }
+        }
+        newShapes.insert(shapeRef);
+    }
+    shapes.swap(newShapes);
+}
+
 VectorObjectType VectorObject::getVectorType() const
 {
     if (shapes.empty())
@@ -958,45 +1058,51 @@ std::string VectorObject::log() const
     return outStr;
 }
     
+// Scale the points on the way in to reproject
+static inline Point3d ReprojectIn(const Point2f &pt,double scale) { return {pt.x()*scale,pt.y()*scale,0.0}; }
+static inline Point3d ReprojectIn(const Point3f &pt,double scale) { return {pt.x()*scale,pt.y()*scale,pt.z()}; }
+static inline Point3d ReprojectIn(const Point3d &pt,double scale) { return pt * scale; }
+static inline void ReprojectOut(const Point3d &in,double outScale,Point2f &pt) { pt = Point2f(in.x()*outScale,in.y()*outScale); }
+static inline void ReprojectOut(const Point3d &in,double,Point3f &pt) { pt = in.cast<float>(); }
+static inline void ReprojectOut(const Point3d &in,double,Point3d &pt) { pt = in; }
+
+// Convert a whole run of points in one batch, reusing the buffer
+template <typename PtVector>
+static void ReprojectPoints(const CoordSystem *inSystem,double scale,const CoordSystem *outSystem,
+                            PtVector &pts,double outScale,std::vector<Point3d> &buf)
+{
+    buf.resize(pts.size());
+    for (size_t ii=0;ii<pts.size();ii++)
+        buf[ii] = ReprojectIn(pts[ii],scale);
+    CoordSystemConvertBatch(inSystem,outSystem,buf.data(),buf.data(),buf.size());
+    for (size_t ii=0;ii<pts.size();ii++)
+        ReprojectOut(buf[ii],outScale,pts[ii]);
+}
+
 void VectorObject::reproject(CoordSystem *inSystem,double scale,CoordSystem *outSystem)
 {
+    unshareShapes();
+
+    std::vector<Point3d> buf;
     for (const auto &shapeRef : shapes)
     {
         const auto shape = shapeRef.get();
         if (const auto points = dynamic_cast<VectorPoints*>(shape))
         {
-            for (Point2f &pt : points->pts)
-            {
-                const Point3f outPt = CoordSystemConvert(inSystem, outSystem, Point3f(pt.x()*scale,pt.y()*scale,0.0));
-                pt.x() = outPt.x();  pt.y() = outPt.y();
-            }
+            ReprojectPoints(inSystem,scale,outSystem,points->pts,1.0,buf);
             points->calcGeoMbr();
         } else if (const auto lin = dynamic_cast<VectorLinear*>(shape)) {
-            for (Point2f &pt : lin->pts)
-            {
-                const Point3f outPt = CoordSystemConvert(inSystem, outSystem, Point3f(pt.x()*scale,pt.y()*scale,0.0));
-                pt.x() = outPt.x();  pt.y() = outPt.y();
-            }
+            ReprojectPoints(inSystem,scale,outSystem,lin->pts,1.0,buf);
             lin->calcGeoMbr();
         } else if (const auto lin3d = dynamic_cast<VectorLinear3d*>(shape)) {
-            for (Point3d &pt : lin3d->pts)
-            {
-                const Point3d outPt = CoordSystemConvert3d(inSystem, outSystem, pt * scale);
-                pt = outPt;
-            }
+            ReprojectPoints(inSystem,scale,outSystem,lin3d->pts,1.0,buf);
             lin3d->calcGeoMbr();
         } else if (const auto ar = dynamic_cast<VectorAreal*>(shape)) {
             for (auto &loop : ar->loops)
-                for (Point2f &pt : loop) {
-                    const Point3f outPt = CoordSystemConvert(inSystem, outSystem, Point3f(pt.x()*scale,pt.y()*scale,0.0));
-                    pt.x() = outPt.x() * 180 / M_PI;  pt.y() = outPt.y() * 180 / M_PI;
-                }
+                ReprojectPoints(inSystem,scale,outSystem,loop,180 / M_PI,buf);
             ar->calcGeoMbr();
         } else if (const auto tri = dynamic_cast<VectorTriangles*>(shape)) {
-            for (Point3f &pt : tri->pts)
-            {
-                pt = CoordSystemConvert(inSystem, outSystem, Point3f(pt.x()*scale,pt.y()*scale,pt.z()));
-            }
+            ReprojectPoints(inSystem,scale,outSystem,tri->pts,1.0,buf);
             tri->calcGeoMbr();
         }
     }
@@ -1004,6 +1110,8 @@ void VectorObject::reproject(CoordSystem *inSystem,double scale,CoordSystem *out
     
 void VectorObject::subdivideToGlobe(float epsilon)
 {
+    unshareShapes();
+
     FakeGeocentricDisplayAdapter adapter;
     
     VectorRing outPts;
@@ -1041,13 +1149,18 @@ static void SubdivideEdgesToSurfaceGCGeo(const VectorRing &inPts,VectorRing &out
                                          float eps,float surfOffset=0,int minPts=0)
 {
     Point3dVector outPts;
-    outPts.reserve(std::max(20, 3 * minPts));
     SubdivideEdgesToSurfaceGC(inPts,outPts,closed,adapter,eps,surfOffset,minPts);
 
+    for (auto &pt : outPts)
+    {
+        pt = adapter->displayToLocal(pt);
+    }
+    Point2dVector geoPts(outPts.size());
+    coordSys->localToGeographicBatch(outPts.data(),geoPts.data(),outPts.size());
     outPts2D.resize(outPts.size());
     for (unsigned int ii=0;ii<outPts.size();ii++)
     {
-        outPts2D[ii] = coordSys->localToGeographic(adapter->displayToLocal(outPts[ii]));
+        outPts2D[ii] = geoPts[ii].cast<float>();
     }
     if (!inPts.empty())
     {
@@ -1082,7 +1195,6 @@ static void SubdivideEdgesToSurfaceGCGeo(const VectorRing3d &inPts,Point3dVector
         inPts2D.emplace_back(p.x(),p.y());
     }
     VectorRing outPts2d;
-    outPts2d.resize(inPts.size() * 3);
     SubdivideEdgesToSurfaceGCGeo(inPts2D,outPts2d,closed,adapter,coordSys,eps,surfOffset,minPts);
     outPts.reserve(outPts.size() + outPts2d.size());
     for (const auto &p : outPts2d)
@@ -1203,125 +1315,82 @@ static bool anyIntersect(const TIter beg, const TIter end, bool close)
     return false;
 }
 
-static std::pair<double,double> CalcInv(const Point2f &p1, const Point2f &p2)
+// Geographic point along an edge, keeping the height for 3D points
+static inline Point2f GeoLibPt(const Point2f &, const Point2f &, double, double lon, double lat)
 {
-    const auto lat1 = WhirlyKit::RadToDeg(p1.y());
-    const auto lon1 = WhirlyKit::RadToDeg(p1.x());
-    const auto lat2 = WhirlyKit::RadToDeg(p2.y());
-    const auto lon2 = WhirlyKit::RadToDeg(p2.x());
-    double dist = 0.0, az1 = 0.0, az2 = 0.0;
-    detail::wgs84Geodesic().Inverse(lat1, lon1, lat2, lon2, dist, az1, az2);
-    return std::make_pair(dist,WhirlyKit::DegToRad(az1));
+    return {(float)lon,(float)lat};
 }
 
-static std::pair<bool,Point2f> CalcDirect(const Point2f &origin, double az, double dist)
+static inline Point3d GeoLibPt(const Point3d &p0, const Point3d &p1, double t, double lon, double lat)
 {
-    const auto lat1 = WhirlyKit::RadToDeg(origin.y());
-    const auto lon1 = WhirlyKit::RadToDeg(origin.x());
-    const auto azDeg = WhirlyKit::RadToDeg(az);
-
-    double lat2 = 0.0, lon2 = 0.0;
-    const auto res = detail::wgs84Geodesic().Direct(lat1, lon1, azDeg, dist, lat2, lon2);
-
-    return std::make_pair(std::isfinite(res),
-                          Point2f((float)WhirlyKit::DegToRad(lon2),
-                                  (float)WhirlyKit::DegToRad(lat2)));
+    return {lon,lat,p0.z() + (p1.z() - p0.z()) * t};
 }
 
-template <typename Tin,typename Tout>
-static void SubdivideGeoLib(Tin beg, Tin end, Tout out, double maxDistMeters)
+// Break up the edges along their WGS84 geodesics so no piece is longer than the given distance.
+// The first pass works out the pieces for each edge so the output is allocated once,
+//  and then each edge gets one geodesic line to step along.
+template <typename TRing>
+static void SubdivideGeoLib(const TRing &inPts, TRing &outPts, double maxDistMeters)
 {
-    const auto count = std::distance(beg, end);
-    if (count < 2)
+    if (inPts.size() < 2)
     {
-        if (beg != end)
-        {
-            // special case for one point
-            *out++ = *beg;
-        }
+        outPts.insert(outPts.end(), inPts.begin(), inPts.end());
         return;
     }
-    while (beg != end)
+
+    using namespace GeographicLib;
+    const auto &geod = detail::wgs84Geodesic();
+
+    struct Edge
     {
-        const auto next = std::next(beg);
-        if (next == end)
+        double azimuth;     // degrees
+        double segLen;
+        int segs;
+    };
+    std::vector<Edge> edges(inPts.size() - 1);
+    size_t total = outPts.size() + inPts.size();
+    for (size_t ii = 0; ii < edges.size(); ++ii)
+    {
+        const auto &p0 = inPts[ii];
+        const auto &p1 = inPts[ii+1];
+        double dist = 0.0, az1 = 0.0, az2 = 0.0;
+        geod.Inverse(RadToDeg((double)p0.y()), RadToDeg((double)p0.x()),
+                     RadToDeg((double)p1.y()), RadToDeg((double)p1.x()), dist, az1, az2);
+        const int segs = (dist > maxDistMeters) ? (int)std::ceil(dist / maxDistMeters) : 1;
+        edges[ii] = { az1, dist / segs, segs };
+        total += segs - 1;
+    }
+    outPts.reserve(total);
+
+    for (size_t ii = 0; ii < edges.size(); ++ii)
+    {
+        const auto &p0 = inPts[ii];
+        const auto &p1 = inPts[ii+1];
+        const auto &edge = edges[ii];
+        outPts.push_back(p0);
+        if (edge.segs < 2)
         {
-            *out++ = *beg;
-            break;
+            continue;
         }
-        const auto &p0 = *beg;
-        const auto &p1 = *next;
-        ++beg;
-        *out++ = p0;
-
-        double dist,az;
-        std::tie(dist,az) = CalcInv(p0,p1);
 
-        if (dist > maxDistMeters)
+        const GeodesicLine line = geod.Line(RadToDeg((double)p0.y()), RadToDeg((double)p0.x()),
+                                            edge.azimuth, Geodesic::LATITUDE | Geodesic::LONGITUDE | Geodesic::DISTANCE_IN);
+        for (int i = 1; i < edge.segs; ++i)
         {
-            const auto segs = (int)std::ceil(dist / maxDistMeters);
-            const auto segLen = dist / segs;
-            Point2f outPt;
-            bool valid;
-            for (int i = 1; i < segs; ++i)
+            double lat = 0.0, lon = 0.0;
+            if (std::isfinite(line.Position(edge.segLen * i, lat, lon)))
             {
-                std::tie(valid,outPt) = CalcDirect(p0,az,segLen * i);
-                if (valid)
-                {
-                    *out++ = outPt;
-                }
+                outPts.push_back(GeoLibPt(p0, p1, (double)i / edge.segs, DegToRad(lon), DegToRad(lat)));
             }
         }
     }
-}
-
-template <typename T> struct Adapt3dTo2f : std::vector<Point2f>::const_iterator
-{
-    explicit Adapt3dTo2f(T i) : _i(i) {}
-    Adapt3dTo2f(const Adapt3dTo2f &i) : _i(i._i) {}
-    Point2f operator*() const { return Point2f(_i->x(),_i->y()); }
-    Adapt3dTo2f& operator++() { ++_i; return *this; }
-    Adapt3dTo2f operator++(int) { auto x = *this; ++_i; return x; }
-    bool operator==(const Adapt3dTo2f &other) const { return _i == other._i; }
-    bool operator!=(const Adapt3dTo2f &other) const { return _i != other._i; }
-    T _i;
-};
-template <typename T> struct Adapt2fTo3d
-{
-    explicit Adapt2fTo3d(T i) : _i(i) {}
-    Adapt2fTo3d& operator*() { return *this; }
-    Adapt2fTo3d& operator++() { ++_i; return this; }
-    Adapt2fTo3d operator++(int) { auto x = *this; ++_i; return x; }
-    Adapt2fTo3d& operator=(const Point2f &p) { _i.operator=(Point3d(p.x(),p.y(),0.0)); return *this; }
-    bool operator==(const Adapt2fTo3d &other) const { return _i == other._i; }
-    bool operator!=(const Adapt2fTo3d &other) const { return _i != other._i; }
-    T _i;
-};
-template <typename T> Adapt3dTo2f<T> make3to2(T iter) { return Adapt3dTo2f<T>(iter); }
-template <typename T> Adapt2fTo3d<T> make2to3(T iter) { return Adapt2fTo3d<T>(iter); }
-
-static void SubdivideGeoLib(const VectorRing &inPts, VectorRing &outPts, double maxDistMeters)
-{
-    outPts.reserve(outPts.size() + inPts.size() * 10);
-    SubdivideGeoLib(inPts.begin(), inPts.end(), std::back_inserter(outPts), maxDistMeters);
-}
-
-#if 0
-static void SubdivideGeoLib(const VectorRing3d &inPts, VectorRing &outPts, double maxDistMeters)
-{
-    outPts.reserve(outPts.size() + inPts.size() * 10);
-    SubdivideGeoLib(make3to2(inPts.begin()), make3to2(inPts.end()), std::back_inserter(outPts), maxDistMeters);
-}
-#endif
-
-static void SubdivideGeoLib(const VectorRing3d &inPts, VectorRing3d &outPts, double maxDistMeters)
-{
-    outPts.reserve(outPts.size() + inPts.size() * 10);
-    SubdivideGeoLib(make3to2(inPts.begin()), make3to2(inPts.end()), make2to3(std::back_inserter(outPts)), maxDistMeters);
+    outPts.push_back(inPts.back());
 }
 
 void VectorObject::subdivideToInternal(float epsilon,WhirlyKit::CoordSystemDisplayAdapter *adapter,bool useGeoLib,bool edgeMode)
 {
+    unshareShapes();
+
     CoordSystem *coordSys = adapter->getCoordSystem();
 
     const auto geoDist = useGeoLib ? epsilon * detail::wgs84Geodesic().EquatorialRadius() : 0.0;
@@ -1465,6 +1534,8 @@ int VectorObject::countAreals() const
 
 void VectorObject::reverseAreals()
 {
+    unshareShapes();
+
     for (auto& shape : shapes)
     {
         if (auto areal = dynamic_cast<VectorAreal*>(shape.get()))
@@ -1544,6 +1615,8 @@ int VectorObject::countUnClosedLoops() const
 
 void VectorObject::closeLoops()
 {
+    unshareShapes();
+
     for (auto& shape : shapes)
     {
         if (auto areal = dynamic_cast<VectorAreal*>(shape.get()))
@@ -1571,6 +1644,8 @@ VectorObjectRef VectorObject::closedLoops() const
 
 void VectorObject::unCloseLoops()
 {
+    unshareShapes();
+
     for (auto& shape : shapes)
     {
         if (auto areal = dynamic_cast<VectorAreal*>(shape.get()))
@@ -1698,6 +1773,8 @@ VectorObjectRef VectorObject::tesselate() const
     
 VectorObjectRef VectorObject::clipToGrid(const Point2d &gridSize)
 {
+    WKTraceScope("Vector clipToGrid");
+
     auto newVec = std::make_shared<VectorObject>();
     newVec->shapes.reserve(shapes.size());
 
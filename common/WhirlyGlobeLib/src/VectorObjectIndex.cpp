@@ -0,0 +1,112 @@
+/*  VectorObjectIndex.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import "VectorObjectIndex.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    // Below this we just look through the entries
+    constexpr int LeafSize = 8;
+    // Never bother rebuilding for fewer changes than this
+    constexpr size_t MinRebuild = 64;
+}
+
+void VectorObjectIndex::add(SimpleIdentity compID,int which,const Point2d &ll,const Point2d &ur)
+{
+    // Don't let removals pile up if nobody's querying
+    if (numDead > std::max(MinRebuild,entries.size() / 2))
+        rebuild();
+
+    where.insert(std::make_pair(compID,entries.size()));
+    entries.push_back(Entry { ll, ur, compID, which, true });
+}
+
+void VectorObjectIndex::remove(SimpleIdentity compID)
+{
+    const auto range = where.equal_range(compID);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        entries[it->second].live = false;
+        numDead++;
+    }
+    where.erase(range.first,range.second);
+}
+
+void VectorObjectIndex::rebuild()
+{
+    entries.erase(std::remove_if(entries.begin(),entries.end(),[](const Entry &entry) { return !entry.live; }),
+                  entries.end());
+    numDead = 0;
+
+    nodes.clear();
+    nodes.reserve(2 * entries.size() / LeafSize + 1);
+    if (!entries.empty())
+        BuildBoundsHierarchy(nodes,entries,0,(int)entries.size(),LeafSize);
+    numIndexed = entries.size();
+
+    where.clear();
+    where.reserve(entries.size());
+    for (size_t ii=0;ii<entries.size();ii++)
+        where.insert(std::make_pair(entries[ii].compID,ii));
+}
+
+void VectorObjectIndex::query(const Point2d &ll,const Point2d &ur,std::vector<Candidate> &results)
+{
+    const size_t numPending = entries.size() - numIndexed;
+    if (numPending > std::max(MinRebuild,numIndexed / 8) || numDead > std::max(MinRebuild,numIndexed / 4))
+        rebuild();
+
+    const auto checkEntry = [&](const Entry &entry)
+    {
+        if (entry.live && overlaps(entry.ll,entry.ur,ll,ur))
+            results.push_back(Candidate { entry.compID, entry.which });
+    };
+
+    if (!nodes.empty())
+    {
+        std::vector<int> stack;
+        stack.push_back(0);
+        while (!stack.empty())
+        {
+            const Node &node = nodes[stack.back()];
+            stack.pop_back();
+
+            if (!overlaps(node.ll,node.ur,ll,ur))
+                continue;
+
+            if (node.count > 0)
+            {
+                for (int ii=node.first;ii<node.first+node.count;ii++)
+                    checkEntry(entries[ii]);
+            }
+            else
+            {
+                stack.push_back(node.left);
+                stack.push_back(node.right);
+            }
+        }
+    }
+
+    // Anything added since the last build
+    for (size_t ii=numIndexed;ii<entries.size();ii++)
+        checkEntry(entries[ii]);
+}
+
+}
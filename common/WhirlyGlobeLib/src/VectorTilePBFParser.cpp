@@ -23,6 +23,8 @@
 #import "VectorObject.h"
 #import "WhirlyKitLog.h"
 #import "DictionaryC.h"
+#import "GridClipper.h"
+#import "PerformanceTimer.h"
 
 #import "vector_tile.pb.h"
 #import "maply_pb_decode.h"
@@ -57,7 +59,7 @@ const vector_tile_Tile_Feature VectorTilePBFParser::_defaultFeature = {
     /* tags     */ { &VectorTilePBFParser::intVecDecode, nullptr },
     /* has_type */ false,
     /* type     */ vector_tile_Tile_GeomType_UNKNOWN,
-    /* geometry */ { &VectorTilePBFParser::intVecDecode, nullptr },
+    /* geometry */ { &VectorTilePBFParser::geomViewDecode, nullptr },
 };
 
 const vector_tile_Tile_Value VectorTilePBFParser::_defaultValue = {
@@ -109,13 +111,51 @@ VectorTilePBFParser::VectorTilePBFParser(
 {
 }
 
+Point2d VectorTilePBFParser::toOutput(double fx, double fy) const
+{
+    if (_localCoords)
+    {
+        return { fx, fy };
+    }
+    return { DegToRad((fx / MAX_EXTENT) * 180.0),
+             2 * atan(exp(DegToRad((fy / MAX_EXTENT) * 180.0))) - M_PI_2 };
+}
+
+void VectorTilePBFParser::setSourceBounds(const MbrD &srcBBox)
+{
+    _bbox = srcBBox;
+    _bboxWidth = _bbox.ur().x() - _bbox.ll().x();
+    _bboxHeight = _bbox.ur().y() - _bbox.ll().y();
+    _sx = (_bboxWidth > 0) ? (TileSize / _bboxWidth) : 0;
+    _sy = (_bboxHeight > 0) ? (TileSize / _bboxHeight) : 0;
+    _tileOriginX = _bbox.ll().x();
+    _tileOriginY = _bbox.ur().y();
+
+    // Our own tile is what we keep
+    const auto &bbox = _tileData->bbox;
+    const Point2d ll = toOutput(bbox.ll().x(), bbox.ll().y());
+    const Point2d ur = toOutput(bbox.ur().x(), bbox.ur().y());
+    _clipMbr = Mbr(Point2f(ll.x(), ll.y()), Point2f(ur.x(), ur.y()));
+    _clip = _clipMbr.valid();
+
+    // Anything closer than about half a display pixel won't show
+    const double pixel = std::min(ur.x() - ll.x(), ur.y() - ll.y()) / (TileSize * 2);
+    _minVertDist2 = pixel * pixel;
+}
+
 bool VectorTilePBFParser::parse(const uint8_t* data, size_t length)
 {
+    WKTraceScope("PBF parse");
+
     _vector_tile_Tile tile = {
         /* layer     */ { layerDecode, this },
         /*extensions */ nullptr,
     };
 
+    // Strings and geometry point back into this, so it has to outlive the parse
+    _data = data;
+    _dataLength = length;
+
     auto stream = pb_istream_from_buffer(data, length);
     if (!pb_decode(&stream, vector_tile_Tile_fields, &tile))
     {
@@ -159,6 +199,9 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
     _featureGeometry.reserve(featureGeometryHeuristic(layerBytes));
     _features.clear();
     _features.reserve(featureHeuristic(layerBytes));
+    _layerKeyStrings.clear();
+    _layerValueStrings.clear();
+    _haveValueStrings.clear();
 
     if (!pb_decode(stream, vector_tile_Tile_Layer_fields, &layer))
     {
@@ -167,6 +210,10 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
 
     auto layerName = std::string(layerNameView);
 
+    _layerKeyStrings.resize(_layerKeys.size());
+    _layerValueStrings.resize(_layerValues.size());
+    _haveValueStrings.resize(_layerValues.size(), false);
+
     // When `has_extent` is false, nanopb sets the default in `extent`
     _layerScale = (double)layer.extent / TileSize;
 
@@ -202,6 +249,8 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
         return true;
     }
 
+    setupLayerKeys(layerName);
+
     size_t prevTagIndex = 0;
     size_t prevGeomIndex = 0;
     for (auto const &feature : _features)
@@ -212,17 +261,25 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
             return false;
         }
 
+        const auto curTagIndex = prevTagIndex;
+        auto curGeomIndex = prevGeomIndex;
+        auto curGeomCount = feature.geomIndex - prevGeomIndex;
+        prevTagIndex = feature.tagIndex;
+        prevGeomIndex = feature.geomIndex;
+
+        // Skip features we've been told to ignore before building anything for them
+        if (!checkUUIDTag(curTagIndex, feature))
+        {
+            _skippedFeatureCount += 1;
+            continue;
+        }
+
         auto attributes = std::make_shared<MutableDictionaryC>();
         attributes->setString(layerNameKey, layerName);
         attributes->setInt(geometryTypeKey, (int)feature.geomType);
         attributes->setInt(layerOrderKey, (int)_layerCount);
 
-        const bool tagsOk = processTags(attributes, prevTagIndex, prevGeomIndex, feature);
-        //const auto curTagIndex = prevTagIndex;
-        const auto curGeomIndex = prevGeomIndex;
-        const auto curGeomCount = feature.geomIndex - prevGeomIndex;
-        prevTagIndex = feature.tagIndex;
-        prevGeomIndex = feature.geomIndex;
+        const bool tagsOk = processTags(attributes, curTagIndex, curGeomIndex, feature);
         
         if (!tagsOk)
         {
@@ -238,6 +295,21 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
             continue;
         }
 
+        // Now that someone wants it, decode the geometry
+        const uint32_t *geometry = curGeomCount ? &_featureGeometry[curGeomIndex] : nullptr;
+        if (feature.geomData)
+        {
+            _geomScratch.clear();
+            if (!decodePackedInts(feature.geomData, feature.geomBytes, _geomScratch))
+            {
+                _parseErrors += 1;
+                _skippedFeatureCount += 1;
+                continue;
+            }
+            geometry = _geomScratch.data();
+            curGeomCount = (uint32_t)_geomScratch.size();
+        }
+
         _featureCount += 1;
 
         auto vecObj = std::make_shared<VectorObject>();
@@ -248,12 +320,12 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
             switch (feature.geomType)
             {
                 case GeomTypeLineString:
-                    parseLineString(&_featureGeometry[curGeomIndex], curGeomCount, vecObj->shapes);
+                    parseLineString(geometry, curGeomCount, vecObj->shapes);
                     break;
                 case GeomTypePolygon:
                 {
                     auto shape = VectorAreal::createAreal();
-                    if (parsePolygon(&_featureGeometry[curGeomIndex], curGeomCount, *shape))
+                    if (parsePolygon(geometry, curGeomCount, *shape))
                     {
                         vecObj->shapes.insert(shape);
                     }
@@ -262,7 +334,7 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
                 case GeomTypePoint:
                 {
                     auto shape = VectorPoints::createPoints();
-                    if (parsePoints(&_featureGeometry[curGeomIndex], curGeomCount, *shape))
+                    if (parsePoints(geometry, curGeomCount, *shape))
                     {
                         vecObj->shapes.insert(shape);
                     }
@@ -290,6 +362,16 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
             vecObj.reset();
         }
 
+        if (vecObj && _clip)
+        {
+            clipFeature(*vecObj);
+        }
+
+        if (!vecObj)
+        {
+            continue;
+        }
+
         for (const auto &shape: vecObj->shapes)
         {
             shape->setAttrDict(attributes);
@@ -323,9 +405,12 @@ bool VectorTilePBFParser::featureDecode(pb_istream_t *stream, const pb_field_ite
 
 bool VectorTilePBFParser::featureDecode(pb_istream_t *stream, const pb_field_iter_t *field)
 {
+    GeomView geom;
+    geom.parser = this;
+
     auto feature = _defaultFeature;
     feature.tags.arg = &_featureTags;
-    feature.geometry.arg = &_featureGeometry;
+    feature.geometry.arg = &geom;
 
     if (!pb_decode(stream, vector_tile_Tile_Feature_fields, &feature))
     {
@@ -333,7 +418,7 @@ bool VectorTilePBFParser::featureDecode(pb_istream_t *stream, const pb_field_ite
     }
 
     const auto geomType = static_cast<MapnikGeometryType>(feature.type);
-    _features.emplace_back(_featureTags.size(),_featureGeometry.size(),geomType);
+    _features.emplace_back(_featureTags.size(),_featureGeometry.size(),geomType,geom);
 
     return true;
 }
@@ -362,12 +447,16 @@ bool VectorTilePBFParser::processTags(const MutableDictionaryCRef &attributes, s
             continue;
         }
 
-        // TODO: We don't really need transient string allocations here
-        const auto skey = std::string(key);
+        // Nobody's going to look at this one
+        if (!_layerKeyWanted.empty() && !_layerKeyWanted[keyIndex]) {
+            continue;
+        }
+
+        const auto &skey = layerKeyString(keyIndex);
 
         const auto &value = _layerValues[valueIndex];
         switch (value.type) {
-            case SmallValue::SmallValString: attributes->setString(skey, std::string(value.stringValue)); break;
+            case SmallValue::SmallValString: attributes->setString(skey, layerValueString(valueIndex)); break;
             case SmallValue::SmallValFloat:  attributes->setDouble(skey, value.floatValue); break;
             case SmallValue::SmallValDouble: attributes->setDouble(skey, value.doubleValue); break;
             case SmallValue::SmallValInt:    attributes->setInt(skey, value.intValue); break;
@@ -385,6 +474,89 @@ bool VectorTilePBFParser::processTags(const MutableDictionaryCRef &attributes, s
     return true;
 }
 
+bool VectorTilePBFParser::checkUUIDTag(size_t tagIdx, const Feature &feature) const
+{
+    if (_uuidName.empty())
+    {
+        return true;
+    }
+
+    // Look for a string value right in the tags.  Anything else waits for the full check.
+    for (size_t m = tagIdx; m + 1 < feature.tagIndex; m += 2)
+    {
+        const auto keyIndex = _featureTags[m];
+        const auto valueIndex = _featureTags[m + 1];
+        if (keyIndex >= _layerKeys.size() || valueIndex >= _layerValues.size() ||
+            _layerKeys[keyIndex] != _uuidName)
+        {
+            continue;
+        }
+
+        const auto &value = _layerValues[valueIndex];
+        if (value.type != SmallValue::SmallValString)
+        {
+            return true;
+        }
+        return _uuidValues.find(std::string(value.stringValue)) != _uuidValues.end();
+    }
+
+    return true;
+}
+
+const std::string &VectorTilePBFParser::layerKeyString(uint32_t keyIndex)
+{
+    auto &str = _layerKeyStrings[keyIndex];
+    if (str.empty())
+    {
+        str.assign(_layerKeys[keyIndex].data(), _layerKeys[keyIndex].size());
+    }
+    return str;
+}
+
+const std::string &VectorTilePBFParser::layerValueString(uint32_t valueIndex)
+{
+    auto &str = _layerValueStrings[valueIndex];
+    if (!_haveValueStrings[valueIndex])
+    {
+        const auto &view = _layerValues[valueIndex].stringValue;
+        str.assign(view.data(), view.size());
+        _haveValueStrings[valueIndex] = true;
+    }
+    return str;
+}
+
+void VectorTilePBFParser::setupLayerKeys(const std::string &layerName)
+{
+    _layerKeyWanted.clear();
+
+    // Anyone getting the vectors back wants the whole thing
+    if (_parseAll || _keepVectors)
+    {
+        return;
+    }
+
+    _styleKeys.clear();
+    if (!_styleDelegate->attributeKeysForLayer(_styleInst, layerName, _styleKeys))
+    {
+        return;
+    }
+    if (!_uuidName.empty())
+    {
+        _styleKeys.insert(_uuidName);
+    }
+
+    _layerKeyWanted.resize(_layerKeys.size(), false);
+    for (size_t ii = 0; ii < _layerKeys.size(); ii++)
+    {
+        _layerKeyWanted[ii] = _styleKeys.find(layerKeyString(ii)) != _styleKeys.end();
+    }
+}
+
+bool VectorTilePBFParser::inTileData(const uint8_t *data, size_t bytes) const
+{
+    return _data && data >= _data && data + bytes <= _data + _dataLength;
+}
+
 bool VectorTilePBFParser::checkStyles(SimpleIDUSet& styleIDs, const MutableDictionaryCRef &attributes, const std::string &layerName)
 {
     // Ask for the styles that correspond to this feature
@@ -635,6 +807,94 @@ bool VectorTilePBFParser::parsePoints(const uint32_t *geometry, size_t geomCount
     return false;
 }
 
+void VectorTilePBFParser::thinRing(VectorRing &ring, bool closed) const
+{
+    if (ring.size() < 3)
+    {
+        return;
+    }
+
+    // Keep the ends, drop anything too close to the last point we kept
+    size_t kept = 1;
+    for (size_t ii = 1; ii < ring.size() - 1; ii++)
+    {
+        if ((ring[ii] - ring[kept-1]).cast<double>().squaredNorm() >= _minVertDist2)
+        {
+            ring[kept++] = ring[ii];
+        }
+    }
+    ring[kept++] = ring.back();
+    ring.resize(kept);
+
+    // A loop that's collapsed down to a sliver isn't worth drawing
+    if (closed && ring.size() < 4)
+    {
+        ring.clear();
+    }
+}
+
+void VectorTilePBFParser::clipFeature(VectorObject &vecObj) const
+{
+    // Local coordinates are too big for the default scale in the polygon clipper
+    const double polyScale = _localCoords ? 1e6 : 0.0;
+
+    ShapeSet newShapes;
+    std::vector<VectorRing> clipped;
+    for (const auto &shape : vecObj.shapes)
+    {
+        if (const auto lin = std::dynamic_pointer_cast<VectorLinear>(shape))
+        {
+            clipped.clear();
+            ClipLoopToMbr(lin->pts, _clipMbr, false, clipped);
+            for (auto &ring : clipped)
+            {
+                thinRing(ring, false);
+                if (ring.size() > 1)
+                {
+                    auto newLin = VectorLinear::createLinear();
+                    newLin->pts = std::move(ring);
+                    newLin->initGeoMbr();
+                    newShapes.insert(newLin);
+                }
+            }
+        }
+        else if (const auto ar = std::dynamic_pointer_cast<VectorAreal>(shape))
+        {
+            for (auto &loop : ar->loops)
+            {
+                thinRing(loop, true);
+            }
+            ar->loops.erase(std::remove_if(ar->loops.begin(), ar->loops.end(),
+                                           [](const VectorRing &loop) { return loop.empty(); }),
+                            ar->loops.end());
+
+            // Outer and hole loops all go in together and we fill with the odd rule, so they stay in one areal
+            clipped.clear();
+            if (!ar->loops.empty() && ClipLoopsToMbr(ar->loops, _clipMbr, true, clipped, polyScale) && !clipped.empty())
+            {
+                ar->loops = std::move(clipped);
+                clipped = std::vector<VectorRing>();
+                ar->initGeoMbr();
+                newShapes.insert(ar);
+            }
+        }
+        else if (const auto pts = std::dynamic_pointer_cast<VectorPoints>(shape))
+        {
+            // Otherwise every child of the source tile would put up the same labels
+            pts->pts.erase(std::remove_if(pts->pts.begin(), pts->pts.end(),
+                                          [this](const Point2f &pt) { return !_clipMbr.insideOrOnEdge(pt); }),
+                           pts->pts.end());
+            if (!pts->pts.empty())
+            {
+                pts->initGeoMbr();
+                newShapes.insert(pts);
+            }
+        }
+    }
+
+    vecObj.shapes = std::move(newShapes);
+}
+
 void VectorTilePBFParser::addFeature(const VectorObjectRef &vecObj, const SimpleIDUSet &styleIDs)
 {
     if (vecObj->shapes.empty())
@@ -725,5 +985,61 @@ bool VectorTilePBFParser::intVecDecode(pb_istream_t *stream, const pb_field_iter
     return true;
 }
 
+// Note where the packed geometry is rather than decoding it
+bool VectorTilePBFParser::geomViewDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg)
+{
+    auto &geom = **(GeomView**)arg;
+    auto *parser = geom.parser;
+
+    const auto *start = (const uint8_t *)stream->state;
+    if (!geom.copied && !geom.data && parser->inTileData(start, stream->bytes_left))
+    {
+        // The decoder skips over whatever we don't read
+        geom.data = start;
+        geom.bytes = stream->bytes_left;
+        return true;
+    }
+
+    // Unpacked or split into pieces, so decode it all the old way
+    if (!geom.copied && geom.data)
+    {
+        if (!decodePackedInts(geom.data, geom.bytes, parser->_featureGeometry))
+        {
+            return false;
+        }
+        geom.data = nullptr;
+        geom.bytes = 0;
+    }
+    geom.copied = true;
+
+    auto *vec = &parser->_featureGeometry;
+    return intVecDecode(stream, field, (void **)&vec);
+}
+
+// Decode packed varints straight from the tile data
+bool VectorTilePBFParser::decodePackedInts(const uint8_t *data, size_t bytes, std::vector<uint32_t> &vec)
+{
+    vec.reserve(vec.size() + bytes);
+    const uint8_t *end = data + bytes;
+    while (data < end)
+    {
+        uint64_t value = 0;
+        int shift = 0;
+        uint8_t byte;
+        do
+        {
+            if (data >= end || shift >= 64)
+            {
+                return false;
+            }
+            byte = *data++;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        vec.push_back((uint32_t)value);
+    }
+    return true;
+}
+
 }   // namespace WhirlyKit
 
@@ -0,0 +1,296 @@
+/*  VectorTiler.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <cmath>
+#import "VectorTiler.h"
+#import "VectorLOD.h"
+#import "GridClipper.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    size_t countPoints(const VectorShapeRef &shape)
+    {
+        if (const auto ar = std::dynamic_pointer_cast<VectorAreal>(shape))
+        {
+            size_t num = 0;
+            for (const auto &loop : ar->loops)
+                num += loop.size();
+            return num;
+        }
+        if (const auto lin = std::dynamic_pointer_cast<VectorLinear>(shape))
+            return lin->pts.size();
+        if (const auto pts = std::dynamic_pointer_cast<VectorPoints>(shape))
+            return pts->pts.size();
+        return 0;
+    }
+
+    // Plain bounds, since the clipping doesn't know about wrapping around the date line
+    //  the way a GeoMbr does
+    Mbr shapeMbr(const VectorShapeRef &shape)
+    {
+        Mbr mbr;
+        if (const auto ar = std::dynamic_pointer_cast<VectorAreal>(shape))
+        {
+            for (const auto &loop : ar->loops)
+                mbr.addPoints(loop);
+        }
+        else if (const auto lin = std::dynamic_pointer_cast<VectorLinear>(shape))
+            mbr.addPoints(lin->pts);
+        else if (const auto pts = std::dynamic_pointer_cast<VectorPoints>(shape))
+            mbr.addPoints(pts->pts);
+        return mbr;
+    }
+
+    bool overlaps(const Mbr &mbr,const Mbr &shapeMbr)
+    {
+        return shapeMbr.ur().x() >= mbr.ll().x() && shapeMbr.ur().y() >= mbr.ll().y() &&
+               shapeMbr.ll().x() <= mbr.ur().x() && shapeMbr.ll().y() <= mbr.ur().y();
+    }
+
+    bool inside(const Mbr &mbr,const Mbr &shapeMbr)
+    {
+        return shapeMbr.ll().x() >= mbr.ll().x() && shapeMbr.ll().y() >= mbr.ll().y() &&
+               shapeMbr.ur().x() <= mbr.ur().x() && shapeMbr.ur().y() <= mbr.ur().y();
+    }
+
+    // Clip the shapes to the given bounds.  Points just have to be inside.
+    void clipShapes(const std::vector<VectorShapeRef> &shapes,const Mbr &mbr,std::vector<VectorShapeRef> &outShapes)
+    {
+        std::vector<VectorRing> clipped;
+        for (const auto &shape : shapes)
+        {
+            const Mbr thisMbr = shapeMbr(shape);
+            if (!thisMbr.valid() || !overlaps(mbr,thisMbr))
+                continue;
+            // Nothing to cut, so it can be shared
+            if (inside(mbr,thisMbr))
+            {
+                outShapes.push_back(shape);
+                continue;
+            }
+
+            if (const auto ar = std::dynamic_pointer_cast<VectorAreal>(shape))
+            {
+                // The holes go in with the outer loop, since we fill with the odd rule
+                clipped.clear();
+                if (!ar->loops.empty() && ClipLoopsToMbr(ar->loops,mbr,true,clipped) && !clipped.empty())
+                {
+                    auto newAr = VectorAreal::createAreal();
+                    newAr->loops = std::move(clipped);
+                    clipped = std::vector<VectorRing>();
+                    newAr->setAttrDict(ar->getAttrDictRef());
+                    newAr->initGeoMbr();
+                    outShapes.push_back(newAr);
+                }
+            }
+            else if (const auto lin = std::dynamic_pointer_cast<VectorLinear>(shape))
+            {
+                clipped.clear();
+                ClipLoopToMbr(lin->pts,mbr,false,clipped);
+                for (auto &ring : clipped)
+                {
+                    auto newLin = VectorLinear::createLinear();
+                    newLin->pts = std::move(ring);
+                    newLin->setAttrDict(lin->getAttrDictRef());
+                    newLin->initGeoMbr();
+                    outShapes.push_back(newLin);
+                }
+            }
+            else if (const auto pts = std::dynamic_pointer_cast<VectorPoints>(shape))
+            {
+                auto newPts = VectorPoints::createPoints();
+                for (const auto &pt : pts->pts)
+                    if (mbr.inside(pt))
+                        newPts->pts.push_back(pt);
+                if (!newPts->pts.empty())
+                {
+                    newPts->setAttrDict(pts->getAttrDictRef());
+                    newPts->initGeoMbr();
+                    outShapes.push_back(newPts);
+                }
+            }
+        }
+    }
+}
+
+VectorTiler::VectorTiler(const VectorTilerSettings &settings)
+: settings(settings), built(false)
+{
+}
+
+void VectorTiler::addShapes(const ShapeSet &shapes)
+{
+    allShapes.reserve(allShapes.size() + shapes.size());
+    for (const auto &shape : shapes)
+    {
+        if (std::dynamic_pointer_cast<VectorAreal>(shape) ||
+            std::dynamic_pointer_cast<VectorLinear>(shape) ||
+            std::dynamic_pointer_cast<VectorPoints>(shape))
+            allShapes.push_back(shape);
+    }
+}
+
+Mbr VectorTiler::tileMbr(const QuadTreeNew::Node &node,bool buffered) const
+{
+    // Tiles are square in Spherical Mercator, which runs from -PI to PI both ways
+    const double span = 2.0 * M_PI / (1 << node.level);
+    const double pad = buffered ? span * settings.buffer / settings.tileSize : 0.0;
+    const double minX = -M_PI + node.x * span - pad, maxX = -M_PI + (node.x + 1) * span + pad;
+    const double minY = -M_PI + node.y * span - pad, maxY = -M_PI + (node.y + 1) * span + pad;
+
+    return Mbr(Point2f((float)minX,(float)std::atan(std::sinh(minY))),
+               Point2f((float)maxX,(float)std::atan(std::sinh(maxY))));
+}
+
+VectorTiler::Tile &VectorTiler::makeTile(const QuadTreeNew::Node &node,std::vector<VectorShapeRef> &&source)
+{
+    Tile &tile = tiles[node.NodeNumber()];
+    tile.source = std::move(source);
+    tile.numPoints = 0;
+    for (const auto &shape : tile.source)
+        tile.numPoints += countPoints(shape);
+
+    // Good enough for this level, in radians of Spherical Mercator like VectorLOD
+    const double eps = settings.tolerance * 2.0 * M_PI / (settings.tileSize * (1 << node.level));
+    std::vector<VectorShapeRef> simplified;
+    SimplifyShapes(tile.source,eps,simplified);
+
+    // Points in the buffer belong to the tile next door, so don't show them twice
+    const Mbr mbr = tileMbr(node,false);
+    tile.shapes.reserve(simplified.size());
+    for (auto &shape : simplified)
+    {
+        const auto pts = std::dynamic_pointer_cast<VectorPoints>(shape);
+        if (!pts)
+        {
+            tile.shapes.push_back(std::move(shape));
+            continue;
+        }
+        auto newPts = VectorPoints::createPoints();
+        for (const auto &pt : pts->pts)
+            if (pt.x() >= mbr.ll().x() && pt.x() < mbr.ur().x() &&
+                pt.y() >= mbr.ll().y() && pt.y() < mbr.ur().y())
+                newPts->pts.push_back(pt);
+        if (newPts->pts.size() == pts->pts.size())
+            tile.shapes.push_back(std::move(shape));
+        else if (!newPts->pts.empty())
+        {
+            newPts->setAttrDict(pts->getAttrDictRef());
+            newPts->initGeoMbr();
+            tile.shapes.push_back(newPts);
+        }
+    }
+
+    return tile;
+}
+
+void VectorTiler::splitTile(const QuadTreeNew::Node &node,Tile &tile)
+{
+    if (node.level >= settings.maxZoom)
+        return;
+
+    for (int iy=0;iy<2;iy++)
+        for (int ix=0;ix<2;ix++)
+        {
+            const QuadTreeNew::Node child(node.x*2+ix,node.y*2+iy,node.level+1);
+            std::vector<VectorShapeRef> childShapes;
+            clipShapes(tile.source,tileMbr(child,true),childShapes);
+            if (!childShapes.empty())
+                makeTile(child,std::move(childShapes));
+        }
+
+    // The children have everything we need now
+    tile.source = std::vector<VectorShapeRef>();
+}
+
+void VectorTiler::buildIndex()
+{
+    built = true;
+    if (allShapes.empty())
+        return;
+
+    std::vector<QuadTreeNew::Node> toSplit;
+    toSplit.emplace_back(0,0,0);
+    makeTile(toSplit.back(),std::move(allShapes));
+    allShapes = std::vector<VectorShapeRef>();
+
+    while (!toSplit.empty())
+    {
+        const QuadTreeNew::Node node = toSplit.back();
+        toSplit.pop_back();
+
+        auto it = tiles.find(node.NodeNumber());
+        if (it == tiles.end() || node.level >= settings.indexMaxZoom ||
+            it->second.numPoints <= (size_t)settings.indexMaxPoints)
+            continue;
+
+        splitTile(node,it->second);
+        for (int iy=0;iy<2;iy++)
+            for (int ix=0;ix<2;ix++)
+                toSplit.emplace_back(node.x*2+ix,node.y*2+iy,node.level+1);
+    }
+}
+
+std::vector<VectorShapeRef> VectorTiler::getTile(int x,int y,int level)
+{
+    if (level < 0 || level > settings.maxZoom)
+        return std::vector<VectorShapeRef>();
+
+    std::lock_guard<std::mutex> guardLock(lock);
+    if (!built)
+        buildIndex();
+
+    auto it = tiles.find(QuadTreeIdentifier::NodeNumber(x,y,level));
+    if (it != tiles.end())
+        return it->second.shapes;
+
+    // Closest tile above that we've made
+    QuadTreeNew::Node node(x,y,level);
+    while (node.level > 0)
+    {
+        node = QuadTreeNew::Node(node.x/2,node.y/2,node.level-1);
+        it = tiles.find(node.NodeNumber());
+        if (it != tiles.end())
+            break;
+    }
+    // If it was already split, there's nothing in this part of it
+    if (it == tiles.end() || it->second.source.empty())
+        return std::vector<VectorShapeRef>();
+
+    // Work down to the one we want
+    while (node.level < level)
+    {
+        splitTile(node,it->second);
+        const int shift = level - node.level - 1;
+        node = QuadTreeNew::Node(x >> shift,y >> shift,node.level+1);
+        it = tiles.find(node.NodeNumber());
+        if (it == tiles.end())
+            return std::vector<VectorShapeRef>();
+    }
+
+    return it->second.shapes;
+}
+
+int VectorTiler::getNumTiles()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return (int)tiles.size();
+}
+
+}
@@ -18,6 +18,10 @@
  *
  */
 
+#import <cstring>
+#import <cmath>
+#import <limits>
+#import <algorithm>
 #import "VertexAttribute.h"
 
 using namespace Eigen;
@@ -94,6 +98,14 @@ void VertexAttribute::addColor(const RGBAColor &color)
 
 void VertexAttribute::addVector2f(const Eigen::Vector2f &vec)
 {
+    if (dataType == BDHalf2Type || dataType == BDShort2NormType)
+    {
+        if (!data)
+            data = new std::vector<uint32_t>();
+        auto *vals = (std::vector<uint32_t> *)data;
+        vals->push_back(dataType == BDHalf2Type ? PackHalf2(vec) : PackShort2Norm(vec));
+        return;
+    }
     if (dataType != BDFloat2Type)
         return;
     
@@ -105,6 +117,13 @@ void VertexAttribute::addVector2f(const Eigen::Vector2f &vec)
 
 void VertexAttribute::addVector3f(const Eigen::Vector3f &vec)
 {
+    if (dataType == BDChar4NormType)
+    {
+        if (!data)
+            data = new std::vector<uint32_t>();
+        ((std::vector<uint32_t> *)data)->push_back(PackChar4Norm(vec));
+        return;
+    }
     if (dataType != BDFloat3Type)
         return;
     
@@ -219,6 +238,16 @@ void VertexAttribute::reserve(int size)
             ints->reserve(size);
         }
             break;
+        case BDHalf2Type:
+        case BDShort2NormType:
+        case BDChar4NormType:
+        {
+            if (!data)
+                data = new std::vector<uint32_t>();
+            std::vector<uint32_t> *vals = (std::vector<uint32_t> *)data;
+            vals->reserve(size);
+        }
+            break;
         case BDDataTypeMax:
             break;
     }
@@ -273,6 +302,13 @@ int VertexAttribute::numElements() const
             std::vector<int64_t> *ints = (std::vector<int64_t> *)data;
             return (int)ints->size();
         }
+        case BDHalf2Type:
+        case BDShort2NormType:
+        case BDChar4NormType:
+        {
+            std::vector<uint32_t> *vals = (std::vector<uint32_t> *)data;
+            return (int)vals->size();
+        }
         case BDDataTypeMax:
             return 0;
             break;
@@ -305,6 +341,11 @@ int VertexAttribute::size() const
         case BDInt64Type:
             return 8;
             break;
+        case BDHalf2Type:
+        case BDShort2NormType:
+        case BDChar4NormType:
+            return 4;
+            break;
         case BDDataTypeMax:
             return 0;
             break;
@@ -346,6 +387,11 @@ int SingleVertexAttributeInfo::size() const
         case BDInt64Type:
             return 8;
             break;
+        case BDHalf2Type:
+        case BDShort2NormType:
+        case BDChar4NormType:
+            return 4;
+            break;
         case BDDataTypeMax:
             return 0;
             break;
@@ -454,6 +500,14 @@ void VertexAttribute::clear()
                 delete ints;
             }
                 break;
+            case BDHalf2Type:
+            case BDShort2NormType:
+            case BDChar4NormType:
+            {
+                std::vector<uint32_t> *vals = (std::vector<uint32_t> *)data;
+                delete vals;
+            }
+                break;
             case BDDataTypeMax:
                 break;
         }
@@ -461,6 +515,110 @@ void VertexAttribute::clear()
     data = NULL;
 }
 
+namespace {
+    template <typename T> void appendData(void *&data,const void *thatData)
+    {
+        if (!thatData)
+            return;
+        if (!data)
+            data = new std::vector<T>();
+        auto &vals = *(std::vector<T> *)data;
+        const auto &thatVals = *(const std::vector<T> *)thatData;
+        vals.insert(vals.end(),thatVals.begin(),thatVals.end());
+    }
+
+    template <typename T> void appendStridedData(void *&data,const unsigned char *src,int count,int stride)
+    {
+        if (!data)
+            data = new std::vector<T>();
+        auto &vals = *(std::vector<T> *)data;
+        vals.reserve(vals.size() + count);
+        for (int ii=0;ii<count;ii++,src+=stride)
+        {
+            T val;
+            memcpy(&val,src,sizeof(T));
+            vals.push_back(val);
+        }
+    }
+}
+
+bool VertexAttribute::append(const VertexAttribute &that)
+{
+    if (dataType != that.dataType)
+        return false;
+
+    switch (dataType)
+    {
+        case BDFloat4Type:
+            appendData<Vector4f>(data,that.data);
+            break;
+        case BDFloat3Type:
+            appendData<Vector3f>(data,that.data);
+            break;
+        case BDFloat2Type:
+            appendData<Vector2f>(data,that.data);
+            break;
+        case BDChar4Type:
+            appendData<RGBAColor>(data,that.data);
+            break;
+        case BDFloatType:
+            appendData<float>(data,that.data);
+            break;
+        case BDIntType:
+            appendData<int>(data,that.data);
+            break;
+        case BDInt64Type:
+            appendData<int64_t>(data,that.data);
+            break;
+        case BDHalf2Type:
+        case BDShort2NormType:
+        case BDChar4NormType:
+            appendData<uint32_t>(data,that.data);
+            break;
+        case BDDataTypeMax:
+            return false;
+    }
+    return true;
+}
+
+void VertexAttribute::appendStrided(const unsigned char *src,int count,int stride)
+{
+    if (count <= 0)
+        return;
+
+    switch (dataType)
+    {
+        case BDFloat4Type:
+            appendStridedData<Vector4f>(data,src,count,stride);
+            break;
+        case BDFloat3Type:
+            appendStridedData<Vector3f>(data,src,count,stride);
+            break;
+        case BDFloat2Type:
+            appendStridedData<Vector2f>(data,src,count,stride);
+            break;
+        case BDChar4Type:
+            appendStridedData<RGBAColor>(data,src,count,stride);
+            break;
+        case BDFloatType:
+            appendStridedData<float>(data,src,count,stride);
+            break;
+        case BDIntType:
+            appendStridedData<int>(data,src,count,stride);
+            break;
+        case BDInt64Type:
+            appendStridedData<int64_t>(data,src,count,stride);
+            break;
+        case BDHalf2Type:
+        case BDShort2NormType:
+        case BDChar4NormType:
+            appendStridedData<uint32_t>(data,src,count,stride);
+            break;
+        case BDDataTypeMax:
+            break;
+    }
+}
+
 /// Return a pointer to the given element
 void *VertexAttribute::addressForElement(int which)
 {
@@ -508,6 +666,14 @@ void *VertexAttribute::addressForElement(int which)
             return &(*ints)[which];
         }
             break;
+        case BDHalf2Type:
+        case BDShort2NormType:
+        case BDChar4NormType:
+        {
+            std::vector<uint32_t> *vals = (std::vector<uint32_t> *)data;
+            return &(*vals)[which];
+        }
+            break;
         case BDDataTypeMax:
             return NULL;
             break;
@@ -516,6 +682,126 @@ void *VertexAttribute::addressForElement(int which)
     return NULL;
 }
 
+uint32_t VertexAttribute::packedDefault() const
+{
+    switch (dataType)
+    {
+        case BDHalf2Type:
+            return PackHalf2(Vector2f(defaultData.vec2[0],defaultData.vec2[1]));
+        case BDShort2NormType:
+            return PackShort2Norm(Vector2f(defaultData.vec2[0],defaultData.vec2[1]));
+        case BDChar4NormType:
+            return PackChar4Norm(Vector3f(defaultData.vec3[0],defaultData.vec3[1],defaultData.vec3[2]));
+        default:
+            return 0;
+    }
+}
+
+bool IsCompactAttributeType(BDAttributeDataType dataType)
+{
+    return dataType == BDHalf2Type || dataType == BDShort2NormType || dataType == BDChar4NormType;
+}
+
+uint16_t FloatToHalf(float val)
+{
+    uint32_t bits;
+    memcpy(&bits,&val,sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t absBits = bits & 0x7fffffff;
+
+    // NaN stays NaN, anything too big is infinity
+    if (absBits > 0x7f800000)
+        return (uint16_t)(sign | 0x7e00);
+    if (absBits >= 0x477ff000)
+        return (uint16_t)(sign | 0x7c00);
+
+    // Too small for a normal half, so it's a denormal or zero
+    if (absBits < 0x38800000)
+    {
+        if (absBits < 0x33000000)
+            return (uint16_t)sign;
+        const uint32_t mant = (absBits & 0x007fffff) | 0x00800000;
+        const int shift = 126 - (int)(absBits >> 23);
+        uint32_t half = mant >> shift;
+        // Round to nearest even
+        const uint32_t rest = mant & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+            half++;
+        return (uint16_t)(sign | half);
+    }
+
+    // Rebias the exponent and round the mantissa to nearest even
+    uint32_t half = (absBits - 0x38000000) >> 13;
+    const uint32_t rest = absBits & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        half++;
+    return (uint16_t)(sign | half);
+}
+
+float HalfToFloat(uint16_t half)
+{
+    const uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    const uint32_t exp = (half >> 10) & 0x1f;
+    uint32_t mant = half & 0x3ff;
+
+    uint32_t bits;
+    if (exp == 0x1f)
+    {
+        bits = sign | 0x7f800000 | (mant << 13);
+    }
+    else if (exp != 0)
+    {
+        bits = sign | ((exp + 112) << 23) | (mant << 13);
+    }
+    else if (mant == 0)
+    {
+        bits = sign;
+    }
+    else
+    {
+        // Denormal, so normalize it
+        int e = -1;
+        do {
+            e++;
+            mant <<= 1;
+        } while ((mant & 0x400) == 0);
+        bits = sign | ((uint32_t)(112 - e) << 23) | ((mant & 0x3ff) << 13);
+    }
+
+    float val;
+    memcpy(&val,&bits,sizeof(val));
+    return val;
+}
+
+namespace {
+    template <typename T> T normalizedInt(float val)
+    {
+        const float maxVal = (float)std::numeric_limits<T>::max();
+        const float clamped = std::min(std::max(val,-1.0f),1.0f);
+        return (T)std::lround(clamped * maxVal);
+    }
+}
+
+// Low bytes of the 32 bits hold the first component, which is what the GPU expects on little-endian
+uint32_t PackHalf2(const Eigen::Vector2f &vec)
+{
+    return (uint32_t)FloatToHalf(vec.x()) | ((uint32_t)FloatToHalf(vec.y()) << 16);
+}
+
+uint32_t PackShort2Norm(const Eigen::Vector2f &vec)
+{
+    return (uint32_t)(uint16_t)normalizedInt<int16_t>(vec.x()) |
+           ((uint32_t)(uint16_t)normalizedInt<int16_t>(vec.y()) << 16);
+}
+
+uint32_t PackChar4Norm(const Eigen::Vector3f &vec)
+{
+    return (uint32_t)(uint8_t)normalizedInt<int8_t>(vec.x()) |
+           ((uint32_t)(uint8_t)normalizedInt<int8_t>(vec.y()) << 8) |
+           ((uint32_t)(uint8_t)normalizedInt<int8_t>(vec.z()) << 16);
+}
+
 void VertexAttributeSetConvert(const SingleVertexAttributeSet &attrSet,SingleVertexAttributeInfoSet &infoSet)
 {
     for (auto it : attrSet)
@@ -61,6 +61,13 @@ GLuint VertexAttributeGLES::glEntryComponents() const
         case BDInt64Type:
             return 1;
             break;
+        case BDHalf2Type:
+        case BDShort2NormType:
+            return 2;
+            break;
+        case BDChar4NormType:
+            return 3;
+            break;
         case BDDataTypeMax:
             return 0;
             break;
@@ -100,6 +107,13 @@ GLuint SingleVertexAttributeInfoGLES::glEntryComponents() const
         case BDInt64Type:
             return 1;
             break;
+        case BDHalf2Type:
+        case BDShort2NormType:
+            return 2;
+            break;
+        case BDChar4NormType:
+            return 3;
+            break;
         case BDDataTypeMax:
             break;
     }
@@ -125,6 +139,15 @@ GLenum VertexAttributeGLES::glType() const
         case BDInt64Type:
             return GL_INT;
             break;
+        case BDHalf2Type:
+            return GL_HALF_FLOAT;
+            break;
+        case BDShort2NormType:
+            return GL_SHORT;
+            break;
+        case BDChar4NormType:
+            return GL_BYTE;
+            break;
         case BDDataTypeMax:
             return GL_INT;
             break;
@@ -150,6 +173,15 @@ GLenum SingleVertexAttributeInfoGLES::glType() const
         case BDInt64Type:
             return GL_INT;
             break;
+        case BDHalf2Type:
+            return GL_HALF_FLOAT;
+            break;
+        case BDShort2NormType:
+            return GL_SHORT;
+            break;
+        case BDChar4NormType:
+            return GL_BYTE;
+            break;
         case BDDataTypeMax:
             return GL_INT;
             break;
@@ -168,9 +200,12 @@ GLboolean VertexAttributeGLES::glNormalize() const
         case BDFloatType:
         case BDIntType:
         case BDInt64Type:
+        case BDHalf2Type:
             return GL_FALSE;
             break;
         case BDChar4Type:
+        case BDShort2NormType:
+        case BDChar4NormType:
             return GL_TRUE;
             break;
         case BDDataTypeMax:
@@ -190,9 +225,12 @@ GLboolean SingleVertexAttributeInfoGLES::glNormalize() const
         case BDFloatType:
         case BDIntType:
         case BDInt64Type:
+        case BDHalf2Type:
             return GL_FALSE;
             break;
         case BDChar4Type:
+        case BDShort2NormType:
+        case BDChar4NormType:
             return GL_TRUE;
             break;
         case BDDataTypeMax:
@@ -212,8 +250,14 @@ void VertexAttributeGLES::glSetDefault(int index) const
             glVertexAttrib3f(index, defaultData.vec3[0], defaultData.vec3[1], defaultData.vec3[2]);
             break;
         case BDFloat2Type:
+        case BDHalf2Type:
+        case BDShort2NormType:
+            // Defaults are kept as floats, whatever the array would be
             glVertexAttrib2f(index, defaultData.vec2[0], defaultData.vec2[1]);
             break;
+        case BDChar4NormType:
+            glVertexAttrib3f(index, defaultData.vec3[0], defaultData.vec3[1], defaultData.vec3[2]);
+            break;
         case BDFloatType:
             glVertexAttrib1f(index, defaultData.floatVal);
             break;
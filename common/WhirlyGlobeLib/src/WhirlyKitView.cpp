@@ -43,6 +43,7 @@ View::View(const View &that) :
     imagePlaneSize(that.imagePlaneSize),
     lastChangedTime(that.lastChangedTime),
     continuousZoom(that.continuousZoom),
+    predictionTime(that.predictionTime),
     coordAdapter(that.coordAdapter),
     centerOffset(that.centerOffset)
 {
@@ -267,6 +268,29 @@ void View::runViewUpdates()
         it->viewUpdated(this);
 }
 
+ViewStateRef View::getViewState(SceneRenderer *renderer)
+{
+    // These are cheap.  It's the inverses that add up.
+    const Point2f frameSize = renderer->getFramebufferSize();
+    const Eigen::Matrix4d modelMat = calcModelMatrix();
+    const Eigen::Matrix4d viewMat = calcViewMatrix();
+    const Eigen::Matrix4d projMat = calcProjectionMatrix(frameSize,0.0);
+
+    std::lock_guard<std::mutex> guardLock(viewStateLock);
+    if (sharedViewState && frameSize == sharedFrameSize &&
+        modelMat == sharedModelMat && viewMat == sharedViewMat && projMat == sharedProjMat)
+    {
+        return sharedViewState;
+    }
+
+    sharedViewState = makeViewState(renderer);
+    sharedModelMat = modelMat;
+    sharedViewMat = viewMat;
+    sharedProjMat = projMat;
+    sharedFrameSize = frameSize;
+    return sharedViewState;
+}
+
 ViewState::ViewState(WhirlyKit::View *view,SceneRenderer *renderer) :
     near(0),
     far(0)
@@ -274,25 +298,48 @@ ViewState::ViewState(WhirlyKit::View *view,SceneRenderer *renderer) :
     modelMatrix = view->calcModelMatrix();
     invModelMatrix = modelMatrix.inverse();
     
-    std::vector<Eigen::Matrix4d> offMatrices;
-    Point2f frameSize = renderer->getFramebufferSize();
-    view->getOffsetMatrices(offMatrices, frameSize, 0.0);
-    viewMatrices.resize(offMatrices.size());
-    invViewMatrices.resize(offMatrices.size());
-    fullMatrices.resize(offMatrices.size());
-    invFullMatrices.resize(offMatrices.size());
-    fullNormalMatrices.resize(offMatrices.size());
-    
-    projMatrix = view->calcProjectionMatrix(renderer->getFramebufferSize(),0.0);
+    frameSize = renderer->getFramebufferSize();
+    view->getOffsetMatrices(offsetMatrices, frameSize, 0.0);
+    const size_t numOffsets = offsetMatrices.size();
+    viewMatrices.resize(numOffsets);
+    invViewMatrices.resize(numOffsets);
+    fullMatrices.resize(numOffsets);
+    invFullMatrices.resize(numOffsets);
+    fullNormalMatrices.resize(numOffsets);
+    mvpMatrices.resize(numOffsets);
+    invMvpMatrices.resize(numOffsets);
+    mvpNormalMatrices.resize(numOffsets);
+    frustumPlanes.resize(6 * numOffsets);
+
+    projMatrix = view->calcProjectionMatrix(frameSize,0.0);
     invProjMatrix = projMatrix.inverse();
-    Eigen::Matrix4d baseViewMatrix = view->calcViewMatrix();
-    for (unsigned int ii=0;ii<offMatrices.size();ii++)
+    viewMatrix = view->calcViewMatrix();
+    fullMatrix = viewMatrix * modelMatrix;
+    invFullMatrix = fullMatrix.inverse();
+    fullNormalMatrix = invFullMatrix.transpose();
+    mvpMatrix = projMatrix * fullMatrix;
+    invMvpMatrix = mvpMatrix.inverse();
+    mvpNormalMatrix = invMvpMatrix.transpose();
+    for (unsigned int ii=0;ii<numOffsets;ii++)
     {
-        viewMatrices[ii] = baseViewMatrix * offMatrices[ii];
+        viewMatrices[ii] = viewMatrix * offsetMatrices[ii];
         invViewMatrices[ii] = viewMatrices[ii].inverse();
         fullMatrices[ii] = viewMatrices[ii] * modelMatrix;
         invFullMatrices[ii] = fullMatrices[ii].inverse();
-        fullNormalMatrices[ii] = fullMatrices[ii].inverse().transpose();
+        fullNormalMatrices[ii] = invFullMatrices[ii].transpose();
+        mvpMatrices[ii] = projMatrix * fullMatrices[ii];
+        invMvpMatrices[ii] = mvpMatrices[ii].inverse();
+        mvpNormalMatrices[ii] = invMvpMatrices[ii].transpose();
+
+        // Pull the clipping planes out of the combined matrix
+        const Eigen::Matrix4d &mvp = mvpMatrices[ii];
+        const Vector4d rows[4] = { mvp.row(0).transpose(), mvp.row(1).transpose(), mvp.row(2).transpose(), mvp.row(3).transpose() };
+        for (unsigned int pp=0;pp<6;pp++)
+        {
+            const Vector4d plane = (pp % 2 == 0) ? Vector4d(rows[3] + rows[pp/2]) : Vector4d(rows[3] - rows[pp/2]);
+            const double len = plane.head<3>().norm();
+            frustumPlanes[ii*6+pp] = (len > 0.0) ? Vector4d(plane / len) : plane;
+        }
     }
     
     fieldOfView = view->fieldOfView;
@@ -311,8 +358,18 @@ ViewState::ViewState(WhirlyKit::View *view,SceneRenderer *renderer) :
     eyePos = Vector3d(eyePos4.x(),eyePos4.y(),eyePos4.z());
     
     ll.x() = ur.x() = 0.0;
-    
+    // Work this out now, since we may be shared between threads
+    if (frameSize.x() > 0 && frameSize.y() > 0)
+        calcFrustumWidth((unsigned int)frameSize.x(),(unsigned int)frameSize.y());
+
     coordAdapter = view->coordAdapter;
+    if (coordAdapter && !coordAdapter->isFlat())
+    {
+        horizonDist = std::sqrt(std::max(eyePos.squaredNorm() - 1.0,0.0));
+        horizon = HorizonCuller(eyePos);
+    }
+    else
+        horizonDist = 0.0;
 }
 
 void ViewState::calcFrustumWidth(unsigned int frameWidth,unsigned int frameHeight)
@@ -388,6 +445,20 @@ bool ViewState::isSameAs(const ViewState *other) const
     return true;
 }
 
+bool ViewState::sphereInFrustum(const Point3d &center,double radius,unsigned int offset) const
+{
+    if (offset * 6 + 6 > frustumPlanes.size())
+        return true;
+
+    for (unsigned int pp=0;pp<6;pp++)
+    {
+        const Vector4d &plane = frustumPlanes[offset*6+pp];
+        if (plane.head<3>().dot(center) + plane.w() < -radius)
+            return false;
+    }
+    return true;
+}
+
 void ViewState::log()
 {
     wkLogLevel(Verbose,"--- ViewState ---");
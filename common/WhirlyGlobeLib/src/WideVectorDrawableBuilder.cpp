@@ -87,6 +87,20 @@ void WideVectorDrawableBuilder::setValues(const WideVectorInfo &vecInfo)
     lineWidth = vecInfo.width;
     lineOffset = vecInfo.offset;
     edgeSize = vecInfo.edgeSize;
+    // The rest goes into the uniforms too, so it has to match what the manager built with
+    texRepeat = vecInfo.repeatSize;
+    widthExp = vecInfo.widthExp;
+    offsetExp = vecInfo.offsetExp;
+    colorExp = vecInfo.colorExp;
+    opacityExp = vecInfo.opacityExp;
+    if (vecInfo.implType == WideVecImplPerf)
+    {
+        texOffset = vecInfo.texOffset;
+        joinType = vecInfo.joinType;
+        capType = vecInfo.capType;
+        miterLimit = vecInfo.miterLimit;
+        fallbackMode = vecInfo.fallbackMode;
+    }
 }
     
 void WideVectorDrawableBuilder::setLineWidth(float inWidth)
@@ -224,7 +238,7 @@ void WideVectorDrawableBuilder::addCenterLine(const Point3d &centerPt,
                                               int prev,int next)
 {
     CenterPoint pt;
-    pt.center = centerPt.cast<float>();
+    pt.center = (basicDrawable->hasCenter() ? Point3d(centerPt - basicDrawable->getCenter()) : centerPt).cast<float>();
     pt.up = up.cast<float>();
     pt.segLen = (float)len;
     pt.totalLen = centerline.empty() ? 0.0f : (centerline.back().totalLen + centerline.back().segLen);
@@ -313,6 +327,13 @@ void WideVectorDrawableBuilder::setMatrix(const Eigen::Matrix4d *inMat)
         basicDrawable->setMatrix(inMat);
 }
 
+void WideVectorDrawableBuilder::setCenter(const Point3d &center)
+{
+    // Instances pick up the matrix from the drawable they're instancing,
+    //  which is how the center lines get it
+    basicDrawable->setCenter(center);
+}
+
 void WideVectorDrawableBuilder::addVertexAttributes(const SingleVertexAttributeSet &attrs)
 {
     basicDrawable->addVertexAttributes(attrs);
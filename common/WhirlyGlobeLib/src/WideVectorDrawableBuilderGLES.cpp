@@ -68,6 +68,52 @@ void WideVectorTweakerGLES::tweakForFrame(Drawable *inDraw,RendererFrameInfo *fr
     }
 }
 
+// Performance version works on the instance drawable and sets the program up directly
+void WideVectorPerfTweakerGLES::tweakForFrame(Drawable *inDraw,RendererFrameInfo *frameInfo)
+{
+    auto instDraw = dynamic_cast<BasicDrawableInstance *>(inDraw);
+    auto prog = dynamic_cast<ProgramGLES *>(frameInfo->program);
+    if (!instDraw || !prog)
+    {
+        wkLogLevel(Warn, "Invalid drawable passed to WideVectorPerfTweakerGLES");
+        return;
+    }
+
+    const Point2f frameSize = frameInfo->sceneRenderer->getFramebufferSize();
+    const double frameSpan = std::min(frameSize.x(), frameSize.y());
+    const double screenSize = std::min(frameInfo->screenSizeInDisplayCoords.x(), frameInfo->screenSizeInDisplayCoords.y());
+    const double pixDispScale = screenSize / frameSpan;
+    const float zoom = (opacityExp || colorExp || widthExp || offsetExp) ? getZoom(*inDraw,*frameInfo->scene,0.0f) : 0.0f;
+
+    Vector4f c = colorExp ? colorExp->evaluateF(zoom,color) : color.asRGBAVecF();
+    if (opacityExp)
+    {
+        c.w() = opacityExp->evaluate(zoom, 1.0f);
+    }
+    // Multiply the alpha through, otherwise you just get the max color
+    c *= c.w();
+    instDraw->setColor(RGBAColor(c));
+
+    // Half width includes the edge blend, if there's any width at all
+    float w2 = (widthExp ? widthExp->evaluate(zoom, lineWidth) : lineWidth) / 2;
+    if (w2 > 0)
+    {
+        w2 += edgeSize;
+    }
+    prog->setUniform(u_w2NameID, w2);
+    prog->setUniform(u_EdgeNameID, edgeSize);
+    prog->setUniform(u_wideOffsetNameID, offsetExp ? offsetExp->evaluate(zoom, offset) : offset);
+    prog->setUniform(u_ScaleNameID, Point2f(2.f / frameSize.x(), 2.f / frameSize.y()));
+    prog->setUniform(u_texScaleNameID, (float)(1.0 / pixDispScale / texRepeat));
+    prog->setUniform(u_wideTexOffsetNameID, texOffset);
+    prog->setUniform(u_wideJoinNameID, (int)joinType);
+    prog->setUniform(u_wideCapNameID, (int)capType);
+    prog->setUniform(u_miterLimitNameID, miterLimit);
+    prog->setUniform(u_interClipLimitNameID, interClipLimit);
+    prog->setUniform(u_globeNameID, globeMode ? 1 : 0);
+    prog->setUniform(u_originNameID, origin);
+}
+
 WideVectorDrawableBuilderGLES::WideVectorDrawableBuilderGLES(const std::string &name,const SceneRenderer *sceneRenderer,Scene *scene) :
     WideVectorDrawableBuilder(name,sceneRenderer,scene),
     drawableGotten(false),
@@ -98,9 +144,20 @@ int WideVectorDrawableBuilderGLES::addAttribute(BDAttributeDataType dataType,Str
 
 DrawableTweakerRef WideVectorDrawableBuilderGLES::makeTweaker() const
 {
+    if (implType == WideVecImplPerf)
+    {
+        return std::make_shared<WideVectorPerfTweakerGLES>();
+    }
     return std::make_shared<WideVectorTweakerGLES>();
 }
 
+int WideVectorDrawableBuilderGLES::maxInstances() const
+{
+    // Center, packed matrix and color as BasicDrawableInstanceGLES writes them.  Same 32MB as Metal.
+    constexpr int instSize = (3 + 16 + 1) * sizeof(GLfloat) + 4 * sizeof(GLubyte);
+    return 32*1024*1024 / instSize;
+}
+
 BasicDrawableRef WideVectorDrawableBuilderGLES::getBasicDrawable()
 {
     if (drawableGotten)
@@ -112,14 +169,75 @@ BasicDrawableRef WideVectorDrawableBuilderGLES::getBasicDrawable()
     // non-const to allow copy elision on return
     auto theDraw = basicDrawable->getDrawable();
 
-    setupTweaker(*theDraw);
+    // In performance mode this just holds the geometry for the instances, which get the tweaker
+    if (implType == WideVecImplBasic)
+    {
+        setupTweaker(*theDraw);
+    }
 
     return theDraw;
 }
 
-BasicDrawableInstanceRef  WideVectorDrawableBuilderGLES::getInstanceDrawable()
+BasicDrawableInstanceRef WideVectorDrawableBuilderGLES::getInstanceDrawable()
 {
-    return nullptr;
+    if (!instDrawable)
+        return nullptr;
+    if (instanceGotten)
+        return instDrawable->getDrawable();
+
+    instanceGotten = true;
+
+    // GLES 3 doesn't let the shader look around in a buffer, so each instance
+    //  carries its neighbors along in the matrix.  Columns are the previous,
+    //  next and next-next center points with 1 in w if they exist, then the
+    //  segment and total lengths.
+    const auto packCenter = [this](int which) -> Eigen::Vector4d
+    {
+        if (which < 0 || which >= (int)centerline.size())
+            return { 0.0, 0.0, 0.0, 0.0 };
+        const Point3f &pt = centerline[which].center;
+        return { pt.x(), pt.y(), pt.z(), 1.0 };
+    };
+    std::vector<BasicDrawableInstance::SingleInstance> insts(centerline.size());
+    for (unsigned int ii=0;ii<centerline.size();ii++)
+    {
+        const CenterPoint &pt = centerline[ii];
+        const int nextNext = (pt.next >= 0 && pt.next < (int)centerline.size()) ? centerline[pt.next].next : -1;
+        auto &inst = insts[ii];
+        inst.center = pt.center.cast<double>();
+        inst.mat.col(0) = packCenter(pt.prev);
+        inst.mat.col(1) = packCenter(pt.next);
+        inst.mat.col(2) = packCenter(nextNext);
+        inst.mat.col(3) = Eigen::Vector4d(pt.segLen, pt.totalLen, 0.0, 0.0);
+    }
+    instDrawable->setPackedInstances(true);
+    instDrawable->addInstances(insts);
+
+    if (const auto tweaker = makeTweaker())
+    {
+        setupTweaker(tweaker);
+        if (auto tweak = dynamic_cast<WideVectorPerfTweakerGLES*>(tweaker.get()))
+        {
+            // Color goes on the instance, not the basic drawable
+            tweak->color = color;
+            tweak->colorExp = colorExp;
+            tweak->opacityExp = opacityExp;
+            tweak->offset = lineOffset;
+            tweak->texOffset = texOffset;
+            tweak->joinType = joinType;
+            tweak->capType = capType;
+            tweak->miterLimit = miterLimit;
+            tweak->interClipLimit = (fallbackMode == WideVecFallbackClip) ? 4.0f : 0.0f;
+            tweak->globeMode = globeMode;
+            if (basicDrawable->hasCenter())
+            {
+                tweak->origin = basicDrawable->getCenter().cast<float>();
+            }
+        }
+        instDrawable->addTweaker(tweaker);
+    }
+
+    return instDrawable->getDrawable();
 }
     
 static const char *vertexShaderTri = R"(
@@ -303,5 +421,462 @@ ProgramGLES *BuildWideVectorGlobeProgramGLES(const std::string &name, SceneRende
 
     return shader;
 }
+
+// Performance wide vectors.  The same 12 vertices are instanced for each center point
+//  and worked out into joins and caps here.  Follows vertexTri_wideVecPerf in the Metal shaders.
+static const char *vertexShaderPerf = R"(
+precision highp float;
+
+uniform mat4  u_mvpMatrix;
+uniform mat4  u_mvMatrix;
+uniform mat4  u_mvNormalMatrix;
+uniform float u_fade;
+uniform vec2  u_scale;
+uniform float u_w2;
+uniform float u_edge;
+uniform float u_wideOffset;
+uniform float u_texScale;
+uniform vec2  u_wideTexOffset;
+uniform int   u_wideJoin;
+uniform int   u_wideCap;
+uniform float u_miterLimit;
+uniform float u_interClipLimit;
+uniform bool  u_globe;
+uniform vec3  u_origin;
+
+attribute float a_instIndex;        // polygon | (vertex << 16)
+attribute vec4  a_color;
+attribute vec3  a_modelCenter;      // this center point
+attribute mat4  a_singleMatrix;     // previous, next, next-next centers, then lengths
+
+varying vec2  v_texCoord;
+varying vec4  v_color;
+varying float v_roundJoin;
+varying vec2  v_centerPos;
+varying vec2  v_screenPos;
+varying vec2  v_midDir;
+
+const int JoinMiter = 0;
+const int JoinMiterClip = 1;
+const int JoinMiterSimple = 2;
+const int JoinRound = 3;
+const int JoinBevel = 4;
+const int JoinNone = 5;
+const int CapButt = 0;
+const int CapRound = 1;
+const int CapSquare = 2;
+const int PolyBody = 1;
+
+const float MinTurnThreshold = 1e-5;
+const float MaxTurnThreshold = 0.99999998476;   // sin(89.99 deg)
+const float PI = 3.14159265358979;
+
+// Outside the clip volume.  Whole polygons go here, so they drop out.
+const vec4 discardPt = vec4(0.0,0.0,-2.0,1.0);
+
+// wedge product (2D cross product)
+float wedge(vec2 a,vec2 b)
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+// Intersect two lines, false if they're parallel
+bool intersectLines(vec2 a0,vec2 a1,vec2 b0,vec2 b1,out vec2 inter)
+{
+    vec2 dA = a0 - a1;
+    vec2 dB = b0 - b1;
+    float denom = wedge(dA,dB);
+    if (denom == 0.0)
+        return false;
+    float tA = a0.x * a1.y - a0.y * a1.x;
+    float tB = b0.x * b1.y - b0.y * b1.x;
+    inter = vec2(tA * dB.x - dA.x * tB, tA * dB.y - dA.y * tB) / denom;
+    return true;
+}
+
+vec2 screenPos(vec3 pt)
+{
+    vec4 s = u_mvpMatrix * vec4(pt,1.0);
+    return s.xy / s.w;
+}
+
+void main()
+{
+    gl_Position = discardPt;
+    v_texCoord = vec2(0.0,0.0);
+    v_color = vec4(0.0,0.0,0.0,0.0);
+    v_roundJoin = 0.0;
+    v_centerPos = vec2(0.0,0.0);
+    v_screenPos = vec2(0.0,0.0);
+    v_midDir = vec2(0.0,0.0);
+
+    // Vertex index within the instance, 0-11.  Odd indexes are on the left, evens on the right.
+    // Polygon index is 0 for the start cap, 1 for the body and 2 for the end cap.
+    float vertF = floor(a_instIndex / 65536.0);
+    int whichVert = int(vertF + 0.5);
+    int whichPoly = int(a_instIndex - vertF * 65536.0 + 0.5);
+    bool isLeft = mod(vertF, 2.0) > 0.5;
+    bool isEnd = whichVert > 5;
+
+    // Half width with the edge blend, stroke width without
+    float w2 = u_w2;
+    float strokeWidth = 2.0 * max(w2 - u_edge, 0.0);
+
+    // Disable joins for narrow lines
+    int join = (w2 >= 1.0) ? u_wideJoin : JoinNone;
+
+    // Previous, this, next and the one after that
+    bool valid0 = a_singleMatrix[0].w > 0.5 && join != JoinNone;
+    bool valid2 = a_singleMatrix[1].w > 0.5;
+    bool valid3 = valid2 && a_singleMatrix[2].w > 0.5 && join != JoinNone;
+    float segLen = a_singleMatrix[3].x;
+    float totalLen = a_singleMatrix[3].y;
+
+    // We need at least this and next
+    if (!valid2)
+        return;
+
+    bool isStartCap = whichPoly == 0 && !valid0;
+    bool isEndCap = whichPoly == 2 && !valid3;
+
+    // Butt is the default cap style, the line ends at the point
+    if ((isStartCap || isEndCap) && u_wideCap == CapButt)
+        return;
+
+    // Make sure the center is facing the user (only for the globe)
+    if (u_globe)
+    {
+        vec4 pt = u_mvMatrix * vec4(a_modelCenter,1.0);
+        pt /= pt.w;
+        if (pt.z > 0.0)
+            return;
+        vec4 testNorm = u_mvNormalMatrix * vec4(u_origin + a_modelCenter,0.0);
+        if (dot(-pt.xyz,testNorm.xyz) <= 0.0)
+            return;
+    }
+
+    vec2 s0 = valid0 ? screenPos(a_singleMatrix[0].xyz) : vec2(0.0,0.0);
+    vec2 s1 = screenPos(a_modelCenter);
+    vec2 s2 = screenPos(a_singleMatrix[1].xyz);
+    vec2 s3 = valid3 ? screenPos(a_singleMatrix[2].xyz) : vec2(0.0,0.0);
+
+    // Directions and normals leading into each point.
+    // Done in isotropic coords to avoid skewing everything when later multiplying by screenScale.
+    vec2 screenScale = u_scale;
+    vec2 d1 = (s1 - s0) / screenScale;
+    vec2 d2 = (s2 - s1) / screenScale;
+    vec2 d3 = (s3 - s2) / screenScale;
+    float len1 = length(d1), len2 = length(d2), len3 = length(d3);
+    vec2 dir1 = valid0 ? normalize(d1) : vec2(0.0,0.0);
+    vec2 dir2 = normalize(d2);
+    vec2 dir3 = valid3 ? normalize(d3) : vec2(0.0,0.0);
+    vec2 norm1 = vec2(-dir1.y,dir1.x);
+    vec2 norm2 = vec2(-dir2.y,dir2.x);
+    vec2 norm3 = vec2(-dir3.y,dir3.x);
+
+    // Textures are based on un-projected coords
+    float projScale = len2 / segLen;
+
+    float centerLine = u_wideOffset;
+
+    // Intersect on the left or right depending
+    float interSgn = isLeft ? 1.0 : -1.0;
+
+    // On the far end of the body we need this and the next two segments.
+    // Otherwise we need the previous, this, and the next segment.
+    vec2 prevPos = isEnd ? s1 : s0;
+    vec2 curPos = isEnd ? s2 : s1;
+    vec2 nextPos = isEnd ? s3 : s2;
+    vec2 curDir = isEnd ? dir2 : dir1;
+    vec2 nextDir = isEnd ? dir3 : dir2;
+    vec2 curNorm = isEnd ? norm2 : norm1;
+    vec2 nextNorm = isEnd ? norm3 : norm2;
+    float curLen = isEnd ? len2 : len1;
+    float nextLen = isEnd ? len3 : len2;
+    bool interNeighbors = isEnd ? valid3 : valid0;
+
+    bool intersectValid = false;
+    bool turningLeft = false;
+    vec2 offsetCenter = curPos + norm2 * centerLine * screenScale;
+    vec2 interPt = vec2(0.0,0.0);
+    vec2 realInterPt = vec2(0.0,0.0);
+    float theta = 0.0;
+    float miterLength = 0.0;
+
+    if (interNeighbors)
+    {
+        // Don't even bother computing intersections for very acute angles or very small turns
+        float dotProd = dot(curDir,nextDir);
+        if (-MaxTurnThreshold < dotProd && dotProd < MaxTurnThreshold &&
+            abs(abs(dotProd) - 1.0) >= MinTurnThreshold)
+        {
+            // Interior turn angle
+            theta = PI - acos(dotProd);
+
+            // Miter turns into a bevel past the limit, miter-clip gets clipped there
+            if (join == JoinMiter || join == JoinMiterClip)
+            {
+                miterLength = abs(1.0 / sin(theta / 2.0));
+                if (miterLength > u_miterLimit)
+                {
+                    if (join == JoinMiter)
+                        join = JoinBevel;
+                    else
+                        miterLength = u_miterLimit;
+                }
+            }
+
+            // Intersect the left or right sides of prev-this and this-next, plus offset
+            vec2 edgeDist = screenScale * (interSgn * w2 + centerLine);
+            vec2 n0 = edgeDist * curNorm;
+            vec2 n1 = edgeDist * nextNorm;
+            vec2 inter;
+            if (intersectLines(prevPos + n0, curPos + n0, curPos + n1, nextPos + n1, inter))
+            {
+                float c = wedge(nextPos - curPos, curPos - prevPos);
+                turningLeft = c < 0.0;
+                interPt = inter;
+                realInterPt = inter;
+
+                // Keep consecutive segments from colliding
+                float maxAdjDist = min(curLen, nextLen) / 2.0;
+
+                // With an offset we need to know where the offset lines intersect
+                if (centerLine != 0.0)
+                {
+                    vec2 cn0 = curNorm * centerLine * screenScale;
+                    vec2 cn1 = nextNorm * centerLine * screenScale;
+                    vec2 i2;
+                    if (intersectLines(prevPos + cn0, curPos + cn0, curPos + cn1, nextPos + cn1, i2))
+                    {
+                        vec2 d = (i2 - offsetCenter) / screenScale;
+                        if (dot(d,d) < maxAdjDist * maxAdjDist)
+                            offsetCenter = i2;
+                    }
+                }
+
+                vec2 interVec = (interPt - offsetCenter) / screenScale;
+                float interDist2 = dot(interVec,interVec);
+                float maxClipDist = maxAdjDist * u_interClipLimit;
+
+                // Limit intersection distance, or clip it back if we're allowed to
+                if (interDist2 <= maxAdjDist * maxAdjDist)
+                {
+                    intersectValid = true;
+                }
+                else if (u_interClipLimit > 0.0 && interDist2 <= maxClipDist * maxClipDist)
+                {
+                    interPt = offsetCenter + normalize(interVec) * sqrt(interDist2) * screenScale;
+                    intersectValid = true;
+                }
+            }
+        }
+    }
+
+    // Endcaps not used for miter case, discard them
+    if ((join == JoinMiter || join == JoinMiterSimple) &&
+        whichPoly != PolyBody && !isStartCap && !isEndCap)
+        return;
+
+    v_color = a_color * u_fade;
+
+    // Work out the corner positions by extending the normals
+    vec2 realEdge = interSgn * w2 * screenScale;
+    vec2 corner = offsetCenter + norm2 * realEdge;
+    float turnSgn = turningLeft ? -1.0 : 1.0;
+    bool isInsideEdge = (isLeft == turningLeft);
+
+    vec2 pos = corner;
+
+    // Texture position is based on cumulative distance along the line
+    float texY = totalLen + (isEnd ? segLen : 0.0);
+    float texX = isLeft ? -1.0 : 1.0;
+
+    if (isStartCap || isEndCap)
+    {
+        // Square extends beyond the point by half a width.
+        // Round uses the same geometry but rounds it off in the fragment shader.
+        if (u_wideCap == CapSquare || u_wideCap == CapRound)
+        {
+            if (whichVert == 0 || whichVert == 1 || whichVert == 10 || whichVert == 11)
+            {
+                pos = corner + dir2 * w2 * screenScale * (isEnd ? 1.0 : -1.0);
+                texY += w2 / projScale * (isEnd ? 1.0 : -1.0);
+            }
+        }
+        if (u_wideCap == CapRound)
+        {
+            v_roundJoin = 1.0;
+            v_centerPos = offsetCenter / screenScale;
+            v_screenPos = pos / screenScale;
+            v_midDir = dir2 * (isEnd ? 1.0 : -1.0);
+        }
+    }
+    else
+    {
+        if (join == JoinNone || !intersectValid)
+        {
+            // Trivial case, just use the corner
+            gl_Position = vec4(pos,0.0,1.0);
+            v_texCoord = -u_wideTexOffset + vec2(texX, texY * u_texScale);
+            return;
+        }
+
+        // Since there is one, use the intersect point by default
+        pos = interPt;
+
+        vec2 otherCorner = offsetCenter + norm2 * (-interSgn * w2 * screenScale);
+
+        if (join == JoinMiter || join == JoinMiterSimple)
+        {
+            // Account for the textures being based on un-projected coordinates
+            texY += dot((interPt - corner) / screenScale, dir2) / projScale;
+        }
+        else if (join == JoinBevel || join == JoinRound)
+        {
+            if (whichVert == 1 || whichVert == 11)
+            {
+                // Halfway between the outside corner and the one on the opposite side
+                vec2 norm = (whichVert == 1) ? norm1 : norm3;
+                vec2 c = offsetCenter + norm2 * realEdge * turnSgn;
+                vec2 e = turnSgn * interSgn * w2 * screenScale;
+                pos = (offsetCenter + c + norm * e) / 2.0;
+                // We're placing the vertex on the "wrong" side, so fix the texture X
+                texX *= turnSgn;
+            }
+            else
+            {
+                // Merge inside corners to avoid overlap, use default outside corner.
+                // The second cap triangle isn't used, so 2 and 10 collapse onto 0 and 8.
+                pos = isInsideEdge ? interPt : corner;
+            }
+
+            // For round, extend the center of the bevel out into a tip the fragment shader rounds off
+            if (join == JoinRound && whichPoly != PolyBody && whichVert != 2 && whichVert != 10)
+            {
+                v_roundJoin = 1.0;
+                v_centerPos = offsetCenter / screenScale;
+                v_screenPos = pos / screenScale;
+
+                // Direction bisecting the turn toward the outside
+                vec2 mid = isEnd ? (dir2 - dir3) : (dir1 - dir2);
+                v_midDir = normalize(mid / screenScale);
+
+                if (whichVert == 1 || whichVert == 11)
+                {
+                    pos += v_midDir * 2.0 * w2 * screenScale;
+                    v_screenPos = pos / screenScale;
+                }
+            }
+        }
+        else if (join == JoinMiterClip)
+        {
+            // Direction of intersect point (bisecting the segment directions) and the perpendicular
+            vec2 interVec = (realInterPt - offsetCenter) / screenScale;
+            vec2 interDir = normalize(interVec) * turnSgn * interSgn;
+            vec2 interNorm = vec2(-interDir.y, interDir.x);
+            float interDist = length(interVec);
+            // Clipped half the miter length from the intersection
+            float midExt = miterLength / 2.0 * strokeWidth + u_edge;
+
+            if (whichVert == 0 || whichVert == 8)
+            {
+                // Out to the miter cap, then perpendicular to the line edge
+                float miterEdgeW2 = (interDist - midExt) * tan(theta / 2.0);
+                pos = offsetCenter + screenScale * (interDir * midExt -
+                        interNorm * miterEdgeW2 * turnSgn * ((whichVert != 0) ? -1.0 : 1.0));
+            }
+            else if (whichVert == 1 || whichVert == 10)
+            {
+                // Extend the turn bisector to the miter clip edge
+                pos = turningLeft ? (offsetCenter + interDir * midExt * screenScale) :
+                                    ((whichVert == 1) ? corner : otherCorner);
+            }
+            else if (whichVert == 2 || whichVert == 9)
+            {
+                // Extend segment endpoint outward along the intersection angle by the miter length
+                pos = turningLeft ? ((whichVert == 2) ? corner : otherCorner) :
+                                    (offsetCenter + interDir * midExt * screenScale);
+            }
+            else if (whichVert == 3 || whichVert == 11)
+            {
+                // The edge intersect, or the one on the other side
+                pos = turningLeft ? interPt : (offsetCenter + (offsetCenter - interPt));
+            }
+            else
+            {
+                // Body segment, merge inside corners
+                pos = isInsideEdge ? interPt : corner;
+            }
+
+            // Fix texture X-coords for vertices placed opposite the usual even/odd side
+            if (whichVert == 1 || whichVert == 9)
+                texX = -texX;
+            if (whichVert < 4 || whichVert > 7)
+                texX *= -turnSgn;
+        }
+    }
+
+    gl_Position = vec4(pos,0.0,1.0);
+    v_texCoord = -u_wideTexOffset + vec2(texX, texY * u_texScale);
+}
+)";
+
+static const char *fragmentShaderPerf = R"(
+precision highp float;
+
+uniform sampler2D s_baseMap0;
+uniform bool  u_hasTexture;
+uniform float u_w2;
+uniform float u_edge;
+
+varying vec2  v_texCoord;
+varying vec4  v_color;
+varying float v_roundJoin;
+varying vec2  v_centerPos;
+varying vec2  v_screenPos;
+varying vec2  v_midDir;
+
+void main()
+{
+    // Dash patterns and such come from the texture alpha
+    float patternAlpha = u_hasTexture ? texture2D(s_baseMap0, vec2(0.5,v_texCoord.y)).a : 1.0;
+
+    // Reduce alpha of the tip for round joins and caps to get a round look
+    float roundAlpha = 1.0;
+    vec2 fromCenter = v_screenPos - v_centerPos;
+    if (v_roundJoin > 0.5 && dot(fromCenter, v_midDir) > 0.0)
+    {
+        float r = dot(fromCenter,fromCenter) / u_w2 / u_w2;
+        roundAlpha = clamp((r > 0.95) ? (1.0 - r) * 20.0 : 1.0, 0.0, 1.0);
+    }
+
+    // Reduce alpha along the edges to get smooth blending
+    float edgeAlpha = (u_edge > 0.0) ? clamp((1.0 - abs(v_texCoord.x)) * u_w2 / u_edge, 0.0, 1.0) : 1.0;
+
+    gl_FragColor = v_color * edgeAlpha * patternAlpha * roundAlpha;
+}
+)";
+
+ProgramGLES *BuildWideVectorPerfProgramGLES(const std::string &name, SceneRenderer *)
+{
+    auto shader = new ProgramGLES(name,vertexShaderPerf,fragmentShaderPerf);
+    if (!shader->isValid())
+    {
+        delete shader;
+        shader = nullptr;
+    }
+
+    // Set some reasonable defaults
+    if (shader)
+    {
+        glUseProgram(shader->getProgram());
+
+        shader->setUniform(u_texScaleNameID, 1.f);
+        shader->setUniform(u_miterLimitNameID, 2.f);
+    }
+
+    return shader;
+}
     
 }
@@ -25,6 +25,7 @@
 #import "WideVectorDrawableBuilder.h"
 #import "MapboxVectorStyleSetC.h"
 #import "WhirlyKitLog.h"
+#import "PerformanceTimer.h"
 
 using namespace WhirlyKit;
 using namespace Eigen;
@@ -52,6 +53,7 @@ WideVectorInfo::WideVectorInfo(const Dictionary &dict)
     implType = implTypeStr.compare(MaplyWideVecImplPerf) ? WideVecImplBasic : WideVecImplPerf;
 
     closeAreals = dict.getBool(MaplyVecCloseAreals, closeAreals);
+    lod = VectorLODSettings(dict);
 
     const std::string coordTypeStr = dict.getString(MaplyWideVecCoordType);
     if (!coordTypeStr.compare(MaplyWideVecCoordTypeReal))
@@ -764,11 +766,7 @@ struct WideVectorDrawableConstructor
                 }
 
                 if (centerValid)
-                {
-                    Eigen::Affine3d trans(Eigen::Translation3d(dispCenter.x(),dispCenter.y(),dispCenter.z()));
-                    Matrix4d transMat = trans.matrix();
-                    drawable->setMatrix(&transMat);
-                }
+                    drawable->setCenter(dispCenter);
             }
         } else {
             // Basic mode builds up a lot more geometry
@@ -818,11 +816,7 @@ struct WideVectorDrawableConstructor
                 if (vecInfo->texID != EmptyIdentity)
                     drawable->setTexId(baseTexId++, vecInfo->texID);
                 if (centerValid)
-                {
-                    Eigen::Affine3d trans(Eigen::Translation3d(dispCenter.x(),dispCenter.y(),dispCenter.z()));
-                    Matrix4d transMat = trans.matrix();
-                    drawable->setMatrix(&transMat);
-                }
+                    drawable->setCenter(dispCenter);
             }
         }
         
@@ -903,12 +897,11 @@ struct WideVectorDrawableConstructor
             }
             
             // Run through the points, adding centerline instances
+            toDisplay(newPts);
             const int startPt = drawable->getCenterLineCount();
             for (unsigned int ii=0;ii<newPts.size();ii++) {
                 const auto &pt = newPts[ii];
-
-                const Point3d localPa = coordSys->geographicToLocal3d(pt);
-                const Point3d dispPa = coordAdapter->localToDisplay(localPa);
+                const Point3d &dispPa = dispPts[ii];
 
                 unsigned int prev = startPt + ii - 1;
                 if (ii == 0) {
@@ -954,21 +947,23 @@ struct WideVectorDrawableConstructor
             int totalPtCount = totalTriCount * 3;
 
             // Work through the segments
+            toDisplay(pts);
             Point2f lastPt;
             bool validLastPt = false;
             for (int ii=startPoint;ii<(int)pts.size();ii++)
             {
                 // Get the points in display space.
                 // Note that we may be starting with a negative index.
-                const Point2f &geoA = pts[(ii + pts.size()) % pts.size()];
+                const int which = (int)((ii + pts.size()) % pts.size());
+                const Point2f &geoA = pts[which];
 
                 if (validLastPt && geoA == lastPt)
                 {
                     continue;
                 }
 
-                const Point3d localPa = coordSys->geographicToLocal3d(GeoCoord(geoA.x(),geoA.y()));
-                const Point3d dispPa = coordAdapter->localToDisplay(localPa);
+                const Point3d &localPa = localPts[which];
+                const Point3d &dispPa = dispPts[which];
                 const Point3d thisUp = coordAdapter->isFlat() ? up : coordAdapter->normalForLocal(localPa);
 
                 // Get a drawable ready
@@ -1063,6 +1058,18 @@ struct WideVectorDrawableConstructor
     }
     
 protected:
+    // Convert a whole linear to local and display coordinates in batches
+    void toDisplay(const VectorRing &pts)
+    {
+        geoPts.resize(pts.size());
+        localPts.resize(pts.size());
+        dispPts.resize(pts.size());
+        for (size_t ii=0;ii<pts.size();ii++)
+            geoPts[ii] = pts[ii].cast<double>();
+        coordSys->geographicToLocalBatch(geoPts.data(),localPts.data(),pts.size());
+        coordAdapter->localToDisplayBatch(localPts.data(),dispPts.data(),pts.size());
+    }
+
     // Move an active drawable to the list
     void flush()
     {
@@ -1090,6 +1097,9 @@ protected:
     WideVectorDrawableBuilderRef drawable = nullptr;
     std::vector<WideVectorDrawableBuilderRef> drawables;
     std::string drawableName;
+    // Scratch space for toDisplay
+    std::vector<Point2d> geoPts;
+    std::vector<Point3d> localPts,dispPts;
 };
     
 void WideVectorSceneRep::enableContents(bool enable,ChangeSet &changes)
@@ -1124,8 +1134,22 @@ WideVectorManager::~WideVectorManager()
 static const std::string colorStr = "color"; // NOLINT(cert-err58-cpp)   constructor can throw
 static const std::string maskID0 = "maskID0"; // NOLINT
 
+SimpleIdentity WideVectorManager::addVectors(const CompactShapeSet &shapes,const WideVectorInfo &vecInfo,ChangeSet &changes)
+{
+    std::vector<VectorShapeRef> decoded;
+    shapes.decode(decoded);
+    return addVectors(decoded,vecInfo,changes);
+}
+
 SimpleIdentity WideVectorManager::addVectors(const std::vector<VectorShapeRef> &shapes,const WideVectorInfo &vecInfo,ChangeSet &changes)
 {
+    WKTraceScope("WideVector addVectors");
+
+    if (vecInfo.lod.levels > 0 && vecInfo.zoomSlot >= 0)
+    {
+        return addVectorLODs(shapes,vecInfo,changes);
+    }
+
     // Calculate a center for this geometry
     bool doColors = false;
     bool hasMaskIDs = false;
@@ -1241,6 +1265,51 @@ SimpleIdentity WideVectorManager::addVectors(const std::vector<VectorShapeRef> &
     return vecID;
 }
 
+SimpleIdentity WideVectorManager::addVectorLODs(const std::vector<VectorShapeRef> &shapes,const WideVectorInfo &vecInfo,ChangeSet &changes)
+{
+    WideVectorInfo lodInfo(vecInfo);
+    lodInfo.lod.levels = 0;
+
+    std::vector<VectorShapeRef> lodShapes;
+    WideVectorSceneRep *sceneRep = nullptr;
+    for (const auto &lod : CalcVectorLODs(vecInfo.lod,vecInfo.minZoomVis,vecInfo.maxZoomVis))
+    {
+        lodInfo.minZoomVis = lod.minZoomVis;
+        lodInfo.maxZoomVis = lod.maxZoomVis;
+        lodShapes.clear();
+        if (lod.eps > 0.0)
+        {
+            SimplifyShapes(shapes,lod.eps,lodShapes);
+        }
+        const SimpleIdentity lodID = addVectors((lod.eps > 0.0) ? lodShapes : shapes,lodInfo,changes);
+        if (lodID == EmptyIdentity)
+        {
+            continue;
+        }
+
+        // Fold this level into the first one
+        std::lock_guard<std::mutex> guardLock(lock);
+        WideVectorSceneRep dummyRep(lodID);
+        const auto it = sceneReps.find(&dummyRep);
+        if (it == sceneReps.end())
+        {
+            continue;
+        }
+        if (!sceneRep)
+        {
+            sceneRep = *it;
+            continue;
+        }
+        const WideVectorSceneRep *lodRep = *it;
+        sceneRep->drawIDs.insert(lodRep->drawIDs.begin(),lodRep->drawIDs.end());
+        sceneRep->instIDs.insert(lodRep->instIDs.begin(),lodRep->instIDs.end());
+        sceneReps.erase(it);
+        delete lodRep;
+    }
+
+    return sceneRep ? sceneRep->getId() : EmptyIdentity;
+}
+
 void WideVectorManager::enableVectors(SimpleIDSet &vecIDs,bool enable,ChangeSet &changes)
 {
     std::lock_guard<std::mutex> guardLock(lock);
@@ -1314,6 +1383,27 @@ SimpleIdentity WideVectorManager::instanceVectors(SimpleIdentity vecID,const Wid
     return newId;
 }
 
+void WideVectorManager::changeSceneRep(const WideVectorSceneRep &sceneRep,const WideVectorInfo &vecInfo,
+                                       WideVectorDrawableBuilder &builder,ChangeSet &changes)
+{
+    // If we're using instances, we just change those
+    const SimpleIDSet &allIDs = sceneRep.instIDs.empty() ? sceneRep.drawIDs : sceneRep.instIDs;
+
+    // Set the builder up with the new values (works for Metal)
+    builder.setValues(vecInfo);
+    builder.generateChanges(allIDs, changes);
+
+    for (const auto id : allIDs)
+    {
+        auto change = new DrawableStyleChangeRequest(id, vecInfo.color, vecInfo.drawPriority, vecInfo.drawOrder);
+        if (vecInfo.minVis != DrawVisibleInvalid || vecInfo.maxVis != DrawVisibleInvalid)
+        {
+            change->setVisibleRange(vecInfo.minVis, vecInfo.maxVis);
+        }
+        changes.push_back(change);
+    }
+}
+
 void WideVectorManager::changeVectors(SimpleIdentity vecID,const WideVectorInfo &vecInfo,ChangeSet &changes)
 {
     std::lock_guard<std::mutex> guardLock(lock);
@@ -1324,31 +1414,26 @@ void WideVectorManager::changeVectors(SimpleIdentity vecID,const WideVectorInfo
     const auto it = sceneReps.find(&dummyRep);
     if (it != sceneReps.end())
     {
-        const auto sceneRep = *it;
+        changeSceneRep(**it,vecInfo,*builder,changes);
+    }
+}
 
-        // If we're using instances, we just change those
-        SimpleIDSet allIDs = sceneRep->instIDs.empty() ? sceneRep->drawIDs : sceneRep->instIDs;
+void WideVectorManager::changeVectors(const std::unordered_map<SimpleIdentity,WideVectorInfoRef> &vecInfos,ChangeSet &changes)
+{
+    changes.reserve(changes.size() + vecInfos.size());
+
+    std::lock_guard<std::mutex> guardLock(lock);
 
-        // Set the builder up with the new values (works for Metal)
-        builder->setValues(vecInfo);
-        builder->generateChanges(allIDs, changes);
+    // One builder is enough to work out the uniforms for all of them
+    WideVectorDrawableBuilderRef builder = renderer->makeWideVectorDrawableBuilder("Wide Vector change");
 
-        for (const auto id : allIDs)
+    for (const auto &entry : vecInfos)
+    {
+        WideVectorSceneRep dummyRep(entry.first);
+        const auto it = sceneReps.find(&dummyRep);
+        if (it != sceneReps.end() && entry.second)
         {
-            // Changed color
-            changes.push_back(new ColorChangeRequest(id, vecInfo.color));
-            
-            // Changed visibility
-            if (vecInfo.minVis != DrawVisibleInvalid || vecInfo.maxVis != DrawVisibleInvalid)
-            {
-                changes.push_back(new VisibilityChangeRequest(id, vecInfo.minVis, vecInfo.maxVis));
-            }
-                        
-            // Changed draw priority
-            changes.push_back(new DrawPriorityChangeRequest(id, vecInfo.drawPriority));
-            
-            // Changed draw order
-            changes.push_back(new DrawOrderChangeRequest(id, vecInfo.drawOrder));
+            changeSceneRep(**it,*entry.second,*builder,changes);
         }
     }
 }
@@ -0,0 +1,120 @@
+/*  WorkerPool.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import "WorkerPool.h"
+
+namespace WhirlyKit
+{
+
+int WorkerPool::getDefaultNumThreads()
+{
+    // Past this the layer threads and the renderer start fighting over cores
+    const int MaxDefaultThreads = 3;
+    const int numCores = (int)std::thread::hardware_concurrency();
+    return std::min(std::max(numCores - 1,0),MaxDefaultThreads);
+}
+
+WorkerPool::WorkerPool(int numThreads) :
+    nextChunk(0)
+{
+    threads.reserve(std::max(numThreads,0));
+    for (int ii=0;ii<numThreads;ii++)
+        threads.emplace_back(&WorkerPool::workerMain,this);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        shutdown = true;
+    }
+    wakeCond.notify_all();
+    for (auto &thread : threads)
+        thread.join();
+}
+
+void WorkerPool::runChunks(const RangeFunc &func,size_t count,size_t chunkSize)
+{
+    while (true)
+    {
+        const size_t start = nextChunk.fetch_add(chunkSize,std::memory_order_relaxed);
+        if (start >= count)
+            break;
+        func(start,std::min(start+chunkSize,count));
+    }
+}
+
+void WorkerPool::parallelFor(size_t count,size_t chunkSize,const RangeFunc &func)
+{
+    if (count == 0)
+        return;
+    chunkSize = std::max(chunkSize,(size_t)1);
+
+    // Not worth waking anyone up, or they're busy
+    std::unique_lock<std::mutex> callerUniqueLock(callerLock,std::defer_lock);
+    if (threads.empty() || count <= chunkSize || !callerUniqueLock.try_lock())
+    {
+        func(0,count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        job = &func;
+        jobCount = count;
+        jobChunkSize = chunkSize;
+        nextChunk.store(0,std::memory_order_relaxed);
+        jobGeneration++;
+    }
+    wakeCond.notify_all();
+
+    runChunks(func,count,chunkSize);
+
+    // Everything's been handed out, but workers may still be finishing theirs
+    std::unique_lock<std::mutex> uniqueLock(lock);
+    doneCond.wait(uniqueLock,[this]{ return activeWorkers == 0; });
+    job = nullptr;
+}
+
+void WorkerPool::workerMain()
+{
+    unsigned int seenGeneration = 0;
+
+    std::unique_lock<std::mutex> uniqueLock(lock);
+    while (true)
+    {
+        wakeCond.wait(uniqueLock,[&]{ return shutdown || (job && jobGeneration != seenGeneration); });
+        if (shutdown)
+            break;
+
+        seenGeneration = jobGeneration;
+        const RangeFunc *func = job;
+        const size_t count = jobCount;
+        const size_t chunkSize = jobChunkSize;
+        activeWorkers++;
+        uniqueLock.unlock();
+
+        runChunks(*func,count,chunkSize);
+
+        uniqueLock.lock();
+        if (--activeWorkers == 0)
+            doneCond.notify_one();
+    }
+}
+
+}
@@ -17,17 +17,50 @@
  */
 
 #import <string.h>
+#import <stdio.h>
 #import "WrapperGLES.h"
 
-#ifdef __ANDROID__
+#if defined(__ANDROID__) || defined(__linux__)
 
+// Android and host builds find out from the context
 bool hasVertexArraySupport = false;
 bool hasMapBufferSupport = false;
+bool hasFramebufferBlitSupport = false;
+bool hasASTCSupport = false;
+bool hasTimerQuerySupport = false;
 
 #else
 
 // On ios we have both
 bool hasVertexArraySupport = true;
 bool hasMapBufferSupport = true;
+bool hasFramebufferBlitSupport = false;
+bool hasASTCSupport = false;
+bool hasTimerQuerySupport = false;
 
 #endif
+
+void SetupGLESCapabilities()
+{
+    // Looks like "OpenGL ES 3.2 ..." and is null with no context
+    const auto *version = (const char *)glGetString(GL_VERSION);
+    int major = 0, minor = 0;
+    if (version && sscanf(version, "OpenGL ES %d.%d", &major, &minor) >= 1 && major >= 3)
+    {
+        hasVertexArraySupport = true;
+        hasFramebufferBlitSupport = true;
+    }
+
+    const auto *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    if ((major == 3 && minor >= 2) || major > 3 ||
+        (extensions && strstr(extensions, "GL_KHR_texture_compression_astc_ldr")))
+    {
+        hasASTCSupport = true;
+    }
+
+    // The ES 3 query calls work for timers once the extension's there
+    if (major >= 3 && extensions && strstr(extensions, "GL_EXT_disjoint_timer_query"))
+    {
+        hasTimerQuerySupport = true;
+    }
+}
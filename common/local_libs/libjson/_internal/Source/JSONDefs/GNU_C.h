@@ -55,7 +55,12 @@
     #endif
 
     #define json_nothrow throw()
-    #define json_throws(x) throw(x)
+    #if __cplusplus >= 201703L
+	   // Dynamic exception specifications are gone in C++17
+	   #define json_throws(x)
+    #else
+	   #define json_throws(x) throw(x)
+    #endif
 
     #ifdef JSON_LESS_MEMORY
 	   #define PACKED(x) :x __attribute__ ((packed))
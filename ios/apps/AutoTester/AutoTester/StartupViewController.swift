@@ -19,6 +19,7 @@ class StartupViewController: UITableViewController, UIPopoverPresentationControl
         BNGCustomMapTestCase(),
         BNGTestCase(),
         BillboardTestCase(),
+        CameraPathBenchmarkTestCase(),
         CartoDBLightTestCase(),
         CartoDBTestCase(),
         ChangeVectorsTestCase(),
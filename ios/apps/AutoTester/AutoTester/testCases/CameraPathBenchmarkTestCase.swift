@@ -0,0 +1,251 @@
+//
+//  CameraPathBenchmarkTestCase.swift
+//  AutoTester
+//
+//  Copyright 2015-2022 mousebird consulting.
+//
+
+import UIKit
+import WhirlyGlobe
+
+// Replays fixed camera paths over the local Geography Class tiles and records how the renderer keeps up.
+// The camera is placed by frame number rather than by time, so every run sees the same views in
+// the same order no matter how fast the device is.
+// Set START_TEST to "Camera Path Benchmark" to run it unattended.  Results go to the log on a line
+// starting with BENCHMARK_RESULT and to benchmark-globe.json or benchmark-map.json in Documents.
+class CameraPathBenchmarkTestCase: MaplyTestCase {
+
+    override init() {
+        super.init()
+
+        self.name = "Camera Path Benchmark"
+        self.implementations = [.globe, .map]
+    }
+
+    struct Keyframe {
+        let lon: Double
+        let lat: Double
+        let height: Float
+        let heading: Float
+    }
+
+    struct CameraPath {
+        let name: String
+        let frames: Int
+        // Fling paths start fast and coast to a stop
+        let easeOut: Bool
+        let keys: [Keyframe]
+    }
+
+    static let paths: [CameraPath] = [
+        CameraPath(name: "pan", frames: 300, easeOut: false, keys: [
+            Keyframe(lon: -122.4192, lat: 37.7793, height: 0.05, heading: 0.0),
+            Keyframe(lon: -118.2437, lat: 34.0522, height: 0.05, heading: 0.0),
+            Keyframe(lon: -112.0740, lat: 33.4484, height: 0.05, heading: 0.0)]),
+        CameraPath(name: "fling", frames: 180, easeOut: true, keys: [
+            Keyframe(lon: -0.1276, lat: 51.5072, height: 0.1, heading: 0.0),
+            Keyframe(lon: 13.4050, lat: 52.5200, height: 0.1, heading: 0.0)]),
+        CameraPath(name: "zoom", frames: 360, easeOut: false, keys: [
+            Keyframe(lon: 151.2111, lat: -33.8600, height: 2.0, heading: 0.0),
+            Keyframe(lon: 151.2111, lat: -33.8600, height: 0.005, heading: 0.0),
+            Keyframe(lon: 151.2111, lat: -33.8600, height: 2.0, heading: 0.0)]),
+        CameraPath(name: "spin", frames: 360, easeOut: false, keys: [
+            Keyframe(lon: -180.0, lat: 20.0, height: 1.5, heading: 0.0),
+            Keyframe(lon: 0.0, lat: 20.0, height: 1.5, heading: 0.0),
+            Keyframe(lon: 180.0, lat: 20.0, height: 1.5, heading: 0.0)]),
+    ]
+
+    // Longest we'll wait for the tiles to come in before and after each path
+    let settleTimeout: TimeInterval = 20.0
+
+    override func setUpWithGlobe(_ globeVC: WhirlyGlobeViewController) {
+        viewType = "globe"
+        start(globeVC)
+    }
+
+    override func setUpWithMap(_ mapVC: MaplyViewController) {
+        viewType = "map"
+        start(mapVC)
+    }
+
+    override func stop() {
+        displayLink?.invalidate()
+        displayLink = nil
+        timer?.invalidate()
+        timer = nil
+        baseCase.stop()
+        super.stop()
+    }
+
+    private func start(_ viewC: MaplyBaseViewController) {
+        baseCase.setupLayers(viewC)
+        viewC.frameStatsEnabled = true
+        results = ["view": viewType,
+                   "startup": viewC.startupTimings()]
+        pathResults = []
+        pathIndex = 0
+        moveTo(Self.paths[0].keys[0])
+        waitForTiles { [weak self] _ in self?.startPath() }
+    }
+
+    // Position along a path, by frame number
+    private func keyframe(_ path: CameraPath, frame: Int) -> Keyframe {
+        var t = Double(frame) / Double(max(path.frames - 1, 1))
+        if path.easeOut {
+            t = 1.0 - (1.0 - t) * (1.0 - t)
+        }
+        let span = t * Double(path.keys.count - 1)
+        let which = min(Int(span), path.keys.count - 2)
+        let frac = span - Double(which)
+        let a = path.keys[which], b = path.keys[which + 1]
+        return Keyframe(lon: a.lon + (b.lon - a.lon) * frac,
+                        lat: a.lat + (b.lat - a.lat) * frac,
+                        height: a.height + (b.height - a.height) * Float(frac),
+                        heading: a.heading + (b.heading - a.heading) * Float(frac))
+    }
+
+    private func moveTo(_ key: Keyframe) {
+        let pos = MaplyCoordinateMakeWithDegrees(Float(key.lon), Float(key.lat))
+        if let globeVC = globeViewController {
+            globeVC.setPosition(pos, height: key.height)
+            globeVC.heading = key.heading
+        } else if let mapVC = mapViewController {
+            mapVC.setPosition(pos, height: key.height)
+            mapVC.heading = key.heading
+        }
+    }
+
+    private var isLoading: Bool {
+        return baseCase.getLoader()?.isLoading() ?? false
+    }
+
+    // Poll the loader until it's idle.  Hands back how long that took, or -1 if it never got there.
+    private func waitForTiles(_ done: @escaping (TimeInterval) -> Void) {
+        let startTime = CACurrentMediaTime()
+        timer?.invalidate()
+        timer = Timer.scheduledTimer(withTimeInterval: 0.05, repeats: true) { [weak self] timer in
+            guard let self = self else {
+                timer.invalidate()
+                return
+            }
+            let elapsed = CACurrentMediaTime() - startTime
+            if !self.isLoading || elapsed > self.settleTimeout {
+                timer.invalidate()
+                self.timer = nil
+                done(self.isLoading ? -1.0 : elapsed)
+            }
+        }
+    }
+
+    private func startPath() {
+        guard let viewC = baseViewController else {
+            return
+        }
+        viewC.clearFrameStats()
+        frame = 0
+        frameTimes = []
+        loadTimes = []
+        loadStart = nil
+        lastTimestamp = nil
+
+        displayLink?.invalidate()
+        displayLink = CADisplayLink(target: self, selector: #selector(step(_:)))
+        displayLink?.add(to: .main, forMode: .common)
+    }
+
+    @objc private func step(_ link: CADisplayLink) {
+        let path = Self.paths[pathIndex]
+
+        if let last = lastTimestamp {
+            frameTimes.append(link.timestamp - last)
+        }
+        lastTimestamp = link.timestamp
+
+        // Each stretch of loading counts as one load, from when it starts to when it's idle again
+        let now = CACurrentMediaTime()
+        if isLoading {
+            if loadStart == nil {
+                loadStart = now
+            }
+        } else if let start = loadStart {
+            loadTimes.append(now - start)
+            loadStart = nil
+        }
+
+        if frame >= path.frames {
+            link.invalidate()
+            displayLink = nil
+            finishPath(path)
+            return
+        }
+
+        moveTo(keyframe(path, frame: frame))
+        frame += 1
+    }
+
+    private func finishPath(_ path: CameraPath) {
+        waitForTiles { [weak self] settleTime in
+            guard let self = self, let viewC = self.baseViewController else {
+                return
+            }
+            if let start = self.loadStart, settleTime >= 0.0 {
+                self.loadTimes.append(CACurrentMediaTime() - start)
+                self.loadStart = nil
+            }
+
+            var result: [String: Any] = [
+                "name": path.name,
+                "frames": path.frames,
+                "frameIntervals": self.frameTimes,
+                "tileLoads": self.loadTimes,
+                "settleTime": settleTime,
+                "memory": viewC.memoryUsage()
+            ]
+            if let stats = viewC.frameStats() {
+                result["frameStats"] = stats
+            }
+            self.pathResults.append(result)
+
+            self.pathIndex += 1
+            if self.pathIndex < Self.paths.count {
+                self.moveTo(Self.paths[self.pathIndex].keys[0])
+                self.waitForTiles { [weak self] _ in self?.startPath() }
+            } else {
+                self.report()
+            }
+        }
+    }
+
+    private func report() {
+        results["paths"] = pathResults
+        guard JSONSerialization.isValidJSONObject(results),
+              let data = try? JSONSerialization.data(withJSONObject: results, options: [.sortedKeys]),
+              let json = String(data: data, encoding: .utf8) else {
+            print("BENCHMARK_RESULT failed to encode results")
+            return
+        }
+        print("BENCHMARK_RESULT \(json)")
+
+        if let docs = FileManager.default.urls(for: .documentDirectory, in: .userDomainMask).first {
+            let url = docs.appendingPathComponent("benchmark-\(viewType).json")
+            do {
+                try data.write(to: url, options: .atomic)
+            } catch {
+                print("Failed to write benchmark results to \(url.path): \(error)")
+            }
+        }
+    }
+
+    private let baseCase = GeographyClassTestCase()
+    private var viewType = "globe"
+    private var displayLink: CADisplayLink?
+    private var timer: Timer?
+    private var pathIndex = 0
+    private var frame = 0
+    private var lastTimestamp: CFTimeInterval?
+    private var frameTimes: [Double] = []
+    private var loadStart: CFTimeInterval?
+    private var loadTimes: [Double] = []
+    private var results: [String: Any] = [:]
+    private var pathResults: [[String: Any]] = []
+}
@@ -17,8 +17,13 @@
 #include "tinyxml2.h"
 #include <dirent.h>
 #include <vector>
+#include <map>
 #include <fstream>
 #include <iostream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <boost/filesystem.hpp>
 #include <boost/geometry.hpp>
 #include <boost/geometry/geometries/point.hpp>
@@ -477,6 +482,9 @@ char *SanitizeSRS( const char *pszUserInput )
 OGRSFDriver *shpDriver = NULL;
 OGRSFDriver *memDriver = NULL;
 
+// Number of worker threads for dicing and encoding tiles
+int numThreads = 1;
+
 // Merge the given features into an existing shapefile or create a new one
 bool MergeIntoShapeFile(std::vector<OGRFeature *> &features,OGRLayer *srcLayer,OGRSpatialReference *out_srs,const char *fileName)
 {
@@ -550,11 +558,141 @@ public:
         numTiles = 0;
     }
     
+    // Add in what another thread built
+    void merge(const BuildStats &that)
+    {
+        minFeat = std::min(minFeat,that.minFeat);
+        maxFeat = std::max(maxFeat,that.maxFeat);
+        featAvg += that.featAvg;
+        numTiles += that.numTiles;
+    }
+    
     int minFeat,maxFeat;
     double featAvg;
     int numTiles;
 };
 
+// Keeps track of which layers have been diced, so a run that dies partway can pick up where it left off.
+// A layer is only written out once all of its chunks are done.  Any partial output for the
+//  layer after that has to be cleared out before doing it again.
+class DiceCheckpoint
+{
+public:
+    // What came out of one call to ChopShapefile
+    class Chunk
+    {
+    public:
+        Chunk() : copiedFeatures(0) { }
+
+        int copiedFeatures;
+        // Cells covered, if it's been set
+        OGREnvelope env;
+    };
+    
+    DiceCheckpoint(const std::string &fileName) : fileName(fileName) { }
+    
+    // Read in what a previous run finished.  Lines for a layer that never finished won't be there.
+    void load()
+    {
+        FILE *fp = fopen(fileName.c_str(),"r");
+        if (!fp)
+            return;
+        char line[1024];
+        while (fgets(line,sizeof(line),fp))
+        {
+            int layer,level,style,dataType,envSet;
+            Chunk chunk;
+            if (sscanf(line,"chunk %d %d %d %d %d %d %lf %lf %lf %lf",&layer,&level,&style,&dataType,&chunk.copiedFeatures,&envSet,
+                       &chunk.env.MinX,&chunk.env.MinY,&chunk.env.MaxX,&chunk.env.MaxY) == 10)
+            {
+                if (!envSet)
+                    chunk.env = OGREnvelope();
+                chunks[ChunkKey(layer,level,style,dataType)] = chunk;
+            } else if (sscanf(line,"layer %d",&layer) == 1)
+                doneLayers.insert(layer);
+        }
+        fclose(fp);
+    }
+    
+    bool isLayerDone(int layer) { return doneLayers.find(layer) != doneLayers.end(); }
+    
+    // Look for a chunk from a finished layer
+    bool getChunk(int layer,int level,int style,int dataType,Chunk &chunk)
+    {
+        std::map<std::string,Chunk>::iterator it = chunks.find(ChunkKey(layer,level,style,dataType));
+        if (it == chunks.end())
+            return false;
+        chunk = it->second;
+        return true;
+    }
+    
+    // Note a chunk that's done.  It's not written out until the whole layer is.
+    void addChunk(int layer,int level,int style,int dataType,const Chunk &chunk)
+    {
+        char line[1024];
+        sprintf(line,"chunk %d %d %d %d %d %d %.17g %.17g %.17g %.17g\n",layer,level,style,dataType,chunk.copiedFeatures,(int)chunk.env.IsInit(),
+                chunk.env.MinX,chunk.env.MinY,chunk.env.MaxX,chunk.env.MaxY);
+        pending += line;
+    }
+    
+    // Write out the layer's chunks and that it's done
+    bool finishLayer(int layer)
+    {
+        FILE *fp = fopen(fileName.c_str(),"a");
+        if (!fp)
+            return false;
+        fprintf(fp,"%slayer %d\n",pending.c_str(),layer);
+        bool ok = (fflush(fp) == 0);
+        fclose(fp);
+        pending.clear();
+        doneLayers.insert(layer);
+        return ok;
+    }
+    
+protected:
+    std::string ChunkKey(int layer,int level,int style,int dataType)
+    {
+        return std::to_string(layer) + "_" + std::to_string(level) + "_" + std::to_string(style) + "_" + std::to_string(dataType);
+    }
+    
+    std::string fileName;
+    std::set<int> doneLayers;
+    std::map<std::string,Chunk> chunks;
+    std::string pending;
+};
+
+// Remove anything diced for the given layer.  Cell files are named <x><layer>_<type>
+//  in a directory per row.
+void RemoveLayerFiles(const char *targetDir,int minLevel,int maxLevel,const std::string &layerName)
+{
+    for (int level = minLevel;level<=maxLevel;level++)
+    {
+        std::string levelDir = (std::string)targetDir + "/" + std::to_string(level);
+        try
+        {
+            std::vector<boost::filesystem::path> toRemove;
+            for (boost::filesystem::recursive_directory_iterator dirIter(levelDir);
+                 dirIter != boost::filesystem::recursive_directory_iterator(); ++dirIter)
+            {
+                if (!boost::filesystem::is_regular_file(dirIter->status()))
+                    continue;
+                std::string stem = dirIter->path().stem().string();
+                size_t pos = stem.find_first_not_of("0123456789");
+                if (pos == 0 || pos == std::string::npos)
+                    continue;
+                std::string rest = stem.substr(pos);
+                if (rest.size() == layerName.size()+2 && !rest.compare(0,layerName.size(),layerName) && rest[layerName.size()] == '_')
+                    toRemove.push_back(dirIter->path());
+            }
+            for (unsigned int ii=0;ii<toRemove.size();ii++)
+                boost::filesystem::remove(toRemove[ii]);
+        }
+        catch (...)
+        {
+            // Nothing there yet
+        }
+    }
+}
 
 class ShapefileWrapper
 {
@@ -668,11 +806,16 @@ void ChopShapefile(const char *layerName,OGRDataSource *poDS,std::vector<OGRFeat
             fprintf(stderr,"Can't transform from coordinate system to destination for input\n");
             exit(-1);
         }
-        OGRCoordinateTransformation *tileTransform = OGRCreateCoordinateTransformation(hTrgSRS,hTileSRS);
-        if (!tileTransform)
+        // Coordinate transforms aren't thread safe, so each worker gets its own
+        std::vector<OGRCoordinateTransformation *> tileTransforms(numThreads,NULL);
+        for (unsigned int ti=0;ti<tileTransforms.size();ti++)
         {
-            fprintf(stderr,"Can't transform from coordinate system to tile for input file\n");
-            exit(-1);
+            tileTransforms[ti] = OGRCreateCoordinateTransformation(hTrgSRS,hTileSRS);
+            if (!tileTransforms[ti])
+            {
+                fprintf(stderr,"Can't transform from coordinate system to tile for input file\n");
+                exit(-1);
+            }
         }
 
         OGRDataSource *memDS = memDriver->CreateDataSource("memory");
@@ -691,60 +834,84 @@ void ChopShapefile(const char *layerName,OGRDataSource *poDS,std::vector<OGRFeat
         sx = std::max(sx,0);  sy = std::max(sy,0);
         ex = std::min(ex,numCells-1);  ey = std::min(ey,numCells-1);
         
-        // Work through the possible cells
-        for (unsigned int iy=sy;iy<=ey;iy++)
+        // Work through the possible cells.  Each row has its own directory, so the workers
+        //  take whole rows and never write to the same file.
+        std::atomic<int> nextRow(sy);
+        std::mutex statsLock;
+        std::vector<std::thread> workers;
+        for (unsigned int ti=0;ti<tileTransforms.size();ti++)
         {
-            for (unsigned int ix=sx;ix<=ex;ix++)
+            workers.push_back(std::thread([&,ti]()
             {
-                std::string cellDir = (std::string)targetDir + "/" + std::to_string(iy) + "/";
-                std::string cellFileName = cellDir + std::to_string(ix) + ".shp";
+                OGRCoordinateTransformation *tileTransform = tileTransforms[ti];
+                BuildStats rowStats;
+                OGREnvelope rowEnv;
+                bool rowEnvSet = false;
+                int iy;
+                while ((iy = nextRow++) <= ey)
+                {
+                    for (int ix=sx;ix<=ex;ix++)
+                    {
+                        // Clip the input geometry to this cell
+                        OGREnvelope cellEnv;
+                        cellEnv.MinX = ix*cellSizeX+xmin;
+                        cellEnv.MinY = iy*cellSizeY+ymin;
+                        cellEnv.MaxX = (ix+1)*cellSizeX+xmin;
+                        cellEnv.MaxY = (iy+1)*cellSizeY+ymin;
                 
-                // Clip the input geometry to this cell
-                OGREnvelope cellEnv;
-                cellEnv.MinX = ix*cellSizeX+xmin;
-                cellEnv.MinY = iy*cellSizeY+ymin;
-                cellEnv.MaxX = (ix+1)*cellSizeX+xmin;
-                cellEnv.MaxY = (iy+1)*cellSizeY+ymin;
+                        // Check against clip bounds
+                        if (clipEnv && !(clipEnv->Intersects(cellEnv) || clipEnv->Contains(cellEnv)))
+                            continue;
                 
-                // Check against clip bounds
-                if (clipEnv && !(clipEnv->Intersects(cellEnv) || clipEnv->Contains(cellEnv)))
-                    continue;
+                        // Make sure we include the clipping box
+                        OGREnvelope toClipEnv = cellEnv;
+                        if (clipEnv)
+                            toClipEnv.Intersect(*clipEnv);
                 
-                // Make sure we include the clipping box
-                OGREnvelope toClipEnv = cellEnv;
-                if (clipEnv)
-                    toClipEnv.Intersect(*clipEnv);
+                        if (rowEnvSet)
+                            rowEnv.Merge(cellEnv);
+                        else
+                            rowEnv = cellEnv;
+                        rowEnvSet = true;
                 
-                totalEnv.Merge(cellEnv);
+                        std::vector<OGRFeature *> clippedFeatures;
+                        ClipInputToBox(&layerIndex,toClipEnv.MinX,toClipEnv.MinY,toClipEnv.MaxX,toClipEnv.MaxY,hTrgSRS,clippedFeatures,tileTransform);
                 
-                std::vector<OGRFeature *> clippedFeatures;
-                ClipInputToBox(&layerIndex,toClipEnv.MinX,toClipEnv.MinY,toClipEnv.MaxX,toClipEnv.MaxY,hTrgSRS,clippedFeatures,tileTransform);
+                        //                    fprintf(stdout, "            Cell (%d,%d):  %d features\n",ix,iy,cellLayer->GetFeatureCount());
                 
-                //                    fprintf(stdout, "            Cell (%d,%d):  %d features\n",ix,iy,cellLayer->GetFeatureCount());
+                        // Clean up and flush output data
+                        int numFeat = (int)clippedFeatures.size();
+                        rowStats.minFeat = std::min(rowStats.minFeat,numFeat);
+                        rowStats.maxFeat = std::max(rowStats.maxFeat,numFeat);
+                        rowStats.numTiles++;
+                        rowStats.featAvg += numFeat;
+                        if (numFeat > 0)
+                        {
+                            std::string cellDir = (std::string)targetDir + "/" + std::to_string(level) + "/" + std::to_string(iy) + "/";
+                            mkdir(cellDir.c_str(),S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+                            const char *typeName = (dataType == MapnikConfig::SymbolDataPoint ? "_p" : ((dataType == MapnikConfig::SymbolDataLinear) ? "_l" : ((dataType == MapnikConfig::SymbolDataAreal) ? "_a" : "_u")));
+                            std::string cellFileName = cellDir + std::to_string(ix) + layerName + typeName + ".shp";
+                            if (!MergeIntoShapeFile(clippedFeatures,layer,hTileSRS,cellFileName.c_str()))
+                                exit(-1);
+                        }
                 
-                // Clean up and flush output data
-                int numFeat = (int)clippedFeatures.size();
-                stats.minFeat = std::min(stats.minFeat,numFeat);
-                stats.maxFeat = std::max(stats.maxFeat,numFeat);
-                stats.numTiles++;
-                stats.featAvg += numFeat;
-                if (numFeat > 0)
-                {
-                    std::string cellDir = (std::string)targetDir + "/" + std::to_string(level) + "/" + std::to_string(iy) + "/";
-                    mkdir(cellDir.c_str(),S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
-                    const char *typeName = (dataType == MapnikConfig::SymbolDataPoint ? "_p" : ((dataType == MapnikConfig::SymbolDataLinear) ? "_l" : ((dataType == MapnikConfig::SymbolDataAreal) ? "_a" : "_u")));
-                    std::string cellFileName = cellDir + std::to_string(ix) + layerName + typeName + ".shp";
-                    if (!MergeIntoShapeFile(clippedFeatures,layer,hTileSRS,cellFileName.c_str()))
-                        exit(-1);
+                        for (unsigned int ii=0;ii<clippedFeatures.size();ii++)
+                            OGRFeature::DestroyFeature(clippedFeatures[ii]);
+                    }
                 }
                 
-                for (unsigned int ii=0;ii<clippedFeatures.size();ii++)
-                    OGRFeature::DestroyFeature(clippedFeatures[ii]);
-            }
+                std::lock_guard<std::mutex> guardLock(statsLock);
+                stats.merge(rowStats);
+                if (rowEnvSet)
+                    totalEnv.Merge(rowEnv);
+            }));
         }
+        for (unsigned int ti=0;ti<workers.size();ti++)
+            workers[ti].join();
         
         OGRDataSource::DestroyDataSource(memDS);
-        delete tileTransform;
+        for (unsigned int ti=0;ti<tileTransforms.size();ti++)
+            delete tileTransforms[ti];
         delete transform;
     }
 }
@@ -765,6 +932,196 @@ int ScaleForLevel(int level,float levelScale)
     return (1<<exp) * 150 / levelScale;
 }
 
+// One tile's worth of data, ready to go into the vector DB
+class EncodedTile
+{
+public:
+    int x,layerID;
+    std::vector<unsigned char> data;
+};
+
+// A row of tiles at one level
+class EncodedRow
+{
+public:
+    std::vector<EncodedTile> tiles;
+    std::string error;
+};
+
+// Read the diced shapefiles for a row of tiles and encode them for the vector DB.
+// Web DB files are written here too.  This runs on the worker threads, so it only
+//  touches files for its own row.
+void EncodeRow(Maply::VectorDatabase *vectorDb,const char *targetDir,const char *webDbDir,const char *webDbName,int level,int iy,int sx,int ex,int maxLevelSeen,bool mergeLayers,const std::vector<std::string> &localLayerNames,const std::vector<int> &layerIDs,EncodedRow &row)
+{
+    bool fileExists = true;
+    // If there's nothing in the row we can skip that
+    std::string yDir = (std::string)targetDir + "/" + std::to_string(level) + "/" + std::to_string(iy);
+    boost::filesystem::path yDirPath(yDir);
+    try
+    {
+        fileExists = boost::filesystem::exists(yDirPath);
+    }
+    catch (...)
+    {
+        // This tells us nothing
+    }
+    if (!fileExists)
+        return;
+    
+    // Collect up all the filenames for the row, to save us from opening files one by one
+    bool fileNameCache = false;
+    std::set<std::string> yFileNames;
+    try
+    {
+        for (boost::filesystem::directory_iterator dirIter = boost::filesystem::directory_iterator(yDir);
+             dirIter != boost::filesystem::directory_iterator(); ++dirIter)
+        {
+            boost::filesystem::path p = dirIter->path();
+            std::string ext = p.extension().string();
+            if (!ext.compare(".shp"))
+            {
+                yFileNames.insert(p.string());
+            }
+        }
+        fileNameCache = true;
+    }
+    catch (...)
+    {
+        fileNameCache = false;
+    }
+
+    for (int ix=sx;ix<=ex;ix++)
+    {
+        // Work through the layers at this level
+        std::vector<OGRDataSource *> dataSources;
+        std::vector<OGRFeature *> layerFeatures;
+        for (unsigned int li=0;li<localLayerNames.size();li++)
+        {
+            // Load all the data types together into memory at once
+            std::string layerName = localLayerNames[li];
+            std::string cellDir = (std::string)targetDir + "/" + std::to_string(level) + "/" + std::to_string(iy) + "/";
+
+            for (int di=0;di<MapnikConfig::SymbolDataUnknown;di++)
+            {
+                const char *typeName = (di == MapnikConfig::SymbolDataPoint ? "_p" : ((di == MapnikConfig::SymbolDataLinear) ? "_l" : ((di == MapnikConfig::SymbolDataAreal) ? "_a" : "_u")));
+                std::string cellFileName = cellDir + std::to_string(ix) + layerName + typeName + ".shp";
+                
+                // Look for the filename in the name cache.  Faster.
+                if (fileNameCache)
+                    if (yFileNames.find(cellFileName) == yFileNames.end())
+                        continue;
+
+                // Open the shapefile and get pointers to the features
+                OGRDataSource *poCDS = shpDriver->Open(cellFileName.c_str());
+                if (poCDS)
+                {
+                    OGRLayer *srcLayer = poCDS->GetLayer(0);
+                    for (unsigned int fi=0;fi<srcLayer->GetFeatureCount();fi++)
+                        layerFeatures.push_back(srcLayer->GetFeature(fi));
+                    dataSources.push_back(poCDS);
+                }
+            }
+            
+            // Write the data out in our custom format
+            if (!mergeLayers || (li == localLayerNames.size()-1))
+            {
+                try {
+                    int layerID = 0;
+                    std::string outLayerName = "";
+                    if (!mergeLayers)
+                    {
+                        layerID = layerIDs[li];
+                        outLayerName = layerName;
+                    } else {
+                        layerID = layerIDs[0];
+                        outLayerName = "";
+                    }
+                    // Also write it out to the web DB if needed
+                    std::string cellDir = "";
+                    std::string cellFileName = "";
+                    if (webDbDir)
+                    {
+                        cellDir = (std::string)webDbDir + "/" + std::to_string(level) + "/" + std::to_string(ix) + "/";
+                        cellFileName = cellDir + std::to_string(iy) + outLayerName + ".mvt";
+                    }
+
+                    if (!layerFeatures.empty())
+                    {
+                        EncodedTile tile;
+                        tile.x = ix;
+                        tile.layerID = layerID;
+                        vectorDb->vectorToDBFormat(layerFeatures, tile.data);
+                        if (!tile.data.empty())
+                        {
+                            if (webDbName)
+                            {
+                                void *compressOut;
+                                int compressSize=0;
+                                // Need to compress the tiles first
+                                if (Maply::CompressData((void *)&tile.data[0], (int)tile.data.size(), &compressOut, compressSize))
+                                {
+                                    mkdir(cellDir.c_str(),S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+                                    FILE *fp = fopen(cellFileName.c_str(),"w");
+                                    if (!fp)
+                                    {
+                                        fprintf(stderr,"Failed to open file for write: %s\n",cellFileName.c_str());
+                                        exit(-1);
+                                    }
+                                    if (fwrite(compressOut,compressSize,1,fp) != 1)
+                                    {
+                                        fprintf(stderr,"Failed to write to file: %s\n",cellFileName.c_str());
+                                        exit(-1);
+                                    }
+                                    fclose(fp);
+                                } else {
+                                    fprintf(stderr,"Tile compression failed for %d: (%d,%d)\n",level,ix,iy);
+                                    exit(-1);
+                                }
+                            }
+                            
+                            row.tiles.push_back(tile);
+                        }
+                    } else {
+                        // If it is empty and we're writing a web DB we need to create an empty file
+                        // This is dumb, yes.
+                        if (level < maxLevelSeen-1)
+                        {
+                            if (webDbName)
+                            {
+                                mkdir(cellDir.c_str(),S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+                                FILE *fp = fopen(cellFileName.c_str(),"w");
+                                if (!fp)
+                                {
+                                    fprintf(stderr,"Failed to open file for write: %s\n",cellFileName.c_str());
+                                    exit(-1);
+                                }
+                                fclose(fp);
+                            }
+                        }
+                    }
+                }
+                catch (std::string &errorStr)
+                {
+                    row.error = "Unable to write tile " + std::to_string(level) + ": (" + std::to_string(ix) + "," + std::to_string(iy) + ")\nBecause: " + errorStr;
+                }
+                
+                // Clean up the layer features
+                for (unsigned int lf=0;lf<layerFeatures.size();lf++)
+                    delete layerFeatures[lf];
+                layerFeatures.clear();
+
+                // Clean up the data sources
+                for (unsigned int si=0;si<dataSources.size();si++)
+                    OGRDataSource::DestroyDataSource(dataSources[si]);
+                dataSources.clear();
+                
+                if (!row.error.empty())
+                    return;
+            }
+        }
+    }
+}
+
 int main(int argc, char * argv[])
 {
     const char *targetDir = NULL;
@@ -782,6 +1139,9 @@ int main(int argc, char * argv[])
     std::vector<std::string> pathRedirect;
     float levelScale = 4;
     MapnikConfig::Symbolizer::TileGeometryType tileGeomType = MapnikConfig::Symbolizer::TileGeomAdd;
+    bool resume = false;
+    int batchSize = 1000;
+    numThreads = std::max(1,(int)std::thread::hardware_concurrency());
     
     GDALAllRegister();
     OGRRegisterAll();
@@ -939,6 +1299,38 @@ int main(int argc, char * argv[])
                 fprintf(stderr,"Expecting non-zero number for -levelscale\n");
                 return -1;
             }
+        } else if (EQUAL(argv[ii],"-threads"))
+        {
+            numArgs = 2;
+            if (ii+numArgs > argc)
+            {
+                fprintf(stderr,"Expecting one argument for -threads\n");
+                return -1;
+            }
+            numThreads = atoi(argv[ii+1]);
+            if (numThreads < 1)
+            {
+                fprintf(stderr,"Expecting at least one thread for -threads\n");
+                return -1;
+            }
+        } else if (EQUAL(argv[ii],"-batchsize"))
+        {
+            numArgs = 2;
+            if (ii+numArgs > argc)
+            {
+                fprintf(stderr,"Expecting one argument for -batchsize\n");
+                return -1;
+            }
+            batchSize = atoi(argv[ii+1]);
+            if (batchSize < 1)
+            {
+                fprintf(stderr,"Expecting a positive number for -batchsize\n");
+                return -1;
+            }
+        } else if (EQUAL(argv[ii],"-resume"))
+        {
+            numArgs = 1;
+            resume = true;
         } else if (EQUAL(argv[ii],"-tilegeom"))
         {
             numArgs = 1;
@@ -1026,8 +1418,12 @@ int main(int argc, char * argv[])
         }
     }
     
-    // Clear out the target directory
-    system(((std::string) "rm -rf " + targetDir).c_str() );
+    // Clear out the target directory, unless we're picking up where the last run stopped
+    DiceCheckpoint checkpoint((std::string)targetDir + "/dice_progress.txt");
+    if (resume)
+        checkpoint.load();
+    else
+        system(((std::string) "rm -rf " + targetDir).c_str() );
     
     // Create the output directory
     mkdir(targetDir,S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
@@ -1087,9 +1483,18 @@ int main(int argc, char * argv[])
             fprintf(stdout,"Data Source: %s\n",inLayer.name.c_str());
             fflush(stdout);
 
+            // A finished layer just needs its styles compiled again, which we still do below
+            bool layerDone = checkpoint.isLayerDone(ii);
+            if (layerDone)
+                fprintf(stdout,"  Already diced\n");
+            else if (resume)
+                RemoveLayerFiles(targetDir, minLevel, maxLevel, inLayer.name);
+
             // Load the data into memory reprojected and bounds checked
             std::vector<OGRFeature *> inFeatures;
-            OGRDataSource *inDataSource = LoadAndCheck(inLayer.dataSources[0]->getShapefileName(&inLayer,(shapeCacheDir ? shapeCacheDir : targetDir)).c_str(),(clipBoundsSet ? &clipBounds : NULL),hTrgSRS,inFeatures);
+            OGRDataSource *inDataSource = NULL;
+            if (!layerDone)
+                inDataSource = LoadAndCheck(inLayer.dataSources[0]->getShapefileName(&inLayer,(shapeCacheDir ? shapeCacheDir : targetDir)).c_str(),(clipBoundsSet ? &clipBounds : NULL),hTrgSRS,inFeatures);
             
             MapnikConfig::SortedLayer layer(mapnikConfig,inLayer);
             if (!layer.isValid())
@@ -1157,9 +1562,18 @@ int main(int argc, char * argv[])
                             else
                                 fprintf(stdout,"\tData Type = %s; Filter = %s, %d rules\n",symbolType,style->filter.filter.c_str(),numRules);
                             
-                            int copiedFeatures = 0;
                             std::string thisLayerName = inLayer.name;
-                            ChopShapefile(thisLayerName.c_str(), inDataSource, inFeatures, symGroups, (MapnikConfig::SymbolDataType)di, targetDir, xmin, ymin, xmax, ymax, li, hTrgSRS, hTileSRS, buildStats,fullExtents, (clipBoundsSet ? &clipBounds : NULL),copiedFeatures);
+                            DiceCheckpoint::Chunk chunk;
+                            if (layerDone)
+                                checkpoint.getChunk(ii, li, ssi, di, chunk);
+                            else
+                            {
+                                ChopShapefile(thisLayerName.c_str(), inDataSource, inFeatures, symGroups, (MapnikConfig::SymbolDataType)di, targetDir, xmin, ymin, xmax, ymax, li, hTrgSRS, hTileSRS, buildStats,chunk.env, (clipBoundsSet ? &clipBounds : NULL),chunk.copiedFeatures);
+                                checkpoint.addChunk(ii, li, ssi, di, chunk);
+                            }
+                            if (chunk.env.IsInit())
+                                fullExtents.Merge(chunk.env);
+                            int copiedFeatures = chunk.copiedFeatures;
                             
                             if (copiedFeatures > 0)
                             {
@@ -1187,6 +1601,9 @@ int main(int argc, char * argv[])
             for (unsigned int fi=0;fi<inFeatures.size();fi++)
                 delete inFeatures[fi];
             delete inDataSource;
+            
+            if (!layerDone && !checkpoint.finishLayer(ii))
+                fprintf(stderr,"Couldn't record progress for layer %s\n",inLayer.name.c_str());
         }
         
         // Write the symbolizers out as JSON
@@ -1263,7 +1680,7 @@ int main(int argc, char * argv[])
             return -1;
         }
         
-        // Do one big transaction
+        // Tiles go in a batch at a time, starting here
         {
             Kompex::SQLiteStatement transactStmt(sqliteDb);
             transactStmt.SqlStatement((std::string)"BEGIN TRANSACTION");
@@ -1307,6 +1724,9 @@ int main(int argc, char * argv[])
                 }
             }
             
+            // Commit every so often rather than holding everything in one transaction
+            int tilesInBatch = 0;
+            
             // Work through the levels
             for (unsigned int level = minLevel; level <= maxLevel; level++)
             {
@@ -1322,185 +1742,100 @@ int main(int argc, char * argv[])
                 sx = std::max(sx,0);  sy = std::max(sy,0);
                 ex = std::min(ex,numCells-1);  ey = std::min(ey,numCells-1);
                 
-                for (unsigned int iy=sy;iy<=ey;iy++)
+                // The workers read and encode rows, which we write out here in order.
+                // They're not allowed to get too far ahead, so we don't hold on to too much.
+                std::mutex rowLock;
+                std::condition_variable rowCond;
+                std::map<int,EncodedRow *> doneRows;
+                int nextRow = sy, writeRow = sy;
+                bool stopWorkers = false;
+                std::vector<std::thread> workers;
+                for (int ti=0;ti<numThreads;ti++)
                 {
-                    bool fileExists = true;
-                    // If there's nothing in the row we can skip that
-                    std::string yDir = (std::string)targetDir + "/" + std::to_string(level) + "/" + std::to_string(iy);
-                    boost::filesystem::path yDirPath(yDir);
-                    try
-                    {
-                        fileExists = boost::filesystem::exists(yDirPath);
-                    }
-                    catch (...)
-                    {
-                        // This tells us nothing
-                    }
-                    if (!fileExists)
-                    {
-                        cellsProcessed += (ex-sx+1);
-                        double done = cellsProcessed/((double)totalNumCells);
-                        GDALTermProgress(done,NULL,NULL);
-                        continue;
-                    }
-                    
-                    // Collect up all the filenames for the row, to save us from opening files one by one
-                    bool fileNameCache = false;
-                    std::set<std::string> yFileNames;
-                    try
+                    workers.push_back(std::thread([&]()
                     {
-                        for (boost::filesystem::directory_iterator dirIter = boost::filesystem::directory_iterator(yDir);
-                             dirIter != boost::filesystem::directory_iterator(); ++dirIter)
+                        while (true)
                         {
-                            boost::filesystem::path p = dirIter->path();
-                            std::string ext = p.extension().string();
-                            if (!ext.compare(".shp"))
+                            int iy;
+                            {
+                                std::unique_lock<std::mutex> lock(rowLock);
+                                rowCond.wait(lock,[&]{ return stopWorkers || nextRow - writeRow < 2*numThreads; });
+                                if (stopWorkers || nextRow > ey)
+                                    return;
+                                iy = nextRow++;
+                            }
+                            
+                            EncodedRow *row = new EncodedRow();
+                            EncodeRow(vectorDb, targetDir, webDbDir, webDbName, level, iy, sx, ex, maxLevelSeen, mergeLayers, localLayerNames, layerIDs, *row);
                             {
-                                yFileNames.insert(p.string());
+                                std::lock_guard<std::mutex> guardLock(rowLock);
+                                doneRows[iy] = row;
                             }
+                            rowCond.notify_all();
                         }
-                        fileNameCache = true;
-                    }
-                    catch (...)
-                    {
-                        fileNameCache = false;
-                    }
-
-                    for (unsigned int ix=sx;ix<=ex;ix++)
+                    }));
+                }
+                
+                std::string errorStr;
+                try
+                {
+                    for (int iy=sy;iy<=ey && errorStr.empty();iy++)
                     {
-                        // Set up an in memory data source
-//                        OGRDataSource *memDS = memDriver->CreateDataSource("memory");
-//                        OGRLayer *memLayer = memDS->CreateLayer("layer",hTileSRS);
+                        EncodedRow *row = NULL;
+                        {
+                            std::unique_lock<std::mutex> lock(rowLock);
+                            rowCond.wait(lock,[&]{ return doneRows.find(iy) != doneRows.end(); });
+                            row = doneRows[iy];
+                            doneRows.erase(iy);
+                            writeRow = iy+1;
+                        }
+                        rowCond.notify_all();
                         
-                        // Work through the layers at this level
-                        std::vector<OGRDataSource *> dataSources;
-                        std::vector<OGRFeature *> layerFeatures;
-                        for (unsigned int li=0;li<layerNames.size();li++)
+                        errorStr = row->error;
+                        for (unsigned int ti=0;ti<row->tiles.size() && errorStr.empty();ti++)
                         {
-                            // Load all the data types together into memory at once
-                            std::string layerName = localLayerNames[li];
-                            std::string cellDir = (std::string)targetDir + "/" + std::to_string(level) + "/" + std::to_string(iy) + "/";
-
-                            for (int di=0;di<MapnikConfig::SymbolDataUnknown;di++)
-                            {
-                                const char *typeName = (di == MapnikConfig::SymbolDataPoint ? "_p" : ((di == MapnikConfig::SymbolDataLinear) ? "_l" : ((di == MapnikConfig::SymbolDataAreal) ? "_a" : "_u")));
-                                std::string cellFileName = cellDir + std::to_string(ix) + layerName + typeName + ".shp";
-                                
-                                // Look for the filename in the name cache.  Faster.
-                                if (fileNameCache)
-                                    if (yFileNames.find(cellFileName) == yFileNames.end())
-                                        continue;
-
-                                // Open the shapefile and get pointers to the features
-                                OGRDataSource *poCDS = shpDriver->Open(cellFileName.c_str());
-                                if (poCDS)
-                                {
-                                    OGRLayer *srcLayer = poCDS->GetLayer(0);
-                                    for (unsigned int fi=0;fi<srcLayer->GetFeatureCount();fi++)
-                                        layerFeatures.push_back(srcLayer->GetFeature(fi));
-                                    dataSources.push_back(poCDS);
-                                }
-                            }
-                            
-                            // Write the data out in our custom format
-                            if (!mergeLayers || (li == layerNames.size()-1))
+                            EncodedTile &tile = row->tiles[ti];
+                            vectorDb->addVectorTile(tile.x, iy, level, tile.layerID, (const char *)&tile.data[0], (int)tile.data.size());
+                            if (++tilesInBatch >= batchSize)
                             {
-                                try {
-                                    int layerID = 0;
-                                    std::string outLayerName = "";
-                                    if (!mergeLayers)
-                                    {
-                                        layerID = layerIDs[li];
-                                        outLayerName = layerName;
-                                    } else {
-                                        layerID = layerIDs[0];
-                                        outLayerName = "";
-                                    }
-                                    // Also write it out to the web DB if needed
-                                    std::string cellDir = "";
-                                    std::string cellFileName = "";
-                                    if (webDbDir)
-                                    {
-                                        cellDir = (std::string)webDbDir + "/" + std::to_string(level) + "/" + std::to_string(ix) + "/";
-                                        cellFileName = cellDir + std::to_string(iy) + outLayerName + ".mvt";
-                                    }
-
-                                    if (!layerFeatures.empty())
-                                    {
-                                        std::vector<unsigned char> vecData;
-                                        vectorDb->vectorToDBFormat(layerFeatures, vecData);
-                                        if (!vecData.empty())
-                                        {
-                                            vectorDb->addVectorTile(ix, iy, level, layerID, (const char *)&vecData[0], (int)vecData.size());
-                                            
-                                            if (webDbName)
-                                            {
-                                                void *compressOut;
-                                                int compressSize=0;
-                                                // Need to compress the tiles first
-                                                if (Maply::CompressData((void *)&vecData[0], (int)vecData.size(), &compressOut, compressSize))
-                                                {
-                                                    mkdir(cellDir.c_str(),S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
-                                                    FILE *fp = fopen(cellFileName.c_str(),"w");
-                                                    if (!fp)
-                                                    {
-                                                        fprintf(stderr,"Failed to open file for write: %s\n",cellFileName.c_str());
-                                                        exit(-1);
-                                                    }
-                                                    if (fwrite(compressOut,compressSize,1,fp) != 1)
-                                                    {
-                                                        fprintf(stderr,"Failed to write to file: %s\n",cellFileName.c_str());
-                                                        exit(-1);
-                                                    }
-                                                    fclose(fp);
-                                                } else {
-                                                    fprintf(stderr,"Tile compression failed for %d: (%d,%d)\n",level,ix,iy);
-                                                    exit(-1);
-                                                }
-                                            }
-                                        }
-                                    } else {
-                                        // If it is empty and we're writing a web DB we need to create an empty file
-                                        // This is dumb, yes.
-                                        if (level < maxLevelSeen-1)
-                                        {
-                                            if (webDbName)
-                                            {
-                                                mkdir(cellDir.c_str(),S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
-                                                FILE *fp = fopen(cellFileName.c_str(),"w");
-                                                if (!fp)
-                                                {
-                                                    fprintf(stderr,"Failed to open file for write: %s\n",cellFileName.c_str());
-                                                    exit(-1);
-                                                }
-                                                fclose(fp);
-                                            }
-                                        }
-                                    }
-                                }
-                                catch (std::string &errorStr)
-                                {
-                                    fprintf(stderr,"Unable to write tile %d: (%d,%d)\nBecause: %s\n",level,ix,iy,errorStr.c_str());
-                                    return -1;
-                                }
-                                
-                                // Clean up the layer features
-                                for (unsigned int lf=0;lf<layerFeatures.size();lf++)
-                                    delete layerFeatures[lf];
-                                layerFeatures.clear();
-
-                                // Clean up the data sources
-                                for (unsigned int si=0;si<dataSources.size();si++)
-                                    OGRDataSource::DestroyDataSource(dataSources[si]);
-                                dataSources.clear();
+                                Kompex::SQLiteStatement transactStmt(sqliteDb);
+                                transactStmt.SqlStatement((std::string)"END TRANSACTION");
+                                transactStmt.SqlStatement((std::string)"BEGIN TRANSACTION");
+                                tilesInBatch = 0;
                             }
                         }
-                        
-                        cellsProcessed++;
+                        delete row;
+
+                        cellsProcessed += (ex-sx+1);
                         double done = cellsProcessed/((double)totalNumCells);
                         GDALTermProgress(done,NULL,NULL);
                     }
                 }
+                catch (const std::string &what)
+                {
+                    errorStr = what;
+                }
+                catch (Kompex::SQLiteException &exc)
+                {
+                    errorStr = (std::string)"Failed to write to database:\n" + exc.GetString();
+                }
+                
+                // Wait for the workers to wind down before we go on, or give up
+                {
+                    std::lock_guard<std::mutex> guardLock(rowLock);
+                    stopWorkers = true;
+                }
+                rowCond.notify_all();
+                for (unsigned int ti=0;ti<workers.size();ti++)
+                    workers[ti].join();
+                for (std::map<int,EncodedRow *>::iterator it = doneRows.begin(); it != doneRows.end(); ++it)
+                    delete it->second;
+                
+                if (!errorStr.empty())
+                {
+                    fprintf(stderr,"%s\n",errorStr.c_str());
+                    return -1;
+                }
             }
         }
         catch (const std::string &what)
@@ -1509,7 +1844,7 @@ int main(int argc, char * argv[])
             return -1;
         }
         
-        // End the big transaction
+        // End the last batch
         {
             Kompex::SQLiteStatement transactStmt(sqliteDb);
             transactStmt.SqlStatement((std::string)"END TRANSACTION");
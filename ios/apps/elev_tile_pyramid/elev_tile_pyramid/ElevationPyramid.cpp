@@ -11,9 +11,9 @@
 
 using namespace Kompex;
 
-ElevationPyramid::ElevationPyramid(Kompex::SQLiteDatabase *db,const char *srs,GDALDataType dataType,double minX,double minY,double maxX,double maxY,unsigned int tileSizeX,unsigned int tileSizeY,bool compress,int minLevel,int maxLevel)
+ElevationPyramid::ElevationPyramid(Kompex::SQLiteDatabase *db,const char *srs,GDALDataType dataType,const char *format,double minX,double minY,double maxX,double maxY,unsigned int tileSizeX,unsigned int tileSizeY,bool compress,int minLevel,int maxLevel)
 : db(db), dataType(dataType), compress(compress), tileSizeX(tileSizeX), tileSizeY(tileSizeY), insertStmt(NULL),
-    minLevel(minLevel), maxLevel(maxLevel), minx(minX), miny(minY), maxx(maxX), maxy(maxY), srs(srs)
+    minLevel(minLevel), maxLevel(maxLevel), minx(minX), miny(minY), maxx(maxX), maxy(maxY), srs(srs), format(format)
 {
     SQLiteStatement stmt(db);
     
@@ -29,7 +29,7 @@ ElevationPyramid::ElevationPyramid(Kompex::SQLiteDatabase *db,const char *srs,GD
         stmt.SqlStatement((std::string)"ALTER TABLE manifest ADD srs TEXT DEFAULT '' NOT NULL;");
         
         char stmtStr[1024];
-        sprintf(stmtStr,"INSERT INTO manifest (minx,miny,maxx,maxy,tilesizex,tilesizey,compressed,format,minlevel,maxlevel,srs) VALUES (%f,%f,%f,%f,%d,%d,%d,'%s',%d,%d,'%s');",minX,minY,maxX,maxY,tileSizeX,tileSizeY,1,"int16",minLevel,maxLevel,(srs ? srs : ""));
+        sprintf(stmtStr,"INSERT INTO manifest (minx,miny,maxx,maxy,tilesizex,tilesizey,compressed,format,minlevel,maxlevel,srs) VALUES (%f,%f,%f,%f,%d,%d,%d,'%s',%d,%d,'%s');",minX,minY,maxX,maxY,tileSizeX,tileSizeY,(int)compress,format,minLevel,maxLevel,(srs ? srs : ""));
         stmt.SqlStatement(stmtStr);
         
         stmt.SqlStatement("CREATE TABLE elevationtiles (data BLOB,level INTEGER,x INTEGER,y INTEGER,quadindex INTEGER PRIMARY KEY);");
@@ -42,7 +42,7 @@ ElevationPyramid::ElevationPyramid(Kompex::SQLiteDatabase *db,const char *srs,GD
 }
 
 ElevationPyramid::ElevationPyramid(Kompex::SQLiteDatabase *db,int newMaxLevel)
-: db(db)
+: db(db), insertStmt(NULL)
 {
     SQLiteStatement stmt(db);
     
@@ -58,8 +58,9 @@ ElevationPyramid::ElevationPyramid(Kompex::SQLiteDatabase *db,int newMaxLevel)
             tileSizeY = stmt.GetColumnInt("tilesizey");
             compress = stmt.GetColumnInt("compressed");
             minLevel = stmt.GetColumnInt("minlevel");
-            maxLevel = stmt.GetColumnInt("minlevel");
+            maxLevel = stmt.GetColumnInt("maxlevel");
             srs = stmt.GetColumnString("srs");
+            format = stmt.GetColumnString("format");
         } else
             valid = false;
         
@@ -124,6 +125,31 @@ bool CompressData(void *data,int dataLen,void **retData,int &retDataLen)
 }
 
 bool ElevationPyramid::addElevationTile(void *tileData,int x,int y,int level)
+{
+    // No data, so leave the blob empty.  This means the tile is all at zero.
+    if (!tileData)
+        return insertTile(NULL, 0, x, y, level);
+
+    unsigned int dataSize = sizeof(unsigned short)*tileSizeX*tileSizeY;
+    if (!compress)
+        return insertTile(tileData, dataSize, x, y, level);
+
+    void *compressOut = NULL;
+    int compressSize=0;
+    if (!CompressData((void *)tileData, dataSize, &compressOut, compressSize))
+        return false;
+    bool ret = insertTile(compressOut, compressSize, x, y, level);
+    free(compressOut);
+    
+    return ret;
+}
+
+bool ElevationPyramid::addEncodedTile(const void *data,int dataLen,int x,int y,int level)
+{
+    return insertTile(data, dataLen, x, y, level);
+}
+
+bool ElevationPyramid::insertTile(const void *data,int dataLen,int x,int y,int level)
 {
     // Calculate a quad index for later use
     int quadIndex = 0;
@@ -137,57 +163,22 @@ bool ElevationPyramid::addElevationTile(void *tileData,int x,int y,int level)
         insertStmt->Sql("INSERT INTO elevationtiles (data,level,x,y,quadindex) VALUES (@data,@level,@x,@y,@quadinex);");
     }
     
-    // Here we've got data to insert
-    if (tileData)
+    // Now insert the samples into the database as a blob
+    try {
+        insertStmt->BindBlob(1, data, dataLen);
+        insertStmt->BindInt(2, level);
+        insertStmt->BindInt(3, x);
+        insertStmt->BindInt(4, y);
+        insertStmt->BindInt(5, quadIndex);
+        insertStmt->Execute();
+        insertStmt->Reset();
+    }
+    catch (SQLiteException &except)
     {
-        unsigned int dataSize = sizeof(unsigned short)*tileSizeX*tileSizeY;
-        
-        if (compress)
-        {
-            void *compressOut;
-            int compressSize=0;
-            if (CompressData((void *)tileData, dataSize, &compressOut, compressSize))
-            {
-                // Now insert the samples into the database as a blob
-                try {
-                    insertStmt->BindBlob(1, compressOut, compressSize);
-                    insertStmt->BindInt(2, level);
-                    insertStmt->BindInt(3, x);
-                    insertStmt->BindInt(4, y);
-                    insertStmt->BindInt(5, quadIndex);
-                    insertStmt->Execute();
-                    insertStmt->Reset();
-                }
-                catch (SQLiteException &except)
-                {
-                    fprintf(stderr,"Failed to write blob to database:\n%s\n",except.GetString().c_str());
-                    return false;
-                }            
-            } else
-                return false;
-        }
-    } else {
-        // No data, so leave the blob empty.  This means the tile is all at zero.
-        try {
-            insertStmt->BindBlob(1, NULL, 0);
-            insertStmt->BindInt(2, level);
-            insertStmt->BindInt(3, x);
-            insertStmt->BindInt(4, y);
-            insertStmt->BindInt(5, quadIndex);
-            insertStmt->Execute();
-            insertStmt->Reset();
-        }
-        catch (SQLiteException &except)
-        {
-            fprintf(stderr,"Failed to write blob to database:\n%s\n",except.GetString().c_str());
-            return false;
-        }
+        fprintf(stderr,"Failed to write blob to database:\n%s\n",except.GetString().c_str());
+        return false;
     }
     
-//    if (insertStmt)
-//        delete insertStmt;
-//    insertStmt = NULL;
-    
     return true;
 }
 
@@ -24,14 +24,17 @@
 class ElevationPyramid
 {
 public:
-    // Construct a brand new database
-    ElevationPyramid(Kompex::SQLiteDatabase *db,const char *srs,GDALDataType dataType,double minX,double minY,double maxX,double maxY,unsigned int tileSizeX,unsigned int tileSizeY,bool compress,int minLevel,int maxLevel);
+    // Construct a brand new database.  The format is int16 for raw samples, or the name of an image encoding.
+    ElevationPyramid(Kompex::SQLiteDatabase *db,const char *srs,GDALDataType dataType,const char *format,double minX,double minY,double maxX,double maxY,unsigned int tileSizeX,unsigned int tileSizeY,bool compress,int minLevel,int maxLevel);
     // Construct from a database and update a bit of info
     ElevationPyramid(Kompex::SQLiteDatabase *db,int maxLevel);
     
     // Load the elevaiton tile and add it to the sqlite db
     bool addElevationTile(void *tileData,int x,int y,int level);
     
+    // Add a tile that's already been encoded (e.g. as a PNG).  It goes in as is.
+    bool addEncodedTile(const void *data,int dataLen,int x,int y,int level);
+    
     // Create the quadIndex index
     void createIndex();
     
@@ -50,12 +53,19 @@ public:
     // Return the spatial reference system (e.g. coordinate system)
     const std::string &getSrs() { return srs; }
     
+    // How the tiles are stored
+    const std::string &getFormat() { return format; }
+    
     // Check this after opening
     bool isValid() { return valid; }
     
 protected:
+    // Write the blob for a tile, which may be empty
+    bool insertTile(const void *data,int dataLen,int x,int y,int level);
+    
     Kompex::SQLiteDatabase *db;
     std::string srs;
+    std::string format;
     double minx,miny,maxx,maxy;
     int minLevel,maxLevel;
     unsigned int tileSizeX,tileSizeY;
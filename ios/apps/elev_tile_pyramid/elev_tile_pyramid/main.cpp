@@ -17,8 +17,14 @@
 #include "cpl_string.h"
 #include "ogr_spatialref.h"
 #include "cpl_minixml.h"
+#include "cpl_vsi.h"
 #include <dirent.h>
 #include <vector>
+#include <map>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "KompexSQLitePrerequisites.h"
 #include "KompexSQLiteDatabase.h"
 #include "KompexSQLiteStatement.h"
@@ -133,8 +139,9 @@ float searchForMaxPixel(GDALRasterBandH hBand, int sx, int sy, int ex, int ey)
         int numRows = maxRows;
         if (ey-iy<=numRows)
             numRows = ey-iy+1;
-        float pixels[rowSize*numRows];
-        if (GDALRasterIO( hBand, GF_Read, sx, iy, rowSize, numRows, pixels, rowSize, numRows, GDT_Float32, 0,  0) != CE_None)
+        // Too big for the stack of a worker thread
+        std::vector<float> pixels(rowSize*numRows);
+        if (GDALRasterIO( hBand, GF_Read, sx, iy, rowSize, numRows, &pixels[0], rowSize, numRows, GDT_Float32, 0,  0) != CE_None)
         {
             fprintf(stderr,"Query failure in GDALRasterIO");
             return -1;
@@ -149,6 +156,289 @@ float searchForMaxPixel(GDALRasterBandH hBand, int sx, int sy, int ex, int ey)
 
 typedef enum {SampleSingle,SampleMax} SamplingType;
 
+// Raw int16 samples, or elevation packed into the RGB of a PNG
+typedef enum {EncodeInt16,EncodeTerrarium,EncodeMapboxRGB} ElevEncoding;
+
+// Name of the encoding, as we record it in the database
+const char *EncodingName(ElevEncoding encoding)
+{
+    switch (encoding)
+    {
+        case EncodeTerrarium:
+            return "terrarium";
+        case EncodeMapboxRGB:
+            return "mapboxrgb";
+        default:
+            return "int16";
+    }
+}
+
+bool EncodingFromName(const char *name,ElevEncoding &encoding)
+{
+    if (EQUAL(name,"int16"))
+        encoding = EncodeInt16;
+    else if (EQUAL(name,"terrarium"))
+        encoding = EncodeTerrarium;
+    else if (EQUAL(name,"mapboxrgb") || EQUAL(name,"mapbox"))
+        encoding = EncodeMapboxRGB;
+    else
+        return false;
+    
+    return true;
+}
+
+// Pack the elevations into RGB and write a PNG into memory.
+// Our rows run from the bottom; the image goes north up, the way the tile sources have it.
+bool EncodeRGBTile(const float *tileData,int pixelsX,int pixelsY,ElevEncoding encoding,std::vector<unsigned char> &pngData)
+{
+    std::vector<unsigned char> rgb(3*pixelsX*pixelsY);
+    for (int cy=0;cy<pixelsY;cy++)
+        for (int cx=0;cx<pixelsX;cx++)
+        {
+            double elev = tileData[cy*pixelsX+cx];
+            unsigned char *pix = &rgb[3*((pixelsY-1-cy)*pixelsX+cx)];
+            if (encoding == EncodeTerrarium)
+            {
+                // elev = (R * 256 + G + B / 256) - 32768
+                double val = MIN(MAX(elev + 32768.0,0.0),65535.99);
+                int whole = (int)floor(val);
+                pix[0] = whole / 256;
+                pix[1] = whole % 256;
+                pix[2] = (int)floor((val - whole) * 256.0);
+            } else {
+                // elev = -10000 + ((R * 256 * 256 + G * 256 + B) * 0.1)
+                int val = (int)floor((elev + 10000.0) * 10.0 + 0.5);
+                val = MIN(MAX(val,0),(1<<24)-1);
+                pix[0] = (val >> 16) & 0xff;
+                pix[1] = (val >> 8) & 0xff;
+                pix[2] = val & 0xff;
+            }
+        }
+    
+    // The PNG driver can only copy, so go through a memory data set
+    GDALDriverH memDriver = GDALGetDriverByName("MEM");
+    GDALDriverH pngDriver = GDALGetDriverByName("PNG");
+    if (!memDriver || !pngDriver)
+    {
+        fprintf(stderr,"Need the MEM and PNG drivers for RGB output.");
+        return false;
+    }
+    GDALDatasetH memDS = GDALCreate(memDriver, "", pixelsX, pixelsY, 3, GDT_Byte, NULL);
+    if (!memDS)
+        return false;
+    if (GDALDatasetRasterIO(memDS, GF_Write, 0, 0, pixelsX, pixelsY, &rgb[0], pixelsX, pixelsY, GDT_Byte, 3, NULL, 3, 3*pixelsX, 1) != CE_None)
+    {
+        GDALClose(memDS);
+        return false;
+    }
+    
+    static std::atomic<int> whichFile(0);
+    std::stringstream fileName;
+    fileName << "/vsimem/elev_tile_" << whichFile++ << ".png";
+    GDALDatasetH pngDS = GDALCreateCopy(pngDriver, fileName.str().c_str(), memDS, FALSE, NULL, NULL, NULL);
+    GDALClose(memDS);
+    if (!pngDS)
+        return false;
+    GDALClose(pngDS);
+    
+    vsi_l_offset dataLen = 0;
+    GByte *data = VSIGetMemFileBuffer(fileName.str().c_str(), &dataLen, TRUE);
+    if (!data)
+        return false;
+    pngData.assign(data, data+dataLen);
+    CPLFree(data);
+    VSIUnlink(fileName.str().c_str());
+    
+    return true;
+}
+
+// Samples one tile at a time from the input.
+// GDAL data sets and coordinate transforms can't be shared between threads, so each worker gets its own.
+class TileSampler
+{
+public:
+    TileSampler() : hSrcDS(NULL), hBand(NULL), hCTBack(NULL), rasterXSize(0), rasterYSize(0) { }
+    ~TileSampler()
+    {
+        if (hCTBack)
+            OCTDestroyCoordinateTransformation(hCTBack);
+        if (hSrcDS)
+            GDALClose(hSrcDS);
+    }
+    
+    // Open our own copy of the input.  Pass in the SRSes to reproject.
+    bool init(const char *inputFile,OGRSpatialReference *hSrcSRS,OGRSpatialReference *hTrgSRS)
+    {
+        hSrcDS = GDALOpen( inputFile, GA_ReadOnly );
+        if (!hSrcDS)
+            return false;
+        hBand = GDALGetRasterBand( hSrcDS, 1);
+        double adfGeoTransform[6];
+        if (!hBand || GDALGetGeoTransform( hSrcDS, adfGeoTransform) != CE_None)
+            return false;
+        GDALInvGeoTransform( adfGeoTransform, adfInvGeoTransform );
+        rasterXSize = GDALGetRasterXSize(hSrcDS);
+        rasterYSize = GDALGetRasterYSize(hSrcDS);
+        if (hSrcSRS && hTrgSRS)
+        {
+            hCTBack = OCTNewCoordinateTransformation(hTrgSRS,hSrcSRS);
+            if (!hCTBack)
+                return false;
+        }
+        
+        return true;
+    }
+    
+    // Fill in pixelsX by pixelsY samples, starting from the lower left
+    bool sampleTile(SamplingType samplingType,double tileMinX,double tileMinY,double cellX,double cellY,int pixelsX,int pixelsY,float *tileData)
+    {
+        if (samplingType == SampleSingle)
+            return sampleSingle(tileMinX, tileMinY, cellX, cellY, pixelsX, pixelsY, tileData);
+        
+        for (unsigned int cy=0;cy<pixelsY;cy++)
+            for (unsigned int cx=0;cx<pixelsX;cx++)
+            {
+                double thisX = tileMinX + cellX*cx;
+                double thisY = tileMinY + cellY*cy;
+
+                // Make a bounding box and project it into the source data
+                double pixX[4],pixY[4];
+                double srcX[4],srcY[4];
+                srcX[0] = thisX-cellX/2.0;  srcY[0] = thisY-cellY/2.0;
+                srcX[1] = thisX+cellX/2.0;  srcY[1] = thisY-cellY/2.0;
+                srcX[2] = thisX+cellX/2.0;  srcY[2] = thisY+cellY/2.0;
+                srcX[3] = thisX-cellX/2.0;  srcY[3] = thisY+cellY/2.0;
+                
+                // Convert the rectangle points individually, if needed
+                if (hCTBack)
+                    for (unsigned int pi=0;pi<4;pi++)
+                        OCTTransform(hCTBack, 1, &srcX[pi], &srcY[pi], NULL);
+
+                int sx=1000000,sy=1000000,ex=-1000000,ey=-1000000;
+                for (unsigned int pi=0;pi<4;pi++)
+                {
+                    pixX[pi] = adfInvGeoTransform[0] + adfInvGeoTransform[1] * srcX[pi] + adfInvGeoTransform[2] * srcY[pi];
+                    pixY[pi] = adfInvGeoTransform[3] + adfInvGeoTransform[4] * srcX[pi] + adfInvGeoTransform[5] * srcY[pi];
+                    sx = MIN(sx,floor(pixX[pi]));
+                    sy = MIN(sy,floor(pixY[pi]));
+                    ex = MAX(ex,ceil(pixX[pi]));
+                    ey = MAX(ey,ceil(pixY[pi]));
+                }
+                sx = clampX(sx);
+                sy = clampY(sy);
+                ex = clampX(ex);
+                ey = clampY(ey);
+                
+                // Search for the maximum pixel in the area
+                tileData[cy*pixelsX+cx] = searchForMaxPixel(hBand, sx, sy, ex, ey);
+            }
+        
+        return true;
+    }
+    
+protected:
+    int clampX(int pixX) { return MIN(MAX(pixX,0),rasterXSize-1); }
+    int clampY(int pixY) { return MIN(MAX(pixY,0),rasterYSize-1); }
+    
+    // Bilinear interpolation of the four nearest pixels.
+    // We read the whole window under the tile at once, rather than a pixel at a time,
+    //  which keeps GDAL's block cache in charge of how much of the input is in memory.
+    bool sampleSingle(double tileMinX,double tileMinY,double cellX,double cellY,int pixelsX,int pixelsY,float *tileData)
+    {
+        int numSamples = pixelsX*pixelsY;
+        lookups.resize(4*numSamples);
+        fracs.resize(2*numSamples);
+        int sx = rasterXSize, sy = rasterYSize, ex = -1, ey = -1;
+        for (unsigned int cy=0;cy<pixelsY;cy++)
+            for (unsigned int cx=0;cx<pixelsX;cx++)
+            {
+                double thisX = tileMinX + cellX*cx;
+                double thisY = tileMinY + cellY*cy;
+                
+                // Project back to the original data file
+                if (hCTBack)
+                    OCTTransform(hCTBack, 1, &thisX, &thisY, NULL);
+                
+                // Figure out which pixel this is
+                double pixX = adfInvGeoTransform[0] + adfInvGeoTransform[1] * thisX + adfInvGeoTransform[2] * thisY;
+                double pixY = adfInvGeoTransform[3] + adfInvGeoTransform[4] * thisX + adfInvGeoTransform[5] * thisY;
+                int pixXint = (int)pixX,pixYint = (int)pixY;
+                
+                int which = cy*pixelsX+cx;
+                fracs[2*which] = pixX-pixXint;
+                fracs[2*which+1] = pixY-pixYint;
+                int *look = &lookups[4*which];
+                look[0] = clampX(pixXint);  look[1] = clampX(pixXint+1);
+                look[2] = clampY(pixYint);  look[3] = clampY(pixYint+1);
+                sx = MIN(sx,look[0]);  ex = MAX(ex,look[1]);
+                sy = MIN(sy,look[2]);  ey = MAX(ey,look[3]);
+            }
+        
+        // A tile reprojected across a lot of the input can end up with a huge window.
+        // Fall back to fetching individual pixels for that.
+        int winX = ex-sx+1, winY = ey-sy+1;
+        bool useWindow = (double)winX * winY <= MaxPixelLoad;
+        if (useWindow)
+        {
+            window.resize(winX*winY);
+            if (GDALRasterIO( hBand, GF_Read, sx, sy, winX, winY, &window[0], winX, winY, GDT_Float32, 0,  0) != CE_None)
+            {
+                fprintf(stderr,"Query failure in GDALRasterIO");
+                return false;
+            }
+        }
+        
+        for (int which=0;which<numSamples;which++)
+        {
+            const int *look = &lookups[4*which];
+            int pixXlookup[4] = {look[0],look[1],look[1],look[0]};
+            int pixYlookup[4] = {look[2],look[2],look[3],look[3]};
+            float pixVals[4];
+            for (unsigned int pi=0;pi<4;pi++)
+            {
+                if (useWindow)
+                    pixVals[pi] = window[(pixYlookup[pi]-sy)*winX + pixXlookup[pi]-sx];
+                else if (GDALRasterIO( hBand, GF_Read, pixXlookup[pi], pixYlookup[pi], 1, 1, &pixVals[pi], 1, 1, GDT_Float32, 0,  0) != CE_None)
+                {
+                    fprintf(stderr,"Query failure in GDALRasterIO");
+                    return false;
+                }
+            }
+            
+            // Now do a bilinear interpolation
+            double ta = fracs[2*which], tb = fracs[2*which+1];
+            float pixA = (pixVals[1]-pixVals[0])*ta + pixVals[0];
+            float pixB = (pixVals[2]-pixVals[3])*ta + pixVals[3];
+            tileData[which] = (pixB-pixA)*tb+pixA;
+        }
+        
+        return true;
+    }
+    
+    GDALDatasetH hSrcDS;
+    GDALRasterBandH hBand;
+    OGRCoordinateTransformationH hCTBack;
+    double adfInvGeoTransform[6];
+    int rasterXSize,rasterYSize;
+    std::vector<int> lookups;
+    std::vector<double> fracs;
+    std::vector<float> window;
+};
+
+// A tile as it comes back from a worker, waiting to be written in order
+class TileResult
+{
+public:
+    TileResult() : ix(0), iy(0), skipped(false), failed(false), nonZero(false) { }
+    
+    int ix,iy;
+    double tileMinX,tileMinY,tileMaxX,tileMaxY;
+    bool skipped,failed,nonZero;
+    std::vector<float> tileData;
+    // For the RGB encodings
+    std::vector<unsigned char> encoded;
+};
+
 int main(int argc, char * argv[])
 {
     const char *inputFile = NULL;
@@ -166,6 +456,11 @@ int main(int argc, char * argv[])
     double updateMinX = 0.0,updateMaxX = 0.0,updateMinY = 0.0,updateMaxY = 0.0;
     const char *updateShapeFile = NULL,*outShapeFile=NULL;
     SamplingType samplingtype = SampleSingle;
+    ElevEncoding encoding = EncodeInt16;
+    bool encodingSet = false;
+    int numThreads = std::thread::hardware_concurrency();
+    int batchSize = 1000;
+    GIntBig cacheMax = 2048;
 
     GDALAllRegister();
     OGRRegisterAll();
@@ -307,6 +602,47 @@ int main(int argc, char * argv[])
                 fprintf(stderr,"Expecting single or max for sampling type.");
                 return -1;
             }
+        } else if (EQUAL(argv[ii],"-encoding"))
+        {
+            numArgs = 2;
+            if (ii+numArgs > argc)
+            {
+                fprintf(stderr,"Expecting type for -encoding");
+                return -1;
+            }
+            if (!EncodingFromName(argv[ii+1], encoding))
+            {
+                fprintf(stderr,"Expecting int16, terrarium or mapboxrgb for encoding.");
+                return -1;
+            }
+            encodingSet = true;
+        } else if (EQUAL(argv[ii],"-threads"))
+        {
+            numArgs = 2;
+            if (ii+numArgs > argc)
+            {
+                fprintf(stderr,"Expecting number of threads for -threads");
+                return -1;
+            }
+            numThreads = atoi(argv[ii+1]);
+        } else if (EQUAL(argv[ii],"-batchsize"))
+        {
+            numArgs = 2;
+            if (ii+numArgs > argc)
+            {
+                fprintf(stderr,"Expecting number of tiles for -batchsize");
+                return -1;
+            }
+            batchSize = atoi(argv[ii+1]);
+        } else if (EQUAL(argv[ii],"-cachemax"))
+        {
+            numArgs = 2;
+            if (ii+numArgs > argc)
+            {
+                fprintf(stderr,"Expecting size in megabytes for -cachemax");
+                return -1;
+            }
+            cacheMax = atoi(argv[ii+1]);
         } else
         {
             if (inputFile)
@@ -374,14 +710,27 @@ int main(int argc, char * argv[])
         elevPyr->getExtents(xmin,ymin,xmax,ymax);
         destSRS = SanitizeSRS(elevPyr->getSrs().c_str());
         elevPyr->getTileSize(pixelsX,pixelsY);
+        
+        // Have to match what's already in there
+        ElevEncoding dbEncoding;
+        if (!EncodingFromName(elevPyr->getFormat().c_str(), dbEncoding) ||
+            (encodingSet && dbEncoding != encoding))
+        {
+            fprintf(stderr, "Database has %s tiles, which we can't update with %s.",elevPyr->getFormat().c_str(),EncodingName(encoding));
+            return -1;
+        }
+        encoding = dbEncoding;
     }
+    numThreads = MAX(numThreads,1);
+    batchSize = MAX(batchSize,1);
 
     // Open the input file
     GDALDatasetH hSrcDS = NULL;
     hSrcDS = GDALOpen( inputFile, GA_ReadOnly );
     if( hSrcDS == NULL )
         return -1;
-    GDALSetCacheMax64(2*1024*1024*1024);
+    // Workers read the input through GDAL's block cache, so this is all of it we'll hold on to
+    GDALSetCacheMax64(cacheMax*1024*1024);
 
     // Set up a coordinate transformation
     OGRCoordinateTransformationH hCT = NULL,hCTBack = NULL;
@@ -584,7 +933,8 @@ int main(int argc, char * argv[])
             fprintf(stderr, "Invalid sqlite database: %s\n",targetDb);
             return -1;
         }
-        elevPyr = new ElevationPyramid(sqliteDb,destSRS,GDT_Int16,xmin,ymin,xmax,ymax,pixelsX,pixelsY,true,0,levels-1);
+        // PNGs are already compressed
+        elevPyr = new ElevationPyramid(sqliteDb,destSRS,GDT_Int16,EncodingName(encoding),xmin,ymin,xmax,ymax,pixelsX,pixelsY,encoding == EncodeInt16,0,levels-1);
         if (!elevPyr->isValid())
             return -1;
     }
@@ -593,7 +943,18 @@ int main(int argc, char * argv[])
     char *trgSrsWKT = NULL;
     OSRExportToWkt( hTrgSRS, &trgSrsWKT );
 
-    if (targetDb)
+    // Each worker samples with its own copy of the input
+    std::vector<TileSampler> samplers(numThreads);
+    for (unsigned int si=0;si<samplers.size();si++)
+        if (!samplers[si].init(inputFile, (hCT ? hSrcSRS : NULL), (hCT ? hTrgSRS : NULL)))
+        {
+            fprintf(stderr, "Failed to open input for worker %d.",si);
+            return -1;
+        }
+
+    // We write in batches, so one big run doesn't pile up in a single transaction
+    int tilesInBatch = 0;
+    if (sqliteDb)
     {
         Kompex::SQLiteStatement transactStmt(sqliteDb);
         transactStmt.SqlStatement((std::string)"BEGIN TRANSACTION");
@@ -609,7 +970,8 @@ int main(int argc, char * argv[])
 
     // Work through the levels of detail, starting from the top
     int totalTiles = 0,zeroTiles = 0, skippedTiles = 0;
-    for (int level=max_level;level>=min_level;level--)
+    std::atomic<bool> failed(false);
+    for (int level=max_level;level>=min_level && !failed;level--)
     {
         printf("Level %d: ",level);
         fflush(stdout);
@@ -637,278 +999,270 @@ int main(int argc, char * argv[])
             max_ix = ceil((updateMaxX-xmin)/sizeX);
             max_iy = ceil((updateMaxY-ymin)/sizeY);
         }
-        int numTilesToDo = (max_ix-min_ix+1)*(max_iy-min_iy+1);
-        int chunksProcessed = 0;
+        int numTilesY = max_iy-min_iy+1;
+        int numTilesToDo = (max_ix-min_ix+1)*numTilesY;
 
-        // Now through the individual files
-        for (unsigned int ix=min_ix;ix<=max_ix;ix++)
-        {
-            std::stringstream xDir;
-            if (targetDir)
-            {
-                xDir << levelDir.str() << "/" << ix;
-                mkdir(xDir.str().c_str(),S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
-            }
-            
-            for (unsigned int iy=min_iy;iy<=max_iy;iy++)
+        // Workers take tiles in order and hand them back to be written in that order.
+        // They only get so far ahead of the writer, which keeps the finished tiles we hold on to down.
+        std::atomic<int> nextTile(0);
+        std::mutex resultLock;
+        std::condition_variable resultCond;
+        std::map<int,TileResult> results;
+        int nextToWrite = 0;
+        const int maxAhead = 2*numThreads;
+        
+        std::vector<std::thread> workers;
+        for (unsigned int ti=0;ti<numThreads;ti++)
+            workers.push_back(std::thread([&,ti]()
             {
-                // Extents for this particular tile
-                double tileMinX = xmin+ix*sizeX;
-                double tileMinY = ymin+iy*sizeY;
-                double tileMaxX = tileMinX + pixelsX * cellX;
-                double tileMaxY = tileMinY + pixelsY * cellY;
-               
-                // Let's check this against the inclusion polygons if we have them
-                bool includeTile = true;
-                if (!includeBounds.empty())
+                TileSampler &sampler = samplers[ti];
+                while (true)
                 {
-                    includeTile = false;
-                    OGREnvelope box;
-                    box.MinX = tileMinX;
-                    box.MinY = tileMinY;
-                    box.MaxX = tileMaxX;
-                    box.MaxY = tileMaxY;
-                    for (unsigned si=0;si<includeBounds.size();si++)
                     {
-                        OGREnvelope &env = includeBounds[si];
-                        if (env.Contains(box) || env.Intersects(box) || box.Contains(env))
+                        std::unique_lock<std::mutex> lock(resultLock);
+                        resultCond.wait(lock,[&]{ return failed || nextTile < nextToWrite + maxAhead; });
+                        if (failed)
+                            return;
+                    }
+                    int which = nextTile++;
+                    if (which >= numTilesToDo)
+                        return;
+                    
+                    TileResult result;
+                    result.ix = min_ix + which / numTilesY;
+                    result.iy = min_iy + which % numTilesY;
+                    
+                    // Extents for this particular tile
+                    result.tileMinX = xmin+result.ix*sizeX;
+                    result.tileMinY = ymin+result.iy*sizeY;
+                    result.tileMaxX = result.tileMinX + pixelsX * cellX;
+                    result.tileMaxY = result.tileMinY + pixelsY * cellY;
+                    
+                    // Let's check this against the inclusion polygons if we have them
+                    bool includeTile = true;
+                    if (!includeBounds.empty())
+                    {
+                        includeTile = false;
+                        OGREnvelope box;
+                        box.MinX = result.tileMinX;
+                        box.MinY = result.tileMinY;
+                        box.MaxX = result.tileMaxX;
+                        box.MaxY = result.tileMaxY;
+                        for (unsigned si=0;si<includeBounds.size();si++)
                         {
-                            includeTile = true;
-                            break;
+                            OGREnvelope &env = includeBounds[si];
+                            if (env.Contains(box) || env.Intersects(box) || box.Contains(env))
+                            {
+                                includeTile = true;
+                                break;
+                            }
                         }
                     }
+                    
+                    if (!includeTile)
+                        result.skipped = true;
+                    else {
+                        result.tileData.resize(pixelsX*pixelsY);
+                        if (!sampler.sampleTile(samplingtype, result.tileMinX, result.tileMinY, cellX, cellY, pixelsX, pixelsY, &result.tileData[0]))
+                            result.failed = true;
+                        
+                        // See if anything of is non-zero
+                        for (unsigned int ip=0;ip<pixelsX*pixelsY && !result.failed;ip++)
+                            if (result.tileData[ip] != 0)
+                            {
+                                result.nonZero = true;
+                                break;
+                            }
+
+                        // Encoding is the expensive part of writing, so do it here
+                        if (!result.failed && encoding != EncodeInt16 && (targetDir || (elevPyr && result.nonZero)))
+                            if (!EncodeRGBTile(&result.tileData[0], pixelsX, pixelsY, encoding, result.encoded))
+                                result.failed = true;
+                    }
+                    
+                    {
+                        std::lock_guard<std::mutex> lock(resultLock);
+                        results[which] = std::move(result);
+                    }
+                    resultCond.notify_all();
                 }
-                
-                if (includeTile)
+            }));
+        
+        // Write the tiles out in order as they come in
+        int lastIx = -1;
+        std::stringstream xDir;
+        for (int which=0;which<numTilesToDo && !failed;which++)
+        {
+            TileResult result;
+            {
+                std::unique_lock<std::mutex> lock(resultLock);
+                resultCond.wait(lock,[&]{ return results.find(which) != results.end(); });
+                result = std::move(results[which]);
+                results.erase(which);
+                nextToWrite = which+1;
+            }
+            resultCond.notify_all();
+            
+            int ix = result.ix, iy = result.iy;
+            const std::vector<float> &tileData = result.tileData;
+            if (result.failed)
+            {
+                fprintf(stderr, "Failed to sample tile %d: %d, %d",level,ix,iy);
+                failed = true;
+            } else if (result.skipped)
+                skippedTiles++;
+            else {
+                // Output directory
+                if (targetDir)
                 {
-                    GDALDatasetH hDestDS = NULL;
-                    GDALRasterBandH hBandOut = NULL;
-                    if (targetDir)
+                    if (ix != lastIx)
                     {
-                        std::stringstream fileName;
-                        int outY = (flipY ? (numChunks-1-iy) : iy);
-                        fileName << xDir.str() << "/" << outY << ".tif";
+                        xDir.str("");
+                        xDir << levelDir.str() << "/" << ix;
+                        mkdir(xDir.str().c_str(),S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+                        lastIx = ix;
+                    }
+                    std::stringstream fileName;
+                    int outY = (flipY ? (numChunks-1-iy) : iy);
+                    fileName << xDir.str() << "/" << outY << (encoding == EncodeInt16 ? ".tif" : ".png");
                     
+                    if (encoding != EncodeInt16)
+                    {
+                        FILE *fp = fopen(fileName.str().c_str(),"wb");
+                        if (!fp || fwrite(&result.encoded[0], 1, result.encoded.size(), fp) != result.encoded.size())
+                        {
+                            fprintf(stderr,"Failed to write output data");
+                            failed = true;
+                        }
+                        if (fp)
+                            fclose(fp);
+                    } else {
                         // Create the output file
-                        hDestDS = CreateOutputDataFile(outFileFormat,fileName.str().c_str(),pixelsX,pixelsY,outFormat);
-                        if (!hDestDS)
-                            return -1;
-                        hBandOut = GDALGetRasterBand(hDestDS, 1);
+                        GDALDatasetH hDestDS = CreateOutputDataFile(outFileFormat,fileName.str().c_str(),pixelsX,pixelsY,outFormat);
+                        GDALRasterBandH hBandOut = hDestDS ? GDALGetRasterBand(hDestDS, 1) : NULL;
                         if (!hBandOut)
                         {
                             fprintf(stderr,"Failed to create output band.");
-                            return -1;
-                        }
-                    }
-                    
-                    float tileData[pixelsX*pixelsY];
-                    
-                    // Run through and query the various cells
-                    for (unsigned int cy=0;cy<pixelsY;cy++)
-                        for (unsigned int cx=0;cx<pixelsX;cx++)
-                        {
-                            double thisX = tileMinX + cellX*cx;
-                            double thisY = tileMinY + cellY*cy;
-                            
-                            if (samplingtype == SampleSingle)
-                            {
-                                // Project back to the original data file
-                                if (hCT)
-                                    OCTTransform(hCTBack, 1, &thisX, &thisY, NULL);
-
-                                // Figure out which pixel this is
-                                double pixX = adfInvGeoTransform[0] + adfInvGeoTransform[1] * thisX + adfInvGeoTransform[2] * thisY;
-                                double pixY = adfInvGeoTransform[3] + adfInvGeoTransform[4] * thisX + adfInvGeoTransform[5] * thisY;
-                                
-                                // Note: Should do some interpolation
-                                int pixXint = (int)pixX,pixYint = (int)pixY;
-                                
-                                double ta = pixX-pixXint;
-                                double tb = pixY-pixYint;
-
-                                // Look up the four nearby pixels
-                                int pixXlookup[4],pixYlookup[4];
-                                pixXlookup[0] = pixXint;  pixYlookup[0] = pixYint;
-                                pixXlookup[1] = pixXint+1;  pixYlookup[1] = pixYint;
-                                pixXlookup[2] = pixXint+1;  pixYlookup[2] = pixYint+1;
-                                pixXlookup[3] = pixXint;  pixYlookup[3] = pixYint+1;
-                                float pixVals[4];
-                                for (unsigned int pi=0;pi<4;pi++)
-                                {
-                                    int pixXlook = pixXlookup[pi];
-                                    int pixYlook = pixYlookup[pi];
-                                    if (pixXlook < 0) pixXlook = 0;
-                                    if (pixYlook < 0) pixYlook = 0;
-                                    if (pixXlook >= rasterXSize)  pixXlook = rasterXSize-1;
-                                    if (pixYlook >= rasterYSize)  pixYlook = rasterYSize-1;
-                                
-                                    // Fetch the pixel
-                                    if (GDALRasterIO( hBand, GF_Read, pixXlook, pixYlook, 1, 1, &pixVals[pi], 1, 1, GDT_Float32, 0,  0) != CE_None)
-                                    {
-                                        fprintf(stderr,"Query failure in GDALRasterIO");
-                                        return -1;
-                                    }
-                                }
-                                
-                                // Now do a bilinear interpolation
-                                float pixA = (pixVals[1]-pixVals[0])*ta + pixVals[0];
-                                float pixB = (pixVals[2]-pixVals[3])*ta + pixVals[3];
-                                float pixVal = (pixB-pixA)*tb+pixA;
-                                
-                                tileData[cy*pixelsX+cx] = pixVal;
-                            } else if (samplingtype == SampleMax)
-                            {
-                                // Make a bounding box and project it into the source data
-                                double pixX[4],pixY[4];
-                                double srcX[4],srcY[4];
-                                srcX[0] = thisX-cellX/2.0;  srcY[0] = thisY-cellY/2.0;
-                                srcX[1] = thisX+cellX/2.0;  srcY[1] = thisY-cellY/2.0;
-                                srcX[2] = thisX+cellX/2.0;  srcY[2] = thisY+cellY/2.0;
-                                srcX[3] = thisX-cellX/2.0;  srcY[3] = thisY+cellY/2.0;
-                                
-                                // Convert the rectangle points individually, if needed
-                                if (hCT)
-                                    for (unsigned int pi=0;pi<4;pi++)
-                                        OCTTransform(hCTBack, 1, &srcX[pi], &srcY[pi], NULL);
-
-                                int sx=1000000,sy=1000000,ex=-1000000,ey=-1000000;
-                                for (unsigned int pi=0;pi<4;pi++)
-                                {
-                                    pixX[pi] = adfInvGeoTransform[0] + adfInvGeoTransform[1] * srcX[pi] + adfInvGeoTransform[2] * srcY[pi];
-                                    pixY[pi] = adfInvGeoTransform[3] + adfInvGeoTransform[4] * srcX[pi] + adfInvGeoTransform[5] * srcY[pi];
-                                    sx = MIN(sx,floor(pixX[pi]));
-                                    sy = MIN(sy,floor(pixY[pi]));
-                                    ex = MAX(ex,ceil(pixX[pi]));
-                                    ey = MAX(ey,ceil(pixY[pi]));
-                                }
-                                sx = MAX(0,sx);
-                                sy = MAX(0,sy);
-                                sx = MIN(sx,rasterXSize-1);
-                                sy = MIN(sy,rasterYSize-1);
-                                ex = MAX(0,ex);
-                                ey = MAX(0,ey);
-                                ex = MIN(ex,rasterXSize-1);
-                                ey = MIN(ey,rasterYSize-1);
-                                
-                                
-                                
-                                // Work through the pixels in the source looking for a max
-                                float maxPix = -MAXFLOAT;
-
-                                // Search for the maximum pixel in the area
-                                maxPix = searchForMaxPixel(hBand, sx, sy, ex, ey);
-                                
-                                tileData[cy*pixelsX+cx] = maxPix;
-                            }
+                            failed = true;
                         }
-                    
-                    // Output directory
-                    if (targetDir)
-                    {
+                        
                         // Write all the data at once
-                        if (GDALRasterIO( hBandOut, GF_Write, 0, 0, pixelsX, pixelsY, tileData, pixelsX, pixelsX, GDT_Int16, 0, 0) != CE_None)
+                        else if (GDALRasterIO( hBandOut, GF_Write, 0, 0, pixelsX, pixelsY, (void *)&tileData[0], pixelsX, pixelsY, GDT_Float32, 0, 0) != CE_None)
                         {
                             fprintf(stderr,"Failed to write output data");
-                            return -1;
+                            failed = true;
+                        } else {
+                            // Set projection and extents
+                            GDALSetProjection(hDestDS, trgSrsWKT);
+                            
+                            double adfOutTransform[6];
+                            adfOutTransform[0] = result.tileMinX;
+                            adfOutTransform[1] = (result.tileMaxX-result.tileMinX)/pixelsX;
+                            adfOutTransform[2] = 0;
+                            adfOutTransform[3] = result.tileMinY;
+                            adfOutTransform[4] = 0;
+                            adfOutTransform[5] = (result.tileMaxY-result.tileMinY)/pixelsY;
+                            GDALSetGeoTransform(hDestDS, adfOutTransform);
                         }
-
-                        // Set projection and extents
-                        GDALSetProjection(hDestDS, trgSrsWKT);
-                        
-                        double adfOutTransform[6];
-                        adfOutTransform[0] = tileMinX;
-                        adfOutTransform[1] = (tileMaxX-tileMinX)/pixelsX;
-                        adfOutTransform[2] = 0;
-                        adfOutTransform[3] = tileMinY;
-                        adfOutTransform[4] = 0;
-                        adfOutTransform[5] = (tileMaxY-tileMinY)/pixelsY;
-                        GDALSetGeoTransform(hDestDS, adfOutTransform);
                         
                         // Close the output file
-                        GDALClose(hDestDS);
+                        if (hDestDS)
+                            GDALClose(hDestDS);
                     }
-                    
-                    // Output pyramid sqlite db
-                    if (elevPyr)
+                }
+                
+                // Output pyramid sqlite db
+                if (elevPyr && !failed)
+                {
+                    totalTiles++;
+                    if (result.nonZero)
                     {
-                        // See if anything of is non-zero
-                        bool nonZero = false;
-                        for (unsigned int ip=0;ip<pixelsX*pixelsY;ip++)
-                            if (tileData[ip] != 0)
-                            {
-                                nonZero = true;
-                                break;
-                            }
-                        
-                        totalTiles++;
-                        if (nonZero)
+                        bool written = false;
+                        if (encoding == EncodeInt16)
                         {
                             // Need int16 data
-                            short tileDataShort[pixelsX*pixelsY];
+                            std::vector<short> tileDataShort(pixelsX*pixelsY);
                             for (unsigned int ii=0;ii<pixelsX*pixelsY;ii++)
                                 tileDataShort[ii] = tileData[ii];
-
-                            if (!elevPyr->addElevationTile(tileDataShort, ix, iy, level))
-                            {
-                                fprintf(stderr, "Failed to write tile %d: %d, %d",level,ix,iy);
-                                return -1;
-                            }
-                        } else {
-                            if (!elevPyr->addElevationTile(NULL, ix, iy, level))
-                            {
-                                fprintf(stderr, "Failed to write empty tile %d: %d, %d",level,ix,iy);
-                                return -1;
-                            }
-                            zeroTiles++;
-                        }                    
-                    }
-                    
-                    // Update the shape file for what we're... updating
-                    if (outShapeLayer)
-                    {
-                        float minElev=MAXFLOAT,maxElev=-MAXFLOAT;
-                        for (unsigned int it=0;it<pixelsX*pixelsY;it++)
+                            written = elevPyr->addElevationTile(&tileDataShort[0], ix, iy, level);
+                        } else
+                            written = elevPyr->addEncodedTile(&result.encoded[0], (int)result.encoded.size(), ix, iy, level);
+                        if (!written)
                         {
-                            minElev = MIN(minElev,tileData[it]);
-                            maxElev = MAX(maxElev,tileData[it]);
+                            fprintf(stderr, "Failed to write tile %d: %d, %d",level,ix,iy);
+                            failed = true;
                         }
-                        OGRPolygon *poly = new OGRPolygon();
-                        OGRLinearRing ring;
-                        ring.addPoint(tileMinX, tileMinY);
-                        ring.addPoint(tileMaxX, tileMinY);
-                        ring.addPoint(tileMaxX, tileMaxY);
-                        ring.addPoint(tileMinX, tileMaxY);
-                        ring.addPoint(tileMinX, tileMinY);
-                        poly->addRing(&ring);
-                        OGRFeature *feat = new OGRFeature(outShapeLayer->GetLayerDefn());
-                        feat->SetGeometry(poly);
-                        char cellName[1024];
-                        sprintf(cellName,"cell: %d: (%d,%d)",level,ix,iy);
-                        feat->SetField("cell",cellName);
-                        feat->SetField("min", minElev);
-                        feat->SetField("max", maxElev);
-                        outShapeLayer->CreateFeature(feat);
-                        OGRFeature::DestroyFeature( feat );
+                    } else {
+                        if (!elevPyr->addElevationTile(NULL, ix, iy, level))
+                        {
+                            fprintf(stderr, "Failed to write empty tile %d: %d, %d",level,ix,iy);
+                            failed = true;
+                        }
+                        zeroTiles++;
                     }
                     
-                } else
-                    skippedTiles++;
+                    if (++tilesInBatch >= batchSize)
+                    {
+                        Kompex::SQLiteStatement transactStmt(sqliteDb);
+                        transactStmt.SqlStatement((std::string)"END TRANSACTION");
+                        transactStmt.SqlStatement((std::string)"BEGIN TRANSACTION");
+                        tilesInBatch = 0;
+                    }
+                }
                 
-                chunksProcessed++;
-                double done = chunksProcessed/((double)numTilesToDo);
-                GDALTermProgress(done,NULL,NULL);
+                // Update the shape file for what we're... updating
+                if (outShapeLayer && !failed)
+                {
+                    float minElev=MAXFLOAT,maxElev=-MAXFLOAT;
+                    for (unsigned int it=0;it<pixelsX*pixelsY;it++)
+                    {
+                        minElev = MIN(minElev,tileData[it]);
+                        maxElev = MAX(maxElev,tileData[it]);
+                    }
+                    OGRPolygon *poly = new OGRPolygon();
+                    OGRLinearRing ring;
+                    ring.addPoint(result.tileMinX, result.tileMinY);
+                    ring.addPoint(result.tileMaxX, result.tileMinY);
+                    ring.addPoint(result.tileMaxX, result.tileMaxY);
+                    ring.addPoint(result.tileMinX, result.tileMaxY);
+                    ring.addPoint(result.tileMinX, result.tileMinY);
+                    poly->addRing(&ring);
+                    OGRFeature *feat = new OGRFeature(outShapeLayer->GetLayerDefn());
+                    feat->SetGeometry(poly);
+                    char cellName[1024];
+                    sprintf(cellName,"cell: %d: (%d,%d)",level,ix,iy);
+                    feat->SetField("cell",cellName);
+                    feat->SetField("min", minElev);
+                    feat->SetField("max", maxElev);
+                    outShapeLayer->CreateFeature(feat);
+                    OGRFeature::DestroyFeature( feat );
+                }
             }
+            
+            double done = (which+1)/((double)numTilesToDo);
+            GDALTermProgress(done,NULL,NULL);
         }
         
-        GDALTermProgress(1.0,NULL,NULL);
+        // Let the workers know if we're bailing out
+        {
+            std::lock_guard<std::mutex> lock(resultLock);
+        }
+        resultCond.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+        
+        if (!failed)
+            GDALTermProgress(1.0,NULL,NULL);
     }
+    if (failed)
+        return -1;
     
     if (outShape)
         OGRDataSource::DestroyDataSource( outShape );
         
     printf("Flushing database...");  fflush(stdout);
-    // Flush out one big one
-    if (targetDb)
+    // Flush out the last batch
+    if (sqliteDb)
     {
         Kompex::SQLiteStatement transactStmt(sqliteDb);
         transactStmt.SqlStatement((std::string)"END TRANSACTION");
@@ -60,6 +60,7 @@ FOUNDATION_EXPORT const unsigned char WhirlyGlobeMaplyComponentVersionString[];
 #import <WhirlyGlobe/MaplyMatrix.h>
 #import <WhirlyGlobe/MaplyMBTileFetcher.h>
 #import <WhirlyGlobe/MaplyMoon.h>
+#import <WhirlyGlobe/MaplyPMTilesFetcher.h>
 #import <WhirlyGlobe/MaplyPanDelegate.h>
 #import <WhirlyGlobe/MaplyParticleSystem.h>
 #import <WhirlyGlobe/MaplyPinchDelegate.h>
@@ -31,6 +31,7 @@
 #import <WhirlyGlobe/MaplyMatrix.h>
 
 #import <WhirlyGlobe/MaplyActiveObject.h>
+#import <WhirlyGlobe/MaplyDescription.h>
 #import <WhirlyGlobe/MaplyAnnotation.h>
 #import <WhirlyGlobe/MaplyRenderController.h>
 #import <WhirlyGlobe/MaplyUpdateLayer.h>
@@ -83,14 +84,20 @@
 #import <WhirlyGlobe/MaplyQuadImageLoader.h>
 #import <WhirlyGlobe/MaplyQuadImageFrameLoader.h>
 #import <WhirlyGlobe/MaplyQuadPagingLoader.h>
+#import <WhirlyGlobe/MaplyVectorTiler.h>
 #import <WhirlyGlobe/MaplyTileSourceNew.h>
 #import <WhirlyGlobe/MaplySimpleTileFetcher.h>
 #import <WhirlyGlobe/MaplyQuadSampler.h>
 #import <WhirlyGlobe/MaplyRemoteTileFetcher.h>
+#import <WhirlyGlobe/MaplyMultiResTileInfo.h>
+#import <WhirlyGlobe/MaplyPointCloudLoader.h>
+#import <WhirlyGlobe/MaplyOfflineRegion.h>
+#import <WhirlyGlobe/MaplyElevationInterpreter.h>
 #import <WhirlyGlobe/GeoJSONSource.h>
 
 #import <WhirlyGlobe/MaplyWMSTileSource.h>
 #import <WhirlyGlobe/MaplyMBTileFetcher.h>
+#import <WhirlyGlobe/MaplyPMTilesFetcher.h>
 
 #import <WhirlyGlobe/MaplyVariableTarget.h>
 #import <WhirlyGlobe/MaplyAtmosphere.h>
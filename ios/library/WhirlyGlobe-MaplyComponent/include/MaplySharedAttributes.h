@@ -204,6 +204,12 @@ extern NSString * const _Nonnull kMaplyVecTexScaleY;
 
 // scale for markers
 extern NSString * const _Nonnull kMaplyMarkerScale;
+/// Screen markers that will be moved with moveScreenMarkers:.  They don't take part in layout.
+extern NSString * const _Nonnull kMaplyMarkerFleet;
+/// Plain screen markers are drawn as instances of one shared quad, which is a lot less vertex data
+extern NSString * const _Nonnull kMaplyMarkerInstanced;
+/// Markers on the globe sit on the loaded elevation, if it's there when they're added
+extern NSString * const _Nonnull kMaplyMarkerClampToGround;
 
 /// The projection to use when generating texture coordinates
 extern NSString * const _Nonnull kMaplyVecTextureProjection;
@@ -218,6 +224,14 @@ extern NSString * const _Nonnull kMaplyProjectionNone;
 /// This fixes the jittering problem when zoomed in close
 extern NSString * const _Nonnull kMaplyVecCentered;
 
+/// Number of simplified versions of linear and areal features to build for lower zoom levels.
+/// Needs a zoom slot to switch between them.
+extern NSString * const _Nonnull kMaplyVecLODLevels;
+/// Zoom level where features are shown at full detail
+extern NSString * const _Nonnull kMaplyVecLODMaxZoom;
+/// How far lines can stray during simplification, in pixels
+extern NSString * const _Nonnull kMaplyVecLODTolerance;
+
 /// Center of the feature, to use for texture calculations
 extern NSString * const _Nonnull kMaplyVecCenterX;
 extern NSString * const _Nonnull kMaplyVecCenterY;
@@ -336,6 +350,8 @@ extern NSString * const _Nonnull kMaplyBillboardOrient;
 extern NSString * const _Nonnull kMaplyBillboardOrientGround;
 /// Billboards are oriented only towards the eye
 extern NSString * const _Nonnull kMaplyBillboardOrientEye;
+/// Billboards are drawn as instances of a single quad, which is a lot less vertex data
+extern NSString * const _Nonnull kMaplyBillboardInstanced;
 
 /// These are used for lofted polygons
 
@@ -353,6 +369,10 @@ extern NSString * const _Nonnull kMaplyLoftedPolyGridSize;
 extern NSString * const _Nonnull kMaplyLoftedPolyOutline;
 /// If set to @(YES) this will draw an outline around the bottom of the lofted poly in lines
 extern NSString * const _Nonnull kMaplyLoftedPolyOutlineBottom;
+/// If set to @(YES) the walls and roof are raised by the shader.  Metal builds them up front instead.
+extern NSString * const _Nonnull kMaplyLoftedPolyShaderExtrude;
+/// If set to @(YES) touching footprints are merged into one roof, dropping the walls between them
+extern NSString * const _Nonnull kMaplyLoftedPolyMergeRoofs;
 /// If the outline is one this is the outline's color
 extern NSString * const _Nonnull kMaplyLoftedPolyOutlineColor;
 /// This is the outline's width if it's turned on
@@ -370,6 +390,8 @@ extern NSString * const _Nonnull kMaplyShapeSampleX;
 extern NSString * const _Nonnull kMaplyShapeSampleY;
 /// If set to true, we'll tessellate a shape using the opposite vertex ordering
 extern NSString * const _Nonnull kMaplyShapeInsideOut;
+/// If set to true, circles, spheres and cylinders are drawn as instances of one shared mesh
+extern NSString * const _Nonnull kMaplyShapeInstanced;
 /// Center for the shape geometry
 extern NSString * const _Nonnull kMaplyShapeCenterX;
 extern NSString * const _Nonnull kMaplyShapeCenterY;
@@ -410,6 +432,8 @@ extern NSString * const _Nonnull kMaplyShaderDefaultTriScreenTex;
 
 extern NSString * const _Nonnull kMaplyShaderDefaultTriMultiTex;
 extern NSString * const _Nonnull kMaplyShaderDefaultTriMultiTexRamp;
+extern NSString * const _Nonnull kMaplyShaderDefaultTriComposite;
+extern NSString * const _Nonnull kMaplyShaderDefaultTriTerrain;
 extern NSString * const _Nonnull kMaplyShaderDefaultTriNightDay;
 
 extern NSString * const _Nonnull kMaplyShaderDefaultLine;
@@ -420,6 +444,9 @@ extern NSString * const _Nonnull kMaplyNoBackfaceLineShader;
 
 extern NSString * const _Nonnull kMaplyShaderBillboardGround;
 extern NSString * const _Nonnull kMaplyShaderBillboardEye;
+/// Billboards drawn as instances of one quad (used for kMaplyBillboardInstanced)
+extern NSString * const _Nonnull kMaplyShaderBillboardGroundInstance;
+extern NSString * const _Nonnull kMaplyShaderBillboardEyeInstance;
 
 extern NSString * const _Nonnull kMaplyShaderDefaultWideVector;
 extern NSString * const _Nonnull kMaplyShaderWideVectorPerformance;
@@ -428,7 +455,14 @@ extern NSString * const _Nonnull kMaplyShaderWideVectorExp;
 extern NSString * const _Nonnull kMaplyScreenSpaceDefaultMotionProgram;
 extern NSString * const _Nonnull kMaplyScreenSpaceDefaultProgram;
 extern NSString * const _Nonnull kMaplyScreenSpaceMaskProgram;
+/// Draws selectable shapes into the selection ID render target
+extern NSString * const _Nonnull kMaplyTriangleIDProgram;
 extern NSString * const _Nonnull kMaplyScreenSpaceExpProgram;
+extern NSString * const _Nonnull kMaplyScreenSpaceSDFProgram;
+extern NSString * const _Nonnull kMaplyScreenSpaceSDFMotionProgram;
+/// Screen space rectangles drawn as instances of one quad (used by the layout engine)
+extern NSString * const _Nonnull kMaplyScreenSpaceInstanceProgram;
+extern NSString * const _Nonnull kMaplyScreenSpaceSDFInstanceProgram;
 
 extern NSString * const _Nonnull kMaplyAtmosphereProgram;
 extern NSString * const _Nonnull kMaplyAtmosphereGroundProgram;
@@ -34,6 +34,7 @@
 #import "GlobePanDelegate.h"
 #import "MaplyTextureBuilder.h"
 #import "MaplyActiveObject.h"
+#import "MaplyDescription.h"
 #import "MapboxVectorStyleSet.h"
 #import "MaplyScreenMarker.h"
 #import "MaplyViewTracker.h"
@@ -56,7 +57,12 @@
 #import "MaplyIconManager.h"
 #import "MaplyLight.h"
 #import "MaplyQuadPagingLoader.h"
+#import "MaplyVectorTiler.h"
 #import "MaplyRemoteTileFetcher.h"
+#import "MaplyMultiResTileInfo.h"
+#import "MaplyPointCloudLoader.h"
+#import "MaplyOfflineRegion.h"
+#import "MaplyElevationInterpreter.h"
 #import "GlobeDoubleTapDragDelegate.h"
 #import "MaplyMBTileFetcher.h"
 #import "MaplySimpleTileFetcher.h"
@@ -20,6 +20,7 @@
 #import <Metal/Metal.h>
 #import <WhirlyGlobe/MaplyCoordinate.h>
 #import <WhirlyGlobe/MaplyScreenMarker.h>
+#import <WhirlyGlobe/MaplyScreenLabel.h>
 #import <WhirlyGlobe/MaplyVectorObject.h>
 #import <WhirlyGlobe/MaplyViewTracker.h>
 #import <WhirlyGlobe/MaplyComponentObject.h>
@@ -43,6 +44,27 @@
 typedef double (^ZoomEasingBlock)(double z0,double z1,double t);
 typedef void (__strong ^InitCompletionBlock)(void);
 
+/// How hard the renderer tries to keep the frame rate up.
+/// Full renders at the display rate whenever anything changes.
+/// Balanced keeps the full rate for view motion, runs fades and other animation at up to 60fps
+///  and tile loading at 30fps, and polls at 30fps when idle.
+/// Low power caps motion at 60fps, everything else at 30fps, and polls at 15fps when idle.
+typedef NS_ENUM(NSInteger, MaplyFramePacing) {
+    MaplyFramePacingFull,
+    MaplyFramePacingBalanced,
+    MaplyFramePacingLowPower,
+};
+
+/// How much to give back under memory pressure.  Each level includes the ones before it.
+/// Caches drops decode buffers, parsed tile and label layout caches and spare GPU buffers.
+/// Offscreen tiles holds tile loaders to less than they have for a while, least important tiles first.
+/// Atlas pages repacks the label glyph textures.
+typedef NS_ENUM(NSInteger, MaplyMemoryTrimLevel) {
+    MaplyMemoryTrimCaches = 1,
+    MaplyMemoryTrimOffscreenTiles,
+    MaplyMemoryTrimAtlasPages,
+};
+
 /** 
     When selecting multiple objects, one or more of these is returned.
     
@@ -159,6 +181,131 @@ typedef void (__strong ^InitCompletionBlock)(void);
  */
 @property (nonatomic,assign) bool layoutFade;
 
+/**
+    Keep label placements from one layout pass to the next where nothing has changed around them.
+ 
+    Only labels that moved relative to the view, or are near something that changed, are re-evaluated,
+    and only the affected drawables are rebuilt.  This helps with thousands of labels.  Off by default.
+ */
+@property (nonatomic,assign) bool layoutIncremental;
+
+/**
+    Extra threads to lay out labels on.
+ 
+    The screen is split into tiles which are laid out at the same time, after the labels that could
+    land across the tile edges.  Worth it for screens with thousands of labels.  0 (the default) turns it off.
+ */
+@property (nonatomic,assign) int layoutThreads;
+
+/**
+    Show and hide labels by updating the drawables they're already in, rather than building new ones.
+ 
+    Hidden labels stay in the drawables until there are enough of them to be worth a rebuild.
+    Doesn't apply with layout fade, clustering or incremental layout.  Off by default.
+ */
+@property (nonatomic,assign) bool layoutToggleInPlace;
+
+/**
+    Draw plain rectangular labels and markers as instances of one shared quad.
+ 
+    Anything with masks, expressions or animated textures is still built the regular way.
+    With layoutToggleInPlace, instanced objects can also be moved without a rebuild.  Off by default.
+ */
+@property (nonatomic,assign) bool layoutInstancing;
+
+/**
+    Cluster markers from a hierarchy worked out when they're added, rather than from scratch every layout.
+ 
+    Helps a lot with tens of thousands of clustered markers.  Clusters are formed in map space at
+    fixed zoom levels, so they won't follow rotation or tilt quite as closely.  Off by default.
+ */
+@property (nonatomic,assign) bool layoutClusterHierarchy;
+
+/**
+    Directory to keep rendered label glyphs in.
+ 
+    Glyphs rendered by CoreText are saved here and loaded back in later runs rather than rendered again.
+    Somewhere under the caches directory is a good spot.  Nil, the default, turns it off.
+ */
+@property (nonatomic,copy) NSString * _Nullable glyphCacheDir;
+
+/**
+    Get something on the screen sooner at startup.
+ 
+    The shader functions are looked up in parallel with the rest of the setup.  Image loaders draw the low levels they have in place of tiles that are still loading, and the tile fetchers the controller makes read cached tiles without waiting for a connection.  Between them, the low zoom tiles cached on the last run show up right away.  The tile sources need a cacheDir for that.
+ 
+    Set this before the controller's view loads.  Off by default.
+ */
+@property (nonatomic,assign) bool fastStartup;
+
+/**
+    Render label glyphs as signed distance fields.
+ 
+    Glyphs are rendered once per font at a fixed size and scaled by the shader, so labels
+    stay sharp at any size and share texture space.  Labels with outlines or backgrounds
+    are rendered as before, as are labels with their own shader.  Off by default.
+    Applies to labels added after it's set.
+ */
+@property (nonatomic,assign) bool labelSDF;
+
+/**
+    Keep the label glyph textures compact.
+ 
+    As labels come and go, pages of glyphs that are no longer used are released and
+    sparsely used pages are folded into others.  Worth turning on for long sessions
+    with a lot of label turnover.  Off by default.
+ */
+@property (nonatomic,assign) bool labelAtlasCompaction;
+
+/**
+    Render label glyphs ahead of time.
+ 
+    Renders the glyphs for the given characters in the given font, so labels using them
+    don't have to wait.  Use it for the character sets you know you'll need, such as digits
+    or part of a CJK set.  Outlined labels have their colors baked into the glyphs, so pass
+    the text color, outline color and size those use, or nil and 0 for plain labels.
+    This takes a while for big sets, so call it off the main thread.
+    The glyphs are held until releaseLabelGlyphWarmUp.
+ */
+- (void)warmUpLabelGlyphs:(NSString *__nonnull)chars
+                     font:(UIFont *__nonnull)font
+                textColor:(UIColor *__nullable)textColor
+             outlineColor:(UIColor *__nullable)outlineColor
+              outlineSize:(float)outlineSize;
+
+/// Release the glyphs held by warmUpLabelGlyphs:font:textColor:outlineColor:outlineSize:
+- (void)releaseLabelGlyphWarmUp;
+
+/**
+    Memory in use, in bytes, by category.
+ 
+    Keys are textures, vertexBuffers, atlases, caches, parsedTiles and total.
+    GPU memory is only counted when it comes from Metal heaps, which isn't the case in the simulator.
+ */
+- (NSDictionary<NSString *,NSNumber *> *__nonnull)memoryUsage;
+
+/**
+    Memory held by the drawables and textures in the scene, by owner.
+ 
+    The owner is the name the manager or loader gave them, such as "Vector Layer" or "Marker Layer".
+    Each entry is a dictionary with "count", "cpuBytes" and "gpuBytes".
+    The totals are kept up to date as things come and go, so this is cheap enough to poll.
+    A count that only goes up is a good sign of a leak.
+ */
+- (NSDictionary<NSString *,NSDictionary<NSString *,NSNumber *> *> *__nonnull)memoryUsageByOwner;
+
+/**
+    The same, by type: "basic", "instance", "screenSpace", "particles", "texture" and "dynamicTexture".
+ */
+- (NSDictionary<NSString *,NSDictionary<NSString *,NSNumber *> *> *__nonnull)memoryUsageByType;
+
+/**
+    Give back memory, in order, up to the given level.
+ 
+    Memory warnings do this with MaplyMemoryTrimAtlasPages.  Nothing on screen is torn down.
+ */
+- (void)trimMemory:(MaplyMemoryTrimLevel)level;
+
 /**
     Controls the way height changes while animating the view
     For simple, linear zoom use:
@@ -262,6 +409,26 @@ typedef void (__strong ^InitCompletionBlock)(void);
   */
 - (MaplyComponentObject *__nullable)addScreenMarkers:(NSArray *__nonnull)markers desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode;
 
+/**
+    Add a lot of screen markers at once, from plain structs.
+
+    This skips making a MaplyScreenMarker for each one and fills in markers directly from the structs.  It's meant for large sets of simple markers.  These markers aren't selectable and don't have rotations, offsets, masks or moving versions.  Everything not in the struct comes from the description, which takes the same entries as addScreenMarkers:desc:mode:.
+
+    @param markers The markers, copied before this returns.
+
+    @param count Number of markers.
+
+    @param textures Textures the markers refer to by index.  The component object holds on to them.
+
+    @param desc The description dictionary, as for addScreenMarkers:desc:mode:.
+
+    @param threadMode MaplyThreadAny is preferred and will use another thread, thus not blocking the one you're on.  MaplyThreadCurrent will make the changes immediately, blocking this thread.
+
+    @return Returns a MaplyComponentObject, which can be used to make modifications or delete the objects created.
+  */
+- (MaplyComponentObject *__nullable)addScreenMarkerStructs:(const MaplyScreenMarkerStruct *__nonnull)markers count:(NSUInteger)count
+                                                 textures:(NSArray<MaplyTexture *> *__nullable)textures desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode;
+
 /** 
     Add a cluster generator for making clustered marker images on demand.
     
@@ -360,6 +527,28 @@ typedef void (__strong ^InitCompletionBlock)(void);
  */
 - (MaplyComponentObject *__nullable)addScreenLabels:(NSArray *__nonnull)labels desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode;
 
+/**
+    Add a lot of screen labels at once, from plain structs.
+
+    This skips making a MaplyScreenLabel for each one and fills in labels directly from the structs.  The strings for all the labels go in one block of UTF-8 text, each ending with a NUL, with the structs pointing into it.  These labels aren't selectable and don't have icons, rotations, offsets, masks or moving versions.  Everything not in the struct comes from the description, which takes the same entries as addScreenLabels:desc:mode:.
+
+    @param labels The labels, copied before this returns.
+
+    @param count Number of labels.
+
+    @param text The strings for the labels, copied before this returns.
+
+    @param length Length of the text block in bytes.
+
+    @param desc The description dictionary, as for addScreenLabels:desc:mode:.
+
+    @param threadMode MaplyThreadAny is preferred and will use another thread, thus not blocking the one you're on.  MaplyThreadCurrent will make the changes immediately, blocking this thread.
+
+    @return Returns a MaplyComponentObject, which can be used to make modifications or delete the objects created.
+  */
+- (MaplyComponentObject *__nullable)addScreenLabelStructs:(const MaplyScreenLabelStruct *__nonnull)labels count:(NSUInteger)count
+                                                    text:(const char *__nonnull)text length:(NSUInteger)length desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode;
+
 /// This calls addLabels:desc:mode: with mode set to MaplyThreadAny
 - (MaplyComponentObject *__nullable)addLabels:(NSArray *__nonnull)labels desc:(NSDictionary *__nullable)desc;
 
@@ -588,6 +777,7 @@ typedef void (__strong ^InitCompletionBlock)(void);
  |kMaplyShapeSampleX|NSNumber|Number of samples to use in one direction when converting to polygons.|
  |kMaplyShapeSampleY|NSNumber|Number of samples to use in the other direction when converting to polygons.|
  |kMaplyShapeInsideOut|NSNumber boolean|If set to YES, we'll make the spheres inside out and such.  Set to NO by default.|
+ |kMaplyShapeInstanced|NSNumber boolean|If set to YES, circles, spheres and cylinders are drawn as instances of a shared mesh, which is much faster for large numbers of them.  Set to NO by default.|
  |kMaplyMinVis|NSNumber|This is viewer height above the globe or map.  The shapes will only be visible if the user is above this height.  Off by default.|
  |kMaplyMaxVis|NSNumber|This is viewer height above the globe or map.  The shapes will only be visible if the user is below this height.  Off by default.|
  |kMaplyMinViewerDist|NSNumber|Minimum distance from the viewer at which to display object(s).|
@@ -714,6 +904,15 @@ typedef void (__strong ^InitCompletionBlock)(void);
  */
 - (void)changeParticleSystem:(MaplyComponentObject *__nonnull)compObj renderTarget:(MaplyRenderTarget *__nullable)target;
 
+/**
+    Change the textures for a particle system.
+
+    This swaps in new textures for an existing particle system, such as the next frame of a vector field the calculation shader follows.
+    Pass in MaplyTexture objects in the same order as the particle system's images.  You need to keep them around while they're in use.
+    This change takes place immediately, so call it on the main thread.
+ */
+- (void)changeParticleSystem:(MaplyComponentObject *__nonnull)compObj textures:(NSArray<MaplyTexture *> *__nonnull)textures;
+
 /** 
     Add a batch of particles to the current scene.
     
@@ -756,6 +955,26 @@ typedef void (__strong ^InitCompletionBlock)(void);
  */
 - (void)changeVector:(MaplyComponentObject *__nonnull)compObj desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode;
 
+/**
+    Move a fleet of screen markers to new locations.
+
+    The markers must have been added with kMaplyMarkerFleet set.  Locations go with the markers in the order they were added.
+    Each marker heads for its new location over the given duration and keeps going at that speed until it's moved again,
+    so regular position updates come out smooth.  A duration of zero moves them straight there.
+
+    @param compObj The component object returned by addScreenMarkers:desc:.
+
+    @param locs New locations in geographic (radians), one per marker.
+
+    @param count Number of locations.
+
+    @param duration Time to get there, in seconds.
+
+    @param threadMode MaplyThreadAny will use another thread, thus not blocking the one you're on.  MaplyThreadCurrent will make the changes immediately, blocking this thread.
+  */
+- (void)moveScreenMarkers:(MaplyComponentObject *__nonnull)compObj locations:(const MaplyCoordinate *__nonnull)locs count:(int)count
+                 duration:(NSTimeInterval)duration mode:(MaplyThreadMode)threadMode;
+
 /** 
     Adds the MaplyVectorObject's passed in as lofted polygons.
     
@@ -778,6 +997,7 @@ typedef void (__strong ^InitCompletionBlock)(void);
  |kMaplyLoftedPolyGridSize|NSNumber|The size of the grid (in radians) we'll use to chop up the vector features to make them follow the sphere (for a globe).|
  |kMaplyLoftedPolyOutline|NSNumber boolean|If set to @(YES) this will draw an outline around the top of the lofted poly in lines.|
  |kMaplyLoftedPolyOutlineBottom|NSNumber boolean|If set to @(YES) this will draw an outline around the bottom of the lofted poly in lines.|
+ |kMaplyLoftedPolyMergeRoofs|NSNumber boolean|If set to @(YES) touching footprints are merged, so they share one roof and lose the walls between them.  Merged roofs aren't clipped to the grid.|
  |kMaplyLoftedPolyOutlineColor|UIColor|If the outline is on this is the outline's color.|
  |kMaplyLoftedPolyOutlineWidth|NSNumber|This is the outline's width if it's turned on.|
  |kMaplyLoftedPolyOutlineDrawPriority|NSNumber|Draw priority of the lines created for the lofted poly outline.|
@@ -1100,6 +1320,21 @@ typedef void (__strong ^InitCompletionBlock)(void);
   */
 - (void)removeRenderTarget:(MaplyRenderTarget * _Nonnull)renderTarget;
 
+/**
+    Pick shapes by drawing their IDs into a render target.
+
+    Selectable shapes added after this go into a render target at the given fraction of the screen size (0.25 by default).
+    Picking them reads back the pixels around the touch, rather than testing each one's geometry.
+    This only applies to the Metal renderer.
+    Wide vectors and lofted polygons aren't drawn into the target.  They're still found with findVectorsInPoint:.
+ */
+- (void)startSelectionIDTarget:(NSNumber * __nullable)scale;
+
+/**
+    Go back to picking shapes by their geometry.
+ */
+- (void)stopSelectionIDTarget;
+
 /** 
     Set the max number of objects for the layout engine to display.
     
@@ -1336,6 +1571,8 @@ typedef void (__strong ^InitCompletionBlock)(void);
  |kMaplyShaderDefaultTri|The shader used on triangles by default when there is lighting.|
  |kMaplyShaderDefaultTriNoLighting|The shader used when lighting is explicitly turned off.|
  |kMaplyShaderDefaultTriMultiTex|The shader used when drawables have more than one texture.|
+ |kMaplyShaderDefaultTriComposite|The shader used by frame loaders that composite their frames.|
+ |kMaplyShaderDefaultTriTerrain|The shader used by frame loaders that raise their tiles with elevation.|
  |kMaplyShaderDefaultLine|The shader used for line drawing on the globe.  This does a tricky bit of backface culling.|
  |kMaplyShaderDefaultLineNoBackface|The shader used for line drawing on the map.  This does no backface culling.|
   */
@@ -1483,6 +1720,121 @@ typedef void (__strong ^InitCompletionBlock)(void);
 /// Turn on/off performance output (goes to the log periodically).
 @property (nonatomic,assign) bool performanceOutput;
 
+/**
+    Turn on/off per-frame stats collection.
+ 
+    When on, the renderer records frame time, time spent in each phase, draw calls, triangles,
+    texture bytes uploaded and change requests executed for the last several hundred frames.
+    Fetch them with frameStats.
+  */
+@property (nonatomic,assign) bool frameStatsEnabled;
+
+/**
+    Summarize the recorded per-frame stats.
+ 
+    Returns a dictionary keyed by metric name (e.g. "frameTime", "drawCalls").
+    Each entry is a dictionary with "count", "min", "max", "mean", "p50", "p95" and "p99".
+    Times are in seconds.  Returns nil if stats collection isn't on.
+  */
+- (NSDictionary<NSString *,NSDictionary<NSString *,NSNumber *> *> * _Nullable)frameStats;
+
+/// Discard the recorded per-frame stats
+- (void)clearFrameStats;
+
+/**
+    Turn on/off visibility checks on the GPU.
+ 
+    When on, a compute pass checks each drawable's height range, zoom range and extents
+    and turns off the draw commands for the ones that can't be seen, instead of the CPU
+    re-encoding them.  It only applies on devices that use indirect rendering.
+    On by default where it's supported.
+  */
+@property (nonatomic,assign) bool gpuCulling;
+
+/**
+    Limit how long each frame spends applying changes from the layer threads, in seconds.
+ 
+    Once the limit is hit, everything but high priority changes waits for the next frame,
+    so a big batch of tiles gets spread out rather than dropping a frame.
+    0, the default, means no limit.
+  */
+@property (nonatomic,assign) NSTimeInterval changeTimeBudget;
+
+/**
+    Limit how many bytes of texture and buffer uploads each frame applies.
+ 
+    Works like changeTimeBudget.  0, the default, means no limit.
+  */
+@property (nonatomic,assign) NSUInteger changeByteBudget;
+
+/**
+    Trade resolution for frame rate while the map is moving.
+ 
+    When the GPU takes longer than the display allows for a few frames in a row,
+    the map is drawn smaller, down to minScale of the screen resolution, and scaled up.
+    Labels, markers and other screen space objects stay at full resolution.
+    It steps back up when frames come in well under budget, and goes back to
+    full resolution when the view stops.  Off by default.
+  */
+- (void)setDynamicResolution:(bool)enable minScale:(float)minScale maxScale:(float)maxScale;
+
+/// The fraction of the screen resolution the map is drawn at right now
+@property (nonatomic,readonly) float dynamicResolutionScale;
+
+/**
+    Turn on/off GPU timing.
+ 
+    When on, the renderer asks Metal how long the GPU spent on each work group
+    (offscreen, reduce ops, screen render) for the last several hundred frames.
+    It's separate from frameStatsEnabled since it adds a small amount of work per command buffer.
+  */
+@property (nonatomic,assign) bool gpuTimingsEnabled;
+
+/**
+    Summarize the recorded GPU times.
+ 
+    Returns a dictionary keyed by phase ("offscreen", "reduceOps", "screenRender", "total", ...).
+    Each entry has the same "count", "min", "max", "mean", "p50", "p95" and "p99" as frameStats,
+    in seconds.  Phases that haven't run have a count of zero.  Returns nil if GPU timing isn't on.
+  */
+- (NSDictionary<NSString *,NSDictionary<NSString *,NSNumber *> *> * _Nullable)gpuTimings;
+
+/// Discard the recorded GPU times
+- (void)clearGPUTimings;
+
+/**
+    Startup phases, from the start of setup to the first frame that drew something.
+ 
+    Each entry has a "name", a "start" and an "end", in seconds from when setup started.
+    Marks like "first frame" and "first content" start and end at the same time.
+    Phases that haven't finished have an end of -1.  The phases are written to the log
+    when the first content is drawn.
+  */
+- (NSArray<NSDictionary<NSString *,id> *> * _Nonnull)startupTimings;
+
+/**
+    Control how eagerly we render.
+ 
+    Full is the default and renders at the display rate (up to frameInterval) whenever something changes.
+    The balanced and low power modes slow down frames that don't involve the view moving and let
+    ProMotion displays drop their refresh rate when the map is idle.
+  */
+@property (nonatomic,assign) MaplyFramePacing framePacing;
+
+/**
+    Record trace zones from the loaders, parsers, layout and renderer.
+ 
+    Zones are kept in per-thread buffers and can be fetched with traceJSON.
+    This applies to every controller in the process.
+  */
+@property (nonatomic,assign) bool traceRecording;
+
+/// Pass trace zones through to os_signpost so they show up in Instruments
+@property (nonatomic,assign) bool traceSignposts;
+
+/// Recorded trace zones in Chrome trace event format (chrome://tracing or Perfetto)
+- (NSString * _Nonnull)traceJSON;
+
 /// Turn on/off debug outlines for layout objects
 @property (nonatomic,assign) bool showDebugLayoutBoundaries;
 
@@ -0,0 +1,32 @@
+/*  MaplyDescription.h
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+    A description dictionary that only gets parsed once.
+ 
+    Every add call (addVectors:desc:, addScreenMarkers:desc: and so on) turns its description dictionary into the settings the renderer uses, looking up each of the kMaply entries as it goes.  If you're adding lots of batches with the same style, make one of these from the dictionary and pass it in as the desc instead.  The settings are parsed the first time it's used for each kind of object and copied from then on.
+ 
+    It's an immutable NSDictionary, so it can go anywhere a desc can.  Mask IDs, textures and shaders in it are still looked up on each call, since those can change.
+  */
+@interface MaplyDescription : NSDictionary
+
+/// Make a description from the entries in a dictionary, which are copied
+- (instancetype __nonnull)initWithDictionary:(NSDictionary *__nonnull)dict;
+
+@end
@@ -20,6 +20,7 @@
 
 #import <WhirlyGlobe/MaplyCoordinate.h>
 #import <WhirlyGlobe/MaplyScreenMarker.h>
+#import <WhirlyGlobe/MaplyScreenLabel.h>
 #import <WhirlyGlobe/MaplyVectorObject.h>
 #import <WhirlyGlobe/MaplyComponentObject.h>
 #import <WhirlyGlobe/MaplySharedAttributes.h>
@@ -179,6 +180,26 @@ typedef NS_ENUM(NSInteger, MaplyRenderType) {
  */
 - (MaplyComponentObject *__nullable)addScreenMarkers:(NSArray *__nonnull)markers desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode;
 
+/**
+    Add a lot of screen markers at once, from plain structs.
+
+    This skips making a MaplyScreenMarker for each one and fills in markers directly from the structs.  It's meant for large sets of simple markers.  These markers aren't selectable and don't have rotations, offsets, masks or moving versions.  Everything not in the struct comes from the description, which takes the same entries as addScreenMarkers:desc:mode:.
+
+    @param markers The markers, copied before this returns.
+
+    @param count Number of markers.
+
+    @param textures Textures the markers refer to by index.  The component object holds on to them.
+
+    @param desc The description dictionary, as for addScreenMarkers:desc:mode:.
+
+    @param threadMode MaplyThreadAny is preferred and will use another thread, thus not blocking the one you're on.  MaplyThreadCurrent will make the changes immediately, blocking this thread.
+
+    @return Returns a MaplyComponentObject, which can be used to make modifications or delete the objects created.
+  */
+- (MaplyComponentObject *__nullable)addScreenMarkerStructs:(const MaplyScreenMarkerStruct *__nonnull)markers count:(NSUInteger)count
+                                                 textures:(NSArray<MaplyTexture *> *__nullable)textures desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode;
+
 /**
  Add one or more 3D markers to the current scene.
  
@@ -260,6 +281,28 @@ typedef NS_ENUM(NSInteger, MaplyRenderType) {
  */
 - (MaplyComponentObject *__nullable)addScreenLabels:(NSArray *__nonnull)labels desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode;
 
+/**
+    Add a lot of screen labels at once, from plain structs.
+
+    This skips making a MaplyScreenLabel for each one and fills in labels directly from the structs.  The strings for all the labels go in one block of UTF-8 text, each ending with a NUL, with the structs pointing into it.  These labels aren't selectable and don't have icons, rotations, offsets, masks or moving versions.  Everything not in the struct comes from the description, which takes the same entries as addScreenLabels:desc:mode:.
+
+    @param labels The labels, copied before this returns.
+
+    @param count Number of labels.
+
+    @param text The strings for the labels, copied before this returns.
+
+    @param length Length of the text block in bytes.
+
+    @param desc The description dictionary, as for addScreenLabels:desc:mode:.
+
+    @param threadMode MaplyThreadAny is preferred and will use another thread, thus not blocking the one you're on.  MaplyThreadCurrent will make the changes immediately, blocking this thread.
+
+    @return Returns a MaplyComponentObject, which can be used to make modifications or delete the objects created.
+  */
+- (MaplyComponentObject *__nullable)addScreenLabelStructs:(const MaplyScreenLabelStruct *__nonnull)labels count:(NSUInteger)count
+                                                    text:(const char *__nonnull)text length:(NSUInteger)length desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode;
+
 /**
  Add one or more 3D labels to the current scene.
  
@@ -475,6 +518,7 @@ typedef NS_ENUM(NSInteger, MaplyRenderType) {
  |kMaplyShapeSampleX|NSNumber|Number of samples to use in one direction when converting to polygons.|
  |kMaplyShapeSampleY|NSNumber|Number of samples to use in the other direction when converting to polygons.|
  |kMaplyShapeInsideOut|NSNumber boolean|If set to YES, we'll make the spheres inside out and such.  Set to NO by default.|
+ |kMaplyShapeInstanced|NSNumber boolean|If set to YES, circles, spheres and cylinders are drawn as instances of a shared mesh, which is much faster for large numbers of them.  Set to NO by default.|
  |kMaplyMinVis|NSNumber|This is viewer height above the globe or map.  The shapes will only be visible if the user is above this height.  Off by default.|
  |kMaplyMaxVis|NSNumber|This is viewer height above the globe or map.  The shapes will only be visible if the user is below this height.  Off by default.|
  |kMaplyMinViewerDist|NSNumber|Minimum distance from the viewer at which to display object(s).|
@@ -598,6 +642,15 @@ typedef NS_ENUM(NSInteger, MaplyRenderType) {
  */
 - (void)changeParticleSystem:(MaplyComponentObject *__nonnull)compObj renderTarget:(MaplyRenderTarget *__nullable)target;
 
+/**
+    Change the textures for a particle system.
+
+    This swaps in new textures for an existing particle system, such as the next frame of a vector field the calculation shader follows.
+    Pass in MaplyTexture objects in the same order as the particle system's images.  You need to keep them around while they're in use.
+    This change takes place immediately, so call it on the main thread.
+ */
+- (void)changeParticleSystem:(MaplyComponentObject *__nonnull)compObj textures:(NSArray<MaplyTexture *> *__nonnull)textures;
+
 /**
     Add a batch of particles to the current scene.
     
@@ -622,6 +675,26 @@ typedef NS_ENUM(NSInteger, MaplyRenderType) {
  */
 - (void)changeVector:(MaplyComponentObject *__nonnull)compObj desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode;
 
+/**
+    Move a fleet of screen markers to new locations.
+
+    The markers must have been added with kMaplyMarkerFleet set.  Locations go with the markers in the order they were added.
+    Each marker heads for its new location over the given duration and keeps going at that speed until it's moved again,
+    so regular position updates come out smooth.  A duration of zero moves them straight there.
+
+    @param compObj The component object returned by addScreenMarkers:desc:.
+
+    @param locs New locations in geographic (radians), one per marker.
+
+    @param count Number of locations.
+
+    @param duration Time to get there, in seconds.
+
+    @param threadMode MaplyThreadAny will use another thread, thus not blocking the one you're on.  MaplyThreadCurrent will make the changes immediately, blocking this thread.
+  */
+- (void)moveScreenMarkers:(MaplyComponentObject *__nonnull)compObj locations:(const MaplyCoordinate *__nonnull)locs count:(int)count
+                 duration:(NSTimeInterval)duration mode:(MaplyThreadMode)threadMode;
+
 /**
  Adds the MaplyVectorObject's passed in as lofted polygons.
  
@@ -644,6 +717,7 @@ typedef NS_ENUM(NSInteger, MaplyRenderType) {
  |kMaplyLoftedPolyGridSize|NSNumber|The size of the grid (in degrees) we'll use to chop up the vector features to make them follow the sphere (for a globe).|
  |kMaplyLoftedPolyOutline|NSNumber boolean|If set to @(YES) this will draw an outline around the top of the lofted poly in lines.|
  |kMaplyLoftedPolyOutlineBottom|NSNumber boolean|If set to @(YES) this will draw an outline around the bottom of the lofted poly in lines.|
+ |kMaplyLoftedPolyMergeRoofs|NSNumber boolean|If set to @(YES) touching footprints are merged, so they share one roof and lose the walls between them.  Merged roofs aren't clipped to the grid.|
  |kMaplyLoftedPolyOutlineColor|UIColor|If the outline is one this is the outline's color.|
  |kMaplyLoftedPolyOutlineWidth|NSNumber|This is the outline's width if it's turned on.|
  |kMaplyLoftedPolyOutlineDrawPriority|NSNumber|Draw priority of the lines created for the lofted poly outline.|
@@ -799,6 +873,21 @@ typedef NS_ENUM(NSInteger, MaplyRenderType) {
  */
 - (void)stopMaskTarget;
 
+/**
+    Pick shapes by drawing their IDs into a render target.
+
+    Selectable shapes added after this go into a render target at the given fraction of the screen size (0.25 by default).
+    Picking them reads back the pixels around the touch, rather than testing each one's geometry.
+    This only applies to the Metal renderer.
+    Wide vectors and lofted polygons aren't drawn into the target.  They're still found with findVectorsInPoint:.
+ */
+- (void)startSelectionIDTarget:(NSNumber * __nullable)scale;
+
+/**
+    Go back to picking shapes by their geometry.
+ */
+- (void)stopSelectionIDTarget;
+
 /**
     Normally the layout layer runs periodically if you change something or when you move around.
     You can ask it to run ASAP right here.  Layout runs on its own thread, so there may still be a delay.
@@ -1013,4 +1102,19 @@ typedef NS_ENUM(NSInteger, MaplyRenderType) {
 /// Return the raw RGBA pixels from the rendered image rather than a UIImage
 - (NSData * __nullable)renderToImageData;
 
+/**
+    Draw until the loaders are done, or the timeout passes, then return the raw RGBA pixels.
+    
+    This is the one to use for static maps, where the tiles have to be there before we snapshot.
+  */
+- (NSData * __nullable)renderToImageDataWhenLoaded:(NSTimeInterval)timeout;
+
+/**
+    Draw until the loaders are done, then time a run of frames.
+    
+    Returns JSON with the time for each frame, summaries of the renderer's frame stats and the memory in use afterward.
+    Call it on the thread you render from.
+  */
+- (NSString * __nullable)runOfflineBenchmark:(int)frames settleTimeout:(NSTimeInterval)timeout;
+
 @end
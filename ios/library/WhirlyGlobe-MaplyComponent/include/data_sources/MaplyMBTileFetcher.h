@@ -37,6 +37,17 @@
 - (nullable instancetype)initWithMBTiles:(NSString *__nonnull)fileName
                                cacheSize:(int)cacheSize;
 
+/** Initialize with the name of the local MBTiles file, the cache size in bytes,
+    the number of reader connections and how much of the file sqlite may memory map.
+
+    Each reader can be working on a group of tiles at once.  The other initializers use 4.
+    An mmapSize of 0 leaves sqlite's default.  The cache size is per reader.
+  */
+- (nullable instancetype)initWithMBTiles:(NSString *__nonnull)fileName
+                               cacheSize:(int)cacheSize
+                              numReaders:(int)numReaders
+                                mmapSize:(int64_t)mmapSize;
+
 // Coordinate system (probably Spherical Mercator)
 - (MaplyCoordinateSystem * __nonnull)coordSys;
 
@@ -0,0 +1,87 @@
+/*  MaplyPMTilesFetcher.h
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting inc
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <WhirlyGlobe/MaplyTileSourceNew.h>
+#import <WhirlyGlobe/MaplySimpleTileFetcher.h>
+#import <WhirlyGlobe/MaplyCoordinateSystem.h>
+
+/**
+    PMTiles tile fetcher.
+ 
+    This tile fetcher reads tiles out of a single PMTiles archive, on a web server,
+    object storage or a local file.  You mate this with a QuadImageLoader or one of
+    the other loaders to do the actual work.
+ 
+    The archive's directories are kept once they're read.  Tiles asked for together
+    are read with as few range requests as we can manage, since neighboring tiles sit
+    next to each other in the archive.  All the requests go through one URL session,
+    so they share an HTTP/2 connection when the server has one.
+ 
+    Call start: and wait for it before setting up the loader, since the zoom levels
+    come from the archive.
+  */
+@interface MaplyPMTilesFetcher : NSObject<MaplyTileFetcher>
+
+/// Initialize with the URL of the archive.  File URLs work too.
+- (nullable instancetype)initWithURL:(NSURL *__nonnull)url name:(NSString *__nonnull)name;
+
+/// Read the header and root directory.  The callback is on the main queue.
+- (void)start:(void (^__nullable)(MaplyPMTilesFetcher *__nonnull fetcher,NSError *__nullable error))callback;
+
+/// Set once start: has succeeded
+@property (nonatomic,readonly) bool valid;
+
+/// Min zoom level, from the archive
+- (int)minZoom;
+
+/// Max zoom level, from the archive
+- (int)maxZoom;
+
+/// The loaders need a TileInfo object, even if it's very simple
+- (nullable NSObject<MaplyTileInfoNew> *)tileInfo;
+
+/// Coordinate system, which is always Spherical Mercator
+- (MaplyCoordinateSystem * __nonnull)coordSys;
+
+/// Area the archive covers
+@property (nonatomic,readonly) MaplyBoundingBox bounds;
+
+/// Tile format from the archive: pbf, png, jpg, webp or avif
+@property (nonatomic,readonly,nullable) NSString *format;
+
+/// Extra headers sent with every request
+@property (nonatomic,retain,nullable) NSDictionary *headers;
+
+/// Tiles closer together than this (in bytes) within the archive are read in the same request.  16k by default.
+@property (nonatomic,assign) NSUInteger maxGap;
+
+/// Longest a single request can get, in bytes.  1MB by default.
+@property (nonatomic,assign) NSUInteger maxRequestSize;
+
+/// Number of requests we'll have going at once
+@property (nonatomic) int numConnections;
+
+/// Set by default.  Tiles that aren't in the archive come back as empty rather than failing.
+@property (nonatomic,assign) bool neverFail;
+
+/// Timeout for each request, in seconds
+@property (nonatomic,assign) NSTimeInterval timeOut;
+
+/// If set, you get way too much debugging output
+@property (nonatomic,assign) bool debugMode;
+
+@end
@@ -0,0 +1,63 @@
+/*  MaplyElevationInterpreter.h
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <WhirlyGlobe/MaplyQuadLoader.h>
+
+/// How heights are packed into the pixels of an elevation tile
+typedef NS_ENUM(NSInteger, MaplyElevationEncoding) {
+    /// (R * 256 + G + B / 256) - 32768
+    MaplyElevationTerrarium,
+    /// -10000 + (R * 65536 + G * 256 + B) * 0.1
+    MaplyElevationMapboxRGB
+};
+
+/**
+ Reads elevation tiles as they come in and keeps them for height queries.
+
+ Hand this to a MaplyQuadPagingLoader pointed at PNG elevation tiles.
+ Nothing is displayed.  The heights are kept, most detailed tile first, and used by
+ tiles with includeElev set in their sampling params, by markers with kMaplyMarkerClampToGround,
+ and for finding where a tap hits the terrain.
+ <br>
+ There's one set of heights per view controller, so use one of these at a time.
+ */
+@interface MaplyElevationInterpreter : NSObject<MaplyLoaderInterpreter>
+
+/// Initialize with the view controller to keep the heights for and how the tiles are packed
+- (nonnull instancetype)initWithViewC:(NSObject<MaplyRenderControllerProtocol> * __nonnull)viewC
+                             encoding:(MaplyElevationEncoding)encoding;
+
+/// Most memory to spend on elevation tiles.  64MB by default.
+@property (nonatomic,assign) size_t maxBytes;
+
+/**
+ Look up heights for a batch of coordinates.
+
+ @param coords Geographic coordinates in radians.
+
+ @param heights Filled in with heights in meters.  0 where there's no elevation loaded.
+
+ @param count Number of coordinates.
+
+ @return The number of coordinates that had elevation loaded for them.
+ */
+- (int)heightsForCoords:(const MaplyCoordinate * __nonnull)coords heights:(double * __nonnull)heights count:(int)count;
+
+/// Height in meters for one coordinate in radians.  0 where there's no elevation loaded.
+- (double)heightForCoord:(MaplyCoordinate)coord;
+
+@end
@@ -0,0 +1,57 @@
+/*  MaplyMultiResTileInfo.h
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <WhirlyGlobe/MaplyRemoteTileFetcher.h>
+#import <WhirlyGlobe/MaplyQuadLoader.h>
+
+/**
+ Picks between versions of the same tile source depending on how fast the network is.
+
+ Add the variants best first, say @2x tiles, then @1x tiles, then @1x tiles with a lower max zoom, each with the throughput it needs.
+ New tiles come from the best variant the fetcher's throughput will support, or the last one until that's been measured.
+ Tiles past a variant's max zoom are skipped while it's in use, leaving their parents in place.
+ <br>
+ When the throughput stays up long enough for a better variant, we switch to it and, if there's a loader, ask it to reload.
+ The tiles we already have stay up until the better ones replace them.
+ Going down happens right away, for new tiles only.
+ <br>
+ Give each variant its own cache directory, since cache files are named by tile.
+ */
+@interface MaplyMultiResTileInfo : NSObject<MaplyTileInfoNew>
+
+/// Initialize with the fetcher the loader uses, which measures the throughput
+- (nonnull instancetype)initWithFetcher:(MaplyRemoteTileFetcher *__nonnull)fetcher;
+
+/**
+ Add a version of the tiles.
+
+ @param tileInfo Where this version's tiles come from.
+
+ @param minThroughput The throughput, in bytes per second, needed to use this version.  The last one is used when nothing else fits, so its value doesn't matter.
+ */
+- (void)addVariant:(MaplyRemoteTileInfoNew *__nonnull)tileInfo minThroughput:(double)minThroughput;
+
+/// Which of the variants new tiles are coming from
+@property (nonatomic,readonly) int currentVariant;
+
+/// Set this to the loader using us, so it can be told to reload with better tiles
+@property (nonatomic,weak,nullable) MaplyQuadLoaderBase *loader;
+
+/// How long, in seconds, the throughput has to stay up before we switch to a better variant.  10s by default.
+@property (nonatomic,assign) NSTimeInterval upgradeDelay;
+
+@end
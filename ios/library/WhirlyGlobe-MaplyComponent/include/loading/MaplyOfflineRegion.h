@@ -0,0 +1,96 @@
+/*  MaplyOfflineRegion.h
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <WhirlyGlobe/MaplyRemoteTileFetcher.h>
+
+@class MaplyOfflineRegion;
+
+/// Called as tiles come in and once more when the download is done
+typedef void (^MaplyOfflineRegionProgress)(MaplyOfflineRegion * __nonnull region);
+
+/**
+ Downloads all the tiles for an area ahead of time, so it can be used without a network.
+
+ Give it the tile info loaders use and the fetcher they use.  Every tile in the bounding box between the zoom levels goes through the fetcher into the tile info's cache directory.
+ After that, loaders find the tiles there rather than fetching them.
+ <br>
+ Turn on packedCache for the fetcher, so a big region is a few pack files rather than a file per tile.
+ Leave cacheSizeLimit and cacheLifetime off for that directory, or the region will be dropped along with older tiles.
+ <br>
+ Tiles already in the cache are skipped, so starting a stopped or interrupted download again picks up where it left off.
+ */
+@interface MaplyOfflineRegion : NSObject
+
+/**
+ Set up for a download.
+
+ @param tileInfo Where the tiles come from.  It needs a cacheDir.
+
+ @param fetcher Fetcher to download with.
+
+ @param bbox Area to download, in geographic radians.
+
+ @param minZoom Top level to download.
+
+ @param maxZoom Bottom level to download.
+ */
+- (nonnull instancetype)initWithTileInfo:(MaplyRemoteTileInfoNew * __nonnull)tileInfo
+                                 fetcher:(MaplyRemoteTileFetcher * __nonnull)fetcher
+                                    bbox:(MaplyBoundingBoxD)bbox
+                                 minZoom:(int)minZoom
+                                 maxZoom:(int)maxZoom;
+
+/// Most tiles to have in the fetcher at once.  8 by default.
+@property (nonatomic,assign) int maxConcurrent;
+
+/// Priority for the fetches.  Less is more important.  100 by default, which puts them behind what the loaders want.
+@property (nonatomic,assign) int priority;
+
+/// Match this to the loaders.  True by default, as for them.
+@property (nonatomic,assign) bool flipY;
+
+/// Tiles in the region, from all the levels
+@property (nonatomic,readonly) int64_t numTiles;
+
+/// Tiles we downloaded
+@property (nonatomic,readonly) int64_t tilesFetched;
+
+/// Tiles that were already cached, or outside the tile info's valid bounds
+@property (nonatomic,readonly) int64_t tilesSkipped;
+
+/// Tiles that failed to download
+@property (nonatomic,readonly) int64_t tilesFailed;
+
+/// Bytes downloaded
+@property (nonatomic,readonly) int64_t bytesFetched;
+
+/// True while the download is going
+@property (nonatomic,readonly) bool running;
+
+/// Called on the main thread, at most every progressInterval seconds, and when the download finishes
+@property (nonatomic,copy,nullable) MaplyOfflineRegionProgress progress;
+
+/// How often progress is called, in seconds.  0.5s by default.
+@property (nonatomic,assign) NSTimeInterval progressInterval;
+
+/// Start downloading, or start again after a stop.  The counts start over.
+- (void)start;
+
+/// Stop downloading.  Tiles on their way in are cancelled.
+- (void)stop;
+
+@end
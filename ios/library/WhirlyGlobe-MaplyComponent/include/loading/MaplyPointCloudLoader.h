@@ -0,0 +1,135 @@
+/*  MaplyPointCloudLoader.h
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <WhirlyGlobe/MaplyControllerLayer.h>
+#import <WhirlyGlobe/MaplyCoordinate.h>
+#import <WhirlyGlobe/MaplyRenderController.h>
+
+/// A node in a point cloud octree.  Level 0 is the whole cloud, and x, y and z run from 0 to 2^level-1.
+typedef struct
+{
+    int x,y,z;
+    int level;
+} MaplyOctreeID;
+
+/**
+    The points for one octree node.
+
+    Your source fills one of these in for each node it's asked for.  Positions are in display coordinates and
+    are quantized to 16 bits per axis within the node's box, so they take much less memory than a MaplyPoints would.
+  */
+@interface MaplyPointCloudChunk : NSObject
+
+/// Set up for the given node.  Get the box from the loader.
+- (nonnull instancetype)initWithLL:(MaplyCoordinate3dD)ll ur:(MaplyCoordinate3dD)ur;
+
+/// Add a point in display coordinates.  It's clamped to the node's box.
+- (void)addDispCoordX:(double)x y:(double)y z:(double)z;
+
+/// Add a color for the point just added.  Colors are optional, but if you add any, add one for every point.
+- (void)addColorR:(float)r g:(float)g b:(float)b a:(float)a;
+
+/**
+    Which of the node's children exist, one bit per child.
+
+    Bit 0 of the child number picks x, bit 1 y and bit 2 z.  All eight by default.
+    Clear the bits for empty children and the loader won't ask for them.
+  */
+@property (nonatomic) uint8_t childMask;
+
+/// Number of points added so far
+@property (nonatomic,readonly) int numPoints;
+
+@end
+
+@class MaplyPointCloudLoader;
+
+/**
+    Provides point cloud nodes to a MaplyPointCloudLoader.
+
+    Each node should hold a subsample of the points under it, getting denser as the levels go down.
+    Nodes are shown along with their parents rather than in place of them.
+  */
+@protocol MaplyPointCloudSource <NSObject>
+
+/**
+    Start loading a node.
+
+    This is called on the layer thread, so do the real work somewhere else.  When you're done, hand
+    the points back with loadedChunk:forNode: or call failedNode: from whatever thread you're on.
+  */
+- (void)pointCloudLoader:(MaplyPointCloudLoader *__nonnull)loader startFetch:(MaplyOctreeID)node;
+
+@optional
+
+/// The loader doesn't want the node anymore.  Anything handed back for it is ignored.
+- (void)pointCloudLoader:(MaplyPointCloudLoader *__nonnull)loader cancelFetch:(MaplyOctreeID)node;
+
+@end
+
+/**
+    Pages a large point cloud in and out by octree node.
+
+    This is for point clouds too big to add all at once with addPoints:.  Starting from the root, the loader
+    works out which nodes are on screen and how close their points would be, and refines until they'd be
+    pixelSpacing apart.  It only asks your source for the nodes it needs, the most visible first.
+
+    Nodes that go off screen are hidden and kept around.  When the loader is over its memory budget (or the shared
+    tile budget) the least recently used of those lose their geometry and then their points.
+
+    Create one, set it up and hand it to addLayer:.
+  */
+@interface MaplyPointCloudLoader : MaplyControllerLayer
+
+/**
+    Set up the loader for a point cloud.
+
+    @param ll Lower left of the root node in display coordinates.
+    @param ur Upper right of the root node in display coordinates.
+    @param maxLevel The deepest level the octree goes.
+    @param rootSpacing Typical distance between points in the root node, in display units.  It halves with each level down.
+    @param source Your source for the octree nodes.
+    @param desc Point settings, such as kMaplyPointSize, kMaplyShader, kMaplyDrawPriority and so on.  The same as addPoints:desc:mode: takes.
+  */
+- (nonnull instancetype)initWithLL:(MaplyCoordinate3dD)ll ur:(MaplyCoordinate3dD)ur maxLevel:(int)maxLevel rootSpacing:(double)rootSpacing source:(NSObject<MaplyPointCloudSource> *__nonnull)source desc:(NSDictionary *__nullable)desc;
+
+/// How far apart points should get on screen before we stop loading more detail.  2 pixels by default.
+@property (nonatomic) double pixelSpacing;
+
+/// Bytes we'll hold for points and geometry.  256MB by default.
+@property (nonatomic) size_t memoryBudget;
+
+/// Most fetches we'll have going at once.  8 by default.
+@property (nonatomic) int maxFetches;
+
+/// Box for the given node, in display coordinates
+- (void)boundsForNode:(MaplyOctreeID)node ll:(MaplyCoordinate3dD *__nonnull)ll ur:(MaplyCoordinate3dD *__nonnull)ur;
+
+/// Hand back the points for a node.  Call from any thread.
+- (void)loadedChunk:(MaplyPointCloudChunk *__nonnull)chunk forNode:(MaplyOctreeID)node;
+
+/// The node couldn't be loaded.  Call from any thread.
+- (void)failedNode:(MaplyOctreeID)node;
+
+/// Number of nodes loaded right now
+@property (nonatomic,readonly) int numLoadedNodes;
+
+/// Number of points being displayed right now
+@property (nonatomic,readonly) size_t numDisplayedPoints;
+
+@end
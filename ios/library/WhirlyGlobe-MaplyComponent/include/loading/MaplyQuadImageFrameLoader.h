@@ -19,6 +19,7 @@
 
 #import <WhirlyGlobe/MaplyQuadImageLoader.h>
 #import <WhirlyGlobe/MaplyActiveObject.h>
+#import <WhirlyGlobe/MaplyElevationInterpreter.h>
 
 @class MaplyQuadImageFrameLoader;
 
@@ -55,6 +56,12 @@
 /// Number of tiles this frame has yet to load
 @property (nonatomic) int tilesToLoad;
 
+/// Number of tiles that have this frame loaded
+@property (nonatomic) int tilesLoaded;
+
+/// Set if the frame is inside the frame window, or there isn't one
+@property (nonatomic) bool resident;
+
 @end
 
 /**
@@ -65,6 +72,12 @@
 /// Total number of tiles managed by the loader
 @property (nonatomic) int numTiles;
 
+/// Texture memory for all the frames the loader has loaded, in bytes
+@property (nonatomic) size_t texBytes;
+
+/// Tiles holding at least one texture
+@property (nonatomic) int numTexTiles;
+
 /// Per frame stats for current loading state
 @property (nonatomic,nonnull) NSArray<MaplyQuadImageFrameStats *> *frames;
 
@@ -98,6 +111,34 @@ typedef NS_ENUM(NSInteger, MaplyLoadFrameMode) {
 /// How frames are loaded (top down vs broad)
 @property (nonatomic,assign) MaplyLoadFrameMode loadFrameMode;
 
+/**
+  Number of frames to keep loaded around the current image.
+ 
+  If set, only this many frames are kept in memory, most of them ahead of the current image in the direction the animation is running.  Frames are loaded as they come into that window and unloaded as they leave it.  Useful for long animations.  0, the default, keeps all the frames.
+  */
+@property (nonatomic,assign) int frameWindow;
+
+/**
+  Draw all the frames at once, each blended over the ones before, rather than animating between them.
+ 
+  Use this for stacked layers, such as a basemap, a hillshade and an overlay.  They share one set of tile geometry and are drawn in a single pass, which cuts down on overdraw and draw calls.  Up to four frames are composited and all of them are loaded.  Set this before the loader starts.
+  */
+@property (nonatomic,assign) bool compositeFrames;
+
+/**
+  Use the second tile source as elevation for the first, rather than as another frame.
+ 
+  Give the loader two tile infos, the imagery and then elevation tiles with the same layout.  Each tile is raised in the vertex shader by the heights in its elevation image, so terrain costs nothing extra to build and the tile geometry can still be shared.  Skirts are built to hide the seams, on flat maps as well.  Turn up tessX and tessY in the sampling params for more detail.  Set this before the loader starts.
+
+  @param encoding How the heights are packed into the elevation images.
+
+  @param exaggeration Scale for the heights.  1.0 is true to life.
+  */
+- (void)setTerrainWithEncoding:(MaplyElevationEncoding)encoding exaggeration:(double)exaggeration;
+
+/// Set if the second tile source is elevation for the first
+@property (nonatomic,readonly) bool terrain;
+
 /**
   Add another rendering focus to the frame loader.
  
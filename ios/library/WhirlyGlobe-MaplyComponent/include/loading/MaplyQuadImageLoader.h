@@ -78,6 +78,15 @@
  This is the default interpreter used by the MaplyQuadImageLoader.
  */
 @interface MaplyImageLoaderInterpreter : NSObject<MaplyLoaderInterpreter>
+
+/**
+ If set, images bigger than this on a side are scaled down as they're decoded.
+ 
+ Decoding at the smaller size is a good deal faster and uses less memory.  Use it when the tiles
+ are bigger than they'll ever be displayed.  Defaults to 0, which is full size.
+ */
+@property (nonatomic,assign) int maxDecodeSize;
+
 @end
 
 /**
@@ -115,6 +124,45 @@
 /// Name of the shared MaplyRemoteTileFetcher
 extern NSString * _Nonnull const MaplyQuadImageLoaderFetcherName;
 
+/**
+ How to draw single channel data tiles, such as elevation or temperature.
+
+ Hand one of these to a loader's dataTileStyle and the tiles are uploaded as the raw values, then colored, thresholded and hillshaded on the GPU.  Change the style and set it again to change the look.  Nothing is reloaded or uploaded again, other than a new ramp.
+ */
+@interface MaplyDataTileStyle : NSObject
+
+/// Color ramp image, run left to right from minValue to maxValue.  MaplyColorRampGenerator can make one.  Without it, we use gray.
+@property (nonatomic,retain,nullable) UIImage *colorRamp;
+
+/// Data value at the left of the ramp.  0 by default.
+@property (nonatomic,assign) float minValue;
+
+/// Data value at the right of the ramp.  1 by default.
+@property (nonatomic,assign) float maxValue;
+
+/// Values below this are left clear.  No limit by default.
+@property (nonatomic,assign) float lowThreshold;
+
+/// Values above this are left clear.  No limit by default.
+@property (nonatomic,assign) float highThreshold;
+
+/// Pixels with exactly this value are left clear.  NaN, the default, turns this off.
+@property (nonatomic,assign) float noDataValue;
+
+/// How much hillshading to mix in, from 0 (none, the default) to 1.
+@property (nonatomic,assign) float hillshade;
+
+/// Scale from data units across one texel to a slope, for the hillshade.  1 by default.  Turn it up for flat looking data.
+@property (nonatomic,assign) float hillshadeScale;
+
+/// Direction the light comes from, in degrees clockwise from north.  315 by default.
+@property (nonatomic,assign) float lightAzimuth;
+
+/// Height of the light above the horizon, in degrees.  45 by default.
+@property (nonatomic,assign) float lightAltitude;
+
+@end
+
 /**
   Base object for Maply Quad Image loader.
  
@@ -189,6 +237,36 @@ extern NSString * _Nonnull const MaplyQuadImageLoaderFetcherName;
  */
 @property (nonatomic) MaplyQuadImageFormat imageFormat;
 
+/**
+ Stage tile images off the render thread.
+ 
+ If set, image data is copied to staging memory on the loader's thread and the renderer copies it into the texture as part of the next frame.  Off by default.
+ */
+@property (nonatomic) bool asyncTextureUpload;
+
+/**
+ Draw loading tiles with a piece of their parent's image.
+ 
+ If set, a tile that hasn't arrived yet is drawn with the part of the nearest loaded ancestor's image that covers it, even when the levels in between are missing.  Tiles whose parents are still loading are fetched after everything else.  Helps with blank tiles during fast zooms.  Off by default, unless the controller is set for fastStartup and this is left alone.
+ */
+@property (nonatomic) bool parentPlaceholders;
+
+/**
+ Warp images from other coordinate systems on the GPU.
+ 
+ For tile sources in a coordinate system other than the display's, such as a Proj4 or British National Grid source on a spherical mercator map or globe.  If set, each image is drawn once into a new texture through a mesh with this many samples on a side, lining it up with the tile geometry.  The tile geometry can then be sampled much more lightly, with smaller tessX and tessY in MaplySamplingParams.  0, the default, turns this off.
+ */
+@property (nonatomic) int reprojectSamples;
+
+/**
+ Draw the tiles as data rather than imagery.  Metal only.
+
+ Tiles should be single channel, so set imageFormat to MaplyImageSingleFloat16 (filtered on all devices) or MaplyImageSingleFloat32 and hand back raw values with MaplyImageTile's initWithRawImage:format:width:height:viewC:.  The values are colored through the style's ramp in a shared shader, so there's no work on the CPU per tile.  Frames are blended as values, before coloring.
+
+ Set this before the loader starts to turn data tiles on.  Set it again any time after to change the look right away.  This replaces the default shader, but not one you've set yourself.
+ */
+@property (nonatomic,retain,nullable) MaplyDataTileStyle *dataTileStyle;
+
 @end
 
 /**
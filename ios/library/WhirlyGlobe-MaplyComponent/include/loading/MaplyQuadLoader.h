@@ -125,9 +125,41 @@ typedef void (__strong ^InitCompletionBlock)(void);
 /// This is really just a limit on the number of tiles we'lll parse concurrently to keep memory use under control
 @property (nonatomic) unsigned int numSimultaneousTiles;
 
+/**
+ Parse tiles for all loaders on a shared set of threads.
+ 
+ With this on, loaders that don't have their own queue hand their parsing to a
+ shared pool, most important tiles first, rather than to a dispatch queue each.
+ That keeps the total work bounded no matter how many loaders there are.
+ 0, the default, turns it off.
+ */
++ (void)setSharedTaskThreads:(int)numThreads;
++ (int)sharedTaskThreads;
+
 // True if the loader is not currently loading anything
 - (bool)isLoading;
 
+/**
+ Turn on/off per-tile latency tracking.
+ 
+ When on, each tile is timed from the fetch request, through the data coming back, the
+ interpreter finishing and the results being merged, to the renderer applying the changes
+ for the frame that draws them.  Off by default.
+ */
+@property (nonatomic,assign) bool tileLatencyEnabled;
+
+/**
+ Summarize the recorded tile latencies.
+ 
+ Returns a dictionary keyed by "fetch", "decode", "merge", "display" and "total".
+ Each entry covers the time from the stage before and has "count", "min", "max", "mean", "p50" and "p95", in seconds.
+ Returns nil if tracking isn't on.
+ */
+- (NSDictionary<NSString *,NSDictionary<NSString *,NSNumber *> *> * __nullable)tileLatencyStats;
+
+/// Discard the recorded tile latencies
+- (void)clearTileLatencyStats;
+
 /**
  Calculate the bounding box for a single tile in geographic.
  
@@ -230,6 +262,17 @@ typedef void (__strong ^InitCompletionBlock)(void);
   */
 - (void)reloadAreas:(NSArray<NSValue*>* __nullable)bounds;
 
+/**
+  Reload over the tiles currently showing, rather than clearing them.
+  <br>
+  With this on, a reload only touches the tiles in the areas given.  They keep showing what they have
+  until their new data is parsed, then the textures are swapped in one go.  Tiles whose data comes back
+  the same as before aren't parsed again.  Failed loads leave the old data up.
+  <br>
+  This is meant for live data that's refreshed often.  Off by default.
+  */
+@property (nonatomic,assign) bool reloadInPlace;
+
 /** Turn off the loader and shut things down.
  This unregisters us with the sampling layer and shuts down the various objects we created.
  */
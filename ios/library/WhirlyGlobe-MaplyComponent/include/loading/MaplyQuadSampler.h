@@ -62,6 +62,18 @@
 /// If set, generate skirt geometry to hide the edges between levels
 @property (nonatomic) bool edgeMatching;
 
+/// If set, tiles on a flat map are built from one precomputed grid and sized by their transform.
+/// Quicker to build each tile.  Has no effect on the globe.  Off by default.
+@property (nonatomic) bool meshTemplates;
+
+/// If set, tiles on the globe are raised to the heights loaded through a MaplyElevationInterpreter.
+/// Tiles built before their heights arrive stay flat.  Off by default.
+@property (nonatomic) bool includeElev;
+
+/// If set, tiles are raised in the shader from elevation textures.  A terrain MaplyQuadImageFrameLoader turns this on.
+/// Flat maps get skirts as well.  Off by default.
+@property (nonatomic) bool elevTextures;
+
 /// Tesselation values per level for breaking down the coordinate system (e.g. globe)
 @property (nonatomic) int tessX,tessY;
 
@@ -79,6 +91,18 @@
 /// If set, we'll try to load a single level
 @property (nonatomic) bool singleLevel;
 
+/// If set, tile importance from earlier view updates is reused where the view hasn't moved enough to matter.
+/// Cheaper while panning, but the ordering of tiles is approximate.  Off by default.
+@property (nonatomic) bool incrementalCoverage;
+
+/// If set, while a momentum animation is running we fetch ahead for the tiles where it's going to end up.
+/// Those fetches are low priority and just warm up the tile fetcher's cache.  Off by default.
+@property (nonatomic) bool predictivePrefetch;
+
+/// Memory, in bytes, used to keep the tile volumes we evaluate against the view.
+/// Those don't change as the view moves, so keeping them saves work.  2MB by default, 0 turns it off.
+@property (nonatomic) int displaySolidCacheSize;
+
 /// If set, the tiles are clipped to this boundary
 @property (nonatomic) MaplyBoundingBoxD clipBounds;
 @property (nonatomic,readonly) bool hasClipBounds;
@@ -100,4 +124,14 @@
 /// Decide if these sampling params are the same as others
 - (bool)isEqualTo:(MaplySamplingParams *__nonnull)other;
 
+/**
+ Set a memory budget for tile textures and geometry, shared by all the samplers.
+ 
+ When everything the samplers want won't fit in the budget, the least important tiles are left out, whichever layer they belong to.  0, the default, means no budget.
+ */
++ (void)setTileMemoryBudget:(size_t)bytes;
+
+/// The shared memory budget for tiles, in bytes.  0 if there isn't one.
++ (size_t)tileMemoryBudget;
+
 @end
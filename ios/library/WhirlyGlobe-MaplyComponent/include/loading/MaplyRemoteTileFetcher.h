@@ -171,6 +171,27 @@
 /// Number of outstanding connections in parallel
 @property (nonatomic) int numConnections;
 
+/**
+ Work out how many of the connections each host should get.
+ 
+ We keep track of how fast each host answers and how much data we get back from it.  When more connections aren't getting more data, the requests are just waiting at the server, so that host gets fewer and the other requests go first.  Timeouts and overloaded responses cut a host back right away.  No host gets more than numConnections.  On by default.
+ */
+@property (nonatomic,assign) bool adaptiveConnections;
+
+/**
+ Read cached tiles as soon as they're asked for.
+ 
+ Tiles in the memory or disk caches normally take up a connection while they're read, so they wait behind the network fetches.  With this on, they're read right away and only network fetches count against numConnections.  Controllers set for fast startup turn it on for the fetchers they make.  Off by default.
+ */
+@property (nonatomic,assign) bool immediateCacheReads;
+
+/**
+ How fast remote data has been coming in lately, in bytes per second.
+ 
+ This is what all the connections to all the hosts have been getting together, worked out the same way as for adaptiveConnections.  It's 0 until enough tiles have come back to tell.
+ */
+@property (nonatomic,readonly) double throughput;
+
 /// Local storage is for pre-downloaded tiles, rather than a cache.  This is consulted *before* we go out to the network.
 /// If it fails, then we hit the local file cache and then we hit the network
 - (void)setLocalStorage:(NSObject<MaplyTileLocalStorage> * __nullable)localStorage;
@@ -179,6 +200,9 @@
 /// Useful if you've got an old version of the tile lying around you might use in a pinch
 - (void)setSecondChance:(NSObject<MaplyTileSecondChance> * __nullable)secondChance;
 
+/// True if the fetch info's tile is already in the cache directory, or the packed cache if that's on
+- (bool)isCached:(MaplyRemoteTileFetchInfo * __nonnull)fetchInfo;
+
 /// Return the fetching stats since the beginning or since the last reset
 - (MaplyRemoteTileFetcherStats * __nullable)getStats:(bool)allTime;
 
@@ -197,6 +221,28 @@
 // If set, you get way too much debugging output
 @property (nonatomic,assign) bool debugMode;
 
+/**
+ Keep cached tiles in a few pack files rather than a file per tile.
+ 
+ Tiles still go in the cache directory from the tile info, but they're appended to pack files with an index next to them.
+ This is much faster once there are a lot of tiles and it's what makes the size and lifetime limits work.
+ Loose tile files already in the cache directory are ignored when this is on.  Off by default.
+ */
+@property (nonatomic,assign) bool packedCache;
+
+/// With packedCache on, the most space (in bytes) to use in each cache directory.  0, the default, is no limit.
+@property (nonatomic,assign) NSUInteger cacheSizeLimit;
+
+/// With packedCache on, cached tiles older than this (in seconds) are fetched again.  0, the default, keeps them forever.
+@property (nonatomic,assign) NSTimeInterval cacheLifetime;
+
+/**
+ Bytes of recently fetched tile data to keep in memory.
+ 
+ Tiles asked for again soon after they were fetched, as happens when panning back and forth, come from here rather than the cache directory or the network.  16MB by default, 0 turns it off.
+ */
+@property (nonatomic,assign) NSUInteger memoryCacheSize;
+
 @end
 
 /// Stats collected by the fetcher
@@ -61,6 +61,26 @@
   */
 - (id __nullable)dataForTile:(id __nonnull)fetchInfo tileID:(MaplyTileID)tileID;
 
+/** Number of reads that can go at once.  Defaults to 1, which reads on the dispatch queue.
+ 
+    Anything more and reads happen on background queues, so only set this if your
+    dataForTiles:tileIDs: can handle being called from several threads.
+  */
+@property (nonatomic) int maxConcurrentReads;
+
+/** Most tiles we'll pass to a single dataForTiles:tileIDs: call.  Defaults to 1.
+ 
+    They'll all be from the same level.
+  */
+@property (nonatomic) int maxTilesPerRead;
+
+/** Override dataForTiles:tileIDs: to read several tiles at once.
+ 
+    Return an array of the same length with NSNull for the tiles you don't have.
+    The default calls dataForTile:tileID: for each one.
+  */
+- (NSArray * __nonnull)dataForTiles:(NSArray * __nonnull)fetchInfos tileIDs:(const MaplyTileID * __nonnull)tileIDs;
+
 /** Override the shutdown method.
  
     Call the superclass shutdown method *first* and then run your own shutdown.
@@ -0,0 +1,60 @@
+/*  MaplyVectorTiler.h
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <WhirlyGlobe/MaplyQuadPagingLoader.h>
+#import <WhirlyGlobe/MaplyVectorObject.h>
+#import <WhirlyGlobe/MaplyVectorStyle.h>
+
+/**
+ Cuts a big set of vectors up into tiles for a MaplyQuadPagingLoader.
+ 
+ Adding a large data set all at once makes huge drawables that get drawn at every zoom level.
+ Instead, hand the vectors to one of these, and it'll clip them into Spherical Mercator tiles
+ and simplify them for each level, in the manner of geojson-vt, and build just the tiles the
+ paging loader asks for with the given styles.
+ <br>
+ Hand the tiler's tileInfo and the tiler itself (as the interpreter) to the paging loader.
+ Nothing gets fetched.
+ */
+@interface MaplyVectorTiler : NSObject<MaplyLoaderInterpreter>
+
+/// Initialize with the styles to build tiles with and the controller to add them to
+- (nonnull instancetype)initWithStyle:(NSObject<MaplyVectorStyleDelegate> *__nonnull)styleDelegate
+                                viewC:(NSObject<MaplyRenderControllerProtocol> *__nonnull)viewC;
+
+/// Deepest level we'll make tiles for.  14 by default.  Set the tiler up before adding vectors.
+@property (nonatomic) int maxZoom;
+
+/// Levels we cut everything down to up front.  Deeper tiles are cut when they're needed.  5 by default.
+@property (nonatomic) int indexMaxZoom;
+
+/// Tiles with fewer points than this aren't cut up front.  100000 by default.
+@property (nonatomic) int indexMaxPoints;
+
+/// How far simplified lines can stray, in pixels.  3 by default.
+@property (nonatomic) double tolerance;
+
+/// Extra around the edge of each tile to clip to, in pixels.  16 by default.
+@property (nonatomic) double buffer;
+
+/// Add vectors to the data set.  Do this before starting the loader.
+- (void)addVectors:(NSArray<MaplyVectorObject *> *__nonnull)vecObjs;
+
+/// Tile info for the paging loader, covering level 0 to maxZoom
+- (NSObject<MaplyTileInfoNew> *__nonnull)tileInfo;
+
+@end
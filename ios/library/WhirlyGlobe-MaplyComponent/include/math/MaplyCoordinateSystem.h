@@ -164,6 +164,14 @@
 /// True if the proj.4 string was valid and the coordinate system can work.
 - (bool)valid;
 
+/**
+    Approximate conversions from local coordinates with a grid over the bounds.
+
+    The grid is sampled through proj.4 once.  After that, batch conversions, like the ones used for tile corners, interpolate within it.
+    Set the bounds first.  Finer grids are closer.  Pass 0 to go back to exact conversions.
+  */
+- (void)setApproxGridCellsX:(int)cellsX cellsY:(int)cellsY;
+
 @end
 
 /** 
@@ -0,0 +1,88 @@
+/*  MBTilesReader.h
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import <condition_variable>
+#import <memory>
+#import <mutex>
+#import <string>
+#import <vector>
+#import "sqlite3.h"
+#import "sqlhelpers.h"
+#import <WhirlyGlobe/MaplyTileSourceNew.h>
+
+namespace WhirlyKit
+{
+
+/** Reads tiles out of an MBTiles file from several threads at once.
+    Each thread borrows one of a small pool of read-only connections, each with its
+    statements prepared up front.  Files in WAL mode are opened normally, which lets
+    the readers work alongside each other.  Anything else is opened as immutable,
+    which skips the file locking entirely.  Don't use that on a file being written.
+  */
+class MBTilesReader
+{
+public:
+    /// Open the given file with this many connections.  mmapSize, in bytes, is passed
+    /// on to sqlite if it's set, as is the cache size.
+    MBTilesReader(const std::string &path,int numReaders,int64_t mmapSize,int cacheSize);
+    ~MBTilesReader();
+
+    /// False if we couldn't open the file or it doesn't have the tiles table
+    bool isValid() const { return !readers.empty(); }
+
+    /// Number of connections, which is how many reads can go at once
+    int getNumReaders() const { return (int)readers.size(); }
+
+    /// Data for a single tile, nil if it's not there.  y is in the file's (TMS) order.
+    NSData *readTile(int x,int y,int level);
+
+    /// Data for a group of tiles, nil where one is missing.
+    /// Tiles on the same level that sit close together are read in one query.
+    std::vector<NSData *> readTiles(const std::vector<MaplyTileID> &tileIDs);
+
+protected:
+    struct Reader
+    {
+        ~Reader();
+        sqlite3 *db = nullptr;
+        std::unique_ptr<sqlhelpers::StatementRead> tileStmt;
+        std::unique_ptr<sqlhelpers::StatementRead> rangeStmt;
+    };
+    typedef std::shared_ptr<Reader> ReaderRef;
+
+    // Open a connection and prepare its statements
+    ReaderRef openReader(const std::string &uri,int flags,int64_t mmapSize,int cacheSize);
+
+    // Wait for a free connection to use, then give it back
+    ReaderRef takeReader();
+    void returnReader(const ReaderRef &reader);
+
+    // Read the tiles in the given range of columns and rows, filling in the ones we want
+    void readRange(Reader &reader,int level,int minX,int minY,int maxX,int maxY,
+                   const std::vector<MaplyTileID> &tileIDs,const std::vector<int> &which,
+                   std::vector<NSData *> &results);
+
+    std::vector<ReaderRef> readers;
+
+    std::mutex lock;
+    std::condition_variable freeCond;
+    std::vector<ReaderRef> freeReaders;
+};
+typedef std::shared_ptr<MBTilesReader> MBTilesReaderRef;
+
+}
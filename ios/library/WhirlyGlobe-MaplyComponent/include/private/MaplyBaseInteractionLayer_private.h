@@ -75,6 +75,10 @@
 // Add screen space (2D) markers
 - (MaplyComponentObject *__nullable)addScreenMarkers:(NSArray * __nonnull)markers desc:(NSDictionary * __nullable)desc mode:(MaplyThreadMode)threadMode;
 
+// Add screen space (2D) markers from packed structs
+- (MaplyComponentObject *__nullable)addScreenMarkerStructs:(const MaplyScreenMarkerStruct *__nonnull)markers count:(NSUInteger)count
+                                                 textures:(NSArray<MaplyTexture *> *__nullable)textures desc:(NSDictionary * __nullable)desc mode:(MaplyThreadMode)threadMode;
+
 // Add a marker cluster generator
 - (void)addClusterGenerator:(NSObject <MaplyClusterGenerator> *__nonnull)clusterGen;
 
@@ -84,6 +88,10 @@
 // Add screen space (2D) labels
 - (MaplyComponentObject *__nullable)addScreenLabels:(NSArray *__nonnull)labels desc:(NSDictionary * __nullable)desc mode:(MaplyThreadMode)threadMode;
 
+// Add screen space (2D) labels from packed structs and one block of text
+- (MaplyComponentObject *__nullable)addScreenLabelStructs:(const MaplyScreenLabelStruct *__nonnull)labels count:(NSUInteger)count
+                                                    text:(const char *__nonnull)text length:(NSUInteger)length desc:(NSDictionary * __nullable)desc mode:(MaplyThreadMode)threadMode;
+
 // Add 3D labels
 - (MaplyComponentObject *__nullable)addLabels:(NSArray *__nonnull)labels desc:(NSDictionary * __nullable)desc mode:(MaplyThreadMode)threadMode;
 
@@ -102,6 +110,10 @@
 // Change vector representation
 - (void)changeVectors:(MaplyComponentObject *__nonnull)vecObj desc:(NSDictionary * __nullable)desc mode:(MaplyThreadMode)threadMode;
 
+// Move a fleet of screen markers
+- (void)moveScreenMarkers:(MaplyComponentObject *__nonnull)compObj locations:(const MaplyCoordinate *__nonnull)locs count:(int)count
+                 duration:(NSTimeInterval)duration mode:(MaplyThreadMode)threadMode;
+
 // Add shapes
 - (MaplyComponentObject *__nullable)addShapes:(NSArray *__nonnull)shapes desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode;
 
@@ -129,6 +141,9 @@
 // Change the render target for a particle system
 - (void)changeParticleSystem:(MaplyComponentObject *__nonnull)compObj renderTarget:(MaplyRenderTarget * __nullable)target;
 
+// Swap in new textures for a particle system
+- (void)changeParticleSystem:(MaplyComponentObject *__nonnull)compObj textures:(NSArray<MaplyTexture *> *__nonnull)textures;
+
 // Add a particle system batch
 - (void)addParticleBatch:(MaplyParticleBatch *__nonnull)batch mode:(MaplyThreadMode)threadMode;
 
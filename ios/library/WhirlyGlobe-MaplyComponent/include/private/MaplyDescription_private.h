@@ -0,0 +1,40 @@
+/*  MaplyDescription_private.h
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <functional>
+#import "control/MaplyDescription.h"
+#import "WhirlyGlobeLib.h"
+
+@interface MaplyDescription()
+
+/// Info parsed from this description for the given kind of object.
+/// The first call for a key makes it, later ones get the same one back.
+- (WhirlyKit::BaseInfoRef)infoForKey:(const char *)key make:(const std::function<WhirlyKit::BaseInfoRef()> &)make;
+
+@end
+
+/// Parse the info for a description, or copy it from a MaplyDescription that already has
+template <typename T,typename F>
+T InfoForDesc(NSDictionary *desc,const char *key,F &&make)
+{
+    if ([desc isKindOfClass:[MaplyDescription class]])
+    {
+        const auto info = [(MaplyDescription *)desc infoForKey:key make:[&]{ return WhirlyKit::BaseInfoRef(new T(make())); }];
+        return *std::static_pointer_cast<T>(info);
+    }
+    return make();
+}
@@ -43,6 +43,20 @@
     
     // Scene renderer... renders the scene
     WhirlyKit::SceneRendererRef sceneRenderer;
+
+    // Default shaders come out of here.  Loaded once, in loadSetup.
+    id<MTLLibrary> defaultLibrary;
+
+    // Set for the fast startup path, before loadSetup
+    bool fastStartup;
+
+    // When setup started, if it was before loadSetup
+    WhirlyKit::TimeInterval setupStartTime;
+
+    // On a fast startup the shader functions are looked up in the background.
+    // setupShaders waits on the group and takes them from here.
+    NSMutableDictionary<NSString *,id<MTLFunction>> *shaderFunctions;
+    dispatch_group_t shaderFunctionsGroup;
     
     // General pointer to the view
     WhirlyKit::CoordSystemDisplayAdapter *coordAdapter;
@@ -97,6 +111,13 @@
     MaplyTexture *maskTex;
     MaplyRenderTarget *maskRenderTarget;
 
+    // Selectable shapes draw their IDs in here for picking
+    MaplyTexture *selectIDTex;
+    MaplyRenderTarget *selectIDRenderTarget;
+
+    // Render target textures that variable targets are done with, waiting for the next one
+    std::vector<std::pair<MaplyQuadImageFormat,MaplyTexture *>> targetTexPool;
+
     /// Number of simultaneous tile fetcher connections (per tile fetcher)
     int tileFetcherConnections;
 }
@@ -130,4 +151,11 @@
 
 - (void)addShader:(NSString *)inName program:(WhirlyKit::ProgramRef)program;
 
+/// A render target texture of the given format and size that a variable target handed back, or nil
+- (MaplyTexture *)takePooledTargetTexture:(MaplyQuadImageFormat)type sizeX:(int)sizeX sizeY:(int)sizeY;
+
+/// Hold on to a render target texture for the next variable target that wants one like it.
+/// Returns false if we won't keep it, in which case it's still the caller's to remove.
+- (bool)poolTargetTexture:(MaplyTexture *)tex type:(MaplyQuadImageFormat)type;
+
 @end
@@ -36,6 +36,17 @@
 
 @end
 
+// Style delegates that can match features against the C++ attributes directly,
+//  saving the conversion to NSDictionary
+@protocol MaplyVectorStyleDelegateDictionary <NSObject>
+
+- (nullable NSArray *)stylesForFeatureWithDictionary:(const WhirlyKit::Dictionary &)attrs
+                                              onTile:(MaplyTileID)tileID
+                                             inLayer:(NSString *__nonnull)layer
+                                               viewC:(NSObject<MaplyRenderControllerProtocol> *__nonnull)viewC;
+
+@end
+
 // This wraps C++ style implementations to be called from ObjC
 @interface MaplyVectorStyleReverseWrapper: NSObject<MaplyVectorStyle>
 
@@ -69,6 +80,9 @@
 namespace WhirlyKit
 {
 
+/// NSDictionary version of the attributes, wrapped if they already are one, converted if not
+NSDictionary *_Nullable NSDictionaryForAttrs(const Dictionary &attrs);
+
 // iOS version wants the view controller for some of the variants
 class MapboxVectorStyleSetImpl_iOS : public MapboxVectorStyleSetImpl
 {
@@ -0,0 +1,31 @@
+/*  MapnikStyleRule_private.h
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "vector_styles/MapnikStyleRule.h"
+#import "StyleRuleFilter.h"
+
+@interface MapnikStyleRule()
+{
+@public
+    // Compiled version of the filter, when we understood all of it
+    WhirlyKit::StyleRuleFilterRef ruleFilter;
+}
+
+/// Run the compiled filter if we have one, the predicate if not
+- (bool)testAttrs:(const WhirlyKit::Dictionary &)attrs nsAttrs:(NSDictionary * __nullable (^ __nonnull)(void))nsAttrs;
+
+@end
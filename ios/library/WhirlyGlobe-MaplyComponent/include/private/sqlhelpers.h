@@ -49,6 +49,13 @@ public:
 
 	/// You can force a finalize here
 	void finalize();
+
+	/// Get ready to run again, forgetting the old bindings.
+	/// Lets a prepared statement be kept and reused.
+	void reset();
+
+	/// Bind the next parameter, starting from the first
+	void bind(int);
 	
 	/// Return an int from the current row
 	int getInt();
@@ -69,6 +76,7 @@ protected:
 	sqlite3_stmt *stmt;
 	bool isFinalized;
 	int curField;
+	int bindField;
 };
 
 /** This version is for an insert or update.
@@ -30,6 +30,34 @@ typedef NS_ENUM(NSUInteger,MaplyMipmapType) {
     MaplyMipmapGauss
 };
 
+/**
+    Histogram of the first channel of a render target.
+ 
+    The counting is done on the GPU and only the bins come back.  The bins split the range
+    between minVal and maxVal evenly, with anything outside that put in the end bins.
+  */
+@interface MaplyRenderTargetHistogram : NSObject
+
+/// Bottom of the range the bins cover
+@property (nonatomic,readonly) float minVal;
+
+/// Top of the range the bins cover
+@property (nonatomic,readonly) float maxVal;
+
+/// Number of pixels in each bin, as NSNumbers
+@property (nonatomic,readonly,nonnull) NSArray<NSNumber *> *bins;
+
+/// Total pixels counted
+@property (nonatomic,readonly) uint64_t numPixels;
+
+/// Value below which the given fraction (0-1) of the pixels fall.  Interpolated within a bin.
+- (float)percentile:(double)frac;
+
+/// Mean value, taking each pixel to be in the middle of its bin
+- (float)mean;
+
+@end
+
 /** 
     Represents a render target (other than the screen)
     
@@ -70,6 +98,17 @@ typedef NS_ENUM(NSUInteger,MaplyMipmapType) {
  */
 @property (nonatomic) bool calculateMinMax;
 
+/**
+ If set, we'll only draw into the render target when something drawn there changes, something in it
+    animates or the view moves.  Otherwise the contents are left from the last time.  This saves a lot
+    of GPU time for data layers that sit still.
+ 
+    Animation means tweakers or a continuous render request on something drawn into the target.
+    Turn this off for a shader that changes every frame without asking for continuous rendering.
+    Set this before adding the target.  On by default.
+ */
+@property (nonatomic) bool renderWhenChanged;
+
 /**
     Clear the render target to this color every frame.
  
@@ -116,4 +155,43 @@ typedef NS_ENUM(NSUInteger,MaplyMipmapType) {
  */
 - (NSData *)getMinMaxValues;
 
+/**
+ Copies out a single data value without waiting for the GPU.
+ The copy goes in with the next frame and the completion block is called on the main queue
+ once it's done, with nil if the copy couldn't be made.
+ Metal only.
+ */
+- (void)getValueAtX:(int)x y:(int)y completion:(void (^)(NSData *data))completion;
+
+/**
+ Copies out the whole render target without waiting for the GPU.
+ The completion block is called on the main queue once the next frame's copy is done.
+ Metal only.
+ */
+- (void)getSnapshotWithCompletion:(void (^)(NSData *data))completion;
+
+/**
+ Copies out the min/max data values, if those are being calculated, without waiting for the GPU.
+ The completion block is called on the main queue once the next frame's copy is done.
+ Metal only.
+ */
+- (void)getMinMaxValuesWithCompletion:(void (^)(NSData *data))completion;
+
+/**
+ Counts the first channel of the render target into a histogram without waiting for the GPU.
+ 
+ This is meant for data layers, such as a weather variable drawn into a float target.
+ The counting is done by a compute pass that goes in with the next frame, so nothing but the bins
+ has to be copied back.  Use the percentile and mean methods on the result for a summary.
+ 
+ The completion block is called on the main queue, with nil if the histogram couldn't be made.
+ Metal only.
+ 
+ @param numBins Number of bins to split the range into.
+ @param minVal Bottom of the range.  Anything below this goes in the first bin.
+ @param maxVal Top of the range.  Anything above this goes in the last bin.
+ */
+- (void)getHistogramWithBins:(int)numBins minVal:(float)minVal maxVal:(float)maxVal
+                  completion:(void (^)(MaplyRenderTargetHistogram *histogram))completion;
+
 @end
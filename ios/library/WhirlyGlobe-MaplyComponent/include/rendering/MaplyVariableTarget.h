@@ -51,6 +51,11 @@
 /// When we're clearing, use this value.  0 by default
 @property (nonatomic,assign) float clearVal;
 
+/// If set, the target is only drawn again when a tile comes or goes, a frame changes,
+/// something in it animates or the view moves.  Turn it off for shaders that change every frame
+/// on their own.  On by default.  Set it before the target is set up on the next main queue pass.
+@property (nonatomic,assign) bool renderWhenChanged;
+
 /// Shader used to draw the render target to the screen.
 /// Leave this empty and we'll provide our own
 @property (nonatomic,strong,nullable) MaplyShader *shader;
@@ -97,6 +97,31 @@ typedef NS_ENUM(NSUInteger,MapboxLayerType) {
 /// Make a layer visible/invisible
 - (void)setLayerVisible:(NSString *__nonnull)layerName visible:(bool)visible;
 
+/**
+ Replace the paint values for a layer and apply them to what's already displayed.
+ 
+ This is for quick changes like switching to a night palette.  Fill and line colors, opacity
+ and line widths can change this way, as long as they don't vary by zoom level.
+ Returns false if the layer can't take the new values without rebuilding its geometry.
+ Nothing changes in that case, so reload the tiles with an updated style instead.
+ */
+- (bool)updateLayerPaint:(NSString *__nonnull)layerName paint:(NSDictionary *__nonnull)paint;
+
+/**
+ Render the common label glyphs for the symbol layers visible at the given zoom level.
+ 
+ Call this after the style is set up and before the loader starts.  The first screen of labels
+ won't have to wait on glyph rendering.  The progress block is called after each symbol layer.
+ The glyphs are held in the font atlas until releaseWarmUp.
+ */
+- (void)warmUpGlyphsForZoom:(int)zoom progress:(void (^ __nullable)(int done,int total))progress;
+
+/// Like warmUpGlyphsForZoom:progress:, but with the characters to render rather than the Latin-1 set
+- (void)warmUpGlyphsForZoom:(int)zoom chars:(NSString *__nonnull)chars progress:(void (^ __nullable)(int done,int total))progress;
+
+/// Release the glyphs held by warmUpGlyphsForZoom:progress:
+- (void)releaseWarmUp;
+
 /// Slot for continuous zoom levels.  If not set, we won't use those.
 - (void)setZoomSlot:(int)zoomSlot;
 
@@ -73,7 +73,7 @@
 /// Use widened vectors (which do anti-aliasing and such)
 @property (nonatomic) bool useWideVectors;
 
-/// Use GPU-based wide vector implementation
+/// Use GPU-based wide vector implementation.  On by default.
 @property (nonatomic) bool usePerfWideVectors;
 
 /// Where we're using old vectors (e.g. not wide) scale them by this amount
@@ -62,4 +62,34 @@
  */
 - (void)setUUIDName:(NSString * __nonnull)uuidName uuidValues:(NSArray<NSString *> * __nonnull)uuids;
 
+/**
+ Build the styles for each tile on this many extra threads.
+ 
+ Dense tiles can have dozens of styles to build and they're independent of each other.
+ This only applies to styles backed by the native implementation, such as MaplyMapboxVectorStyleSet.
+ Styles implemented in Objective-C or Swift are always built on the loader thread.
+ 0, the default, turns this off.
+ */
+- (void)setBuildThreads:(int)numThreads;
+
+/**
+ Keep decoded vector tiles around, up to about this many bytes.
+ 
+ When a tile comes back with the same data, and the style layers haven't changed, we skip decoding it again.
+ Changing a layer's visibility or adding layers starts over, changing paint values doesn't.
+ Only styles backed by the native implementation, such as MaplyMapboxVectorStyleSet, use this.
+ 0, the default, turns it off.
+ */
+- (void)setTileCacheSize:(size_t)maxBytes;
+
+/**
+ The deepest level the vector tile source really has.
+ 
+ Past this level the loader is overzooming and each tile is handed its ancestor's data.
+ When set, we clip the features to the tile being built and drop vertices too close
+ together to see, rather than building the whole ancestor for every tile.
+ -1, the default, turns it off.
+ */
+- (void)setSourceMaxZoom:(int)level;
+
 @end
@@ -76,6 +76,8 @@
     Generate a cluster group for a given collection of markers.
     
     Generate an image and size to represent the number of marker/labels we're consolidating.
+    Hand back the same image object for clusters that look the same and its texture will be
+    reused, within a layout and from one layout to the next.
  
     @note Will not be called if @c -showMarkerWithHighestImportance returns @c true.
   */
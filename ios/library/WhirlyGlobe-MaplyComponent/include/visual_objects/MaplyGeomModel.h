@@ -39,6 +39,13 @@
   */
 - (nullable instancetype)initWithObj:(NSString *__nonnull)fullPath;
 
+/**
+    Initialize with the full path to a Wavefront OBJ model file, keeping a binary version in the given directory.
+    
+    Parsing a big OBJ file can take a while.  The first time through, the model is optimized for rendering and saved to the cache directory.  After that it's read straight from there, as long as the OBJ file hasn't changed.  Somewhere under the caches directory is a good spot.  Nil turns it off.
+  */
+- (nullable instancetype)initWithObj:(NSString *__nonnull)fullPath cacheDir:(NSString *__nullable)cacheDir;
+
 /** 
     Initialize with a shape.
     
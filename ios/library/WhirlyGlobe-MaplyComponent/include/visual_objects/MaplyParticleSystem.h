@@ -71,6 +71,7 @@ typedef NS_ENUM(NSInteger, MaplyParticleSystemType) {
     Individual particle lifetime.
     
     The created particles will last only a certain amount of time.
+    Set it to zero and they'll stay put, so a position shader can keep moving them on the GPU without any more batches.
   */
 @property (nonatomic,assign) NSTimeInterval lifetime;
 
@@ -36,6 +36,25 @@
 /// Okay to place below a point
 #define kMaplyLayoutBelow  (1<<5)
 
+/**
+    A screen label as a plain struct, for adding lots of them at once.
+
+    These go to addScreenLabelStructs:count:text:length:desc:mode: on the view controller along with one block of UTF-8 text holding all their strings.  Anything not here comes from the description dictionary.
+  */
+typedef struct
+{
+    /// Location in geographic (lon/lat in radians)
+    MaplyCoordinate loc;
+    /// Where the label's text starts in the text block.  It runs to the next NUL.
+    uint32_t textOffset;
+    /// Text color as 0xAARRGGBB.  Zero takes the color from the description.
+    uint32_t color;
+    /// Layout importance.  MAXFLOAT means it isn't laid out.
+    float layoutImportance;
+    /// Where the layout engine can put it, from kMaplyLayoutRight and friends
+    int32_t layoutPlacement;
+} MaplyScreenLabelStruct;
+
 /** 
     The Screen Label is a 2D label that tracks a given geographic location.
     
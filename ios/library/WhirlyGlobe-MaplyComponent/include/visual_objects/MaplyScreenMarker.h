@@ -21,6 +21,25 @@
 
 @class MaplyVectorObject;
 
+/**
+    A screen marker as a plain struct, for adding lots of them at once.
+
+    These go to addScreenMarkerStructs:count:textures:desc:mode: on the view controller, which turns them into markers directly, without making a MaplyScreenMarker for each.  Anything not here comes from the description dictionary.
+  */
+typedef struct
+{
+    /// Location in geographic (lon/lat in radians)
+    MaplyCoordinate loc;
+    /// Size on the screen in points.  Zero takes the size from the description.
+    float width,height;
+    /// Index into the textures passed along with the markers, or -1 for a plain rectangle
+    int32_t texIndex;
+    /// Color as 0xAARRGGBB.  Zero takes the color from the description.
+    uint32_t color;
+    /// Layout importance.  MAXFLOAT means it isn't laid out.
+    float layoutImportance;
+} MaplyScreenMarkerStruct;
+
 /** 
     The Screen Marker is a 2D object that displays an image on the screen tracking a given location.
     
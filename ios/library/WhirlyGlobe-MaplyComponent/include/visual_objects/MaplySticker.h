@@ -21,6 +21,7 @@
 #import <UIKit/UIKit.h>
 #import <WhirlyGlobe/MaplyCoordinate.h>
 #import <WhirlyGlobe/MaplyRenderController.h>
+#import <WhirlyGlobe/MaplyQuadSampler.h>
 
 /** 
     Stickers are rectangles placed on the globe with an image.
@@ -81,5 +82,21 @@
  */
 @property (nonatomic) MaplyQuadImageFormat imageFormat;
 
+/**
+    Sampling parameters to stream a large image over the sticker's extents.
+ 
+    Images too big for a single texture (a 20k by 20k scan, say) can be cut into a tile pyramid and loaded a piece at a time.  This sets up sampling over just the sticker, with enough levels to reach full resolution.  Hand it to a MaplyQuadImageLoader along with a tile source for the pyramid, rather than adding the sticker itself, and only the tiles in view are loaded at the resolution the view needs.
+ 
+    Level 0 is the whole image in one tile.  The pyramid is anchored at the lower left, TMS style, so turn off flipY on the loader.  Tiles along the top and right are padded out to tileSize.
+ 
+    Returns nil for rotated stickers, which the tile geometry can't follow.
+ 
+    @param imageWidth Width of the full resolution image in pixels.
+ 
+    @param imageHeight Height of the full resolution image in pixels.
+ 
+    @param tileSize Size of the square tiles the image has been cut into (e.g. 256).
+  */
+- (MaplySamplingParams * __nullable)samplingParamsForImageWidth:(int)imageWidth height:(int)imageHeight tileSize:(int)tileSize;
 
 @end
@@ -20,31 +20,14 @@
 
 #import <Foundation/Foundation.h>
 #import <zlib.h>
+#import "RawData.h"
+
+using namespace WhirlyKit;
 
 @implementation NSData(zlib)
 - (BOOL)isCompressed
 {
-    // Update courtesy: Tim Sylvester
-    uint32_t const smallest_zlib_output = 8;    // gzip is 23
-    if (self.length >= smallest_zlib_output)
-    {
-        const uint8_t* const bytes = (const uint8_t*)self.bytes;
-        switch (bytes[0])
-        {
-            case 0x1f:
-                return (bytes[1] == 0x8b);  // gzip
-            case 0x78:
-                switch (bytes[1])
-            {
-                case 0x01:  // Compression levels 0-1 (none,fast)
-                case 0x5e:  // Compression levels 2-5
-                case 0x9c:  // Compression level  6   (default)
-                case 0xda:  // Compression levels 7-9 (best)
-                    return true;
-            }
-        }
-    }
-    return false;
+    return RawDataIsCompressed(self.bytes, self.length);
 }
 
 - (NSData *) compressData
@@ -92,51 +75,21 @@
 
 - (NSData *) uncompressGZip
 {
-    NSData *compressedData = self;
-    
-    if ([compressedData length] == 0) return compressedData;
-    
-    NSUInteger full_length = [compressedData length];
-    NSUInteger half_length = [compressedData length] / 2;
-    
-    NSMutableData *decompressed = [NSMutableData dataWithLength: full_length + half_length];
-    BOOL done = NO;
-    int status;
-    
-    z_stream strm;
-    strm.next_in = (Bytef *)[compressedData bytes];
-    strm.avail_in = (unsigned int)[compressedData length];
-    strm.total_out = 0;
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    
-    if (inflateInit2(&strm, (15+32)) != Z_OK) return nil;
-    
-    while (!done) {
-        // Make sure we have enough room and reset the lengths.
-        if (strm.total_out >= [decompressed length]) {
-            [decompressed increaseLengthBy: half_length];
-        }
-        strm.next_out = (uint8_t*)[decompressed mutableBytes] + strm.total_out;
-        strm.avail_out = (unsigned int)([decompressed length] - strm.total_out);
-        
-        // Inflate another chunk.
-        status = inflate (&strm, Z_SYNC_FLUSH);
-        if (status == Z_STREAM_END) {
-            done = YES;
-        } else if (status != Z_OK) {
-            break;
-        }
-    }
-    if (inflateEnd (&strm) != Z_OK) return nil;
-    
-    // Set real length.
-    if (done) {
-        [decompressed setLength: strm.total_out];
-        return [NSData dataWithData: decompressed];
-    } else {
+    if ([self length] == 0) return self;
+
+    // Inflate straight into a buffer the NSData takes over, rather than copying it out again
+    auto *decompressed = new std::vector<unsigned char>();
+    if (!RawDataInflate([self bytes], [self length], *decompressed) || decompressed->empty())
+    {
+        delete decompressed;
         return nil;
     }
+
+    return [[NSData alloc] initWithBytesNoCopy:decompressed->data()
+                                        length:decompressed->size()
+                                   deallocator:^(void *bytes, NSUInteger length) {
+        delete decompressed;
+    }];
 }
 
 @end
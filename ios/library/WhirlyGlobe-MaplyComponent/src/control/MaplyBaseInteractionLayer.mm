@@ -40,6 +40,7 @@
 #import "MaplyShape_private.h"
 #import "MaplyPoints_private.h"
 #import "MaplyRenderTarget_private.h"
+#import "MaplyDescription_private.h"
 #import "Dictionary_NSDictionary.h"
 #import "SingleLabel_iOS.h"
 #import "FontTextureManager_iOS.h"
@@ -77,6 +78,15 @@ typedef std::set<ThreadChanges> ThreadChangeSet;
 
 typedef std::map<int,NSObject <MaplyClusterGenerator> *> ClusterGenMap;
 
+// Snapshot of a description to take over to the layer thread.
+// MaplyDescriptions can't change, so they go as they are and keep what they've parsed.
+static NSDictionary *CopyDesc(NSDictionary *desc)
+{
+    if ([desc isKindOfClass:[MaplyDescription class]])
+        return desc;
+    return [NSDictionary dictionaryWithDictionary:desc];
+}
+
 @interface MaplyBaseInteractionLayer()
 - (void) startLayoutObjects;
 - (void) makeLayoutObject:(int)clusterID layoutObjects:(const std::vector<LayoutObjectEntryRef> &)layoutObjects retObj:(LayoutObject &)retObj;
@@ -126,8 +136,9 @@ public:
     int numActiveWorkers;
     ClusterGenMap clusterGens;
     OurClusterGenerator ourClusterGen;
-    // Last frame (layout frame, not screen frame)
-    std::vector<MaplyTexture *> currentClusterTex,oldClusterTex;
+    // Cluster textures by the image they came from, for this layout pass and the last one
+    // Images a generator hands back again reuse their texture
+    NSMapTable<id,MaplyTexture *> *currentClusterTex,*oldClusterTex;
     bool offlineMode;
         
     // Pre-fetched IDs for the various programs
@@ -426,13 +437,23 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
         maplyTex = [[MaplyTexture alloc] init];
         
         Texture *tex = [self createTexture:image desc:desc mode:threadMode];
-        maplyTex.texID = tex->getId();
         maplyTex.interactLayer = self;
         maplyTex.image = image;
         maplyTex.width = tex->getWidth();
         maplyTex.height = tex->getHeight();
-        
-        changes.push_back(new AddTextureReq(tex));
+
+        // A different UIImage with the same pixels can share the texture
+        const uint64_t contentHash = image ? tex->getContentHash() : 0;
+        const SimpleIdentity sharedTexID = scene->retainSharedImage(contentHash);
+        if (sharedTexID != EmptyIdentity)
+        {
+            maplyTex.texID = sharedTexID;
+            delete tex;
+        } else {
+            maplyTex.texID = tex->getId();
+            scene->addSharedImage(contentHash, tex->getId());
+            changes.push_back(new AddTextureReq(tex));
+        }
         imageTextures.push_back(maplyTex);
     }
     
@@ -451,12 +472,35 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     Texture *tex = [self createTexture:image desc:desc mode:threadMode];
     if (!tex)
         return nil;
-    
+
+    // Atlas entries are kept apart from whole textures with the same pixels
+    uint64_t contentHash = tex->getContentHash();
+    if (contentHash)
+        contentHash = contentHash * 31 + 1;
+
+    // The same pixels may already be in an atlas
+    const SimpleIdentity sharedTexID = scene->retainSharedImage(contentHash);
+    if (sharedTexID != EmptyIdentity)
+    {
+        MaplyTexture *maplyTex = [[MaplyTexture alloc] init];
+        maplyTex.image = image;
+        maplyTex.texID = sharedTexID;
+        maplyTex.isSubTex = true;
+        maplyTex.interactLayer = self;
+        {
+            std::lock_guard<std::mutex> guardLock(imageLock);
+            imageTextures.push_back(maplyTex);
+        }
+        delete tex;
+        return maplyTex;
+    }
+
     // Add to a texture atlas
     MaplyTexture *maplyTex = nil;
     SubTexture subTex;
     if ([atlasGroup addTexture:tex subTex:subTex changes:changes])
     {
+        scene->addSharedImage(contentHash, subTex.getId());
         maplyTex = [[MaplyTexture alloc] init];
         maplyTex.image = image;
         maplyTex.texID = subTex.getId();
@@ -538,6 +582,13 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     if (!layerThread || isShuttingDown)
         return;
     
+    // Other textures may still be using the same image
+    if (scene && !scene->releaseSharedImage(tex.texID))
+    {
+        tex.texID = EmptyIdentity;
+        return;
+    }
+
     ChangeSet changes;
 
     if (tex.isSubTex)
@@ -702,6 +753,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     if (it != perThreadChanges.end())
     {
         ThreadChanges theseChanges = *it;
+        compactChanges(theseChanges.changes);
         // Process the setupGL on this thread rather than making the main thread do it
         if (currentThread != mainThread)
             for (auto &change : theseChanges.changes) {
@@ -801,7 +853,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
         isMotionMarkers = true;
     
     iosDictionary dictWrap(inDesc);
-    MarkerInfo markerInfo(dictWrap,true);
+    MarkerInfo markerInfo = InfoForDesc<MarkerInfo>(inDesc,"MarkerInfoScreen",[&]{ return MarkerInfo(dictWrap,true); });
 
     // Might be a custom shader on these
     if (isMotionMarkers)
@@ -957,7 +1009,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
 
-    NSArray *argArray = @[markers, compObj, [NSDictionary dictionaryWithDictionary:desc], @(threadMode)];
+    NSArray *argArray = @[markers, compObj, CopyDesc(desc), @(threadMode)];
     
     switch (threadMode)
     {
@@ -972,6 +1024,95 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     return compObj;
 }
 
+// Markers from packed structs.  No selection or per-marker extras, just what's in the struct.
+// Called in an unknown thread
+- (void)addScreenMarkerStructsRun:(NSArray *)argArray
+{
+    if (isShuttingDown || (!layerThread && !offlineMode))
+        return;
+
+    NSData *markerData = [argArray objectAtIndex:0];
+    NSArray<MaplyTexture *> *textures = [argArray objectAtIndex:1];
+    MaplyComponentObject *compObj = [argArray objectAtIndex:2];
+    NSDictionary *inDesc = [argArray objectAtIndex:3];
+    const auto threadMode = (MaplyThreadMode)[[argArray objectAtIndex:4] intValue];
+
+    iosDictionary dictWrap(inDesc);
+    MarkerInfo markerInfo = InfoForDesc<MarkerInfo>(inDesc,"MarkerInfoScreen",[&]{ return MarkerInfo(dictWrap,true); });
+    [self resolveInfoDefaults:inDesc info:&markerInfo defaultShader:kMaplyScreenSpaceDefaultProgram];
+    [self resolveDrawPriority:inDesc info:&markerInfo drawPriority:kMaplyLabelDrawPriorityDefault offset:_screenObjectDrawPriorityOffset];
+
+    const auto *structs = (const MaplyScreenMarkerStruct *)markerData.bytes;
+    const NSUInteger count = markerData.length / sizeof(MaplyScreenMarkerStruct);
+    const NSUInteger numTex = textures.count;
+
+    // The textures are looked up once, not once per marker
+    std::vector<SimpleIdentity> texIDs;
+    texIDs.reserve(numTex);
+    for (MaplyTexture *tex in textures)
+    {
+        texIDs.push_back(tex.texID);
+        compObj->contents->texs.insert(tex);
+    }
+
+    std::vector<Marker,Eigen::aligned_allocator<Marker>> markerStore(count);
+    std::vector<Marker *> wgMarkers(count);
+    for (NSUInteger ii=0;ii<count;ii++)
+    {
+        const MaplyScreenMarkerStruct &marker = structs[ii];
+        Marker &wgMarker = markerStore[ii];
+        wgMarker.loc = GeoCoord(marker.loc.x,marker.loc.y);
+        if (marker.texIndex >= 0 && (NSUInteger)marker.texIndex < numTex)
+            wgMarker.texIDs.push_back(texIDs[marker.texIndex]);
+        if (marker.color != 0)
+        {
+            wgMarker.color = RGBAColor::FromARGBInt(marker.color);
+            wgMarker.colorSet = true;
+        }
+        wgMarker.width = (marker.width > 0.0) ? marker.width : markerInfo.width;
+        wgMarker.height = (marker.width > 0.0) ? marker.height : markerInfo.height;
+        wgMarker.layoutWidth = wgMarker.width;
+        wgMarker.layoutHeight = wgMarker.height;
+        wgMarker.layoutImportance = marker.layoutImportance;
+        wgMarkers[ii] = &wgMarker;
+    }
+
+    ChangeSet changes;
+    const SimpleIdentity markerID = compManager->markerManager->addMarkers(wgMarkers, markerInfo, changes);
+    if (markerID != EmptyIdentity)
+        compObj->contents->markerIDs.insert(markerID);
+
+    compManager->addComponentObject(compObj->contents, changes);
+
+    [self flushChanges:changes mode:threadMode];
+}
+
+// Called in the main thread.
+- (MaplyComponentObject *)addScreenMarkerStructs:(const MaplyScreenMarkerStruct *)markers count:(NSUInteger)count
+                                       textures:(NSArray<MaplyTexture *> *)textures desc:(NSDictionary *)desc mode:(MaplyThreadMode)threadMode
+{
+    threadMode = [self resolveThreadMode:threadMode];
+
+    MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
+    compObj->contents->underConstruction = true;
+
+    // The caller's array may not be around by the time we get to it
+    NSData *markerData = [NSData dataWithBytes:markers length:count * sizeof(MaplyScreenMarkerStruct)];
+    NSArray *argArray = @[markerData, textures ? [textures copy] : @[], compObj, CopyDesc(desc), @(threadMode)];
+
+    switch (threadMode)
+    {
+        case MaplyThreadCurrent:
+            [self addScreenMarkerStructsRun:argArray];
+            break;
+        case MaplyThreadAny:
+            [self performSelector:@selector(addScreenMarkerStructsRun:) onThread:layerThread withObject:argArray waitUntilDone:NO];
+            break;
+    }
+
+    return compObj;
+}
+
 - (void)addClusterGenerator:(NSObject <MaplyClusterGenerator> *)clusterGen
 {
     @synchronized(self)
@@ -984,7 +1125,8 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
 {
     // Started cluster generation, so keep track of the old textures
     oldClusterTex = currentClusterTex;
-    currentClusterTex.clear();
+    currentClusterTex = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory|NSPointerFunctionsObjectPointerPersonality
+                                              valueOptions:NSPointerFunctionsStrongMemory];
     
     @synchronized(self) {
         for (ClusterGenMap::iterator it = clusterGens.begin();
@@ -1102,13 +1244,25 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
         retObj.importance = sampleObj->importance;
     }
     
-    // Create the texture
-    // Note: Keep this around
-    MaplyTexture *maplyTex = [self addTexture:group.image desc:@{kMaplyTexFormat: @(MaplyImageIntRGBA),
-                                                                 kMaplyTexAtlas: @(true),
-                                                                 kMaplyTexMagFilter: kMaplyMinFilterNearest}
-                                         mode:MaplyThreadCurrent];
-    currentClusterTex.push_back(maplyTex);
+    // Reuse the texture if we've seen this image, in this pass or the last one
+    MaplyTexture *maplyTex = [currentClusterTex objectForKey:group.image];
+    if (!maplyTex)
+    {
+        maplyTex = [oldClusterTex objectForKey:group.image];
+        if (maplyTex)
+        {
+            [oldClusterTex removeObjectForKey:group.image];
+        }
+        else
+        {
+            maplyTex = [self addTexture:group.image desc:@{kMaplyTexFormat: @(MaplyImageIntRGBA),
+                                                           kMaplyTexAtlas: @(true),
+                                                           kMaplyTexMagFilter: kMaplyMinFilterNearest}
+                                   mode:MaplyThreadCurrent];
+        }
+        if (maplyTex)
+            [currentClusterTex setObject:maplyTex forKey:group.image];
+    }
     if (maplyTex.isSubTex)
     {
         SubTexture subTex = scene->getSubTexture(maplyTex.texID);
@@ -1123,15 +1277,13 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
 
 - (void)endLayoutObjects
 {
-    // Layout of new objects is over, so schedule the old textures for removal
-    if (!oldClusterTex.empty())
+    // Layout of new objects is over, so schedule the old textures nobody reused for removal
+    if ([oldClusterTex count])
     {
-        NSMutableArray *texArr = [NSMutableArray array];
-        for (auto tex : oldClusterTex)
-            [texArr addObject:tex];
+        NSArray *texArr = [[oldClusterTex objectEnumerator] allObjects];
         [self performSelector:@selector(delayedRemoveTextures:) withObject:texArr afterDelay:2.0];
-        oldClusterTex.clear();
     }
+    oldClusterTex = nil;
     
     @synchronized(self) {
         for (ClusterGenMap::iterator it = clusterGens.begin();
@@ -1203,7 +1355,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     }
 
     iosDictionary dictWrap(inDesc);
-    MarkerInfo markerInfo(dictWrap,false);
+    MarkerInfo markerInfo = InfoForDesc<MarkerInfo>(inDesc,"MarkerInfo",[&]{ return MarkerInfo(dictWrap,false); });
     [self resolveInfoDefaults:inDesc info:&markerInfo defaultShader:(hasMultiTex ? kMaplyShaderDefaultMarker : kMaplyShaderDefaultTri)];
     [self resolveDrawPriority:inDesc info:&markerInfo drawPriority:kMaplyMarkerDrawPriorityDefault offset:0];
     
@@ -1301,7 +1453,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
 
-    NSArray *argArray = @[markers, compObj, [NSDictionary dictionaryWithDictionary:desc], @(threadMode)];
+    NSArray *argArray = @[markers, compObj, CopyDesc(desc), @(threadMode)];
     switch (threadMode)
     {
         case MaplyThreadCurrent:
@@ -1332,7 +1484,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     const bool isMotionLabels = ([[labels objectAtIndex:0] isKindOfClass:[MaplyMovingScreenLabel class]]);
 
     iosDictionary dictWrap(inDesc);
-    LabelInfo_iOS labelInfo(inDesc,dictWrap, /*screenObject=*/true);
+    LabelInfo_iOS labelInfo = InfoForDesc<LabelInfo_iOS>(inDesc,"LabelInfoScreen",[&]{ return LabelInfo_iOS(inDesc,dictWrap, /*screenObject=*/true); });
     [self resolveInfoDefaults:inDesc info:&labelInfo
                 defaultShader:(isMotionLabels ? kMaplyScreenSpaceDefaultMotionProgram : kMaplyScreenSpaceDefaultProgram)];
     [self resolveDrawPriority:inDesc info:&labelInfo drawPriority:kMaplyLabelDrawPriorityDefault offset:_screenObjectDrawPriorityOffset];
@@ -1453,6 +1605,111 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     [self flushChanges:changes mode:threadMode];
 }
 
+// Labels from packed structs, with their strings in one block of UTF-8
+// Called in an unknown thread
+- (void)addScreenLabelStructsRun:(NSArray *)argArray
+{
+    if (isShuttingDown || (!layerThread && !offlineMode))
+        return;
+
+    NSData *labelData = [argArray objectAtIndex:0];
+    NSData *textData = [argArray objectAtIndex:1];
+    MaplyComponentObject *compObj = [argArray objectAtIndex:2];
+    NSDictionary *inDesc = [argArray objectAtIndex:3];
+    const auto threadMode = (MaplyThreadMode)[[argArray objectAtIndex:4] intValue];
+
+    iosDictionary dictWrap(inDesc);
+    LabelInfo_iOS labelInfo = InfoForDesc<LabelInfo_iOS>(inDesc,"LabelInfoScreen",[&]{ return LabelInfo_iOS(inDesc,dictWrap, /*screenObject=*/true); });
+    [self resolveInfoDefaults:inDesc info:&labelInfo defaultShader:kMaplyScreenSpaceDefaultProgram];
+    [self resolveDrawPriority:inDesc info:&labelInfo drawPriority:kMaplyLabelDrawPriorityDefault offset:_screenObjectDrawPriorityOffset];
+    if (!labelInfo.font)
+    {
+        labelInfo.font = [UIFont systemFontOfSize:32.0];
+    }
+
+    const auto *structs = (const MaplyScreenLabelStruct *)labelData.bytes;
+    const NSUInteger count = labelData.length / sizeof(MaplyScreenLabelStruct);
+    const char *text = (const char *)textData.bytes;
+    const NSUInteger textLen = textData.length;
+
+    std::vector<SingleLabel *> wgLabels;
+    std::vector<std::unique_ptr<SingleLabel>> wgLabelOwner;
+    wgLabels.reserve(count);
+    wgLabelOwner.reserve(count);
+    for (NSUInteger ii=0;ii<count;ii++)
+    {
+        const MaplyScreenLabelStruct &label = structs[ii];
+        if (label.textOffset >= textLen)
+            continue;
+        // The block ends with a NUL, so this can't run off the end
+        NSString *str = [[NSString alloc] initWithUTF8String:text + label.textOffset];
+        if (str.length == 0)
+            continue;
+
+        auto wgLabel = std::make_unique<SingleLabel_iOS>();
+        wgLabel->loc = GeoCoord(label.loc.x,label.loc.y);
+        wgLabel->text = str;
+        if (label.color != 0)
+        {
+            wgLabel->infoOverride = std::make_shared<LabelInfo>(true);
+            wgLabel->infoOverride->hasTextColor = true;
+            wgLabel->infoOverride->textColor = RGBAColor::FromARGBInt(label.color);
+        }
+        if (label.layoutImportance < MAXFLOAT)
+        {
+            wgLabel->layoutEngine = true;
+            wgLabel->layoutImportance = label.layoutImportance;
+            wgLabel->layoutPlacement = label.layoutPlacement;
+        }
+
+        wgLabels.push_back(wgLabel.get());
+        wgLabelOwner.push_back(std::move(wgLabel));
+    }
+
+    ChangeSet changes;
+    if (auto labelManager = scene->getManager<LabelManager>(kWKLabelManager))
+    {
+        const SimpleIdentity labelID = labelManager->addLabels(nullptr, wgLabels, labelInfo, changes);
+        if (labelID != EmptyIdentity)
+        {
+            compObj->contents->labelIDs.insert(labelID);
+        }
+    }
+
+    compManager->addComponentObject(compObj->contents, changes);
+
+    [self flushChanges:changes mode:threadMode];
+}
+
+// Called in the main thread.
+- (MaplyComponentObject *)addScreenLabelStructs:(const MaplyScreenLabelStruct *)labels count:(NSUInteger)count
+                                          text:(const char *)text length:(NSUInteger)length desc:(NSDictionary *)desc mode:(MaplyThreadMode)threadMode
+{
+    threadMode = [self resolveThreadMode:threadMode];
+
+    MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
+    compObj->contents->underConstruction = true;
+
+    // Copy both, making sure the text ends with a NUL
+    NSData *labelData = [NSData dataWithBytes:labels length:count * sizeof(MaplyScreenLabelStruct)];
+    NSMutableData *textData = [NSMutableData dataWithBytes:text length:length];
+    if (length == 0 || text[length-1] != '\0')
+        [textData appendBytes:"" length:1];
+    NSArray *argArray = @[labelData, textData, compObj, CopyDesc(desc), @(threadMode)];
+
+    switch (threadMode)
+    {
+        case MaplyThreadCurrent:
+            [self addScreenLabelStructsRun:argArray];
+            break;
+        case MaplyThreadAny:
+            [self performSelector:@selector(addScreenLabelStructsRun:) onThread:layerThread withObject:argArray waitUntilDone:NO];
+            break;
+    }
+
+    return compObj;
+}
+
 // Add screen space (2D) labels
 - (MaplyComponentObject *)addScreenLabels:(NSArray *)labels desc:(NSDictionary *)desc mode:(MaplyThreadMode)threadMode
 {
@@ -1461,7 +1718,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
 
-    NSArray *argArray = @[labels, compObj, [NSDictionary dictionaryWithDictionary:desc], @(threadMode)];
+    NSArray *argArray = @[labels, compObj, CopyDesc(desc), @(threadMode)];
 
     switch (threadMode)
     {
@@ -1489,7 +1746,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     const auto threadMode = (MaplyThreadMode)[[argArray objectAtIndex:3] intValue];
 
     iosDictionary dictWrap(inDesc);
-    LabelInfo_iOS labelInfo(inDesc,dictWrap, /*screenObject=*/false);
+    LabelInfo_iOS labelInfo = InfoForDesc<LabelInfo_iOS>(inDesc,"LabelInfo",[&]{ return LabelInfo_iOS(inDesc,dictWrap, /*screenObject=*/false); });
     [self resolveInfoDefaults:inDesc info:&labelInfo defaultShader:kMaplyShaderDefaultTri];
     [self resolveDrawPriority:inDesc info:&labelInfo drawPriority:kMaplyLabelDrawPriorityDefault offset:0];
 
@@ -1570,7 +1827,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
 
-    NSArray *argArray = @[labels, compObj, [NSDictionary dictionaryWithDictionary:desc], @(threadMode)];
+    NSArray *argArray = @[labels, compObj, CopyDesc(desc), @(threadMode)];
 
     switch (threadMode)
     {
@@ -1625,7 +1882,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     const auto threadMode = (MaplyThreadMode)[[argArray objectAtIndex:4] intValue];
     
     iosDictionary dictWrap(inDesc);
-    VectorInfo vectorInfo(dictWrap);
+    VectorInfo vectorInfo = InfoForDesc<VectorInfo>(inDesc,"VectorInfo",[&]{ return VectorInfo(dictWrap); });
 
     // Might be a custom shader on these
     NSString *shaderName = !vectorInfo.filled ? kMaplyShaderDefaultLine : kMaplyDefaultTriangleShader;
@@ -1658,7 +1915,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
         {
             const float eps = vectorInfo.subdivEps;
             const NSString *subdivType = inDesc[kMaplySubdivType];
-            MaplyVectorObject *newVecObj = [vecObj deepCopy2];
+            MaplyVectorObject *newVecObj = [[MaplyVectorObject alloc] initWithRef:vecObj->vObj->copyOnWrite()];
             // Note: This logic needs to be moved down a level
             //       Along with the subdivision routines above
             if (![subdivType compare:kMaplySubdivGreatCirclePrecise])
@@ -1738,7 +1995,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
 
-    NSArray *argArray = @[vectors, compObj, [NSDictionary dictionaryWithDictionary:desc], [NSNumber numberWithBool:YES], @(threadMode)];
+    NSArray *argArray = @[vectors, compObj, CopyDesc(desc), [NSNumber numberWithBool:YES], @(threadMode)];
     switch (threadMode)
     {
         case MaplyThreadCurrent:
@@ -1765,7 +2022,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     const auto threadMode = (MaplyThreadMode)[[argArray objectAtIndex:3] intValue];
     
     iosDictionary dictWrap(inDesc);
-    WideVectorInfo vectorInfo(dictWrap);
+    WideVectorInfo vectorInfo = InfoForDesc<WideVectorInfo>(inDesc,"WideVectorInfo",[&]{ return WideVectorInfo(dictWrap); });
     [self resolveInfoDefaults:inDesc info:&vectorInfo defaultShader:(vectorInfo.implType == WideVecImplBasic ? kMaplyShaderDefaultWideVector : kMaplyShaderWideVectorPerformance )];
     [self resolveDrawPriority:inDesc info:&vectorInfo drawPriority:kMaplyVectorDrawPriorityDefault offset:0];
     
@@ -1792,7 +2049,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
         {
             const float eps = vectorInfo.subdivEps;
             const NSString *subdivType = inDesc[kMaplySubdivType];
-            MaplyVectorObject *newVecObj = [vecObj deepCopy2];
+            MaplyVectorObject *newVecObj = [[MaplyVectorObject alloc] initWithRef:vecObj->vObj->copyOnWrite()];
             // Note: This logic needs to be moved down a level
             //       Along with the subdivision routines above
             if (![subdivType compare:kMaplySubdivGreatCirclePrecise])
@@ -1856,7 +2113,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
 
-    NSArray *argArray = @[vectors, compObj, [NSDictionary dictionaryWithDictionary:desc], @(threadMode)];
+    NSArray *argArray = @[vectors, compObj, CopyDesc(desc), @(threadMode)];
     switch (threadMode)
     {
         case MaplyThreadCurrent:
@@ -1885,7 +2142,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     const auto threadMode = (MaplyThreadMode)[[argArray objectAtIndex:4] intValue];
     
     iosDictionary dictWrap(inDesc);
-    VectorInfo vectorInfo(dictWrap);
+    VectorInfo vectorInfo = InfoForDesc<VectorInfo>(inDesc,"VectorInfo",[&]{ return VectorInfo(dictWrap); });
     [self resolveInfoDefaults:inDesc info:&vectorInfo defaultShader:kMaplyDefaultTriangleShader];
     [self resolveDrawPriority:inDesc info:&vectorInfo drawPriority:kMaplyVectorDrawPriorityDefault offset:0];
     
@@ -1917,7 +2174,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
             if (const auto wideVectorManager = scene->getManager<WideVectorManager>(kWKWideVectorManager))
             {
                 iosDictionary dictWrap(inDesc);
-                WideVectorInfo vectorInfo(dictWrap);
+                WideVectorInfo vectorInfo = InfoForDesc<WideVectorInfo>(inDesc,"WideVectorInfo",[&]{ return WideVectorInfo(dictWrap); });
 
                 for (const auto vid : baseObj->contents->wideVectorIDs)
                 {
@@ -1944,7 +2201,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
     
-    NSArray *argArray = @[baseObj, compObj, [NSDictionary dictionaryWithDictionary:desc], [NSNumber numberWithBool:YES], @(threadMode)];
+    NSArray *argArray = @[baseObj, compObj, CopyDesc(desc), [NSNumber numberWithBool:YES], @(threadMode)];
     switch (threadMode)
     {
         case MaplyThreadCurrent:
@@ -1964,7 +2221,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = false;
 
-    NSArray *argArray = @[vectors, compObj, [NSDictionary dictionaryWithDictionary:desc], [NSNumber numberWithBool:NO], @(MaplyThreadCurrent)];
+    NSArray *argArray = @[vectors, compObj, CopyDesc(desc), [NSNumber numberWithBool:NO], @(MaplyThreadCurrent)];
     [self addVectorsRun:argArray];
     
     return compObj;
@@ -1990,7 +2247,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
         if (!vecObj->contents->vectorIDs.empty())
         {
             iosDictionary dictWrap(desc);
-            VectorInfo vectorInfo(dictWrap);
+            VectorInfo vectorInfo = InfoForDesc<VectorInfo>(desc,"VectorInfo",[&]{ return VectorInfo(dictWrap); });
 
             if (const auto vectorManager = scene->getManager<VectorManager>(kWKVectorManager))
             {
@@ -2006,7 +2263,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
         if (!vecObj->contents->wideVectorIDs.empty())
         {
             iosDictionary dictWrap(desc);
-            WideVectorInfo wideVecInfo(dictWrap);
+            WideVectorInfo wideVecInfo = InfoForDesc<WideVectorInfo>(desc,"WideVectorInfo",[&]{ return WideVectorInfo(dictWrap); });
             
             if (const auto wideManager = scene->getManager<WideVectorManager>(kWKWideVectorManager))
             {
@@ -2051,6 +2308,69 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     }
 }
 
+// Actually move the screen markers
+- (void)moveScreenMarkersRun:(NSArray *)argArray
+{
+    if (isShuttingDown || (!layerThread && !offlineMode))
+        return;
+
+    MaplyComponentObject *compObj = [argArray objectAtIndex:0];
+    NSData *locData = [argArray objectAtIndex:1];
+    const TimeInterval duration = [[argArray objectAtIndex:2] doubleValue];
+    MaplyThreadMode threadMode = (MaplyThreadMode)[[argArray objectAtIndex:3] intValue];
+
+    const auto *coords = (const MaplyCoordinate *)[locData bytes];
+    const size_t numCoords = [locData length] / sizeof(MaplyCoordinate);
+    std::vector<GeoCoord> locs;
+    locs.reserve(numCoords);
+    for (size_t ii=0;ii<numCoords;ii++)
+        locs.emplace_back(coords[ii].x,coords[ii].y);
+
+    @synchronized(compObj)
+    {
+        if (!compManager->hasComponentObject(compObj->contents->getId()))
+            return;
+
+        ChangeSet changes;
+        if (const auto markerManager = compManager->markerManager)
+        {
+            for (const auto markerID : compObj->contents->markerIDs)
+            {
+                markerManager->moveMarkers(markerID, locs, duration, changes);
+            }
+        }
+
+        [self flushChanges:changes mode:threadMode];
+    }
+}
+
+// Move a fleet of screen markers
+- (void)moveScreenMarkers:(MaplyComponentObject *)compObj locations:(const MaplyCoordinate *)locs count:(int)count
+                 duration:(NSTimeInterval)duration mode:(MaplyThreadMode)threadMode
+{
+    threadMode = [self resolveThreadMode:threadMode];
+
+    if (!compObj || !locs || count <= 0)
+        return;
+
+    NSData *locData = [NSData dataWithBytes:locs length:count * sizeof(MaplyCoordinate)];
+    NSArray *argArray = @[compObj, locData, @(duration), @(threadMode)];
+
+    // If the object is under construction, toss this over to the layer thread
+    if (compObj->contents->underConstruction)
+        threadMode = MaplyThreadAny;
+
+    switch (threadMode)
+    {
+        case MaplyThreadCurrent:
+            [self moveScreenMarkersRun:argArray];
+            break;
+        case MaplyThreadAny:
+            [self performSelector:@selector(moveScreenMarkersRun:) onThread:layerThread withObject:argArray waitUntilDone:NO];
+            break;
+    }
+}
+
 // Called in the layer thread
 - (void)addShapesRun:(NSArray *)argArray
 {
@@ -2064,7 +2384,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     const auto threadMode = (MaplyThreadMode)[[argArray objectAtIndex:3] intValue];
 
     iosDictionary dictWrap(inDesc);
-    ShapeInfo shapeInfo(dictWrap);
+    ShapeInfo shapeInfo = InfoForDesc<ShapeInfo>(inDesc,"ShapeInfo",[&]{ return ShapeInfo(dictWrap); });
     [self resolveInfoDefaults:inDesc info:&shapeInfo defaultShader:kMaplyDefaultTriangleShader];
     [self resolveDrawPriority:inDesc info:&shapeInfo drawPriority:kMaplyShapeDrawPriorityDefault offset:0];
 
@@ -2228,7 +2548,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
 
-    NSArray *argArray = @[shapes, compObj, [NSDictionary dictionaryWithDictionary:desc], @(threadMode)];
+    NSArray *argArray = @[shapes, compObj, CopyDesc(desc), @(threadMode)];
     switch (threadMode)
     {
         case MaplyThreadCurrent:
@@ -2276,7 +2596,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     const auto threadMode = (MaplyThreadMode)[[argArray objectAtIndex:3] intValue];
     
     iosDictionary dictWrap(inDesc);
-    GeometryInfo geomInfo(dictWrap);
+    GeometryInfo geomInfo = InfoForDesc<GeometryInfo>(inDesc,"GeometryInfo",[&]{ return GeometryInfo(dictWrap); });
     [self resolveInfoDefaults:inDesc info:&geomInfo defaultShader:kMaplyShaderDefaultModelTri];
     [self resolveDrawPriority:inDesc info:&geomInfo drawPriority:kMaplyModelDrawPriorityDefault offset:0];
 
@@ -2512,7 +2832,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
 
-    NSArray *argArray = @[modelInstances, compObj, [NSDictionary dictionaryWithDictionary:desc], @(threadMode)];
+    NSArray *argArray = @[modelInstances, compObj, CopyDesc(desc), @(threadMode)];
     switch (threadMode)
     {
         case MaplyThreadCurrent:
@@ -2533,7 +2853,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
 
-    NSArray *argArray = @[geom, compObj, [NSDictionary dictionaryWithDictionary:desc], @(threadMode)];
+    NSArray *argArray = @[geom, compObj, CopyDesc(desc), @(threadMode)];
     switch (threadMode)
     {
         case MaplyThreadCurrent:
@@ -2559,7 +2879,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     const auto threadMode = (MaplyThreadMode)[[argArray objectAtIndex:3] intValue];
     
     iosDictionary dictWrap(inDesc);
-    SphericalChunkInfo chunkInfo(dictWrap);
+    SphericalChunkInfo chunkInfo = InfoForDesc<SphericalChunkInfo>(inDesc,"SphericalChunkInfo",[&]{ return SphericalChunkInfo(dictWrap); });
     [self resolveInfoDefaults:inDesc info:&chunkInfo defaultShader:kMaplyDefaultTriangleShader];
     [self resolveDrawPriority:inDesc info:&chunkInfo drawPriority:kMaplyStickerDrawPriorityDefault offset:0];
     
@@ -2653,7 +2973,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
 
-    NSArray *argArray = @[stickers, compObj, [NSDictionary dictionaryWithDictionary:desc], @(threadMode)];
+    NSArray *argArray = @[stickers, compObj, CopyDesc(desc), @(threadMode)];
     switch (threadMode)
     {
         case MaplyThreadCurrent:
@@ -2765,7 +3085,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     const auto threadMode = (MaplyThreadMode)[[argArray objectAtIndex:3] intValue];
     
     iosDictionary dictWrap(inDesc);
-    LoftedPolyInfo loftInfo(dictWrap);
+    LoftedPolyInfo loftInfo = InfoForDesc<LoftedPolyInfo>(inDesc,"LoftedPolyInfo",[&]{ return LoftedPolyInfo(dictWrap); });
     [self resolveInfoDefaults:inDesc info:&loftInfo defaultShader:kMaplyDefaultTriangleShader];
     [self resolveDrawPriority:inDesc info:&loftInfo drawPriority:kMaplyLoftedPolysDrawPriorityDefault offset:0];
     
@@ -2799,7 +3119,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
 
-    NSArray *argArray = @[vectors, compObj, [NSDictionary dictionaryWithDictionary:desc], @(threadMode)];
+    NSArray *argArray = @[vectors, compObj, CopyDesc(desc), @(threadMode)];
     switch (threadMode)
     {
         case MaplyThreadCurrent:
@@ -2828,7 +3148,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     CoordSystem *coordSys = coordAdapter->getCoordSystem();
     
     iosDictionary dictWrap(inDesc);
-    BillboardInfo billInfo(dictWrap);
+    BillboardInfo billInfo = InfoForDesc<BillboardInfo>(inDesc,"BillboardInfo",[&]{ return BillboardInfo(dictWrap); });
     
     [self resolveInfoDefaults:inDesc info:&billInfo
                 defaultShader:(billInfo.orient == WhirlyKit::BillboardInfo::Eye ? kMaplyShaderBillboardEye : kMaplyShaderBillboardGround)];
@@ -2968,7 +3288,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
 
-    NSArray *argArray = @[bboards, compObj, [NSDictionary dictionaryWithDictionary:desc], @(threadMode)];
+    NSArray *argArray = @[bboards, compObj, CopyDesc(desc), @(threadMode)];
     switch (threadMode)
     {
         case MaplyThreadCurrent:
@@ -2993,7 +3313,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     const auto threadMode = (MaplyThreadMode)[[argArray objectAtIndex:3] intValue];
     
     iosDictionary dictWrap(inDesc);
-    BaseInfo partInfo(dictWrap);
+    BaseInfo partInfo = InfoForDesc<BaseInfo>(inDesc,"BaseInfo",[&]{ return BaseInfo(dictWrap); });
     [self resolveInfoDefaults:inDesc info:&partInfo defaultShader:kMaplyShaderParticleSystemPointDefault];
     [self resolveDrawPriority:inDesc info:&partInfo drawPriority:kMaplyParticleSystemDrawPriorityDefault offset:0];
     
@@ -3107,7 +3427,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
     
-    NSArray *argArray = @[partSys, compObj, [NSDictionary dictionaryWithDictionary:desc], @(threadMode)];
+    NSArray *argArray = @[partSys, compObj, CopyDesc(desc), @(threadMode)];
     switch (threadMode)
     {
         case MaplyThreadCurrent:
@@ -3136,6 +3456,24 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     }
 }
 
+- (void)changeParticleSystem:(MaplyComponentObject *)compObj textures:(NSArray<MaplyTexture *> *)textures
+{
+    if (const auto partSysManager = scene->getManager<ParticleSystemManager>(kWKParticleSystemManager))
+    {
+        ChangeSet changes;
+
+        std::vector<SimpleIdentity> texIDs;
+        texIDs.reserve([textures count]);
+        for (MaplyTexture *tex in textures)
+            texIDs.push_back(tex.texID);
+        for (SimpleIdentity partSysID : compObj->contents->partSysIDs) {
+            partSysManager->changeTextures(partSysID,texIDs,changes);
+        }
+
+        [self flushChanges:changes mode:MaplyThreadCurrent];
+    }
+}
+
 - (void)addParticleSystemBatchRun:(NSArray *)argArray
 {
     if (isShuttingDown || (!layerThread && !offlineMode))
@@ -3188,7 +3526,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     const auto threadMode = (MaplyThreadMode)[[argArray objectAtIndex:3] intValue];
     
     iosDictionary dictWrap(inDesc);
-    GeometryInfo geomInfo(dictWrap);
+    GeometryInfo geomInfo = InfoForDesc<GeometryInfo>(inDesc,"GeometryInfo",[&]{ return GeometryInfo(dictWrap); });
     if (geomInfo.pointSize == 0.0)
         geomInfo.pointSize = kMaplyPointSizeDefault;
     [self resolveInfoDefaults:inDesc info:&geomInfo defaultShader:kMaplyShaderParticleSystemPointDefault];
@@ -3222,7 +3560,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     MaplyComponentObject *compObj = [[MaplyComponentObject alloc] initWithDesc:desc];
     compObj->contents->underConstruction = true;
     
-    NSArray *argArray = @[points, compObj, [NSDictionary dictionaryWithDictionary:desc], @(threadMode)];
+    NSArray *argArray = @[points, compObj, CopyDesc(desc), @(threadMode)];
     switch (threadMode)
     {
         case MaplyThreadCurrent:
@@ -3252,7 +3590,8 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
                                              [renderTarget.clearColor asRGBAColor],
                                              renderTarget.clearVal,
                                              (RenderTargetMipmapType)renderTarget.mipmapType,
-                                             renderTarget.calculateMinMax));
+                                             renderTarget.calculateMinMax,
+                                             renderTarget.renderWhenChanged));
     
     [self flushChanges:changes mode:MaplyThreadCurrent];
 }
@@ -3641,7 +3980,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     
     pt = visualView->unwrapCoordinate(pt);
     
-    ViewStateRef viewState = vc->renderControl->visualView->makeViewState(vc->renderControl->sceneRenderer.get());
+    ViewStateRef viewState = vc->renderControl->visualView->getViewState(vc->renderControl->sceneRenderer.get());
     
     auto rets = compManager->findVectors(Point2d(pt.x(),pt.y()),20.0,viewState,vc->renderControl->sceneRenderer->getFramebufferSizeScaled(),multi);
     
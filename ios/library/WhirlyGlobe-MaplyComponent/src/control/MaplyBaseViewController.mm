@@ -115,12 +115,27 @@ using namespace WhirlyKit;
 {
     MaplyLocationTracker *_locationTracker;
     bool _layoutFade;
+    bool _layoutIncremental;
+    int _layoutThreads;
+    bool _layoutToggleInPlace;
+    bool _layoutInstancing;
+    bool _layoutClusterHierarchy;
+    NSString *_glyphCacheDir;
+    bool _labelSDF;
+    bool _labelAtlasCompaction;
+    std::mutex _warmUpLock;
+    std::vector<SimpleIdentity> _warmUpStrIDs;
     NSMutableArray<InitCompletionBlock> *_postInitCalls;
 }
 
 - (instancetype)init{
     self = [super init];
     _layoutFade = false;
+    _layoutIncremental = false;
+    _layoutThreads = 0;
+    _layoutToggleInPlace = false;
+    _layoutInstancing = false;
+    _layoutClusterHierarchy = false;
     _postInitCalls = [NSMutableArray new];
     return self;
 }
@@ -211,6 +226,184 @@ using namespace WhirlyKit;
     return _layoutFade;
 }
 
+- (void)setLayoutIncremental:(bool)enable
+{
+    _layoutIncremental = enable;
+    if (auto rc = renderControl)
+    if (auto scene = rc->scene)
+    if (auto layoutManager = scene->getManager<LayoutManager>(kWKLayoutManager))
+    {
+        layoutManager->setIncremental(enable);
+    }
+}
+
+- (bool)layoutIncremental
+{
+    return _layoutIncremental;
+}
+
+- (void)setLayoutThreads:(int)numThreads
+{
+    _layoutThreads = numThreads;
+    if (auto rc = renderControl)
+    if (auto scene = rc->scene)
+    if (auto layoutManager = scene->getManager<LayoutManager>(kWKLayoutManager))
+    {
+        layoutManager->setLayoutThreads(numThreads);
+    }
+}
+
+- (int)layoutThreads
+{
+    return _layoutThreads;
+}
+
+- (void)setLayoutToggleInPlace:(bool)enable
+{
+    _layoutToggleInPlace = enable;
+    if (auto rc = renderControl)
+    if (auto scene = rc->scene)
+    if (auto layoutManager = scene->getManager<LayoutManager>(kWKLayoutManager))
+    {
+        layoutManager->setToggleInPlace(enable);
+    }
+}
+
+- (bool)layoutToggleInPlace
+{
+    return _layoutToggleInPlace;
+}
+
+- (void)setLayoutInstancing:(bool)enable
+{
+    _layoutInstancing = enable;
+    if (auto rc = renderControl)
+    if (auto scene = rc->scene)
+    if (auto layoutManager = scene->getManager<LayoutManager>(kWKLayoutManager))
+    {
+        layoutManager->setInstancing(enable);
+    }
+}
+
+- (bool)layoutInstancing
+{
+    return _layoutInstancing;
+}
+
+- (void)setLayoutClusterHierarchy:(bool)enable
+{
+    _layoutClusterHierarchy = enable;
+    if (auto rc = renderControl)
+    if (auto scene = rc->scene)
+    if (auto layoutManager = scene->getManager<LayoutManager>(kWKLayoutManager))
+    {
+        layoutManager->setClusterHierarchy(enable);
+    }
+}
+
+- (bool)layoutClusterHierarchy
+{
+    return _layoutClusterHierarchy;
+}
+
+- (void)setGlyphCacheDir:(NSString *)dir
+{
+    _glyphCacheDir = [dir copy];
+    if (auto rc = renderControl)
+    if (auto scene = rc->scene)
+    if (auto fontTexManager = scene->getFontTextureManager())
+    {
+        fontTexManager->setGlyphCache(dir ? GlyphCache::getShared([dir UTF8String]) : GlyphCacheRef());
+    }
+}
+
+- (NSString *)glyphCacheDir
+{
+    return _glyphCacheDir;
+}
+
+- (void)setLabelSDF:(bool)labelSDF
+{
+    _labelSDF = labelSDF;
+    if (auto rc = renderControl)
+    if (auto scene = rc->scene)
+    if (auto fontTexManager = scene->getFontTextureManager())
+    {
+        fontTexManager->setSDFMode(labelSDF);
+    }
+}
+
+- (bool)labelSDF
+{
+    return _labelSDF;
+}
+
+- (void)setLabelAtlasCompaction:(bool)labelAtlasCompaction
+{
+    _labelAtlasCompaction = labelAtlasCompaction;
+    if (auto rc = renderControl)
+    if (auto scene = rc->scene)
+    if (auto fontTexManager = scene->getFontTextureManager())
+    {
+        fontTexManager->setAtlasCompaction(labelAtlasCompaction);
+    }
+}
+
+- (bool)labelAtlasCompaction
+{
+    return _labelAtlasCompaction;
+}
+
+- (void)warmUpLabelGlyphs:(NSString *)chars font:(UIFont *)font textColor:(UIColor *)textColor outlineColor:(UIColor *)outlineColor outlineSize:(float)outlineSize
+{
+    const auto rc = renderControl;
+    const auto scene = rc ? rc->scene : nullptr;
+    const auto fontTexManager = scene ? std::dynamic_pointer_cast<FontTextureManager_iOS>(scene->getFontTextureManager()) : nullptr;
+    if (!fontTexManager || chars.length == 0 || !font)
+        return;
+
+    // Same attributes the labels use, or we'd get different glyphs
+    NSMutableAttributedString *attrStr = [[NSMutableAttributedString alloc] initWithString:chars];
+    const NSRange range = NSMakeRange(0, attrStr.length);
+    [attrStr addAttribute:NSFontAttributeName value:font range:range];
+    if (outlineColor && outlineSize > 0.0)
+    {
+        [attrStr addAttribute:kOutlineAttributeSize value:@(outlineSize) range:range];
+        [attrStr addAttribute:kOutlineAttributeColor value:outlineColor range:range];
+        [attrStr addAttribute:NSForegroundColorAttributeName value:(textColor ? textColor : [UIColor whiteColor]) range:range];
+    }
+
+    ChangeSet changes;
+    std::vector<SimpleIdentity> strIDs;
+    fontTexManager->warmUp(nullptr, attrStr, strIDs, changes);
+    scene->addChangeRequests(changes);
+
+    std::lock_guard<std::mutex> guardLock(_warmUpLock);
+    _warmUpStrIDs.insert(_warmUpStrIDs.end(), strIDs.begin(), strIDs.end());
+}
+
+- (void)releaseLabelGlyphWarmUp
+{
+    std::vector<SimpleIdentity> strIDs;
+    {
+        std::lock_guard<std::mutex> guardLock(_warmUpLock);
+        strIDs.swap(_warmUpStrIDs);
+    }
+
+    const auto rc = renderControl;
+    const auto scene = rc ? rc->scene : nullptr;
+    const auto fontTexManager = scene ? scene->getFontTextureManager() : nullptr;
+    if (!fontTexManager || strIDs.empty())
+        return;
+
+    ChangeSet changes;
+    for (const auto strID : strIDs)
+    {
+        fontTexManager->removeString(nullptr, strID, changes, 0.0);
+    }
+    scene->addChangeRequests(changes);
+}
+
 // Kick off the analytics logic.  First we need the server name.
 - (void)startAnalytics
 {
@@ -275,6 +468,7 @@ using namespace WhirlyKit;
 // For specific parts we'll call our subclasses
 - (void) loadSetup
 {
+    const TimeInterval setupStart = TimeGetCurrent();
 #if !TARGET_OS_SIMULATOR
     [self startAnalytics];
 #endif
@@ -283,10 +477,14 @@ using namespace WhirlyKit;
         renderControl = [[MaplyRenderController alloc] init];
     
     renderControl->renderType = SceneRenderer::RenderMetal;
+    renderControl->fastStartup = _fastStartup;
+    renderControl->setupStartTime = setupStart;
     
     allowRepositionForAnnnotations = true;
         
     [renderControl loadSetup];
+    StartupTimeline &startup = renderControl->sceneRenderer->getStartupTimeline();
+    startup.begin("view setup");
     [self loadSetup_mtlView];
     
     // Set up the GL View to display it in
@@ -297,6 +495,7 @@ using namespace WhirlyKit;
 	self.view.autoresizesSubviews = YES;
 	wrapView.frame = self.view.bounds;
     wrapView.backgroundColor = [UIColor blackColor];
+    startup.end("view setup");
         
     [renderControl loadSetup_view:[self loadSetup_view]];
     [renderControl loadSetup_scene:[self loadSetup_interactionLayer]];
@@ -311,6 +510,20 @@ using namespace WhirlyKit;
 
     // Apply layout fade option set before init to the newly-created manager
     [self setLayoutFade:_layoutFade];
+    [self setLayoutIncremental:_layoutIncremental];
+    [self setLayoutToggleInPlace:_layoutToggleInPlace];
+    [self setLayoutInstancing:_layoutInstancing];
+    [self setLayoutClusterHierarchy:_layoutClusterHierarchy];
+    if (_glyphCacheDir)
+    {
+        [self setGlyphCacheDir:_glyphCacheDir];
+    }
+    [self setLabelSDF:_labelSDF];
+    [self setLabelAtlasCompaction:_labelAtlasCompaction];
+    if (_layoutThreads > 0)
+    {
+        [self setLayoutThreads:_layoutThreads];
+    }
 
     // Set up defaults for the hints
     NSDictionary *newHints = [NSDictionary dictionary];
@@ -326,6 +539,8 @@ using namespace WhirlyKit;
                                              selector:@selector(appForeground:)
                                                  name:UIApplicationWillEnterForegroundNotification
                                                object:nil];
+
+    startup.add("controller setup",setupStart,TimeGetCurrent());
 }
 
 - (void)loadSetup_lighting
@@ -393,6 +608,10 @@ using namespace WhirlyKit;
     {
         [t pause];
     }
+
+    // Good time to write out any new pipelines
+    if (const auto sceneRenderMTL = std::dynamic_pointer_cast<SceneRendererMTL>(renderControl->sceneRenderer))
+        sceneRenderMTL->savePipelineArchive();
 }
 
 - (void)appForeground:(NSNotification *)note
@@ -442,6 +661,59 @@ using namespace WhirlyKit;
 - (void)didReceiveMemoryWarning
 {
     [super didReceiveMemoryWarning];
+
+    // Caches first, then the tiles we can spare, then the glyph atlas
+    [self trimMemory:MaplyMemoryTrimAtlasPages];
+}
+
+- (NSDictionary<NSString *,NSNumber *> *)memoryUsage
+{
+    if (!renderControl || !renderControl->scene)
+        return @{};
+
+    const MemoryUsage usage = renderControl->scene->getMemoryGovernor().getUsage();
+    return @{@"textures": @(usage.bytes[MemTextures]),
+             @"vertexBuffers": @(usage.bytes[MemVertexBuffers]),
+             @"atlases": @(usage.bytes[MemAtlases]),
+             @"caches": @(usage.bytes[MemCaches]),
+             @"parsedTiles": @(usage.bytes[MemParsedTiles]),
+             @"total": @(usage.total())};
+}
+
+static NSDictionary *MemoryLedgerDictionary(const MemoryLedger::EntryMap &entries)
+{
+    NSMutableDictionary *ret = [NSMutableDictionary dictionaryWithCapacity:entries.size()];
+    for (const auto &it : entries)
+    {
+        ret[@(it.first.c_str())] = @{@"count": @(it.second.count),
+                                     @"cpuBytes": @(it.second.cpuBytes),
+                                     @"gpuBytes": @(it.second.gpuBytes)};
+    }
+    return ret;
+}
+
+- (NSDictionary<NSString *,NSDictionary<NSString *,NSNumber *> *> *)memoryUsageByOwner
+{
+    if (!renderControl || !renderControl->scene)
+        return @{};
+
+    return MemoryLedgerDictionary(renderControl->scene->getMemoryLedger().getByOwner());
+}
+
+- (NSDictionary<NSString *,NSDictionary<NSString *,NSNumber *> *> *)memoryUsageByType
+{
+    if (!renderControl || !renderControl->scene)
+        return @{};
+
+    return MemoryLedgerDictionary(renderControl->scene->getMemoryLedger().getByType());
+}
+
+- (void)trimMemory:(MaplyMemoryTrimLevel)level
+{
+    if (!renderControl || !renderControl->scene)
+        return;
+
+    renderControl->scene->trimMemory(nullptr, (MemoryTrimLevel)level);
 }
 
 - (void)setFrameInterval:(int)frameInterval
@@ -456,6 +728,26 @@ using namespace WhirlyKit;
             mtlView.preferredFramesPerSecond = 60 / frameInterval;
         }
     }
+
+    // The view asks the pacer what rate to run at, so that's where the limit goes
+    if (renderControl && renderControl->sceneRenderer)
+    {
+        const NSInteger rate = (frameInterval <= 0) ? 120 : 60 / frameInterval;
+        renderControl->sceneRenderer->getFramePacer().setDisplayRate((int)MIN(rate, UIScreen.mainScreen.maximumFramesPerSecond));
+    }
+}
+
+- (void)setFramePacing:(MaplyFramePacing)framePacing
+{
+    if (renderControl && renderControl->sceneRenderer)
+        renderControl->sceneRenderer->getFramePacer().setMode((FramePacer::Mode)framePacing);
+}
+
+- (MaplyFramePacing)framePacing
+{
+    if (renderControl && renderControl->sceneRenderer)
+        return (MaplyFramePacing)renderControl->sceneRenderer->getFramePacer().getMode();
+    return MaplyFramePacingFull;
 }
 
 static const float PerfOutputDelay = 15.0;
@@ -512,6 +804,166 @@ static const float PerfOutputDelay = 15.0;
     return _performanceOutput;
 }
 
+- (void)setFrameStatsEnabled:(bool)frameStatsEnabled
+{
+    if (renderControl && renderControl->sceneRenderer)
+        renderControl->sceneRenderer->getFrameStats().setEnable(frameStatsEnabled);
+}
+
+- (bool)frameStatsEnabled
+{
+    return renderControl && renderControl->sceneRenderer &&
+           renderControl->sceneRenderer->getFrameStats().isEnabled();
+}
+
+- (NSDictionary<NSString *,NSDictionary<NSString *,NSNumber *> *> *)frameStats
+{
+    if (![self frameStatsEnabled])
+        return nil;
+
+    const auto summaries = renderControl->sceneRenderer->getFrameStats().getSummaries();
+    NSMutableDictionary *ret = [NSMutableDictionary dictionaryWithCapacity:summaries.size()];
+    for (const auto &summary : summaries)
+    {
+        ret[@(FrameStats::getMetricName(summary.metric))] =
+            @{@"count": @(summary.numFrames),
+              @"min": @(summary.minVal),
+              @"max": @(summary.maxVal),
+              @"mean": @(summary.mean),
+              @"p50": @(summary.p50),
+              @"p95": @(summary.p95),
+              @"p99": @(summary.p99)};
+    }
+    return ret;
+}
+
+- (void)clearFrameStats
+{
+    if (renderControl && renderControl->sceneRenderer)
+        renderControl->sceneRenderer->getFrameStats().clear();
+}
+
+- (void)setGpuCulling:(bool)gpuCulling
+{
+    if (const auto sceneRenderMTL = renderControl ? std::dynamic_pointer_cast<SceneRendererMTL>(renderControl->sceneRenderer) : nullptr)
+        sceneRenderMTL->setGPUCulling(gpuCulling);
+}
+
+- (bool)gpuCulling
+{
+    const auto sceneRenderMTL = renderControl ? std::dynamic_pointer_cast<SceneRendererMTL>(renderControl->sceneRenderer) : nullptr;
+    return sceneRenderMTL && sceneRenderMTL->getGPUCulling();
+}
+
+- (void)setChangeTimeBudget:(NSTimeInterval)changeTimeBudget
+{
+    if (renderControl && renderControl->scene)
+        renderControl->scene->setChangeBudget(changeTimeBudget, renderControl->scene->getChangeByteBudget());
+}
+
+- (NSTimeInterval)changeTimeBudget
+{
+    return (renderControl && renderControl->scene) ? renderControl->scene->getChangeTimeBudget() : 0.0;
+}
+
+- (void)setChangeByteBudget:(NSUInteger)changeByteBudget
+{
+    if (renderControl && renderControl->scene)
+        renderControl->scene->setChangeBudget(renderControl->scene->getChangeTimeBudget(), changeByteBudget);
+}
+
+- (NSUInteger)changeByteBudget
+{
+    return (renderControl && renderControl->scene) ? renderControl->scene->getChangeByteBudget() : 0;
+}
+
+- (void)setDynamicResolution:(bool)enable minScale:(float)minScale maxScale:(float)maxScale
+{
+    if (renderControl && renderControl->sceneRenderer)
+    {
+        renderControl->sceneRenderer->getDynamicResolution().setScaleRange(minScale,maxScale);
+        renderControl->sceneRenderer->getDynamicResolution().setEnabled(enable);
+    }
+}
+
+- (float)dynamicResolutionScale
+{
+    return (renderControl && renderControl->sceneRenderer) ?
+        renderControl->sceneRenderer->getDynamicResolution().getScale() : 1.0f;
+}
+
+- (void)setGpuTimingsEnabled:(bool)gpuTimingsEnabled
+{
+    if (renderControl && renderControl->sceneRenderer)
+        renderControl->sceneRenderer->getGPUTimings().setEnable(gpuTimingsEnabled);
+}
+
+- (bool)gpuTimingsEnabled
+{
+    return renderControl && renderControl->sceneRenderer &&
+           renderControl->sceneRenderer->getGPUTimings().isEnabled();
+}
+
+- (NSDictionary<NSString *,NSDictionary<NSString *,NSNumber *> *> *)gpuTimings
+{
+    if (![self gpuTimingsEnabled])
+        return nil;
+
+    const auto summaries = renderControl->sceneRenderer->getGPUTimings().getSummaries();
+    NSMutableDictionary *ret = [NSMutableDictionary dictionaryWithCapacity:summaries.size()];
+    for (const auto &summary : summaries)
+    {
+        ret[@(GPUTimings::getPhaseName(summary.phase))] =
+            @{@"count": @(summary.numFrames),
+              @"min": @(summary.minVal),
+              @"max": @(summary.maxVal),
+              @"mean": @(summary.mean),
+              @"p50": @(summary.p50),
+              @"p95": @(summary.p95),
+              @"p99": @(summary.p99)};
+    }
+    return ret;
+}
+
+- (void)clearGPUTimings
+{
+    if (renderControl && renderControl->sceneRenderer)
+        renderControl->sceneRenderer->getGPUTimings().clear();
+}
+
+- (NSArray<NSDictionary<NSString *,id> *> *)startupTimings
+{
+    if (!renderControl || !renderControl->sceneRenderer)
+        return @[];
+
+    const auto phases = renderControl->sceneRenderer->getStartupTimeline().getPhases();
+    NSMutableArray *ret = [NSMutableArray arrayWithCapacity:phases.size()];
+    for (const auto &phase : phases)
+    {
+        [ret addObject:@{@"name": @(phase.name.c_str()),
+                         @"start": @(phase.start),
+                         @"end": @(phase.end)}];
+    }
+    return ret;
+}
+
+- (void)setTraceRecording:(bool)traceRecording
+{
+    _traceRecording = traceRecording;
+    TraceZones::setRecording(traceRecording);
+}
+
+- (void)setTraceSignposts:(bool)traceSignposts
+{
+    _traceSignposts = traceSignposts;
+    TraceZones::setSystemTracing(traceSignposts);
+}
+
+- (NSString *)traceJSON
+{
+    return [NSString stringWithUTF8String:TraceZones::getChromeTrace().c_str()];
+}
+
 // Build an array of lights and send them down all at once
 - (void)updateLights
 {
@@ -563,6 +1015,16 @@ static const float PerfOutputDelay = 15.0;
     [renderControl stopMaskTarget];
 }
 
+- (void)startSelectionIDTarget:(NSNumber * __nullable)inScale
+{
+    [renderControl startSelectionIDTarget:inScale];
+}
+
+- (void)stopSelectionIDTarget
+{
+    [renderControl stopSelectionIDTarget];
+}
+
 #pragma mark - Defaults and descriptions
 
 // Set new hints and update any related settings
@@ -585,6 +1047,12 @@ static const float PerfOutputDelay = 15.0;
     return [self addScreenMarkers:markers desc:desc mode:MaplyThreadAny];
 }
 
+- (MaplyComponentObject *)addScreenMarkerStructs:(const MaplyScreenMarkerStruct *)markers count:(NSUInteger)count
+                                       textures:(NSArray<MaplyTexture *> *)textures desc:(NSDictionary *)desc mode:(MaplyThreadMode)threadMode
+{
+    return [renderControl addScreenMarkerStructs:markers count:count textures:textures desc:desc mode:threadMode];
+}
+
 - (void)addClusterGenerator:(NSObject <MaplyClusterGenerator> *)clusterGen
 {
     if (!renderControl)
@@ -618,6 +1086,12 @@ static const float PerfOutputDelay = 15.0;
     return [self addScreenLabels:labels desc:desc mode:MaplyThreadAny];
 }
 
+- (MaplyComponentObject *)addScreenLabelStructs:(const MaplyScreenLabelStruct *)labels count:(NSUInteger)count
+                                          text:(const char *)text length:(NSUInteger)length desc:(NSDictionary *)desc mode:(MaplyThreadMode)threadMode
+{
+    return [renderControl addScreenLabelStructs:labels count:count text:text length:length desc:desc mode:threadMode];
+}
+
 - (MaplyComponentObject *)addLabels:(NSArray *)labels desc:(NSDictionary *)desc mode:(MaplyThreadMode)threadMode
 {
     MaplyComponentObject *compObj = [renderControl addLabels:labels desc:desc mode:threadMode];
@@ -679,6 +1153,11 @@ static const float PerfOutputDelay = 15.0;
     return [renderControl changeParticleSystem:compObj renderTarget:target];
 }
 
+- (void)changeParticleSystem:(MaplyComponentObject *__nonnull)compObj textures:(NSArray<MaplyTexture *> *__nonnull)textures
+{
+    [renderControl changeParticleSystem:compObj textures:textures];
+}
+
 - (void)addParticleBatch:(MaplyParticleBatch *)batch mode:(MaplyThreadMode)threadMode
 {
     [renderControl addParticleBatch:batch mode:threadMode];
@@ -697,6 +1176,12 @@ static const float PerfOutputDelay = 15.0;
     [renderControl changeVector:compObj desc:desc mode:threadMode];
 }
 
+- (void)moveScreenMarkers:(MaplyComponentObject *)compObj locations:(const MaplyCoordinate *)locs count:(int)count
+                 duration:(NSTimeInterval)duration mode:(MaplyThreadMode)threadMode
+{
+    [renderControl moveScreenMarkers:compObj locations:locs count:count duration:duration mode:threadMode];
+}
+
 - (void)changeVector:(MaplyComponentObject *)compObj desc:(NSDictionary *)desc
 {
     [self changeVector:compObj desc:desc mode:MaplyThreadAny];
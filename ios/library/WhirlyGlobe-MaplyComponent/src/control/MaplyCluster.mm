@@ -64,14 +64,19 @@
         self.selectable = true;
         self.markerAnimationTime = 0.2;
         viewC = inViewC;
+        imagesByNumber = [NSMutableDictionary dictionary];
     }
     
     return self;
 }
 
+// Images are kept from one layout to the next, so the layer can reuse their textures
+static const int MaxCachedImages = 256;
+
 - (void)startClusterGroup
 {
-    imagesByNumber = [NSMutableDictionary dictionary];    
+    if ([imagesByNumber count] > MaxCachedImages)
+        [imagesByNumber removeAllObjects];
 }
 
 - (MaplyClusterGroup *__nonnull) makeClusterGroup:(MaplyClusterInfo *__nonnull)clusterInfo
@@ -117,7 +122,6 @@
 
 - (void)endClusterGroup
 {
-    imagesByNumber = nil;
 }
 
 @end
@@ -0,0 +1,89 @@
+/*  MaplyDescription.mm
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "MaplyDescription_private.h"
+#import <mutex>
+#import <string>
+#import <unordered_map>
+
+using namespace WhirlyKit;
+
+@implementation MaplyDescription
+{
+    NSDictionary *dict;
+    std::mutex infoLock;
+    // Parsed versions, by the kind of object they're for
+    std::unordered_map<std::string,BaseInfoRef> infos;
+}
+
+- (instancetype)init
+{
+    return [self initWithObjects:nil forKeys:nil count:0];
+}
+
+- (instancetype)initWithDictionary:(NSDictionary *)inDict
+{
+    if ((self = [super init]))
+    {
+        dict = inDict ? [inDict copy] : @{};
+    }
+    return self;
+}
+
+- (instancetype)initWithObjects:(const id [])objects forKeys:(const id<NSCopying> [])keys count:(NSUInteger)count
+{
+    if ((self = [super init]))
+    {
+        dict = [[NSDictionary alloc] initWithObjects:objects forKeys:keys count:count];
+    }
+    return self;
+}
+
+- (NSUInteger)count
+{
+    return dict.count;
+}
+
+- (id)objectForKey:(id)key
+{
+    return [dict objectForKey:key];
+}
+
+- (NSEnumerator *)keyEnumerator
+{
+    return [dict keyEnumerator];
+}
+
+// Immutable, so the cached info stays good
+- (id)copyWithZone:(NSZone *)zone
+{
+    return self;
+}
+
+- (BaseInfoRef)infoForKey:(const char *)key make:(const std::function<BaseInfoRef()> &)make
+{
+    std::lock_guard<std::mutex> guardLock(infoLock);
+
+    auto &info = infos[key];
+    if (!info)
+    {
+        info = make();
+    }
+    return info;
+}
+
+@end
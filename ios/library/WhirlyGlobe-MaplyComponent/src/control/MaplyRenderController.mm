@@ -31,6 +31,7 @@
 #import "MaplyActiveObject_private.h"
 #import "MaplyRenderTarget_private.h"
 #import "WorkRegion_private.h"
+#import "OfflineRunner.h"
 
 using namespace WhirlyKit;
 using namespace Eigen;
@@ -114,6 +115,8 @@ using namespace Eigen;
     for (auto tileFetcher : tileFetchers)
         [tileFetcher shutdown];
     tileFetchers.clear();
+    // These go away with the scene
+    targetTexPool.clear();
     
     // This stuff is our responsibility if we created it
     if (offlineMode) {
@@ -182,6 +185,7 @@ using namespace Eigen;
 - (void)loadSetup
 {
     screenDrawPriorityOffset = 1000000;
+    const TimeInterval setupStart = (setupStartTime > 0.0) ? setupStartTime : TimeGetCurrent();
     
     id<MTLDevice> mtlDevice = MTLCreateSystemDefaultDevice();
     NSError *err = nil;
@@ -189,11 +193,37 @@ using namespace Eigen;
     if (err) {
         NSLog(@"Failed to set up default Metal library in MaplyRenderController::loadSetup.  Things will be missing.");
     }
+    defaultLibrary = mtlLib;
     SceneRendererMTLRef sceneRendererMTL = std::make_shared<SceneRendererMTL>(mtlDevice,mtlLib,1.0);
     if (offlineMode)
         sceneRendererMTL->setup((int)initialFramebufferSize.width,(int)initialFramebufferSize.height, true);
+    sceneRendererMTL->setFastStartup(fastStartup);
+    sceneRendererMTL->getStartupTimeline().restart(setupStart);
+    sceneRendererMTL->getStartupTimeline().add("renderer setup",setupStart,TimeGetCurrent());
+
+    // Compiled pipelines are kept between runs so the first frames don't stall on them.
+    // The archive can be big, so read it in while the rest of the setup goes on.
+    // Pipelines asked for before it's in just get compiled.
+    NSString *cacheDir = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+    if (cacheDir)
+    {
+        NSString *archivePath = [cacheDir stringByAppendingPathComponent:@"MaplyPipelines.metallib"];
+        std::weak_ptr<SceneRendererMTL> weakRender = sceneRendererMTL;
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+            if (const auto render = weakRender.lock())
+            {
+                StartupPhase phase(render->getStartupTimeline(),"pipeline archive");
+                render->setPipelineArchivePath(archivePath);
+            }
+        });
+    }
     sceneRenderer = sceneRendererMTL;
 
+    // The shaders need their functions from the library, which is slow one at a time.
+    // On a fast start look them all up at once while the view and scene get set up.
+    if (fastStartup && mtlLib)
+        [self prefetchShaderFunctions:mtlLib];
+
     sceneRenderer->setZBufferMode(zBufferOffDefault);
     sceneRenderer->setClearColor([[UIColor blackColor] asRGBAColor]);
     
@@ -201,6 +231,32 @@ using namespace Eigen;
     sceneRenderer->setUseViewChanged(true);
 }
 
+// Look up all the functions in the library in parallel, for setupShaders
+- (void)prefetchShaderFunctions:(id<MTLLibrary>)mtlLib
+{
+    NSArray<NSString *> *names = mtlLib.functionNames;
+    NSMutableDictionary<NSString *,id<MTLFunction>> *funcs = [NSMutableDictionary dictionaryWithCapacity:names.count];
+    shaderFunctions = funcs;
+    shaderFunctionsGroup = dispatch_group_create();
+
+    std::weak_ptr<SceneRenderer> weakRender = sceneRenderer;
+    dispatch_queue_t workQueue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+    dispatch_group_async(shaderFunctionsGroup, workQueue, ^{
+        const auto render = weakRender.lock();
+        if (!render)
+            return;
+        StartupPhase phase(render->getStartupTimeline(),"shader functions");
+        dispatch_apply(names.count, workQueue, ^(size_t ii) {
+            if (id<MTLFunction> func = [mtlLib newFunctionWithName:names[ii]])
+            {
+                @synchronized (funcs) {
+                    funcs[names[ii]] = func;
+                }
+            }
+        });
+    });
+}
+
 - (void)loadSetup_view:(WhirlyKit::ViewRef)view
 {
     visualView = view;
@@ -208,12 +264,17 @@ using namespace Eigen;
 
 - (void)loadSetup_scene:(MaplyBaseInteractionLayer *)newInteractLayer
 {
+    StartupTimeline &startup = sceneRenderer->getStartupTimeline();
+    startup.begin("scene setup");
+
     scene = new SceneMTL(visualView->coordAdapter);
     sceneRenderer->setScene(scene);
 
     // Set up a Font Texture Manager
     fontTexManager = std::make_shared<FontTextureManager_iOS>(sceneRenderer.get(),scene);
     scene->setFontTextureManager(fontTexManager);
+    scene->getMemoryGovernor().addConsumer(std::dynamic_pointer_cast<SceneRendererMTL>(sceneRenderer));
+    startup.end("scene setup");
     
     layerThreads = [NSMutableArray array];
     
@@ -233,11 +294,14 @@ using namespace Eigen;
     // Give the renderer what it needs
     sceneRenderer->setView(visualView.get());
     
+    startup.begin("default shaders");
     [self setupShaders];
+    startup.end("default shaders");
     
     // Kick off the layer thread
     // This will start loading things
     [baseLayerThread start];
+    startup.mark("layer thread started");
     
     // Default cluster generator
     defaultClusterGenerator = [[MaplyBasicClusterGenerator alloc] initWithColors:@[[UIColor orangeColor]] clusterNumber:0 size:CGSizeMake(32,32) viewC:self];
@@ -289,6 +353,54 @@ using namespace Eigen;
     return toRet;
 }
 
+// Set up to draw offline frames until the sampling layers are done
+- (std::shared_ptr<OfflineRunner>)makeOfflineRunner
+{
+    SceneRendererMTLRef sceneRendererMTL = std::dynamic_pointer_cast<SceneRendererMTL>(sceneRenderer);
+    if (!sceneRendererMTL || !scene)
+        return nullptr;
+
+    const auto runner = std::make_shared<OfflineRunner>(scene,sceneRendererMTL.get(),[sceneRendererMTL]{
+        @autoreleasepool {
+            sceneRendererMTL->render(1.0/60.0,nil,nil);
+        }
+    });
+    for (MaplyQuadSamplingLayer *layer : samplingLayers)
+    {
+        MaplyQuadSamplingLayer * __weak weakLayer = layer;
+        runner->addBusyCheck([weakLayer]{ return weakLayer && [weakLayer isLoading]; });
+    }
+    return runner;
+}
+
+- (NSData *)renderToImageDataWhenLoaded:(NSTimeInterval)timeout
+{
+    const auto runner = [self makeOfflineRunner];
+    if (!runner)
+        return nil;
+
+    OfflineRunner::Params params;
+    params.settleTimeout = timeout;
+    OfflineRunner::Result result;
+    runner->settle(params,result);
+
+    return [self renderToImageData];
+}
+
+- (NSString *)runOfflineBenchmark:(int)frames settleTimeout:(NSTimeInterval)timeout
+{
+    const auto runner = [self makeOfflineRunner];
+    if (!runner)
+        return nil;
+
+    OfflineRunner::Params params;
+    params.settleTimeout = timeout;
+    params.frames = frames;
+    const auto result = runner->run(params);
+
+    return [NSString stringWithUTF8String:OfflineRunner::ToJSON(result).c_str()];
+}
+
 - (void)clearLights
 {
     lights = nil;
@@ -448,6 +560,18 @@ using namespace Eigen;
     return nil;
 }
 
+- (MaplyComponentObject *__nullable)addScreenMarkerStructs:(const MaplyScreenMarkerStruct *__nonnull)markers count:(NSUInteger)count
+                                                 textures:(NSArray<MaplyTexture *> *__nullable)textures desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode
+{
+    if (count == 0)
+        return nil;
+
+    if (auto wr = WorkRegion(interactLayer)) {
+        return [interactLayer addScreenMarkerStructs:markers count:count textures:textures desc:desc mode:threadMode];
+    }
+    return nil;
+}
+
 - (MaplyComponentObject *__nullable)addMarkers:(NSArray *__nonnull)markers desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode
 {
     if ([markers count] == 0)
@@ -470,6 +594,18 @@ using namespace Eigen;
     return nil;
 }
 
+- (MaplyComponentObject *__nullable)addScreenLabelStructs:(const MaplyScreenLabelStruct *__nonnull)labels count:(NSUInteger)count
+                                                    text:(const char *__nonnull)text length:(NSUInteger)length desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode
+{
+    if (count == 0)
+        return nil;
+
+    if (auto wr = WorkRegion(interactLayer)) {
+        return [interactLayer addScreenLabelStructs:labels count:count text:text length:length desc:desc mode:threadMode];
+    }
+    return nil;
+}
+
 - (MaplyComponentObject *__nullable)addLabels:(NSArray *__nonnull)labels desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode
 {
     if ([labels count] == 0)
@@ -546,6 +682,17 @@ using namespace Eigen;
     }
 }
 
+- (void)moveScreenMarkers:(MaplyComponentObject *__nonnull)compObj locations:(const MaplyCoordinate *__nonnull)locs count:(int)count
+                 duration:(NSTimeInterval)duration mode:(MaplyThreadMode)threadMode
+{
+    if (!compObj)
+        return;
+
+    if (auto wr = WorkRegion(interactLayer)) {
+        [interactLayer moveScreenMarkers:compObj locations:locs count:count duration:duration mode:threadMode];
+    }
+}
+
 - (MaplyComponentObject *__nullable)addShapes:(NSArray *__nonnull)shapes desc:(NSDictionary *__nullable)desc mode:(MaplyThreadMode)threadMode
 {
     if ([shapes count] == 0)
@@ -615,6 +762,21 @@ using namespace Eigen;
     }
 }
 
+- (void)changeParticleSystem:(MaplyComponentObject *__nonnull)compObj textures:(NSArray<MaplyTexture *> *__nonnull)textures
+{
+    if (!compObj)
+        return;
+
+    if ([NSThread currentThread] != mainThread) {
+        NSLog(@"MaplyBaseViewController: changeParticleSystem:textures: must be called on main thread");
+        return;
+    }
+    
+    if (auto wr = WorkRegion(interactLayer)) {
+        [interactLayer changeParticleSystem:compObj textures:textures];
+    }
+}
+
 - (void)addParticleBatch:(MaplyParticleBatch *)batch mode:(MaplyThreadMode)threadMode
 {
     if (![batch isValid])
@@ -778,6 +940,99 @@ using namespace Eigen;
     }
 }
 
+// Only a few full size textures are worth holding on to
+static const int MaxPooledTargetTextures = 4;
+
+- (MaplyTexture *)takePooledTargetTexture:(MaplyQuadImageFormat)type sizeX:(int)sizeX sizeY:(int)sizeY
+{
+    for (auto it = targetTexPool.begin(); it != targetTexPool.end(); ++it) {
+        MaplyTexture *tex = it->second;
+        if (it->first == type && tex.width == sizeX && tex.height == sizeY) {
+            targetTexPool.erase(it);
+            return tex;
+        }
+    }
+    return nil;
+}
+
+- (bool)poolTargetTexture:(MaplyTexture *)tex type:(MaplyQuadImageFormat)type
+{
+    if (!tex || !scene)
+        return false;
+
+    // Anything bigger than the framebuffer is from before a resize and won't be asked for again
+    const CGSize screenSize = [self getFramebufferSize];
+    NSMutableArray *staleTexs = [NSMutableArray array];
+    for (auto it = targetTexPool.begin(); it != targetTexPool.end();) {
+        if (it->second.width > screenSize.width || it->second.height > screenSize.height) {
+            [staleTexs addObject:it->second];
+            it = targetTexPool.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (tex.width <= screenSize.width && tex.height <= screenSize.height) {
+        if (targetTexPool.size() >= MaxPooledTargetTextures) {
+            [staleTexs addObject:targetTexPool.front().second];
+            targetTexPool.erase(targetTexPool.begin());
+        }
+        targetTexPool.emplace_back(type, tex);
+    } else {
+        tex = nil;
+    }
+    if ([staleTexs count] > 0) {
+        [self removeTextures:staleTexs mode:MaplyThreadCurrent];
+    }
+
+    return tex != nil;
+}
+
+- (void)startSelectionIDTarget:(NSNumber * __nullable)inScale
+{
+    if (selectIDRenderTarget || !scene)
+        return;
+
+    const double scale = inScale ? [inScale doubleValue] : 0.25;
+
+    CGSize screenSize = [self getFramebufferSize];
+    if (screenSize.width == 0.0) {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.01 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+            [self startSelectionIDTarget:inScale];
+        });
+        return;
+    }
+
+    screenSize.width *= scale;
+    screenSize.height *= scale;
+
+    selectIDTex = [self createTexture:@{kMaplyTexFormat: @(MaplyImageUInt32)} sizeX:screenSize.width sizeY:screenSize.height mode:MaplyThreadCurrent];
+    selectIDRenderTarget = [[MaplyRenderTarget alloc] init];
+    selectIDRenderTarget.texture = selectIDTex;
+    [self addRenderTarget:selectIDRenderTarget];
+
+    if (const auto selectManager = scene->getManager<SelectionManager>(kWKSelectionManager)) {
+        selectManager->setIDBuffer([selectIDRenderTarget renderTargetID],scale);
+    }
+}
+
+- (void)stopSelectionIDTarget
+{
+    if (scene) {
+        if (const auto selectManager = scene->getManager<SelectionManager>(kWKSelectionManager)) {
+            selectManager->setIDBuffer(EmptyIdentity,1.0);
+        }
+    }
+
+    if (selectIDRenderTarget) {
+        [self removeRenderTarget:selectIDRenderTarget];
+        selectIDRenderTarget = nil;
+    }
+    if (selectIDTex) {
+        [self removeTextures:@[selectIDTex] mode:MaplyThreadCurrent];
+        selectIDTex = nil;
+    }
+}
+
 
 - (void)removeObjects:(NSArray *__nonnull)theObjs mode:(MaplyThreadMode)threadMode
 {
@@ -948,19 +1203,37 @@ using namespace Eigen;
     bool isGlobe = !scene->getCoordAdapter()->isFlat();
 
     // Get the default library.  This should be bundled with WhirlyGlobe-Maply
-    SceneRendererMTL *sceneRenderMTL = (SceneRendererMTL *)sceneRenderer.get();
-    id<MTLDevice> mtlDevice = ((RenderSetupInfoMTL *)sceneRenderMTL->getRenderSetupInfo())->mtlDevice;
-    NSError *err = nil;
-    id<MTLLibrary> mtlLib = [mtlDevice newDefaultLibraryWithBundle:[NSBundle bundleForClass:[MaplyRenderController class]] error:&err];
+    id<MTLLibrary> mtlLib = defaultLibrary;
+    if (!mtlLib)
+    {
+        SceneRendererMTL *sceneRenderMTL = (SceneRendererMTL *)sceneRenderer.get();
+        id<MTLDevice> mtlDevice = ((RenderSetupInfoMTL *)sceneRenderMTL->getRenderSetupInfo())->mtlDevice;
+        NSError *err = nil;
+        mtlLib = [mtlDevice newDefaultLibraryWithBundle:[NSBundle bundleForClass:[MaplyRenderController class]] error:&err];
+    }
+
+    // Functions looked up in the background for a fast start
+    NSDictionary<NSString *,id<MTLFunction>> *funcs = nil;
+    if (shaderFunctionsGroup)
+    {
+        dispatch_group_wait(shaderFunctionsGroup, DISPATCH_TIME_FOREVER);
+        funcs = shaderFunctions;
+        shaderFunctions = nil;
+        shaderFunctionsGroup = nil;
+    }
+    id<MTLFunction> (^shaderFunc)(NSString *) = ^id<MTLFunction>(NSString *name) {
+        id<MTLFunction> func = funcs[name];
+        return func ? func : [mtlLib newFunctionWithName:name];
+    };
     
     auto defaultLineShader = std::make_shared<ProgramMTL>(
         [kMaplyShaderDefaultLine cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexLineOnly_globe"],
-        [mtlLib newFunctionWithName:@"fragmentLineOnly_globe"]);
+        shaderFunc(@"vertexLineOnly_globe"),
+        shaderFunc(@"fragmentLineOnly_globe"));
     auto defaultLineShaderNoBack = std::make_shared<ProgramMTL>(
         [kMaplyShaderDefaultLineNoBackface cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexLineOnly_flat"],
-        [mtlLib newFunctionWithName:@"fragmentLineOnly_flat"]);
+        shaderFunc(@"vertexLineOnly_flat"),
+        shaderFunc(@"fragmentLineOnly_flat"));
 
     [self addShader:kMaplyShaderDefaultLine program:isGlobe ? defaultLineShader : defaultLineShaderNoBack];
     [self addShader:kMaplyShaderDefaultLineNoBackface program:defaultLineShaderNoBack];
@@ -968,97 +1241,144 @@ using namespace Eigen;
     // Default triangle shaders
     [self addShader:kMaplyShaderDefaultTri program: std::make_shared<ProgramMTL>(
         [kMaplyShaderDefaultTri cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_light"],
-        [mtlLib newFunctionWithName:@"fragmentTri_basic"])];
+        shaderFunc(@"vertexTri_light"),
+        shaderFunc(@"fragmentTri_basic"))];
     [self addShader:kMaplyShaderTriExp program: std::make_shared<ProgramMTL>(
         [kMaplyShaderTriExp cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_lightExp"],
-        [mtlLib newFunctionWithName:@"fragmentTri_basic"])];
+        shaderFunc(@"vertexTri_lightExp"),
+        shaderFunc(@"fragmentTri_basic"))];
     [self addShader:kMaplyShaderDefaultTriNoLighting program: std::make_shared<ProgramMTL>(
         [kMaplyShaderDefaultTriNoLighting cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_noLight"],
-        [mtlLib newFunctionWithName:@"fragmentTri_basic"])];
+        shaderFunc(@"vertexTri_noLight"),
+        shaderFunc(@"fragmentTri_basic"))];
     [self addShader:kMaplyShaderNoLightTriangleExp program: std::make_shared<ProgramMTL>(
         [kMaplyShaderNoLightTriangleExp cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_noLightExp"],
-        [mtlLib newFunctionWithName:@"fragmentTri_basic"])];
+        shaderFunc(@"vertexTri_noLightExp"),
+        shaderFunc(@"fragmentTri_basic"))];
 
     // TODO: Screen Space Texture application
 
     // Multitexture shader - Used for animation
     [self addShader:kMaplyShaderDefaultTriMultiTex program: std::make_shared<ProgramMTL>(
         [kMaplyShaderDefaultTriMultiTex cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_multiTex"],
-        [mtlLib newFunctionWithName:@"fragmentTri_multiTex"])];
+        shaderFunc(@"vertexTri_multiTex"),
+        shaderFunc(@"fragmentTri_multiTex"))];
     
+    // Composite shader - Layers from a frame loader drawn in one pass
+    [self addShader:kMaplyShaderDefaultTriComposite program: std::make_shared<ProgramMTL>(
+        [kMaplyShaderDefaultTriComposite cStringUsingEncoding:NSASCIIStringEncoding],
+        shaderFunc(@"vertexTri_composite"),
+        shaderFunc(@"fragmentTri_composite"))];
+
+    // Terrain shader - Tiles raised by the elevation texture in the second slot
+    [self addShader:kMaplyShaderDefaultTriTerrain program: std::make_shared<ProgramMTL>(
+        [kMaplyShaderDefaultTriTerrain cStringUsingEncoding:NSASCIIStringEncoding],
+        shaderFunc(@"vertexTri_terrain"),
+        shaderFunc(@"fragmentTri_terrain"))];
+
     // Multitexture ramp shader - Very simple implementation of animated color lookup
     [self addShader:kMaplyShaderDefaultTriMultiTexRamp program: std::make_shared<ProgramMTL>(
         [kMaplyShaderDefaultTriMultiTexRamp cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_multiTex"],
-        [mtlLib newFunctionWithName:@"fragmentTri_multiTexRamp"])];
+        shaderFunc(@"vertexTri_multiTex"),
+        shaderFunc(@"fragmentTri_multiTexRamp"))];
     
     // MultiTexture for Markers
     [self addShader:kMaplyShaderDefaultMarker program: std::make_shared<ProgramMTL>(
         [kMaplyShaderDefaultTriMultiTex cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_multiTex"],
-        [mtlLib newFunctionWithName:@"fragmentTri_multiTex"])];
+        shaderFunc(@"vertexTri_multiTex"),
+        shaderFunc(@"fragmentTri_multiTex"))];
 
     // Model Instancing
     [self addShader:kMaplyShaderDefaultModelTri program: std::make_shared<ProgramMTL>(
         [kMaplyShaderDefaultModelTri cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_model"],
-        [mtlLib newFunctionWithName:@"fragmentTri_multiTex"])];
+        shaderFunc(@"vertexTri_model"),
+        shaderFunc(@"fragmentTri_multiTex"))];
 
     // Night/Day Shader
     [self addShader:kMaplyShaderDefaultTriNightDay program: std::make_shared<ProgramMTL>(
         [kMaplyShaderDefaultTriNightDay cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_multiTex_nightDay"],
-        [mtlLib newFunctionWithName:@"fragmentTri_multiTex_nightDay"])];
+        shaderFunc(@"vertexTri_multiTex_nightDay"),
+        shaderFunc(@"fragmentTri_multiTex_nightDay"))];
 
     // Billboards
     auto billboardProg = std::make_shared<ProgramMTL>(
         [kMaplyShaderBillboardGround cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_billboard"],
-        [mtlLib newFunctionWithName:@"fragmentTri_basic"]);
+        shaderFunc(@"vertexTri_billboard"),
+        shaderFunc(@"fragmentTri_basic"));
     [self addShader:kMaplyShaderBillboardGround program:billboardProg];
     [self addShader:kMaplyShaderBillboardEye program:billboardProg];
 
+    // Billboards drawn as instances of a single quad
+    auto billboardInstProg = std::make_shared<ProgramMTL>(
+        [kMaplyShaderBillboardGroundInstance cStringUsingEncoding:NSASCIIStringEncoding],
+        shaderFunc(@"vertexTri_billboardInst"),
+        shaderFunc(@"fragmentTri_basic"));
+    [self addShader:kMaplyShaderBillboardGroundInstance program:billboardInstProg];
+    [self addShader:kMaplyShaderBillboardEyeInstance program:billboardInstProg];
+
     // Wide vectors
     [self addShader:kMaplyShaderDefaultWideVector program: std::make_shared<ProgramMTL>(
         [kMaplyShaderDefaultWideVector cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_wideVec"],
-        [mtlLib newFunctionWithName:@"fragmentTri_wideVec"])];
+        shaderFunc(@"vertexTri_wideVec"),
+        shaderFunc(@"fragmentTri_wideVec"))];
     [self addShader:kMaplyShaderWideVectorExp program: std::make_shared<ProgramMTL>(
         [kMaplyShaderWideVectorExp cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_wideVecExp"],
-        [mtlLib newFunctionWithName:@"fragmentTri_wideVec"])];
+        shaderFunc(@"vertexTri_wideVecExp"),
+        shaderFunc(@"fragmentTri_wideVec"))];
     [self addShader:kMaplyShaderWideVectorPerformance program: std::make_shared<ProgramMTL>(
         [kMaplyShaderWideVectorPerformance cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_wideVecPerf"],
-        [mtlLib newFunctionWithName:@"fragmentTri_wideVecPerf"])];
+        shaderFunc(@"vertexTri_wideVecPerf"),
+        shaderFunc(@"fragmentTri_wideVecPerf"))];
     
     // Screen Space (motion and regular are the same)
     auto screenSpace = std::make_shared<ProgramMTL>(
         [kMaplyScreenSpaceDefaultProgram cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_screenSpace"],
-        [mtlLib newFunctionWithName:@"fragmentTri_basic"]);
+        shaderFunc(@"vertexTri_screenSpace"),
+        shaderFunc(@"fragmentTri_basic"));
     [self addShader:kMaplyScreenSpaceDefaultProgram program:screenSpace];
     [self addShader:kMaplyScreenSpaceDefaultMotionProgram program:screenSpace];
     
     // Renders the mask ID to the screen
     auto screenSpaceMask = std::make_shared<ProgramMTL>(
         MaplyScreenSpaceMaskShader,
-        [mtlLib newFunctionWithName:@"vertexTri_screenSpace"],
-        [mtlLib newFunctionWithName:@"fragmentTri_mask"]);
+        shaderFunc(@"vertexTri_screenSpace"),
+        shaderFunc(@"fragmentTri_mask"));
     [self addShader:kMaplyScreenSpaceMaskProgram program:screenSpaceMask];
+
+    // Writes selectable shape IDs out for picking
+    auto triangleID = std::make_shared<ProgramMTL>(
+        MaplyTriangleIDShader,
+        shaderFunc(@"vertexTri_id"),
+        shaderFunc(@"fragmentTri_mask"));
+    [self addShader:kMaplyTriangleIDProgram program:triangleID];
     
     // Screen Space that handles expressions
     auto screenSpaceExp = std::make_shared<ProgramMTL>(
         [kMaplyScreenSpaceExpProgram cStringUsingEncoding:NSASCIIStringEncoding],
-        [mtlLib newFunctionWithName:@"vertexTri_screenSpaceExp"],
-        [mtlLib newFunctionWithName:@"fragmentTri_basic"]);
+        shaderFunc(@"vertexTri_screenSpaceExp"),
+        shaderFunc(@"fragmentTri_basic"));
     [self addShader:kMaplyScreenSpaceExpProgram program:screenSpaceExp];
 
+    // Labels drawn from distance field glyphs
+    auto screenSpaceSDF = std::make_shared<ProgramMTL>(
+        MaplyScreenSpaceSDFShader,
+        shaderFunc(@"vertexTri_screenSpace"),
+        shaderFunc(@"fragmentTri_sdf"));
+    [self addShader:kMaplyScreenSpaceSDFProgram program:screenSpaceSDF];
+    [self addShader:kMaplyScreenSpaceSDFMotionProgram program:screenSpaceSDF];
+
+    // Rectangles drawn as instances of a single quad, with or without motion
+    auto screenSpaceInst = std::make_shared<ProgramMTL>(
+        MaplyScreenSpaceInstanceShader,
+        shaderFunc(@"vertexTri_screenSpaceInst"),
+        shaderFunc(@"fragmentTri_basic"));
+    [self addShader:kMaplyScreenSpaceInstanceProgram program:screenSpaceInst];
+    auto screenSpaceSDFInst = std::make_shared<ProgramMTL>(
+        MaplyScreenSpaceSDFInstanceShader,
+        shaderFunc(@"vertexTri_screenSpaceInst"),
+        shaderFunc(@"fragmentTri_sdf"));
+    [self addShader:kMaplyScreenSpaceSDFInstanceProgram program:screenSpaceSDFInst];
+
     // TODO: Particles
 }
 
@@ -1256,6 +1576,8 @@ using namespace Eigen;
             return tileFetcher;
     
     MaplyRemoteTileFetcher *tileFetcher = [[MaplyRemoteTileFetcher alloc] initWithName:name connections:tileFetcherConnections];
+    // Cached tiles go straight in on a fast start, they're the placeholders
+    tileFetcher.immediateCacheReads = fastStartup;
     tileFetchers.push_back(tileFetcher);
     
     return tileFetcher;
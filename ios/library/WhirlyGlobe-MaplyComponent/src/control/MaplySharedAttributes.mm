@@ -176,6 +176,9 @@ NSString* const kMaplyVecTexScaleY = MaplyVecTexScaleY;
 
 // scale for markers
 WKDefineConst(MarkerScale);
+WKDefineConst(MarkerFleet);
+WKDefineConst(MarkerInstanced);
+WKDefineConst(MarkerClampToGround);
 
 /// The projection to use when generating texture coordinates
 NSString* const kMaplyVecTextureProjection = MaplyVecTextureProjection;
@@ -190,6 +193,11 @@ NSString* const kMaplyProjectionNone = MaplyVecProjectionNone;
 /// This fixes the jittering problem when zoomed in close
 NSString* const kMaplyVecCentered = MaplyVecCentered;
 
+/// Simplified versions of features for lower zoom levels
+NSString* const kMaplyVecLODLevels = MaplyVecLODLevels;
+NSString* const kMaplyVecLODMaxZoom = MaplyVecLODMaxZoom;
+NSString* const kMaplyVecLODTolerance = MaplyVecLODTolerance;
+
 /// Center of the feature, to use for texture calculations
 NSString* const kMaplyVecCenterX = MaplyVecCenterX;
 NSString* const kMaplyVecCenterY = MaplyVecCenterY;
@@ -300,6 +308,8 @@ NSString* const kMaplyBillboardOrient = MaplyBillboardOrient;
 NSString* const kMaplyBillboardOrientGround = MaplyBillboardOrientGround;
 /// Billboards are oriented only towards the eye
 NSString* const kMaplyBillboardOrientEye = MaplyBillboardOrientEye;
+/// Billboards are drawn as instances of a single quad
+NSString* const kMaplyBillboardInstanced = MaplyBillboardInstanced;
 
 /// These are used for lofted polygons
 
@@ -317,6 +327,10 @@ NSString* const kMaplyLoftedPolyGridSize = MaplyLoftedPolyGridSize;
 NSString* const kMaplyLoftedPolyOutline = MaplyLoftedPolyOutline;
 /// If set to @(YES) this will draw an outline around the bottom of the lofted poly in lines
 NSString* const kMaplyLoftedPolyOutlineBottom = MaplyLoftedPolyOutlineBottom;
+/// If set to @(YES) the walls and roof are raised by the shader.  Metal builds them up front instead.
+NSString* const kMaplyLoftedPolyShaderExtrude = MaplyLoftedPolyShaderExtrude;
+/// If set to @(YES) touching footprints are merged into one roof, dropping the walls between them
+NSString* const kMaplyLoftedPolyMergeRoofs = MaplyLoftedPolyMergeRoofs;
 /// If the outline is one this is the outline's color
 NSString* const kMaplyLoftedPolyOutlineColor = MaplyLoftedPolyOutlineColor;
 /// This is the outline's width if it's turned on
@@ -334,6 +348,7 @@ WKDefineConst(ShapeSampleX)
 WKDefineConst(ShapeSampleY)
 /// If set to true, we'll tessellate a shape using the opposite vertex ordering
 NSString* const kMaplyShapeInsideOut = MaplyShapeInsideOut;
+NSString* const kMaplyShapeInstanced = MaplyShapeInstanced;
 /// Center for the shape geometry
 NSString* const kMaplyShapeCenterX = MaplyShapeCenterX;
 NSString* const kMaplyShapeCenterY = MaplyShapeCenterY;
@@ -374,6 +389,8 @@ NSString* const kMaplyShaderDefaultTriScreenTex = @"Default Triangle;screentex=y
 
 NSString* const kMaplyShaderDefaultTriMultiTex = @"Default Triangle;multitex=yes;lighting=yes";
 NSString* const kMaplyShaderDefaultTriMultiTexRamp = @"Default Triangle;multitex=yes;lighting=yes;ramp=yes";
+NSString* const kMaplyShaderDefaultTriComposite = @"Default Triangle;composite=yes;lighting=yes";
+NSString* const kMaplyShaderDefaultTriTerrain = @"Default Triangle;terrain=yes;lighting=yes";
 NSString* const kMaplyShaderDefaultTriNightDay = @"Default Triangle;nightday=yes;multitex=yes;lighting=yes";
 
 NSString* const kMaplyShaderDefaultMarker = @"Default marker;multitex=yes;lighting=yes";
@@ -386,6 +403,8 @@ NSString* const kMaplyNoBackfaceLineShader = @"Default Line;backface=no";
 
 NSString* const kMaplyShaderBillboardGround = @"Default Billboard ground";
 NSString* const kMaplyShaderBillboardEye = @"Default Billboard eye";
+NSString* const kMaplyShaderBillboardGroundInstance = @"Billboard ground instance";
+NSString* const kMaplyShaderBillboardEyeInstance = @"Billboard eye instance";
 
 NSString* const kMaplyShaderDefaultWideVector = @"Default Wide Vector";
 NSString* const kMaplyShaderWideVectorExp = @"Default Wide Vector with expressions";
@@ -394,7 +413,12 @@ NSString* const kMaplyShaderWideVectorPerformance = @"Wide Vector performance";
 NSString* const kMaplyScreenSpaceDefaultMotionProgram = @"Default Screenspace Motion";
 NSString* const kMaplyScreenSpaceDefaultProgram = @"Default Screenspace";
 NSString* const kMaplyScreenSpaceMaskProgram = @"Screenspace mask";
+NSString* const kMaplyTriangleIDProgram = @"Default Triangle ID";
 NSString* const kMaplyScreenSpaceExpProgram = @"Screenspace with expressions";
+NSString* const kMaplyScreenSpaceSDFProgram = @"Screenspace SDF";
+NSString* const kMaplyScreenSpaceSDFMotionProgram = @"Screenspace SDF Motion";
+NSString* const kMaplyScreenSpaceInstanceProgram = @"Screenspace instance";
+NSString* const kMaplyScreenSpaceSDFInstanceProgram = @"Screenspace SDF instance";
 
 NSString * const kMaplyAtmosphereProgram = @"Default Atmosphere";
 NSString * const kMaplyAtmosphereGroundProgram = @"Default Atmosphere Ground";
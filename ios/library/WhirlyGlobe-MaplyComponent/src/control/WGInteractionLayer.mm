@@ -145,7 +145,7 @@ using namespace WhirlyGlobe;
 {
     SelectionManagerRef selectManager = std::dynamic_pointer_cast<SelectionManager>(scene->getManager(kWKSelectionManager));
     std::vector<SelectionManager::SelectedObject> selectedObjs;
-    selectManager->pickObjects(Point2f(screenPoint.x,screenPoint.y),10.0,globeView->makeViewState(layerThread.renderer),selectedObjs);
+    selectManager->pickObjects(Point2f(screenPoint.x,screenPoint.y),10.0,globeView->getViewState(layerThread.renderer),selectedObjs);
 
     return [self convertSelectedObjects:selectedObjs];
 }
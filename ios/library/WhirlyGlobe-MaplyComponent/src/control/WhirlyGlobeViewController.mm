@@ -1717,7 +1717,7 @@ struct WhirlyGlobeViewWrapper : public WhirlyGlobe::GlobeViewAnimationDelegate,
     
     // Look for the object, returns an ID
     SelectionManagerRef selectManager = std::dynamic_pointer_cast<SelectionManager>(renderControl->scene->getManager(kWKSelectionManager));
-    SimpleIdentity objId = selectManager->pickObject(Point2f(screenPt.x,screenPt.y), 10.0, globeView->makeViewState(renderControl->sceneRenderer.get()));
+    SimpleIdentity objId = selectManager->pickObject(Point2f(screenPt.x,screenPt.y), 10.0, globeView->getViewState(renderControl->sceneRenderer.get()));
     
     if (objId != EmptyIdentity)
     {
@@ -20,6 +20,7 @@
 #import "MaplyCoordinateSystem_private.h"
 #import "WhirlyGlobeLib.h"
 #import "sqlhelpers.h"
+#import "MBTilesReader.h"
 
 using namespace WhirlyKit;
 
@@ -30,6 +31,7 @@ using namespace WhirlyKit;
     Mbr mbr;
     GeoMbr geoMbr;
     sqlite3 *sqlDb;
+    MBTilesReaderRef reader;
     MaplyCoordinateSystem *coordSys;
 }
 
@@ -40,6 +42,14 @@ using namespace WhirlyKit;
 
 - (nullable instancetype)initWithMBTiles:(NSString *__nonnull)mbTilesName
                                cacheSize:(int)cacheSize
+{
+    return [self initWithMBTiles:mbTilesName cacheSize:cacheSize numReaders:4 mmapSize:0];
+}
+
+- (nullable instancetype)initWithMBTiles:(NSString *__nonnull)mbTilesName
+                               cacheSize:(int)cacheSize
+                              numReaders:(int)numReaders
+                                mmapSize:(int64_t)mmapSize
 {
     NSString *infoPath = nil;
     // See if that was a direct path first
@@ -221,6 +231,18 @@ using namespace WhirlyKit;
         geoMbr = gmbr;
         coordSys = cs;
         sqlDb = db;
+
+        // The older style, without a tiles table, stays on the one connection
+        if (tilesStyles && numReaders > 0)
+        {
+            const auto newReader = std::make_shared<MBTilesReader>(nameStr,numReaders,mmapSize,cacheSize);
+            if (newReader->isValid())
+            {
+                reader = newReader;
+                self.maxConcurrentReads = reader->getNumReaders();
+                self.maxTilesPerRead = 16;
+            }
+        }
     }
     
     return self;
@@ -233,6 +255,11 @@ using namespace WhirlyKit;
 
 - (id)dataForTile:(id)fetchInfo tileID:(MaplyTileID)tileID;
 {
+    if (const auto theReader = std::atomic_load(&reader))
+    {
+        return theReader->readTile(tileID.x,tileID.y,tileID.level);
+    }
+
     NSData *imageData = nil;
     
     @synchronized(self)
@@ -261,9 +288,30 @@ using namespace WhirlyKit;
     return imageData;
 }
 
+- (NSArray *)dataForTiles:(NSArray *)fetchInfos tileIDs:(const MaplyTileID *)tileIDs
+{
+    const auto theReader = std::atomic_load(&reader);
+    if (!theReader)
+    {
+        return [super dataForTiles:fetchInfos tileIDs:tileIDs];
+    }
+
+    const std::vector<MaplyTileID> ids(tileIDs,tileIDs + fetchInfos.count);
+    const auto tileData = theReader->readTiles(ids);
+    NSMutableArray *ret = [NSMutableArray arrayWithCapacity:tileData.size()];
+    for (NSData *data : tileData)
+    {
+        [ret addObject:data ? data : [NSNull null]];
+    }
+    return ret;
+}
+
 - (void)shutdown
 {
     [super shutdown];
+
+    // Reads still going keep their own reference
+    std::atomic_store(&reader,MBTilesReaderRef());
     
     if (sqlDb) {
         sqlite3_close(sqlDb);
@@ -0,0 +1,506 @@
+/*  MaplyPMTilesFetcher.mm
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting inc
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <fcntl.h>
+#import <unistd.h>
+#import "data_sources/MaplyPMTilesFetcher.h"
+#import "MaplyURLSessionManager+Private.h"
+#import "WhirlyGlobeLib.h"
+#import "PMTilesArchive.h"
+
+using namespace WhirlyKit;
+
+namespace
+{
+
+// A single tile that we're aware of
+class PMTileInfo
+{
+public:
+    enum State {ToLoad,Loading};
+
+    /// Comparison based on priority, importance, then the request
+    bool operator < (const PMTileInfo &that) const
+    {
+        if (priority == that.priority) {
+            if (importance == that.importance) {
+                return request < that.request;
+            }
+            return importance < that.importance;
+        }
+        return priority > that.priority;
+    }
+
+    State state = ToLoad;
+    int priority = 0;
+    double importance = 0.0;
+    /// Where the tile is in the archive
+    uint64_t tileID = 0;
+    PMTilesArchive::Range range;
+    MaplyTileFetchRequest *request = nil;
+};
+
+typedef std::shared_ptr<PMTileInfo> PMTileInfoRef;
+struct PMTileInfoSorter {
+    bool operator () (const PMTileInfoRef &a,const PMTileInfoRef &b) const {
+        return *a < *b;
+    }
+};
+typedef std::set<PMTileInfoRef,PMTileInfoSorter> PMTileInfoSet;
+typedef std::map<MaplyTileFetchRequest *,PMTileInfoRef> PMTileFetchMap;
+
+}
+
+@implementation MaplyPMTilesFetcher
+{
+    bool active;
+    bool loadScheduled;
+    NSString *name;
+    NSURL *url;
+    // Set for local files, which we read directly
+    int fileFD;
+    NSURLSession *session;
+    dispatch_queue_t queue;
+    PMTilesArchiveRef archive;
+    MaplySimpleTileInfo *tileInfo;
+    MaplyCoordinateSystem *coordSys;
+
+    PMTileInfoSet toLoad;  // Tiles we haven't read yet, sorted by importance
+    PMTileFetchMap tilesByFetchRequest;  // Tiles sorted by fetch request
+    std::set<uint64_t> dirsLoading;  // Leaf directories being read, by offset
+    int numActive;  // Reads underway
+}
+
+- (nullable instancetype)initWithURL:(NSURL *__nonnull)inURL name:(NSString *__nonnull)inName
+{
+    self = [super init];
+    if (!self)
+        return nil;
+
+    url = inURL;
+    name = inName;
+    fileFD = -1;
+    if ([url isFileURL]) {
+        fileFD = open([[url path] fileSystemRepresentation], O_RDONLY);
+        if (fileFD < 0) {
+            NSLog(@"MaplyPMTilesFetcher: Can't open %@",[url path]);
+            return nil;
+        }
+    } else {
+        session = [[MaplyURLSessionManager sharedManager] createURLSession];
+    }
+
+    _neverFail = true;
+    _maxGap = 16*1024;
+    _maxRequestSize = 1024*1024;
+    _numConnections = 8;
+    _timeOut = 0.0;
+    archive = std::make_shared<PMTilesArchive>();
+    coordSys = [[MaplySphericalMercator alloc] initWebStandard];
+    queue = dispatch_queue_create([name cStringUsingEncoding:NSASCIIStringEncoding], DISPATCH_QUEUE_SERIAL);
+    active = true;
+
+    return self;
+}
+
+- (void)dealloc
+{
+    if (fileFD >= 0)
+        close(fileFD);
+}
+
+- (NSString *)name
+{
+    return name;
+}
+
+- (bool)valid
+{
+    return archive->isValid();
+}
+
+- (int)minZoom
+{
+    return archive->getHeader().minZoom;
+}
+
+- (int)maxZoom
+{
+    return archive->getHeader().maxZoom;
+}
+
+- (NSObject<MaplyTileInfoNew> *)tileInfo
+{
+    return tileInfo;
+}
+
+- (MaplyCoordinateSystem *)coordSys
+{
+    return coordSys;
+}
+
+- (MaplyBoundingBox)bounds
+{
+    const auto header = archive->getHeader();
+    MaplyBoundingBox bbox;
+    bbox.ll = MaplyCoordinateMakeWithDegrees(header.minLon, header.minLat);
+    bbox.ur = MaplyCoordinateMakeWithDegrees(header.maxLon, header.maxLat);
+    return bbox;
+}
+
+- (NSString *)format
+{
+    switch (archive->getHeader().tileType) {
+        case PMTilesArchive::TileTypeMVT: return @"pbf";
+        case PMTilesArchive::TileTypePNG: return @"png";
+        case PMTilesArchive::TileTypeJPEG: return @"jpg";
+        case PMTilesArchive::TileTypeWebP: return @"webp";
+        case PMTilesArchive::TileTypeAVIF: return @"avif";
+        default: return nil;
+    }
+}
+
+// Read some bytes from the archive, calling back on our queue
+- (void)readRange:(const PMTilesArchive::Range &)range callback:(void (^)(NSData *data,NSError *error))callback
+{
+    MaplyPMTilesFetcher * __weak weakSelf = self;
+    const uint64_t offset = range.offset, length = range.length;
+
+    if (fileFD >= 0) {
+        const int fd = fileFD;
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            NSMutableData *data = [NSMutableData dataWithLength:length];
+            const ssize_t numRead = pread(fd, [data mutableBytes], length, offset);
+            NSError *error = nil;
+            if (numRead < 0) {
+                data = nil;
+                error = [[NSError alloc] initWithDomain:@"MaplyPMTilesFetcher" code:errno
+                                               userInfo:@{NSLocalizedDescriptionKey: @"Failed to read from the archive"}];
+            } else {
+                [data setLength:numRead];
+            }
+            const auto __strong s = weakSelf;
+            if (s && s->active)
+                dispatch_async(s->queue, ^{ callback(data,error); });
+        });
+        return;
+    }
+
+    NSMutableURLRequest *urlReq = [NSMutableURLRequest requestWithURL:url];
+    if (_timeOut > 0.0)
+        urlReq.timeoutInterval = _timeOut;
+    for (NSString *key in _headers)
+        [urlReq setValue:_headers[key] forHTTPHeaderField:key];
+    [urlReq setValue:[NSString stringWithFormat:@"bytes=%llu-%llu",offset,offset + length - 1] forHTTPHeaderField:@"Range"];
+
+    if (_debugMode)
+        NSLog(@"MaplyPMTilesFetcher: Reading %llu bytes at %llu",length,offset);
+
+    NSURLSessionDataTask *task = [session dataTaskWithRequest:urlReq completionHandler:
+                                  ^(NSData * _Nullable data, NSURLResponse * _Nullable inResponse, NSError * _Nullable error) {
+        NSHTTPURLResponse *response = (NSHTTPURLResponse *)inResponse;
+        if (!error) {
+            if (response.statusCode == 200 && [data length] > offset) {
+                // Server ignored the range and sent the whole thing
+                data = [data subdataWithRange:NSMakeRange(offset, std::min((uint64_t)[data length] - offset,length))];
+            } else if (response.statusCode != 206 && response.statusCode != 200) {
+                data = nil;
+                error = [[NSError alloc] initWithDomain:@"MaplyPMTilesFetcher" code:response.statusCode
+                                               userInfo:@{NSLocalizedDescriptionKey:[NSString stringWithFormat:@"Server response: %d",(int)response.statusCode]}];
+            }
+        }
+        const auto __strong s = weakSelf;
+        if (s && s->active)
+            dispatch_async(s->queue, ^{ callback(data,error); });
+    }];
+    [task resume];
+}
+
+- (void)start:(void (^)(MaplyPMTilesFetcher *fetcher,NSError *error))callback
+{
+    PMTilesArchive::Range range;
+    range.length = PMTilesArchive::StartSize;
+
+    MaplyPMTilesFetcher * __weak weakSelf = self;
+    dispatch_async(queue, ^{
+        [weakSelf readRange:range callback:^(NSData *data, NSError *error) {
+            const auto __strong s = weakSelf;
+            if (!s)
+                return;
+            if (!error && !s->archive->parseStart([data bytes],[data length])) {
+                error = [[NSError alloc] initWithDomain:@"MaplyPMTilesFetcher" code:0
+                                               userInfo:@{NSLocalizedDescriptionKey: @"Not a PMTiles archive we can read"}];
+            }
+            if (!error) {
+                const auto header = s->archive->getHeader();
+                s->tileInfo = [[MaplySimpleTileInfo alloc] initWithMinZoom:header.minZoom maxZoom:header.maxZoom];
+                if (s->_debugMode)
+                    NSLog(@"MaplyPMTilesFetcher: Archive has %llu tiles, levels %d to %d",
+                          header.numAddressedTiles,header.minZoom,header.maxZoom);
+                [s scheduleLoading];
+            }
+            if (callback)
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    callback(s,error);
+                });
+        }];
+    });
+}
+
+- (void)startTileFetches:(NSArray<MaplyTileFetchRequest *> * _Nonnull)requests
+{
+    if (!active || !requests.count)
+        return;
+
+    // Check each of the fetchInfo objects
+    for (MaplyTileFetchRequest *request in requests)
+        if (![request.fetchInfo isKindOfClass:[MaplySimpleTileFetchInfo class]]) {
+            NSLog(@"MaplyPMTilesFetcher is expecting MaplySimpleTileFetchInfo objects.  Rejecting requests.");
+            return;
+        }
+
+    dispatch_async(queue, ^{
+        for (MaplyTileFetchRequest *request in requests) {
+            MaplySimpleTileFetchInfo *fetchInfo = request.fetchInfo;
+            const auto tile = std::make_shared<PMTileInfo>();
+            tile->importance = request.importance;
+            tile->priority = request.priority;
+            tile->request = request;
+            // Our tile IDs count up from the bottom and the archive's down from the top
+            tile->tileID = PMTilesArchive::tileIDForTile(fetchInfo.x,(1 << fetchInfo.level) - 1 - fetchInfo.y,fetchInfo.level);
+            self->tilesByFetchRequest[request] = tile;
+            self->toLoad.insert(tile);
+        }
+
+        [self scheduleLoading];
+    });
+}
+
+- (id)updateTileFetch:(id _Nonnull)request priority:(int)priority importance:(double)importance
+{
+    if (!active)
+        return nil;
+
+    dispatch_async(queue, ^{
+        auto it = self->tilesByFetchRequest.find(request);
+        if (it == self->tilesByFetchRequest.end())
+            return;
+
+        // Reinsert the tile with the new values, unless we're already reading it
+        PMTileInfoRef tile = it->second;
+        if (tile->state == PMTileInfo::ToLoad) {
+            self->toLoad.erase(tile);
+            tile->priority = priority;
+            tile->importance = importance;
+            self->toLoad.insert(tile);
+        }
+    });
+
+    return request;
+}
+
+- (void)cancelTileFetches:(NSArray * _Nonnull)requests
+{
+    if (!active || !requests.count)
+        return;
+
+    // Reads already underway carry on for the other tiles in them, we just drop these
+    dispatch_async(queue, ^{
+        for (MaplyTileFetchRequest *request in requests) {
+            auto it = self->tilesByFetchRequest.find(request);
+            if (it == self->tilesByFetchRequest.end())
+                continue;
+            self->toLoad.erase(it->second);
+            self->tilesByFetchRequest.erase(it);
+        }
+    });
+}
+
+// Run on our queue
+- (void)scheduleLoading
+{
+    if (!active || loadScheduled)
+        return;
+
+    // Let any other requests coming in right now get here first, so they can be batched
+    loadScheduled = true;
+    MaplyPMTilesFetcher * __weak weakSelf = self;
+    dispatch_async(queue, ^{
+        [weakSelf updateLoading];
+    });
+}
+
+// Hand a tile back to whoever asked for it, on a background queue since parsing takes a while
+- (void)finishTile:(const PMTileInfoRef &)tile data:(NSData *)data error:(NSError *)error
+{
+    auto it = tilesByFetchRequest.find(tile->request);
+    if (it == tilesByFetchRequest.end() || it->second != tile)
+        return;
+    tilesByFetchRequest.erase(it);
+    toLoad.erase(tile);
+
+    MaplyTileFetchRequest *request = tile->request;
+    const bool neverFail = _neverFail;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        if (data || (neverFail && !error)) {
+            if (request.success)
+                request.success(request,data);
+        } else if (request.failure) {
+            request.failure(request, error ? error :
+                            [[NSError alloc] initWithDomain:@"MaplyPMTilesFetcher" code:0
+                                                   userInfo:@{NSLocalizedDescriptionKey: @"Tile isn't in the archive"}]);
+        }
+    });
+}
+
+// Undo the archive's tile compression
+- (NSData *)tileDataFrom:(NSData *)data
+{
+    const int compression = archive->getHeader().tileCompression;
+    if (compression == PMTilesArchive::CompressNone || compression == PMTilesArchive::CompressUnknown)
+        return data;
+
+    const auto rawData = std::make_shared<RawDataWrapper>([data bytes],[data length],false);
+    const auto tileData = archive->decompressTile(rawData);
+    return tileData ? [NSData dataWithBytes:tileData->getRawData() length:tileData->getLen()] : nil;
+}
+
+// Run on our queue
+- (void)updateLoading
+{
+    loadScheduled = false;
+    if (!active || !archive->isValid())
+        return;
+
+    // Work out where everything waiting is, most important first
+    std::vector<PMTileInfoRef> found;
+    std::vector<PMTilesArchive::Range> ranges;
+    std::vector<PMTileInfoRef> missing;
+    for (auto it = toLoad.rbegin(); it != toLoad.rend(); ++it) {
+        const PMTileInfoRef &tile = *it;
+        PMTilesArchive::Range range;
+        switch (archive->lookup(tile->tileID, range)) {
+            case PMTilesArchive::TileFound:
+                tile->range = range;
+                found.push_back(tile);
+                ranges.push_back(range);
+                break;
+            case PMTilesArchive::TileMissing:
+                missing.push_back(tile);
+                break;
+            case PMTilesArchive::NeedDirectory:
+                // The tile stays where it is until we have the directory
+                if (numActive < _numConnections && dirsLoading.insert(range.offset).second)
+                    [self readDirectory:range];
+                break;
+        }
+    }
+    for (const auto &tile : missing)
+        [self finishTile:tile data:nil error:nil];
+
+    // Neighbors go in the same read.  The reads with the more important tiles go first.
+    std::vector<PMTilesArchive::Read> reads;
+    PMTilesArchive::groupReads(ranges, _maxGap, _maxRequestSize, reads);
+    for (auto &read : reads)
+        std::sort(read.which.begin(), read.which.end());
+    std::sort(reads.begin(), reads.end(), [](const PMTilesArchive::Read &a,const PMTilesArchive::Read &b) {
+        return a.which.front() < b.which.front();
+    });
+
+    for (const auto &read : reads) {
+        if (numActive >= _numConnections)
+            break;
+        std::vector<PMTileInfoRef> tiles;
+        for (int which : read.which) {
+            const PMTileInfoRef &tile = found[which];
+            tile->state = PMTileInfo::Loading;
+            toLoad.erase(tile);
+            tiles.push_back(tile);
+        }
+        [self readTiles:tiles range:read.range];
+    }
+}
+
+// Run on our queue
+- (void)readDirectory:(PMTilesArchive::Range)range
+{
+    numActive++;
+    MaplyPMTilesFetcher * __weak weakSelf = self;
+    [self readRange:range callback:^(NSData *data, NSError *error) {
+        const auto __strong s = weakSelf;
+        if (!s)
+            return;
+        s->numActive--;
+        s->dirsLoading.erase(range.offset);
+        if (error || !s->archive->addDirectory(range, [data bytes], [data length])) {
+            // Fail everything that was waiting on it, rather than asking again forever
+            std::vector<PMTileInfoRef> waiting;
+            for (const auto &tile : s->toLoad) {
+                PMTilesArchive::Range tileRange;
+                if (s->archive->lookup(tile->tileID, tileRange) == PMTilesArchive::NeedDirectory &&
+                    tileRange.offset == range.offset)
+                    waiting.push_back(tile);
+            }
+            NSError *dirError = error ? error : [[NSError alloc] initWithDomain:@"MaplyPMTilesFetcher" code:0
+                                                                        userInfo:@{NSLocalizedDescriptionKey: @"Bad directory in the archive"}];
+            for (const auto &tile : waiting)
+                [s finishTile:tile data:nil error:dirError];
+        }
+        [s scheduleLoading];
+    }];
+}
+
+// Run on our queue
+- (void)readTiles:(const std::vector<PMTileInfoRef> &)tiles range:(PMTilesArchive::Range)range
+{
+    numActive++;
+    MaplyPMTilesFetcher * __weak weakSelf = self;
+    const std::vector<PMTileInfoRef> readTiles = tiles;
+    [self readRange:range callback:^(NSData *data, NSError *error) {
+        const auto __strong s = weakSelf;
+        if (!s)
+            return;
+        s->numActive--;
+        for (const auto &tile : readTiles) {
+            const uint64_t start = tile->range.offset - range.offset;
+            NSData *tileData = nil;
+            if (!error && start + tile->range.length <= [data length])
+                tileData = [s tileDataFrom:[data subdataWithRange:NSMakeRange(start, tile->range.length)]];
+            NSError *tileError = error;
+            if (!tileData && !tileError)
+                tileError = [[NSError alloc] initWithDomain:@"MaplyPMTilesFetcher" code:0
+                                                   userInfo:@{NSLocalizedDescriptionKey: @"Couldn't read the tile from the archive"}];
+            [s finishTile:tile data:tileData error:tileError];
+        }
+        [s scheduleLoading];
+    }];
+}
+
+- (void)shutdown
+{
+    active = false;
+
+    // Execute an empty task and wait for it to return
+    // This drains the queue
+    dispatch_sync(queue, ^{});
+
+    toLoad.clear();
+    tilesByFetchRequest.clear();
+    [session invalidateAndCancel];
+}
+
+@end
@@ -0,0 +1,290 @@
+/*  MBTilesReader.mm
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <algorithm>
+#import <climits>
+#import <map>
+#import "MBTilesReader.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+namespace {
+    const char *TileSQL = "SELECT tile_data FROM tiles WHERE zoom_level=? AND tile_column=? AND tile_row=?;";
+    const char *RangeSQL = "SELECT tile_column,tile_row,tile_data FROM tiles WHERE zoom_level=? AND "
+                           "tile_column BETWEEN ? AND ? AND tile_row BETWEEN ? AND ?;";
+
+    // A range query is worth it if we wanted most of what it'll look at
+    bool rangeWorthIt(int numTiles,int minX,int minY,int maxX,int maxY)
+    {
+        const int64_t area = (int64_t)(maxX - minX + 1) * (maxY - minY + 1);
+        return numTiles > 1 && area <= 2 * (int64_t)numTiles;
+    }
+
+    // Turn a path into a URI sqlite will take, with the given parameters
+    std::string fileURI(const std::string &path,const char *params)
+    {
+        std::string uri = "file:";
+        for (char c : path)
+        {
+            if (c == '?' || c == '#' || c == '%')
+            {
+                char buf[4];
+                snprintf(buf,sizeof(buf),"%%%02X",(unsigned char)c);
+                uri += buf;
+            }
+            else
+                uri += c;
+        }
+        return uri + "?" + params;
+    }
+
+    void logSQLError(const char *what,int err)
+    {
+        const char *str = sqlite3_errstr(err);
+        wkLogLevel(Warn,"MBTilesReader: %s (%d): %s",what,err,str ? str : "?");
+    }
+}
+
+MBTilesReader::Reader::~Reader()
+{
+    // Statements have to go before the connection
+    tileStmt.reset();
+    rangeStmt.reset();
+    if (db)
+        sqlite3_close(db);
+}
+
+MBTilesReader::MBTilesReader(const std::string &path,int numReaders,int64_t mmapSize,int cacheSize)
+{
+    // Find out if the file is in WAL mode, which readers need to know about
+    std::string uri = fileURI(path,"mode=ro");
+    ReaderRef first = openReader(uri,SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_URI,mmapSize,cacheSize);
+    if (!first)
+        return;
+
+    bool walMode = false;
+    try
+    {
+        sqlhelpers::StatementRead modeStmt(first->db,"PRAGMA journal_mode;");
+        walMode = modeStmt.stepRow() && [modeStmt.getString() caseInsensitiveCompare:@"wal"] == NSOrderedSame;
+    }
+    catch (int err)
+    {
+        logSQLError("Can't read journal mode",err);
+    }
+
+    if (!walMode)
+    {
+        // Nobody's going to change it under us, so we can skip the locking and change checks
+        uri = fileURI(path,"immutable=1");
+        first = openReader(uri,SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_URI,mmapSize,cacheSize);
+        if (!first)
+            return;
+    }
+
+    readers.push_back(first);
+    for (int ii=1;ii<numReaders;ii++)
+    {
+        if (auto reader = openReader(uri,SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_URI,mmapSize,cacheSize))
+            readers.push_back(reader);
+        else
+            break;
+    }
+    freeReaders = readers;
+}
+
+MBTilesReader::~MBTilesReader()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    freeReaders.clear();
+    readers.clear();
+}
+
+MBTilesReader::ReaderRef MBTilesReader::openReader(const std::string &uri,int flags,int64_t mmapSize,int cacheSize)
+{
+    auto reader = std::make_shared<Reader>();
+    const int openRes = sqlite3_open_v2(uri.c_str(),&reader->db,flags,nullptr);
+    if (openRes != SQLITE_OK)
+    {
+        logSQLError("Failed to open",openRes);
+        return nullptr;
+    }
+
+    try
+    {
+        if (mmapSize > 0)
+        {
+            const auto sql = "PRAGMA mmap_size=" + std::to_string(mmapSize) + ";";
+            sqlhelpers::StatementRead mmapStmt(reader->db,sql.c_str(),true);
+        }
+        if (cacheSize > 0)
+        {
+            // Negative means KiB rather than pages
+            const auto sql = "PRAGMA cache_size=-" + std::to_string((cacheSize + 1023) / 1024) + ";";
+            sqlhelpers::StatementRead cacheStmt(reader->db,sql.c_str(),true);
+        }
+    }
+    catch (int err)
+    {
+        logSQLError("Can't configure connection",err);
+    }
+
+    reader->tileStmt = std::make_unique<sqlhelpers::StatementRead>(reader->db,TileSQL);
+    reader->rangeStmt = std::make_unique<sqlhelpers::StatementRead>(reader->db,RangeSQL);
+    if (!reader->tileStmt->isValid() || !reader->rangeStmt->isValid())
+    {
+        wkLogLevel(Warn,"MBTilesReader: No tiles table: %s",sqlite3_errmsg(reader->db));
+        return nullptr;
+    }
+
+    return reader;
+}
+
+MBTilesReader::ReaderRef MBTilesReader::takeReader()
+{
+    std::unique_lock<std::mutex> guardLock(lock);
+    freeCond.wait(guardLock,[this]{ return !freeReaders.empty(); });
+    auto reader = freeReaders.back();
+    freeReaders.pop_back();
+    return reader;
+}
+
+void MBTilesReader::returnReader(const ReaderRef &reader)
+{
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        freeReaders.push_back(reader);
+    }
+    freeCond.notify_one();
+}
+
+NSData *MBTilesReader::readTile(int x,int y,int level)
+{
+    if (readers.empty())
+        return nil;
+
+    NSData *data = nil;
+    const auto reader = takeReader();
+    auto &stmt = *reader->tileStmt;
+    try
+    {
+        stmt.reset();
+        stmt.bind(level);
+        stmt.bind(x);
+        stmt.bind(y);
+        if (stmt.stepRow())
+            data = stmt.getBlob();
+    }
+    catch (int err)
+    {
+        logSQLError("Tile read failed",err);
+    }
+    // Don't hang on to the read lock between tiles
+    stmt.reset();
+    returnReader(reader);
+
+    return data;
+}
+
+void MBTilesReader::readRange(Reader &reader,int level,int minX,int minY,int maxX,int maxY,
+                              const std::vector<MaplyTileID> &tileIDs,const std::vector<int> &which,
+                              std::vector<NSData *> &results)
+{
+    // Same tile may have been asked for more than once
+    std::multimap<std::pair<int,int>,int> wanted;
+    for (int idx : which)
+        wanted.emplace(std::make_pair(tileIDs[idx].x,tileIDs[idx].y),idx);
+
+    auto &stmt = *reader.rangeStmt;
+    stmt.reset();
+    stmt.bind(level);
+    stmt.bind(minX);
+    stmt.bind(maxX);
+    stmt.bind(minY);
+    stmt.bind(maxY);
+    while (stmt.stepRow())
+    {
+        const int x = stmt.getInt();
+        const int y = stmt.getInt();
+        const auto range = wanted.equal_range(std::make_pair(x,y));
+        if (range.first == range.second)
+            continue;
+        NSData *data = stmt.getBlob();
+        for (auto it = range.first; it != range.second; ++it)
+            results[it->second] = data;
+    }
+    stmt.reset();
+}
+
+std::vector<NSData *> MBTilesReader::readTiles(const std::vector<MaplyTileID> &tileIDs)
+{
+    std::vector<NSData *> results(tileIDs.size(),nil);
+    if (readers.empty() || tileIDs.empty())
+        return results;
+
+    // Sort out the levels
+    std::map<int,std::vector<int>> byLevel;
+    for (int ii=0;ii<(int)tileIDs.size();ii++)
+        byLevel[tileIDs[ii].level].push_back(ii);
+
+    const auto reader = takeReader();
+    try
+    {
+        for (const auto &levelTiles : byLevel)
+        {
+            const auto &which = levelTiles.second;
+            int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+            for (int idx : which)
+            {
+                minX = std::min(minX,tileIDs[idx].x);  maxX = std::max(maxX,tileIDs[idx].x);
+                minY = std::min(minY,tileIDs[idx].y);  maxY = std::max(maxY,tileIDs[idx].y);
+            }
+
+            if (rangeWorthIt((int)which.size(),minX,minY,maxX,maxY))
+            {
+                readRange(*reader,levelTiles.first,minX,minY,maxX,maxY,tileIDs,which,results);
+                continue;
+            }
+
+            // Too spread out, so one at a time
+            auto &stmt = *reader->tileStmt;
+            for (int idx : which)
+            {
+                stmt.reset();
+                stmt.bind(tileIDs[idx].level);
+                stmt.bind(tileIDs[idx].x);
+                stmt.bind(tileIDs[idx].y);
+                if (stmt.stepRow())
+                    results[idx] = stmt.getBlob();
+            }
+            stmt.reset();
+        }
+    }
+    catch (int err)
+    {
+        logSQLError("Tile read failed",err);
+        reader->tileStmt->reset();
+        reader->rangeStmt->reset();
+    }
+    returnReader(reader);
+
+    return results;
+}
+
+}
@@ -139,6 +139,36 @@ using namespace WhirlyKit;
     params.edgeMatching = edgeMatching;
 }
 
+- (bool)meshTemplates
+{
+    return params.meshTemplates;
+}
+
+- (void)setMeshTemplates:(bool)meshTemplates
+{
+    params.meshTemplates = meshTemplates;
+}
+
+- (bool)includeElev
+{
+    return params.includeElev;
+}
+
+- (void)setIncludeElev:(bool)includeElev
+{
+    params.includeElev = includeElev;
+}
+
+- (bool)elevTextures
+{
+    return params.elevTextures;
+}
+
+- (void)setElevTextures:(bool)elevTextures
+{
+    params.elevTextures = elevTextures;
+}
+
 - (int)tessX
 {
     return params.tessX;
@@ -169,6 +199,36 @@ using namespace WhirlyKit;
     params.singleLevel = singleLevel;
 }
 
+- (bool)incrementalCoverage
+{
+    return params.incrementalCoverage;
+}
+
+- (void)setIncrementalCoverage:(bool)incrementalCoverage
+{
+    params.incrementalCoverage = incrementalCoverage;
+}
+
+- (bool)predictivePrefetch
+{
+    return params.predictivePrefetch;
+}
+
+- (void)setPredictivePrefetch:(bool)predictivePrefetch
+{
+    params.predictivePrefetch = predictivePrefetch;
+}
+
+- (int)displaySolidCacheSize
+{
+    return params.displaySolidCacheSize;
+}
+
+- (void)setDisplaySolidCacheSize:(int)displaySolidCacheSize
+{
+    params.displaySolidCacheSize = displaySolidCacheSize;
+}
+
 - (void)setForceMinLevel:(bool)forceMinLevel
 {
     params.forceMinLevel = forceMinLevel;
@@ -227,6 +287,16 @@ using namespace WhirlyKit;
     return params == other->params;
 }
 
++ (void)setTileMemoryBudget:(size_t)bytes
+{
+    TileMemoryManager::getShared().setBudget(bytes);
+}
+
++ (size_t)tileMemoryBudget
+{
+    return TileMemoryManager::getShared().getBudget();
+}
+
 @end
 
 @implementation MaplyQuadSamplingLayer
@@ -68,6 +68,7 @@ void StatementRead::init(sqlite3 *db,const char *stmtStr,bool justRun)
 	stmt = NULL;
 	isFinalized = false;
 	curField = 0;
+	bindField = 1;
 	
 	if (sqlite3_prepare_v2(db,stmtStr,-1,&stmt,NULL) != SQLITE_OK)
     {
@@ -119,6 +120,29 @@ void StatementRead::finalize()
 	}
 }
 	
+// Reset so we can run it again
+void StatementRead::reset()
+{
+	if (isFinalized || !valid)
+		return;
+
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+	curField = 0;
+	bindField = 1;
+}
+
+// Bind the next parameter
+void StatementRead::bind(int iVal)
+{
+	if (isFinalized || !valid)
+		throw SQLITE_IOERR_CLOSE;
+
+	const int res = sqlite3_bind_int(stmt,bindField++,iVal);
+	if (res != SQLITE_OK)
+		throw res;
+}
+	
 // Return int from the current row
 int StatementRead::getInt()
 {
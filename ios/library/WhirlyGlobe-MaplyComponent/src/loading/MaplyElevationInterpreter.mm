@@ -0,0 +1,116 @@
+/*  MaplyElevationInterpreter.mm
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "loading/MaplyElevationInterpreter.h"
+#import "MaplyQuadLoader_private.h"
+#import "MaplyRenderController_private.h"
+#import "ElevationManager.h"
+#import "WhirlyKitLog.h"
+
+using namespace WhirlyKit;
+
+@implementation MaplyElevationInterpreter
+{
+    ElevationManagerRef elevManager;
+    ElevationEncoding encoding;
+}
+
+- (nonnull instancetype)initWithViewC:(NSObject<MaplyRenderControllerProtocol> * __nonnull)viewC
+                             encoding:(MaplyElevationEncoding)inEncoding
+{
+    if (!(self = [super init]))
+        return nil;
+
+    encoding = inEncoding == MaplyElevationMapboxRGB ? ElevEncodeMapboxRGB : ElevEncodeTerrarium;
+    _maxBytes = 64*1024*1024;
+    if (const auto renderControl = [viewC getRenderControl])
+    {
+        if (renderControl->scene)
+            elevManager = renderControl->scene->getManager<ElevationManager>(kWKElevationManager);
+    }
+
+    return self;
+}
+
+- (void)setMaxBytes:(size_t)maxBytes
+{
+    _maxBytes = maxBytes;
+    if (elevManager)
+        elevManager->setMaxBytes(maxBytes);
+}
+
+- (void)setLoader:(MaplyQuadLoaderBase * __nonnull)loader
+{
+    if (!elevManager)
+        return;
+
+    // Lay the tiles out the way the loader does
+    const SamplingParams &params = loader->params;
+    elevManager->setup(params.coordSys,params.coordBounds,params.minZoom,params.maxZoom);
+    elevManager->setMaxBytes(_maxBytes);
+}
+
+- (void)dataForTile:(MaplyLoaderReturn * __nonnull)loadReturn loader:(MaplyQuadLoaderBase * __nonnull)loader
+{
+    if (!elevManager)
+        return;
+
+    const MaplyTileID tileID = loadReturn.tileID;
+    const QuadTreeIdentifier ident(tileID.x,tileID.y,tileID.level);
+    for (id data in [loadReturn getTileData])
+    {
+        if (loadReturn.isCancelled)
+            return;
+        if (![data isKindOfClass:[NSData class]])
+            continue;
+
+        NSData *pngData = (NSData *)data;
+        if (!elevManager->addTile(ident,(const unsigned char *)[pngData bytes],[pngData length],encoding))
+        {
+            wkLogLevel(Warn, "Failed to read elevation PNG in MaplyElevationInterpreter for tile %d: (%d,%d)",tileID.level,tileID.x,tileID.y);
+        }
+        break;
+    }
+}
+
+- (void)tileUnloaded:(MaplyTileID)tileID
+{
+    // The heights are still good for queries.  They go when the cache fills up.
+}
+
+- (int)heightsForCoords:(const MaplyCoordinate * __nonnull)coords heights:(double * __nonnull)heights count:(int)count
+{
+    if (!elevManager || count <= 0)
+    {
+        for (int ii=0;ii<count;ii++)
+            heights[ii] = 0.0;
+        return 0;
+    }
+
+    std::vector<Point2d> geo(count);
+    for (int ii=0;ii<count;ii++)
+        geo[ii] = Point2d(coords[ii].x,coords[ii].y);
+
+    return (int)elevManager->heightsAt(geo.data(),heights,count);
+}
+
+- (double)heightForCoord:(MaplyCoordinate)coord
+{
+    return elevManager ? elevManager->heightAt(Point2d(coord.x,coord.y)) : 0.0;
+}
+
+@end
@@ -22,6 +22,7 @@
 #import "MaplyImageTile_private.h"
 #import "MaplyRenderController_private.h"
 #import "WhirlyGlobeLib.h"
+#import "RawData_NSData.h"
 
 using namespace WhirlyKit;
 
@@ -176,6 +177,15 @@ using namespace WhirlyKit;
     imageTile->borderSize = 0;
     imageTile->imageStuff = data;
 
+    // Tiles already in a GPU format (KTX, KTX2, PKM or .astc) skip the decode
+    CompressedImageInfo info;
+    if (ParseCompressedImage(RawNSDataReader(data),info))
+    {
+        imageTile->type = MaplyImgTypeDataCompressed;
+        imageTile->width = info.width;
+        imageTile->height = info.height;
+    }
+
     return self;
 }
 
@@ -0,0 +1,185 @@
+/*  MaplyMultiResTileInfo.mm
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <vector>
+#import "loading/MaplyMultiResTileInfo.h"
+#import "Platform.h"
+
+using namespace WhirlyKit;
+
+// How often we look for a chance to upgrade, when there's something to upgrade
+static const NSTimeInterval UpgradeCheckPeriod = 2.0;
+
+@implementation MaplyMultiResTileInfo
+{
+    MaplyRemoteTileFetcher * __weak fetcher;
+    NSMutableArray<MaplyRemoteTileInfoNew *> *variants;
+    std::vector<double> minThroughputs;
+    // Lowest quality variant tiles have come from since the last switch
+    int worstServed;
+    // When the throughput first allowed something better than the current variant
+    TimeInterval upgradeStart;
+    bool checkPending;
+}
+
+- (nonnull instancetype)initWithFetcher:(MaplyRemoteTileFetcher *__nonnull)inFetcher
+{
+    if (!(self = [super init]))
+        return nil;
+
+    fetcher = inFetcher;
+    variants = [NSMutableArray new];
+    _currentVariant = 0;
+    _upgradeDelay = 10.0;
+    worstServed = 0;
+    upgradeStart = 0.0;
+    checkPending = false;
+
+    return self;
+}
+
+- (void)addVariant:(MaplyRemoteTileInfoNew *__nonnull)tileInfo minThroughput:(double)minThroughput
+{
+    @synchronized(self)
+    {
+        [variants addObject:tileInfo];
+        minThroughputs.push_back(minThroughput);
+        // Start cheap until we know better
+        _currentVariant = (int)[variants count] - 1;
+        worstServed = _currentVariant;
+    }
+}
+
+- (int)minZoom
+{
+    @synchronized(self)
+    {
+        int minZoom = [variants count] > 0 ? variants[0].minZoom : 0;
+        for (MaplyRemoteTileInfoNew *variant in variants)
+            minZoom = std::min(minZoom,variant.minZoom);
+        return minZoom;
+    }
+}
+
+- (int)maxZoom
+{
+    @synchronized(self)
+    {
+        int maxZoom = [variants count] > 0 ? variants[0].maxZoom : 0;
+        for (MaplyRemoteTileInfoNew *variant in variants)
+            maxZoom = std::max(maxZoom,variant.maxZoom);
+        return maxZoom;
+    }
+}
+
+// Switch variants if the throughput says to.  Returns true if the tiles we have should be replaced.
+// Lock must be held.
+- (bool)updateVariant
+{
+    MaplyRemoteTileFetcher *theFetcher = fetcher;
+    const double throughput = theFetcher ? theFetcher.throughput : 0.0;
+    // Nothing measured lately, so stick with what we've got
+    if (throughput <= 0.0 || [variants count] == 0)
+        return false;
+
+    int bestFit = (int)[variants count] - 1;
+    for (int which = 0;which < bestFit;which++)
+        if (throughput >= minThroughputs[which])
+        {
+            bestFit = which;
+            break;
+        }
+
+    if (bestFit >= _currentVariant)
+    {
+        _currentVariant = bestFit;
+        upgradeStart = 0.0;
+        return false;
+    }
+
+    // Better is possible, but make sure it's not just a blip
+    const TimeInterval now = TimeGetCurrent();
+    if (upgradeStart == 0.0)
+        upgradeStart = now;
+    if (now - upgradeStart < _upgradeDelay)
+        return false;
+
+    _currentVariant = bestFit;
+    upgradeStart = 0.0;
+    const bool replace = worstServed > _currentVariant;
+    worstServed = _currentVariant;
+    return replace;
+}
+
+// Keep checking in the background while there are tiles that could be better
+// Lock must be held.
+- (void)scheduleCheck
+{
+    if (checkPending || worstServed == 0 || !_loader)
+        return;
+    checkPending = true;
+
+    MaplyMultiResTileInfo * __weak weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(UpgradeCheckPeriod * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [weakSelf checkUpgrade];
+    });
+}
+
+- (void)checkUpgrade
+{
+    bool replace = false;
+    @synchronized(self)
+    {
+        checkPending = false;
+        replace = [self updateVariant];
+        [self scheduleCheck];
+    }
+
+    if (replace)
+        [_loader reload];
+}
+
+- (id _Nullable)fetchInfoForTile:(MaplyTileID)tileID flipY:(bool)flipY
+{
+    MaplyRemoteTileInfoNew *variant = nil;
+    bool replace = false;
+    @synchronized(self)
+    {
+        if ([variants count] == 0)
+            return nil;
+        replace = [self updateVariant];
+        variant = variants[_currentVariant];
+        worstServed = std::max(worstServed,_currentVariant);
+        [self scheduleCheck];
+    }
+
+    if (replace)
+    {
+        MaplyQuadLoaderBase * __weak weakLoader = _loader;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [weakLoader reload];
+        });
+    }
+
+    // This one doesn't go that deep, so the parent will have to do
+    if (tileID.level < variant.minZoom || tileID.level > variant.maxZoom)
+        return nil;
+
+    return [variant fetchInfoForTile:tileID flipY:flipY];
+}
+
+@end
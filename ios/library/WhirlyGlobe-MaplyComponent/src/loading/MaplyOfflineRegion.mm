@@ -0,0 +1,204 @@
+/*  MaplyOfflineRegion.mm
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "loading/MaplyOfflineRegion.h"
+#import "OfflineTileRegion.h"
+#import "Platform.h"
+
+using namespace WhirlyKit;
+
+// Tiles we'll look through for one pass, if they're all cached, before letting anything else on the queue
+static const int MaxChecksPerPass = 1000;
+
+@implementation MaplyOfflineRegion
+{
+    MaplyRemoteTileInfoNew *tileInfo;
+    MaplyRemoteTileFetcher *fetcher;
+    std::shared_ptr<OfflineTileRegion> region;
+    dispatch_queue_t queue;
+    // Next tile to look at and the fetches we have going
+    int64_t nextTile;
+    NSMutableSet<MaplyTileFetchRequest *> *active;
+    // Bumped on each start and stop, so answers from before are ignored
+    int generation;
+    TimeInterval lastProgress;
+}
+
+- (nonnull instancetype)initWithTileInfo:(MaplyRemoteTileInfoNew * __nonnull)inTileInfo
+                                 fetcher:(MaplyRemoteTileFetcher * __nonnull)inFetcher
+                                    bbox:(MaplyBoundingBoxD)bbox
+                                 minZoom:(int)minZoom
+                                 maxZoom:(int)maxZoom
+{
+    if (!(self = [super init]))
+        return nil;
+
+    tileInfo = inTileInfo;
+    fetcher = inFetcher;
+    queue = dispatch_queue_create("MaplyOfflineRegion", DISPATCH_QUEUE_SERIAL);
+    active = [NSMutableSet new];
+    generation = 0;
+    _maxConcurrent = 8;
+    _priority = 100;
+    _flipY = true;
+    _progressInterval = 0.5;
+
+    // Work out the tiles in the tile set's own coordinates
+    MaplyCoordinateSystem *coordSys = tileInfo.coordSys ?: [[MaplySphericalMercator alloc] initWebStandard];
+    MaplyCoordinate ll,ur;
+    [coordSys getBoundsLL:&ll ur:&ur];
+    const MbrD mbr(Point2d(ll.x,ll.y),Point2d(ur.x,ur.y));
+
+    MbrD regionMbr;
+    const MaplyCoordinate corners[4] = {
+        {(float)bbox.ll.x,(float)bbox.ll.y}, {(float)bbox.ur.x,(float)bbox.ll.y},
+        {(float)bbox.ur.x,(float)bbox.ur.y}, {(float)bbox.ll.x,(float)bbox.ur.y} };
+    for (const auto &corner : corners)
+    {
+        const MaplyCoordinate local = [coordSys geoToLocal:corner];
+        regionMbr.addPoint(Point2d(local.x,local.y));
+    }
+
+    region = std::make_shared<OfflineTileRegion>(mbr,regionMbr,std::max(minZoom,tileInfo.minZoom),std::min(maxZoom,tileInfo.maxZoom));
+    _numTiles = region->getNumTiles();
+
+    return self;
+}
+
+- (void)start
+{
+    dispatch_async(queue, ^{
+        if (self->_running)
+            return;
+        self->_running = true;
+        self->generation++;
+        self->nextTile = 0;
+        self->_tilesFetched = 0;
+        self->_tilesSkipped = 0;
+        self->_tilesFailed = 0;
+        self->_bytesFetched = 0;
+        self->lastProgress = 0.0;
+        [self fill];
+    });
+}
+
+- (void)stop
+{
+    dispatch_async(queue, ^{
+        if (!self->_running)
+            return;
+        self->_running = false;
+        self->generation++;
+        if ([self->active count] > 0)
+            [self->fetcher cancelTileFetches:[self->active allObjects]];
+        [self->active removeAllObjects];
+        [self reportProgress:true];
+    });
+}
+
+// Run on the queue.  Start fetches until we've got as many going as we're allowed.
+- (void)fill
+{
+    if (!_running)
+        return;
+
+    NSMutableArray<MaplyTileFetchRequest *> *toStart = [NSMutableArray new];
+    int checks = 0;
+    while ([active count] + [toStart count] < _maxConcurrent && nextTile < _numTiles)
+    {
+        // Lots of cached tiles in a row.  Let anything else waiting on the queue go.
+        if (checks++ >= MaxChecksPerPass)
+        {
+            dispatch_async(queue, ^{ [self fill]; });
+            break;
+        }
+
+        QuadTreeNew::Node node;
+        region->getTile(nextTile++,node);
+        MaplyTileID tileID;
+        tileID.x = node.x;  tileID.y = node.y;  tileID.level = node.level;
+
+        MaplyRemoteTileFetchInfo *fetchInfo = [tileInfo fetchInfoForTile:tileID flipY:_flipY];
+        if (!fetchInfo || [fetcher isCached:fetchInfo])
+        {
+            _tilesSkipped++;
+            continue;
+        }
+
+        MaplyTileFetchRequest *request = [[MaplyTileFetchRequest alloc] init];
+        request.tileID = tileID;
+        request.fetchInfo = fetchInfo;
+        request.tileSource = tileInfo;
+        request.priority = _priority;
+        request.importance = 0.0;
+        const int thisGeneration = generation;
+        MaplyOfflineRegion * __weak weakSelf = self;
+        request.success = ^(MaplyTileFetchRequest *request, id data) {
+            [weakSelf finished:request generation:thisGeneration length:[data isKindOfClass:[NSData class]] ? [(NSData *)data length] : 0 failed:false];
+        };
+        request.failure = ^(MaplyTileFetchRequest *request, NSError *error) {
+            [weakSelf finished:request generation:thisGeneration length:0 failed:true];
+        };
+        [toStart addObject:request];
+    }
+
+    if ([toStart count] > 0)
+    {
+        [active addObjectsFromArray:toStart];
+        [fetcher startTileFetches:toStart];
+    }
+
+    if ([active count] == 0 && nextTile >= _numTiles)
+    {
+        _running = false;
+        [self reportProgress:true];
+    } else
+        [self reportProgress:false];
+}
+
+// Called from the fetcher
+- (void)finished:(MaplyTileFetchRequest *)request generation:(int)whichGeneration length:(NSUInteger)length failed:(bool)failed
+{
+    dispatch_async(queue, ^{
+        if (whichGeneration != self->generation || ![self->active containsObject:request])
+            return;
+        [self->active removeObject:request];
+        if (failed)
+            self->_tilesFailed++;
+        else {
+            self->_tilesFetched++;
+            self->_bytesFetched += length;
+        }
+        [self fill];
+    });
+}
+
+// Run on the queue
+- (void)reportProgress:(bool)force
+{
+    const TimeInterval now = TimeGetCurrent();
+    if (!_progress || (!force && now - lastProgress < _progressInterval))
+        return;
+    lastProgress = now;
+
+    MaplyOfflineRegionProgress progress = _progress;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        progress(self);
+    });
+}
+
+@end
@@ -0,0 +1,249 @@
+/*  MaplyPointCloudLoader.mm
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "loading/MaplyPointCloudLoader.h"
+#import "MaplyControllerLayer_private.h"
+#import "MaplyShader_private.h"
+#import "MaplySharedAttributes.h"
+#import "Dictionary_NSDictionary.h"
+#import "PointCloudLoader.h"
+
+using namespace WhirlyKit;
+
+static MaplyOctreeID OctreeIDFromIdent(const OctreeIdentifier &ident)
+{
+    MaplyOctreeID node;
+    node.x = ident.x;  node.y = ident.y;  node.z = ident.z;
+    node.level = ident.level;
+    return node;
+}
+
+@implementation MaplyPointCloudChunk
+{
+@public
+    PointCloudChunkRef chunk;
+}
+
+- (instancetype)initWithLL:(MaplyCoordinate3dD)ll ur:(MaplyCoordinate3dD)ur
+{
+    self = [super init];
+    chunk = std::make_shared<PointCloudChunk>(Point3d(ll.x,ll.y,ll.z),Point3d(ur.x,ur.y,ur.z));
+
+    return self;
+}
+
+- (void)addDispCoordX:(double)x y:(double)y z:(double)z
+{
+    chunk->addPoint(Point3d(x,y,z));
+}
+
+- (void)addColorR:(float)r g:(float)g b:(float)b a:(float)a
+{
+    chunk->addColor(RGBAColor(r*255.0,g*255.0,b*255.0,a*255.0));
+}
+
+- (uint8_t)childMask
+{
+    return chunk->childMask;
+}
+
+- (void)setChildMask:(uint8_t)childMask
+{
+    chunk->childMask = childMask;
+}
+
+- (int)numPoints
+{
+    return (int)chunk->getNumPoints();
+}
+
+@end
+
+namespace WhirlyKit
+{
+
+// Passes fetches on to the Objective-C source
+class PointCloudSource_iOS : public PointCloudSource
+{
+public:
+    PointCloudSource_iOS(NSObject<MaplyPointCloudSource> *source,MaplyPointCloudLoader *loader)
+    : source(source), loader(loader) { }
+
+    virtual void startFetch(PointCloudLoader *,const OctreeIdentifier &ident) override
+    {
+        [source pointCloudLoader:loader startFetch:OctreeIDFromIdent(ident)];
+    }
+
+    virtual void cancelFetch(PointCloudLoader *,const OctreeIdentifier &ident) override
+    {
+        if ([source respondsToSelector:@selector(pointCloudLoader:cancelFetch:)])
+            [source pointCloudLoader:loader cancelFetch:OctreeIDFromIdent(ident)];
+    }
+
+protected:
+    NSObject<MaplyPointCloudSource> *source;
+    MaplyPointCloudLoader * __weak loader;
+};
+
+}
+
+@implementation MaplyPointCloudLoader
+{
+    PointCloudLoaderRef loader;
+    NSDictionary *desc;
+    WhirlyKitLayerThread * __weak layerThread;
+}
+
+- (instancetype)initWithLL:(MaplyCoordinate3dD)ll ur:(MaplyCoordinate3dD)ur maxLevel:(int)maxLevel rootSpacing:(double)rootSpacing source:(NSObject<MaplyPointCloudSource> *)source desc:(NSDictionary *)inDesc
+{
+    self = [super init];
+    if (!self)
+        return nil;
+
+    desc = inDesc;
+    _maxFetches = 8;
+    const auto sourceWrap = std::make_shared<PointCloudSource_iOS>(source,self);
+    loader = std::make_shared<PointCloudLoader>(Point3d(ll.x,ll.y,ll.z),Point3d(ur.x,ur.y,ur.z),maxLevel,rootSpacing,sourceWrap);
+
+    return self;
+}
+
+- (double)pixelSpacing
+{
+    return loader->getPixelSpacing();
+}
+
+- (void)setPixelSpacing:(double)pixelSpacing
+{
+    loader->setPixelSpacing(pixelSpacing);
+}
+
+- (size_t)memoryBudget
+{
+    return loader->getMemoryBudget();
+}
+
+- (void)setMemoryBudget:(size_t)memoryBudget
+{
+    loader->setMemoryBudget(memoryBudget);
+}
+
+- (void)setMaxFetches:(int)maxFetches
+{
+    _maxFetches = maxFetches;
+    loader->setMaxFetches(maxFetches);
+}
+
+- (void)boundsForNode:(MaplyOctreeID)node ll:(MaplyCoordinate3dD *)ll ur:(MaplyCoordinate3dD *)ur
+{
+    Point3d nodeLL,nodeUR;
+    loader->boundsForNode(OctreeIdentifier(node.x,node.y,node.z,node.level),nodeLL,nodeUR);
+    ll->x = nodeLL.x();  ll->y = nodeLL.y();  ll->z = nodeLL.z();
+    ur->x = nodeUR.x();  ur->y = nodeUR.y();  ur->z = nodeUR.z();
+}
+
+- (void)loadedChunk:(MaplyPointCloudChunk *)chunk forNode:(MaplyOctreeID)node
+{
+    loader->chunkLoaded(OctreeIdentifier(node.x,node.y,node.z,node.level),chunk->chunk);
+}
+
+- (void)failedNode:(MaplyOctreeID)node
+{
+    loader->chunkFailed(OctreeIdentifier(node.x,node.y,node.z,node.level));
+}
+
+- (int)numLoadedNodes
+{
+    return loader->getStats().numLoaded;
+}
+
+- (size_t)numDisplayedPoints
+{
+    return loader->getStats().numPointsDisplayed;
+}
+
+- (bool)startLayer:(WhirlyKitLayerThread *)inLayerThread scene:(WhirlyKit::Scene *)inScene renderer:(SceneRenderer *)renderer viewC:(NSObject<MaplyRenderControllerProtocol> *)viewC
+{
+    layerThread = inLayerThread;
+    super.layerThread = inLayerThread;
+
+    // Same point settings as addPoints:
+    iosDictionary dictWrap(desc);
+    GeometryInfo geomInfo(dictWrap);
+    if (geomInfo.pointSize == 0.0)
+        geomInfo.pointSize = kMaplyPointSizeDefault;
+    NSObject *shader = desc[kMaplyShader];
+    if ([shader isKindOfClass:[NSString class]])
+        shader = [viewC getShaderByName:(NSString *)shader];
+    if (![shader isKindOfClass:[MaplyShader class]])
+        shader = [viewC getShaderByName:kMaplyShaderParticleSystemPointDefault];
+    if ([shader isKindOfClass:[MaplyShader class]])
+        geomInfo.programID = [(MaplyShader *)shader getShaderID];
+    loader->setGeometryInfo(geomInfo);
+
+    loader->start(inScene);
+
+    [inLayerThread.viewWatcher addWatcherTarget:self selector:@selector(viewUpdate:) minTime:0.1 minDist:0.0 maxLagTime:10.0];
+
+    return true;
+}
+
+static const float DelayPeriod = 0.1;
+
+// Pick up fetches that finished while the view sat still
+- (void)delayCheck
+{
+    [self runUpdate:nullptr];
+}
+
+- (void)viewUpdate:(WhirlyKitViewStateWrapper *)inViewState
+{
+    [self runUpdate:inViewState.viewState];
+}
+
+- (void)runUpdate:(const ViewStateRef &)viewState
+{
+    if (!loader)
+        return;
+
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(delayCheck) object:nil];
+
+    ChangeSet changes;
+    if (loader->viewUpdate(NULL,viewState,changes))
+        [self performSelector:@selector(delayCheck) withObject:nil afterDelay:DelayPeriod];
+
+    [layerThread addChangeRequests:changes];
+}
+
+- (void)cleanupLayers:(WhirlyKitLayerThread *)inLayerThread scene:(WhirlyKit::Scene *)scene
+{
+    [inLayerThread.viewWatcher removeWatcherTarget:self selector:@selector(viewUpdate:)];
+
+    [self performSelector:@selector(teardown) onThread:inLayerThread withObject:nil waitUntilDone:NO];
+}
+
+- (void)teardown
+{
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(delayCheck) object:nil];
+
+    ChangeSet changes;
+    loader->stop(NULL,changes);
+
+    [layerThread addChangeRequests:changes];
+}
+
+@end
@@ -180,6 +180,45 @@ NSString * const MaplyQuadImageLoaderFetcherName = @"QuadImageLoader";
     [self updatePriorities];
 }
 
+- (void)setFrameWindow:(int)frameWindow
+{
+    if (!loader)
+        return;
+
+    loader->setFrameWindow(frameWindow);
+    _frameWindow = loader->getFrameWindow();
+
+    [self updatePriorities];
+}
+
+- (void)setCompositeFrames:(bool)compositeFrames
+{
+    if (!loader)
+        return;
+    if (started) {
+        NSLog(@"MaplyQuadImageFrameLoader: setCompositeFrames called too late.");
+        return;
+    }
+
+    loader->setCompositeFrames(compositeFrames);
+    _compositeFrames = loader->getCompositeFrames();
+}
+
+- (void)setTerrainWithEncoding:(MaplyElevationEncoding)encoding exaggeration:(double)exaggeration
+{
+    if (!loader)
+        return;
+    if (started) {
+        NSLog(@"MaplyQuadImageFrameLoader: setTerrainWithEncoding called too late.");
+        return;
+    }
+
+    loader->setTerrain(true, encoding == MaplyElevationMapboxRGB ? ElevEncodeMapboxRGB : ElevEncodeTerrarium, exaggeration);
+    _terrain = loader->getTerrain();
+    // The tile geometry needs to know, for the skirts
+    params.elevTextures = _terrain;
+}
+
 - (bool)delayedInit
 {
     started = true;
@@ -222,7 +261,8 @@ NSString * const MaplyQuadImageLoaderFetcherName = @"QuadImageLoader";
     loader->setCurFrame(NULL, focusID, curFrame);
     
     // Update the loading priorities if we're in narrow mode and we changed images
-    if (_loadFrameMode != MaplyLoadFrameBroad) {
+    // The frame window moves along with the image too
+    if (_loadFrameMode != MaplyLoadFrameBroad || _frameWindow > 0) {
         int oldInt = oldFrame;
         int newInt = curFrame;
 
@@ -263,11 +303,15 @@ NSString * const MaplyQuadImageLoaderFetcherName = @"QuadImageLoader";
     
     MaplyQuadImageFrameLoaderStats *retStats = [[MaplyQuadImageFrameLoaderStats alloc] init];
     retStats.numTiles = stats.numTiles;
+    retStats.texBytes = stats.texBytes;
+    retStats.numTexTiles = stats.numTexTiles;
     NSMutableArray *frameStats = [[NSMutableArray alloc] init];
     for (auto frameStat: stats.frameStats) {
         MaplyQuadImageFrameStats *retFrameStat = [[MaplyQuadImageFrameStats alloc] init];
         retFrameStat.totalTiles = frameStat.totalTiles;
         retFrameStat.tilesToLoad = frameStat.tilesToLoad;
+        retFrameStat.tilesLoaded = frameStat.tilesLoaded;
+        retFrameStat.resident = frameStat.resident;
         [frameStats addObject:retFrameStat];
     }
     retStats.frames = frameStats;
@@ -27,6 +27,10 @@
 #import "MaplyRenderTarget_private.h"
 #import "MaplyRenderController_private.h"
 #import "MaplyQuadSampler_private.h"
+#import "MaplyShader_private.h"
+#import "MaplyTexture_private.h"
+#import "DefaultShadersMTL.h"
+#import "WrapperMTL.h"
 
 using namespace WhirlyKit;
 
@@ -137,7 +141,16 @@ using namespace WhirlyKit;
         NSArray *tileDatas = [loadReturn getTileData];
         
         for (NSData *tileData in tileDatas) {
+            if ([loadReturn isCancelled]) {
+                return;
+            }
             MaplyImageTile *imageTile = [[MaplyImageTile alloc] initWithPNGorJPEGData:tileData viewC:vc];
+            if (!imageTile) {
+                continue;
+            }
+            imageTile->imageTile->maxDecodeSize = _maxDecodeSize;
+            // Decode here on the interpreter's thread rather than when the tile is merged in
+            [imageTile preprocessTexture];
             [loadReturn addImageTile:imageTile];
         }
     }
@@ -312,9 +325,37 @@ static const int debugColors[MaxDebugColors] = {0x86812D, 0x5EB9C9, 0x2A7E3E, 0x
 
 @end
 
+@implementation MaplyDataTileStyle
+
+- (instancetype)init
+{
+    if (!(self = [super init]))
+        return nil;
+
+    _minValue = 0.0;
+    _maxValue = 1.0;
+    _lowThreshold = -MAXFLOAT;
+    _highThreshold = MAXFLOAT;
+    _noDataValue = NAN;
+    _hillshade = 0.0;
+    _hillshadeScale = 1.0;
+    _lightAzimuth = 315.0;
+    _lightAltitude = 45.0;
+
+    return self;
+}
+
+@end
+
 @implementation MaplyQuadImageLoaderBase
 {
     bool _enable;
+    // Data tiles get their own program, since the style lives in its uniforms
+    MaplyShader *dataTileShader;
+    MaplyTexture *dataTileRamp;
+    UIImage *dataTileRampImage;
+    // Set once the app picks parentPlaceholders, otherwise the controller's default applies
+    bool parentPlaceholdersSet;
 }
 
 - (instancetype)initWithViewC:(NSObject<MaplyRenderControllerProtocol> *)inViewC
@@ -336,6 +377,12 @@ static const int debugColors[MaxDebugColors] = {0x86812D, 0x5EB9C9, 0x2A7E3E, 0x
     return self;
 }
 
+- (void)setParentPlaceholders:(bool)parentPlaceholders
+{
+    _parentPlaceholders = parentPlaceholders;
+    parentPlaceholdersSet = true;
+}
+
 - (bool)delayedInit
 {
     if (![super delayedInit])
@@ -360,6 +407,11 @@ static const int debugColors[MaxDebugColors] = {0x86812D, 0x5EB9C9, 0x2A7E3E, 0x
     loader->setMasterEnable(_enable);
     
     [loadInterp setLoader:self];
+
+    loader->setAsyncTextureUpload(_asyncTextureUpload);
+    if (parentPlaceholdersSet)
+        loader->setParentPlaceholders(_parentPlaceholders);
+    loader->setReprojectSamples(_reprojectSamples);
     
     // Sort out the texture format
     switch (self.imageFormat) {
@@ -416,13 +468,30 @@ static const int debugColors[MaxDebugColors] = {0x86812D, 0x5EB9C9, 0x2A7E3E, 0x
             break;
     }
     
+    if (_dataTileStyle && !dataTileShader) {
+        id<MTLLibrary> mtlLib = [vc getMetalLibrary];
+        if (mtlLib) {
+            dataTileShader = [[MaplyShader alloc] initMetalWithName:@"Data Tile"
+                                                              vertex:[mtlLib newFunctionWithName:@"vertexTri_multiTex"]
+                                                            fragment:[mtlLib newFunctionWithName:@"fragmentTri_dataTile"]
+                                                               viewC:vc];
+        }
+        if (dataTileShader)
+            [vc addShaderProgram:dataTileShader];
+        else
+            NSLog(@"MaplyQuadImageLoader: Data tiles need Metal.");
+    }
+
     for (unsigned int ii=0;ii<loader->getNumFocus();ii++) {
         if (loader->getShaderID(ii) == EmptyIdentity) {
-            MaplyShader *theShader = [vc getShaderByName:kMaplyShaderDefaultTriMultiTex];
+            NSString *shaderName = loader->getTerrain() ? kMaplyShaderDefaultTriTerrain :
+                                   (loader->getCompositeFrames() ? kMaplyShaderDefaultTriComposite : kMaplyShaderDefaultTriMultiTex);
+            MaplyShader *theShader = dataTileShader ? dataTileShader : [vc getShaderByName:shaderName];
             if (theShader)
                 loader->setShaderID(ii,[theShader getShaderID]);
         }
     }
+    [self applyDataTileStyle];
     
     // These might be changed by the setup call
     loader->setFlipY(self.flipY);
@@ -445,6 +514,80 @@ static const int debugColors[MaxDebugColors] = {0x86812D, 0x5EB9C9, 0x2A7E3E, 0x
     loader->setShaderID(0,[shader getShaderID]);
 }
 
+- (void)setDataTileStyle:(MaplyDataTileStyle *)dataTileStyle
+{
+    _dataTileStyle = dataTileStyle;
+
+    [self applyDataTileStyle];
+}
+
+// Hand the style to the data tile program.  The tiles themselves don't change.
+- (void)applyDataTileStyle
+{
+    const auto __strong vc = self.viewC;
+    MaplyDataTileStyle *style = _dataTileStyle;
+    if (!dataTileShader || !style || !vc)
+        return;
+
+    if (style.colorRamp != dataTileRampImage) {
+        if (dataTileRamp) {
+            [dataTileShader removeTexture:dataTileRamp viewC:vc];
+            [vc removeTextures:@[dataTileRamp] mode:MaplyThreadCurrent];
+            dataTileRamp = nil;
+        }
+        dataTileRampImage = style.colorRamp;
+        if (dataTileRampImage) {
+            dataTileRamp = [vc addTexture:dataTileRampImage
+                                     desc:@{kMaplyTexMinFilter: kMaplyMinFilterLinear,
+                                            kMaplyTexMagFilter: kMaplyMinFilterLinear}
+                                     mode:MaplyThreadCurrent];
+            if (dataTileRamp)
+                [dataTileShader setTexture:dataTileRamp forIndex:0 viewC:vc];
+        }
+    }
+
+    WhirlyKitShader::UniformDataTile uni;
+    memset(&uni, 0, sizeof(uni));
+    const double az = style.lightAzimuth / 180.0 * M_PI;
+    const double alt = style.lightAltitude / 180.0 * M_PI;
+    CopyIntoMtlFloat3(uni.lightDir, Point3d(sin(az) * cos(alt), cos(az) * cos(alt), sin(alt)));
+    uni.minValue = style.minValue;
+    uni.maxValue = style.maxValue;
+    uni.lowThreshold = style.lowThreshold;
+    uni.highThreshold = style.highThreshold;
+    uni.hasNoData = !std::isnan(style.noDataValue);
+    uni.noDataValue = uni.hasNoData ? style.noDataValue : 0.0;
+    uni.hillshade = std::min(std::max(style.hillshade, 0.0f), 1.0f);
+    uni.zScale = style.hillshadeScale;
+
+    NSData *uniBlock = [[NSData alloc] initWithBytes:&uni length:sizeof(uni)];
+    [dataTileShader setUniformBlock:uniBlock buffer:WhirlyKitShader::WKSUniformDataTileEntry];
+}
+
+- (void)shutdown
+{
+    [super shutdown];
+
+    // After the tiles are gone
+    const auto __strong thread = samplingLayer.layerThread;
+    if (dataTileShader && thread)
+        [self performSelector:@selector(cleanupDataTile) onThread:thread withObject:nil waitUntilDone:NO];
+}
+
+- (void)cleanupDataTile
+{
+    const auto __strong vc = self.viewC;
+    if (vc) {
+        if (dataTileRamp)
+            [vc removeTextures:@[dataTileRamp] mode:MaplyThreadCurrent];
+        if (dataTileShader)
+            [vc removeShaderProgram:dataTileShader];
+    }
+    dataTileRamp = nil;
+    dataTileRampImage = nil;
+    dataTileShader = nil;
+}
+
 - (void)setRenderTarget:(MaplyRenderTarget *__nonnull)renderTarget
 {
     if (!loader)
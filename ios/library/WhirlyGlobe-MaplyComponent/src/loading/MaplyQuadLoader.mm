@@ -24,6 +24,7 @@
 #import "visual_objects/MaplyScreenLabel.h"
 #import "MaplyQuadLoader_private.h"
 #import "RawData_NSData.h"
+#import "TaskScheduler.h"
 
 using namespace WhirlyKit;
 
@@ -101,6 +102,8 @@ using namespace WhirlyKit;
 @implementation MaplyQuadLoaderBase
 {
     NSMutableSet<MaplyLoaderReturn*> *pendingReturns;
+    // Parsed and waiting for the layer thread, also in pendingReturns
+    NSMutableArray<MaplyLoaderReturn*> *toMerge;
     std::mutex pendingReturnsLock;
     NSMutableArray<InitCompletionBlock> *_postInitCalls;
 }
@@ -118,10 +121,21 @@ using namespace WhirlyKit;
     _postInitCalls = [NSMutableArray new];
 
     pendingReturns = [NSMutableSet new];
+    toMerge = [NSMutableArray new];
 
     return self;
 }
 
++ (void)setSharedTaskThreads:(int)numThreads
+{
+    TaskScheduler::getShared().setNumThreads(numThreads);
+}
+
++ (int)sharedTaskThreads
+{
+    return TaskScheduler::getShared().getNumThreads();
+}
+
 - (bool)delayedInit
 {
     return valid;
@@ -179,6 +193,51 @@ using namespace WhirlyKit;
     return !ldr || ldr->getLoadingStatus();
 }
 
+- (void)setTileLatencyEnabled:(bool)enable
+{
+    _tileLatencyEnabled = enable;
+    [self addPostInitBlock:^{
+        if (const auto ldr = self->loader)
+            ldr->getLatencyStats()->setEnable(self->_tileLatencyEnabled);
+    }];
+}
+
+- (void)setReloadInPlace:(bool)reloadInPlace
+{
+    _reloadInPlace = reloadInPlace;
+    [self addPostInitBlock:^{
+        if (const auto ldr = self->loader)
+            ldr->setReloadInPlace(self->_reloadInPlace);
+    }];
+}
+
+- (NSDictionary<NSString *,NSDictionary<NSString *,NSNumber *> *> *)tileLatencyStats
+{
+    const auto ldr = loader;
+    if (!ldr || !_tileLatencyEnabled)
+        return nil;
+
+    const auto summaries = ldr->getLatencyStats()->getSummaries();
+    NSMutableDictionary *ret = [NSMutableDictionary dictionaryWithCapacity:summaries.size()];
+    for (const auto &summary : summaries)
+    {
+        ret[@(TileLatencyStats::getStageName(summary.stage))] =
+            @{@"count": @(summary.numTiles),
+              @"min": @(summary.minVal),
+              @"max": @(summary.maxVal),
+              @"mean": @(summary.mean),
+              @"p50": @(summary.p50),
+              @"p95": @(summary.p95)};
+    }
+    return ret;
+}
+
+- (void)clearTileLatencyStats
+{
+    if (const auto ldr = loader)
+        ldr->getLatencyStats()->clear();
+}
+
 - (MaplyBoundingBox)geoBoundsForTile:(MaplyTileID)tileID
 {
     if (!samplingLayer)
@@ -465,7 +524,7 @@ using namespace WhirlyKit;
 
     dispatch_queue_t theQueue = _queue;
     if (!theQueue)
-        theQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+        theQueue = dispatch_get_global_queue(QOS_CLASS_UTILITY, 0);
     dispatch_async(theQueue, ^{
         [self->loadInterp tileUnloaded:tileID];
     });
@@ -530,6 +589,13 @@ using namespace WhirlyKit;
     // Might be keeping the data coming back per frame
     // If we are, this tells us to merge when all the data has come back
     auto dataWrap = std::make_shared<RawNSDataReader>([loadReturn getFirstData]);
+
+    // An in-place reload that came back with the same data, so keep what's showing
+    if ([[loadReturn getFirstData] isKindOfClass:[NSData class]] && loader->frameUnchanged(nullptr,tileID,loadReturn->loadReturn->frame,dataWrap.get()))
+    {
+        [self cleanupLoadedData:loadReturn];
+        return;
+    }
     std::vector<RawDataRef> allData;
     //allData.reserve(?)
     if (loader->mergeLoadedFrame(loadReturn->loadReturn->ident,loadReturn->loadReturn->frame,dataWrap,allData))
@@ -554,59 +620,83 @@ using namespace WhirlyKit;
         if (!theQueue)
             theQueue = serialQueue;
         dispatch_semaphore_t theSemaphore = serialSemaphore;
+        // Tiles that have dropped out of view don't hold up the ones still in it
+        const double importance = loader->getTileImportance(tileID);
+        const auto qos = (importance > 0.0) ? QOS_CLASS_USER_INITIATED : QOS_CLASS_UTILITY;
 
         // Hold on to these till the task runs
         NSObject<MaplyLoaderInterpreter> *theLoadInterp = self->loadInterp;
 
-        dispatch_async(theQueue, ^{
-            if (!self->valid || !self->_viewC)
+        auto loadAndMerge = ^{
+            // No load interpreter means the fetcher created the objects.  Hopefully.
+            if (theLoadInterp && !loadReturn->loadReturn->cancel)
+                [theLoadInterp dataForTile:loadReturn loader:self];
+            
+            // Merge in the results on the sampling layer thread.
+            // If the load was canceled, or we're shutting down and the thread no
+            // longer exists, then we need to clean up the results to avoid leaks.
+            const auto __strong thread = self->samplingLayer.layerThread;
+            if (!thread || [thread isCancelled])
             {
                 [self cleanupLoadedData:loadReturn];
-                return;
             }
-
-            auto loadAndMerge = ^{
-                // No load interpreter means the fetcher created the objects.  Hopefully.
-                if (theLoadInterp && !loadReturn->loadReturn->cancel)
-                    [theLoadInterp dataForTile:loadReturn loader:self];
-                
-                // Merge in the results on the sampling layer thread.
-                // If the load was canceled, or we're shutting down and the thread no
-                // longer exists, then we need to clean up the results to avoid leaks.
-                const auto __strong thread = self->samplingLayer.layerThread;
-                if (!thread || [thread isCancelled])
-                {
-                    [self cleanupLoadedData:loadReturn];
-                }
-                else
+            else
+            {
+                // Objects in this LoaderReturn have already been added to the base controller.
+                // If the layer thread is stopped between now and when the perform occurs, those
+                // objects will not be cleaned up by mergeLoadedTiles, and need to be cleaned up
+                // in shutdown() instead.
+                // Tiles that finish while a merge is queued go in with it.
+                bool scheduleMerge = false;
                 {
-                    // Objects in this LoaderReturn have already been added to the base controller.
-                    // If the layer thread is stopped between now and when the perform occurs, those
-                    // objects will not be cleaned up by mergeLoadedTile(), and need to be cleaned up
-                    // in shutdown() instead.
+                    std::lock_guard<std::mutex> lock(self->pendingReturnsLock);
+                    if (self->valid)
                     {
-                        std::lock_guard<std::mutex> lock(self->pendingReturnsLock);
-                        if (self->valid)
-                        {
-                            [self->pendingReturns addObject:loadReturn];
-                        }
-                        else
-                        {
-                            // Shutdown already started, newly added objects may not be cleaned up.
-                            [self cleanupLoadedData:loadReturn];
-                        }
+                        [self->pendingReturns addObject:loadReturn];
+                        scheduleMerge = ([self->toMerge count] == 0);
+                        [self->toMerge addObject:loadReturn];
                     }
-                    if (self->valid)
+                    else
                     {
-                        [self performSelector:@selector(mergeLoadedTile:) onThread:thread withObject:loadReturn waitUntilDone:NO];
+                        // Shutdown already started, newly added objects may not be cleaned up.
+                        [self cleanupLoadedData:loadReturn];
                     }
                 }
-            };
-            
+                if (scheduleMerge)
+                {
+                    [self performSelector:@selector(mergeLoadedTiles) onThread:thread withObject:nil waitUntilDone:NO];
+                }
+            }
+        };
+
+        // Shared workers take the most important tiles first, from all the loaders.
+        // Cancelled tiles still go through, but skip the parsing.
+        auto &scheduler = TaskScheduler::getShared();
+        if (!_queue && scheduler.getNumThreads() > 0)
+        {
+            scheduler.addTask(importance, &loadReturn->loadReturn->cancel,
+                              [self,loadReturn,loadAndMerge](bool cancelled) {
+                @autoreleasepool {
+                    if (!self->valid || !self->_viewC)
+                        [self cleanupLoadedData:loadReturn];
+                    else
+                        loadAndMerge();
+                }
+            });
+            return;
+        }
+
+        dispatch_async(theQueue, ^{
+            if (!self->valid || !self->_viewC)
+            {
+                [self cleanupLoadedData:loadReturn];
+                return;
+            }
+
             if (theSemaphore) {
                 // Need to limit the number of simultaneous loader return parses
                 dispatch_semaphore_wait(theSemaphore, DISPATCH_TIME_FOREVER);
-                dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                dispatch_async(dispatch_get_global_queue(qos, 0), ^{
                     @try {
                         loadAndMerge();
                     } @finally {
@@ -623,30 +713,46 @@ using namespace WhirlyKit;
 }
 
 // Called on the SamplingLayer.LayerThread
-- (void)mergeLoadedTile:(MaplyLoaderReturn *)loadReturn
+// Everything parsed since the last merge goes in together, with one set of changes
+- (void)mergeLoadedTiles
 {
     const auto __strong thread = samplingLayer.layerThread;
 
-    // This object will be cleaned up
+    // These objects will be cleaned up
+    NSArray<MaplyLoaderReturn *> *loadReturns = nil;
     {
         std::lock_guard<std::mutex> lock(self->pendingReturnsLock);
-        [self->pendingReturns removeObject:loadReturn];
+        loadReturns = toMerge;
+        toMerge = [NSMutableArray new];
+        for (MaplyLoaderReturn *loadReturn in loadReturns)
+        {
+            [self->pendingReturns removeObject:loadReturn];
+        }
     }
 
     if (!loader || !thread || !valid)
     {
-        [self cleanupLoadedData:loadReturn];
+        for (MaplyLoaderReturn *loadReturn in loadReturns)
+        {
+            [self cleanupLoadedData:loadReturn];
+        }
         return;
     }
-    
-    ChangeSet changes;
-    if (!loadReturn->loadReturn->changes.empty()) {
-        [thread addChangeRequests:loadReturn->loadReturn->changes];
-        loadReturn->loadReturn->changes.clear();
+
+    std::vector<QuadLoaderReturn *> returns;
+    returns.reserve([loadReturns count]);
+    for (MaplyLoaderReturn *loadReturn in loadReturns)
+    {
+        returns.push_back(loadReturn->loadReturn.get());
     }
-    loader->mergeLoadedTile(nullptr,loadReturn->loadReturn.get(),changes);
 
-    loader->setLoadReturnRef(loadReturn->loadReturn->ident,loadReturn->loadReturn->frame,nullptr);
+    ChangeSet changes;
+    loader->mergeLoadedTiles(nullptr,returns,changes);
+
+    for (MaplyLoaderReturn *loadReturn in loadReturns)
+    {
+        loader->setLoadReturnRef(loadReturn->loadReturn->ident,loadReturn->loadReturn->frame,nullptr);
+    }
 
     [thread addChangeRequests:changes];
 }
@@ -662,6 +768,7 @@ using namespace WhirlyKit;
             [self cleanupLoadedData:loadReturn];
         }
         [pendingReturns removeAllObjects];
+        [toMerge removeAllObjects];
     }
 
     ChangeSet changes;
@@ -21,6 +21,9 @@
 #import "loading/MaplyRemoteTileFetcher.h"
 #import "MaplyRenderController_private.h"
 #import "MaplyURLSessionManager+Private.h"
+#import "TileCacheStore.h"
+#import "TileMemoryCache.h"
+#import "TileFetchThrottle.h"
 namespace WhirlyKit
 {
 
@@ -104,6 +107,15 @@ typedef struct TileInfoSorter {
 typedef std::set<TileInfoRef,TileInfoSorter> TileInfoSet;
 typedef std::map<MaplyTileFetchRequest *,TileInfoRef> TileFetchMap;
 
+// One network transfer and all the tiles waiting on it
+struct SharedFetch
+{
+    NSURLSessionDataTask *task;
+    std::string host;
+    std::vector<TileInfoRef> tiles;
+};
+typedef std::unordered_map<std::string,SharedFetch> SharedFetchMap;
+
 }
 
 using namespace WhirlyKit;
@@ -409,6 +421,38 @@ using namespace WhirlyKit;
     MaplyRemoteTileFetcherStats *recentStats;
     
     MaplyRemoteTileFetcherLog *log;
+
+    // Recently fetched tiles, by URL
+    TileMemoryCacheRef memCache;
+
+    // Network fetches in progress, by URL, so loaders asking for the same tile share one
+    SharedFetchMap sharedFetches;
+
+    // Connections each host gets, worked out from how it's responding
+    TileFetchThrottleRef throttle;
+}
+
+// Data that hangs on to the NSData it came from
+static RawDataRef RawDataForNSData(NSData *data)
+{
+    if ([data length] == 0)
+        return std::make_shared<RawDataWrapper>(nullptr,0,false);
+    CFTypeRef ref = CFBridgingRetain(data);
+    return std::make_shared<RawDataWrapper>([data bytes],[data length],[ref](const void *){ CFRelease(ref); });
+}
+
+// NSData that hangs on to the raw data rather than copying it
+static NSData *NSDataForRawData(const RawDataRef &rawData)
+{
+    if (rawData->getLen() == 0)
+        return [NSData data];
+    // The block keeps its own copy of the reference
+    const RawDataRef holdData = rawData;
+    return [[NSData alloc] initWithBytesNoCopy:(void *)rawData->getRawData()
+                                        length:rawData->getLen()
+                                   deallocator:^(void *bytes, NSUInteger length) {
+                                       (void)holdData;
+                                   }];
 }
 
 - (instancetype)initWithName:(NSString *)inName connections:(int)numConnections
@@ -422,10 +466,20 @@ using namespace WhirlyKit;
     session = [[MaplyURLSessionManager sharedManager] createURLSession];
     allStats = [[MaplyRemoteTileFetcherStats alloc] initWithFetcher:self];
     recentStats = [[MaplyRemoteTileFetcherStats alloc] initWithFetcher:self];
+    _memoryCacheSize = 16*1024*1024;
+    memCache = std::make_shared<TileMemoryCache>(_memoryCacheSize);
+    _adaptiveConnections = true;
+    throttle = std::make_shared<TileFetchThrottle>(std::min(2,numConnections),numConnections);
             
     return self;
 }
 
+- (void)setMemoryCacheSize:(NSUInteger)memoryCacheSize
+{
+    _memoryCacheSize = memoryCacheSize;
+    memCache->setMaxSize(memoryCacheSize);
+}
+
 - (void)setLocalStorage:(NSObject<MaplyTileLocalStorage> *)inLocalStorage
 {
     localStorage = inLocalStorage;
@@ -436,6 +490,11 @@ using namespace WhirlyKit;
     secondChance = inSecondChance;
 }
 
+- (double)throughput
+{
+    return throttle->getRate();
+}
+
 /// Return the fetching stats since the beginning or since the last reset
 - (MaplyRemoteTileFetcherStats * __nullable)getStats:(bool)allTime
 {
@@ -550,7 +609,8 @@ using namespace WhirlyKit;
         tilesByFetchRequest[request] = tile;
 
         // If it's already cached, just short circuit this
-        if (tile->fetchInfo.cacheFile && [self isTileLocal:tile fileName:tile->fetchInfo.cacheFile])
+        if ([self isTileInMemory:tile] ||
+            (tile->fetchInfo.cacheFile && [self isTileLocal:tile fileName:tile->fetchInfo.cacheFile]))
             tile->isLocal = true;
 
         // Just run the normal load
@@ -608,7 +668,7 @@ using namespace WhirlyKit;
         TileInfoRef tile = it->second;
         switch (tile->state) {
             case TileInfo::Loading:
-                [tile->task cancel];
+                [self cancelNetworkFetch:tile];
                 break;
             case TileInfo::ToLoad:
                 break;
@@ -622,11 +682,34 @@ using namespace WhirlyKit;
     [self updateLoading];
 }
 
+// Packed cache for the directory a cache file would go in, and the key for that file
+- (TileCacheStoreRef)cacheStoreForFile:(NSString *)fileName key:(std::string &)key
+{
+    key = [[fileName lastPathComponent] UTF8String];
+    const auto store = TileCacheStore::getShared([[fileName stringByDeletingLastPathComponent] UTF8String]);
+    if (store->getMaxSize() != _cacheSizeLimit)
+        store->setMaxSize(_cacheSizeLimit);
+    if (store->getLifetime() != _cacheLifetime)
+        store->setLifetime(_cacheLifetime);
+    return store;
+}
+
+- (bool)isCached:(MaplyRemoteTileFetchInfo *)fetchInfo
+{
+    return [self isTileLocal:TileInfoRef() fileName:fetchInfo.cacheFile];
+}
+
 - (bool)isTileLocal:(TileInfoRef)tile fileName:(NSString *)fileName
 {
     if (!fileName)
         return false;
     
+    if (_packedCache)
+    {
+        std::string key;
+        return [self cacheStoreForFile:fileName key:key]->contains(key);
+    }
+
     if ([[NSFileManager defaultManager] fileExistsAtPath:fileName])
     {
         return true;
@@ -660,6 +743,15 @@ using namespace WhirlyKit;
         NSString *dir = [tileInfo->fetchInfo.cacheFile stringByDeletingLastPathComponent];
         NSString *cacheFile = tileInfo->fetchInfo.cacheFile;
         
+        if (_packedCache) {
+            std::string key;
+            const auto store = [self cacheStoreForFile:cacheFile key:key];
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                store->add(key, [tileData bytes], [tileData length]);
+            });
+            return;
+        }
+
         // Do the actual writing somewhere else
         dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
             NSError *error;
@@ -673,17 +765,83 @@ using namespace WhirlyKit;
 {
     if (!tileInfo->fetchInfo.cacheFile)
         return nil;
+    if (_packedCache) {
+        std::string key;
+        const RawDataRef rawData = [self cacheStoreForFile:tileInfo->fetchInfo.cacheFile key:key]->find(key);
+        // Hand back the mapped data as-is
+        return rawData ? NSDataForRawData(rawData) : nil;
+    }
     return [NSData dataWithContentsOfFile:tileInfo->fetchInfo.cacheFile];
 }
 
+// Tiles are known by URL for the memory cache and for sharing fetches
+- (std::string)keyForTile:(TileInfoRef)tileInfo
+{
+    NSString *urlStr = tileInfo->fetchInfo.urlReq.URL.absoluteString;
+    return urlStr ? [urlStr UTF8String] : std::string();
+}
+
+- (bool)isTileInMemory:(TileInfoRef)tileInfo
+{
+    return _memoryCacheSize > 0 && memCache->find([self keyForTile:tileInfo]) != nullptr;
+}
+
+- (NSData *)readFromMemory:(TileInfoRef)tileInfo
+{
+    if (_memoryCacheSize == 0)
+        return nil;
+    const RawDataRef rawData = memCache->find([self keyForTile:tileInfo]);
+    return rawData ? NSDataForRawData(rawData) : nil;
+}
+
+- (void)writeToMemory:(TileInfoRef)tileInfo tileData:(NSData *)tileData
+{
+    if (_memoryCacheSize > 0 && tileData)
+        memCache->add([self keyForTile:tileInfo], RawDataForNSData(tileData));
+}
+
+// Host a tile's network fetch would go to
+static std::string HostForTile(const TileInfoRef &tile)
+{
+    NSString *host = tile->fetchInfo.urlReq.URL.host;
+    return host ? [host UTF8String] : std::string();
+}
+
+// Run on the dispatch queue
+- (bool)canStartTile:(const TileInfoRef &)tile
+{
+    // Only network fetches count against the hosts
+    return !_adaptiveConnections || tile->isLocal || throttle->canStart(HostForTile(tile));
+}
+
+// Connections the loading tiles are holding.  Run on the dispatch queue
+- (int)connectionsInUse
+{
+    if (!_immediateCacheReads)
+        return (int)loading.size();
+
+    // Cached tiles don't wait on the network, so they don't count
+    int count = 0;
+    for (const auto &tile : loading)
+        if (!tile->isLocal)
+            count++;
+    return count;
+}
+
 // Run on the dispatch queue
 - (void)updateLoading
 {
+    throttle->setLimits(std::min(2,_numConnections),_numConnections);
+
     // Ask for a few more to load
-    while (loading.size() < _numConnections) {
+    int inUse = [self connectionsInUse];
+    while (inUse < _numConnections) {
         [self updateActiveStats];
 
+        // The most important one we can start, passing over those for hosts that are busy
         auto nextLoad = toLoad.rbegin();
+        while (nextLoad != toLoad.rend() && ![self canStartTile:*nextLoad])
+            ++nextLoad;
         if (nextLoad == toLoad.rend())
             break;
         
@@ -692,30 +850,26 @@ using namespace WhirlyKit;
         toLoad.erase(std::next(nextLoad).base());
         tile->state = TileInfo::Loading;
         loading.insert(tile);
+        if (!_immediateCacheReads || !tile->isLocal)
+            inUse++;
         
         NSURLRequest *urlReq = tile->fetchInfo.urlReq;
         
-        TimeInterval fetchStartTile = TimeGetCurrent();
-        
         if (_debugMode)
             NSLog(@"Started load: %@ priority = %d, importance = %f, group = %d",urlReq.URL.absoluteString,tile->priority,tile->importance,tile->group);
         
-        // Set up the fetch task so we can use it in a couple places
         MaplyRemoteTileFetcher * __weak weakSelf = self;
-        tile->task = [session dataTaskWithRequest:urlReq completionHandler:
-                      ^(NSData * _Nullable data, NSURLResponse * _Nullable inResponse, NSError * _Nullable error) {
-                          NSHTTPURLResponse *response = (NSHTTPURLResponse *)inResponse;
 
-                          if (dispatch_queue_t queue = [weakSelf getQueue])
-                              dispatch_async(queue, ^{
-                                     [weakSelf handleData:data response:response error:error tile:tile fetchStart:fetchStartTile];
-                                 });
-                        }];
-        
-        // Look for it in local storage first
+        // Look in memory for tiles we've fetched recently, then in local storage
         bool inLocalStorage = false;
+        if (NSData *data = [self readFromMemory:tile]) {
+            inLocalStorage = true;
+            if (_debugMode)
+                NSLog(@"Memory for: %@, %dk",urlReq.URL.absoluteString,(int)[data length] / 1024);
+            [self handleFinishLoading:data tile:tile];
+        }
         const auto __strong ls = localStorage;
-        if (ls) {
+        if (ls && !inLocalStorage) {
             NSData *data = [ls dataForTile:tile->fetchInfo tileID:tile->tileID];
             if (data) {
                 inLocalStorage = true;
@@ -733,7 +887,7 @@ using namespace WhirlyKit;
                     [weakSelf handleCache:tile];
                 });
             } else {
-                [tile->task resume];
+                [self startNetworkFetch:tile];
             }
         }
     }
@@ -741,6 +895,94 @@ using namespace WhirlyKit;
     [self updateActiveStats];
 }
 
+// Run on the dispatch queue
+- (void)startNetworkFetch:(TileInfoRef)tile
+{
+    // Cancelled while we were looking in the cache
+    if (tilesByFetchRequest.find(tile->request) == tilesByFetchRequest.end())
+        return;
+
+    // Someone else is already fetching this one, so wait on theirs
+    const std::string key = [self keyForTile:tile];
+    auto it = sharedFetches.find(key);
+    if (it != sharedFetches.end()) {
+        if (_debugMode)
+            NSLog(@"Sharing load: %@",tile->fetchInfo.urlReq.URL.absoluteString);
+        tile->task = it->second.task;
+        it->second.tiles.push_back(tile);
+        return;
+    }
+
+    TimeInterval fetchStartTile = TimeGetCurrent();
+    MaplyRemoteTileFetcher * __weak weakSelf = self;
+    NSURLSessionDataTask *task = [session dataTaskWithRequest:tile->fetchInfo.urlReq completionHandler:
+                      ^(NSData * _Nullable data, NSURLResponse * _Nullable inResponse, NSError * _Nullable error) {
+                          NSHTTPURLResponse *response = (NSHTTPURLResponse *)inResponse;
+
+                          if (dispatch_queue_t queue = [weakSelf getQueue])
+                              dispatch_async(queue, ^{
+                                     [weakSelf handleData:data response:response error:error fetchKey:key fetchStart:fetchStartTile];
+                                 });
+                        }];
+    tile->task = task;
+    SharedFetch &fetch = sharedFetches[key];
+    fetch.task = task;
+    fetch.host = HostForTile(tile);
+    fetch.tiles.push_back(tile);
+    throttle->started(fetch.host);
+    [task resume];
+}
+
+// Run on the dispatch queue
+- (void)cancelNetworkFetch:(TileInfoRef)tile
+{
+    if (!tile->task)
+        return;
+
+    // Only stop the transfer if nobody else wants it
+    auto it = sharedFetches.find([self keyForTile:tile]);
+    if (it != sharedFetches.end()) {
+        auto &tiles = it->second.tiles;
+        tiles.erase(std::remove(tiles.begin(), tiles.end(), tile), tiles.end());
+        if (tiles.empty()) {
+            [it->second.task cancel];
+            throttle->cancelled(it->second.host);
+            sharedFetches.erase(it);
+        }
+    }
+    tile->task = nil;
+}
+
+// Run on the dispatch queue
+- (void)handleData:(NSData *)data response:(NSHTTPURLResponse *)response error:(NSError *)error fetchKey:(const std::string &)key fetchStart:(TimeInterval)fetchStartTile
+{
+    auto it = sharedFetches.find(key);
+    if (it == sharedFetches.end())
+        return;
+    const std::vector<TileInfoRef> tiles = std::move(it->second.tiles);
+    const std::string host = it->second.host;
+    sharedFetches.erase(it);
+
+    // Timeouts and busy servers mean the host wants fewer connections.  Any other answer tells us how it's doing.
+    if (error && error.code == NSURLErrorCancelled) {
+        throttle->cancelled(host);
+    } else if (error || response.statusCode == 429 || response.statusCode >= 500) {
+        throttle->failed(host);
+    } else {
+        throttle->finished(host,TimeGetCurrent() - fetchStartTile,[data length]);
+    }
+
+    // Everyone gets the data, but it's only counted once and only written once to each cache file
+    std::set<std::string> cacheFiles;
+    bool first = true;
+    for (const auto &tile : tiles) {
+        NSString *cacheFile = tile->fetchInfo.cacheFile;
+        const bool writeCache = !cacheFile || cacheFiles.insert([cacheFile UTF8String]).second;
+        [self handleData:data response:response error:error tile:tile fetchStart:fetchStartTile countStats:first writeCache:writeCache];
+        first = false;
+    }
+}
+
 - (void)updateActiveStats
 {
     recentStats.activeRequests = loading.size()+toLoad.size();
@@ -748,7 +990,10 @@ using namespace WhirlyKit;
 }
 
 - (void)handleData:(NSData *)data response:(NSHTTPURLResponse *)response error:(NSError *)error tile:(TileInfoRef)tile fetchStart:(TimeInterval)fetchStartTile
+        countStats:(bool)countStats writeCache:(bool)writeCache
 {
+    tile->task = nil;
+
     bool success = true;
     bool useCache = true;
     
@@ -778,20 +1023,28 @@ using namespace WhirlyKit;
        if (log)
            [log addRemoteSuccess:tile length:length startTime:fetchStartTile];
 
-       allStats.remoteRequests = allStats.remoteRequests + 1;
-       recentStats.remoteRequests = recentStats.remoteRequests + 1;
-       allStats.remoteData = allStats.remoteData + length;
-       recentStats.remoteData = recentStats.remoteData + length;
-       TimeInterval howLong = TimeGetCurrent() - fetchStartTile;
-       allStats.totalLatency = allStats.totalLatency + howLong;
-       recentStats.totalLatency = recentStats.totalLatency + howLong;
+       if (countStats) {
+           allStats.remoteRequests = allStats.remoteRequests + 1;
+           recentStats.remoteRequests = recentStats.remoteRequests + 1;
+           allStats.remoteData = allStats.remoteData + length;
+           recentStats.remoteData = recentStats.remoteData + length;
+           TimeInterval howLong = TimeGetCurrent() - fetchStartTile;
+           allStats.totalLatency = allStats.totalLatency + howLong;
+           recentStats.totalLatency = recentStats.totalLatency + howLong;
+       }
        [self finishedLoading:tile data:data error:error];
-       if (useCache)
-           [self writeToCache:tile tileData:data];
+       if (useCache) {
+           if (countStats)
+               [self writeToMemory:tile tileData:data];
+           if (writeCache)
+               [self writeToCache:tile tileData:data];
+       }
     } else {
         // Failed.  Sad.  :-{
-        allStats.totalFails = allStats.totalFails + 1;
-        recentStats.totalFails = recentStats.totalFails + 1;
+        if (countStats) {
+            allStats.totalFails = allStats.totalFails + 1;
+            recentStats.totalFails = recentStats.totalFails + 1;
+        }
         if (_debugMode)
             NSLog(@"Remote fail for: %@",tile->fetchInfo.urlReq.URL.absoluteString);
         // Build an NSError around the status code
@@ -810,14 +1063,16 @@ using namespace WhirlyKit;
     NSData *data = [self readFromCache:tile];
     if (!data) {
         // It failed (which happens) so we need to fetch it after all
-        [tile->task resume];
+        MaplyRemoteTileFetcher * __weak weakSelf = self;
+        dispatch_async(queue,^{
+            [weakSelf startNetworkFetch:tile];
+        });
     } else {
-        tile->task = nil;
-        
         if (_debugMode)
             NSLog(@"Cache for: %@, %dk",tile->fetchInfo.urlReq.URL.absoluteString,(int)[data length] / 1024);
         if (log)
             [log addCache:tile length:[data length]];
+        [self writeToMemory:tile tileData:data];
         
         MaplyRemoteTileFetcher * __weak weakSelf = self;
         // It worked, but run the finished loading back on our queue
@@ -905,6 +1160,10 @@ using namespace WhirlyKit;
     
     toLoad.clear();
     loading.clear();
+    for (auto &it : sharedFetches) {
+        [it.second.task cancel];
+    }
+    sharedFetches.clear();
     for (auto it : tilesByFetchRequest) {
         it.second->clear();
     }
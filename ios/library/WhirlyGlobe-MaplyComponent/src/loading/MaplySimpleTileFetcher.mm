@@ -106,6 +106,7 @@ typedef std::map<MaplyTileFetchRequest *,TileInfoRef> TileFetchMap;
 {
     bool active;
     bool loadScheduled;
+    int numReading;
     int minZoom,maxZoom;
     MaplySimpleTileInfo *tileInfo;
     
@@ -122,6 +123,9 @@ typedef std::map<MaplyTileFetchRequest *,TileInfoRef> TileFetchMap;
     minZoom = inMinZoom;
     maxZoom = inMaxZoom;
     _neverFail = true;
+    _maxConcurrentReads = 1;
+    _maxTilesPerRead = 1;
+    numReading = 0;
     
     tileInfo = [[MaplySimpleTileInfo alloc] initWithMinZoom:minZoom maxZoom:maxZoom];
     _queue = dispatch_queue_create([_name cStringUsingEncoding:NSASCIIStringEncoding], DISPATCH_QUEUE_SERIAL);
@@ -152,6 +156,18 @@ typedef std::map<MaplyTileFetchRequest *,TileInfoRef> TileFetchMap;
     return nil;
 }
 
+- (NSArray *)dataForTiles:(NSArray *)fetchInfos tileIDs:(const MaplyTileID *)tileIDs
+{
+    NSMutableArray *tileData = [NSMutableArray arrayWithCapacity:fetchInfos.count];
+    for (unsigned int ii=0;ii<fetchInfos.count;ii++)
+    {
+        id data = [self dataForTile:fetchInfos[ii] tileID:tileIDs[ii]];
+        [tileData addObject:data ? data : [NSNull null]];
+    }
+    
+    return tileData;
+}
+
 - (void)updateLoading
 {
     loadScheduled = false;
@@ -162,6 +178,12 @@ typedef std::map<MaplyTileFetchRequest *,TileInfoRef> TileFetchMap;
     if (toLoad.empty())
         return;
     
+    if (_maxConcurrentReads > 1 || _maxTilesPerRead > 1)
+    {
+        [self updateLoadingBatched];
+        return;
+    }
+    
     // Take the first one off the stack
     auto it = toLoad.rbegin();
     TileInfoRef tile = *it;
@@ -199,6 +221,64 @@ typedef std::map<MaplyTileFetchRequest *,TileInfoRef> TileFetchMap;
     [weakSelf finishTile:tile];
 }
 
+// Hand groups of tiles off to be read on background queues, as many as we're allowed at once
+- (void)updateLoadingBatched
+{
+    MaplySimpleTileFetcher * __weak weakSelf = self;
+    const int tilesPerRead = std::max(_maxTilesPerRead,1);
+    
+    while (numReading < std::max(_maxConcurrentReads,1) && !toLoad.empty())
+    {
+        // The most important tile and the next ones on the same level
+        std::vector<TileInfoRef> tiles;
+        const int level = (*toLoad.rbegin())->fetchInfo.level;
+        for (auto it = toLoad.rbegin(); it != toLoad.rend() && (int)tiles.size() < tilesPerRead; ++it)
+            if ((*it)->fetchInfo.level == level)
+                tiles.push_back(*it);
+        
+        NSMutableArray *fetchInfos = [NSMutableArray arrayWithCapacity:tiles.size()];
+        std::vector<MaplyTileID> tileIDs;
+        tileIDs.reserve(tiles.size());
+        for (const auto &tile : tiles)
+        {
+            [fetchInfos addObject:tile->fetchInfo];
+            tileIDs.push_back(MaplyTileID { tile->fetchInfo.x, tile->fetchInfo.y, tile->fetchInfo.level });
+            [self finishTile:tile];
+        }
+        
+        numReading++;
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+                       ^{
+                           MaplySimpleTileFetcher *strongSelf = weakSelf;
+                           NSArray *tileData = [strongSelf dataForTiles:fetchInfos tileIDs:tileIDs.data()];
+                           for (unsigned int ii=0;ii<tiles.size();ii++)
+                           {
+                               const auto &tile = tiles[ii];
+                               id data = (ii < tileData.count) ? tileData[ii] : nil;
+                               if (data == [NSNull null])
+                                   data = nil;
+                               if (data || strongSelf.neverFail) {
+                                   tile->request.success(tile->request,data);
+                               } else {
+                                   NSError *error = [[NSError alloc] initWithDomain:@"MaplySimpleTileFetcher" code:0 userInfo:@{NSLocalizedDescriptionKey: @"Failed to fetch tile from sqlite file"}];
+                                   tile->request.failure(tile->request, error);
+                               }
+                           }
+                           
+                           dispatch_queue_t theQueue = strongSelf.queue;
+                           if (theQueue)
+                               dispatch_async(theQueue,
+                                              ^{
+                                                  MaplySimpleTileFetcher *queueSelf = weakSelf;
+                                                  if (queueSelf) {
+                                                      queueSelf->numReading--;
+                                                      [queueSelf updateLoading];
+                                                  }
+                                              });
+                       });
+    }
+}
+
 - (void)finishTile:(TileInfoRef)tile
 {
     // Done with the tile, so take it out of here
@@ -0,0 +1,160 @@
+/*  MaplyVectorTiler.mm
+ *  WhirlyGlobe-MaplyComponent
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <unordered_map>
+#import "loading/MaplyVectorTiler.h"
+#import "MaplyVectorObject_private.h"
+#import "MapboxVectorTiles_private.h"
+#import "VectorTiler.h"
+
+using namespace WhirlyKit;
+
+// Tile info with nothing to fetch, so the loader goes straight to the interpreter
+@interface MaplyVectorTilerTileInfo : NSObject<MaplyTileInfoNew>
+@property (nonatomic) int minZoom,maxZoom;
+@end
+
+@implementation MaplyVectorTilerTileInfo
+
+- (id _Nullable)fetchInfoForTile:(MaplyTileID)tileID flipY:(bool)flipY
+{
+    return [NSNull null];
+}
+
+@end
+
+@implementation MaplyVectorTiler
+{
+    NSObject<MaplyVectorStyleDelegate> * __weak styleDelegate;
+    NSObject<MaplyRenderControllerProtocol> * __weak viewC;
+    VectorTilerRef tiler;
+}
+
+- (nonnull instancetype)initWithStyle:(NSObject<MaplyVectorStyleDelegate> *__nonnull)inStyleDelegate
+                                viewC:(NSObject<MaplyRenderControllerProtocol> *__nonnull)inViewC
+{
+    if (!(self = [super init]))
+        return nil;
+
+    styleDelegate = inStyleDelegate;
+    viewC = inViewC;
+
+    const VectorTilerSettings defaults;
+    _maxZoom = defaults.maxZoom;
+    _indexMaxZoom = defaults.indexMaxZoom;
+    _indexMaxPoints = defaults.indexMaxPoints;
+    _tolerance = defaults.tolerance;
+    _buffer = defaults.buffer;
+
+    return self;
+}
+
+- (void)addVectors:(NSArray<MaplyVectorObject *> *__nonnull)vecObjs
+{
+    if (!tiler)
+    {
+        VectorTilerSettings settings;
+        settings.maxZoom = _maxZoom;
+        settings.indexMaxZoom = _indexMaxZoom;
+        settings.indexMaxPoints = _indexMaxPoints;
+        settings.tolerance = _tolerance;
+        settings.buffer = _buffer;
+        tiler = std::make_shared<VectorTiler>(settings);
+    }
+
+    for (MaplyVectorObject *vecObj in vecObjs)
+        tiler->addShapes(vecObj->vObj->shapes);
+}
+
+- (NSObject<MaplyTileInfoNew> *__nonnull)tileInfo
+{
+    MaplyVectorTilerTileInfo *tileInfo = [[MaplyVectorTilerTileInfo alloc] init];
+    tileInfo.minZoom = 0;
+    tileInfo.maxZoom = _maxZoom;
+    return tileInfo;
+}
+
+- (void)setLoader:(MaplyQuadLoaderBase * __nonnull)loader
+{
+}
+
+- (void)dataForTile:(MaplyLoaderReturn * __nonnull)loadReturn loader:(MaplyQuadLoaderBase * __nonnull)loader
+{
+    const auto __strong vc = viewC;
+    const auto __strong styles = styleDelegate;
+    if (!tiler || !vc || !styles)
+        return;
+
+    const MaplyTileID tileID = loadReturn.tileID;
+    const auto shapes = tiler->getTile(tileID.x,tileID.y,tileID.level);
+    if (shapes.empty() || loadReturn.isCancelled)
+        return;
+
+    // Pieces of the same feature share attributes, so put them back together
+    std::unordered_map<const Dictionary *,VectorObjectRef> features;
+    std::vector<VectorObjectRef> featureOrder;
+    for (const auto &shape : shapes)
+    {
+        auto &feature = features[shape->getAttrDict().get()];
+        if (!feature)
+        {
+            feature = std::make_shared<VectorObject>();
+            featureOrder.push_back(feature);
+        }
+        feature->shapes.insert(shape);
+    }
+
+    MaplyVectorTileData *tileData = [[MaplyVectorTileData alloc] initWithID:tileID
+                                                                       bbox:[loader boundsForTileD:tileID]
+                                                                    geoBBox:[loader geoBoundsForTileD:tileID]];
+    NSMutableDictionary *featureStyles = [NSMutableDictionary new];
+    for (const auto &feature : featureOrder)
+    {
+        MaplyVectorObject *vecObj = [[MaplyVectorObject alloc] initWithRef:feature];
+        NSDictionary *attrs = vecObj.attributes ?: @{};
+        for (NSObject<MaplyVectorStyle> *style in [styles stylesForFeatureWithAttributes:attrs onTile:tileID inLayer:@"" viewC:vc])
+        {
+            NSMutableArray *featuresForStyle = featureStyles[@(style.uuid)];
+            if (!featuresForStyle)
+            {
+                featuresForStyle = [NSMutableArray new];
+                featureStyles[@(style.uuid)] = featuresForStyle;
+            }
+            [featuresForStyle addObject:vecObj];
+        }
+    }
+
+    NSArray *styleKeys = [featureStyles.allKeys sortedArrayUsingSelector:@selector(compare:)];
+    for (NSNumber *key in styleKeys)
+    {
+        if (loadReturn.isCancelled)
+            break;
+        NSObject<MaplyVectorStyle> *style = [styles styleForUUID:[key longLongValue] viewC:vc];
+        [style buildObjects:featureStyles[key] forTile:tileData viewC:vc desc:nil cancelFn:^bool{
+            return loadReturn.isCancelled;
+        }];
+    }
+
+    if ([loadReturn isKindOfClass:[MaplyObjectLoaderReturn class]])
+        [(MaplyObjectLoaderReturn *)loadReturn addCompObjs:[tileData componentObjects]];
+}
+
+- (void)tileUnloaded:(MaplyTileID)tileID
+{
+}
+
+@end
@@ -246,6 +246,16 @@ using namespace WhirlyKit;
     return p4CoordSys != nil && p4CoordSys->isValid();
 }
 
+- (void)setApproxGridCellsX:(int)cellsX cellsY:(int)cellsY
+{
+    if (!p4CoordSys)
+        return;
+
+    MaplyCoordinate ll,ur;
+    [self getBoundsLL:&ll ur:&ur];
+    p4CoordSys->setApproxGrid(MbrD(Point2d(ll.x,ll.y),Point2d(ur.x,ur.y)),cellsX,cellsY);
+}
+
 @end
 
 MaplyCoordinateSystem *MaplyCoordinateSystemFromEPSG(NSString *crs)
@@ -22,6 +22,53 @@
 
 using namespace WhirlyKit;
 
+// Hand the readback to the caller's block on the main queue
+static SceneRenderer::ReadbackCallback MakeReadbackCallback(void (^completion)(NSData *))
+{
+    return [completion](RawDataRef dataRef) {
+        NSData *data = nil;
+        if (const auto rawData = dynamic_cast<RawNSDataReader*>(dataRef.get())) {
+            data = rawData->getData();
+        }
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(data);
+        });
+    };
+}
+
+@implementation MaplyRenderTargetHistogram
+{
+    RenderTargetHistogramRef hist;
+}
+
+- (instancetype)initWithHistogram:(RenderTargetHistogramRef)inHist
+{
+    self = [super init];
+    hist = inHist;
+
+    NSMutableArray<NSNumber *> *bins = [NSMutableArray arrayWithCapacity:hist->bins.size()];
+    for (uint32_t count : hist->bins)
+        [bins addObject:@(count)];
+    _bins = bins;
+    _minVal = hist->minVal;
+    _maxVal = hist->maxVal;
+    _numPixels = hist->numPixels;
+
+    return self;
+}
+
+- (float)percentile:(double)frac
+{
+    return hist->percentile(frac);
+}
+
+- (float)mean
+{
+    return hist->mean();
+}
+
+@end
+
 @implementation MaplyRenderTarget
 
 - (id)init
@@ -34,6 +81,7 @@ using namespace WhirlyKit;
     _clearVal = 0.0;
     _mipmapType = MaplyMipmapNone;
     _calculateMinMax = false;
+    _renderWhenChanged = true;
     
     return self;
 }
@@ -77,4 +125,63 @@ using namespace WhirlyKit;
     return nil;
 }
 
+- (void)getValueAtX:(int)x y:(int)y completion:(void (^)(NSData *))completion
+{
+    [self addReadbackX:x y:y width:1 height:1 minMax:false completion:completion];
+}
+
+- (void)getSnapshotWithCompletion:(void (^)(NSData *))completion
+{
+    [self addReadbackX:0 y:0 width:0 height:0 minMax:false completion:completion];
+}
+
+- (void)getMinMaxValuesWithCompletion:(void (^)(NSData *))completion
+{
+    [self addReadbackX:0 y:0 width:0 height:0 minMax:true completion:completion];
+}
+
+- (void)getHistogramWithBins:(int)numBins minVal:(float)minVal maxVal:(float)maxVal
+                  completion:(void (^)(MaplyRenderTargetHistogram *))completion
+{
+    if (!completion)
+        return;
+
+    const auto __strong rc = _renderControl;
+    const auto sceneRenderer = rc ? dynamic_cast<SceneRendererMTL*>(rc->sceneRenderer.get()) : nullptr;
+    if (!sceneRenderer) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(nil);
+        });
+        return;
+    }
+
+    sceneRenderer->addHistogramReadback(_renderTargetID, numBins, minVal, maxVal, [completion](RenderTargetHistogramRef hist) {
+        MaplyRenderTargetHistogram *histogram = hist ? [[MaplyRenderTargetHistogram alloc] initWithHistogram:hist] : nil;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(histogram);
+        });
+    });
+}
+
+- (void)addReadbackX:(int)x y:(int)y width:(int)width height:(int)height minMax:(bool)minMax completion:(void (^)(NSData *))completion
+{
+    if (!completion)
+        return;
+
+    const auto __strong rc = _renderControl;
+    const auto sceneRenderer = rc ? dynamic_cast<SceneRendererMTL*>(rc->sceneRenderer.get()) : nullptr;
+    if (!sceneRenderer) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(nil);
+        });
+        return;
+    }
+
+    if (minMax) {
+        sceneRenderer->addMinMaxReadback(_renderTargetID, MakeReadbackCallback(completion));
+    } else {
+        sceneRenderer->addReadback(_renderTargetID, x, y, width, height, MakeReadbackCallback(completion));
+    }
+}
+
 @end
@@ -23,6 +23,16 @@
 #import <vector>
 #import "MaplyBaseViewController_private.h"
 
+// Variable targets hand their textures back to the render controller for the next one
+static MaplyRenderController *RenderControlFor(NSObject<MaplyRenderControllerProtocol> *vc)
+{
+    if ([vc isKindOfClass:[MaplyBaseViewController class]])
+        return ((MaplyBaseViewController *)vc)->renderControl;
+    if ([vc isKindOfClass:[MaplyRenderController class]])
+        return (MaplyRenderController *)vc;
+    return nil;
+}
+
 @implementation MaplyVariableTarget
 {
     bool valid;
@@ -47,6 +57,7 @@
     _clearEveryFrame = true;
     _clearVal = 0.0;
     _zBuffer = false;
+    _renderWhenChanged = true;
 
     dispatch_async(dispatch_get_main_queue(), ^{
         [self delayedSetup];
@@ -121,11 +132,14 @@
     screenSize.height *= scale;
     _texSize = screenSize;
 
-    // Set up the render target
-    _renderTex = [vc createTexture:@{kMaplyTexFormat: @(_type)} sizeX:screenSize.width sizeY:screenSize.height mode:MaplyThreadCurrent];
+    // Set up the render target, reusing a texture an old target was done with if there's one
+    _renderTex = [RenderControlFor(vc) takePooledTargetTexture:_type sizeX:screenSize.width sizeY:screenSize.height];
+    if (!_renderTex)
+        _renderTex = [vc createTexture:@{kMaplyTexFormat: @(_type)} sizeX:screenSize.width sizeY:screenSize.height mode:MaplyThreadCurrent];
     _renderTarget.texture = _renderTex;
     _renderTarget.clearEveryFrame = _clearEveryFrame;
     _renderTarget.clearVal = _clearVal;
+    _renderTarget.renderWhenChanged = _renderWhenChanged;
     [vc addRenderTarget:_renderTarget];
     
     if (_buildRectangle) {
@@ -174,7 +188,8 @@
 #endif
     }
     if (_renderTex) {
-        [vc removeTextures:@[_renderTex] mode:MaplyThreadCurrent];
+        if (![RenderControlFor(vc) poolTargetTexture:_renderTex type:_type])
+            [vc removeTextures:@[_renderTex] mode:MaplyThreadCurrent];
         _renderTex = nil;
     }
 }
@@ -21,6 +21,7 @@
 #import "vector_styles/SLDStyleSet.h"
 #import "MaplyVectorObject_private.h"
 #import "VectorData.h"
+#import "GeoJSONStreamReader.h"
 #import "Dictionary_NSDictionary.h"
 #import "MapboxVectorTiles_private.h"
 
@@ -93,23 +94,17 @@ using namespace WhirlyKit;
         self->_styleSet = [[SLDStyleSet alloc] initWithViewC:baseVC useLayerNames:NO relativeDrawPriority:self->_relativeDrawPriority];
         [self->_styleSet loadSldURL:self->_sldURL];
 
-        ShapeSet shapes;
-        NSData *geoJSONData = [NSData dataWithContentsOfURL:self->_geoJSONURL];
-        NSString *nsStr = [[NSString alloc] initWithData:geoJSONData encoding:NSUTF8StringEncoding];
-        if (!nsStr)
-            return;
-        std::string geoJSONStr = [nsStr UTF8String];
-
-        std::string crs;
-        bool parsed = VectorParseGeoJSON(shapes, geoJSONStr, crs);
-        
-        if (!parsed  || shapes.empty()) {
+        // Map the file and style the features as we read them, rather than
+        //  building the whole document in memory first
+        NSData *geoJSONData = [NSData dataWithContentsOfURL:self->_geoJSONURL options:NSDataReadingMappedIfSafe error:nil];
+        if (!geoJSONData) {
             dispatch_async(dispatch_get_main_queue(), ^{
                 completionBlock();
-                return;
             });
+            return;
         }
-        
+        GeoJSONStreamReader reader((const char *)geoJSONData.bytes, geoJSONData.length);
+
         NSMutableDictionary *featureStyles = [NSMutableDictionary new];
         MaplyBoundingBoxD geoBBox;
         MaplyBoundingBoxD bbox {{0,0},{0,0}};
@@ -118,47 +113,53 @@ using namespace WhirlyKit;
         MaplyTileID tileID = {0,0,0};
         MaplyVectorTileData *tileInfo = [[MaplyVectorTileData alloc] initWithID:tileID bbox:bbox geoBBox:geoBBox];
 
-        for (ShapeSet::iterator it = shapes.begin(); it != shapes.end(); ++it) {
+        ShapeSet shapes;
+        MutableDictionaryRef featureAttrs;
+        while (reader.next(shapes, featureAttrs)) {
+            for (ShapeSet::iterator it = shapes.begin(); it != shapes.end(); ++it) {
             
-            NSMutableDictionary *attributes = ((iosMutableDictionary *)(*it)->getAttrDict().get())->dict;
+                NSMutableDictionary *attributes = ((iosMutableDictionary *)(*it)->getAttrDict().get())->dict;
 
-            NSMutableArray *vectorObjs = [NSMutableArray array];
+                NSMutableArray *vectorObjs = [NSMutableArray array];
             
-            VectorPointsRef points = std::dynamic_pointer_cast<VectorPoints>(*it);
-            VectorLinearRef lin = std::dynamic_pointer_cast<VectorLinear>(*it);
-            VectorArealRef ar = std::dynamic_pointer_cast<VectorAreal>(*it);
+                VectorPointsRef points = std::dynamic_pointer_cast<VectorPoints>(*it);
+                VectorLinearRef lin = std::dynamic_pointer_cast<VectorLinear>(*it);
+                VectorArealRef ar = std::dynamic_pointer_cast<VectorAreal>(*it);
             
-            if (points) {
-                attributes[@"geometry_type"] = @"POINT";
-                [self processPoints:points andVectorObjs:vectorObjs];
-            } else if (lin) {
-                attributes[@"geometry_type"] = @"LINESTRING";
-                [self processLinear:lin andVectorObjs:vectorObjs];
-            } else if (ar) {
-                attributes[@"geometry_type"] = @"POLYGON";
-                [self processAreal:ar andVectorObjs:vectorObjs];
-            }
+                if (points) {
+                    attributes[@"geometry_type"] = @"POINT";
+                    [self processPoints:points andVectorObjs:vectorObjs];
+                } else if (lin) {
+                    attributes[@"geometry_type"] = @"LINESTRING";
+                    [self processLinear:lin andVectorObjs:vectorObjs];
+                } else if (ar) {
+                    attributes[@"geometry_type"] = @"POLYGON";
+                    [self processAreal:ar andVectorObjs:vectorObjs];
+                }
             
-            NSArray *styles = [self->_styleSet stylesForFeatureWithAttributes:attributes onTile:tileInfo.tileID inLayer:@"" viewC:baseVC];
+                NSArray *styles = [self->_styleSet stylesForFeatureWithAttributes:attributes onTile:tileInfo.tileID inLayer:@"" viewC:baseVC];
             
-            if (!styles || styles.count == 0)
-                continue;
+                if (!styles || styles.count == 0)
+                    continue;
             
-            SimpleIDSet styleIDs;
-            for(NSObject<MaplyVectorStyle> *style in styles) {
-                NSMutableArray *featuresForStyle = featureStyles[@(style.uuid)];
-                if(!featuresForStyle) {
-                    featuresForStyle = [NSMutableArray new];
-                    featureStyles[@(style.uuid)] = featuresForStyle;
+                SimpleIDSet styleIDs;
+                for(NSObject<MaplyVectorStyle> *style in styles) {
+                    NSMutableArray *featuresForStyle = featureStyles[@(style.uuid)];
+                    if(!featuresForStyle) {
+                        featuresForStyle = [NSMutableArray new];
+                        featureStyles[@(style.uuid)] = featuresForStyle;
+                    }
+                    [featuresForStyle addObjectsFromArray:vectorObjs];
+                }
+                iosMutableDictionaryRef attrDict(new iosMutableDictionary(attributes));
+                for (MaplyVectorObject *vecObj in vectorObjs) {
+                    vecObj->vObj->setAttributes(attrDict);
                 }
-                [featuresForStyle addObjectsFromArray:vectorObjs];
-            }
-            iosMutableDictionaryRef attrDict(new iosMutableDictionary(attributes));
-            for (MaplyVectorObject *vecObj in vectorObjs) {
-                vecObj->vObj->setAttributes(attrDict);
             }
         }
-        
+        if (!reader.getError().empty())
+            NSLog(@"GeoJSONSource: Stopped reading %@: %s", self->_geoJSONURL, reader.getError().c_str());
+
         NSArray *symbolizerKeys = [featureStyles.allKeys sortedArrayUsingDescriptors:@[[NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES]]];
         dispatch_async(dispatch_get_main_queue(), ^{
             
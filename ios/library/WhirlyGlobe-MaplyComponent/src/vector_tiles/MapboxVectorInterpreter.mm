@@ -64,6 +64,7 @@ static int BackImageWidth = 16, BackImageHeight = 16;
     MaplyRenderController *offlineRender;
 
     MapboxVectorTileParserRef imageTileParser,vecTileParser;
+    bool nativeVecStyle;
 }
 
 - (instancetype) initWithImageStyle:(NSObject<MaplyVectorStyleDelegate> *)inImageStyle
@@ -89,6 +90,7 @@ static int BackImageWidth = 16, BackImageHeight = 16;
     NSObject<MaplyVectorStyleDelegateSecret> *testVecStyle = (NSObject<MaplyVectorStyleDelegateSecret> *)inVectorStyle;
     if ([testVecStyle respondsToSelector:@selector(getVectorStyleImpl)]) {
         vecStyle = [testVecStyle getVectorStyleImpl];
+        nativeVecStyle = true;
     } else
         vecStyle = std::make_shared<VectorStyleDelegateWrapper>(inViewC,inVectorStyle);
 
@@ -109,6 +111,7 @@ static int BackImageWidth = 16, BackImageHeight = 16;
     NSObject<MaplyVectorStyleDelegateSecret> *testVecStyle = (NSObject<MaplyVectorStyleDelegateSecret> *)inVectorStyle;
     if ([testVecStyle respondsToSelector:@selector(getVectorStyleImpl)]) {
         vecStyle = [testVecStyle getVectorStyleImpl];
+        nativeVecStyle = true;
     } else
         vecStyle = std::make_shared<VectorStyleDelegateWrapper>(inViewC,inVectorStyle);
 
@@ -117,6 +120,38 @@ static int BackImageWidth = 16, BackImageHeight = 16;
     return self;
 }
 
+- (void)setBuildThreads:(int)numThreads
+{
+    // The wrapped Objective-C styles may not be safe to run together
+    if (vecTileParser && nativeVecStyle)
+    {
+        vecTileParser->setBuildThreads(numThreads);
+    }
+}
+
+- (void)setTileCacheSize:(size_t)maxBytes
+{
+    if (vecTileParser)
+    {
+        vecTileParser->setTileCacheSize(maxBytes);
+
+        // Give it up under memory pressure
+        MaplyRenderController *rc = [viewC getRenderControl];
+        if (rc && rc->scene)
+        {
+            rc->scene->getMemoryGovernor().addConsumer(vecTileParser->getTileCache());
+        }
+    }
+}
+
+- (void)setSourceMaxZoom:(int)level
+{
+    if (vecTileParser)
+    {
+        vecTileParser->setSourceMaxZoom(level);
+    }
+}
+
 - (void)setUUIDName:(NSString *)inUuidName uuidValues:(NSArray<NSString *> *)uuids
 {
     if (imageTileParser || vecTileParser)
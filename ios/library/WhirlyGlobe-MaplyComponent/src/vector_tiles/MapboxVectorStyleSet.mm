@@ -67,6 +67,7 @@ using namespace WhirlyKit;
     // Copy from NSDictionary to our internal version
     if (auto dictWrap = [styleDict toDictionaryC])
     {
+        StartupPhase parsePhase([viewC getRenderControl]->sceneRenderer->getStartupTimeline(),"style parse");
         if (!style->parse(nullptr, dictWrap))
         {
             return nil;
@@ -181,11 +182,41 @@ using namespace WhirlyKit;
 {
     std::string layerName = [inLayerName cStringUsingEncoding:NSUTF8StringEncoding];
     
-    for (auto layer : style->layers) {
-        if (layer->ident == layerName) {
-            layer->visible = visible;
-        }
-    }
+    style->setLayerVisible(layerName, visible);
+}
+
+- (bool)updateLayerPaint:(NSString *__nonnull)inLayerName paint:(NSDictionary *__nonnull)paint
+{
+    std::string layerName = [inLayerName cStringUsingEncoding:NSUTF8StringEncoding];
+
+    return style->updateLayerPaint(nullptr, layerName, [paint toDictionaryC]);
+}
+
+- (void)warmUpGlyphsForZoom:(int)zoom progress:(void (^ __nullable)(int done,int total))progress
+{
+    MapboxVectorStyleSetImpl::WarmUpProgressFunc progressFunc;
+    if (progress)
+        progressFunc = [progress](int done, int total) { progress(done, total); };
+
+    style->warmUpGlyphs(nullptr, zoom, MapboxVectorStyleSetImpl::defaultWarmUpChars(), progressFunc);
+}
+
+- (void)warmUpGlyphsForZoom:(int)zoom chars:(NSString *)chars progress:(void (^ __nullable)(int done,int total))progress
+{
+    MapboxVectorStyleSetImpl::WarmUpProgressFunc progressFunc;
+    if (progress)
+        progressFunc = [progress](int done, int total) { progress(done, total); };
+
+    const char *utf8 = [chars UTF8String];
+    style->warmUpGlyphs(nullptr, zoom, utf8 ? utf8 : "", progressFunc);
+}
+
+- (void)releaseWarmUp
+{
+    ChangeSet changes;
+    style->releaseWarmUp(nullptr, changes);
+    if (!changes.empty() && style->scene)
+        style->scene->addChangeRequests(changes);
 }
 
 - (UIColor * __nullable) colorForLayer:(NSString *__nonnull)inLayerName
@@ -701,6 +701,18 @@ void MapboxVectorStyleSetImpl_iOS::addSprites(MapboxVectorStyleSpritesRef newSpr
     MapboxVectorStyleSetImpl::addSprites(std::move(newSprites));
 }
 
+NSDictionary *NSDictionaryForAttrs(const Dictionary &attrs)
+{
+    if (const auto dictRef = dynamic_cast<const iosDictionary*>(&attrs)) {
+        return const_cast<NSDictionary*>(dictRef->dict);
+    } else if (const auto dictRef = dynamic_cast<const iosMutableDictionary*>(&attrs)) {
+        return dictRef->dict;
+    } else if (const auto dictRef = dynamic_cast<const MutableDictionaryC*>(&attrs)) {
+        return [NSMutableDictionary fromDictionaryCPointer:dictRef];
+    }
+    return nil;
+}
+
 VectorStyleDelegateWrapper::VectorStyleDelegateWrapper(NSObject<MaplyRenderControllerProtocol> *viewC,NSObject<MaplyVectorStyleDelegate> *delegate)
 : viewC(viewC), delegate(delegate)
 {
@@ -712,24 +724,27 @@ VectorStyleDelegateWrapper::stylesForFeature(PlatformThreadInfo *inst,
                                              const QuadTreeIdentifier &tileID,
                                              const std::string &layerName)
 {
-    const NSDictionary *dict = nil;
-    if (const auto dictRef = dynamic_cast<const iosDictionary*>(&attrs)) {
-        dict = dictRef->dict;
-    } else if (const auto dictRef = dynamic_cast<const iosMutableDictionary*>(&attrs)) {
-        dict = dictRef->dict;
-    } else if (const auto dictRef = dynamic_cast<const MutableDictionaryC*>(&attrs)) {
-        dict = [NSMutableDictionary fromDictionaryCPointer:dictRef];
-    } else if (dict) {
-        wkLogLevel(Warn, "unsupported dictionary implementation");
-        return std::vector<VectorStyleImplRef>();
-    }
-    
     const MaplyTileID theTileID = { tileID.x, tileID.y, tileID.level };
     NSString *layerStr = [NSString stringWithFormat:@"%s",layerName.c_str()];
-    NSArray *styles = [delegate stylesForFeatureWithAttributes:const_cast<NSDictionary*>(dict)
-                                                        onTile:theTileID
-                                                       inLayer:layerStr
-                                                         viewC:viewC];
+
+    NSArray *styles = nil;
+    if ([delegate conformsToProtocol:@protocol(MaplyVectorStyleDelegateDictionary)]) {
+        // These can look at the attributes as they are
+        styles = [(NSObject<MaplyVectorStyleDelegateDictionary> *)delegate stylesForFeatureWithDictionary:attrs
+                                                                                                    onTile:theTileID
+                                                                                                   inLayer:layerStr
+                                                                                                     viewC:viewC];
+    } else {
+        NSDictionary *dict = NSDictionaryForAttrs(attrs);
+        if (!dict) {
+            wkLogLevel(Warn, "unsupported dictionary implementation");
+            return std::vector<VectorStyleImplRef>();
+        }
+        styles = [delegate stylesForFeatureWithAttributes:dict
+                                                   onTile:theTileID
+                                                  inLayer:layerStr
+                                                    viewC:viewC];
+    }
     
     std::vector<VectorStyleImplRef> retStyles;
     retStyles.reserve([styles count]);
@@ -21,6 +21,9 @@
 
 #import "vector_styles/MapnikStyleRule.h"
 #import "vector_styles/MaplyVectorStyle.h"
+#import "MapnikStyleRule_private.h"
+
+using namespace WhirlyKit;
 
 @interface MapnikStyleRule ()
 @property (nonatomic, strong, readwrite) NSMutableArray *symbolizers;
@@ -38,6 +41,13 @@
 
 
 - (void)setFilter:(NSString*)filterExpression {
+  // Most filters are simple comparisons we can run without NSPredicate
+  auto newFilter = std::make_shared<StyleRuleFilter>();
+  if (StyleRuleFilter::ParseMapnik([filterExpression UTF8String] ?: "",*newFilter))
+    ruleFilter = newFilter;
+  else
+    ruleFilter.reset();
+
   NSMutableString *mutableFilterExpression = [NSMutableString stringWithString:filterExpression];
   [mutableFilterExpression replaceOccurrencesOfString:@"["
                                            withString:@""
@@ -65,6 +75,19 @@
 }
 
 
+- (bool)testAttrs:(const Dictionary &)attrs nsAttrs:(NSDictionary * (^)(void))nsAttrs {
+  if (ruleFilter)
+    return ruleFilter->test(attrs);
+  @try {
+    return [self.filterPredicate evaluateWithObject:nsAttrs()];
+  }
+  @catch (NSException *exception) {
+    NSLog(@"Error evaluating rule:%@", self.filterPredicate);
+  }
+  return false;
+}
+
+
 - (void)setMaxScaleDenomitator:(NSUInteger)maxScaleDenomitator {
   _maxScaleDenomitator = maxScaleDenomitator;
   self.minZoom = [MapnikStyleRule scaleToZoom:maxScaleDenomitator];
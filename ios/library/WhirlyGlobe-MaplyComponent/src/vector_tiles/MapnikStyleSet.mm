@@ -25,8 +25,12 @@
 #import "loading/MaplyTileSourceNew.h"
 #import "vector_styles/MapnikStyle.h"
 #import "vector_styles/MapnikStyleRule.h"
+#import "MapnikStyleRule_private.h"
+#import "MaplyVectorStyle_private.h"
 
-@interface MapnikStyleSet() {
+using namespace WhirlyKit;
+
+@interface MapnikStyleSet() <MaplyVectorStyleDelegateDictionary> {
   //temporary storage during parsing
   NSString *currentString;
   NSMutableDictionary *currentStyle;
@@ -279,28 +283,41 @@ static NSString *FILTERMODE_ATTRIBUTE = @"filter-mode";
                                     onTile:(MaplyTileID)tileID
                                    inLayer:(NSString*)layer
                                      viewC:(NSObject<MaplyRenderControllerProtocol> *)viewC
+{
+  const iosDictionary attrs(attributes);
+  return [self stylesForFeatureWithDictionary:attrs onTile:tileID inLayer:layer viewC:viewC];
+}
+
+- (NSArray*)stylesForFeatureWithDictionary:(const Dictionary &)attrs
+                                    onTile:(MaplyTileID)tileID
+                                   inLayer:(NSString*)layer
+                                     viewC:(NSObject<MaplyRenderControllerProtocol> *)viewC
 {
   NSMutableArray *symbolizers = [NSMutableArray new];
   NSArray *styles = self.layers[layer];
 
+  // Only rules we couldn't compile need the NSDictionary
+  const Dictionary *attrsPtr = &attrs;
+  __block NSDictionary *nsAttrs = nil;
+  NSDictionary * (^getNSAttrs)(void) = ^{
+    if (!nsAttrs)
+      nsAttrs = NSDictionaryForAttrs(*attrsPtr);
+    return nsAttrs;
+  };
+
   for(MapnikStyle *style in styles) {
     for(MapnikStyleRule *rule in style.rules) {
       if(tileID.level <= rule.maxZoom && (tileID.level >= rule.minZoom ||
                                           (tileID.level == _tileMaxZoom && rule.minZoom >= _tileMaxZoom))) {
         //some rules dont take effect until after max zoom, so we need to apply them at maxZoom
-        @try {
-          if([rule.filterPredicate evaluateWithObject:attributes]) {
-            [symbolizers addObjectsFromArray:rule.symbolizers];
-            if(style.filterModeFirst) {
-              //filter mode first means we stop applying rules after the first match
-              //https://github.com/mapnik/mapnik/issues/706
-              break;
-            }
+        if([rule testAttrs:attrs nsAttrs:getNSAttrs]) {
+          [symbolizers addObjectsFromArray:rule.symbolizers];
+          if(style.filterModeFirst) {
+            //filter mode first means we stop applying rules after the first match
+            //https://github.com/mapnik/mapnik/issues/706
+            break;
           }
         }
-        @catch (NSException *exception) {
-          NSLog(@"Error evaluating rule:%@", rule.filterPredicate);
-        }
       }
     }
   }
@@ -7,13 +7,20 @@
 //
 
 #import "vector_styles/SLDExpressions.h"
+#import "SLDOperators_private.h"
 #import "DDXML.h"
 
+using namespace WhirlyKit;
+
 @implementation SLDExpression
 + (BOOL)matchesElementNamed:(NSString * _Nonnull)elementName {
     return NO;
 }
 
+- (int)addToRuleFilter:(StyleRuleFilter &)filter {
+    return -1;
+}
+
 + (SLDExpression *)expressionForNode:(DDXMLNode *)node {
     
     NSString *name = [node localName];
@@ -54,6 +61,11 @@
     return [elementName isEqualToString:@"Literal"];
 }
 
+- (int)addToRuleFilter:(StyleRuleFilter &)filter {
+    NSString *str = [self.literal isKindOfClass:[NSString class]] ? (NSString *)self.literal : [self.literal stringValue];
+    return str ? filter.addLiteral([str UTF8String]) : -1;
+}
+
 @end
 
 @implementation SLDPropertyNameExpression
@@ -72,6 +84,10 @@
     return [elementName isEqualToString:@"PropertyName"];
 }
 
+- (int)addToRuleFilter:(StyleRuleFilter &)filter {
+    return filter.addAttr([self.propertyName UTF8String]);
+}
+
 @end
 
 
@@ -124,5 +140,20 @@
     return [set containsObject:elementName];
 }
 
+- (int)addToRuleFilter:(StyleRuleFilter &)filter {
+    StyleExprType type;
+    if ([self.elementName isEqualToString:@"Add"])
+        type = StyleExprAdd;
+    else if ([self.elementName isEqualToString:@"Sub"])
+        type = StyleExprSub;
+    else if ([self.elementName isEqualToString:@"Mul"])
+        type = StyleExprMul;
+    else if ([self.elementName isEqualToString:@"Div"])
+        type = StyleExprDiv;
+    else
+        return -1;
+    return filter.addArith(type,[self.leftExpression addToRuleFilter:filter],[self.rightExpression addToRuleFilter:filter]);
+}
+
 @end
 
@@ -7,13 +7,20 @@
 //
 
 #import "vector_styles/SLDOperators.h"
+#import "SLDOperators_private.h"
 #import "DDXML.h"
 
+using namespace WhirlyKit;
+
 @implementation SLDOperator
 + (BOOL)matchesElementNamed:(NSString * _Nonnull)elementName {
     return NO;
 }
 
+- (int)addToRuleFilter:(StyleRuleFilter &)filter {
+    return -1;
+}
+
 + (SLDOperator *)operatorForNode:(DDXMLNode *)node {
     NSString *name = [node localName];
     if ([SLDLogicalOperator matchesElementNamed:name])
@@ -90,6 +97,25 @@
     return [set containsObject:elementName];
 }
 
+- (int)addToRuleFilter:(StyleRuleFilter &)filter {
+    StyleRuleOp op;
+    if ([self.elementName isEqualToString:@"PropertyIsEqualTo"])
+        op = StyleRuleEqual;
+    else if ([self.elementName isEqualToString:@"PropertyIsNotEqualTo"])
+        op = StyleRuleNotEqual;
+    else if ([self.elementName isEqualToString:@"PropertyIsLessThan"])
+        op = StyleRuleLess;
+    else if ([self.elementName isEqualToString:@"PropertyIsGreaterThan"])
+        op = StyleRuleGreater;
+    else if ([self.elementName isEqualToString:@"PropertyIsLessThanOrEqualTo"])
+        op = StyleRuleLessEqual;
+    else if ([self.elementName isEqualToString:@"PropertyIsGreaterThanOrEqualTo"])
+        op = StyleRuleGreaterEqual;
+    else
+        return -1;
+    return filter.addCompare(op,[self.leftExpression addToRuleFilter:filter],[self.rightExpression addToRuleFilter:filter],self.matchCase);
+}
+
 @end
 
 
@@ -119,6 +145,15 @@
     return [elementName isEqualToString:@"PropertyIsNull"];
 }
 
+- (int)addToRuleFilter:(StyleRuleFilter &)filter {
+    return filter.addIsNull([self.subExpression addToRuleFilter:filter]);
+}
+
+@end
+
+@interface SLDIsLikeOperator()
+// The pattern as the document wrote it, before we converted it for NSPredicate
+@property (nonatomic, strong) NSString *pattern;
 @end
 
 @implementation SLDIsLikeOperator
@@ -134,8 +169,10 @@
                 [expressions addObject:expression];
             if ([expression isKindOfClass:[SLDPropertyNameExpression class]])
                 self.propertyExpression = (SLDPropertyNameExpression *)expression;
-            else if ([expression isKindOfClass:[SLDLiteralExpression class]])
+            else if ([expression isKindOfClass:[SLDLiteralExpression class]]) {
                 self.literalExpression = (SLDLiteralExpression *)expression;
+                self.pattern = [child stringValue];
+            }
         }
         if (expressions.count != 2)
             return nil;
@@ -244,6 +281,16 @@
     return [elementName isEqualToString:@"PropertyIsLike"];
 }
 
+- (int)addToRuleFilter:(StyleRuleFilter &)filter {
+    const unichar wildCard = [self.wildCardStr characterAtIndex:0];
+    const unichar singleChar = [self.singleCharStr characterAtIndex:0];
+    const unichar escapeChar = [self.escapeCharStr characterAtIndex:0];
+    if (!self.pattern || wildCard > 127 || singleChar > 127 || escapeChar > 127)
+        return -1;
+    return filter.addLike([self.propertyExpression addToRuleFilter:filter],[self.pattern UTF8String],
+                          (char)wildCard,(char)singleChar,(char)escapeChar,self.matchCase);
+}
+
 @end
 
 
@@ -303,6 +350,12 @@
     return [elementName isEqualToString:@"PropertyIsBetween"];
 }
 
+- (int)addToRuleFilter:(StyleRuleFilter &)filter {
+    return filter.addBetween([self.subExpression addToRuleFilter:filter],
+                             [self.lowerBoundaryExpression addToRuleFilter:filter],
+                             [self.upperBoundaryExpression addToRuleFilter:filter]);
+}
+
 @end
 
 
@@ -336,6 +389,10 @@
     return [elementName isEqualToString:@"Not"];
 }
 
+- (int)addToRuleFilter:(StyleRuleFilter &)filter {
+    return filter.addLogical(StyleRuleNot,{[self.subOperator addToRuleFilter:filter]});
+}
+
 @end
 
 
@@ -375,5 +432,13 @@
     return ([elementName isEqualToString:@"And"] || [elementName isEqualToString:@"Or"]);
 }
 
+- (int)addToRuleFilter:(StyleRuleFilter &)filter {
+    std::vector<int> subTests;
+    subTests.reserve(self.subOperators.count);
+    for (SLDOperator *subOperator in self.subOperators)
+        subTests.push_back([subOperator addToRuleFilter:filter]);
+    return filter.addLogical([self.elementName isEqualToString:@"And"] ? StyleRuleAll : StyleRuleAny,subTests);
+}
+
 @end
 
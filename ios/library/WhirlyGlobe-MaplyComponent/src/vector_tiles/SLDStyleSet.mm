@@ -9,10 +9,14 @@
 #import <WhirlyGlobe/SLDStyleSet.h>
 #import "vector_styles/SLDExpressions.h"
 #import "vector_styles/SLDOperators.h"
+#import "SLDOperators_private.h"
+#import "MaplyVectorStyle_private.h"
 #import "vector_styles/SLDSymbolizers.h"
 #import "vector_styles/MaplyVectorTileStyle.h"
 #import "DDXML.h"
 
+using namespace WhirlyKit;
+
 
 @implementation SLDNamedLayer
 @end
@@ -28,10 +32,26 @@
 
 @implementation SLDFilter
 
+- (void)compileRuleFilter {
+    ruleFilter.reset();
+    if (!self.sldOperator)
+        return;
+    auto newFilter = std::make_shared<StyleRuleFilter>();
+    if (newFilter->compile([self.sldOperator addToRuleFilter:*newFilter]))
+        ruleFilter = newFilter;
+}
+
+- (bool)testAttrs:(const Dictionary &)attrs nsAttrs:(NSDictionary * (^)(void))nsAttrs {
+    if (ruleFilter)
+        return ruleFilter->test(attrs);
+    NSDictionary *dict = nsAttrs();
+    return dict && [self.sldOperator.predicate evaluateWithObject:dict];
+}
+
 @end
 
 
-@interface SLDStyleSet () {
+@interface SLDStyleSet () <MaplyVectorStyleDelegateDictionary> {
 }
 
 @property (nonatomic, strong) NSMutableArray *symbolizers;
@@ -366,6 +386,7 @@
         else
             NSLog(@"SLDFilter; Unmatched operator: %@", [child localName]);
     }
+    [filter compileRuleFilter];
 
     return filter;
 }
@@ -379,19 +400,34 @@
                                               onTile:(MaplyTileID)tileID
                                              inLayer:(NSString *__nonnull)layer
                                                viewC:(NSObject<MaplyRenderControllerProtocol> *__nonnull)viewC {
-    
-    
+    const iosDictionary attrs(attributes);
+    return [self stylesForFeatureWithDictionary:attrs onTile:tileID inLayer:layer viewC:viewC];
+}
+
+- (nullable NSArray *)stylesForFeatureWithDictionary:(const Dictionary &)attrs
+                                              onTile:(MaplyTileID)tileID
+                                             inLayer:(NSString *__nonnull)layer
+                                               viewC:(NSObject<MaplyRenderControllerProtocol> *__nonnull)viewC {
+    // Only filters we couldn't compile need the NSDictionary, so make it when asked
+    const Dictionary *attrsPtr = &attrs;
+    __block NSDictionary *nsAttrs = nil;
+    NSDictionary * (^getNSAttrs)(void) = ^{
+        if (!nsAttrs)
+            nsAttrs = NSDictionaryForAttrs(*attrsPtr);
+        return nsAttrs;
+    };
+
     if (self.useLayerNames) {
         SLDNamedLayer *namedLayer = _namedLayers[layer];
         if (!namedLayer)
             return nil;
-        return [self stylesForFeatureWithAttributes:attributes onTile:tileID inNamedLayer:namedLayer viewC:viewC];
+        return [self stylesForFeatureWithAttributes:attrs nsAttrs:getNSAttrs onTile:tileID inNamedLayer:namedLayer viewC:viewC];
         
     } else {
         // If we're not using layer names for matching, check all layers for
         // matching styles.
         for (SLDNamedLayer *namedLayer in [_namedLayers allValues]) {
-            NSArray *styles = [self stylesForFeatureWithAttributes:attributes onTile:tileID inNamedLayer:namedLayer viewC:viewC];
+            NSArray *styles = [self stylesForFeatureWithAttributes:attrs nsAttrs:getNSAttrs onTile:tileID inNamedLayer:namedLayer viewC:viewC];
             if (styles && styles.count > 0)
                 return styles;
         }
@@ -400,7 +436,8 @@
     return nil;
 }
 
-- (nullable NSArray *)stylesForFeatureWithAttributes:(NSDictionary *__nonnull)attributes
+- (nullable NSArray *)stylesForFeatureWithAttributes:(const Dictionary &)attrs
+                                             nsAttrs:(NSDictionary * (^)(void))nsAttrs
                                               onTile:(MaplyTileID)tileID
                                         inNamedLayer:(SLDNamedLayer *__nonnull)namedLayer
                                                viewC:(NSObject<MaplyRenderControllerProtocol> *__nonnull)viewC {
@@ -414,14 +451,14 @@
                 if (rule.filters.count == 0 && rule.elseFilters.count == 0)
                     matched = true;
                 for (SLDFilter *filter in rule.filters) {
-                    if ([filter.sldOperator.predicate evaluateWithObject:attributes]) {
+                    if ([filter testAttrs:attrs nsAttrs:nsAttrs]) {
                         matched = true;
                         break;
                     }
                 }
                 if (!matched) {
                     for (SLDFilter *filter in rule.elseFilters) {
-                        if ([filter.sldOperator.predicate evaluateWithObject:attributes]) {
+                        if ([filter testAttrs:attrs nsAttrs:nsAttrs]) {
                             matched = true;
                             break;
                         }
@@ -24,6 +24,7 @@
 #import "MaplyShape_private.h"
 #import "MaplyComponentObject_private.h"
 #import "FontTextureManager_iOS.h"
+#import "GeometryModelBinary.h"
 
 using namespace WhirlyKit;
 using namespace Eigen;
@@ -36,24 +37,26 @@ using namespace Eigen;
 }
 
 - (instancetype)initWithObj:(NSString *)fullPath
+{
+    return [self initWithObj:fullPath cacheDir:nil];
+}
+
+- (instancetype)initWithObj:(NSString *)fullPath cacheDir:(NSString *)cacheDir
 {
     self = [super init];
     
-    const char *str = [fullPath cStringUsingEncoding:NSASCIIStringEncoding];
-    FILE *fp = fopen(str, "r");
-    if (!fp)
-        return nil;
+    std::string cachePath;
+    if (cacheDir)
+    {
+        [[NSFileManager defaultManager] createDirectoryAtPath:cacheDir withIntermediateDirectories:YES attributes:nil error:nil];
+        cachePath = [[cacheDir stringByAppendingPathComponent:[[fullPath lastPathComponent] stringByAppendingPathExtension:@"wkgeom"]] UTF8String];
+    }
     
-    // Parse it out of the file
-    GeometryModelOBJ objModel;
+    // Parse it out of the file, or read the binary version if we've got it
     NSString *bundlePath = [[NSBundle mainBundle] resourcePath];
-    objModel.setResourceDir([bundlePath cStringUsingEncoding:NSASCIIStringEncoding]);
-    
-    if (!objModel.parse(fp))
+    if (!GeometryModelBinary::readOBJ([fullPath UTF8String], [bundlePath UTF8String], cachePath, textures, rawGeom))
         return nil;
     
-    objModel.toRawGeometry(textures,rawGeom);
-    
     return self;
 }
 
@@ -36,24 +36,14 @@ using namespace WhirlyKit;
         return nil;
     }
 
-    // Start with the Julian Date
-    NSCalendar *calendar = [[NSCalendar alloc] initWithCalendarIdentifier:NSCalendarIdentifierGregorian];
-    calendar.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
-    
-    const NSCalendarUnit units = NSCalendarUnitYear |
-                                 NSCalendarUnitMonth |
-                                 NSCalendarUnitDay |
-                                 NSCalendarUnitHour |
-                                 NSCalendarUnitMinute |
-                                 NSCalendarUnitSecond;
-    NSDateComponents *components = [calendar components:units fromDate:date];
-    if (!components)
+    if (!date)
     {
         return nil;
     }
-    
-    moon = std::make_unique<Moon>(components.year,components.month,components.day,
-                                  components.hour,components.minute,components.second);
+
+    // Start with the Julian Date, and share the interpolated values as MaplySun does
+    static MoonCache moonCache;
+    moon = std::make_unique<Moon>(moonCache.getMoon(Sun::JulianDateFromUnixTime(date.timeIntervalSince1970)));
 
     return self;
 }
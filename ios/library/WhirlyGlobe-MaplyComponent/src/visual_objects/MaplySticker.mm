@@ -19,7 +19,28 @@
  */
 
 #import "visual_objects/MaplySticker.h"
+#import "MaplyQuadSampler_private.h"
+
+using namespace WhirlyKit;
 
 @implementation MaplySticker
 
+- (MaplySamplingParams *)samplingParamsForImageWidth:(int)imageWidth height:(int)imageHeight tileSize:(int)tileSize
+{
+    if (_rotation != 0.0)
+        return nil;
+
+    MaplyCoordinateSystem *theCoordSys = _coordSys ? _coordSys : [[MaplyPlateCarree alloc] initFullCoverage];
+    MaplySamplingParams *sampleParams = [[MaplySamplingParams alloc] init];
+    sampleParams.coordSys = theCoordSys;
+
+    MbrD mbr;
+    mbr.addPoint(Point2d(_ll.x,_ll.y));
+    mbr.addPoint(Point2d(_ur.x,_ur.y));
+    if (!sampleParams->params.setupTiledImage([theCoordSys getCoordSystem],mbr,imageWidth,imageHeight,tileSize))
+        return nil;
+
+    return sampleParams;
+}
+
 @end
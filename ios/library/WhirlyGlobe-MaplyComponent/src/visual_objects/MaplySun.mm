@@ -34,24 +34,16 @@ using namespace WhirlyKit;
         return nil;
     }
     
-    // It all starts with the Julian date
-    NSCalendar *calendar = [[NSCalendar alloc] initWithCalendarIdentifier:NSCalendarIdentifierGregorian];
-    calendar.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
-
-    const NSCalendarUnit units = NSCalendarUnitYear |
-                                 NSCalendarUnitMonth |
-                                 NSCalendarUnitDay |
-                                 NSCalendarUnitHour |
-                                 NSCalendarUnitMinute |
-                                 NSCalendarUnitSecond;
-    NSDateComponents *components = [calendar components:units fromDate:date];
-    if (!components)
+    if (!date)
     {
         return nil;
     }
 
-    sun = std::make_unique<Sun>(components.year, components.month, components.day,
-                                components.hour, components.minute, components.second);
+    // It all starts with the Julian date.
+    // Time lapses make a lot of these, so they share the interpolated positions.
+    static SunCache sunCache;
+    sun = std::make_unique<Sun>();
+    sunCache.getSun(Sun::JulianDateFromUnixTime(date.timeIntervalSince1970), *sun);
     
     return self;
 }
@@ -69,7 +69,16 @@ public:
     API_AVAILABLE(ios(13.0))
     virtual void encodeIndirect(id<MTLIndirectRenderCommand> cmdEncode,SceneRendererMTL *sceneRender,Scene *scene,RenderTargetMTL *renderTarget);
 
+    /// GPU style instances draw from an indirect argument buffer, which indirect commands can't do
+    virtual bool canEncodeIndirect() const override { return instanceStyle != GPUStyle; }
+
+    /// Rewrite part of the instance buffer, if we've set one up
+    virtual void setInstances(unsigned int startInst,const std::vector<SingleInstance> &insts) override;
+
 protected:
+    // Convert one instance to what the shader wants, noting color and motion in the uniforms
+    void setupInstance(const SingleInstance &inst,WhirlyKitShader::VertexTriModelInstance &outInst);
+
     // Pipeline render state for the encoder
     id<MTLRenderPipelineState> getRenderPipelineState(SceneRendererMTL *sceneRender,Scene *scene,ProgramMTL *program,RenderTargetMTL *renderTarget,BasicDrawableMTL *basicDrawMTL);
     
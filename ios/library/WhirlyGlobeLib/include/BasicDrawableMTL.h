@@ -40,12 +40,30 @@ public:
     
     /// Tweak the values passed in for the override color
     virtual void setOverrideColor(RGBAColor inColor) override;
+
+    /// The fragment shader works out the blend between the two textures from the time
+    virtual bool setTexAnimation(TimeInterval startTime,double period,int numTextures) override;
+
+    /// Change per-vertex colors, in the buffer if we've already set it up
+    virtual void setVertexColors(unsigned int startVert,unsigned int numVerts,RGBAColor inColor) override;
+
+    /// Move vertices, writing into the buffers if we've already set them up
+    virtual void setVertexMotion(const std::vector<VertexMotion> &motions) override;
+
+    /// Take over another plain Metal drawable's geometry, before either is set up
+    virtual bool merge(BasicDrawable &that) override;
+
+    /// Rewrite the triangle buffer when a merged drawable turns on or off
+    virtual void mergedTrisChanged() override;
     
     /// Set up local rendering structures (e.g. VBOs)
     virtual void setupForRenderer(const RenderSetupInfo *setupInfo,Scene *scene) override;
     
     /// Clean up any rendering objects you may have (e.g. VBOs).
     virtual void teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene,RenderTeardownInfoRef teardown) override;
+
+    /// Triangles we'll draw, once set up
+    virtual unsigned int getNumTris() const override { return numTris; }
     
     /** An all-purpose pre-render that sets up textures, uniforms and such in preparation for rendering
         Also adds to the list of resources being used by this drawable.
@@ -74,6 +92,12 @@ public:
     API_AVAILABLE(ios(13.0))
     virtual void encodeIndirect(id<MTLIndirectRenderCommand> cmdEncode,SceneRendererMTL *sceneRender,Scene *scene,RenderTargetMTL *renderTarget) override;
     
+    /// Height, zoom and, if we can tell, extents for the GPU cull
+    virtual void setupGPUCull(bool gpuCull,WhirlyKitShader::CullInfo &info) override;
+
+    /// Everything but clip coordinates and calculations gets drawn for each copy of the world
+    virtual bool drawsWorldCopies() const override { return !clipCoords && calcDataEntries <= 0; }
+
     /// Find the vertex attribute corresponding to the given name
     VertexAttributeMTL *findVertexAttribute(int nameID);
     
@@ -116,10 +140,18 @@ public:
     std::vector<BufferEntryMTL> calcBuffers;
     
     BufferEntryMTL mainBuffer;        // We're storing all the bits and pieces in here
+    bool hasDispBox;                  // Extents of the vertices, filled in before we hand them over
+    TimeInterval texAnimStart = 0.0;  // Cycling through textures, if the period is set
+    double texAnimPeriod = 0.0;
+    int texAnimTextures = 0;
+    Point3f dispBoxMin,dispBoxMax;
     ArgBuffContentsMTLRef vertABInfo,fragABInfo;
     bool vertHasTextures,fragHasTextures;
     bool vertHasLighting,fragHasLighting;
     ArgBuffRegularTexturesMTLRef vertTexInfo,fragTexInfo;
+    // Our matrix and the view, combined in doubles, as last handed to the shader
+    Eigen::Matrix4f drawMvMat;
+    bool drawMvValid = false;
     
     // Textures currently in use
     std::vector< TextureEntryMTL > activeTextures;
@@ -157,7 +157,8 @@ typedef enum {
     WKSUniformScreenSpaceEntryExp = 210,
     WKSUniformModelInstanceEntry = 300,
     WKSUniformBillboardEntry = 400,
-    WKSUniformParticleStateEntry = 410
+    WKSUniformParticleStateEntry = 410,
+    WKSUniformDataTileEntry = 420
 } WKSArgBufferEntries;
 
 // Uniforms for the basic case.  Nothing fancy.
@@ -180,14 +181,19 @@ struct Uniforms
     float currentTime;         // Current time relative to the start of the renderer
     float height;              // Height above the ground/globe
     float zoomSlots[MaxZoomSlots];  // Zoom levels calculated by the sampling layers
+    simd::float3 mvCopyOffset; // Eye space offset of this copy of the world from the main one, for drawable mvMatrix values
     bool globeMode;
 };
 
 // Things that change per drawable (like fade)
 struct UniformDrawStateA {
     simd::float4x4 singleMat; // Individual transform used by model instances
+    simd::float4x4 mvMatrix;  // singleMat and the view combined in doubles, if hasMvMatrix is set
     simd::float2 screenOrigin; // Used for texture pinning in screen space
     float interp;              // Used to interpolate between two textures (if appropriate)
+    float texAnimStart;        // If the period is set, interp comes from the time instead, cycling through
+    float texAnimPeriod;       //  this many textures over the period
+    int texAnimTextures;
     int outputTexLevel;        // Normally 0, unless we're running a reduce
     int whichOffsetMatrix;     // Normally 0, unless we're in 2D mode drawing the same stuff multiple times
     float fadeUp,fadeDown;     // Fading in/out values
@@ -196,6 +202,19 @@ struct UniformDrawStateA {
     int zoomSlot;              // Used to pass continuous zoom info
     bool clipCoords;           // If set, the geometry coordinates aren't meant to be transformed
     bool hasExp;               // Look for a UniformWideVecExp structure for color, opacity, and width
+    bool hasMvMatrix;          // Position with mvMatrix rather than singleMat and the view
+    simd::float4 elevDecode;   // Terrain: dot with an elevation pixel, plus w, for a height in display units
+};
+
+// How to shade single channel data tiles, set on the program
+struct UniformDataTile {
+    simd::float3 lightDir;     // Toward the light, in tile space with z up
+    float minValue,maxValue;   // Data values at either end of the color ramp
+    float lowThreshold,highThreshold;  // Anything outside these is left clear
+    float noDataValue;         // Pixels with exactly this value are left clear
+    float hillshade;           // How much hillshading to mix in.  0 for none.
+    float zScale;              // Data units per texel, multiplied in for the hillshade slope
+    bool hasNoData;
 };
 
 // Uniform expressions optionally passed to basic polygon shaders
@@ -212,6 +231,37 @@ struct UniformDrawStateParticle {
     float frameLen; // Length of a single frame
 };
 
+//// GPU culling //////
+
+// Buffer entries for the draw group cull kernel
+typedef enum {
+    WKSCullUniformArgBuffer = 0,
+    WKSCullFrameArgBuffer,
+    WKSCullInfoArgBuffer,
+    WKSCullCommandArgBuffer
+} WKSCullArgumentBuffers;
+
+// Checks a CullInfo asks for
+#define WKSCullHeight  1
+#define WKSCullMinZoom 2
+#define WKSCullMaxZoom 4
+#define WKSCullExtents 8
+
+// Visibility for one command in a draw group, checked every frame by the cull kernel
+struct CullInfo {
+    simd::float3 boxMin,boxMax;   // Extents in display space
+    float minVisible,maxVisible;  // Visibility by height, in either order
+    float minZoomVis,maxZoomVis;  // Visibility by zoom slot value
+    int zoomSlot;
+    int flags;                    // Which of the WKSCull checks to do
+};
+
+// Values the cull kernel needs that aren't in the uniforms
+struct CullFrame {
+    float height;                 // Height above the ground/globe
+    int numCommands;
+};
+
 //// Lighting support //////
 
 // A single light
@@ -362,6 +412,13 @@ struct VertexTriA
     float2 texCoord [[attribute(WhirlyKitShader::WKSVertexTextureBaseAttribute)]];
 };
 
+// Triangle vertex carrying just an object ID, for picking
+struct VertexTriID
+{
+    float3 position [[attribute(WhirlyKitShader::WKSVertexPositionAttribute)]];
+    int maskID [[attribute(WhirlyKitShader::WKSVertexMaskAttribute)]];
+};
+
 // Output vertex to the fragment shader
 struct ProjVertexTriA {
     float4 position [[invariant]] [[position]];
@@ -178,6 +178,16 @@ public:
     /// Indirect version of regular encoding.  Called only when things change enough to re-encode.
     API_AVAILABLE(ios(13.0))
     virtual void encodeIndirect(id<MTLIndirectRenderCommand> cmdEncode,SceneRendererMTL *sceneRender,Scene *scene,RenderTargetMTL *renderTarget) = 0;
+
+    /// Set if this can go into an indirect command buffer.  If not, it's encoded directly every frame.
+    virtual bool canEncodeIndirect() const { return true; }
+
+    /// Set if this is drawn again for the other copies of the world on a wrapped map
+    virtual bool drawsWorldCopies() const { return false; }
+
+    /// Turn culling on the GPU on or off and fill in what the cull kernel checks.
+    /// By default there's nothing to check.
+    virtual void setupGPUCull(bool gpuCull,WhirlyKitShader::CullInfo &info) { info.flags = 0; info.zoomSlot = -1; }
 };
 
 }
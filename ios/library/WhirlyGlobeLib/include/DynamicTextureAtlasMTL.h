@@ -40,16 +40,32 @@ public:
     /// Add the data at a given location in the texture
     void addTextureData(int startX,int startY,int width,int height,RawDataRef data);
     
-    /// Clear out the low level data
-    void clearTextureData(int startX,int startY,int width,int height,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData);
-    
     /// Create an appropriately empty texture in OpenGL ES
     virtual bool createInRenderer(const RenderSetupInfo *setupInfo);
     
     /// Render side only.  Don't call this.  Destroy the OpenGL ES version
     virtual void destroyInRenderer(const RenderSetupInfo *setupInfo,Scene *scene);
+
+    /// Copy the region data into a shared buffer
+    virtual StagedDataRef stageTextureData(const RenderSetupInfo *setupInfo,int startX,int startY,int width,int height,const RawDataRef &data) override;
+
+    /// Have the renderer blit the shared buffer into the texture
+    virtual void addStagedData(SceneRenderer *renderer,const StagedDataRef &staged) override;
+
+    /// Any format we can set up, we can blit
+    virtual bool canCopyRegions() const override { return valid; }
+
+    /// Have the renderer blit regions over from another texture
+    virtual void copyRegions(SceneRenderer *renderer,DynamicTexture *src,const std::vector<Region> &regions) override;
     
 protected:
+    // Staging buffer for one region
+    class StagedDataMTL : public StagedData
+    {
+    public:
+        id<MTLBuffer> buffer = nil;
+    };
+
     bool valid;
     MTLPixelFormat pixFormat;
     TextureType type;
@@ -56,12 +56,52 @@ public:
     FontTextureManager_iOS(SceneRenderer *sceneRender,Scene *scene);
     virtual ~FontTextureManager_iOS();
     
-    /// Add the given string.  Caller is responsible for deleting the DrawableString
+    /** Add the given string.  Caller is responsible for deleting the DrawableString.
+        Glyphs we don't have yet are rendered without holding the lock, so any number
+        of threads can be doing that at once.  The lock is only held to look glyphs up
+        and put them in the atlas.
+      */
     std::unique_ptr<DrawableString> addString(PlatformThreadInfo *,NSAttributedString *,ChangeSet &);
 
+    /** Render the glyphs for the characters in a string ahead of time, with its font and colors.
+        They're held like a string's are, until the IDs added to strIDs are passed to removeString.
+        Returns false if there was nothing to render.
+      */
+    bool warmUp(PlatformThreadInfo *,NSAttributedString *str,std::vector<SimpleIdentity> &strIDs,ChangeSet &changes);
+
     virtual void teardown(PlatformThreadInfo*) override;
 
 protected:
+    // A glyph rendered outside the lock, waiting to go in the atlas
+    struct StagedGlyph
+    {
+        NSData *image = nil;
+        Point2f texSize = {0.0f, 0.0f};
+        Point2f glyphSize = {0.0f, 0.0f};
+        Point2f offset = {0.0f, 0.0f};
+        Point2f textureOffset = {0.0f, 0.0f};
+    };
+
+    // One run of a string, with everything we need from CoreText pulled out
+    struct GlyphRun
+    {
+        std::vector<CGGlyph> glyphs;
+        std::vector<CGPoint> offsets;
+        UIFont *font = nil;
+        UIColor *foregroundColor = nil;
+        UIColor *backgroundColor = nil;
+        UIColor *outlineColor = nil;
+        float outlineSize = 0.0f;
+        FontManager_iOSRef fm;
+        std::map<CGGlyph,StagedGlyph> staged;
+    };
+
+    // Render a glyph, or pull it from the glyph cache.  Doesn't need the lock.
+    void stageGlyph(CGGlyph glyph,const FontManager_iOSRef &fm,StagedGlyph &staged);
+    // Put a rendered glyph in the atlas.  Lock must be held.
+    FontManager::GlyphInfo *addStagedGlyph(CGGlyph glyph,const FontManager_iOSRef &fm,
+                                           const StagedGlyph &staged,ChangeSet &changes);
+
     NSData *renderGlyph(CGGlyph glyph,
                         const FontManager_iOSRef &,
                         Point2f &size,          // out: size with borders
@@ -72,7 +112,8 @@ protected:
                                               UIColor *colorUI,
                                               UIColor *backColorUI,
                                               UIColor *outlineColorUI,
-                                              float outlinesize);
+                                              float outlinesize,
+                                              bool sdf);
 };
     
 typedef std::shared_ptr<FontTextureManager_iOS> FontTextureManager_iOSRef;
@@ -24,7 +24,8 @@
 namespace WhirlyKit
 {
 
-typedef enum {MaplyImgTypeImage,MaplyImgTypeDataUIKitRecognized,MaplyImgTypeDataPKM,MaplyImgTypeDataPVRTC4,MaplyImgTypeRawImage} MaplyImgType;
+/// DataCompressed is anything ParseCompressedImage() recognizes, which goes to the GPU as is
+typedef enum {MaplyImgTypeImage,MaplyImgTypeDataUIKitRecognized,MaplyImgTypeDataPKM,MaplyImgTypeDataPVRTC4,MaplyImgTypeRawImage,MaplyImgTypeDataCompressed} MaplyImgType;
 
 /** ImageTile (iOS) Version
     This bridges the gap between ImageTile (and texture construction)
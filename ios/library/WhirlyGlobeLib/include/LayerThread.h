@@ -91,6 +91,13 @@
 ///  and the render.  And you know what this does.
 - (void)flushChangeRequests;
 
+/** Run work that doesn't touch the layers or need ordering off the layer thread.
+    It goes to the shared task threads, if they're running, most important first.
+    Otherwise it goes to a global queue, user initiated if priority is above zero and utility if not.
+    You can call this from any thread.
+  */
+- (void)addWorkerTask:(double)priority block:(dispatch_block_t)block;
+
 /// Dump out logging info.  Call this anywhere, but it'll run on the layer thread.
 - (void)log;
 
@@ -66,6 +66,9 @@ public:
     bool valid = false;
     id<MTLFunction> vertFunc,fragFunc;
     TimeInterval lightsLastUpdated = 0.0;
+    // Set if the vertex function positions drawables with UniformDrawStateA::mvMatrix.
+    // Drawables with a matrix then combine it with the view on the CPU as the view moves.
+    bool usesMvMatrix = false;
 
     // Program wide textures
     class TextureEntry {
@@ -75,6 +75,9 @@ public:
     // We're not bothering to load it, but pretend like it succeeded
     virtual void loadSkipped() override;
 
+    // Reload came back the same, so we're done with the request
+    virtual void loadUnchanged(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader) override;
+
 protected:
     // Returned by the TileFetcher
     MaplyTileFetchRequest *request;
@@ -139,6 +142,12 @@ protected:
 
     // Make an iOS specific tile/frame assets
     virtual QIFTileAssetRef makeTileAsset(PlatformThreadInfo *threadInfo,const QuadTreeNew::ImportantNode &ident) override;
+
+    // Start fetches for tiles we're likely to need, without loading the results
+    virtual void prefetchTiles(PlatformThreadInfo *threadInfo,const std::vector<QuadTreeNew::ImportantNode> &tiles) override;
+
+    // Outstanding fetch-ahead requests, by node number
+    NSMutableDictionary<NSNumber *,NSArray *> *prefetchRequests;
 };
     
 typedef std::shared_ptr<QuadImageFrameLoader_ios> QuadImageFrameLoader_iosRef;
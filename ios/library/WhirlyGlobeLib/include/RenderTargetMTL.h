@@ -57,6 +57,16 @@ public:
     /// If we've asked for a min/max calculation, this is where we get it
     virtual RawDataRef snapshotMinMax();
 
+    /// Encode a copy of a region (or the min/max values) into a shared buffer we can read once it's done.
+    /// Width or height of 0 means the whole texture.  Returns nil if there's nothing we can copy.
+    id<MTLBuffer> encodeReadback(id<MTLDevice> mtlDevice,id<MTLBlitCommandEncoder> bltEncode,
+                                 int startX,int startY,int snapWidth,int snapHeight,bool minMax);
+
+    /// Encode a histogram of the first channel into a shared buffer of uint32 counts, to read once it's done.
+    /// The counts for the other channels follow, if there are any.  Returns nil if there's no texture to count.
+    id<MTLBuffer> encodeHistogram(id<MTLDevice> mtlDevice,id<MTLCommandBuffer> cmdBuff,
+                                  int numBins,float minVal,float maxVal);
+
     /// Set the texture directly
     void setTargetTexture(TextureBaseMTL *tex);
     
@@ -97,6 +107,8 @@ protected:
     MPSImagePyramid *mipmapKernel;
     id<MTLTexture> minMaxOutTex;
     API_AVAILABLE(ios(11.0)) MPSImageStatisticsMinAndMax *minMaxKernel;
+    // Histogram kernels are set up for one range, so we keep the last one around
+    MPSImageHistogram *histKernel;
 };
     
 }
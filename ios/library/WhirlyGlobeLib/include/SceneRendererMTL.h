@@ -29,6 +29,7 @@
 #import <MetalKit/MetalKit.h>
 #import "DefaultShadersMTL.h"
 #import "Snapshot_iOS.h"
+#import "TransformMath.h"
 
 /// Caller to render() fills this in so we don't allocate the drawable
 ///  until it's needed.
@@ -68,6 +69,25 @@ public:
     API_AVAILABLE(ios(12.0)) id<MTLIndirectCommandBuffer> indCmdBuff;
     int numCommands;
 
+    // The other copies of the world on a wrapped map follow the main commands.
+    // Each copy repeats the drawables that can be copied, pointed at that copy's uniforms.
+    int numMainCommands = 0;
+    int numCopyCommands = 0;
+    int numCopies = 0;
+
+    // Drawables that can't be encoded indirectly go in their own groups and are drawn directly
+    bool direct = false;
+
+    // Screen space drawables go in their own groups too, so a scaled map can be drawn without them
+    bool screenSpace = false;
+
+    // If set, the commands are copied into the culled buffer every frame and the cull kernel
+    //  turns off the ones we can't see.  The info buffer has one entry per command.
+    bool gpuCull = false;
+    API_AVAILABLE(ios(12.0)) id<MTLIndirectCommandBuffer> culledCmdBuff;
+    BufferEntryMTL cullInfoBuff;
+    id<MTLBuffer> cullArgBuff;
+
     // Drawables in this group
     std::vector<DrawableRef> drawables;
     
@@ -100,7 +120,7 @@ protected:
 };
     
 /// Metal version of the Scene Renderer
-class SceneRendererMTL : public SceneRenderer
+class SceneRendererMTL : public SceneRenderer, public MemoryConsumer
 {
 public:
     SceneRendererMTL(id<MTLDevice> mtlDevice,id<MTLLibrary> mtlLibrary,float scale);
@@ -161,10 +181,19 @@ public:
     
     /// Construct a renderer-specific dynamic texture
     virtual DynamicTextureRef makeDynamicTexture(const std::string &name) const override;
+
+    /// Construct a blank texture for a render target to draw into
+    virtual Texture *makeRenderTexture(const std::string &name,int width,int height,TextureType type) const override;
     
-    /// Set up the buffer for general uniforms and attach it to its vertex/fragment buffers
+    /// Set up the buffer for general uniforms and attach it to its vertex/fragment buffers.
+    /// These are written into this frame's ring slot and only blitted into place for indirect rendering.
     void setupUniformBuffer(RendererFrameInfoMTL *frameInfo, id<MTLBlitCommandEncoder> bltEncode,CoordSystemDisplayAdapter *coordAdapter);
 
+    /// Set up uniforms for the other copies of the world on a wrapped map, one per offset matrix.
+    /// Drawables repeat their draw calls with these.
+    /// For indirect rendering they're blitted into buffers that stay put, like the main uniforms.
+    void setupCopyUniformBuffers(std::vector<RendererFrameInfoMTL> &offFrameInfos,const std::vector<Eigen::Matrix4d> &offsetMats,id<MTLBlitCommandEncoder> bltEncode,CoordSystemDisplayAdapter *coordAdapter);
+
     /// Set the lights and tie them to a vertex buffer index
     void setupLightBuffer(SceneMTL *scene,RendererFrameInfoMTL *frameInfo,id<MTLBlitCommandEncoder> bltEncode);
     
@@ -173,12 +202,27 @@ public:
     
     // Generate a render pipeline descriptor matching the given frame
     MTLRenderPipelineDescriptor *defaultRenderPipelineState(SceneRendererMTL *sceneRender,ProgramMTL *program,RenderTargetMTL *renderTarget);
+
+    // Pipeline state for the descriptor, shared with every drawable asking for the same one.
+    // The key is the shader functions, vertex layout, attachment formats and blending, not the label.
+    // Thread safe.
+    id<MTLRenderPipelineState> pipelineStateForDescriptor(MTLRenderPipelineDescriptor *renderDesc);
+
+    // Keep compiled pipelines in a binary archive at this path, so later runs load them rather than compile.
+    // Does nothing before iOS 14.  Set it before anything is drawn.
+    void setPipelineArchivePath(NSString *path);
+
+    // Write out the pipelines compiled since the archive was loaded, if any
+    void savePipelineArchive();
     
     // Return the whole buffer for a given render target
     RawDataRef getSnapshot(SimpleIdentity renderTargetID);
     
     // Return data values at a single pixel for the given render target
     RawDataRef getSnapshotAt(SimpleIdentity renderTargetID,int x,int y);
+
+    // Return the data values for a region of the given render target
+    virtual RawDataRef getSnapshotAt(SimpleIdentity renderTargetID,int x,int y,int width,int height) override;
     
     // Return the min/max values (assuming that option is on) for a render target
     RawDataRef getSnapshotMinMax(SimpleIdentity renderTargetID);
@@ -186,30 +230,122 @@ public:
     // Explicit wait for shutdown of ongoing frames
     void shutdown();
 
+    // Give back the memory we're holding on to for reuse, such as on a memory warning
+    void purgeMemory();
+
+    // Buffer and texture heap space.  Only what's allocated from heaps is counted.
+    virtual void addMemoryUsage(MemoryUsage &usage) override;
+
+    // Spare buffer space and pooled textures go with the caches
+    virtual void trimMemory(PlatformThreadInfo *inst,MemoryTrimLevel step,ChangeSet &changes) override;
+
+    // Check visibility by height, zoom and extents on the GPU for indirect rendering.
+    // On by default when the device does indirect rendering and the cull kernel loads.
+    void setGPUCulling(bool newVal);
+    bool getGPUCulling() const { return gpuCulling; }
+
     bool isShuttingDown() const { return *_isShuttingDown; }
 
 protected:
     RendererFrameInfoMTLRef makeFrameInfo();
 
+    // Everything in the shared uniforms for one set of matrices
+    void fillUniforms(RendererFrameInfoMTL *frameInfo,CoordSystemDisplayAdapter *coordAdapter,WhirlyKitShader::Uniforms &uniforms);
+
+    // Encode a draw group's drawables into a new indirect command buffer
+    API_AVAILABLE(ios(13.0))
+    void encodeDrawGroup(DrawGroupMTL &drawGroup,WorkGroup::GroupType groupType,RenderTargetMTL *renderTarget,RendererFrameInfoMTL *frameInfo);
+
+    // If dynamic resolution has us below full size, set up the smaller target to draw the map into
+    //  and return its render pass.  Returns nil at full size or if we can't scale into this pass.
+    MTLRenderPassDescriptor *setupScaledPass(MTLRenderPassDescriptor *screenPassDesc);
+
+    // Draw the scaled map over the whole screen pass
+    void encodeScaleUp(id<MTLRenderCommandEncoder> cmdEncode);
+
 public:
     RenderTargetMTLRef getRenderTarget(SimpleIdentity renderTargetID);
+
+    // Copy staged texture data into a texture with the next frame's blit pass.
+    // Render thread only.
+    void addTextureUpload(id<MTLBuffer> srcBuf,NSUInteger bytesPerRow,id<MTLTexture> destTex,MTLRegion destRegion);
+    // Copy a region from one texture to the same spot in another with the next frame's blit pass.
+    // Render thread only.
+    void addTextureCopy(id<MTLTexture> srcTex,id<MTLTexture> destTex,MTLRegion region);
     id<MTLCommandBuffer> lastCmdBuff;
 
     // If set, we'll use indirect rendering
     bool indirectRender;
+    // Turns off the indirect commands that aren't visible, if it's available
+    bool gpuCulling;
+    id<MTLComputePipelineState> cullPipeline;
+    id<MTLArgumentEncoder> cullArgEncoder;
     // By default offscreen rendering turns on or off blend enable
     bool offscreenBlendEnable;
+
+    // Dynamic resolution draws the map into these, then scales it up onto the screen
+    //  before the screen space drawables go on top.  They're the same formats as the
+    //  screen's, so the pipelines and indirect commands for it work here too.
+    id<MTLTexture> scaledColorTex;
+    id<MTLTexture> scaledDepthTex;
+    id<MTLFunction> scaleUpVertFunc,scaleUpFragFunc;
+    id<MTLRenderPipelineState> scaleUpPipeline;
+    id<MTLDepthStencilState> scaleUpDepthState;
+
+    // Pipeline states by descriptor.  The functions are held so their addresses stay unique.
+    struct PipelineEntry
+    {
+        id<MTLRenderPipelineState> state;
+        id<MTLFunction> vertFunc,fragFunc;
+    };
+    std::mutex pipelineLock;
+    std::unordered_map<std::string,PipelineEntry> pipelineStates;
+    NSURL *pipelineArchiveURL;
+    id pipelineArchive;     // id<MTLBinaryArchive> where available
+    bool pipelineArchiveDirty;
     // Information about the renderer passed around to various calls
     RenderSetupInfoMTL setupInfo;
+    // This frame's view in doubles.  Drawables with their own matrix fold it into these.
+    FrameMatrices drawFrameMats;
     std::vector<NSObject<WhirlyKitSnapshot> *> snapshotDelegates;
     dispatch_queue_t releaseQueue;
 
     id<MTLCommandQueue> cmdQueue;
 
+    // Texture copies waiting for the next blit pass
+    struct TextureUploadMTL
+    {
+        id<MTLBuffer> srcBuf;
+        NSUInteger bytesPerRow;
+        id<MTLTexture> destTex;
+        MTLRegion destRegion;
+    };
+    std::vector<TextureUploadMTL> pendingUploads;
+
+    // Texture to texture copies, after the uploads
+    struct TextureCopyMTL
+    {
+        id<MTLTexture> srcTex;
+        id<MTLTexture> destTex;
+        MTLRegion region;
+    };
+    std::vector<TextureCopyMTL> pendingCopies;
+
     // This keeps us from stomping on the previous frame's uniforms
     int lastRenderNo;
     id<MTLEvent> renderEvent;
 
+    // Copy per-frame data into the current ring slot, or a buffer of its own if that's full
+    BufferEntryMTL allocFrameData(const void *data,size_t size);
+
+    // Per-frame uniforms are written directly into one of these shared buffers.
+    // The semaphore keeps us from getting more than that many frames ahead of the GPU.
+    static constexpr int NumFrameBuffers = 3;
+    BufferEntryMTL frameBuffs[NumFrameBuffers];
+    int frameBuffWhich;
+    size_t frameBuffUsed;
+    dispatch_semaphore_t frameBuffSema;
+
 private:
     RendererFrameInfoRef lastFrameInfo;
     const std::shared_ptr<bool> _isShuttingDown;
@@ -65,9 +65,20 @@ public:
     /// Tears down MTL resources
     virtual void destroyInRenderer(const RenderSetupInfo *setupInfo,Scene *inScene);
 
+    /// Hands the staged data to the renderer to blit in with the next frame
+    virtual void finishUploadInRenderer(SceneRenderer *renderer) override;
+
 protected:
     // Convert our own raw data into bytes of the appropriate format
     RawDataRef convertData();
+
+    // Where the texture goes back to when we're done, if it came from there.
+    // We may be torn down after the heap manager is gone, hence the weak reference.
+    std::weak_ptr<TexturePoolMTL> texPool;
+
+    // Shared storage copy of the data for an asynchronous upload
+    id<MTLBuffer> stagingBuf = nil;
+    NSUInteger stagingBytesPerRow = 0;
 };
 
 typedef std::shared_ptr<TextureMTL> TextureMTLRef;
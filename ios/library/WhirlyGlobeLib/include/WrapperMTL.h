@@ -24,6 +24,8 @@
 #import "baseInfo.h"
 #import "DefaultShadersMTL.h"
 #import <unordered_set>
+#import <map>
+#import <tuple>
 
 namespace WhirlyKit
 {
@@ -58,6 +60,7 @@ public:
     id<MTLHeap> heap;      // Set if this is in a heap
     id<MTLBuffer> buffer;  // Buffer reference
     int offset;            // Offset within the buffer
+    std::shared_ptr<void> subBuffer;   // Set if this is a piece of a shared buffer, handed back when the last copy lets go
 };
 
 /// Description of what and where a texture is
@@ -69,6 +72,46 @@ public:
     id<MTLTexture> tex;  // The texture itself
 };
 
+/** Textures whose owners are done with them, kept for reuse by
+    textures of the same size and format.
+    Textures are only handed back once the GPU is finished with them.
+  */
+class TexturePoolMTL
+{
+public:
+    TexturePoolMTL(size_t maxBytes);
+
+    // Find a texture matching the descriptor, if we have one
+    TextureEntryMTL getTexture(MTLTextureDescriptor *desc);
+
+    // Hand back a texture for reuse.  It'll be released instead if we're full.
+    void returnTexture(const TextureEntryMTL &tex);
+
+    // Limit on the bytes we'll hang on to, 0 to disable
+    void setMaxBytes(size_t maxBytes);
+
+    // Release everything
+    void clear();
+
+protected:
+    // Pixel format, width, height, usage, storage mode
+    typedef std::tuple<NSUInteger,NSUInteger,NSUInteger,NSUInteger,NSUInteger> PoolKey;
+    static PoolKey makeKey(MTLPixelFormat format,NSUInteger width,NSUInteger height,
+                           MTLTextureUsage usage,MTLStorageMode storageMode);
+
+    struct PoolEntry
+    {
+        TextureEntryMTL tex;
+        size_t bytes;
+    };
+
+    std::mutex lock;
+    std::map<PoolKey,std::vector<PoolEntry>> textures;
+    size_t curBytes = 0;
+    size_t maxBytes;
+};
+typedef std::shared_ptr<TexturePoolMTL> TexturePoolMTLRef;
+
 // Used to construct unified buffers for drawables (or whatever)
 class BufferBuilderMTL
 {
@@ -84,6 +127,10 @@ public:
     
     // Construct the buffer from the data we got
     BufferEntryMTL buildBuffer();
+
+    // Same, but small ones can be a piece of a shared buffer.
+    // Only for buffers that last until a drawable is torn down, once the GPU is done with it.
+    BufferEntryMTL buildSharedBuffer();
 public:
     RenderSetupInfoMTL *setupInfo;
     std::vector<BufferEntryMTL *> bufferRefs;
@@ -178,9 +225,24 @@ public:
     
     // This version copies data into the buffer
     BufferEntryMTL allocateBuffer(HeapType,const void *data,size_t size);
+
+    // Small drawable buffers come out of bigger shared ones, in power of two slots.
+    // The slot goes back when the last entry referring to it is cleared, so the GPU has to be done with it by then.
+    BufferEntryMTL allocateSubBuffer(const void *data,size_t size);
+
+    // Let go of shared buffers and heaps with nothing in them and empty the texture pool.
+    // Used on memory warnings.
+    void purge();
+
+    // Bytes allocated from the buffer and texture heaps
+    void getUsage(size_t &bufferBytes,size_t &textureBytes);
     
     // Allocate a texture with the given descriptor off of a heap (or not)
-    TextureEntryMTL newTextureWithDescriptor(MTLTextureDescriptor *desc,size_t size);
+    // If usePool is set we'll try recycled textures of the same size first.
+    TextureEntryMTL newTextureWithDescriptor(MTLTextureDescriptor *desc,size_t size,bool usePool = false);
+
+    // Textures waiting for reuse.  Owners keep a weak reference to hand them back.
+    const TexturePoolMTLRef &getTexturePool() const { return texPool; }
 
 protected:
     // Info about a single heap
@@ -206,6 +268,28 @@ protected:
         HeapSet heaps;
     };
     
+    // One shared buffer cut up into equal slots
+    struct SubBufferSlab
+    {
+        id<MTLHeap> heap;
+        id<MTLBuffer> buffer;
+        size_t numSlots;
+        std::vector<int> freeSlots;
+    };
+    typedef std::shared_ptr<SubBufferSlab> SubBufferSlabRef;
+
+    // Slabs by slot size, memAlign and up by powers of two.
+    // The pieces handed out keep a weak reference so they can find their way back.
+    struct SubBufferPool
+    {
+        std::mutex lock;
+        std::vector<std::vector<SubBufferSlabRef>> slabs;
+    };
+    typedef std::shared_ptr<SubBufferPool> SubBufferPoolRef;
+
+    // Let go of the heaps with nothing in them.  Lock must be held.
+    static void purgeHeaps(HeapSet &heapSet);
+
     HeapInfoRef allocateHeap(unsigned size, unsigned minSize, MTLStorageMode mode);
     HeapInfoRef findHeap(HeapType heapType,size_t &size,id<MTLHeap> prevHeap = nil);
     HeapInfoRef findHeap(HeapSet &heapSet,size_t &size,id<MTLHeap> prevHeap = nil);
@@ -216,11 +300,16 @@ protected:
     id<MTLDevice> mtlDevice;
     HeapGroup heapGroups[MaxType];
     HeapGroup texGroups;
+    TexturePoolMTLRef texPool;
+    SubBufferPoolRef subPool;
 
     // Keep Metal allocations aligned to this
     size_t memAlign;
     
     static constexpr size_t MB = 1024 * 1024;
+    // Bigger than this gets its own buffer
+    static constexpr size_t SubBufferMaxSize = 64 * 1024;
+    static constexpr size_t SubBufferSlabSize = 1 * MB;
 };
 
 /// Passed around to various init and teardown routines
@@ -239,6 +328,11 @@ struct RenderSetupInfoMTL : public RenderSetupInfo
     // Wired into the various drawables individually
     BufferEntryMTL uniformBuff;
     BufferEntryMTL lightingBuff;
+    // Uniforms for the other copies of the world on a wrapped map.
+    // Drawables repeat their draws with these after the main one.
+    std::vector<BufferEntryMTL> copyUniformBuffs;
+    // Where the copies' uniforms live for indirect rendering.  Only grows, since commands point at these.
+    std::vector<BufferEntryMTL> fixedCopyUniformBuffs;
 };
 
 /// Convert  a float expression into its Metal version
@@ -82,7 +82,7 @@ void BasicDrawableBuilderMTL::setupTexCoordEntry(int which,int numReserve)
         BasicDrawable::TexInfo newInfo;
         char attributeName[40];
         sprintf(attributeName,"a_texCoord%d",ii);
-        newInfo.texCoordEntry = addAttribute(BDFloat2Type,StringIndexer::getStringID(attributeName));
+        newInfo.texCoordEntry = addAttribute(texCoordType(),StringIndexer::getStringID(attributeName));
         VertexAttributeMTL *vertAttrMTL = (VertexAttributeMTL *)basicDraw->vertexAttributes[newInfo.texCoordEntry];
         vertAttrMTL->setDefaultVector2f(Vector2f(0.0,0.0));
         vertAttrMTL->reserve(numReserve);
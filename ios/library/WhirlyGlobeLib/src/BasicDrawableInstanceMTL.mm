@@ -67,31 +67,8 @@ void BasicDrawableInstanceMTL::setupForRenderer(const RenderSetupInfo *inSetupIn
         } else {
             // Set up the instances in their own array
             std::vector<WhirlyKitShader::VertexTriModelInstance> insts(instances.size());
-            for (int which = 0;which < instances.size();which++) {
-                auto &inst = instances[which];
-                auto &outInst = insts[which];
-                
-                // Color override
-                if (inst.colorOverride) {
-                    uniMI.useInstanceColor = true;
-                    float colors[4];
-                    inst.color.asUnitFloats(colors);
-                    CopyIntoMtlFloat4(outInst.color, colors);
-                } else {
-                    outInst.color[0] = 1.0;  outInst.color[1] = 1.0;  outInst.color[2] = 1.0;  outInst.color[3] = 1.0;
-                }
-                
-                // Center
-                CopyIntoMtlFloat3(outInst.center, inst.center);
-                
-                // Rotation/translation/scale
-                CopyIntoMtlFloat4x4(outInst.mat, inst.mat);
-                
-                // EndCenter/direction
-                Point3d dir = moving ? (inst.endCenter - inst.center)/inst.duration : Point3d(0.0,0.0,0.0);
-                CopyIntoMtlFloat3(outInst.dir, dir);
-                uniMI.hasMotion |= moving;
-            }
+            for (int which = 0;which < instances.size();which++)
+                setupInstance(instances[which], insts[which]);
 
             int bufferSize = sizeof(WhirlyKitShader::VertexTriModelInstance) * insts.size();
             buffBuild.addData(&insts[0], bufferSize, &instBuffer);
@@ -121,12 +98,54 @@ void BasicDrawableInstanceMTL::setupForRenderer(const RenderSetupInfo *inSetupIn
     buffBuild.addData(&data[0], 4, &colorBuffer);
     
     // Construct the buffer we've been adding to
-    mainBuffer = buffBuild.buildBuffer();
+    mainBuffer = buffBuild.buildSharedBuffer();
     baseMainBuffer = basicDrawMTL->mainBuffer;
     
     setupForMTL = true;
 }
 
+void BasicDrawableInstanceMTL::setupInstance(const SingleInstance &inst,WhirlyKitShader::VertexTriModelInstance &outInst)
+{
+    // Color override
+    if (inst.colorOverride) {
+        uniMI.useInstanceColor = true;
+        float colors[4];
+        inst.color.asUnitFloats(colors);
+        CopyIntoMtlFloat4(outInst.color, colors);
+    } else {
+        outInst.color[0] = 1.0;  outInst.color[1] = 1.0;  outInst.color[2] = 1.0;  outInst.color[3] = 1.0;
+    }
+    
+    // Center
+    CopyIntoMtlFloat3(outInst.center, inst.center);
+    
+    // Rotation/translation/scale
+    CopyIntoMtlFloat4x4(outInst.mat, inst.mat);
+    
+    // EndCenter/direction
+    Point3d dir = moving ? (inst.endCenter - inst.center)/inst.duration : Point3d(0.0,0.0,0.0);
+    CopyIntoMtlFloat3(outInst.dir, dir);
+    uniMI.hasMotion |= moving;
+}
+
+void BasicDrawableInstanceMTL::setInstances(unsigned int startInst,const std::vector<SingleInstance> &insts)
+{
+    BasicDrawableInstance::setInstances(startInst,insts);
+    if (!setupForMTL || instData || !instBuffer.valid || !instBuffer.buffer || insts.empty() ||
+        startInst + insts.size() > numInst)
+        return;
+
+    // The instances went into the shared buffer, so we can write right over them
+    auto *outInsts = (WhirlyKitShader::VertexTriModelInstance *)((unsigned char *)[instBuffer.buffer contents] + instBuffer.offset);
+    const bool useInstanceColor = uniMI.useInstanceColor;
+    for (unsigned int ii=0;ii<insts.size();ii++)
+        setupInstance(insts[ii], outInsts[startInst+ii]);
+
+    // A first color override means the uniforms need another look
+    if (uniMI.useInstanceColor != useInstanceColor)
+        setValuesChanged();
+}
+
 void BasicDrawableInstanceMTL::teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *inScene,RenderTeardownInfoRef inTeardown)
 {
     RenderTeardownInfoMTLRef teardown = std::dynamic_pointer_cast<RenderTeardownInfoMTL>(inTeardown);
@@ -206,13 +225,8 @@ id<MTLRenderPipelineState> BasicDrawableInstanceMTL::getRenderPipelineState(Scen
         }
     }
 
-    // Set up a render state
-    NSError *err = nil;
-    renderState = [sceneRender->setupInfo.mtlDevice newRenderPipelineStateWithDescriptor:renderDesc error:&err];
-    if (err) {
-        NSLog(@"BasicDrawableMTL: Failed to set up render state because:\n%@",err);
-        return nil;
-    }
+    // Set up a render state, or reuse one with the same program and layout
+    renderState = sceneRender->pipelineStateForDescriptor(renderDesc);
 
     return renderState;
 }
@@ -290,13 +304,8 @@ id<MTLRenderPipelineState> BasicDrawableInstanceMTL::getCalcRenderPipelineState(
     if (!name.empty())
         renderDesc.label = [NSString stringWithFormat:@"%s",name.c_str()];
     
-    // Set up a render state
-    NSError *err = nil;
-    calcRenderState = [sceneRender->setupInfo.mtlDevice newRenderPipelineStateWithDescriptor:renderDesc error:&err];
-    if (err) {
-        NSLog(@"BasicDrawableMTL: Failed to set up render state because:\n%@",err);
-        return nil;
-    }
+    // Set up a render state, or reuse one with the same program and layout
+    calcRenderState = sceneRender->pipelineStateForDescriptor(renderDesc);
     
     return calcRenderState;
 }
@@ -432,10 +441,11 @@ bool BasicDrawableInstanceMTL::preProcess(SceneRendererMTL *sceneRender,
             uni.zoomSlot = zoomSlot;
             uni.clipCoords = basicDraw->clipCoords;
             uni.hasExp = hasExp;
-            // TODO: Put these in the instance as well
+            // Our own fade times win, if we have them
             double baseTime = scene->getBaseTime();
-            uni.fadeUp = basicDraw->fadeUp-baseTime;
-            uni.fadeDown = basicDraw->fadeDown-baseTime;
+            const bool ownFade = (fadeUp != fadeDown);
+            uni.fadeUp = (ownFade ? fadeUp : basicDraw->fadeUp)-baseTime;
+            uni.fadeDown = (ownFade ? fadeDown : basicDraw->fadeDown)-baseTime;
             uni.minVisible = basicDraw->minVisible;
             uni.maxVisible = basicDraw->maxVisible;
             uni.minVisibleFadeBand = basicDraw->minVisibleFadeBand;
@@ -886,7 +896,7 @@ void BasicDrawableInstanceMTL::encodeIndirect(id<MTLIndirectRenderCommand> cmdEn
             }
             break;
         case GPUStyle:
-            NSLog(@"GPU Style BasicDrawableInstance needs to be implemented");
+            // These are encoded directly, see canEncodeIndirect()
             break;
     }
 }
@@ -16,6 +16,7 @@
  *  limitations under the License.
  */
 
+#import <typeinfo>
 #import "BasicDrawableMTL.h"
 #import "ProgramMTL.h"
 #import "SceneRendererMTL.h"
@@ -24,6 +25,7 @@
 #import "SceneMTL.h"
 #import "DefaultShadersMTL.h"
 #import "WhirlyKitLog.h"
+#import "TransformMath.h"
 
 using namespace Eigen;
 
@@ -32,7 +34,7 @@ namespace WhirlyKit
 
 BasicDrawableMTL::BasicDrawableMTL(const std::string &name) :
     BasicDrawable(name), Drawable(name), setupForMTL(false), vertDesc(nil),
-    renderState(nil), numPts(0), numTris(0),vertHasTextures(false),
+    renderState(nil), numPts(0), numTris(0),hasDispBox(false),vertHasTextures(false),
     fragHasTextures(false),vertHasLighting(false),fragHasLighting(false)
 {
 }
@@ -65,25 +67,45 @@ void BasicDrawableMTL::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scene
     SceneMTL *scene = (SceneMTL *)inScene;
     
     BufferBuilderMTL buffBuild(setupInfo);
+    gpuBytes = 0;
 
     // Set up the buffers for each vertex attribute
     for (VertexAttribute *vertAttr : vertexAttributes) {
         VertexAttributeMTL *vertAttrMTL = (VertexAttributeMTL *)vertAttr;
+
+        // Note the extents while we still have the data
+        if (vertAttrMTL->nameID == a_PositionNameID && vertAttrMTL->getDataType() == BDFloat3Type &&
+            vertAttrMTL->numElements() > 0) {
+            for (int ii=0;ii<vertAttrMTL->numElements();ii++) {
+                const Point3f &pt = *(const Point3f *)vertAttrMTL->addressForElement(ii);
+                dispBoxMin = (ii == 0) ? pt : Point3f(dispBoxMin.cwiseMin(pt));
+                dispBoxMax = (ii == 0) ? pt : Point3f(dispBoxMax.cwiseMax(pt));
+            }
+            hasDispBox = true;
+        }
         
         int bufferSize = vertAttrMTL->sizeMTL() * vertAttrMTL->numElements();
         if (bufferSize > 0) {
             numPts = vertAttrMTL->numElements();
             buffBuild.addData(vertAttrMTL->addressForElement(0), bufferSize, &vertAttrMTL->buffer);
+            gpuBytes += bufferSize;
             vertAttrMTL->clear();
         }
     }
     
+    // Merged drawables hang on to their triangles so they can put back the ones turned back on
+    if (isMerged()) {
+        mergedTris = tris;
+        maskMergedTris(tris);
+    }
+
     // And put the triangles in their own
     // Note: Could use 1 byte some of the time
     numTris = tris.size();
     const int bufferSize = 3*2*numTris;
     if (bufferSize > 0) {
         buffBuild.addData(&tris[0], bufferSize, &triBuffer);
+        gpuBytes += bufferSize;
         tris.clear();
     }
     
@@ -100,7 +122,7 @@ void BasicDrawableMTL::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scene
         buffBuild.addData(&defAttr.data, sizeof(defAttr.data), &defAttr.buffer);
     
     // Construct the buffer we've been adding to
-    mainBuffer = buffBuild.buildBuffer();
+    mainBuffer = buffBuild.buildSharedBuffer();
     
     // If this is a calculation drawable, we need to build the data buffers
     // We're not going to merge these into a main buffer, they're meant to be big
@@ -109,11 +131,49 @@ void BasicDrawableMTL::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scene
                                                             thisData->getRawData(),
                                                             thisData->getLen());
         calcBuffers.push_back(newBuff);
+        gpuBytes += thisData->getLen();
     }
     
     setupForMTL = true;
 }
 
+void BasicDrawableMTL::setupGPUCull(bool gpuCull,WhirlyKitShader::CullInfo &info)
+{
+    setGPUCulled(gpuCull);
+
+    info.flags = 0;
+    info.zoomSlot = -1;
+    if (!gpuCull)
+        return;
+
+    if (minVisible != DrawVisibleInvalid && maxVisible != DrawVisibleInvalid) {
+        info.flags |= WKSCullHeight;
+        info.minVisible = minVisible;
+        info.maxVisible = maxVisible;
+    }
+    if (zoomSlot > -1 && zoomSlot < MaxZoomSlots) {
+        info.zoomSlot = zoomSlot;
+        if (minZoomVis != DrawVisibleInvalid) {
+            info.flags |= WKSCullMinZoom;
+            info.minZoomVis = minZoomVis;
+        }
+        if (maxZoomVis != DrawVisibleInvalid) {
+            info.flags |= WKSCullMaxZoom;
+            info.maxZoomVis = maxZoomVis;
+        }
+    }
+
+    // Anything from the wide vectors on moves its vertices around in the shader, so the extents don't tell us much
+    const bool shaderMoves = hasMatrix || clipCoords || motion || !tweakers.empty() ||
+        std::any_of(uniBlocks.begin(), uniBlocks.end(), [](const UniformBlock &uniBlock)
+                    { return uniBlock.bufferID >= WhirlyKitShader::WKSUniformWideVecEntry; });
+    if (hasDispBox && !shaderMoves) {
+        info.flags |= WKSCullExtents;
+        CopyIntoMtlFloat3(info.boxMin, dispBoxMin);
+        CopyIntoMtlFloat3(info.boxMax, dispBoxMax);
+    }
+}
+
 void BasicDrawableMTL::teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *inScene,RenderTeardownInfoRef inTeardown)
 {
     RenderTeardownInfoMTLRef teardown = std::dynamic_pointer_cast<RenderTeardownInfoMTL>(inTeardown);
@@ -122,6 +182,7 @@ void BasicDrawableMTL::teardownForRenderer(const RenderSetupInfo *setupInfo,Scen
         enumerateBuffers(*teardown->resources);
     
     setupForMTL = false;
+    gpuBytes = 0;
 
     renderState = nil;
     vertDesc = nil;
@@ -219,6 +280,16 @@ MTLVertexDescriptor *BasicDrawableMTL::getVertexDescriptor(id<MTLFunction> vertF
                     defAttr.dataType = MTLDataTypeInt;
                     defAttr.data.iVal = ourVertAttr->defaultData.intVal;
                     break;
+                case BDHalf2Type:
+                case BDShort2NormType:
+                case BDChar4NormType:
+                {
+                    // Read with the same format as the array would be, so it has to be packed the same way
+                    defAttr.dataType = (ourVertAttr->dataType == BDChar4NormType) ? MTLDataTypeFloat3 : MTLDataTypeFloat2;
+                    const uint32_t packed = ourVertAttr->packedDefault();
+                    memcpy(&defAttr.data, &packed, sizeof(packed));
+                }
+                    break;
                 default:
                     break;
             }
@@ -308,13 +379,8 @@ id<MTLRenderPipelineState> BasicDrawableMTL::getRenderPipelineState(SceneRendere
     if (!name.empty())
         renderDesc.label = [NSString stringWithFormat:@"%s",name.c_str()];
 
-    // Set up a render state
-    NSError *err = nil;
-    renderState = [sceneRender->setupInfo.mtlDevice newRenderPipelineStateWithDescriptor:renderDesc error:&err];
-    if (err) {
-        NSLog(@"BasicDrawableMTL: Failed to set up render state because:\n%@",err);
-        return nil;
-    }
+    // Drawables with the same program and layout share a render state
+    renderState = sceneRender->pipelineStateForDescriptor(renderDesc);
 
     return renderState;
 }
@@ -327,10 +393,22 @@ void BasicDrawableMTL::applyUniformsToDrawState(WhirlyKitShader::UniformDrawStat
         } else if (uni.nameID == u_screenOriginNameID) {
             drawState.screenOrigin[0] = uni.data.vec2[0];
             drawState.screenOrigin[1] = uni.data.vec2[1];
+        } else if (uni.nameID == u_elevDecodeNameID) {
+            drawState.elevDecode = simd::float4{uni.data.vec4[0],uni.data.vec4[1],uni.data.vec4[2],uni.data.vec4[3]};
         }
     }
 }
 
+bool BasicDrawableMTL::setTexAnimation(TimeInterval startTime,double period,int numTextures)
+{
+    texAnimStart = startTime;
+    texAnimPeriod = period;
+    texAnimTextures = numTextures;
+    setValuesChanged();
+
+    return true;
+}
+
 void BasicDrawableMTL::setOverrideColor(RGBAColor inColor)
 {
     BasicDrawable::setOverrideColor(inColor);
@@ -352,6 +430,80 @@ void BasicDrawableMTL::setOverrideColor(RGBAColor inColor)
     }
 }
 
+void BasicDrawableMTL::setVertexColors(unsigned int startVert,unsigned int numVerts,RGBAColor inColor)
+{
+    if (!setupForMTL)
+    {
+        BasicDrawable::setVertexColors(startVert,numVerts,inColor);
+        return;
+    }
+    if (colorEntry < 0 || colorEntry >= vertexAttributes.size() || startVert + numVerts > numPts)
+        return;
+
+    // Drawable buffers are shared with the CPU, so we can write right into it
+    auto *colorAttr = (VertexAttributeMTL *)vertexAttributes[colorEntry];
+    if (!colorAttr->buffer.valid || !colorAttr->buffer.buffer || colorAttr->dataType != BDChar4Type)
+        return;
+    auto *colors = (unsigned char *)[colorAttr->buffer.buffer contents] + colorAttr->buffer.offset;
+    for (unsigned int ii=startVert;ii<startVert+numVerts;ii++)
+        inColor.asUChar4(&colors[ii*colorAttr->sizeMTL()]);
+}
+
+void BasicDrawableMTL::setVertexMotion(const std::vector<VertexMotion> &motions)
+{
+    if (!setupForMTL)
+    {
+        BasicDrawable::setVertexMotion(motions);
+        return;
+    }
+
+    // Positions and directions each have their own buffer, which the CPU can see
+    for (const auto nameID : { a_PositionNameID, a_dirNameID })
+    {
+        VertexAttributeMTL *attr = findVertexAttribute((int)nameID);
+        if (!attr || !attr->buffer.valid || !attr->buffer.buffer || attr->dataType != BDFloat3Type)
+            continue;
+        auto *vals = (unsigned char *)[attr->buffer.buffer contents] + attr->buffer.offset;
+        const int stride = attr->sizeMTL();
+        for (const auto &motion : motions)
+        {
+            if (motion.startVert + motion.numVerts > numPts)
+                continue;
+            const Point3f &val = (nameID == a_PositionNameID) ? motion.pos : motion.dir;
+            for (unsigned int ii=motion.startVert;ii<motion.startVert+motion.numVerts;ii++)
+                memcpy(&vals[ii*stride], &val.x(), 3*sizeof(float));
+        }
+    }
+}
+
+bool BasicDrawableMTL::merge(BasicDrawable &inThat)
+{
+    // Subclasses have their own ideas about drawing, so it's just us
+    auto *that = dynamic_cast<BasicDrawableMTL *>(&inThat);
+    if (!that || typeid(*this) != typeid(BasicDrawableMTL) || typeid(*that) != typeid(BasicDrawableMTL) ||
+        setupForMTL || that->setupForMTL || !canMerge(*that))
+        return false;
+
+    // Positions are just another attribute for us
+    const auto *posAttr = findVertexAttribute((int)a_PositionNameID);
+    const auto *thatPosAttr = that->findVertexAttribute((int)a_PositionNameID);
+    if (!posAttr || !thatPosAttr)
+        return false;
+
+    return mergeGeometry(*that,tris,that->tris,posAttr->numElements(),thatPosAttr->numElements());
+}
+
+void BasicDrawableMTL::mergedTrisChanged()
+{
+    if (!setupForMTL || !triBuffer.valid || !triBuffer.buffer || mergedTris.size() != numTris)
+        return;
+
+    // Same as the vertex colors, the buffer's shared with the CPU
+    std::vector<Triangle> masked;
+    maskMergedTris(masked);
+    memcpy((unsigned char *)[triBuffer.buffer contents] + triBuffer.offset, &masked[0], masked.size()*sizeof(Triangle));
+}
+
 namespace {
     const static std::string hasTextures("hasTextures");
     const static std::string hasLighting("hasLighting");
@@ -435,8 +587,22 @@ bool BasicDrawableMTL::preProcess(SceneRendererMTL *sceneRender,id<MTLCommandBuf
         }
     }
 
-    if (texturesChanged || valuesChanged || prog->texturesChanged || prog->valuesChanged) {
-        ret = true;
+    // Our matrix (usually the center the points are relative to) is combined with the view here in doubles,
+    //  rather than in floats in the shader.  That has to be redone whenever the view moves.
+    bool mvChanged = false;
+    if (hasMatrix && !clipCoords && prog->usesMvMatrix) {
+        DrawMatrices drawMats;
+        CalcDrawMatrices(sceneRender->drawFrameMats,mat,drawMats);
+        if (!drawMvValid || drawMats.mv != drawMvMat) {
+            drawMvMat = drawMats.mv;
+            drawMvValid = true;
+            mvChanged = true;
+        }
+    }
+
+    if (texturesChanged || valuesChanged || prog->texturesChanged || prog->valuesChanged || mvChanged) {
+        // Only the draw state changes for a new view, so the encoded commands are still good
+        ret = texturesChanged || valuesChanged || prog->texturesChanged || prog->valuesChanged;
         
         // We need to blit the default values into place because we let those change
         // Typically, this is color
@@ -516,7 +682,7 @@ bool BasicDrawableMTL::preProcess(SceneRendererMTL *sceneRender,id<MTLCommandBuf
             }
         }
 
-        if (valuesChanged || prog->valuesChanged) {
+        if (valuesChanged || prog->valuesChanged || mvChanged) {
             if (vertABInfo)
                 vertABInfo->startEncoding(sceneRender->setupInfo.mtlDevice);
             if (fragABInfo)
@@ -551,6 +717,10 @@ bool BasicDrawableMTL::preProcess(SceneRendererMTL *sceneRender,id<MTLCommandBuf
                 Eigen::Matrix4d identMatrix = Eigen::Matrix4d::Identity();
                 CopyIntoMtlFloat4x4(uni.singleMat, identMatrix);
             }
+            if (drawMvValid && hasMatrix && !clipCoords && prog->usesMvMatrix) {
+                CopyIntoMtlFloat4x4(uni.mvMatrix, drawMvMat);
+                uni.hasMvMatrix = true;
+            }
             double baseTime = scene->getBaseTime();
             uni.fadeUp = fadeUp - baseTime;
             uni.fadeDown = fadeDown - baseTime;
@@ -558,6 +728,11 @@ bool BasicDrawableMTL::preProcess(SceneRendererMTL *sceneRender,id<MTLCommandBuf
             uni.maxVisible = maxVisible;
             uni.minVisibleFadeBand = minVisibleFadeBand;
             uni.maxVisibleFadeBand = maxVisibleFadeBand;
+            if (texAnimPeriod > 0.0) {
+                uni.texAnimStart = texAnimStart - baseTime;
+                uni.texAnimPeriod = texAnimPeriod;
+                uni.texAnimTextures = texAnimTextures;
+            }
             applyUniformsToDrawState(uni,uniforms);
             if (vertABInfo)
                 vertABInfo->updateEntry(sceneRender->setupInfo.mtlDevice,bltEncode, WhirlyKitShader::WKSUniformDrawStateEntry, &uni, sizeof(uni));
@@ -699,20 +874,33 @@ void BasicDrawableMTL::encodeDirect(RendererFrameInfoMTL *frameInfo,id<MTLRender
     }
 
     // Render the primitives themselves
-    switch (type) {
-        case Lines:
-            [cmdEncode drawPrimitives:MTLPrimitiveTypeLine vertexStart:0 vertexCount:numPts];
-            break;
-        case Triangles:
-            if (numTris == 0) {
-                NSLog(@"BasicDrawableMTL: Found a drawable with no triangles.");
-                return;
-            }
-            // This actually draws the triangles (well, in a bit)
-            [cmdEncode drawIndexedPrimitives:MTLPrimitiveTypeTriangle indexCount:numTris*3 indexType:MTLIndexTypeUInt16 indexBuffer:triBuffer.buffer indexBufferOffset:triBuffer.offset];
-            break;
-        default:
-            break;
+    const auto drawPrims = [&]()
+    {
+        switch (type) {
+            case Lines:
+                [cmdEncode drawPrimitives:MTLPrimitiveTypeLine vertexStart:0 vertexCount:numPts];
+                break;
+            case Triangles:
+                // This actually draws the triangles (well, in a bit)
+                [cmdEncode drawIndexedPrimitives:MTLPrimitiveTypeTriangle indexCount:numTris*3 indexType:MTLIndexTypeUInt16 indexBuffer:triBuffer.buffer indexBufferOffset:triBuffer.offset];
+                break;
+            default:
+                break;
+        }
+    };
+    if (type == Triangles && numTris == 0) {
+        NSLog(@"BasicDrawableMTL: Found a drawable with no triangles.");
+        return;
+    }
+    drawPrims();
+
+    // Other copies of the world on a wrapped map are the same draw with their own uniforms
+    if (!clipCoords) {
+        for (const auto &copyBuff : sceneRender->setupInfo.copyUniformBuffs) {
+            [cmdEncode setVertexBuffer:copyBuff.buffer offset:copyBuff.offset atIndex:WhirlyKitShader::WKSVertUniformArgBuffer];
+            [cmdEncode setFragmentBuffer:copyBuff.buffer offset:copyBuff.offset atIndex:WhirlyKitShader::WKSFragUniformArgBuffer];
+            drawPrims();
+        }
     }
 }
 
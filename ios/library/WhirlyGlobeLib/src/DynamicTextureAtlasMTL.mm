@@ -19,6 +19,7 @@
  */
 
 #import "DynamicTextureAtlasMTL.h"
+#import "SceneRendererMTL.h"
 
 namespace WhirlyKit
 {
@@ -128,12 +129,62 @@ void DynamicTextureMTL::addTextureData(int startX,int startY,int width,int heigh
     [texBuf.tex replaceRegion:region mipmapLevel:0 withBytes:data->getRawData() bytesPerRow:width*bytesPerPixel];    
 }
 
-void DynamicTextureMTL::clearTextureData(int startX,int startY,int width,int height,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData)
+DynamicTexture::StagedDataRef DynamicTextureMTL::stageTextureData(const RenderSetupInfo *inSetupInfo,int startX,int startY,int width,int height,const RawDataRef &data)
 {
-    if (!clearTextures)
+    RenderSetupInfoMTL *setupInfo = (RenderSetupInfoMTL *)inSetupInfo;
+    if (!valid || !setupInfo || !data || data->getLen() < (size_t)width*height*bytesPerPixel)
+    {
+        return StagedDataRef();
+    }
+
+    const auto staged = std::make_shared<StagedDataMTL>();
+    staged->buffer = [setupInfo->mtlDevice newBufferWithBytes:data->getRawData()
+                                                       length:data->getLen()
+                                                      options:MTLResourceStorageModeShared];
+    if (!staged->buffer)
+    {
+        return StagedDataRef();
+    }
+    staged->startX = startX;
+    staged->startY = startY;
+    staged->width = width;
+    staged->height = height;
+
+    return staged;
+}
+
+void DynamicTextureMTL::addStagedData(SceneRenderer *renderer,const StagedDataRef &inStaged)
+{
+    const auto staged = std::dynamic_pointer_cast<StagedDataMTL>(inStaged);
+    if (!staged || !staged->buffer || !texBuf.tex)
+    {
         return;
+    }
 
-    // TODO: Implement this with a blit encoder
+    ((SceneRendererMTL *)renderer)->addTextureUpload(staged->buffer, staged->width*bytesPerPixel, texBuf.tex,
+                                                     MTLRegionMake2D(staged->startX,staged->startY,staged->width,staged->height));
+    staged->buffer = nil;
 }
-    
+
+void DynamicTextureMTL::copyRegions(SceneRenderer *renderer,DynamicTexture *inSrc,const std::vector<Region> &regions)
+{
+    const auto src = dynamic_cast<DynamicTextureMTL *>(inSrc);
+    if (!src || !src->texBuf.tex || !texBuf.tex)
+    {
+        return;
+    }
+
+    for (const auto &region : regions)
+    {
+        const int startX = region.sx * cellSize, startY = region.sy * cellSize;
+        const int width = std::min((region.ex - region.sx + 1) * cellSize, texSize - startX);
+        const int height = std::min((region.ey - region.sy + 1) * cellSize, texSize - startY);
+        if (width > 0 && height > 0)
+        {
+            ((SceneRendererMTL *)renderer)->addTextureCopy(src->texBuf.tex, texBuf.tex,
+                                                           MTLRegionMake2D(startX,startY,width,height));
+        }
+    }
+}
+
 }
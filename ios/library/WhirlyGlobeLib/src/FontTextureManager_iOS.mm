@@ -78,21 +78,30 @@ void FontTextureManager_iOS::teardown(PlatformThreadInfo* inst)
 }
 
 // Look for an existing font that will match the UIFont given
-FontManager_iOSRef FontTextureManager_iOS::findFontManagerForFont(UIFont *uiFont,UIColor *colorUI,UIColor *backColorUI,UIColor *outlineColorUI,float outlineSize)
+FontManager_iOSRef FontTextureManager_iOS::findFontManagerForFont(UIFont *uiFont,UIColor *colorUI,UIColor *backColorUI,UIColor *outlineColorUI,float outlineSize,bool sdf)
 {
+    // Distance fields are white at a fixed size, the shader does the rest
+    if (sdf)
+    {
+        colorUI = [UIColor whiteColor];
+        backColorUI = nil;
+        outlineColorUI = nil;
+        outlineSize = 0.0;
+    }
+
     // We need to scale the font up so it looks better scaled down
     std::string fontName = [uiFont.fontName cStringUsingEncoding:NSASCIIStringEncoding];
     float pointSize = uiFont.pointSize;
     RGBAColor color = [colorUI asRGBAColor];
     RGBAColor backColor = [backColorUI asRGBAColor];
     RGBAColor outlineColor = [outlineColorUI asRGBAColor];
-    pointSize *= BogusFontScale;
+    pointSize = sdf ? SDFPointSize : pointSize * BogusFontScale;
     uiFont = [UIFont fontWithDescriptor:uiFont.fontDescriptor size:pointSize];
     
     for (auto it : fontManagers)
     {
         FontManager_iOSRef fm = std::dynamic_pointer_cast<FontManager_iOS>(it.second);
-        if (fontName == fm->fontName && pointSize == fm->pointSize &&
+        if (fontName == fm->fontName && pointSize == fm->pointSize && sdf == fm->sdf &&
             fm->color == color &&
             fm->backColor == backColor &&
             fm->outlineColor == outlineColor &&
@@ -115,6 +124,12 @@ FontManager_iOSRef FontTextureManager_iOS::findFontManagerForFont(UIFont *uiFont
     fm->outlineColorUI = outlineColorUI;
     fm->outlineSize = outlineSize;
     //    fm->outlineSize *= BogusFontScale;
+    fm->sdf = sdf;
+    if (glyphCache)
+    {
+        fm->cacheKey = GlyphCache::fontKey(sdf ? fontName + "#sdf" : fontName,pointSize,
+                                           color,backColor,outlineColor,outlineSize);
+    }
     fontManagers[fm->getId()] = fm;
 
     return fm;
@@ -216,12 +231,48 @@ NSData *FontTextureManager_iOS::renderGlyph(CGGlyph glyph, const FontManager_iOS
     return retData;
 }
 
+// Identify a string by its text and whatever in its attributes changes the glyphs
+static std::string LayoutKey(NSAttributedString *str,bool sdfMode)
+{
+    NSMutableString *key = [NSMutableString stringWithFormat:@"%d|%@",(int)sdfMode,str.string];
+    [str enumerateAttributesInRange:NSMakeRange(0,str.length) options:0 usingBlock:
+     ^(NSDictionary<NSAttributedStringKey,id> *attrs, NSRange range, BOOL *stop)
+    {
+        UIFont *font = attrs[NSFontAttributeName];
+        NSNumber *outlineSize = attrs[kOutlineAttributeSize];
+        [key appendFormat:@"|%d,%d:%@,%f,%x,%x,%x,%f",(int)range.location,(int)range.length,
+            [font isKindOfClass:[UIFont class]] ? font.fontName : @"",
+            [font isKindOfClass:[UIFont class]] ? font.pointSize : 0.0,
+            [attrs[NSForegroundColorAttributeName] asRGBAColor].asInt(),
+            [attrs[NSBackgroundColorAttributeName] asRGBAColor].asInt(),
+            [attrs[kOutlineAttributeColor] asRGBAColor].asInt(),
+            [outlineSize floatValue]];
+    }];
+    const char *utf8 = [key UTF8String];
+    return utf8 ? std::string(utf8) : std::string();
+}
+
 /// Add the given string.  Caller is responsible for deleting the DrawableString
 std::unique_ptr<DrawableString> FontTextureManager_iOS::addString(
         PlatformThreadInfo *, NSAttributedString *str, ChangeSet &changes)
 {
+    std::unique_lock<std::mutex> guardLock(lock);
+
+    const bool sdfEnabled = sdfMode;
+    const std::string layoutKey = LayoutKey(str,sdfEnabled);
+
+    // Seen this one before, so no need to shape it or look up glyphs
+    if (auto drawString = findLayout(layoutKey))
+    {
+        return drawString;
+    }
+
+    // Shaping doesn't touch anything of ours
+    guardLock.unlock();
+
     auto drawString = std::make_unique<DrawableString>();
     auto drawStringRep = std::make_unique<DrawStringRep>(drawString->getId());
+    LayoutGlyphs layoutGlyphs;
 
     // Convert to runs of glyphs
     CTLineRef line = CTLineCreateWithAttributedString((__bridge CFAttributedStringRef)str);
@@ -234,122 +285,150 @@ std::unique_ptr<DrawableString> FontTextureManager_iOS::addString(
 
     drawString->mbr.reset();
 
-    // We could make this more granular
-    std::lock_guard<std::mutex> guardLock(lock);
-    
+    // The string is drawn with one shader, so it's all distance fields or none.
+    // Outlines and backgrounds are baked into the glyphs, so those stay as they are.
+    drawString->sdf = sdfEnabled;
+    for (unsigned int ii=0;ii<CFArrayGetCount(runs) && drawString->sdf;ii++)
+    {
+        NSDictionary *attrs = (__bridge NSDictionary*)CTRunGetAttributes((CTRunRef)CFArrayGetValueAtIndex(runs,ii));
+        UIColor *backgroundColor = attrs[NSBackgroundColorAttributeName];
+        if ((attrs[kOutlineAttributeColor] && attrs[kOutlineAttributeSize]) ||
+            (backgroundColor && [backgroundColor asRGBAColor].a != 0))
+            drawString->sdf = false;
+    }
+
+    std::vector<GlyphRun> glyphRuns(CFArrayGetCount(runs));
+    for (unsigned int ii=0;ii<glyphRuns.size();ii++)
+    {
+        CTRunRef run = (CTRunRef)CFArrayGetValueAtIndex(runs,ii);
+        GlyphRun &glyphRun = glyphRuns[ii];
+        const CFIndex num = CTRunGetGlyphCount(run);
+        if (num <= 0)
+            continue;
+
+        glyphRun.glyphs.resize(num);
+        glyphRun.offsets.resize(num);
+        const CFRange range = CFRangeMake(0,num);
+        CTRunGetGlyphs(run,range,&glyphRun.glyphs[0]);
+        CTRunGetPositions(run,range,&glyphRun.offsets[0]);
+
+        // Need the font manager for this run
+        NSDictionary *attrs = (__bridge NSDictionary*)CTRunGetAttributes(run);
+        glyphRun.font = attrs[NSFontAttributeName];
+
+        // And outline parameters, if they exist
+        UIColor *outlineColor = attrs[kOutlineAttributeColor];
+        NSNumber *outlineSize = attrs[kOutlineAttributeSize];
+        if (outlineSize && outlineColor)
+        {
+            glyphRun.outlineColor = outlineColor;
+            glyphRun.outlineSize = [outlineSize floatValue];
+        }
+        glyphRun.foregroundColor = attrs[NSForegroundColorAttributeName];
+        glyphRun.backgroundColor = attrs[NSBackgroundColorAttributeName];
+    }
+    CFRelease(line);
+
+    // See which glyphs we don't have yet
+    guardLock.lock();
+    for (auto &glyphRun : glyphRuns)
+    {
+        if (glyphRun.glyphs.empty() || ![glyphRun.font isKindOfClass:[UIFont class]])
+            continue;
+        glyphRun.fm = findFontManagerForFont(glyphRun.font,glyphRun.foregroundColor,glyphRun.backgroundColor,
+                                             glyphRun.outlineColor,glyphRun.outlineSize,drawString->sdf);
+        for (const CGGlyph glyph : glyphRun.glyphs)
+        {
+            if (!glyphRun.fm->findGlyph(glyph))
+                glyphRun.staged[glyph];
+        }
+    }
+    guardLock.unlock();
+
+    // Render those without the lock, so other threads can get at the atlas meanwhile.
+    // The font managers are held by the runs, so they stay put even if they're dropped.
+    for (auto &glyphRun : glyphRuns)
+    {
+        for (auto &staged : glyphRun.staged)
+        {
+            stageGlyph(staged.first,glyphRun.fm,staged.second);
+        }
+    }
+
+    guardLock.lock();
+
     if (!texAtlas)
     {
         // Let's do the biggest possible texture with small cells 32 bits deep
         texAtlas = new DynamicTextureAtlas("Font Texture Atlas",2048,16,TexTypeUnsignedByte);
     }
 
-    for (unsigned int ii=0;ii<CFArrayGetCount(runs);ii++)
+    for (auto &glyphRun : glyphRuns)
     {
-        CTRunRef run = (CTRunRef)CFArrayGetValueAtIndex(runs,ii);
-        CFIndex num = CTRunGetGlyphCount(run);
-        if (num > 0)
+        if (!glyphRun.fm)
+            continue;
+
+        // Look again, the one we had may have gone away while we were rendering
+        const FontManager_iOSRef fm = findFontManagerForFont(glyphRun.font,glyphRun.foregroundColor,glyphRun.backgroundColor,
+                                                             glyphRun.outlineColor,glyphRun.outlineSize,drawString->sdf);
+        if (!fm)
+            continue;
+
+        GlyphSet glyphsUsed;
+
+        // Work through the individual glyphs
+        for (unsigned int jj=0;jj<glyphRun.glyphs.size();jj++)
         {
-            //CGGlyph *glyphs = (CGGlyph *)malloc(sizeof(CGGlyph)*num);
-            //CGPoint *offsets = (CGPoint *)malloc(sizeof(CGPoint)*num);
-            // manage memory automatically
-            std::vector<CGGlyph> glyphs(num);
-            std::vector<CGPoint> offsets(num);
-            CFRange range;
-            range.location = 0;
-            range.length = num;
-            CTRunGetGlyphs(run,range,&glyphs[0]);
-            CTRunGetPositions(run,range,&offsets[0]);
-            
-            // Need the font manager for this run
-            NSDictionary *attrs = (__bridge NSDictionary*)CTRunGetAttributes(run);
-            UIFont *uiFont = attrs[NSFontAttributeName];
-            
-            // And outline parameters, if they exist
-            UIColor *outlineColor = attrs[kOutlineAttributeColor];
-            NSNumber *outlineSize = attrs[kOutlineAttributeSize];
-            if (!outlineSize || !outlineColor)
+            const CGGlyph glyph = glyphRun.glyphs[jj];
+            // Look for an existing one, which another thread may have added since
+            FontManager::GlyphInfo *glyphInfo = fm->findGlyph(glyph);
+            if (!glyphInfo)
             {
-                outlineSize = nil;
-                outlineColor = nil;
-            }
-            UIColor *foregroundColor = attrs[NSForegroundColorAttributeName];
-            UIColor *backgroundColor = attrs[NSBackgroundColorAttributeName];
-            
-            FontManager_iOSRef fm;
-            if ([uiFont isKindOfClass:[UIFont class]])
-                fm = findFontManagerForFont(uiFont,foregroundColor,backgroundColor,outlineColor,[outlineSize floatValue]);
-            if (!fm)
-                continue;
-            
-            GlyphSet glyphsUsed;
-            
-            // Work through the individual glyphs
-            for (unsigned int jj=0;jj<num;jj++)
-            {
-                const CGGlyph glyph = glyphs[jj];
-                // Look for an existing one
-                FontManager::GlyphInfo *glyphInfo = fm->findGlyph(glyph);
-                if (!glyphInfo)
-                {
-                    // We need to render that Glyph and add it
-                    Point2f texSize,glyphSize;
-                    Point2f offset,textureOffset;
-                    if (NSData *glyphImage = renderGlyph(glyph, fm, texSize, glyphSize, offset, textureOffset))
-                    {
-                        RawDataRef glyphImageWrap = std::make_shared<RawNSDataReader>(glyphImage);
-
-                        TextureMTL tex("Font Texture Manager",glyphImageWrap,false);
-                        tex.setWidth(texSize.x());
-                        tex.setHeight(texSize.y());
-
-                        SubTexture subTex;
-                        const Point2f realSize(glyphSize.x()+2*textureOffset.x(),glyphSize.y()+2*textureOffset.y());
-
-                        std::vector<Texture *> texs = { &tex };
-                        if (texAtlas->addTexture(sceneRender, texs, -1, &realSize, nullptr, subTex, changes, 0, 1))
-                        {
-                            glyphInfo = fm->addGlyph(glyph, subTex, glyphSize.cast<float>(), offset, textureOffset);
-                        }
-                    }
-                }
-                
-                if (glyphInfo)
+                auto stagedIt = glyphRun.staged.find(glyph);
+                if (stagedIt == glyphRun.staged.end())
                 {
-                    // Now we make a rectangle that covers the glyph in its texture atlas
-                    const CGPoint &offset = offsets[jj];
-                    const float scale = 1.0/BogusFontScale;
-                    
-                    drawString->glyphPolys.emplace_back();
-                    auto &rect = drawString->glyphPolys.back();
-
-                    // Note: was -1,-1
-                    rect.pts[0] = Point2f(glyphInfo->offset.x()*scale-glyphInfo->textureOffset.x()*scale,
-                                          glyphInfo->offset.y()*scale-glyphInfo->textureOffset.y()*scale)+Point2f(offset.x,offset.y);
-                    rect.texCoords[0] = TexCoord(0.0,0.0);
-                    // Note: was 2,2
-                    rect.pts[1] = Point2f(glyphInfo->size.x()*scale+2*glyphInfo->textureOffset.x()*scale,
-                                          glyphInfo->size.y()*scale+2*glyphInfo->textureOffset.y()*scale)+rect.pts[0];
-                    rect.texCoords[1] = TexCoord(1.0,1.0);
-                    rect.subTex = glyphInfo->subTex;
-
-                    drawString->mbr.addPoint(rect.pts[0]);
-                    drawString->mbr.addPoint(rect.pts[1]);
-
-                    glyphsUsed.insert(glyphInfo->glyph);
+                    // Dropped since we looked, so render it here
+                    stagedIt = glyphRun.staged.emplace(glyph,StagedGlyph()).first;
+                    stageGlyph(glyph,fm,stagedIt->second);
                 }
+                glyphInfo = addStagedGlyph(glyph,fm,stagedIt->second,changes);
+            }
+
+            if (glyphInfo)
+            {
+                // Now we make a rectangle that covers the glyph in its texture atlas
+                const CGPoint &offset = glyphRun.offsets[jj];
+                const float scale = fm->sdf ? glyphRun.font.pointSize / SDFPointSize : 1.0/BogusFontScale;
+
+                drawString->glyphPolys.emplace_back();
+                auto &rect = drawString->glyphPolys.back();
+
+                // Note: was -1,-1
+                rect.pts[0] = Point2f(glyphInfo->offset.x()*scale-glyphInfo->textureOffset.x()*scale,
+                                      glyphInfo->offset.y()*scale-glyphInfo->textureOffset.y()*scale)+Point2f(offset.x,offset.y);
+                rect.texCoords[0] = TexCoord(0.0,0.0);
+                // Note: was 2,2
+                rect.pts[1] = Point2f(glyphInfo->size.x()*scale+2*glyphInfo->textureOffset.x()*scale,
+                                      glyphInfo->size.y()*scale+2*glyphInfo->textureOffset.y()*scale)+rect.pts[0];
+                rect.texCoords[1] = TexCoord(1.0,1.0);
+                rect.subTex = glyphInfo->subTex;
+
+                drawString->mbr.addPoint(rect.pts[0]);
+                drawString->mbr.addPoint(rect.pts[1]);
+
+                glyphsUsed.insert(glyphInfo->glyph);
+                layoutGlyphs.emplace_back(fm->getId(),glyphInfo->glyph);
             }
-            
-            // Keep track of the glyphs we're using
-            drawStringRep->addGlyphs(fm->getId(),glyphsUsed);
-            fm->addGlyphRefs(glyphsUsed);
         }
+
+        // Keep track of the glyphs we're using
+        drawStringRep->addGlyphs(fm->getId(),glyphsUsed);
+        fm->addGlyphRefs(glyphsUsed);
     }
-    
+
     // Need the extents for the whole line
     //    drawString->mbr.ll() = Point2f(0,-descent);
     //    drawString->mbr.ur() = Point2f(lineWidth,ascent);
-    
-    CFRelease(line);
 
     // If it didn't produce anything, just delete it now
     if (drawString->glyphPolys.empty())
@@ -360,9 +439,83 @@ std::unique_ptr<DrawableString> FontTextureManager_iOS::addString(
     else if (drawStringRep)
     {
         drawStringReps.insert(drawStringRep.release());
+        addLayout(layoutKey,*drawString,std::move(layoutGlyphs));
     }
 
     return drawString;
 }
 
+bool FontTextureManager_iOS::warmUp(PlatformThreadInfo *inst,NSAttributedString *str,
+                                    std::vector<SimpleIdentity> &strIDs,ChangeSet &changes)
+{
+    // Held as a string like any other, so the glyphs stay until it's removed
+    if (auto drawString = addString(inst,str,changes))
+    {
+        strIDs.push_back(drawString->getId());
+        return true;
+    }
+    return false;
+}
+
+void FontTextureManager_iOS::stageGlyph(CGGlyph glyph,const FontManager_iOSRef &fm,StagedGlyph &staged)
+{
+    GlyphCache::Glyph cached;
+    const bool useCache = glyphCache && !fm->cacheKey.empty();
+    if (useCache && glyphCache->findGlyph(fm->cacheKey, glyph, cached))
+    {
+        staged.image = [NSData dataWithBytes:cached.pixels.data() length:cached.pixels.size()];
+        staged.texSize = Point2f(cached.sizeX, cached.sizeY);
+        staged.glyphSize = Point2f(cached.glyphSizeX, cached.glyphSizeY);
+        staged.offset = Point2f(cached.offsetX, cached.offsetY);
+        staged.textureOffset = Point2f(cached.textureOffsetX, cached.textureOffsetY);
+        return;
+    }
+
+    staged.image = renderGlyph(glyph, fm, staged.texSize, staged.glyphSize, staged.offset, staged.textureOffset);
+    if (staged.image && fm->sdf)
+    {
+        std::vector<unsigned char> sdfPixels;
+        int sdfWidth = 0, sdfHeight = 0;
+        makeSDFGlyph((const unsigned char *)[staged.image bytes], (int)staged.texSize.x(), (int)staged.texSize.y(),
+                     sdfPixels, sdfWidth, sdfHeight);
+        staged.image = [NSData dataWithBytes:sdfPixels.data() length:sdfPixels.size()];
+        staged.texSize = Point2f(sdfWidth, sdfHeight);
+        staged.textureOffset += Point2f(SDFRadius, SDFRadius);
+    }
+    if (staged.image && useCache)
+    {
+        cached.width = (int)staged.texSize.x();
+        cached.height = (int)staged.texSize.y();
+        cached.sizeX = staged.texSize.x();  cached.sizeY = staged.texSize.y();
+        cached.glyphSizeX = staged.glyphSize.x();  cached.glyphSizeY = staged.glyphSize.y();
+        cached.offsetX = staged.offset.x();  cached.offsetY = staged.offset.y();
+        cached.textureOffsetX = staged.textureOffset.x();  cached.textureOffsetY = staged.textureOffset.y();
+        const auto *bytes = (const unsigned char *)[staged.image bytes];
+        cached.pixels.assign(bytes, bytes + [staged.image length]);
+        glyphCache->addGlyph(fm->cacheKey, glyph, cached);
+    }
+}
+
+FontManager::GlyphInfo *FontTextureManager_iOS::addStagedGlyph(CGGlyph glyph,const FontManager_iOSRef &fm,
+                                                              const StagedGlyph &staged,ChangeSet &changes)
+{
+    if (!staged.image)
+        return nullptr;
+
+    RawDataRef glyphImageWrap = std::make_shared<RawNSDataReader>(staged.image);
+
+    TextureMTL tex("Font Texture Manager",glyphImageWrap,false);
+    tex.setWidth(staged.texSize.x());
+    tex.setHeight(staged.texSize.y());
+
+    SubTexture subTex;
+    const Point2f realSize(staged.glyphSize.x()+2*staged.textureOffset.x(),staged.glyphSize.y()+2*staged.textureOffset.y());
+
+    std::vector<Texture *> texs = { &tex };
+    if (!texAtlas->addTexture(sceneRender, texs, -1, &realSize, nullptr, subTex, changes, 0, 1))
+        return nullptr;
+
+    return fm->addGlyph(glyph, subTex, staged.glyphSize.cast<float>(), staged.offset, staged.textureOffset);
+}
+
 }
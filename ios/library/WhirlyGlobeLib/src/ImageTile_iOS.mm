@@ -18,14 +18,74 @@
  *
  */
 
+#import <ImageIO/ImageIO.h>
 #import "ImageTile_iOS.h"
 #import "RawData_NSData.h"
 #import "UIImage+Stuff.h"
 #import "TextureMTL.h"
+#import "DecodeBufferPool.h"
 
 namespace WhirlyKit
 {
-    
+
+// Decode PNG, JPEG, HEIC and such with ImageIO, which uses the hardware decoders
+//  where it has them.  Big images are scaled down during the decode if there's a max size.
+static CGImageRef CreateDecodedImage(NSData *data,int maxSize)
+{
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)data, nullptr);
+    if (!source)
+        return nullptr;
+
+    // Just reads the header
+    bool scaleDown = false;
+    if (maxSize > 0)
+    {
+        if (NSDictionary *props = (__bridge_transfer NSDictionary *)CGImageSourceCopyPropertiesAtIndex(source, 0, nullptr))
+        {
+            const int imageWidth = [props[(id)kCGImagePropertyPixelWidth] intValue];
+            const int imageHeight = [props[(id)kCGImagePropertyPixelHeight] intValue];
+            scaleDown = std::max(imageWidth,imageHeight) > maxSize;
+        }
+    }
+
+    CGImageRef image = nullptr;
+    if (scaleDown)
+    {
+        NSDictionary *opts = @{ (id)kCGImageSourceCreateThumbnailFromImageAlways: @YES,
+                                (id)kCGImageSourceThumbnailMaxPixelSize: @(maxSize),
+                                (id)kCGImageSourceShouldCacheImmediately: @YES };
+        image = CGImageSourceCreateThumbnailAtIndex(source, 0, (__bridge CFDictionaryRef)opts);
+    }
+    else
+    {
+        NSDictionary *opts = @{ (id)kCGImageSourceShouldCacheImmediately: @YES };
+        image = CGImageSourceCreateImageAtIndex(source, 0, (__bridge CFDictionaryRef)opts);
+    }
+    CFRelease(source);
+
+    return image;
+}
+
+// Draw a decoded image into one of the pooled buffers
+static RawDataRef RenderToPooledBuffer(CGImageRef image,int destWidth,int destHeight)
+{
+    unsigned char *bytes = nullptr;
+    RawDataRef rawData = DecodeBufferPool::getShared().getBuffer((size_t)destWidth * destHeight * 4,&bytes);
+
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(bytes, destWidth, destHeight, 8, destWidth * 4, colorSpace, kCGImageAlphaPremultipliedLast);
+    CGColorSpaceRelease(colorSpace);
+    if (!context)
+        return nullptr;
+
+    // The buffer has whatever the last tile left in it
+    CGContextSetBlendMode(context, kCGBlendModeCopy);
+    CGContextDrawImage(context, CGRectMake(0, 0, destWidth, destHeight), image);
+    CGContextRelease(context);
+
+    return rawData;
+}
+
 ImageTile_iOS::ImageTile_iOS(SceneRenderer::Type renderType)
 : renderType(renderType), imageStuff(nil), tex(NULL)
 {
@@ -34,6 +94,10 @@ ImageTile_iOS::ImageTile_iOS(SceneRenderer::Type renderType)
 ImageTile_iOS::~ImageTile_iOS()
 {
     imageStuff = nil;
+
+    // Built ahead of time and never picked up
+    delete tex;
+    tex = NULL;
 }
     
 void ImageTile_iOS::clearTexture()
@@ -94,31 +158,33 @@ Texture *ImageTile_iOS::buildTexture()
             break;
         case MaplyImgTypeDataUIKitRecognized:
         {
-            UIImage *texImage = [UIImage imageWithData:(NSData *)imageStuff];
+            CGImageRef texImage = CreateDecodedImage((NSData *)imageStuff,maxDecodeSize);
             if (!texImage)
                 return nullptr;
             if (destWidth <= 0)
-                destWidth = (int)CGImageGetWidth(texImage.CGImage);
+                destWidth = (int)CGImageGetWidth(texImage);
             if (destHeight <= 0)
-                destHeight = (int)CGImageGetHeight(texImage.CGImage);
+                destHeight = (int)CGImageGetHeight(texImage);
 
-            if (NSData *rawData = [texImage rawDataScaleWidth:destWidth height:destHeight border:0])
-            {
-                tex = new TextureMTL("ImageTile_iOS",RawDataRef(new RawNSDataReader(rawData)),false);
-                tex->setWidth(destWidth);
-                tex->setHeight(destHeight);
-            }
-            else
-            {
+            RawDataRef rawData = RenderToPooledBuffer(texImage,destWidth,destHeight);
+            CGImageRelease(texImage);
+            if (!rawData)
                 return nullptr;
-            }
+
+            tex = new TextureMTL("ImageTile_iOS",rawData,false);
+            tex->setWidth(destWidth);
+            tex->setHeight(destHeight);
         }
             break;
         case MaplyImgTypeDataPKM:
+        case MaplyImgTypeDataCompressed:
+            // Size comes from the header
             tex = new TextureMTL("ImageTile_iOS");
-            tex->setPKMData(RawDataRef(new RawNSDataReader((NSData *)imageStuff)));
-            tex->setWidth(destWidth);
-            tex->setHeight(destHeight);
+            if (!tex->setCompressedData(std::make_shared<RawNSDataReader>((NSData *)imageStuff)))
+            {
+                delete tex;
+                tex = nullptr;
+            }
             break;
         case MaplyImgTypeDataPVRTC4:
             tex = new TextureMTL("ImageTile_iOS", RawDataRef(new RawNSDataReader((NSData *)imageStuff)),true);
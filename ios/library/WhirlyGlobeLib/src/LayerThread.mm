@@ -24,6 +24,7 @@
 #import "Platform.h"
 #import "SceneRendererMTL.h"
 #import "WhirlyKitLog.h"
+#import "TaskScheduler.h"
 
 using namespace WhirlyKit;
 
@@ -69,6 +70,9 @@ using namespace WhirlyKit;
         threadsToShutdown = [NSMutableArray array];
         
         _allowFlush = true;
+
+        // Our work ends up on screen, so it shouldn't wait behind background work
+        self.qualityOfService = NSQualityOfServiceUserInitiated;
         
         pauseLock = [[NSCondition alloc] init];
 	}
@@ -215,6 +219,9 @@ using namespace WhirlyKit;
         changesToProcess = std::move(changeRequests);
     }
 
+    // Toss anything redundant before we spend time setting it up
+    compactChanges(changesToProcess);
+
     bool requiresFlush = false;
     // Set up anything that needs to be set up
     ChangeSet changesToAdd;
@@ -246,6 +253,26 @@ using namespace WhirlyKit;
     _scene->addChangeRequests(changesToAdd);
 }
 
+- (void)addWorkerTask:(double)priority block:(dispatch_block_t)block
+{
+    if (!block || self.isCancelled)
+        return;
+
+    auto &scheduler = TaskScheduler::getShared();
+    if (scheduler.getNumThreads() > 0)
+    {
+        scheduler.addTask(priority, nullptr, [block](bool) {
+            @autoreleasepool {
+                block();
+            }
+        });
+        return;
+    }
+
+    const auto qos = (priority > 0.0) ? QOS_CLASS_USER_INITIATED : QOS_CLASS_UTILITY;
+    dispatch_async(dispatch_get_global_queue(qos, 0), block);
+}
+
 - (void)log
 {
     if ([NSThread currentThread] != self)
@@ -47,6 +47,8 @@ using namespace WhirlyKit;
     Point3d lastEyePos;
     float minDist;
     TimeInterval lastUpdated;
+    /// How long the watcher's been taking to handle an update, smoothed
+    TimeInterval latency;
 }
 @end
 
@@ -103,7 +105,7 @@ public:
         layerThread = inLayerThread;
         view = inView;
         watchers = [NSMutableArray array];
-        lastViewState = inView->makeViewState(inLayerThread.renderer);
+        lastViewState = inView->getViewState(inLayerThread.renderer);
         viewWatchWrapper.viewWatcher = self;
         inView->addWatcher(&viewWatchWrapper);
     }
@@ -134,7 +136,7 @@ public:
         const auto __strong thread = layerThread;
         if (thread.renderer->getFramebufferSize().x() != 0)
         {
-            lastViewState = view->makeViewState(thread.renderer);
+            lastViewState = view->getViewState(thread.renderer);
         }
     }
     
@@ -197,7 +199,7 @@ public:
         return;
     }
 
-    ViewStateRef viewState = view->makeViewState(thread.renderer);
+    ViewStateRef viewState = view->getViewState(thread.renderer);
     
     //    lastViewState = viewState;
     @synchronized(self)
@@ -235,6 +237,7 @@ public:
 // Called in the layer thread
 - (void)updateSingleWatcher:(LocalWatcher *)watch
 {
+    ViewStateRef viewState;
     @synchronized(self)
     {
         // Make sure the thing we're watching is still valid.
@@ -244,16 +247,25 @@ public:
             //        NSLog(@"Whoa! Tried to call a watcher that's no longer there.");
             return;
         }
+
+        // The view may have moved on while the watchers before this one ran.
+        // The kickoff that's coming will find this one already up to date.
+        if (newViewState)
+            lastViewState = newViewState;
+        viewState = lastViewState;
     }
     
-    if (lastViewState)
+    if (viewState)
     {
+        const TimeInterval startTime = layerThread.scene->getCurrentTime();
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Warc-performSelector-leaks"
-        [watch->target performSelector:watch->selector withObject:[[WhirlyKitViewStateWrapper alloc] initWithViewState:lastViewState]];
+        [watch->target performSelector:watch->selector withObject:[[WhirlyKitViewStateWrapper alloc] initWithViewState:viewState]];
 #pragma clang diagnostic pop
         watch->lastUpdated = layerThread.scene->getCurrentTime();
-        watch->lastEyePos = lastViewState->eyePos;
+        watch->lastEyePos = viewState->eyePos;
+        watch->latency = (watch->latency == 0.0) ? (watch->lastUpdated - startTime) :
+                             0.75 * watch->latency + 0.25 * (watch->lastUpdated - startTime);
     } else
         NSLog(@"Missing last view state");
 }
@@ -283,8 +295,11 @@ public:
     {
         for (LocalWatcher *watch in watchers)
         {
+            // A watcher that takes longer than its minimum to handle an update
+            // gets them as often as it can keep up with, rather than one per view
+            const TimeInterval minTime = std::max(watch->minTime,watch->latency);
             TimeInterval minTest = curTime - watch->lastUpdated;
-            if (minTest > watch->minTime)
+            if (minTest > minTime)
             {
                 bool runUpdate = false;
                 
@@ -308,7 +323,7 @@ public:
                 if (runUpdate)
                     orderedLayers.insert(LayerPriorityOrder(minTest,watch));
             } else {
-                minNextUpdate = MIN(minNextUpdate,minTest);
+                minNextUpdate = MIN(minNextUpdate,minTime - minTest);
             }
             maxLayerDelay = MAX(maxLayerDelay,minTest);
         }
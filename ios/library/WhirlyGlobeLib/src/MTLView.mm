@@ -71,6 +71,9 @@ using namespace WhirlyKit;
 
     self->renderer = inRenderer;
     self->renderer->setScale(self.contentScaleFactor);
+    // The pacer starts from what we asked for, within what the screen can do
+    const NSInteger maxRate = MIN(self.preferredFramesPerSecond, UIScreen.mainScreen.maximumFramesPerSecond);
+    self->renderer->getFramePacer().setDisplayRate((int)maxRate);
 
     renderMTL->setup(self.frame.size.width, self.frame.size.height,false);
 }
@@ -114,7 +117,14 @@ using namespace WhirlyKit;
     if (animating) {
         renderMTL->getView()->animate();
 
-        if (renderMTL->hasChanges()) {
+        const bool renderFrame = renderMTL->shouldRenderFrame();
+
+        // Slow the display link down when there's not much going on
+        const NSInteger rate = renderMTL->getFramePacer().getPreferredRate(TimeGetCurrent());
+        if (rate != self.preferredFramesPerSecond)
+            self.preferredFramesPerSecond = rate;
+
+        if (renderFrame) {
             renderMTL->updateZoomSlots();
 
             MTLRenderPassDescriptor *renderPassDesc = self.currentRenderPassDescriptor;
@@ -30,6 +30,13 @@ ProgramMTL::ProgramMTL(const std::string &inName,id<MTLFunction> vertFunc,id<MTL
     : vertFunc(vertFunc), fragFunc(fragFunc), lightsLastUpdated(0.0), valid(true)
 {
     name = inName;
+
+    // The default shaders that go through drawablePosition()
+    static NSSet<NSString *> *mvMatrixFuncs = [NSSet setWithArray:@[
+        @"vertexLineOnly_flat", @"vertexTri_noLight", @"vertexTri_noLightExp",
+        @"vertexTri_light", @"vertexTri_lightExp", @"vertexTri_id", @"vertexTri_multiTex",
+        @"vertexTri_composite", @"vertexTri_terrain", @"vertexTri_multiTex_nightDay" ]];
+    usesMvMatrix = vertFunc.name && [mvMatrixFuncs containsObject:vertFunc.name];
 }
 
 bool ProgramMTL::isValid() const
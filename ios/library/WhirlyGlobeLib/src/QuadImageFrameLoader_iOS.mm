@@ -113,6 +113,12 @@ void QIFFrameAsset_ios::loadSkipped()
     QIFFrameAsset::loadSkipped();
     request = nil;
 }
+
+void QIFFrameAsset_ios::loadUnchanged(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader)
+{
+    QIFFrameAsset::loadUnchanged(threadInfo,loader);
+    request = nil;
+}
     
 QIFTileAsset_ios::QIFTileAsset_ios(const QuadTreeNew::ImportantNode &ident)
 : QIFTileAsset(ident)
@@ -249,6 +255,61 @@ void QuadImageFrameLoader_ios::processBatchOps(PlatformThreadInfo *threadInfo,QI
     batchOps->toCancel = nil;
     batchOps->toStart = nil;
 }
+
+void QuadImageFrameLoader_ios::prefetchTiles(PlatformThreadInfo *threadInfo,const std::vector<QuadTreeNew::ImportantNode> &inTiles)
+{
+    if (!tileFetcher || !frameInfos)
+        return;
+
+    // Anything we were fetching ahead that's no longer where we're going can stop
+    NSMutableDictionary<NSNumber *,NSArray *> *newRequests = [[NSMutableDictionary alloc] init];
+    NSMutableArray *toStart = [[NSMutableArray alloc] init];
+    const int priority = getPrefetchPriority();
+    for (const auto &ident : inTiles) {
+        NSNumber *key = @(ident.NodeNumber());
+        if (NSArray *existing = prefetchRequests[key]) {
+            newRequests[key] = existing;
+            [prefetchRequests removeObjectForKey:key];
+            continue;
+        }
+
+        MaplyTileID tileID;  tileID.level = ident.level;  tileID.x = ident.x;  tileID.y = ident.y;
+        NSMutableArray *requests = [[NSMutableArray alloc] init];
+        for (NSObject<MaplyTileInfoNew> *frameInfo in frameInfos) {
+            if (tileID.level < frameInfo.minZoom || tileID.level > frameInfo.maxZoom)
+                continue;
+            id fetchInfo = [frameInfo fetchInfoForTile:tileID flipY:getFlipY()];
+            // Nothing to fetch if the interpreter does all the work
+            if (!fetchInfo || [fetchInfo isKindOfClass:[NSNull class]])
+                continue;
+
+            // The fetcher caches the data, that's all we're after
+            MaplyTileFetchRequest *request = [[MaplyTileFetchRequest alloc] init];
+            request.tileID = tileID;
+            request.fetchInfo = fetchInfo;
+            request.tileSource = frameInfo;
+            request.priority = priority;
+            request.importance = ident.importance;
+            request.success = ^(MaplyTileFetchRequest *request, id data) { };
+            request.failure = ^(MaplyTileFetchRequest *request, NSError *error) { };
+            [requests addObject:request];
+        }
+        if ([requests count] > 0) {
+            newRequests[key] = requests;
+            [toStart addObjectsFromArray:requests];
+        }
+    }
+
+    NSMutableArray *toCancel = [[NSMutableArray alloc] init];
+    for (NSArray *requests in [prefetchRequests allValues])
+        [toCancel addObjectsFromArray:requests];
+    if ([toCancel count] > 0)
+        [tileFetcher cancelTileFetches:toCancel];
+    if ([toStart count] > 0)
+        [tileFetcher startTileFetches:toStart];
+
+    prefetchRequests = newRequests;
+}
     
 // Change the tile sources for upcoming loads
 void QuadImageFrameLoader_ios::setTileInfos(NSArray<NSObject<MaplyTileInfoNew> *> *tileInfos)
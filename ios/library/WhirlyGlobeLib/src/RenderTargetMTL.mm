@@ -126,7 +126,7 @@ RawDataRef RenderTargetMTL::snapshot(int startX,int startY,int snapWidth,int sna
     
     NSMutableData *data = [[NSMutableData alloc] initWithLength:snapWidth*snapHeight*pixSize];
 #if !TARGET_OS_SIMULATOR
-    [tex getBytes:[data mutableBytes] bytesPerRow:width*pixSize fromRegion:region mipmapLevel:0];
+    [tex getBytes:[data mutableBytes] bytesPerRow:snapWidth*pixSize fromRegion:region mipmapLevel:0];
 #endif
     
     return RawDataRef(new RawNSDataReader(data));
@@ -148,6 +148,66 @@ RawDataRef RenderTargetMTL::snapshotMinMax()
     return RawDataRef(new RawNSDataReader(data));
 }
 
+id<MTLBuffer> RenderTargetMTL::encodeReadback(id<MTLDevice> mtlDevice,id<MTLBlitCommandEncoder> bltEncode,
+                                              int startX,int startY,int snapWidth,int snapHeight,bool minMax)
+{
+    // The screen's drawable can't be copied from, so there's no tex for that one
+    id<MTLTexture> srcTex = minMax ? minMaxOutTex : tex;
+    if (!srcTex)
+        return nil;
+
+    if (minMax) {
+        startX = 0;  startY = 0;
+        snapWidth = 2;  snapHeight = 1;
+    } else if (snapWidth <= 0 || snapHeight <= 0) {
+        startX = 0;  startY = 0;
+        snapWidth = (int)[srcTex width];  snapHeight = (int)[srcTex height];
+    }
+    if (startX < 0 || startY < 0 || snapWidth <= 0 || snapHeight <= 0 ||
+        startX + snapWidth > [srcTex width] || startY + snapHeight > [srcTex height])
+        return nil;
+
+    const NSUInteger bytesPerRow = snapWidth * calcPixelSize([srcTex pixelFormat]);
+    id<MTLBuffer> buf = [mtlDevice newBufferWithLength:bytesPerRow * snapHeight options:MTLResourceStorageModeShared];
+    [bltEncode copyFromTexture:srcTex
+                   sourceSlice:0
+                   sourceLevel:0
+                  sourceOrigin:MTLOriginMake(startX,startY,0)
+                    sourceSize:MTLSizeMake(snapWidth,snapHeight,1)
+                      toBuffer:buf
+             destinationOffset:0
+        destinationBytesPerRow:bytesPerRow
+      destinationBytesPerImage:bytesPerRow * snapHeight];
+
+    return buf;
+}
+
+id<MTLBuffer> RenderTargetMTL::encodeHistogram(id<MTLDevice> mtlDevice,id<MTLCommandBuffer> cmdBuff,
+                                               int numBins,float minVal,float maxVal)
+{
+    if (!tex || numBins <= 0)
+        return nil;
+
+    const MPSImageHistogramInfo *oldInfo = histKernel ? &histKernel.histogramInfo : nullptr;
+    if (!oldInfo || oldInfo->numberOfHistogramEntries != numBins ||
+        oldInfo->minPixelValue.x != minVal || oldInfo->maxPixelValue.x != maxVal) {
+        MPSImageHistogramInfo info;
+        info.numberOfHistogramEntries = numBins;
+        info.histogramForAlpha = false;
+        info.minPixelValue = vector_float4 { minVal, minVal, minVal, minVal };
+        info.maxPixelValue = vector_float4 { maxVal, maxVal, maxVal, maxVal };
+        histKernel = [[MPSImageHistogram alloc] initWithDevice:mtlDevice histogramInfo:&info];
+    }
+    if (!histKernel)
+        return nil;
+
+    const size_t histSize = [histKernel histogramSizeForSourceFormat:[tex pixelFormat]];
+    id<MTLBuffer> buf = [mtlDevice newBufferWithLength:histSize options:MTLResourceStorageModeShared];
+    [histKernel encodeToCommandBuffer:cmdBuff sourceTexture:tex histogram:buf histogramOffset:0];
+
+    return buf;
+}
+
 void RenderTargetMTL::setTargetTexture(TextureBaseMTL *inTex)
 {
     if (!inTex)
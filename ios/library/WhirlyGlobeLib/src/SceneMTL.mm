@@ -49,12 +49,13 @@ id<MTLTexture> SceneMTL::getMTLTexture(SimpleIdentity texIdent)
 
 void SceneMTL::teardown(PlatformThreadInfo *inst)
 {
-    for (const auto &it : drawables) {
-        if (auto draw = dynamic_cast<DrawableMTL *>(it.second.get())) {
+    for (const auto &drawRef : drawables) {
+        if (auto draw = dynamic_cast<DrawableMTL *>(drawRef.get())) {
             draw->teardownForRenderer((RenderSetupInfoMTL *)setupInfo,this,nullptr);
         }
     }
     drawables.clear();
+    drawableHandles.clear();
     for (auto it : textures) {
         it.second->destroyInRenderer(setupInfo,this);
     }
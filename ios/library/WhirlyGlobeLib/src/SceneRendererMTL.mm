@@ -25,6 +25,7 @@
 #import "RenderTargetMTL.h"
 #import "DynamicTextureAtlasMTL.h"
 #import "MaplyView.h"
+#import "TransformMath.h"
 #import "WhirlyKitLog.h"
 #import "DefaultShadersMTL.h"
 #import "RawData_NSData.h"
@@ -35,6 +36,11 @@ using namespace Eigen;
 namespace WhirlyKit
 {
 
+namespace {
+    // Room for the uniforms and lighting of a few render targets in each frame's slot
+    constexpr size_t FrameBuffSize = 8 * (sizeof(WhirlyKitShader::Uniforms) + sizeof(WhirlyKitShader::Lighting) + 2 * 256);
+}
+
 WorkGroupMTL::WorkGroupMTL(GroupType inGroupType)
 {
     groupType = inGroupType;
@@ -72,10 +78,14 @@ SceneRendererMTL::SceneRendererMTL(id<MTLDevice> mtlDevice,id<MTLLibrary> mtlLib
     cmdQueue([mtlDevice newCommandQueue]),
     _isShuttingDown(std::make_shared<bool>(false)),
     lastRenderNo(0),
-    renderEvent(nil)
+    renderEvent(nil),
+    frameBuffWhich(0),
+    frameBuffUsed(0),
+    pipelineArchiveDirty(false)
 {
     offscreenBlendEnable = false;
     indirectRender = false;
+    gpuCulling = false;
 #if !TARGET_OS_MACCATALYST
     if (@available(iOS 13.0, *)) {
         if ([mtlDevice supportsFeatureSet:MTLFeatureSet_iOS_GPUFamily3_v4])
@@ -86,6 +96,26 @@ SceneRendererMTL::SceneRendererMTL(id<MTLDevice> mtlDevice,id<MTLLibrary> mtlLib
     indirectRender = false;
 #endif
 
+    // The cull pass writes the indirect command buffers, so it's only any use with those
+    if (indirectRender) {
+        if (@available(iOS 13.0, *)) {
+            id<MTLFunction> cullFunc = [mtlLibrary newFunctionWithName:@"cullDrawGroup"];
+            if (cullFunc) {
+                NSError *err = nil;
+                cullPipeline = [mtlDevice newComputePipelineStateWithFunction:cullFunc error:&err];
+                if (cullPipeline) {
+                    cullArgEncoder = [cullFunc newArgumentEncoderWithBufferIndex:WhirlyKitShader::WKSCullCommandArgBuffer];
+                    gpuCulling = true;
+                } else
+                    wkLogLevel(Warn, "SceneRendererMTL: Failed to set up the cull kernel.  Culling on the CPU.");
+            }
+        }
+    }
+
+    // Dynamic resolution scales the map up with these
+    scaleUpVertFunc = [mtlLibrary newFunctionWithName:@"vertexScaleUp"];
+    scaleUpFragFunc = [mtlLibrary newFunctionWithName:@"fragmentScaleUp"];
+
     init();
         
     // Calculation shaders
@@ -101,6 +131,12 @@ SceneRendererMTL::SceneRendererMTL(id<MTLDevice> mtlDevice,id<MTLLibrary> mtlLib
     setupInfo.mtlDevice = mtlDevice;
     setupInfo.uniformBuff = setupInfo.heapManage.allocateBuffer(HeapManagerMTL::Drawable,sizeof(WhirlyKitShader::Uniforms));
     setupInfo.lightingBuff = setupInfo.heapManage.allocateBuffer(HeapManagerMTL::Drawable,sizeof(WhirlyKitShader::Lighting));
+    for (auto &frameBuff : frameBuffs)
+        frameBuff = setupInfo.heapManage.allocateBuffer(HeapManagerMTL::Drawable,FrameBuffSize);
+    // Start at zero and count up, since libdispatch objects to being freed below their starting value
+    frameBuffSema = dispatch_semaphore_create(0);
+    for (int ii=0;ii<NumFrameBuffers;ii++)
+        dispatch_semaphore_signal(frameBuffSema);
     releaseQueue = dispatch_queue_create("Maply release queue", DISPATCH_QUEUE_SERIAL);
 }
     
@@ -202,11 +238,27 @@ bool SceneRendererMTL::resize(int sizeX,int sizeY)
     return true;
 }
 
-void SceneRendererMTL::setupUniformBuffer(RendererFrameInfoMTL *frameInfo,id<MTLBlitCommandEncoder> bltEncode,CoordSystemDisplayAdapter *coordAdapter)
+BufferEntryMTL SceneRendererMTL::allocFrameData(const void *data,size_t size)
+{
+    const size_t align = std::max(setupInfo.memAlign,(size_t)1);
+    const size_t alignSize = (size + align - 1) / align * align;
+
+    const BufferEntryMTL &frameBuff = frameBuffs[frameBuffWhich];
+    if (!frameBuff.buffer || frameBuffUsed + alignSize > FrameBuffSize)
+    {
+        // Lots of render targets, so this one gets its own.  The command buffer holds on to it.
+        return setupInfo.heapManage.allocateBuffer(HeapManagerMTL::Drawable,data,size);
+    }
+
+    BufferEntryMTL entry = frameBuff;
+    entry.offset += frameBuffUsed;
+    memcpy((uint8_t *)[frameBuff.buffer contents] + entry.offset,data,size);
+    frameBuffUsed += alignSize;
+    return entry;
+}
+
+void SceneRendererMTL::fillUniforms(RendererFrameInfoMTL *frameInfo,CoordSystemDisplayAdapter *coordAdapter,WhirlyKitShader::Uniforms &uniforms)
 {
-    SceneRendererMTL *sceneRender = (SceneRendererMTL *)frameInfo->sceneRenderer;
-    
-    WhirlyKitShader::Uniforms uniforms;
     bzero(&uniforms,sizeof(uniforms));
     CopyIntoMtlFloat4x4Pair(uniforms.mvpMatrix,uniforms.mvpMatrixDiff,frameInfo->mvpMat4d);
     CopyIntoMtlFloat4x4(uniforms.mvpInvMatrix,frameInfo->mvpInvMat);
@@ -221,12 +273,51 @@ void SceneRendererMTL::setupUniformBuffer(RendererFrameInfoMTL *frameInfo,id<MTL
     uniforms.globeMode = !coordAdapter->isFlat();
     uniforms.frameCount = frameCount;
     uniforms.currentTime = frameInfo->currentTime - scene->getBaseTime();
-    frameInfo->scene->copyZoomSlots(uniforms.zoomSlots);
+    std::copy(&frameInfo->zoomSlots[0], &frameInfo->zoomSlots[MaplyMaxZoomSlots], uniforms.zoomSlots);
+}
+
+void SceneRendererMTL::setupUniformBuffer(RendererFrameInfoMTL *frameInfo,id<MTLBlitCommandEncoder> bltEncode,CoordSystemDisplayAdapter *coordAdapter)
+{
+    SceneRendererMTL *sceneRender = (SceneRendererMTL *)frameInfo->sceneRenderer;
+    
+    WhirlyKitShader::Uniforms uniforms;
+    fillUniforms(frameInfo,coordAdapter,uniforms);
     
-    // Copy this to a buffer and then blit that buffer into place
-    // TODO: Try to reuse these
-    auto buff = setupInfo.heapManage.allocateBuffer(HeapManagerMTL::HeapType::Drawable, &uniforms, sizeof(uniforms));
-    [bltEncode copyFromBuffer:buff.buffer sourceOffset:buff.offset toBuffer:sceneRender->setupInfo.uniformBuff.buffer destinationOffset:sceneRender->setupInfo.uniformBuff.offset size:sizeof(uniforms)];
+    const BufferEntryMTL buff = allocFrameData(&uniforms, sizeof(uniforms));
+    if (indirectRender) {
+        // Indirect commands have the destination baked in, so it stays put and we copy into it
+        [bltEncode copyFromBuffer:buff.buffer sourceOffset:buff.offset toBuffer:sceneRender->setupInfo.uniformBuff.buffer destinationOffset:sceneRender->setupInfo.uniformBuff.offset size:sizeof(uniforms)];
+    } else {
+        sceneRender->setupInfo.uniformBuff = buff;
+    }
+}
+
+void SceneRendererMTL::setupCopyUniformBuffers(std::vector<RendererFrameInfoMTL> &offFrameInfos,const std::vector<Eigen::Matrix4d> &offsetMats,id<MTLBlitCommandEncoder> bltEncode,CoordSystemDisplayAdapter *coordAdapter)
+{
+    setupInfo.copyUniformBuffs.clear();
+
+    // The main uniforms are for the world without an offset, so that one's already done
+    for (unsigned int off=0;off<offFrameInfos.size() && off<offsetMats.size();off++) {
+        if (offsetMats[off].isIdentity())
+            continue;
+        WhirlyKitShader::Uniforms uniforms;
+        fillUniforms(&offFrameInfos[off],coordAdapter,uniforms);
+        // Offsets only move the world, so drawables' own view matrices just need shifting
+        const Eigen::Vector4d copyOffset = offFrameInfos[off].viewAndModelMat4d.col(3) - drawFrameMats.mv.col(3);
+        CopyIntoMtlFloat3(uniforms.mvCopyOffset,Point3d(copyOffset.head<3>()));
+        const BufferEntryMTL buff = allocFrameData(&uniforms, sizeof(uniforms));
+        if (indirectRender) {
+            // Indirect commands have the destinations baked in, one per copy
+            const size_t which = setupInfo.copyUniformBuffs.size();
+            if (which >= setupInfo.fixedCopyUniformBuffs.size())
+                setupInfo.fixedCopyUniformBuffs.push_back(setupInfo.heapManage.allocateBuffer(HeapManagerMTL::Drawable,sizeof(WhirlyKitShader::Uniforms)));
+            const BufferEntryMTL &fixedBuff = setupInfo.fixedCopyUniformBuffs[which];
+            [bltEncode copyFromBuffer:buff.buffer sourceOffset:buff.offset toBuffer:fixedBuff.buffer destinationOffset:fixedBuff.offset size:sizeof(uniforms)];
+            setupInfo.copyUniformBuffs.push_back(fixedBuff);
+        } else {
+            setupInfo.copyUniformBuffs.push_back(buff);
+        }
+    }
 }
 
 void SceneRendererMTL::setupLightBuffer(SceneMTL *scene,RendererFrameInfoMTL *frameInfo,id<MTLBlitCommandEncoder> bltEncode)
@@ -254,10 +345,12 @@ void SceneRendererMTL::setupLightBuffer(SceneMTL *scene,RendererFrameInfoMTL *fr
     CopyIntoMtlFloat4(lighting.mat.specular,defaultMat.getSpecular());
     lighting.mat.specularExponent = defaultMat.getSpecularExponent();
     
-    // Copy this to a buffer and then blit that buffer into place
-    // TODO: Try to reuse these
-    auto buff = setupInfo.heapManage.allocateBuffer(HeapManagerMTL::HeapType::Drawable, &lighting, sizeof(lighting));
-    [bltEncode copyFromBuffer:buff.buffer sourceOffset:buff.offset toBuffer:sceneRender->setupInfo.lightingBuff.buffer destinationOffset:sceneRender->setupInfo.lightingBuff.offset size:sizeof(lighting)];
+    const BufferEntryMTL buff = allocFrameData(&lighting, sizeof(lighting));
+    if (indirectRender) {
+        [bltEncode copyFromBuffer:buff.buffer sourceOffset:buff.offset toBuffer:sceneRender->setupInfo.lightingBuff.buffer destinationOffset:sceneRender->setupInfo.lightingBuff.offset size:sizeof(lighting)];
+    } else {
+        sceneRender->setupInfo.lightingBuff = buff;
+    }
 }
     
 void SceneRendererMTL::setupDrawStateA(WhirlyKitShader::UniformDrawStateA &drawState)
@@ -297,6 +390,143 @@ MTLRenderPipelineDescriptor *SceneRendererMTL::defaultRenderPipelineState(SceneR
     return renderDesc;
 }
     
+// Everything about a descriptor that changes the pipeline we get back
+static std::string PipelineKey(MTLRenderPipelineDescriptor *renderDesc)
+{
+    std::string key;
+    key.reserve(256);
+    const auto add = [&key](uint64_t val) { key.append((const char *)&val,sizeof(val)); };
+
+    add((uint64_t)(__bridge void *)renderDesc.vertexFunction);
+    add((uint64_t)(__bridge void *)renderDesc.fragmentFunction);
+    add(renderDesc.depthAttachmentPixelFormat);
+    add(renderDesc.stencilAttachmentPixelFormat);
+    add(renderDesc.rasterSampleCount);
+    add(renderDesc.rasterizationEnabled);
+    if (@available(iOS 13.0, *))
+        add(renderDesc.supportIndirectCommandBuffers);
+
+    MTLRenderPipelineColorAttachmentDescriptor *color = renderDesc.colorAttachments[0];
+    add(color.pixelFormat);
+    add(color.blendingEnabled);
+    if (color.blendingEnabled)
+    {
+        add(color.rgbBlendOperation);
+        add(color.alphaBlendOperation);
+        add(color.sourceRGBBlendFactor);
+        add(color.sourceAlphaBlendFactor);
+        add(color.destinationRGBBlendFactor);
+        add(color.destinationAlphaBlendFactor);
+    }
+    add(color.writeMask);
+
+    if (MTLVertexDescriptor *vertDesc = renderDesc.vertexDescriptor)
+    {
+        for (unsigned int ii=0;ii<31;ii++)
+        {
+            MTLVertexAttributeDescriptor *attr = vertDesc.attributes[ii];
+            if (attr.format != MTLVertexFormatInvalid)
+            {
+                add(ii);
+                add(attr.format);
+                add(attr.offset);
+                add(attr.bufferIndex);
+            }
+            MTLVertexBufferLayoutDescriptor *layout = vertDesc.layouts[ii];
+            if (layout.stride != 0)
+            {
+                add(ii | 0x100);
+                add(layout.stride);
+                add(layout.stepFunction);
+                add(layout.stepRate);
+            }
+        }
+    }
+
+    return key;
+}
+
+id<MTLRenderPipelineState> SceneRendererMTL::pipelineStateForDescriptor(MTLRenderPipelineDescriptor *renderDesc)
+{
+    const std::string key = PipelineKey(renderDesc);
+
+    std::lock_guard<std::mutex> guardLock(pipelineLock);
+
+    const auto it = pipelineStates.find(key);
+    if (it != pipelineStates.end())
+        return it->second.state;
+
+    if (@available(iOS 14.0, *)) {
+        if (pipelineArchive)
+            renderDesc.binaryArchives = @[pipelineArchive];
+    }
+
+    NSError *err = nil;
+    id<MTLRenderPipelineState> state = [setupInfo.mtlDevice newRenderPipelineStateWithDescriptor:renderDesc error:&err];
+    if (!state) {
+        NSLog(@"SceneRendererMTL: Failed to set up render state because:\n%@",err);
+        return nil;
+    }
+
+    // Remember it for next time.  Those already in the archive are skipped.
+    if (@available(iOS 14.0, *)) {
+        if (pipelineArchive) {
+            id<MTLBinaryArchive> archive = pipelineArchive;
+            NSError *archiveErr = nil;
+            if ([archive addRenderPipelineFunctionsWithDescriptor:renderDesc error:&archiveErr])
+                pipelineArchiveDirty = true;
+        }
+    }
+
+    pipelineStates[key] = PipelineEntry { state, renderDesc.vertexFunction, renderDesc.fragmentFunction };
+
+    return state;
+}
+
+void SceneRendererMTL::setPipelineArchivePath(NSString *path)
+{
+    std::lock_guard<std::mutex> guardLock(pipelineLock);
+
+    pipelineArchive = nil;
+    pipelineArchiveURL = path ? [NSURL fileURLWithPath:path] : nil;
+    pipelineArchiveDirty = false;
+    if (!pipelineArchiveURL)
+        return;
+
+    if (@available(iOS 14.0, *)) {
+        MTLBinaryArchiveDescriptor *desc = [[MTLBinaryArchiveDescriptor alloc] init];
+        if ([[NSFileManager defaultManager] fileExistsAtPath:path])
+            desc.url = pipelineArchiveURL;
+
+        NSError *err = nil;
+        pipelineArchive = [setupInfo.mtlDevice newBinaryArchiveWithDescriptor:desc error:&err];
+        if (!pipelineArchive && desc.url) {
+            // Probably from another OS or GPU, so start over
+            NSLog(@"SceneRendererMTL: Discarding pipeline archive because:\n%@",err);
+            [[NSFileManager defaultManager] removeItemAtURL:pipelineArchiveURL error:nil];
+            desc.url = nil;
+            pipelineArchive = [setupInfo.mtlDevice newBinaryArchiveWithDescriptor:desc error:&err];
+        }
+    }
+}
+
+void SceneRendererMTL::savePipelineArchive()
+{
+    std::lock_guard<std::mutex> guardLock(pipelineLock);
+
+    if (!pipelineArchiveDirty || !pipelineArchive || !pipelineArchiveURL)
+        return;
+
+    if (@available(iOS 14.0, *)) {
+        id<MTLBinaryArchive> archive = pipelineArchive;
+        NSError *err = nil;
+        if ([archive serializeToURL:pipelineArchiveURL error:&err])
+            pipelineArchiveDirty = false;
+        else
+            NSLog(@"SceneRendererMTL: Failed to save pipeline archive because:\n%@",err);
+    }
+}
+
 void SceneRendererMTL::addSnapshotDelegate(NSObject<WhirlyKitSnapshot> *newDelegate)
 {
     snapshotDelegates.push_back(newDelegate);
@@ -309,6 +539,8 @@ void SceneRendererMTL::removeSnapshotDelegate(NSObject<WhirlyKitSnapshot> *oldDe
 
 void SceneRendererMTL::updateWorkGroups(RendererFrameInfo *inFrameInfo)
 {
+    WKTraceScope("Render MTL updateWorkGroups");
+
     RendererFrameInfoMTL *frameInfo = (RendererFrameInfoMTL *)inFrameInfo;
     RenderTeardownInfoMTLRef teardownInfoMTL = std::dynamic_pointer_cast<RenderTeardownInfoMTL>(teardownInfo);
     SceneRenderer::updateWorkGroups(frameInfo);
@@ -320,7 +552,8 @@ void SceneRendererMTL::updateWorkGroups(RendererFrameInfo *inFrameInfo)
     if (@available(iOS 13.0, *)) {
         for (const auto &workGroup : workGroups) {
             for (const auto &targetContainer : workGroup->renderTargetContainers) {
-                if (targetContainer->drawables.empty() && !targetContainer->modified)
+                // Groups that haven't changed keep their command buffers
+                if (!targetContainer->modified)
                     continue;
                 RenderTargetContainerMTLRef targetContainerMTL = std::dynamic_pointer_cast<RenderTargetContainerMTL>(targetContainer);
                 teardownInfoMTL->releaseDrawGroups(this,targetContainerMTL->drawGroups);
@@ -338,7 +571,8 @@ void SceneRendererMTL::updateWorkGroups(RendererFrameInfo *inFrameInfo)
                     continue;
                 }
 
-                // Sort the drawables into draw groups by Z buffer usage
+                // Sort the drawables into draw groups by Z buffer usage, whether they can be encoded indirectly
+                //  and whether they're in screen space
                 DrawGroupMTLRef drawGroup;
                 bool dgZBufferRead = false, dgZBufferWrite = false;
                 for (const auto &draw : targetContainer->drawables) {
@@ -360,11 +594,16 @@ void SceneRendererMTL::updateWorkGroups(RendererFrameInfo *inFrameInfo)
                         zBufferRead = drawMTL->getRequestZBuffer();
                         zBufferWrite = drawMTL->getWriteZbuffer();
                     }
+                    const bool direct = !drawMTL->canEncodeIndirect();
+                    const bool screenSpace = draw->isScreenSpace();
 
                     // If this isn't compatible with the draw group, create a new one
-                    if (!drawGroup || zBufferRead != dgZBufferRead || zBufferWrite != dgZBufferWrite) {
+                    if (!drawGroup || zBufferRead != dgZBufferRead || zBufferWrite != dgZBufferWrite ||
+                        direct != drawGroup->direct || screenSpace != drawGroup->screenSpace) {
                         // It's not, so we need to make a new draw group
                         drawGroup = std::make_shared<DrawGroupMTL>();
+                        drawGroup->direct = direct;
+                        drawGroup->screenSpace = screenSpace;
 
                         // Depth stencil, which goes in the command encoder later
                         MTLDepthStencilDescriptor *depthDesc = [[MTLDepthStencilDescriptor alloc] init];
@@ -384,68 +623,9 @@ void SceneRendererMTL::updateWorkGroups(RendererFrameInfo *inFrameInfo)
                     drawGroup->drawables.push_back(draw);
                 }
 
-                // Command buffer description should be the same
-                MTLIndirectCommandBufferDescriptor *cmdBuffDesc = [[MTLIndirectCommandBufferDescriptor alloc] init];
-                cmdBuffDesc.commandTypes = MTLIndirectCommandTypeDraw | MTLIndirectCommandTypeDrawIndexed;
-                cmdBuffDesc.inheritBuffers = false;
-                if (@available(iOS 13.0, *)) {
-                    cmdBuffDesc.inheritPipelineState = false;
-                }
-                // TODO: Should query the drawables to get this maximum number
-                cmdBuffDesc.maxVertexBufferBindCount = WhirlyKitShader::WKSVertMaxBuffer;
-                cmdBuffDesc.maxFragmentBufferBindCount = WhirlyKitShader::WKSFragMaxBuffer;
-
                 // Build up indirect buffers for each draw group
                 for (const auto &drawGroup : targetContainerMTL->drawGroups) {
-                    int curCommand = 0;
-                    drawGroup->numCommands = drawGroup->drawables.size();
-                    drawGroup->indCmdBuff = [setupInfo.mtlDevice newIndirectCommandBufferWithDescriptor:cmdBuffDesc maxCommandCount:drawGroup->numCommands options:0];
-                    if (!drawGroup->indCmdBuff) {
-                        wkLogLevel(Error, "SceneRendererMTL: Failed to allocate indirect command buffer.  Skipping.");
-                        continue;
-                    }
-
-                    // Just run the calculation portion
-                    if (workGroup->groupType == WorkGroup::Calculation) {
-                        // Work through the drawables
-                        for (const auto &draw : targetContainer->drawables) {
-                            DrawableMTL *drawMTL = dynamic_cast<DrawableMTL *>(draw.get());
-                            if (!drawMTL) {
-                                wkLogLevel(Error, "SceneRendererMTL: Invalid drawable.  Skipping.");
-                                continue;
-                            }
-                            SimpleIdentity calcProgID = drawMTL->getCalculationProgram();
-                            
-                            // Figure out the program to use for drawing
-                            if (calcProgID == EmptyIdentity)
-                                continue;
-                            ProgramMTL *calcProgram = (ProgramMTL *)scene->getProgram(calcProgID);
-                            if (!calcProgram) {
-                                wkLogLevel(Error, "SceneRendererMTL: Invalid calculation program for drawable.  Skipping.");
-                                continue;
-                            }
-                            
-                            id<MTLIndirectRenderCommand> cmdEncode = [drawGroup->indCmdBuff indirectRenderCommandAtIndex:curCommand++];
-                            drawMTL->encodeIndirectCalculate(cmdEncode,this,scene,renderTarget.get());
-                            drawMTL->enumerateResources(frameInfo, drawGroup->resources);
-                        }
-                    } else {
-                        // Work through the drawables
-                        for (const auto &draw : drawGroup->drawables) {
-                            DrawableMTL *drawMTL = dynamic_cast<DrawableMTL *>(draw.get());
-                            if (!drawMTL) {
-                                wkLogLevel(Error, "SceneRendererMTL: Invalid drawable");
-                                continue;
-                            }
-                            
-                            id<MTLIndirectRenderCommand> cmdEncode = [drawGroup->indCmdBuff indirectRenderCommandAtIndex:curCommand++];
-
-                            // TODO: Handle the offset matrices by encoding twice
-
-                            drawMTL->encodeIndirect(cmdEncode,this,scene,renderTarget.get());
-                            drawMTL->enumerateResources(frameInfo, drawGroup->resources);
-                        }
-                    }
+                    encodeDrawGroup(*drawGroup,workGroup->groupType,renderTarget.get(),frameInfo);
                 }
                 
                 targetContainer->modified = false;
@@ -454,6 +634,227 @@ void SceneRendererMTL::updateWorkGroups(RendererFrameInfo *inFrameInfo)
     }
 }
 
+void SceneRendererMTL::encodeDrawGroup(DrawGroupMTL &drawGroup,WorkGroup::GroupType groupType,RenderTargetMTL *renderTarget,RendererFrameInfoMTL *frameInfo)
+{
+    drawGroup.numCommands = drawGroup.drawables.size();
+    drawGroup.numMainCommands = 0;
+    drawGroup.numCopyCommands = 0;
+    drawGroup.numCopies = 0;
+    drawGroup.indCmdBuff = nil;
+    drawGroup.resources.clear();
+    drawGroup.gpuCull = false;
+    drawGroup.culledCmdBuff = nil;
+    drawGroup.cullInfoBuff.clear();
+    drawGroup.cullArgBuff = nil;
+
+    // These are drawn directly every frame, so all we need are the resources
+    if (drawGroup.direct) {
+        WhirlyKitShader::CullInfo cullInfo;
+        for (const auto &draw : drawGroup.drawables) {
+            if (const auto drawMTL = dynamic_cast<DrawableMTL *>(draw.get())) {
+                drawMTL->setupGPUCull(false, cullInfo);
+                drawMTL->enumerateResources(frameInfo, drawGroup.resources);
+            }
+        }
+        return;
+    }
+
+    const bool gpuCull = gpuCulling && cullPipeline && groupType != WorkGroup::Calculation;
+    std::vector<WhirlyKitShader::CullInfo> cullInfos;
+
+    // Room for every copy of the world we've needed so far
+    std::vector<DrawableMTL *> copyDraws;
+    if (groupType != WorkGroup::Calculation) {
+        for (const auto &draw : drawGroup.drawables) {
+            DrawableMTL *drawMTL = dynamic_cast<DrawableMTL *>(draw.get());
+            if (drawMTL && drawMTL->drawsWorldCopies())
+                copyDraws.push_back(drawMTL);
+        }
+        drawGroup.numCommands += copyDraws.size() * setupInfo.fixedCopyUniformBuffs.size();
+    }
+
+    // Command buffer description should be the same
+    MTLIndirectCommandBufferDescriptor *cmdBuffDesc = [[MTLIndirectCommandBufferDescriptor alloc] init];
+    cmdBuffDesc.commandTypes = MTLIndirectCommandTypeDraw | MTLIndirectCommandTypeDrawIndexed;
+    cmdBuffDesc.inheritBuffers = false;
+    cmdBuffDesc.inheritPipelineState = false;
+    // TODO: Should query the drawables to get this maximum number
+    cmdBuffDesc.maxVertexBufferBindCount = WhirlyKitShader::WKSVertMaxBuffer;
+    cmdBuffDesc.maxFragmentBufferBindCount = WhirlyKitShader::WKSFragMaxBuffer;
+
+    drawGroup.indCmdBuff = [setupInfo.mtlDevice newIndirectCommandBufferWithDescriptor:cmdBuffDesc maxCommandCount:std::max(drawGroup.numCommands,1) options:0];
+    if (!drawGroup.indCmdBuff) {
+        wkLogLevel(Error, "SceneRendererMTL: Failed to allocate indirect command buffer.  Skipping.");
+        drawGroup.numCommands = 0;
+        return;
+    }
+
+    int curCommand = 0;
+    for (const auto &draw : drawGroup.drawables) {
+        DrawableMTL *drawMTL = dynamic_cast<DrawableMTL *>(draw.get());
+        if (!drawMTL) {
+            wkLogLevel(Error, "SceneRendererMTL: Invalid drawable");
+            continue;
+        }
+
+        if (groupType == WorkGroup::Calculation) {
+            // Just run the calculation portion
+            const SimpleIdentity calcProgID = drawMTL->getCalculationProgram();
+            if (calcProgID == EmptyIdentity)
+                continue;
+            if (!scene->getProgram(calcProgID)) {
+                wkLogLevel(Error, "SceneRendererMTL: Invalid calculation program for drawable.  Skipping.");
+                continue;
+            }
+            id<MTLIndirectRenderCommand> cmdEncode = [drawGroup.indCmdBuff indirectRenderCommandAtIndex:curCommand++];
+            drawMTL->encodeIndirectCalculate(cmdEncode,this,scene,renderTarget);
+        } else {
+            id<MTLIndirectRenderCommand> cmdEncode = [drawGroup.indCmdBuff indirectRenderCommandAtIndex:curCommand++];
+            drawMTL->encodeIndirect(cmdEncode,this,scene,renderTarget);
+
+            cullInfos.emplace_back();
+            drawMTL->setupGPUCull(gpuCull, cullInfos.back());
+            if (cullInfos.back().flags != 0)
+                drawGroup.gpuCull = true;
+        }
+        drawMTL->enumerateResources(frameInfo, drawGroup.resources);
+    }
+    drawGroup.numMainCommands = curCommand;
+
+    // Then the same commands again for each copy of the world, with that copy's uniforms swapped in.
+    // If the map wraps more than this later on, the group gets encoded again.
+    drawGroup.numCopyCommands = copyDraws.size();
+    if (!copyDraws.empty()) {
+        for (const auto &copyBuff : setupInfo.fixedCopyUniformBuffs) {
+            for (DrawableMTL *drawMTL : copyDraws) {
+                id<MTLIndirectRenderCommand> cmdEncode = [drawGroup.indCmdBuff indirectRenderCommandAtIndex:curCommand++];
+                drawMTL->encodeIndirect(cmdEncode,this,scene,renderTarget);
+                [cmdEncode setVertexBuffer:copyBuff.buffer offset:copyBuff.offset atIndex:WhirlyKitShader::WKSVertUniformArgBuffer];
+                [cmdEncode setFragmentBuffer:copyBuff.buffer offset:copyBuff.offset atIndex:WhirlyKitShader::WKSFragUniformArgBuffer];
+
+                // Extents are checked against the main view, so the copies only get the rest
+                cullInfos.emplace_back();
+                drawMTL->setupGPUCull(gpuCull, cullInfos.back());
+                cullInfos.back().flags &= ~WKSCullExtents;
+            }
+            drawGroup.resources.addEntry(copyBuff);
+        }
+        drawGroup.numCopies = setupInfo.fixedCopyUniformBuffs.size();
+    }
+    drawGroup.numCommands = curCommand;
+
+    // Nothing to check, so we can draw straight from the encoded version
+    if (!drawGroup.gpuCull || drawGroup.numCommands == 0) {
+        drawGroup.gpuCull = false;
+        return;
+    }
+
+    // The cull pass gets a copy of the commands to work on every frame
+    drawGroup.culledCmdBuff = [setupInfo.mtlDevice newIndirectCommandBufferWithDescriptor:cmdBuffDesc maxCommandCount:drawGroup.numCommands options:0];
+    drawGroup.cullInfoBuff = setupInfo.heapManage.allocateBuffer(HeapManagerMTL::Drawable, cullInfos.data(), sizeof(WhirlyKitShader::CullInfo) * cullInfos.size());
+    drawGroup.cullArgBuff = [setupInfo.mtlDevice newBufferWithLength:cullArgEncoder.encodedLength options:MTLResourceStorageModeShared];
+    if (!drawGroup.culledCmdBuff || !drawGroup.cullInfoBuff.buffer || !drawGroup.cullArgBuff) {
+        wkLogLevel(Warn, "SceneRendererMTL: Failed to set up culling for a draw group.");
+        // Back to checking on the CPU
+        WhirlyKitShader::CullInfo cullInfo;
+        for (const auto &draw : drawGroup.drawables)
+            if (const auto drawMTL = dynamic_cast<DrawableMTL *>(draw.get()))
+                drawMTL->setupGPUCull(false, cullInfo);
+        drawGroup.gpuCull = false;
+        return;
+    }
+    [cullArgEncoder setArgumentBuffer:drawGroup.cullArgBuff offset:0];
+    [cullArgEncoder setIndirectCommandBuffer:drawGroup.culledCmdBuff atIndex:0];
+}
+
+MTLRenderPassDescriptor *SceneRendererMTL::setupScaledPass(MTLRenderPassDescriptor *screenPassDesc)
+{
+    const float resScale = dynamicRes.getScale();
+    id<MTLTexture> screenTex = screenPassDesc.colorAttachments[0].texture;
+    id<MTLTexture> screenDepthTex = screenPassDesc.depthAttachment.texture;
+    if (resScale >= 1.0f || !screenTex || !scaleUpVertFunc || !scaleUpFragFunc)
+        return nil;
+
+    const NSUInteger width = std::max((NSUInteger)1,(NSUInteger)(screenTex.width * resScale + 0.5f));
+    const NSUInteger height = std::max((NSUInteger)1,(NSUInteger)(screenTex.height * resScale + 0.5f));
+    if (!scaledColorTex || scaledColorTex.width != width || scaledColorTex.height != height ||
+        scaledColorTex.pixelFormat != screenTex.pixelFormat ||
+        (screenDepthTex && (!scaledDepthTex || scaledDepthTex.pixelFormat != screenDepthTex.pixelFormat)))
+    {
+        scaledColorTex = nil;
+        scaledDepthTex = nil;
+        scaleUpPipeline = nil;
+
+        // Scaling a multisampled map up would need a resolve in between
+        if (screenTex.sampleCount > 1) {
+            wkLogLevel(Warn, "SceneRendererMTL: Turning off dynamic resolution, can't scale into this render pass");
+            dynamicRes.setEnabled(false);
+            return nil;
+        }
+
+        id<MTLDevice> mtlDevice = setupInfo.mtlDevice;
+        MTLTextureDescriptor *texDesc = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:screenTex.pixelFormat width:width height:height mipmapped:NO];
+        texDesc.usage = MTLTextureUsageRenderTarget | MTLTextureUsageShaderRead;
+        texDesc.storageMode = MTLStorageModePrivate;
+        scaledColorTex = [mtlDevice newTextureWithDescriptor:texDesc];
+        if (screenDepthTex) {
+            MTLTextureDescriptor *depthDesc = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:screenDepthTex.pixelFormat width:width height:height mipmapped:NO];
+            depthDesc.usage = MTLTextureUsageRenderTarget;
+            depthDesc.storageMode = MTLStorageModePrivate;
+            scaledDepthTex = [mtlDevice newTextureWithDescriptor:depthDesc];
+        }
+
+        MTLRenderPipelineDescriptor *pipelineDesc = [[MTLRenderPipelineDescriptor alloc] init];
+        pipelineDesc.label = @"Dynamic resolution scale up";
+        pipelineDesc.vertexFunction = scaleUpVertFunc;
+        pipelineDesc.fragmentFunction = scaleUpFragFunc;
+        pipelineDesc.colorAttachments[0].pixelFormat = screenTex.pixelFormat;
+        if (screenDepthTex)
+            pipelineDesc.depthAttachmentPixelFormat = screenDepthTex.pixelFormat;
+        NSError *err = nil;
+        scaleUpPipeline = [mtlDevice newRenderPipelineStateWithDescriptor:pipelineDesc error:&err];
+
+        if (!scaleUpDepthState) {
+            MTLDepthStencilDescriptor *depthStateDesc = [[MTLDepthStencilDescriptor alloc] init];
+            depthStateDesc.depthCompareFunction = MTLCompareFunctionAlways;
+            depthStateDesc.depthWriteEnabled = false;
+            scaleUpDepthState = [mtlDevice newDepthStencilStateWithDescriptor:depthStateDesc];
+        }
+
+        if (!scaledColorTex || (screenDepthTex && !scaledDepthTex) || !scaleUpPipeline) {
+            wkLogLevel(Warn, "SceneRendererMTL: Turning off dynamic resolution, couldn't set up the scaled target");
+            scaledColorTex = nil;
+            scaledDepthTex = nil;
+            scaleUpPipeline = nil;
+            dynamicRes.setEnabled(false);
+            return nil;
+        }
+    }
+
+    // Same clears as the screen.  Only the color survives to be scaled up.
+    MTLRenderPassDescriptor *passDesc = [MTLRenderPassDescriptor renderPassDescriptor];
+    passDesc.colorAttachments[0].texture = scaledColorTex;
+    passDesc.colorAttachments[0].loadAction = MTLLoadActionClear;
+    passDesc.colorAttachments[0].clearColor = screenPassDesc.colorAttachments[0].clearColor;
+    passDesc.colorAttachments[0].storeAction = MTLStoreActionStore;
+    if (scaledDepthTex) {
+        passDesc.depthAttachment.texture = scaledDepthTex;
+        passDesc.depthAttachment.loadAction = MTLLoadActionClear;
+        passDesc.depthAttachment.clearDepth = screenPassDesc.depthAttachment.clearDepth;
+        passDesc.depthAttachment.storeAction = MTLStoreActionDontCare;
+    }
+    return passDesc;
+}
+
+void SceneRendererMTL::encodeScaleUp(id<MTLRenderCommandEncoder> cmdEncode)
+{
+    [cmdEncode setRenderPipelineState:scaleUpPipeline];
+    [cmdEncode setDepthStencilState:scaleUpDepthState];
+    [cmdEncode setCullMode:MTLCullModeNone];
+    [cmdEncode setFragmentTexture:scaledColorTex atIndex:0];
+    [cmdEncode drawPrimitives:MTLPrimitiveTypeTriangle vertexStart:0 vertexCount:3];
+}
+
 RendererFrameInfoMTLRef SceneRendererMTL::makeFrameInfo()
 {
     if (!theView || !scene)
@@ -461,25 +862,25 @@ RendererFrameInfoMTLRef SceneRendererMTL::makeFrameInfo()
         return RendererFrameInfoMTLRef();
     }
 
-    // Get the model and view matrices
-    const Eigen::Matrix4d modelTrans4d = theView->calcModelMatrix();
-    const Eigen::Matrix4d viewTrans4d = theView->calcViewMatrix();
+    // The matrices and their inverses come from the same view state everyone else is using
+    const ViewStateRef viewState = theView->getViewState(this);
+    const Eigen::Matrix4d &modelTrans4d = viewState->modelMatrix;
+    const Eigen::Matrix4d &viewTrans4d = viewState->viewMatrix;
     const Eigen::Matrix4f modelTrans = Matrix4dToMatrix4f(modelTrans4d);
     const Eigen::Matrix4f viewTrans = Matrix4dToMatrix4f(viewTrans4d);
     
-    // Set up a projection matrix
     const Point2f frameSize = getFramebufferSize();
-    const Eigen::Matrix4d projMat4d = theView->calcProjectionMatrix(frameSize,0.0);
+    const Eigen::Matrix4d &projMat4d = viewState->projMatrix;
 
-    const Eigen::Matrix4d modelAndViewMat4d = viewTrans4d * modelTrans4d;
+    const Eigen::Matrix4d &modelAndViewMat4d = viewState->fullMatrix;
     const Eigen::Matrix4d pvMat4d = projMat4d * viewTrans4d;
-    const Eigen::Matrix4d modelAndViewNormalMat4d = modelAndViewMat4d.inverse().transpose();
-    const Eigen::Matrix4d mvpMat4d = projMat4d * modelAndViewMat4d;
+    const Eigen::Matrix4d &modelAndViewNormalMat4d = viewState->fullNormalMatrix;
+    const Eigen::Matrix4d &mvpMat4d = viewState->mvpMatrix;
 
     const Eigen::Matrix4f projMat = Matrix4dToMatrix4f(projMat4d);
     const Eigen::Matrix4f modelAndViewMat = Matrix4dToMatrix4f(modelAndViewMat4d);
     const Eigen::Matrix4f mvpMat = Matrix4dToMatrix4f(mvpMat4d);
-    const Eigen::Matrix4f mvpNormalMat4f = Matrix4dToMatrix4f(mvpMat4d.inverse().transpose());
+    const Eigen::Matrix4f mvpNormalMat4f = Matrix4dToMatrix4f(viewState->mvpNormalMatrix);
     const Eigen::Matrix4f modelAndViewNormalMat = Matrix4dToMatrix4f(modelAndViewNormalMat4d);
 
     auto frameInfo = std::make_shared<RendererFrameInfoMTL>();
@@ -497,7 +898,7 @@ RendererFrameInfoMTLRef SceneRendererMTL::makeFrameInfo()
     frameInfo->projMat4d = projMat4d;
     frameInfo->mvpMat = mvpMat;
     frameInfo->mvpMat4d = mvpMat4d;
-    frameInfo->mvpInvMat = mvpMat.inverse();
+    frameInfo->mvpInvMat = Matrix4dToMatrix4f(viewState->invMvpMatrix);
     frameInfo->mvpNormalMat = mvpNormalMat4f;
     frameInfo->viewModelNormalMat = modelAndViewNormalMat;
     frameInfo->viewAndModelMat = modelAndViewMat;
@@ -515,6 +916,8 @@ void SceneRendererMTL::render(TimeInterval duration,
                               MTLRenderPassDescriptor *renderPassDesc,
                               id<SceneRendererMTLDrawableGetter> drawGetter)
 {
+    WKTraceScope("Render frame");
+
     if (!scene)
         return;
     SceneMTL *sceneMTL = (SceneMTL *)scene;
@@ -534,6 +937,24 @@ void SceneRendererMTL::render(TimeInterval duration,
     }
     
     lastDraw = now;
+
+    // See if we need to trade some resolution for frame rate.
+    // The command buffers tell us what the GPU took, a frame or two later, so that's what counts.
+    const TimeInterval frameBudget = 1.0 / std::max(framePacer.getDisplayRate(),1);
+    dynamicRes.addFrame(TimeGetCurrent(), frameBudget, viewMoved, true);
+
+    // Structured stats for this frame, if anyone's recording them
+    const bool collectStats = frameStats.isEnabled();
+    FrameStats::Frame frameStat;
+    frameStat.when = now;
+    const TimeInterval frameStart = collectStats ? TimeGetCurrent() : 0.0;
+    TimeInterval phaseStart = frameStart;
+    const auto markPhase = [&](FrameStats::Metric metric)
+    {
+        const TimeInterval phaseEnd = TimeGetCurrent();
+        frameStat.add(metric, phaseEnd - phaseStart);
+        phaseStart = phaseEnd;
+    };
     
     if (perfInterval > 0)
         perfTimer.startTiming("Render Frame");
@@ -552,21 +973,18 @@ void SceneRendererMTL::render(TimeInterval duration,
         return;
     }
     
-    // Get the model and view matrices
-    Eigen::Matrix4d modelTrans4d = theView->calcModelMatrix();
-    Eigen::Matrix4d viewTrans4d = theView->calcViewMatrix();
-    Eigen::Matrix4f modelTrans = Matrix4dToMatrix4f(modelTrans4d);
-    
-    // Set up a projection matrix
-    Eigen::Matrix4d projMat4d = theView->calcProjectionMatrix(frameSize,0.0);
+    // Shared with the frame info and everyone else looking at the view
+    const ViewStateRef viewState = theView->getViewState(this);
+    const Eigen::Matrix4d &modelTrans4d = viewState->modelMatrix;
+    const Eigen::Matrix4d &viewTrans4d = viewState->viewMatrix;
+    const Eigen::Matrix4d &projMat4d = viewState->projMatrix;
 
-    Eigen::Matrix4d modelAndViewMat4d = viewTrans4d * modelTrans4d;
+    Eigen::Matrix4d modelAndViewMat4d = viewState->fullMatrix;
     Eigen::Matrix4d pvMat4d = projMat4d * viewTrans4d;
-    Eigen::Matrix4d modelAndViewNormalMat4d = modelAndViewMat4d.inverse().transpose();
-    Eigen::Matrix4d mvpMat4d = projMat4d * modelAndViewMat4d;
+    Eigen::Matrix4d modelAndViewNormalMat4d = viewState->fullNormalMatrix;
 
     Eigen::Matrix4f modelAndViewMat = Matrix4dToMatrix4f(modelAndViewMat4d);
-    Eigen::Matrix4f mvpNormalMat4f = Matrix4dToMatrix4f(mvpMat4d.inverse().transpose());
+    Eigen::Matrix4f mvpNormalMat4f = Matrix4dToMatrix4f(viewState->mvpNormalMatrix);
     Eigen::Matrix4f modelAndViewNormalMat = Matrix4dToMatrix4f(modelAndViewNormalMat4d);
 
     if (perfInterval > 0)
@@ -589,18 +1007,18 @@ void SceneRendererMTL::render(TimeInterval duration,
 
     lastFrameInfo = frameInfoRef;
 
+    drawFrameMats.mvp = viewState->mvpMatrix;
+    drawFrameMats.mvpInv = viewState->invMvpMatrix;
+    drawFrameMats.mv = viewState->fullMatrix;
+    drawFrameMats.mvNormal = viewState->fullNormalMatrix;
+
     // We need a reverse of the eye vector in model space
     // We'll use this to determine what's pointed away
-    Eigen::Matrix4f modelTransInv = modelTrans.inverse();
-    Vector4f eyeVec4 = modelTransInv * Vector4f(0,0,1,0);
-    Vector3f eyeVec3(eyeVec4.x(),eyeVec4.y(),eyeVec4.z());
-    baseFrameInfo.eyeVec = eyeVec3;
-    Eigen::Matrix4f fullTransInv = modelAndViewMat.inverse();
-    Vector4f fullEyeVec4 = fullTransInv * Vector4f(0,0,1,0);
-    Vector3f fullEyeVec3(fullEyeVec4.x(),fullEyeVec4.y(),fullEyeVec4.z());
-    baseFrameInfo.fullEyeVec = -fullEyeVec3;
-    Matrix4d modelTransInv4d = modelTrans4d.inverse();
-    Vector4d eyeVec4d = modelTransInv4d * Vector4d(0,0,1,0.0);
+    baseFrameInfo.eyeVec = viewState->eyeVecModel.cast<float>();
+    const Vector4d fullEyeVec4 = viewState->invFullMatrix * Vector4d(0,0,1,0);
+    baseFrameInfo.fullEyeVec = -Vector3f(fullEyeVec4.x(),fullEyeVec4.y(),fullEyeVec4.z());
+    const Matrix4d &modelTransInv4d = viewState->invModelMatrix;
+    const Vector3d &eyeVec3d = viewState->eyeVecModel;
     baseFrameInfo.heightAboveSurface = theView->heightAboveSurface();
     const bool isFlat = scene->getCoordAdapter()->isFlat();
     if (isFlat) {
@@ -608,8 +1026,12 @@ void SceneRendererMTL::render(TimeInterval duration,
         eyePos4d /= eyePos4d.w();
         baseFrameInfo.eyePos = Vector3d(eyePos4d.x(),eyePos4d.y(),eyePos4d.z());
     } else
-        baseFrameInfo.eyePos = Vector3d(eyeVec4d.x(),eyeVec4d.y(),eyeVec4d.z()) * (1.0+baseFrameInfo.heightAboveSurface);
+        baseFrameInfo.eyePos = eyeVec3d * (1.0+baseFrameInfo.heightAboveSurface);
+    baseFrameInfo.horizon = viewState->horizon;
     
+    if (collectStats)
+        phaseStart = TimeGetCurrent();
+
     if (perfInterval > 0)
         perfTimer.startTiming("Scene preprocessing");
     
@@ -630,30 +1052,47 @@ void SceneRendererMTL::render(TimeInterval duration,
     
     // Let the active models to their thing
     // That thing had better not take too long
-    auto activeModels = scene->getActiveModels();
-    for (auto activeModel : activeModels) {
-        activeModel->updateForFrame(&baseFrameInfo);
+    const int numModelChanges = scene->runActiveModels(&baseFrameInfo);
+    if (perfInterval > 0) {
+        perfTimer.addCount("Active Models", (int)scene->getActiveModels().size());
+        perfTimer.addCount("Active Model Changes", numModelChanges);
     }
-    if (perfInterval > 0)
-        perfTimer.addCount("Active Models", (int)activeModels.size());
     
     if (perfInterval > 0)
         perfTimer.stopTiming("Active Model Runs");
     
     if (perfInterval > 0)
         perfTimer.addCount("Scene changes", scene->getNumChangeRequests());
+
+    if (perfInterval > 0)
+        perfTimer.addCount("Change batches", scene->getNumChangeBatches());
     
     if (perfInterval > 0)
         perfTimer.startTiming("Scene processing");
     
     // Merge any outstanding changes into the scenegraph
-    processScene(now);
+    const int numChanges = processScene(now);
+
+    if (collectStats)
+    {
+        markPhase(FrameStats::ChangeTime);
+        frameStat.add(FrameStats::ChangesExecuted, numPreProcessChanges + numModelChanges + numChanges);
+    }
     
+    // Zoom slots were just updated by the changes, so get them once for the whole frame
+    baseFrameInfo.zoomSlotMask = scene->copyZoomSlots(baseFrameInfo.zoomSlots);
+
     // Update our work groups accordingly
     updateWorkGroups(&baseFrameInfo);
+
+    if (collectStats)
+        markPhase(FrameStats::CullTime);
     
     if (perfInterval > 0)
         perfTimer.stopTiming("Scene processing");
+
+    if (perfInterval > 0)
+        perfTimer.addCount("Changes deferred", scene->getNumDeferredChanges());
     
     // Work through the available offset matrices (only 1 if we're not wrapping)
     std::vector<Matrix4d> &offsetMats = baseFrameInfo.offsetMatrices;
@@ -675,15 +1114,26 @@ void SceneRendererMTL::render(TimeInterval duration,
         pvMat4d = projMat4d * viewTrans4d * offsetMats[off];
         modelAndViewMat = Matrix4dToMatrix4f(modelAndViewMat4d);
         mvpMats[off] = projMat4d * modelAndViewMat4d;
-        mvpInvMats[off] = (Eigen::Matrix4d)mvpMats[off].inverse();
+        // The view state has the inverses, unless the overlap margin gave us different offsets
+        const bool sharedOffset = off < viewState->offsetMatrices.size() && viewState->offsetMatrices[off] == offsetMats[off];
+        if (sharedOffset)
+        {
+            mvpInvMats[off] = viewState->invMvpMatrices[off];
+            modelAndViewNormalMat4d = viewState->fullNormalMatrices[off];
+        }
+        else
+        {
+            const Eigen::Matrix4d mvInv = AffineInverse(modelAndViewMat4d);
+            mvpInvMats[off] = mvInv * viewState->invProjMatrix;
+            modelAndViewNormalMat4d = mvInv.transpose();
+        }
         mvpMats4f[off] = Matrix4dToMatrix4f(mvpMats[off]);
         mvpInvMats4f[off] = Matrix4dToMatrix4f(mvpInvMats[off]);
-        modelAndViewNormalMat4d = modelAndViewMat4d.inverse().transpose();
         modelAndViewNormalMat = Matrix4dToMatrix4f(modelAndViewNormalMat4d);
         offFrameInfo.mvpMat = mvpMats4f[off];
         offFrameInfo.mvpMat4d = mvpMats[off];
         offFrameInfo.mvpInvMat = mvpInvMats4f[off];
-        mvpNormalMat4f = Matrix4dToMatrix4f(mvpMats[off].inverse().transpose());
+        mvpNormalMat4f = Matrix4dToMatrix4f(sharedOffset ? viewState->mvpNormalMatrices[off] : (Eigen::Matrix4d)mvpInvMats[off].transpose());
         offFrameInfo.mvpNormalMat = mvpNormalMat4f;
         offFrameInfo.viewModelNormalMat = modelAndViewNormalMat;
         offFrameInfo.viewAndModelMat4d = modelAndViewMat4d;
@@ -697,6 +1147,22 @@ void SceneRendererMTL::render(TimeInterval duration,
     // Keeps us from stomping on the last frame's uniforms
     if (renderEvent == nil && drawGetter)
         renderEvent = [mtlDevice newEvent];
+
+    // Wait for the GPU to finish with the oldest ring slot, then take it for this frame
+    dispatch_semaphore_wait(frameBuffSema, DISPATCH_TIME_FOREVER);
+    frameBuffWhich = (frameBuffWhich + 1) % NumFrameBuffers;
+    frameBuffUsed = 0;
+
+    // Each command buffer adds its GPU time to its work group as it finishes.
+    // They finish in order, so the frame is complete when the last one does.
+    struct GPUFrameMTL
+    {
+        std::mutex lock;
+        GPUTimings::Frame frame;
+    };
+    const bool recordGPUTimes = gpuTimings.isEnabled();
+    const bool dynamicResTimes = dynamicRes.isEnabled() && drawGetter;
+    const auto gpuFrame = (recordGPUTimes || dynamicResTimes) ? std::make_shared<GPUFrameMTL>() : nullptr;
     
     // Workgroups force us to draw things in order
     for (auto &workGroup : workGroups) {
@@ -719,6 +1185,13 @@ void SceneRendererMTL::render(TimeInterval duration,
                 renderTarget = std::dynamic_pointer_cast<RenderTargetMTL>(targetContainer->renderTarget);
             }
 
+            // Cached targets keep what they drew last time until something changes
+            if (workGroup->groupType == WorkGroup::Offscreen) {
+                if (!renderTargetNeedsDraw(renderTarget.get()))
+                    continue;
+                renderTarget->dirty = false;
+            }
+
             // Render pass descriptor might change from frame to frame if we're clearing sporadically
             renderTarget->makeRenderPassDesc();
             baseFrameInfo.renderTarget = renderTarget.get();
@@ -740,13 +1213,51 @@ void SceneRendererMTL::render(TimeInterval duration,
             id<MTLFence> preProcessFence = [mtlDevice newFence];
             id<MTLBlitCommandEncoder> bltEncode = [cmdBuff blitCommandEncoder];
 
+            // Textures staged on other threads.  The command buffer holds on to the
+            //  staging buffers until it's done.
+            for (const auto &upload : pendingUploads) {
+                [bltEncode copyFromBuffer:upload.srcBuf
+                             sourceOffset:0
+                        sourceBytesPerRow:upload.bytesPerRow
+                      sourceBytesPerImage:upload.bytesPerRow * upload.destRegion.size.height
+                               sourceSize:upload.destRegion.size
+                                toTexture:upload.destTex
+                         destinationSlice:0
+                         destinationLevel:0
+                        destinationOrigin:upload.destRegion.origin];
+            }
+            pendingUploads.clear();
+
+            // Regions moved between textures.  The source may already be released,
+            //  but we hold on to it until the command buffer is done.
+            for (const auto &copy : pendingCopies) {
+                [bltEncode copyFromTexture:copy.srcTex
+                               sourceSlice:0
+                               sourceLevel:0
+                              sourceOrigin:copy.region.origin
+                                sourceSize:copy.region.size
+                                 toTexture:copy.destTex
+                          destinationSlice:0
+                          destinationLevel:0
+                         destinationOrigin:copy.region.origin];
+            }
+            pendingCopies.clear();
+
+            // Uniforms go first so the drawables pick up this target's buffers
+            setupLightBuffer(sceneMTL,&baseFrameInfo,bltEncode);
+            setupUniformBuffer(&baseFrameInfo,bltEncode,scene->getCoordAdapter());
+            setupCopyUniformBuffers(offFrameInfos,offsetMats,bltEncode,scene->getCoordAdapter());
+            const int numCopies = setupInfo.copyUniformBuffs.size();
+
             // Resources used by this container
             ResourceRefsMTL resources;
+            for (const auto &copyBuff : setupInfo.copyUniformBuffs)
+                resources.addEntry(copyBuff);
 
             if (indirectRender) {
                 // Run pre-process on the draw groups
                 for (const auto &drawGroup : targetContainerMTL->drawGroups) {
-                    if (drawGroup->numCommands > 0) {
+                    if (!drawGroup->drawables.empty()) {
                         bool resourcesChanged = false;
                         for (auto &draw : drawGroup->drawables) {
                             DrawableMTL *drawMTL = dynamic_cast<DrawableMTL *>(draw.get());
@@ -758,13 +1269,14 @@ void SceneRendererMTL::render(TimeInterval duration,
                             if (drawMTL->preProcess(this, cmdBuff, bltEncode, sceneMTL))
                                 resourcesChanged = true;
                         }
-                        // At least one of the drawables is pointing at different resources, so we need to redo this
-                        if (resourcesChanged) {
-                            drawGroup->resources.clear();
-                            for (auto &draw : drawGroup->drawables) {
-                                if (const auto drawMTL = dynamic_cast<DrawableMTL *>(draw.get())) {
-                                    drawMTL->enumerateResources(&baseFrameInfo, drawGroup->resources);
-                                }
+                        // At least one of the drawables is pointing at different resources, so we need to redo this group.
+                        // Same if we're wrapped more times than the group has copies encoded for.
+                        // The GPU may still be using the old command buffer, so that hangs around until the frame's done.
+                        if (resourcesChanged || (drawGroup->numCopyCommands > 0 && drawGroup->numCopies < numCopies)) {
+                            if (@available(iOS 13.0, *)) {
+                                std::vector<DrawGroupMTLRef> oldGroup { std::make_shared<DrawGroupMTL>(*drawGroup) };
+                                frameTeardownInfo->releaseDrawGroups(this, oldGroup);
+                                encodeDrawGroup(*drawGroup, workGroup->groupType, renderTarget.get(), &baseFrameInfo);
                             }
                         }
                         resources.addResources(drawGroup->resources);
@@ -781,11 +1293,50 @@ void SceneRendererMTL::render(TimeInterval duration,
                 }
             }
 
-            // TODO: Just set these up once and copy it into position
-            setupLightBuffer(sceneMTL,&baseFrameInfo,bltEncode);
-            setupUniformBuffer(&baseFrameInfo,bltEncode,scene->getCoordAdapter());
+            // Fresh copies of the commands for the cull pass to turn off
+            bool anyGPUCull = false;
+            if (indirectRender) {
+                if (@available(iOS 13.0, *)) {
+                    for (const auto &drawGroup : targetContainerMTL->drawGroups) {
+                        if (drawGroup->gpuCull) {
+                            [bltEncode copyIndirectCommandBuffer:drawGroup->indCmdBuff
+                                                     sourceRange:NSMakeRange(0,drawGroup->numCommands)
+                                                     destination:drawGroup->culledCmdBuff
+                                                destinationIndex:0];
+                            anyGPUCull = true;
+                        }
+                    }
+                }
+            }
+
             [bltEncode updateFence:preProcessFence];
             [bltEncode endEncoding];
+
+            // Turn off what we can't see.  This goes after the copies and uniforms and the render waits on it.
+            if (anyGPUCull) {
+                if (@available(iOS 13.0, *)) {
+                    id<MTLComputeCommandEncoder> cullEncode = [cmdBuff computeCommandEncoder];
+                    [cullEncode waitForFence:preProcessFence];
+                    [cullEncode setComputePipelineState:cullPipeline];
+                    [cullEncode setBuffer:setupInfo.uniformBuff.buffer offset:setupInfo.uniformBuff.offset atIndex:WhirlyKitShader::WKSCullUniformArgBuffer];
+                    const NSUInteger threadWidth = cullPipeline.threadExecutionWidth;
+                    for (const auto &drawGroup : targetContainerMTL->drawGroups) {
+                        if (!drawGroup->gpuCull)
+                            continue;
+                        WhirlyKitShader::CullFrame cullFrame;
+                        cullFrame.height = baseFrameInfo.heightAboveSurface;
+                        cullFrame.numCommands = drawGroup->numCommands;
+                        [cullEncode setBytes:&cullFrame length:sizeof(cullFrame) atIndex:WhirlyKitShader::WKSCullFrameArgBuffer];
+                        [cullEncode setBuffer:drawGroup->cullInfoBuff.buffer offset:drawGroup->cullInfoBuff.offset atIndex:WhirlyKitShader::WKSCullInfoArgBuffer];
+                        [cullEncode setBuffer:drawGroup->cullArgBuff offset:0 atIndex:WhirlyKitShader::WKSCullCommandArgBuffer];
+                        [cullEncode useResource:drawGroup->culledCmdBuff usage:MTLResourceUsageWrite];
+                        [cullEncode dispatchThreadgroups:MTLSizeMake((drawGroup->numCommands + threadWidth - 1) / threadWidth,1,1)
+                                   threadsPerThreadgroup:MTLSizeMake(threadWidth,1,1)];
+                    }
+                    [cullEncode updateFence:preProcessFence];
+                    [cullEncode endEncoding];
+                }
+            }
             
             // If we're forcing a mipmap calculation, then we're just going to use this render target once
             // If not, then we run some program over it multiple times
@@ -794,25 +1345,10 @@ void SceneRendererMTL::render(TimeInterval duration,
             if (renderTarget->mipmapType != RenderTargetMipmapNone)
                 numLevels = 1;
 
-            for (unsigned int level=0;level<numLevels;level++) {
-                // TODO: Pass the level into the draw call
-                //       Also do something about the offset matrices
-                // Set up the encoder
-                id<MTLRenderCommandEncoder> cmdEncode = nil;
-                if (renderTarget->getTex() == nil) {
-                    // This happens if the dev wants an instantaneous render
-                    if (!renderPassDesc)
-                        renderPassDesc = renderTarget->getRenderPassDesc(level);
-
-                    baseFrameInfo.renderPassDesc = renderPassDesc;
-                } else {
-                    baseFrameInfo.renderPassDesc = renderTarget->getRenderPassDesc(level);
-                }
-                cmdEncode = [cmdBuff renderCommandEncoderWithDescriptor:baseFrameInfo.renderPassDesc];
-                [cmdEncode waitForFence:preProcessFence beforeStages:MTLRenderStageVertex];
-
-                resources.use(cmdEncode);
-
+            // Draw everything, or just the map or screen space parts for dynamic resolution
+            enum { DrawAll, DrawWorld, DrawScreenSpace };
+            const auto encodeDraws = [&](id<MTLRenderCommandEncoder> cmdEncode,unsigned int level,int which)
+            {
                 if (indirectRender) {
                     if (@available(iOS 12.0, *)) {
                         // Front-face culling on by default for globes
@@ -821,9 +1357,39 @@ void SceneRendererMTL::render(TimeInterval duration,
                             [cmdEncode setCullMode:MTLCullModeFront];
                         }
                         for (const auto &drawGroup : targetContainerMTL->drawGroups) {
-                            if (drawGroup->numCommands > 0) {
+                            if (which != DrawAll && drawGroup->screenSpace != (which == DrawScreenSpace))
+                                continue;
+                            if (drawGroup->direct) {
+                                // The few that can't be encoded ahead of time
                                 [cmdEncode setDepthStencilState:drawGroup->depthStencil];
-                                [cmdEncode executeCommandsInBuffer:drawGroup->indCmdBuff withRange:NSMakeRange(0,drawGroup->numCommands)];
+                                for (const auto &draw : drawGroup->drawables) {
+                                    const auto drawMTL = dynamic_cast<DrawableMTL *>(draw.get());
+                                    ProgramMTL *program = drawMTL ? (ProgramMTL *)scene->getProgram(drawMTL->getProgram()) : nullptr;
+                                    if (!program)
+                                        continue;
+                                    baseFrameInfo.program = program;
+                                    drawMTL->encodeDirect(&baseFrameInfo,cmdEncode,scene);
+                                }
+                                if (collectStats) {
+                                    frameStat.add(FrameStats::DrawCalls, drawGroup->numCommands);
+                                    frameStat.add(FrameStats::DrawablesDrawn, drawGroup->numCommands);
+                                    for (const auto &draw : drawGroup->drawables)
+                                        frameStat.add(FrameStats::Triangles, draw->getNumTris());
+                                }
+                            } else if (drawGroup->numCommands > 0) {
+                                // The main commands, then as many copies of the world as this frame needs
+                                const int numToDraw = drawGroup->numMainCommands +
+                                    drawGroup->numCopyCommands * std::min(drawGroup->numCopies,numCopies);
+                                [cmdEncode setDepthStencilState:drawGroup->depthStencil];
+                                [cmdEncode executeCommandsInBuffer:(drawGroup->gpuCull ? drawGroup->culledCmdBuff : drawGroup->indCmdBuff)
+                                                         withRange:NSMakeRange(0,numToDraw)];
+
+                                if (collectStats) {
+                                    frameStat.add(FrameStats::DrawCalls, 1);
+                                    frameStat.add(FrameStats::DrawablesDrawn, numToDraw);
+                                    for (const auto &draw : drawGroup->drawables)
+                                        frameStat.add(FrameStats::Triangles, draw->getNumTris());
+                                }
                             }
                         }
                     }
@@ -878,6 +1444,8 @@ void SceneRendererMTL::render(TimeInterval duration,
                                 wkLogLevel(Error, "SceneRendererMTL: Invalid drawable.  Skipping.");
                                 continue;
                             }
+                            if (which != DrawAll && drawMTL->isScreenSpace() != (which == DrawScreenSpace))
+                                continue;
 
                             // Figure out the program to use for drawing
                             ProgramMTL *program = (ProgramMTL *)scene->getProgram(drawMTL->getProgram());
@@ -927,19 +1495,63 @@ void SceneRendererMTL::render(TimeInterval duration,
                                 firstDepthState = false;
                             }
                             
-                            //for (unsigned int off=0;off<offFrameInfos.size();off++) {
-                                // Set up transforms to use right now (one per offset matrix)
-//                                baseFrameInfo.mvpMat = mvpMats4f[off];
-//                                baseFrameInfo.mvpInvMat = mvpInvMats4f[off];
-                                
-                                baseFrameInfo.program = program;
+                            baseFrameInfo.program = program;
+
+                            // "Draw" using the given program.  This covers the other copies of the world, too.
+                            drawMTL->encodeDirect(&baseFrameInfo,cmdEncode,scene);
 
-                                // "Draw" using the given program
-                                drawMTL->encodeDirect(&baseFrameInfo,cmdEncode,scene);
-                            //}
+                            if (collectStats) {
+                                frameStat.add(FrameStats::DrawCalls, 1);
+                                frameStat.add(FrameStats::DrawablesDrawn, 1);
+                                frameStat.add(FrameStats::Triangles, drawMTL->getNumTris());
+                            }
                         }
                     }
                 }
+            };
+
+            for (unsigned int level=0;level<numLevels;level++) {
+                // TODO: Pass the level into the draw call
+                //       Also do something about the offset matrices
+                // Set up the encoder
+                if (renderTarget->getTex() == nil) {
+                    // This happens if the dev wants an instantaneous render
+                    if (!renderPassDesc)
+                        renderPassDesc = renderTarget->getRenderPassDesc(level);
+
+                    baseFrameInfo.renderPassDesc = renderPassDesc;
+                } else {
+                    baseFrameInfo.renderPassDesc = renderTarget->getRenderPassDesc(level);
+                }
+
+                // If we're falling behind, draw the map smaller first.
+                // It gets scaled up into the screen pass and the screen space drawables go on top at full resolution.
+                MTLRenderPassDescriptor *scaledPassDesc = nil;
+                if (drawGetter && level == 0 && workGroup->groupType == WorkGroup::ScreenRender &&
+                    renderTarget.get() == defaultTarget)
+                    scaledPassDesc = setupScaledPass(baseFrameInfo.renderPassDesc);
+                if (scaledPassDesc) {
+                    MTLRenderPassDescriptor *screenPassDesc = baseFrameInfo.renderPassDesc;
+                    baseFrameInfo.renderPassDesc = scaledPassDesc;
+                    id<MTLRenderCommandEncoder> mapEncode = [cmdBuff renderCommandEncoderWithDescriptor:scaledPassDesc];
+                    [mapEncode waitForFence:preProcessFence beforeStages:MTLRenderStageVertex];
+                    resources.use(mapEncode);
+                    encodeDraws(mapEncode,level,DrawWorld);
+                    [mapEncode endEncoding];
+                    baseFrameInfo.renderPassDesc = screenPassDesc;
+                }
+
+                id<MTLRenderCommandEncoder> cmdEncode = [cmdBuff renderCommandEncoderWithDescriptor:baseFrameInfo.renderPassDesc];
+                [cmdEncode waitForFence:preProcessFence beforeStages:MTLRenderStageVertex];
+
+                resources.use(cmdEncode);
+
+                if (scaledPassDesc) {
+                    encodeScaleUp(cmdEncode);
+                    encodeDraws(cmdEncode,level,DrawScreenSpace);
+                } else {
+                    encodeDraws(cmdEncode,level,DrawAll);
+                }
 
                 [cmdEncode endEncoding];
             }
@@ -987,14 +1599,18 @@ void SceneRendererMTL::render(TimeInterval duration,
                     }
                     
 //                    targetContainerMTL->lastRenderFence = nil;
-                    
-                    // We can do the free-ing on a low priority queue
-                    // But it has to be a single queue, otherwise we'll end up deleting things at the same time.  Oops.
-                    dispatch_async(releaseQueue, ^{
-                        frameTeardownInfo->clear();
-                    });
                 });
             }];
+
+            if (gpuFrame) {
+                const auto phase = (GPUTimings::Phase)workGroup->groupType;
+                [cmdBuff addCompletedHandler:^(id<MTLCommandBuffer> _Nonnull doneBuff) {
+                    if (doneBuff.status != MTLCommandBufferStatusCompleted || doneBuff.GPUEndTime <= doneBuff.GPUStartTime)
+                        return;
+                    std::lock_guard<std::mutex> guardLock(gpuFrame->lock);
+                    gpuFrame->frame.add(phase, doneBuff.GPUEndTime - doneBuff.GPUStartTime);
+                }];
+            }
             lastCmdBuff = cmdBuff;
 
             // This happens for offline rendering and we want to wait until the render finishes to return it
@@ -1009,18 +1625,139 @@ void SceneRendererMTL::render(TimeInterval duration,
             perfTimer.stopTiming("Work Group: " + workGroup->name);
     }
     
+    if (collectStats)
+        markPhase(FrameStats::DrawTime);
+
     // Notify anyone waiting that this frame is complete
-    if (lastCmdBuff) {
-        if (drawGetter) {
-            [lastCmdBuff encodeSignalEvent:renderEvent value:lastRenderNo+1];
-            [lastCmdBuff commit];
+    // The ring slot is free once the GPU is done, or right now if we already waited for it.
+    // Whatever was removed during the frame goes at the same point, all at once, on the
+    // release queue.  It has to be a single queue, otherwise we'll end up deleting things at the same time.
+    dispatch_semaphore_t frameSema = frameBuffSema;
+    dispatch_queue_t frameReleaseQueue = releaseQueue;
+    if (gpuFrame) {
+        // Offline rendering has already waited on everything
+        const auto shuttingDown = this->_isShuttingDown;
+        GPUTimings *timings = recordGPUTimes ? &gpuTimings : nullptr;
+        DynamicResolution *dynRes = dynamicResTimes ? &dynamicRes : nullptr;
+        const bool moving = viewMoved;
+        const auto addGPUFrame = [gpuFrame,shuttingDown,timings,dynRes,moving,frameBudget]() {
+            if (*shuttingDown)
+                return;
+            std::lock_guard<std::mutex> guardLock(gpuFrame->lock);
+            if (timings)
+                timings->addFrame(gpuFrame->frame);
+            if (dynRes) {
+                double total = 0.0;
+                for (int pp=0;pp<GPUTimings::Total;pp++)
+                    total += gpuFrame->frame.values[pp];
+                dynRes->addGPUFrame(total, frameBudget, moving);
+            }
+        };
+        if (lastCmdBuff && drawGetter) {
+            [lastCmdBuff addCompletedHandler:^(id<MTLCommandBuffer> _Nonnull) { addGPUFrame(); }];
+        } else {
+            addGPUFrame();
         }
-        lastCmdBuff = nil;
     }
+    if (lastCmdBuff && drawGetter) {
+        [lastCmdBuff addCompletedHandler:^(id<MTLCommandBuffer> _Nonnull) {
+            dispatch_semaphore_signal(frameSema);
+            dispatch_async(frameReleaseQueue, ^{
+                frameTeardownInfo->clear();
+            });
+        }];
+        [lastCmdBuff encodeSignalEvent:renderEvent value:lastRenderNo+1];
+        [lastCmdBuff commit];
+    } else {
+        dispatch_semaphore_signal(frameSema);
+        dispatch_async(frameReleaseQueue, ^{
+            frameTeardownInfo->clear();
+        });
+    }
+    lastCmdBuff = nil;
     lastRenderNo++;
 
+    // Histograms are counted by a compute pass in their own command buffer, so only the bins come back
+    std::vector<HistogramRequest> histograms = takeHistograms();
+    if (!histograms.empty()) {
+        id<MTLCommandBuffer> histCmdBuff = [cmdQueue commandBuffer];
+        for (auto &request : histograms) {
+            const auto renderTarget = getRenderTarget(request.targetID);
+            id<MTLBuffer> buf = renderTarget ? renderTarget->encodeHistogram(mtlDevice, histCmdBuff, request.numBins,
+                                                                             request.minVal, request.maxVal) : nil;
+            if (!buf) {
+                request.callback(RenderTargetHistogramRef());
+                continue;
+            }
+
+            const HistogramCallback callback = std::move(request.callback);
+            const int numBins = request.numBins;
+            const float minVal = request.minVal, maxVal = request.maxVal;
+            [histCmdBuff addCompletedHandler:^(id<MTLCommandBuffer> _Nonnull doneBuff) {
+                if ([doneBuff status] != MTLCommandBufferStatusCompleted || [buf length] < numBins * sizeof(uint32_t)) {
+                    callback(RenderTargetHistogramRef());
+                    return;
+                }
+                auto hist = std::make_shared<RenderTargetHistogram>();
+                hist->minVal = minVal;
+                hist->maxVal = maxVal;
+                const uint32_t *counts = (const uint32_t *)[buf contents];
+                hist->bins.assign(counts, counts + numBins);
+                for (uint32_t count : hist->bins)
+                    hist->numPixels += count;
+                callback(hist);
+            }];
+        }
+        [histCmdBuff commit];
+    }
+
+    // Readbacks go in their own command buffer, which runs after the frame's
+    std::vector<ReadbackRequest> readbacks = takeReadbacks();
+    if (!readbacks.empty()) {
+        id<MTLCommandBuffer> readCmdBuff = [cmdQueue commandBuffer];
+        id<MTLBlitCommandEncoder> readEncode = [readCmdBuff blitCommandEncoder];
+        for (auto &request : readbacks) {
+            const auto renderTarget = getRenderTarget(request.targetID);
+            id<MTLBuffer> buf = renderTarget ? renderTarget->encodeReadback(mtlDevice, readEncode,
+                                                                            request.x, request.y, request.width, request.height,
+                                                                            request.minMax) : nil;
+            if (!buf) {
+                request.callback(RawDataRef());
+                continue;
+            }
+
+            const ReadbackCallback callback = std::move(request.callback);
+            [readCmdBuff addCompletedHandler:^(id<MTLCommandBuffer> _Nonnull doneBuff) {
+                if ([doneBuff status] != MTLCommandBufferStatusCompleted) {
+                    callback(RawDataRef());
+                    return;
+                }
+                // Hand out the buffer's memory directly, holding on to the buffer until they're done
+                NSData *data = [[NSData alloc] initWithBytesNoCopy:[buf contents]
+                                                            length:[buf length]
+                                                       deallocator:^(void *, NSUInteger) { (void)buf; }];
+                callback(std::make_shared<RawNSDataReader>(data));
+            }];
+        }
+        [readEncode endEncoding];
+        [readCmdBuff commit];
+    }
+
     if (perfInterval > 0)
         perfTimer.stopTiming("Render Frame");
+
+    if (!startupTimeline.isDone())
+        noteStartupFrame(hasScreenDrawables());
+
+    // Take this every frame so it doesn't pile up while we're not recording
+    const size_t uploadBytes = scene->takeUploadBytes();
+    if (collectStats)
+    {
+        markPhase(FrameStats::PresentTime);
+        frameStat.add(FrameStats::FrameTime, TimeGetCurrent() - frameStart);
+        frameStat.add(FrameStats::TextureBytes, (double)uploadBytes);
+        frameStats.addFrame(frameStat);
+    }
     
     // Update the frames per sec
     if (perfInterval > 0 && frameCount > perfInterval)
@@ -1049,6 +1786,54 @@ void SceneRendererMTL::render(TimeInterval duration,
     setupInfo.heapManage.updateHeaps();
 }
 
+void SceneRendererMTL::purgeMemory()
+{
+    setupInfo.heapManage.purge();
+    // The scaled map target comes back the next time dynamic resolution drops
+    scaledColorTex = nil;
+    scaledDepthTex = nil;
+}
+
+void SceneRendererMTL::addMemoryUsage(MemoryUsage &usage)
+{
+    size_t bufferBytes = 0, textureBytes = 0;
+    setupInfo.heapManage.getUsage(bufferBytes,textureBytes);
+    usage.bytes[MemVertexBuffers] += bufferBytes;
+    usage.bytes[MemTextures] += textureBytes;
+}
+
+void SceneRendererMTL::trimMemory(PlatformThreadInfo *,MemoryTrimLevel step,ChangeSet &)
+{
+    if (step == MemTrimDecodeCaches)
+        purgeMemory();
+}
+
+void SceneRendererMTL::setGPUCulling(bool newVal)
+{
+    // Nothing to do the culling with
+    if (!cullPipeline)
+        newVal = false;
+    if (gpuCulling == newVal)
+        return;
+    gpuCulling = newVal;
+
+    // Everything gets re-encoded with or without the cull info
+    for (const auto &workGroup : workGroups)
+        for (const auto &targetContainer : workGroup->renderTargetContainers)
+            targetContainer->modified = true;
+
+    // The ones not in a group would come back in without their height checks
+    if (!gpuCulling) {
+        const auto clearCulled = [](const DrawableRef &draw) {
+            if (const auto basicDraw = dynamic_cast<BasicDrawable *>(draw.get()))
+                basicDraw->setGPUCulled(false);
+        };
+        for (const auto &draw : offDrawables)
+            clearCulled(draw);
+        timeIndex.forEach(clearCulled);
+    }
+}
+
 void SceneRendererMTL::shutdown()
 {
     *_isShuttingDown = true;
@@ -1065,9 +1850,25 @@ void SceneRendererMTL::shutdown()
 
     cmdQueue = nil;
 
+    savePipelineArchive();
+    {
+        std::lock_guard<std::mutex> guardLock(pipelineLock);
+        pipelineStates.clear();
+    }
+
     SceneRenderer::shutdown();
 }
 
+void SceneRendererMTL::addTextureUpload(id<MTLBuffer> srcBuf,NSUInteger bytesPerRow,id<MTLTexture> destTex,MTLRegion destRegion)
+{
+    pendingUploads.push_back(TextureUploadMTL { srcBuf, bytesPerRow, destTex, destRegion });
+}
+
+void SceneRendererMTL::addTextureCopy(id<MTLTexture> srcTex,id<MTLTexture> destTex,MTLRegion region)
+{
+    pendingCopies.push_back(TextureCopyMTL { srcTex, destTex, region });
+}
+
 RenderTargetMTLRef SceneRendererMTL::getRenderTarget(SimpleIdentity renderTargetID)
 {
     if (renderTargetID == EmptyIdentity) {
@@ -1094,6 +1895,12 @@ RawDataRef SceneRendererMTL::getSnapshotAt(SimpleIdentity renderTargetID,int x,i
     return renderTarget ? renderTarget->snapshot(x, y, 1, 1) : nil;
 }
 
+RawDataRef SceneRendererMTL::getSnapshotAt(SimpleIdentity renderTargetID,int x,int y,int width,int height)
+{
+    const auto renderTarget = getRenderTarget(renderTargetID);
+    return renderTarget ? renderTarget->snapshot(x, y, width, height) : nil;
+}
+
 RawDataRef SceneRendererMTL::getSnapshotMinMax(SimpleIdentity renderTargetID)
 {
     const auto renderTarget = getRenderTarget(renderTargetID);
@@ -1140,5 +1947,15 @@ DynamicTextureRef SceneRendererMTL::makeDynamicTexture(const std::string &name)
     return std::make_shared<DynamicTextureMTL>(name);
 }
 
+Texture *SceneRendererMTL::makeRenderTexture(const std::string &name,int width,int height,TextureType type) const
+{
+    auto tex = new TextureMTL(name);
+    tex->setWidth(width);
+    tex->setHeight(height);
+    tex->setIsEmptyTexture(true);
+    tex->setFormat(type);
+    return tex;
+}
+
     
 }
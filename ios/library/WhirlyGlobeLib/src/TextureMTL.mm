@@ -22,10 +22,77 @@
 #import <Accelerate/Accelerate.h>
 #import "WhirlyKitLog.h"
 #import "SceneMTL.h"
+#import "SceneRendererMTL.h"
 
 namespace WhirlyKit
 {
 
+// Metal version of a compressed format, if the GPU can do it
+static bool CompressedPixelFormat(const RenderSetupInfo *inSetupInfo,const CompressedImageInfo &info,MTLPixelFormat &pixFormat)
+{
+#if TARGET_OS_SIMULATOR || TARGET_OS_MACCATALYST
+    // Only the Apple GPUs do ETC2 and ASTC
+    if (@available(iOS 13.0, macCatalyst 13.1, *))
+    {
+        if (![((RenderSetupInfoMTL *)inSetupInfo)->mtlDevice supportsFamily:MTLGPUFamilyApple2])
+            return false;
+    }
+    else
+    {
+        return false;
+    }
+#endif
+
+    switch (info.format)
+    {
+        case CompressedETC2_RGB8:
+            pixFormat = info.sRGB ? MTLPixelFormatETC2_RGB8_sRGB : MTLPixelFormatETC2_RGB8;
+            return true;
+        case CompressedETC2_RGB8A1:
+            pixFormat = info.sRGB ? MTLPixelFormatETC2_RGB8A1_sRGB : MTLPixelFormatETC2_RGB8A1;
+            return true;
+        case CompressedETC2_RGBA8:
+            pixFormat = info.sRGB ? MTLPixelFormatEAC_RGBA8_sRGB : MTLPixelFormatEAC_RGBA8;
+            return true;
+        case CompressedEAC_R11:
+            pixFormat = MTLPixelFormatEAC_R11Unorm;
+            return true;
+        case CompressedEAC_R11Signed:
+            pixFormat = MTLPixelFormatEAC_R11Snorm;
+            return true;
+        case CompressedEAC_RG11:
+            pixFormat = MTLPixelFormatEAC_RG11Unorm;
+            return true;
+        case CompressedEAC_RG11Signed:
+            pixFormat = MTLPixelFormatEAC_RG11Snorm;
+            return true;
+        case CompressedASTC:
+        {
+            // Same order as the block size list
+            static const MTLPixelFormat linearFormats[14] = {
+                MTLPixelFormatASTC_4x4_LDR, MTLPixelFormatASTC_5x4_LDR, MTLPixelFormatASTC_5x5_LDR,
+                MTLPixelFormatASTC_6x5_LDR, MTLPixelFormatASTC_6x6_LDR, MTLPixelFormatASTC_8x5_LDR,
+                MTLPixelFormatASTC_8x6_LDR, MTLPixelFormatASTC_8x8_LDR, MTLPixelFormatASTC_10x5_LDR,
+                MTLPixelFormatASTC_10x6_LDR, MTLPixelFormatASTC_10x8_LDR, MTLPixelFormatASTC_10x10_LDR,
+                MTLPixelFormatASTC_12x10_LDR, MTLPixelFormatASTC_12x12_LDR };
+            static const MTLPixelFormat sRGBFormats[14] = {
+                MTLPixelFormatASTC_4x4_sRGB, MTLPixelFormatASTC_5x4_sRGB, MTLPixelFormatASTC_5x5_sRGB,
+                MTLPixelFormatASTC_6x5_sRGB, MTLPixelFormatASTC_6x6_sRGB, MTLPixelFormatASTC_8x5_sRGB,
+                MTLPixelFormatASTC_8x6_sRGB, MTLPixelFormatASTC_8x8_sRGB, MTLPixelFormatASTC_10x5_sRGB,
+                MTLPixelFormatASTC_10x6_sRGB, MTLPixelFormatASTC_10x8_sRGB, MTLPixelFormatASTC_10x10_sRGB,
+                MTLPixelFormatASTC_12x10_sRGB, MTLPixelFormatASTC_12x12_sRGB };
+            const int which = info.astcBlockIndex();
+            if (which < 0)
+                return false;
+            pixFormat = info.sRGB ? sRGBFormats[which] : linearFormats[which];
+            return true;
+        }
+        case CompressedNone:
+        default:
+            return false;
+    }
+}
+
 TextureMTL::TextureMTL(const std::string &name)
     : Texture(name), TextureBaseMTL(name), TextureBase(name)
 {
@@ -122,6 +189,14 @@ static RawDataRef ConvertRGBA8888toRGBA5551(const RawDataRef &inData, int width,
 
 RawDataRef TextureMTL::convertData()
 {
+    // Just the first level, past the header
+    if (isCompressed)
+    {
+        const RawDataRef srcData = texData;
+        return std::make_shared<RawDataWrapper>(texData->getRawData() + compressedInfo.offset,compressedInfo.size,
+                                                [srcData](const void *) { });
+    }
+
     switch (format)
     {
     case TexTypeUnsignedByte:
@@ -189,142 +264,155 @@ bool TextureMTL::createInRenderer(const RenderSetupInfo *inSetupInfo)
     // "Don't use the following pixel formats: r8Unorm_srgb, b5g6r5Unorm, a1bgr5Unorm, abgr4Unorm, bgr5A1Unorm, or any XR10 or YUV formats."
     // https://developer.apple.com/documentation/metal/developing_metal_apps_that_run_in_simulator
 
-    // TODO: Missing all the compressed formats
-    switch (format)
+    if (isCompressed)
     {
-        case TexTypeUnsignedByte:
-            pixFormat = MTLPixelFormatRGBA8Unorm;
-            // Note: Render target.  this is goofy
-            if (!texData)
-            {
-                pixFormat = MTLPixelFormatBGRA8Unorm;
-            }
-            bytesPerRow = 4*width;
-            break;
-        case TexTypeShort565:
-            // TODO: These aren't the right order
-#if TARGET_OS_MACCATALYST
-            // Marked as `API_AVAILABLE(macCatalyst(14.0))` but produces "MTLTextureDescriptor has invalid pixelFormat (40)" at runtime
-            //if (@available(macCatalyst 14.0, *))
-            //{
-            //    pixFormat = MTLPixelFormatB5G6R5Unorm;
-            //    bytesPerRow = 2*width;
-            //}
-            //else
-            {
+        // Rows of blocks rather than pixels
+        if (!CompressedPixelFormat(inSetupInfo,compressedInfo,pixFormat))
+        {
+            wkLogLevel(Warn,"TextureMTL: Compressed format %d isn't supported here for %s",
+                       (int)compressedInfo.format,name.c_str());
+            return false;
+        }
+        bytesPerRow = compressedInfo.blocksWide() * compressedInfo.bytesPerBlock();
+    }
+    else
+    {
+        switch (format)
+        {
+            case TexTypeUnsignedByte:
+                pixFormat = MTLPixelFormatRGBA8Unorm;
+                // Note: Render target.  this is goofy
+                if (!texData)
+                {
+                    pixFormat = MTLPixelFormatBGRA8Unorm;
+                }
+                bytesPerRow = 4*width;
+                break;
+            case TexTypeShort565:
+                // TODO: These aren't the right order
+    #if TARGET_OS_MACCATALYST
+                // Marked as `API_AVAILABLE(macCatalyst(14.0))` but produces "MTLTextureDescriptor has invalid pixelFormat (40)" at runtime
+                //if (@available(macCatalyst 14.0, *))
+                //{
+                //    pixFormat = MTLPixelFormatB5G6R5Unorm;
+                //    bytesPerRow = 2*width;
+                //}
+                //else
+                {
+                    // Requires conversion
+                    pixFormat = MTLPixelFormatRGBA8Unorm;
+                    bytesPerRow = 4*width;
+                }
+    #elif TARGET_OS_SIMULATOR
                 // Requires conversion
                 pixFormat = MTLPixelFormatRGBA8Unorm;
                 bytesPerRow = 4*width;
-            }
-#elif TARGET_OS_SIMULATOR
-            // Requires conversion
-            pixFormat = MTLPixelFormatRGBA8Unorm;
-            bytesPerRow = 4*width;
-#else
-            pixFormat = MTLPixelFormatB5G6R5Unorm;
-            bytesPerRow = 2*width;
-#endif
-            break;
-        case TexTypeShort4444:
-            // TODO: These aren't the right order
-#if TARGET_OS_MACCATALYST
-            if (@available(macCatalyst 14.0, *))
-            {
+    #else
+                pixFormat = MTLPixelFormatB5G6R5Unorm;
+                bytesPerRow = 2*width;
+    #endif
+                break;
+            case TexTypeShort4444:
+                // TODO: These aren't the right order
+    #if TARGET_OS_MACCATALYST
+                if (@available(macCatalyst 14.0, *))
+                {
+                    pixFormat = MTLPixelFormatABGR4Unorm;
+                    bytesPerRow = 2*width;
+                }
+                else
+                {
+                    pixFormat = MTLPixelFormatRGBA8Unorm;
+                    bytesPerRow = 4*width;
+                }
+    #elif TARGET_OS_SIMULATOR
+                // Requires conversion
+                pixFormat = MTLPixelFormatRGBA8Unorm;
+                bytesPerRow = 4*width;
+    #else
                 pixFormat = MTLPixelFormatABGR4Unorm;
                 bytesPerRow = 2*width;
-            }
-            else
-            {
+    #endif
+                break;
+            case TexTypeShort5551:
+                // TODO: These aren't the right order
+    #if TARGET_OS_MACCATALYST
+                if (@available(macCatalyst 14.0, *))
+                {
+                    pixFormat = MTLPixelFormatA1BGR5Unorm;
+                    bytesPerRow = 2*width;
+                }
+                else
+                {
+                    pixFormat = MTLPixelFormatRGBA8Unorm;
+                    bytesPerRow = 4*width;
+                }
+    #elif TARGET_OS_SIMULATOR
+                // Requires conversion
                 pixFormat = MTLPixelFormatRGBA8Unorm;
                 bytesPerRow = 4*width;
-            }
-#elif TARGET_OS_SIMULATOR
-            // Requires conversion
-            pixFormat = MTLPixelFormatRGBA8Unorm;
-            bytesPerRow = 4*width;
-#else
-            pixFormat = MTLPixelFormatABGR4Unorm;
-            bytesPerRow = 2*width;
-#endif
-            break;
-        case TexTypeShort5551:
-            // TODO: These aren't the right order
-#if TARGET_OS_MACCATALYST
-            if (@available(macCatalyst 14.0, *))
-            {
+    #else
                 pixFormat = MTLPixelFormatA1BGR5Unorm;
                 bytesPerRow = 2*width;
-            }
-            else
-            {
-                pixFormat = MTLPixelFormatRGBA8Unorm;
+    #endif
+                break;
+            case TexTypeSingleChannel:
+                pixFormat = MTLPixelFormatA8Unorm;
+                // Nudge up the size a bit
+                bytesPerRow = width;
+                break;
+            case TexTypeDoubleChannel:
+                pixFormat = MTLPixelFormatRG8Unorm;
+                bytesPerRow = 2*width;
+                break;
+            case TexTypeSingleFloat16:
+                pixFormat = MTLPixelFormatR16Float;
+                bytesPerRow = 2*width;
+                break;
+            case TexTypeSingleFloat32:
+                pixFormat = MTLPixelFormatR32Float;
                 bytesPerRow = 4*width;
-            }
-#elif TARGET_OS_SIMULATOR
-            // Requires conversion
-            pixFormat = MTLPixelFormatRGBA8Unorm;
-            bytesPerRow = 4*width;
-#else
-            pixFormat = MTLPixelFormatA1BGR5Unorm;
-            bytesPerRow = 2*width;
-#endif
-            break;
-        case TexTypeSingleChannel:
-            pixFormat = MTLPixelFormatA8Unorm;
-            // Nudge up the size a bit
-            bytesPerRow = width;
-            break;
-        case TexTypeDoubleChannel:
-            pixFormat = MTLPixelFormatRG8Unorm;
-            bytesPerRow = 2*width;
-            break;
-        case TexTypeSingleFloat16:
-            pixFormat = MTLPixelFormatR16Float;
-            bytesPerRow = 2*width;
-            break;
-        case TexTypeSingleFloat32:
-            pixFormat = MTLPixelFormatR32Float;
-            bytesPerRow = 4*width;
-            break;
-        case TexTypeDoubleFloat16:
-            pixFormat = MTLPixelFormatRG16Float;
-            bytesPerRow = 4*width;
-            break;
-        case TexTypeDoubleFloat32:
-            pixFormat = MTLPixelFormatRG32Float;
-            bytesPerRow = 8*width;
-            break;
-        case TexTypeQuadFloat16:
-            pixFormat = MTLPixelFormatRGBA16Float;
-            bytesPerRow = 8*width;
-            break;
-        case TexTypeQuadFloat32:
-            pixFormat = MTLPixelFormatRGBA32Float;
-            bytesPerRow = 16*width;
-            break;
-        case TexTypeDepthFloat32:
-            pixFormat = MTLPixelFormatDepth32Float;
-            bytesPerRow = 4*width;
-            break;
-        case TexTypeSingleInt16:
-            pixFormat = MTLPixelFormatR16Sint;
-            bytesPerRow = 2*width;
-            break;
-        case TexTypeSingleUInt32:
-            pixFormat = MTLPixelFormatR32Uint;
-            bytesPerRow = 4*width;
-            break;
-        case TexTypeDoubleUInt32:
-            pixFormat = MTLPixelFormatRG32Uint;
-            bytesPerRow = 8*width;
-            break;
-        case TexTypeQuadUInt32:
-            pixFormat = MTLPixelFormatRGBA32Uint;
-            bytesPerRow = 16*width;
-            break;
-        default:
-            wkLogLevel(Error,"Unsupported texture format %d", format);
-            return false;
+                break;
+            case TexTypeDoubleFloat16:
+                pixFormat = MTLPixelFormatRG16Float;
+                bytesPerRow = 4*width;
+                break;
+            case TexTypeDoubleFloat32:
+                pixFormat = MTLPixelFormatRG32Float;
+                bytesPerRow = 8*width;
+                break;
+            case TexTypeQuadFloat16:
+                pixFormat = MTLPixelFormatRGBA16Float;
+                bytesPerRow = 8*width;
+                break;
+            case TexTypeQuadFloat32:
+                pixFormat = MTLPixelFormatRGBA32Float;
+                bytesPerRow = 16*width;
+                break;
+            case TexTypeDepthFloat32:
+                pixFormat = MTLPixelFormatDepth32Float;
+                bytesPerRow = 4*width;
+                break;
+            case TexTypeSingleInt16:
+                pixFormat = MTLPixelFormatR16Sint;
+                bytesPerRow = 2*width;
+                break;
+            case TexTypeSingleUInt32:
+                pixFormat = MTLPixelFormatR32Uint;
+                bytesPerRow = 4*width;
+                break;
+            case TexTypeDoubleUInt32:
+                pixFormat = MTLPixelFormatRG32Uint;
+                bytesPerRow = 8*width;
+                break;
+            case TexTypeQuadUInt32:
+                pixFormat = MTLPixelFormatRGBA32Uint;
+                bytesPerRow = 16*width;
+                break;
+            default:
+                wkLogLevel(Error,"Unsupported texture format %d", format);
+                return false;
+        }
     }
 
     // Set up the texture and upload the data
@@ -362,8 +450,46 @@ bool TextureMTL::createInRenderer(const RenderSetupInfo *inSetupInfo)
     }
 
     RenderSetupInfoMTL *setupInfo = (RenderSetupInfoMTL *)inSetupInfo;
-    const size_t size = bytesPerRow * height;
-    texBuf = setupInfo->heapManage.newTextureWithDescriptor(desc,size);
+    const size_t size = bytesPerRow * (isCompressed ? compressedInfo.blocksHigh() : height);
+
+    // Put the data in a staging buffer now and let the GPU copy it into private
+    //  storage.  The texture can't come off a heap since those are shared storage.
+    // Compressed data is small enough to go straight in.
+    if (asyncUpload && texData && !usesMipmaps && !isCompressed)
+    {
+        if (const auto convData = convertData())
+        {
+            stagingBuf = [setupInfo->mtlDevice newBufferWithBytes:convData->getRawData()
+                                                           length:convData->getLen()
+                                                          options:MTLResourceStorageModeShared];
+        }
+        if (stagingBuf)
+        {
+            desc.storageMode = MTLStorageModePrivate;
+            texBuf.heap = nil;
+            texBuf.tex = [setupInfo->mtlDevice newTextureWithDescriptor:desc];
+            if (texBuf.tex)
+            {
+                stagingBytesPerRow = bytesPerRow;
+                if (!name.empty())
+                {
+                    [texBuf.tex setLabel:[NSString stringWithFormat:@"%s",name.c_str()]];
+                }
+                texData.reset();
+                return true;
+            }
+            stagingBuf = nil;
+        }
+    }
+
+    // Data textures of the same size are interchangeable once they're overwritten.
+    // Render targets and mipmapped textures get their own.
+    const bool usePool = texData && !usesMipmaps;
+    texBuf = setupInfo->heapManage.newTextureWithDescriptor(desc,size,usePool);
+    if (usePool)
+    {
+        texPool = setupInfo->heapManage.getTexturePool();
+    }
 
     if (!name.empty())
     {
@@ -388,9 +514,26 @@ bool TextureMTL::createInRenderer(const RenderSetupInfo *inSetupInfo)
     return texBuf.tex != nil;
 }
 
+void TextureMTL::finishUploadInRenderer(SceneRenderer *renderer)
+{
+    if (stagingBuf && texBuf.tex)
+    {
+        ((SceneRendererMTL *)renderer)->addTextureUpload(stagingBuf,stagingBytesPerRow,texBuf.tex,
+                                                         MTLRegionMake2D(0,0,width,height));
+    }
+    stagingBuf = nil;
+}
+
 void TextureMTL::destroyInRenderer(const RenderSetupInfo *inSetupInfo,Scene *inScene)
 {
+    // This happens after the GPU is done with the texture, so it's safe to reuse
+    if (const auto pool = texPool.lock())
+    {
+        pool->returnTexture(texBuf);
+    }
+    texPool.reset();
     texBuf.tex = nil;
+    stagingBuf = nil;
 }
 
 }
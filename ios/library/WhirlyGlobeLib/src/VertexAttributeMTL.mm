@@ -56,6 +56,11 @@ int VertexAttributeMTL::sizeMTL() const
         case BDIntType:
             return 4;
             break;
+        case BDHalf2Type:
+        case BDShort2NormType:
+        case BDChar4NormType:
+            return 4;
+            break;
         default:
             return 0;
     }
@@ -84,6 +89,16 @@ MTLVertexFormat VertexAttributeMTL::formatMTL() const
         case BDIntType:
             return MTLVertexFormatInt;
             break;
+        // The vertex fetch turns these back into floats for the shader
+        case BDHalf2Type:
+            return MTLVertexFormatHalf2;
+            break;
+        case BDShort2NormType:
+            return MTLVertexFormatShort2Normalized;
+            break;
+        case BDChar4NormType:
+            return MTLVertexFormatChar4Normalized;
+            break;
         default:
             return MTLVertexFormatFloat;
     }
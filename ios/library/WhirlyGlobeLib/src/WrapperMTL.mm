@@ -108,6 +108,7 @@ void BufferEntryMTL::clear()
 {
     heap = nil;  buffer = nil;  offset = 0;
     valid = false;
+    subBuffer.reset();
 }
 
 BufferBuilderMTL::BufferBuilderMTL(RenderSetupInfoMTL *setupInfo)
@@ -168,12 +169,129 @@ BufferEntryMTL BufferBuilderMTL::buildBuffer()
     return buffer;
 }
 
+BufferEntryMTL BufferBuilderMTL::buildSharedBuffer()
+{
+    if ([data length] == 0)
+        return BufferEntryMTL();
+
+    BufferEntryMTL buffer = setupInfo->heapManage.allocateSubBuffer([data mutableBytes],[data length]);
+
+    // The pieces are relative to wherever we ended up
+    for (auto bufRef : bufferRefs) {
+        bufRef->heap = buffer.heap;
+        bufRef->buffer = buffer.buffer;
+        bufRef->offset += buffer.offset;
+    }
+
+    bufferRefs.clear();
+
+    return buffer;
+}
+
 TextureEntryMTL::TextureEntryMTL()
 : heap(nil), tex(nil)
 {
     
 }
 
+TexturePoolMTL::TexturePoolMTL(size_t maxBytes)
+: maxBytes(maxBytes)
+{
+}
+
+TexturePoolMTL::PoolKey TexturePoolMTL::makeKey(MTLPixelFormat format,NSUInteger width,NSUInteger height,
+                                                MTLTextureUsage usage,MTLStorageMode storageMode)
+{
+    return PoolKey(format,width,height,usage,storageMode);
+}
+
+TextureEntryMTL TexturePoolMTL::getTexture(MTLTextureDescriptor *desc)
+{
+    if (desc.mipmapLevelCount > 1 || desc.arrayLength > 1 || desc.textureType != MTLTextureType2D)
+    {
+        return TextureEntryMTL();
+    }
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    const auto it = textures.find(makeKey(desc.pixelFormat,desc.width,desc.height,desc.usage,desc.storageMode));
+    if (it == textures.end() || it->second.empty())
+    {
+        return TextureEntryMTL();
+    }
+
+    const PoolEntry entry = it->second.back();
+    it->second.pop_back();
+    if (it->second.empty())
+    {
+        textures.erase(it);
+    }
+    curBytes -= entry.bytes;
+
+    return entry.tex;
+}
+
+void TexturePoolMTL::returnTexture(const TextureEntryMTL &tex)
+{
+    id<MTLTexture> mtlTex = tex.tex;
+    if (!mtlTex || mtlTex.mipmapLevelCount > 1 || mtlTex.textureType != MTLTextureType2D)
+    {
+        return;
+    }
+
+    const size_t bytes = mtlTex.allocatedSize;
+
+    // Release these outside the lock
+    std::vector<PoolEntry> toRelease;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        if (bytes > maxBytes)
+        {
+            return;
+        }
+
+        textures[makeKey(mtlTex.pixelFormat,mtlTex.width,mtlTex.height,mtlTex.usage,mtlTex.storageMode)]
+            .push_back(PoolEntry { tex, bytes });
+        curBytes += bytes;
+
+        // Toss the oldest textures from the biggest group until we fit
+        while (curBytes > maxBytes && !textures.empty())
+        {
+            auto biggest = textures.begin();
+            for (auto it = textures.begin(); it != textures.end(); ++it)
+            {
+                if (it->second.size() > biggest->second.size())
+                    biggest = it;
+            }
+            toRelease.push_back(biggest->second.front());
+            biggest->second.erase(biggest->second.begin());
+            if (biggest->second.empty())
+            {
+                textures.erase(biggest);
+            }
+            curBytes -= toRelease.back().bytes;
+        }
+    }
+}
+
+void TexturePoolMTL::setMaxBytes(size_t newMaxBytes)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    maxBytes = newMaxBytes;
+    if (curBytes > maxBytes)
+    {
+        textures.clear();
+        curBytes = 0;
+    }
+}
+
+void TexturePoolMTL::clear()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    textures.clear();
+    curBytes = 0;
+}
+
 ResourceRefsMTL::ResourceRefsMTL(bool trackHolds)
 : trackHolds(trackHolds)
 {
@@ -297,24 +415,83 @@ const bool HeapManagerMTL::UseHeaps =
 #endif
 
 HeapManagerMTL::HeapManagerMTL(id<MTLDevice> mtlDevice)
-: mtlDevice(mtlDevice)
+: mtlDevice(mtlDevice),
+  texPool(std::make_shared<TexturePoolMTL>(32 * MB)),
+  subPool(std::make_shared<SubBufferPool>())
 {
     memAlign = [mtlDevice heapBufferSizeAndAlignWithLength:1 options:MTLResourceUsageRead].align;
 }
 
 void HeapManagerMTL::updateHeaps()
 {
-    for (unsigned int ig=0;ig<MaxType;ig++) {
-        for (auto heap : heapGroups[ig].heaps) {
-            heap->maxAvailSize = [heap->heap maxAvailableSizeWithAlignment:memAlign];
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        for (unsigned int ig=0;ig<MaxType;ig++) {
+            for (auto heap : heapGroups[ig].heaps) {
+                heap->maxAvailSize = [heap->heap maxAvailableSizeWithAlignment:memAlign];
+            }
         }
     }
-    
+
+    std::lock_guard<std::mutex> guardLock(texLock);
     for (auto texHeap : texGroups.heaps) {
         texHeap->maxAvailSize = [texHeap->heap maxAvailableSizeWithAlignment:memAlign];
     }
 }
 
+void HeapManagerMTL::purgeHeaps(HeapSet &heapSet)
+{
+    for (auto it = heapSet.begin(); it != heapSet.end(); ) {
+        if ([(*it)->heap usedSize] == 0) {
+            it = heapSet.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void HeapManagerMTL::purge()
+{
+    // Pooled textures go back to their heaps first
+    texPool->clear();
+
+    {
+        std::lock_guard<std::mutex> guardLock(subPool->lock);
+        for (auto &slabs : subPool->slabs) {
+            slabs.erase(std::remove_if(slabs.begin(), slabs.end(),
+                                       [](const SubBufferSlabRef &slab) { return slab->freeSlots.size() == slab->numSlots; }),
+                        slabs.end());
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        for (unsigned int ig=0;ig<MaxType;ig++) {
+            purgeHeaps(heapGroups[ig].heaps);
+        }
+    }
+
+    std::lock_guard<std::mutex> guardLock(texLock);
+    purgeHeaps(texGroups.heaps);
+}
+
+void HeapManagerMTL::getUsage(size_t &bufferBytes,size_t &textureBytes)
+{
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        for (unsigned int ig=0;ig<MaxType;ig++) {
+            for (const auto &heapInfo : heapGroups[ig].heaps) {
+                bufferBytes += [heapInfo->heap usedSize];
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> guardLock(texLock);
+    for (const auto &heapInfo : texGroups.heaps) {
+        textureBytes += [heapInfo->heap usedSize];
+    }
+}
+
 HeapManagerMTL::HeapInfoRef HeapManagerMTL::allocateHeap(unsigned size, unsigned minSize, MTLStorageMode mode)
 {
     MTLHeapDescriptor *heapDesc = [[MTLHeapDescriptor alloc] init];
@@ -448,9 +625,91 @@ BufferEntryMTL HeapManagerMTL::allocateBuffer(HeapType heapType,const void *data
     return buffer;
 }
 
-TextureEntryMTL HeapManagerMTL::newTextureWithDescriptor(MTLTextureDescriptor *desc,size_t size)
+BufferEntryMTL HeapManagerMTL::allocateSubBuffer(const void *data,size_t size)
+{
+    if (size == 0 || size > SubBufferMaxSize || memAlign > SubBufferMaxSize)
+    {
+        return allocateBuffer(Drawable,data,size);
+    }
+
+    // Round up to the slot size, which keeps the pieces aligned
+    size_t slotSize = memAlign;
+    size_t sizeClass = 0;
+    for (; slotSize < size; slotSize *= 2, sizeClass++);
+
+    SubBufferSlabRef slab;
+    int slot = -1;
+    {
+        std::lock_guard<std::mutex> guardLock(subPool->lock);
+        if (subPool->slabs.size() <= sizeClass)
+        {
+            subPool->slabs.resize(sizeClass + 1);
+        }
+        auto &slabs = subPool->slabs[sizeClass];
+        for (const auto &thisSlab : slabs)
+        {
+            if (!thisSlab->freeSlots.empty())
+            {
+                slab = thisSlab;
+                break;
+            }
+        }
+        if (!slab)
+        {
+            const BufferEntryMTL slabBuff = allocateBuffer(Drawable,SubBufferSlabSize);
+            if (!slabBuff.buffer)
+            {
+                return slabBuff;
+            }
+            slab = std::make_shared<SubBufferSlab>();
+            slab->heap = slabBuff.heap;
+            slab->buffer = slabBuff.buffer;
+            slab->numSlots = SubBufferSlabSize / slotSize;
+            // Hand out from the front, so the rest of the slab stays untouched as long as possible
+            for (int ii = (int)slab->numSlots - 1; ii >= 0; ii--)
+            {
+                slab->freeSlots.push_back(ii);
+            }
+            slabs.push_back(slab);
+        }
+        slot = slab->freeSlots.back();
+        slab->freeSlots.pop_back();
+    }
+
+    BufferEntryMTL buffer;
+    buffer.heap = slab->heap;
+    buffer.buffer = slab->buffer;
+    buffer.offset = (int)(slot * slotSize);
+    buffer.valid = true;
+    if (data)
+    {
+        memcpy((unsigned char *)[buffer.buffer contents] + buffer.offset, data, size);
+    }
+
+    const std::weak_ptr<SubBufferPool> weakPool = subPool;
+    buffer.subBuffer = std::shared_ptr<void>(nullptr, [weakPool,slab,slot](void *) {
+        if (const auto pool = weakPool.lock())
+        {
+            std::lock_guard<std::mutex> guardLock(pool->lock);
+            slab->freeSlots.push_back(slot);
+        }
+    });
+
+    return buffer;
+}
+
+TextureEntryMTL HeapManagerMTL::newTextureWithDescriptor(MTLTextureDescriptor *desc,size_t size,bool usePool)
 {
     TextureEntryMTL tex;
+
+    if (usePool)
+    {
+        tex = texPool->getTexture(desc);
+        if (tex.tex)
+        {
+            return tex;
+        }
+    }
     
     if (UseHeaps)
     {
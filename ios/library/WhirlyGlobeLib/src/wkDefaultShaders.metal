@@ -75,6 +75,22 @@ float calculateFade(constant Uniforms &uni,
     return fade;
 }
 
+// Clip space position of a point in a drawable's own coordinates.
+// A drawable matrix (usually the center the points are relative to) is normally
+//  folded into the view in doubles on the CPU, rather than applied here in floats.
+float4 drawablePosition(constant Uniforms &uni,
+                        constant UniformDrawStateA &uniA,
+                        float3 pos)
+{
+    if (uniA.hasMvMatrix && !uniA.clipCoords)
+        return uni.pMatrix * (uniA.mvMatrix * float4(pos,1.0) + float4(uni.mvCopyOffset,0.0));
+
+    const float4 v = uniA.singleMat * float4(pos,1.0);
+    if (uniA.clipCoords)
+        return v;
+    return uni.pMatrix * (uni.mvMatrix * v + uni.mvMatrixDiff * v);
+}
+
 // Get zoom from appropriate slot
 float ZoomFromSlot(constant Uniforms &uniforms,int zoomSlot)
 {
@@ -246,13 +262,8 @@ vertex ProjVertexB vertexLineOnly_flat(
 {
     ProjVertexB outVert;
     
-    float3 vertPos = (vertArgs.uniDrawState.singleMat * float4(vert.position,1.0)).xyz;
-
     outVert.color = float4(vert.color) * calculateFade(uniforms,vertArgs.uniDrawState);
-    if (vertArgs.uniDrawState.clipCoords)
-        outVert.position = float4(vertPos,1.0);
-    else
-        outVert.position = uniforms.mvpMatrix * float4(vertPos,1.0);
+    outVert.position = drawablePosition(uniforms,vertArgs.uniDrawState,vert.position);
     
     return outVert;
 }
@@ -328,14 +339,7 @@ vertex ProjVertexTriA vertexTri_noLight(
     ProjVertexTriA outVert;
     outVert.maskIDs = uint2(0,0);
 
-    float3 vertPos = (vertArgs.uniDrawState.singleMat * float4(vert.position,1.0)).xyz;
-    
-    if (vertArgs.uniDrawState.clipCoords)
-        outVert.position = float4(vertPos,1.0);
-    else {
-        float4 pt = uniforms.pMatrix * (uniforms.mvMatrix * float4(vertPos,1.0) + uniforms.mvMatrixDiff * float4(vertPos,1.0));
-        outVert.position = pt;
-    }
+    outVert.position = drawablePosition(uniforms,vertArgs.uniDrawState,vert.position);
 
     outVert.color = vert.color * calculateFade(uniforms,vertArgs.uniDrawState);
     
@@ -355,14 +359,7 @@ vertex ProjVertexTriA vertexTri_noLightExp(
     ProjVertexTriA outVert;
     outVert.maskIDs = uint2(0,0);
 
-    float3 vertPos = (vertArgs.uniDrawState.singleMat * float4(vert.position,1.0)).xyz;
-    
-    if (vertArgs.uniDrawState.clipCoords)
-        outVert.position = float4(vertPos,1.0);
-    else {
-        float4 pt = uniforms.pMatrix * (uniforms.mvMatrix * float4(vertPos,1.0) + uniforms.mvMatrixDiff * float4(vertPos,1.0));
-        outVert.position = pt;
-    }
+    outVert.position = drawablePosition(uniforms,vertArgs.uniDrawState,vert.position);
 
     // Sort out expressions for color and opacity
     float4 color = vert.color;
@@ -399,14 +396,7 @@ vertex ProjVertexTriA vertexTri_light(
     ProjVertexTriA outVert;
     outVert.maskIDs = uint2(0,0);
     
-    float3 vertPos = (vertArgs.uniDrawState.singleMat * float4(vert.position,1.0)).xyz;
-    if (vertArgs.uniDrawState.clipCoords)
-        outVert.position = float4(vertPos,1.0);
-    else {
-        float4 pt = uniforms.pMatrix * (uniforms.mvMatrix * vertArgs.uniDrawState.singleMat * float4(vert.position,1.0) +
-                                        uniforms.mvMatrixDiff * vertArgs.uniDrawState.singleMat * float4(vert.position,1.0));
-        outVert.position = pt;
-    }
+    outVert.position = drawablePosition(uniforms,vertArgs.uniDrawState,vert.position);
     
     outVert.color = resolveLighting(vert.position,
                                     vert.normal,
@@ -438,14 +428,7 @@ vertex ProjVertexTriA vertexTri_lightExp(
     ProjVertexTriA outVert;
     outVert.maskIDs = uint2(0,0);
 
-    float3 vertPos = (vertArgs.uniDrawState.singleMat * float4(vert.position,1.0)).xyz;
-    if (vertArgs.uniDrawState.clipCoords)
-        outVert.position = float4(vertPos,1.0);
-    else {
-        float4 pt = uniforms.pMatrix * (uniforms.mvMatrix * vertArgs.uniDrawState.singleMat * float4(vert.position,1.0) +
-                                        uniforms.mvMatrixDiff * vertArgs.uniDrawState.singleMat * float4(vert.position,1.0));
-        outVert.position = pt;
-    }
+    outVert.position = drawablePosition(uniforms,vertArgs.uniDrawState,vert.position);
     
     // Sort out expressions for color and opacity
     float4 color = vert.color;
@@ -484,6 +467,39 @@ fragment float4 fragmentTri_basic(
     return vert.color;
 }
 
+// Glyphs stored as distance fields, edge at 0.5, blended over about a pixel
+fragment float4 fragmentTri_sdf(
+                ProjVertexTriA vert [[stage_in]],
+                constant Uniforms &uniforms [[ buffer(WKSFragUniformArgBuffer) ]],
+                constant FragTriArgBufferB & fragArgs [[buffer(WKSFragmentArgBuffer)]],
+                constant RegularTextures & texArgs [[buffer(WKSFragTextureArgBuffer)]])
+{
+    int numTextures = TexturesBase(texArgs.texPresent);
+    if (numTextures > 0) {
+        constexpr sampler sampler2d(coord::normalized, filter::linear);
+        float dist = texArgs.tex[0].sample(sampler2d, vert.texCoord).a;
+        float width = max(fwidth(dist), 0.001);
+        return vert.color * smoothstep(0.5 - width, 0.5 + width, dist);
+    }
+    return vert.color;
+}
+
+// Vertex shader that passes an object ID through for the selection render target
+vertex ProjVertexTriA vertexTri_id(
+                VertexTriID vert [[stage_in]],
+                constant Uniforms &uniforms [[ buffer(WKSVertUniformArgBuffer) ]],
+                constant VertexTriArgBufferA & vertArgs [[buffer(WKSVertexArgBuffer)]])
+{
+    ProjVertexTriA outVert;
+    outVert.maskIDs = uint2(vert.maskID,0);
+    outVert.color = float4(1.0);
+    outVert.texCoord = float2(0.0);
+
+    outVert.position = drawablePosition(uniforms,vertArgs.uniDrawState,vert.position);
+
+    return outVert;
+}
+
 // Fragment shader that pulls the mask ID out only
 fragment unsigned int fragmentTri_mask(ProjVertexTriA vert [[stage_in]],
                               constant Uniforms &uniforms [[ buffer(WKSFragUniformArgBuffer) ]],
@@ -504,13 +520,7 @@ vertex ProjVertexTriB vertexTri_multiTex(
     ProjVertexTriB outVert;
 
     float3 vertPos = (vertArgs.uniDrawState.singleMat * float4(vert.position,1.0)).xyz;
-    if (vertArgs.uniDrawState.clipCoords)
-        outVert.position = float4(vertPos,1.0);
-    else {
-        float4 pt = uniforms.pMatrix * (uniforms.mvMatrix * vertArgs.uniDrawState.singleMat * float4(vert.position,1.0) +
-                                        uniforms.mvMatrixDiff * vertArgs.uniDrawState.singleMat * float4(vert.position,1.0));
-        outVert.position = pt;
-    }
+    outVert.position = drawablePosition(uniforms,vertArgs.uniDrawState,vert.position);
     outVert.color = resolveLighting(vertPos,
                                     vert.normal,
                                     float4(vert.color),
@@ -534,6 +544,16 @@ vertex ProjVertexTriB vertexTri_multiTex(
     return outVert;
 }
 
+// Blend between the two textures, worked out from the time if the drawable is cycling through them
+float TexInterp(constant Uniforms &uniforms,constant UniformDrawStateA &drawState)
+{
+    if (drawState.texAnimPeriod <= 0.0)
+        return drawState.interp;
+
+    const float t = fract(max(uniforms.currentTime - drawState.texAnimStart,0.0) / drawState.texAnimPeriod);
+    return fract(t * drawState.texAnimTextures);
+}
+
 // Fragment shader that handles to two textures
 fragment float4 fragmentTri_multiTex(
         ProjVertexTriB vert [[stage_in]],
@@ -554,8 +574,96 @@ fragment float4 fragmentTri_multiTex(
         float4 color0 = texArgs.tex[0].sample(sampler2d, vert.texCoord0);
         // Note: There are times we may not want to reuse the same texture coordinates
         float4 color1 = texArgs.tex[1].sample(sampler2d, vert.texCoord0);
-        return vert.color * mix(color0,color1,fragArgs.uniDrawState.interp);
+        return vert.color * mix(color0,color1,TexInterp(uniforms,fragArgs.uniDrawState));
+    }
+}
+
+// Vertex shader for layered textures
+// The layers can come from different levels, so the fragment shader works out their coordinates
+vertex ProjVertexTriB vertexTri_composite(
+                VertexTriB vert [[stage_in]],
+                constant Uniforms &uniforms [[ buffer(WKSVertUniformArgBuffer) ]],
+                constant Lighting &lighting [[ buffer(WKSVertLightingArgBuffer) ]],
+                constant VertexTriArgBufferB & vertArgs [[buffer(WKSVertexArgBuffer)]])
+{
+    ProjVertexTriB outVert;
+
+    const float4 v = vertArgs.uniDrawState.singleMat * float4(vert.position,1.0);
+    outVert.position = drawablePosition(uniforms,vertArgs.uniDrawState,vert.position);
+    outVert.color = resolveLighting(v.xyz,
+                                    vert.normal,
+                                    float4(vert.color),
+                                    lighting,
+                                    uniforms.mvpMatrix) *
+                    calculateFade(uniforms,vertArgs.uniDrawState);
+    outVert.texCoord0 = vert.texCoord0;
+    outVert.texCoord1 = vert.texCoord0;
+
+    return outVert;
+}
+
+// Up to four layers, each drawn over the ones before.  Colors are premultiplied.
+fragment float4 fragmentTri_composite(
+        ProjVertexTriB vert [[stage_in]],
+        constant Uniforms &uniforms [[ buffer(WKSFragUniformArgBuffer) ]],
+        constant RegularTextures & texArgs [[buffer(WKSFragTextureArgBuffer)]])
+{
+    constexpr sampler sampler2d(coord::normalized, filter::linear);
+    float4 color = float4(0.0);
+    for (int ii=0;ii<4;ii++) {
+        if (texArgs.texPresent & (1<<ii)) {
+            const float4 layer = texArgs.tex[ii].sample(sampler2d, resolveTexCoords(vert.texCoord0,texArgs,ii));
+            color = layer + color * (1.0 - layer.a);
+        }
+    }
+    return vert.color * color;
+}
+
+// Vertex shader for tiles raised by the elevation texture in the second slot
+// Skirts are raised along with the edges they hang from
+vertex ProjVertexTriB vertexTri_terrain(
+                VertexTriB vert [[stage_in]],
+                constant Uniforms &uniforms [[ buffer(WKSVertUniformArgBuffer) ]],
+                constant Lighting &lighting [[ buffer(WKSVertLightingArgBuffer) ]],
+                constant VertexTriArgBufferB & vertArgs [[buffer(WKSVertexArgBuffer)]],
+                constant RegularTextures & texArgs [[buffer(WKSVertTextureArgBuffer)]])
+{
+    ProjVertexTriB outVert;
+
+    // Elevation pixels are packed, so they can't be blended
+    float3 pos = vert.position;
+    if (texArgs.texPresent & (1<<1)) {
+        constexpr sampler samplerElev(coord::normalized, filter::nearest, address::clamp_to_edge);
+        const float3 elev = texArgs.tex[1].sample(samplerElev, resolveTexCoords(vert.texCoord0,texArgs,1), level(0)).rgb;
+        const float4 decode = vertArgs.uniDrawState.elevDecode;
+        pos += normalize(vert.normal) * (dot(elev, decode.xyz) + decode.w);
     }
+
+    const float4 v = vertArgs.uniDrawState.singleMat * float4(pos,1.0);
+    outVert.position = drawablePosition(uniforms,vertArgs.uniDrawState,pos);
+    outVert.color = resolveLighting(v.xyz,
+                                    vert.normal,
+                                    float4(vert.color),
+                                    lighting,
+                                    uniforms.mvpMatrix) *
+                    calculateFade(uniforms,vertArgs.uniDrawState);
+    outVert.texCoord0 = resolveTexCoords(vert.texCoord0,texArgs,0);
+    outVert.texCoord1 = outVert.texCoord0;
+
+    return outVert;
+}
+
+// Imagery from the first slot.  The second is the elevation.
+fragment float4 fragmentTri_terrain(
+        ProjVertexTriB vert [[stage_in]],
+        constant Uniforms &uniforms [[ buffer(WKSFragUniformArgBuffer) ]],
+        constant RegularTextures & texArgs [[buffer(WKSFragTextureArgBuffer)]])
+{
+    if (!(texArgs.texPresent & 1))
+        return vert.color;
+
+    constexpr sampler sampler2d(coord::normalized, filter::linear);
+    return vert.color * texArgs.tex[0].sample(sampler2d, vert.texCoord0);
 }
 
 vertex ProjVertexTriNightDay vertexTri_multiTex_nightDay(
@@ -568,12 +676,7 @@ vertex ProjVertexTriNightDay vertexTri_multiTex_nightDay(
     ProjVertexTriNightDay outVert;
 
     const float3 vertPos = (vertArgs.uniDrawState.singleMat * float4(vert.position,1.0)).xyz;
-    if (vertArgs.uniDrawState.clipCoords)
-        outVert.position = float4(vertPos,1.0);
-    else {
-        const float4 v = vertArgs.uniDrawState.singleMat * float4(vert.position,1.0);
-        outVert.position = uniforms.pMatrix * (uniforms.mvMatrix * v + uniforms.mvMatrixDiff * v);
-    }
+    outVert.position = drawablePosition(uniforms,vertArgs.uniDrawState,vert.position);
 
     outVert.color = resolveLighting(vertPos, vert.normal, float4(vert.color),
                                     lighting, uniforms.mvpMatrix) *
@@ -650,7 +753,7 @@ fragment float4 fragmentTri_multiTexRamp(ProjVertexTriB vert [[stage_in]],
         float index0 = texArgs.tex[0].sample(sampler2d, vert.texCoord0).r;
         // Note: There are times we may not want to reuse the same texture coordinates
         float index1 = texArgs.tex[1].sample(sampler2d, vert.texCoord0).r;
-        index = mix(index0,index1,fragArgs.uniDrawState.interp);
+        index = mix(index0,index1,TexInterp(uniforms,fragArgs.uniDrawState));
     }
 
     // Use the lookup ramp if it's here
@@ -662,6 +765,68 @@ fragment float4 fragmentTri_multiTexRamp(ProjVertexTriB vert [[stage_in]],
     return vert.color * lookupColor;
 }
 
+struct FragTriDataTileArgBuffer {
+    UniformDrawStateA uniDrawState      [[ id(WKSUniformDrawStateEntry) ]];
+    UniformDataTile dataTile            [[ id(WKSUniformDataTileEntry) ]];
+    bool hasTextures;
+};
+
+// Raw data value at the given spot, blended between frames if there are two
+float DataTileValue(constant RegularTextures &texArgs,float2 texCoord0,float2 texCoord1,float interp)
+{
+    constexpr sampler sampler2d(coord::normalized, filter::linear, address::clamp_to_edge);
+
+    const float val0 = texArgs.tex[0].sample(sampler2d, texCoord0).r;
+    if (TexturesBase(texArgs.texPresent) <= 1)
+        return val0;
+    return mix(val0, texArgs.tex[1].sample(sampler2d, texCoord1).r, interp);
+}
+
+// Single channel data (elevation, temperature and so on) colored through the lookup ramp,
+//  with optional thresholds and hillshading.  All the settings come from the program.
+fragment float4 fragmentTri_dataTile(ProjVertexTriB vert [[stage_in]],
+                                     constant Uniforms &uniforms [[ buffer(WKSFragUniformArgBuffer) ]],
+                                     constant FragTriDataTileArgBuffer & fragArgs [[buffer(WKSFragmentArgBuffer)]],
+                                     constant RegularTextures & texArgs [[buffer(WKSFragTextureArgBuffer)]])
+{
+    if (TexturesBase(texArgs.texPresent) == 0)
+        return vert.color;
+
+    constant UniformDataTile &dataTile = fragArgs.dataTile;
+    const float interp = TexInterp(uniforms,fragArgs.uniDrawState);
+    const float val = DataTileValue(texArgs, vert.texCoord0, vert.texCoord1, interp);
+    if ((dataTile.hasNoData && val == dataTile.noDataValue) ||
+        val < dataTile.lowThreshold || val > dataTile.highThreshold)
+        return float4(0.0);
+
+    const float range = dataTile.maxValue - dataTile.minValue;
+    const float index = range != 0.0 ? saturate((val - dataTile.minValue) / range) : 0.0;
+
+    float4 color(index,index,index,1.0);
+    if (TextureIsPresent(texArgs.texPresent, WKSTextureEntryLookup)) {
+        constexpr sampler rampSampler(coord::normalized, filter::linear, address::clamp_to_edge);
+        color = texArgs.tex[WKSTextureEntryLookup].sample(rampSampler,float2(index,0.5));
+    }
+
+    // Slope from the neighboring texels, lit from the light direction
+    if (dataTile.hillshade > 0.0) {
+        const float2 texel0 = 1.0 / float2(texArgs.tex[0].get_width(), texArgs.tex[0].get_height());
+        const float2 texel1 = TexturesBase(texArgs.texPresent) > 1 ?
+                1.0 / float2(texArgs.tex[1].get_width(), texArgs.tex[1].get_height()) : texel0;
+        const float2 dx0(texel0.x,0.0), dy0(0.0,texel0.y);
+        const float2 dx1(texel1.x,0.0), dy1(0.0,texel1.y);
+        const float dzdx = DataTileValue(texArgs, vert.texCoord0 + dx0, vert.texCoord1 + dx1, interp) -
+                           DataTileValue(texArgs, vert.texCoord0 - dx0, vert.texCoord1 - dx1, interp);
+        const float dzdy = DataTileValue(texArgs, vert.texCoord0 + dy0, vert.texCoord1 + dy1, interp) -
+                           DataTileValue(texArgs, vert.texCoord0 - dy0, vert.texCoord1 - dy1, interp);
+        const float3 norm = normalize(float3(-dzdx * dataTile.zScale, -dzdy * dataTile.zScale, 2.0));
+        const float shade = saturate(dot(norm, normalize(dataTile.lightDir)));
+        color.rgb *= mix(1.0, shade, dataTile.hillshade);
+    }
+
+    return vert.color * color;
+}
+
 struct TriWideArgBufferA {
     UniformDrawStateA uniDrawState      [[ id(WKSUniformDrawStateEntry) ]];
     UniformWideVec wideVec              [[ id(WKSUniformWideVecEntry) ]];
@@ -1497,6 +1662,68 @@ vertex ProjVertexTriA vertexTri_screenSpaceExp(
     return outVert;
 }
 
+struct VertexTriSSInstArgBuffer {
+    UniformDrawStateA uniDrawState      [[ id(WKSUniformDrawStateEntry) ]];
+    UniformScreenSpace ss      [[ id(WKSUniformScreenSpaceEntry) ]];
+    UniformModelInstance uniMI          [[ id(WKSUniformModelInstanceEntry) ]];
+    bool hasTextures;
+};
+
+// Screen space vertex shader for rectangles drawn as instances of a unit quad
+// The instance matrix holds the screen corner and edges, the texture corner and edges
+//  and the rotation vector.  The quad's offset picks out which corner we are.
+vertex ProjVertexTriA vertexTri_screenSpaceInst(
+            VertexTriScreenSpace vert [[stage_in]],
+            uint instanceID [[instance_id]],
+            constant Uniforms &uniforms [[ buffer(WKSVertUniformArgBuffer) ]],
+            constant VertexTriSSInstArgBuffer & vertArgs [[buffer(WKSVertexArgBuffer)]],
+            constant RegularTextures & texArgs [[buffer(WKSVertTextureArgBuffer)]],
+            constant VertexTriModelInstance *ssInsts   [[ buffer(WKSVertModelInstanceArgBuffer) ]])
+{
+    ProjVertexTriA outVert;
+    outVert.maskIDs = uint2(0,0);
+
+    const VertexTriModelInstance inst = ssInsts[instanceID];
+
+    float3 pos = (vertArgs.uniDrawState.singleMat * float4(inst.center,1.0)).xyz;
+    if (vertArgs.ss.hasMotion)
+        pos += (uniforms.currentTime - vertArgs.ss.startTime) * inst.dir;
+
+    outVert.color = inst.color * calculateFade(uniforms,vertArgs.uniDrawState);
+    outVert.texCoord = inst.mat[1].zw + vert.offset.x * inst.mat[2].xy + vert.offset.y * inst.mat[2].zw;
+
+    // Convert from model space into display space
+    float4 pt = uniforms.mvMatrix * float4(pos,1.0);
+    pt /= pt.w;
+
+    // Make sure the object is facing the user (only for the globe)
+    float dotProd = 1.0;
+    if (uniforms.globeMode && inst.mat[3].w > 0.5) {
+        float4 testNorm = uniforms.mvNormalMatrix * float4(normalize(pos),0.0);
+        dotProd = dot(-pt.xyz,testNorm.xyz);
+    }
+
+    // Project the point all the way to screen space
+    float4 screenPt = uniforms.pMatrix * (uniforms.mvMatrix * float4(pos,1.0) + uniforms.mvMatrixDiff * float4(pos,1.0));
+    screenPt /= screenPt.w;
+
+    // Corner of the rectangle, then project the rotation into display space and drop the Z
+    const float2 offset = inst.mat[0].xy + vert.offset.x * inst.mat[0].zw + vert.offset.y * inst.mat[1].xy;
+    float2 screenOffset;
+    if (vertArgs.ss.activeRot) {
+        float4 projRot = uniforms.mvNormalMatrix * float4(inst.mat[3].xyz,0.0);
+        float2 rotY = normalize(projRot.xy);
+        float2 rotX(rotY.y,-rotY.x);
+        screenOffset = offset.x*rotX + offset.y*rotY;
+    } else
+        screenOffset = offset;
+
+    float2 scale = float2(2.0/uniforms.frameSize.x,2.0/uniforms.frameSize.y);
+    outVert.position = (dotProd > 0.0 && pt.z <= 0.0) ? float4(screenPt.xy + float2(screenOffset.x*scale.x,screenOffset.y*scale.y),0.0,1.0) : float4(0.0,0.0,0.0,0.0);
+
+    return outVert;
+}
+
 struct VertexTriModelArgBuffer {
     UniformDrawStateA uniDrawState      [[ id(WKSUniformDrawStateEntry) ]];
     UniformModelInstance uniMI          [[ id(WKSUniformModelInstanceEntry) ]];
@@ -1582,6 +1809,40 @@ vertex ProjVertexTriA vertexTri_billboard(
 
 }
 
+// Vertex shader for billboards drawn as instances of a unit quad
+// The instance matrix holds the corner and edges, the texture corner and edges
+//  and the normal.  The quad's offset picks out which corner we are.
+vertex ProjVertexTriA vertexTri_billboardInst(
+            VertexTriBillboard vert [[stage_in]],
+            uint instanceID [[instance_id]],
+            constant Uniforms &uniforms [[ buffer(WKSVertUniformArgBuffer) ]],
+            constant VertexTriBillboardArgBuffer & vertArgs [[buffer(WKSVertexArgBuffer)]],
+            constant VertexTriModelInstance *billInsts   [[ buffer(WKSVertModelInstanceArgBuffer) ]])
+{
+    ProjVertexTriA outVert;
+    outVert.maskIDs = uint2(0,0);
+
+    const VertexTriModelInstance inst = billInsts[instanceID];
+    const float3 vertPos = (vertArgs.uniDrawState.singleMat * float4(inst.center,1.0)).xyz;
+    const float2 offset = inst.mat[0].xy + vert.offset.x * inst.mat[0].zw + vert.offset.y * inst.mat[1].xy;
+
+    if (vertArgs.uniBB.groundMode) {
+        const float3 normal = inst.mat[3].xyz;
+        float3 axisX = -normalize(cross(uniforms.eyeVec,normal));
+        float3 newPos = vertPos + axisX * offset.x + normal * offset.y;
+        outVert.position = uniforms.mvpMatrix * float4(newPos,1.0);
+    } else {
+        float4 pos = uniforms.mvMatrix * float4(vertPos,1.0);
+        float3 pos3 = (pos/pos.w).xyz;
+        outVert.position = uniforms.pMatrix * float4(pos3.x + offset.x,pos3.y + offset.y,pos3.z,1.0);
+    }
+
+    outVert.color = inst.color * calculateFade(uniforms,vertArgs.uniDrawState);
+    outVert.texCoord = inst.mat[1].zw + vert.offset.x * inst.mat[2].xy + vert.offset.y * inst.mat[2].zw;
+
+    return outVert;
+}
+
 
 
 // Atmosphere shaders
@@ -1776,3 +2037,84 @@ fragment float4 fragmentStars(ProjVertexTriB vert [[stage_in]],
         return vert.color;
     }
 }
+
+// Indirect command buffer for a draw group, as seen by the cull kernel
+struct CullCommands {
+    command_buffer cmdBuff [[ id(0) ]];
+};
+
+// Turn off the commands in a draw group that aren't visible this frame.
+// The commands are copied fresh from the encoded version every frame, so this only ever resets them.
+kernel void cullDrawGroup(uint which [[ thread_position_in_grid ]],
+                          constant Uniforms &uniforms [[ buffer(WKSCullUniformArgBuffer) ]],
+                          constant CullFrame &frame [[ buffer(WKSCullFrameArgBuffer) ]],
+                          const device CullInfo *cullInfos [[ buffer(WKSCullInfoArgBuffer) ]],
+                          device CullCommands &cmds [[ buffer(WKSCullCommandArgBuffer) ]])
+{
+    if ((int)which >= frame.numCommands)
+        return;
+    const CullInfo info = cullInfos[which];
+
+    bool visible = true;
+    if (info.flags & WKSCullHeight) {
+        visible = (info.minVisible <= frame.height && frame.height <= info.maxVisible) ||
+                  (info.maxVisible <= frame.height && frame.height <= info.minVisible);
+    }
+
+    if (visible && info.zoomSlot >= 0 && info.zoomSlot < MaxZoomSlots) {
+        const float zoom = uniforms.zoomSlots[info.zoomSlot];
+        if (zoom != MAXFLOAT) {
+            if (((info.flags & WKSCullMinZoom) && zoom < info.minZoomVis) ||
+                ((info.flags & WKSCullMaxZoom) && zoom >= info.maxZoomVis))
+                visible = false;
+        }
+    }
+
+    // Off screen if all the corners are on the far side of one of the clip planes
+    if (visible && (info.flags & WKSCullExtents)) {
+        int outside[6] = {0,0,0,0,0,0};
+        for (int ii=0;ii<8;ii++) {
+            const float3 corner = float3((ii & 1) ? info.boxMax.x : info.boxMin.x,
+                                         (ii & 2) ? info.boxMax.y : info.boxMin.y,
+                                         (ii & 4) ? info.boxMax.z : info.boxMin.z);
+            const float4 pt = uniforms.mvpMatrix * float4(corner,1.0) + uniforms.mvpMatrixDiff * float4(corner,1.0);
+            outside[0] += pt.x < -pt.w;
+            outside[1] += pt.x > pt.w;
+            outside[2] += pt.y < -pt.w;
+            outside[3] += pt.y > pt.w;
+            outside[4] += pt.z < 0.0;
+            outside[5] += pt.z > pt.w;
+        }
+        for (int ii=0;ii<6;ii++)
+            if (outside[ii] == 8)
+                visible = false;
+    }
+
+    if (!visible) {
+        render_command cmd(cmds.cmdBuff, which);
+        cmd.reset();
+    }
+}
+
+// Full screen triangle for scaling the map up from a smaller target
+struct ScaleUpVertex {
+    float4 position [[position]];
+    float2 texCoord;
+};
+
+vertex ScaleUpVertex vertexScaleUp(uint vid [[ vertex_id ]])
+{
+    // One triangle that covers the screen, with the texture flipped to match
+    const float2 uv = float2((vid << 1) & 2, vid & 2);
+    ScaleUpVertex outVert;
+    outVert.position = float4(uv * float2(2.0,-2.0) + float2(-1.0,1.0), 0.0, 1.0);
+    outVert.texCoord = uv;
+    return outVert;
+}
+
+fragment float4 fragmentScaleUp(ScaleUpVertex vert [[stage_in]],
+                                texture2d<float> mapTex [[ texture(0) ]])
+{
+    constexpr sampler linearSampler(filter::linear, address::clamp_to_edge);
+    return mapTex.sample(linearSampler, vert.texCoord);
+}